@@ -0,0 +1,25 @@
+# Copyright (c) 2022 The Orbit Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+find_package(benchmark CONFIG REQUIRED)
+
+# `register_benchmark` adds a `run_<target>` target which runs the Google
+# Benchmark executable BENCHMARK_TARGET and writes the results as JSON to
+# `benchmarkresults/<target>.json` in the build directory, so that they can be
+# archived and compared between commits.
+function(register_benchmark BENCHMARK_TARGET)
+  if(CMAKE_CROSSCOMPILING)
+    return()
+  endif()
+
+  set(BENCHMARKRESULTS_DIRECTORY "${CMAKE_BINARY_DIR}/benchmarkresults")
+
+  add_custom_target(run_${BENCHMARK_TARGET}
+    COMMAND ${CMAKE_COMMAND} -E make_directory "${BENCHMARKRESULTS_DIRECTORY}"
+    COMMAND $<TARGET_FILE:${BENCHMARK_TARGET}>
+      --benchmark_out=${BENCHMARKRESULTS_DIRECTORY}/${BENCHMARK_TARGET}.json
+      --benchmark_out_format=json
+    DEPENDS ${BENCHMARK_TARGET}
+    USES_TERMINAL)
+endfunction()
@@ -0,0 +1,122 @@
+"""
+Copyright (c) 2022 The Orbit Authors. All rights reserved.
+Use of this source code is governed by a BSD-style license that can be
+found in the LICENSE file.
+"""
+
+"""Benchmarks the capture throughput of OrbitService with OrbitFakeClient and OrbitTest.
+
+For each combination of the values of --threads, --depths and --sleep_us, the script starts
+OrbitTest with that many threads, that recursion depth of the instrumented functions and that sleep
+time per call, so that the rate of ORBIT_SCOPEs and the depth of the callstacks vary. It then takes
+a capture of it with OrbitFakeClient and appends one JSON object per configuration to the report,
+with the configuration itself and the content of OrbitFakeClient.capture_report.json (events per
+second, lost perf_event_open records, discarded out-of-order events, end-to-end latency) and
+OrbitFakeClient.service_report.json (CPU time and RSS of OrbitService).
+
+OrbitService needs to be running on the same machine, usually as root, e.g.:
+  sudo build/bin/OrbitService &
+  python3 contrib/scripts/run_capture_benchmark.py --bin_dir build/bin --threads 1,10 \\
+      --depths 5,50 --sleep_us 10,1000 --report capture_benchmark.jsonl -- --sampling_rate 1000
+
+Arguments after "--" are passed to OrbitFakeClient as they are.
+"""
+
+import argparse
+import itertools
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def parse_int_list(text):
+  return [int(value) for value in text.split(",")]
+
+
+def find_pid_by_name(name):
+  for entry in os.listdir("/proc"):
+    if not entry.isdigit():
+      continue
+    try:
+      with open(os.path.join("/proc", entry, "comm")) as comm_file:
+        if comm_file.read().strip() == name:
+          return int(entry)
+    except OSError:
+      continue
+  return None
+
+
+def read_json(path):
+  with open(path) as json_file:
+    return json.load(json_file)
+
+
+def run_configuration(args, fake_client_args, service_pid, threads, depth, sleep_us):
+  orbit_test = subprocess.Popen(
+      [os.path.join(args.bin_dir, "OrbitTest"),
+       str(threads), str(depth), str(sleep_us)],
+      stdin=subprocess.PIPE,
+      stdout=subprocess.DEVNULL)
+  try:
+    # Let OrbitTest start its threads before capturing.
+    time.sleep(args.warmup_s)
+    with tempfile.TemporaryDirectory() as output_path:
+      fake_client_command = [
+          os.path.join(args.bin_dir, "OrbitFakeClient"), f"--pid={orbit_test.pid}",
+          f"--duration={args.duration_s}", f"--service_pid={service_pid}",
+          f"--output_path={output_path}", "--orbit_api", "--frame_time=false"
+      ]
+      subprocess.run(fake_client_command + fake_client_args, check=True)
+      result = {"threads": threads, "depth": depth, "sleep_us": sleep_us}
+      result.update(read_json(os.path.join(output_path, "OrbitFakeClient.capture_report.json")))
+      result.update(read_json(os.path.join(output_path, "OrbitFakeClient.service_report.json")))
+      return result
+  finally:
+    # OrbitTest exits when it reads a character from stdin.
+    orbit_test.communicate(input=b"\n")
+
+
+def main():
+  argv = sys.argv[1:]
+  fake_client_args = []
+  if "--" in argv:
+    fake_client_args = argv[argv.index("--") + 1:]
+    argv = argv[:argv.index("--")]
+
+  parser = argparse.ArgumentParser(
+      description="Benchmarks the capture throughput of OrbitService with OrbitFakeClient and "
+      "OrbitTest. Arguments after \"--\" are passed to OrbitFakeClient.")
+  parser.add_argument("--bin_dir", required=True,
+                      help="Directory containing OrbitFakeClient and OrbitTest")
+  parser.add_argument("--threads", type=parse_int_list, default=[1, 10],
+                      help="Comma-separated numbers of OrbitTest threads")
+  parser.add_argument("--depths", type=parse_int_list, default=[10],
+                      help="Comma-separated recursion depths of the OrbitTest functions")
+  parser.add_argument("--sleep_us", type=parse_int_list, default=[100, 10000],
+                      help="Comma-separated sleep times in microseconds of the OrbitTest functions")
+  parser.add_argument("--duration_s", type=int, default=10, help="Duration of each capture")
+  parser.add_argument("--warmup_s", type=float, default=1.0,
+                      help="Time between starting OrbitTest and starting the capture")
+  parser.add_argument("--service_pid", type=int, default=None,
+                      help="PID of OrbitService (default: the process named OrbitService)")
+  parser.add_argument("--report", required=True,
+                      help="Path of the JSON Lines report, one line per configuration")
+  args = parser.parse_args(argv)
+
+  service_pid = args.service_pid or find_pid_by_name("OrbitService")
+  if service_pid is None:
+    sys.exit("OrbitService is not running")
+
+  with open(args.report, "w") as report:
+    for threads, depth, sleep_us in itertools.product(args.threads, args.depths, args.sleep_us):
+      result = run_configuration(args, fake_client_args, service_pid, threads, depth, sleep_us)
+      print(json.dumps(result))
+      report.write(json.dumps(result) + "\n")
+      report.flush()
+
+
+if __name__ == "__main__":
+  main()
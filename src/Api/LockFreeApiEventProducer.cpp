@@ -4,22 +4,340 @@
 
 #include "LockFreeApiEventProducer.h"
 
+#include <memory>
+#include <string>
+#include <type_traits>
 #include <variant>
 
+#include "ApiUtils/PackedApiEvents.h"
+#include "OrbitBase/Profiling.h"
+
 namespace orbit_api {
 
-orbit_grpc_protos::ProducerCaptureEvent* LockFreeApiEventProducer::TranslateIntermediateEvent(
-    ApiEventVariant&& raw_api_event, google::protobuf::Arena* arena) {
-  auto* capture_event =
+namespace {
+
+template <typename ApiEventT>
+constexpr bool kHasInternedName = std::is_same_v<ApiEventT, ApiScopeStart> ||
+                                  std::is_same_v<ApiEventT, ApiScopeStartAsync> ||
+                                  std::is_same_v<ApiEventT, ApiStringEvent>;
+
+void SetNameKey(const ApiScopeStart& /*event*/, uint64_t name_key,
+                orbit_grpc_protos::ProducerCaptureEvent* capture_event) {
+  capture_event->mutable_api_scope_start()->set_name_key(name_key);
+}
+
+void SetNameKey(const ApiScopeStartAsync& /*event*/, uint64_t name_key,
+                orbit_grpc_protos::ProducerCaptureEvent* capture_event) {
+  capture_event->mutable_api_scope_start_async()->set_name_key(name_key);
+}
+
+void SetNameKey(const ApiStringEvent& /*event*/, uint64_t name_key,
+                orbit_grpc_protos::ProducerCaptureEvent* capture_event) {
+  capture_event->mutable_api_string_event()->set_name_key(name_key);
+}
+
+template <typename ApiEventT>
+constexpr bool kIsPackable =
+    std::is_same_v<ApiEventT, ApiScopeStart> || std::is_same_v<ApiEventT, ApiScopeStop> ||
+    std::is_same_v<ApiEventT, ApiScopeStartAsync> || std::is_same_v<ApiEventT, ApiScopeStopAsync>;
+
+template <typename ApiEventT>
+constexpr bool kIsTrackValue =
+    std::is_same_v<ApiEventT, ApiTrackDouble> || std::is_same_v<ApiEventT, ApiTrackFloat> ||
+    std::is_same_v<ApiEventT, ApiTrackInt> || std::is_same_v<ApiEventT, ApiTrackInt64> ||
+    std::is_same_v<ApiEventT, ApiTrackUint> || std::is_same_v<ApiEventT, ApiTrackUint64>;
+
+[[nodiscard]] PackedApiScopeStart Pack(const ApiScopeStart& event, uint64_t name_key) {
+  PackedApiScopeStart packed_event;
+  packed_event.tid = event.meta_data.tid;
+  packed_event.timestamp_ns = event.meta_data.timestamp_ns;
+  packed_event.name_key = name_key;
+  packed_event.group_id = event.group_id;
+  packed_event.address_in_function = event.address_in_function;
+  packed_event.color_rgba = event.color_rgba;
+  return packed_event;
+}
+
+[[nodiscard]] PackedApiScopeStop Pack(const ApiScopeStop& event, uint64_t /*name_key*/) {
+  PackedApiScopeStop packed_event;
+  packed_event.tid = event.meta_data.tid;
+  packed_event.timestamp_ns = event.meta_data.timestamp_ns;
+  return packed_event;
+}
+
+[[nodiscard]] PackedApiScopeStartAsync Pack(const ApiScopeStartAsync& event, uint64_t name_key) {
+  PackedApiScopeStartAsync packed_event;
+  packed_event.tid = event.meta_data.tid;
+  packed_event.timestamp_ns = event.meta_data.timestamp_ns;
+  packed_event.name_key = name_key;
+  packed_event.id = event.id;
+  packed_event.address_in_function = event.address_in_function;
+  packed_event.color_rgba = event.color_rgba;
+  return packed_event;
+}
+
+[[nodiscard]] PackedApiScopeStopAsync Pack(const ApiScopeStopAsync& event, uint64_t /*name_key*/) {
+  PackedApiScopeStopAsync packed_event;
+  packed_event.tid = event.meta_data.tid;
+  packed_event.timestamp_ns = event.meta_data.timestamp_ns;
+  packed_event.id = event.id;
+  return packed_event;
+}
+
+}  // namespace
+
+void LockFreeApiEventProducer::EnqueueIntermediateEventBatched(ApiEventVariant&& event) {
+  // Once the thread exits, the forwarder thread holds the only reference to the buffer and takes
+  // care of the events left in it.
+  thread_local std::shared_ptr<StagingBuffer> staging_buffer = CreateStagingBuffer();
+  absl::MutexLock lock{&staging_buffer->mutex};
+  if (staging_buffer->event_count == 0) {
+    staging_buffer->first_event_staged_timestamp_ns = orbit_base::CaptureTimestampNs();
+  }
+  staging_buffer->events[staging_buffer->event_count] = std::move(event);
+  ++staging_buffer->event_count;
+  if (staging_buffer->event_count == StagingBuffer::kCapacity) {
+    FlushStagingBuffer(staging_buffer.get());
+  }
+}
+
+std::shared_ptr<LockFreeApiEventProducer::StagingBuffer>
+LockFreeApiEventProducer::CreateStagingBuffer() {
+  auto staging_buffer = std::make_shared<StagingBuffer>(CreateProducerToken());
+  absl::MutexLock lock{&staging_buffers_mutex_};
+  staging_buffers_.push_back(staging_buffer);
+  return staging_buffer;
+}
+
+void LockFreeApiEventProducer::FlushStagingBuffer(StagingBuffer* staging_buffer) {
+  if (staging_buffer->event_count == 0) return;
+  EnqueueIntermediateEvents(&staging_buffer->token, staging_buffer->events.data(),
+                            staging_buffer->event_count);
+  staging_buffer->event_count = 0;
+}
+
+void LockFreeApiEventProducer::FlushStagingBuffers(uint64_t min_staging_duration_ns) {
+  const uint64_t now_ns = orbit_base::CaptureTimestampNs();
+  absl::MutexLock lock{&staging_buffers_mutex_};
+  auto it = staging_buffers_.begin();
+  while (it != staging_buffers_.end()) {
+    // If we hold the only reference, the thread has exited and won't stage any more events.
+    const bool thread_exited = it->use_count() == 1;
+    StagingBuffer* staging_buffer = it->get();
+    {
+      absl::MutexLock buffer_lock{&staging_buffer->mutex};
+      if (thread_exited ||
+          staging_buffer->first_event_staged_timestamp_ns + min_staging_duration_ns <= now_ns) {
+        FlushStagingBuffer(staging_buffer);
+      }
+    }
+    // The events already enqueued with the token of the buffer stay in the queue.
+    if (thread_exited) {
+      it = staging_buffers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void LockFreeApiEventProducer::ResetNameKeysIfRequested() {
+  if (name_keys_reset_requested_.exchange(false)) {
+    name_to_key_.clear();
+    name_id_to_key_.clear();
+    // Summaries left over from the previous capture refer to keys of that capture.
+    track_value_summaries_.clear();
+  }
+}
+
+uint64_t LockFreeApiEventProducer::GetOrInternNameKey(const ApiEncodedString& name,
+                                                      google::protobuf::Arena* arena) {
+  ResetNameKeysIfRequested();
+  auto it = name_to_key_.find(name);
+  if (it != name_to_key_.end()) return it->second;
+  if (name_to_key_.size() + name_id_to_key_.size() >= kMaxInternedNameCount) return 0;
+
+  const uint64_t key = InternName(name.Decode(), arena);
+  name_to_key_.emplace(name, key);
+  return key;
+}
+
+uint64_t LockFreeApiEventProducer::GetOrInternStaticNameKey(uint64_t name_id, const char* name,
+                                                            google::protobuf::Arena* arena) {
+  ResetNameKeysIfRequested();
+  auto it = name_id_to_key_.find(name_id);
+  if (it != name_id_to_key_.end()) return it->second;
+  if (name_to_key_.size() + name_id_to_key_.size() >= kMaxInternedNameCount) return 0;
+
+  const uint64_t key = InternName(name, arena);
+  name_id_to_key_.emplace(name_id, key);
+  return key;
+}
+
+uint64_t LockFreeApiEventProducer::InternName(std::string name, google::protobuf::Arena* arena) {
+  const uint64_t key = next_name_key_++;
+  auto* interned_string_event =
       google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
+  orbit_grpc_protos::InternedString* interned_string =
+      interned_string_event->mutable_interned_string();
+  interned_string->set_key(key);
+  interned_string->set_intern(std::move(name));
+  AddPrecedingCaptureEvent(interned_string_event);
+  return key;
+}
+
+template <typename PackedApiEventT>
+void LockFreeApiEventProducer::AddPackedApiEvent(uint32_t pid, const PackedApiEventT& packed_event,
+                                                 google::protobuf::Arena* arena) {
+  if (packed_api_events_event_ != nullptr &&
+      packed_api_events_event_->packed_api_events().pid() != pid) {
+    FlushPackedApiEvents();
+  }
+  if (packed_api_events_event_ == nullptr) {
+    packed_api_events_event_ =
+        google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
+    orbit_grpc_protos::PackedApiEvents* packed_api_events =
+        packed_api_events_event_->mutable_packed_api_events();
+    packed_api_events->set_version(kPackedApiEventsVersion);
+    packed_api_events->set_pid(pid);
+  }
+  AppendPackedApiEvent(packed_event,
+                       packed_api_events_event_->mutable_packed_api_events()->mutable_records());
+}
+
+void LockFreeApiEventProducer::FlushPackedApiEvents() {
+  if (packed_api_events_event_ == nullptr) return;
+  AddPrecedingCaptureEvent(packed_api_events_event_);
+  packed_api_events_event_ = nullptr;
+}
 
-  std::visit(
-      [capture_event](const auto& event) {
-        orbit_api::FillProducerCaptureEventFromApiEvent(event, capture_event);
+void LockFreeApiEventProducer::AddToTrackValueSummary(const TrackValueSummaryKey& key,
+                                                      uint64_t timestamp_ns, double value) {
+  auto [it, inserted] = track_value_summaries_.try_emplace(key);
+  TrackValueSummary& summary = it->second;
+  if (inserted) {
+    summary.first_timestamp_ns = timestamp_ns;
+    summary.min = value;
+    summary.min_timestamp_ns = timestamp_ns;
+    summary.max = value;
+    summary.max_timestamp_ns = timestamp_ns;
+  } else if (value < summary.min) {
+    summary.min = value;
+    summary.min_timestamp_ns = timestamp_ns;
+  } else if (value > summary.max) {
+    summary.max = value;
+    summary.max_timestamp_ns = timestamp_ns;
+  }
+  summary.last = value;
+  summary.last_timestamp_ns = timestamp_ns;
+  ++summary.count;
+}
+
+void LockFreeApiEventProducer::FlushTrackValueSummaries(bool flush_all,
+                                                        google::protobuf::Arena* arena) {
+  const uint64_t now_ns = orbit_base::CaptureTimestampNs();
+  const uint64_t window_ns = api_track_aggregation_window_ns_;
+  auto it = track_value_summaries_.begin();
+  while (it != track_value_summaries_.end()) {
+    const auto& [key, summary] = *it;
+    if (!flush_all && summary.first_timestamp_ns + window_ns > now_ns) {
+      ++it;
+      continue;
+    }
+    auto* capture_event =
+        google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
+    orbit_grpc_protos::ApiTrackValueSummary* api_track_value_summary =
+        capture_event->mutable_api_track_value_summary();
+    api_track_value_summary->set_pid(key.pid);
+    api_track_value_summary->set_tid(key.tid);
+    api_track_value_summary->set_name_key(key.name_key);
+    api_track_value_summary->set_count(summary.count);
+    api_track_value_summary->set_min(summary.min);
+    api_track_value_summary->set_min_timestamp_ns(summary.min_timestamp_ns);
+    api_track_value_summary->set_max(summary.max);
+    api_track_value_summary->set_max_timestamp_ns(summary.max_timestamp_ns);
+    api_track_value_summary->set_last(summary.last);
+    api_track_value_summary->set_last_timestamp_ns(summary.last_timestamp_ns);
+    AddPrecedingCaptureEvent(capture_event);
+    track_value_summaries_.erase(it++);
+  }
+}
+
+void LockFreeApiEventProducer::FinishTranslatingIntermediateEvents(
+    google::protobuf::Arena* arena) {
+  FlushPackedApiEvents();
+  if (!track_value_summaries_.empty()) {
+    FlushTrackValueSummaries(flush_all_track_value_summaries_requested_, arena);
+  }
+  flush_all_track_value_summaries_requested_ = false;
+}
+
+orbit_grpc_protos::ProducerCaptureEvent* LockFreeApiEventProducer::TranslateIntermediateEvent(
+    ApiEventVariant&& raw_api_event, google::protobuf::Arena* arena) {
+  return std::visit(
+      [this, arena](auto& event) -> orbit_grpc_protos::ProducerCaptureEvent* {
+        using ApiEventT = std::decay_t<decltype(event)>;
+        if constexpr (std::is_same_v<ApiEventT, std::monostate>) {
+          // The marker enqueued by OnCaptureStop.
+          flush_all_track_value_summaries_requested_ = true;
+          return nullptr;
+        } else {
+          event.meta_data.timestamp_ns = ToCaptureTimestampNs(event.meta_data.timestamp_ns);
+          return TranslateApiEvent(event, arena);
+        }
       },
       raw_api_event);
+}
+
+template <typename ApiEventT>
+orbit_grpc_protos::ProducerCaptureEvent* LockFreeApiEventProducer::TranslateApiEvent(
+    ApiEventT& event, google::protobuf::Arena* arena) {
+  uint64_t name_key = 0;
+  if constexpr (std::is_same_v<ApiEventT, ApiScopeStart>) {
+    if (event.name_id != 0) {
+      name_key = GetOrInternStaticNameKey(event.name_id, event.static_name, arena);
+      // The name wasn't encoded when the event was created.
+      if (name_key == 0) event.encoded_name = ApiEncodedString{event.static_name};
+    } else {
+      name_key = GetOrInternNameKey(event.encoded_name, arena);
+    }
+  } else if constexpr (kHasInternedName<ApiEventT>) {
+    name_key = GetOrInternNameKey(event.encoded_name, arena);
+  }
+
+  if constexpr (kIsPackable<ApiEventT>) {
+    // Packed records can only refer to names by their key.
+    if (!kHasInternedName<ApiEventT> || name_key != 0) {
+      AddPackedApiEvent(event.meta_data.pid, Pack(event, name_key), arena);
+      return nullptr;
+    }
+  }
 
+  if constexpr (kIsTrackValue<ApiEventT>) {
+    if (api_track_aggregation_window_ns_ != 0) {
+      // Summaries can only refer to names by their key.
+      const uint64_t track_name_key = GetOrInternNameKey(event.encoded_name, arena);
+      if (track_name_key != 0) {
+        AddToTrackValueSummary({event.meta_data.pid, event.meta_data.tid, track_name_key},
+                               event.meta_data.timestamp_ns, static_cast<double>(event.data));
+        return nullptr;
+      }
+    }
+  }
+
+  // Preserve the order of the events, e.g., of an ApiScopeStart with a name that couldn't be
+  // interned relative to the ApiScopeStops packed so far.
+  FlushPackedApiEvents();
+  auto* capture_event =
+      google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
+  if constexpr (kHasInternedName<ApiEventT>) {
+    // Don't copy the encoded name to the proto if the key replaces it.
+    if (name_key != 0) event.encoded_name = ApiEncodedString{""};
+  }
+  orbit_api::FillProducerCaptureEventFromApiEvent(event, capture_event);
+  if constexpr (kHasInternedName<ApiEventT>) {
+    SetNameKey(event, name_key, capture_event);
+  }
   return capture_event;
 }
 
-}  // namespace orbit_api
\ No newline at end of file
+}  // namespace orbit_api
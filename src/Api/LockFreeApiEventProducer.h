@@ -5,10 +5,19 @@
 #ifndef API_LOCK_FREE_API_EVENT_PRODUCER_H_
 #define API_LOCK_FREE_API_EVENT_PRODUCER_H_
 
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
 #include <google/protobuf/arena.h>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "ApiUtils/Event.h"
 #include "CaptureEventProducer/LockFreeBufferCaptureEventProducer.h"
@@ -19,18 +28,157 @@ namespace orbit_api {
 
 // This class is used to enqueue orbit_api::ApiEvent events from multiple threads and relay them to
 // OrbitService in the form of orbit_grpc_protos::ApiEvent events.
+// The names of scopes and string events are interned: the first event with a given name is
+// preceded by an orbit_grpc_protos::InternedString, and all events only carry the key of the name.
+// Consecutive scope events are then sent together as one orbit_grpc_protos::PackedApiEvents, see
+// ApiUtils/PackedApiEvents.h.
+// If the capture options ask for it, the values of each track of each thread are aggregated over
+// a short window and sent as orbit_grpc_protos::ApiTrackValueSummary.
 class LockFreeApiEventProducer
     : public orbit_capture_event_producer::LockFreeBufferCaptureEventProducer<ApiEventVariant> {
  public:
   LockFreeApiEventProducer() {
+    UseSharedMemoryBuffer();
     BuildAndStart(orbit_producer_side_channel::CreateProducerSideChannel());
   }
 
   ~LockFreeApiEventProducer() override { ShutdownAndWait(); }
 
+  // Stages `event` in a buffer of the calling thread instead of enqueueing it right away. The
+  // buffer is moved to the lock-free queue at once when it is full or when the thread exits, and by
+  // the forwarder thread once its oldest event has waited for `kMaxStagingDurationNs`. This keeps
+  // threads producing many events from contending on the lock-free queue for each of them.
+  // As the buffer is thread-local, there must only be one instance of this class in the process.
+  void EnqueueIntermediateEventBatched(ApiEventVariant&& event);
+
  protected:
+  void OnCaptureStart(orbit_grpc_protos::CaptureOptions capture_options) override {
+    // Keys are only valid within one capture, so the names need to be sent again.
+    name_keys_reset_requested_ = true;
+    api_track_aggregation_window_ns_ = capture_options.api_track_aggregation_window_ns();
+    LockFreeBufferCaptureEventProducer::OnCaptureStart(std::move(capture_options));
+  }
+
+  void OnCaptureStop() override {
+    // Make sure the staged events are sent before AllEventsSent.
+    FlushStagingBuffers(/*min_staging_duration_ns=*/0);
+    if (api_track_aggregation_window_ns_ != 0) {
+      // When the forwarder thread translates this marker, it sends all ApiTrackValueSummaries.
+      EnqueueIntermediateEvent(ApiEventVariant{});
+    }
+    LockFreeBufferCaptureEventProducer::OnCaptureStop();
+  }
+
+  size_t DequeueIntermediateEvents(ApiEventVariant* events, size_t max_event_count) override {
+    FlushStagingBuffers(kMaxStagingDurationNs);
+    return LockFreeBufferCaptureEventProducer::DequeueIntermediateEvents(events, max_event_count);
+  }
+
   [[nodiscard]] orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
       ApiEventVariant&& raw_api_event, google::protobuf::Arena* arena) override;
+
+  void FinishTranslatingIntermediateEvents(google::protobuf::Arena* arena) override;
+
+ private:
+  struct StagingBuffer {
+    explicit StagingBuffer(moodycamel::ProducerToken token) : token{std::move(token)} {}
+
+    static constexpr size_t kCapacity = 64;
+
+    // Only contended when the forwarder thread flushes the buffer.
+    absl::Mutex mutex;
+    moodycamel::ProducerToken token ABSL_GUARDED_BY(mutex);
+    std::array<ApiEventVariant, kCapacity> events ABSL_GUARDED_BY(mutex);
+    size_t event_count ABSL_GUARDED_BY(mutex) = 0;
+    // The orbit_base::CaptureTimestampNs at which the first of `events` was staged.
+    uint64_t first_event_staged_timestamp_ns ABSL_GUARDED_BY(mutex) = 0;
+  };
+  // Flushes the staging buffer of a thread when the thread exits.
+  class ThreadStagingBuffer;
+
+  static constexpr uint64_t kMaxStagingDurationNs = 1'000'000;
+
+  [[nodiscard]] std::shared_ptr<StagingBuffer> CreateStagingBuffer();
+  void FlushStagingBuffer(StagingBuffer* staging_buffer)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(staging_buffer->mutex);
+  // Flushes the staging buffers whose first event has been staged at least
+  // `min_staging_duration_ns` ago, and releases the buffers of threads that have exited.
+  void FlushStagingBuffers(uint64_t min_staging_duration_ns);
+
+  // Returns the key of `name`, after adding an InternedString for it in front of the event being
+  // translated if it wasn't sent before. Returns 0 if `name` should be sent with the event instead.
+  [[nodiscard]] uint64_t GetOrInternNameKey(const ApiEncodedString& name,
+                                            google::protobuf::Arena* arena);
+  // Same for a name with static storage duration identified by `name_id`, see ORBIT_SCOPE_LITERAL.
+  // This saves encoding and hashing the name on every event.
+  [[nodiscard]] uint64_t GetOrInternStaticNameKey(uint64_t name_id, const char* name,
+                                                  google::protobuf::Arena* arena);
+  [[nodiscard]] uint64_t InternName(std::string name, google::protobuf::Arena* arena);
+  void ResetNameKeysIfRequested();
+
+  // Appends `packed_event` to the PackedApiEvents being built from the events being translated.
+  template <typename PackedApiEventT>
+  void AddPackedApiEvent(uint32_t pid, const PackedApiEventT& packed_event,
+                         google::protobuf::Arena* arena);
+  // Adds the PackedApiEvents being built, if any, to the events being forwarded.
+  void FlushPackedApiEvents();
+
+  // Translates all events other than the marker of OnCaptureStop.
+  template <typename ApiEventT>
+  [[nodiscard]] orbit_grpc_protos::ProducerCaptureEvent* TranslateApiEvent(
+      ApiEventT& event, google::protobuf::Arena* arena);
+
+  struct TrackValueSummaryKey {
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t name_key;
+
+    friend bool operator==(const TrackValueSummaryKey& lhs, const TrackValueSummaryKey& rhs) {
+      return lhs.pid == rhs.pid && lhs.tid == rhs.tid && lhs.name_key == rhs.name_key;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const TrackValueSummaryKey& key) {
+      return H::combine(std::move(h), key.pid, key.tid, key.name_key);
+    }
+  };
+  struct TrackValueSummary {
+    uint64_t first_timestamp_ns = 0;
+    uint64_t count = 0;
+    double min = 0;
+    uint64_t min_timestamp_ns = 0;
+    double max = 0;
+    uint64_t max_timestamp_ns = 0;
+    double last = 0;
+    uint64_t last_timestamp_ns = 0;
+  };
+
+  void AddToTrackValueSummary(const TrackValueSummaryKey& key, uint64_t timestamp_ns,
+                              double value);
+  // Adds the ApiTrackValueSummaries whose first value is older than the aggregation window, or all
+  // of them if `flush_all` is true, to the events being forwarded.
+  void FlushTrackValueSummaries(bool flush_all, google::protobuf::Arena* arena);
+
+  // Names that aren't string literals could be unique, so stop interning at some point rather than
+  // growing without bounds.
+  static constexpr size_t kMaxInternedNameCount = 64 * 1024;
+
+  // Only accessed by the forwarder thread, through TranslateIntermediateEvent.
+  absl::flat_hash_map<ApiEncodedString, uint64_t> name_to_key_;
+  absl::flat_hash_map<uint64_t, uint64_t> name_id_to_key_;
+  uint64_t next_name_key_ = 1;
+  std::atomic<bool> name_keys_reset_requested_ = false;
+  // Only accessed by the forwarder thread. Allocated in the Arena of the current batch.
+  orbit_grpc_protos::ProducerCaptureEvent* packed_api_events_event_ = nullptr;
+
+  std::atomic<uint64_t> api_track_aggregation_window_ns_ = 0;
+  // Only accessed by the forwarder thread.
+  absl::flat_hash_map<TrackValueSummaryKey, TrackValueSummary> track_value_summaries_;
+  bool flush_all_track_value_summaries_requested_ = false;
+
+  absl::Mutex staging_buffers_mutex_;
+  std::vector<std::shared_ptr<StagingBuffer>> staging_buffers_
+      ABSL_GUARDED_BY(staging_buffers_mutex_);
 };
 
 }  // namespace orbit_api
@@ -33,9 +33,9 @@ void EnqueueApiEvent(Types... args) {
 
   static uint32_t pid = orbit_base::GetCurrentProcessId();
   thread_local uint32_t tid = orbit_base::GetCurrentThreadId();
-  uint64_t timestamp_ns = orbit_base::CaptureTimestampNs();
-  Event event{pid, tid, timestamp_ns, args...};
-  producer.EnqueueIntermediateEvent(event);
+  // Converted to a capture timestamp by the producer, if needed.
+  uint64_t timestamp = producer.ReadTimestamp();
+  producer.EnqueueIntermediateEventBatched(Event{pid, tid, timestamp, args...});
 }
 
 void orbit_api_start_v1(const char* name, orbit_api_color color, uint64_t group_id,
@@ -52,6 +52,14 @@ void orbit_api_start_v1(const char* name, orbit_api_color color, uint64_t group_
       name, color, static_cast<uint64_t>(kOrbitDefaultGroupId), return_address);
 }
 
+void orbit_api_start_with_name_id_v3(uint64_t name_id, const char* name, orbit_api_color color,
+                                     uint64_t group_id, uint64_t caller_address) {
+  if (caller_address == kOrbitCallerAddressAuto) {
+    caller_address = ORBIT_GET_CALLER_PC();
+  }
+  EnqueueApiEvent<orbit_api::ApiScopeStart>(name_id, name, color, group_id, caller_address);
+}
+
 void orbit_api_stop() { EnqueueApiEvent<orbit_api::ApiScopeStop>(); }
 
 void orbit_api_start_async_v1(const char* name, uint64_t id, orbit_api_color color,
@@ -166,6 +174,21 @@ void orbit_api_initialize_v2(orbit_api_v2* api_v2) {
   api_v2->track_double = &orbit_api_track_double;
 }
 
+void orbit_api_initialize_v3(orbit_api_v3* api_v3) {
+  api_v3->start = &orbit_api_start_v1;
+  api_v3->stop = &orbit_api_stop;
+  api_v3->start_async = &orbit_api_start_async_v1;
+  api_v3->stop_async = &orbit_api_stop_async;
+  api_v3->async_string = &orbit_api_async_string;
+  api_v3->track_int = &orbit_api_track_int;
+  api_v3->track_int64 = &orbit_api_track_int64;
+  api_v3->track_uint = &orbit_api_track_uint;
+  api_v3->track_uint64 = &orbit_api_track_uint64;
+  api_v3->track_float = &orbit_api_track_float;
+  api_v3->track_double = &orbit_api_track_double;
+  api_v3->start_with_name_id = &orbit_api_start_with_name_id_v3;
+}
+
 #ifdef __linux
 
 // The functions that follow, with `__attribute__((ms_abi))`, are used to fill the function table
@@ -180,6 +203,17 @@ __attribute__((ms_abi)) void orbit_api_start_wine_v1(const char* name, orbit_api
   orbit_api_start_v1(name, color, group_id, caller_address);
 }
 
+__attribute__((ms_abi)) void orbit_api_start_with_name_id_wine_v3(uint64_t name_id,
+                                                                   const char* name,
+                                                                   orbit_api_color color,
+                                                                   uint64_t group_id,
+                                                                   uint64_t caller_address) {
+  if (caller_address == kOrbitCallerAddressAuto) {
+    caller_address = ORBIT_GET_CALLER_PC();
+  }
+  orbit_api_start_with_name_id_v3(name_id, name, color, group_id, caller_address);
+}
+
 __attribute__((ms_abi)) void orbit_api_stop_wine() { orbit_api_stop(); }
 
 __attribute__((ms_abi)) void orbit_api_start_async_wine_v1(const char* name, uint64_t id,
@@ -242,6 +276,21 @@ void orbit_api_initialize_wine_v2(orbit_api_win_v2* api_win_v2) {
   api_win_v2->track_double = &orbit_api_track_double_wine;
 }
 
+void orbit_api_initialize_wine_v3(orbit_api_win_v3* api_win_v3) {
+  api_win_v3->start = &orbit_api_start_wine_v1;
+  api_win_v3->stop = &orbit_api_stop_wine;
+  api_win_v3->start_async = &orbit_api_start_async_wine_v1;
+  api_win_v3->stop_async = &orbit_api_stop_async_wine;
+  api_win_v3->async_string = &orbit_api_async_string_wine;
+  api_win_v3->track_int = &orbit_api_track_int_wine;
+  api_win_v3->track_int64 = &orbit_api_track_int64_wine;
+  api_win_v3->track_uint = &orbit_api_track_uint_wine;
+  api_win_v3->track_uint64 = &orbit_api_track_uint64_wine;
+  api_win_v3->track_float = &orbit_api_track_float_wine;
+  api_win_v3->track_double = &orbit_api_track_double_wine;
+  api_win_v3->start_with_name_id = &orbit_api_start_with_name_id_wine_v3;
+}
+
 #endif  // __linux
 
 }  // namespace
@@ -275,6 +324,10 @@ ORBIT_EXPORT void orbit_api_set_enabled(uint64_t address, uint64_t api_version,
       auto* api_v2 = absl::bit_cast<orbit_api_v2*>(address);
       orbit_api_initialize_and_set_enabled(api_v2, &orbit_api_initialize_v2, enabled);
     } break;
+    case 3: {
+      auto* api_v3 = absl::bit_cast<orbit_api_v3*>(address);
+      orbit_api_initialize_and_set_enabled(api_v3, &orbit_api_initialize_v3, enabled);
+    } break;
     default:
       ORBIT_UNREACHABLE();
   }
@@ -317,6 +370,10 @@ void orbit_api_set_enabled_wine(uint64_t address, uint64_t api_version, bool ena
       auto* api_win = absl::bit_cast<orbit_api_win_v2*>(address);
       orbit_api_initialize_and_set_enabled(api_win, &orbit_api_initialize_wine_v2, enabled);
     } break;
+    case 3: {
+      auto* api_win = absl::bit_cast<orbit_api_win_v3*>(address);
+      orbit_api_initialize_and_set_enabled(api_win, &orbit_api_initialize_wine_v3, enabled);
+    } break;
     default:
       ORBIT_UNREACHABLE();
   }
@@ -45,6 +45,24 @@ struct orbit_api_v1 {  // NOLINT(readability-identifier-naming)
   void (*track_double)(const char* name, double value, orbit_api_color color);
 };
 
+struct orbit_api_v2 {  // NOLINT(readability-identifier-naming)
+  uint32_t enabled;
+  uint32_t initialized;
+  void (*start)(const char* name, orbit_api_color color, uint64_t group_id,
+                uint64_t caller_address);
+  void (*stop)();
+  void (*start_async)(const char* name, uint64_t id, orbit_api_color color,
+                      uint64_t caller_address);
+  void (*stop_async)(uint64_t id);
+  void (*async_string)(const char* str, uint64_t id, orbit_api_color color);
+  void (*track_int)(const char* name, int value, orbit_api_color color);
+  void (*track_int64)(const char* name, int64_t value, orbit_api_color color);
+  void (*track_uint)(const char* name, uint32_t value, orbit_api_color color);
+  void (*track_uint64)(const char* name, uint64_t value, orbit_api_color color);
+  void (*track_float)(const char* name, float value, orbit_api_color color);
+  void (*track_double)(const char* name, double value, orbit_api_color color);
+};
+
 #ifdef __linux
 
 // And these are the versions that resulted from building Orbit.h on Windows, but defined on Linux
@@ -74,6 +92,31 @@ struct orbit_api_win_v2 {  // NOLINT(readability-identifier-naming)
                                                orbit_api_color color);
 };
 
+struct orbit_api_win_v3 {  // NOLINT(readability-identifier-naming)
+  uint32_t enabled;
+  uint32_t initialized;
+  __attribute__((ms_abi)) void (*start)(const char* name, orbit_api_color color, uint64_t group_id,
+                                        uint64_t caller_address);
+  __attribute__((ms_abi)) void (*stop)();
+  __attribute__((ms_abi)) void (*start_async)(const char* name, uint64_t id, orbit_api_color color,
+                                              uint64_t caller_address);
+  __attribute__((ms_abi)) void (*stop_async)(uint64_t id);
+  __attribute__((ms_abi)) void (*async_string)(const char* str, uint64_t id, orbit_api_color color);
+  __attribute__((ms_abi)) void (*track_int)(const char* name, int value, orbit_api_color color);
+  __attribute__((ms_abi)) void (*track_int64)(const char* name, int64_t value,
+                                              orbit_api_color color);
+  __attribute__((ms_abi)) void (*track_uint)(const char* name, uint32_t value,
+                                             orbit_api_color color);
+  __attribute__((ms_abi)) void (*track_uint64)(const char* name, uint64_t value,
+                                               orbit_api_color color);
+  __attribute__((ms_abi)) void (*track_float)(const char* name, float value, orbit_api_color color);
+  __attribute__((ms_abi)) void (*track_double)(const char* name, double value,
+                                               orbit_api_color color);
+  __attribute__((ms_abi)) void (*start_with_name_id)(uint64_t name_id, const char* name,
+                                                     orbit_api_color color, uint64_t group_id,
+                                                     uint64_t caller_address);
+};
+
 #endif  // __linux
 
 #endif  // ORBIT_API_ORBIT_API_VERSIONS_H_
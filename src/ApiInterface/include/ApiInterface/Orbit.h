@@ -80,6 +80,13 @@
 // group_id: [uint64_t] User-defined non-zero id that associates the current time slice with all the
 //           other time slices with the same id.
 //
+// String literals:
+// When the name is a string literal, prefer the "ORBIT_SCOPE_LITERAL" variants of these macros,
+// e.g., ORBIT_SCOPE_LITERAL("DoSomeMoreWork"). They identify the name by a hash computed at compile
+// time, so that the name doesn't need to be copied on every call. The name itself is only read
+// the first time in each capture that a scope with that name is recorded. Passing anything other
+// than a string literal results in a compilation error.
+//
 //
 // =================================================================================================
 // ORBIT_START/ORBIT_STOP: Profile sections inside a scope.
@@ -215,6 +222,19 @@
   ORBIT_SCOPE_WITH_COLOR_AND_GROUP_ID_INTERNAL(name, col, group_id, ORBIT_VAR)
 #endif  // _WIN32
 
+#define ORBIT_SCOPE_LITERAL(name) ORBIT_SCOPE_LITERAL_WITH_COLOR(name, kOrbitColorAuto)
+#define ORBIT_SCOPE_LITERAL_WITH_COLOR(name, col) \
+  ORBIT_SCOPE_LITERAL_WITH_COLOR_AND_GROUP_ID(name, col, kOrbitDefaultGroupId)
+#define ORBIT_SCOPE_LITERAL_WITH_GROUP_ID(name, group_id) \
+  ORBIT_SCOPE_LITERAL_WITH_COLOR_AND_GROUP_ID(name, kOrbitColorAuto, group_id)
+#ifdef _WIN32
+#define ORBIT_SCOPE_LITERAL_WITH_COLOR_AND_GROUP_ID(name, col, group_id) \
+  orbit_api::Scope ORBIT_VAR(ORBIT_NAME_ID(name), name, col, group_id)
+#else
+#define ORBIT_SCOPE_LITERAL_WITH_COLOR_AND_GROUP_ID(name, col, group_id) \
+  ORBIT_SCOPE_LITERAL_WITH_COLOR_AND_GROUP_ID_INTERNAL(name, col, group_id, ORBIT_VAR)
+#endif  // _WIN32
+
 #endif  // __cplusplus
 
 #define ORBIT_START(name) \
@@ -255,6 +275,10 @@
 #define ORBIT_SCOPE_WITH_COLOR(name, color)
 #define ORBIT_SCOPE_WITH_GROUP_ID(name, group_id)
 #define ORBIT_SCOPE_WITH_COLOR_AND_GROUP_ID(name, col, group_id)
+#define ORBIT_SCOPE_LITERAL(name)
+#define ORBIT_SCOPE_LITERAL_WITH_COLOR(name, color)
+#define ORBIT_SCOPE_LITERAL_WITH_GROUP_ID(name, group_id)
+#define ORBIT_SCOPE_LITERAL_WITH_COLOR_AND_GROUP_ID(name, col, group_id)
 #endif
 
 #define ORBIT_START(name)
@@ -286,6 +310,7 @@
 
 #ifdef __cplusplus
 #include <atomic>
+#include <type_traits>
 
 #define ORBIT_THREAD_FENCE_ACQUIRE() std::atomic_thread_fence(std::memory_order_acquire)
 #else
@@ -340,9 +365,9 @@ typedef enum {  // NOLINT(modernize-use-using): This is C code.
 enum { kOrbitDefaultGroupId = 0ULL };
 enum { kOrbitCallerAddressAuto = 0ULL };
 
-enum { kOrbitApiVersion = 2 };
+enum { kOrbitApiVersion = 3 };
 
-struct orbit_api_v2 {  // NOLINT(readability-identifier-naming)
+struct orbit_api_v3 {  // NOLINT(readability-identifier-naming)
   uint32_t enabled;
   uint32_t initialized;
   void (*start)(const char* name, orbit_api_color color, uint64_t group_id,
@@ -358,31 +383,34 @@ struct orbit_api_v2 {  // NOLINT(readability-identifier-naming)
   void (*track_uint64)(const char* name, uint64_t value, orbit_api_color color);
   void (*track_float)(const char* name, float value, orbit_api_color color);
   void (*track_double)(const char* name, double value, orbit_api_color color);
+  // Like `start`, for a `name` with static storage duration identified by `name_id`.
+  void (*start_with_name_id)(uint64_t name_id, const char* name, orbit_api_color color,
+                             uint64_t group_id, uint64_t caller_address);
 };
 
 #if __cplusplus >= 201103L  // C++11
-static_assert(sizeof(struct orbit_api_v2) == 96, "struct orbit_api_v2 has an unexpected layout");
+static_assert(sizeof(struct orbit_api_v3) == 104, "struct orbit_api_v3 has an unexpected layout");
 #elif __STDC_VERSION__ >= 201112L  // C11
-_Static_assert(sizeof(struct orbit_api_v2) == 96, "struct orbit_api_v2 has an unexpected layout");
+_Static_assert(sizeof(struct orbit_api_v3) == 104, "struct orbit_api_v3 has an unexpected layout");
 #endif
 
-extern struct orbit_api_v2 g_orbit_api;
+extern struct orbit_api_v3 g_orbit_api;
 
 // User needs to place "ORBIT_API_INSTANTIATE" in an implementation file.
 // We use a different name per platform for the "orbit_api_get_function_table_address_..._v#"
 // function, so that we can easily distinguish what platform the binary was built for.
 #ifdef _WIN32
-extern ORBIT_EXPORT void* orbit_api_get_function_table_address_win_v2();
+extern ORBIT_EXPORT void* orbit_api_get_function_table_address_win_v3();
 
 #define ORBIT_API_INSTANTIATE      \
-  struct orbit_api_v2 g_orbit_api; \
-  void* orbit_api_get_function_table_address_win_v2() { return &g_orbit_api; }
+  struct orbit_api_v3 g_orbit_api; \
+  void* orbit_api_get_function_table_address_win_v3() { return &g_orbit_api; }
 #else
-extern ORBIT_EXPORT void* orbit_api_get_function_table_address_v2();
+extern ORBIT_EXPORT void* orbit_api_get_function_table_address_v3();
 
 #define ORBIT_API_INSTANTIATE      \
-  struct orbit_api_v2 g_orbit_api; \
-  void* orbit_api_get_function_table_address_v2() { return &g_orbit_api; }
+  struct orbit_api_v3 g_orbit_api; \
+  void* orbit_api_get_function_table_address_v3() { return &g_orbit_api; }
 #endif  // _WIN32
 
 #ifndef __cplusplus
@@ -411,6 +439,19 @@ static
 #define ORBIT_UNIQUE(x) ORBIT_CONCAT(x, __COUNTER__)
 #define ORBIT_VAR ORBIT_UNIQUE(ORB)
 
+namespace orbit_api {
+// 64-bit FNV-1a hash of `name`. Written as a single return statement to be a valid C++11 constexpr
+// function.
+constexpr uint64_t HashName(const char* name, uint64_t hash = 0xcbf29ce484222325ULL) {
+  return *name == '\0'
+             ? hash
+             : HashName(name + 1, (hash ^ static_cast<uint8_t>(*name)) * 0x100000001b3ULL);
+}
+}  // namespace orbit_api
+
+// Forces the hash to be computed at compile time, which also requires `name` to be a literal.
+#define ORBIT_NAME_ID(name) (std::integral_constant<uint64_t, ::orbit_api::HashName(name)>::value)
+
 #ifdef _WIN32
 #include <intrin.h>
 
@@ -432,6 +473,11 @@ struct Scope {
     uint64_t return_address = ORBIT_GET_CALLER_PC();
     ORBIT_CALL(start, name, color, group_id, return_address);
   }
+  __declspec(noinline) Scope(uint64_t name_id, const char* name, orbit_api_color color,
+                             uint64_t group_id) {
+    uint64_t return_address = ORBIT_GET_CALLER_PC();
+    ORBIT_CALL(start_with_name_id, name_id, name, color, group_id, return_address);
+  }
   ~Scope() { ORBIT_CALL(stop); }
 };
 }  // namespace orbit_api
@@ -442,12 +488,20 @@ struct Scope {
   uint64_t pc_name;                                                                \
   asm("lea (%%rip), %0" : "=r"(pc_name) : :);                                      \
   orbit_api::Scope ORBIT_VAR(name, col, group_id, pc_name)
+#define ORBIT_SCOPE_LITERAL_WITH_COLOR_AND_GROUP_ID_INTERNAL(name, col, group_id, pc_name) \
+  uint64_t pc_name;                                                                        \
+  asm("lea (%%rip), %0" : "=r"(pc_name) : :);                                              \
+  orbit_api::Scope ORBIT_VAR(ORBIT_NAME_ID(name), name, col, group_id, pc_name)
 
 namespace orbit_api {
 struct Scope {
   Scope(const char* name, orbit_api_color color, uint64_t group_id, uint64_t pc) {
     ORBIT_CALL(start, name, color, group_id, pc);
   }
+  Scope(uint64_t name_id, const char* name, orbit_api_color color, uint64_t group_id,
+        uint64_t pc) {
+    ORBIT_CALL(start_with_name_id, name_id, name, color, group_id, pc);
+  }
   ~Scope() { ORBIT_CALL(stop); }
 };
 }  // namespace orbit_api
@@ -7,6 +7,8 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -30,6 +32,7 @@ struct ApiEventMetaData {
 };
 
 struct ApiEncodedString {
+  ApiEncodedString() = default;
   explicit ApiEncodedString(const char* name) { EncodeString(name, this); }
   void set_encoded_name_1(uint64_t value) { encoded_name_1 = value; }
   void set_encoded_name_2(uint64_t value) { encoded_name_2 = value; }
@@ -40,6 +43,30 @@ struct ApiEncodedString {
   void set_encoded_name_7(uint64_t value) { encoded_name_7 = value; }
   void set_encoded_name_8(uint64_t value) { encoded_name_8 = value; }
   void add_encoded_name_additional(uint64_t value) { encoded_name_additional.push_back(value); }
+
+  friend bool operator==(const ApiEncodedString& lhs, const ApiEncodedString& rhs) {
+    return lhs.encoded_name_1 == rhs.encoded_name_1 && lhs.encoded_name_2 == rhs.encoded_name_2 &&
+           lhs.encoded_name_3 == rhs.encoded_name_3 && lhs.encoded_name_4 == rhs.encoded_name_4 &&
+           lhs.encoded_name_5 == rhs.encoded_name_5 && lhs.encoded_name_6 == rhs.encoded_name_6 &&
+           lhs.encoded_name_7 == rhs.encoded_name_7 && lhs.encoded_name_8 == rhs.encoded_name_8 &&
+           lhs.encoded_name_additional == rhs.encoded_name_additional;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const ApiEncodedString& encoded_string) {
+    return H::combine(std::move(h), encoded_string.encoded_name_1, encoded_string.encoded_name_2,
+                      encoded_string.encoded_name_3, encoded_string.encoded_name_4,
+                      encoded_string.encoded_name_5, encoded_string.encoded_name_6,
+                      encoded_string.encoded_name_7, encoded_string.encoded_name_8,
+                      encoded_string.encoded_name_additional);
+  }
+
+  [[nodiscard]] std::string Decode() const {
+    return DecodeString(encoded_name_1, encoded_name_2, encoded_name_3, encoded_name_4,
+                        encoded_name_5, encoded_name_6, encoded_name_7, encoded_name_8,
+                        encoded_name_additional.data(), encoded_name_additional.size());
+  }
+
   uint64_t encoded_name_1 = 0;
   uint64_t encoded_name_2 = 0;
   uint64_t encoded_name_3 = 0;
@@ -60,6 +87,17 @@ struct ApiScopeStart {
         group_id(group_id),
         address_in_function(address_in_function),
         color_rgba(color_rgba) {}
+  // For a `name` with static storage duration, identified by the non-zero `name_id`. The name is
+  // not encoded, see `name_id` below.
+  ApiScopeStart(uint32_t pid, uint32_t tid, uint64_t timestamp_ns, uint64_t name_id,
+                const char* name, orbit_api_color color_rgba, uint64_t group_id,
+                uint64_t address_in_function)
+      : meta_data(pid, tid, timestamp_ns),
+        group_id(group_id),
+        address_in_function(address_in_function),
+        color_rgba(color_rgba),
+        name_id(name_id),
+        static_name(name) {}
 
   void CopyToGrpcProto(orbit_grpc_protos::ApiScopeStart* grpc_proto) const;
 
@@ -68,6 +106,10 @@ struct ApiScopeStart {
   uint64_t group_id = 0;
   uint64_t address_in_function = 0;
   uint32_t color_rgba = 0;
+  // If not zero, `encoded_name` is empty and the name is `static_name` instead. Whoever converts
+  // the event to a proto needs to replace the name by an InternedString, or encode it.
+  uint64_t name_id = 0;
+  const char* static_name = nullptr;
 };
 
 struct ApiScopeStop {
@@ -200,7 +242,8 @@ struct ApiTrackFloat {
 };
 
 // Used in `LockFreeApiEventProducer`. The `std::monostate` is required make this variant default
-// constructable. However, real (fully instantiated) values will never be of type `std::monostate`.
+// constructable. The only values of type `std::monostate` are the markers the producer enqueues
+// itself at the end of a capture, they are never translated to a `ProducerCaptureEvent`.
 using ApiEventVariant =
     std::variant<std::monostate, ApiScopeStart, ApiScopeStop, ApiScopeStartAsync, ApiScopeStopAsync,
                  ApiStringEvent, ApiTrackDouble, ApiTrackFloat, ApiTrackInt, ApiTrackInt64,
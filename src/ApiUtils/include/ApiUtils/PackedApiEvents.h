@@ -0,0 +1,104 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_API_UTILS_PACKED_API_EVENTS_H_
+#define ORBIT_API_UTILS_PACKED_API_EVENTS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace orbit_api {
+
+// The most frequent Api events can be sent as fixed-layout records, packed back to back into
+// `orbit_grpc_protos::PackedApiEvents::records`, so that they are neither encoded nor decoded as
+// protobufs. Producer and OrbitService run on the same machine, hence the records are in native
+// byte order. Any change to the layout of the records requires increasing this version.
+constexpr uint32_t kPackedApiEventsVersion = 1;
+
+enum class PackedApiEventType : uint32_t {
+  kScopeStart = 1,
+  kScopeStop = 2,
+  kScopeStartAsync = 3,
+  kScopeStopAsync = 4,
+};
+
+// All records start with their type, their size is a multiple of 8 bytes, and names are always
+// passed as keys of InternedStrings.
+struct PackedApiScopeStart {
+  static constexpr PackedApiEventType kType = PackedApiEventType::kScopeStart;
+  PackedApiEventType type = kType;
+  uint32_t tid = 0;
+  uint64_t timestamp_ns = 0;
+  uint64_t name_key = 0;
+  uint64_t group_id = 0;
+  uint64_t address_in_function = 0;
+  uint32_t color_rgba = 0;
+  uint32_t padding = 0;
+};
+
+struct PackedApiScopeStop {
+  static constexpr PackedApiEventType kType = PackedApiEventType::kScopeStop;
+  PackedApiEventType type = kType;
+  uint32_t tid = 0;
+  uint64_t timestamp_ns = 0;
+};
+
+struct PackedApiScopeStartAsync {
+  static constexpr PackedApiEventType kType = PackedApiEventType::kScopeStartAsync;
+  PackedApiEventType type = kType;
+  uint32_t tid = 0;
+  uint64_t timestamp_ns = 0;
+  uint64_t name_key = 0;
+  uint64_t id = 0;
+  uint64_t address_in_function = 0;
+  uint32_t color_rgba = 0;
+  uint32_t padding = 0;
+};
+
+struct PackedApiScopeStopAsync {
+  static constexpr PackedApiEventType kType = PackedApiEventType::kScopeStopAsync;
+  PackedApiEventType type = kType;
+  uint32_t tid = 0;
+  uint64_t timestamp_ns = 0;
+  uint64_t id = 0;
+};
+
+static_assert(sizeof(PackedApiScopeStart) == 48);
+static_assert(sizeof(PackedApiScopeStop) == 16);
+static_assert(sizeof(PackedApiScopeStartAsync) == 48);
+static_assert(sizeof(PackedApiScopeStopAsync) == 24);
+
+template <typename PackedApiEventT>
+void AppendPackedApiEvent(const PackedApiEventT& packed_event, std::string* records) {
+  static_assert(std::is_trivially_copyable_v<PackedApiEventT>);
+  records->append(reinterpret_cast<const char*>(&packed_event), sizeof(packed_event));
+}
+
+// Reads the type of the record starting at `offset`. Returns false if `records` ends before.
+[[nodiscard]] inline bool ReadPackedApiEventType(std::string_view records, size_t offset,
+                                                 PackedApiEventType* type) {
+  if (offset + sizeof(PackedApiEventType) > records.size()) return false;
+  std::memcpy(type, records.data() + offset, sizeof(PackedApiEventType));
+  return true;
+}
+
+// Reads the record starting at `offset`. Returns false if `records` ends before the end of it. The
+// records can't be accessed in place, as `records` has no alignment guarantees.
+template <typename PackedApiEventT>
+[[nodiscard]] bool ReadPackedApiEvent(std::string_view records, size_t offset,
+                                      PackedApiEventT* packed_event) {
+  static_assert(std::is_trivially_copyable_v<PackedApiEventT>);
+  if (offset + sizeof(PackedApiEventT) > records.size()) return false;
+  std::memcpy(packed_event, records.data() + offset, sizeof(PackedApiEventT));
+  return true;
+}
+
+}  // namespace orbit_api
+
+#endif  // ORBIT_API_UTILS_PACKED_API_EVENTS_H_
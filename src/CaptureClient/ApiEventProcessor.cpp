@@ -8,6 +8,9 @@
 
 #include <algorithm>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "ApiInterface/Orbit.h"
 #include "ApiUtils/EncodedString.h"
@@ -22,7 +25,6 @@ using orbit_client_data::ApiStringEvent;
 using orbit_client_data::ApiTrackValue;
 using orbit_client_protos::TimerInfo;
 using orbit_grpc_protos::ApiScopeStart;
-using orbit_grpc_protos::ApiScopeStartAsync;
 
 namespace {
 template <typename Source>
@@ -43,88 +45,122 @@ void EncodedColorToColor(uint32_t encoded_color, orbit_client_protos::Color* col
 }
 }  // namespace
 
-ApiEventProcessor::ApiEventProcessor(CaptureListener* listener) : capture_listener_(listener) {
+ApiEventProcessor::ApiEventProcessor(
+    CaptureListener* listener, const absl::flat_hash_map<uint64_t, std::string>* string_intern_pool)
+    : capture_listener_(listener), string_intern_pool_(string_intern_pool) {
   ORBIT_CHECK(listener != nullptr);
 }
 
+template <typename NamedApiEvent>
+std::string ApiEventProcessor::GetName(const NamedApiEvent& api_event) const {
+  if (api_event.name_key() == 0) return DecodeString(api_event);
+  return GetInternedName(api_event.name_key());
+}
+
+std::string ApiEventProcessor::GetInternedName(uint64_t name_key) const {
+  if (string_intern_pool_ == nullptr) {
+    ORBIT_ERROR("Api event with interned name but no InternedStrings");
+    return "";
+  }
+  auto it = string_intern_pool_->find(name_key);
+  if (it == string_intern_pool_->end()) {
+    ORBIT_ERROR("Api event with unknown name key %u", name_key);
+    return "";
+  }
+  return it->second;
+}
+
+template <typename ApiScopeStartT>
+ApiEventProcessor::OpenScope ApiEventProcessor::CreateOpenScope(
+    const ApiScopeStartT& api_scope_start) {
+  OpenScope open_scope;
+  open_scope.timestamp_ns = api_scope_start.timestamp_ns();
+  open_scope.color_rgba = api_scope_start.color_rgba();
+  if constexpr (std::is_same_v<ApiScopeStartT, ApiScopeStart>) {
+    open_scope.group_id = api_scope_start.group_id();
+  }
+  open_scope.address_in_function = api_scope_start.address_in_function();
+  open_scope.name_key = api_scope_start.name_key();
+  if (open_scope.name_key == 0) open_scope.name = DecodeString(api_scope_start);
+  return open_scope;
+}
+
+void ApiEventProcessor::SetTimerInfoFromOpenScope(OpenScope& open_scope) {
+  timer_info_.set_start(open_scope.timestamp_ns);
+  if (open_scope.color_rgba != kOrbitColorAuto) {
+    EncodedColorToColor(open_scope.color_rgba, timer_info_.mutable_color());
+  }
+  timer_info_.set_group_id(open_scope.group_id);
+  timer_info_.set_address_in_function(open_scope.address_in_function);
+  if (open_scope.name_key == 0) {
+    timer_info_.set_api_scope_name(std::move(open_scope.name));
+  } else {
+    timer_info_.set_api_scope_name(GetInternedName(open_scope.name_key));
+  }
+  timer_info_.set_api_scope_name_key(open_scope.name_key);
+}
+
 void ApiEventProcessor::ProcessApiScopeStart(
     const orbit_grpc_protos::ApiScopeStart& api_scope_start) {
-  synchronous_scopes_stack_by_tid_[api_scope_start.tid()].emplace_back(api_scope_start);
+  auto [it, inserted] = synchronous_scopes_stack_by_tid_.try_emplace(api_scope_start.tid());
+  if (inserted) it->second.reserve(kInitialScopeStackCapacity);
+  it->second.push_back(CreateOpenScope(api_scope_start));
 }
 
 void ApiEventProcessor::ProcessApiScopeStop(
     const orbit_grpc_protos::ApiScopeStop& grpc_api_scope_stop) {
-  std::vector<ApiScopeStart>& event_stack =
-      synchronous_scopes_stack_by_tid_[grpc_api_scope_stop.tid()];
-  if (event_stack.empty()) {
+  auto it = synchronous_scopes_stack_by_tid_.find(grpc_api_scope_stop.tid());
+  if (it == synchronous_scopes_stack_by_tid_.end() || it->second.empty()) {
     // We received a stop event with no matching start event, which is possible if the capture was
     // started between the event's start and stop times.
     return;
   }
-
-  const ApiScopeStart& start_event = event_stack.back();
-  TimerInfo timer_info;
-
-  timer_info.set_start(start_event.timestamp_ns());
-  timer_info.set_end(grpc_api_scope_stop.timestamp_ns());
-  timer_info.set_process_id(grpc_api_scope_stop.pid());
-  timer_info.set_thread_id(grpc_api_scope_stop.tid());
-  timer_info.set_depth(event_stack.size() - 1);
-  timer_info.set_type(TimerInfo::kApiScope);
-
-  if (start_event.color_rgba() != kOrbitColorAuto) {
-    EncodedColorToColor(start_event.color_rgba(), timer_info.mutable_color());
-  }
-
-  timer_info.set_group_id(start_event.group_id());
-  timer_info.set_address_in_function(start_event.address_in_function());
-
-  timer_info.set_api_scope_name(DecodeString(start_event));
-
-  capture_listener_->OnTimer(timer_info);
-  event_stack.pop_back();
+  std::vector<OpenScope>& scope_stack = it->second;
+
+  timer_info_.Clear();
+  timer_info_.set_end(grpc_api_scope_stop.timestamp_ns());
+  timer_info_.set_process_id(grpc_api_scope_stop.pid());
+  timer_info_.set_thread_id(grpc_api_scope_stop.tid());
+  timer_info_.set_depth(scope_stack.size() - 1);
+  timer_info_.set_type(TimerInfo::kApiScope);
+  SetTimerInfoFromOpenScope(scope_stack.back());
+  scope_stack.pop_back();
+
+  capture_listener_->OnTimer(timer_info_);
 }
 
 void ApiEventProcessor::ProcessApiScopeStartAsync(
     const orbit_grpc_protos::ApiScopeStartAsync& grpc_api_scope_start_async) {
-  asynchronous_scopes_by_id_[grpc_api_scope_start_async.id()] = grpc_api_scope_start_async;
+  asynchronous_scopes_by_id_.insert_or_assign(grpc_api_scope_start_async.id(),
+                                              CreateOpenScope(grpc_api_scope_start_async));
 }
 
 void ApiEventProcessor::ProcessApiScopeStopAsync(
     const orbit_grpc_protos::ApiScopeStopAsync& grpc_api_scope_stop_async) {
   uint64_t event_id = grpc_api_scope_stop_async.id();
-  if (!asynchronous_scopes_by_id_.contains(event_id)) {
+  auto it = asynchronous_scopes_by_id_.find(event_id);
+  if (it == asynchronous_scopes_by_id_.end()) {
     // We received a stop event with no matching start event, which is possible if the capture was
     // started between the event's start and stop times.
     return;
   }
 
-  ApiScopeStartAsync& start_event = asynchronous_scopes_by_id_[event_id];
-  TimerInfo timer_info;
-
-  timer_info.set_start(start_event.timestamp_ns());
-  timer_info.set_end(grpc_api_scope_stop_async.timestamp_ns());
-  timer_info.set_process_id(grpc_api_scope_stop_async.pid());
-  timer_info.set_thread_id(grpc_api_scope_stop_async.tid());
-  timer_info.set_depth(0);
-  timer_info.set_type(TimerInfo::kApiScopeAsync);
-
-  if (start_event.color_rgba() != kOrbitColorAuto) {
-    EncodedColorToColor(start_event.color_rgba(), timer_info.mutable_color());
-  }
-
-  timer_info.set_api_async_scope_id(event_id);
-  timer_info.set_address_in_function(start_event.address_in_function());
-
-  timer_info.set_api_scope_name(DecodeString(start_event));
-
-  capture_listener_->OnTimer(timer_info);
-  asynchronous_scopes_by_id_.erase(event_id);
+  timer_info_.Clear();
+  timer_info_.set_end(grpc_api_scope_stop_async.timestamp_ns());
+  timer_info_.set_process_id(grpc_api_scope_stop_async.pid());
+  timer_info_.set_thread_id(grpc_api_scope_stop_async.tid());
+  timer_info_.set_depth(0);
+  timer_info_.set_type(TimerInfo::kApiScopeAsync);
+  timer_info_.set_api_async_scope_id(event_id);
+  SetTimerInfoFromOpenScope(it->second);
+  asynchronous_scopes_by_id_.erase(it);
+
+  capture_listener_->OnTimer(timer_info_);
 }
 
 void ApiEventProcessor::ProcessApiStringEvent(
     const orbit_grpc_protos::ApiStringEvent& grpc_api_string_event) {
-  ApiStringEvent api_string_event{grpc_api_string_event.id(), DecodeString(grpc_api_string_event),
+  ApiStringEvent api_string_event{grpc_api_string_event.id(), GetName(grpc_api_string_event),
                                   /*should_concatenate=*/false};
   capture_listener_->OnApiStringEvent(api_string_event);
 }
@@ -184,4 +220,26 @@ void ApiEventProcessor::ProcessApiTrackUint64(
   capture_listener_->OnApiTrackValue(api_track_value);
 }
 
+void ApiEventProcessor::ProcessApiTrackValueSummary(
+    const orbit_grpc_protos::ApiTrackValueSummary& api_track_value_summary) {
+  const std::string name = GetInternedName(api_track_value_summary.name_key());
+  // The minimum, the maximum, and the last value are enough to draw the track as if it had
+  // received all values of the summary. Several of them can be the same value.
+  std::vector<std::pair<uint64_t, double>> values{
+      {api_track_value_summary.min_timestamp_ns(), api_track_value_summary.min()},
+      {api_track_value_summary.max_timestamp_ns(), api_track_value_summary.max()},
+      {api_track_value_summary.last_timestamp_ns(), api_track_value_summary.last()}};
+  std::sort(values.begin(), values.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  values.erase(std::unique(values.begin(), values.end(),
+                           [](const auto& lhs, const auto& rhs) { return lhs.first == rhs.first; }),
+               values.end());
+
+  for (const auto& [timestamp_ns, value] : values) {
+    ApiTrackValue api_track_value{api_track_value_summary.pid(), api_track_value_summary.tid(),
+                                  timestamp_ns, name, value};
+    capture_listener_->OnApiTrackValue(api_track_value);
+  }
+}
+
 }  // namespace orbit_capture_client
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <absl/container/flat_hash_map.h>
 #include <gmock/gmock.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
@@ -44,7 +45,7 @@ namespace {
 
 class ApiEventProcessorTest : public ::testing::Test {
  public:
-  ApiEventProcessorTest() : api_event_processor_{&capture_listener_} {}
+  ApiEventProcessorTest() : api_event_processor_{&capture_listener_, &string_intern_pool_} {}
 
  protected:
   void SetUp() override {}
@@ -154,6 +155,7 @@ class ApiEventProcessorTest : public ::testing::Test {
   }
 
   MockCaptureListener capture_listener_;
+  absl::flat_hash_map<uint64_t, std::string> string_intern_pool_;
   ApiEventProcessor api_event_processor_;
 
   static constexpr int32_t kProcessId = 42;
@@ -225,6 +227,45 @@ TEST_F(ApiEventProcessorTest, ScopesFromSameThread) {
   EXPECT_TRUE(MessageDifferencer::Equivalent(expected_timer_0, actual_timers[2]));
 }
 
+TEST_F(ApiEventProcessorTest, FieldsOfOneTimerDontCarryOverToTheNext) {
+  constexpr orbit_api_color kColor = static_cast<orbit_api_color>(0x11223344);
+  auto colored_start = CreateStartScope("Colored", 1, kProcessId, kThreadId1, kGroupId,
+                                        kAddressInFunction, kColor);
+  auto async_start = CreateStartScopeAsync("Async", 3, kProcessId, kThreadId2, kId1,
+                                           kAddressInFunction);
+  auto plain_start = CreateStartScope("Plain", 5, kProcessId, kThreadId1, 0, kAddressInFunction);
+
+  std::vector<orbit_client_protos::TimerInfo> actual_timers;
+  EXPECT_CALL(capture_listener_, OnTimer)
+      .Times(3)
+      .WillRepeatedly(
+          Invoke([&actual_timers](const TimerInfo& timer) { actual_timers.push_back(timer); }));
+
+  api_event_processor_.ProcessApiScopeStart(colored_start);
+  api_event_processor_.ProcessApiScopeStop(CreateStopScope(2, kProcessId, kThreadId1));
+  api_event_processor_.ProcessApiScopeStartAsync(async_start);
+  api_event_processor_.ProcessApiScopeStopAsync(
+      CreateStopScopeAsync(4, kProcessId, kThreadId2, kId1));
+  api_event_processor_.ProcessApiScopeStart(plain_start);
+  api_event_processor_.ProcessApiScopeStop(CreateStopScope(6, kProcessId, kThreadId1));
+
+  ASSERT_EQ(actual_timers.size(), 3);
+  auto expected_colored = CreateTimerInfo(1, 2, kProcessId, kThreadId1, "Colored", 0, kGroupId, 0,
+                                          kAddressInFunction, TimerInfo::kApiScope);
+  expected_colored.mutable_color()->set_red(0x11);
+  expected_colored.mutable_color()->set_green(0x22);
+  expected_colored.mutable_color()->set_blue(0x33);
+  expected_colored.mutable_color()->set_alpha(0x44);
+  auto expected_async = CreateTimerInfo(3, 4, kProcessId, kThreadId2, "Async", 0, 0, kId1,
+                                        kAddressInFunction, TimerInfo::kApiScopeAsync);
+  auto expected_plain = CreateTimerInfo(5, 6, kProcessId, kThreadId1, "Plain", 0, 0, 0,
+                                        kAddressInFunction, TimerInfo::kApiScope);
+
+  EXPECT_TRUE(MessageDifferencer::Equivalent(expected_colored, actual_timers[0]));
+  EXPECT_TRUE(MessageDifferencer::Equivalent(expected_async, actual_timers[1]));
+  EXPECT_TRUE(MessageDifferencer::Equivalent(expected_plain, actual_timers[2]));
+}
+
 TEST_F(ApiEventProcessorTest, ScopesFromDifferentThreads) {
   auto start_0 =
       CreateStartScope("Scope0", 1, kProcessId, kThreadId1, kGroupId, kAddressInFunction);
@@ -374,6 +415,50 @@ TEST_F(ApiEventProcessorTest, StringEvent) {
   EXPECT_THAT(actual_string_event.value(), ApiStringEventEq(expected_string_event));
 }
 
+TEST_F(ApiEventProcessorTest, InternedNames) {
+  constexpr uint64_t kScopeNameKey = 1;
+  constexpr uint64_t kAsyncScopeNameKey = 2;
+  constexpr uint64_t kStringNameKey = 3;
+  string_intern_pool_.emplace(kScopeNameKey, "Scope");
+  string_intern_pool_.emplace(kAsyncScopeNameKey, "AsyncScope");
+  string_intern_pool_.emplace(kStringNameKey, "Some string for this id");
+
+  auto start = CreateStartScope("", 1, kProcessId, kThreadId1, kGroupId, kAddressInFunction);
+  start.set_name_key(kScopeNameKey);
+  auto stop = CreateStopScope(2, kProcessId, kThreadId1);
+  auto start_async = CreateStartScopeAsync("", 3, kProcessId, kThreadId1, kId1, kAddressInFunction);
+  start_async.set_name_key(kAsyncScopeNameKey);
+  auto stop_async = CreateStopScopeAsync(4, kProcessId, kThreadId1, kId1);
+  auto string_event = CreateStringEvent(5, kProcessId, kThreadId1, kId1, "");
+  string_event.set_name_key(kStringNameKey);
+
+  std::vector<orbit_client_protos::TimerInfo> actual_timers;
+  EXPECT_CALL(capture_listener_, OnTimer)
+      .Times(2)
+      .WillRepeatedly(
+          Invoke([&actual_timers](const TimerInfo& timer) { actual_timers.push_back(timer); }));
+  std::optional<ApiStringEvent> actual_string_event;
+  EXPECT_CALL(capture_listener_, OnApiStringEvent)
+      .Times(1)
+      .WillOnce(SaveArg<0>(&actual_string_event));
+
+  api_event_processor_.ProcessApiScopeStart(start);
+  api_event_processor_.ProcessApiScopeStop(stop);
+  api_event_processor_.ProcessApiScopeStartAsync(start_async);
+  api_event_processor_.ProcessApiScopeStopAsync(stop_async);
+  api_event_processor_.ProcessApiStringEvent(string_event);
+
+  ASSERT_EQ(actual_timers.size(), 2);
+  EXPECT_EQ(actual_timers[0].api_scope_name(), "Scope");
+  EXPECT_EQ(actual_timers[0].api_scope_name_key(), kScopeNameKey);
+  EXPECT_EQ(actual_timers[1].api_scope_name(), "AsyncScope");
+  EXPECT_EQ(actual_timers[1].api_scope_name_key(), kAsyncScopeNameKey);
+  ASSERT_TRUE(actual_string_event.has_value());
+  EXPECT_THAT(actual_string_event.value(),
+              ApiStringEventEq(ApiStringEvent{kId1, "Some string for this id",
+                                              /*should_concatenate=*/false}));
+}
+
 TEST_F(ApiEventProcessorTest, TrackDouble) {
   auto track_double = CreateTrackValue<double, orbit_grpc_protos::ApiTrackDouble>(
       1, kProcessId, kThreadId1, "Some name", 3.14);
@@ -486,4 +571,66 @@ TEST_F(ApiEventProcessorTest, TrackUint64) {
   EXPECT_THAT(actual_track_value.value(), ApiTrackValueEq(expected_track_value));
 }
 
+TEST_F(ApiEventProcessorTest, TrackValueSummary) {
+  constexpr uint64_t kNameKey = 42;
+  string_intern_pool_.emplace(kNameKey, "Some name");
+
+  orbit_grpc_protos::ApiTrackValueSummary summary;
+  summary.set_pid(kProcessId);
+  summary.set_tid(kThreadId1);
+  summary.set_name_key(kNameKey);
+  summary.set_count(5);
+  summary.set_min(-1.0);
+  summary.set_min_timestamp_ns(3);
+  summary.set_max(2.0);
+  summary.set_max_timestamp_ns(1);
+  summary.set_last(0.5);
+  summary.set_last_timestamp_ns(5);
+
+  std::vector<ApiTrackValue> actual_track_values;
+  EXPECT_CALL(capture_listener_, OnApiTrackValue)
+      .Times(3)
+      .WillRepeatedly(Invoke([&actual_track_values](const ApiTrackValue& track_value) {
+        actual_track_values.push_back(track_value);
+      }));
+
+  api_event_processor_.ProcessApiTrackValueSummary(summary);
+
+  ASSERT_EQ(actual_track_values.size(), 3);
+  EXPECT_THAT(actual_track_values[0],
+              ApiTrackValueEq(ApiTrackValue{kProcessId, kThreadId1, 1, "Some name", 2.0}));
+  EXPECT_THAT(actual_track_values[1],
+              ApiTrackValueEq(ApiTrackValue{kProcessId, kThreadId1, 3, "Some name", -1.0}));
+  EXPECT_THAT(actual_track_values[2],
+              ApiTrackValueEq(ApiTrackValue{kProcessId, kThreadId1, 5, "Some name", 0.5}));
+}
+
+TEST_F(ApiEventProcessorTest, TrackValueSummaryWithSingleValue) {
+  constexpr uint64_t kNameKey = 42;
+  string_intern_pool_.emplace(kNameKey, "Some name");
+
+  orbit_grpc_protos::ApiTrackValueSummary summary;
+  summary.set_pid(kProcessId);
+  summary.set_tid(kThreadId1);
+  summary.set_name_key(kNameKey);
+  summary.set_count(1);
+  summary.set_min(3.14);
+  summary.set_min_timestamp_ns(1);
+  summary.set_max(3.14);
+  summary.set_max_timestamp_ns(1);
+  summary.set_last(3.14);
+  summary.set_last_timestamp_ns(1);
+
+  std::optional<ApiTrackValue> actual_track_value;
+  EXPECT_CALL(capture_listener_, OnApiTrackValue)
+      .Times(1)
+      .WillOnce(SaveArg<0>(&actual_track_value));
+
+  api_event_processor_.ProcessApiTrackValueSummary(summary);
+
+  ASSERT_TRUE(actual_track_value.has_value());
+  EXPECT_THAT(actual_track_value.value(),
+              ApiTrackValueEq(ApiTrackValue{kProcessId, kThreadId1, 1, "Some name", 3.14}));
+}
+
 }  // namespace orbit_capture_client
@@ -5,13 +5,18 @@
 #include "CaptureClient/CaptureClient.h"
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/base/thread_annotations.h>
 #include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include <absl/time/time.h>
 #include <stddef.h>
 
 #include <algorithm>
+#include <deque>
 #include <map>
+#include <optional>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -30,6 +35,7 @@
 #include "OrbitBase/Future.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/ThreadUtils.h"
 
 namespace orbit_capture_client {
 
@@ -114,16 +120,37 @@ std::vector<ApiFunction> FindApiFunctions(const orbit_client_data::ModuleManager
   capture_options.set_stack_dump_size(options.stack_dump_size);
   capture_options.set_thread_state_change_callstack_stack_dump_size(
       options.thread_state_change_callstack_stack_dump_size);
+  capture_options.set_thread_state_change_callstack_min_off_cpu_duration_ns(
+      options.thread_state_change_callstack_min_off_cpu_duration_ns);
+  capture_options.set_off_cpu_time_aggregation_interval_ns(
+      options.off_cpu_time_aggregation_interval_ns);
   capture_options.set_samples_per_second(options.samples_per_second);
 
   capture_options.set_collect_memory_info(options.collect_memory_info);
   constexpr const uint64_t kMsToNs = 1'000'000;
   capture_options.set_memory_sampling_period_ns(options.memory_sampling_period_ms * kMsToNs);
+  capture_options.set_page_fault_sampling_period(options.page_fault_sampling_period);
+  constexpr const uint64_t kMsToUs = 1'000;
+  capture_options.set_pressure_stall_threshold_us(options.pressure_stall_threshold_ms * kMsToUs);
+  capture_options.set_pressure_stall_window_us(options.pressure_stall_window_ms * kMsToUs);
+  capture_options.set_sample_performance_counters(options.sample_performance_counters);
 
   capture_options.set_trace_thread_state(options.collect_thread_states);
+  *capture_options.mutable_additional_thread_state_pids() = {
+      options.additional_thread_state_process_ids.begin(),
+      options.additional_thread_state_process_ids.end()};
   capture_options.set_trace_gpu_driver(options.collect_gpu_jobs);
   capture_options.set_max_local_marker_depth_per_command_buffer(
       options.max_local_marker_depth_per_command_buffer);
+  capture_options.set_use_ring_buffer_wakeups(options.use_ring_buffer_wakeups);
+  capture_options.set_ring_buffer_reader_thread_count(options.ring_buffer_reader_thread_count);
+  capture_options.set_unwinding_thread_count(options.unwinding_thread_count);
+  capture_options.set_flight_recorder_duration_ms(options.flight_recorder_duration_ms);
+  capture_options.set_perf_record_dump_path(options.perf_record_dump_path);
+  capture_options.set_capture_file_path_on_target(options.capture_file_path_on_target);
+  capture_options.set_use_tsc_timestamps(options.use_tsc_timestamps);
+  capture_options.set_subtract_instrumentation_overhead(options.subtract_instrumentation_overhead);
+  capture_options.set_capture_response_compression(options.capture_response_compression);
 
   for (const auto& [function_id, function] : options.selected_functions) {
     InstrumentedFunction* instrumented_function = capture_options.add_instrumented_functions();
@@ -140,6 +167,8 @@ std::vector<ApiFunction> FindApiFunctions(const orbit_client_data::ModuleManager
     instrumented_function->set_is_hotpatchable(function.IsHotpatchable());
     instrumented_function->set_record_arguments(options.record_arguments);
     instrumented_function->set_record_return_value(options.record_return_values);
+    instrumented_function->set_record_one_in_n_calls(options.record_one_in_n_calls);
+    instrumented_function->set_min_duration_ns(options.min_function_call_duration_ns);
   }
 
   for (const auto& [function_id, function] : options.functions_to_record_additional_stack_on) {
@@ -169,6 +198,7 @@ std::vector<ApiFunction> FindApiFunctions(const orbit_client_data::ModuleManager
 
   capture_options.set_enable_api(options.enable_api);
   capture_options.set_enable_introspection(options.enable_introspection);
+  capture_options.set_api_track_aggregation_window_ns(options.api_track_aggregation_window_ns);
   ORBIT_CHECK(options.dynamic_instrumentation_method == CaptureOptions::kKernelUprobes ||
               options.dynamic_instrumentation_method == CaptureOptions::kUserSpaceInstrumentation);
   capture_options.set_dynamic_instrumentation_method(options.dynamic_instrumentation_method);
@@ -182,6 +212,60 @@ std::vector<ApiFunction> FindApiFunctions(const orbit_client_data::ModuleManager
   return capture_options;
 }
 
+// Hands the CaptureResponses read from the gRPC stream to the thread that processes them, in the
+// order in which they were read. Push blocks while kMaxSize responses are waiting, so that the
+// client still doesn't read faster than it can process in the long run. The size of the responses
+// waiting is tracked, as that is the backlog reported to the service.
+class CaptureResponseQueue {
+ public:
+  static constexpr size_t kMaxSize = 64;
+
+  void Push(CaptureResponse response, uint64_t byte_count) {
+    absl::MutexLock lock{&mutex_};
+    mutex_.Await(absl::Condition(
+        +[](std::deque<QueuedResponse>* responses) { return responses->size() < kMaxSize; },
+        &responses_));
+    responses_.push_back({std::move(response), byte_count});
+    byte_count_ += byte_count;
+  }
+
+  // Returns std::nullopt once the queue was closed and all responses were popped.
+  [[nodiscard]] std::optional<CaptureResponse> Pop() {
+    absl::MutexLock lock{&mutex_};
+    mutex_.Await(absl::Condition(
+        +[](CaptureResponseQueue* queue) ABSL_EXCLUSIVE_LOCKS_REQUIRED(queue->mutex_) {
+          return !queue->responses_.empty() || queue->closed_;
+        },
+        this));
+    if (responses_.empty()) return std::nullopt;
+    QueuedResponse queued_response = std::move(responses_.front());
+    responses_.pop_front();
+    byte_count_ -= queued_response.byte_count;
+    return std::move(queued_response.response);
+  }
+
+  void Close() {
+    absl::MutexLock lock{&mutex_};
+    closed_ = true;
+  }
+
+  [[nodiscard]] uint64_t GetByteCount() const {
+    absl::MutexLock lock{&mutex_};
+    return byte_count_;
+  }
+
+ private:
+  struct QueuedResponse {
+    CaptureResponse response;
+    uint64_t byte_count;
+  };
+
+  mutable absl::Mutex mutex_;
+  std::deque<QueuedResponse> responses_ ABSL_GUARDED_BY(mutex_);
+  uint64_t byte_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
 }  // namespace
 
 orbit_base::Future<ErrorMessageOr<CaptureListener::CaptureOutcome>> CaptureClient::Capture(
@@ -213,6 +297,10 @@ ErrorMessageOr<CaptureListener::CaptureOutcome> CaptureClient::CaptureSync(
   ORBIT_SCOPE_FUNCTION;
   writes_done_failed_ = false;
   try_abort_ = false;
+  {
+    absl::MutexLock lock{&write_mutex_};
+    writes_done_ = false;
+  }
   {
     absl::WriterMutexLock lock{&context_and_stream_mutex_};
     ORBIT_CHECK(client_context_ == nullptr);
@@ -242,19 +330,50 @@ ErrorMessageOr<CaptureListener::CaptureOutcome> CaptureClient::CaptureSync(
   }
   ORBIT_LOG("Sent CaptureRequest on Capture's gRPC stream: asking to start capturing");
 
+  // The events are processed on another thread, so that reading, decompressing and parsing the
+  // next CaptureResponse happens while the previous one is processed.
+  CaptureResponseQueue response_queue;
+  // The backlog is reported from this thread, and not from the one reading, as the latter blocks
+  // in Push exactly when the client is behind.
+  std::thread processing_thread{[this, &response_queue, capture_event_processor]() {
+    orbit_base::SetCurrentThreadName("CaptureEvents");
+    constexpr absl::Duration kClientCaptureBacklogReportInterval = absl::Milliseconds(200);
+    absl::Time last_backlog_report_time = absl::Now();
+    while (std::optional<CaptureResponse> response = response_queue.Pop()) {
+      ProcessEvents(capture_event_processor, response->capture_events());
+      if (absl::Now() - last_backlog_report_time >= kClientCaptureBacklogReportInterval) {
+        last_backlog_report_time = absl::Now();
+        SendClientCaptureBacklog(response_queue.GetByteCount());
+      }
+    }
+  }};
+
+  uint64_t total_number_of_bytes_received = 0;
+  // CPU time of this thread spent in `reader_writer_->Read`, which includes decompressing, if
+  // enabled, and parsing the CaptureResponses.
+  uint64_t total_read_cpu_time_ns = 0;
   while (!writes_done_failed_ && !try_abort_) {
     CaptureResponse response;
     bool read_succeeded{};
     {
       absl::ReaderMutexLock lock{&context_and_stream_mutex_};
+      const uint64_t cpu_time_before_read_ns = orbit_base::GetCurrentThreadCpuTimeNs();
       read_succeeded = reader_writer_->Read(&response);
+      total_read_cpu_time_ns += orbit_base::GetCurrentThreadCpuTimeNs() - cpu_time_before_read_ns;
     }
     if (read_succeeded) {
-      ProcessEvents(capture_event_processor, response.capture_events());
+      const uint64_t response_byte_count = response.ByteSizeLong();
+      total_number_of_bytes_received += response_byte_count;
+      response_queue.Push(std::move(response), response_byte_count);
     } else {
       break;
     }
   }
+  response_queue.Close();
+  processing_thread.join();
+  ORBIT_LOG("Total number of bytes received: %u", total_number_of_bytes_received);
+  ORBIT_LOG("CPU time spent reading CaptureResponses: %.3f ms",
+            static_cast<double>(total_read_cpu_time_ns) / 1'000'000);
 
   ErrorMessageOr<void> finish_result = FinishCapture();
   if (try_abort_) {
@@ -301,7 +420,9 @@ bool CaptureClient::StopCapture() {
   {
     absl::ReaderMutexLock lock{&context_and_stream_mutex_};
     ORBIT_CHECK(reader_writer_ != nullptr);
+    absl::MutexLock write_lock{&write_mutex_};
     writes_done_succeeded = reader_writer_->WritesDone();
+    writes_done_ = true;
   }
   if (!writes_done_succeeded) {
     // Normally the capture thread waits until service stops sending messages,
@@ -319,6 +440,22 @@ bool CaptureClient::StopCapture() {
   return true;
 }
 
+void CaptureClient::SendClientCaptureBacklog(uint64_t unprocessed_byte_count) {
+  CaptureRequest request;
+  request.mutable_client_capture_backlog()->set_unprocessed_byte_count(unprocessed_byte_count);
+
+  absl::ReaderMutexLock lock{&context_and_stream_mutex_};
+  ORBIT_CHECK(reader_writer_ != nullptr);
+  absl::MutexLock write_lock{&write_mutex_};
+  // Nothing can be written once the stop of the capture was requested.
+  if (writes_done_) return;
+  // A failure is not fatal: the service then simply doesn't know about the backlog, and Read will
+  // fail, too, if the stream is broken.
+  if (!reader_writer_->Write(request)) {
+    ORBIT_ERROR_ONCE("Sending the client's capture backlog on Capture's gRPC stream");
+  }
+}
+
 bool CaptureClient::AbortCaptureAndWait(int64_t max_wait_ms) {
   {
     absl::ReaderMutexLock lock{&context_and_stream_mutex_};
@@ -372,13 +509,15 @@ ErrorMessageOr<void> CaptureClient::FinishCapture() {
 void CaptureClient::ProcessEvents(
     CaptureEventProcessor* capture_event_processor,
     const google::protobuf::RepeatedPtrField<ClientCaptureEvent>& events) {
-  for (const auto& event : events) {
-    capture_event_processor->ProcessEvent(event);
-    if (event.event_case() == ClientCaptureEvent::kCaptureStarted) {
-      absl::MutexLock lock{&state_mutex_};
-      state_ = State::kStarted;
-      ORBIT_LOG("State is now kStarted");
-    }
+  capture_event_processor->ProcessEvents(events);
+  const bool contains_capture_started =
+      std::any_of(events.begin(), events.end(), [](const ClientCaptureEvent& event) {
+        return event.event_case() == ClientCaptureEvent::kCaptureStarted;
+      });
+  if (contains_capture_started) {
+    absl::MutexLock lock{&state_mutex_};
+    state_ = State::kStarted;
+    ORBIT_LOG("State is now kStarted");
   }
 }
 
@@ -0,0 +1,164 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "CaptureEventFilter.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "CaptureFile/CaptureEventThreadIdsAndTimestamps.h"
+
+using orbit_client_protos::CaptureIndexChunk;
+using orbit_grpc_protos::ClientCaptureEvent;
+
+namespace orbit_capture_client {
+
+namespace {
+
+enum class FilterKind {
+  // The event is always loaded.
+  kNone,
+  // The event is filtered by kind and thread id, but not by time, as the scopes that start and
+  // stop events belong to can overlap the time range with both events outside of it.
+  kThreadId,
+  // The event is filtered by kind, thread id and time.
+  kThreadIdAndTime,
+  // The event is filtered by kind and time, as it doesn't belong to a thread.
+  kTime,
+};
+
+[[nodiscard]] FilterKind GetFilterKind(int event_case) {
+  switch (event_case) {
+    case ClientCaptureEvent::kFunctionCall:
+    case ClientCaptureEvent::kFunctionCallBatch:
+    case ClientCaptureEvent::kSchedulingSlice:
+    case ClientCaptureEvent::kSchedulingSliceBatch:
+    case ClientCaptureEvent::kCallstackSample:
+    case ClientCaptureEvent::kCallstackSampleBatch:
+    case ClientCaptureEvent::kPageFaultSample:
+    case ClientCaptureEvent::kThreadStateSlice:
+    case ClientCaptureEvent::kThreadStateSliceBatch:
+    case ClientCaptureEvent::kOffCpuTimeSummary:
+    case ClientCaptureEvent::kApiStringEvent:
+    case ClientCaptureEvent::kApiTrackDouble:
+    case ClientCaptureEvent::kApiTrackFloat:
+    case ClientCaptureEvent::kApiTrackInt:
+    case ClientCaptureEvent::kApiTrackInt64:
+    case ClientCaptureEvent::kApiTrackUint:
+    case ClientCaptureEvent::kApiTrackUint64:
+    case ClientCaptureEvent::kApiTrackValueSummary:
+    case ClientCaptureEvent::kTracepointEvent:
+    case ClientCaptureEvent::kPresentEvent:
+    case ClientCaptureEvent::kPerformanceCounterSample:
+      return FilterKind::kThreadIdAndTime;
+    case ClientCaptureEvent::kApiScopeStart:
+    case ClientCaptureEvent::kApiScopeStop:
+      return FilterKind::kThreadId;
+    case ClientCaptureEvent::kMemoryUsageEvent:
+    case ClientCaptureEvent::kPressureStallEvent:
+      return FilterKind::kTime;
+    default:
+      return FilterKind::kNone;
+  }
+}
+
+// Visitor of orbit_capture_file::VisitThreadIdsAndTimestamps that records whether any thread id and
+// any timestamp of an event match.
+class EventMatcher {
+ public:
+  EventMatcher(const absl::flat_hash_set<uint32_t>* thread_ids, uint64_t min_timestamp_ns,
+               uint64_t max_timestamp_ns)
+      : thread_ids_{thread_ids},
+        min_timestamp_ns_{min_timestamp_ns},
+        max_timestamp_ns_{max_timestamp_ns} {}
+
+  void OnThreadId(uint32_t tid) {
+    thread_id_matches_ = thread_id_matches_ || thread_ids_->empty() || thread_ids_->contains(tid);
+  }
+  void OnTimestamp(uint64_t timestamp_ns) { OnTimeRange(timestamp_ns, timestamp_ns); }
+  void OnTimeRange(uint64_t start_timestamp_ns, uint64_t end_timestamp_ns) {
+    time_matches_ = time_matches_ || (start_timestamp_ns <= max_timestamp_ns_ &&
+                                      end_timestamp_ns >= min_timestamp_ns_);
+  }
+
+  [[nodiscard]] bool ThreadIdMatches() const { return thread_id_matches_; }
+  [[nodiscard]] bool TimeMatches() const { return time_matches_; }
+
+ private:
+  const absl::flat_hash_set<uint32_t>* thread_ids_;
+  uint64_t min_timestamp_ns_;
+  uint64_t max_timestamp_ns_;
+  bool thread_id_matches_ = false;
+  bool time_matches_ = false;
+};
+
+[[nodiscard]] uint64_t SaturatingAdd(uint64_t a, uint64_t b) {
+  return b > std::numeric_limits<uint64_t>::max() - a ? std::numeric_limits<uint64_t>::max()
+                                                      : a + b;
+}
+
+}  // namespace
+
+CaptureEventFilter::CaptureEventFilter(LoadCaptureFilter filter,
+                                       uint64_t capture_start_timestamp_ns)
+    : filter_{std::move(filter)},
+      min_timestamp_ns_{
+          SaturatingAdd(capture_start_timestamp_ns, filter_.min_relative_timestamp_ns)},
+      max_timestamp_ns_{
+          SaturatingAdd(capture_start_timestamp_ns, filter_.max_relative_timestamp_ns)} {}
+
+bool CaptureEventFilter::MatchesEvent(const ClientCaptureEvent& event) const {
+  const FilterKind filter_kind = GetFilterKind(event.event_case());
+  if (filter_kind == FilterKind::kNone) return true;
+  if (!filter_.event_cases.empty() && !filter_.event_cases.contains(event.event_case())) {
+    return false;
+  }
+
+  EventMatcher matcher{&filter_.thread_ids, min_timestamp_ns_, max_timestamp_ns_};
+  orbit_capture_file::VisitThreadIdsAndTimestamps(event, &matcher);
+  switch (filter_kind) {
+    case FilterKind::kThreadId:
+      return matcher.ThreadIdMatches();
+    case FilterKind::kThreadIdAndTime:
+      return matcher.ThreadIdMatches() && matcher.TimeMatches();
+    case FilterKind::kTime:
+      return matcher.TimeMatches();
+    case FilterKind::kNone:
+      break;
+  }
+  return true;
+}
+
+bool CaptureEventFilter::MayMatchChunk(const CaptureIndexChunk& chunk) const {
+  bool has_event_case_filtered_by_time_only = false;
+  bool has_event_case_not_filtered_by_time = false;
+  bool has_matching_event_case = false;
+  for (const int event_case : chunk.event_cases()) {
+    const FilterKind filter_kind = GetFilterKind(event_case);
+    if (filter_kind == FilterKind::kNone) return true;
+    has_event_case_filtered_by_time_only |= filter_kind == FilterKind::kTime;
+    has_event_case_not_filtered_by_time |= filter_kind == FilterKind::kThreadId;
+    has_matching_event_case |=
+        filter_.event_cases.empty() ||
+        filter_.event_cases.contains(static_cast<ClientCaptureEvent::EventCase>(event_case));
+  }
+  if (!has_matching_event_case) return false;
+
+  // Events that don't belong to a thread don't contribute thread ids to the chunk.
+  if (!filter_.thread_ids.empty() && !has_event_case_filtered_by_time_only &&
+      std::none_of(chunk.tids().begin(), chunk.tids().end(),
+                   [this](uint32_t tid) { return MatchesThreadId(tid); })) {
+    return false;
+  }
+
+  if (!has_event_case_not_filtered_by_time &&
+      !OverlapsTimeRange(chunk.min_timestamp_ns(), chunk.max_timestamp_ns())) {
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace orbit_capture_client
@@ -0,0 +1,46 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CAPTURE_CLIENT_CAPTURE_EVENT_FILTER_H_
+#define CAPTURE_CLIENT_CAPTURE_EVENT_FILTER_H_
+
+#include <stdint.h>
+
+#include "CaptureClient/LoadCapture.h"
+#include "ClientProtos/capture_index.pb.h"
+#include "GrpcProtos/capture.pb.h"
+
+namespace orbit_capture_client {
+
+// Applies a LoadCaptureFilter to the events of a capture file and to the chunks of its
+// CAPTURE_INDEX section.
+class CaptureEventFilter {
+ public:
+  // The relative time range of `filter` refers to `capture_start_timestamp_ns`.
+  CaptureEventFilter(LoadCaptureFilter filter, uint64_t capture_start_timestamp_ns);
+
+  // Returns false if `event` is not to be loaded. Batches are loaded as a whole if any of their
+  // elements matches the filter.
+  [[nodiscard]] bool MatchesEvent(const orbit_grpc_protos::ClientCaptureEvent& event) const;
+  // Returns false if none of the events of `chunk` match the filter, so that the chunk doesn't need
+  // to be parsed. This is conservative: true doesn't imply that any event matches.
+  [[nodiscard]] bool MayMatchChunk(const orbit_client_protos::CaptureIndexChunk& chunk) const;
+
+ private:
+  [[nodiscard]] bool MatchesThreadId(uint32_t tid) const {
+    return filter_.thread_ids.empty() || filter_.thread_ids.contains(tid);
+  }
+  [[nodiscard]] bool OverlapsTimeRange(uint64_t start_timestamp_ns,
+                                       uint64_t end_timestamp_ns) const {
+    return start_timestamp_ns <= max_timestamp_ns_ && end_timestamp_ns >= min_timestamp_ns_;
+  }
+
+  LoadCaptureFilter filter_;
+  uint64_t min_timestamp_ns_;
+  uint64_t max_timestamp_ns_;
+};
+
+}  // namespace orbit_capture_client
+
+#endif  // CAPTURE_CLIENT_CAPTURE_EVENT_FILTER_H_
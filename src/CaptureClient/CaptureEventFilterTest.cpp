@@ -0,0 +1,139 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "CaptureClient/LoadCapture.h"
+#include "CaptureEventFilter.h"
+#include "ClientProtos/capture_index.pb.h"
+#include "GrpcProtos/capture.pb.h"
+
+using orbit_client_protos::CaptureIndexChunk;
+using orbit_grpc_protos::ClientCaptureEvent;
+
+namespace orbit_capture_client {
+
+namespace {
+
+constexpr uint64_t kCaptureStartTimestampNs = 1000;
+
+[[nodiscard]] ClientCaptureEvent CreateFunctionCallEvent(uint32_t tid, uint64_t start_timestamp_ns,
+                                                         uint64_t end_timestamp_ns) {
+  ClientCaptureEvent event;
+  event.mutable_function_call()->set_tid(tid);
+  event.mutable_function_call()->set_duration_ns(end_timestamp_ns - start_timestamp_ns);
+  event.mutable_function_call()->set_end_timestamp_ns(end_timestamp_ns);
+  return event;
+}
+
+[[nodiscard]] CaptureIndexChunk CreateChunk(
+    uint64_t min_timestamp_ns, uint64_t max_timestamp_ns, const std::vector<uint32_t>& tids,
+    const std::vector<ClientCaptureEvent::EventCase>& event_cases) {
+  CaptureIndexChunk chunk;
+  chunk.set_min_timestamp_ns(min_timestamp_ns);
+  chunk.set_max_timestamp_ns(max_timestamp_ns);
+  chunk.mutable_tids()->Add(tids.begin(), tids.end());
+  chunk.mutable_event_cases()->Add(event_cases.begin(), event_cases.end());
+  return chunk;
+}
+
+}  // namespace
+
+TEST(CaptureEventFilter, EmptyFilterMatchesEverything) {
+  CaptureEventFilter filter{LoadCaptureFilter{}, kCaptureStartTimestampNs};
+  EXPECT_TRUE(filter.MatchesEvent(CreateFunctionCallEvent(42, 1000, 1010)));
+  EXPECT_TRUE(
+      filter.MayMatchChunk(CreateChunk(1010, 1020, {42}, {ClientCaptureEvent::kFunctionCall})));
+}
+
+TEST(CaptureEventFilter, FiltersByRelativeTimeRange) {
+  LoadCaptureFilter load_capture_filter;
+  load_capture_filter.min_relative_timestamp_ns = 100;
+  load_capture_filter.max_relative_timestamp_ns = 200;
+  CaptureEventFilter filter{load_capture_filter, kCaptureStartTimestampNs};
+
+  EXPECT_FALSE(filter.MatchesEvent(CreateFunctionCallEvent(42, 1000, 1099)));
+  EXPECT_TRUE(filter.MatchesEvent(CreateFunctionCallEvent(42, 1000, 1100)));
+  EXPECT_TRUE(filter.MatchesEvent(CreateFunctionCallEvent(42, 1000, 1500)));
+  EXPECT_TRUE(filter.MatchesEvent(CreateFunctionCallEvent(42, 1200, 1500)));
+  EXPECT_FALSE(filter.MatchesEvent(CreateFunctionCallEvent(42, 1201, 1500)));
+
+  ClientCaptureEvent batch_event;
+  orbit_grpc_protos::CallstackSampleBatch* batch = batch_event.mutable_callstack_sample_batch();
+  batch->add_tids(42);
+  batch->add_timestamp_deltas_ns(1050);
+  batch->add_tids(42);
+  batch->add_timestamp_deltas_ns(100);
+  EXPECT_TRUE(filter.MatchesEvent(batch_event));
+  batch->set_timestamp_deltas_ns(1, 200);
+  EXPECT_FALSE(filter.MatchesEvent(batch_event));
+
+  // Scope start and stop events are needed for the scopes that overlap the time range.
+  ClientCaptureEvent api_scope_start_event;
+  api_scope_start_event.mutable_api_scope_start()->set_tid(42);
+  api_scope_start_event.mutable_api_scope_start()->set_timestamp_ns(1000);
+  EXPECT_TRUE(filter.MatchesEvent(api_scope_start_event));
+
+  ClientCaptureEvent interned_string_event;
+  interned_string_event.mutable_interned_string()->set_key(1);
+  EXPECT_TRUE(filter.MatchesEvent(interned_string_event));
+
+  EXPECT_FALSE(filter.MayMatchChunk(
+      CreateChunk(1300, 1400, {42}, {ClientCaptureEvent::kFunctionCall})));
+  EXPECT_TRUE(filter.MayMatchChunk(
+      CreateChunk(1150, 1400, {42}, {ClientCaptureEvent::kFunctionCall})));
+  EXPECT_TRUE(filter.MayMatchChunk(CreateChunk(
+      1300, 1400, {42}, {ClientCaptureEvent::kFunctionCall, ClientCaptureEvent::kApiScopeStart})));
+  EXPECT_TRUE(filter.MayMatchChunk(CreateChunk(
+      1300, 1400, {42}, {ClientCaptureEvent::kFunctionCall, ClientCaptureEvent::kInternedString})));
+}
+
+TEST(CaptureEventFilter, FiltersByThreadId) {
+  LoadCaptureFilter load_capture_filter;
+  load_capture_filter.thread_ids = {42};
+  CaptureEventFilter filter{load_capture_filter, kCaptureStartTimestampNs};
+
+  EXPECT_TRUE(filter.MatchesEvent(CreateFunctionCallEvent(42, 1000, 1100)));
+  EXPECT_FALSE(filter.MatchesEvent(CreateFunctionCallEvent(43, 1000, 1100)));
+
+  ClientCaptureEvent memory_usage_event;
+  memory_usage_event.mutable_memory_usage_event()->set_timestamp_ns(1000);
+  EXPECT_TRUE(filter.MatchesEvent(memory_usage_event));
+
+  ClientCaptureEvent thread_name_event;
+  thread_name_event.mutable_thread_name()->set_tid(43);
+  EXPECT_TRUE(filter.MatchesEvent(thread_name_event));
+
+  EXPECT_FALSE(filter.MayMatchChunk(
+      CreateChunk(1000, 1100, {43, 44}, {ClientCaptureEvent::kFunctionCall})));
+  EXPECT_TRUE(filter.MayMatchChunk(
+      CreateChunk(1000, 1100, {42, 43}, {ClientCaptureEvent::kFunctionCall})));
+  // Memory usage events don't contribute thread ids.
+  EXPECT_TRUE(filter.MayMatchChunk(
+      CreateChunk(1000, 1100, {43},
+                  {ClientCaptureEvent::kFunctionCall, ClientCaptureEvent::kMemoryUsageEvent})));
+}
+
+TEST(CaptureEventFilter, FiltersByEventCase) {
+  LoadCaptureFilter load_capture_filter;
+  load_capture_filter.event_cases = {ClientCaptureEvent::kCallstackSample};
+  CaptureEventFilter filter{load_capture_filter, kCaptureStartTimestampNs};
+
+  EXPECT_FALSE(filter.MatchesEvent(CreateFunctionCallEvent(42, 1000, 1100)));
+  ClientCaptureEvent callstack_sample_event;
+  callstack_sample_event.mutable_callstack_sample()->set_tid(42);
+  callstack_sample_event.mutable_callstack_sample()->set_timestamp_ns(1000);
+  EXPECT_TRUE(filter.MatchesEvent(callstack_sample_event));
+
+  EXPECT_FALSE(filter.MayMatchChunk(
+      CreateChunk(1000, 1100, {42}, {ClientCaptureEvent::kFunctionCall})));
+  EXPECT_TRUE(filter.MayMatchChunk(
+      CreateChunk(1000, 1100, {42},
+                  {ClientCaptureEvent::kFunctionCall, ClientCaptureEvent::kCallstackSample})));
+}
+
+}  // namespace orbit_capture_client
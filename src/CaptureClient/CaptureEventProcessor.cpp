@@ -8,16 +8,23 @@
 #include <absl/container/flat_hash_set.h>
 #include <absl/hash/hash.h>
 #include <absl/meta/type_traits.h>
+#include <google/protobuf/repeated_ptr_field.h>
 #include <google/protobuf/stubs/port.h>
 #include <llvm/Demangle/Demangle.h>
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "CaptureClient/ApiEventProcessor.h"
+#include "CaptureClient/ClientCaptureEventBatches.h"
 #include "CaptureClient/GpuQueueSubmissionProcessor.h"
 #include "ClientData/CallstackEvent.h"
 #include "ClientData/CallstackInfo.h"
@@ -54,6 +61,7 @@ using orbit_grpc_protos::GpuJob;
 using orbit_grpc_protos::GpuQueueSubmission;
 using orbit_grpc_protos::InternedCallstack;
 using orbit_grpc_protos::InternedString;
+using orbit_grpc_protos::PageFaultSample;
 using orbit_grpc_protos::SchedulingSlice;
 using orbit_grpc_protos::ThreadName;
 using orbit_grpc_protos::ThreadStateSlice;
@@ -67,17 +75,26 @@ class CaptureEventProcessorForListener : public CaptureEventProcessor {
       : file_path_{std::move(file_path)},
         frame_track_function_ids_(std::move(frame_track_function_ids)),
         capture_listener_(capture_listener),
-        api_event_processor_{capture_listener} {}
+        api_event_processor_{capture_listener, &string_intern_pool_} {}
   ~CaptureEventProcessorForListener() override = default;
 
   void ProcessEvent(const orbit_grpc_protos::ClientCaptureEvent& event) override;
+  void ProcessEvents(
+      const google::protobuf::RepeatedPtrField<orbit_grpc_protos::ClientCaptureEvent>& events)
+      override;
 
  private:
+  // Adds the timers, callstack events and thread state slices that `event` produces to the pending
+  // batches instead of sending them to the listener right away.
+  void ProcessEventIntoPendingBatches(const orbit_grpc_protos::ClientCaptureEvent& event);
+  void SendPendingBatchesToListener();
+
   void ProcessCaptureStarted(const orbit_grpc_protos::CaptureStarted& capture_started);
   void ProcessCaptureFinished(const orbit_grpc_protos::CaptureFinished& capture_finished);
   void ProcessSchedulingSlice(const orbit_grpc_protos::SchedulingSlice& scheduling_slice);
   void ProcessInternedCallstack(orbit_grpc_protos::InternedCallstack interned_callstack);
   void ProcessCallstackSample(const orbit_grpc_protos::CallstackSample& callstack_sample);
+  void ProcessPageFaultSample(const orbit_grpc_protos::PageFaultSample& page_fault_sample);
   void ProcessFunctionCall(const orbit_grpc_protos::FunctionCall& function_call);
   void ProcessInternedString(orbit_grpc_protos::InternedString interned_string);
   void ProcessModuleUpdate(orbit_grpc_protos::ModuleUpdateEvent module_update);
@@ -88,6 +105,10 @@ class CaptureEventProcessorForListener : public CaptureEventProcessor {
   void ProcessThreadNamesSnapshot(
       const orbit_grpc_protos::ThreadNamesSnapshot& thread_names_snapshot);
   void ProcessThreadStateSlice(const orbit_grpc_protos::ThreadStateSlice& thread_state_slice);
+  // Processes each event of the columnar `batch` with `process_event`.
+  template <typename BatchT, typename EventT>
+  void ProcessBatch(const BatchT& batch,
+                    void (CaptureEventProcessorForListener::*process_event)(const EventT&));
   void ProcessAddressInfo(const orbit_grpc_protos::AddressInfo& address_info);
   void ProcessInternedTracepointInfo(
       const orbit_grpc_protos::InternedTracepointInfo& interned_tracepoint_info);
@@ -112,6 +133,8 @@ class CaptureEventProcessorForListener : public CaptureEventProcessor {
       const orbit_grpc_protos::LostPerfRecordsEvent& lost_perf_records_event);
   void ProcessOutOfOrderEventsDiscardedEvent(
       const orbit_grpc_protos::OutOfOrderEventsDiscardedEvent& out_of_order_events_discarded_event);
+  void ProcessPerfEventProcessingStatsEvent(
+      const orbit_grpc_protos::PerfEventProcessingStatsEvent& perf_event_processing_stats_event);
 
   void ProcessMemoryUsageEvent(const orbit_grpc_protos::MemoryUsageEvent& memory_usage_event);
   void ExtractAndProcessSystemMemoryInfo(
@@ -141,9 +164,77 @@ class CaptureEventProcessorForListener : public CaptureEventProcessor {
 
   GpuQueueSubmissionProcessor gpu_queue_submission_processor_;
   ApiEventProcessor api_event_processor_;
+
+  // CaptureStarted.function_call_overhead_ns, if
+  // CaptureOptions.subtract_instrumentation_overhead is set, and zero otherwise.
+  uint64_t function_call_overhead_ns_ = 0;
+  // For each thread and each depth, the number of function calls at that depth that have already
+  // ended, including their descendants, but whose caller hasn't ended yet. Function calls of a
+  // thread arrive in the order in which they end, so this is all that is needed to know how many
+  // instrumented calls are nested in a call.
+  absl::flat_hash_map<uint32_t, std::vector<uint64_t>> tids_to_call_counts_by_depth_;
+
+  std::vector<TimerInfo> pending_timers_;
+  std::vector<CallstackEvent> pending_callstack_events_;
+  std::vector<ThreadStateSliceInfo> pending_thread_state_slices_;
 };
 
+// The events that only result in calls to the listener that are batched, or in the unique
+// callstacks and strings those refer to, don't need the pending batches to be sent first.
+[[nodiscard]] bool CanBeProcessedBeforePendingBatchesAreSent(
+    ClientCaptureEvent::EventCase event_case) {
+  switch (event_case) {
+    case ClientCaptureEvent::kSchedulingSlice:
+    case ClientCaptureEvent::kSchedulingSliceBatch:
+    case ClientCaptureEvent::kInternedCallstack:
+    case ClientCaptureEvent::kCallstackSample:
+    case ClientCaptureEvent::kCallstackSampleBatch:
+    case ClientCaptureEvent::kFunctionCall:
+    case ClientCaptureEvent::kFunctionCallBatch:
+    case ClientCaptureEvent::kInternedString:
+    case ClientCaptureEvent::kGpuJob:
+    case ClientCaptureEvent::kThreadStateSlice:
+    case ClientCaptureEvent::kThreadStateSliceBatch:
+    case ClientCaptureEvent::kGpuQueueSubmission:
+      return true;
+    default:
+      return false;
+  }
+}
+
 void CaptureEventProcessorForListener::ProcessEvent(const ClientCaptureEvent& event) {
+  ProcessEventIntoPendingBatches(event);
+  SendPendingBatchesToListener();
+}
+
+void CaptureEventProcessorForListener::ProcessEvents(
+    const google::protobuf::RepeatedPtrField<ClientCaptureEvent>& events) {
+  for (const ClientCaptureEvent& event : events) {
+    ProcessEventIntoPendingBatches(event);
+  }
+  SendPendingBatchesToListener();
+}
+
+void CaptureEventProcessorForListener::SendPendingBatchesToListener() {
+  if (!pending_timers_.empty()) {
+    capture_listener_->OnTimers(pending_timers_);
+    pending_timers_.clear();
+  }
+  if (!pending_callstack_events_.empty()) {
+    capture_listener_->OnCallstackEvents(pending_callstack_events_);
+    pending_callstack_events_.clear();
+  }
+  if (!pending_thread_state_slices_.empty()) {
+    capture_listener_->OnThreadStateSlices(pending_thread_state_slices_);
+    pending_thread_state_slices_.clear();
+  }
+}
+
+void CaptureEventProcessorForListener::ProcessEventIntoPendingBatches(
+    const ClientCaptureEvent& event) {
+  if (!CanBeProcessedBeforePendingBatchesAreSent(event.event_case())) {
+    SendPendingBatchesToListener();
+  }
   switch (event.event_case()) {
     case ClientCaptureEvent::kCaptureStarted:
       ProcessCaptureStarted(event.capture_started());
@@ -151,15 +242,30 @@ void CaptureEventProcessorForListener::ProcessEvent(const ClientCaptureEvent& ev
     case ClientCaptureEvent::kSchedulingSlice:
       ProcessSchedulingSlice(event.scheduling_slice());
       break;
+    case ClientCaptureEvent::kSchedulingSliceBatch:
+      ProcessBatch(event.scheduling_slice_batch(),
+                   &CaptureEventProcessorForListener::ProcessSchedulingSlice);
+      break;
     case ClientCaptureEvent::kInternedCallstack:
       ProcessInternedCallstack(event.interned_callstack());
       break;
     case ClientCaptureEvent::kCallstackSample:
       ProcessCallstackSample(event.callstack_sample());
       break;
+    case ClientCaptureEvent::kCallstackSampleBatch:
+      ProcessBatch(event.callstack_sample_batch(),
+                   &CaptureEventProcessorForListener::ProcessCallstackSample);
+      break;
+    case ClientCaptureEvent::kPageFaultSample:
+      ProcessPageFaultSample(event.page_fault_sample());
+      break;
     case ClientCaptureEvent::kFunctionCall:
       ProcessFunctionCall(event.function_call());
       break;
+    case ClientCaptureEvent::kFunctionCallBatch:
+      ProcessBatch(event.function_call_batch(),
+                   &CaptureEventProcessorForListener::ProcessFunctionCall);
+      break;
     case ClientCaptureEvent::kInternedString:
       ProcessInternedString(event.interned_string());
       break;
@@ -172,6 +278,10 @@ void CaptureEventProcessorForListener::ProcessEvent(const ClientCaptureEvent& ev
     case ClientCaptureEvent::kThreadStateSlice:
       ProcessThreadStateSlice(event.thread_state_slice());
       break;
+    case ClientCaptureEvent::kThreadStateSliceBatch:
+      ProcessBatch(event.thread_state_slice_batch(),
+                   &CaptureEventProcessorForListener::ProcessThreadStateSlice);
+      break;
     case ClientCaptureEvent::kAddressInfo:
       ProcessAddressInfo(event.address_info());
       break;
@@ -199,6 +309,15 @@ void CaptureEventProcessorForListener::ProcessEvent(const ClientCaptureEvent& ev
     case ClientCaptureEvent::kMemoryUsageEvent:
       ProcessMemoryUsageEvent(event.memory_usage_event());
       break;
+    case ClientCaptureEvent::kPerformanceCounterSample:
+      capture_listener_->OnPerformanceCounterSample(event.performance_counter_sample());
+      break;
+    case ClientCaptureEvent::kOffCpuTimeSummary:
+      capture_listener_->OnOffCpuTimeSummary(event.off_cpu_time_summary());
+      break;
+    case ClientCaptureEvent::kPressureStallEvent:
+      capture_listener_->OnPressureStallEvent(event.pressure_stall_event());
+      break;
     case ClientCaptureEvent::kApiScopeStart:
       api_event_processor_.ProcessApiScopeStart(event.api_scope_start());
       break;
@@ -232,6 +351,9 @@ void CaptureEventProcessorForListener::ProcessEvent(const ClientCaptureEvent& ev
     case ClientCaptureEvent::kApiTrackUint64:
       api_event_processor_.ProcessApiTrackUint64(event.api_track_uint64());
       break;
+    case ClientCaptureEvent::kApiTrackValueSummary:
+      api_event_processor_.ProcessApiTrackValueSummary(event.api_track_value_summary());
+      break;
     case ClientCaptureEvent::kWarningEvent:
       ProcessWarningEvent(event.warning_event());
       break;
@@ -261,6 +383,9 @@ void CaptureEventProcessorForListener::ProcessEvent(const ClientCaptureEvent& ev
     case ClientCaptureEvent::kOutOfOrderEventsDiscardedEvent:
       ProcessOutOfOrderEventsDiscardedEvent(event.out_of_order_events_discarded_event());
       break;
+    case ClientCaptureEvent::kPerfEventProcessingStatsEvent:
+      ProcessPerfEventProcessingStatsEvent(event.perf_event_processing_stats_event());
+      break;
     case ClientCaptureEvent::kCaptureFinished:
       ProcessCaptureFinished(event.capture_finished());
       break;
@@ -272,11 +397,20 @@ void CaptureEventProcessorForListener::ProcessEvent(const ClientCaptureEvent& ev
 
 void CaptureEventProcessorForListener::ProcessCaptureStarted(
     const orbit_grpc_protos::CaptureStarted& capture_started) {
+  function_call_overhead_ns_ = capture_started.capture_options().subtract_instrumentation_overhead()
+                                   ? capture_started.function_call_overhead_ns()
+                                   : 0;
   capture_listener_->OnCaptureStarted(capture_started, file_path_, frame_track_function_ids_);
 }
 
 void CaptureEventProcessorForListener::ProcessCaptureFinished(
     const orbit_grpc_protos::CaptureFinished& capture_finished) {
+  if (gpu_queue_submission_processor_.GetNumEvictedGpuJobs() > 0 ||
+      gpu_queue_submission_processor_.GetNumEvictedGpuQueueSubmissions() > 0) {
+    ORBIT_LOG("Evicted %u GpuJobs and %u GpuQueueSubmissions that were not matched in time",
+              gpu_queue_submission_processor_.GetNumEvictedGpuJobs(),
+              gpu_queue_submission_processor_.GetNumEvictedGpuQueueSubmissions());
+  }
   capture_listener_->OnCaptureFinished(capture_finished);
 }
 
@@ -294,7 +428,7 @@ void CaptureEventProcessorForListener::ProcessSchedulingSlice(
 
   gpu_queue_submission_processor_.UpdateBeginCaptureTime(in_timestamp_ns);
 
-  capture_listener_->OnTimer(timer_info);
+  pending_timers_.push_back(std::move(timer_info));
 }
 
 void CaptureEventProcessorForListener::ProcessInternedCallstack(
@@ -319,7 +453,18 @@ void CaptureEventProcessorForListener::ProcessCallstackSample(
 
   gpu_queue_submission_processor_.UpdateBeginCaptureTime(callstack_sample.timestamp_ns());
 
-  capture_listener_->OnCallstackEvent(callstack_event);
+  pending_callstack_events_.push_back(callstack_event);
+}
+
+void CaptureEventProcessorForListener::ProcessPageFaultSample(
+    const PageFaultSample& page_fault_sample) {
+  uint64_t callstack_id = page_fault_sample.callstack_id();
+  Callstack callstack = callstack_intern_pool_[callstack_id];
+
+  SendCallstackToListenerIfNecessary(callstack_id, callstack);
+
+  capture_listener_->OnPageFaultCallstackEvent(CallstackEvent{
+      page_fault_sample.timestamp_ns(), callstack_id, page_fault_sample.tid()});
 }
 
 void CaptureEventProcessorForListener::ProcessFunctionCall(const FunctionCall& function_call) {
@@ -339,9 +484,26 @@ void CaptureEventProcessorForListener::ProcessFunctionCall(const FunctionCall& f
     timer_info.add_registers(function_call.registers(i));
   }
 
+  if (function_call_overhead_ns_ != 0) {
+    std::vector<uint64_t>& call_counts_by_depth =
+        tids_to_call_counts_by_depth_[function_call.tid()];
+    const size_t depth = function_call.depth();
+    // All the calls deeper than this one that haven't been attributed to a caller yet are nested in
+    // this call.
+    uint64_t descendant_count = 0;
+    if (call_counts_by_depth.size() > depth + 1) {
+      descendant_count =
+          std::accumulate(call_counts_by_depth.begin() + static_cast<ptrdiff_t>(depth) + 1,
+                          call_counts_by_depth.end(), uint64_t{0});
+    }
+    call_counts_by_depth.resize(depth + 1);
+    call_counts_by_depth[depth] += descendant_count + 1;
+    timer_info.set_instrumentation_overhead_ns(descendant_count * function_call_overhead_ns_);
+  }
+
   gpu_queue_submission_processor_.UpdateBeginCaptureTime(begin_timestamp_ns);
 
-  capture_listener_->OnTimer(timer_info);
+  pending_timers_.push_back(std::move(timer_info));
 }
 
 void CaptureEventProcessorForListener::ProcessInternedString(InternedString interned_string) {
@@ -393,7 +555,7 @@ void CaptureEventProcessorForListener::ProcessGpuJob(const GpuJob& gpu_job) {
 
   gpu_queue_submission_processor_.UpdateBeginCaptureTime(gpu_job.amdgpu_cs_ioctl_time_ns());
 
-  capture_listener_->OnTimer(timer_user_to_sched);
+  pending_timers_.push_back(std::move(timer_user_to_sched));
 
   constexpr const char* kHwQueue = "hw queue";
   uint64_t hw_queue_key = GetStringHashAndSendToListenerIfNecessary(kHwQueue);
@@ -408,7 +570,7 @@ void CaptureEventProcessorForListener::ProcessGpuJob(const GpuJob& gpu_job) {
   timer_sched_to_start.set_timeline_hash(timeline_key);
   timer_sched_to_start.set_processor(-1);
   timer_sched_to_start.set_type(TimerInfo::kGpuActivity);
-  capture_listener_->OnTimer(timer_sched_to_start);
+  pending_timers_.push_back(std::move(timer_sched_to_start));
 
   constexpr const char* kHwExecution = "hw execution";
   uint64_t hw_execution_key = GetStringHashAndSendToListenerIfNecessary(kHwExecution);
@@ -423,14 +585,14 @@ void CaptureEventProcessorForListener::ProcessGpuJob(const GpuJob& gpu_job) {
   timer_start_to_finish.set_timeline_hash(timeline_key);
   timer_start_to_finish.set_processor(-1);
   timer_start_to_finish.set_type(TimerInfo::kGpuActivity);
-  capture_listener_->OnTimer(timer_start_to_finish);
+  pending_timers_.push_back(std::move(timer_start_to_finish));
 
   std::vector<TimerInfo> vulkan_related_timers = gpu_queue_submission_processor_.ProcessGpuJob(
       gpu_job, string_intern_pool_,
       [this](std::string_view str) { return GetStringHashAndSendToListenerIfNecessary(str); });
-  for (const TimerInfo& timer : vulkan_related_timers) {
-    capture_listener_->OnTimer(timer);
-  }
+  pending_timers_.insert(pending_timers_.end(),
+                         std::make_move_iterator(vulkan_related_timers.begin()),
+                         std::make_move_iterator(vulkan_related_timers.end()));
 }
 
 void CaptureEventProcessorForListener::ProcessGpuQueueSubmission(
@@ -439,9 +601,9 @@ void CaptureEventProcessorForListener::ProcessGpuQueueSubmission(
       gpu_queue_submission_processor_.ProcessGpuQueueSubmission(
           gpu_queue_submission, string_intern_pool_,
           [this](std::string_view str) { return GetStringHashAndSendToListenerIfNecessary(str); });
-  for (const TimerInfo& timer : vulkan_related_timers) {
-    capture_listener_->OnTimer(timer);
-  }
+  pending_timers_.insert(pending_timers_.end(),
+                         std::make_move_iterator(vulkan_related_timers.begin()),
+                         std::make_move_iterator(vulkan_related_timers.end()));
 }
 
 void CaptureEventProcessorForListener::ProcessMemoryUsageEvent(
@@ -580,7 +742,19 @@ void CaptureEventProcessorForListener::ProcessThreadStateSlice(
 
   gpu_queue_submission_processor_.UpdateBeginCaptureTime(slice_info.begin_timestamp_ns());
 
-  capture_listener_->OnThreadStateSlice(slice_info);
+  pending_thread_state_slices_.push_back(slice_info);
+}
+
+template <typename BatchT, typename EventT>
+void CaptureEventProcessorForListener::ProcessBatch(
+    const BatchT& batch, void (CaptureEventProcessorForListener::*process_event)(const EventT&)) {
+  ErrorMessageOr<void> result =
+      ForEachEventInBatch(batch, [this, process_event](const EventT& event) {
+        (this->*process_event)(event);
+      });
+  if (result.has_error()) {
+    ORBIT_ERROR("Processing batch of events: %s", result.error().message());
+  }
 }
 
 void CaptureEventProcessorForListener::ProcessAddressInfo(const AddressInfo& address_info) {
@@ -675,6 +849,11 @@ void CaptureEventProcessorForListener::ProcessOutOfOrderEventsDiscardedEvent(
   capture_listener_->OnOutOfOrderEventsDiscardedEvent(out_of_order_events_discarded_event);
 }
 
+void CaptureEventProcessorForListener::ProcessPerfEventProcessingStatsEvent(
+    const orbit_grpc_protos::PerfEventProcessingStatsEvent& perf_event_processing_stats_event) {
+  capture_listener_->OnPerfEventProcessingStatsEvent(perf_event_processing_stats_event);
+}
+
 uint64_t CaptureEventProcessorForListener::GetStringHashAndSendToListenerIfNecessary(
     std::string_view str) {
   uint64_t hash = std::hash<std::string_view>{}(str);
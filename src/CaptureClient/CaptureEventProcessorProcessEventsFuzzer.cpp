@@ -57,9 +57,12 @@ class MyCaptureListener : public CaptureListener {
   void OnKeyAndString(uint64_t /*key*/, std::string /*str*/) override {}
   void OnUniqueCallstack(uint64_t /*callstack_id*/, CallstackInfo /*callstack*/) override {}
   void OnCallstackEvent(CallstackEvent /*callstack_event*/) override {}
+  void OnPageFaultCallstackEvent(CallstackEvent /*callstack_event*/) override {}
   void OnThreadName(uint32_t /*thread_id*/, std::string /*thread_name*/) override {}
   void OnThreadStateSlice(orbit_client_data::ThreadStateSliceInfo /*thread_state_slice*/) override {
   }
+  void OnOffCpuTimeSummary(
+      const orbit_grpc_protos::OffCpuTimeSummary& /*off_cpu_time_summary*/) override {}
   void OnAddressInfo(LinuxAddressInfo /*address_info*/) override {}
   void OnUniqueTracepointInfo(uint64_t /*tracepoint_id*/,
                               orbit_client_data::TracepointInfo /*tracepoint_info*/) override {}
@@ -70,6 +73,10 @@ class MyCaptureListener : public CaptureListener {
   void OnModulesSnapshot(uint64_t /*timestamp_ns*/,
                          std::vector<orbit_grpc_protos::ModuleInfo> /*module_infos*/) override {}
   void OnPresentEvent(const orbit_grpc_protos::PresentEvent& /*present_event*/) override {}
+  void OnPressureStallEvent(
+      const orbit_grpc_protos::PressureStallEvent& /*pressure_stall_event*/) override {}
+  void OnPerformanceCounterSample(
+      const orbit_grpc_protos::PerformanceCounterSample& /*performance_counter_sample*/) override {}
   void OnApiStringEvent(const orbit_client_data::ApiStringEvent& /*api_string_event*/) override {}
   void OnApiTrackValue(const orbit_client_data::ApiTrackValue& /*api_track_value*/) override {}
   void OnWarningEvent(orbit_grpc_protos::WarningEvent /*warning_event*/) override {}
@@ -92,6 +99,8 @@ class MyCaptureListener : public CaptureListener {
       orbit_grpc_protos::LostPerfRecordsEvent /*lost_perf_records_event*/) override {}
   void OnOutOfOrderEventsDiscardedEvent(orbit_grpc_protos::OutOfOrderEventsDiscardedEvent
                                         /*out_of_order_events_discarded_event*/) override {}
+  void OnPerfEventProcessingStatsEvent(orbit_grpc_protos::PerfEventProcessingStatsEvent
+                                       /*perf_event_processing_stats_event*/) override {}
 };
 }  // namespace
 
@@ -3,7 +3,9 @@
 // found in the LICENSE file.
 
 #include <absl/hash/hash.h>
+#include <absl/types/span.h>
 #include <gmock/gmock.h>
+#include <google/protobuf/repeated_ptr_field.h>
 #include <gtest/gtest.h>
 #include <stddef.h>
 
@@ -67,8 +69,13 @@ using orbit_grpc_protos::InternedString;
 using orbit_grpc_protos::InternedTracepointInfo;
 using orbit_grpc_protos::LostPerfRecordsEvent;
 using orbit_grpc_protos::MemoryUsageEvent;
+using orbit_grpc_protos::OffCpuTimeSummary;
 using orbit_grpc_protos::OutOfOrderEventsDiscardedEvent;
+using orbit_grpc_protos::PageFaultSample;
+using orbit_grpc_protos::PerfEventProcessingStatsEvent;
+using orbit_grpc_protos::PerformanceCounterSample;
 using orbit_grpc_protos::PresentEvent;
+using orbit_grpc_protos::PressureStallEvent;
 using orbit_grpc_protos::ProcessMemoryUsage;
 using orbit_grpc_protos::SchedulingSlice;
 using orbit_grpc_protos::SystemMemoryUsage;
@@ -136,6 +143,105 @@ TEST(CaptureEventProcessor, CanHandlePresentEvent) {
   EXPECT_EQ(actual_present_event.source(), present_event->source());
 }
 
+TEST(CaptureEventProcessor, CanHandlePressureStallEvent) {
+  MockCaptureListener listener;
+  auto event_processor =
+      CaptureEventProcessor::CreateForCaptureListener(&listener, std::filesystem::path{}, {});
+
+  ClientCaptureEvent event;
+  PressureStallEvent* pressure_stall_event = event.mutable_pressure_stall_event();
+  pressure_stall_event->set_resource(PressureStallEvent::kCpu);
+  pressure_stall_event->set_is_cgroup(false);
+  pressure_stall_event->set_timestamp_ns(100);
+  pressure_stall_event->set_duration_ns(1000);
+  pressure_stall_event->set_some_stall_ns(300);
+  pressure_stall_event->set_full_stall_ns(0);
+
+  PressureStallEvent actual_pressure_stall_event;
+  EXPECT_CALL(listener, OnPressureStallEvent)
+      .Times(1)
+      .WillOnce(SaveArg<0>(&actual_pressure_stall_event));
+  event_processor->ProcessEvent(event);
+
+  EXPECT_EQ(actual_pressure_stall_event.resource(), pressure_stall_event->resource());
+  EXPECT_EQ(actual_pressure_stall_event.is_cgroup(), pressure_stall_event->is_cgroup());
+  EXPECT_EQ(actual_pressure_stall_event.timestamp_ns(), pressure_stall_event->timestamp_ns());
+  EXPECT_EQ(actual_pressure_stall_event.duration_ns(), pressure_stall_event->duration_ns());
+  EXPECT_EQ(actual_pressure_stall_event.some_stall_ns(), pressure_stall_event->some_stall_ns());
+  EXPECT_EQ(actual_pressure_stall_event.full_stall_ns(), pressure_stall_event->full_stall_ns());
+}
+
+TEST(CaptureEventProcessor, CanHandlePerformanceCounterSample) {
+  MockCaptureListener listener;
+  auto event_processor =
+      CaptureEventProcessor::CreateForCaptureListener(&listener, std::filesystem::path{}, {});
+
+  ClientCaptureEvent event;
+  PerformanceCounterSample* performance_counter_sample = event.mutable_performance_counter_sample();
+  performance_counter_sample->set_pid(42);
+  performance_counter_sample->set_tid(24);
+  performance_counter_sample->set_cpu(3);
+  performance_counter_sample->set_timestamp_ns(100);
+  performance_counter_sample->set_cycles(2000);
+  performance_counter_sample->set_instructions(3000);
+  performance_counter_sample->set_cache_misses(40);
+  performance_counter_sample->set_branch_misses(5);
+
+  PerformanceCounterSample actual_performance_counter_sample;
+  EXPECT_CALL(listener, OnPerformanceCounterSample)
+      .Times(1)
+      .WillOnce(SaveArg<0>(&actual_performance_counter_sample));
+  event_processor->ProcessEvent(event);
+
+  EXPECT_EQ(actual_performance_counter_sample.pid(), performance_counter_sample->pid());
+  EXPECT_EQ(actual_performance_counter_sample.tid(), performance_counter_sample->tid());
+  EXPECT_EQ(actual_performance_counter_sample.cpu(), performance_counter_sample->cpu());
+  EXPECT_EQ(actual_performance_counter_sample.timestamp_ns(),
+            performance_counter_sample->timestamp_ns());
+  EXPECT_EQ(actual_performance_counter_sample.cycles(), performance_counter_sample->cycles());
+  EXPECT_EQ(actual_performance_counter_sample.instructions(),
+            performance_counter_sample->instructions());
+  EXPECT_EQ(actual_performance_counter_sample.cache_misses(),
+            performance_counter_sample->cache_misses());
+  EXPECT_EQ(actual_performance_counter_sample.branch_misses(),
+            performance_counter_sample->branch_misses());
+}
+
+TEST(CaptureEventProcessor, CanHandleOffCpuTimeSummary) {
+  MockCaptureListener listener;
+  auto event_processor =
+      CaptureEventProcessor::CreateForCaptureListener(&listener, std::filesystem::path{}, {});
+
+  ClientCaptureEvent event;
+  OffCpuTimeSummary* off_cpu_time_summary = event.mutable_off_cpu_time_summary();
+  off_cpu_time_summary->set_pid(42);
+  off_cpu_time_summary->set_tid(24);
+  off_cpu_time_summary->set_thread_state(ThreadStateSlice::kUninterruptibleSleep);
+  off_cpu_time_summary->set_callstack_id(7);
+  off_cpu_time_summary->set_count(3);
+  off_cpu_time_summary->set_total_duration_ns(300);
+  off_cpu_time_summary->set_min_begin_timestamp_ns(100);
+  off_cpu_time_summary->set_max_end_timestamp_ns(1000);
+
+  OffCpuTimeSummary actual_off_cpu_time_summary;
+  EXPECT_CALL(listener, OnOffCpuTimeSummary)
+      .Times(1)
+      .WillOnce(SaveArg<0>(&actual_off_cpu_time_summary));
+  event_processor->ProcessEvent(event);
+
+  EXPECT_EQ(actual_off_cpu_time_summary.pid(), off_cpu_time_summary->pid());
+  EXPECT_EQ(actual_off_cpu_time_summary.tid(), off_cpu_time_summary->tid());
+  EXPECT_EQ(actual_off_cpu_time_summary.thread_state(), off_cpu_time_summary->thread_state());
+  EXPECT_EQ(actual_off_cpu_time_summary.callstack_id(), off_cpu_time_summary->callstack_id());
+  EXPECT_EQ(actual_off_cpu_time_summary.count(), off_cpu_time_summary->count());
+  EXPECT_EQ(actual_off_cpu_time_summary.total_duration_ns(),
+            off_cpu_time_summary->total_duration_ns());
+  EXPECT_EQ(actual_off_cpu_time_summary.min_begin_timestamp_ns(),
+            off_cpu_time_summary->min_begin_timestamp_ns());
+  EXPECT_EQ(actual_off_cpu_time_summary.max_end_timestamp_ns(),
+            off_cpu_time_summary->max_end_timestamp_ns());
+}
+
 static InternedCallstack* AddAndInitializeInternedCallstack(ClientCaptureEvent& event) {
   InternedCallstack* interned_callstack = event.mutable_interned_callstack();
   interned_callstack->set_key(1);
@@ -218,6 +324,44 @@ TEST(CaptureEventProcessor, CanHandleOneNonCompleteCallstackSample) {
   CanHandleOneCallstackSampleOfType(Callstack::kStackTopForDwarfUnwindingTooSmall);
 }
 
+TEST(CaptureEventProcessor, CanHandlePageFaultSample) {
+  MockCaptureListener listener;
+  auto event_processor =
+      CaptureEventProcessor::CreateForCaptureListener(&listener, std::filesystem::path{}, {});
+
+  ClientCaptureEvent interned_callstack_event;
+  InternedCallstack* interned_callstack =
+      AddAndInitializeInternedCallstack(interned_callstack_event);
+  event_processor->ProcessEvent(interned_callstack_event);
+
+  ClientCaptureEvent event;
+  PageFaultSample* page_fault_sample = event.mutable_page_fault_sample();
+  page_fault_sample->set_pid(1);
+  page_fault_sample->set_tid(3);
+  page_fault_sample->set_callstack_id(interned_callstack->key());
+  page_fault_sample->set_timestamp_ns(100);
+
+  std::optional<CallstackInfo> actual_callstack;
+  EXPECT_CALL(listener, OnUniqueCallstack(interned_callstack->key(), _))
+      .Times(1)
+      .WillOnce([&](uint64_t /*id*/, CallstackInfo callstack) {
+        actual_callstack = std::move(callstack);
+      });
+  std::optional<CallstackEvent> actual_callstack_event;
+  EXPECT_CALL(listener, OnPageFaultCallstackEvent)
+      .Times(1)
+      .WillOnce(SaveArg<0>(&actual_callstack_event));
+  EXPECT_CALL(listener, OnCallstackEvent).Times(0);
+
+  event_processor->ProcessEvent(event);
+  ASSERT_TRUE(actual_callstack.has_value());
+  EXPECT_THAT(actual_callstack->frames(), testing::ElementsAre(14, 15));
+  ASSERT_TRUE(actual_callstack_event.has_value());
+  EXPECT_EQ(actual_callstack_event->timestamp_ns(), 100);
+  EXPECT_EQ(actual_callstack_event->thread_id(), 3);
+  EXPECT_EQ(actual_callstack_event->callstack_id(), interned_callstack->key());
+}
+
 TEST(CaptureEventProcessor, WillOnlyHandleUniqueCallstacksOnce) {
   MockCaptureListener listener;
   auto event_processor =
@@ -336,6 +480,96 @@ TEST(CaptureEventProcessor, CanHandleFunctionCalls) {
   EXPECT_EQ(actual_timer.type(), TimerInfo::kNone);
 }
 
+TEST(CaptureEventProcessor, CanHandleFunctionCallBatches) {
+  MockCaptureListener listener;
+  auto event_processor =
+      CaptureEventProcessor::CreateForCaptureListener(&listener, std::filesystem::path{}, {});
+
+  ClientCaptureEvent event;
+  orbit_grpc_protos::FunctionCallBatch* batch = event.mutable_function_call_batch();
+  for (uint64_t function_id : {123, 124}) {
+    batch->add_pids(42);
+    batch->add_tids(24);
+    batch->add_function_ids(function_id);
+    batch->add_durations_ns(97);
+    batch->add_end_timestamp_deltas_ns(100);
+    batch->add_depths(3);
+    batch->add_return_values(16);
+  }
+
+  std::vector<TimerInfo> actual_timers;
+  EXPECT_CALL(listener, OnTimer).Times(2).WillRepeatedly([&actual_timers](const TimerInfo& timer) {
+    actual_timers.push_back(timer);
+  });
+
+  event_processor->ProcessEvent(event);
+
+  ASSERT_EQ(actual_timers.size(), 2);
+  EXPECT_EQ(actual_timers[0].process_id(), 42);
+  EXPECT_EQ(actual_timers[0].thread_id(), 24);
+  EXPECT_EQ(actual_timers[0].function_id(), 123);
+  EXPECT_EQ(actual_timers[0].start(), 3);
+  EXPECT_EQ(actual_timers[0].end(), 100);
+  EXPECT_EQ(actual_timers[0].depth(), 3);
+  EXPECT_EQ(actual_timers[0].user_data_key(), 16);
+  EXPECT_EQ(actual_timers[1].function_id(), 124);
+  EXPECT_EQ(actual_timers[1].start(), 103);
+  EXPECT_EQ(actual_timers[1].end(), 200);
+}
+
+TEST(CaptureEventProcessor, SubtractsInstrumentationOverheadOfNestedFunctionCalls) {
+  MockCaptureListener listener;
+  auto event_processor =
+      CaptureEventProcessor::CreateForCaptureListener(&listener, std::filesystem::path{}, {});
+
+  constexpr uint64_t kFunctionCallOverheadNs = 10;
+  ClientCaptureEvent capture_started_event;
+  capture_started_event.mutable_capture_started()->set_function_call_overhead_ns(
+      kFunctionCallOverheadNs);
+  capture_started_event.mutable_capture_started()
+      ->mutable_capture_options()
+      ->set_subtract_instrumentation_overhead(true);
+  EXPECT_CALL(listener, OnCaptureStarted).Times(1);
+  event_processor->ProcessEvent(capture_started_event);
+
+  std::vector<TimerInfo> actual_timers;
+  EXPECT_CALL(listener, OnTimer).WillRepeatedly([&actual_timers](const TimerInfo& timer_info) {
+    actual_timers.push_back(timer_info);
+  });
+
+  // Function calls arrive in the order in which they end:
+  // 0: [                          ]
+  // 1:    [             ]  [    ]
+  // 2:       [ ]  [ ]
+  // 3:        []
+  auto process_function_call = [&event_processor](uint64_t start, uint64_t end, uint64_t depth) {
+    ClientCaptureEvent event;
+    FunctionCall* function_call = event.mutable_function_call();
+    function_call->set_tid(24);
+    function_call->set_end_timestamp_ns(end);
+    function_call->set_duration_ns(end - start);
+    function_call->set_depth(depth);
+    event_processor->ProcessEvent(event);
+  };
+  process_function_call(7, 8, 3);
+  process_function_call(6, 9, 2);
+  process_function_call(11, 14, 2);
+  process_function_call(3, 17, 1);
+  process_function_call(20, 25, 1);
+  process_function_call(0, 30, 0);
+
+  ASSERT_EQ(actual_timers.size(), 6);
+  EXPECT_EQ(actual_timers[0].instrumentation_overhead_ns(), 0);
+  EXPECT_EQ(actual_timers[1].instrumentation_overhead_ns(), kFunctionCallOverheadNs);
+  EXPECT_EQ(actual_timers[2].instrumentation_overhead_ns(), 0);
+  EXPECT_EQ(actual_timers[3].instrumentation_overhead_ns(), 3 * kFunctionCallOverheadNs);
+  EXPECT_EQ(actual_timers[4].instrumentation_overhead_ns(), 0);
+  EXPECT_EQ(actual_timers[5].instrumentation_overhead_ns(), 5 * kFunctionCallOverheadNs);
+  // The timers themselves are not changed.
+  EXPECT_EQ(actual_timers[5].start(), 0);
+  EXPECT_EQ(actual_timers[5].end(), 30);
+}
+
 TEST(CaptureEventProcessor, CanHandleThreadNames) {
   MockCaptureListener listener;
   auto event_processor =
@@ -1463,6 +1697,37 @@ TEST(CaptureEventProcessor, CanHandleOutOfOrderEventsDiscardedEvents) {
   EXPECT_EQ(actual_out_of_order_events_discarded_event.end_timestamp_ns(), kEndTimestampNs);
 }
 
+TEST(CaptureEventProcessor, CanHandlePerfEventProcessingStatsEvents) {
+  MockCaptureListener listener;
+  auto event_processor =
+      CaptureEventProcessor::CreateForCaptureListener(&listener, std::filesystem::path{}, {});
+
+  ClientCaptureEvent event;
+  PerfEventProcessingStatsEvent* perf_event_processing_stats_event =
+      event.mutable_perf_event_processing_stats_event();
+  constexpr uint64_t kTimestampNs = 123;
+  perf_event_processing_stats_event->set_timestamp_ns(kTimestampNs);
+  orbit_grpc_protos::PerfEventVisitorStats* visitor_stats =
+      perf_event_processing_stats_event->add_visitor_stats();
+  visitor_stats->set_name("GpuTracepointVisitor");
+  constexpr uint64_t kProcessingTimeNs = 42;
+  visitor_stats->set_processing_time_ns(kProcessingTimeNs);
+
+  PerfEventProcessingStatsEvent actual_perf_event_processing_stats_event;
+  EXPECT_CALL(listener, OnPerfEventProcessingStatsEvent)
+      .Times(1)
+      .WillOnce(SaveArg<0>(&actual_perf_event_processing_stats_event));
+
+  event_processor->ProcessEvent(event);
+
+  EXPECT_EQ(actual_perf_event_processing_stats_event.timestamp_ns(), kTimestampNs);
+  ASSERT_EQ(actual_perf_event_processing_stats_event.visitor_stats_size(), 1);
+  EXPECT_EQ(actual_perf_event_processing_stats_event.visitor_stats(0).name(),
+            "GpuTracepointVisitor");
+  EXPECT_EQ(actual_perf_event_processing_stats_event.visitor_stats(0).processing_time_ns(),
+            kProcessingTimeNs);
+}
+
 TEST(CaptureEventProcessor, CanHandleMultipleEvents) {
   MockCaptureListener listener;
   auto event_processor =
@@ -1510,4 +1775,73 @@ TEST(CaptureEventProcessor, CanHandleMultipleEvents) {
   EXPECT_EQ(actual_address_info->module_path(), kModuleName);
 }
 
+namespace {
+
+class MockBatchCaptureListener : public MockCaptureListener {
+ public:
+  MOCK_METHOD(void, OnTimers, (absl::Span<const TimerInfo>), (override));
+  MOCK_METHOD(void, OnCallstackEvents, (absl::Span<const CallstackEvent>), (override));
+};
+
+ClientCaptureEvent CreateFunctionCallEvent(uint64_t function_id, uint64_t end_timestamp_ns) {
+  ClientCaptureEvent event;
+  FunctionCall* function_call = event.mutable_function_call();
+  function_call->set_pid(42);
+  function_call->set_tid(24);
+  function_call->set_function_id(function_id);
+  function_call->set_duration_ns(10);
+  function_call->set_end_timestamp_ns(end_timestamp_ns);
+  return event;
+}
+
+}  // namespace
+
+TEST(CaptureEventProcessor, ProcessEventsSendsTimersAndCallstackEventsInBatches) {
+  MockBatchCaptureListener listener;
+  auto event_processor =
+      CaptureEventProcessor::CreateForCaptureListener(&listener, std::filesystem::path{}, {});
+
+  google::protobuf::RepeatedPtrField<ClientCaptureEvent> events;
+  AddAndInitializeInternedCallstack(*events.Add());
+  *events.Add() = CreateFunctionCallEvent(1, 100);
+  AddAndInitializeCallstackSample(*events.Add())->set_timestamp_ns(150);
+  *events.Add() = CreateFunctionCallEvent(2, 200);
+  // Not batched, so the timers before it are sent before it.
+  events.Add()->mutable_warning_event()->set_message("message");
+  *events.Add() = CreateFunctionCallEvent(3, 300);
+
+  std::vector<std::vector<uint64_t>> actual_timer_function_ids;
+  std::vector<CallstackEvent> actual_callstack_events;
+  {
+    ::testing::InSequence sequence;
+    EXPECT_CALL(listener, OnUniqueCallstack).Times(1);
+    EXPECT_CALL(listener, OnTimers).WillOnce([&](absl::Span<const TimerInfo> timers) {
+      actual_timer_function_ids.emplace_back();
+      for (const TimerInfo& timer : timers) {
+        actual_timer_function_ids.back().push_back(timer.function_id());
+      }
+    });
+    EXPECT_CALL(listener, OnCallstackEvents)
+        .WillOnce([&](absl::Span<const CallstackEvent> callstack_events) {
+          actual_callstack_events.assign(callstack_events.begin(), callstack_events.end());
+        });
+    EXPECT_CALL(listener, OnWarningEvent).Times(1);
+    EXPECT_CALL(listener, OnTimers).WillOnce([&](absl::Span<const TimerInfo> timers) {
+      actual_timer_function_ids.emplace_back();
+      for (const TimerInfo& timer : timers) {
+        actual_timer_function_ids.back().push_back(timer.function_id());
+      }
+    });
+  }
+  EXPECT_CALL(listener, OnTimer).Times(0);
+  EXPECT_CALL(listener, OnCallstackEvent).Times(0);
+
+  event_processor->ProcessEvents(events);
+
+  EXPECT_THAT(actual_timer_function_ids,
+              ::testing::ElementsAre(::testing::ElementsAre(1, 2), ::testing::ElementsAre(3)));
+  ASSERT_EQ(actual_callstack_events.size(), 1);
+  EXPECT_EQ(actual_callstack_events[0].timestamp_ns(), 150);
+}
+
 }  // namespace orbit_capture_client
@@ -0,0 +1,134 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "CaptureClient/ClientCaptureEventBatches.h"
+
+#include <absl/strings/str_format.h>
+#include <stdint.h>
+
+#include <string_view>
+
+using orbit_grpc_protos::CallstackSample;
+using orbit_grpc_protos::CallstackSampleBatch;
+using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::FunctionCallBatch;
+using orbit_grpc_protos::SchedulingSlice;
+using orbit_grpc_protos::SchedulingSliceBatch;
+using orbit_grpc_protos::ThreadStateSlice;
+using orbit_grpc_protos::ThreadStateSliceBatch;
+
+namespace orbit_capture_client {
+
+namespace {
+
+template <typename... Columns>
+[[nodiscard]] ErrorMessageOr<void> CheckColumnSizes(std::string_view batch_name, int size,
+                                                    const Columns&... columns) {
+  if (((columns.size() != size) || ...)) {
+    return ErrorMessage{
+        absl::StrFormat("%s with %d events has columns of different sizes", batch_name, size)};
+  }
+  return outcome::success();
+}
+
+// Adds the timestamp delta to `*timestamp_ns`, see the batch messages in capture.proto.
+[[nodiscard]] uint64_t ApplyTimestampDelta(int64_t delta_ns, uint64_t* timestamp_ns) {
+  *timestamp_ns += static_cast<uint64_t>(delta_ns);
+  return *timestamp_ns;
+}
+
+}  // namespace
+
+ErrorMessageOr<void> ForEachEventInBatch(
+    const FunctionCallBatch& batch, const std::function<void(const FunctionCall&)>& consumer) {
+  const int size = batch.tids_size();
+  OUTCOME_TRY(CheckColumnSizes("FunctionCallBatch", size, batch.pids(), batch.function_ids(),
+                               batch.durations_ns(), batch.end_timestamp_deltas_ns(),
+                               batch.depths(), batch.return_values()));
+  FunctionCall function_call;
+  uint64_t end_timestamp_ns = 0;
+  for (int i = 0; i < size; ++i) {
+    function_call.set_pid(batch.pids(i));
+    function_call.set_tid(batch.tids(i));
+    function_call.set_function_id(batch.function_ids(i));
+    function_call.set_duration_ns(batch.durations_ns(i));
+    function_call.set_end_timestamp_ns(
+        ApplyTimestampDelta(batch.end_timestamp_deltas_ns(i), &end_timestamp_ns));
+    function_call.set_depth(batch.depths(i));
+    function_call.set_return_value(batch.return_values(i));
+    consumer(function_call);
+  }
+  return outcome::success();
+}
+
+ErrorMessageOr<void> ForEachEventInBatch(
+    const SchedulingSliceBatch& batch,
+    const std::function<void(const SchedulingSlice&)>& consumer) {
+  const int size = batch.tids_size();
+  OUTCOME_TRY(CheckColumnSizes("SchedulingSliceBatch", size, batch.pids(), batch.cores(),
+                               batch.durations_ns(), batch.out_timestamp_deltas_ns()));
+  SchedulingSlice scheduling_slice;
+  uint64_t out_timestamp_ns = 0;
+  for (int i = 0; i < size; ++i) {
+    scheduling_slice.set_pid(batch.pids(i));
+    scheduling_slice.set_tid(batch.tids(i));
+    scheduling_slice.set_core(batch.cores(i));
+    scheduling_slice.set_duration_ns(batch.durations_ns(i));
+    scheduling_slice.set_out_timestamp_ns(
+        ApplyTimestampDelta(batch.out_timestamp_deltas_ns(i), &out_timestamp_ns));
+    consumer(scheduling_slice);
+  }
+  return outcome::success();
+}
+
+ErrorMessageOr<void> ForEachEventInBatch(
+    const CallstackSampleBatch& batch,
+    const std::function<void(const CallstackSample&)>& consumer) {
+  const int size = batch.tids_size();
+  OUTCOME_TRY(CheckColumnSizes("CallstackSampleBatch", size, batch.pids(), batch.callstack_ids(),
+                               batch.timestamp_deltas_ns()));
+  CallstackSample callstack_sample;
+  uint64_t timestamp_ns = 0;
+  for (int i = 0; i < size; ++i) {
+    callstack_sample.set_pid(batch.pids(i));
+    callstack_sample.set_tid(batch.tids(i));
+    callstack_sample.set_callstack_id(batch.callstack_ids(i));
+    callstack_sample.set_timestamp_ns(
+        ApplyTimestampDelta(batch.timestamp_deltas_ns(i), &timestamp_ns));
+    consumer(callstack_sample);
+  }
+  return outcome::success();
+}
+
+ErrorMessageOr<void> ForEachEventInBatch(
+    const ThreadStateSliceBatch& batch,
+    const std::function<void(const ThreadStateSlice&)>& consumer) {
+  const int size = batch.tids_size();
+  OUTCOME_TRY(CheckColumnSizes(
+      "ThreadStateSliceBatch", size, batch.pids(), batch.thread_states(), batch.durations_ns(),
+      batch.end_timestamp_deltas_ns(), batch.wakeup_reasons(), batch.wakeup_tids(),
+      batch.wakeup_pids(), batch.switch_out_or_wakeup_callstack_statuses(),
+      batch.switch_out_or_wakeup_callstack_ids()));
+  ThreadStateSlice thread_state_slice;
+  uint64_t end_timestamp_ns = 0;
+  for (int i = 0; i < size; ++i) {
+    thread_state_slice.set_pid(batch.pids(i));
+    thread_state_slice.set_tid(batch.tids(i));
+    thread_state_slice.set_thread_state(batch.thread_states(i));
+    thread_state_slice.set_duration_ns(batch.durations_ns(i));
+    thread_state_slice.set_end_timestamp_ns(
+        ApplyTimestampDelta(batch.end_timestamp_deltas_ns(i), &end_timestamp_ns));
+    thread_state_slice.set_wakeup_reason(batch.wakeup_reasons(i));
+    thread_state_slice.set_wakeup_tid(batch.wakeup_tids(i));
+    thread_state_slice.set_wakeup_pid(batch.wakeup_pids(i));
+    thread_state_slice.set_switch_out_or_wakeup_callstack_status(
+        batch.switch_out_or_wakeup_callstack_statuses(i));
+    thread_state_slice.set_switch_out_or_wakeup_callstack_id(
+        batch.switch_out_or_wakeup_callstack_ids(i));
+    consumer(thread_state_slice);
+  }
+  return outcome::success();
+}
+
+}  // namespace orbit_capture_client
@@ -0,0 +1,166 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "CaptureClient/ClientCaptureEventBatches.h"
+#include "GrpcProtos/capture.pb.h"
+#include "TestUtils/TestUtils.h"
+
+using orbit_grpc_protos::CallstackSample;
+using orbit_grpc_protos::CallstackSampleBatch;
+using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::FunctionCallBatch;
+using orbit_grpc_protos::SchedulingSlice;
+using orbit_grpc_protos::SchedulingSliceBatch;
+using orbit_grpc_protos::ThreadStateSlice;
+using orbit_grpc_protos::ThreadStateSliceBatch;
+using orbit_test_utils::HasErrorWithMessage;
+using orbit_test_utils::HasNoError;
+
+namespace orbit_capture_client {
+
+TEST(ClientCaptureEventBatches, FunctionCallBatch) {
+  FunctionCallBatch batch;
+  batch.add_pids(42);
+  batch.add_tids(43);
+  batch.add_function_ids(1);
+  batch.add_durations_ns(10);
+  batch.add_end_timestamp_deltas_ns(1000);
+  batch.add_depths(2);
+  batch.add_return_values(3);
+  batch.add_pids(42);
+  batch.add_tids(44);
+  batch.add_function_ids(2);
+  batch.add_durations_ns(20);
+  batch.add_end_timestamp_deltas_ns(-100);
+  batch.add_depths(0);
+  batch.add_return_values(0);
+
+  std::vector<FunctionCall> function_calls;
+  EXPECT_THAT(ForEachEventInBatch(batch,
+                                  [&function_calls](const FunctionCall& function_call) {
+                                    function_calls.push_back(function_call);
+                                  }),
+              HasNoError());
+
+  ASSERT_EQ(function_calls.size(), 2);
+  EXPECT_EQ(function_calls[0].pid(), 42);
+  EXPECT_EQ(function_calls[0].tid(), 43);
+  EXPECT_EQ(function_calls[0].function_id(), 1);
+  EXPECT_EQ(function_calls[0].duration_ns(), 10);
+  EXPECT_EQ(function_calls[0].end_timestamp_ns(), 1000);
+  EXPECT_EQ(function_calls[0].depth(), 2);
+  EXPECT_EQ(function_calls[0].return_value(), 3);
+  EXPECT_EQ(function_calls[1].tid(), 44);
+  EXPECT_EQ(function_calls[1].function_id(), 2);
+  EXPECT_EQ(function_calls[1].end_timestamp_ns(), 900);
+  EXPECT_EQ(function_calls[1].depth(), 0);
+  EXPECT_EQ(function_calls[1].return_value(), 0);
+}
+
+TEST(ClientCaptureEventBatches, SchedulingSliceBatch) {
+  SchedulingSliceBatch batch;
+  for (int32_t core : {1, 2}) {
+    batch.add_pids(42);
+    batch.add_tids(43);
+    batch.add_cores(core);
+    batch.add_durations_ns(50);
+    batch.add_out_timestamp_deltas_ns(500);
+  }
+
+  std::vector<SchedulingSlice> scheduling_slices;
+  EXPECT_THAT(ForEachEventInBatch(batch,
+                                  [&scheduling_slices](const SchedulingSlice& scheduling_slice) {
+                                    scheduling_slices.push_back(scheduling_slice);
+                                  }),
+              HasNoError());
+
+  ASSERT_EQ(scheduling_slices.size(), 2);
+  EXPECT_EQ(scheduling_slices[0].core(), 1);
+  EXPECT_EQ(scheduling_slices[0].out_timestamp_ns(), 500);
+  EXPECT_EQ(scheduling_slices[1].pid(), 42);
+  EXPECT_EQ(scheduling_slices[1].tid(), 43);
+  EXPECT_EQ(scheduling_slices[1].core(), 2);
+  EXPECT_EQ(scheduling_slices[1].duration_ns(), 50);
+  EXPECT_EQ(scheduling_slices[1].out_timestamp_ns(), 1000);
+}
+
+TEST(ClientCaptureEventBatches, CallstackSampleBatch) {
+  CallstackSampleBatch batch;
+  batch.add_pids(42);
+  batch.add_tids(43);
+  batch.add_callstack_ids(5);
+  batch.add_timestamp_deltas_ns(300);
+
+  std::vector<CallstackSample> callstack_samples;
+  EXPECT_THAT(ForEachEventInBatch(batch,
+                                  [&callstack_samples](const CallstackSample& callstack_sample) {
+                                    callstack_samples.push_back(callstack_sample);
+                                  }),
+              HasNoError());
+
+  ASSERT_EQ(callstack_samples.size(), 1);
+  EXPECT_EQ(callstack_samples[0].pid(), 42);
+  EXPECT_EQ(callstack_samples[0].tid(), 43);
+  EXPECT_EQ(callstack_samples[0].callstack_id(), 5);
+  EXPECT_EQ(callstack_samples[0].timestamp_ns(), 300);
+}
+
+TEST(ClientCaptureEventBatches, ThreadStateSliceBatch) {
+  ThreadStateSliceBatch batch;
+  batch.add_pids(0);
+  batch.add_tids(43);
+  batch.add_thread_states(ThreadStateSlice::kRunnable);
+  batch.add_durations_ns(70);
+  batch.add_end_timestamp_deltas_ns(700);
+  batch.add_wakeup_reasons(ThreadStateSlice::kCreated);
+  batch.add_wakeup_tids(44);
+  batch.add_wakeup_pids(42);
+  batch.add_switch_out_or_wakeup_callstack_statuses(ThreadStateSlice::kCallstackSet);
+  batch.add_switch_out_or_wakeup_callstack_ids(6);
+
+  std::vector<ThreadStateSlice> thread_state_slices;
+  EXPECT_THAT(
+      ForEachEventInBatch(batch,
+                          [&thread_state_slices](const ThreadStateSlice& thread_state_slice) {
+                            thread_state_slices.push_back(thread_state_slice);
+                          }),
+      HasNoError());
+
+  ASSERT_EQ(thread_state_slices.size(), 1);
+  EXPECT_EQ(thread_state_slices[0].tid(), 43);
+  EXPECT_EQ(thread_state_slices[0].thread_state(), ThreadStateSlice::kRunnable);
+  EXPECT_EQ(thread_state_slices[0].duration_ns(), 70);
+  EXPECT_EQ(thread_state_slices[0].end_timestamp_ns(), 700);
+  EXPECT_EQ(thread_state_slices[0].wakeup_reason(), ThreadStateSlice::kCreated);
+  EXPECT_EQ(thread_state_slices[0].wakeup_tid(), 44);
+  EXPECT_EQ(thread_state_slices[0].wakeup_pid(), 42);
+  EXPECT_EQ(thread_state_slices[0].switch_out_or_wakeup_callstack_status(),
+            ThreadStateSlice::kCallstackSet);
+  EXPECT_EQ(thread_state_slices[0].switch_out_or_wakeup_callstack_id(), 6);
+}
+
+TEST(ClientCaptureEventBatches, ColumnsOfDifferentSizesAreRejected) {
+  CallstackSampleBatch batch;
+  batch.add_pids(42);
+  batch.add_tids(43);
+  batch.add_tids(44);
+  batch.add_callstack_ids(5);
+  batch.add_timestamp_deltas_ns(300);
+
+  bool consumer_called = false;
+  EXPECT_THAT(ForEachEventInBatch(
+                  batch, [&consumer_called](const CallstackSample& /*callstack_sample*/) {
+                    consumer_called = true;
+                  }),
+              HasErrorWithMessage("different sizes"));
+  EXPECT_FALSE(consumer_called);
+}
+
+}  // namespace orbit_capture_client
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <google/protobuf/repeated_ptr_field.h>
+
 #include <memory>
 #include <utility>
 #include <vector>
@@ -25,6 +27,14 @@ class CompositeEventProcessor : public CaptureEventProcessor {
     }
   }
 
+  void ProcessEvents(
+      const google::protobuf::RepeatedPtrField<orbit_grpc_protos::ClientCaptureEvent>& events)
+      override {
+    for (auto& event_processor : event_processors_) {
+      event_processor->ProcessEvents(events);
+    }
+  }
+
  private:
   std::vector<std::unique_ptr<CaptureEventProcessor>> event_processors_;
 };
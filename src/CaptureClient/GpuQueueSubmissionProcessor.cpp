@@ -6,6 +6,7 @@
 
 #include <absl/meta/type_traits.h>
 #include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
 #include <stddef.h>
 
 #include <tuple>
@@ -19,19 +20,35 @@ using orbit_client_protos::Color;
 using orbit_client_protos::TimerInfo;
 
 using orbit_grpc_protos::GpuCommandBuffer;
+using orbit_grpc_protos::GpuDebugMarker;
 using orbit_grpc_protos::GpuJob;
 using orbit_grpc_protos::GpuQueueSubmission;
 
+namespace {
+constexpr int32_t kUnknownThreadId = -1;
+}  // namespace
+
 std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuQueueSubmission(
     const GpuQueueSubmission& gpu_queue_submission,
     const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
     const std::function<uint64_t(std::string_view str)>&
         get_string_hash_and_send_to_listener_if_necessary) {
+  if (gpu_queue_submission.gpu_timestamps_are_capture_timestamps()) {
+    if (!has_calibrated_gpu_queue_submissions_) {
+      // From now on, `GpuJob`s would only pile up waiting for a matching submission.
+      has_calibrated_gpu_queue_submissions_ = true;
+      tid_to_submission_time_to_gpu_job_.clear();
+    }
+    return ProcessCalibratedGpuQueueSubmission(gpu_queue_submission, string_intern_pool,
+                                               get_string_hash_and_send_to_listener_if_necessary);
+  }
+
   uint32_t thread_id = gpu_queue_submission.meta_info().tid();
   uint64_t pre_submission_cpu_timestamp =
       gpu_queue_submission.meta_info().pre_submission_cpu_timestamp();
   uint64_t post_submission_cpu_timestamp =
       gpu_queue_submission.meta_info().post_submission_cpu_timestamp();
+  EvictStaleEvents(thread_id, pre_submission_cpu_timestamp);
   const GpuJob* matching_gpu_job =
       FindMatchingGpuJob(thread_id, pre_submission_cpu_timestamp, post_submission_cpu_timestamp);
 
@@ -68,8 +85,15 @@ std::vector<orbit_client_protos::TimerInfo> GpuQueueSubmissionProcessor::Process
     const GpuJob& gpu_job, const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
     const std::function<uint64_t(std::string_view str)>&
         get_string_hash_and_send_to_listener_if_necessary) {
+  // The amdgpu driver tracepoints are not needed to convert calibrated submissions, and the
+  // `GpuActivity` timers of the job are produced independently of this class.
+  if (has_calibrated_gpu_queue_submissions_) {
+    return {};
+  }
+
   uint32_t thread_id = gpu_job.tid();
   uint64_t amdgpu_cs_ioctl_time_ns = gpu_job.amdgpu_cs_ioctl_time_ns();
+  EvictStaleEvents(thread_id, amdgpu_cs_ioctl_time_ns);
   const GpuQueueSubmission* matching_gpu_submission =
       FindMatchingGpuQueueSubmission(thread_id, amdgpu_cs_ioctl_time_ns);
 
@@ -179,9 +203,15 @@ std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuQueueSubmissionWit
     return result;
   }
 
-  std::vector<TimerInfo> command_buffer_timers =
-      ProcessGpuCommandBuffers(gpu_queue_submission, matching_gpu_job, first_command_buffer,
-                               timeline_key, get_string_hash_and_send_to_listener_if_necessary);
+  // Note that we assume that the first command buffer starts execution right away when the
+  // hardware starts executing the job.
+  const uint64_t gpu_to_cpu_timestamp_offset =
+      first_command_buffer.has_value() ? matching_gpu_job.gpu_hardware_start_time_ns() -
+                                             first_command_buffer->begin_gpu_timestamp_ns()
+                                       : 0;
+  std::vector<TimerInfo> command_buffer_timers = ProcessGpuCommandBuffers(
+      gpu_queue_submission, gpu_to_cpu_timestamp_offset, matching_gpu_job.depth(), timeline_key,
+      get_string_hash_and_send_to_listener_if_necessary);
 
   result.insert(result.end(), command_buffer_timers.begin(), command_buffer_timers.end());
 
@@ -252,9 +282,79 @@ void GpuQueueSubmissionProcessor::DeleteSavedGpuSubmission(uint32_t thread_id,
   }
 }
 
+void GpuQueueSubmissionProcessor::EvictStaleEvents(uint32_t thread_id, uint64_t timestamp) {
+  if (timestamp < kMaxRetentionNs) {
+    return;
+  }
+  const uint64_t min_timestamp_to_keep = timestamp - kMaxRetentionNs;
+
+  // Both maps are sorted by timestamp, so only their stale prefixes need to be visited. The events
+  // kept for "begin" markers are skipped, and there are only ever few of them.
+  auto post_submission_time_to_gpu_submission_it =
+      tid_to_post_submission_time_to_gpu_submission_.find(thread_id);
+  if (post_submission_time_to_gpu_submission_it !=
+      tid_to_post_submission_time_to_gpu_submission_.end()) {
+    auto& post_submission_time_to_gpu_submission =
+        post_submission_time_to_gpu_submission_it->second;
+    for (auto it = post_submission_time_to_gpu_submission.begin();
+         it != post_submission_time_to_gpu_submission.end() &&
+         it->first < min_timestamp_to_keep;) {
+      if (HasUnprocessedBeginMarkers(thread_id, it->first)) {
+        ++it;
+        continue;
+      }
+      it = post_submission_time_to_gpu_submission.erase(it);
+      ++num_evicted_gpu_queue_submissions_;
+    }
+    if (post_submission_time_to_gpu_submission.empty()) {
+      tid_to_post_submission_time_to_gpu_submission_.erase(
+          post_submission_time_to_gpu_submission_it);
+    }
+  }
+
+  auto submission_time_to_gpu_job_it = tid_to_submission_time_to_gpu_job_.find(thread_id);
+  if (submission_time_to_gpu_job_it != tid_to_submission_time_to_gpu_job_.end()) {
+    auto& submission_time_to_gpu_job = submission_time_to_gpu_job_it->second;
+    for (auto it = submission_time_to_gpu_job.begin();
+         it != submission_time_to_gpu_job.end() && it->first < min_timestamp_to_keep;) {
+      const GpuQueueSubmission* matching_gpu_submission =
+          FindMatchingGpuQueueSubmission(thread_id, it->first);
+      if (matching_gpu_submission != nullptr &&
+          HasUnprocessedBeginMarkers(
+              thread_id, matching_gpu_submission->meta_info().post_submission_cpu_timestamp())) {
+        ++it;
+        continue;
+      }
+      it = submission_time_to_gpu_job.erase(it);
+      ++num_evicted_gpu_jobs_;
+    }
+    if (submission_time_to_gpu_job.empty()) {
+      tid_to_submission_time_to_gpu_job_.erase(submission_time_to_gpu_job_it);
+    }
+  }
+}
+
+std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessCalibratedGpuQueueSubmission(
+    const GpuQueueSubmission& gpu_queue_submission,
+    const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
+    const std::function<uint64_t(std::string_view str)>&
+        get_string_hash_and_send_to_listener_if_necessary) const {
+  const uint64_t timeline_hash = get_string_hash_and_send_to_listener_if_necessary(
+      absl::StrFormat("Vulkan queue %#x", gpu_queue_submission.queue_id()));
+
+  std::vector<TimerInfo> result = ProcessGpuCommandBuffers(
+      gpu_queue_submission, /*gpu_to_cpu_timestamp_offset=*/0, /*depth=*/0, timeline_hash,
+      get_string_hash_and_send_to_listener_if_necessary);
+
+  std::vector<TimerInfo> debug_marker_timers =
+      ProcessCalibratedGpuDebugMarkers(gpu_queue_submission, timeline_hash, string_intern_pool);
+  result.insert(result.end(), debug_marker_timers.begin(), debug_marker_timers.end());
+  return result;
+}
+
 std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuCommandBuffers(
-    const GpuQueueSubmission& gpu_queue_submission, const GpuJob& matching_gpu_job,
-    const std::optional<GpuCommandBuffer>& first_command_buffer, uint64_t timeline_hash,
+    const GpuQueueSubmission& gpu_queue_submission, uint64_t gpu_to_cpu_timestamp_offset,
+    int32_t depth, uint64_t timeline_hash,
     const std::function<uint64_t(std::string_view str)>&
         get_string_hash_and_send_to_listener_if_necessary) const {
   constexpr const char* kCommandBufferLabel = "command buffer";
@@ -268,20 +368,17 @@ std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuCommandBuffers(
 
   for (const auto& submit_info : gpu_queue_submission.submit_infos()) {
     for (const auto& command_buffer : submit_info.command_buffers()) {
-      ORBIT_CHECK(first_command_buffer != std::nullopt);
       TimerInfo command_buffer_timer;
       if (command_buffer.begin_gpu_timestamp_ns() != 0) {
-        command_buffer_timer.set_start(command_buffer.begin_gpu_timestamp_ns() -
-                                       first_command_buffer->begin_gpu_timestamp_ns() +
-                                       matching_gpu_job.gpu_hardware_start_time_ns());
+        command_buffer_timer.set_start(command_buffer.begin_gpu_timestamp_ns() +
+                                       gpu_to_cpu_timestamp_offset);
       } else {
         command_buffer_timer.set_start(begin_capture_time_ns_);
       }
 
-      command_buffer_timer.set_end(command_buffer.end_gpu_timestamp_ns() -
-                                   first_command_buffer->begin_gpu_timestamp_ns() +
-                                   matching_gpu_job.gpu_hardware_start_time_ns());
-      command_buffer_timer.set_depth(matching_gpu_job.depth());
+      command_buffer_timer.set_end(command_buffer.end_gpu_timestamp_ns() +
+                                   gpu_to_cpu_timestamp_offset);
+      command_buffer_timer.set_depth(depth);
       command_buffer_timer.set_timeline_hash(timeline_hash);
       command_buffer_timer.set_processor(-1);
       command_buffer_timer.set_thread_id(thread_id);
@@ -311,8 +408,6 @@ std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuDebugMarkers(
   uint64_t submission_post_submission_cpu_timestamp =
       submission_meta_info.post_submission_cpu_timestamp();
 
-  static constexpr int32_t kUnknownThreadId = -1;
-
   // GpuQueueSubmissions and GpuJobs will be saved if they contain "begin markers"
   // and only ereased again, after all "begin markers" have been processed.
   // The "begin markers" are likely in the same submission as their "end marker",
@@ -405,33 +500,11 @@ std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuDebugMarkers(
     }
 
     marker_timer.set_process_id(submission_process_id);
-    marker_timer.set_depth(completed_marker.depth());
     marker_timer.set_timeline_hash(matching_gpu_job.timeline_key());
-    marker_timer.set_processor(-1);
-    marker_timer.set_type(TimerInfo::kGpuDebugMarker);
     marker_timer.set_end(completed_marker.end_gpu_timestamp_ns() -
                          first_command_buffer->begin_gpu_timestamp_ns() +
                          matching_gpu_job.gpu_hardware_start_time_ns());
-
-    if (completed_marker.has_color()) {
-      Color* color = marker_timer.mutable_color();
-      color->set_red(static_cast<uint32_t>(completed_marker.color().red() * 255.f));
-      color->set_green(static_cast<uint32_t>(completed_marker.color().green() * 255.f));
-      color->set_blue(static_cast<uint32_t>(completed_marker.color().blue() * 255.f));
-      color->set_alpha(static_cast<uint32_t>(completed_marker.color().alpha() * 255.f));
-    }
-
-    const uint64_t text_key = completed_marker.text_key();
-    marker_timer.set_user_data_key(text_key);
-
-    // We have special handling for DXVK instrumentation that have an encoded group_id in their
-    // label.
-    ORBIT_CHECK(string_intern_pool.contains(text_key));
-    const std::string& text = string_intern_pool.at(text_key);
-    uint64_t group_id = 0;
-    if (TryExtractDXVKVulkanGroupIdFromDebugLabel(text, &group_id)) {
-      marker_timer.set_group_id(group_id);
-    }
+    SetDebugMarkerTimerFields(completed_marker, string_intern_pool, &marker_timer);
 
     result.push_back(marker_timer);
   }
@@ -443,6 +516,65 @@ std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessGpuDebugMarkers(
   return result;
 }
 
+std::vector<TimerInfo> GpuQueueSubmissionProcessor::ProcessCalibratedGpuDebugMarkers(
+    const GpuQueueSubmission& gpu_queue_submission, uint64_t timeline_hash,
+    const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool) const {
+  std::vector<TimerInfo> result;
+  const uint32_t submission_thread_id = gpu_queue_submission.meta_info().tid();
+  for (const GpuDebugMarker& completed_marker : gpu_queue_submission.completed_markers()) {
+    TimerInfo marker_timer;
+    // The timestamp of the "begin" marker is already a CPU timestamp, even if it was submitted in
+    // a different submission, so we don't need that submission.
+    if (completed_marker.has_begin_marker()) {
+      marker_timer.set_start(completed_marker.begin_marker().gpu_timestamp_ns());
+      const uint32_t begin_marker_thread_id = completed_marker.begin_marker().meta_info().tid();
+      if (begin_marker_thread_id == submission_thread_id) {
+        marker_timer.set_thread_id(begin_marker_thread_id);
+      } else {
+        marker_timer.set_thread_id(kUnknownThreadId);
+      }
+    } else {
+      marker_timer.set_start(begin_capture_time_ns_);
+      marker_timer.set_thread_id(kUnknownThreadId);
+    }
+    marker_timer.set_end(completed_marker.end_gpu_timestamp_ns());
+    marker_timer.set_process_id(gpu_queue_submission.meta_info().pid());
+    marker_timer.set_timeline_hash(timeline_hash);
+    SetDebugMarkerTimerFields(completed_marker, string_intern_pool, &marker_timer);
+    result.push_back(marker_timer);
+  }
+  return result;
+}
+
+void GpuQueueSubmissionProcessor::SetDebugMarkerTimerFields(
+    const GpuDebugMarker& marker,
+    const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
+    TimerInfo* marker_timer) {
+  marker_timer->set_depth(marker.depth());
+  marker_timer->set_processor(-1);
+  marker_timer->set_type(TimerInfo::kGpuDebugMarker);
+
+  if (marker.has_color()) {
+    Color* color = marker_timer->mutable_color();
+    color->set_red(static_cast<uint32_t>(marker.color().red() * 255.f));
+    color->set_green(static_cast<uint32_t>(marker.color().green() * 255.f));
+    color->set_blue(static_cast<uint32_t>(marker.color().blue() * 255.f));
+    color->set_alpha(static_cast<uint32_t>(marker.color().alpha() * 255.f));
+  }
+
+  const uint64_t text_key = marker.text_key();
+  marker_timer->set_user_data_key(text_key);
+
+  // We have special handling for DXVK instrumentation that have an encoded group_id in their
+  // label.
+  ORBIT_CHECK(string_intern_pool.contains(text_key));
+  const std::string& text = string_intern_pool.at(text_key);
+  uint64_t group_id = 0;
+  if (TryExtractDXVKVulkanGroupIdFromDebugLabel(text, &group_id)) {
+    marker_timer->set_group_id(group_id);
+  }
+}
+
 std::optional<GpuCommandBuffer> GpuQueueSubmissionProcessor::ExtractFirstCommandBuffer(
     const GpuQueueSubmission& gpu_queue_submission) {
   for (const auto& submit_info : gpu_queue_submission.submit_infos()) {
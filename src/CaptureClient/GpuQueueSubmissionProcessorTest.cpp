@@ -189,6 +189,138 @@ TEST_F(GpuQueueSubmissionProcessorTest, DXVKVulkanDebugMarkerEncodesGroupId) {
   EXPECT_TRUE(MessageDifferencer::Equivalent(expected_debug_marker, actual_timers[1]));
 }
 
+TEST_F(GpuQueueSubmissionProcessorTest, CalibratedSubmissionIsProcessedWithoutGpuJob) {
+  static constexpr uint64_t kCommandBufferTextKey = 1234;
+  static constexpr uint64_t kQueueTimelineKey = 5678;
+  auto get_string_hash_and_send_if_necessary_fake = [](std::string_view str) -> uint64_t {
+    if (str == "Vulkan queue 0x42") return kQueueTimelineKey;
+    EXPECT_EQ(str, "command buffer");
+    return kCommandBufferTextKey;
+  };
+
+  GpuQueueSubmission submission;
+  GpuQueueSubmissionMetaInfo* meta_info = CreateGpuQueueSubmissionMetaInfo(&submission, 9, 11);
+  submission.set_gpu_timestamps_are_capture_timestamps(true);
+  submission.set_queue_id(0x42);
+
+  GpuSubmitInfo* submit_info = submission.add_submit_infos();
+  AddGpuCommandBufferToGpuSubmitInfo(submit_info, 100, 109);
+
+  AddGpuDebugMarkerToGpuQueueSubmission(&submission, meta_info, kDXVKGpuLabelKey, 101, 108);
+  submission.set_num_begin_markers(1);
+
+  std::vector<orbit_client_protos::TimerInfo> actual_timers =
+      gpu_queue_submission_processor_.ProcessGpuQueueSubmission(
+          submission, string_intern_pool_, get_string_hash_and_send_if_necessary_fake);
+  ASSERT_EQ(actual_timers.size(), 2);
+
+  TimerInfo expected_command_buffer_timer =
+      CreateTimerInfo(100, 109, kPid, -1, kTid, kQueueTimelineKey, kCommandBufferTextKey, 0, 0,
+                      0.f, 0.f, 0.f, 0.f, TimerInfo_Type_kGpuCommandBuffer);
+
+  TimerInfo expected_debug_marker = CreateTimerInfo(
+      101, 108, kPid, -1, kTid, kQueueTimelineKey, kDXVKGpuLabelKey, kGpuDebugMarkerDepth,
+      kDXVKGpuGroupId, kGpuDebugMarkerAlpha, kGpuDebugMarkerRed, kGpuDebugMarkerGreen,
+      kGpuDebugMarkerBlue, orbit_client_protos::TimerInfo_Type_kGpuDebugMarker);
+
+  EXPECT_TRUE(MessageDifferencer::Equivalent(expected_command_buffer_timer, actual_timers[0]));
+  EXPECT_TRUE(MessageDifferencer::Equivalent(expected_debug_marker, actual_timers[1]));
+
+  // The matching job doesn't yield any timers anymore.
+  orbit_grpc_protos::GpuJob gpu_job = CreateGpuJob(kTimelineKey, 10, 20, 30, 40);
+  EXPECT_TRUE(gpu_queue_submission_processor_
+                  .ProcessGpuJob(gpu_job, string_intern_pool_,
+                                 get_string_hash_and_send_if_necessary_fake)
+                  .empty());
+}
+
+TEST_F(GpuQueueSubmissionProcessorTest, UnmatchedEventsAreEvictedAfterRetention) {
+  static constexpr uint64_t kCommandBufferTextKey = 1234;
+  auto get_string_hash_and_send_if_necessary_fake = [](std::string_view /*str*/) -> uint64_t {
+    return kCommandBufferTextKey;
+  };
+  static constexpr uint64_t kLater = GpuQueueSubmissionProcessor::kMaxRetentionNs + 1000;
+
+  orbit_grpc_protos::GpuJob gpu_job = CreateGpuJob(kTimelineKey, 10, 20, 30, 40);
+  EXPECT_TRUE(gpu_queue_submission_processor_
+                  .ProcessGpuJob(gpu_job, string_intern_pool_,
+                                 get_string_hash_and_send_if_necessary_fake)
+                  .empty());
+  GpuQueueSubmission submission;
+  CreateGpuQueueSubmissionMetaInfo(&submission, 50, 60);
+  AddGpuCommandBufferToGpuSubmitInfo(submission.add_submit_infos(), 100, 109);
+  EXPECT_TRUE(gpu_queue_submission_processor_
+                  .ProcessGpuQueueSubmission(submission, string_intern_pool_,
+                                             get_string_hash_and_send_if_necessary_fake)
+                  .empty());
+  EXPECT_EQ(gpu_queue_submission_processor_.GetNumEvictedGpuJobs(), 0);
+  EXPECT_EQ(gpu_queue_submission_processor_.GetNumEvictedGpuQueueSubmissions(), 0);
+
+  orbit_grpc_protos::GpuJob later_gpu_job =
+      CreateGpuJob(kTimelineKey, kLater + 10, kLater + 20, kLater + 30, kLater + 40);
+  EXPECT_TRUE(gpu_queue_submission_processor_
+                  .ProcessGpuJob(later_gpu_job, string_intern_pool_,
+                                 get_string_hash_and_send_if_necessary_fake)
+                  .empty());
+  EXPECT_EQ(gpu_queue_submission_processor_.GetNumEvictedGpuJobs(), 1);
+  EXPECT_EQ(gpu_queue_submission_processor_.GetNumEvictedGpuQueueSubmissions(), 1);
+
+  // The evicted job is not matched anymore.
+  GpuQueueSubmission late_submission;
+  CreateGpuQueueSubmissionMetaInfo(&late_submission, 9, 11);
+  AddGpuCommandBufferToGpuSubmitInfo(late_submission.add_submit_infos(), 100, 109);
+  EXPECT_TRUE(gpu_queue_submission_processor_
+                  .ProcessGpuQueueSubmission(late_submission, string_intern_pool_,
+                                             get_string_hash_and_send_if_necessary_fake)
+                  .empty());
+}
+
+TEST_F(GpuQueueSubmissionProcessorTest, EventsNeededForBeginMarkersAreNotEvicted) {
+  static constexpr uint64_t kCommandBufferTextKey = 1234;
+  auto get_string_hash_and_send_if_necessary_fake = [](std::string_view /*str*/) -> uint64_t {
+    return kCommandBufferTextKey;
+  };
+  static constexpr uint64_t kLater = GpuQueueSubmissionProcessor::kMaxRetentionNs + 1000;
+
+  orbit_grpc_protos::GpuJob begin_gpu_job = CreateGpuJob(kTimelineKey, 10, 20, 30, 40);
+  EXPECT_TRUE(gpu_queue_submission_processor_
+                  .ProcessGpuJob(begin_gpu_job, string_intern_pool_,
+                                 get_string_hash_and_send_if_necessary_fake)
+                  .empty());
+  GpuQueueSubmission begin_submission;
+  GpuQueueSubmissionMetaInfo* begin_meta_info =
+      CreateGpuQueueSubmissionMetaInfo(&begin_submission, 9, 11);
+  AddGpuCommandBufferToGpuSubmitInfo(begin_submission.add_submit_infos(), 100, 109);
+  begin_submission.set_num_begin_markers(1);
+  EXPECT_EQ(gpu_queue_submission_processor_
+                .ProcessGpuQueueSubmission(begin_submission, string_intern_pool_,
+                                           get_string_hash_and_send_if_necessary_fake)
+                .size(),
+            1);
+
+  orbit_grpc_protos::GpuJob end_gpu_job =
+      CreateGpuJob(kTimelineKey, kLater + 10, kLater + 20, kLater + 30, kLater + 40);
+  EXPECT_TRUE(gpu_queue_submission_processor_
+                  .ProcessGpuJob(end_gpu_job, string_intern_pool_,
+                                 get_string_hash_and_send_if_necessary_fake)
+                  .empty());
+  GpuQueueSubmission end_submission;
+  CreateGpuQueueSubmissionMetaInfo(&end_submission, kLater + 9, kLater + 11);
+  AddGpuCommandBufferToGpuSubmitInfo(end_submission.add_submit_infos(), 200, 209);
+  AddGpuDebugMarkerToGpuQueueSubmission(&end_submission, begin_meta_info, kDXVKGpuLabelKey, 101,
+                                        208);
+  std::vector<orbit_client_protos::TimerInfo> actual_timers =
+      gpu_queue_submission_processor_.ProcessGpuQueueSubmission(
+          end_submission, string_intern_pool_, get_string_hash_and_send_if_necessary_fake);
+  EXPECT_EQ(gpu_queue_submission_processor_.GetNumEvictedGpuJobs(), 0);
+  EXPECT_EQ(gpu_queue_submission_processor_.GetNumEvictedGpuQueueSubmissions(), 0);
+
+  ASSERT_EQ(actual_timers.size(), 2);
+  EXPECT_EQ(actual_timers[1].type(), orbit_client_protos::TimerInfo_Type_kGpuDebugMarker);
+  EXPECT_EQ(actual_timers[1].start(), 31);
+  EXPECT_EQ(actual_timers[1].end(), kLater + 38);
+}
+
 TEST_F(GpuQueueSubmissionProcessorTest, TryExtractDXVKVulkanGroupIdFromDebugLabel) {
   uint64_t group_id = 0;
   EXPECT_FALSE(GpuQueueSubmissionProcessor::TryExtractDXVKVulkanGroupIdFromDebugLabel(
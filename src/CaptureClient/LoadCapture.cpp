@@ -6,25 +6,131 @@
 
 #include <absl/container/flat_hash_set.h>
 #include <absl/hash/hash.h>
+#include <absl/time/time.h>
 #include <google/protobuf/stubs/port.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <deque>
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <vector>
 
 #include "CaptureClient/CaptureEventProcessor.h"
+#include "CaptureEventFilter.h"
+#include "CaptureFile/CaptureFileHelpers.h"
 #include "CaptureFile/CaptureFileSection.h"
 #include "CaptureFile/ProtoSectionInputStream.h"
+#include "ClientProtos/capture_index.pb.h"
 #include "ClientProtos/user_defined_capture_info.pb.h"
 #include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Future.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/ThreadPool.h"
+#include "OrbitBase/UniqueResource.h"
 
 namespace orbit_capture_client {
 
+namespace {
+
+using orbit_client_protos::CaptureIndexChunk;
+using orbit_grpc_protos::ClientCaptureEvent;
+
+// Bounds the number of chunks that are parsed, but not yet processed, and hence memory usage.
+constexpr size_t kMaxParsedChunksPerThread = 2;
+
+// The events that don't match `filter` are dropped here already, so that they don't take up memory
+// while waiting to be processed.
+[[nodiscard]] ErrorMessageOr<std::vector<ClientCaptureEvent>> ParseChunk(
+    orbit_capture_file::CaptureFile* capture_file, const CaptureIndexChunk& chunk,
+    const std::optional<CaptureEventFilter>& filter) {
+  std::unique_ptr<orbit_capture_file::ProtoSectionInputStream> input_stream =
+      capture_file->CreateCaptureSectionInputStreamAtChunk(chunk.offset());
+  std::vector<ClientCaptureEvent> events;
+  // The event count comes from the file, so don't trust it for the allocation.
+  constexpr uint64_t kMaxEventsToReserve = 1 << 16;
+  events.reserve(std::min(chunk.event_count(), kMaxEventsToReserve));
+  for (uint64_t i = 0; i < chunk.event_count(); ++i) {
+    OUTCOME_TRY(input_stream->ReadMessage(&events.emplace_back()));
+    if (filter.has_value() && !filter->MatchesEvent(events.back())) events.pop_back();
+  }
+  return events;
+}
+
+// Parses the chunks listed in the CAPTURE_INDEX section on a thread pool, while the events are
+// processed in order on the calling thread.
+[[nodiscard]] ErrorMessageOr<CaptureListener::CaptureOutcome> LoadCaptureSectionInParallel(
+    orbit_capture_file::CaptureFile* capture_file, const std::vector<CaptureIndexChunk>& chunks,
+    const std::optional<CaptureEventFilter>& filter, CaptureEventProcessor* capture_event_processor,
+    std::atomic<bool>* capture_loading_cancellation_requested) {
+  const size_t thread_count = std::max(1U, std::thread::hardware_concurrency());
+  std::shared_ptr<orbit_base::ThreadPool> thread_pool =
+      orbit_base::ThreadPool::Create(thread_count, thread_count, absl::Seconds(1));
+  // The tasks refer to `chunks`, `filter` and `capture_file`, so wait for them before returning.
+  orbit_base::unique_resource shutdown_thread_pool{
+      thread_pool.get(), [](orbit_base::ThreadPool* pool) { pool->ShutdownAndWait(); }};
+
+  // Holds the chunks in order, so that they are processed in order even if they are parsed out of
+  // order.
+  std::deque<orbit_base::Future<ErrorMessageOr<std::vector<ClientCaptureEvent>>>> parsed_chunks;
+  size_t next_chunk_index = 0;
+  // The chunks that can't contain any event matching `filter` are skipped without being parsed.
+  auto skip_unmatched_chunks = [&]() {
+    while (next_chunk_index < chunks.size() && filter.has_value() &&
+           !filter->MayMatchChunk(chunks[next_chunk_index])) {
+      ++next_chunk_index;
+    }
+  };
+  auto schedule_next_chunk = [&]() {
+    const CaptureIndexChunk* chunk = &chunks[next_chunk_index++];
+    parsed_chunks.push_back(thread_pool->Schedule(
+        [capture_file, chunk, &filter]() { return ParseChunk(capture_file, *chunk, filter); }));
+    skip_unmatched_chunks();
+  };
+  skip_unmatched_chunks();
+  while (next_chunk_index < chunks.size() &&
+         parsed_chunks.size() < thread_count * kMaxParsedChunksPerThread) {
+    schedule_next_chunk();
+  }
+
+  while (!parsed_chunks.empty()) {
+    const ErrorMessageOr<std::vector<ClientCaptureEvent>>& events_or_error =
+        parsed_chunks.front().Get();
+    if (events_or_error.has_error()) return events_or_error.error();
+
+    for (const ClientCaptureEvent& event : events_or_error.value()) {
+      if (*capture_loading_cancellation_requested) {
+        return CaptureListener::CaptureOutcome::kCancelled;
+      }
+      capture_event_processor->ProcessEvent(event);
+      if (event.event_case() == ClientCaptureEvent::kCaptureFinished) {
+        return CaptureListener::CaptureOutcome::kComplete;
+      }
+    }
+
+    parsed_chunks.pop_front();
+    if (next_chunk_index < chunks.size()) schedule_next_chunk();
+  }
+
+  return ErrorMessage{"Unexpected end of section: the capture index has no CaptureFinished event"};
+}
+
+// The relative time range of LoadCaptureFilter refers to the CaptureStarted event, which is the
+// first event of the Capture Section.
+[[nodiscard]] ErrorMessageOr<uint64_t> ReadCaptureStartTimestampNs(
+    orbit_capture_file::CaptureFile* capture_file) {
+  ClientCaptureEvent event;
+  OUTCOME_TRY(capture_file->CreateCaptureSectionInputStream()->ReadMessage(&event));
+  return event.capture_started().capture_start_timestamp_ns();
+}
+
+}  // namespace
+
 [[nodiscard]] ErrorMessageOr<CaptureListener::CaptureOutcome> LoadCapture(
     CaptureListener* listener, orbit_capture_file::CaptureFile* capture_file,
-    std::atomic<bool>* capture_loading_cancellation_requested) {
+    std::atomic<bool>* capture_loading_cancellation_requested, const LoadCaptureFilter& filter) {
   {
     ORBIT_SCOPED_TIMED_LOG("Loading capture from \"%s\"", capture_file->GetFilePath().string());
     absl::flat_hash_set<uint64_t> frame_track_function_ids;
@@ -45,6 +151,21 @@ namespace orbit_capture_client {
         CaptureEventProcessor::CreateForCaptureListener(listener, capture_file->GetFilePath(),
                                                         frame_track_function_ids);
 
+    std::optional<CaptureEventFilter> capture_event_filter;
+    if (!filter.IsEmpty()) {
+      OUTCOME_TRY(const uint64_t capture_start_timestamp_ns,
+                  ReadCaptureStartTimestampNs(capture_file));
+      capture_event_filter.emplace(filter, capture_start_timestamp_ns);
+    }
+
+    OUTCOME_TRY(const std::optional<std::vector<CaptureIndexChunk>> capture_index,
+                orbit_capture_file::ReadCaptureIndex(capture_file));
+    if (capture_index.has_value()) {
+      return LoadCaptureSectionInParallel(capture_file, capture_index.value(),
+                                          capture_event_filter, capture_event_processor.get(),
+                                          capture_loading_cancellation_requested);
+    }
+
     auto capture_section_input_stream = capture_file->CreateCaptureSectionInputStream();
     while (true) {
       if (*capture_loading_cancellation_requested) {
@@ -52,6 +173,7 @@ namespace orbit_capture_client {
       }
       orbit_grpc_protos::ClientCaptureEvent event;
       OUTCOME_TRY(capture_section_input_stream->ReadMessage(&event));
+      if (capture_event_filter.has_value() && !capture_event_filter->MatchesEvent(event)) continue;
       capture_event_processor->ProcessEvent(event);
       if (event.event_case() == orbit_grpc_protos::ClientCaptureEvent::kCaptureFinished) {
         return CaptureListener::CaptureOutcome::kComplete;
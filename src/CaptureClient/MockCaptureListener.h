@@ -26,8 +26,11 @@ class MockCaptureListener : public CaptureListener {
   MOCK_METHOD(void, OnKeyAndString, (uint64_t, std::string), (override));
   MOCK_METHOD(void, OnUniqueCallstack, (uint64_t, orbit_client_data::CallstackInfo), (override));
   MOCK_METHOD(void, OnCallstackEvent, (orbit_client_data::CallstackEvent), (override));
+  MOCK_METHOD(void, OnPageFaultCallstackEvent, (orbit_client_data::CallstackEvent), (override));
   MOCK_METHOD(void, OnThreadName, (uint32_t, std::string), (override));
   MOCK_METHOD(void, OnThreadStateSlice, (orbit_client_data::ThreadStateSliceInfo), (override));
+  MOCK_METHOD(void, OnOffCpuTimeSummary, (const orbit_grpc_protos::OffCpuTimeSummary&),
+              (override));
   MOCK_METHOD(void, OnAddressInfo, (orbit_client_data::LinuxAddressInfo), (override));
   MOCK_METHOD(void, OnUniqueTracepointInfo, (uint64_t, orbit_client_data::TracepointInfo),
               (override));
@@ -36,6 +39,10 @@ class MockCaptureListener : public CaptureListener {
   MOCK_METHOD(void, OnModulesSnapshot, (uint64_t, std::vector<orbit_grpc_protos::ModuleInfo>),
               (override));
   MOCK_METHOD(void, OnPresentEvent, (const orbit_grpc_protos::PresentEvent&), (override));
+  MOCK_METHOD(void, OnPressureStallEvent, (const orbit_grpc_protos::PressureStallEvent&),
+              (override));
+  MOCK_METHOD(void, OnPerformanceCounterSample,
+              (const orbit_grpc_protos::PerformanceCounterSample&), (override));
   MOCK_METHOD(void, OnApiStringEvent, (const orbit_client_data::ApiStringEvent&), (override));
   MOCK_METHOD(void, OnApiTrackValue, (const orbit_client_data::ApiTrackValue&), (override));
   MOCK_METHOD(void, OnWarningEvent, (orbit_grpc_protos::WarningEvent), (override));
@@ -54,6 +61,8 @@ class MockCaptureListener : public CaptureListener {
   MOCK_METHOD(void, OnLostPerfRecordsEvent, (orbit_grpc_protos::LostPerfRecordsEvent), (override));
   MOCK_METHOD(void, OnOutOfOrderEventsDiscardedEvent,
               (orbit_grpc_protos::OutOfOrderEventsDiscardedEvent), (override));
+  MOCK_METHOD(void, OnPerfEventProcessingStatsEvent,
+              (orbit_grpc_protos::PerfEventProcessingStatsEvent), (override));
 };
 
 }  // namespace orbit_capture_client
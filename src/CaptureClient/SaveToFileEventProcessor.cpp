@@ -2,21 +2,31 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <absl/base/thread_annotations.h>
 #include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 
+#include <deque>
 #include <filesystem>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "CaptureClient/CaptureEventProcessor.h"
+#include "CaptureFile/CaptureFileHelpers.h"
 #include "CaptureFile/CaptureFileOutputStream.h"
 #include "ClientProtos/user_defined_capture_info.pb.h"
 #include "GrpcProtos/capture.pb.h"
+#include "Introspection/Introspection.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/ThreadUtils.h"
 
 using orbit_capture_file::CaptureFileOutputStream;
+using orbit_capture_file::CaptureSectionCompression;
 using orbit_client_protos::UserDefinedCaptureInfo;
 using orbit_grpc_protos::ClientCaptureEvent;
 
@@ -24,6 +34,15 @@ namespace orbit_capture_client {
 
 namespace {
 
+// Events are handed over to the writer thread in batches of this many events.
+constexpr size_t kMaxEventsPerBatch = 4096;
+// The maximum number of batches handed over to the writer thread that it hasn't finished writing
+// yet. ProcessEvent only waits for the writer thread when this is exceeded, which bounds the memory
+// used for pending events when the disk can't keep up.
+constexpr size_t kMaxBatchesInFlight = 2;
+
+// Saves the events to a capture file. Events are collected in batches, and compressing and writing
+// them is done on a separate writer thread, so that ProcessEvent doesn't wait for the disk.
 class SaveToFileEventProcessor : public CaptureEventProcessor {
  public:
   explicit SaveToFileEventProcessor(std::filesystem::path file_path,
@@ -31,7 +50,7 @@ class SaveToFileEventProcessor : public CaptureEventProcessor {
       : file_path_{std::move(file_path)},
         error_handler_{std::move(error_handler)},
         state_{State::kProcessing} {}
-  ~SaveToFileEventProcessor() override = default;
+  ~SaveToFileEventProcessor() override;
 
   ErrorMessageOr<void> Initialize();
   void ProcessEvent(const ClientCaptureEvent& event) override;
@@ -44,21 +63,48 @@ class SaveToFileEventProcessor : public CaptureEventProcessor {
   };
 
   void ReportError(const ErrorMessage& error);
+  // Hands `filling_batch_` over to the writer thread. Waits if kMaxBatchesInFlight batches are
+  // already in flight. Returns the error that made the writer thread stop, if any.
+  [[nodiscard]] ErrorMessageOr<void> SubmitFillingBatch();
+  // Waits for the writer thread to write all submitted batches, and joins it.
+  [[nodiscard]] ErrorMessageOr<void> StopWriterThread();
+  void RunWriterThread();
+  [[nodiscard]] bool CanSubmitBatch() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] bool HasBatchesToWriteOrIsStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   std::filesystem::path file_path_;
   std::function<void(const ErrorMessage&)> error_handler_;
+  // Only accessed by the writer thread while it's running.
   std::unique_ptr<CaptureFileOutputStream> output_stream_;
   State state_;
+  std::vector<ClientCaptureEvent> filling_batch_;
+
+  absl::Mutex mutex_;
+  std::deque<std::vector<ClientCaptureEvent>> batches_to_write_ ABSL_GUARDED_BY(mutex_);
+  bool is_writing_batch_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stop_writer_thread_ ABSL_GUARDED_BY(mutex_) = false;
+  std::optional<ErrorMessage> writer_error_ ABSL_GUARDED_BY(mutex_);
+  std::thread writer_thread_;
 };
 
+SaveToFileEventProcessor::~SaveToFileEventProcessor() {
+  if (writer_thread_.joinable()) (void)StopWriterThread();
+}
+
 ErrorMessageOr<void> SaveToFileEventProcessor::Initialize() {
-  auto stream_or_error = CaptureFileOutputStream::Create(file_path_);
+  auto stream_or_error = CaptureFileOutputStream::Create(
+      file_path_, CaptureSectionCompression::kZlib);
   if (stream_or_error.has_error()) {
     return ErrorMessage{absl::StrFormat("Failed to initialize CaptureSaveToFileProcessor: %s",
                                         stream_or_error.error().message())};
   }
 
   output_stream_ = std::move(stream_or_error.value());
+  filling_batch_.reserve(kMaxEventsPerBatch);
+  writer_thread_ = std::thread{[this] {
+    orbit_base::SetCurrentThreadName("SaveToFile");
+    RunWriterThread();
+  }};
 
   return outcome::success();
 }
@@ -68,6 +114,73 @@ void SaveToFileEventProcessor::ReportError(const ErrorMessage& error) {
   state_ = State::kErrorReported;
 }
 
+bool SaveToFileEventProcessor::CanSubmitBatch() const {
+  return writer_error_.has_value() ||
+         batches_to_write_.size() + (is_writing_batch_ ? 1 : 0) < kMaxBatchesInFlight;
+}
+
+bool SaveToFileEventProcessor::HasBatchesToWriteOrIsStopping() const {
+  return stop_writer_thread_ || !batches_to_write_.empty();
+}
+
+ErrorMessageOr<void> SaveToFileEventProcessor::SubmitFillingBatch() {
+  if (filling_batch_.empty()) return outcome::success();
+
+  std::vector<ClientCaptureEvent> batch;
+  batch.reserve(kMaxEventsPerBatch);
+  std::swap(batch, filling_batch_);
+
+  absl::MutexLock lock{&mutex_};
+  mutex_.Await(absl::Condition(this, &SaveToFileEventProcessor::CanSubmitBatch));
+  if (writer_error_.has_value()) return writer_error_.value();
+  batches_to_write_.push_back(std::move(batch));
+  return outcome::success();
+}
+
+ErrorMessageOr<void> SaveToFileEventProcessor::StopWriterThread() {
+  {
+    absl::MutexLock lock{&mutex_};
+    stop_writer_thread_ = true;
+  }
+  writer_thread_.join();
+
+  absl::MutexLock lock{&mutex_};
+  if (writer_error_.has_value()) return writer_error_.value();
+  return outcome::success();
+}
+
+void SaveToFileEventProcessor::RunWriterThread() {
+  while (true) {
+    std::vector<ClientCaptureEvent> batch;
+    {
+      absl::MutexLock lock{&mutex_};
+      mutex_.Await(
+          absl::Condition(this, &SaveToFileEventProcessor::HasBatchesToWriteOrIsStopping));
+      // Submitted batches are still written when stopping.
+      if (batches_to_write_.empty()) return;
+      batch = std::move(batches_to_write_.front());
+      batches_to_write_.pop_front();
+      is_writing_batch_ = true;
+    }
+
+    ORBIT_SCOPE("SaveToFileEventProcessor::WriteBatch");
+    for (const ClientCaptureEvent& event : batch) {
+      auto write_result = output_stream_->WriteCaptureEvent(event);
+      if (write_result.has_error()) {
+        // The output stream is closed after an error, so the remaining events are dropped.
+        absl::MutexLock lock{&mutex_};
+        writer_error_ = write_result.error();
+        batches_to_write_.clear();
+        is_writing_batch_ = false;
+        return;
+      }
+    }
+
+    absl::MutexLock lock{&mutex_};
+    is_writing_batch_ = false;
+  }
+}
+
 void SaveToFileEventProcessor::ProcessEvent(const ClientCaptureEvent& event) {
   ORBIT_CHECK(output_stream_ != nullptr);
 
@@ -78,24 +191,44 @@ void SaveToFileEventProcessor::ProcessEvent(const ClientCaptureEvent& event) {
 
   if (state_ == State::kErrorReported) return;
 
-  ORBIT_CHECK(output_stream_->IsOpen());
+  filling_batch_.push_back(event);
+
+  if (event.event_case() != ClientCaptureEvent::kCaptureFinished) {
+    if (filling_batch_.size() < kMaxEventsPerBatch) return;
 
-  auto write_result = output_stream_->WriteCaptureEvent(event);
-  if (write_result.has_error()) {
-    ReportError(write_result.error());
+    auto submit_result = SubmitFillingBatch();
+    if (submit_result.has_error()) ReportError(submit_result.error());
     return;
   }
 
-  if (event.event_case() == ClientCaptureEvent::kCaptureFinished) {
-    // We are done - close the stream.
-    auto close_result = output_stream_->Close();
-    if (close_result.has_error()) {
-      ReportError(close_result.error());
-      return;
-    }
+  // We are done - write the remaining events and close the stream. The writer thread has been
+  // joined after that, so output_stream_ can be accessed on this thread again.
+  auto submit_result = SubmitFillingBatch();
+  auto stop_result = StopWriterThread();
+  if (submit_result.has_error()) {
+    ReportError(submit_result.error());
+    return;
+  }
+  if (stop_result.has_error()) {
+    ReportError(stop_result.error());
+    return;
+  }
 
-    state_ = State::kCaptureFinished;
+  ORBIT_CHECK(output_stream_->IsOpen());
+  auto close_result = output_stream_->Close();
+  if (close_result.has_error()) {
+    ReportError(close_result.error());
+    return;
   }
+
+  auto write_index_result =
+      orbit_capture_file::WriteCaptureIndex(file_path_, output_stream_->GetCaptureIndex());
+  if (write_index_result.has_error()) {
+    ReportError(write_index_result.error());
+    return;
+  }
+
+  state_ = State::kCaptureFinished;
 }
 
 }  // namespace
@@ -108,11 +108,52 @@ TEST(SaveToFileEventProcessor, SaveAndLoadSimpleCapture) {
   }
 
   const auto& sections = capture_file->GetSectionList();
-  EXPECT_EQ(sections.size(), 0);
+  ASSERT_EQ(sections.size(), 1);
+  EXPECT_EQ(sections[0].type, orbit_capture_file::kSectionTypeCaptureIndex);
 
   std::optional<size_t> user_data_section =
       capture_file->FindSectionByType(orbit_capture_file::kSectionTypeUserData);
   EXPECT_FALSE(user_data_section.has_value());
 }
 
-}  // namespace orbit_capture_client
\ No newline at end of file
+TEST(SaveToFileEventProcessor, SavesManyEventsInOrder) {
+  auto temporary_dir_or_error = TemporaryDirectory::Create();
+  ASSERT_TRUE(temporary_dir_or_error.has_value()) << temporary_dir_or_error.error().message();
+  TemporaryDirectory temporary_dir = std::move(temporary_dir_or_error.value());
+
+  auto error_handler = [](const ErrorMessage& error) { FAIL() << error.message(); };
+
+  std::filesystem::path capture_file_path = temporary_dir.GetDirectoryPath() / "capture.orbit";
+  auto capture_event_processor_or_error =
+      CaptureEventProcessor::CreateSaveToFileProcessor(capture_file_path, error_handler);
+  ASSERT_TRUE(capture_event_processor_or_error.has_value())
+      << capture_event_processor_or_error.error().message();
+
+  // Enough events to be handed over to the writer thread in several batches.
+  constexpr uint64_t kEventCount = 20'000;
+  std::unique_ptr<CaptureEventProcessor> capture_event_processor =
+      std::move(capture_event_processor_or_error.value());
+  for (uint64_t key = 0; key < kEventCount; ++key) {
+    capture_event_processor->ProcessEvent(CreateInternedStringEvent(key, "intern"));
+  }
+  capture_event_processor->ProcessEvent(CreateCaptureFinishedEvent());
+  capture_event_processor.reset();
+
+  auto capture_file_or_error = CaptureFile::OpenForReadWrite(capture_file_path);
+  ASSERT_THAT(capture_file_or_error, HasValue());
+  auto capture_section_input_stream =
+      capture_file_or_error.value()->CreateCaptureSectionInputStream();
+
+  for (uint64_t key = 0; key < kEventCount; ++key) {
+    ClientCaptureEvent event;
+    ASSERT_THAT(capture_section_input_stream->ReadMessage(&event), HasNoError());
+    ASSERT_EQ(event.event_case(), ClientCaptureEvent::kInternedString);
+    ASSERT_EQ(event.interned_string().key(), key);
+  }
+
+  ClientCaptureEvent event;
+  ASSERT_THAT(capture_section_input_stream->ReadMessage(&event), HasNoError());
+  EXPECT_EQ(event.event_case(), ClientCaptureEvent::kCaptureFinished);
+}
+
+}  // namespace orbit_capture_client
@@ -5,6 +5,8 @@
 #ifndef CAPTURE_CLIENT_ABSTRACT_CAPTURE_LISTENER_H_
 #define CAPTURE_CLIENT_ABSTRACT_CAPTURE_LISTENER_H_
 
+#include <absl/types/span.h>
+
 #include "CaptureClient/CaptureListener.h"
 #include "ClientData/CaptureData.h"
 
@@ -46,6 +48,15 @@ class AbstractCaptureListener : public CaptureListener {
     GetMutableCaptureDataFromDerived().AddCallstackEvent(callstack_event);
   }
 
+  void OnCallstackEvents(
+      absl::Span<const orbit_client_data::CallstackEvent> callstack_events) override {
+    GetMutableCaptureDataFromDerived().AddCallstackEvents(callstack_events);
+  }
+
+  void OnPageFaultCallstackEvent(orbit_client_data::CallstackEvent callstack_event) override {
+    GetMutableCaptureDataFromDerived().AddPageFaultCallstackEvent(callstack_event);
+  }
+
   void OnThreadName(uint32_t thread_id, std::string thread_name) override {
     GetMutableCaptureDataFromDerived().AddOrAssignThreadName(thread_id, std::move(thread_name));
   }
@@ -54,6 +65,16 @@ class AbstractCaptureListener : public CaptureListener {
     GetMutableCaptureDataFromDerived().AddThreadStateSlice(thread_state_slice);
   }
 
+  void OnThreadStateSlices(
+      absl::Span<const orbit_client_data::ThreadStateSliceInfo> thread_state_slices) override {
+    GetMutableCaptureDataFromDerived().AddThreadStateSlices(thread_state_slices);
+  }
+
+  void OnOffCpuTimeSummary(
+      const orbit_grpc_protos::OffCpuTimeSummary& off_cpu_time_summary) override {
+    GetMutableCaptureDataFromDerived().AddOffCpuTimeSummary(off_cpu_time_summary);
+  }
+
   void OnTracepointEvent(orbit_client_data::TracepointEventInfo tracepoint_event_info) override {
     uint32_t capture_process_id = GetMutableCaptureDataFromDerived().process_id();
     bool is_same_pid_as_target = capture_process_id == tracepoint_event_info.pid();
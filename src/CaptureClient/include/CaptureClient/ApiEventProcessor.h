@@ -7,10 +7,13 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "CaptureClient/CaptureListener.h"
+#include "ClientProtos/capture_data.pb.h"
 #include "GrpcProtos/capture.pb.h"
 
 namespace orbit_capture_client {
@@ -22,7 +25,11 @@ namespace orbit_capture_client {
 // however, they are translated to TimerInfo objects that are directly passed to the listener.
 class ApiEventProcessor {
  public:
-  explicit ApiEventProcessor(CaptureListener* listener);
+  // `string_intern_pool` maps the keys of InternedStrings to the strings, and is needed to resolve
+  // the `name_key` of events with interned names. It needs to outlive this object.
+  explicit ApiEventProcessor(
+      CaptureListener* listener,
+      const absl::flat_hash_map<uint64_t, std::string>* string_intern_pool = nullptr);
 
   void ProcessApiScopeStart(const orbit_grpc_protos::ApiScopeStart& api_scope_start);
   void ProcessApiScopeStartAsync(
@@ -37,12 +44,39 @@ class ApiEventProcessor {
   void ProcessApiTrackInt64(const orbit_grpc_protos::ApiTrackInt64& grpc_api_track_int64);
   void ProcessApiTrackUint(const orbit_grpc_protos::ApiTrackUint& grpc_api_track_uint);
   void ProcessApiTrackUint64(const orbit_grpc_protos::ApiTrackUint64& grpc_api_track_uint64);
+  // Relays the minimum, the maximum, and the last value of the summary as separate track values.
+  void ProcessApiTrackValueSummary(
+      const orbit_grpc_protos::ApiTrackValueSummary& api_track_value_summary);
 
  private:
+  // What is kept of an ApiScopeStart or ApiScopeStartAsync until the matching stop event, instead
+  // of the whole event. `name` is only set if the name was not interned.
+  struct OpenScope {
+    uint64_t timestamp_ns = 0;
+    uint32_t color_rgba = 0;
+    uint64_t group_id = 0;
+    uint64_t address_in_function = 0;
+    uint64_t name_key = 0;
+    std::string name;
+  };
+  // Most threads never nest more scopes than this, so their stacks are allocated only once.
+  static constexpr size_t kInitialScopeStackCapacity = 64;
+
+  template <typename NamedApiEvent>
+  [[nodiscard]] std::string GetName(const NamedApiEvent& api_event) const;
+  [[nodiscard]] std::string GetInternedName(uint64_t name_key) const;
+  template <typename ApiScopeStartT>
+  [[nodiscard]] static OpenScope CreateOpenScope(const ApiScopeStartT& api_scope_start);
+  // Fills the fields of `timer_info_` that come from `open_scope`.
+  void SetTimerInfoFromOpenScope(OpenScope& open_scope);
+
   CaptureListener* capture_listener_ = nullptr;
-  absl::flat_hash_map<int32_t, std::vector<orbit_grpc_protos::ApiScopeStart>>
-      synchronous_scopes_stack_by_tid_;
-  absl::flat_hash_map<uint64_t, orbit_grpc_protos::ApiScopeStartAsync> asynchronous_scopes_by_id_;
+  const absl::flat_hash_map<uint64_t, std::string>* string_intern_pool_ = nullptr;
+  absl::flat_hash_map<uint32_t, std::vector<OpenScope>> synchronous_scopes_stack_by_tid_;
+  // Asynchronous scopes can start and stop on different threads, so they are matched by id.
+  absl::flat_hash_map<uint64_t, OpenScope> asynchronous_scopes_by_id_;
+  // Reused for every timer, so that its allocations are reused as well.
+  orbit_client_protos::TimerInfo timer_info_;
 };
 
 }  // namespace orbit_capture_client
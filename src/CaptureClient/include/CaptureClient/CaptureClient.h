@@ -72,6 +72,10 @@ class CaptureClient {
       CaptureEventProcessor* capture_event_processor,
       const google::protobuf::RepeatedPtrField<orbit_grpc_protos::ClientCaptureEvent>& events);
 
+  // Tells the service how many bytes of CaptureResponses were received but not processed yet, so
+  // that it can shed load while the client is behind.
+  void SendClientCaptureBacklog(uint64_t unprocessed_byte_count);
+
   [[nodiscard]] ErrorMessageOr<void> FinishCapture();
 
   std::unique_ptr<orbit_grpc_protos::CaptureService::Stub> capture_service_;
@@ -80,6 +84,9 @@ class CaptureClient {
                                            orbit_grpc_protos::CaptureResponse>>
       reader_writer_;
   absl::Mutex context_and_stream_mutex_;
+  // Serializes the writes of the backlog with WritesDone, after which nothing can be written.
+  absl::Mutex write_mutex_;
+  bool writes_done_ ABSL_GUARDED_BY(write_mutex_) = false;
 
   mutable absl::Mutex state_mutex_;
   State state_ = State::kStopped;
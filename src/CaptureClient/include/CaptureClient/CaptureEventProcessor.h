@@ -6,6 +6,7 @@
 #define CAPTURE_CLIENT_CAPTURE_EVENT_PROCESSOR_H_
 
 #include <absl/container/flat_hash_set.h>
+#include <google/protobuf/repeated_ptr_field.h>
 
 #include <cstdint>
 #include <filesystem>
@@ -27,6 +28,14 @@ class CaptureEventProcessor {
   virtual ~CaptureEventProcessor() = default;
 
   virtual void ProcessEvent(const orbit_grpc_protos::ClientCaptureEvent& event) = 0;
+  // Processes the events of a whole CaptureResponse, which lets an implementation amortize its
+  // per-call costs, and those of the consumers it forwards to, over all of them.
+  virtual void ProcessEvents(
+      const google::protobuf::RepeatedPtrField<orbit_grpc_protos::ClientCaptureEvent>& events) {
+    for (const orbit_grpc_protos::ClientCaptureEvent& event : events) {
+      ProcessEvent(event);
+    }
+  }
 
   static std::unique_ptr<CaptureEventProcessor> CreateForCaptureListener(
       CaptureListener* capture_listener, std::optional<std::filesystem::path> file_path,
@@ -6,6 +6,7 @@
 #define CAPTURE_CLIENT_CAPTURE_LISTENER_H_
 
 #include <absl/container/flat_hash_set.h>
+#include <absl/types/span.h>
 
 #include <filesystem>
 
@@ -55,12 +56,22 @@ class CaptureListener {
   virtual void OnUniqueCallstack(uint64_t callstack_id,
                                  orbit_client_data::CallstackInfo callstack) = 0;
   virtual void OnCallstackEvent(orbit_client_data::CallstackEvent callstack_event) = 0;
+  // Called for the callstacks of the sampled page faults, when page fault sampling is enabled.
+  virtual void OnPageFaultCallstackEvent(orbit_client_data::CallstackEvent callstack_event) = 0;
   virtual void OnThreadName(uint32_t thread_id, std::string thread_name) = 0;
   virtual void OnModuleUpdate(uint64_t timestamp_ns, orbit_grpc_protos::ModuleInfo module_info) = 0;
   virtual void OnModulesSnapshot(uint64_t timestamp_ns,
                                  std::vector<orbit_grpc_protos::ModuleInfo> module_infos) = 0;
   virtual void OnPresentEvent(const orbit_grpc_protos::PresentEvent& present_event) = 0;
+  virtual void OnPressureStallEvent(
+      const orbit_grpc_protos::PressureStallEvent& pressure_stall_event) = 0;
+  virtual void OnPerformanceCounterSample(
+      const orbit_grpc_protos::PerformanceCounterSample& performance_counter_sample) = 0;
   virtual void OnThreadStateSlice(orbit_client_data::ThreadStateSliceInfo thread_state_slice) = 0;
+  // Called instead of OnThreadStateSlice for the slices that OrbitService summarized, see
+  // CaptureOptions.off_cpu_time_aggregation_interval_ns.
+  virtual void OnOffCpuTimeSummary(
+      const orbit_grpc_protos::OffCpuTimeSummary& off_cpu_time_summary) = 0;
   virtual void OnAddressInfo(orbit_client_data::LinuxAddressInfo address_info) = 0;
   virtual void OnUniqueTracepointInfo(uint64_t tracepoint_id,
                                       orbit_client_data::TracepointInfo tracepoint_info) = 0;
@@ -85,6 +96,29 @@ class CaptureListener {
       orbit_grpc_protos::LostPerfRecordsEvent lost_perf_records_event) = 0;
   virtual void OnOutOfOrderEventsDiscardedEvent(
       orbit_grpc_protos::OutOfOrderEventsDiscardedEvent out_of_order_events_discarded_event) = 0;
+  virtual void OnPerfEventProcessingStatsEvent(
+      orbit_grpc_protos::PerfEventProcessingStatsEvent perf_event_processing_stats_event) = 0;
+
+  // Batched variants of OnTimer, OnCallstackEvent and OnThreadStateSlice, which the
+  // CaptureEventProcessor calls with the events of a whole CaptureResponse, so that listeners can
+  // take their locks and notify once per batch. A batch can be delivered after other calls for
+  // later events, but never before the unique callstacks and strings its events refer to.
+  virtual void OnTimers(absl::Span<const orbit_client_protos::TimerInfo> timer_infos) {
+    for (const orbit_client_protos::TimerInfo& timer_info : timer_infos) {
+      OnTimer(timer_info);
+    }
+  }
+  virtual void OnCallstackEvents(absl::Span<const orbit_client_data::CallstackEvent> events) {
+    for (const orbit_client_data::CallstackEvent& callstack_event : events) {
+      OnCallstackEvent(callstack_event);
+    }
+  }
+  virtual void OnThreadStateSlices(
+      absl::Span<const orbit_client_data::ThreadStateSliceInfo> thread_state_slices) {
+    for (const orbit_client_data::ThreadStateSliceInfo& thread_state_slice : thread_state_slices) {
+      OnThreadStateSlice(thread_state_slice);
+    }
+  }
 };
 
 }  // namespace orbit_capture_client
@@ -0,0 +1,33 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CAPTURE_CLIENT_CLIENT_CAPTURE_EVENT_BATCHES_H_
+#define CAPTURE_CLIENT_CLIENT_CAPTURE_EVENT_BATCHES_H_
+
+#include <functional>
+
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_capture_client {
+
+// These functions call `consumer` with each event of the columnar `batch`, in order, as an
+// individual event (see FunctionCallBatch in capture.proto). They fail without calling `consumer`
+// if the columns of `batch` don't all have the same size.
+[[nodiscard]] ErrorMessageOr<void> ForEachEventInBatch(
+    const orbit_grpc_protos::FunctionCallBatch& batch,
+    const std::function<void(const orbit_grpc_protos::FunctionCall&)>& consumer);
+[[nodiscard]] ErrorMessageOr<void> ForEachEventInBatch(
+    const orbit_grpc_protos::SchedulingSliceBatch& batch,
+    const std::function<void(const orbit_grpc_protos::SchedulingSlice&)>& consumer);
+[[nodiscard]] ErrorMessageOr<void> ForEachEventInBatch(
+    const orbit_grpc_protos::CallstackSampleBatch& batch,
+    const std::function<void(const orbit_grpc_protos::CallstackSample&)>& consumer);
+[[nodiscard]] ErrorMessageOr<void> ForEachEventInBatch(
+    const orbit_grpc_protos::ThreadStateSliceBatch& batch,
+    const std::function<void(const orbit_grpc_protos::ThreadStateSlice&)>& consumer);
+
+}  // namespace orbit_capture_client
+
+#endif  // CAPTURE_CLIENT_CLIENT_CAPTURE_EVENT_BATCHES_H_
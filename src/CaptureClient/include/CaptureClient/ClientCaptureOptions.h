@@ -8,6 +8,9 @@
 #include <absl/container/flat_hash_map.h>
 #include <stdint.h>
 
+#include <string>
+#include <vector>
+
 #include "ClientData/FunctionInfo.h"
 #include "ClientData/TracepointCustom.h"
 #include "GrpcProtos/capture.pb.h"
@@ -16,6 +19,8 @@ namespace orbit_capture_client {
 
 struct ClientCaptureOptions {
   uint32_t process_id = 0;
+  // See CaptureOptions.additional_thread_state_pids in capture.proto.
+  std::vector<uint32_t> additional_thread_state_process_ids;
 
   absl::flat_hash_map<uint64_t, orbit_client_data::FunctionInfo> selected_functions;
   absl::flat_hash_map<uint64_t, orbit_client_data::FunctionInfo>
@@ -33,11 +38,36 @@ struct ClientCaptureOptions {
       thread_state_change_callstack_collection =
           orbit_grpc_protos::CaptureOptions::kThreadStateChangeCallStackCollectionUnspecified;
 
+  orbit_grpc_protos::CaptureOptions::CaptureResponseCompression capture_response_compression =
+      orbit_grpc_protos::CaptureOptions::kNoCompression;
+
   uint16_t stack_dump_size = 0;
   uint16_t thread_state_change_callstack_stack_dump_size = 0;
+  // See CaptureOptions in capture.proto.
+  uint64_t thread_state_change_callstack_min_off_cpu_duration_ns = 0;
+  // If not zero, the off-CPU time of the thread state slices with callstacks is summarized over
+  // intervals of this duration, see CaptureOptions in capture.proto.
+  uint64_t off_cpu_time_aggregation_interval_ns = 0;
   uint64_t max_local_marker_depth_per_command_buffer = 0;
   uint64_t memory_sampling_period_ms = 0;
+  uint64_t page_fault_sampling_period = 0;
+  uint64_t pressure_stall_threshold_ms = 0;
+  uint64_t pressure_stall_window_ms = 0;
+  bool sample_performance_counters = false;
+  uint32_t ring_buffer_reader_thread_count = 0;
+  uint32_t unwinding_thread_count = 0;
+  uint64_t flight_recorder_duration_ms = 0;
+  // Applied to all instrumented functions, see InstrumentedFunction in capture.proto.
+  uint32_t record_one_in_n_calls = 0;
+  uint64_t min_function_call_duration_ns = 0;
+  std::string perf_record_dump_path;
+  // If not empty, OrbitService writes the capture to this file and only streams a preview of it,
+  // see CaptureOptions in capture.proto.
+  std::string capture_file_path_on_target;
   double samples_per_second = 0;
+  // If not zero, the values of each Orbit API track are aggregated over windows of this duration,
+  // see CaptureOptions in capture.proto.
+  uint64_t api_track_aggregation_window_ns = 0;
 
   bool collect_gpu_jobs = false;
   bool collect_memory_info = false;
@@ -48,6 +78,9 @@ struct ClientCaptureOptions {
   bool record_arguments = false;
   bool record_return_values = false;
   bool enable_auto_frame_track = false;
+  bool use_ring_buffer_wakeups = false;
+  bool use_tsc_timestamps = false;
+  bool subtract_instrumentation_overhead = false;
 };
 
 }  // namespace orbit_capture_client
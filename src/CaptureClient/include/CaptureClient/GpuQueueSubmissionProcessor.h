@@ -37,8 +37,20 @@ namespace orbit_capture_client {
 // Worth mentioning is the case of debug markers, where the "begin" marker originates from a
 // different submission than the "end" marker. In this case we store the "begin" marker's
 // `GpuQueueSubmission` and `GpuJob` until we have processed all corresponding "end" markers.
+//
+// If the producer could calibrate the GPU clock against the capture clock (see
+// `GpuQueueSubmission::gpu_timestamps_are_capture_timestamps`), the timestamps of the submission
+// are already CPU timestamps. Then the submission is converted right away, on a timeline per queue,
+// without a `GpuJob`. Once such a submission was processed, `GpuJob`s are no longer stored for
+// matching.
+//
+// Stored events that could not be matched are evicted once they are `kMaxRetentionNs` older than
+// the latest event of their thread, as the events of a thread arrive roughly in order. Events that
+// are still needed for the "begin" of a debug marker are kept.
 class GpuQueueSubmissionProcessor {
  public:
+  static constexpr uint64_t kMaxRetentionNs = 10'000'000'000;
+
   // If the matching `GpuJob` has already been processed, it converts the command buffer and debug
   // marker information from the `GpuQueueSubmission` event into `TimerInfo`s. Otherwise, it
   // returns an empty vector and stores the submission for later processing.
@@ -73,6 +85,11 @@ class GpuQueueSubmissionProcessor {
   static bool TryExtractDXVKVulkanGroupIdFromDebugLabel(std::string_view label,
                                                         uint64_t* out_group_id);
 
+  [[nodiscard]] uint64_t GetNumEvictedGpuJobs() const { return num_evicted_gpu_jobs_; }
+  [[nodiscard]] uint64_t GetNumEvictedGpuQueueSubmissions() const {
+    return num_evicted_gpu_queue_submissions_;
+  }
+
  private:
   [[nodiscard]] std::vector<orbit_client_protos::TimerInfo>
   ProcessGpuQueueSubmissionWithMatchingGpuJob(
@@ -82,11 +99,17 @@ class GpuQueueSubmissionProcessor {
       const std::function<uint64_t(std::string_view str)>&
           get_string_hash_and_send_to_listener_if_necessary);
 
+  [[nodiscard]] std::vector<orbit_client_protos::TimerInfo> ProcessCalibratedGpuQueueSubmission(
+      const orbit_grpc_protos::GpuQueueSubmission& gpu_queue_submission,
+      const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
+      const std::function<uint64_t(std::string_view str)>&
+          get_string_hash_and_send_to_listener_if_necessary) const;
+
+  // Converts the GPU timestamps of the command buffers to CPU timestamps by adding
+  // `gpu_to_cpu_timestamp_offset` (with unsigned wrap around).
   [[nodiscard]] std::vector<orbit_client_protos::TimerInfo> ProcessGpuCommandBuffers(
       const orbit_grpc_protos::GpuQueueSubmission& gpu_queue_submission,
-      const orbit_grpc_protos::GpuJob& matching_gpu_job,
-      const std::optional<orbit_grpc_protos::GpuCommandBuffer>& first_command_buffer,
-      uint64_t timeline_hash,
+      uint64_t gpu_to_cpu_timestamp_offset, int32_t depth, uint64_t timeline_hash,
       const std::function<uint64_t(std::string_view str)>&
           get_string_hash_and_send_to_listener_if_necessary) const;
 
@@ -96,6 +119,16 @@ class GpuQueueSubmissionProcessor {
       const std::optional<orbit_grpc_protos::GpuCommandBuffer>& first_command_buffer,
       const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool);
 
+  [[nodiscard]] std::vector<orbit_client_protos::TimerInfo> ProcessCalibratedGpuDebugMarkers(
+      const orbit_grpc_protos::GpuQueueSubmission& gpu_queue_submission, uint64_t timeline_hash,
+      const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool) const;
+
+  // Sets the fields of a debug marker `TimerInfo` that don't depend on the timestamps.
+  static void SetDebugMarkerTimerFields(
+      const orbit_grpc_protos::GpuDebugMarker& marker,
+      const absl::flat_hash_map<uint64_t, std::string>& string_intern_pool,
+      orbit_client_protos::TimerInfo* marker_timer);
+
   [[nodiscard]] static std::optional<orbit_grpc_protos::GpuCommandBuffer> ExtractFirstCommandBuffer(
       const orbit_grpc_protos::GpuQueueSubmission& gpu_queue_submission);
 
@@ -120,6 +153,10 @@ class GpuQueueSubmissionProcessor {
 
   void DeleteSavedGpuSubmission(uint32_t thread_id, uint64_t post_submission_timestamp);
 
+  // Evicts the stored events of `thread_id` that are more than `kMaxRetentionNs` older than
+  // `timestamp`, unless they are needed for unprocessed "begin" markers.
+  void EvictStaleEvents(uint32_t thread_id, uint64_t timestamp);
+
   absl::node_hash_map<int32_t, std::map<uint64_t, orbit_grpc_protos::GpuJob>>
       tid_to_submission_time_to_gpu_job_;
   absl::node_hash_map<int32_t, std::map<uint64_t, orbit_grpc_protos::GpuQueueSubmission>>
@@ -128,6 +165,9 @@ class GpuQueueSubmissionProcessor {
       tid_to_post_submission_time_to_num_begin_markers_;
 
   uint64_t begin_capture_time_ns_ = std::numeric_limits<uint64_t>::max();
+  bool has_calibrated_gpu_queue_submissions_ = false;
+  uint64_t num_evicted_gpu_jobs_ = 0;
+  uint64_t num_evicted_gpu_queue_submissions_ = 0;
 };
 
 }  // namespace orbit_capture_client
@@ -5,18 +5,46 @@
 #ifndef CAPTURE_CLIENT_LOAD_CAPTURE_H_
 #define CAPTURE_CLIENT_LOAD_CAPTURE_H_
 
+#include <absl/container/flat_hash_set.h>
+#include <stdint.h>
+
 #include <atomic>
+#include <limits>
 
 #include "CaptureClient/CaptureListener.h"
 #include "CaptureFile/CaptureFile.h"
+#include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Result.h"
 
 namespace orbit_capture_client {
 
+// Restricts LoadCapture to a part of the capture. Only the events that are shown per thread and
+// over time, like timers, scheduling slices, callstack samples and thread states, are filtered.
+// Events that other events depend on, like interned strings, callstacks, modules and thread names,
+// as well as asynchronous scopes and GPU jobs, are always loaded.
+struct LoadCaptureFilter {
+  [[nodiscard]] bool IsEmpty() const {
+    return min_relative_timestamp_ns == 0 &&
+           max_relative_timestamp_ns == std::numeric_limits<uint64_t>::max() &&
+           thread_ids.empty() && event_cases.empty();
+  }
+
+  // Relative to the start of the capture. Events that overlap this time range are loaded.
+  uint64_t min_relative_timestamp_ns = 0;
+  uint64_t max_relative_timestamp_ns = std::numeric_limits<uint64_t>::max();
+  // If not empty, only the events of these threads are loaded.
+  absl::flat_hash_set<uint32_t> thread_ids;
+  // If not empty, only the events of these kinds are loaded.
+  absl::flat_hash_set<orbit_grpc_protos::ClientCaptureEvent::EventCase> event_cases;
+};
+
 // TODO(b/234110675) Add a smoke test
+// If the capture file has a CAPTURE_INDEX section, the chunks that contain no event matching
+// `filter` are skipped without being parsed.
 [[nodiscard]] ErrorMessageOr<CaptureListener::CaptureOutcome> LoadCapture(
     CaptureListener* listener, orbit_capture_file::CaptureFile* capture_file,
-    std::atomic<bool>* capture_loading_cancellation_requested);
+    std::atomic<bool>* capture_loading_cancellation_requested,
+    const LoadCaptureFilter& filter = {});
 
 }  // namespace orbit_capture_client
 #endif  // CAPTURE_CLIENT_LOAD_CAPTURE_H_
@@ -107,6 +107,23 @@ bool CaptureEventProducer::NotifyAllEventsSent() {
   return write_succeeded;
 }
 
+void CaptureEventProducer::SendSharedMemoryBufferCreated() {
+  orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest shared_memory_buffer_created_request;
+  shared_memory_buffer_created_request.mutable_shared_memory_buffer_created()->set_name(
+      shared_memory_buffer_name_);
+  bool write_succeeded{};
+  {
+    absl::ReaderMutexLock lock{&context_and_stream_mutex_};
+    ORBIT_CHECK(stream_ != nullptr);
+    write_succeeded = stream_->Write(shared_memory_buffer_created_request);
+  }
+  if (write_succeeded) {
+    ORBIT_LOG("Sent SharedMemoryBufferCreated to ProducerSideService");
+  } else {
+    ORBIT_ERROR("Sending SharedMemoryBufferCreated to ProducerSideService");
+  }
+}
+
 void CaptureEventProducer::ConnectAndReceiveCommandsThread() {
   ORBIT_CHECK(producer_side_service_stub_ != nullptr);
   orbit_base::SetCurrentThreadName("ConnectRcvCmds");
@@ -142,6 +159,11 @@ void CaptureEventProducer::ConnectAndReceiveCommandsThread() {
     }
     ORBIT_LOG("Called ReceiveCommandsAndSendEvents on ProducerSideService");
 
+    // If this fails, so does the Read below, which handles the disconnection.
+    if (!shared_memory_buffer_name_.empty()) {
+      SendSharedMemoryBufferCreated();
+    }
+
     while (true) {
       ReceiveCommandsAndSendEventsResponse response;
       bool read_succeeded{};
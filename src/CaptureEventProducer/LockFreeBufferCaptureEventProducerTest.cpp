@@ -186,6 +186,35 @@ TEST_F(LockFreeBufferCaptureEventProducerTest, EnqueueIntermediateEvent) {
   buffer_producer_->EnqueueIntermediateEvent("");
 }
 
+TEST_F(LockFreeBufferCaptureEventProducerTest, EnqueueIntermediateEventsWithToken) {
+  fake_service_->SendStartCaptureCommand(orbit_grpc_protos::CaptureOptions{});
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+  EXPECT_TRUE(buffer_producer_->IsCapturing());
+
+  std::atomic<uint64_t> capture_events_received_count = 0;
+  ON_CALL(*fake_service_, OnCaptureEventsReceived)
+      .WillByDefault([&capture_events_received_count](
+                         absl::Span<const orbit_grpc_protos::ProducerCaptureEvent> events) {
+        capture_events_received_count += events.size();
+      });
+  EXPECT_CALL(*fake_service_, OnCaptureEventsReceived).Times(::testing::Between(1, 2));
+  EXPECT_CALL(*fake_service_, OnAllEventsSentReceived).Times(0);
+  moodycamel::ProducerToken token = buffer_producer_->CreateProducerToken();
+  std::string events[] = {"", "", ""};
+  buffer_producer_->EnqueueIntermediateEvents(&token, events, 2);
+  buffer_producer_->EnqueueIntermediateEvents(&token, events + 2, 1);
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+  EXPECT_EQ(capture_events_received_count, 3);
+
+  ::testing::Mock::VerifyAndClearExpectations(&*fake_service_);
+
+  EXPECT_CALL(*fake_service_, OnCaptureEventsReceived).Times(0);
+  EXPECT_CALL(*fake_service_, OnAllEventsSentReceived).Times(1);
+  fake_service_->SendStopCaptureCommand();
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+  EXPECT_FALSE(buffer_producer_->IsCapturing());
+}
+
 TEST_F(LockFreeBufferCaptureEventProducerTest, DuplicatedCommands) {
   EXPECT_FALSE(buffer_producer_->IsCapturing());
 
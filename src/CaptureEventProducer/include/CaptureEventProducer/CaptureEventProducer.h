@@ -11,11 +11,14 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
 #include <thread>
+#include <utility>
 
 #include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/producer_side_services.grpc.pb.h"
 #include "GrpcProtos/producer_side_services.pb.h"
+#include "OrbitBase/Logging.h"
 
 namespace orbit_capture_event_producer {
 
@@ -60,10 +63,21 @@ class CaptureEventProducer {
   // they have sent all their CaptureEvents after the capture has been stopped.
   [[nodiscard]] bool NotifyAllEventsSent();
 
+  // Subclasses that write their CaptureEvents to a shared memory ring buffer instead of calling
+  // SendCaptureEvents need to call this before BuildAndStart. The name of the buffer is then sent
+  // to ProducerSideService every time the connection is established.
+  void SetSharedMemoryBufferName(std::string name) {
+    ORBIT_CHECK(producer_side_service_stub_ == nullptr);
+    shared_memory_buffer_name_ = std::move(name);
+  }
+
  private:
   void ConnectAndReceiveCommandsThread();
 
+  void SendSharedMemoryBufferCreated();
+
   std::unique_ptr<orbit_grpc_protos::ProducerSideService::Stub> producer_side_service_stub_;
+  std::string shared_memory_buffer_name_;
   std::thread connect_and_receive_commands_thread_;
 
   std::unique_ptr<grpc::ClientContext> context_;
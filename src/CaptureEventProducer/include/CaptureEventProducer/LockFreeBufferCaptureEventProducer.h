@@ -5,12 +5,26 @@
 #ifndef CAPTURE_EVENT_PRODUCER_LOCK_FREE_BUFFER_CAPTURE_EVENT_PRODUCER_H_
 #define CAPTURE_EVENT_PRODUCER_LOCK_FREE_BUFFER_CAPTURE_EVENT_PRODUCER_H_
 
+#include <absl/base/casts.h>
+#include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
 #include <google/protobuf/arena.h>
+#include <google/protobuf/repeated_ptr_field.h>
+
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <optional>
+#include <string>
 
 #include "CaptureEventProducer/CaptureEventProducer.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/MakeUniqueForOverwrite.h"
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/SharedMemoryRingBuffer.h"
 #include "OrbitBase/ThreadUtils.h"
+#include "OrbitBase/Tsc.h"
 #include "concurrentqueue.h"
 
 namespace orbit_capture_event_producer {
@@ -31,6 +45,15 @@ namespace orbit_capture_event_producer {
 // In particular, when hundreds of thousands of events are produced per second, it is recommended
 // that IntermediateEventT not be a protobuf or another type that involves heap allocations, as the
 // cost of dynamic allocations and de-allocations can add up quickly.
+//
+// For the same reason, events can be timestamped with ReadTimestamp instead of
+// orbit_base::CaptureTimestampNs. If the capture options ask for it, this reads the time stamp
+// counter, and subclasses need to convert the timestamps with ToCaptureTimestampNs in
+// TranslateIntermediateEvent.
+//
+// Producers with high event rates can call UseSharedMemoryBuffer before BuildAndStart, in which
+// case the ProducerCaptureEvents are written to a ring buffer in memory shared with OrbitService,
+// and gRPC is only used for commands.
 template <typename IntermediateEventT>
 class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
  public:
@@ -42,6 +65,7 @@ class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
 
   void ShutdownAndWait() final {
     shutdown_requested_ = true;
+    WakeUpForwarderThread();
 
     ORBIT_CHECK(forwarder_thread_.joinable());
     forwarder_thread_.join();
@@ -57,6 +81,40 @@ class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
     lock_free_queue_.enqueue(std::move(event));
   }
 
+  // A token gives a thread a sub-queue of its own in the lock-free queue, which saves looking up
+  // the sub-queue of the calling thread on each enqueue. A token must not be used by multiple
+  // threads at the same time.
+  [[nodiscard]] moodycamel::ProducerToken CreateProducerToken() {
+    return moodycamel::ProducerToken{lock_free_queue_};
+  }
+
+  // Moves `event_count` events to the lock-free queue at once, using a token from
+  // CreateProducerToken. Enqueueing many events like this is considerably cheaper than one by one.
+  void EnqueueIntermediateEvents(moodycamel::ProducerToken* token, IntermediateEventT* events,
+                                 size_t event_count) {
+    lock_free_queue_.enqueue_bulk(*token, std::make_move_iterator(events), event_count);
+    // Only bulk enqueues are counted, so that enqueueing single events doesn't contend on the
+    // counter. Wake up the forwarder thread once, when the count crosses the threshold.
+    const uint64_t previous_count =
+        bulk_enqueued_event_count_.fetch_add(event_count, std::memory_order_relaxed);
+    if (previous_count < kWakeUpBulkEnqueuedEventCount &&
+        previous_count + event_count >= kWakeUpBulkEnqueuedEventCount) {
+      WakeUpForwarderThread();
+    }
+  }
+
+  // Returns either a capture timestamp or a raw value of the time stamp counter, depending on the
+  // capture options of the current capture. Pass the value to ToCaptureTimestampNs to get a capture
+  // timestamp.
+  [[nodiscard]] uint64_t ReadTimestamp() const {
+    if (use_tsc_timestamps_.load(std::memory_order_relaxed)) return orbit_base::ReadTsc();
+    return orbit_base::CaptureTimestampNs();
+  }
+
+  [[nodiscard]] bool UsesTscTimestamps() const {
+    return use_tsc_timestamps_.load(std::memory_order_relaxed);
+  }
+
   bool EnqueueIntermediateEventIfCapturing(
       const std::function<IntermediateEventT()>& event_builder_if_capturing) {
     if (IsCapturing()) {
@@ -67,14 +125,45 @@ class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
   }
 
  protected:
-  void OnCaptureStart(orbit_grpc_protos::CaptureOptions /*capture_options*/) override {
+  static constexpr uint64_t kDefaultSharedMemoryBufferCapacity = 8 * 1024 * 1024;
+
+  // Makes the forwarder thread write the ProducerCaptureEvents to a shared memory ring buffer of
+  // `capacity` bytes instead of sending them through gRPC. This saves most of the cost of gRPC,
+  // and OrbitService reads the events in bulk. If the buffer can't be created, events keep being
+  // sent through gRPC. Needs to be called before BuildAndStart.
+  void UseSharedMemoryBuffer(uint64_t capacity = kDefaultSharedMemoryBufferCapacity) {
+    std::string name = absl::StrFormat("orbit-producer-events-%u-%#x",
+                                       orbit_base::GetCurrentProcessId(),
+                                       absl::bit_cast<uintptr_t>(this));
+    auto buffer_or_error = orbit_base::SharedMemoryRingBuffer::Create(name, capacity);
+    if (buffer_or_error.has_error()) {
+      ORBIT_ERROR("Creating shared memory buffer for CaptureEvents: %s",
+                  buffer_or_error.error().message());
+      return;
+    }
+    shared_memory_buffer_.emplace(std::move(buffer_or_error.value()));
+    SetSharedMemoryBufferName(std::move(name));
+  }
+
+  void OnCaptureStart(orbit_grpc_protos::CaptureOptions capture_options) override {
+    // Calibrate before taking the lock, as the first calibration sleeps for a few milliseconds.
+    std::optional<orbit_base::TscConverter> tsc_converter;
+    if (capture_options.use_tsc_timestamps() && orbit_base::HasInvariantTsc()) {
+      tsc_converter = orbit_base::TscConverter::Create();
+    }
     absl::MutexLock lock{&status_mutex_};
+    // The forwarder thread reads tsc_converter_ only after having seen the new status_.
+    tsc_converter_ = tsc_converter;
+    use_tsc_timestamps_ = tsc_converter.has_value();
     status_ = ProducerStatus::kShouldSendEvents;
+    WakeUpForwarderThread();
   }
 
   void OnCaptureStop() override {
     absl::MutexLock lock{&status_mutex_};
     status_ = ProducerStatus::kShouldNotifyAllEventsSent;
+    // Send AllEventsSent as soon as the queue has been emptied.
+    WakeUpForwarderThread();
   }
 
   void OnCaptureFinished() override {
@@ -92,14 +181,45 @@ class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
   // - If `IntermediateEventT` is itself a `ProducerCaptureEvent`, or the type of one of its fields,
   //   attempting to move from it into the Arena-allocated `ProducerCaptureEvent` will silently
   //   result in a deep copy.
+  // Returning nullptr means that no `CaptureEvent` is sent for this `IntermediateEventT` by
+  // itself, e.g., because the subclass merges it with other events in
+  // FinishTranslatingIntermediateEvents.
   [[nodiscard]] virtual orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
       IntermediateEventT&& intermediate_event, google::protobuf::Arena* arena) = 0;
 
+  // Called after TranslateIntermediateEvent has been called for all events of a batch, with the
+  // same Arena. Subclasses can override this to add more events with AddPrecedingCaptureEvent,
+  // which then come last in the batch.
+  virtual void FinishTranslatingIntermediateEvents(google::protobuf::Arena* /*arena*/) {}
+
+  // Adds `capture_event`, which must be created in the Arena passed to TranslateIntermediateEvent,
+  // to the events being forwarded, before the one TranslateIntermediateEvent returns. This allows,
+  // e.g., to send an InternedString the first time it is referenced. Only to be called from
+  // TranslateIntermediateEvent and FinishTranslatingIntermediateEvents.
+  void AddPrecedingCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent* capture_event) {
+    ORBIT_CHECK(capture_events_being_translated_ != nullptr);
+    capture_events_being_translated_->AddAllocated(capture_event);
+  }
+
+  // Converts a value returned by ReadTimestamp to a capture timestamp. Only to be called from
+  // TranslateIntermediateEvent.
+  [[nodiscard]] uint64_t ToCaptureTimestampNs(uint64_t timestamp) const {
+    if (!tsc_converter_.has_value()) return timestamp;
+    return tsc_converter_->ToCaptureTimestampNs(timestamp);
+  }
+
+  // Moves up to `max_event_count` events to `events` and returns their number. Returning fewer
+  // than `max_event_count` events means that there are no more events for now. By default, this
+  // dequeues the events enqueued with EnqueueIntermediateEvent(IfCapturing). Subclasses can
+  // override this to provide the events from their own buffers instead.
+  virtual size_t DequeueIntermediateEvents(IntermediateEventT* events, size_t max_event_count) {
+    return lock_free_queue_.try_dequeue_bulk(events, max_event_count);
+  }
+
  private:
   void ForwarderThread() {
     orbit_base::SetCurrentThreadName("ForwarderThread");
 
-    constexpr uint64_t kMaxEventsPerRequest = 10'000;
     std::vector<IntermediateEventT> dequeued_events(kMaxEventsPerRequest);
 
     // Pre-allocate and always reuse the same 1 MB chunk of memory as the first block of each Arena
@@ -118,7 +238,7 @@ class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
     while (!shutdown_requested_) {
       while (true) {
         size_t dequeued_event_count =
-            lock_free_queue_.try_dequeue_bulk(dequeued_events.begin(), kMaxEventsPerRequest);
+            DequeueIntermediateEvents(dequeued_events.data(), kMaxEventsPerRequest);
         bool queue_was_emptied = dequeued_event_count < kMaxEventsPerRequest;
 
         ProducerStatus current_status;
@@ -141,12 +261,18 @@ class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
               send_request->mutable_buffered_capture_events()->mutable_capture_events();
           capture_events->Reserve(dequeued_event_count);
 
+          capture_events_being_translated_ = capture_events;
           for (size_t i = 0; i < dequeued_event_count; ++i) {
-            capture_events->AddAllocated(
-                TranslateIntermediateEvent(std::move(dequeued_events[i]), &arena));
+            orbit_grpc_protos::ProducerCaptureEvent* capture_event =
+                TranslateIntermediateEvent(std::move(dequeued_events[i]), &arena);
+            if (capture_event != nullptr) capture_events->AddAllocated(capture_event);
           }
+          FinishTranslatingIntermediateEvents(&arena);
+          capture_events_being_translated_ = nullptr;
 
-          if (!SendCaptureEvents(*send_request)) {
+          if (shared_memory_buffer_.has_value()) {
+            WriteCaptureEventsToSharedMemoryBuffer(*capture_events);
+          } else if (!SendCaptureEvents(*send_request)) {
             ORBIT_ERROR("Forwarding %lu CaptureEvents", dequeued_event_count);
             break;
           }
@@ -169,20 +295,97 @@ class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
         }
       }
 
-      constexpr std::chrono::microseconds kSleepOnEmptyQueue{1000};
-      // Wait for lock_free_queue_ to fill up with new CaptureEvents.
-      std::this_thread::sleep_for(kSleepOnEmptyQueue);
+      WaitForMoreEvents();
+    }
+  }
+
+  void WakeUpForwarderThread() {
+    absl::MutexLock lock{&forwarder_wake_up_mutex_};
+    forwarder_wake_up_requested_ = true;
+  }
+
+  // Waits for lock_free_queue_ to fill up with new events, or for a change of status. Outside of
+  // captures, the events only need to be dropped, so the forwarder thread can mostly sleep.
+  void WaitForMoreEvents() {
+    // During a capture, this also bounds how long events wait in lock_free_queue_ and in the
+    // buffers of subclasses, like the ones of DequeueIntermediateEvents, before being forwarded.
+    constexpr absl::Duration kMaxWaitWhileCapturing = absl::Milliseconds(1);
+    constexpr absl::Duration kMaxWaitWhileNotCapturing = absl::Milliseconds(100);
+    bool is_capturing;
+    {
+      absl::MutexLock lock{&status_mutex_};
+      is_capturing = status_ != ProducerStatus::kShouldDropEvents;
+    }
+
+    absl::MutexLock lock{&forwarder_wake_up_mutex_};
+    forwarder_wake_up_mutex_.AwaitWithTimeout(
+        absl::Condition(&forwarder_wake_up_requested_),
+        is_capturing ? kMaxWaitWhileCapturing : kMaxWaitWhileNotCapturing);
+    forwarder_wake_up_requested_ = false;
+    bulk_enqueued_event_count_.store(0, std::memory_order_relaxed);
+  }
+
+  void WriteCaptureEventsToSharedMemoryBuffer(
+      const google::protobuf::RepeatedPtrField<orbit_grpc_protos::ProducerCaptureEvent>&
+          capture_events) {
+    // Wait for OrbitService to make room in the buffer, but not indefinitely, e.g., in case it has
+    // stopped reading. Once that happened, the rest of the batch is dropped without waiting.
+    constexpr std::chrono::microseconds kSleepOnFullBuffer{100};
+    constexpr int kMaxAttemptsOnFullBuffer = 10'000;
+    bool buffer_stayed_full = false;
+    uint64_t dropped_event_count = 0;
+    for (const orbit_grpc_protos::ProducerCaptureEvent& capture_event : capture_events) {
+      const size_t size = capture_event.ByteSizeLong();
+      char* record = nullptr;
+      if (size <= shared_memory_buffer_->GetMaxRecordSize()) {
+        record = shared_memory_buffer_->TryReserveRecord(size);
+        for (int attempt = 1; record == nullptr && !buffer_stayed_full; ++attempt) {
+          if (attempt == kMaxAttemptsOnFullBuffer || shutdown_requested_) {
+            buffer_stayed_full = true;
+            break;
+          }
+          std::this_thread::sleep_for(kSleepOnFullBuffer);
+          record = shared_memory_buffer_->TryReserveRecord(size);
+        }
+      }
+      if (record == nullptr) {
+        ++dropped_event_count;
+        continue;
+      }
+      capture_event.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(record));
+      shared_memory_buffer_->CommitRecord();
+    }
+    if (dropped_event_count > 0) {
+      ORBIT_ERROR("Dropped %u CaptureEvents that didn't fit into the shared memory buffer",
+                  dropped_event_count);
     }
   }
 
+  static constexpr uint64_t kMaxEventsPerRequest = 10'000;
+
   moodycamel::ConcurrentQueue<IntermediateEventT> lock_free_queue_;
+  // Only accessed by the forwarder thread after BuildAndStart.
+  std::optional<orbit_base::SharedMemoryRingBuffer> shared_memory_buffer_;
+  // Only accessed by the forwarder thread, while it calls TranslateIntermediateEvent.
+  google::protobuf::RepeatedPtrField<orbit_grpc_protos::ProducerCaptureEvent>*
+      capture_events_being_translated_ = nullptr;
 
   std::thread forwarder_thread_;
   std::atomic<bool> shutdown_requested_ = false;
 
+  // Half a request, as the forwarder thread is then likely to be done with the previous one.
+  static constexpr uint64_t kWakeUpBulkEnqueuedEventCount = kMaxEventsPerRequest / 2;
+  // Events enqueued with EnqueueIntermediateEvents since the forwarder thread last woke up.
+  std::atomic<uint64_t> bulk_enqueued_event_count_ = 0;
+  absl::Mutex forwarder_wake_up_mutex_;
+  bool forwarder_wake_up_requested_ ABSL_GUARDED_BY(forwarder_wake_up_mutex_) = false;
+
   enum class ProducerStatus { kShouldSendEvents, kShouldNotifyAllEventsSent, kShouldDropEvents };
   ProducerStatus status_ = ProducerStatus::kShouldDropEvents;
   absl::Mutex status_mutex_;
+
+  std::atomic<bool> use_tsc_timestamps_ = false;
+  std::optional<orbit_base::TscConverter> tsc_converter_;
 };
 
 }  // namespace orbit_capture_event_producer
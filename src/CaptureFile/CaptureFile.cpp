@@ -45,6 +45,7 @@ constexpr uint64_t kMaxNumberOfSections = std::numeric_limits<uint16_t>::max();
 struct CaptureFileHeader {
   static constexpr uint64_t kSignatureSize = kFileSignature.size();
   static constexpr uint64_t kFileFormatVersionSize = sizeof(uint32_t);
+  uint32_t version;
   uint64_t capture_section_offset;
   uint64_t section_list_offset;
   static constexpr uint64_t kSectionListOffsetFieldOffset =
@@ -78,6 +79,9 @@ class CaptureFileImpl : public CaptureFile {
 
   std::unique_ptr<ProtoSectionInputStream> CreateCaptureSectionInputStream() override;
 
+  std::unique_ptr<ProtoSectionInputStream> CreateCaptureSectionInputStreamAtChunk(
+      uint64_t chunk_offset) override;
+
   [[nodiscard]] const std::filesystem::path& GetFilePath() const override;
 
   std::unique_ptr<ProtoSectionInputStream> CreateProtoSectionInputStream(
@@ -220,7 +224,7 @@ ErrorMessageOr<void> ValidateSignature(google::protobuf::io::CodedInputStream* c
   return outcome::success();
 }
 
-ErrorMessageOr<void> ValidateFileVersion(google::protobuf::io::CodedInputStream* coded_input,
+ErrorMessageOr<uint32_t> ReadFileVersion(google::protobuf::io::CodedInputStream* coded_input,
                                          google::protobuf::io::FileInputStream* raw_input) {
   uint32_t version{};
   if (!coded_input->ReadLittleEndian32(&version)) {
@@ -229,12 +233,12 @@ ErrorMessageOr<void> ValidateFileVersion(google::protobuf::io::CodedInputStream*
                         SafeStrerror(raw_input->GetErrno()))};
   }
 
-  if (version != kFileVersion) {
-    return ErrorMessage{
-        absl::StrFormat("Incompatible version %d, expected %d", version, kFileVersion)};
+  if (version != kFileVersion && version != kCompressedCaptureSectionFileVersion) {
+    return ErrorMessage{absl::StrFormat("Incompatible version %d, expected %d or %d", version,
+                                        kFileVersion, kCompressedCaptureSectionFileVersion)};
   }
 
-  return outcome::success();
+  return version;
 }
 
 // Calculates how large (bytes) a section list (with `number_of_sections` sections) is when written
@@ -248,9 +252,10 @@ ErrorMessageOr<void> CaptureFileImpl::ReadHeader() {
   google::protobuf::io::CodedInputStream coded_input{&raw_input};
 
   OUTCOME_TRY(ValidateSignature(&coded_input, &raw_input));
-  OUTCOME_TRY(ValidateFileVersion(&coded_input, &raw_input));
+  OUTCOME_TRY(const uint32_t version, ReadFileVersion(&coded_input, &raw_input));
 
   CaptureFileHeader header{};
+  header.version = version;
 
   if (!coded_input.ReadLittleEndian64(&header.capture_section_offset)) {
     return ErrorMessage{"Could not read the capture section's offset value"};
@@ -368,8 +373,15 @@ ErrorMessageOr<void> CaptureFileImpl::ReadFromSection(uint64_t section_number,
 }
 
 std::unique_ptr<ProtoSectionInputStream> CaptureFileImpl::CreateCaptureSectionInputStream() {
+  return CreateCaptureSectionInputStreamAtChunk(0);
+}
+
+std::unique_ptr<ProtoSectionInputStream> CaptureFileImpl::CreateCaptureSectionInputStreamAtChunk(
+    uint64_t chunk_offset) {
+  ORBIT_CHECK(chunk_offset < capture_section_size_);
   return std::make_unique<orbit_capture_file_internal::ProtoSectionInputStreamImpl>(
-      fd_, header_.capture_section_offset, capture_section_size_);
+      fd_, header_.capture_section_offset + chunk_offset, capture_section_size_ - chunk_offset,
+      /*is_compressed=*/header_.version == kCompressedCaptureSectionFileVersion);
 }
 
 std::unique_ptr<ProtoSectionInputStream> CaptureFileImpl::CreateProtoSectionInputStream(
@@ -17,5 +17,17 @@ constexpr std::string_view kFileSignature = "ORBT";
 static_assert(kFileSignature.size() == 4);
 
 constexpr uint32_t kFileVersion = 1;
+// In this version the Capture Section is a sequence of independently compressed frames, see
+// FORMAT.md. All other sections are unchanged.
+constexpr uint32_t kCompressedCaptureSectionFileVersion = 2;
+
+// Each frame of a compressed Capture Section starts with its uncompressed and compressed size.
+constexpr uint64_t kCompressedFrameHeaderSize = 2 * sizeof(uint32_t);
+// The writer closes a chunk of the Capture Section, i.e., a frame if the section is compressed,
+// after the first message that makes the chunk reach this uncompressed size. The CAPTURE_INDEX
+// section has one entry per chunk.
+constexpr uint64_t kCaptureSectionChunkTargetSize = 1024 * 1024;  // 1Mb
+// Since file input is not trusted, the reader rejects frames exceeding this (uncompressed) size.
+constexpr uint64_t kCompressedFrameMaximumSize = 16 * 1024 * 1024;  // 16Mb
 
 #endif  // CAPTURE_FILE_CONSTANTS_H_
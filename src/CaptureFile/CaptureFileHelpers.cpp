@@ -4,6 +4,7 @@
 
 #include "CaptureFile/CaptureFileHelpers.h"
 
+#include <absl/strings/str_format.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <stddef.h>
@@ -11,9 +12,13 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "CaptureFile/CaptureFile.h"
 #include "CaptureFile/CaptureFileSection.h"
+#include "CaptureFile/ProtoSectionInputStream.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/MakeUniqueForOverwrite.h"
 
@@ -48,4 +53,100 @@ ErrorMessageOr<void> WriteUserData(
   return outcome::success();
 }
 
+namespace {
+
+// Serializes `header` followed by `messages`, each prepended by its size.
+template <typename Header, typename Message>
+[[nodiscard]] std::string SerializeHeaderAndMessages(const Header& header,
+                                                     const std::vector<Message>& messages) {
+  std::string buf;
+  google::protobuf::io::StringOutputStream string_output_stream{&buf};
+  {
+    google::protobuf::io::CodedOutputStream coded_output_stream{&string_output_stream};
+    coded_output_stream.WriteVarint32(header.ByteSizeLong());
+    ORBIT_CHECK(header.SerializeToCodedStream(&coded_output_stream));
+    for (const Message& message : messages) {
+      coded_output_stream.WriteVarint32(message.ByteSizeLong());
+      ORBIT_CHECK(message.SerializeToCodedStream(&coded_output_stream));
+    }
+  }
+  return buf;
+}
+
+[[nodiscard]] ErrorMessageOr<void> AddReadOnlySection(
+    const std::filesystem::path& capture_file_path, uint64_t section_type,
+    std::string_view section_name, const std::string& content) {
+  OUTCOME_TRY(auto&& capture_file, CaptureFile::OpenForReadWrite(capture_file_path));
+  if (capture_file->FindSectionByType(section_type).has_value()) {
+    return ErrorMessage{
+        absl::StrFormat("The capture file already contains a %s section", section_name)};
+  }
+
+  OUTCOME_TRY(auto&& section_index,
+              capture_file->AddAdditionalSectionOfType(section_type, content.size()));
+  OUTCOME_TRY(capture_file->WriteToSection(section_index, 0, content.data(), content.size()));
+
+  return outcome::success();
+}
+
+// Reads the messages of a section written with SerializeHeaderAndMessages. `get_message_count`
+// returns the number of messages from the header.
+template <typename Header, typename Message, typename GetMessageCount>
+[[nodiscard]] ErrorMessageOr<std::optional<std::vector<Message>>> ReadHeaderAndMessages(
+    CaptureFile* capture_file, uint64_t section_type, GetMessageCount get_message_count) {
+  ORBIT_CHECK(capture_file != nullptr);
+  std::optional<uint64_t> section_index = capture_file->FindSectionByType(section_type);
+  if (!section_index.has_value()) return std::nullopt;
+
+  std::unique_ptr<ProtoSectionInputStream> input_stream =
+      capture_file->CreateProtoSectionInputStream(section_index.value());
+  Header header;
+  OUTCOME_TRY(input_stream->ReadMessage(&header));
+
+  std::vector<Message> messages;
+  const uint64_t message_count = get_message_count(header);
+  for (uint64_t i = 0; i < message_count; ++i) {
+    OUTCOME_TRY(input_stream->ReadMessage(&messages.emplace_back()));
+  }
+  return messages;
+}
+
+}  // namespace
+
+ErrorMessageOr<void> WriteCaptureIndex(
+    const std::filesystem::path& capture_file_path,
+    const std::vector<orbit_client_protos::CaptureIndexChunk>& chunks) {
+  // The chunks are written as separate messages, as a single one could exceed the maximum message
+  // size of ProtoSectionInputStream for long captures.
+  orbit_client_protos::CaptureIndexHeader header;
+  header.set_chunk_count(chunks.size());
+  return AddReadOnlySection(capture_file_path, kSectionTypeCaptureIndex, "CAPTURE_INDEX",
+                            SerializeHeaderAndMessages(header, chunks));
+}
+
+ErrorMessageOr<void> WriteCaptureSummary(
+    const std::filesystem::path& capture_file_path,
+    const std::vector<orbit_client_protos::CaptureSummaryEntry>& entries) {
+  orbit_client_protos::CaptureSummaryHeader header;
+  header.set_entry_count(entries.size());
+  return AddReadOnlySection(capture_file_path, kSectionTypeCaptureSummary, "CAPTURE_SUMMARY",
+                            SerializeHeaderAndMessages(header, entries));
+}
+
+ErrorMessageOr<std::optional<std::vector<orbit_client_protos::CaptureIndexChunk>>>
+ReadCaptureIndex(CaptureFile* capture_file) {
+  return ReadHeaderAndMessages<orbit_client_protos::CaptureIndexHeader,
+                               orbit_client_protos::CaptureIndexChunk>(
+      capture_file, kSectionTypeCaptureIndex,
+      [](const orbit_client_protos::CaptureIndexHeader& header) { return header.chunk_count(); });
+}
+
+ErrorMessageOr<std::optional<std::vector<orbit_client_protos::CaptureSummaryEntry>>>
+ReadCaptureSummary(CaptureFile* capture_file) {
+  return ReadHeaderAndMessages<orbit_client_protos::CaptureSummaryHeader,
+                               orbit_client_protos::CaptureSummaryEntry>(
+      capture_file, kSectionTypeCaptureSummary,
+      [](const orbit_client_protos::CaptureSummaryHeader& header) { return header.entry_count(); });
+}
+
 }  // namespace orbit_capture_file
\ No newline at end of file
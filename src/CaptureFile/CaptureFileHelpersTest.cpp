@@ -11,12 +11,15 @@
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "CaptureFile/CaptureFile.h"
 #include "CaptureFile/CaptureFileHelpers.h"
 #include "CaptureFile/CaptureFileOutputStream.h"
 #include "CaptureFile/CaptureFileSection.h"
 #include "CaptureFile/ProtoSectionInputStream.h"
+#include "ClientProtos/capture_index.pb.h"
+#include "ClientProtos/capture_summary.pb.h"
 #include "ClientProtos/user_defined_capture_info.pb.h"
 #include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Result.h"
@@ -25,6 +28,7 @@
 
 namespace orbit_capture_file {
 
+using orbit_test_utils::HasErrorWithMessage;
 using orbit_test_utils::HasNoError;
 
 static constexpr const char* kAnswerString =
@@ -113,4 +117,137 @@ TEST(CaptureFileHelpers, CreateCaptureFileAndWriteUserData) {
   }
 }
 
-}  // namespace orbit_capture_file
\ No newline at end of file
+TEST(CaptureFileHelpers, WriteCaptureIndexAndReadFromChunk) {
+  // Enough events to fill more than one chunk.
+  constexpr uint64_t kEventCount = 50'000;
+
+  for (CaptureSectionCompression compression :
+       {CaptureSectionCompression::kNone, CaptureSectionCompression::kZlib}) {
+    auto temporary_dir_or_error = orbit_test_utils::TemporaryDirectory::Create();
+    ASSERT_THAT(temporary_dir_or_error, HasNoError());
+    orbit_test_utils::TemporaryDirectory temporary_dir = std::move(temporary_dir_or_error.value());
+    const std::filesystem::path file_path = temporary_dir.GetDirectoryPath() / "capture.orbit";
+
+    std::vector<orbit_client_protos::CaptureIndexChunk> written_chunks;
+    {
+      auto output_stream_or_error = CaptureFileOutputStream::Create(file_path, compression);
+      ASSERT_THAT(output_stream_or_error, HasNoError());
+      std::unique_ptr<CaptureFileOutputStream> output_stream =
+          std::move(output_stream_or_error.value());
+      for (uint64_t key = 0; key < kEventCount; ++key) {
+        ASSERT_THAT(
+            output_stream->WriteCaptureEvent(CreateInternedStringCaptureEvent(key, kAnswerString)),
+            HasNoError());
+      }
+      ASSERT_THAT(output_stream->Close(), HasNoError());
+      written_chunks = output_stream->GetCaptureIndex();
+    }
+    ASSERT_GE(written_chunks.size(), 2);
+    ASSERT_THAT(WriteCaptureIndex(file_path, written_chunks), HasNoError());
+    EXPECT_THAT(WriteCaptureIndex(file_path, written_chunks),
+                HasErrorWithMessage("already contains a CAPTURE_INDEX section"));
+
+    auto capture_file_or_error = CaptureFile::OpenForReadWrite(file_path);
+    ASSERT_THAT(capture_file_or_error, HasNoError());
+    std::unique_ptr<CaptureFile> capture_file = std::move(capture_file_or_error.value());
+
+    auto chunks_or_error = ReadCaptureIndex(capture_file.get());
+    ASSERT_THAT(chunks_or_error, HasNoError());
+    ASSERT_TRUE(chunks_or_error.value().has_value());
+    const std::vector<orbit_client_protos::CaptureIndexChunk>& chunks =
+        chunks_or_error.value().value();
+    ASSERT_EQ(chunks.size(), written_chunks.size());
+
+    uint64_t first_key_of_chunk = 0;
+    for (const orbit_client_protos::CaptureIndexChunk& chunk : chunks) {
+      EXPECT_THAT(chunk.event_cases(), testing::ElementsAre(ClientCaptureEvent::kInternedString));
+      auto input_stream = capture_file->CreateCaptureSectionInputStreamAtChunk(chunk.offset());
+      ClientCaptureEvent event;
+      ASSERT_THAT(input_stream->ReadMessage(&event), HasNoError());
+      EXPECT_EQ(event.interned_string().key(), first_key_of_chunk);
+      first_key_of_chunk += chunk.event_count();
+    }
+    EXPECT_EQ(first_key_of_chunk, kEventCount);
+  }
+}
+
+TEST(CaptureFileHelpers, ReadCaptureIndexWithoutIndexSection) {
+  auto temporary_dir_or_error = orbit_test_utils::TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_dir_or_error, HasNoError());
+  orbit_test_utils::TemporaryDirectory temporary_dir = std::move(temporary_dir_or_error.value());
+  const std::filesystem::path file_path = temporary_dir.GetDirectoryPath() / "capture.orbit";
+
+  auto output_stream_or_error = CaptureFileOutputStream::Create(file_path);
+  ASSERT_THAT(output_stream_or_error, HasNoError());
+  ASSERT_THAT(output_stream_or_error.value()->WriteCaptureEvent(
+                  CreateInternedStringCaptureEvent(kAnswerKey, kAnswerString)),
+              HasNoError());
+  ASSERT_THAT(output_stream_or_error.value()->Close(), HasNoError());
+
+  auto capture_file_or_error = CaptureFile::OpenForReadWrite(file_path);
+  ASSERT_THAT(capture_file_or_error, HasNoError());
+  auto chunks_or_error = ReadCaptureIndex(capture_file_or_error.value().get());
+  ASSERT_THAT(chunks_or_error, HasNoError());
+  EXPECT_FALSE(chunks_or_error.value().has_value());
+}
+
+TEST(CaptureFileHelpers, WriteAndReadCaptureSummary) {
+  auto temporary_dir_or_error = orbit_test_utils::TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_dir_or_error, HasNoError());
+  orbit_test_utils::TemporaryDirectory temporary_dir = std::move(temporary_dir_or_error.value());
+  const std::filesystem::path file_path = temporary_dir.GetDirectoryPath() / "capture.orbit";
+
+  {
+    auto output_stream_or_error = CaptureFileOutputStream::Create(file_path);
+    ASSERT_THAT(output_stream_or_error, HasNoError());
+    ASSERT_THAT(output_stream_or_error.value()->WriteCaptureEvent(
+                    CreateInternedStringCaptureEvent(kAnswerKey, kAnswerString)),
+                HasNoError());
+    ASSERT_THAT(output_stream_or_error.value()->Close(), HasNoError());
+  }
+
+  {
+    auto capture_file_or_error = CaptureFile::OpenForReadWrite(file_path);
+    ASSERT_THAT(capture_file_or_error, HasNoError());
+    auto summary_or_error = ReadCaptureSummary(capture_file_or_error.value().get());
+    ASSERT_THAT(summary_or_error, HasNoError());
+    EXPECT_FALSE(summary_or_error.value().has_value());
+  }
+
+  orbit_client_protos::UserDefinedCaptureInfo user_defined_capture_info;
+  user_defined_capture_info.mutable_frame_tracks_info()->add_frame_track_function_ids(1);
+  ASSERT_THAT(WriteUserData(file_path, user_defined_capture_info), HasNoError());
+
+  std::vector<orbit_client_protos::CaptureSummaryEntry> written_entries(2);
+  orbit_client_protos::ScopeStatsSummary* scope_stats = written_entries[0].mutable_scope_stats();
+  scope_stats->set_scope_id(1);
+  scope_stats->set_count(2);
+  scope_stats->add_log2_duration_histogram(0);
+  scope_stats->add_log2_duration_histogram(2);
+  written_entries[1].mutable_thread()->set_tid(kAnswerKey);
+  written_entries[1].mutable_thread()->set_name(kAnswerString);
+  ASSERT_THAT(WriteCaptureSummary(file_path, written_entries), HasNoError());
+  EXPECT_THAT(WriteCaptureSummary(file_path, written_entries),
+              HasErrorWithMessage("already contains a CAPTURE_SUMMARY section"));
+
+  auto capture_file_or_error = CaptureFile::OpenForReadWrite(file_path);
+  ASSERT_THAT(capture_file_or_error, HasNoError());
+  std::unique_ptr<CaptureFile> capture_file = std::move(capture_file_or_error.value());
+  // The user data section stays the last section.
+  ASSERT_EQ(capture_file->GetSectionList().size(), 2);
+  EXPECT_EQ(capture_file->GetSectionList().back().type, kSectionTypeUserData);
+
+  auto summary_or_error = ReadCaptureSummary(capture_file.get());
+  ASSERT_THAT(summary_or_error, HasNoError());
+  ASSERT_TRUE(summary_or_error.value().has_value());
+  const std::vector<orbit_client_protos::CaptureSummaryEntry>& entries =
+      summary_or_error.value().value();
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_EQ(entries[0].scope_stats().scope_id(), 1);
+  EXPECT_EQ(entries[0].scope_stats().count(), 2);
+  EXPECT_THAT(entries[0].scope_stats().log2_duration_histogram(), testing::ElementsAre(0, 2));
+  EXPECT_EQ(entries[1].thread().tid(), kAnswerKey);
+  EXPECT_EQ(entries[1].thread().name(), kAnswerString);
+}
+
+}  // namespace orbit_capture_file
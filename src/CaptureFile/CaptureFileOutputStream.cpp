@@ -13,6 +13,7 @@
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <zlib.h>
 
 #include <optional>
 #include <string>
@@ -21,6 +22,7 @@
 
 #include "CaptureFile/BufferOutputStream.h"
 #include "CaptureFileConstants.h"
+#include "CaptureIndexBuilder.h"
 #include "OrbitBase/File.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/SafeStrerror.h"
@@ -29,12 +31,22 @@ namespace orbit_capture_file {
 
 namespace {
 
+// signature - 4bytes, version - 4bytes
+// capture section offset - 8 bytes
+// additional section offset - 8 bytes
+constexpr uint64_t kCaptureSectionOffset =
+    kFileSignature.size() + sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
 class CaptureFileOutputStreamImpl final : public CaptureFileOutputStream {
  public:
-  explicit CaptureFileOutputStreamImpl(std::filesystem::path path)
-      : output_type_(OutputType::kFile), path_{std::move(path)} {}
-  explicit CaptureFileOutputStreamImpl(BufferOutputStream* output_buffer)
-      : output_type_(OutputType::kBuffer), output_buffer_(output_buffer) {}
+  explicit CaptureFileOutputStreamImpl(std::filesystem::path path,
+                                       CaptureSectionCompression compression)
+      : output_type_(OutputType::kFile), compression_{compression}, path_{std::move(path)} {}
+  explicit CaptureFileOutputStreamImpl(BufferOutputStream* output_buffer,
+                                       CaptureSectionCompression compression)
+      : output_type_(OutputType::kBuffer),
+        compression_{compression},
+        output_buffer_(output_buffer) {}
   ~CaptureFileOutputStreamImpl() override;
 
   [[nodiscard]] ErrorMessageOr<void> Initialize();
@@ -42,10 +54,18 @@ class CaptureFileOutputStreamImpl final : public CaptureFileOutputStream {
       const orbit_grpc_protos::ClientCaptureEvent& event) override;
   [[nodiscard]] ErrorMessageOr<void> Close() override;
   [[nodiscard]] bool IsOpen() override;
+  [[nodiscard]] const std::vector<orbit_client_protos::CaptureIndexChunk>& GetCaptureIndex()
+      const override {
+    return capture_index_builder_.GetChunks();
+  }
 
  private:
   void Reset();
   [[nodiscard]] ErrorMessageOr<void> WriteHeader();
+  // Returns the number of bytes of the Capture Section written so far.
+  [[nodiscard]] uint64_t GetCaptureSectionSize() const;
+  // Compresses the events accumulated in `uncompressed_frame_` and writes them as one frame.
+  [[nodiscard]] ErrorMessageOr<void> WriteCompressedFrame();
   [[nodiscard]] std::string_view GetErrorFromOutputStream() const;
   // Handles write error by cleaning up the file and generating error message.
   [[nodiscard]] ErrorMessage HandleWriteError(const char* section_name,
@@ -55,12 +75,16 @@ class CaptureFileOutputStreamImpl final : public CaptureFileOutputStream {
 
   enum class OutputType { kFile, kBuffer };
   OutputType output_type_;
+  CaptureSectionCompression compression_;
 
   std::filesystem::path path_;
   orbit_base::UniqueFd fd_;
   BufferOutputStream* output_buffer_ = nullptr;
   std::unique_ptr<google::protobuf::io::ZeroCopyOutputStream> zero_copy_output_stream_;
   std::optional<google::protobuf::io::CodedOutputStream> coded_output_;
+  std::string uncompressed_frame_;
+  std::string compressed_frame_;
+  orbit_capture_file_internal::CaptureIndexBuilder capture_index_builder_;
 };
 
 CaptureFileOutputStreamImpl::~CaptureFileOutputStreamImpl() {
@@ -101,6 +125,11 @@ ErrorMessageOr<void> CaptureFileOutputStreamImpl::Initialize() {
 }
 
 ErrorMessageOr<void> CaptureFileOutputStreamImpl::Close() {
+  if (!uncompressed_frame_.empty()) {
+    OUTCOME_TRY(WriteCompressedFrame());
+  }
+  if (capture_index_builder_.HasOpenChunk()) capture_index_builder_.FinishChunk();
+
   coded_output_->Trim();
   if (coded_output_->HadError()) {
     return HandleWriteError("Unknown", GetErrorFromOutputStream());
@@ -162,25 +191,84 @@ ErrorMessageOr<void> CaptureFileOutputStreamImpl::WriteCaptureEvent(
   ORBIT_CHECK(coded_output_.has_value());
   ORBIT_CHECK(zero_copy_output_stream_ != nullptr);
 
+  if (!capture_index_builder_.HasOpenChunk()) {
+    capture_index_builder_.StartChunk(GetCaptureSectionSize());
+  }
+  capture_index_builder_.AddEvent(event);
+
   uint32_t event_size = event.ByteSizeLong();
+
+  if (compression_ == CaptureSectionCompression::kZlib) {
+    const size_t offset = uncompressed_frame_.size();
+    uncompressed_frame_.resize(
+        offset + google::protobuf::io::CodedOutputStream::VarintSize32(event_size) + event_size);
+    uint8_t* target = absl::bit_cast<uint8_t*>(uncompressed_frame_.data() + offset);
+    target = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(event_size, target);
+    event.SerializeWithCachedSizesToArray(target);
+
+    if (uncompressed_frame_.size() >= kCaptureSectionChunkTargetSize) {
+      OUTCOME_TRY(WriteCompressedFrame());
+    }
+    return outcome::success();
+  }
+
   coded_output_->WriteVarint32(event_size);
   if (!event.SerializeToCodedStream(&coded_output_.value()) || coded_output_->HadError()) {
     return HandleWriteError("Capture", GetErrorFromOutputStream());
   }
 
+  if (GetCaptureSectionSize() - capture_index_builder_.GetCurrentChunkOffset() >=
+      kCaptureSectionChunkTargetSize) {
+    capture_index_builder_.FinishChunk();
+  }
+
+  return outcome::success();
+}
+
+uint64_t CaptureFileOutputStreamImpl::GetCaptureSectionSize() const {
+  return coded_output_->ByteCount() - kCaptureSectionOffset;
+}
+
+ErrorMessageOr<void> CaptureFileOutputStreamImpl::WriteCompressedFrame() {
+  ORBIT_CHECK(coded_output_.has_value());
+  // Frames are closed at the target size, so only a huge single event can exceed the limit.
+  if (uncompressed_frame_.size() > kCompressedFrameMaximumSize) {
+    return HandleWriteError(
+        "Capture", absl::StrFormat("Event of %u bytes exceeds the maximum frame size",
+                                   uncompressed_frame_.size()));
+  }
+
+  uLongf compressed_size = compressBound(uncompressed_frame_.size());
+  compressed_frame_.resize(compressed_size);
+  // Frames are compressed while capturing, so favor speed over compression ratio.
+  const int result = compress2(absl::bit_cast<Bytef*>(compressed_frame_.data()), &compressed_size,
+                               absl::bit_cast<const Bytef*>(uncompressed_frame_.data()),
+                               uncompressed_frame_.size(), Z_BEST_SPEED);
+  if (result != Z_OK) {
+    return HandleWriteError("Capture", absl::StrFormat("zlib error %d", result));
+  }
+
+  coded_output_->WriteLittleEndian32(static_cast<uint32_t>(uncompressed_frame_.size()));
+  coded_output_->WriteLittleEndian32(static_cast<uint32_t>(compressed_size));
+  coded_output_->WriteRaw(compressed_frame_.data(), static_cast<int>(compressed_size));
+  if (coded_output_->HadError()) {
+    return HandleWriteError("Capture", GetErrorFromOutputStream());
+  }
+
+  uncompressed_frame_.clear();
+  capture_index_builder_.FinishChunk();
   return outcome::success();
 }
 
 ErrorMessageOr<void> CaptureFileOutputStreamImpl::WriteHeader() {
   ORBIT_CHECK(coded_output_.has_value());
 
+  const uint32_t version = compression_ == CaptureSectionCompression::kNone
+                               ? kFileVersion
+                               : kCompressedCaptureSectionFileVersion;
   std::string header{kFileSignature};
-  header.append(std::string_view(absl::bit_cast<char*>(&kFileVersion), sizeof(kFileVersion)));
-  // signature - 4bytes, version - 4bytes
-  // capture section offset - 8 bytes
-  // additional section offset - 8 bytes
-  uint64_t capture_section_offset =
-      kFileSignature.size() + sizeof(kFileVersion) + 2 * sizeof(uint64_t);
+  header.append(std::string_view(absl::bit_cast<const char*>(&version), sizeof(version)));
+  uint64_t capture_section_offset = kCaptureSectionOffset;
   header.append(std::string_view(absl::bit_cast<char*>(&capture_section_offset),
                                  sizeof(capture_section_offset)));
   uint64_t additional_section_list_offset =
@@ -201,8 +289,9 @@ ErrorMessageOr<void> CaptureFileOutputStreamImpl::WriteHeader() {
 }  // namespace
 
 ErrorMessageOr<std::unique_ptr<CaptureFileOutputStream>> CaptureFileOutputStream::Create(
-    std::filesystem::path path) {
-  auto implementation = std::make_unique<CaptureFileOutputStreamImpl>(std::move(path));
+    std::filesystem::path path, CaptureSectionCompression compression) {
+  auto implementation =
+      std::make_unique<CaptureFileOutputStreamImpl>(std::move(path), compression);
   auto init_result = implementation->Initialize();
   if (init_result.has_error()) {
     return init_result.error();
@@ -212,8 +301,8 @@ ErrorMessageOr<std::unique_ptr<CaptureFileOutputStream>> CaptureFileOutputStream
 }
 
 std::unique_ptr<CaptureFileOutputStream> CaptureFileOutputStream::Create(
-    BufferOutputStream* output_buffer) {
-  auto implementation = std::make_unique<CaptureFileOutputStreamImpl>(output_buffer);
+    BufferOutputStream* output_buffer, CaptureSectionCompression compression) {
+  auto implementation = std::make_unique<CaptureFileOutputStreamImpl>(output_buffer, compression);
   auto init_result = implementation->Initialize();
   ORBIT_CHECK(!init_result.has_error());
 
@@ -303,6 +303,41 @@ TEST_F(CaptureFileTest, CreateCaptureFileAndAddUserDataSection) {
   }
 }
 
+TEST_F(CaptureFileHeaderTest, CreateCompressedCaptureFileAndReadMainSection) {
+  // Enough events to fill more than one compressed frame.
+  constexpr uint64_t kEventCount = 50'000;
+  {
+    auto output_stream_or_error = CaptureFileOutputStream::Create(
+        GetCaptureFilePath().string(), CaptureSectionCompression::kZlib);
+    ASSERT_THAT(output_stream_or_error, HasNoError());
+    for (uint64_t key = 0; key < kEventCount; ++key) {
+      ASSERT_THAT(output_stream_or_error.value()->WriteCaptureEvent(
+                      CreateInternedStringCaptureEvent(key, kAnswerString)),
+                  HasNoError());
+    }
+    ASSERT_THAT(output_stream_or_error.value()->Close(), HasNoError());
+  }
+
+  auto capture_file_or_error = CaptureFile::OpenForReadWrite(GetCaptureFilePath());
+  ASSERT_THAT(capture_file_or_error, HasNoError());
+  ASSERT_THAT(capture_file_or_error.value()->AddUserDataSection(333), HasValue(0));
+
+  auto capture_section = capture_file_or_error.value()->CreateCaptureSectionInputStream();
+  for (uint64_t key = 0; key < kEventCount; ++key) {
+    ClientCaptureEvent event;
+    ASSERT_THAT(capture_section->ReadMessage(&event), HasNoError());
+    ASSERT_EQ(event.event_case(), ClientCaptureEvent::kInternedString);
+    ASSERT_EQ(event.interned_string().key(), key);
+    ASSERT_EQ(event.interned_string().intern(), kAnswerString);
+  }
+
+  // The events compress well, so the file must be much smaller than the uncompressed events.
+  std::error_code error;
+  const uintmax_t file_size = std::filesystem::file_size(GetCaptureFilePath(), error);
+  ASSERT_FALSE(error) << error.message();
+  EXPECT_LT(file_size, kEventCount * std::string_view{kAnswerString}.size() / 4);
+}
+
 TEST_F(CaptureFileHeaderTest, OpenCaptureFileInvalidSignature) {
   EXPECT_THAT(
       orbit_base::WriteStringToFile(GetCaptureFilePath(), "This is not an Orbit Capture File"),
@@ -0,0 +1,65 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "CaptureIndexBuilder.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "CaptureFile/CaptureEventThreadIdsAndTimestamps.h"
+#include "OrbitBase/Logging.h"
+
+using orbit_client_protos::CaptureIndexChunk;
+using orbit_grpc_protos::ClientCaptureEvent;
+
+namespace orbit_capture_file_internal {
+
+void CaptureIndexBuilder::StartChunk(uint64_t offset) {
+  if (HasOpenChunk()) FinishChunk();
+  current_chunk_.emplace();
+  current_chunk_->set_offset(offset);
+}
+
+void CaptureIndexBuilder::OnThreadId(uint32_t tid) { tids_.insert(tid); }
+
+void CaptureIndexBuilder::OnTimestamp(uint64_t timestamp_ns) {
+  min_timestamp_ns_ = std::min(min_timestamp_ns_.value_or(timestamp_ns), timestamp_ns);
+  max_timestamp_ns_ = std::max(max_timestamp_ns_, timestamp_ns);
+}
+
+void CaptureIndexBuilder::OnTimeRange(uint64_t start_timestamp_ns, uint64_t end_timestamp_ns) {
+  OnTimestamp(start_timestamp_ns);
+  OnTimestamp(end_timestamp_ns);
+}
+
+void CaptureIndexBuilder::AddEvent(const ClientCaptureEvent& event) {
+  ORBIT_CHECK(HasOpenChunk());
+  current_chunk_->set_event_count(current_chunk_->event_count() + 1);
+  event_cases_.insert(event.event_case());
+
+  orbit_capture_file::VisitThreadIdsAndTimestamps(event, this);
+}
+
+void CaptureIndexBuilder::FinishChunk() {
+  ORBIT_CHECK(HasOpenChunk());
+
+  if (min_timestamp_ns_.has_value()) {
+    current_chunk_->set_min_timestamp_ns(min_timestamp_ns_.value());
+    current_chunk_->set_max_timestamp_ns(max_timestamp_ns_);
+  }
+  current_chunk_->mutable_tids()->Add(tids_.begin(), tids_.end());
+  std::sort(current_chunk_->mutable_tids()->begin(), current_chunk_->mutable_tids()->end());
+  current_chunk_->mutable_event_cases()->Add(event_cases_.begin(), event_cases_.end());
+  std::sort(current_chunk_->mutable_event_cases()->begin(),
+            current_chunk_->mutable_event_cases()->end());
+
+  chunks_.push_back(std::move(current_chunk_.value()));
+  current_chunk_.reset();
+  min_timestamp_ns_.reset();
+  max_timestamp_ns_ = 0;
+  tids_.clear();
+  event_cases_.clear();
+}
+
+}  // namespace orbit_capture_file_internal
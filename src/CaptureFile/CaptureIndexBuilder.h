@@ -0,0 +1,55 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CAPTURE_INDEX_BUILDER_H_
+#define CAPTURE_INDEX_BUILDER_H_
+
+#include <absl/container/flat_hash_set.h>
+#include <stdint.h>
+
+#include <optional>
+#include <vector>
+
+#include "ClientProtos/capture_index.pb.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Logging.h"
+
+namespace orbit_capture_file_internal {
+
+// Collects the CaptureIndexChunks of the CAPTURE_INDEX section while the Capture Section is
+// written: StartChunk, AddEvent for each event of the chunk, then FinishChunk.
+class CaptureIndexBuilder {
+ public:
+  // `offset` is the offset of the chunk from the start of the Capture Section.
+  void StartChunk(uint64_t offset);
+  [[nodiscard]] bool HasOpenChunk() const { return current_chunk_.has_value(); }
+  [[nodiscard]] uint64_t GetCurrentChunkOffset() const {
+    ORBIT_CHECK(HasOpenChunk());
+    return current_chunk_->offset();
+  }
+  // Records the timestamps, thread ids and the kind of `event` in the current chunk.
+  void AddEvent(const orbit_grpc_protos::ClientCaptureEvent& event);
+  void FinishChunk();
+
+  [[nodiscard]] const std::vector<orbit_client_protos::CaptureIndexChunk>& GetChunks() const {
+    return chunks_;
+  }
+
+  // Visitor of orbit_capture_file::VisitThreadIdsAndTimestamps, called by AddEvent.
+  void OnThreadId(uint32_t tid);
+  void OnTimestamp(uint64_t timestamp_ns);
+  void OnTimeRange(uint64_t start_timestamp_ns, uint64_t end_timestamp_ns);
+
+ private:
+  std::optional<orbit_client_protos::CaptureIndexChunk> current_chunk_;
+  std::optional<uint64_t> min_timestamp_ns_;
+  uint64_t max_timestamp_ns_ = 0;
+  absl::flat_hash_set<uint32_t> tids_;
+  absl::flat_hash_set<int> event_cases_;
+  std::vector<orbit_client_protos::CaptureIndexChunk> chunks_;
+};
+
+}  // namespace orbit_capture_file_internal
+
+#endif  // CAPTURE_INDEX_BUILDER_H_
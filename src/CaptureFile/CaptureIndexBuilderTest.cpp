@@ -0,0 +1,69 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "CaptureIndexBuilder.h"
+#include "ClientProtos/capture_index.pb.h"
+#include "GrpcProtos/capture.pb.h"
+
+using orbit_client_protos::CaptureIndexChunk;
+using orbit_grpc_protos::ClientCaptureEvent;
+using testing::ElementsAre;
+
+namespace orbit_capture_file_internal {
+
+TEST(CaptureIndexBuilder, RecordsTimeRangeThreadIdsAndEventCases) {
+  CaptureIndexBuilder builder;
+  builder.StartChunk(0);
+
+  ClientCaptureEvent function_call_event;
+  function_call_event.mutable_function_call()->set_tid(43);
+  function_call_event.mutable_function_call()->set_duration_ns(100);
+  function_call_event.mutable_function_call()->set_end_timestamp_ns(1100);
+  builder.AddEvent(function_call_event);
+
+  ClientCaptureEvent interned_string_event;
+  interned_string_event.mutable_interned_string()->set_key(1);
+  builder.AddEvent(interned_string_event);
+
+  ClientCaptureEvent callstack_sample_batch_event;
+  orbit_grpc_protos::CallstackSampleBatch* batch =
+      callstack_sample_batch_event.mutable_callstack_sample_batch();
+  batch->add_tids(44);
+  batch->add_timestamp_deltas_ns(2000);
+  batch->add_tids(42);
+  batch->add_timestamp_deltas_ns(-1500);
+  builder.AddEvent(callstack_sample_batch_event);
+
+  EXPECT_EQ(builder.GetCurrentChunkOffset(), 0);
+  builder.StartChunk(123);
+  builder.AddEvent(interned_string_event);
+  builder.FinishChunk();
+
+  ASSERT_EQ(builder.GetChunks().size(), 2);
+
+  const CaptureIndexChunk& first_chunk = builder.GetChunks()[0];
+  EXPECT_EQ(first_chunk.offset(), 0);
+  EXPECT_EQ(first_chunk.event_count(), 3);
+  EXPECT_EQ(first_chunk.min_timestamp_ns(), 500);
+  EXPECT_EQ(first_chunk.max_timestamp_ns(), 2000);
+  EXPECT_THAT(first_chunk.tids(), ElementsAre(42, 43, 44));
+  EXPECT_THAT(first_chunk.event_cases(), ElementsAre(ClientCaptureEvent::kFunctionCall,
+                                                     ClientCaptureEvent::kCallstackSampleBatch,
+                                                     ClientCaptureEvent::kInternedString));
+
+  const CaptureIndexChunk& second_chunk = builder.GetChunks()[1];
+  EXPECT_EQ(second_chunk.offset(), 123);
+  EXPECT_EQ(second_chunk.event_count(), 1);
+  EXPECT_EQ(second_chunk.min_timestamp_ns(), 0);
+  EXPECT_EQ(second_chunk.max_timestamp_ns(), 0);
+  EXPECT_THAT(second_chunk.tids(), ElementsAre());
+  EXPECT_THAT(second_chunk.event_cases(), ElementsAre(ClientCaptureEvent::kInternedString));
+  EXPECT_FALSE(builder.HasOpenChunk());
+}
+
+}  // namespace orbit_capture_file_internal
@@ -0,0 +1,97 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "CompressedFrameInputStream.h"
+
+#include <absl/strings/str_format.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <zlib.h>
+
+#include "CaptureFileConstants.h"
+
+namespace orbit_capture_file_internal {
+
+bool CompressedFrameInputStream::DecompressNextFrame() {
+  // The CodedInputStream backs up the bytes it read ahead into `input_stream_` on destruction.
+  google::protobuf::io::CodedInputStream coded_input_stream{input_stream_};
+
+  uint32_t uncompressed_size = 0;
+  uint32_t compressed_size = 0;
+  if (!coded_input_stream.ReadLittleEndian32(&uncompressed_size) ||
+      !coded_input_stream.ReadLittleEndian32(&compressed_size)) {
+    return false;
+  }
+
+  // The compressed size of the frame is bounded by the uncompressed size, see compressBound.
+  if (uncompressed_size == 0 || uncompressed_size > kCompressedFrameMaximumSize ||
+      compressed_size > compressBound(uncompressed_size)) {
+    last_error_ = ErrorMessage{
+        absl::StrFormat("Invalid compressed frame of size %u (%u bytes uncompressed)",
+                        compressed_size, uncompressed_size)};
+    return false;
+  }
+
+  compressed_frame_.resize(compressed_size);
+  if (!coded_input_stream.ReadRaw(compressed_frame_.data(), static_cast<int>(compressed_size))) {
+    last_error_ = ErrorMessage{"Unexpected end of section while reading a compressed frame"};
+    return false;
+  }
+
+  byte_count_of_previous_frames_ += static_cast<int64_t>(frame_.size());
+  frame_.resize(uncompressed_size);
+  position_in_frame_ = 0;
+
+  uLongf decompressed_size = uncompressed_size;
+  const int result =
+      uncompress(frame_.data(), &decompressed_size, compressed_frame_.data(), compressed_size);
+  if (result != Z_OK || decompressed_size != uncompressed_size) {
+    frame_.clear();
+    last_error_ = ErrorMessage{absl::StrFormat(
+        "Unable to decompress frame of size %u (zlib error %d)", compressed_size, result)};
+    return false;
+  }
+
+  return true;
+}
+
+bool CompressedFrameInputStream::Next(const void** data, int* size) {
+  ORBIT_CHECK(data != nullptr);
+  ORBIT_CHECK(size != nullptr);
+
+  if (last_error_.has_value()) return false;
+
+  if (position_in_frame_ == frame_.size() && !DecompressNextFrame()) return false;
+
+  *data = frame_.data() + position_in_frame_;
+  *size = static_cast<int>(frame_.size() - position_in_frame_);
+  position_in_frame_ = frame_.size();
+  return true;
+}
+
+void CompressedFrameInputStream::BackUp(int count) {
+  ORBIT_CHECK(count >= 0);
+  ORBIT_CHECK(static_cast<size_t>(count) <= position_in_frame_);
+  position_in_frame_ -= count;
+}
+
+bool CompressedFrameInputStream::Skip(int count) {
+  ORBIT_CHECK(count >= 0);
+
+  if (last_error_.has_value()) return false;
+
+  size_t bytes_to_skip = count;
+  while (bytes_to_skip > frame_.size() - position_in_frame_) {
+    bytes_to_skip -= frame_.size() - position_in_frame_;
+    position_in_frame_ = frame_.size();
+    if (!DecompressNextFrame()) return false;
+  }
+  position_in_frame_ += bytes_to_skip;
+  return true;
+}
+
+int64_t CompressedFrameInputStream::ByteCount() const {
+  return byte_count_of_previous_frames_ + static_cast<int64_t>(position_in_frame_);
+}
+
+}  // namespace orbit_capture_file_internal
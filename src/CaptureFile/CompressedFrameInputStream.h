@@ -0,0 +1,56 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef COMPRESSED_FRAME_INPUT_STREAM_H_
+#define COMPRESSED_FRAME_INPUT_STREAM_H_
+
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <optional>
+#include <vector>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_capture_file_internal {
+
+// ZeroCopyInputStream that decompresses the zlib-compressed frames read from `input_stream`, see
+// the description of the compressed Capture Section in FORMAT.md. Frames are decompressed one at a
+// time, when the previous one has been consumed, so that memory usage doesn't depend on the size of
+// the section.
+class CompressedFrameInputStream : public google::protobuf::io::ZeroCopyInputStream {
+ public:
+  explicit CompressedFrameInputStream(google::protobuf::io::ZeroCopyInputStream* input_stream)
+      : input_stream_{input_stream} {
+    ORBIT_CHECK(input_stream_ != nullptr);
+  }
+
+  bool Next(const void** data, int* size) override;
+  // As required by ZeroCopyInputStream, `count` can't exceed the size returned by the last Next().
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  [[nodiscard]] int64_t ByteCount() const override;
+
+  // Returns the error that made Next() or Skip() fail. Errors of the underlying stream are not
+  // included.
+  [[nodiscard]] std::optional<ErrorMessage> GetLastError() const { return last_error_; }
+
+ private:
+  // Replaces the current frame with the next one. Returns false at the end of `input_stream_` and
+  // on errors, in which case `last_error_` is set.
+  [[nodiscard]] bool DecompressNextFrame();
+
+  google::protobuf::io::ZeroCopyInputStream* input_stream_;
+  std::vector<uint8_t> compressed_frame_;
+  std::vector<uint8_t> frame_;
+  size_t position_in_frame_ = 0;
+  int64_t byte_count_of_previous_frames_ = 0;
+  std::optional<ErrorMessage> last_error_{};
+};
+
+}  // namespace orbit_capture_file_internal
+
+#endif  // COMPRESSED_FRAME_INPUT_STREAM_H_
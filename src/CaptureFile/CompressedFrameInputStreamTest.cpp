@@ -0,0 +1,121 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/base/casts.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <zlib.h>
+
+#include <string>
+#include <string_view>
+
+#include "CompressedFrameInputStream.h"
+
+namespace orbit_capture_file_internal {
+
+namespace {
+
+void AppendCompressedFrame(std::string_view content, std::string* section) {
+  uLongf compressed_size = compressBound(content.size());
+  std::string compressed(compressed_size, '\0');
+  ASSERT_EQ(compress2(absl::bit_cast<Bytef*>(compressed.data()), &compressed_size,
+                      absl::bit_cast<const Bytef*>(content.data()), content.size(), Z_BEST_SPEED),
+            Z_OK);
+  const auto uncompressed_size32 = static_cast<uint32_t>(content.size());
+  const auto compressed_size32 = static_cast<uint32_t>(compressed_size);
+  section->append(absl::bit_cast<const char*>(&uncompressed_size32), sizeof(uncompressed_size32));
+  section->append(absl::bit_cast<const char*>(&compressed_size32), sizeof(compressed_size32));
+  section->append(compressed.data(), compressed_size);
+}
+
+[[nodiscard]] std::string_view ToStringView(const void* data, int size) {
+  return {static_cast<const char*>(data), static_cast<size_t>(size)};
+}
+
+}  // namespace
+
+TEST(CompressedFrameInputStream, ReadsFramesOneAtATime) {
+  std::string section;
+  AppendCompressedFrame("Vestibulum euismod sapien", &section);
+  AppendCompressedFrame(" eget urna molestie", &section);
+  google::protobuf::io::ArrayInputStream array_input_stream{section.data(),
+                                                            static_cast<int>(section.size())};
+  CompressedFrameInputStream input_stream{&array_input_stream};
+  EXPECT_EQ(input_stream.ByteCount(), 0);
+
+  const void* data = nullptr;
+  int size = 0;
+  ASSERT_TRUE(input_stream.Next(&data, &size));
+  EXPECT_EQ(ToStringView(data, size), "Vestibulum euismod sapien");
+  EXPECT_EQ(input_stream.ByteCount(), 25);
+
+  input_stream.BackUp(6);
+  EXPECT_EQ(input_stream.ByteCount(), 19);
+  ASSERT_TRUE(input_stream.Next(&data, &size));
+  EXPECT_EQ(ToStringView(data, size), "sapien");
+
+  ASSERT_TRUE(input_stream.Next(&data, &size));
+  EXPECT_EQ(ToStringView(data, size), " eget urna molestie");
+  EXPECT_EQ(input_stream.ByteCount(), 44);
+
+  EXPECT_FALSE(input_stream.Next(&data, &size));
+  EXPECT_FALSE(input_stream.GetLastError().has_value());
+}
+
+TEST(CompressedFrameInputStream, SkipsAcrossFrames) {
+  std::string section;
+  AppendCompressedFrame("Vestibulum euismod sapien", &section);
+  AppendCompressedFrame(" eget urna molestie", &section);
+  google::protobuf::io::ArrayInputStream array_input_stream{section.data(),
+                                                            static_cast<int>(section.size())};
+  CompressedFrameInputStream input_stream{&array_input_stream};
+
+  ASSERT_TRUE(input_stream.Skip(31));
+  EXPECT_EQ(input_stream.ByteCount(), 31);
+
+  const void* data = nullptr;
+  int size = 0;
+  ASSERT_TRUE(input_stream.Next(&data, &size));
+  EXPECT_EQ(ToStringView(data, size), "urna molestie");
+
+  input_stream.BackUp(13);
+  EXPECT_FALSE(input_stream.Skip(14));
+  EXPECT_FALSE(input_stream.GetLastError().has_value());
+}
+
+TEST(CompressedFrameInputStream, InvalidFrameSizes) {
+  std::string section;
+  AppendCompressedFrame("Vestibulum euismod sapien", &section);
+  // Claim a compressed size that no frame of 25 uncompressed bytes can have.
+  section[4] = static_cast<char>(0xff);
+  google::protobuf::io::ArrayInputStream array_input_stream{section.data(),
+                                                            static_cast<int>(section.size())};
+  CompressedFrameInputStream input_stream{&array_input_stream};
+
+  const void* data = nullptr;
+  int size = 0;
+  EXPECT_FALSE(input_stream.Next(&data, &size));
+  ASSERT_TRUE(input_stream.GetLastError().has_value());
+  EXPECT_EQ(input_stream.GetLastError()->message(),
+            "Invalid compressed frame of size 255 (25 bytes uncompressed)");
+}
+
+TEST(CompressedFrameInputStream, TruncatedFrame) {
+  std::string section;
+  AppendCompressedFrame("Vestibulum euismod sapien", &section);
+  section.resize(section.size() - 1);
+  google::protobuf::io::ArrayInputStream array_input_stream{section.data(),
+                                                            static_cast<int>(section.size())};
+  CompressedFrameInputStream input_stream{&array_input_stream};
+
+  const void* data = nullptr;
+  int size = 0;
+  EXPECT_FALSE(input_stream.Next(&data, &size));
+  ASSERT_TRUE(input_stream.GetLastError().has_value());
+  EXPECT_EQ(input_stream.GetLastError()->message(),
+            "Unexpected end of section while reading a compressed frame");
+}
+
+}  // namespace orbit_capture_file_internal
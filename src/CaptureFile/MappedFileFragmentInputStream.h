@@ -0,0 +1,64 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MAPPED_FILE_FRAGMENT_INPUT_STREAM_H_
+#define MAPPED_FILE_FRAGMENT_INPUT_STREAM_H_
+
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_capture_file_internal {
+
+// ZeroCopyInputStream for a file fragment with offset and size, like FileFragmentInputStream, but
+// the fragment is memory-mapped, so that the data is read straight from the page cache instead of
+// being copied to a buffer. Pages are mapped for sequential access, and pages that have been read
+// are unmapped again as the stream advances, so that resident memory stays bounded.
+class MappedFileFragmentInputStream : public google::protobuf::io::ZeroCopyInputStream {
+ public:
+  // Returns an error if the fragment can't be mapped, including when it extends beyond the end of
+  // the file, as accessing such a mapping would raise SIGBUS.
+  [[nodiscard]] static ErrorMessageOr<std::unique_ptr<MappedFileFragmentInputStream>> Create(
+      const orbit_base::UniqueFd& fd, uint64_t file_offset, uint64_t size);
+
+  MappedFileFragmentInputStream(const MappedFileFragmentInputStream&) = delete;
+  MappedFileFragmentInputStream& operator=(const MappedFileFragmentInputStream&) = delete;
+  ~MappedFileFragmentInputStream() override;
+
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  [[nodiscard]] int64_t ByteCount() const override;
+
+ private:
+  MappedFileFragmentInputStream(void* mapping, size_t mapping_size, size_t fragment_start,
+                                size_t page_size)
+      : mapping_{static_cast<uint8_t*>(mapping)},
+        mapping_size_{mapping_size},
+        fragment_start_{fragment_start},
+        current_position_{fragment_start},
+        released_until_{0},
+        page_size_{page_size} {}
+
+  // Unmaps the pages before the current position, once there are enough of them.
+  void ReleaseConsumedPages();
+
+  uint8_t* const mapping_;
+  const size_t mapping_size_;
+  // Positions are relative to the start of the mapping, which is page-aligned and can hence start
+  // before the fragment.
+  const size_t fragment_start_;
+  size_t current_position_;
+  size_t released_until_;
+  const size_t page_size_;
+};
+
+}  // namespace orbit_capture_file_internal
+
+#endif  // MAPPED_FILE_FRAGMENT_INPUT_STREAM_H_
@@ -0,0 +1,115 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_format.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "MappedFileFragmentInputStream.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/SafeStrerror.h"
+
+namespace orbit_capture_file_internal {
+
+namespace {
+
+// Next() returns blocks of at most this size, so that ReleaseConsumedPages runs regularly.
+constexpr size_t kBlockSize = 1024 * 1024;
+// Pages are unmapped in batches of this size, to limit the number of madvise calls.
+constexpr size_t kReleaseThreshold = 64 * 1024 * 1024;
+
+}  // namespace
+
+ErrorMessageOr<std::unique_ptr<MappedFileFragmentInputStream>>
+MappedFileFragmentInputStream::Create(const orbit_base::UniqueFd& fd, uint64_t file_offset,
+                                      uint64_t size) {
+  ORBIT_CHECK(size > 0);
+
+  struct stat file_stat {};
+  if (fstat(fd.get(), &file_stat) == -1) {
+    return ErrorMessage{absl::StrFormat("Unable to stat file: %s", SafeStrerror(errno))};
+  }
+  if (file_offset + size > static_cast<uint64_t>(file_stat.st_size)) {
+    return ErrorMessage{
+        absl::StrFormat("The fragment [%u, %u) extends beyond the end of file at %u", file_offset,
+                        file_offset + size, file_stat.st_size)};
+  }
+
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const uint64_t mapping_offset = file_offset - file_offset % page_size;
+  const uint64_t mapping_size = file_offset + size - mapping_offset;
+  if (mapping_size > std::numeric_limits<size_t>::max()) {
+    return ErrorMessage{absl::StrFormat("The fragment of size %u is too large to map", size)};
+  }
+
+  void* mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd.get(),
+                       static_cast<off_t>(mapping_offset));
+  if (mapping == MAP_FAILED) {
+    return ErrorMessage{absl::StrFormat("Unable to map file: %s", SafeStrerror(errno))};
+  }
+  // This is only a hint, so ignore errors.
+  (void)madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+
+  return std::unique_ptr<MappedFileFragmentInputStream>{new MappedFileFragmentInputStream{
+      mapping, mapping_size, file_offset - mapping_offset, page_size}};
+}
+
+MappedFileFragmentInputStream::~MappedFileFragmentInputStream() {
+  if (munmap(mapping_, mapping_size_) == -1) {
+    ORBIT_ERROR("Unable to unmap file fragment: %s", SafeStrerror(errno));
+  }
+}
+
+void MappedFileFragmentInputStream::ReleaseConsumedPages() {
+  const size_t release_until = current_position_ - current_position_ % page_size_;
+  if (release_until - released_until_ < kReleaseThreshold) return;
+
+  // The mapping is private and read-only, so this only drops the pages from the mapping. They stay
+  // in the page cache and would be mapped again if accessed.
+  (void)madvise(mapping_ + released_until_, release_until - released_until_, MADV_DONTNEED);
+  released_until_ = release_until;
+}
+
+bool MappedFileFragmentInputStream::Next(const void** data, int* size) {
+  ORBIT_CHECK(data != nullptr);
+  ORBIT_CHECK(size != nullptr);
+
+  if (current_position_ == mapping_size_) return false;
+
+  ReleaseConsumedPages();
+
+  const size_t block_size = std::min(kBlockSize, mapping_size_ - current_position_);
+  *data = mapping_ + current_position_;
+  *size = static_cast<int>(block_size);
+  current_position_ += block_size;
+  return true;
+}
+
+void MappedFileFragmentInputStream::BackUp(int count) {
+  ORBIT_CHECK(count >= 0);
+  ORBIT_CHECK(static_cast<size_t>(count) <= current_position_ - fragment_start_);
+  current_position_ -= count;
+}
+
+bool MappedFileFragmentInputStream::Skip(int count) {
+  ORBIT_CHECK(count >= 0);
+
+  if (static_cast<size_t>(count) > mapping_size_ - current_position_) {
+    current_position_ = mapping_size_;
+    return false;
+  }
+  current_position_ += count;
+  return true;
+}
+
+int64_t MappedFileFragmentInputStream::ByteCount() const {
+  return static_cast<int64_t>(current_position_ - fragment_start_);
+}
+
+}  // namespace orbit_capture_file_internal
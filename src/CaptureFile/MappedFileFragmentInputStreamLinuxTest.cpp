@@ -0,0 +1,103 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "MappedFileFragmentInputStream.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Result.h"
+#include "TestUtils/TemporaryFile.h"
+
+namespace orbit_capture_file_internal {
+
+namespace {
+
+orbit_test_utils::TemporaryFile CreateTemporaryFileWithContent(std::string_view content) {
+  auto temporary_file_or_error = orbit_test_utils::TemporaryFile::Create();
+  ORBIT_CHECK(temporary_file_or_error.has_value());
+  orbit_test_utils::TemporaryFile temporary_file = std::move(temporary_file_or_error.value());
+  auto write_result = orbit_base::WriteFully(temporary_file.fd(), content);
+  ORBIT_CHECK(!write_result.has_error());
+  return temporary_file;
+}
+
+std::string_view ToStringView(const void* bytes, int size) {
+  return std::string_view{static_cast<const char*>(bytes), static_cast<size_t>(size)};
+}
+
+}  // namespace
+
+TEST(MappedFileFragmentInputStream, ReadSkipAndBackUp) {
+  orbit_test_utils::TemporaryFile temporary_file = CreateTemporaryFileWithContent(
+      "Vestibulum euismod sapien eget urna molestie euismod. Etiam "
+      "pellentesque porttitor ligula et facilisis.");
+
+  // The fragment is "urna molestie euismod. Etiam pellentesque"
+  auto input_stream_or_error = MappedFileFragmentInputStream::Create(temporary_file.fd(), 31, 41);
+  ASSERT_TRUE(input_stream_or_error.has_value()) << input_stream_or_error.error().message();
+  MappedFileFragmentInputStream& input_stream = *input_stream_or_error.value();
+  EXPECT_EQ(input_stream.ByteCount(), 0);
+
+  const void* bytes = nullptr;
+  int size = 0;
+  ASSERT_TRUE(input_stream.Next(&bytes, &size));
+  EXPECT_EQ(ToStringView(bytes, size), "urna molestie euismod. Etiam pellentesque");
+  EXPECT_EQ(input_stream.ByteCount(), 41);
+  EXPECT_FALSE(input_stream.Next(&bytes, &size));
+
+  input_stream.BackUp(36);
+  EXPECT_EQ(input_stream.ByteCount(), 5);
+  ASSERT_TRUE(input_stream.Skip(9));
+  EXPECT_EQ(input_stream.ByteCount(), 14);
+  ASSERT_TRUE(input_stream.Next(&bytes, &size));
+  EXPECT_EQ(ToStringView(bytes, size), "euismod. Etiam pellentesque");
+
+  input_stream.BackUp(5);
+  EXPECT_FALSE(input_stream.Skip(6));
+  EXPECT_EQ(input_stream.ByteCount(), 41);
+  EXPECT_FALSE(input_stream.Next(&bytes, &size));
+}
+
+TEST(MappedFileFragmentInputStream, ReadsLargeFragmentInBlocks) {
+  constexpr size_t kFileSize = 3 * 1024 * 1024 + 17;
+  std::string content(kFileSize, '\0');
+  for (size_t i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<char>(i % 251);
+  }
+  orbit_test_utils::TemporaryFile temporary_file = CreateTemporaryFileWithContent(content);
+
+  constexpr size_t kFragmentOffset = 4097;
+  auto input_stream_or_error = MappedFileFragmentInputStream::Create(
+      temporary_file.fd(), kFragmentOffset, kFileSize - kFragmentOffset);
+  ASSERT_TRUE(input_stream_or_error.has_value()) << input_stream_or_error.error().message();
+  MappedFileFragmentInputStream& input_stream = *input_stream_or_error.value();
+
+  std::string read_content;
+  const void* bytes = nullptr;
+  int size = 0;
+  while (input_stream.Next(&bytes, &size)) {
+    EXPECT_GT(size, 0);
+    read_content.append(ToStringView(bytes, size));
+  }
+  EXPECT_EQ(read_content, std::string_view{content}.substr(kFragmentOffset));
+  EXPECT_EQ(input_stream.ByteCount(), kFileSize - kFragmentOffset);
+}
+
+TEST(MappedFileFragmentInputStream, FragmentBeyondEndOfFileIsAnError) {
+  orbit_test_utils::TemporaryFile temporary_file = CreateTemporaryFileWithContent("short");
+
+  auto input_stream_or_error = MappedFileFragmentInputStream::Create(temporary_file.fd(), 2, 10);
+  ASSERT_TRUE(input_stream_or_error.has_error());
+  EXPECT_NE(input_stream_or_error.error().message().find("beyond the end of file"),
+            std::string::npos);
+}
+
+}  // namespace orbit_capture_file_internal
@@ -8,30 +8,81 @@
 
 #include <memory>
 
+#include "OrbitBase/Logging.h"
 #include "OrbitBase/MakeUniqueForOverwrite.h"
 
+#ifdef __linux
+#include "MappedFileFragmentInputStream.h"
+#endif
+
 namespace orbit_capture_file_internal {
 
 constexpr uint64_t kMaximumMessageSize = 1024 * 1024;  // 1Mb
 
+ProtoSectionInputStreamImpl::ProtoSectionInputStreamImpl(orbit_base::UniqueFd& fd,
+                                                         uint64_t capture_section_offset,
+                                                         uint64_t capture_section_size,
+                                                         bool is_compressed)
+    : fd_{fd} {
+#ifdef __linux
+  auto mapped_stream_or_error =
+      MappedFileFragmentInputStream::Create(fd_, capture_section_offset, capture_section_size);
+  if (mapped_stream_or_error.has_value()) {
+    mapped_file_fragment_input_stream_ = std::move(mapped_stream_or_error.value());
+  } else {
+    ORBIT_LOG("Reading file section without memory-mapping it: %s",
+              mapped_stream_or_error.error().message());
+  }
+#endif
+  if (mapped_file_fragment_input_stream_ == nullptr) {
+    file_fragment_input_stream_.emplace(fd_, capture_section_offset, capture_section_size);
+  }
+
+  if (is_compressed) compressed_frame_input_stream_.emplace(GetFileFragmentInputStream());
+  coded_input_stream_.emplace(GetInputStream());
+  coded_input_stream_->SetTotalBytesLimit(kCodedInputStreamTotalBytesLimit);
+}
+
+google::protobuf::io::ZeroCopyInputStream*
+ProtoSectionInputStreamImpl::GetFileFragmentInputStream() {
+  if (mapped_file_fragment_input_stream_ != nullptr) {
+    return mapped_file_fragment_input_stream_.get();
+  }
+  return &file_fragment_input_stream_.value();
+}
+
+google::protobuf::io::ZeroCopyInputStream* ProtoSectionInputStreamImpl::GetInputStream() {
+  if (compressed_frame_input_stream_.has_value()) return &compressed_frame_input_stream_.value();
+  return GetFileFragmentInputStream();
+}
+
+std::optional<ErrorMessage> ProtoSectionInputStreamImpl::GetLastInputError() const {
+  if (compressed_frame_input_stream_.has_value() &&
+      compressed_frame_input_stream_->GetLastError().has_value()) {
+    return compressed_frame_input_stream_->GetLastError();
+  }
+  // Reading from a MappedFileFragmentInputStream can't fail.
+  if (file_fragment_input_stream_.has_value()) return file_fragment_input_stream_->GetLastError();
+  return std::nullopt;
+}
+
 ErrorMessageOr<void> ProtoSectionInputStreamImpl::ReadMessage(google::protobuf::Message* message) {
   // CodedInputStream imposes a hard limit on the total number of bytes it will read. It's INT_MAX
   // by default and it cannot be increased past that. To work around the limitation, reinitialize
-  // the CodedInputStream, as the actual current position is kept by the FileFragmentInputStream
-  // instead. Note that this makes CodedInputStream::CurrentPosition not always reflect the actual
-  // position in the stream.
+  // the CodedInputStream, as the actual current position is kept by the underlying stream instead.
+  // Note that this makes CodedInputStream::CurrentPosition not always reflect the actual position
+  // in the stream.
   if (coded_input_stream_->CurrentPosition() >= kCodedInputStreamReinitializationThreshold) {
-    coded_input_stream_.emplace(&file_fragment_input_stream_);
+    coded_input_stream_.emplace(GetInputStream());
     coded_input_stream_->SetTotalBytesLimit(kCodedInputStreamTotalBytesLimit);
   }
 
   uint32_t message_size = 0;
 
   // Note that in case there was an error CodedInputStream does not provide error messages/codes.
-  // We need to go to underlying stream (file_fragment_input_stream_ in this case) to get the error
-  // message in case of a failure.
+  // We need to go to the underlying streams to get the error message in case of a failure.
   if (!coded_input_stream_->ReadVarint32(&message_size)) {
-    return file_fragment_input_stream_.GetLastError().value_or(
+    return GetLastInputError().value_or(
         ErrorMessage{"Unexpected end of section while reading message size"});
   }
 
@@ -45,7 +96,7 @@ ErrorMessageOr<void> ProtoSectionInputStreamImpl::ReadMessage(google::protobuf::
 
   auto buf = make_unique_for_overwrite<uint8_t[]>(message_size);
   if (!coded_input_stream_->ReadRaw(buf.get(), message_size)) {
-    return file_fragment_input_stream_.GetLastError().value_or(
+    return GetLastInputError().value_or(
         ErrorMessage{"Unexpected end of section while reading the message"});
   }
 
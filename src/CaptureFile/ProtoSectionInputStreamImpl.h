@@ -10,36 +10,45 @@
 #include <stdint.h>
 
 #include <limits>
+#include <memory>
 #include <optional>
 #include <utility>
 
 #include "CaptureFile/ProtoSectionInputStream.h"
+#include "CompressedFrameInputStream.h"
 #include "FileFragmentInputStream.h"
 #include "OrbitBase/File.h"
 #include "OrbitBase/Result.h"
 
 namespace orbit_capture_file_internal {
 
-// This class is used to read proto messages from a section of capture file.
+// This class is used to read proto messages from a section of capture file. If `is_compressed` is
+// true, the section consists of compressed frames as described in FORMAT.md. Where supported, the
+// section is memory-mapped (see MappedFileFragmentInputStream), otherwise it is read through a
+// FileFragmentInputStream.
 class ProtoSectionInputStreamImpl : public orbit_capture_file::ProtoSectionInputStream {
  public:
   explicit ProtoSectionInputStreamImpl(orbit_base::UniqueFd& fd, uint64_t capture_section_offset,
-                                       uint64_t capture_section_size)
-      : fd_{fd},
-        file_fragment_input_stream_{fd_, capture_section_offset, capture_section_size},
-        coded_input_stream_{std::in_place, &file_fragment_input_stream_} {
-    coded_input_stream_->SetTotalBytesLimit(kCodedInputStreamTotalBytesLimit);
-  }
+                                       uint64_t capture_section_size, bool is_compressed = false);
 
   ErrorMessageOr<void> ReadMessage(google::protobuf::Message* message) override;
 
  private:
+  // Returns the stream of the raw bytes of the section.
+  [[nodiscard]] google::protobuf::io::ZeroCopyInputStream* GetFileFragmentInputStream();
+  // Returns the stream of the section after decompression, if the section is compressed.
+  [[nodiscard]] google::protobuf::io::ZeroCopyInputStream* GetInputStream();
+  [[nodiscard]] std::optional<ErrorMessage> GetLastInputError() const;
+
   static constexpr int kCodedInputStreamTotalBytesLimit = std::numeric_limits<int>::max();
   static constexpr int kCodedInputStreamReinitializationThreshold =
       kCodedInputStreamTotalBytesLimit / 2;
 
   orbit_base::UniqueFd& fd_;
-  FileFragmentInputStream file_fragment_input_stream_;
+  // Exactly one of the two is set.
+  std::unique_ptr<google::protobuf::io::ZeroCopyInputStream> mapped_file_fragment_input_stream_;
+  std::optional<FileFragmentInputStream> file_fragment_input_stream_;
+  std::optional<CompressedFrameInputStream> compressed_frame_input_stream_;
   std::optional<google::protobuf::io::CodedInputStream> coded_input_stream_;
 };
 
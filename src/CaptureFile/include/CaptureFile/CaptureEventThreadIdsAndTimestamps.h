@@ -0,0 +1,188 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CAPTURE_FILE_CAPTURE_EVENT_THREAD_IDS_AND_TIMESTAMPS_H_
+#define CAPTURE_FILE_CAPTURE_EVENT_THREAD_IDS_AND_TIMESTAMPS_H_
+
+#include <stdint.h>
+
+#include "GrpcProtos/capture.pb.h"
+
+namespace orbit_capture_file {
+
+// Calls `visitor->OnThreadId(uint32_t tid)` for the thread ids, `visitor->OnTimestamp(uint64_t
+// timestamp_ns)` for the points in time, and `visitor->OnTimeRange(uint64_t start_timestamp_ns,
+// uint64_t end_timestamp_ns)` for the time ranges that `event` refers to. Batches are visited
+// element by element. Events that don't refer to a point in time, like interned strings and
+// callstacks, aren't visited.
+template <typename Visitor>
+void VisitThreadIdsAndTimestamps(const orbit_grpc_protos::ClientCaptureEvent& event,
+                                 Visitor* visitor) {
+  using orbit_grpc_protos::ClientCaptureEvent;
+  // Timestamps of batches are stored as deltas, see the batch messages in capture.proto.
+  uint64_t batch_timestamp_ns = 0;
+  switch (event.event_case()) {
+    case ClientCaptureEvent::kFunctionCall: {
+      const orbit_grpc_protos::FunctionCall& function_call = event.function_call();
+      visitor->OnThreadId(function_call.tid());
+      visitor->OnTimeRange(function_call.end_timestamp_ns() - function_call.duration_ns(),
+                           function_call.end_timestamp_ns());
+    } break;
+    case ClientCaptureEvent::kFunctionCallBatch: {
+      const orbit_grpc_protos::FunctionCallBatch& batch = event.function_call_batch();
+      for (const uint32_t tid : batch.tids()) visitor->OnThreadId(tid);
+      for (int i = 0; i < batch.end_timestamp_deltas_ns_size(); ++i) {
+        batch_timestamp_ns += batch.end_timestamp_deltas_ns(i);
+        const uint64_t duration_ns = i < batch.durations_ns_size() ? batch.durations_ns(i) : 0;
+        visitor->OnTimeRange(batch_timestamp_ns - duration_ns, batch_timestamp_ns);
+      }
+    } break;
+    case ClientCaptureEvent::kSchedulingSlice: {
+      const orbit_grpc_protos::SchedulingSlice& scheduling_slice = event.scheduling_slice();
+      visitor->OnThreadId(scheduling_slice.tid());
+      visitor->OnTimeRange(scheduling_slice.out_timestamp_ns() - scheduling_slice.duration_ns(),
+                           scheduling_slice.out_timestamp_ns());
+    } break;
+    case ClientCaptureEvent::kSchedulingSliceBatch: {
+      const orbit_grpc_protos::SchedulingSliceBatch& batch = event.scheduling_slice_batch();
+      for (const uint32_t tid : batch.tids()) visitor->OnThreadId(tid);
+      for (int i = 0; i < batch.out_timestamp_deltas_ns_size(); ++i) {
+        batch_timestamp_ns += batch.out_timestamp_deltas_ns(i);
+        const uint64_t duration_ns = i < batch.durations_ns_size() ? batch.durations_ns(i) : 0;
+        visitor->OnTimeRange(batch_timestamp_ns - duration_ns, batch_timestamp_ns);
+      }
+    } break;
+    case ClientCaptureEvent::kCallstackSample:
+      visitor->OnThreadId(event.callstack_sample().tid());
+      visitor->OnTimestamp(event.callstack_sample().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kCallstackSampleBatch: {
+      const orbit_grpc_protos::CallstackSampleBatch& batch = event.callstack_sample_batch();
+      for (const uint32_t tid : batch.tids()) visitor->OnThreadId(tid);
+      for (int64_t timestamp_delta_ns : batch.timestamp_deltas_ns()) {
+        batch_timestamp_ns += timestamp_delta_ns;
+        visitor->OnTimestamp(batch_timestamp_ns);
+      }
+    } break;
+    case ClientCaptureEvent::kPageFaultSample:
+      visitor->OnThreadId(event.page_fault_sample().tid());
+      visitor->OnTimestamp(event.page_fault_sample().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kThreadStateSlice: {
+      const orbit_grpc_protos::ThreadStateSlice& thread_state_slice = event.thread_state_slice();
+      visitor->OnThreadId(thread_state_slice.tid());
+      visitor->OnTimeRange(thread_state_slice.end_timestamp_ns() - thread_state_slice.duration_ns(),
+                           thread_state_slice.end_timestamp_ns());
+    } break;
+    case ClientCaptureEvent::kThreadStateSliceBatch: {
+      const orbit_grpc_protos::ThreadStateSliceBatch& batch = event.thread_state_slice_batch();
+      for (const uint32_t tid : batch.tids()) visitor->OnThreadId(tid);
+      for (int i = 0; i < batch.end_timestamp_deltas_ns_size(); ++i) {
+        batch_timestamp_ns += batch.end_timestamp_deltas_ns(i);
+        const uint64_t duration_ns = i < batch.durations_ns_size() ? batch.durations_ns(i) : 0;
+        visitor->OnTimeRange(batch_timestamp_ns - duration_ns, batch_timestamp_ns);
+      }
+    } break;
+    case ClientCaptureEvent::kApiScopeStart:
+      visitor->OnThreadId(event.api_scope_start().tid());
+      visitor->OnTimestamp(event.api_scope_start().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiScopeStop:
+      visitor->OnThreadId(event.api_scope_stop().tid());
+      visitor->OnTimestamp(event.api_scope_stop().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiScopeStartAsync:
+      visitor->OnThreadId(event.api_scope_start_async().tid());
+      visitor->OnTimestamp(event.api_scope_start_async().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiScopeStopAsync:
+      visitor->OnThreadId(event.api_scope_stop_async().tid());
+      visitor->OnTimestamp(event.api_scope_stop_async().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiStringEvent:
+      visitor->OnThreadId(event.api_string_event().tid());
+      visitor->OnTimestamp(event.api_string_event().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiTrackDouble:
+      visitor->OnThreadId(event.api_track_double().tid());
+      visitor->OnTimestamp(event.api_track_double().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiTrackFloat:
+      visitor->OnThreadId(event.api_track_float().tid());
+      visitor->OnTimestamp(event.api_track_float().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiTrackInt:
+      visitor->OnThreadId(event.api_track_int().tid());
+      visitor->OnTimestamp(event.api_track_int().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiTrackInt64:
+      visitor->OnThreadId(event.api_track_int64().tid());
+      visitor->OnTimestamp(event.api_track_int64().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiTrackUint:
+      visitor->OnThreadId(event.api_track_uint().tid());
+      visitor->OnTimestamp(event.api_track_uint().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiTrackUint64:
+      visitor->OnThreadId(event.api_track_uint64().tid());
+      visitor->OnTimestamp(event.api_track_uint64().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kApiTrackValueSummary:
+      visitor->OnThreadId(event.api_track_value_summary().tid());
+      visitor->OnTimeRange(event.api_track_value_summary().min_timestamp_ns(),
+                           event.api_track_value_summary().max_timestamp_ns());
+      break;
+    case ClientCaptureEvent::kGpuJob:
+      visitor->OnThreadId(event.gpu_job().tid());
+      visitor->OnTimeRange(event.gpu_job().amdgpu_cs_ioctl_time_ns(),
+                           event.gpu_job().dma_fence_signaled_time_ns());
+      break;
+    case ClientCaptureEvent::kTracepointEvent:
+      visitor->OnThreadId(event.tracepoint_event().tid());
+      visitor->OnTimestamp(event.tracepoint_event().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kThreadName:
+      visitor->OnThreadId(event.thread_name().tid());
+      visitor->OnTimestamp(event.thread_name().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kPresentEvent:
+      visitor->OnThreadId(event.present_event().tid());
+      visitor->OnTimeRange(event.present_event().begin_timestamp_ns(),
+                           event.present_event().begin_timestamp_ns() +
+                               event.present_event().duration_ns());
+      break;
+    case ClientCaptureEvent::kMemoryUsageEvent:
+      visitor->OnTimestamp(event.memory_usage_event().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kPerformanceCounterSample:
+      visitor->OnThreadId(event.performance_counter_sample().tid());
+      visitor->OnTimestamp(event.performance_counter_sample().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kPressureStallEvent:
+      visitor->OnTimestamp(event.pressure_stall_event().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kOffCpuTimeSummary:
+      visitor->OnThreadId(event.off_cpu_time_summary().tid());
+      visitor->OnTimeRange(event.off_cpu_time_summary().min_begin_timestamp_ns(),
+                           event.off_cpu_time_summary().max_end_timestamp_ns());
+      break;
+    case ClientCaptureEvent::kModuleUpdateEvent:
+      visitor->OnTimestamp(event.module_update_event().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kModulesSnapshot:
+      visitor->OnTimestamp(event.modules_snapshot().timestamp_ns());
+      break;
+    case ClientCaptureEvent::kThreadNamesSnapshot:
+      visitor->OnTimestamp(event.thread_names_snapshot().timestamp_ns());
+      break;
+    default:
+      // The remaining events are either not bound to a point in time, like interned strings and
+      // callstacks, or are rare.
+      break;
+  }
+}
+
+}  // namespace orbit_capture_file
+
+#endif  // CAPTURE_FILE_CAPTURE_EVENT_THREAD_IDS_AND_TIMESTAMPS_H_
@@ -71,6 +71,12 @@ class CaptureFile {
 
   virtual std::unique_ptr<ProtoSectionInputStream> CreateCaptureSectionInputStream() = 0;
 
+  // Creates a stream that reads the Capture Section starting from the chunk at `chunk_offset`, as
+  // listed in the CAPTURE_INDEX section (see ReadCaptureIndex). The offset must be in bounds of the
+  // Capture Section, otherwise this function will CHECK fail.
+  virtual std::unique_ptr<ProtoSectionInputStream> CreateCaptureSectionInputStreamAtChunk(
+      uint64_t chunk_offset) = 0;
+
   static ErrorMessageOr<std::unique_ptr<CaptureFile>> OpenForReadWrite(
       const std::filesystem::path& file_path);
 
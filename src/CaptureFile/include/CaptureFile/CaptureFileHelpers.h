@@ -6,7 +6,12 @@
 #define CAPTURE_FILE_CAPTURE_FILE_HELPERS_H_
 
 #include <filesystem>
+#include <optional>
+#include <vector>
 
+#include "CaptureFile/CaptureFile.h"
+#include "ClientProtos/capture_index.pb.h"
+#include "ClientProtos/capture_summary.pb.h"
 #include "ClientProtos/user_defined_capture_info.pb.h"
 #include "OrbitBase/Result.h"
 
@@ -14,5 +19,27 @@ namespace orbit_capture_file {
 ErrorMessageOr<void> WriteUserData(
     const std::filesystem::path& capture_file_path,
     const orbit_client_protos::UserDefinedCaptureInfo& user_defined_capture_info);
+
+// Adds a CAPTURE_INDEX section with `chunks` (see CaptureFileOutputStream::GetCaptureIndex). The
+// file must not contain such a section yet.
+ErrorMessageOr<void> WriteCaptureIndex(
+    const std::filesystem::path& capture_file_path,
+    const std::vector<orbit_client_protos::CaptureIndexChunk>& chunks);
+
+// Reads the chunks from the CAPTURE_INDEX section. Returns std::nullopt if the file has no such
+// section, as is the case for files written before it was introduced. Use
+// CaptureFile::CreateCaptureSectionInputStreamAtChunk to read the events of a chunk.
+ErrorMessageOr<std::optional<std::vector<orbit_client_protos::CaptureIndexChunk>>>
+ReadCaptureIndex(CaptureFile* capture_file);
+
+// Adds a CAPTURE_SUMMARY section with `entries`. The file must not contain such a section yet.
+ErrorMessageOr<void> WriteCaptureSummary(
+    const std::filesystem::path& capture_file_path,
+    const std::vector<orbit_client_protos::CaptureSummaryEntry>& entries);
+
+// Reads the entries from the CAPTURE_SUMMARY section. Returns std::nullopt if the file has no such
+// section.
+ErrorMessageOr<std::optional<std::vector<orbit_client_protos::CaptureSummaryEntry>>>
+ReadCaptureSummary(CaptureFile* capture_file);
 }  // namespace orbit_capture_file
 #endif  // CAPTURE_FILE_CAPTURE_FILE_HELPERS_H_
\ No newline at end of file
@@ -9,13 +9,19 @@
 
 #include <filesystem>
 #include <memory>
+#include <vector>
 
 #include "CaptureFile/BufferOutputStream.h"
+#include "ClientProtos/capture_index.pb.h"
 #include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Result.h"
 
 namespace orbit_capture_file {
 
+// kZlib writes the Capture Section as a sequence of compressed frames, which requires version 2 of
+// the capture file format, see FORMAT.md. CaptureFile reads both transparently.
+enum class CaptureSectionCompression { kNone, kZlib };
+
 // This class in used for creating new capture file from
 // a stream of ClientCaptureEvents. If the file already exists
 // it is going to be overwritten. Appending to the existing file
@@ -51,12 +57,19 @@ class CaptureFileOutputStream {
 
   [[nodiscard]] virtual bool IsOpen() = 0;
 
+  // Returns the chunks of the events written so far, for the CAPTURE_INDEX section (see
+  // WriteCaptureIndex). The last chunk is only included after Close().
+  [[nodiscard]] virtual const std::vector<orbit_client_protos::CaptureIndexChunk>&
+  GetCaptureIndex() const = 0;
+
   // Create new capture file output stream. If the file exists it is going to be
   // overwritten.
   [[nodiscard]] static ErrorMessageOr<std::unique_ptr<CaptureFileOutputStream>> Create(
-      std::filesystem::path path);
+      std::filesystem::path path,
+      CaptureSectionCompression compression = CaptureSectionCompression::kNone);
   [[nodiscard]] static std::unique_ptr<CaptureFileOutputStream> Create(
-      BufferOutputStream* output_buffer);
+      BufferOutputStream* output_buffer,
+      CaptureSectionCompression compression = CaptureSectionCompression::kNone);
 };
 
 }  // namespace orbit_capture_file
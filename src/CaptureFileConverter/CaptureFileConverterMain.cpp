@@ -0,0 +1,75 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/flags/flag.h>
+#include <absl/flags/parse.h>
+#include <absl/flags/usage.h>
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CaptureFile/CaptureFile.h"
+#include "CaptureFile/ProtoSectionInputStream.h"
+#include "CaptureFileConverter/ChromeTraceWriter.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Result.h"
+
+ABSL_FLAG(std::string, output, "",
+          "Path of the trace to write, in the JSON Trace Event Format of chrome://tracing, which "
+          "the Perfetto UI also opens");
+
+namespace {
+
+// Returns the number of events converted.
+[[nodiscard]] ErrorMessageOr<uint64_t> ConvertCaptureFile(
+    const std::filesystem::path& input_path, const std::filesystem::path& output_path) {
+  OUTCOME_TRY(std::unique_ptr<orbit_capture_file::CaptureFile> capture_file,
+              orbit_capture_file::CaptureFile::OpenForReadWrite(input_path));
+  OUTCOME_TRY(orbit_base::UniqueFd output_fd, orbit_base::OpenFileForWriting(output_path));
+
+  orbit_capture_file_converter::ChromeTraceWriter writer{
+      [&output_fd](std::string_view data) { return orbit_base::WriteFully(output_fd, data); }};
+  std::unique_ptr<orbit_capture_file::ProtoSectionInputStream> input_stream =
+      capture_file->CreateCaptureSectionInputStream();
+  uint64_t event_count = 0;
+  while (true) {
+    orbit_grpc_protos::ClientCaptureEvent event;
+    OUTCOME_TRY(input_stream->ReadMessage(&event));
+    ++event_count;
+    OUTCOME_TRY(writer.ProcessEvent(event));
+    if (event.event_case() == orbit_grpc_protos::ClientCaptureEvent::kCaptureFinished) break;
+  }
+  OUTCOME_TRY(writer.Finish());
+  return event_count;
+}
+
+}  // namespace
+
+// Converts an Orbit capture file to a trace that other tools open, streaming both, so that memory
+// usage doesn't grow with the size of the capture.
+int main(int argc, char* argv[]) {
+  absl::SetProgramUsageMessage(
+      "Converts an Orbit capture file to the JSON Trace Event Format.\n"
+      "Usage: OrbitCaptureFileConverter --output=<trace.json> <capture.orbit>");
+  std::vector<char*> positional_arguments = absl::ParseCommandLine(argc, argv);
+  const std::string output_path = absl::GetFlag(FLAGS_output);
+  ORBIT_FAIL_IF(positional_arguments.size() != 2 || output_path.empty(),
+                "Expected --output and exactly one capture file");
+
+  const absl::Time start_time = absl::Now();
+  ErrorMessageOr<uint64_t> event_count = ConvertCaptureFile(positional_arguments[1], output_path);
+  ORBIT_FAIL_IF(event_count.has_error(), "Converting \"%s\": %s", positional_arguments[1],
+                event_count.error().message());
+  ORBIT_LOG("Converted %u events to \"%s\" in %.3f s", event_count.value(), output_path,
+            absl::ToDoubleSeconds(absl::Now() - start_time));
+  return 0;
+}
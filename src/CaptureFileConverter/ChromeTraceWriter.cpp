@@ -0,0 +1,322 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "CaptureFileConverter/ChromeTraceWriter.h"
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+
+#include <cmath>
+#include <filesystem>
+#include <type_traits>
+
+#include "ApiUtils/EncodedString.h"
+#include "CaptureClient/ClientCaptureEventBatches.h"
+#include "OrbitBase/Logging.h"
+
+namespace orbit_capture_file_converter {
+
+using orbit_grpc_protos::ClientCaptureEvent;
+
+namespace {
+
+void AppendJsonString(std::string* out, std::string_view str) {
+  out->push_back('"');
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(out, "\\u%04x", static_cast<unsigned char>(c));
+        } else {
+          out->push_back(c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+// The timestamps and durations of the Trace Event Format are in microseconds.
+void AppendMicroseconds(std::string* out, uint64_t ns) {
+  absl::StrAppend(out, ns / 1000, ".", absl::Dec(ns % 1000, absl::kZeroPad3));
+}
+
+template <typename Source>
+std::string DecodeString(const Source& encoded_source) {
+  return orbit_api::DecodeString(encoded_source.encoded_name_1(), encoded_source.encoded_name_2(),
+                                 encoded_source.encoded_name_3(), encoded_source.encoded_name_4(),
+                                 encoded_source.encoded_name_5(), encoded_source.encoded_name_6(),
+                                 encoded_source.encoded_name_7(), encoded_source.encoded_name_8(),
+                                 encoded_source.encoded_name_additional().data(),
+                                 encoded_source.encoded_name_additional_size());
+}
+
+}  // namespace
+
+ChromeTraceWriter::ChromeTraceWriter(std::function<ErrorMessageOr<void>(std::string_view)> write)
+    : write_(std::move(write)) {
+  ORBIT_CHECK(write_ != nullptr);
+  buffer_.reserve(kBufferSize + kBufferSize / 4);
+  buffer_.append(R"({"displayTimeUnit":"ns","traceEvents":[)");
+}
+
+ErrorMessageOr<void> ChromeTraceWriter::ProcessEvent(const ClientCaptureEvent& event) {
+  switch (event.event_case()) {
+    case ClientCaptureEvent::kCaptureStarted:
+      ProcessCaptureStarted(event.capture_started());
+      break;
+    case ClientCaptureEvent::kInternedString:
+      interned_strings_.insert_or_assign(event.interned_string().key(),
+                                         event.interned_string().intern());
+      break;
+    case ClientCaptureEvent::kInternedCallstack:
+      interned_callstacks_.insert_or_assign(event.interned_callstack().key(),
+                                            event.interned_callstack().intern());
+      break;
+    case ClientCaptureEvent::kAddressInfo:
+      address_infos_.insert_or_assign(event.address_info().absolute_address(),
+                                      event.address_info());
+      break;
+    case ClientCaptureEvent::kFunctionCall:
+      ProcessFunctionCall(event.function_call());
+      break;
+    case ClientCaptureEvent::kFunctionCallBatch: {
+      OUTCOME_TRY(orbit_capture_client::ForEachEventInBatch(
+          event.function_call_batch(),
+          [this](const orbit_grpc_protos::FunctionCall& function_call) {
+            ProcessFunctionCall(function_call);
+          }));
+    } break;
+    case ClientCaptureEvent::kCallstackSample:
+      ProcessCallstackSample(event.callstack_sample());
+      break;
+    case ClientCaptureEvent::kCallstackSampleBatch: {
+      OUTCOME_TRY(orbit_capture_client::ForEachEventInBatch(
+          event.callstack_sample_batch(),
+          [this](const orbit_grpc_protos::CallstackSample& callstack_sample) {
+            ProcessCallstackSample(callstack_sample);
+          }));
+    } break;
+    case ClientCaptureEvent::kThreadName:
+      ProcessThreadName(event.thread_name());
+      break;
+    case ClientCaptureEvent::kThreadNamesSnapshot:
+      for (const orbit_grpc_protos::ThreadName& thread_name :
+           event.thread_names_snapshot().thread_names()) {
+        ProcessThreadName(thread_name);
+      }
+      break;
+    case ClientCaptureEvent::kApiScopeStart: {
+      const orbit_grpc_protos::ApiScopeStart& api_scope_start = event.api_scope_start();
+      BeginTraceEvent("B", GetApiEventName(api_scope_start), api_scope_start.pid(),
+                      api_scope_start.tid(), api_scope_start.timestamp_ns());
+      buffer_.push_back('}');
+    } break;
+    case ClientCaptureEvent::kApiScopeStop: {
+      const orbit_grpc_protos::ApiScopeStop& api_scope_stop = event.api_scope_stop();
+      BeginTraceEvent("E", "", api_scope_stop.pid(), api_scope_stop.tid(),
+                      api_scope_stop.timestamp_ns());
+      buffer_.push_back('}');
+    } break;
+    case ClientCaptureEvent::kApiScopeStartAsync: {
+      const orbit_grpc_protos::ApiScopeStartAsync& api_scope_start = event.api_scope_start_async();
+      std::string name = GetApiEventName(api_scope_start);
+      BeginTraceEvent("b", name, api_scope_start.pid(), api_scope_start.tid(),
+                      api_scope_start.timestamp_ns());
+      absl::StrAppend(&buffer_, R"(,"cat":"async","id":")", api_scope_start.id(), "\"}");
+      open_async_scope_names_.insert_or_assign(api_scope_start.id(), std::move(name));
+    } break;
+    case ClientCaptureEvent::kApiScopeStopAsync: {
+      const orbit_grpc_protos::ApiScopeStopAsync& api_scope_stop = event.api_scope_stop_async();
+      std::string name;
+      if (auto it = open_async_scope_names_.find(api_scope_stop.id());
+          it != open_async_scope_names_.end()) {
+        name = std::move(it->second);
+        open_async_scope_names_.erase(it);
+      }
+      BeginTraceEvent("e", name, api_scope_stop.pid(), api_scope_stop.tid(),
+                      api_scope_stop.timestamp_ns());
+      absl::StrAppend(&buffer_, R"(,"cat":"async","id":")", api_scope_stop.id(), "\"}");
+    } break;
+    case ClientCaptureEvent::kApiTrackDouble:
+      ProcessApiTrackEvent(event.api_track_double());
+      break;
+    case ClientCaptureEvent::kApiTrackFloat:
+      ProcessApiTrackEvent(event.api_track_float());
+      break;
+    case ClientCaptureEvent::kApiTrackInt:
+      ProcessApiTrackEvent(event.api_track_int());
+      break;
+    case ClientCaptureEvent::kApiTrackInt64:
+      ProcessApiTrackEvent(event.api_track_int64());
+      break;
+    case ClientCaptureEvent::kApiTrackUint:
+      ProcessApiTrackEvent(event.api_track_uint());
+      break;
+    case ClientCaptureEvent::kApiTrackUint64:
+      ProcessApiTrackEvent(event.api_track_uint64());
+      break;
+    default:
+      // The other events have no equivalent in the Trace Event Format, or are not exported yet.
+      break;
+  }
+  return FlushIfFull();
+}
+
+void ChromeTraceWriter::ProcessCaptureStarted(
+    const orbit_grpc_protos::CaptureStarted& capture_started) {
+  for (const orbit_grpc_protos::InstrumentedFunction& function :
+       capture_started.capture_options().instrumented_functions()) {
+    function_names_.insert_or_assign(function.function_id(), function.function_name());
+  }
+
+  const uint32_t pid = capture_started.process_id();
+  BeginTraceEvent("M", "process_name", pid, pid, capture_started.capture_start_timestamp_ns());
+  buffer_.append(R"(,"args":{"name":)");
+  AppendJsonString(&buffer_,
+                   std::filesystem::path(capture_started.executable_path()).filename().string());
+  buffer_.append("}}");
+}
+
+void ChromeTraceWriter::ProcessFunctionCall(const orbit_grpc_protos::FunctionCall& function_call) {
+  std::string generated_name;
+  std::string_view name;
+  if (auto it = function_names_.find(function_call.function_id()); it != function_names_.end()) {
+    name = it->second;
+  } else {
+    generated_name = absl::StrFormat("function %u", function_call.function_id());
+    name = generated_name;
+  }
+  BeginTraceEvent("X", name, function_call.pid(), function_call.tid(),
+                  function_call.end_timestamp_ns() - function_call.duration_ns());
+  buffer_.append(R"(,"dur":)");
+  AppendMicroseconds(&buffer_, function_call.duration_ns());
+  buffer_.push_back('}');
+}
+
+void ChromeTraceWriter::ProcessCallstackSample(
+    const orbit_grpc_protos::CallstackSample& callstack_sample) {
+  BeginTraceEvent("P", "sample", callstack_sample.pid(), callstack_sample.tid(),
+                  callstack_sample.timestamp_ns());
+  const uint64_t stack_frame_id = GetStackFrameId(callstack_sample.callstack_id());
+  if (stack_frame_id != 0) absl::StrAppend(&buffer_, R"(,"sf":")", stack_frame_id, "\"");
+  buffer_.push_back('}');
+}
+
+void ChromeTraceWriter::ProcessThreadName(const orbit_grpc_protos::ThreadName& thread_name) {
+  BeginTraceEvent("M", "thread_name", thread_name.pid(), thread_name.tid(),
+                  thread_name.timestamp_ns());
+  buffer_.append(R"(,"args":{"name":)");
+  AppendJsonString(&buffer_, thread_name.name());
+  buffer_.append("}}");
+}
+
+template <typename ApiTrackEvent>
+void ChromeTraceWriter::ProcessApiTrackEvent(const ApiTrackEvent& api_track_event) {
+  if constexpr (std::is_floating_point_v<decltype(api_track_event.data())>) {
+    // JSON has no representation for these.
+    if (!std::isfinite(api_track_event.data())) return;
+  }
+  // The tracked values of the Orbit API are per process, like the counters of the format.
+  BeginTraceEvent("C", DecodeString(api_track_event), api_track_event.pid(), api_track_event.tid(),
+                  api_track_event.timestamp_ns());
+  absl::StrAppend(&buffer_, R"(,"args":{"value":)", api_track_event.data(), "}}");
+}
+
+template <typename NamedApiEvent>
+std::string ChromeTraceWriter::GetApiEventName(const NamedApiEvent& api_event) const {
+  if (api_event.name_key() == 0) return DecodeString(api_event);
+  auto it = interned_strings_.find(api_event.name_key());
+  if (it == interned_strings_.end()) {
+    ORBIT_ERROR_ONCE("Api event with an unknown interned name");
+    return "";
+  }
+  return it->second;
+}
+
+std::string_view ChromeTraceWriter::GetInternedString(uint64_t key) const {
+  auto it = interned_strings_.find(key);
+  if (it == interned_strings_.end()) return {};
+  return it->second;
+}
+
+uint64_t ChromeTraceWriter::GetStackFrameId(uint64_t callstack_id) {
+  if (auto it = callstack_id_to_frame_id_.find(callstack_id);
+      it != callstack_id_to_frame_id_.end()) {
+    return it->second;
+  }
+  auto callstack_it = interned_callstacks_.find(callstack_id);
+  if (callstack_it == interned_callstacks_.end()) {
+    ORBIT_ERROR_ONCE("CallstackSample with an unknown callstack");
+    return 0;
+  }
+
+  // The first pc is the innermost frame.
+  const auto& pcs = callstack_it->second.pcs();
+  uint64_t frame_id = 0;
+  for (auto pc_it = pcs.rbegin(); pc_it != pcs.rend(); ++pc_it) {
+    auto [it, inserted] = parent_id_and_address_to_frame_id_.try_emplace(
+        std::make_pair(frame_id, *pc_it), stack_frames_.size() + 1);
+    if (inserted) stack_frames_.push_back({frame_id, *pc_it});
+    frame_id = it->second;
+  }
+  callstack_id_to_frame_id_.emplace(callstack_id, frame_id);
+  return frame_id;
+}
+
+void ChromeTraceWriter::BeginTraceEvent(std::string_view phase, std::string_view name,
+                                        uint32_t pid, uint32_t tid, uint64_t timestamp_ns) {
+  buffer_.append(is_first_trace_event_ ? "\n" : ",\n");
+  is_first_trace_event_ = false;
+  buffer_.append(R"({"ph":")");
+  buffer_.append(phase);
+  buffer_.append(R"(","name":)");
+  AppendJsonString(&buffer_, name);
+  absl::StrAppend(&buffer_, R"(,"pid":)", pid, R"(,"tid":)", tid, R"(,"ts":)");
+  AppendMicroseconds(&buffer_, timestamp_ns);
+}
+
+ErrorMessageOr<void> ChromeTraceWriter::FlushIfFull() {
+  if (buffer_.size() < kBufferSize) return outcome::success();
+  OUTCOME_TRY(write_(buffer_));
+  buffer_.clear();
+  return outcome::success();
+}
+
+ErrorMessageOr<void> ChromeTraceWriter::Finish() {
+  buffer_.append("\n],\"stackFrames\":{");
+  for (size_t index = 0; index < stack_frames_.size(); ++index) {
+    const StackFrame& frame = stack_frames_[index];
+    absl::StrAppend(&buffer_, index == 0 ? "\n\"" : ",\n\"", index + 1, R"(":{"name":)");
+    std::string_view module_name;
+    if (auto it = address_infos_.find(frame.address); it != address_infos_.end()) {
+      AppendJsonString(&buffer_, GetInternedString(it->second.function_name_key()));
+      module_name = GetInternedString(it->second.module_name_key());
+    } else {
+      AppendJsonString(&buffer_, absl::StrFormat("%#x", frame.address));
+    }
+    buffer_.append(R"(,"category":)");
+    AppendJsonString(&buffer_, std::filesystem::path(module_name).filename().string());
+    if (frame.parent_id != 0) absl::StrAppend(&buffer_, R"(,"parent":")", frame.parent_id, "\"");
+    buffer_.push_back('}');
+    OUTCOME_TRY(FlushIfFull());
+  }
+  buffer_.append("\n}}\n");
+  OUTCOME_TRY(write_(buffer_));
+  buffer_.clear();
+  return outcome::success();
+}
+
+}  // namespace orbit_capture_file_converter
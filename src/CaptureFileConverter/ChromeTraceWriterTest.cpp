@@ -0,0 +1,180 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "CaptureFileConverter/ChromeTraceWriter.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_capture_file_converter {
+
+using orbit_grpc_protos::ClientCaptureEvent;
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
+using ::testing::StartsWith;
+
+namespace {
+
+class ChromeTraceWriterTest : public ::testing::Test {
+ protected:
+  void ProcessEvent(const ClientCaptureEvent& event) {
+    ASSERT_FALSE(writer_.ProcessEvent(event).has_error());
+  }
+
+  [[nodiscard]] std::string Finish() {
+    EXPECT_FALSE(writer_.Finish().has_error());
+    return trace_;
+  }
+
+  void ProcessInternedString(uint64_t key, std::string intern) {
+    ClientCaptureEvent event;
+    event.mutable_interned_string()->set_key(key);
+    event.mutable_interned_string()->set_intern(std::move(intern));
+    ProcessEvent(event);
+  }
+
+  std::string trace_;
+  int write_count_ = 0;
+  ChromeTraceWriter writer_{[this](std::string_view data) -> ErrorMessageOr<void> {
+    trace_.append(data);
+    ++write_count_;
+    return outcome::success();
+  }};
+};
+
+}  // namespace
+
+TEST_F(ChromeTraceWriterTest, EmptyTrace) {
+  EXPECT_EQ(Finish(), "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n],\"stackFrames\":{\n}}\n");
+}
+
+TEST_F(ChromeTraceWriterTest, WritesFunctionCallsWithTheNamesOfTheFunctions) {
+  ClientCaptureEvent capture_started;
+  capture_started.mutable_capture_started()->set_process_id(42);
+  capture_started.mutable_capture_started()->set_executable_path("/path/to/game");
+  orbit_grpc_protos::InstrumentedFunction* function = capture_started.mutable_capture_started()
+                                                          ->mutable_capture_options()
+                                                          ->add_instrumented_functions();
+  function->set_function_id(7);
+  function->set_function_name("Render\"Frame\"");
+  ProcessEvent(capture_started);
+
+  ClientCaptureEvent function_call;
+  function_call.mutable_function_call()->set_pid(42);
+  function_call.mutable_function_call()->set_tid(43);
+  function_call.mutable_function_call()->set_function_id(7);
+  function_call.mutable_function_call()->set_end_timestamp_ns(3'500'250);
+  function_call.mutable_function_call()->set_duration_ns(1'000'001);
+  ProcessEvent(function_call);
+
+  const std::string trace = Finish();
+  EXPECT_THAT(trace, HasSubstr(R"({"ph":"M","name":"process_name","pid":42,"tid":42,"ts":0.000,)"
+                               R"("args":{"name":"game"}})"));
+  EXPECT_THAT(trace, HasSubstr(R"({"ph":"X","name":"Render\"Frame\"","pid":42,"tid":43,)"
+                               R"("ts":2500.249,"dur":1000.001})"));
+}
+
+TEST_F(ChromeTraceWriterTest, WritesScopesAndTrackedValues) {
+  ProcessInternedString(1, "Scope");
+  ClientCaptureEvent scope_start;
+  scope_start.mutable_api_scope_start()->set_pid(1);
+  scope_start.mutable_api_scope_start()->set_tid(2);
+  scope_start.mutable_api_scope_start()->set_timestamp_ns(1'000);
+  scope_start.mutable_api_scope_start()->set_name_key(1);
+  ProcessEvent(scope_start);
+  ClientCaptureEvent scope_stop;
+  scope_stop.mutable_api_scope_stop()->set_pid(1);
+  scope_stop.mutable_api_scope_stop()->set_tid(2);
+  scope_stop.mutable_api_scope_stop()->set_timestamp_ns(2'000);
+  ProcessEvent(scope_stop);
+
+  ClientCaptureEvent async_start;
+  async_start.mutable_api_scope_start_async()->set_timestamp_ns(3'000);
+  async_start.mutable_api_scope_start_async()->set_id(5);
+  async_start.mutable_api_scope_start_async()->set_name_key(1);
+  ProcessEvent(async_start);
+  ClientCaptureEvent async_stop;
+  async_stop.mutable_api_scope_stop_async()->set_timestamp_ns(4'000);
+  async_stop.mutable_api_scope_stop_async()->set_id(5);
+  ProcessEvent(async_stop);
+
+  ClientCaptureEvent track_int;
+  track_int.mutable_api_track_int()->set_timestamp_ns(5'000);
+  track_int.mutable_api_track_int()->set_data(-3);
+  ProcessEvent(track_int);
+
+  const std::string trace = Finish();
+  EXPECT_THAT(trace, HasSubstr(R"({"ph":"B","name":"Scope","pid":1,"tid":2,"ts":1.000})"));
+  EXPECT_THAT(trace, HasSubstr(R"({"ph":"E","name":"","pid":1,"tid":2,"ts":2.000})"));
+  EXPECT_THAT(trace, HasSubstr(R"("ph":"b","name":"Scope","pid":0,"tid":0,"ts":3.000,)"
+                               R"("cat":"async","id":"5"})"));
+  EXPECT_THAT(trace, HasSubstr(R"("ph":"e","name":"Scope","pid":0,"tid":0,"ts":4.000,)"
+                               R"("cat":"async","id":"5"})"));
+  EXPECT_THAT(trace, HasSubstr(R"("ph":"C","name":"","pid":0,"tid":0,"ts":5.000,)"
+                               R"("args":{"value":-3}})"));
+}
+
+TEST_F(ChromeTraceWriterTest, InternsTheStackFramesOfTheSamples) {
+  ProcessInternedString(1, "main");
+  ProcessInternedString(2, "/path/to/game");
+  ClientCaptureEvent address_info;
+  address_info.mutable_address_info()->set_absolute_address(0x100);
+  address_info.mutable_address_info()->set_function_name_key(1);
+  address_info.mutable_address_info()->set_module_name_key(2);
+  ProcessEvent(address_info);
+
+  // Both callstacks are called from 0x100, the first pc is the innermost frame.
+  ClientCaptureEvent callstack_1;
+  callstack_1.mutable_interned_callstack()->set_key(11);
+  callstack_1.mutable_interned_callstack()->mutable_intern()->add_pcs(0x200);
+  callstack_1.mutable_interned_callstack()->mutable_intern()->add_pcs(0x100);
+  ProcessEvent(callstack_1);
+  ClientCaptureEvent callstack_2;
+  callstack_2.mutable_interned_callstack()->set_key(12);
+  callstack_2.mutable_interned_callstack()->mutable_intern()->add_pcs(0x300);
+  callstack_2.mutable_interned_callstack()->mutable_intern()->add_pcs(0x100);
+  ProcessEvent(callstack_2);
+
+  ClientCaptureEvent batch;
+  for (uint64_t callstack_id : {11, 12, 11}) {
+    batch.mutable_callstack_sample_batch()->add_pids(1);
+    batch.mutable_callstack_sample_batch()->add_tids(2);
+    batch.mutable_callstack_sample_batch()->add_callstack_ids(callstack_id);
+    batch.mutable_callstack_sample_batch()->add_timestamp_deltas_ns(1'000);
+  }
+  ProcessEvent(batch);
+
+  const std::string trace = Finish();
+  EXPECT_THAT(trace, HasSubstr(R"("ts":1.000,"sf":"2"})"));
+  EXPECT_THAT(trace, HasSubstr(R"("ts":2.000,"sf":"3"})"));
+  EXPECT_THAT(trace, HasSubstr(R"("ts":3.000,"sf":"2"})"));
+  EXPECT_THAT(trace, EndsWith("\"stackFrames\":{\n"
+                              R"("1":{"name":"main","category":"game"},)"
+                              "\n"
+                              R"("2":{"name":"0x200","category":"","parent":"1"},)"
+                              "\n"
+                              R"("3":{"name":"0x300","category":"","parent":"1"})"
+                              "\n}}\n"));
+}
+
+TEST_F(ChromeTraceWriterTest, WritesTheTraceInParts) {
+  ClientCaptureEvent thread_name;
+  thread_name.mutable_thread_name()->set_name(std::string(ChromeTraceWriter::kBufferSize, 'a'));
+  ProcessEvent(thread_name);
+  EXPECT_EQ(write_count_, 1);
+  EXPECT_THAT(trace_, StartsWith("{\"displayTimeUnit\""));
+
+  ProcessEvent(thread_name);
+  EXPECT_EQ(write_count_, 2);
+  std::ignore = Finish();
+  EXPECT_EQ(write_count_, 3);
+}
+
+}  // namespace orbit_capture_file_converter
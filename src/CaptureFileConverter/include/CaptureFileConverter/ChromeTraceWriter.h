@@ -0,0 +1,86 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CAPTURE_FILE_CONVERTER_CHROME_TRACE_WRITER_H_
+#define CAPTURE_FILE_CONVERTER_CHROME_TRACE_WRITER_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_capture_file_converter {
+
+// Converts the ClientCaptureEvents of a capture, in the order of the Capture Section, to a trace in
+// the JSON Trace Event Format of chrome://tracing, which the Perfetto UI also opens. The trace is
+// streamed: it is handed to `write` in parts of about kBufferSize bytes, and only what later events
+// refer to is kept in memory, i.e., the interned strings and callstacks, the names of the functions
+// and of the open asynchronous scopes, and the stack frames.
+// The trace contains the instrumented function calls, the synchronous and asynchronous scopes and
+// the tracked values of the Orbit API, the callstack samples and the names of the threads. The
+// stack frames of the samples are interned in the "stackFrames" dictionary, which is written by
+// Finish, as only then all AddressInfos are known.
+class ChromeTraceWriter {
+ public:
+  static constexpr size_t kBufferSize = 1024 * 1024;
+
+  explicit ChromeTraceWriter(std::function<ErrorMessageOr<void>(std::string_view)> write);
+
+  [[nodiscard]] ErrorMessageOr<void> ProcessEvent(
+      const orbit_grpc_protos::ClientCaptureEvent& event);
+  // Writes the stack frames and the end of the trace. No event must be processed afterwards.
+  [[nodiscard]] ErrorMessageOr<void> Finish();
+
+ private:
+  struct StackFrame {
+    uint64_t parent_id;
+    uint64_t address;
+  };
+
+  void ProcessCaptureStarted(const orbit_grpc_protos::CaptureStarted& capture_started);
+  void ProcessFunctionCall(const orbit_grpc_protos::FunctionCall& function_call);
+  void ProcessCallstackSample(const orbit_grpc_protos::CallstackSample& callstack_sample);
+  void ProcessThreadName(const orbit_grpc_protos::ThreadName& thread_name);
+  template <typename ApiTrackEvent>
+  void ProcessApiTrackEvent(const ApiTrackEvent& api_track_event);
+  template <typename NamedApiEvent>
+  [[nodiscard]] std::string GetApiEventName(const NamedApiEvent& api_event) const;
+  // Returns an empty string if there is no InternedString with `key`.
+  [[nodiscard]] std::string_view GetInternedString(uint64_t key) const;
+  // Returns the id of the innermost frame of the callstack, interning the frames that are new.
+  [[nodiscard]] uint64_t GetStackFrameId(uint64_t callstack_id);
+
+  // Appends the common fields of a trace event and opens it, so that fields can be appended.
+  void BeginTraceEvent(std::string_view phase, std::string_view name, uint32_t pid, uint32_t tid,
+                       uint64_t timestamp_ns);
+  [[nodiscard]] ErrorMessageOr<void> FlushIfFull();
+
+  std::function<ErrorMessageOr<void>(std::string_view)> write_;
+  std::string buffer_;
+  bool is_first_trace_event_ = true;
+
+  absl::flat_hash_map<uint64_t, std::string> interned_strings_;
+  absl::flat_hash_map<uint64_t, orbit_grpc_protos::Callstack> interned_callstacks_;
+  absl::flat_hash_map<uint64_t, std::string> function_names_;
+  absl::flat_hash_map<uint64_t, std::string> open_async_scope_names_;
+  absl::flat_hash_map<uint64_t, orbit_grpc_protos::AddressInfo> address_infos_;
+
+  // The frames form a tree, so that callstacks that share callers share frames. Ids start from 1,
+  // 0 is the parent of the outermost frames.
+  std::vector<StackFrame> stack_frames_;
+  absl::flat_hash_map<std::pair<uint64_t, uint64_t>, uint64_t> parent_id_and_address_to_frame_id_;
+  absl::flat_hash_map<uint64_t, uint64_t> callstack_id_to_frame_id_;
+};
+
+}  // namespace orbit_capture_file_converter
+
+#endif  // CAPTURE_FILE_CONVERTER_CHROME_TRACE_WRITER_H_
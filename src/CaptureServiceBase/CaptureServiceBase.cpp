@@ -4,9 +4,11 @@
 
 #include "CaptureServiceBase/CaptureServiceBase.h"
 
+#include <absl/strings/str_format.h>
 #include <absl/time/clock.h>
 #include <absl/time/time.h>
 
+#include <string>
 #include <utility>
 
 #include "CaptureServiceBase/CaptureStartStopListener.h"
@@ -18,6 +20,7 @@ using orbit_grpc_protos::CaptureFinished;
 using orbit_grpc_protos::CaptureOptions;
 using orbit_grpc_protos::ProducerCaptureEvent;
 
+using orbit_producer_event_processor::CaptureFileClientCaptureEventCollector;
 using orbit_producer_event_processor::ClientCaptureEventCollector;
 using orbit_producer_event_processor::ProducerEventProcessor;
 
@@ -53,30 +56,66 @@ CaptureServiceBase::CaptureInitializationResult CaptureServiceBase::InitializeCa
 void CaptureServiceBase::TerminateCapture() {
   producer_event_processor_.reset();
   client_capture_event_collector_ = nullptr;
+  capture_file_client_capture_event_collector_.reset();
+  error_setting_up_capture_file_on_target_.reset();
   capture_start_timestamp_ns_ = 0;
 
   absl::MutexLock lock(&capture_mutex_);
   is_capturing_ = false;
 }
 
-void CaptureServiceBase::StartEventProcessing(const CaptureOptions& capture_options) {
+void CaptureServiceBase::SetUpCaptureFileOnTarget(const CaptureOptions& capture_options) {
+  if (capture_options.capture_file_path_on_target().empty()) return;
+
+  ErrorMessageOr<std::unique_ptr<CaptureFileClientCaptureEventCollector>> collector_or_error =
+      CaptureFileClientCaptureEventCollector::Create(capture_options.capture_file_path_on_target(),
+                                                     client_capture_event_collector_);
+  if (collector_or_error.has_error()) {
+    // Fall back to streaming the whole capture to the client.
+    error_setting_up_capture_file_on_target_ =
+        absl::StrFormat("Could not write the capture to \"%s\" on the target: %s",
+                        capture_options.capture_file_path_on_target(),
+                        collector_or_error.error().message());
+    ORBIT_ERROR("%s", error_setting_up_capture_file_on_target_.value());
+    return;
+  }
+
+  ORBIT_LOG("Writing capture to \"%s\"", capture_options.capture_file_path_on_target());
+  capture_file_client_capture_event_collector_ = std::move(collector_or_error.value());
+  client_capture_event_collector_ = capture_file_client_capture_event_collector_.get();
+  producer_event_processor_ = ProducerEventProcessor::Create(client_capture_event_collector_);
+}
+
+void CaptureServiceBase::StartEventProcessing(const CaptureOptions& capture_options,
+                                              uint64_t function_call_overhead_ns) {
   // These are not in precise sync but they do not have to be.
   absl::Time capture_start_time = absl::Now();
   capture_start_timestamp_ns_ = orbit_base::CaptureTimestampNs();
 
   producer_event_processor_->ProcessEvent(
       orbit_grpc_protos::kRootProducerId,
-      CreateCaptureStartedEvent(capture_options, capture_start_time, capture_start_timestamp_ns_));
+      CreateCaptureStartedEvent(capture_options, capture_start_time, capture_start_timestamp_ns_,
+                                function_call_overhead_ns));
 
   producer_event_processor_->ProcessEvent(
       orbit_grpc_protos::kRootProducerId,
       CreateClockResolutionEvent(capture_start_timestamp_ns_, clock_resolution_ns_));
+
+  if (error_setting_up_capture_file_on_target_.has_value()) {
+    producer_event_processor_->ProcessEvent(
+        orbit_grpc_protos::kRootProducerId,
+        CreateWarningEvent(capture_start_timestamp_ns_,
+                           std::move(error_setting_up_capture_file_on_target_.value())));
+    error_setting_up_capture_file_on_target_.reset();
+  }
 }
 
 void CaptureServiceBase::FinalizeEventProcessing(
     StopCaptureReason stop_capture_reason,
     CaptureFinished::ProcessState target_process_state_after_capture,
-    CaptureFinished::TerminationSignal target_process_termination_signal) {
+    CaptureFinished::TerminationSignal target_process_termination_signal,
+    const std::optional<orbit_grpc_protos::UnwindingCacheStats>& unwinding_cache_stats,
+    const std::optional<orbit_grpc_protos::EtwStats>& etw_stats) {
   ProducerCaptureEvent capture_finished;
   switch (stop_capture_reason) {
     case StopCaptureReason::kUnknown:
@@ -106,6 +145,13 @@ void CaptureServiceBase::FinalizeEventProcessing(
       target_process_state_after_capture);
   capture_finished.mutable_capture_finished()->set_target_process_termination_signal(
       target_process_termination_signal);
+  if (unwinding_cache_stats.has_value()) {
+    *capture_finished.mutable_capture_finished()->mutable_unwinding_cache_stats() =
+        unwinding_cache_stats.value();
+  }
+  if (etw_stats.has_value()) {
+    *capture_finished.mutable_capture_finished()->mutable_etw_stats() = etw_stats.value();
+  }
 
   producer_event_processor_->ProcessEvent(orbit_grpc_protos::kRootProducerId,
                                           std::move(capture_finished));
@@ -44,7 +44,8 @@ ErrorMessageOr<std::string> GetBuildIdFromElfExecutable(
 
 ProducerCaptureEvent CreateCaptureStartedEvent(const CaptureOptions& capture_options,
                                                absl::Time capture_start_time,
-                                               uint64_t capture_start_timestamp_ns) {
+                                               uint64_t capture_start_timestamp_ns,
+                                               uint64_t function_call_overhead_ns) {
   ProducerCaptureEvent event;
   CaptureStarted* capture_started = event.mutable_capture_started();
 
@@ -83,6 +84,7 @@ ProducerCaptureEvent CreateCaptureStartedEvent(const CaptureOptions& capture_opt
   capture_started->set_orbit_version_major(version.major_version);
   capture_started->set_orbit_version_minor(version.minor_version);
   capture_started->mutable_capture_options()->CopyFrom(capture_options);
+  capture_started->set_function_call_overhead_ns(function_call_overhead_ns);
   return event;
 }
 
@@ -23,11 +23,26 @@ GrpcStartStopCaptureRequestWaiter::WaitForStopCaptureRequest() {
   // The client asks for the capture to be stopped by calling WritesDone. At that point, this
   // call to Read will return false. In the meantime, it blocks if no message is received.
   // Read also unblocks and returns false if the gRPC finishes.
+  // The messages received in the meantime report the backlog of the client.
   while (reader_writer_->Read(&request)) {
+    if (request.has_client_capture_backlog()) {
+      client_capture_backlog_byte_count_->store(
+          request.client_capture_backlog().unprocessed_byte_count(), std::memory_order_relaxed);
+    }
   }
 
   ORBIT_LOG("Client finished writing on Capture's gRPC stream: stopping capture");
   return CaptureServiceBase::StopCaptureReason::kClientStop;
 }
 
-}  // namespace orbit_capture_service_base
\ No newline at end of file
+void SetCaptureResponseCompression(const orbit_grpc_protos::CaptureOptions& capture_options,
+                                   grpc::ServerContext* context) {
+  if (capture_options.capture_response_compression() !=
+      orbit_grpc_protos::CaptureOptions::kGzip) {
+    return;
+  }
+  ORBIT_LOG("Compressing CaptureResponses with gzip");
+  context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+}
+
+}  // namespace orbit_capture_service_base
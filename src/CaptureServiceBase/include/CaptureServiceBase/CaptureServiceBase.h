@@ -11,11 +11,14 @@
 #include <stdint.h>
 
 #include <memory>
+#include <optional>
+#include <string>
 
 #include "CaptureStartStopListener.h"
 #include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Profiling.h"
 #include "OrbitBase/Result.h"
+#include "ProducerEventProcessor/CaptureFileClientCaptureEventCollector.h"
 #include "ProducerEventProcessor/ClientCaptureEventCollector.h"
 #include "ProducerEventProcessor/ProducerEventProcessor.h"
 
@@ -44,13 +47,22 @@ class CaptureServiceBase {
   void TerminateCapture();
 
  protected:
-  void StartEventProcessing(const orbit_grpc_protos::CaptureOptions& capture_options);
+  // If `capture_options.capture_file_path_on_target()` is set, makes the events be written to that
+  // file, with only a preview of the capture sent to the collector passed to InitializeCapture.
+  // Must be called before `producer_event_processor_` is used, as it might be replaced.
+  void SetUpCaptureFileOnTarget(const orbit_grpc_protos::CaptureOptions& capture_options);
+  // `function_call_overhead_ns` is reported in CaptureStarted.
+  void StartEventProcessing(const orbit_grpc_protos::CaptureOptions& capture_options,
+                            uint64_t function_call_overhead_ns = 0);
   void FinalizeEventProcessing(
       StopCaptureReason stop_capture_reason,
       orbit_grpc_protos::CaptureFinished::ProcessState target_process_state_after_capture =
           orbit_grpc_protos::CaptureFinished::kProcessStateUnknown,
       orbit_grpc_protos::CaptureFinished::TerminationSignal target_process_termination_signal =
-          orbit_grpc_protos::CaptureFinished::kTerminationSignalUnknown);
+          orbit_grpc_protos::CaptureFinished::kTerminationSignalUnknown,
+      const std::optional<orbit_grpc_protos::UnwindingCacheStats>& unwinding_cache_stats =
+          std::nullopt,
+      const std::optional<orbit_grpc_protos::EtwStats>& etw_stats = std::nullopt);
 
   orbit_producer_event_processor::ClientCaptureEventCollector* client_capture_event_collector_;
   std::unique_ptr<orbit_producer_event_processor::ProducerEventProcessor> producer_event_processor_;
@@ -61,6 +73,10 @@ class CaptureServiceBase {
  private:
   // We estimate clock resolution only once, not at the beginning of every capture.
   uint64_t clock_resolution_ns_ = orbit_base::EstimateAndLogClockResolution();
+  std::unique_ptr<orbit_producer_event_processor::CaptureFileClientCaptureEventCollector>
+      capture_file_client_capture_event_collector_;
+  // Reported as a warning once CaptureStarted has been sent.
+  std::optional<std::string> error_setting_up_capture_file_on_target_;
   absl::Mutex capture_mutex_;
   bool is_capturing_ ABSL_GUARDED_BY(capture_mutex_) = false;
 };
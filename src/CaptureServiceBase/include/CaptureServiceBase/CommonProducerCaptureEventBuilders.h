@@ -18,7 +18,7 @@ namespace orbit_capture_service_base {
 
 [[nodiscard]] orbit_grpc_protos::ProducerCaptureEvent CreateCaptureStartedEvent(
     const orbit_grpc_protos::CaptureOptions& capture_options, absl::Time capture_start_time,
-    uint64_t capture_start_timestamp_ns);
+    uint64_t capture_start_timestamp_ns, uint64_t function_call_overhead_ns = 0);
 
 [[nodiscard]] orbit_grpc_protos::ProducerCaptureEvent CreateSuccessfulCaptureFinishedEvent();
 
@@ -6,6 +6,10 @@
 #define CAPTURE_SERVICE_BASE_GRPC_START_STOP_CAPTURE_REQUEST_WAITER_H_
 
 #include <grpcpp/grpcpp.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
 
 #include "CaptureServiceBase/CaptureServiceBase.h"
 #include "CaptureServiceBase/StopCaptureRequestWaiter.h"
@@ -27,11 +31,28 @@ class GrpcStartStopCaptureRequestWaiter : public StopCaptureRequestWaiter {
   [[nodiscard]] orbit_grpc_protos::CaptureOptions WaitForStartCaptureRequest();
   [[nodiscard]] CaptureServiceBase::StopCaptureReason WaitForStopCaptureRequest() override;
 
+  [[nodiscard]] uint64_t GetClientCaptureBacklogByteCount() const override {
+    return client_capture_backlog_byte_count_->load(std::memory_order_relaxed);
+  }
+  // Shared, as the thread waiting for the stop request can outlive the users of the backlog, e.g.,
+  // a GrpcClientCaptureEventCollector.
+  [[nodiscard]] std::shared_ptr<const std::atomic<uint64_t>> GetClientCaptureBacklogByteCountPtr()
+      const {
+    return client_capture_backlog_byte_count_;
+  }
+
  private:
   grpc::ServerReaderWriter<orbit_grpc_protos::CaptureResponse, orbit_grpc_protos::CaptureRequest>*
       reader_writer_;
+  std::shared_ptr<std::atomic<uint64_t>> client_capture_backlog_byte_count_ =
+      std::make_shared<std::atomic<uint64_t>>(0);
 };
 
+// Makes gRPC compress the CaptureResponses written on the stream of `context` as requested by
+// `capture_options`. Needs to be called before the first CaptureResponse is written.
+void SetCaptureResponseCompression(const orbit_grpc_protos::CaptureOptions& capture_options,
+                                   grpc::ServerContext* context);
+
 }  // namespace orbit_capture_service_base
 
 #endif  // CAPTURE_SERVICE_BASE_GRPC_START_STOP_CAPTURE_REQUEST_WAITER_H_
\ No newline at end of file
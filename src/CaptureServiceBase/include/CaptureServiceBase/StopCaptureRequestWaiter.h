@@ -5,6 +5,8 @@
 #ifndef CAPTURE_SERVICE_BASE_STOP_CAPTURE_REQUEST_WAITER_H_
 #define CAPTURE_SERVICE_BASE_STOP_CAPTURE_REQUEST_WAITER_H_
 
+#include <stdint.h>
+
 #include "CaptureServiceBase/CaptureServiceBase.h"
 #include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Result.h"
@@ -18,6 +20,10 @@ class StopCaptureRequestWaiter {
  public:
   virtual ~StopCaptureRequestWaiter() = default;
   [[nodiscard]] virtual CaptureServiceBase::StopCaptureReason WaitForStopCaptureRequest() = 0;
+
+  // The last ClientCaptureBacklog::unprocessed_byte_count reported by the client while waiting, or
+  // 0 if the client doesn't report it. Can be called from any thread.
+  [[nodiscard]] virtual uint64_t GetClientCaptureBacklogByteCount() const { return 0; }
 };
 
 }  // namespace orbit_capture_service_base
@@ -0,0 +1,65 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ClientData/AddressRangeIndex.h"
+
+using ::testing::ElementsAre;
+using ::testing::IsNull;
+using ::testing::Pointee;
+
+namespace orbit_client_data {
+
+namespace {
+
+AddressRangeIndex<std::string> CreateIndex() {
+  return AddressRangeIndex<std::string>{
+      {{0x300, 0x400, "c"}, {0x100, 0x200, "a"}, {0x200, 0x250, "b"}}};
+}
+
+}  // namespace
+
+TEST(AddressRangeIndex, Find) {
+  const AddressRangeIndex<std::string> index = CreateIndex();
+  EXPECT_EQ(index.size(), 3);
+  EXPECT_THAT(index.values(), ElementsAre("a", "b", "c"));
+
+  EXPECT_THAT(index.Find(0x0ff), IsNull());
+  EXPECT_THAT(index.Find(0x100), Pointee(std::string{"a"}));
+  EXPECT_THAT(index.Find(0x1ff), Pointee(std::string{"a"}));
+  EXPECT_THAT(index.Find(0x200), Pointee(std::string{"b"}));
+  EXPECT_THAT(index.Find(0x250), IsNull());
+  EXPECT_THAT(index.Find(0x3ff), Pointee(std::string{"c"}));
+  EXPECT_THAT(index.Find(0x400), IsNull());
+
+  EXPECT_THAT(index.FindExact(0x200), Pointee(std::string{"b"}));
+  EXPECT_THAT(index.FindExact(0x201), IsNull());
+}
+
+TEST(AddressRangeIndex, EmptyIndex) {
+  const AddressRangeIndex<std::string> index;
+  EXPECT_TRUE(index.empty());
+  EXPECT_THAT(index.Find(0x100), IsNull());
+  EXPECT_THAT(index.FindExact(0x100), IsNull());
+}
+
+TEST(AddressRangeIndex, FindBatchMatchesFind) {
+  const AddressRangeIndex<std::string> index = CreateIndex();
+  // Ascending with duplicates, then descending again.
+  const std::vector<uint64_t> addresses = {0x050, 0x100, 0x180, 0x180, 0x220, 0x260,
+                                           0x300, 0x500, 0x1ff, 0x100, 0x3ff};
+  std::vector<const std::string*> results(addresses.size());
+  index.FindBatch(addresses, absl::MakeSpan(results));
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    EXPECT_EQ(results[i], index.Find(addresses[i])) << i;
+  }
+}
+
+}  // namespace orbit_client_data
@@ -6,27 +6,44 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/types/span.h>
 #include <stdint.h>
 
 #include <algorithm>
 #include <mutex>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "ClientData/CallstackEvent.h"
 #include "ClientData/CallstackInfo.h"
 #include "ClientData/CallstackType.h"
+#include "Introspection/Introspection.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/ParallelFor.h"
 
 namespace orbit_client_data {
 
 void CallstackData::AddCallstackEvent(CallstackEvent callstack_event) {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
+  ORBIT_CHECK(!is_frozen_.load(std::memory_order_relaxed));
   ORBIT_CHECK(unique_callstacks_.contains(callstack_event.callstack_id()));
   RegisterTime(callstack_event.timestamp_ns());
   callstack_events_by_tid_[callstack_event.thread_id()].emplace(callstack_event.timestamp_ns(),
                                                                 callstack_event);
 }
 
+void CallstackData::AddCallstackEvents(absl::Span<const CallstackEvent> callstack_events) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  ORBIT_CHECK(!is_frozen_.load(std::memory_order_relaxed));
+  for (const CallstackEvent& callstack_event : callstack_events) {
+    ORBIT_CHECK(unique_callstacks_.contains(callstack_event.callstack_id()));
+    RegisterTime(callstack_event.timestamp_ns());
+    callstack_events_by_tid_[callstack_event.thread_id()].emplace(callstack_event.timestamp_ns(),
+                                                                  callstack_event);
+  }
+}
+
 void CallstackData::RegisterTime(uint64_t time) {
   if (time > max_time_) max_time_ = time;
   if (time > 0 && time < min_time_) min_time_ = time;
@@ -38,66 +55,206 @@ void CallstackData::AddUniqueCallstack(uint64_t callstack_id, CallstackInfo call
 }
 
 uint32_t CallstackData::GetCallstackEventsCount() const {
+  return VisitCallstackEventsByTid([](const auto& callstack_events_by_tid) {
+    uint32_t count = 0;
+    for (const auto& tid_and_events : callstack_events_by_tid) {
+      count += tid_and_events.second.size();
+    }
+    return count;
+  });
+}
+
+uint64_t CallstackData::GetMemoryUsageBytes() const {
+  uint64_t memory_usage_bytes = uint64_t{GetCallstackEventsCount()} * sizeof(CallstackEvent);
   std::lock_guard<std::recursive_mutex> lock(mutex_);
-  uint32_t count = 0;
-  for (const auto& tid_and_events : callstack_events_by_tid_) {
-    count += tid_and_events.second.size();
+  for (const auto& [unused_callstack_id, callstack_ptr] : unique_callstacks_) {
+    memory_usage_bytes += sizeof(CallstackInfo) + callstack_ptr->frames().size() * sizeof(uint64_t);
   }
-  return count;
+  return memory_usage_bytes;
 }
 
 std::vector<orbit_client_data::CallstackEvent> CallstackData::GetCallstackEventsInTimeRange(
     uint64_t time_begin, uint64_t time_end) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
   std::vector<CallstackEvent> callstack_events;
-  for (const auto& tid_and_events : callstack_events_by_tid_) {
-    const absl::btree_map<uint64_t, CallstackEvent>& events = tid_and_events.second;
-    for (auto event_it = events.lower_bound(time_begin); event_it != events.end(); ++event_it) {
-      uint64_t time = event_it->first;
-      if (time < time_end) {
-        callstack_events.push_back(event_it->second);
-      } else {
-        break;
+  VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+    for (const auto& tid_and_events : callstack_events_by_tid) {
+      const auto& events = tid_and_events.second;
+      for (auto event_it = LowerBound(events, time_begin); event_it != events.end(); ++event_it) {
+        const CallstackEvent& event = GetEvent(*event_it);
+        if (event.timestamp_ns() < time_end) {
+          callstack_events.push_back(event);
+        } else {
+          break;
+        }
       }
     }
-  }
+  });
   return callstack_events;
 }
 
 uint32_t CallstackData::GetCallstackEventsOfTidCount(uint32_t thread_id) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  const auto& tid_and_events_it = callstack_events_by_tid_.find(thread_id);
-  if (tid_and_events_it == callstack_events_by_tid_.end()) {
-    return 0;
-  }
-  return tid_and_events_it->second.size();
+  return VisitCallstackEventsByTid([thread_id](const auto& callstack_events_by_tid) -> uint32_t {
+    const auto& tid_and_events_it = callstack_events_by_tid.find(thread_id);
+    if (tid_and_events_it == callstack_events_by_tid.end()) {
+      return 0;
+    }
+    return tid_and_events_it->second.size();
+  });
 }
 
 std::vector<CallstackEvent> CallstackData::GetCallstackEventsOfTidInTimeRange(
     uint32_t tid, uint64_t time_begin, uint64_t time_end) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
   std::vector<CallstackEvent> callstack_events;
+  VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+    auto tid_and_events_it = callstack_events_by_tid.find(tid);
+    if (tid_and_events_it == callstack_events_by_tid.end()) {
+      return;
+    }
+
+    const auto& events = tid_and_events_it->second;
+    for (auto event_it = LowerBound(events, time_begin); event_it != events.end(); ++event_it) {
+      const CallstackEvent& event = GetEvent(*event_it);
+      if (event.timestamp_ns() < time_end) {
+        callstack_events.push_back(event);
+      } else {
+        break;
+      }
+    }
+  });
+  return callstack_events;
+}
+
+absl::flat_hash_map<uint64_t, uint32_t> CallstackData::GetCallstackIdToCountOfTidInTimeRange(
+    uint32_t tid, uint64_t time_begin, uint64_t time_end) const {
+  absl::flat_hash_map<uint64_t, uint32_t> counts;
+  VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+    auto tid_and_events_it = callstack_events_by_tid.find(tid);
+    if (tid_and_events_it == callstack_events_by_tid.end()) {
+      return;
+    }
+    AddCallstackIdCountsInTimeRange(tid, tid_and_events_it->second, time_begin, time_end,
+                                    &counts);
+  });
+  return counts;
+}
+
+absl::flat_hash_map<uint32_t, absl::flat_hash_map<uint64_t, uint32_t>>
+CallstackData::GetThreadIdToCallstackIdToCountInTimeRange(uint64_t time_begin,
+                                                          uint64_t time_end) const {
+  absl::flat_hash_map<uint32_t, absl::flat_hash_map<uint64_t, uint32_t>> thread_id_to_counts;
+  VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+    for (const auto& [tid, events] : callstack_events_by_tid) {
+      absl::flat_hash_map<uint64_t, uint32_t> counts;
+      AddCallstackIdCountsInTimeRange(tid, events, time_begin, time_end, &counts);
+      if (!counts.empty()) {
+        thread_id_to_counts.emplace(tid, std::move(counts));
+      }
+    }
+  });
+  return thread_id_to_counts;
+}
+
+void CallstackData::AddCallstackIdCountsInTimeRange(
+    uint32_t /*tid*/, const CallstackEventsByTimestamp& events, uint64_t time_begin,
+    uint64_t time_end, absl::flat_hash_map<uint64_t, uint32_t>* counts) {
+  for (auto event_it = events.lower_bound(time_begin);
+       event_it != events.end() && event_it->first < time_end; ++event_it) {
+    ++(*counts)[event_it->second.callstack_id()];
+  }
+}
+
+void CallstackData::AddCallstackIdCountsInTimeRange(
+    uint32_t tid, const FrozenCallstackEvents& events, uint64_t time_begin, uint64_t time_end,
+    absl::flat_hash_map<uint64_t, uint32_t>* counts) const {
+  const size_t begin = LowerBound(events, time_begin) - events.begin();
+  const size_t end = LowerBound(events, time_end) - events.begin();
+  if (begin >= end) return;
 
-  auto tid_and_events_it = callstack_events_by_tid_.find(tid);
-  if (tid_and_events_it == callstack_events_by_tid_.end()) {
-    return callstack_events;
+  auto add_events = [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      ++(*counts)[events[i].callstack_id()];
+    }
+  };
+
+  // The blocks entirely inside [begin, end).
+  const size_t first_block = (begin + kCountsBlockSize - 1) / kCountsBlockSize;
+  const size_t last_block = end / kCountsBlockSize;
+  if (first_block >= last_block) {
+    add_events(begin, end);
+    return;
   }
 
-  const absl::btree_map<uint64_t, CallstackEvent>& events = tid_and_events_it->second;
-  for (auto event_it = events.lower_bound(time_begin); event_it != events.end(); ++event_it) {
-    uint64_t time = event_it->first;
-    if (time < time_end) {
-      callstack_events.push_back(event_it->second);
-    } else {
-      break;
+  add_events(begin, first_block * kCountsBlockSize);
+  const std::vector<CallstackIdCounts>& block_counts = frozen_block_counts_by_tid_.at(tid);
+  for (size_t block = first_block; block < last_block; ++block) {
+    for (const auto& [callstack_id, count] : block_counts[block]) {
+      (*counts)[callstack_id] += count;
     }
   }
-  return callstack_events;
+  add_events(last_block * kCountsBlockSize, end);
+}
+
+void CallstackData::OnCaptureComplete() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (is_frozen_.load(std::memory_order_relaxed)) return;
+
+  frozen_callstack_events_by_tid_.reserve(callstack_events_by_tid_.size());
+  size_t num_events = 0;
+  for (auto& [tid, timestamps_and_callstack_events] : callstack_events_by_tid_) {
+    FrozenCallstackEvents& events = frozen_callstack_events_by_tid_[tid];
+    events.reserve(timestamps_and_callstack_events.size());
+    for (const auto& [unused_timestamp_ns, event] : timestamps_and_callstack_events) {
+      events.push_back(event);
+    }
+
+    // Only full blocks, as the events after the last one are always counted one by one.
+    std::vector<CallstackIdCounts>& block_counts = frozen_block_counts_by_tid_[tid];
+    block_counts.reserve(events.size() / kCountsBlockSize);
+    for (size_t block_begin = 0; block_begin + kCountsBlockSize <= events.size();
+         block_begin += kCountsBlockSize) {
+      absl::flat_hash_map<uint64_t, uint32_t> counts;
+      for (size_t i = block_begin; i < block_begin + kCountsBlockSize; ++i) {
+        ++counts[events[i].callstack_id()];
+      }
+      block_counts.emplace_back(counts.begin(), counts.end());
+    }
+
+    std::vector<uint64_t> timestamps_ns;
+    timestamps_ns.reserve(events.size());
+    for (const CallstackEvent& event : events) {
+      timestamps_ns.push_back(event.timestamp_ns());
+    }
+    frozen_pyramids_by_tid_.try_emplace(tid, std::move(timestamps_ns));
+    num_events += events.size();
+  }
+
+  // The vectors of events are not modified anymore, so the pointers into them stay valid.
+  frozen_callstack_events_of_all_threads_.reserve(num_events);
+  for (const auto& [unused_tid, events] : frozen_callstack_events_by_tid_) {
+    for (const CallstackEvent& event : events) {
+      frozen_callstack_events_of_all_threads_.push_back(&event);
+    }
+  }
+  std::stable_sort(frozen_callstack_events_of_all_threads_.begin(),
+                   frozen_callstack_events_of_all_threads_.end(),
+                   [](const CallstackEvent* lhs, const CallstackEvent* rhs) {
+                     return lhs->timestamp_ns() < rhs->timestamp_ns();
+                   });
+  std::vector<uint64_t> timestamps_ns;
+  timestamps_ns.reserve(frozen_callstack_events_of_all_threads_.size());
+  for (const CallstackEvent* event : frozen_callstack_events_of_all_threads_) {
+    timestamps_ns.push_back(event->timestamp_ns());
+  }
+  frozen_pyramid_of_all_threads_ = TimestampBucketPyramid(std::move(timestamps_ns));
+
+  callstack_events_by_tid_.clear();
+  is_frozen_.store(true, std::memory_order_release);
 }
 
 void CallstackData::AddCallstackFromKnownCallstackData(const CallstackEvent& event,
                                                        const CallstackData& known_callstack_data) {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
+  ORBIT_CHECK(!is_frozen_.load(std::memory_order_relaxed));
   uint64_t callstack_id = event.callstack_id();
   std::shared_ptr<CallstackInfo> unique_callstack =
       known_callstack_data.GetCallstackPtr(callstack_id);
@@ -132,19 +289,23 @@ std::shared_ptr<CallstackInfo> CallstackData::GetCallstackPtr(uint64_t callstack
   return nullptr;
 }
 
+// `functions_to_stop_unwinding_at` holds the start address and the size of each function, sorted by
+// start address.
 static bool IsPcInFunctionsToStopUnwindingAt(
-    const std::map<uint64_t, uint64_t>& absolute_address_to_size_of_functions_to_stop_unwinding_at,
-    uint64_t pc) {
-  auto function_it = absolute_address_to_size_of_functions_to_stop_unwinding_at.upper_bound(pc);
-  if (function_it == absolute_address_to_size_of_functions_to_stop_unwinding_at.begin()) {
+    absl::Span<const std::pair<uint64_t, uint64_t>> functions_to_stop_unwinding_at, uint64_t pc) {
+  auto function_it =
+      std::upper_bound(functions_to_stop_unwinding_at.begin(), functions_to_stop_unwinding_at.end(),
+                       pc, [](uint64_t pc, const std::pair<uint64_t, uint64_t>& function) {
+                         return pc < function.first;
+                       });
+  if (function_it == functions_to_stop_unwinding_at.begin()) {
     return false;
   }
 
   --function_it;
 
-  uint64_t function_start = function_it->first;
+  const auto& [function_start, size] = *function_it;
   ORBIT_CHECK(function_start <= pc);
-  uint64_t size = function_it->second;
   return (pc < function_start + size);
 }
 
@@ -152,77 +313,103 @@ void CallstackData::UpdateCallstackTypeBasedOnMajorityStart(
     const std::map<uint64_t, uint64_t>&
         absolute_address_to_size_of_functions_to_stop_unwinding_at) {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
+  ORBIT_SCOPE_FUNCTION;
+
+  // Classify each unique callstack once, instead of each CallstackEvent: only the complete
+  // callstacks whose outermost frame is not in a function to stop unwinding at take part in the
+  // majority vote, and they are mapped to that frame.
+  const std::vector<std::pair<uint64_t, uint64_t>> functions_to_stop_unwinding_at(
+      absolute_address_to_size_of_functions_to_stop_unwinding_at.begin(),
+      absolute_address_to_size_of_functions_to_stop_unwinding_at.end());
+  absl::flat_hash_map<uint64_t, uint64_t> outermost_frame_by_callstack_id;
+  outermost_frame_by_callstack_id.reserve(unique_callstacks_.size());
+  for (const auto& [callstack_id, callstack] : unique_callstacks_) {
+    if (callstack->type() != CallstackType::kComplete) continue;
+    const auto& frames = callstack->frames();
+    ORBIT_CHECK(!frames.empty());
+    const uint64_t outermost_frame = *frames.rbegin();
+    if (IsPcInFunctionsToStopUnwindingAt(functions_to_stop_unwinding_at, outermost_frame)) {
+      continue;
+    }
+    outermost_frame_by_callstack_id.emplace(callstack_id, outermost_frame);
+  }
 
   absl::flat_hash_set<uint64_t> callstack_ids_to_filter;
 
-  for (auto& [tid, timestamps_and_callstack_events] : callstack_events_by_tid_) {
-    uint64_t count_for_this_thread = 0;
+  VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+    using CallstackEventsOfThread =
+        typename std::decay_t<decltype(callstack_events_by_tid)>::mapped_type;
+    std::vector<std::pair<uint32_t, const CallstackEventsOfThread*>> threads;
+    threads.reserve(callstack_events_by_tid.size());
+    for (const auto& [tid, timestamps_and_callstack_events] : callstack_events_by_tid) {
+      threads.emplace_back(tid, &timestamps_and_callstack_events);
+    }
 
-    // Count the number of occurrences of each outer frame for this thread.
-    absl::flat_hash_map<uint64_t, uint64_t> count_by_outer_frame;
-    for (const auto& [unused_timestamp_ns, event] : timestamps_and_callstack_events) {
-      const CallstackInfo& callstack = *unique_callstacks_.at(event.callstack_id());
-      ORBIT_CHECK(callstack.type() != CallstackType::kFilteredByMajorityOutermostFrame);
-      if (callstack.type() != CallstackType::kComplete) {
-        continue;
-      }
+    // The threads are independent of each other, only the CallstackInfos they share are read. Each
+    // thread records the ids to filter separately, and they are merged afterwards.
+    std::vector<std::vector<uint64_t>> callstack_ids_to_filter_by_thread(threads.size());
+    orbit_base::ParallelFor(threads.size(), [&](size_t thread_index) {
+      const auto& [tid, timestamps_and_callstack_events] = threads[thread_index];
 
-      const auto& frames = callstack.frames();
-      ORBIT_CHECK(!frames.empty());
-      uint64_t outer_frame = *frames.rbegin();
-      if (!IsPcInFunctionsToStopUnwindingAt(
-              absolute_address_to_size_of_functions_to_stop_unwinding_at, outer_frame)) {
-        ++count_for_this_thread;
-        ++count_by_outer_frame[outer_frame];
+      // Count the events of this thread per callstack, then per outermost frame.
+      absl::flat_hash_map<uint64_t, uint64_t> count_by_callstack_id;
+      for (const auto& entry : *timestamps_and_callstack_events) {
+        ++count_by_callstack_id[GetEvent(entry).callstack_id()];
       }
-    }
 
-    // Find the outer frame with the most occurrences.
-    if (count_by_outer_frame.empty()) {
-      continue;
-    }
-    uint64_t majority_outer_frame = 0;
-    uint64_t majority_outer_frame_count = 0;
-    for (const auto& outer_frame_and_count : count_by_outer_frame) {
-      ORBIT_CHECK(outer_frame_and_count.second > 0);
-      if (outer_frame_and_count.second > majority_outer_frame_count) {
-        majority_outer_frame = outer_frame_and_count.first;
-        majority_outer_frame_count = outer_frame_and_count.second;
+      uint64_t count_for_this_thread = 0;
+      absl::flat_hash_map<uint64_t, uint64_t> count_by_outer_frame;
+      for (const auto& [callstack_id, count] : count_by_callstack_id) {
+        ORBIT_CHECK(unique_callstacks_.at(callstack_id)->type() !=
+                    CallstackType::kFilteredByMajorityOutermostFrame);
+        auto outermost_frame_it = outermost_frame_by_callstack_id.find(callstack_id);
+        if (outermost_frame_it == outermost_frame_by_callstack_id.end()) continue;
+        count_for_this_thread += count;
+        count_by_outer_frame[outermost_frame_it->second] += count;
       }
-    }
 
-    // The value is somewhat arbitrary. We want at least three quarters of the thread's callstacks
-    // to agree on the "correct" outermost frame.
-    static constexpr double kFilterSupermajorityThreshold = 0.75;
-    if (majority_outer_frame_count < count_for_this_thread * kFilterSupermajorityThreshold) {
-      ORBIT_LOG(
-          "Skipping filtering CallstackEvents for tid %d: majority outer frame has only %lu "
-          "occurrences out of %lu",
-          tid, majority_outer_frame_count, count_for_this_thread);
-      continue;
-    }
+      // Find the outer frame with the most occurrences.
+      if (count_by_outer_frame.empty()) {
+        return;
+      }
+      uint64_t majority_outer_frame = 0;
+      uint64_t majority_outer_frame_count = 0;
+      for (const auto& outer_frame_and_count : count_by_outer_frame) {
+        ORBIT_CHECK(outer_frame_and_count.second > 0);
+        if (outer_frame_and_count.second > majority_outer_frame_count) {
+          majority_outer_frame = outer_frame_and_count.first;
+          majority_outer_frame_count = outer_frame_and_count.second;
+        }
+      }
 
-    // Record the ids of the CallstackInfos references by the CallstackEvents whose outer frame
-    // doesn't match the (super)majority outer frame.
-    // Note that if a CallstackEvent from another thread references a filtered CallstackInfo, that
-    // CallstackEvent will also be affected.
-    for (const auto& [unused_timestamp_ns, event] : timestamps_and_callstack_events) {
-      const CallstackInfo& callstack = *unique_callstacks_.at(event.callstack_id());
-      ORBIT_CHECK(callstack.type() != CallstackType::kFilteredByMajorityOutermostFrame);
-      if (callstack.type() != CallstackType::kComplete) {
-        continue;
+      // The value is somewhat arbitrary. We want at least three quarters of the thread's callstacks
+      // to agree on the "correct" outermost frame.
+      static constexpr double kFilterSupermajorityThreshold = 0.75;
+      if (majority_outer_frame_count < count_for_this_thread * kFilterSupermajorityThreshold) {
+        ORBIT_LOG(
+            "Skipping filtering CallstackEvents for tid %d: majority outer frame has only %lu "
+            "occurrences out of %lu",
+            tid, majority_outer_frame_count, count_for_this_thread);
+        return;
       }
 
-      const auto& frames = unique_callstacks_.at(event.callstack_id())->frames();
-      ORBIT_CHECK(!frames.empty());
-      uint64_t outermost_frame = *frames.rbegin();
-      if (outermost_frame != majority_outer_frame &&
-          !IsPcInFunctionsToStopUnwindingAt(
-              absolute_address_to_size_of_functions_to_stop_unwinding_at, outermost_frame)) {
-        callstack_ids_to_filter.insert(event.callstack_id());
+      // Record the ids of the CallstackInfos references by the CallstackEvents whose outer frame
+      // doesn't match the (super)majority outer frame.
+      // Note that if a CallstackEvent from another thread references a filtered CallstackInfo, that
+      // CallstackEvent will also be affected.
+      for (const auto& [callstack_id, unused_count] : count_by_callstack_id) {
+        auto outermost_frame_it = outermost_frame_by_callstack_id.find(callstack_id);
+        if (outermost_frame_it == outermost_frame_by_callstack_id.end()) continue;
+        if (outermost_frame_it->second != majority_outer_frame) {
+          callstack_ids_to_filter_by_thread[thread_index].push_back(callstack_id);
+        }
       }
+    });
+
+    for (const std::vector<uint64_t>& callstack_ids : callstack_ids_to_filter_by_thread) {
+      callstack_ids_to_filter.insert(callstack_ids.begin(), callstack_ids.end());
     }
-  }
+  });
 
   // Change the type of the recorded CallstackInfos.
   for (uint64_t callstack_id_to_filter : callstack_ids_to_filter) {
@@ -233,14 +420,12 @@ void CallstackData::UpdateCallstackTypeBasedOnMajorityStart(
 
   // Count how many CallstackEvents had their CallstackInfo affected by the type change.
   uint64_t affected_event_count = 0;
-  for (auto& [tid, timestamps_and_callstack_events] : callstack_events_by_tid_) {
-    for (const auto& [unused_timestamp_ns, event] : timestamps_and_callstack_events) {
-      if (unique_callstacks_.at(event.callstack_id())->type() ==
-          CallstackType::kFilteredByMajorityOutermostFrame) {
-        ++affected_event_count;
-      }
+  ForEachCallstackEvent([&](const CallstackEvent& event) {
+    if (unique_callstacks_.at(event.callstack_id())->type() ==
+        CallstackType::kFilteredByMajorityOutermostFrame) {
+      ++affected_event_count;
     }
-  }
+  });
 
   uint32_t callstack_event_count = GetCallstackEventsCount();
   ORBIT_LOG(
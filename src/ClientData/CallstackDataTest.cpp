@@ -6,6 +6,7 @@
 #include <absl/container/flat_hash_map.h>
 #include <absl/functional/bind_front.h>
 #include <absl/functional/function_ref.h>
+#include <absl/strings/str_format.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -230,12 +231,19 @@ const std::vector<CallstackEvent> kAllEvents = [] {
 
 constexpr auto kGetTestName = [](const auto& info) { return info.param.test_name; };
 
-std::unique_ptr<CallstackData> kCallstackDataWithEvents = [] {
+[[nodiscard]] static std::unique_ptr<CallstackData> CreateCallstackDataWithEvents() {
   auto result = std::make_unique<CallstackData>();
   CallstackInfo cs{{0x11, 0x10}, CallstackType::kComplete};
   result->AddUniqueCallstack(kCallstackId1, std::move(cs));
   absl::c_for_each(kAllEvents, absl::bind_front(&CallstackData::AddCallstackEvent, result.get()));
   return result;
+}
+
+std::unique_ptr<CallstackData> kCallstackDataWithEvents = CreateCallstackDataWithEvents();
+std::unique_ptr<CallstackData> kFrozenCallstackDataWithEvents = [] {
+  std::unique_ptr<CallstackData> result = CreateCallstackDataWithEvents();
+  result->OnCaptureComplete();
+  return result;
 }();
 
 template <typename T>
@@ -245,6 +253,114 @@ template <typename T>
   return slice;
 }
 
+TEST(CallstackData, ReadsAreTheSameAfterOnCaptureComplete) {
+  std::unique_ptr<CallstackData> callstack_data = CreateCallstackDataWithEvents();
+
+  auto expect_all_events = [&] {
+    EXPECT_EQ(callstack_data->GetCallstackEventsCount(), kAllEvents.size());
+    EXPECT_EQ(callstack_data->GetCallstackEventsOfTidCount(kTid), 3);
+    EXPECT_EQ(callstack_data->GetCallstackEventsOfTidCount(kAnotherTid), 1);
+    EXPECT_EQ(callstack_data->GetCallstackEventsOfTidCount(44), 0);
+    EXPECT_EQ(callstack_data->min_time(), kTimestamps[0]);
+    EXPECT_EQ(callstack_data->max_time(), kTimestamps[3]);
+
+    EXPECT_THAT(callstack_data->GetCallstackEventsOfTidInTimeRange(kTid, kTimestamps[1],
+                                                                   kTimestamps[3]),
+                Pointwise(CallstackEventEq(), Slice(kAllEvents, {1})));
+    std::vector<CallstackEvent> events_in_time_range =
+        callstack_data->GetCallstackEventsInTimeRange(kTimestamps[1], kTimestamps[3]);
+    absl::c_sort(events_in_time_range, [](const CallstackEvent& lhs, const CallstackEvent& rhs) {
+      return lhs.timestamp_ns() < rhs.timestamp_ns();
+    });
+    EXPECT_THAT(events_in_time_range, Pointwise(CallstackEventEq(), Slice(kAllEvents, {1, 2})));
+
+    std::vector<CallstackEvent> visited_events;
+    callstack_data->ForEachCallstackEventOfTidInTimeRange(
+        kTid, kTimestamps[1], kTimestamps[3],
+        [&](const CallstackEvent& event) { visited_events.push_back(event); });
+    EXPECT_THAT(visited_events, Pointwise(CallstackEventEq(), Slice(kAllEvents, {1, 3})));
+
+    uint64_t visited_event_count = 0;
+    callstack_data->ForEachCallstackEvent([&](const CallstackEvent&) { ++visited_event_count; });
+    EXPECT_EQ(visited_event_count, kAllEvents.size());
+    visited_event_count = 0;
+    callstack_data->ForEachCallstackEventInTimeRange(
+        kTimestamps[1], kTimestamps[2], [&](const CallstackEvent&) { ++visited_event_count; });
+    EXPECT_EQ(visited_event_count, 2);
+  };
+
+  expect_all_events();
+  callstack_data->OnCaptureComplete();
+  expect_all_events();
+
+  // Changing the type of the unique callstacks is still allowed.
+  callstack_data->UpdateCallstackTypeBasedOnMajorityStart({});
+  EXPECT_EQ(callstack_data->GetCallstack(kCallstackId1)->type(), CallstackType::kComplete);
+  expect_all_events();
+}
+
+TEST(CallstackData, CallstackIdCountsInTimeRangeAreTheSameAfterOnCaptureComplete) {
+  constexpr uint64_t kCallstackIdCount = 7;
+  // Enough events for several blocks, and a partial one at the end.
+  const uint64_t event_count = 3 * CallstackData::kCountsBlockSize + 1000;
+  auto get_timestamp = [](uint64_t index) { return 10 * index + 5; };
+  auto get_callstack_id = [](uint64_t index) { return (index * index) % kCallstackIdCount; };
+
+  CallstackData callstack_data;
+  for (uint64_t callstack_id = 0; callstack_id < kCallstackIdCount; ++callstack_id) {
+    callstack_data.AddUniqueCallstack(callstack_id,
+                                      CallstackInfo{{0x10}, CallstackType::kComplete});
+  }
+  for (uint64_t i = 0; i < event_count; ++i) {
+    callstack_data.AddCallstackEvent(CallstackEvent{get_timestamp(i), get_callstack_id(i), kTid});
+  }
+  callstack_data.AddCallstackEvent(CallstackEvent{get_timestamp(1), 1, kAnotherTid});
+
+  auto get_expected_counts = [&](uint64_t first_index, uint64_t last_index) {
+    absl::flat_hash_map<uint64_t, uint32_t> counts;
+    for (uint64_t i = first_index; i < last_index; ++i) ++counts[get_callstack_id(i)];
+    return counts;
+  };
+
+  const std::vector<std::pair<uint64_t, uint64_t>> index_ranges = {
+      {0, 0},
+      {0, event_count},
+      {3, 10},
+      {CallstackData::kCountsBlockSize - 1, CallstackData::kCountsBlockSize + 1},
+      {CallstackData::kCountsBlockSize, 2 * CallstackData::kCountsBlockSize},
+      {17, 3 * CallstackData::kCountsBlockSize + 5},
+      {CallstackData::kCountsBlockSize + 3, event_count}};
+  auto expect_counts = [&] {
+    for (const auto& [first_index, last_index] : index_ranges) {
+      SCOPED_TRACE(absl::StrFormat("[%u, %u)", first_index, last_index));
+      // Timestamps between events select the same events as the timestamps of the events.
+      EXPECT_EQ(callstack_data.GetCallstackIdToCountOfTidInTimeRange(
+                    kTid, get_timestamp(first_index), get_timestamp(last_index)),
+                get_expected_counts(first_index, last_index));
+      EXPECT_EQ(callstack_data.GetCallstackIdToCountOfTidInTimeRange(
+                    kTid, get_timestamp(first_index) - 1, get_timestamp(last_index) - 1),
+                get_expected_counts(first_index, last_index));
+    }
+
+    absl::flat_hash_map<uint32_t, absl::flat_hash_map<uint64_t, uint32_t>> thread_id_to_counts =
+        callstack_data.GetThreadIdToCallstackIdToCountInTimeRange(get_timestamp(1),
+                                                                  get_timestamp(10));
+    EXPECT_EQ(thread_id_to_counts.size(), 2);
+    EXPECT_EQ(thread_id_to_counts[kTid], get_expected_counts(1, 10));
+    EXPECT_EQ(thread_id_to_counts[kAnotherTid], (absl::flat_hash_map<uint64_t, uint32_t>{{1, 1}}));
+    EXPECT_EQ(callstack_data.GetThreadIdToCallstackIdToCountInTimeRange(get_timestamp(2),
+                                                                        get_timestamp(10))
+                  .size(),
+              1);
+    EXPECT_TRUE(callstack_data.GetCallstackIdToCountOfTidInTimeRange(44, 0, get_timestamp(10))
+                    .empty());
+  };
+
+  expect_counts();
+  callstack_data.OnCaptureComplete();
+  expect_counts();
+}
+
 struct ForEachCallstackEventOfTidInTimeRangeDiscretizedTestCase {
   std::string test_name;
   uint32_t tid;
@@ -259,16 +375,17 @@ using ForEachCallstackEventOfTidInTimeRangeDiscretizedTest =
 
 TEST_P(ForEachCallstackEventOfTidInTimeRangeDiscretizedTest, IterationIsCorrect) {
   const ForEachCallstackEventOfTidInTimeRangeDiscretizedTestCase& test_case = GetParam();
-  const CallstackData* callstack_data = kCallstackDataWithEvents.get();
-
-  std::vector<CallstackEvent> visited_callstack_list;
-  auto visit_callstack = [&](const CallstackEvent& event) {
-    visited_callstack_list.push_back(event);
-  };
-  callstack_data->ForEachCallstackEventOfTidInTimeRangeDiscretized(
-      test_case.tid, test_case.start_ns, test_case.end_ns, test_case.resolution, visit_callstack);
-  EXPECT_THAT(visited_callstack_list,
-              Pointwise(CallstackEventEq(), Slice(kAllEvents, test_case.expected_event_ids)));
+  for (const CallstackData* callstack_data :
+       {kCallstackDataWithEvents.get(), kFrozenCallstackDataWithEvents.get()}) {
+    std::vector<CallstackEvent> visited_callstack_list;
+    auto visit_callstack = [&](const CallstackEvent& event) {
+      visited_callstack_list.push_back(event);
+    };
+    callstack_data->ForEachCallstackEventOfTidInTimeRangeDiscretized(
+        test_case.tid, test_case.start_ns, test_case.end_ns, test_case.resolution, visit_callstack);
+    EXPECT_THAT(visited_callstack_list,
+                Pointwise(CallstackEventEq(), Slice(kAllEvents, test_case.expected_event_ids)));
+  }
 }
 
 constexpr uint64_t kStartNs = 0;
@@ -313,15 +430,16 @@ using ForEachCallstackEventInTimeRangeDiscretizedTest =
     TestWithParam<ForEachCallstackEventInTimeRangeDiscretizedTestCase>;
 TEST_P(ForEachCallstackEventInTimeRangeDiscretizedTest, IterationIsCorrect) {
   const ForEachCallstackEventInTimeRangeDiscretizedTestCase& test_case = GetParam();
-  const CallstackData* callstack_data = kCallstackDataWithEvents.get();
-
-  std::vector<CallstackEvent> visited_callstack_list;
-  auto visit_callstack = [&](const CallstackEvent& event) {
-    visited_callstack_list.push_back(event);
-  };
-  callstack_data->ForEachCallstackEventInTimeRangeDiscretized(
-      test_case.start_ns, test_case.end_ns, test_case.resolution, visit_callstack);
-  test_case.expect(visited_callstack_list, Slice(kAllEvents, test_case.expected_event_ids));
+  for (const CallstackData* callstack_data :
+       {kCallstackDataWithEvents.get(), kFrozenCallstackDataWithEvents.get()}) {
+    std::vector<CallstackEvent> visited_callstack_list;
+    auto visit_callstack = [&](const CallstackEvent& event) {
+      visited_callstack_list.push_back(event);
+    };
+    callstack_data->ForEachCallstackEventInTimeRangeDiscretized(
+        test_case.start_ns, test_case.end_ns, test_case.resolution, visit_callstack);
+    test_case.expect(visited_callstack_list, Slice(kAllEvents, test_case.expected_event_ids));
+  }
 }
 
 INSTANTIATE_TEST_SUITE_P(
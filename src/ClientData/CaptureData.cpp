@@ -6,9 +6,12 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/hash/hash.h>
+#include <stddef.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <memory>
@@ -23,6 +26,8 @@
 #include "ClientData/ScopeInfo.h"
 #include "ClientData/ScopeStatsCollection.h"
 #include "GrpcProtos/process.pb.h"
+#include "Introspection/Introspection.h"
+#include "OrbitBase/ParallelFor.h"
 #include "OrbitBase/ThreadConstants.h"
 #include "OrbitBase/Typedef.h"
 
@@ -70,57 +75,85 @@ CaptureData::CaptureData(CaptureStarted capture_started,
   }
 }
 
+bool CaptureData::HasThreadStatesForThread(uint32_t tid) const {
+  return VisitThreadStateSlices([tid](const ThreadStateSlicesByTid& thread_state_slices) {
+    return thread_state_slices.contains(tid);
+  });
+}
+
 void CaptureData::ForEachThreadStateSliceIntersectingTimeRange(
     uint32_t thread_id, uint64_t min_timestamp, uint64_t max_timestamp,
     const std::function<void(const ThreadStateSliceInfo&)>& action) const {
-  absl::MutexLock lock{&thread_state_slices_mutex_};
-  auto tid_thread_state_slices_it = thread_state_slices_.find(thread_id);
-  if (tid_thread_state_slices_it == thread_state_slices_.end()) {
-    return;
-  }
+  VisitThreadStateSlices([&](const ThreadStateSlicesByTid& thread_state_slices) {
+    auto tid_thread_state_slices_it = thread_state_slices.find(thread_id);
+    if (tid_thread_state_slices_it == thread_state_slices.end()) {
+      return;
+    }
+
+    const std::vector<ThreadStateSliceInfo>& tid_thread_state_slices =
+        tid_thread_state_slices_it->second;
+    auto slice_it = std::lower_bound(tid_thread_state_slices.begin(), tid_thread_state_slices.end(),
+                                     min_timestamp,
+                                     [](const ThreadStateSliceInfo& slice, uint64_t min_timestamp) {
+                                       return slice.end_timestamp_ns() < min_timestamp;
+                                     });
+    while (slice_it != tid_thread_state_slices.end() &&
+           slice_it->begin_timestamp_ns() < max_timestamp) {
+      action(*slice_it);
+      ++slice_it;
+    }
+  });
+}
 
-  const std::vector<ThreadStateSliceInfo>& tid_thread_state_slices =
-      tid_thread_state_slices_it->second;
-  auto slice_it = std::lower_bound(tid_thread_state_slices.begin(), tid_thread_state_slices.end(),
-                                   min_timestamp,
-                                   [](const ThreadStateSliceInfo& slice, uint64_t min_timestamp) {
-                                     return slice.end_timestamp_ns() < min_timestamp;
-                                   });
-  while (slice_it != tid_thread_state_slices.end() &&
-         slice_it->begin_timestamp_ns() < max_timestamp) {
-    action(*slice_it);
-    ++slice_it;
+void CaptureData::ForEachThreadStateSlice(
+    const std::function<void(const ThreadStateSliceInfo&)>& action) const {
+  VisitThreadStateSlices([&](const ThreadStateSlicesByTid& thread_state_slices) {
+    for (const auto& [unused_tid, tid_thread_state_slices] : thread_state_slices) {
+      for (const ThreadStateSliceInfo& slice : tid_thread_state_slices) action(slice);
+    }
+  });
+}
+
+void CaptureData::ForEachOffCpuTimeSummary(
+    const std::function<void(const orbit_grpc_protos::OffCpuTimeSummary&)>& action) const {
+  absl::MutexLock lock{&off_cpu_time_summaries_mutex_};
+  for (const orbit_grpc_protos::OffCpuTimeSummary& off_cpu_time_summary :
+       off_cpu_time_summaries_) {
+    action(off_cpu_time_summary);
   }
 }
 
 void CaptureData::ForEachThreadStateSliceIntersectingTimeRangeDiscretized(
     uint32_t thread_id, uint64_t min_timestamp, uint64_t max_timestamp, uint32_t resolution,
     const std::function<void(const ThreadStateSliceInfo&)>& action) const {
-  absl::MutexLock lock{&thread_state_slices_mutex_};
-  auto tid_thread_state_slices_it = thread_state_slices_.find(thread_id);
-  if (tid_thread_state_slices_it == thread_state_slices_.end()) {
-    return;
-  }
+  VisitThreadStateSlices([&](const ThreadStateSlicesByTid& thread_state_slices) {
+    auto tid_thread_state_slices_it = thread_state_slices.find(thread_id);
+    if (tid_thread_state_slices_it == thread_state_slices.end()) {
+      return;
+    }
 
-  const std::vector<ThreadStateSliceInfo>& tid_thread_state_slices =
-      tid_thread_state_slices_it->second;
-
-  auto thread_state_slices_lower_bound = [&](uint64_t timestamp) {
-    return std::lower_bound(tid_thread_state_slices.begin(), tid_thread_state_slices.end(),
-                            timestamp, [](const ThreadStateSliceInfo& slice, uint64_t timestamp) {
-                              return timestamp >= slice.end_timestamp_ns();
-                            });
-  };
-
-  uint64_t current_timestamp = min_timestamp;
-  auto slice_it = thread_state_slices_lower_bound(current_timestamp);
-  while (slice_it != tid_thread_state_slices.end() &&
-         slice_it->begin_timestamp_ns() < max_timestamp) {
-    action(*slice_it);
-    current_timestamp = GetNextPixelBoundaryTimeNs(slice_it->end_timestamp_ns(), resolution,
-                                                   min_timestamp, max_timestamp);
-    slice_it = thread_state_slices_lower_bound(current_timestamp);
-  }
+    const std::vector<ThreadStateSliceInfo>& tid_thread_state_slices =
+        tid_thread_state_slices_it->second;
+
+    // The slices are sorted, so each search only needs to look after the previous slice.
+    auto thread_state_slices_lower_bound = [&](auto first, uint64_t timestamp) {
+      return std::lower_bound(first, tid_thread_state_slices.end(), timestamp,
+                              [](const ThreadStateSliceInfo& slice, uint64_t timestamp) {
+                                return timestamp >= slice.end_timestamp_ns();
+                              });
+    };
+
+    uint64_t current_timestamp = min_timestamp;
+    auto slice_it = thread_state_slices_lower_bound(tid_thread_state_slices.begin(),
+                                                    current_timestamp);
+    while (slice_it != tid_thread_state_slices.end() &&
+           slice_it->begin_timestamp_ns() < max_timestamp) {
+      action(*slice_it);
+      current_timestamp = GetNextPixelBoundaryTimeNs(slice_it->end_timestamp_ns(), resolution,
+                                                     min_timestamp, max_timestamp);
+      slice_it = thread_state_slices_lower_bound(std::next(slice_it), current_timestamp);
+    }
+  });
 }
 
 const ScopeStats& CaptureData::GetScopeStatsOrDefault(ScopeId scope_id) const {
@@ -139,8 +172,36 @@ void CaptureData::AddScopeStats(ScopeId scope_id, ScopeStats stats) {
 }
 
 void CaptureData::OnCaptureComplete() {
-  thread_track_data_provider_->OnCaptureComplete();
-  all_scopes_->OnCaptureComplete();
+  ORBIT_SCOPE_FUNCTION;
+  {
+    absl::MutexLock lock{&thread_state_slices_mutex_};
+    if (!thread_state_slices_are_frozen_.load(std::memory_order_relaxed)) {
+      frozen_thread_state_slices_ = std::move(thread_state_slices_);
+      thread_state_slices_.clear();
+      thread_state_slices_are_frozen_.store(true, std::memory_order_release);
+    }
+  }
+
+  // The structures are finalized independently of each other, so they are finalized concurrently.
+  const std::array<std::function<void()>, 5> finalizers = {
+      [this] {
+        ORBIT_SCOPE("CallstackData::OnCaptureComplete");
+        callstack_data_.OnCaptureComplete();
+      },
+      [this] {
+        ORBIT_SCOPE("PageFaultCallstackData::OnCaptureComplete");
+        page_fault_callstack_data_.OnCaptureComplete();
+      },
+      [this] {
+        ORBIT_SCOPE("TracepointData::OnCaptureComplete");
+        tracepoint_data_.OnCaptureComplete();
+      },
+      [this] {
+        ORBIT_SCOPE("ThreadTrackDataProvider::OnCaptureComplete");
+        thread_track_data_provider_->OnCaptureComplete();
+      },
+      [this] { all_scopes_->OnCaptureComplete(); }};
+  orbit_base::ParallelFor(finalizers.size(), [&finalizers](size_t index) { finalizers[index](); });
 }
 
 void CaptureData::FilterBrokenCallstacks() {
@@ -274,6 +335,26 @@ std::optional<ScopeId> CaptureData::FunctionIdToScopeId(uint64_t function_id) co
   return scope_id_provider_->FunctionIdToScopeId(function_id);
 }
 
+uint64_t CaptureData::GetMemoryUsageBytes() const {
+  uint64_t memory_usage_bytes = timer_data_manager_.GetMemoryUsageBytes() +
+                                thread_track_data_provider_->GetMemoryUsageBytes() +
+                                callstack_data_.GetMemoryUsageBytes();
+  // The unique callstacks of page_fault_callstack_data_ are shared with callstack_data_.
+  memory_usage_bytes +=
+      uint64_t{page_fault_callstack_data_.GetCallstackEventsCount()} * sizeof(CallstackEvent);
+  VisitThreadStateSlices([&](const ThreadStateSlicesByTid& thread_state_slices) {
+    for (const auto& [unused_tid, slices] : thread_state_slices) {
+      memory_usage_bytes += slices.capacity() * sizeof(ThreadStateSliceInfo);
+    }
+  });
+  {
+    absl::MutexLock lock{&off_cpu_time_summaries_mutex_};
+    memory_usage_bytes += off_cpu_time_summaries_.capacity() *
+                          sizeof(orbit_grpc_protos::OffCpuTimeSummary);
+  }
+  return memory_usage_bytes;
+}
+
 uint64_t CaptureData::ScopeIdToFunctionId(ScopeId scope_id) const {
   ORBIT_CHECK(scope_id_provider_);
   return scope_id_provider_->ScopeIdToFunctionId(scope_id);
@@ -350,24 +431,27 @@ std::unique_ptr<const ScopeStatsCollection> CaptureData::CreateScopeStatsCollect
 
 [[nodiscard]] std::optional<ThreadStateSliceInfo>
 CaptureData::FindThreadStateSliceInfoFromTimestamp(int64_t thread_id, uint64_t timestamp) const {
-  absl::MutexLock lock{&thread_state_slices_mutex_};
-  if (!thread_state_slices_.contains(thread_id)) {
-    return std::nullopt;
-  }
+  return VisitThreadStateSlices([&](const ThreadStateSlicesByTid& thread_state_slices)
+                                    -> std::optional<ThreadStateSliceInfo> {
+    auto tid_thread_state_slices_it = thread_state_slices.find(thread_id);
+    if (tid_thread_state_slices_it == thread_state_slices.end()) {
+      return std::nullopt;
+    }
 
-  const std::vector<ThreadStateSliceInfo>& thread_state_bar = thread_state_slices_.at(thread_id);
-  auto slice = std::upper_bound(
-      thread_state_bar.begin(), thread_state_bar.end(), timestamp,
-      [](uint64_t a,
-         const ThreadStateSliceInfo& b) -> bool {  // compare based on ending timestamps
-        return a < b.end_timestamp_ns();
-      });
+    const std::vector<ThreadStateSliceInfo>& thread_state_bar = tid_thread_state_slices_it->second;
+    auto slice = std::upper_bound(
+        thread_state_bar.begin(), thread_state_bar.end(), timestamp,
+        [](uint64_t a,
+           const ThreadStateSliceInfo& b) -> bool {  // compare based on ending timestamps
+          return a < b.end_timestamp_ns();
+        });
 
-  if (slice == thread_state_bar.end() || timestamp < slice->begin_timestamp_ns()) {
-    return std::nullopt;
-  }
+    if (slice == thread_state_bar.end() || timestamp < slice->begin_timestamp_ns()) {
+      return std::nullopt;
+    }
 
-  return *slice;
+    return *slice;
+  });
 }
 
 }  // namespace orbit_client_data
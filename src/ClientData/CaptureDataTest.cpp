@@ -38,8 +38,10 @@
 #include "OrbitBase/Typedef.h"
 #include "Test/Path.h"
 
+using testing::ElementsAre;
 using testing::ElementsAreArray;
 using testing::Optional;
+using testing::UnorderedElementsAre;
 using ::testing::ValuesIn;
 using ::testing::WithParamInterface;
 
@@ -409,4 +411,68 @@ TEST_F(CaptureDataTest, FindThreadStateSliceInfoFromTimestamp) {
             std::nullopt);
 }
 
-}  // namespace orbit_client_data
\ No newline at end of file
+TEST_F(CaptureDataTest, ThreadStateSlicesAreTheSameAfterCaptureComplete) {
+  capture_data_.AddThreadStateSlice(kSlice1);
+  capture_data_.AddThreadStateSlice(kSlice2);
+  capture_data_.AddThreadStateSlice(kSlice3);
+  capture_data_.AddThreadStateSlice(kSlice4);
+  capture_data_.OnCaptureComplete();
+
+  EXPECT_TRUE(capture_data_.HasThreadStatesForThread(kFirstTid));
+  EXPECT_FALSE(capture_data_.HasThreadStatesForThread(kNonExistingTid));
+
+  std::vector<ThreadStateSliceInfo> visited_slices;
+  capture_data_.ForEachThreadStateSliceIntersectingTimeRange(
+      kFirstTid, kMidSlice1Timestamp, kMidSlice2Timestamp,
+      [&](const ThreadStateSliceInfo& slice) { visited_slices.push_back(slice); });
+  EXPECT_THAT(visited_slices, ElementsAreArray({kSlice1, kSlice2}));
+
+  visited_slices.clear();
+  capture_data_.ForEachThreadStateSliceIntersectingTimeRangeDiscretized(
+      kFirstTid, kStartTimestamp1, kEndTimestamp3, /*resolution=*/1,
+      [&](const ThreadStateSliceInfo& slice) { visited_slices.push_back(slice); });
+  EXPECT_THAT(visited_slices, ElementsAreArray({kSlice1}));
+
+  EXPECT_THAT(capture_data_.FindThreadStateSliceInfoFromTimestamp(kFirstTid, kMidSlice3Timestamp),
+              Optional(kSlice3));
+  EXPECT_THAT(capture_data_.FindThreadStateSliceInfoFromTimestamp(kSecondTid, kMidSlice1Timestamp),
+              Optional(kSlice4));
+  EXPECT_EQ(capture_data_.FindThreadStateSliceInfoFromTimestamp(kSecondTid, kInvalidTimestamp1),
+            std::nullopt);
+}
+
+TEST_F(CaptureDataTest, ForEachThreadStateSliceVisitsTheSlicesOfAllThreads) {
+  capture_data_.AddThreadStateSlice(kSlice1);
+  capture_data_.AddThreadStateSlice(kSlice2);
+  capture_data_.AddThreadStateSlice(kSlice4);
+
+  std::vector<ThreadStateSliceInfo> visited_slices;
+  auto visit_slice = [&](const ThreadStateSliceInfo& slice) { visited_slices.push_back(slice); };
+  capture_data_.ForEachThreadStateSlice(visit_slice);
+  EXPECT_THAT(visited_slices, UnorderedElementsAre(kSlice1, kSlice2, kSlice4));
+
+  visited_slices.clear();
+  capture_data_.OnCaptureComplete();
+  capture_data_.ForEachThreadStateSlice(visit_slice);
+  EXPECT_THAT(visited_slices, UnorderedElementsAre(kSlice1, kSlice2, kSlice4));
+}
+
+TEST_F(CaptureDataTest, ForEachOffCpuTimeSummaryVisitsTheAddedSummaries) {
+  orbit_grpc_protos::OffCpuTimeSummary summary1;
+  summary1.set_tid(kFirstTid);
+  summary1.set_callstack_id(1);
+  summary1.set_total_duration_ns(100);
+  orbit_grpc_protos::OffCpuTimeSummary summary2 = summary1;
+  summary2.set_callstack_id(2);
+  capture_data_.AddOffCpuTimeSummary(summary1);
+  capture_data_.AddOffCpuTimeSummary(summary2);
+
+  std::vector<uint64_t> visited_callstack_ids;
+  capture_data_.ForEachOffCpuTimeSummary(
+      [&](const orbit_grpc_protos::OffCpuTimeSummary& off_cpu_time_summary) {
+        visited_callstack_ids.push_back(off_cpu_time_summary.callstack_id());
+      });
+  EXPECT_THAT(visited_callstack_ids, ElementsAre(1, 2));
+}
+
+}  // namespace orbit_client_data
@@ -0,0 +1,85 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/CompactTimerBlock.h"
+
+#include <algorithm>
+
+using orbit_client_protos::TimerInfo;
+
+namespace orbit_client_data {
+
+namespace {
+
+// Clearing the fields that have columns, rather than testing the others, keeps this correct when
+// fields are added to TimerInfo.
+[[nodiscard]] bool HasRareFields(const TimerInfo& timer_info) {
+  TimerInfo rare_fields = timer_info;
+  rare_fields.clear_start();
+  rare_fields.clear_end();
+  rare_fields.clear_process_id();
+  rare_fields.clear_thread_id();
+  rare_fields.clear_processor();
+  rare_fields.clear_function_id();
+  rare_fields.clear_depth();
+  rare_fields.clear_type();
+  return rare_fields.ByteSizeLong() != 0;
+}
+
+}  // namespace
+
+CompactTimerBlock::CompactTimerBlock() {
+  starts_.reserve(kCapacity);
+  ends_.reserve(kCapacity);
+  function_ids_.reserve(kCapacity);
+  process_ids_.reserve(kCapacity);
+  thread_ids_.reserve(kCapacity);
+  depths_.reserve(kCapacity);
+  processors_.reserve(kCapacity);
+  types_.reserve(kCapacity);
+}
+
+void CompactTimerBlock::Add(const TimerInfo& timer_info) {
+  ORBIT_CHECK(!at_capacity());
+  // TimerInfo::Type has a handful of values, which fit the column.
+  ORBIT_CHECK(timer_info.type() >= 0 && timer_info.type() <= std::numeric_limits<uint8_t>::max());
+
+  if (HasRareFields(timer_info)) {
+    timers_with_rare_fields_.emplace(static_cast<uint32_t>(size()), timer_info);
+  }
+  starts_.push_back(timer_info.start());
+  ends_.push_back(timer_info.end());
+  function_ids_.push_back(timer_info.function_id());
+  process_ids_.push_back(timer_info.process_id());
+  thread_ids_.push_back(timer_info.thread_id());
+  depths_.push_back(timer_info.depth());
+  processors_.push_back(timer_info.processor());
+  types_.push_back(static_cast<uint8_t>(timer_info.type()));
+
+  min_timestamp_ = std::min(timer_info.start(), min_timestamp_);
+  max_timestamp_ = std::max(timer_info.end(), max_timestamp_);
+}
+
+TimerInfo CompactTimerBlock::GetTimerInfo(size_t index) const {
+  ORBIT_CHECK(index < size());
+  auto it = timers_with_rare_fields_.find(static_cast<uint32_t>(index));
+  if (it != timers_with_rare_fields_.end()) return it->second;
+
+  TimerInfo timer_info;
+  timer_info.set_start(starts_[index]);
+  timer_info.set_end(ends_[index]);
+  timer_info.set_function_id(function_ids_[index]);
+  timer_info.set_process_id(process_ids_[index]);
+  timer_info.set_thread_id(thread_ids_[index]);
+  timer_info.set_depth(depths_[index]);
+  timer_info.set_processor(processors_[index]);
+  timer_info.set_type(GetType(index));
+  return timer_info;
+}
+
+size_t CompactTimerBlock::LowerBound(uint64_t min_ns) const {
+  return std::lower_bound(ends_.begin(), ends_.end(), min_ns) - ends_.begin();
+}
+
+}  // namespace orbit_client_data
@@ -0,0 +1,85 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "ClientData/CompactTimerBlock.h"
+#include "ClientProtos/capture_data.pb.h"
+
+using orbit_client_protos::TimerInfo;
+
+namespace orbit_client_data {
+
+namespace {
+
+[[nodiscard]] TimerInfo MakeTimer(uint64_t start, uint64_t end) {
+  TimerInfo timer_info;
+  timer_info.set_start(start);
+  timer_info.set_end(end);
+  timer_info.set_process_id(41);
+  timer_info.set_thread_id(42);
+  timer_info.set_function_id(43);
+  timer_info.set_depth(2);
+  timer_info.set_type(TimerInfo::kCoreActivity);
+  return timer_info;
+}
+
+}  // namespace
+
+TEST(CompactTimerBlock, StoresColumnsAndMaterializesTimerInfos) {
+  CompactTimerBlock block;
+  EXPECT_EQ(block.size(), 0);
+
+  const TimerInfo first_timer = MakeTimer(100, 200);
+  TimerInfo second_timer = MakeTimer(150, 300);
+  second_timer.set_callstack_id(7);
+  second_timer.add_registers(1);
+  second_timer.set_api_scope_name("scope");
+  block.Add(first_timer);
+  block.Add(second_timer);
+
+  ASSERT_EQ(block.size(), 2);
+  EXPECT_EQ(block.GetStart(0), 100);
+  EXPECT_EQ(block.GetEnd(0), 200);
+  EXPECT_EQ(block.GetThreadId(0), 42);
+  EXPECT_EQ(block.GetFunctionId(0), 43);
+  EXPECT_EQ(block.GetDepth(0), 2);
+  EXPECT_EQ(block.GetType(0), TimerInfo::kCoreActivity);
+  EXPECT_EQ(block.GetStart(1), 150);
+  EXPECT_EQ(block.GetEnd(1), 300);
+
+  EXPECT_EQ(block.GetTimerInfo(0).SerializeAsString(), first_timer.SerializeAsString());
+  EXPECT_EQ(block.GetTimerInfo(1).SerializeAsString(), second_timer.SerializeAsString());
+
+  EXPECT_EQ(block.MinTimestamp(), 100);
+  EXPECT_TRUE(block.Intersects(300, 400));
+  EXPECT_TRUE(block.Intersects(0, 100));
+  EXPECT_FALSE(block.Intersects(301, 400));
+  EXPECT_FALSE(block.Intersects(0, 99));
+}
+
+TEST(CompactTimerBlock, LowerBound) {
+  CompactTimerBlock block;
+  block.Add(MakeTimer(0, 10));
+  block.Add(MakeTimer(10, 20));
+  block.Add(MakeTimer(20, 30));
+
+  EXPECT_EQ(block.LowerBound(0), 0);
+  EXPECT_EQ(block.LowerBound(10), 0);
+  EXPECT_EQ(block.LowerBound(11), 1);
+  EXPECT_EQ(block.LowerBound(30), 2);
+  EXPECT_EQ(block.LowerBound(31), 3);
+}
+
+TEST(CompactTimerBlock, AtCapacity) {
+  CompactTimerBlock block;
+  for (size_t i = 0; i < CompactTimerBlock::kCapacity; ++i) {
+    EXPECT_FALSE(block.at_capacity());
+    block.Add(MakeTimer(i, i + 1));
+  }
+  EXPECT_TRUE(block.at_capacity());
+}
+
+}  // namespace orbit_client_data
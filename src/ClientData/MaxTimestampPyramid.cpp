@@ -0,0 +1,75 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/MaxTimestampPyramid.h"
+
+#include <algorithm>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_client_data {
+
+void MaxTimestampPyramid::Append(uint64_t timestamp_ns) {
+  levels_[0]->push_back(timestamp_ns);
+
+  // The timestamps containing the new one are the last ones of each level. A level gets a new last
+  // timestamp when the one below starts a new run of kFanout.
+  size_t num_levels = num_levels_.load(std::memory_order_relaxed);
+  for (size_t level = 0; levels_[level]->size() > 1; ++level) {
+    if (level + 1 == num_levels) {
+      ORBIT_CHECK(num_levels < kMaxLevels);
+      // The new level's first timestamp also covers the first timestamp of the level below.
+      levels_[level + 1] = std::make_unique<Level>();
+      levels_[level + 1]->push_back(Get(level, 0));
+      num_levels_.store(++num_levels, std::memory_order_release);
+    }
+    Level& parents = *levels_[level + 1];
+    const size_t parent_index = (levels_[level]->size() - 1) / kFanout;
+    if (parent_index == parents.size()) {
+      parents.push_back(timestamp_ns);
+    } else {
+      Raise(parents[parent_index], timestamp_ns);
+    }
+  }
+}
+
+void MaxTimestampPyramid::RaiseLast(uint64_t timestamp_ns) {
+  ORBIT_CHECK(size() > 0);
+  const size_t num_levels = num_levels_.load(std::memory_order_relaxed);
+  for (size_t level = 0; level < num_levels; ++level) {
+    Raise(levels_[level]->back(), timestamp_ns);
+  }
+}
+
+size_t MaxTimestampPyramid::FindFirstAtLeast(uint64_t min_timestamp_ns, size_t first_index) const {
+  const size_t num_timestamps = size();
+  if (first_index >= num_timestamps) return num_timestamps;
+  const size_t num_levels = num_levels_.load(std::memory_order_acquire);
+
+  // Move right, and up whenever a run of kFanout timestamps is left, until a timestamp is large
+  // enough. All timestamps covered by the ones visited are at or after `first_index`.
+  size_t level = 0;
+  size_t index = first_index;
+  while (Get(level, index) < min_timestamp_ns) {
+    ++index;
+    while (index % kFanout == 0 && level + 1 < num_levels) {
+      index /= kFanout;
+      ++level;
+    }
+    if (index >= levels_[level]->size()) return num_timestamps;
+  }
+
+  // Move down to the first timestamp of level 0 that is large enough. The bounds only matter if
+  // timestamps are appended concurrently.
+  while (level > 0) {
+    --level;
+    index *= kFanout;
+    const size_t level_size = levels_[level]->size();
+    while (index < level_size && Get(level, index) < min_timestamp_ns) ++index;
+    if (index >= level_size) return num_timestamps;
+  }
+  return std::min(index, num_timestamps);
+}
+
+}  // namespace orbit_client_data
@@ -0,0 +1,77 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "ClientData/MaxTimestampPyramid.h"
+
+namespace orbit_client_data {
+
+namespace {
+
+size_t FindFirstAtLeastLinearly(const std::vector<uint64_t>& timestamps, uint64_t min_timestamp_ns,
+                                size_t first_index) {
+  for (size_t i = first_index; i < timestamps.size(); ++i) {
+    if (timestamps[i] >= min_timestamp_ns) return i;
+  }
+  return timestamps.size();
+}
+
+}  // namespace
+
+TEST(MaxTimestampPyramid, EmptyFindsNothing) {
+  MaxTimestampPyramid pyramid;
+  EXPECT_EQ(pyramid.size(), 0);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(0, 0), 0);
+}
+
+TEST(MaxTimestampPyramid, FindFirstAtLeast) {
+  MaxTimestampPyramid pyramid;
+  pyramid.Append(10);
+  pyramid.Append(20);
+  pyramid.RaiseLast(30);
+  pyramid.RaiseLast(25);
+  pyramid.Append(15);
+
+  EXPECT_EQ(pyramid.size(), 3);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(5, 0), 0);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(10, 0), 0);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(11, 0), 1);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(30, 0), 1);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(31, 0), 3);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(5, 2), 2);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(16, 2), 3);
+  EXPECT_EQ(pyramid.FindFirstAtLeast(5, 3), 3);
+}
+
+TEST(MaxTimestampPyramid, FindFirstAtLeastIsTheSameAsLinearSearchOverManyLevels) {
+  constexpr size_t kCount = MaxTimestampPyramid::kFanout * MaxTimestampPyramid::kFanout * 3 + 5;
+  MaxTimestampPyramid pyramid;
+  std::vector<uint64_t> timestamps;
+  for (size_t i = 0; i < kCount; ++i) {
+    // Mostly increasing, with some dips, like the end timestamps of blocks of overlapping timers.
+    const uint64_t timestamp_ns = 10 * i + (i % 7 == 0 ? 100 : 0) - (i % 5 == 0 ? 9 : 0) + 9;
+    timestamps.push_back(timestamp_ns);
+    pyramid.Append(timestamp_ns - 1);
+    pyramid.RaiseLast(timestamp_ns);
+  }
+  ASSERT_EQ(pyramid.size(), kCount);
+
+  const uint64_t max_timestamp_ns = *std::max_element(timestamps.begin(), timestamps.end());
+  for (uint64_t min_timestamp_ns = 0; min_timestamp_ns <= max_timestamp_ns + 1;
+       min_timestamp_ns += 3) {
+    for (size_t first_index : {size_t{0}, size_t{1}, size_t{15}, size_t{16}, size_t{300}, kCount}) {
+      EXPECT_EQ(pyramid.FindFirstAtLeast(min_timestamp_ns, first_index),
+                FindFirstAtLeastLinearly(timestamps, min_timestamp_ns, first_index))
+          << "min_timestamp_ns: " << min_timestamp_ns << ", first_index: " << first_index;
+    }
+  }
+}
+
+}  // namespace orbit_client_data
@@ -134,7 +134,7 @@ bool ModuleData::UpdateIfChangedAndUnload(ModuleInfo new_module_info) {
   ORBIT_LOG("Module %s contained symbols. Because the module changed, those are now removed.",
             module_info_.file_path());
   functions_.clear();
-  absolute_address_to_function_info_cache_.clear();
+  UpdateFunctionIndex();
   hash_to_function_map_.clear();
   name_to_function_info_map_.clear();
   loaded_symbols_completeness_ = SymbolCompleteness::kNoSymbols;
@@ -162,38 +162,28 @@ bool ModuleData::UpdateIfChangedAndNotLoaded(orbit_grpc_protos::ModuleInfo new_m
 
 const FunctionInfo* ModuleData::FindFunctionByVirtualAddress(uint64_t virtual_address,
                                                              bool is_exact) const {
-  absl::MutexLock lock(&mutex_);
-  if (functions_.empty()) return nullptr;
-
-  auto cache_it = absolute_address_to_function_info_cache_.find(virtual_address);
-  if (cache_it != absolute_address_to_function_info_cache_.end()) {
-    return cache_it->second;
-  }
-
-  if (is_exact) {
-    auto it = functions_.find(virtual_address);
-    FunctionInfo* result = (it != functions_.end()) ? it->second.get() : nullptr;
-    absolute_address_to_function_info_cache_.emplace(virtual_address, result);
-    return result;
-  }
-
-  auto it = functions_.upper_bound(virtual_address);
-  if (it == functions_.begin()) {
-    absolute_address_to_function_info_cache_.emplace(virtual_address, nullptr);
-    return nullptr;
-  }
+  const std::shared_ptr<const FunctionIndex> function_index = GetFunctionIndex();
+  const FunctionInfo* const* function = is_exact ? function_index->FindExact(virtual_address)
+                                                 : function_index->Find(virtual_address);
+  return function != nullptr ? *function : nullptr;
+}
 
-  --it;
-  FunctionInfo* function = it->second.get();
-  ORBIT_CHECK(function->address() <= virtual_address);
+std::shared_ptr<const ModuleData::FunctionIndex> ModuleData::GetFunctionIndex() const {
+  return std::atomic_load(&function_index_);
+}
 
-  if (function->address() + function->size() < virtual_address) {
-    absolute_address_to_function_info_cache_.emplace(virtual_address, nullptr);
-    return nullptr;
+void ModuleData::UpdateFunctionIndex() {
+  mutex_.AssertHeld();
+  std::vector<FunctionIndex::Entry> entries;
+  entries.reserve(functions_.size());
+  for (const auto& [address, function] : functions_) {
+    // The address right after the end of a function is considered part of it, as that is the
+    // return address of a call at the very end of the function, e.g., to a noreturn function.
+    entries.push_back({address, address + function->size() + 1, function.get()});
   }
-
-  absolute_address_to_function_info_cache_.emplace(virtual_address, function);
-  return function;
+  std::atomic_store(&function_index_,
+                    std::shared_ptr<const FunctionIndex>{
+                        std::make_shared<const FunctionIndex>(std::move(entries))});
 }
 
 const FunctionInfo* ModuleData::FindFunctionFromHash(uint64_t hash) const {
@@ -250,7 +240,6 @@ void ModuleData::AddSymbolsInternal(const orbit_grpc_protos::ModuleSymbols& modu
   mutex_.AssertHeld();
   ORBIT_CHECK(loaded_symbols_completeness_ < completeness);
   functions_.clear();
-  absolute_address_to_function_info_cache_.clear();
   hash_to_function_map_.clear();
   name_to_function_info_map_.clear();
 
@@ -295,6 +284,7 @@ void ModuleData::AddSymbolsInternal(const orbit_grpc_protos::ModuleSymbols& modu
         name_reuse_counter, module_info_.name());
   }
 
+  UpdateFunctionIndex();
   loaded_symbols_completeness_ = completeness;
 }
 
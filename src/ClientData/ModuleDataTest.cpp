@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 #include <stdint.h>
 
+#include <memory>
 #include <vector>
 
 #include "ClientData/FunctionInfo.h"
@@ -180,6 +181,42 @@ TEST(ModuleData, FindFunctionFromHash) {
   }
 }
 
+TEST(ModuleData, FindFunctionByVirtualAddress) {
+  ModuleSymbols symbols;
+  SymbolInfo* first_symbol = symbols.add_symbol_infos();
+  first_symbol->set_demangled_name("first");
+  first_symbol->set_address(0x1000);
+  first_symbol->set_size(0x100);
+  SymbolInfo* second_symbol = symbols.add_symbol_infos();
+  second_symbol->set_demangled_name("second");
+  second_symbol->set_address(0x2000);
+  second_symbol->set_size(0x10);
+
+  ModuleData module{ModuleInfo{}};
+  EXPECT_EQ(module.FindFunctionByVirtualAddress(0x1000, false), nullptr);
+  module.AddSymbols(symbols);
+
+  const FunctionInfo* first = module.FindFunctionByVirtualAddress(0x1000, true);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first->pretty_name(), "first");
+  EXPECT_EQ(module.FindFunctionByVirtualAddress(0x1001, true), nullptr);
+  EXPECT_EQ(module.FindFunctionByVirtualAddress(0x0fff, false), nullptr);
+  EXPECT_EQ(module.FindFunctionByVirtualAddress(0x1080, false), first);
+  EXPECT_EQ(module.FindFunctionByVirtualAddress(0x1100, false), first);
+  EXPECT_EQ(module.FindFunctionByVirtualAddress(0x1101, false), nullptr);
+
+  std::shared_ptr<const ModuleData::FunctionIndex> function_index = module.GetFunctionIndex();
+  ASSERT_EQ(function_index->size(), 2);
+  const std::vector<uint64_t> addresses{0x1000, 0x1500, 0x2008};
+  std::vector<const FunctionInfo* const*> results(addresses.size());
+  function_index->FindBatch(addresses, absl::MakeSpan(results));
+  ASSERT_NE(results[0], nullptr);
+  EXPECT_EQ(*results[0], first);
+  EXPECT_EQ(results[1], nullptr);
+  ASSERT_NE(results[2], nullptr);
+  EXPECT_EQ((*results[2])->pretty_name(), "second");
+}
+
 TEST(ModuleData, UpdateIfChangedAndUnload) {
   constexpr const char* kName = "Example Name";
   constexpr const char* kFilePath = "/test/file/path";
@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -27,6 +28,7 @@ std::vector<ModuleData*> ModuleManager::AddOrUpdateModules(
   absl::MutexLock lock(&mutex_);
 
   std::vector<ModuleData*> unloaded_modules;
+  bool modules_added = false;
 
   for (const auto& module_info : module_infos) {
     ModulePathAndBuildId module_path_and_build_id{.module_path = module_info.file_path(),
@@ -46,9 +48,12 @@ std::vector<ModuleData*> ModuleManager::AddOrUpdateModules(
       bool success =
           module_map_.try_emplace(module_id, std::make_unique<ModuleData>(module_info)).second;
       ORBIT_CHECK(success);
+      modules_added = true;
     }
   }
 
+  if (modules_added) UpdateModuleTable();
+
   return unloaded_modules;
 }
 
@@ -57,6 +62,7 @@ std::vector<ModuleData*> ModuleManager::AddOrUpdateNotLoadedModules(
   absl::MutexLock lock(&mutex_);
 
   std::vector<ModuleData*> not_updated_modules;
+  bool modules_added = false;
 
   for (const auto& module_info : module_infos) {
     ModulePathAndBuildId module_path_and_build_id{.module_path = module_info.file_path(),
@@ -77,123 +83,113 @@ std::vector<ModuleData*> ModuleManager::AddOrUpdateNotLoadedModules(
       bool success =
           module_map_.try_emplace(module_id, std::make_unique<ModuleData>(module_info)).second;
       ORBIT_CHECK(success);
+      modules_added = true;
     }
   }
 
+  if (modules_added) UpdateModuleTable();
+
   return not_updated_modules;
 }
 
-const ModuleData* ModuleManager::GetModuleByModuleInMemoryAndAbsoluteAddress(
-    const ModuleInMemory& module_in_memory, uint64_t absolute_address) const {
-  absl::MutexLock lock(&mutex_);
-  auto cache_it = absolute_address_to_module_data_cache_.find(absolute_address);
-  if (cache_it != absolute_address_to_module_data_cache_.end()) {
-    return cache_it->second;
-  }
-  auto it = module_map_.find(module_in_memory.module_id());
-  if (it == module_map_.end()) {
-    absolute_address_to_module_data_cache_.emplace(absolute_address, nullptr);
-    return nullptr;
+void ModuleManager::UpdateModuleTable() {
+  mutex_.AssertHeld();
+  ModuleTable module_table;
+  module_table.reserve(module_map_.size());
+  for (const auto& [module_id, module_data] : module_map_) {
+    module_table.emplace(module_id, module_data.get());
   }
+  std::atomic_store(&module_table_, std::make_shared<const ModuleTable>(std::move(module_table)));
+}
 
-  // The valid absolute address should be >=
-  // module_base_address + (executable_segment_offset % kPageSize)
-  if (absolute_address < module_in_memory.start() + (it->second->executable_segment_offset() %
-                                                     orbit_module_utils::kPageSize)) {
-    absolute_address_to_module_data_cache_.emplace(absolute_address, nullptr);
-    return nullptr;
-  }
+std::shared_ptr<const ModuleManager::ModuleTable> ModuleManager::GetModuleTable() const {
+  return std::atomic_load(&module_table_);
+}
 
-  ModuleData* result = it->second.get();
-  absolute_address_to_module_data_cache_.emplace(absolute_address, result);
-  return result;
+ModuleData* ModuleManager::FindModuleByModuleIdentifier(ModuleIdentifier module_id) const {
+  const std::shared_ptr<const ModuleTable> module_table = GetModuleTable();
+  auto it = module_table->find(module_id);
+  if (it == module_table->end()) return nullptr;
+
+  return it->second;
 }
 
-ModuleData* ModuleManager::GetMutableModuleByModuleInMemoryAndAbsoluteAddress(
-    const ModuleInMemory& module_in_memory, uint64_t absolute_address) {
-  absl::MutexLock lock(&mutex_);
+ModuleData* ModuleManager::FindModuleByModuleInMemoryAndAbsoluteAddress(
+    const ModuleInMemory& module_in_memory, uint64_t absolute_address) const {
+  absl::MutexLock lock(&absolute_address_cache_mutex_);
   auto cache_it = absolute_address_to_module_data_cache_.find(absolute_address);
   if (cache_it != absolute_address_to_module_data_cache_.end()) {
     return cache_it->second;
   }
-  auto it = module_map_.find(module_in_memory.module_id());
-  if (it == module_map_.end()) {
+  ModuleData* module_data = FindModuleByModuleIdentifier(module_in_memory.module_id());
+  if (module_data == nullptr) {
     absolute_address_to_module_data_cache_.emplace(absolute_address, nullptr);
     return nullptr;
   }
 
   // The valid absolute address should be >=
   // module_base_address + (executable_segment_offset % kPageSize)
-  if (absolute_address < module_in_memory.start() + (it->second->executable_segment_offset() %
+  if (absolute_address < module_in_memory.start() + (module_data->executable_segment_offset() %
                                                      orbit_module_utils::kPageSize)) {
     absolute_address_to_module_data_cache_.emplace(absolute_address, nullptr);
     return nullptr;
   }
 
-  ModuleData* result = it->second.get();
-  absolute_address_to_module_data_cache_.emplace(absolute_address, result);
-  return result;
+  absolute_address_to_module_data_cache_.emplace(absolute_address, module_data);
+  return module_data;
 }
 
-const ModuleData* ModuleManager::GetModuleByModuleIdentifier(ModuleIdentifier module_id) const {
-  absl::MutexLock lock(&mutex_);
-  return GetModuleByModuleIdentifierInternal(module_id);
+const ModuleData* ModuleManager::GetModuleByModuleInMemoryAndAbsoluteAddress(
+    const ModuleInMemory& module_in_memory, uint64_t absolute_address) const {
+  return FindModuleByModuleInMemoryAndAbsoluteAddress(module_in_memory, absolute_address);
 }
 
-const ModuleData* ModuleManager::GetModuleByModuleIdentifierInternal(
-    ModuleIdentifier module_id) const {
-  auto it = module_map_.find(module_id);
-  if (it == module_map_.end()) return nullptr;
-
-  return it->second.get();
+ModuleData* ModuleManager::GetMutableModuleByModuleInMemoryAndAbsoluteAddress(
+    const ModuleInMemory& module_in_memory, uint64_t absolute_address) {
+  return FindModuleByModuleInMemoryAndAbsoluteAddress(module_in_memory, absolute_address);
 }
 
-ModuleData* ModuleManager::GetMutableModuleByModuleIdentifier(ModuleIdentifier module_id) {
-  absl::MutexLock lock(&mutex_);
-  return GetMutableModuleByModuleIdentifierInternal(module_id);
+const ModuleData* ModuleManager::GetModuleByModuleIdentifier(ModuleIdentifier module_id) const {
+  return FindModuleByModuleIdentifier(module_id);
 }
 
-ModuleData* ModuleManager::GetMutableModuleByModuleIdentifierInternal(ModuleIdentifier module_id) {
-  auto it = module_map_.find(module_id);
-  if (it == module_map_.end()) return nullptr;
-
-  return it->second.get();
+ModuleData* ModuleManager::GetMutableModuleByModuleIdentifier(ModuleIdentifier module_id) {
+  return FindModuleByModuleIdentifier(module_id);
 }
 
 const ModuleData* ModuleManager::GetModuleByModulePathAndBuildId(
     const ModulePathAndBuildId& module_path_and_build_id) const {
-  absl::MutexLock lock(&mutex_);
   std::optional<orbit_client_data::ModuleIdentifier> module_id =
       module_identifier_provider_->GetModuleIdentifier(module_path_and_build_id);
   if (!module_id.has_value()) return nullptr;
-  return GetModuleByModuleIdentifierInternal(module_id.value());
+  return FindModuleByModuleIdentifier(module_id.value());
 }
 
 ModuleData* ModuleManager::GetMutableModuleByModulePathAndBuildId(
     const ModulePathAndBuildId& module_path_and_build_id) {
-  absl::MutexLock lock(&mutex_);
   std::optional<orbit_client_data::ModuleIdentifier> module_id =
       module_identifier_provider_->GetModuleIdentifier(module_path_and_build_id);
   if (!module_id.has_value()) return nullptr;
-  return GetMutableModuleByModuleIdentifierInternal(module_id.value());
+  return FindModuleByModuleIdentifier(module_id.value());
 }
 
 std::vector<const ModuleData*> ModuleManager::GetAllModuleData() const {
-  absl::MutexLock lock(&mutex_);
+  const std::shared_ptr<const ModuleTable> module_table = GetModuleTable();
   std::vector<const ModuleData*> result;
-  for (const auto& [unused_module_id, module_data] : module_map_) {
-    result.push_back(module_data.get());
+  result.reserve(module_table->size());
+  for (const auto& [unused_module_id, module_data] : *module_table) {
+    result.push_back(module_data);
   }
   return result;
 }
 
 std::vector<const ModuleData*> ModuleManager::GetModulesByFilename(
     std::string_view filename) const {
-  absl::MutexLock lock(&mutex_);
+  const std::shared_ptr<const ModuleTable> module_table = GetModuleTable();
   std::vector<const ModuleData*> result;
-  for (const auto& [module_id, module_data] : module_map_) {
+  for (const auto& [module_id, module_data] : *module_table) {
     if (std::filesystem::path(module_data->file_path()).filename().string() == filename) {
-      result.push_back(module_data.get());
+      result.push_back(module_data);
     }
   }
   return result;
@@ -5,8 +5,12 @@
 #include <gtest/gtest.h>
 #include <stdint.h>
 
+#include <absl/strings/str_format.h>
+
+#include <atomic>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "ClientData/ModuleData.h"
@@ -391,4 +395,50 @@ TEST(ModuleManager, GetModulesByFilename) {
   }
 }
 
+TEST(ModuleManager, LookupsWhileModulesAreAdded) {
+  constexpr int kNumModules = 200;
+  std::vector<ModuleInfo> module_infos(kNumModules);
+  for (int i = 0; i < kNumModules; ++i) {
+    module_infos[i].set_name(absl::StrFormat("module %d", i));
+    module_infos[i].set_file_path(absl::StrFormat("path/of/module/%d", i));
+    module_infos[i].set_build_id(absl::StrFormat("build id %d", i));
+  }
+
+  ModuleIdentifierProvider module_identifier_provider{};
+  ModuleManager module_manager{&module_identifier_provider};
+  EXPECT_TRUE(module_manager.AddOrUpdateModules({module_infos[0]}).empty());
+  const ModuleData* first_module =
+      module_manager.GetModuleByModulePathAndBuildId({.module_path = module_infos[0].file_path(),
+                                                      .build_id = module_infos[0].build_id()});
+  ASSERT_NE(first_module, nullptr);
+
+  std::atomic<bool> adding_done = false;
+  std::thread reader{[&]() {
+    while (!adding_done) {
+      // Modules that have been returned once stay valid and are always found.
+      EXPECT_EQ(module_manager.GetModuleByModulePathAndBuildId(
+                    {.module_path = module_infos[0].file_path(),
+                     .build_id = module_infos[0].build_id()}),
+                first_module);
+      for (const ModuleData* module_data : module_manager.GetAllModuleData()) {
+        EXPECT_FALSE(module_data->file_path().empty());
+      }
+    }
+  }};
+
+  for (int i = 1; i < kNumModules; ++i) {
+    EXPECT_TRUE(module_manager.AddOrUpdateModules({module_infos[i]}).empty());
+  }
+  adding_done = true;
+  reader.join();
+
+  EXPECT_EQ(module_manager.GetAllModuleData().size(), kNumModules);
+  for (const ModuleInfo& module_info : module_infos) {
+    const ModuleData* module_data = module_manager.GetModuleByModulePathAndBuildId(
+        {.module_path = module_info.file_path(), .build_id = module_info.build_id()});
+    ASSERT_NE(module_data, nullptr);
+    EXPECT_EQ(module_data->name(), module_info.name());
+  }
+}
+
 }  // namespace orbit_client_data
@@ -74,7 +74,6 @@ const std::string& ProcessData::build_id() const {
 void ProcessData::UpdateModuleInfos(absl::Span<const ModuleInfo> module_infos) {
   absl::MutexLock lock(&mutex_);
   start_address_to_module_in_memory_.clear();
-  absolute_address_to_module_in_memory_cache_.clear();
 
   for (const auto& module_info : module_infos) {
     std::optional<orbit_client_data::ModuleIdentifier> module_id_opt =
@@ -89,6 +88,7 @@ void ProcessData::UpdateModuleInfos(absl::Span<const ModuleInfo> module_infos) {
   // Files saved with Orbit 1.65 may have intersecting maps, this is why we use DCHECK here
   // instead of CHECK
   ORBIT_DCHECK(IsModuleMapValid(start_address_to_module_in_memory_));
+  UpdateModuleIndex();
 }
 
 std::vector<std::string> ProcessData::FindModuleBuildIdsByPath(std::string_view module_path) const {
@@ -135,40 +135,38 @@ void ProcessData::AddOrUpdateModuleInfo(const ModuleInfo& module_info) {
                                                       module_in_memory);
 
   ORBIT_CHECK(IsModuleMapValid(start_address_to_module_in_memory_));
+  UpdateModuleIndex();
+}
+
+void ProcessData::UpdateModuleIndex() {
+  mutex_.AssertHeld();
+  std::vector<ModuleIndex::Entry> entries;
+  entries.reserve(start_address_to_module_in_memory_.size());
+  for (const auto& [start_address, module_in_memory] : start_address_to_module_in_memory_) {
+    entries.push_back({start_address, module_in_memory.end(), module_in_memory});
+  }
+  std::atomic_store(&module_index_, std::shared_ptr<const ModuleIndex>{
+                                        std::make_shared<const ModuleIndex>(std::move(entries))});
+}
+
+std::shared_ptr<const ProcessData::ModuleIndex> ProcessData::GetModuleIndex() const {
+  return std::atomic_load(&module_index_);
 }
 
 ErrorMessageOr<ModuleInMemory> ProcessData::FindModuleByAddress(uint64_t absolute_address) const {
+  const std::shared_ptr<const ModuleIndex> module_index = GetModuleIndex();
+  const ModuleInMemory* module_in_memory = module_index->Find(absolute_address);
+  if (module_in_memory != nullptr) return *module_in_memory;
+
   absl::MutexLock lock(&mutex_);
-  if (start_address_to_module_in_memory_.empty()) {
+  if (module_index->empty()) {
     return ErrorMessage(
         absl::StrFormat("Unable to find module for address %016x: No modules loaded by process %s",
                         absolute_address, process_info_.name()));
   }
-
-  auto cache_it = absolute_address_to_module_in_memory_cache_.find(absolute_address);
-  if (cache_it != absolute_address_to_module_in_memory_cache_.end()) {
-    return cache_it->second;
-  }
-
-  static constexpr const char* kNotFoundErrorFormat{
-      "Unable to find module for address %016x: No module loaded at this address by process %s"};
-
-  auto it = start_address_to_module_in_memory_.upper_bound(absolute_address);
-  if (it == start_address_to_module_in_memory_.begin()) {
-    return ErrorMessage{
-        absl::StrFormat(kNotFoundErrorFormat, absolute_address, process_info_.name())};
-  }
-
-  --it;
-  const ModuleInMemory& module_in_memory = it->second;
-  ORBIT_CHECK(absolute_address >= module_in_memory.start());
-  if (absolute_address >= module_in_memory.end()) {
-    return ErrorMessage{
-        absl::StrFormat(kNotFoundErrorFormat, absolute_address, process_info_.name())};
-  }
-
-  absolute_address_to_module_in_memory_cache_.emplace(absolute_address, module_in_memory);
-  return module_in_memory;
+  return ErrorMessage{absl::StrFormat(
+      "Unable to find module for address %016x: No module loaded at this address by process %s",
+      absolute_address, process_info_.name())};
 }
 
 std::vector<uint64_t> ProcessData::GetModuleBaseAddresses(
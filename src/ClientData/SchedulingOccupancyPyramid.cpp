@@ -0,0 +1,122 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/SchedulingOccupancyPyramid.h"
+
+#include <algorithm>
+
+#include "ClientData/FastRenderingUtils.h"
+
+namespace orbit_client_data {
+
+using orbit_client_protos::TimerInfo;
+
+namespace {
+
+// The first timestamp of pixel `pixel`, the inverse of GetPixelNumber.
+[[nodiscard]] uint64_t GetPixelStartNs(uint64_t pixel, uint32_t resolution, uint64_t start_ns,
+                                       uint64_t end_ns) {
+  // Rounds up like GetNextPixelBoundaryTimeNs.
+  if (pixel == 0) return start_ns;
+  return start_ns + 1 + ((end_ns - start_ns) * pixel - 1) / resolution;
+}
+
+}  // namespace
+
+void SchedulingOccupancyPyramid::AddSlice(const TimerInfo& slice) {
+  if (slice.processor() < 0 || slice.end() <= slice.start()) return;
+  const auto core = static_cast<size_t>(slice.processor());
+
+  absl::MutexLock lock{&mutex_};
+  if (levels_by_core_.size() <= core) levels_by_core_.resize(core + 1);
+  Levels& levels = levels_by_core_[core];
+  for (size_t level = 0; level < kLevelCount; ++level) {
+    const uint32_t shift = kFinestBucketShift + static_cast<uint32_t>(level) * kLevelShift;
+    std::vector<Bucket>& buckets = levels[level];
+    for (uint64_t number = slice.start() >> shift; number <= (slice.end() - 1) >> shift;
+         ++number) {
+      const uint64_t overlap_ns = std::min(slice.end(), (number + 1) << shift) -
+                                  std::max(slice.start(), number << shift);
+      // The slices of a core mostly arrive in order, so the bucket is usually the last one or a
+      // new one after it.
+      auto it = buckets.end();
+      if (buckets.empty() || buckets.back().number < number) {
+        it = buckets.insert(buckets.end(), Bucket{number, 0, 0, nullptr});
+      } else if (buckets.back().number == number) {
+        it = std::prev(buckets.end());
+      } else {
+        it = std::lower_bound(
+            buckets.begin(), buckets.end(), number,
+            [](const Bucket& bucket, uint64_t number) { return bucket.number < number; });
+        if (it->number != number) it = buckets.insert(it, Bucket{number, 0, 0, nullptr});
+      }
+      it->busy_ns += overlap_ns;
+      if (overlap_ns > it->dominant_ns) {
+        it->dominant_ns = overlap_ns;
+        it->dominant_slice = &slice;
+      }
+    }
+  }
+}
+
+bool SchedulingOccupancyPyramid::CanSummarizePixels(uint64_t min_ns, uint64_t max_ns,
+                                                    uint32_t resolution) {
+  if (min_ns >= max_ns || resolution == 0) return false;
+  return (max_ns - min_ns) / resolution >= (uint64_t{1} << kFinestBucketShift);
+}
+
+std::optional<std::vector<SchedulingOccupancyPyramid::PixelOccupancy>>
+SchedulingOccupancyPyramid::GetPixelOccupancies(uint32_t core, uint64_t min_ns, uint64_t max_ns,
+                                                uint32_t resolution) const {
+  if (!CanSummarizePixels(min_ns, max_ns, resolution)) return std::nullopt;
+  // The coarsest level whose buckets are not wider than a pixel.
+  const uint64_t pixel_width_ns = (max_ns - min_ns) / resolution;
+  size_t level = kLevelCount - 1;
+  while ((uint64_t{1} << (kFinestBucketShift + level * kLevelShift)) > pixel_width_ns) --level;
+  const uint32_t shift = kFinestBucketShift + static_cast<uint32_t>(level) * kLevelShift;
+
+  std::vector<PixelOccupancy> result;
+  absl::ReaderMutexLock lock{&mutex_};
+  if (core >= levels_by_core_.size()) return result;
+  const std::vector<Bucket>& buckets = levels_by_core_[core][level];
+
+  uint64_t current_pixel = 0;
+  uint64_t busy_ns = 0;
+  uint64_t dominant_ns = 0;
+  const TimerInfo* dominant_slice = nullptr;
+  auto flush_pixel = [&]() {
+    if (dominant_slice == nullptr) return;
+    const uint64_t start_ns = GetPixelStartNs(current_pixel, resolution, min_ns, max_ns);
+    const uint64_t end_ns = GetPixelStartNs(current_pixel + 1, resolution, min_ns, max_ns);
+    const float busy_fraction =
+        std::min(1.f, static_cast<float>(busy_ns) / static_cast<float>(end_ns - start_ns));
+    result.push_back({start_ns, end_ns, busy_fraction, dominant_slice});
+    busy_ns = 0;
+    dominant_ns = 0;
+    dominant_slice = nullptr;
+  };
+
+  // The bucket containing `min_ns` is attributed to the first pixel.
+  auto it = std::lower_bound(
+      buckets.begin(), buckets.end(), min_ns >> shift,
+      [](const Bucket& bucket, uint64_t number) { return bucket.number < number; });
+  for (; it != buckets.end(); ++it) {
+    const uint64_t bucket_start_ns = std::max(min_ns, it->number << shift);
+    if (bucket_start_ns >= max_ns) break;
+    const uint64_t pixel = GetPixelNumber(bucket_start_ns, resolution, min_ns, max_ns);
+    if (pixel != current_pixel) {
+      flush_pixel();
+      current_pixel = pixel;
+    }
+    busy_ns += it->busy_ns;
+    if (it->dominant_ns > dominant_ns) {
+      dominant_ns = it->dominant_ns;
+      dominant_slice = it->dominant_slice;
+    }
+  }
+  flush_pixel();
+  return result;
+}
+
+}  // namespace orbit_client_data
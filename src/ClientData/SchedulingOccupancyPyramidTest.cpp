@@ -0,0 +1,103 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "ClientData/SchedulingOccupancyPyramid.h"
+#include "ClientProtos/capture_data.pb.h"
+
+namespace orbit_client_data {
+
+using orbit_client_protos::TimerInfo;
+using PixelOccupancy = SchedulingOccupancyPyramid::PixelOccupancy;
+
+namespace {
+
+// 2^24ns, the width of the buckets of the second level.
+constexpr uint64_t kBucketWidthNs = uint64_t{1} << 24;
+constexpr uint64_t kMillisecondNs = 1'000'000;
+
+class SchedulingOccupancyPyramidTest : public testing::Test {
+ protected:
+  const TimerInfo& AddSlice(int32_t core, uint64_t start, uint64_t end, uint32_t thread_id) {
+    TimerInfo& slice = slices_.emplace_back();
+    slice.set_processor(core);
+    slice.set_start(start);
+    slice.set_end(end);
+    slice.set_thread_id(thread_id);
+    pyramid_.AddSlice(slice);
+    return slice;
+  }
+
+  std::deque<TimerInfo> slices_;
+  SchedulingOccupancyPyramid pyramid_;
+};
+
+}  // namespace
+
+TEST_F(SchedulingOccupancyPyramidTest, PixelsNarrowerThanTheFinestBuckets) {
+  AddSlice(0, 0, 10, 1);
+  EXPECT_EQ(pyramid_.GetPixelOccupancies(0, 0, 1'000'000, 1000), std::nullopt);
+}
+
+TEST_F(SchedulingOccupancyPyramidTest, UnknownCore) {
+  AddSlice(0, 0, 10, 1);
+  std::optional<std::vector<PixelOccupancy>> pixels =
+      pyramid_.GetPixelOccupancies(3, 0, 4 * kBucketWidthNs, 4);
+  ASSERT_TRUE(pixels.has_value());
+  EXPECT_TRUE(pixels->empty());
+}
+
+TEST_F(SchedulingOccupancyPyramidTest, BusyFractionAndDominantSlice) {
+  const TimerInfo& long_slice = AddSlice(0, 0, 8 * kMillisecondNs, 1);
+  AddSlice(0, 8 * kMillisecondNs, 10 * kMillisecondNs, 2);
+  const TimerInfo& other_core_slice = AddSlice(1, kBucketWidthNs, 2 * kBucketWidthNs, 3);
+
+  std::optional<std::vector<PixelOccupancy>> pixels =
+      pyramid_.GetPixelOccupancies(0, 0, 4 * kBucketWidthNs, 4);
+  ASSERT_TRUE(pixels.has_value());
+  ASSERT_EQ(pixels->size(), 1);
+  EXPECT_EQ((*pixels)[0].start_ns, 0);
+  EXPECT_EQ((*pixels)[0].end_ns, kBucketWidthNs);
+  EXPECT_FLOAT_EQ((*pixels)[0].busy_fraction,
+                  static_cast<float>(10 * kMillisecondNs) / static_cast<float>(kBucketWidthNs));
+  EXPECT_EQ((*pixels)[0].dominant_slice, &long_slice);
+
+  pixels = pyramid_.GetPixelOccupancies(1, 0, 4 * kBucketWidthNs, 4);
+  ASSERT_TRUE(pixels.has_value());
+  ASSERT_EQ(pixels->size(), 1);
+  EXPECT_EQ((*pixels)[0].start_ns, kBucketWidthNs);
+  EXPECT_FLOAT_EQ((*pixels)[0].busy_fraction, 1.f);
+  EXPECT_EQ((*pixels)[0].dominant_slice, &other_core_slice);
+}
+
+TEST_F(SchedulingOccupancyPyramidTest, SlicesOutOfOrderAndSpanningPixels) {
+  const TimerInfo& late_slice = AddSlice(0, 3 * kBucketWidthNs, 4 * kBucketWidthNs, 1);
+  const TimerInfo& early_slice = AddSlice(0, kBucketWidthNs / 2, 2 * kBucketWidthNs, 2);
+
+  std::optional<std::vector<PixelOccupancy>> pixels =
+      pyramid_.GetPixelOccupancies(0, 0, 4 * kBucketWidthNs, 4);
+  ASSERT_TRUE(pixels.has_value());
+  ASSERT_EQ(pixels->size(), 3);
+  EXPECT_FLOAT_EQ((*pixels)[0].busy_fraction, 0.5f);
+  EXPECT_EQ((*pixels)[0].dominant_slice, &early_slice);
+  EXPECT_FLOAT_EQ((*pixels)[1].busy_fraction, 1.f);
+  EXPECT_EQ((*pixels)[1].dominant_slice, &early_slice);
+  EXPECT_EQ((*pixels)[2].start_ns, 3 * kBucketWidthNs);
+  EXPECT_EQ((*pixels)[2].dominant_slice, &late_slice);
+
+  // Zoomed out, all the slices are in the same pixel.
+  pixels = pyramid_.GetPixelOccupancies(0, 0, 4 * kBucketWidthNs, 1);
+  ASSERT_TRUE(pixels.has_value());
+  ASSERT_EQ(pixels->size(), 1);
+  EXPECT_FLOAT_EQ((*pixels)[0].busy_fraction, 2.5f / 4);
+  EXPECT_EQ((*pixels)[0].dominant_slice, &early_slice);
+}
+
+}  // namespace orbit_client_data
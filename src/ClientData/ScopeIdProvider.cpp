@@ -5,10 +5,13 @@
 #include "ClientData/ScopeIdProvider.h"
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
 #include <absl/meta/type_traits.h>
 #include <absl/synchronization/mutex.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -93,9 +96,17 @@ std::optional<ScopeId> NameEqualityScopeIdProvider::ProvideId(const TimerInfo& t
 
   ORBIT_CHECK(scope_type == ScopeType::kApiScope || scope_type == ScopeType::kApiScopeAsync);
 
+  const uint64_t name_key = timer_info.api_scope_name_key();
+  if (name_key != 0) {
+    if (std::optional<ScopeId> id = FindCachedScopeId(name_key, scope_type); id.has_value()) {
+      return id.value();
+    }
+  }
+
   const ScopeInfo scope_info{timer_info.api_scope_name(), scope_type};
 
-  {
+  // A name key that is not cached yet goes straight to the writer lock, so that it can be cached.
+  if (name_key == 0) {
     absl::ReaderMutexLock reader_lock{&mutex_};
     if (std::optional<ScopeId> id = GetExistingScopeId(scope_info); id.has_value()) {
       return id.value();
@@ -104,15 +115,54 @@ std::optional<ScopeId> NameEqualityScopeIdProvider::ProvideId(const TimerInfo& t
 
   absl::WriterMutexLock writer_local{&mutex_};
 
-  if (std::optional<ScopeId> id = GetExistingScopeId(scope_info); id.has_value()) {
-    return id.value();
+  std::optional<ScopeId> id = GetExistingScopeId(scope_info);
+  if (!id.has_value()) {
+    id = next_id_++;
+    scope_info_to_id_.emplace(scope_info, id.value());
+    scope_id_to_info_.emplace(id.value(), scope_info);
   }
 
-  const ScopeId id = next_id_++;
+  if (name_key != 0) CacheScopeId(name_key, scope_type, id.value());
+  return id.value();
+}
+
+std::optional<ScopeId> NameEqualityScopeIdProvider::FindCachedScopeId(uint64_t name_key,
+                                                                      ScopeType scope_type) const {
+  constexpr size_t kMask = kNameKeyCacheCapacity - 1;
+  // The cache is never more than half full, so the probing always reaches an empty slot.
+  for (size_t index = absl::Hash<uint64_t>{}(name_key) & kMask;; index = (index + 1) & kMask) {
+    const NameKeyCacheSlot& slot = name_key_cache_[index];
+    const uint64_t slot_key = slot.key.load(std::memory_order_acquire);
+    if (slot_key == 0) return std::nullopt;
+    if (slot_key != name_key) continue;
+
+    const std::atomic<uint64_t>& slot_id =
+        scope_type == ScopeType::kApiScope ? slot.api_scope_id : slot.api_scope_async_id;
+    const uint64_t id = slot_id.load(std::memory_order_acquire);
+    if (id == 0) return std::nullopt;
+    return ScopeId(id);
+  }
+}
 
-  scope_info_to_id_.emplace(scope_info, id);
-  scope_id_to_info_.emplace(id, scope_info);
-  return id;
+void NameEqualityScopeIdProvider::CacheScopeId(uint64_t name_key, ScopeType scope_type,
+                                               ScopeId scope_id) {
+  constexpr size_t kMask = kNameKeyCacheCapacity - 1;
+  for (size_t index = absl::Hash<uint64_t>{}(name_key) & kMask;; index = (index + 1) & kMask) {
+    NameKeyCacheSlot& slot = name_key_cache_[index];
+    const uint64_t slot_key = slot.key.load(std::memory_order_relaxed);
+    if (slot_key != 0 && slot_key != name_key) continue;
+
+    if (slot_key == 0) {
+      if (name_key_cache_size_ >= kNameKeyCacheCapacity / 2) return;
+      ++name_key_cache_size_;
+    }
+    std::atomic<uint64_t>& slot_id =
+        scope_type == ScopeType::kApiScope ? slot.api_scope_id : slot.api_scope_async_id;
+    slot_id.store(*scope_id, std::memory_order_release);
+    // Publish the key last, so that a lookup that finds it also finds the id.
+    if (slot_key == 0) slot.key.store(name_key, std::memory_order_release);
+    return;
+  }
 }
 
 [[nodiscard]] std::vector<ScopeId> NameEqualityScopeIdProvider::GetAllProvidedScopeIds() const {
@@ -15,6 +15,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -120,6 +121,75 @@ TEST(NameEqualityScopeIdProviderTest, SyncAndAsyncScopesOfTheSameNameGetDifferen
   ASSERT_NE(id_provider->ProvideId(sync), id_provider->ProvideId(async));
 }
 
+[[nodiscard]] static orbit_client_protos::TimerInfo MakeTimerInfoWithNameKey(
+    std::string name, uint64_t name_key, orbit_client_protos::TimerInfo_Type type) {
+  orbit_client_protos::TimerInfo timer_info = MakeTimerInfo(std::move(name), type);
+  timer_info.set_api_scope_name_key(name_key);
+  return timer_info;
+}
+
+TEST(NameEqualityScopeIdProviderTest, ProvideIdByNameKeyIsTheSameAsByName) {
+  auto id_provider = NameEqualityScopeIdProvider::Create(orbit_grpc_protos::CaptureOptions{});
+  const std::optional<ScopeId> sync_id =
+      id_provider->ProvideId(MakeTimerInfo("A", TimerInfo::kApiScope));
+  ASSERT_TRUE(sync_id.has_value());
+
+  const TimerInfo sync_with_key = MakeTimerInfoWithNameKey("A", 7, TimerInfo::kApiScope);
+  EXPECT_EQ(id_provider->ProvideId(sync_with_key), sync_id);
+  EXPECT_EQ(id_provider->ProvideId(sync_with_key), sync_id);
+
+  const TimerInfo async_with_key = MakeTimerInfoWithNameKey("A", 7, TimerInfo::kApiScopeAsync);
+  const std::optional<ScopeId> async_id = id_provider->ProvideId(async_with_key);
+  ASSERT_TRUE(async_id.has_value());
+  EXPECT_NE(async_id, sync_id);
+  EXPECT_EQ(id_provider->ProvideId(async_with_key), async_id);
+  EXPECT_EQ(id_provider->ProvideId(MakeTimerInfo("A", TimerInfo::kApiScopeAsync)), async_id);
+
+  EXPECT_EQ(id_provider->GetScopeInfo(sync_id.value()), ScopeInfo("A", ScopeType::kApiScope));
+  EXPECT_EQ(id_provider->GetScopeInfo(async_id.value()),
+            ScopeInfo("A", ScopeType::kApiScopeAsync));
+}
+
+TEST(NameEqualityScopeIdProviderTest, ProvideIdByNameKeyIsCorrectWhenTheCacheIsFull) {
+  // More name keys than the cache holds.
+  constexpr uint64_t kNameCount = 5000;
+  std::vector<TimerInfo> timer_infos;
+  for (uint64_t name_key = 1; name_key <= kNameCount; ++name_key) {
+    timer_infos.push_back(
+        MakeTimerInfoWithNameKey(std::to_string(name_key), name_key, TimerInfo::kApiScope));
+  }
+
+  auto id_provider = NameEqualityScopeIdProvider::Create(orbit_grpc_protos::CaptureOptions{});
+  const std::vector<ScopeId> ids = GetIds(id_provider.get(), timer_infos);
+  AssertNameToIdIsBijective(timer_infos, ids);
+  EXPECT_EQ(GetIds(id_provider.get(), timer_infos), ids);
+}
+
+TEST(NameEqualityScopeIdProviderTest, ProvideIdByNameKeyFromSeveralThreads) {
+  constexpr uint64_t kNameCount = 100;
+  std::vector<TimerInfo> timer_infos;
+  for (uint64_t name_key = 1; name_key <= kNameCount; ++name_key) {
+    timer_infos.push_back(
+        MakeTimerInfoWithNameKey(std::to_string(name_key), name_key, TimerInfo::kApiScope));
+  }
+
+  auto id_provider = NameEqualityScopeIdProvider::Create(orbit_grpc_protos::CaptureOptions{});
+  constexpr size_t kThreadCount = 4;
+  std::vector<std::vector<ScopeId>> ids_per_thread(kThreadCount);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i] {
+      for (size_t repetition = 0; repetition < 10; ++repetition) {
+        ids_per_thread[i] = GetIds(id_provider.get(), timer_infos);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  AssertNameToIdIsBijective(timer_infos, ids_per_thread[0]);
+  for (size_t i = 1; i < kThreadCount; ++i) EXPECT_EQ(ids_per_thread[i], ids_per_thread[0]);
+}
+
 constexpr size_t kFunctionCount = 3;
 constexpr std::array<uint64_t, kFunctionCount> kFunctionIds = {10, 13, 15};
 const std::array<std::string, kFunctionCount> kFunctionNames = {"foo()", "bar()", "baz()"};
@@ -25,6 +25,8 @@ void ScopeStats::UpdateStats(uint64_t elapsed_nanos) {
   if (min_ns_ == 0 || elapsed_nanos < min_ns_) {
     min_ns_ = elapsed_nanos;
   }
+
+  duration_histogram_.Add(elapsed_nanos);
 }
 
 uint64_t ScopeStats::ComputeAverageTimeNs() const {
@@ -8,6 +8,7 @@
 #include <absl/algorithm/container.h>
 #include <absl/types/span.h>
 
+#include <algorithm>
 #include <iterator>
 #include <optional>
 #include <utility>
@@ -35,7 +36,11 @@ ScopeStatsCollection::ScopeStatsCollection(ScopeIdProvider& scope_id_provider,
 
 void ScopeStatsCollection::UpdateScopeStats(ScopeId scope_id, const TimerInfo& timer) {
   ScopeStats& stats = scope_stats_[scope_id];
-  const uint64_t elapsed_nanos = timer.end() - timer.start();
+  // The overhead of the instrumentation of nested calls is only set if the user chose to subtract
+  // it.
+  const uint64_t duration_ns = timer.end() - timer.start();
+  const uint64_t elapsed_nanos =
+      duration_ns - std::min(timer.instrumentation_overhead_ns(), duration_ns);
   stats.UpdateStats(elapsed_nanos);
   scope_id_to_timer_durations_[scope_id].push_back(elapsed_nanos);
   timer_durations_are_sorted_ = false;
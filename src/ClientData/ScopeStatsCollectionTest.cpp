@@ -95,6 +95,35 @@ TEST(ScopeStatsCollectionTest, AddTimersWithUpdateStats) {
   EXPECT_THAT(*timer_durations, ElementsAre(kOrderedDiffs[0], kOrderedDiffs[1], kOrderedDiffs[2]));
 }
 
+TEST(ScopeStatsCollectionTest, SubtractsInstrumentationOverhead) {
+  ScopeStatsCollection collection = ScopeStatsCollection();
+  TimerInfo timer = kTimerScopeId2;
+  timer.set_instrumentation_overhead_ns(20);
+  collection.UpdateScopeStats(kScopeId2, timer);
+  // The overhead is an estimate and can't make a duration negative.
+  timer.set_instrumentation_overhead_ns(1000);
+  collection.UpdateScopeStats(kScopeId2, timer);
+
+  EXPECT_EQ(collection.GetScopeStatsOrDefault(kScopeId2).max_ns(), 200);
+  EXPECT_EQ(collection.GetScopeStatsOrDefault(kScopeId2).min_ns(), 0);
+  collection.OnCaptureComplete();
+  EXPECT_THAT(*collection.GetSortedTimerDurationsForScopeId(kScopeId2), ElementsAre(0, 200));
+}
+
+TEST(ScopeStatsCollectionTest, EstimatesPercentilesWhileAddingTimers) {
+  ScopeStatsCollection collection = ScopeStatsCollection();
+  EXPECT_EQ(collection.GetScopeStatsOrDefault(kScopeId1).ComputePercentileNs(50), 0);
+  for (const TimerInfo& timer : kTimersScopeId1) {
+    collection.UpdateScopeStats(kScopeId1, timer);
+  }
+
+  const ScopeStats& stats = collection.GetScopeStatsOrDefault(kScopeId1);
+  EXPECT_EQ(stats.ComputePercentileNs(0), kOrderedDiffs[0]);
+  EXPECT_NEAR(stats.ComputePercentileNs(50), kOrderedDiffs[1], kOrderedDiffs[1] / 64);
+  EXPECT_EQ(stats.ComputePercentileNs(99), kOrderedDiffs[2]);
+  EXPECT_EQ(stats.ComputePercentileNs(100), kOrderedDiffs[2]);
+}
+
 TEST(ScopeStatsCollectionTest, CreateWithTimers) {
   MockScopeIdProvider mock_scope_id_provider;
   std::vector<const TimerInfo*> timers;
@@ -0,0 +1,83 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/ScopeTimerIndex.h"
+
+#include <algorithm>
+
+namespace orbit_client_data {
+
+using orbit_client_protos::TimerInfo;
+
+namespace {
+
+template <typename Entry>
+void InsertSortedByEnd(std::vector<Entry>* entries, const Entry& entry) {
+  if (entries->empty() || entries->back().end <= entry.end) {
+    entries->push_back(entry);
+    return;
+  }
+  // Timers with the same end stay in the order they were added.
+  auto it = std::upper_bound(entries->begin(), entries->end(), entry.end,
+                             [](uint64_t end, const Entry& other) { return end < other.end; });
+  entries->insert(it, entry);
+}
+
+}  // namespace
+
+void ScopeTimerIndex::Add(ScopeId scope_id, const TimerInfo& timer_info) {
+  const Entry entry{timer_info.end(), &timer_info};
+  absl::MutexLock lock{&mutex_};
+  ScopeEntries& scope_entries = scope_id_to_entries_[scope_id];
+  InsertSortedByEnd(&scope_entries.all_threads, entry);
+  InsertSortedByEnd(&scope_entries.by_thread_id[timer_info.thread_id()], entry);
+}
+
+const std::vector<ScopeTimerIndex::Entry>* ScopeTimerIndex::GetEntries(
+    ScopeId scope_id, std::optional<uint32_t> thread_id) const {
+  auto scope_it = scope_id_to_entries_.find(scope_id);
+  if (scope_it == scope_id_to_entries_.end()) return nullptr;
+  if (!thread_id.has_value()) return &scope_it->second.all_threads;
+
+  auto thread_it = scope_it->second.by_thread_id.find(thread_id.value());
+  if (thread_it == scope_it->second.by_thread_id.end()) return nullptr;
+  return &thread_it->second;
+}
+
+const TimerInfo* ScopeTimerIndex::FindNext(ScopeId scope_id, uint64_t time,
+                                           std::optional<uint32_t> thread_id) const {
+  absl::ReaderMutexLock lock{&mutex_};
+  const std::vector<Entry>* entries = GetEntries(scope_id, thread_id);
+  if (entries == nullptr) return nullptr;
+
+  auto it = std::upper_bound(entries->begin(), entries->end(), time,
+                             [](uint64_t time, const Entry& entry) { return time < entry.end; });
+  return it == entries->end() ? nullptr : it->timer_info;
+}
+
+const TimerInfo* ScopeTimerIndex::FindPrevious(ScopeId scope_id, uint64_t time,
+                                               std::optional<uint32_t> thread_id) const {
+  absl::ReaderMutexLock lock{&mutex_};
+  const std::vector<Entry>* entries = GetEntries(scope_id, thread_id);
+  if (entries == nullptr) return nullptr;
+
+  auto end_less_than = [](const Entry& entry, uint64_t time) { return entry.end < time; };
+  auto it = std::lower_bound(entries->begin(), entries->end(), time, end_less_than);
+  if (it == entries->begin()) return nullptr;
+  // Like FindNext, return the first timer added among those with the same end.
+  return std::lower_bound(entries->begin(), it, std::prev(it)->end, end_less_than)->timer_info;
+}
+
+std::vector<const TimerInfo*> ScopeTimerIndex::GetTimers(ScopeId scope_id) const {
+  absl::ReaderMutexLock lock{&mutex_};
+  const std::vector<Entry>* entries = GetEntries(scope_id, std::nullopt);
+  if (entries == nullptr) return {};
+
+  std::vector<const TimerInfo*> timers;
+  timers.reserve(entries->size());
+  for (const Entry& entry : *entries) timers.push_back(entry.timer_info);
+  return timers;
+}
+
+}  // namespace orbit_client_data
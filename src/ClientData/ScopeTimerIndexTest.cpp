@@ -0,0 +1,108 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <deque>
+#include <vector>
+
+#include "ClientData/ScopeId.h"
+#include "ClientData/ScopeTimerIndex.h"
+#include "ClientData/ThreadTrackDataProvider.h"
+#include "ClientProtos/capture_data.pb.h"
+
+namespace orbit_client_data {
+
+using orbit_client_protos::TimerInfo;
+using testing::ElementsAre;
+
+namespace {
+
+constexpr ScopeId kScopeId{1};
+constexpr ScopeId kOtherScopeId{2};
+constexpr uint32_t kThreadId = 42;
+constexpr uint32_t kOtherThreadId = 43;
+
+class ScopeTimerIndexTest : public testing::Test {
+ protected:
+  const TimerInfo& AddTimer(ScopeId scope_id, uint64_t start, uint64_t end, uint32_t thread_id) {
+    TimerInfo& timer_info = timers_.emplace_back();
+    timer_info.set_start(start);
+    timer_info.set_end(end);
+    timer_info.set_thread_id(thread_id);
+    index_.Add(scope_id, timer_info);
+    return timer_info;
+  }
+
+  std::deque<TimerInfo> timers_;
+  ScopeTimerIndex index_;
+};
+
+}  // namespace
+
+TEST_F(ScopeTimerIndexTest, EmptyIndex) {
+  EXPECT_EQ(index_.FindNext(kScopeId, 0), nullptr);
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 100), nullptr);
+  EXPECT_TRUE(index_.GetTimers(kScopeId).empty());
+}
+
+TEST_F(ScopeTimerIndexTest, FindNextAndPreviousByEnd) {
+  const TimerInfo& first = AddTimer(kScopeId, 0, 10, kThreadId);
+  const TimerInfo& second = AddTimer(kScopeId, 5, 20, kOtherThreadId);
+  const TimerInfo& third = AddTimer(kScopeId, 25, 30, kThreadId);
+  AddTimer(kOtherScopeId, 11, 12, kThreadId);
+
+  EXPECT_EQ(index_.FindNext(kScopeId, 0), &first);
+  EXPECT_EQ(index_.FindNext(kScopeId, 10), &second);
+  EXPECT_EQ(index_.FindNext(kScopeId, 20), &third);
+  EXPECT_EQ(index_.FindNext(kScopeId, 30), nullptr);
+
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 10), nullptr);
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 11), &first);
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 30), &second);
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 31), &third);
+}
+
+TEST_F(ScopeTimerIndexTest, FilterByThread) {
+  const TimerInfo& first = AddTimer(kScopeId, 0, 10, kThreadId);
+  const TimerInfo& second = AddTimer(kScopeId, 5, 20, kOtherThreadId);
+  const TimerInfo& third = AddTimer(kScopeId, 25, 30, kThreadId);
+
+  EXPECT_EQ(index_.FindNext(kScopeId, 10, kThreadId), &third);
+  EXPECT_EQ(index_.FindNext(kScopeId, 0, kOtherThreadId), &second);
+  EXPECT_EQ(index_.FindNext(kScopeId, 20, kOtherThreadId), nullptr);
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 30, kThreadId), &first);
+  EXPECT_EQ(index_.FindNext(kScopeId, 0, kThreadId + 100), nullptr);
+}
+
+TEST_F(ScopeTimerIndexTest, TimersAddedOutOfOrderAreSortedByEnd) {
+  // A caller ends after its callees, and timers of different threads are interleaved.
+  const TimerInfo& caller = AddTimer(kScopeId, 0, 100, kThreadId);
+  const TimerInfo& callee = AddTimer(kScopeId, 10, 20, kThreadId);
+  const TimerInfo& other_thread = AddTimer(kScopeId, 30, 50, kOtherThreadId);
+  const TimerInfo& same_end = AddTimer(kScopeId, 40, 50, kThreadId);
+
+  EXPECT_THAT(index_.GetTimers(kScopeId), ElementsAre(&callee, &other_thread, &same_end, &caller));
+  EXPECT_EQ(index_.FindNext(kScopeId, 20), &other_thread);
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 100), &other_thread);
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 100, kThreadId), &same_end);
+  EXPECT_EQ(index_.FindPrevious(kScopeId, 100, kOtherThreadId), &other_thread);
+}
+
+TEST(ScopeTimerIndex, ThreadTrackDataProviderIndexesTimersWithScopeId) {
+  ThreadTrackDataProvider thread_track_data_provider;
+  TimerInfo timer_info;
+  timer_info.set_start(0);
+  timer_info.set_end(10);
+  timer_info.set_thread_id(kThreadId);
+  const TimerInfo& indexed = thread_track_data_provider.AddTimer(timer_info, kScopeId);
+  thread_track_data_provider.AddTimer(timer_info);
+
+  EXPECT_THAT(thread_track_data_provider.GetScopeTimerIndex().GetTimers(kScopeId),
+              ElementsAre(&indexed));
+}
+
+}  // namespace orbit_client_data
@@ -31,16 +31,18 @@ void ScopeTreeTimerData::OnCaptureComplete() {
   // Build ScopeTree from timer chains, when we are loading a capture.
   if (scope_tree_update_type_ != ScopeTreeUpdateType::kOnCaptureComplete) return;
 
-  std::vector<const TimerChain*> timer_chains = timer_data_.GetChains();
-  for (const TimerChain* timer_chain : timer_chains) {
+  std::vector<const orbit_client_protos::TimerInfo*> timers;
+  timers.reserve(timer_data_.GetNumberOfTimers());
+  for (const TimerChain* timer_chain : timer_data_.GetChains()) {
     ORBIT_CHECK(timer_chain != nullptr);
-    absl::MutexLock lock(&scope_tree_mutex_);
     for (const auto& block : *timer_chain) {
       for (size_t k = 0; k < block.size(); ++k) {
-        scope_tree_.Insert(&block[k]);
+        timers.push_back(&block[k]);
       }
     }
   }
+  absl::MutexLock lock(&scope_tree_mutex_);
+  scope_tree_.Build(std::move(timers));
 }
 
 std::vector<const orbit_client_protos::TimerInfo*> ScopeTreeTimerData::GetTimers(
@@ -4,7 +4,12 @@
 
 #include "ClientData/ThreadTrackDataProvider.h"
 
+#include <stddef.h>
+
+#include <vector>
+
 #include "OrbitBase/Append.h"
+#include "OrbitBase/ParallelFor.h"
 
 namespace orbit_client_data {
 
@@ -44,11 +49,13 @@ const TimerInfo* ThreadTrackDataProvider::GetDown(const TimerInfo& timer) const
 }
 
 void ThreadTrackDataProvider::OnCaptureComplete() {
-  // Update data if needed after capture is completed.
-  for (ScopeTreeTimerData* scope_tree_timer_data :
-       thread_track_data_manager_->GetAllScopeTreeTimerData()) {
-    scope_tree_timer_data->OnCaptureComplete();
-  }
+  // Update data if needed after capture is completed. When loading a capture, this builds the
+  // ScopeTree of every thread, which are independent of each other.
+  const std::vector<ScopeTreeTimerData*> all_scope_tree_timer_data =
+      thread_track_data_manager_->GetAllScopeTreeTimerData();
+  orbit_base::ParallelFor(all_scope_tree_timer_data.size(), [&](size_t index) {
+    all_scope_tree_timer_data[index]->OnCaptureComplete();
+  });
 }
 
 }  // namespace orbit_client_data
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <stddef.h>
+
 #include <cstdint>
 #include <limits>
 #include <vector>
@@ -117,6 +119,38 @@ TEST(ThreadTrackDataProvider, OnCaptureComplete) {
   EXPECT_EQ(inserted_timer_info->end(), kTimerEnd);
 }
 
+TEST(ThreadTrackDataProvider, OnCaptureCompleteBuildsTheSameTreesAsLiveInserts) {
+  constexpr uint32_t kThreadCount = 16;
+  constexpr uint64_t kTimersPerThread = 100;
+  ThreadTrackDataProvider live_provider;
+  ThreadTrackDataProvider loaded_provider(true);
+
+  for (uint32_t thread_id = 0; thread_id < kThreadCount; ++thread_id) {
+    // Nested timers in the order they end, like they are received or loaded.
+    for (uint64_t i = 0; i < kTimersPerThread; ++i) {
+      TimerInfo timer_info;
+      timer_info.set_thread_id(thread_id);
+      timer_info.set_start(1000 * (i / 4) + 10 * (3 - i % 4));
+      timer_info.set_end(1000 * (i / 4) + 100 - 10 * (3 - i % 4) + thread_id);
+      live_provider.AddTimer(timer_info);
+      loaded_provider.AddTimer(timer_info);
+    }
+  }
+  loaded_provider.OnCaptureComplete();
+
+  for (uint32_t thread_id = 0; thread_id < kThreadCount; ++thread_id) {
+    EXPECT_EQ(loaded_provider.GetNumberOfTimers(thread_id), kTimersPerThread);
+    EXPECT_EQ(loaded_provider.GetDepth(thread_id), live_provider.GetDepth(thread_id));
+    std::vector<const TimerInfo*> live_timers = live_provider.GetTimers(thread_id);
+    std::vector<const TimerInfo*> loaded_timers = loaded_provider.GetTimers(thread_id);
+    ASSERT_EQ(loaded_timers.size(), live_timers.size());
+    for (size_t i = 0; i < live_timers.size(); ++i) {
+      EXPECT_EQ(loaded_timers[i]->start(), live_timers[i]->start());
+      EXPECT_EQ(loaded_timers[i]->end(), live_timers[i]->end());
+    }
+  }
+}
+
 // Insert 4 timers with the same thread_id and an extra with a different one.
 TimersInTest InsertTimersForTesting(ThreadTrackDataProvider& thread_track_data_provider) {
   TimersInTest inserted_timers_ptr;
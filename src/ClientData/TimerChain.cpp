@@ -13,15 +13,18 @@ using orbit_client_protos::TimerInfo;
 namespace orbit_client_data {
 
 bool TimerBlock::Intersects(uint64_t min, uint64_t max) const {
-  return (min <= max_timestamp_ && max >= min_timestamp_);
+  return (min <= max_timestamp_.load(std::memory_order_relaxed) &&
+          max >= min_timestamp_.load(std::memory_order_relaxed));
 }
 
 const orbit_client_protos::TimerInfo* TimerBlock::LowerBound(uint64_t min_ns) const {
-  auto it = std::lower_bound(data_.begin(), data_.end(), min_ns,
+  // data_.end() is only for the writer, see size_.
+  const auto end = data_.begin() + size();
+  auto it = std::lower_bound(data_.begin(), end, min_ns,
                              [](const orbit_client_protos::TimerInfo& timer_info, uint64_t value) {
                                return timer_info.end() < value;
                              });
-  if (it == data_.end()) return nullptr;
+  if (it == end) return nullptr;
   return &*it;
 }
 
@@ -52,7 +55,7 @@ const TimerBlock* TimerChain::GetBlockContaining(const TimerInfo& element) const
         return block;
       }
     }
-    block = block->next_;
+    block = block->next_.load(std::memory_order_acquire);
   }
 
   return nullptr;
@@ -66,8 +69,9 @@ const TimerInfo* TimerChain::GetElementAfter(const TimerInfo& element) const {
     if (index < block->size() - 1) {
       return &block->data_[++index];
     }
-    if (block->next_ != nullptr && block->next_->size() != 0) {
-      return &block->next_->data_[0];
+    const TimerBlock* next = block->next_.load(std::memory_order_acquire);
+    if (next != nullptr && next->size() != 0) {
+      return &next->data_[0];
     }
   }
   return nullptr;
@@ -21,33 +21,40 @@ const TimerInfo& TimerData::AddTimer(TimerInfo timer_info, uint32_t depth) {
     process_id_ = timer_info.process_id();
   }
 
-  TimerChain* timer_chain = GetOrCreateTimerChain(depth);
   UpdateMinTime(timer_info.start());
   UpdateMaxTime(timer_info.end());
-  ++num_timers_;
   UpdateDepth(timer_info.depth() + 1);
 
-  return timer_chain->emplace_back(std::move(timer_info));
+  // The mutex only keeps writers apart, TimerChain lets readers run concurrently with one writer.
+  absl::MutexLock lock(&mutex_);
+  const TimerInfo& timer = GetOrCreateTimerChain(depth)->emplace_back(std::move(timer_info));
+  // Counted once it was added, so that a reader seeing the new count also finds the timer.
+  ++num_timers_;
+  return timer;
 }
 
 std::vector<const TimerChain*> TimerData::GetChains() const {
   std::vector<const TimerChain*> chains;
-  absl::MutexLock lock(&mutex_);
-  for (const auto& it : timers_) {
-    chains.push_back(it.second.get());
+  const size_t num_depths = chains_.size();
+  for (size_t depth = 0; depth < num_depths; ++depth) {
+    const TimerChain* chain = chains_[depth].load(std::memory_order_acquire);
+    if (chain != nullptr) chains.push_back(chain);
   }
 
   return chains;
 }
 
-const TimerChain* TimerData::GetChain(uint64_t depth) const {
-  absl::MutexLock lock(&mutex_);
-  auto it = timers_.find(depth);
-  if (it != timers_.end()) {
-    return it->second.get();
+uint64_t TimerData::GetMemoryUsageBytes() const {
+  uint64_t memory_usage_bytes = 0;
+  for (const TimerChain* chain : GetChains()) {
+    memory_usage_bytes += chain->GetMemoryUsageBytes();
   }
+  return memory_usage_bytes;
+}
 
-  return nullptr;
+const TimerChain* TimerData::GetChain(uint64_t depth) const {
+  if (depth >= chains_.size()) return nullptr;
+  return chains_[depth].load(std::memory_order_acquire);
 }
 
 std::vector<const orbit_client_protos::TimerInfo*> TimerData::GetTimers(uint64_t min_tick,
@@ -55,10 +62,8 @@ std::vector<const orbit_client_protos::TimerInfo*> TimerData::GetTimers(uint64_t
                                                                         bool exclusive) const {
   ORBIT_SCOPE_WITH_COLOR("GetTimersAtDepthDiscretized", kOrbitColorBlueGrey);
   // TODO(b/204173236): use it in TimerTracks.
-  absl::MutexLock lock(&mutex_);
   std::vector<const orbit_client_protos::TimerInfo*> timers;
-  for (const auto& [depth, chain] : timers_) {
-    ORBIT_CHECK(chain != nullptr);
+  for (const TimerChain* chain : GetChains()) {
     for (const auto& block : *chain) {
       if (!block.Intersects(min_tick, max_tick)) continue;
       for (uint64_t i = 0; i < block.size(); i++) {
@@ -78,32 +83,38 @@ std::vector<const orbit_client_protos::TimerInfo*> TimerData::GetTimers(uint64_t
 std::vector<const orbit_client_protos::TimerInfo*> TimerData::GetTimersAtDepthDiscretized(
     uint32_t depth, uint32_t resolution, uint64_t start_ns, uint64_t end_ns) const {
   ORBIT_SCOPE_WITH_COLOR("GetTimersAtDepthDiscretized", kOrbitColorBlueGrey);
-  absl::MutexLock lock(&mutex_);
   // The query is for the interval [start_ns, end_ns], but it's easier to work with the close-open
   // interval [start_ns, end_ns+1). We have to be careful with overflowing if end_ns is the maximum
   // unsigned value. In that case, we will just ignore this max_timestamp for simplicity.
   end_ns = std::max(end_ns, end_ns + 1);
 
-  if (timers_.find(depth) == timers_.end()) return {};
+  const TimerChain* chain_ptr = GetChain(depth);
+  if (chain_ptr == nullptr) return {};
+  const TimerChain& chain = *chain_ptr;
 
   std::vector<const orbit_client_protos::TimerInfo*> discretized_timers;
   uint64_t next_pixel_start_ns = start_ns;
 
-  // We are iterating through all blocks until we are after end_ns.
-  for (const auto& block : *timers_.at(depth)) {
+  // Blocks whose timers all end before the next pixel are skipped using the index of the chain, so
+  // that the cost per pixel only grows logarithmically with the number of timers.
+  uint64_t block_index = chain.FindFirstBlockEndingAtOrAfter(next_pixel_start_ns, 0);
+  while (block_index < chain.num_blocks() && next_pixel_start_ns < end_ns) {
+    const TimerBlock& block = chain.GetBlock(block_index);
     if (block.MinTimestamp() >= end_ns) break;
 
+    // First timer for which the end timestamp isn't smaller than the start of the next pixel.
     // Several candidate timers might be in the same block.
-    while (block.Intersects(next_pixel_start_ns, end_ns) && next_pixel_start_ns < end_ns) {
-      // First timer for which the end timestamp isn't smaller than the start of the next pixel.
-      const orbit_client_protos::TimerInfo* timer = block.LowerBound(next_pixel_start_ns);
-      if (timer == nullptr || timer->start() >= end_ns) break;
-      discretized_timers.push_back(timer);
-
-      // Use the time of next pixel boundary as a threshold to avoid returning several timers
-      // for the same pixel that will overlap after.
-      next_pixel_start_ns = GetNextPixelBoundaryTimeNs(timer->end(), resolution, start_ns, end_ns);
+    const orbit_client_protos::TimerInfo* timer = block.LowerBound(next_pixel_start_ns);
+    if (timer == nullptr || timer->start() >= end_ns) {
+      block_index = chain.FindFirstBlockEndingAtOrAfter(next_pixel_start_ns, block_index + 1);
+      continue;
     }
+    discretized_timers.push_back(timer);
+
+    // Use the time of next pixel boundary as a threshold to avoid returning several timers
+    // for the same pixel that will overlap after.
+    next_pixel_start_ns = GetNextPixelBoundaryTimeNs(timer->end(), resolution, start_ns, end_ns);
+    block_index = chain.FindFirstBlockEndingAtOrAfter(next_pixel_start_ns, block_index);
   }
   return discretized_timers;
 }
@@ -157,15 +168,17 @@ void TimerData::UpdateMaxTime(uint64_t max_time) {
 }
 
 TimerChain* TimerData::GetOrCreateTimerChain(uint64_t depth) {
-  absl::MutexLock lock(&mutex_);
-  auto it = timers_.find(depth);
-  if (it != timers_.end()) {
-    return it->second.get();
+  mutex_.AssertHeld();
+  while (chains_.size() <= depth) {
+    chains_.push_back(nullptr);
   }
 
-  auto [inserted_it, inserted] = timers_.insert_or_assign(depth, std::make_unique<TimerChain>());
-  ORBIT_CHECK(inserted);
-  return inserted_it->second.get();
+  std::atomic<TimerChain*>& chain = chains_[depth];
+  if (chain.load(std::memory_order_relaxed) == nullptr) {
+    owned_chains_.push_back(std::make_unique<TimerChain>());
+    chain.store(owned_chains_.back().get(), std::memory_order_release);
+  }
+  return chain.load(std::memory_order_relaxed);
 }
 
 }  // namespace orbit_client_data
\ No newline at end of file
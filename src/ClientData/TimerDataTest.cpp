@@ -6,10 +6,14 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <limits>
 #include <memory>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "ClientData/FastRenderingUtils.h"
 #include "ClientData/TimerChain.h"
 #include "ClientData/TimerData.h"
 #include "ClientProtos/capture_data.pb.h"
@@ -119,6 +123,23 @@ TEST(TimerData, AddTimers) {
   EXPECT_EQ(timer_data.GetMaxTime(), kMaxTimestamp);
 }
 
+TEST(TimerData, MemoryUsageGrowsWithTheBlocksOfTheChains) {
+  TimerData timer_data;
+  EXPECT_EQ(timer_data.GetMemoryUsageBytes(), 0);
+
+  timer_data.AddTimer(GetLeftTimer(), 0);
+  const uint64_t memory_usage_of_one_block = timer_data.GetMemoryUsageBytes();
+  EXPECT_GT(memory_usage_of_one_block, 0);
+  timer_data.AddTimer(GetRightTimer(), 0);
+  EXPECT_EQ(timer_data.GetMemoryUsageBytes(), memory_usage_of_one_block);
+
+  timer_data.AddTimer(GetDownTimer(), 1);
+  EXPECT_EQ(timer_data.GetMemoryUsageBytes(), 2 * memory_usage_of_one_block);
+  EXPECT_EQ(timer_data.GetMemoryUsageBytes(),
+            timer_data.GetChain(0)->GetMemoryUsageBytes() +
+                timer_data.GetChain(1)->GetMemoryUsageBytes());
+}
+
 std::unique_ptr<TimerData> GetOrderedTimersSameDepth() {
   auto timer_data = std::make_unique<TimerData>();
   timer_data->AddTimer(GetLeftTimer());
@@ -286,4 +307,92 @@ TEST(TimerData, GetTimersAtDepthDiscretized) {
   verify_size(2, kNormalResolution, kMinTimestamp, kMaxTimestamp, 0);
 }
 
-}  // namespace orbit_client_data
\ No newline at end of file
+TEST(TimerData, GetTimersAtDepthDiscretizedVisitsAllBlocksOfLongCaptures) {
+  // Enough timers for the index of the blocks of the TimerChain to have several levels.
+  constexpr uint64_t kTimerCount = 100'000;
+  constexpr uint64_t kTimerPeriodNs = 10;
+  constexpr uint64_t kGapNs = 100'000;
+  TimerData timer_data;
+  std::vector<const TimerInfo*> timers;
+  for (uint64_t i = 0; i < kTimerCount; ++i) {
+    TimerInfo timer_info;
+    // Every 5000 timers there is a gap longer than the timers before it.
+    const uint64_t start_ns = i * kTimerPeriodNs + (i / 5000) * kGapNs;
+    timer_info.set_start(start_ns);
+    timer_info.set_end(start_ns + kTimerPeriodNs / 2);
+    timers.push_back(&timer_data.AddTimer(timer_info));
+  }
+
+  // The timers returned when visiting all of them, like the implementation did before using the
+  // index. `end_ns` is exclusive here.
+  auto get_timers_discretized_linearly = [&timers](uint32_t resolution, uint64_t start_ns,
+                                                   uint64_t end_ns) {
+    std::vector<const TimerInfo*> discretized_timers;
+    uint64_t next_pixel_start_ns = start_ns;
+    for (const TimerInfo* timer : timers) {
+      if (next_pixel_start_ns >= end_ns || timer->start() >= end_ns) break;
+      if (timer->end() < next_pixel_start_ns) continue;
+      discretized_timers.push_back(timer);
+      next_pixel_start_ns = GetNextPixelBoundaryTimeNs(timer->end(), resolution, start_ns, end_ns);
+    }
+    return discretized_timers;
+  };
+
+  const uint64_t kCaptureEndNs = timers.back()->end();
+  for (uint32_t resolution : {1, 1000, 4000}) {
+    for (const auto& [start_ns, end_ns] :
+         {std::pair<uint64_t, uint64_t>{0, kCaptureEndNs}, {kCaptureEndNs / 3, kCaptureEndNs / 2},
+          {123'456, 123'456 + 20'000}}) {
+      EXPECT_EQ(timer_data.GetTimersAtDepthDiscretized(0, resolution, start_ns, end_ns),
+                get_timers_discretized_linearly(resolution, start_ns, end_ns + 1))
+          << "resolution: " << resolution << ", start_ns: " << start_ns << ", end_ns: " << end_ns;
+    }
+  }
+}
+
+TEST(TimerData, QueriesSeeAPrefixOfTheTimersWhileTimersAreAdded) {
+  constexpr uint64_t kTimerCount = 50'000;
+  constexpr uint32_t kDepthCount = 3;
+  TimerData timer_data;
+  std::atomic<bool> done_adding = false;
+
+  std::thread writer([&] {
+    for (uint64_t i = 0; i < kTimerCount; ++i) {
+      TimerInfo timer_info;
+      timer_info.set_start(10 * i);
+      timer_info.set_end(10 * i + 5);
+      timer_data.AddTimer(timer_info, i % kDepthCount);
+    }
+    done_adding = true;
+  });
+
+  // Without locking, each query must see the first timers of each chain in order, with no gaps.
+  bool queried_after_done_adding = false;
+  while (!queried_after_done_adding) {
+    queried_after_done_adding = done_adding;
+    for (const TimerChain* chain : timer_data.GetChains()) {
+      uint64_t previous_start = 0;
+      uint64_t count = 0;
+      for (const TimerBlock& block : *chain) {
+        for (size_t i = 0; i < block.size(); ++i) {
+          if (count > 0) {
+            EXPECT_EQ(block[i].start(), previous_start + 10 * kDepthCount);
+          }
+          previous_start = block[i].start();
+          ++count;
+        }
+      }
+      EXPECT_LE(count, kTimerCount / kDepthCount + 1);
+    }
+    const std::vector<const TimerInfo*> timers =
+        timer_data.GetTimersAtDepthDiscretized(0, 1000, 0, std::numeric_limits<uint64_t>::max());
+    for (size_t i = 1; i < timers.size(); ++i) {
+      EXPECT_LT(timers[i - 1]->start(), timers[i]->start());
+    }
+  }
+  writer.join();
+
+  EXPECT_EQ(timer_data.GetTimers().size(), kTimerCount);
+}
+
+}  // namespace orbit_client_data
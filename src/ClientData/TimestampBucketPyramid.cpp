@@ -0,0 +1,88 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientData/TimestampBucketPyramid.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "ClientData/FastRenderingUtils.h"
+#include "OrbitBase/Logging.h"
+
+namespace orbit_client_data {
+
+TimestampBucketPyramid::TimestampBucketPyramid(std::vector<uint64_t> timestamps_ns)
+    : timestamps_ns_(std::move(timestamps_ns)) {
+  ORBIT_CHECK(std::is_sorted(timestamps_ns_.begin(), timestamps_ns_.end()));
+
+  std::vector<Bucket> buckets;
+  for (size_t i = 0; i < timestamps_ns_.size(); ++i) {
+    const uint64_t number = timestamps_ns_[i] >> kFinestBucketShift;
+    if (buckets.empty() || buckets.back().number != number) buckets.push_back({number, i});
+  }
+
+  // Each level is computed from the one below, so the timestamps are only visited once.
+  for (uint32_t shift = kFinestBucketShift; shift <= kCoarsestBucketShift; shift += kLevelShift) {
+    if (shift != kFinestBucketShift) {
+      std::vector<Bucket> coarser_buckets;
+      for (const Bucket& bucket : buckets) {
+        const uint64_t number = bucket.number >> kLevelShift;
+        if (coarser_buckets.empty() || coarser_buckets.back().number != number) {
+          coarser_buckets.push_back({number, bucket.first_index});
+        }
+      }
+      buckets = std::move(coarser_buckets);
+    }
+    if (2 * buckets.size() <= timestamps_ns_.size()) levels_.push_back({shift, buckets});
+  }
+}
+
+std::vector<size_t> TimestampBucketPyramid::GetFirstIndexOfEachPixel(uint64_t min_timestamp_ns,
+                                                                     uint64_t max_timestamp_ns,
+                                                                     uint32_t resolution) const {
+  std::vector<size_t> result;
+  if (min_timestamp_ns >= max_timestamp_ns || resolution == 0) return result;
+
+  // Adds the first timestamp of each pixel among [begin, end), from `next_pixel_start_ns` on.
+  uint64_t next_pixel_start_ns = min_timestamp_ns;
+  auto add_first_indices_of_pixels = [&](size_t begin, size_t end) {
+    const auto timestamps_end = timestamps_ns_.begin() + end;
+    auto it = std::lower_bound(timestamps_ns_.begin() + begin, timestamps_end, next_pixel_start_ns);
+    while (it != timestamps_end && *it < max_timestamp_ns) {
+      result.push_back(it - timestamps_ns_.begin());
+      next_pixel_start_ns =
+          GetNextPixelBoundaryTimeNs(*it, resolution, min_timestamp_ns, max_timestamp_ns);
+      it = std::lower_bound(it + 1, timestamps_end, next_pixel_start_ns);
+    }
+  };
+
+  // The coarsest level whose buckets are not wider than a pixel, so that each bucket intersects at
+  // most two pixels.
+  const uint64_t pixel_width_ns = (max_timestamp_ns - min_timestamp_ns) / resolution;
+  auto level_it = std::find_if(levels_.rbegin(), levels_.rend(), [&](const Level& level) {
+    return (uint64_t{1} << level.shift) <= pixel_width_ns;
+  });
+  if (level_it == levels_.rend()) {
+    add_first_indices_of_pixels(0, timestamps_ns_.size());
+    return result;
+  }
+
+  const std::vector<Bucket>& buckets = level_it->buckets;
+  auto bucket_it = std::lower_bound(
+      buckets.begin(), buckets.end(), min_timestamp_ns >> level_it->shift,
+      [](const Bucket& bucket, uint64_t number) { return bucket.number < number; });
+  for (; bucket_it != buckets.end(); ++bucket_it) {
+    const size_t begin = bucket_it->first_index;
+    if (timestamps_ns_[begin] >= max_timestamp_ns) break;
+    const auto next_bucket_it = std::next(bucket_it);
+    const size_t end =
+        next_bucket_it == buckets.end() ? timestamps_ns_.size() : next_bucket_it->first_index;
+    // All timestamps of the bucket are in pixels that already have one.
+    if (timestamps_ns_[end - 1] < next_pixel_start_ns) continue;
+    add_first_indices_of_pixels(begin, end);
+  }
+  return result;
+}
+
+}  // namespace orbit_client_data
@@ -0,0 +1,81 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "ClientData/FastRenderingUtils.h"
+#include "ClientData/TimestampBucketPyramid.h"
+
+namespace orbit_client_data {
+
+namespace {
+
+// The iteration that CallstackData used for each thread before TimestampBucketPyramid.
+std::vector<size_t> GetFirstIndexOfEachPixelLinearly(const std::vector<uint64_t>& timestamps,
+                                                     uint64_t min_timestamp_ns,
+                                                     uint64_t max_timestamp_ns,
+                                                     uint32_t resolution) {
+  std::vector<size_t> result;
+  uint64_t next_pixel_start_ns = min_timestamp_ns;
+  for (size_t i = 0; i < timestamps.size() && timestamps[i] < max_timestamp_ns; ++i) {
+    if (timestamps[i] < next_pixel_start_ns) continue;
+    result.push_back(i);
+    next_pixel_start_ns =
+        GetNextPixelBoundaryTimeNs(timestamps[i], resolution, min_timestamp_ns, max_timestamp_ns);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(TimestampBucketPyramid, EmptyFindsNothing) {
+  TimestampBucketPyramid pyramid;
+  EXPECT_EQ(pyramid.size(), 0);
+  EXPECT_THAT(pyramid.GetFirstIndexOfEachPixel(0, 1000, 10), testing::IsEmpty());
+}
+
+TEST(TimestampBucketPyramid, GetFirstIndexOfEachPixel) {
+  TimestampBucketPyramid pyramid({10, 11, 12, 30});
+  EXPECT_EQ(pyramid.size(), 4);
+  EXPECT_EQ(pyramid.GetTimestamp(3), 30);
+
+  EXPECT_THAT(pyramid.GetFirstIndexOfEachPixel(0, 40, 4), testing::ElementsAre(0, 3));
+  EXPECT_THAT(pyramid.GetFirstIndexOfEachPixel(0, 40, 40), testing::ElementsAre(0, 1, 2, 3));
+  EXPECT_THAT(pyramid.GetFirstIndexOfEachPixel(11, 30, 40), testing::ElementsAre(1, 2));
+  EXPECT_THAT(pyramid.GetFirstIndexOfEachPixel(0, 40, 1), testing::ElementsAre(0));
+  EXPECT_THAT(pyramid.GetFirstIndexOfEachPixel(0, std::numeric_limits<uint64_t>::max(), 2000),
+              testing::ElementsAre(0));
+  EXPECT_THAT(pyramid.GetFirstIndexOfEachPixel(40, 40, 10), testing::IsEmpty());
+}
+
+TEST(TimestampBucketPyramid, GetFirstIndexOfEachPixelIsTheSameAsLinearIteration) {
+  std::mt19937_64 random_engine(42);
+  std::vector<uint64_t> timestamps;
+  uint64_t timestamp_ns = 0;
+  for (size_t i = 0; i < 100'000; ++i) {
+    // Bursts of dense timestamps separated by long gaps, so that every resolution has buckets.
+    timestamp_ns += (i % 1000 == 0) ? random_engine() % 100'000'000 : random_engine() % 5'000;
+    timestamps.push_back(timestamp_ns);
+  }
+  const TimestampBucketPyramid pyramid(timestamps);
+
+  for (int query = 0; query < 200; ++query) {
+    const uint64_t min_timestamp_ns = random_engine() % timestamp_ns;
+    const uint64_t max_timestamp_ns =
+        min_timestamp_ns + 1 + random_engine() % (timestamp_ns >> (query % 20));
+    const auto resolution = static_cast<uint32_t>(1 + random_engine() % 4000);
+    EXPECT_EQ(pyramid.GetFirstIndexOfEachPixel(min_timestamp_ns, max_timestamp_ns, resolution),
+              GetFirstIndexOfEachPixelLinearly(timestamps, min_timestamp_ns, max_timestamp_ns,
+                                               resolution));
+  }
+}
+
+}  // namespace orbit_client_data
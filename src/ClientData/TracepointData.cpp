@@ -6,8 +6,10 @@
 
 #include <absl/meta/type_traits.h>
 
+#include <algorithm>
 #include <utility>
 
+#include "ClientData/FastRenderingUtils.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ThreadConstants.h"
 
@@ -17,6 +19,7 @@ void TracepointData::EmplaceTracepointEvent(uint64_t timestamp_ns, uint64_t trac
                                             uint32_t process_id, uint32_t thread_id, int32_t cpu,
                                             bool is_same_pid_as_target) {
   absl::MutexLock lock(&mutex_);
+  ORBIT_CHECK(!is_frozen_.load(std::memory_order_relaxed));
   num_total_tracepoint_events_++;
 
   TracepointEventInfo event(process_id, thread_id, cpu, timestamp_ns, tracepoint_id);
@@ -46,6 +49,19 @@ void TracepointData::ForEachTracepointEvent(
 }
 
 namespace {
+void ForEachTracepointEventInRangeDiscretized(
+    uint64_t min_tick, uint64_t max_tick_exclusive, uint32_t resolution,
+    const std::map<uint64_t, TracepointEventInfo>& time_to_tracepoint_events,
+    const std::function<void(const TracepointEventInfo&)>& action) {
+  for (auto time_to_tracepoint_event = time_to_tracepoint_events.lower_bound(min_tick);
+       time_to_tracepoint_event != time_to_tracepoint_events.end() &&
+       time_to_tracepoint_event->first < max_tick_exclusive;
+       time_to_tracepoint_event = time_to_tracepoint_events.lower_bound(GetNextPixelBoundaryTimeNs(
+           time_to_tracepoint_event->first, resolution, min_tick, max_tick_exclusive))) {
+    action(time_to_tracepoint_event->second);
+  }
+}
+
 void ForEachTracepointEventInRange(
     uint64_t min_tick, uint64_t max_tick_exclusive,
     const std::map<uint64_t, TracepointEventInfo>& time_to_tracepoint_events,
@@ -83,6 +99,81 @@ void TracepointData::ForEachTracepointEventOfThreadInTimeRange(
   }
 }
 
+void TracepointData::ForEachTracepointEventOfThreadInTimeRangeDiscretized(
+    uint32_t thread_id, uint64_t min_tick, uint64_t max_tick_exclusive, uint32_t resolution,
+    const std::function<void(const TracepointEventInfo&)>& action) const {
+  if (is_frozen_.load(std::memory_order_acquire)) {
+    const auto thread_id_and_events_it = frozen_events_by_thread_id_.find(thread_id);
+    if (thread_id_and_events_it == frozen_events_by_thread_id_.end()) return;
+    const FrozenEvents& frozen_events = thread_id_and_events_it->second;
+    for (size_t index :
+         frozen_events.pyramid.GetFirstIndexOfEachPixel(min_tick, max_tick_exclusive, resolution)) {
+      action(*frozen_events.events[index]);
+    }
+    return;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  // The tracepoints of several threads can't be discretized one thread at a time, as that could
+  // visit several events per pixel. While capturing, they are visited all.
+  if (thread_id == orbit_base::kAllThreadsOfAllProcessesTid ||
+      thread_id == orbit_base::kAllProcessThreadsTid) {
+    for (const auto& [event_thread_id, time_to_tracepoint] : thread_id_to_time_to_tracepoint_) {
+      if (thread_id == orbit_base::kAllProcessThreadsTid &&
+          event_thread_id == orbit_base::kNotTargetProcessTid) {
+        continue;
+      }
+      ForEachTracepointEventInRange(min_tick, max_tick_exclusive, time_to_tracepoint, action);
+    }
+    return;
+  }
+  const auto& it = thread_id_to_time_to_tracepoint_.find(thread_id);
+  if (it == thread_id_to_time_to_tracepoint_.end()) {
+    return;
+  }
+  ForEachTracepointEventInRangeDiscretized(min_tick, max_tick_exclusive, resolution, it->second,
+                                           action);
+}
+
+void TracepointData::OnCaptureComplete() {
+  absl::MutexLock lock(&mutex_);
+  if (is_frozen_.load(std::memory_order_relaxed)) return;
+
+  auto freeze_events = [this](uint32_t thread_id, std::vector<const TracepointEventInfo*> events) {
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TracepointEventInfo* lhs, const TracepointEventInfo* rhs) {
+                       return lhs->timestamp_ns() < rhs->timestamp_ns();
+                     });
+    std::vector<uint64_t> timestamps_ns;
+    timestamps_ns.reserve(events.size());
+    for (const TracepointEventInfo* event : events) {
+      timestamps_ns.push_back(event->timestamp_ns());
+    }
+    frozen_events_by_thread_id_.try_emplace(
+        thread_id,
+        FrozenEvents{std::move(events), TimestampBucketPyramid(std::move(timestamps_ns))});
+  };
+
+  std::vector<const TracepointEventInfo*> events_of_all_threads;
+  std::vector<const TracepointEventInfo*> events_of_all_process_threads;
+  for (const auto& [thread_id, time_to_tracepoint] : thread_id_to_time_to_tracepoint_) {
+    std::vector<const TracepointEventInfo*> events;
+    events.reserve(time_to_tracepoint.size());
+    for (const auto& [unused_timestamp_ns, event] : time_to_tracepoint) {
+      events.push_back(&event);
+    }
+    events_of_all_threads.insert(events_of_all_threads.end(), events.begin(), events.end());
+    if (thread_id != orbit_base::kNotTargetProcessTid) {
+      events_of_all_process_threads.insert(events_of_all_process_threads.end(), events.begin(),
+                                           events.end());
+    }
+    freeze_events(thread_id, std::move(events));
+  }
+  freeze_events(orbit_base::kAllThreadsOfAllProcessesTid, std::move(events_of_all_threads));
+  freeze_events(orbit_base::kAllProcessThreadsTid, std::move(events_of_all_process_threads));
+  is_frozen_.store(true, std::memory_order_release);
+}
+
 uint32_t TracepointData::GetNumTracepointEventsForThreadId(uint32_t thread_id) const {
   absl::MutexLock lock(&mutex_);
   if (thread_id == orbit_base::kAllThreadsOfAllProcessesTid) {
@@ -15,6 +15,8 @@
 #include "ClientData/TracepointInfo.h"
 #include "OrbitBase/ThreadConstants.h"
 
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 using ::testing::UnorderedElementsAre;
 
 namespace orbit_client_data {
@@ -106,4 +108,39 @@ TEST(TracepointData, Get) {
                empty_trace_point->name() == "sched_switch");
 }
 
+TEST(TracepointData, DiscretizedIterationIsTheSameAfterOnCaptureComplete) {
+  TracepointData tracepoint_data;
+  tracepoint_data.AddUniqueTracepointInfo(0, {"", ""});
+
+  tracepoint_data.EmplaceTracepointEvent(10, 0, 0, 1, 0, true);
+  tracepoint_data.EmplaceTracepointEvent(11, 0, 0, 1, 0, true);
+  tracepoint_data.EmplaceTracepointEvent(30, 0, 0, 1, 0, true);
+  tracepoint_data.EmplaceTracepointEvent(12, 0, 0, 2, 0, true);
+  tracepoint_data.EmplaceTracepointEvent(25, 0, 0, 3, 0, false);
+
+  auto get_timestamps = [&](uint32_t thread_id, uint32_t resolution) {
+    std::vector<uint64_t> timestamps;
+    tracepoint_data.ForEachTracepointEventOfThreadInTimeRangeDiscretized(
+        thread_id, 0, 40, resolution,
+        [&](const TracepointEventInfo& event) { timestamps.push_back(event.timestamp_ns()); });
+    return timestamps;
+  };
+
+  EXPECT_THAT(get_timestamps(1, 4), ElementsAre(10, 30));
+  EXPECT_THAT(get_timestamps(1, 40), ElementsAre(10, 11, 30));
+  EXPECT_THAT(get_timestamps(4, 40), IsEmpty());
+
+  tracepoint_data.OnCaptureComplete();
+
+  EXPECT_THAT(get_timestamps(1, 4), ElementsAre(10, 30));
+  EXPECT_THAT(get_timestamps(1, 40), ElementsAre(10, 11, 30));
+  EXPECT_THAT(get_timestamps(4, 40), IsEmpty());
+  EXPECT_THAT(get_timestamps(orbit_base::kNotTargetProcessTid, 40), ElementsAre(25));
+  // The events of several threads are discretized together.
+  EXPECT_THAT(get_timestamps(orbit_base::kAllProcessThreadsTid, 4), ElementsAre(10, 30));
+  EXPECT_THAT(get_timestamps(orbit_base::kAllProcessThreadsTid, 40), ElementsAre(10, 11, 12, 30));
+  EXPECT_THAT(get_timestamps(orbit_base::kAllThreadsOfAllProcessesTid, 4),
+              ElementsAre(10, 25, 30));
+}
+
 }  // namespace orbit_client_data
@@ -0,0 +1,103 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_ADDRESS_RANGE_INDEX_H_
+#define CLIENT_DATA_ADDRESS_RANGE_INDEX_H_
+
+#include <absl/types/span.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_client_data {
+
+// Immutable index from addresses to the values of address ranges [start, end). If ranges overlap,
+// an address is only looked up in the range with the greatest start not above it.
+// The start addresses are kept in their own sorted array, so that the binary search only touches
+// those, and the end addresses and the values are in parallel arrays. As the index never changes
+// after construction, lookups need no synchronization.
+template <typename Value>
+class AddressRangeIndex {
+ public:
+  struct Entry {
+    uint64_t start;
+    uint64_t end;
+    Value value;
+  };
+
+  AddressRangeIndex() = default;
+  // `entries` need not be sorted.
+  explicit AddressRangeIndex(std::vector<Entry> entries) {
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& lhs, const Entry& rhs) { return lhs.start < rhs.start; });
+    starts_.reserve(entries.size());
+    ends_.reserve(entries.size());
+    values_.reserve(entries.size());
+    for (Entry& entry : entries) {
+      ORBIT_CHECK(entry.start <= entry.end);
+      starts_.push_back(entry.start);
+      ends_.push_back(entry.end);
+      values_.push_back(std::move(entry.value));
+    }
+  }
+
+  [[nodiscard]] bool empty() const { return starts_.empty(); }
+  [[nodiscard]] size_t size() const { return starts_.size(); }
+  [[nodiscard]] const std::vector<Value>& values() const { return values_; }
+
+  // Returns the value of the range containing `address`, or nullptr.
+  [[nodiscard]] const Value* Find(uint64_t address) const {
+    return GetValueIfContained(address, UpperBound(address, 0));
+  }
+
+  // Returns the value of the range starting exactly at `address`, or nullptr.
+  [[nodiscard]] const Value* FindExact(uint64_t address) const {
+    auto it = std::lower_bound(starts_.begin(), starts_.end(), address);
+    if (it == starts_.end() || *it != address) return nullptr;
+    return &values_[it - starts_.begin()];
+  }
+
+  // Like Find for each of `addresses`, writing the results to `results`, which must have the same
+  // size. While the addresses are ascending, each search starts where the previous one ended, so
+  // sorting the addresses beforehand makes the whole batch a single pass over the index.
+  void FindBatch(absl::Span<const uint64_t> addresses, absl::Span<const Value*> results) const {
+    ORBIT_CHECK(addresses.size() == results.size());
+    size_t search_begin = 0;
+    uint64_t previous_address = 0;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+      if (addresses[i] < previous_address) search_begin = 0;
+      previous_address = addresses[i];
+      const size_t upper_bound = UpperBound(addresses[i], search_begin);
+      results[i] = GetValueIfContained(addresses[i], upper_bound);
+      // The starts before upper_bound are also not greater than any following ascending address.
+      search_begin = upper_bound;
+    }
+  }
+
+ private:
+  // Index of the first start greater than `address`, searching from `search_begin` on.
+  [[nodiscard]] size_t UpperBound(uint64_t address, size_t search_begin) const {
+    return std::upper_bound(starts_.begin() + search_begin, starts_.end(), address) -
+           starts_.begin();
+  }
+
+  [[nodiscard]] const Value* GetValueIfContained(uint64_t address, size_t upper_bound) const {
+    if (upper_bound == 0) return nullptr;
+    const size_t index = upper_bound - 1;
+    if (address >= ends_[index]) return nullptr;
+    return &values_[index];
+  }
+
+  std::vector<uint64_t> starts_;
+  std::vector<uint64_t> ends_;
+  std::vector<Value> values_;
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_ADDRESS_RANGE_INDEX_H_
@@ -8,8 +8,11 @@
 #include <absl/container/btree_map.h>
 #include <absl/container/flat_hash_map.h>
 #include <absl/hash/hash.h>
+#include <absl/types/span.h>
 #include <stdint.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <limits>
@@ -24,6 +27,7 @@
 #include "CallstackType.h"
 #include "ClientData/CallstackEvent.h"
 #include "ClientData/CallstackInfo.h"
+#include "ClientData/TimestampBucketPyramid.h"
 #include "ClientProtos/capture_data.pb.h"
 #include "FastRenderingUtils.h"
 #include "ModuleManager.h"
@@ -45,12 +49,17 @@ class CallstackData {
   // Assume that callstack_event.callstack_hash is filled correctly and the
   // Callstack with the corresponding id is already in unique_callstacks_.
   void AddCallstackEvent(orbit_client_data::CallstackEvent callstack_event);
+  // Same as AddCallstackEvent for each of `callstack_events`, but only locks once.
+  void AddCallstackEvents(absl::Span<const orbit_client_data::CallstackEvent> callstack_events);
   void AddUniqueCallstack(uint64_t callstack_id, CallstackInfo callstack);
   void AddCallstackFromKnownCallstackData(const orbit_client_data::CallstackEvent& event,
                                           const CallstackData& known_callstack_data);
 
   [[nodiscard]] uint32_t GetCallstackEventsCount() const;
 
+  // Returns an estimate of the memory held by the callstack events and the unique callstacks.
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const;
+
   [[nodiscard]] std::vector<orbit_client_data::CallstackEvent> GetCallstackEventsInTimeRange(
       uint64_t time_begin, uint64_t time_end) const;
 
@@ -59,27 +68,38 @@ class CallstackData {
   [[nodiscard]] std::vector<orbit_client_data::CallstackEvent> GetCallstackEventsOfTidInTimeRange(
       uint32_t tid, uint64_t time_begin, uint64_t time_end) const;
 
+  // Return how many CallstackEvents with each callstack id are in [time_begin, time_end), without
+  // copying the events. Once the capture is complete, only the events at the ends of the range are
+  // visited, and the rest are counted from the histograms of the blocks of kCountsBlockSize events.
+  [[nodiscard]] absl::flat_hash_map<uint64_t, uint32_t> GetCallstackIdToCountOfTidInTimeRange(
+      uint32_t tid, uint64_t time_begin, uint64_t time_end) const;
+  // Same as above, but for each thread. Threads without CallstackEvents in the range are omitted.
+  [[nodiscard]] absl::flat_hash_map<uint32_t, absl::flat_hash_map<uint64_t, uint32_t>>
+  GetThreadIdToCallstackIdToCountInTimeRange(uint64_t time_begin, uint64_t time_end) const;
+
   template <typename Action>
   void ForEachCallstackEvent(Action&& action) const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    for (const auto& [unused_tid, events] : callstack_events_by_tid_) {
-      for (const auto& [unused_timestamp, event] : events) {
-        std::invoke(action, event);
+    VisitCallstackEventsByTid([&action](const auto& callstack_events_by_tid) {
+      for (const auto& [unused_tid, events] : callstack_events_by_tid) {
+        for (const auto& entry : events) {
+          std::invoke(action, GetEvent(entry));
+        }
       }
-    }
+    });
   }
 
   template <typename Action>
   void ForEachCallstackEventInTimeRange(uint64_t min_timestamp, uint64_t max_timestamp,
                                         Action&& action) const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
     ORBIT_CHECK(min_timestamp <= max_timestamp);
-    for (const auto& [unused_tid, events] : callstack_events_by_tid_) {
-      for (auto event_it = events.lower_bound(min_timestamp);
-           event_it != events.upper_bound(max_timestamp); ++event_it) {
-        std::invoke(action, event_it->second);
+    VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+      for (const auto& [unused_tid, events] : callstack_events_by_tid) {
+        for (auto event_it = LowerBound(events, min_timestamp);
+             event_it != UpperBound(events, max_timestamp); ++event_it) {
+          std::invoke(action, GetEvent(*event_it));
+        }
       }
-    }
+    });
   }
 
   // Do a particular action for callstacks but skipping callstacks that will be rendered later in
@@ -89,51 +109,63 @@ class CallstackData {
   template <typename Action>
   void ForEachCallstackEventInTimeRangeDiscretized(uint64_t min_timestamp, uint64_t max_timestamp,
                                                    uint32_t resolution, Action&& action) const {
-    auto get_next_callstack = [&](uint64_t timestamp) -> std::optional<CallstackEvent> {
-      std::optional<CallstackEvent> next_callstack;
-      const uint32_t current_pixel =
-          GetPixelNumber(timestamp, resolution, min_timestamp, max_timestamp);
-      for (const auto& [unused_tid, events] : callstack_events_by_tid_) {
-        auto next_callstack_of_tid = events.lower_bound(timestamp);
-        if (next_callstack_of_tid == events.end() ||
-            (next_callstack.has_value() &&
-             next_callstack.value().timestamp_ns() <= next_callstack_of_tid->second.timestamp_ns()))
-          continue;
-
-        // If this callstack will be drawn in the current_pixel, we don't need to search for more of
-        // them. Otherwise there could be a callstack in another thread_id that will be draw before,
-        // so we need to keep looking.
-        if (GetPixelNumber(next_callstack_of_tid->first, resolution, min_timestamp,
-                           max_timestamp) == current_pixel) {
-          return next_callstack_of_tid->second;
-        }
-        next_callstack = next_callstack_of_tid->second;
+    if (is_frozen_.load(std::memory_order_acquire)) {
+      for (size_t index : frozen_pyramid_of_all_threads_.GetFirstIndexOfEachPixel(
+               min_timestamp, max_timestamp, resolution)) {
+        std::invoke(action, *frozen_callstack_events_of_all_threads_[index]);
       }
-      return next_callstack;
-    };
-
-    for (std::optional<CallstackEvent> next_callstack = get_next_callstack(min_timestamp);
-         next_callstack.has_value() && next_callstack.value().timestamp_ns() < max_timestamp;
-         next_callstack = get_next_callstack(GetNextPixelBoundaryTimeNs(
-             next_callstack.value().timestamp_ns(), resolution, min_timestamp, max_timestamp))) {
-      std::invoke(action, next_callstack.value());
+      return;
     }
+
+    VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+      auto get_next_callstack = [&](uint64_t timestamp) -> std::optional<CallstackEvent> {
+        std::optional<CallstackEvent> next_callstack;
+        const uint32_t current_pixel =
+            GetPixelNumber(timestamp, resolution, min_timestamp, max_timestamp);
+        for (const auto& [unused_tid, events] : callstack_events_by_tid) {
+          auto next_callstack_of_tid = LowerBound(events, timestamp);
+          if (next_callstack_of_tid == events.end() ||
+              (next_callstack.has_value() && next_callstack.value().timestamp_ns() <=
+                                                 GetEvent(*next_callstack_of_tid).timestamp_ns()))
+            continue;
+
+          // If this callstack will be drawn in the current_pixel, we don't need to search for more
+          // of them. Otherwise there could be a callstack in another thread_id that will be draw
+          // before, so we need to keep looking.
+          const CallstackEvent& next_callstack_event_of_tid = GetEvent(*next_callstack_of_tid);
+          if (GetPixelNumber(next_callstack_event_of_tid.timestamp_ns(), resolution, min_timestamp,
+                             max_timestamp) == current_pixel) {
+            return next_callstack_event_of_tid;
+          }
+          next_callstack = next_callstack_event_of_tid;
+        }
+        return next_callstack;
+      };
+
+      for (std::optional<CallstackEvent> next_callstack = get_next_callstack(min_timestamp);
+           next_callstack.has_value() && next_callstack.value().timestamp_ns() < max_timestamp;
+           next_callstack = get_next_callstack(GetNextPixelBoundaryTimeNs(
+               next_callstack.value().timestamp_ns(), resolution, min_timestamp, max_timestamp))) {
+        std::invoke(action, next_callstack.value());
+      }
+    });
   }
 
   template <typename Action>
   void ForEachCallstackEventOfTidInTimeRange(uint32_t tid, uint64_t min_timestamp,
                                              uint64_t max_timestamp, Action&& action) const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
     ORBIT_CHECK(min_timestamp <= max_timestamp);
-    const auto& tid_and_events_it = callstack_events_by_tid_.find(tid);
-    if (tid_and_events_it == callstack_events_by_tid_.end()) {
-      return;
-    }
-    const auto& events = tid_and_events_it->second;
-    for (auto event_it = events.lower_bound(min_timestamp);
-         event_it != events.upper_bound(max_timestamp); ++event_it) {
-      std::invoke(action, event_it->second);
-    }
+    VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+      const auto& tid_and_events_it = callstack_events_by_tid.find(tid);
+      if (tid_and_events_it == callstack_events_by_tid.end()) {
+        return;
+      }
+      const auto& events = tid_and_events_it->second;
+      for (auto event_it = LowerBound(events, min_timestamp);
+           event_it != UpperBound(events, max_timestamp); ++event_it) {
+        std::invoke(action, GetEvent(*event_it));
+      }
+    });
   }
 
   // Do a particular action for all callstacks in a thread but skipping callstacks that will be
@@ -144,30 +176,55 @@ class CallstackData {
   void ForEachCallstackEventOfTidInTimeRangeDiscretized(uint32_t tid, uint64_t min_timestamp,
                                                         uint64_t max_timestamp, uint32_t resolution,
                                                         Action&& action) const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    const auto& tid_and_events_it = callstack_events_by_tid_.find(tid);
-    if (tid_and_events_it == callstack_events_by_tid_.end()) {
+    if (is_frozen_.load(std::memory_order_acquire)) {
+      const auto tid_and_pyramid_it = frozen_pyramids_by_tid_.find(tid);
+      if (tid_and_pyramid_it == frozen_pyramids_by_tid_.end()) return;
+      const FrozenCallstackEvents& events = frozen_callstack_events_by_tid_.at(tid);
+      for (size_t index : tid_and_pyramid_it->second.GetFirstIndexOfEachPixel(
+               min_timestamp, max_timestamp, resolution)) {
+        std::invoke(action, events[index]);
+      }
       return;
     }
-    const auto& events = tid_and_events_it->second;
-    for (auto event_it = events.lower_bound(min_timestamp);
-         event_it != events.end() && event_it->first < max_timestamp;
-         event_it = events.lower_bound(GetNextPixelBoundaryTimeNs(event_it->first, resolution,
-                                                                  min_timestamp, max_timestamp))) {
-      std::invoke(action, event_it->second);
-    }
+
+    VisitCallstackEventsByTid([&](const auto& callstack_events_by_tid) {
+      const auto& tid_and_events_it = callstack_events_by_tid.find(tid);
+      if (tid_and_events_it == callstack_events_by_tid.end()) {
+        return;
+      }
+      const auto& events = tid_and_events_it->second;
+      for (auto event_it = LowerBound(events, min_timestamp);
+           event_it != events.end() && GetEvent(*event_it).timestamp_ns() < max_timestamp;
+           event_it = LowerBound(events, GetNextPixelBoundaryTimeNs(
+                                             GetEvent(*event_it).timestamp_ns(), resolution,
+                                             min_timestamp, max_timestamp))) {
+        std::invoke(action, GetEvent(*event_it));
+      }
+    });
   }
 
   [[nodiscard]] uint64_t max_time() const {
+    if (is_frozen_.load(std::memory_order_acquire)) return max_time_;
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     return max_time_;
   }
 
   [[nodiscard]] uint64_t min_time() const {
+    if (is_frozen_.load(std::memory_order_acquire)) return min_time_;
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     return min_time_;
   }
 
+  // Moves the CallstackEvents to a sorted vector per thread, which the methods above then read
+  // without taking the mutex, with binary searches, and computes the histograms of callstack ids
+  // per block of kCountsBlockSize events, as well as the TimestampBucketPyramids of each thread and
+  // of all threads that the discretized iterations draw from. Called once the capture is complete,
+  // as no CallstackEvents can be added afterwards. The unique callstacks are still guarded by the
+  // mutex.
+  void OnCaptureComplete();
+
+  static constexpr size_t kCountsBlockSize = 64 * 1024;
+
   [[nodiscard]] const CallstackInfo* GetCallstack(uint64_t callstack_id) const;
 
   [[nodiscard]] bool HasCallstack(uint64_t callstack_id) const;
@@ -193,11 +250,82 @@ class CallstackData {
 
   void RegisterTime(uint64_t time);
 
+  using CallstackEventsByTimestamp = absl::btree_map<uint64_t, CallstackEvent>;
+  // Sorted by timestamp.
+  using FrozenCallstackEvents = std::vector<CallstackEvent>;
+  // The histogram of the callstack ids of a block of frozen CallstackEvents.
+  using CallstackIdCounts = std::vector<std::pair<uint64_t, uint32_t>>;
+
+  // Calls `visitor` with `callstack_events_by_tid_`, holding the mutex, or, once the events are
+  // frozen, with `frozen_callstack_events_by_tid_`, without locking. The helpers below let the
+  // visitors handle both alike.
+  template <typename Visitor>
+  auto VisitCallstackEventsByTid(Visitor&& visitor) const {
+    if (!is_frozen_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      // OnCaptureComplete might have run while waiting for the mutex.
+      if (!is_frozen_.load(std::memory_order_relaxed)) {
+        return std::invoke(visitor, callstack_events_by_tid_);
+      }
+    }
+    return std::invoke(visitor, frozen_callstack_events_by_tid_);
+  }
+
+  [[nodiscard]] static const CallstackEvent& GetEvent(
+      const CallstackEventsByTimestamp::value_type& timestamp_and_event) {
+    return timestamp_and_event.second;
+  }
+  [[nodiscard]] static const CallstackEvent& GetEvent(const CallstackEvent& event) { return event; }
+
+  [[nodiscard]] static CallstackEventsByTimestamp::const_iterator LowerBound(
+      const CallstackEventsByTimestamp& events, uint64_t timestamp_ns) {
+    return events.lower_bound(timestamp_ns);
+  }
+  [[nodiscard]] static FrozenCallstackEvents::const_iterator LowerBound(
+      const FrozenCallstackEvents& events, uint64_t timestamp_ns) {
+    return std::lower_bound(events.begin(), events.end(), timestamp_ns,
+                            [](const CallstackEvent& event, uint64_t timestamp_ns) {
+                              return event.timestamp_ns() < timestamp_ns;
+                            });
+  }
+
+  [[nodiscard]] static CallstackEventsByTimestamp::const_iterator UpperBound(
+      const CallstackEventsByTimestamp& events, uint64_t timestamp_ns) {
+    return events.upper_bound(timestamp_ns);
+  }
+  [[nodiscard]] static FrozenCallstackEvents::const_iterator UpperBound(
+      const FrozenCallstackEvents& events, uint64_t timestamp_ns) {
+    return std::upper_bound(events.begin(), events.end(), timestamp_ns,
+                            [](uint64_t timestamp_ns, const CallstackEvent& event) {
+                              return timestamp_ns < event.timestamp_ns();
+                            });
+  }
+
+  // Add the counts of the callstack ids of the events of `tid` in [time_begin, time_end) to
+  // `counts`.
+  static void AddCallstackIdCountsInTimeRange(uint32_t tid,
+                                              const CallstackEventsByTimestamp& events,
+                                              uint64_t time_begin, uint64_t time_end,
+                                              absl::flat_hash_map<uint64_t, uint32_t>* counts);
+  void AddCallstackIdCountsInTimeRange(uint32_t tid, const FrozenCallstackEvents& events,
+                                       uint64_t time_begin, uint64_t time_end,
+                                       absl::flat_hash_map<uint64_t, uint32_t>* counts) const;
+
   // Use a reentrant mutex so that calls to the ForEach... methods can be nested.
   // E.g., one might want to nest ForEachCallstackEvent and ForEachFrameInCallstack.
   mutable std::recursive_mutex mutex_;
   absl::flat_hash_map<uint64_t, std::shared_ptr<CallstackInfo>> unique_callstacks_;
-  absl::flat_hash_map<uint32_t, absl::btree_map<uint64_t, CallstackEvent>> callstack_events_by_tid_;
+  absl::flat_hash_map<uint32_t, CallstackEventsByTimestamp> callstack_events_by_tid_;
+  // Set by OnCaptureComplete, after which these are immutable.
+  std::atomic<bool> is_frozen_ = false;
+  absl::flat_hash_map<uint32_t, FrozenCallstackEvents> frozen_callstack_events_by_tid_;
+  // For each thread, element i counts the frozen CallstackEvents [i, i + 1) * kCountsBlockSize.
+  absl::flat_hash_map<uint32_t, std::vector<CallstackIdCounts>> frozen_block_counts_by_tid_;
+  // Over the timestamps of frozen_callstack_events_by_tid_.
+  absl::flat_hash_map<uint32_t, TimestampBucketPyramid> frozen_pyramids_by_tid_;
+  // The frozen CallstackEvents of all threads sorted by timestamp, and the pyramid over them.
+  std::vector<const CallstackEvent*> frozen_callstack_events_of_all_threads_;
+  TimestampBucketPyramid frozen_pyramid_of_all_threads_;
 
   uint64_t max_time_ = 0;
   uint64_t min_time_ = std::numeric_limits<uint64_t>::max();
@@ -11,8 +11,10 @@
 #include <absl/synchronization/mutex.h>
 #include <absl/time/clock.h>
 #include <absl/time/time.h>
+#include <absl/types/span.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <filesystem>
@@ -122,27 +124,48 @@ class CaptureData {
     thread_names_.insert_or_assign(thread_id, std::move(thread_name));
   }
 
-  [[nodiscard]] bool HasThreadStatesForThread(uint32_t tid) const {
-    absl::MutexLock lock{&thread_state_slices_mutex_};
-    return thread_state_slices_.count(tid) > 0;
-  }
+  [[nodiscard]] bool HasThreadStatesForThread(uint32_t tid) const;
 
   void AddThreadStateSlice(ThreadStateSliceInfo state_slice) {
     absl::MutexLock lock{&thread_state_slices_mutex_};
+    ORBIT_CHECK(!thread_state_slices_are_frozen_.load(std::memory_order_relaxed));
     thread_state_slices_[state_slice.tid()].emplace_back(state_slice);
   }
 
+  void AddThreadStateSlices(absl::Span<const ThreadStateSliceInfo> state_slices) {
+    absl::MutexLock lock{&thread_state_slices_mutex_};
+    ORBIT_CHECK(!thread_state_slices_are_frozen_.load(std::memory_order_relaxed));
+    for (const ThreadStateSliceInfo& state_slice : state_slices) {
+      thread_state_slices_[state_slice.tid()].emplace_back(state_slice);
+    }
+  }
+
   // Allows the caller to iterate `action` over all the thread state slices of the specified thread
   // in the time range while holding for the whole time the internal mutex, acquired only once.
   void ForEachThreadStateSliceIntersectingTimeRange(
       uint32_t thread_id, uint64_t min_timestamp, uint64_t max_timestamp,
       const std::function<void(const ThreadStateSliceInfo&)>& action) const;
 
+  // Calls `action` on all the thread state slices of all threads, while holding the internal mutex.
+  void ForEachThreadStateSlice(
+      const std::function<void(const ThreadStateSliceInfo&)>& action) const;
+
   // Similar to the previous one, but does not iterate over more than one slice per pixel.
   void ForEachThreadStateSliceIntersectingTimeRangeDiscretized(
       uint32_t thread_id, uint64_t min_timestamp, uint64_t max_timestamp, uint32_t resolution,
       const std::function<void(const ThreadStateSliceInfo&)>& action) const;
 
+  // The off-CPU time that OrbitService summarized instead of sending the thread state slices, see
+  // CaptureOptions.off_cpu_time_aggregation_interval_ns.
+  void AddOffCpuTimeSummary(orbit_grpc_protos::OffCpuTimeSummary off_cpu_time_summary) {
+    absl::MutexLock lock{&off_cpu_time_summaries_mutex_};
+    off_cpu_time_summaries_.emplace_back(std::move(off_cpu_time_summary));
+  }
+
+  // Calls `action` on all the off-CPU time summaries, while holding the internal mutex.
+  void ForEachOffCpuTimeSummary(
+      const std::function<void(const orbit_grpc_protos::OffCpuTimeSummary&)>& action) const;
+
   [[nodiscard]] const ScopeStats& GetScopeStatsOrDefault(ScopeId scope_id) const;
 
   void UpdateScopeStats(const TimerInfo& timer_info);
@@ -150,7 +173,14 @@ class CaptureData {
 
   void OnCaptureComplete();
 
+  // Returns an estimate of the memory held by the timers, the callstack events and the thread state
+  // slices, which are what grows with the length of the capture. Thread-safe.
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const;
+
   [[nodiscard]] const CallstackData& GetCallstackData() const { return callstack_data_; };
+  [[nodiscard]] const CallstackData& GetPageFaultCallstackData() const {
+    return page_fault_callstack_data_;
+  }
 
   [[nodiscard]] const TracepointInfo* GetTracepointInfo(uint64_t tracepoint_id) const {
     return tracepoint_data_.GetTracepointInfo(tracepoint_id);
@@ -163,6 +193,13 @@ class CaptureData {
                                                                       action);
   }
 
+  void ForEachTracepointEventOfThreadInTimeRangeDiscretized(
+      uint32_t thread_id, uint64_t min_tick, uint64_t max_tick, uint32_t resolution,
+      const std::function<void(const TracepointEventInfo&)>& action) const {
+    return tracepoint_data_.ForEachTracepointEventOfThreadInTimeRangeDiscretized(
+        thread_id, min_tick, max_tick, resolution, action);
+  }
+
   uint32_t GetNumTracepointsForThreadId(uint32_t thread_id) const {
     return tracepoint_data_.GetNumTracepointEventsForThreadId(thread_id);
   }
@@ -177,6 +214,16 @@ class CaptureData {
     callstack_data_.AddCallstackEvent(callstack_event);
   }
 
+  void AddCallstackEvents(absl::Span<const orbit_client_data::CallstackEvent> callstack_events) {
+    callstack_data_.AddCallstackEvents(callstack_events);
+  }
+
+  // The callstack of `callstack_event` must already have been added with AddUniqueCallstack.
+  void AddPageFaultCallstackEvent(orbit_client_data::CallstackEvent callstack_event) {
+    page_fault_callstack_data_.AddCallstackFromKnownCallstackData(callstack_event,
+                                                                  callstack_data_);
+  }
+
   void FilterBrokenCallstacks();
 
   void AddUniqueTracepointInfo(uint64_t tracepoint_id, TracepointInfo tracepoint_info) {
@@ -234,6 +281,16 @@ class CaptureData {
     incomplete_data_intervals_.Add(start_timestamp_ns, end_timestamp_ns);
   }
 
+  [[nodiscard]] const std::optional<orbit_grpc_protos::PerfEventProcessingStatsEvent>&
+  perf_event_processing_stats() const {
+    return perf_event_processing_stats_;
+  }
+
+  void set_perf_event_processing_stats(
+      orbit_grpc_protos::PerfEventProcessingStatsEvent perf_event_processing_stats) {
+    perf_event_processing_stats_ = std::move(perf_event_processing_stats);
+  }
+
   void EnableFrameTrack(uint64_t instrumented_function_id);
   void DisableFrameTrack(uint64_t instrumented_function_id);
   [[nodiscard]] bool IsFrameTrackEnabled(uint64_t instrumented_function_id) const;
@@ -272,6 +329,14 @@ class CaptureData {
       uint64_t min_tick = std::numeric_limits<uint64_t>::min(),
       uint64_t max_tick = std::numeric_limits<uint64_t>::max(), bool exclusive = false) const;
 
+  // Returns the timers of type `type` that are not stored in ThreadTracks, e.g., the scheduling
+  // slices (kCoreActivity) or the GPU jobs.
+  [[nodiscard]] std::vector<const TimerInfo*> GetTimersByType(
+      TimerInfo::Type type, uint64_t min_tick = std::numeric_limits<uint64_t>::min(),
+      uint64_t max_tick = std::numeric_limits<uint64_t>::max()) const {
+    return timer_data_manager_.GetTimers(type, min_tick, max_tick);
+  }
+
   [[nodiscard]] std::vector<const TimerInfo*> GetTimersForScope(
       ScopeId scope_id, uint64_t min_tick = std::numeric_limits<uint64_t>::min(),
       uint64_t max_tick = std::numeric_limits<uint64_t>::max()) const;
@@ -288,6 +353,22 @@ class CaptureData {
   [[nodiscard]] std::shared_ptr<const ScopeStatsCollection> GetAllScopeStatsCollection() const;
 
  private:
+  using ThreadStateSlicesByTid = absl::flat_hash_map<uint32_t, std::vector<ThreadStateSliceInfo>>;
+
+  // Calls `visitor` with `thread_state_slices_`, holding the mutex, or, once the capture is
+  // complete, with `frozen_thread_state_slices_`, without locking.
+  template <typename Visitor>
+  auto VisitThreadStateSlices(Visitor&& visitor) const {
+    if (!thread_state_slices_are_frozen_.load(std::memory_order_acquire)) {
+      absl::MutexLock lock{&thread_state_slices_mutex_};
+      // OnCaptureComplete might have run while waiting for the mutex.
+      if (!thread_state_slices_are_frozen_.load(std::memory_order_relaxed)) {
+        return std::invoke(visitor, thread_state_slices_);
+      }
+    }
+    return std::invoke(visitor, frozen_thread_state_slices_);
+  }
+
   orbit_grpc_protos::CaptureStarted capture_started_;
 
   orbit_client_data::ProcessData process_;
@@ -298,6 +379,9 @@ class CaptureData {
   CallstackData callstack_data_;
   std::optional<PostProcessedSamplingData> post_processed_sampling_data_;
 
+  // The callstacks of the sampled page faults. They share the unique callstacks of callstack_data_.
+  CallstackData page_fault_callstack_data_;
+
   // selection_callstack_data_ is subset of callstack_data_.
   // TODO(b/215667641): The callstack selection should be stored in the DataManager.
   std::unique_ptr<orbit_client_data::CallstackData> selection_callstack_data_;
@@ -309,13 +393,21 @@ class CaptureData {
 
   absl::flat_hash_map<uint32_t, std::string> thread_names_;
 
-  // For each thread, assume sorted by timestamp and not overlapping.
-  absl::flat_hash_map<uint32_t, std::vector<ThreadStateSliceInfo>> thread_state_slices_
-      ABSL_GUARDED_BY(thread_state_slices_mutex_);
+  // For each thread, assume sorted by timestamp and not overlapping. OnCaptureComplete moves the
+  // slices to `frozen_thread_state_slices_`, which is read without locking from then on.
+  ThreadStateSlicesByTid thread_state_slices_ ABSL_GUARDED_BY(thread_state_slices_mutex_);
   mutable absl::Mutex thread_state_slices_mutex_;
+  std::atomic<bool> thread_state_slices_are_frozen_ = false;
+  ThreadStateSlicesByTid frozen_thread_state_slices_;
+
+  std::vector<orbit_grpc_protos::OffCpuTimeSummary> off_cpu_time_summaries_
+      ABSL_GUARDED_BY(off_cpu_time_summaries_mutex_);
+  mutable absl::Mutex off_cpu_time_summaries_mutex_;
 
   // Only access this field from the main thread.
   orbit_client_data::TimestampIntervalSet incomplete_data_intervals_;
+  // Only access this field from the main thread.
+  std::optional<orbit_grpc_protos::PerfEventProcessingStatsEvent> perf_event_processing_stats_;
 
   absl::Time capture_start_time_ = absl::Now();
 
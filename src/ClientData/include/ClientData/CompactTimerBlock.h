@@ -0,0 +1,77 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_COMPACT_TIMER_BLOCK_H_
+#define CLIENT_DATA_COMPACT_TIMER_BLOCK_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <vector>
+
+#include "ClientProtos/capture_data.pb.h"
+#include "OrbitBase/Logging.h"
+
+namespace orbit_client_data {
+
+// Struct-of-arrays alternative to TimerBlock (see TimerChain.h). The fields that almost all timers
+// set (start, end, process and thread id, processor, function id, depth and type) are stored in
+// packed columns, which take 41 bytes per timer, about a quarter of the size of a TimerInfo.
+// Timers that set any other field, like a callstack id, registers, a color or an API scope name,
+// are additionally kept whole in a side table. TimerInfos are only materialized by GetTimerInfo.
+//
+// Unlike TimerBlock, this can't hand out references to stored TimerInfos.
+class CompactTimerBlock {
+ public:
+  static constexpr size_t kCapacity = 1024;
+
+  CompactTimerBlock();
+
+  void Add(const orbit_client_protos::TimerInfo& timer_info);
+
+  [[nodiscard]] size_t size() const { return starts_.size(); }
+  [[nodiscard]] bool at_capacity() const { return size() == kCapacity; }
+
+  // Tests if [min, max] intersects with the time range of the timers added so far, see
+  // TimerBlock::Intersects.
+  [[nodiscard]] bool Intersects(uint64_t min, uint64_t max) const {
+    return min <= max_timestamp_ && max >= min_timestamp_;
+  }
+  [[nodiscard]] uint64_t MinTimestamp() const { return min_timestamp_; }
+
+  [[nodiscard]] uint64_t GetStart(size_t index) const { return starts_[index]; }
+  [[nodiscard]] uint64_t GetEnd(size_t index) const { return ends_[index]; }
+  [[nodiscard]] uint32_t GetThreadId(size_t index) const { return thread_ids_[index]; }
+  [[nodiscard]] uint64_t GetFunctionId(size_t index) const { return function_ids_[index]; }
+  [[nodiscard]] uint32_t GetDepth(size_t index) const { return depths_[index]; }
+  [[nodiscard]] orbit_client_protos::TimerInfo::Type GetType(size_t index) const {
+    return static_cast<orbit_client_protos::TimerInfo::Type>(types_[index]);
+  }
+
+  [[nodiscard]] orbit_client_protos::TimerInfo GetTimerInfo(size_t index) const;
+
+  // Assuming timers are sorted, returns the index of the first one for which the end timestamp
+  // isn't smaller than min_ns, or size() if there is none.
+  [[nodiscard]] size_t LowerBound(uint64_t min_ns) const;
+
+ private:
+  std::vector<uint64_t> starts_;
+  std::vector<uint64_t> ends_;
+  std::vector<uint64_t> function_ids_;
+  std::vector<uint32_t> process_ids_;
+  std::vector<uint32_t> thread_ids_;
+  std::vector<uint32_t> depths_;
+  std::vector<int32_t> processors_;
+  std::vector<uint8_t> types_;
+  absl::flat_hash_map<uint32_t, orbit_client_protos::TimerInfo> timers_with_rare_fields_;
+
+  uint64_t min_timestamp_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_timestamp_ = std::numeric_limits<uint64_t>::min();
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_COMPACT_TIMER_BLOCK_H_
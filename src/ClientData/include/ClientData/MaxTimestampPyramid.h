@@ -0,0 +1,75 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_MAX_TIMESTAMP_PYRAMID_H_
+#define CLIENT_DATA_MAX_TIMESTAMP_PYRAMID_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "Containers/AppendOnlyVector.h"
+
+namespace orbit_client_data {
+
+// Keeps an append-only sequence of timestamps, e.g. the maximum end timestamps of the blocks of a
+// TimerChain, at decreasing resolutions: level 0 holds the timestamps themselves, and each
+// timestamp of level l + 1 is the maximum of kFanout consecutive timestamps of level l.
+// FindFirstAtLeast uses the coarser levels to skip whole runs of timestamps that are too small, so
+// that its cost is logarithmic rather than linear in the number of timestamps.
+//
+// One thread can append and raise timestamps while others call FindFirstAtLeast without locking.
+// Such a concurrent search might miss the timestamps being changed at the same time, but sees all
+// the others.
+//
+// Example usage:
+//
+// MaxTimestampPyramid pyramid;
+// pyramid.Append(10);
+// pyramid.Append(20);
+// pyramid.RaiseLast(30);
+// pyramid.FindFirstAtLeast(15, 0);  // Returns 1.
+// pyramid.FindFirstAtLeast(35, 0);  // Returns 2, the size.
+class MaxTimestampPyramid {
+ public:
+  static constexpr size_t kFanout = 16;
+
+  MaxTimestampPyramid() { levels_[0] = std::make_unique<Level>(); }
+
+  void Append(uint64_t timestamp_ns);
+  // Sets the last timestamp to `timestamp_ns` if that is greater. There must be at least one.
+  void RaiseLast(uint64_t timestamp_ns);
+
+  [[nodiscard]] size_t size() const { return levels_[0]->size(); }
+
+  // Returns the index of the first timestamp at or after `first_index` that is not smaller than
+  // `min_timestamp_ns`, or size() if there is none.
+  [[nodiscard]] size_t FindFirstAtLeast(uint64_t min_timestamp_ns, size_t first_index) const;
+
+ private:
+  using Level = orbit_containers::AppendOnlyVector<std::atomic<uint64_t>>;
+  // kFanout^kMaxLevels timestamps are more than a uint64_t can count.
+  static constexpr size_t kMaxLevels = 16;
+
+  [[nodiscard]] uint64_t Get(size_t level, size_t index) const {
+    return (*levels_[level])[index].load(std::memory_order_acquire);
+  }
+  static void Raise(std::atomic<uint64_t>& timestamp, uint64_t timestamp_ns) {
+    if (timestamp.load(std::memory_order_relaxed) < timestamp_ns) {
+      timestamp.store(timestamp_ns, std::memory_order_release);
+    }
+  }
+
+  // levels_[0] holds all timestamps, and the last of the `num_levels_` levels only one, the maximum
+  // of all of them. A level is created before `num_levels_` is increased.
+  std::array<std::unique_ptr<Level>, kMaxLevels> levels_;
+  std::atomic<size_t> num_levels_{1};
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_MAX_TIMESTAMP_PYRAMID_H_
@@ -18,6 +18,7 @@
 #include <utility>
 #include <vector>
 
+#include "ClientData/AddressRangeIndex.h"
 #include "ClientData/FunctionInfo.h"
 #include "ClientData/ModuleIdentifier.h"
 #include "GrpcProtos/module.pb.h"
@@ -31,6 +32,9 @@ namespace orbit_client_data {
 // Represents information about a module on the client. This class if fully synchronized.
 class ModuleData final {
  public:
+  // Maps virtual addresses to the functions containing them.
+  using FunctionIndex = AddressRangeIndex<const FunctionInfo*>;
+
   explicit ModuleData(orbit_grpc_protos::ModuleInfo module_info);
 
   [[nodiscard]] const std::string& name() const;
@@ -52,8 +56,12 @@ class ModuleData final {
   // and false if the module cannot be updated because symbols are already loaded.
   [[nodiscard]] bool UpdateIfChangedAndNotLoaded(orbit_grpc_protos::ModuleInfo new_module_info);
 
+  // Doesn't take the mutex, as it reads the current FunctionIndex.
   [[nodiscard]] const FunctionInfo* FindFunctionByVirtualAddress(uint64_t virtual_address,
                                                                  bool is_exact) const;
+  // Returns a snapshot of the index of the loaded functions, for lookups without any locking, e.g.,
+  // with FunctionIndex::FindBatch. The FunctionInfos are valid until symbols are replaced.
+  [[nodiscard]] std::shared_ptr<const FunctionIndex> GetFunctionIndex() const;
   [[nodiscard]] const FunctionInfo* FindFunctionFromHash(uint64_t hash) const;
   [[nodiscard]] const FunctionInfo* FindFunctionFromPrettyName(std::string_view pretty_name) const;
   [[nodiscard]] std::vector<const FunctionInfo*> GetFunctions() const;
@@ -75,6 +83,8 @@ class ModuleData final {
 
   void AddSymbolsInternal(const orbit_grpc_protos::ModuleSymbols& module_symbols,
                           SymbolCompleteness completeness);
+  // Publishes a new FunctionIndex for the current functions_.
+  void UpdateFunctionIndex();
 
   mutable absl::Mutex mutex_;
   orbit_grpc_protos::ModuleInfo module_info_ ABSL_GUARDED_BY(mutex_);
@@ -82,8 +92,9 @@ class ModuleData final {
   SymbolCompleteness loaded_symbols_completeness_ ABSL_GUARDED_BY(mutex_) =
       SymbolCompleteness::kNoSymbols;
   std::map<uint64_t, std::unique_ptr<FunctionInfo>> functions_ ABSL_GUARDED_BY(mutex_);
-  mutable absl::flat_hash_map<uint64_t, FunctionInfo*> absolute_address_to_function_info_cache_
-      ABSL_GUARDED_BY(mutex_);
+  // Rebuilt from functions_ whenever they change, and only accessed with std::atomic_load and
+  // std::atomic_store.
+  std::shared_ptr<const FunctionIndex> function_index_ = std::make_shared<const FunctionIndex>();
   absl::flat_hash_map<std::string_view, FunctionInfo*> name_to_function_info_map_
       ABSL_GUARDED_BY(mutex_);
 
@@ -31,6 +31,9 @@
 
 namespace orbit_client_data {
 
+// Thread-safety: This class is thread-safe. Lookups don't take the mutex that serializes the
+// updates. They read an immutable snapshot of the module table instead, which the updates publish.
+// ModuleData objects are never removed, so the returned pointers stay valid.
 class ModuleManager final {
  public:
   explicit ModuleManager(ModuleIdentifierProvider* module_identifier_provider)
@@ -72,19 +75,30 @@ class ModuleManager final {
       std::string_view filename) const;
 
  private:
-  [[nodiscard]] const ModuleData* GetModuleByModuleIdentifierInternal(
-      orbit_client_data::ModuleIdentifier module_id) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
-  [[nodiscard]] ModuleData* GetMutableModuleByModuleIdentifierInternal(
-      orbit_client_data::ModuleIdentifier module_id) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  using ModuleTable = absl::flat_hash_map<orbit_client_data::ModuleIdentifier, ModuleData*>;
+
+  // Publishes a new ModuleTable for the current module_map_.
+  void UpdateModuleTable() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] std::shared_ptr<const ModuleTable> GetModuleTable() const;
+  [[nodiscard]] ModuleData* FindModuleByModuleIdentifier(
+      orbit_client_data::ModuleIdentifier module_id) const;
+  [[nodiscard]] ModuleData* FindModuleByModuleInMemoryAndAbsoluteAddress(
+      const ModuleInMemory& module_in_memory, uint64_t absolute_address) const;
 
   mutable absl::Mutex mutex_;
-  ModuleIdentifierProvider* module_identifier_provider_ ABSL_GUARDED_BY(mutex_);
-  // We are sharing pointers to that entries and ensure reference stability by using node_hash_map
+  ModuleIdentifierProvider* module_identifier_provider_;
+  // We are sharing pointers to that entries and ensure reference stability by using unique_ptrs.
   // Map of ModuleIdentifier -> ModuleData (ModuleIdentifier is file_path and build_id)
   absl::flat_hash_map<orbit_client_data::ModuleIdentifier, std::unique_ptr<ModuleData>> module_map_
       ABSL_GUARDED_BY(mutex_);
+  // Rebuilt whenever modules get added to module_map_, and only accessed with std::atomic_load and
+  // std::atomic_store.
+  std::shared_ptr<const ModuleTable> module_table_ = std::make_shared<const ModuleTable>();
+
+  // Separate from mutex_, so that the lookups by address don't wait for updates of the modules.
+  mutable absl::Mutex absolute_address_cache_mutex_;
   mutable absl::flat_hash_map<uint64_t, ModuleData*> absolute_address_to_module_data_cache_
-      ABSL_GUARDED_BY(mutex_);
+      ABSL_GUARDED_BY(absolute_address_cache_mutex_);
 };
 
 }  // namespace orbit_client_data
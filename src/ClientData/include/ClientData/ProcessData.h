@@ -23,6 +23,7 @@
 #include <utility>
 #include <vector>
 
+#include "ClientData/AddressRangeIndex.h"
 #include "ClientData/ModuleData.h"
 #include "ClientData/ModuleIdentifier.h"
 #include "ClientData/ModuleIdentifierProvider.h"
@@ -39,6 +40,9 @@ namespace orbit_client_data {
 // Contains current information about process
 class ProcessData final {
  public:
+  // Maps absolute addresses to the modules loaded there.
+  using ModuleIndex = AddressRangeIndex<ModuleInMemory>;
+
   explicit ProcessData(orbit_grpc_protos::ProcessInfo process_info,
                        const ModuleIdentifierProvider* module_identifier_provider)
       : process_info_(std::move(process_info)),
@@ -62,7 +66,11 @@ class ProcessData final {
   // intersecting with exiting mapping the old module was likely unloaded.
   void AddOrUpdateModuleInfo(const orbit_grpc_protos::ModuleInfo& module_info);
 
+  // Only takes the mutex when no module is found, as it reads the current ModuleIndex.
   [[nodiscard]] ErrorMessageOr<ModuleInMemory> FindModuleByAddress(uint64_t absolute_address) const;
+  // Returns a snapshot of the index of the loaded modules, for lookups without any locking, e.g.,
+  // with ModuleIndex::FindBatch.
+  [[nodiscard]] std::shared_ptr<const ModuleIndex> GetModuleIndex() const;
 
   // Returns module base addresses. Note that the same module could be mapped twice in which case
   // this function returns two base addresses. If no module found the function returns empty vector.
@@ -87,11 +95,15 @@ class ProcessData final {
       orbit_client_data::ModuleIdentifier module_identifier) const;
 
  private:
+  // Publishes a new ModuleIndex for the current start_address_to_module_in_memory_.
+  void UpdateModuleIndex();
+
   mutable absl::Mutex mutex_;
   orbit_grpc_protos::ProcessInfo process_info_ ABSL_GUARDED_BY(mutex_);
   std::map<uint64_t, ModuleInMemory> start_address_to_module_in_memory_ ABSL_GUARDED_BY(mutex_);
-  mutable absl::flat_hash_map<uint64_t, ModuleInMemory> absolute_address_to_module_in_memory_cache_
-      ABSL_GUARDED_BY(mutex_);
+  // Rebuilt whenever start_address_to_module_in_memory_ changes, and only accessed with
+  // std::atomic_load and std::atomic_store.
+  std::shared_ptr<const ModuleIndex> module_index_ = std::make_shared<const ModuleIndex>();
 
   const ModuleIdentifierProvider* module_identifier_provider_;
 };
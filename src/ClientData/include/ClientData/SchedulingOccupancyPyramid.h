@@ -0,0 +1,84 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_SCHEDULING_OCCUPANCY_PYRAMID_H_
+#define CLIENT_DATA_SCHEDULING_OCCUPANCY_PYRAMID_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <optional>
+#include <vector>
+
+#include "ClientProtos/capture_data.pb.h"
+
+namespace orbit_client_data {
+
+// Summarizes the scheduling slices of each core at several resolutions, so that a zoomed-out
+// scheduler track draws one box per pixel from a few buckets instead of looking at the slices.
+// The time is cut into buckets of 2^shift nanoseconds, and each bucket records how long the core
+// was busy in it and the slice that overlaps it the most, whose thread and process are considered
+// the dominant ones. Slices are added incrementally as they arrive, and the buckets of all
+// resolutions are updated at once; queries can run concurrently with additions.
+//
+// Example usage:
+//
+// SchedulingOccupancyPyramid pyramid;
+// pyramid.AddSlice(slice);  // A slice keeps its core in TimerInfo::processor().
+// std::optional<std::vector<PixelOccupancy>> pixels =
+//     pyramid.GetPixelOccupancies(core, min_ns, max_ns, resolution);
+class SchedulingOccupancyPyramid {
+ public:
+  // Each resolution has buckets 2^kLevelShift times wider than the one before. Buckets of ~4ms
+  // keep the memory below that of the slices themselves on a busy core.
+  static constexpr uint32_t kFinestBucketShift = 22;
+  static constexpr uint32_t kLevelShift = 2;
+  static constexpr uint32_t kCoarsestBucketShift = 40;
+  static constexpr size_t kLevelCount =
+      (kCoarsestBucketShift - kFinestBucketShift) / kLevelShift + 1;
+
+  struct PixelOccupancy {
+    // [start_ns, end_ns) is the time range of the pixel.
+    uint64_t start_ns;
+    uint64_t end_ns;
+    // Between 0 and 1.
+    float busy_fraction;
+    const orbit_client_protos::TimerInfo* dominant_slice;
+  };
+
+  // `slice` needs to outlive the pyramid.
+  void AddSlice(const orbit_client_protos::TimerInfo& slice);
+
+  // Whether the pixels of [min_ns, max_ns) are at least as wide as the finest buckets.
+  [[nodiscard]] static bool CanSummarizePixels(uint64_t min_ns, uint64_t max_ns,
+                                               uint32_t resolution);
+
+  // Returns the occupancy of `core` in each pixel of [min_ns, max_ns) in which it was busy, with
+  // pixels as in GetPixelNumber. A bucket is attributed to the pixel it starts in, so the result
+  // is only as precise as the buckets, which are at most as wide as a pixel. Returns nullopt if
+  // !CanSummarizePixels, in which case the slices should be drawn instead.
+  [[nodiscard]] std::optional<std::vector<PixelOccupancy>> GetPixelOccupancies(
+      uint32_t core, uint64_t min_ns, uint64_t max_ns, uint32_t resolution) const;
+
+ private:
+  struct Bucket {
+    // The bucket is [number << shift, (number + 1) << shift).
+    uint64_t number;
+    uint64_t busy_ns;
+    uint64_t dominant_ns;
+    const orbit_client_protos::TimerInfo* dominant_slice;
+  };
+  // Only the non-empty buckets, sorted by number.
+  using Levels = std::array<std::vector<Bucket>, kLevelCount>;
+
+  mutable absl::Mutex mutex_;
+  std::vector<Levels> levels_by_core_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_SCHEDULING_OCCUPANCY_PYRAMID_H_
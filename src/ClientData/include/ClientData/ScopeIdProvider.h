@@ -10,6 +10,8 @@
 #include <absl/hash/hash.h>
 #include <absl/synchronization/mutex.h>
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -57,6 +59,11 @@ class ScopeIdProvider {
 // timers based on the equality of their names and types. Two timers are provided with the same ids
 // if and only if they share the name and the type. Currently this is only implemented for manual
 // instrumentation scopes, both sync and async.
+//
+// Timers whose name was interned (`api_scope_name_key` is set) are first looked up by that key in
+// a fixed-size cache of atomic slots, without constructing a `ScopeInfo` or taking the lock. The
+// slots are only written under the lock, once the id of a name key is known, and never change
+// afterwards. When the cache is half full, the remaining name keys take the slower path.
 class NameEqualityScopeIdProvider : public ScopeIdProvider {
  public:
   // Ids for instrumented functions are precomputed on capture start and we are using id range above
@@ -100,12 +107,29 @@ class NameEqualityScopeIdProvider : public ScopeIdProvider {
   [[nodiscard]] std::optional<ScopeId> GetExistingScopeId(const ScopeInfo& scope_info) const
       ABSL_SHARED_LOCKS_REQUIRED(mutex_);
 
+  // A slot of the name key cache. A `key` of 0 marks an empty slot, an id of 0 an id that is not
+  // known yet, as interned name keys and the ids of manual instrumentation scopes are never 0.
+  struct NameKeyCacheSlot {
+    std::atomic<uint64_t> key = 0;
+    std::atomic<uint64_t> api_scope_id = 0;
+    std::atomic<uint64_t> api_scope_async_id = 0;
+  };
+  static constexpr size_t kNameKeyCacheCapacity = 4096;
+
+  [[nodiscard]] std::optional<ScopeId> FindCachedScopeId(uint64_t name_key,
+                                                         ScopeType scope_type) const;
+  void CacheScopeId(uint64_t name_key, ScopeType scope_type, ScopeId scope_id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   ScopeId next_id_ ABSL_GUARDED_BY(mutex_){};
   ScopeId max_instrumented_function_id_{};
   absl::flat_hash_map<const ScopeInfo, ScopeId> scope_info_to_id_ ABSL_GUARDED_BY(mutex_);
   absl::flat_hash_map<ScopeId, const ScopeInfo> scope_id_to_info_ ABSL_GUARDED_BY(mutex_);
   /// TODO(http://b/247467504): Add FunctionInfo to ScopeInfo.
   absl::flat_hash_map<ScopeId, FunctionInfo> scope_id_to_function_info_;
+  std::unique_ptr<NameKeyCacheSlot[]> name_key_cache_ =
+      std::make_unique<NameKeyCacheSlot[]>(kNameKeyCacheCapacity);
+  size_t name_key_cache_size_ ABSL_GUARDED_BY(mutex_) = 0;
   mutable absl::Mutex mutex_;
 };
 
@@ -8,12 +8,17 @@
 
 #include <cmath>
 
+#include "Statistics/LogLinearHistogram.h"
+
 namespace orbit_client_data {
 
 // A simple class that keeps track of some basic statistics for a particular scope id (e.g. a
 // particular function).
 // Usage: Whenever we have a new occurrence of a particular scope, `UpdateStats` needs to be called
 // with the respective duration.
+// Percentiles are estimated from a histogram of the durations that `UpdateStats` maintains, so they
+// are available while capturing, without keeping and sorting all durations. The setters don't
+// update the histogram.
 class ScopeStats {
  public:
   explicit ScopeStats() = default;
@@ -42,12 +47,19 @@ class ScopeStats {
     return static_cast<uint64_t>(std::sqrt(variance_ns()));
   }
 
+  // Returns an estimate of the duration below which `percentile` percent of the durations are, e.g.
+  // the median for 50. `percentile` must be in [0, 100].
+  [[nodiscard]] uint64_t ComputePercentileNs(double percentile) const {
+    return duration_histogram_.ComputeQuantile(percentile / 100.0);
+  }
+
  private:
   uint64_t count_{};
   uint64_t total_time_ns_{};
   uint64_t min_ns_{};
   uint64_t max_ns_{};
   double variance_ns_{};
+  orbit_statistics::LogLinearHistogram duration_histogram_;
 };
 
 }  // namespace orbit_client_data
@@ -0,0 +1,65 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_SCOPE_TIMER_INDEX_H_
+#define CLIENT_DATA_SCOPE_TIMER_INDEX_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <optional>
+#include <vector>
+
+#include "ClientData/ScopeId.h"
+#include "ClientProtos/capture_data.pb.h"
+
+namespace orbit_client_data {
+
+// Index of the timers of each scope, sorted by end timestamp, in total and per thread. It allows
+// jumping to the next or previous timer of a scope, and iterating over the timers of a scope,
+// without going through all the timers of the capture. The timers are built incrementally: as they
+// mostly arrive in order of end, adding one is amortized constant time. The timers are not owned
+// and need to outlive the index. Thread-safe.
+class ScopeTimerIndex {
+ public:
+  void Add(ScopeId scope_id, const orbit_client_protos::TimerInfo& timer_info);
+
+  // Returns the timer of `scope_id`, on `thread_id` if specified, with the earliest end after
+  // `time`, or nullptr if there is none. Among timers with the same end, the first added is
+  // returned.
+  [[nodiscard]] const orbit_client_protos::TimerInfo* FindNext(
+      ScopeId scope_id, uint64_t time, std::optional<uint32_t> thread_id = std::nullopt) const;
+  // Returns the timer of `scope_id`, on `thread_id` if specified, with the latest end before
+  // `time`, or nullptr if there is none. Among timers with the same end, the first added is
+  // returned.
+  [[nodiscard]] const orbit_client_protos::TimerInfo* FindPrevious(
+      ScopeId scope_id, uint64_t time, std::optional<uint32_t> thread_id = std::nullopt) const;
+
+  // Returns the timers of `scope_id` sorted by end.
+  [[nodiscard]] std::vector<const orbit_client_protos::TimerInfo*> GetTimers(
+      ScopeId scope_id) const;
+
+ private:
+  struct Entry {
+    uint64_t end;
+    const orbit_client_protos::TimerInfo* timer_info;
+  };
+  struct ScopeEntries {
+    std::vector<Entry> all_threads;
+    absl::flat_hash_map<uint32_t, std::vector<Entry>> by_thread_id;
+  };
+
+  [[nodiscard]] const std::vector<Entry>* GetEntries(ScopeId scope_id,
+                                                     std::optional<uint32_t> thread_id) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<ScopeId, ScopeEntries> scope_id_to_entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_SCOPE_TIMER_INDEX_H_
@@ -66,6 +66,11 @@ class ScopeTreeTimerData final : public TimerDataInterface {
     return scope_tree_.Depth();
   }
   [[nodiscard]] uint32_t GetProcessId() const override { return timer_data_.GetProcessId(); }
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const {
+    const uint64_t timer_data_memory_usage_bytes = timer_data_.GetMemoryUsageBytes();
+    absl::MutexLock lock(&scope_tree_mutex_);
+    return timer_data_memory_usage_bytes + scope_tree_.GetMemoryUsageBytes();
+  }
   [[nodiscard]] int64_t GetThreadId() const override { return thread_id_; }
 
   // Relative timers queries
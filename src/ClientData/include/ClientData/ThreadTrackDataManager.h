@@ -64,6 +64,15 @@ class ThreadTrackDataManager final {
     return all_scope_tree_timer_data;
   }
 
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const {
+    absl::MutexLock lock(&mutex_);
+    uint64_t memory_usage_bytes = 0;
+    for (const auto& [unused_tid, scope_tree_timer_data] : scope_tree_timer_data_map_) {
+      memory_usage_bytes += scope_tree_timer_data->GetMemoryUsageBytes();
+    }
+    return memory_usage_bytes;
+  }
+
  private:
   mutable absl::Mutex mutex_;
   absl::flat_hash_map<uint32_t, std::unique_ptr<ScopeTreeTimerData>> scope_tree_timer_data_map_
@@ -10,10 +10,12 @@
 
 #include <limits>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
 #include "ClientData/ScopeId.h"
+#include "ClientData/ScopeTimerIndex.h"
 #include "ClientData/ScopeTreeTimerData.h"
 #include "ClientData/ThreadTrackDataManager.h"
 #include "ClientData/TimerChain.h"
@@ -30,10 +32,17 @@ class ThreadTrackDataProvider final {
       : thread_track_data_manager_{
             std::make_unique<ThreadTrackDataManager>(is_data_from_saved_capture)} {};
 
-  const orbit_client_protos::TimerInfo& AddTimer(orbit_client_protos::TimerInfo timer_info) {
-    return thread_track_data_manager_->AddTimer(std::move(timer_info));
+  // If `scope_id` is given, the timer is also added to the ScopeTimerIndex.
+  const orbit_client_protos::TimerInfo& AddTimer(orbit_client_protos::TimerInfo timer_info,
+                                                 std::optional<ScopeId> scope_id = std::nullopt) {
+    const orbit_client_protos::TimerInfo& added_timer_info =
+        thread_track_data_manager_->AddTimer(std::move(timer_info));
+    if (scope_id.has_value()) scope_timer_index_.Add(scope_id.value(), added_timer_info);
+    return added_timer_info;
   }
 
+  [[nodiscard]] const ScopeTimerIndex& GetScopeTimerIndex() const { return scope_timer_index_; }
+
   const ScopeTreeTimerData* CreateScopeTreeTimerData(uint32_t thread_id) {
     return thread_track_data_manager_->CreateScopeTreeTimerData(thread_id);
   }
@@ -96,6 +105,10 @@ class ThreadTrackDataProvider final {
   [[nodiscard]] const orbit_client_protos::TimerInfo* GetDown(
       const orbit_client_protos::TimerInfo& timer) const;
 
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const {
+    return thread_track_data_manager_->GetMemoryUsageBytes();
+  }
+
   void OnCaptureComplete();
 
  private:
@@ -104,6 +117,7 @@ class ThreadTrackDataProvider final {
   }
 
   std::unique_ptr<ThreadTrackDataManager> thread_track_data_manager_;
+  ScopeTimerIndex scope_timer_index_;
 };
 
 }  // namespace orbit_client_data
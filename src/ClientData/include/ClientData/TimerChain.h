@@ -14,7 +14,9 @@
 #include <utility>
 #include <vector>
 
+#include "ClientData/MaxTimestampPyramid.h"
 #include "ClientProtos/capture_data.pb.h"
+#include "Containers/AppendOnlyVector.h"
 #include "OrbitBase/Logging.h"
 
 namespace orbit_client_data {
@@ -24,6 +26,9 @@ namespace orbit_client_data {
 // trivial rejection of an entire block by using the Intersects(t_min, t_max) method. This
 // effectively tests if any of the timers stored in this block intersects with the [t_min, t_max]
 // interval.
+// The storage of the timers is reserved up front and never moves, and the size is published with
+// release semantics after a timer is added, so readers can access the timers below size() while
+// the chain's writer adds more.
 class TimerBlock {
   friend class TimerChain;
   friend class TimerChainIterator;
@@ -40,11 +45,15 @@ class TimerBlock {
   // Append a new element to the end of the block using placement-new.
   template <class... Args>
   const orbit_client_protos::TimerInfo& emplace_back(Args&&... args) {
-    ORBIT_CHECK(size() < kBlockSize);
+    const size_t size = size_.load(std::memory_order_relaxed);
+    ORBIT_CHECK(size < kBlockSize);
     const orbit_client_protos::TimerInfo& timer_info =
         data_.emplace_back(std::forward<Args>(args)...);
-    min_timestamp_ = std::min(timer_info.start(), min_timestamp_);
-    max_timestamp_ = std::max(timer_info.end(), max_timestamp_);
+    const uint64_t min_timestamp = min_timestamp_.load(std::memory_order_relaxed);
+    min_timestamp_.store(std::min(timer_info.start(), min_timestamp), std::memory_order_relaxed);
+    const uint64_t max_timestamp = max_timestamp_.load(std::memory_order_relaxed);
+    max_timestamp_.store(std::max(timer_info.end(), max_timestamp), std::memory_order_relaxed);
+    size_.store(size + 1, std::memory_order_release);
     return timer_info;
   }
 
@@ -52,9 +61,11 @@ class TimerBlock {
   // {min, max}_timestamp are the minimum and maximum timestamp of the timers
   // that have so far been added to this block.
   [[nodiscard]] bool Intersects(uint64_t min, uint64_t max) const;
-  [[nodiscard]] uint64_t MinTimestamp() const { return min_timestamp_; }
+  [[nodiscard]] uint64_t MinTimestamp() const {
+    return min_timestamp_.load(std::memory_order_relaxed);
+  }
 
-  [[nodiscard]] size_t size() const { return data_.size(); }
+  [[nodiscard]] size_t size() const { return size_.load(std::memory_order_acquire); }
   [[nodiscard]] bool at_capacity() const { return size() == kBlockSize; }
 
   [[nodiscard]] const orbit_client_protos::TimerInfo& operator[](std::size_t idx) const {
@@ -69,11 +80,14 @@ class TimerBlock {
   static constexpr size_t kBlockSize = 1024;
 
   TimerBlock* prev_;
-  TimerBlock* next_;
+  // Set with release semantics once the next block has its first timer.
+  std::atomic<TimerBlock*> next_;
+  // Only the writer uses data_.size(); readers use `size_`.
   std::vector<orbit_client_protos::TimerInfo> data_;
+  std::atomic<size_t> size_{0};
 
-  uint64_t min_timestamp_;
-  uint64_t max_timestamp_;
+  std::atomic<uint64_t> min_timestamp_;
+  std::atomic<uint64_t> max_timestamp_;
 };  // TimerChainIterator iterates over all *blocks* of the chain, not the
 // individual items (TimerInfo instances) that are stored in the blocks (this is
 // different from the BlockIterator in BlockChain.h).
@@ -89,7 +103,7 @@ class TimerChainIterator {
 
   bool operator==(const TimerChainIterator& other) const { return block_ == other.block_; }
   TimerChainIterator& operator++() {
-    block_ = block_->next_;
+    block_ = block_->next_.load(std::memory_order_acquire);
     return *this;
   }
 
@@ -105,24 +119,61 @@ class TimerChainIterator {
 // for fast rejection of entire blocks when rendering timers. Note that there
 // is a difference compared with BlockChain in how the iterators work: Here,
 // the iterator runs over blocks, in BlockChain the iterator runs over the
-// individually stored elements.
+// individually stored elements. The chain also keeps the maximum timestamps of
+// its blocks in a MaxTimestampPyramid, so that the blocks ending before a
+// timestamp can be skipped without visiting each of them.
+//
+// One thread at a time can append timers while others read the chain without locking: new blocks
+// are only linked and indexed once they hold their first timer, and sizes and links are published
+// with release semantics. Readers see a consistent prefix of the timers, which might lag behind by
+// the timers being appended.
 class TimerChain {
  public:
+  TimerChain() { blocks_.push_back(root_); }
   ~TimerChain();
 
   // Append an item to the end of the current block. If capacity of the current block is reached, a
   // new blocked is allocated and the item is added to the new block.
   template <class... Args>
   const orbit_client_protos::TimerInfo& emplace_back(Args&&... args) {
-    if (current_->at_capacity()) AllocateNewBlock();
+    const bool needs_new_block = current_->at_capacity();
+    if (needs_new_block) current_ = new TimerBlock(current_);
     const orbit_client_protos::TimerInfo& timer_info =
         current_->emplace_back(std::forward<Args>(args)...);
-    ++num_items_;
+    if (needs_new_block) PublishCurrentBlock();
+    if (block_max_timestamps_.size() < blocks_.size()) {
+      block_max_timestamps_.Append(timer_info.end());
+    } else {
+      block_max_timestamps_.RaiseLast(timer_info.end());
+    }
+    num_items_.store(num_items_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
     return timer_info;
   }
 
-  [[nodiscard]] bool empty() const { return num_items_ == 0; }
-  [[nodiscard]] uint64_t size() const { return num_items_; }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+  [[nodiscard]] uint64_t size() const { return num_items_.load(std::memory_order_acquire); }
+  [[nodiscard]] uint64_t num_blocks() const { return blocks_.size(); }
+  // Returns an estimate of the memory held by the chain. Blocks reserve room for all their timers.
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const {
+    return num_blocks() * (sizeof(TimerBlock) +
+                           TimerBlock::kBlockSize * sizeof(orbit_client_protos::TimerInfo));
+  }
+
+  [[nodiscard]] const TimerBlock& GetBlock(uint64_t block_index) const {
+    ORBIT_CHECK(block_index < num_blocks());
+    return *blocks_[block_index];
+  }
+
+  // Returns the index of the first block at or after `first_block_index` with a timer that ends at
+  // or after `min_ns`, or num_blocks() if there is none. The cost is logarithmic in the number of
+  // blocks.
+  [[nodiscard]] uint64_t FindFirstBlockEndingAtOrAfter(uint64_t min_ns,
+                                                       uint64_t first_block_index) const {
+    // The index of the blocks is appended to after `blocks_`, so it never has more blocks.
+    const size_t num_indexed_blocks = block_max_timestamps_.size();
+    const size_t block_index = block_max_timestamps_.FindFirstAtLeast(min_ns, first_block_index);
+    return block_index < num_indexed_blocks ? block_index : num_blocks();
+  }
 
   [[nodiscard]] const TimerBlock* GetBlockContaining(
       const orbit_client_protos::TimerInfo& element) const;
@@ -138,17 +189,18 @@ class TimerChain {
   [[nodiscard]] TimerChainIterator end() const { return TimerChainIterator(nullptr); }
 
  private:
-  void AllocateNewBlock() {
-    ORBIT_CHECK(current_->next_ == nullptr);
-    current_->next_ = new TimerBlock(current_);
-    current_ = current_->next_;
-    ++num_blocks_;
+  void PublishCurrentBlock() {
+    TimerBlock* prev = current_->prev_;
+    ORBIT_CHECK(prev->next_.load(std::memory_order_relaxed) == nullptr);
+    prev->next_.store(current_, std::memory_order_release);
+    blocks_.push_back(current_);
   }
 
   TimerBlock* root_ = new TimerBlock(/*prev=*/nullptr);
   TimerBlock* current_ = root_;
-  uint64_t num_blocks_ = 1;
-  uint64_t num_items_ = 0;
+  orbit_containers::AppendOnlyVector<const TimerBlock*> blocks_;
+  MaxTimestampPyramid block_max_timestamps_;
+  std::atomic<uint64_t> num_items_{0};
 };
 }  // namespace orbit_client_data
 
@@ -13,11 +13,11 @@
 #include <algorithm>
 #include <atomic>
 #include <limits>
-#include <map>
 #include <memory>
 #include <vector>
 
 #include "ClientProtos/capture_data.pb.h"
+#include "Containers/AppendOnlyVector.h"
 #include "OrbitBase/ThreadConstants.h"
 #include "TimerChain.h"
 #include "TimerDataInterface.h"
@@ -26,6 +26,8 @@ namespace orbit_client_data {
 
 // Stores all the timers from a particular TimerTrack and provides queries to get timers in a
 // certain range as well as metadata from them. Timers might be divided in different depths.
+// Calls to AddTimer are serialized with a mutex, but the queries don't lock: they read the chains
+// while timers are added, see TimerChain.
 class TimerData final : public TimerDataInterface {
  public:
   const orbit_client_protos::TimerInfo& AddTimer(orbit_client_protos::TimerInfo timer_info,
@@ -56,6 +58,7 @@ class TimerData final : public TimerDataInterface {
   // TODO(b/204173036): Test depth and process_id.
   [[nodiscard]] uint32_t GetDepth() const override { return depth_; }
   [[nodiscard]] uint32_t GetProcessId() const override { return process_id_; }
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const;
 
   // Relative timers queries.
   // TODO(b/221024788): These queries assume Timers are inserted in order and don't work for
@@ -93,11 +96,15 @@ class TimerData final : public TimerDataInterface {
   void UpdateMinTime(uint64_t min_time);
   void UpdateMaxTime(uint64_t max_time);
   void UpdateDepth(uint32_t depth) { depth_ = std::max(depth_, depth); }
-  [[nodiscard]] TimerChain* GetOrCreateTimerChain(uint64_t depth);
+  [[nodiscard]] TimerChain* GetOrCreateTimerChain(uint64_t depth)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   uint32_t depth_ = 0;
-  mutable absl::Mutex mutex_;
-  std::map<uint32_t, std::unique_ptr<TimerChain>> timers_ ABSL_GUARDED_BY(mutex_);
+  absl::Mutex mutex_;
+  // chains_[depth] is the chain of the timers at that depth, or nullptr if there are none yet. A
+  // chain is set with release semantics and never replaced.
+  orbit_containers::AppendOnlyVector<std::atomic<TimerChain*>> chains_;
+  std::vector<std::unique_ptr<TimerChain>> owned_chains_ ABSL_GUARDED_BY(mutex_);
   std::atomic<size_t> num_timers_{0};
   std::atomic<uint64_t> min_time_{std::numeric_limits<uint64_t>::max()};
   std::atomic<uint64_t> max_time_{std::numeric_limits<uint64_t>::min()};
@@ -42,6 +42,15 @@ class TimerDataManager final {
     return timers;
   }
 
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const {
+    absl::MutexLock lock(&mutex_);
+    uint64_t memory_usage_bytes = 0;
+    for (const std::unique_ptr<TimerData>& timer_datum : timer_data_) {
+      memory_usage_bytes += timer_datum->GetMemoryUsageBytes();
+    }
+    return memory_usage_bytes;
+  }
+
  private:
   mutable absl::Mutex mutex_;
   std::vector<std::unique_ptr<TimerData>> timer_data_ ABSL_GUARDED_BY(mutex_);
@@ -0,0 +1,69 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_DATA_TIMESTAMP_BUCKET_PYRAMID_H_
+#define CLIENT_DATA_TIMESTAMP_BUCKET_PYRAMID_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace orbit_client_data {
+
+// Indexes a sorted sequence of timestamps, e.g. of the callstack samples of a thread, to find the
+// first timestamp of each pixel of a time range, which is all that a bar of samples draws.
+// The timestamps are counted into buckets of 2^shift nanoseconds at several resolutions, and a
+// query walks the non-empty buckets of the coarsest resolution whose buckets are not wider than a
+// pixel in a single pass, only searching within the buckets it visits. So its cost grows with the
+// number of pixels, not with the number of timestamps in the range. The pyramid is immutable, so
+// queries need no locking.
+//
+// Example usage:
+//
+// TimestampBucketPyramid pyramid({10, 11, 12, 30});
+// pyramid.GetFirstIndexOfEachPixel(0, 40, 4);  // Returns {0, 3}.
+class TimestampBucketPyramid {
+ public:
+  // Each resolution has buckets 2^kLevelShift times wider than the one before.
+  static constexpr uint32_t kFinestBucketShift = 10;
+  static constexpr uint32_t kLevelShift = 2;
+  static constexpr uint32_t kCoarsestBucketShift = 40;
+
+  TimestampBucketPyramid() = default;
+  // `timestamps_ns` must be sorted.
+  explicit TimestampBucketPyramid(std::vector<uint64_t> timestamps_ns);
+
+  [[nodiscard]] size_t size() const { return timestamps_ns_.size(); }
+  [[nodiscard]] uint64_t GetTimestamp(size_t index) const { return timestamps_ns_[index]; }
+
+  // Returns the index of the first timestamp in each pixel of [min_timestamp_ns, max_timestamp_ns)
+  // that has any, with pixels as in GetPixelNumber. These are the timestamps that iterating from
+  // `min_timestamp_ns` to the next pixel boundary after each visited timestamp visits.
+  [[nodiscard]] std::vector<size_t> GetFirstIndexOfEachPixel(uint64_t min_timestamp_ns,
+                                                             uint64_t max_timestamp_ns,
+                                                             uint32_t resolution) const;
+
+ private:
+  struct Bucket {
+    // The timestamps of the bucket are those whose value shifted right by the level's shift is
+    // `number`. They start at `first_index` and end where the next bucket starts.
+    uint64_t number;
+    size_t first_index;
+  };
+  struct Level {
+    uint32_t shift;
+    // Only the non-empty buckets, sorted.
+    std::vector<Bucket> buckets;
+  };
+
+  std::vector<uint64_t> timestamps_ns_;
+  // Sorted by shift. Resolutions with more than half as many buckets as timestamps are left out, as
+  // searching the timestamps directly is as fast.
+  std::vector<Level> levels_;
+};
+
+}  // namespace orbit_client_data
+
+#endif  // CLIENT_DATA_TIMESTAMP_BUCKET_PYRAMID_H_
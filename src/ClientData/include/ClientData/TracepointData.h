@@ -18,6 +18,7 @@
 #include <memory>
 #include <vector>
 
+#include "ClientData/TimestampBucketPyramid.h"
 #include "ClientData/TracepointEventInfo.h"
 #include "ClientData/TracepointInfo.h"
 #include "ClientProtos/capture_data.pb.h"
@@ -49,6 +50,13 @@ class TracepointData {
       uint32_t thread_id, uint64_t min_tick, uint64_t max_tick_exclusive,
       const std::function<void(const TracepointEventInfo&)>& action) const;
 
+  // Same as above, but only for the first event of each pixel of [min_tick, max_tick_exclusive)
+  // that has any, see GetPixelNumber. Once the capture is complete, this reads the
+  // TimestampBucketPyramids built by OnCaptureComplete without locking.
+  void ForEachTracepointEventOfThreadInTimeRangeDiscretized(
+      uint32_t thread_id, uint64_t min_tick, uint64_t max_tick_exclusive, uint32_t resolution,
+      const std::function<void(const TracepointEventInfo&)>& action) const;
+
   void ForEachTracepointEvent(const std::function<void(const TracepointEventInfo&)>& action) const;
 
   uint32_t GetNumTracepointEventsForThreadId(uint32_t thread_id) const;
@@ -60,7 +68,18 @@ class TracepointData {
 
   void ForEachUniqueTracepointInfo(const std::function<void(const TracepointInfo&)>& action) const;
 
+  // Indexes the events of each thread id, including kAllThreadsOfAllProcessesTid and
+  // kAllProcessThreadsTid, for the discretized iteration. Called once the capture is complete, as
+  // no events can be added afterwards.
+  void OnCaptureComplete();
+
  private:
+  // The events of a thread id sorted by timestamp, pointing into thread_id_to_time_to_tracepoint_.
+  struct FrozenEvents {
+    std::vector<const TracepointEventInfo*> events;
+    TimestampBucketPyramid pyramid;
+  };
+
   int32_t num_total_tracepoint_events_ = 0;
 
   mutable absl::Mutex mutex_;
@@ -68,6 +87,9 @@ class TracepointData {
 
   absl::flat_hash_map<uint32_t, std::map<uint64_t, TracepointEventInfo>>
       thread_id_to_time_to_tracepoint_ ABSL_GUARDED_BY(mutex_);
+  // Set by OnCaptureComplete, after which these are immutable.
+  std::atomic<bool> is_frozen_ = false;
+  absl::flat_hash_map<uint32_t, FrozenEvents> frozen_events_by_thread_id_;
 
   // Store unique pointers, such that we can hand out pointers to tracepoint infos, without
   // requiring the caller to lock the mutex.
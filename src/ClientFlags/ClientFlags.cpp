@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -27,6 +28,42 @@ ABSL_FLAG(std::string, process_name, "",
 // TODO: Remove this flag once we have a way to toggle the display return values
 ABSL_FLAG(bool, show_return_values, false, "Show return values on time slices");
 
+ABSL_FLAG(uint64_t, api_track_aggregation_window_ms, 0,
+          "Aggregate the values of each Orbit API track over windows of this many milliseconds, "
+          "only sending their minimum, maximum, and last value (0 = send all values)");
+
+ABSL_FLAG(uint64_t, off_cpu_time_aggregation_interval_ms, 0,
+          "Sum up the off-CPU time of the thread state slices with callstacks per thread, thread "
+          "state and callstack over intervals of this many milliseconds on OrbitService, instead "
+          "of sending the individual slices (0 = send all slices)");
+
+ABSL_FLAG(bool, compress_capture_responses, false,
+          "Ask OrbitService to compress the capture data it streams to the client with gzip");
+
+ABSL_FLAG(bool, subtract_instrumentation_overhead, false,
+          "Subtract the measured overhead of the dynamic instrumentation of nested calls from the "
+          "durations in the statistics of functions");
+
+ABSL_FLAG(uint64_t, page_fault_sampling_period, 0,
+          "Record the callstack of one in every this many minor page faults of the target process, "
+          "to show where its resident memory grows (0 = disabled)");
+
+ABSL_FLAG(uint64_t, pressure_stall_threshold_ms, 0,
+          "Show CPU, memory and IO pressure tracks, updated each time the tasks were stalled on "
+          "the resource for at least this long within a pressure stall window (0 = disabled)");
+
+ABSL_FLAG(uint64_t, pressure_stall_window_ms, 1000,
+          "Length of the pressure stall window, between 500 and 10000");
+
+ABSL_FLAG(bool, sample_performance_counters, false,
+          "Sample the cycles, instructions, cache misses and branch misses of each thread of the "
+          "target process at the callstack sampling rate, and show them as per-thread IPC and "
+          "misses per kilo-instruction tracks");
+
+ABSL_FLAG(std::vector<std::string>, additional_thread_state_pids, {},
+          "Also collect the thread states of these processes (comma-separated pids) when "
+          "collecting the thread states of the target process.");
+
 ABSL_FLAG(bool, enable_tracepoint_feature, false,
           "Enable the setting of the panel of kernel tracepoints");
 
@@ -42,9 +79,29 @@ ABSL_FLAG(std::string, instance_symbols_folder, "",
 ABSL_FLAG(bool, enforce_full_redraw, false,
           "Enforce full redraw every frame (used for performance measurements)");
 
+ABSL_FLAG(uint64_t, capture_memory_budget_mb, 0,
+          "Stop a live capture once the capture data in the client exceeds this many megabytes "
+          "(0 means no limit)");
+
+ABSL_FLAG(bool, disable_instanced_rendering, false,
+          "Draw boxes from client-side vertex arrays even if OpenGL 3.3 is available");
+
 ABSL_FLAG(std::vector<std::string>, additional_symbol_paths, {},
           "Additional local symbol locations (comma-separated)");
 
+// Partial loading of capture files.
+ABSL_FLAG(uint64_t, load_capture_min_time_ms, 0,
+          "When loading a capture, skip the events that end before this time, in milliseconds "
+          "relative to the start of the capture.");
+ABSL_FLAG(uint64_t, load_capture_max_time_ms, std::numeric_limits<uint64_t>::max(),
+          "When loading a capture, skip the events that start after this time, in milliseconds "
+          "relative to the start of the capture.");
+ABSL_FLAG(std::vector<std::string>, load_capture_thread_ids, {},
+          "When loading a capture, only load the events of these threads (comma-separated).");
+ABSL_FLAG(std::vector<std::string>, load_capture_event_types, {},
+          "When loading a capture, only load these kinds of events (comma-separated field names of "
+          "ClientCaptureEvent, e.g. function_call,callstack_sample).");
+
 // Clears QSettings. This is intended for e2e tests.
 ABSL_FLAG(bool, clear_settings, false,
           "Clears user defined settings. This includes symbol locations and source path mappings.");
@@ -29,6 +29,23 @@ ABSL_DECLARE_FLAG(bool, frame_pointer_unwinding);
 // TODO: Remove this flag once we have a way to toggle the display return values
 ABSL_DECLARE_FLAG(bool, show_return_values);
 
+ABSL_DECLARE_FLAG(uint64_t, api_track_aggregation_window_ms);
+ABSL_DECLARE_FLAG(uint64_t, off_cpu_time_aggregation_interval_ms);
+
+ABSL_DECLARE_FLAG(bool, compress_capture_responses);
+
+ABSL_DECLARE_FLAG(bool, subtract_instrumentation_overhead);
+
+ABSL_DECLARE_FLAG(uint64_t, page_fault_sampling_period);
+
+ABSL_DECLARE_FLAG(uint64_t, pressure_stall_threshold_ms);
+
+ABSL_DECLARE_FLAG(uint64_t, pressure_stall_window_ms);
+
+ABSL_DECLARE_FLAG(bool, sample_performance_counters);
+
+ABSL_DECLARE_FLAG(std::vector<std::string>, additional_thread_state_pids);
+
 ABSL_DECLARE_FLAG(bool, enable_tracepoint_feature);
 
 // TODO(b/185099421): Remove this flag once we have a clear explanation of the memory warning
@@ -40,8 +57,20 @@ ABSL_DECLARE_FLAG(std::string, instance_symbols_folder);
 
 ABSL_DECLARE_FLAG(bool, enforce_full_redraw);
 
+// Stops a live capture once the capture data held by the client exceeds this many megabytes.
+ABSL_DECLARE_FLAG(uint64_t, capture_memory_budget_mb);
+
+// Falls back to the fixed-function rendering of boxes, e.g. to work around driver issues.
+ABSL_DECLARE_FLAG(bool, disable_instanced_rendering);
+
 ABSL_DECLARE_FLAG(std::vector<std::string>, additional_symbol_paths);
 
+// Partial loading of capture files, see orbit_capture_client::LoadCaptureFilter.
+ABSL_DECLARE_FLAG(uint64_t, load_capture_min_time_ms);
+ABSL_DECLARE_FLAG(uint64_t, load_capture_max_time_ms);
+ABSL_DECLARE_FLAG(std::vector<std::string>, load_capture_thread_ids);
+ABSL_DECLARE_FLAG(std::vector<std::string>, load_capture_event_types);
+
 // Clears QSettings. This is intended for e2e tests.
 ABSL_DECLARE_FLAG(bool, clear_settings);
 
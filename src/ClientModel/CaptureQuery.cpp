@@ -0,0 +1,349 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientModel/CaptureQuery.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/ScopeId.h"
+#include "ClientData/ScopeInfo.h"
+#include "ClientData/ThreadStateSliceInfo.h"
+#include "ClientProtos/capture_data.pb.h"
+#include "OrbitBase/Future.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ThreadConstants.h"
+
+using orbit_client_data::CallstackData;
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CaptureData;
+using orbit_client_data::ScopeId;
+using orbit_client_data::ThreadStateSliceInfo;
+using orbit_client_protos::TimerInfo;
+
+namespace orbit_client_model {
+
+namespace {
+
+// The rows are scanned in chunks of this size, which is large enough to amortize the scheduling
+// and small enough to balance the load between the threads.
+constexpr size_t kRowChunkSize = 64 * 1024;
+
+// Calls `function(chunk_index, begin, end)` for each chunk of rows [begin, end) of [0, row_count),
+// spread over the threads of `thread_pool` and the calling thread, and returns once all calls have
+// completed. Without a thread pool, all calls run on the calling thread.
+template <typename Function>
+void ForEachChunk(orbit_base::ThreadPool* thread_pool, size_t row_count, Function&& function) {
+  const size_t chunk_count = (row_count + kRowChunkSize - 1) / kRowChunkSize;
+  auto process_chunk = [row_count, &function](size_t chunk_index) {
+    const size_t begin = chunk_index * kRowChunkSize;
+    function(chunk_index, begin, std::min(begin + kRowChunkSize, row_count));
+  };
+  if (thread_pool == nullptr || chunk_count <= 1) {
+    for (size_t chunk_index = 0; chunk_index < chunk_count; ++chunk_index) {
+      process_chunk(chunk_index);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next_chunk_index = 0;
+  auto process_chunks = [&next_chunk_index, chunk_count, &process_chunk]() {
+    for (size_t chunk_index = next_chunk_index++; chunk_index < chunk_count;
+         chunk_index = next_chunk_index++) {
+      process_chunk(chunk_index);
+    }
+  };
+  const size_t task_count =
+      std::min<size_t>(chunk_count, std::max(1U, std::thread::hardware_concurrency()));
+  std::vector<orbit_base::Future<void>> futures;
+  for (size_t i = 1; i < task_count; ++i) {
+    futures.push_back(thread_pool->Schedule(process_chunks));
+  }
+  process_chunks();
+  for (const orbit_base::Future<void>& future : futures) future.Wait();
+}
+
+[[nodiscard]] EventTable Concatenate(const std::vector<EventTable>& tables) {
+  size_t size = 0;
+  for (const EventTable& table : tables) size += table.size();
+  EventTable result;
+  result.Reserve(size);
+  for (const EventTable& table : tables) result.AppendRows(table);
+  return result;
+}
+
+// The union of a set of time ranges, as disjoint time ranges sorted by start.
+struct TimeRangeUnion {
+  std::vector<uint64_t> start_ns;
+  std::vector<uint64_t> end_ns;
+};
+
+[[nodiscard]] absl::flat_hash_map<uint32_t, TimeRangeUnion> CreateTimeRangeUnions(
+    const EventTable& intervals, JoinThreads join_threads) {
+  absl::flat_hash_map<uint32_t, std::vector<std::pair<uint64_t, uint64_t>>> thread_id_to_ranges;
+  for (size_t i = 0; i < intervals.size(); ++i) {
+    // Time ranges without duration can't contain anything.
+    if (intervals.start_ns()[i] >= intervals.end_ns()[i]) continue;
+    const uint32_t thread_id = join_threads == JoinThreads::kSameThread
+                                   ? intervals.thread_ids()[i]
+                                   : orbit_base::kAllProcessThreadsTid;
+    thread_id_to_ranges[thread_id].emplace_back(intervals.start_ns()[i], intervals.end_ns()[i]);
+  }
+
+  absl::flat_hash_map<uint32_t, TimeRangeUnion> thread_id_to_union;
+  for (auto& [thread_id, ranges] : thread_id_to_ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    TimeRangeUnion& time_range_union = thread_id_to_union[thread_id];
+    for (const auto& [start_ns, end_ns] : ranges) {
+      if (!time_range_union.end_ns.empty() && start_ns <= time_range_union.end_ns.back()) {
+        time_range_union.end_ns.back() = std::max(time_range_union.end_ns.back(), end_ns);
+        continue;
+      }
+      time_range_union.start_ns.push_back(start_ns);
+      time_range_union.end_ns.push_back(end_ns);
+    }
+  }
+  return thread_id_to_union;
+}
+
+void AddToGroup(EventGroup* group, uint64_t duration_ns) {
+  ++group->count;
+  group->total_duration_ns += duration_ns;
+  group->min_duration_ns = std::min(group->min_duration_ns, duration_ns);
+  group->max_duration_ns = std::max(group->max_duration_ns, duration_ns);
+}
+
+}  // namespace
+
+void EventTable::Reserve(size_t size) {
+  start_ns_.reserve(size);
+  end_ns_.reserve(size);
+  thread_ids_.reserve(size);
+  keys_.reserve(size);
+}
+
+void EventTable::Append(uint64_t start_ns, uint64_t end_ns, uint32_t thread_id, uint64_t key) {
+  start_ns_.push_back(start_ns);
+  end_ns_.push_back(end_ns);
+  thread_ids_.push_back(thread_id);
+  keys_.push_back(key);
+}
+
+void EventTable::AppendRows(const EventTable& other) {
+  start_ns_.insert(start_ns_.end(), other.start_ns_.begin(), other.start_ns_.end());
+  end_ns_.insert(end_ns_.end(), other.end_ns_.begin(), other.end_ns_.end());
+  thread_ids_.insert(thread_ids_.end(), other.thread_ids_.begin(), other.thread_ids_.end());
+  keys_.insert(keys_.end(), other.keys_.begin(), other.keys_.end());
+}
+
+void EventTable::Sort() {
+  std::vector<size_t> order(size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+    return std::tie(start_ns_[lhs], end_ns_[lhs], thread_ids_[lhs], keys_[lhs]) <
+           std::tie(start_ns_[rhs], end_ns_[rhs], thread_ids_[rhs], keys_[rhs]);
+  });
+
+  auto permute = [&order](auto* column) {
+    std::remove_reference_t<decltype(*column)> sorted_column;
+    sorted_column.reserve(order.size());
+    for (const size_t index : order) sorted_column.push_back((*column)[index]);
+    *column = std::move(sorted_column);
+  };
+  permute(&start_ns_);
+  permute(&end_ns_);
+  permute(&thread_ids_);
+  permute(&keys_);
+}
+
+EventTable CreateTimerTable(const CaptureData& capture_data) {
+  const std::vector<const TimerInfo*> timers =
+      capture_data.GetAllScopeTimers(orbit_client_data::kAllValidScopeTypes);
+  EventTable table;
+  table.Reserve(timers.size());
+  for (const TimerInfo* timer : timers) {
+    const std::optional<ScopeId> scope_id = capture_data.ProvideScopeId(*timer);
+    if (!scope_id.has_value()) continue;
+    table.Append(timer->start(), timer->end(), timer->thread_id(), *scope_id.value());
+  }
+  table.Sort();
+  return table;
+}
+
+EventTable CreateSchedulingSliceTable(const CaptureData& capture_data) {
+  const std::vector<const TimerInfo*> slices =
+      capture_data.GetTimersByType(TimerInfo::kCoreActivity);
+  EventTable table;
+  table.Reserve(slices.size());
+  for (const TimerInfo* slice : slices) {
+    table.Append(slice->start(), slice->end(), slice->thread_id(),
+                 static_cast<uint64_t>(slice->processor()));
+  }
+  table.Sort();
+  return table;
+}
+
+EventTable CreateThreadStateSliceTable(const CaptureData& capture_data) {
+  EventTable table;
+  capture_data.ForEachThreadStateSlice([&table](const ThreadStateSliceInfo& slice) {
+    table.Append(slice.begin_timestamp_ns(), slice.end_timestamp_ns(), slice.tid(),
+                 static_cast<uint64_t>(slice.thread_state()));
+  });
+  table.Sort();
+  return table;
+}
+
+EventTable CreateCallstackSampleTable(const CallstackData& callstack_data) {
+  EventTable table;
+  table.Reserve(callstack_data.GetCallstackEventsCount());
+  callstack_data.ForEachCallstackEvent([&table](const CallstackEvent& event) {
+    table.Append(event.timestamp_ns(), event.timestamp_ns(), event.thread_id(),
+                 event.callstack_id());
+  });
+  table.Sort();
+  return table;
+}
+
+EventTable Filter(const EventTable& table, const EventFilter& filter,
+                  orbit_base::ThreadPool* thread_pool) {
+  const size_t chunk_count = (table.size() + kRowChunkSize - 1) / kRowChunkSize;
+  std::vector<EventTable> chunk_results(chunk_count);
+  ForEachChunk(thread_pool, table.size(), [&](size_t chunk_index, size_t begin, size_t end) {
+    // Each predicate is evaluated on a whole column at a time, without branches for the time
+    // range, so that the loops are tight and can be vectorized.
+    std::vector<uint8_t> keep(end - begin);
+    const absl::Span<const uint64_t> start_ns = table.start_ns();
+    const absl::Span<const uint64_t> end_ns = table.end_ns();
+    for (size_t i = begin; i < end; ++i) {
+      keep[i - begin] = static_cast<uint8_t>(end_ns[i] >= filter.min_ns) &
+                        static_cast<uint8_t>(start_ns[i] <= filter.max_ns);
+    }
+    if (!filter.thread_ids.empty()) {
+      const absl::Span<const uint32_t> thread_ids = table.thread_ids();
+      for (size_t i = begin; i < end; ++i) {
+        keep[i - begin] &= static_cast<uint8_t>(filter.thread_ids.contains(thread_ids[i]));
+      }
+    }
+    if (!filter.keys.empty()) {
+      const absl::Span<const uint64_t> keys = table.keys();
+      for (size_t i = begin; i < end; ++i) {
+        keep[i - begin] &= static_cast<uint8_t>(filter.keys.contains(keys[i]));
+      }
+    }
+
+    EventTable& result = chunk_results[chunk_index];
+    for (size_t i = begin; i < end; ++i) {
+      if (keep[i - begin] == 0) continue;
+      result.Append(start_ns[i], end_ns[i], table.thread_ids()[i], table.keys()[i]);
+    }
+  });
+  return Concatenate(chunk_results);
+}
+
+EventTable IntersectTime(const EventTable& events, const EventTable& intervals,
+                         JoinThreads join_threads, orbit_base::ThreadPool* thread_pool) {
+  const absl::flat_hash_map<uint32_t, TimeRangeUnion> thread_id_to_union =
+      CreateTimeRangeUnions(intervals, join_threads);
+
+  const size_t chunk_count = (events.size() + kRowChunkSize - 1) / kRowChunkSize;
+  std::vector<EventTable> chunk_results(chunk_count);
+  ForEachChunk(thread_pool, events.size(), [&](size_t chunk_index, size_t begin, size_t end) {
+    EventTable& result = chunk_results[chunk_index];
+    for (size_t i = begin; i < end; ++i) {
+      const uint32_t thread_id = events.thread_ids()[i];
+      const auto union_it = thread_id_to_union.find(
+          join_threads == JoinThreads::kSameThread ? thread_id : orbit_base::kAllProcessThreadsTid);
+      if (union_it == thread_id_to_union.end()) continue;
+      const TimeRangeUnion& time_range_union = union_it->second;
+
+      const uint64_t start_ns = events.start_ns()[i];
+      const uint64_t end_ns = events.end_ns()[i];
+      const uint64_t key = events.keys()[i];
+      // The first time range that ends after the start of the event.
+      size_t range_index = std::upper_bound(time_range_union.end_ns.begin(),
+                                            time_range_union.end_ns.end(), start_ns) -
+                           time_range_union.end_ns.begin();
+      if (start_ns == end_ns) {
+        if (range_index < time_range_union.start_ns.size() &&
+            time_range_union.start_ns[range_index] <= start_ns) {
+          result.Append(start_ns, end_ns, thread_id, key);
+        }
+        continue;
+      }
+      for (; range_index < time_range_union.start_ns.size() &&
+             time_range_union.start_ns[range_index] < end_ns;
+           ++range_index) {
+        result.Append(std::max(start_ns, time_range_union.start_ns[range_index]),
+                      std::min(end_ns, time_range_union.end_ns[range_index]), thread_id, key);
+      }
+    }
+  });
+  return Concatenate(chunk_results);
+}
+
+std::vector<EventGroup> GroupBy(const EventTable& table, GroupByColumn column,
+                                absl::Span<const uint64_t> sorted_frame_starts_ns,
+                                orbit_base::ThreadPool* thread_pool) {
+  ORBIT_CHECK(std::is_sorted(sorted_frame_starts_ns.begin(), sorted_frame_starts_ns.end()));
+  const size_t chunk_count = (table.size() + kRowChunkSize - 1) / kRowChunkSize;
+  std::vector<absl::flat_hash_map<uint64_t, EventGroup>> chunk_groups(chunk_count);
+  ForEachChunk(thread_pool, table.size(), [&](size_t chunk_index, size_t begin, size_t end) {
+    absl::flat_hash_map<uint64_t, EventGroup>& groups = chunk_groups[chunk_index];
+    for (size_t i = begin; i < end; ++i) {
+      uint64_t group = 0;
+      switch (column) {
+        case GroupByColumn::kThreadId:
+          group = table.thread_ids()[i];
+          break;
+        case GroupByColumn::kKey:
+          group = table.keys()[i];
+          break;
+        case GroupByColumn::kFrame: {
+          const size_t frames_started =
+              std::upper_bound(sorted_frame_starts_ns.begin(), sorted_frame_starts_ns.end(),
+                               table.start_ns()[i]) -
+              sorted_frame_starts_ns.begin();
+          if (frames_started == 0) continue;
+          group = frames_started - 1;
+        } break;
+      }
+      EventGroup& event_group = groups[group];
+      event_group.group = group;
+      AddToGroup(&event_group, table.end_ns()[i] - table.start_ns()[i]);
+    }
+  });
+
+  absl::flat_hash_map<uint64_t, EventGroup> merged_groups;
+  for (const absl::flat_hash_map<uint64_t, EventGroup>& groups : chunk_groups) {
+    for (const auto& [group, chunk_group] : groups) {
+      EventGroup& merged_group = merged_groups[group];
+      merged_group.group = group;
+      merged_group.count += chunk_group.count;
+      merged_group.total_duration_ns += chunk_group.total_duration_ns;
+      merged_group.min_duration_ns =
+          std::min(merged_group.min_duration_ns, chunk_group.min_duration_ns);
+      merged_group.max_duration_ns =
+          std::max(merged_group.max_duration_ns, chunk_group.max_duration_ns);
+    }
+  }
+
+  std::vector<EventGroup> result;
+  result.reserve(merged_groups.size());
+  for (const auto& [unused_group, event_group] : merged_groups) result.push_back(event_group);
+  std::sort(result.begin(), result.end(),
+            [](const EventGroup& lhs, const EventGroup& rhs) { return lhs.group < rhs.group; });
+  return result;
+}
+
+}  // namespace orbit_client_model
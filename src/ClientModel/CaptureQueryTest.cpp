@@ -0,0 +1,221 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/time/time.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "ClientData/CallstackData.h"
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/CallstackInfo.h"
+#include "ClientData/CallstackType.h"
+#include "ClientData/CaptureData.h"
+#include "ClientData/ModuleIdentifierProvider.h"
+#include "ClientData/ThreadStateSliceInfo.h"
+#include "ClientModel/CaptureQuery.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/ThreadPool.h"
+
+using orbit_client_data::CallstackData;
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CallstackInfo;
+using orbit_client_data::CallstackType;
+using orbit_client_data::CaptureData;
+using orbit_client_data::ThreadStateSliceInfo;
+using orbit_grpc_protos::ThreadStateSlice;
+using testing::ElementsAre;
+using testing::ElementsAreArray;
+
+namespace orbit_client_model {
+
+namespace {
+
+constexpr uint32_t kThreadId = 42;
+constexpr uint32_t kOtherThreadId = 43;
+
+struct Row {
+  uint64_t start_ns;
+  uint64_t end_ns;
+  uint32_t thread_id;
+  uint64_t key;
+
+  friend bool operator==(const Row& lhs, const Row& rhs) {
+    return lhs.start_ns == rhs.start_ns && lhs.end_ns == rhs.end_ns &&
+           lhs.thread_id == rhs.thread_id && lhs.key == rhs.key;
+  }
+};
+
+[[nodiscard]] EventTable CreateTable(const std::vector<Row>& rows) {
+  EventTable table;
+  for (const Row& row : rows) table.Append(row.start_ns, row.end_ns, row.thread_id, row.key);
+  return table;
+}
+
+[[nodiscard]] std::vector<Row> GetRows(const EventTable& table) {
+  std::vector<Row> rows;
+  for (size_t i = 0; i < table.size(); ++i) {
+    rows.push_back(
+        Row{table.start_ns()[i], table.end_ns()[i], table.thread_ids()[i], table.keys()[i]});
+  }
+  return rows;
+}
+
+MATCHER_P5(EventGroupIs, group, count, total_duration_ns, min_duration_ns, max_duration_ns, "") {
+  return arg.group == static_cast<uint64_t>(group) && arg.count == static_cast<uint64_t>(count) &&
+         arg.total_duration_ns == static_cast<uint64_t>(total_duration_ns) &&
+         arg.min_duration_ns == static_cast<uint64_t>(min_duration_ns) &&
+         arg.max_duration_ns == static_cast<uint64_t>(max_duration_ns);
+}
+
+}  // namespace
+
+TEST(CaptureQuery, SortOrdersRowsByStartThenByTheOtherColumns) {
+  EventTable table = CreateTable({{20, 30, kThreadId, 1},
+                                  {10, 40, kThreadId, 2},
+                                  {10, 20, kOtherThreadId, 3},
+                                  {10, 20, kThreadId, 4}});
+  table.Sort();
+  EXPECT_THAT(GetRows(table), ElementsAre(Row{10, 20, kThreadId, 4}, Row{10, 20, kOtherThreadId, 3},
+                                          Row{10, 40, kThreadId, 2}, Row{20, 30, kThreadId, 1}));
+}
+
+TEST(CaptureQuery, FilterByTimeRangeThreadAndKey) {
+  const EventTable table = CreateTable({{10, 20, kThreadId, 1},
+                                        {30, 40, kThreadId, 2},
+                                        {50, 60, kOtherThreadId, 1},
+                                        {70, 80, kThreadId, 1}});
+
+  EXPECT_THAT(GetRows(Filter(table, {})), ElementsAreArray(GetRows(table)));
+  EXPECT_THAT(GetRows(Filter(table, {.min_ns = 20, .max_ns = 50})),
+              ElementsAre(Row{10, 20, kThreadId, 1}, Row{30, 40, kThreadId, 2},
+                          Row{50, 60, kOtherThreadId, 1}));
+  EXPECT_THAT(GetRows(Filter(table, {.thread_ids = {kOtherThreadId}})),
+              ElementsAre(Row{50, 60, kOtherThreadId, 1}));
+  EXPECT_THAT(GetRows(Filter(table, {.thread_ids = {kThreadId}, .keys = {1}})),
+              ElementsAre(Row{10, 20, kThreadId, 1}, Row{70, 80, kThreadId, 1}));
+}
+
+TEST(CaptureQuery, IntersectTimeClipsEventsToTheUnionOfIntervals) {
+  const EventTable events = CreateTable({{0, 100, kThreadId, 1},
+                                         {150, 160, kThreadId, 2},
+                                         {25, 25, kThreadId, 3},
+                                         {45, 45, kThreadId, 4}});
+  const EventTable intervals = CreateTable({{20, 30, kOtherThreadId, 7},
+                                            {25, 40, kOtherThreadId, 7},
+                                            {60, 200, kOtherThreadId, 8},
+                                            {10, 10, kOtherThreadId, 9}});
+
+  EXPECT_THAT(GetRows(IntersectTime(events, intervals)),
+              ElementsAre(Row{20, 40, kThreadId, 1}, Row{60, 100, kThreadId, 1},
+                          Row{150, 160, kThreadId, 2}, Row{25, 25, kThreadId, 3}));
+  EXPECT_TRUE(IntersectTime(events, intervals, JoinThreads::kSameThread).empty());
+}
+
+TEST(CaptureQuery, IntersectTimeOnTheSameThread) {
+  const EventTable events =
+      CreateTable({{0, 100, kThreadId, 1}, {0, 100, kOtherThreadId, 2}});
+  const EventTable intervals =
+      CreateTable({{10, 20, kThreadId, 0}, {30, 40, kOtherThreadId, 0}});
+
+  EXPECT_THAT(GetRows(IntersectTime(events, intervals, JoinThreads::kSameThread)),
+              ElementsAre(Row{10, 20, kThreadId, 1}, Row{30, 40, kOtherThreadId, 2}));
+}
+
+TEST(CaptureQuery, GroupByThreadIdAndKey) {
+  const EventTable table = CreateTable({{10, 20, kThreadId, 1},
+                                        {30, 35, kThreadId, 2},
+                                        {50, 80, kOtherThreadId, 1}});
+
+  EXPECT_THAT(GroupBy(table, GroupByColumn::kThreadId),
+              ElementsAre(EventGroupIs(kThreadId, 2, 15, 5, 10),
+                          EventGroupIs(kOtherThreadId, 1, 30, 30, 30)));
+  EXPECT_THAT(GroupBy(table, GroupByColumn::kKey),
+              ElementsAre(EventGroupIs(1, 2, 40, 10, 30), EventGroupIs(2, 1, 5, 5, 5)));
+}
+
+TEST(CaptureQuery, GroupByFrame) {
+  const EventTable table = CreateTable({{5, 8, kThreadId, 1},
+                                        {10, 20, kThreadId, 1},
+                                        {30, 35, kThreadId, 1},
+                                        {40, 50, kThreadId, 1},
+                                        {1000, 1001, kThreadId, 1}});
+  const std::vector<uint64_t> frame_starts = {10, 40, 60};
+
+  EXPECT_THAT(GroupBy(table, GroupByColumn::kFrame, frame_starts),
+              ElementsAre(EventGroupIs(0, 2, 15, 5, 10), EventGroupIs(1, 1, 10, 10, 10),
+                          EventGroupIs(2, 1, 1, 1, 1)));
+  EXPECT_TRUE(GroupBy(table, GroupByColumn::kFrame).empty());
+}
+
+TEST(CaptureQuery, ParallelQueriesAreTheSameAsSerialOnes) {
+  // Enough rows for several chunks.
+  constexpr uint64_t kRowCount = 300'000;
+  EventTable events;
+  EventTable intervals;
+  for (uint64_t i = 0; i < kRowCount; ++i) {
+    events.Append(i * 10, i * 10 + 7, static_cast<uint32_t>(i % 4), i % 3);
+    if (i % 2 == 0) intervals.Append(i * 10 + 5, i * 10 + 15, static_cast<uint32_t>(i % 4), 0);
+  }
+  const std::vector<uint64_t> frame_starts = {0, 1'000'000, 2'000'000};
+
+  std::shared_ptr<orbit_base::ThreadPool> thread_pool =
+      orbit_base::ThreadPool::Create(4, 4, absl::Seconds(1));
+  const EventFilter filter{.min_ns = 1'000, .max_ns = 2'000'000, .thread_ids = {0, 1, 3}};
+  EXPECT_THAT(GetRows(Filter(events, filter, thread_pool.get())),
+              ElementsAreArray(GetRows(Filter(events, filter))));
+
+  const EventTable parallel_join =
+      IntersectTime(events, intervals, JoinThreads::kSameThread, thread_pool.get());
+  const EventTable serial_join = IntersectTime(events, intervals, JoinThreads::kSameThread);
+  EXPECT_FALSE(serial_join.empty());
+  EXPECT_THAT(GetRows(parallel_join), ElementsAreArray(GetRows(serial_join)));
+
+  const std::vector<EventGroup> parallel_groups =
+      GroupBy(serial_join, GroupByColumn::kFrame, frame_starts, thread_pool.get());
+  const std::vector<EventGroup> serial_groups =
+      GroupBy(serial_join, GroupByColumn::kFrame, frame_starts);
+  ASSERT_EQ(parallel_groups.size(), serial_groups.size());
+  for (size_t i = 0; i < serial_groups.size(); ++i) {
+    EXPECT_THAT(parallel_groups[i],
+                EventGroupIs(serial_groups[i].group, serial_groups[i].count,
+                             serial_groups[i].total_duration_ns, serial_groups[i].min_duration_ns,
+                             serial_groups[i].max_duration_ns));
+  }
+
+  thread_pool->ShutdownAndWait();
+}
+
+TEST(CaptureQuery, CreateThreadStateSliceTable) {
+  orbit_client_data::ModuleIdentifierProvider module_identifier_provider;
+  CaptureData capture_data{{}, std::nullopt, {}, CaptureData::DataSource::kLiveCapture,
+                           &module_identifier_provider};
+  capture_data.AddThreadStateSlice(ThreadStateSliceInfo{
+      kOtherThreadId, ThreadStateSlice::kRunning, 10, 20,
+      ThreadStateSliceInfo::WakeupReason::kNotApplicable, 0, 0, std::nullopt});
+  capture_data.AddThreadStateSlice(ThreadStateSliceInfo{
+      kThreadId, ThreadStateSlice::kUninterruptibleSleep, 5, 15,
+      ThreadStateSliceInfo::WakeupReason::kNotApplicable, 0, 0, std::nullopt});
+
+  EXPECT_THAT(GetRows(CreateThreadStateSliceTable(capture_data)),
+              ElementsAre(Row{5, 15, kThreadId, ThreadStateSlice::kUninterruptibleSleep},
+                          Row{10, 20, kOtherThreadId, ThreadStateSlice::kRunning}));
+}
+
+TEST(CaptureQuery, CreateCallstackSampleTable) {
+  CallstackData callstack_data;
+  callstack_data.AddUniqueCallstack(1, CallstackInfo{{0x10}, CallstackType::kComplete});
+  callstack_data.AddUniqueCallstack(2, CallstackInfo{{0x20}, CallstackType::kComplete});
+  callstack_data.AddCallstackEvent(CallstackEvent{20, 2, kThreadId});
+  callstack_data.AddCallstackEvent(CallstackEvent{10, 1, kOtherThreadId});
+
+  EXPECT_THAT(GetRows(CreateCallstackSampleTable(callstack_data)),
+              ElementsAre(Row{10, 10, kOtherThreadId, 1}, Row{20, 20, kThreadId, 2}));
+}
+
+}  // namespace orbit_client_model
@@ -0,0 +1,145 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientModel/CaptureSummary.h"
+
+#include <absl/container/btree_map.h>
+#include <absl/numeric/bits.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ClientData/ScopeId.h"
+#include "ClientData/ScopeStats.h"
+
+using orbit_client_data::CaptureData;
+using orbit_client_data::PostProcessedSamplingData;
+using orbit_client_data::ScopeId;
+using orbit_client_data::ScopeStats;
+using orbit_client_data::ThreadSampleData;
+using orbit_client_protos::CaptureSummaryEntry;
+
+namespace orbit_client_model {
+
+namespace {
+
+void AddScopeStatsEntries(const CaptureData& capture_data,
+                          std::vector<CaptureSummaryEntry>* entries) {
+  std::vector<ScopeId> scope_ids = capture_data.GetAllProvidedScopeIds();
+  std::sort(scope_ids.begin(), scope_ids.end());
+  for (const ScopeId scope_id : scope_ids) {
+    const ScopeStats& stats = capture_data.GetScopeStatsOrDefault(scope_id);
+    if (stats.count() == 0) continue;
+
+    orbit_client_protos::ScopeStatsSummary* scope_stats =
+        entries->emplace_back().mutable_scope_stats();
+    scope_stats->set_scope_id(*scope_id);
+    scope_stats->set_name(capture_data.GetScopeInfo(scope_id).GetName());
+    scope_stats->set_count(stats.count());
+    scope_stats->set_total_time_ns(stats.total_time_ns());
+    scope_stats->set_min_ns(stats.min_ns());
+    scope_stats->set_max_ns(stats.max_ns());
+    scope_stats->set_variance_ns(stats.variance_ns());
+
+    const std::vector<uint64_t>* durations =
+        capture_data.GetSortedTimerDurationsForScopeId(scope_id);
+    if (durations == nullptr) continue;
+    for (const uint64_t duration_ns : *durations) {
+      // Durations of 0 are counted in the first bucket.
+      const int bucket = duration_ns == 0 ? 0 : absl::bit_width(duration_ns) - 1;
+      while (scope_stats->log2_duration_histogram_size() <= bucket) {
+        scope_stats->add_log2_duration_histogram(0);
+      }
+      scope_stats->set_log2_duration_histogram(
+          bucket, scope_stats->log2_duration_histogram(bucket) + 1);
+    }
+  }
+}
+
+void AddThreadEntries(const CaptureData& capture_data,
+                      const PostProcessedSamplingData& post_processed_sampling_data,
+                      std::vector<CaptureSummaryEntry>* entries) {
+  absl::btree_map<uint32_t, orbit_client_protos::ThreadSummary> tid_to_thread;
+  for (const auto& [tid, name] : capture_data.thread_names()) {
+    orbit_client_protos::ThreadSummary& thread = tid_to_thread[tid];
+    thread.set_tid(tid);
+    thread.set_name(name);
+  }
+  for (const ThreadSampleData* thread_sample_data :
+       post_processed_sampling_data.GetSortedThreadSampleData()) {
+    orbit_client_protos::ThreadSummary& thread = tid_to_thread[thread_sample_data->thread_id];
+    thread.set_tid(thread_sample_data->thread_id);
+    thread.set_samples_count(thread_sample_data->samples_count);
+    thread.set_unwinding_errors_count(thread_sample_data->unwinding_errors_count);
+  }
+
+  for (auto& [unused_tid, thread] : tid_to_thread) {
+    *entries->emplace_back().mutable_thread() = std::move(thread);
+  }
+}
+
+void AddSamplingEntries(const PostProcessedSamplingData& post_processed_sampling_data,
+                        std::vector<CaptureSummaryEntry>* entries) {
+  std::vector<const ThreadSampleData*> thread_sample_data =
+      post_processed_sampling_data.GetSortedThreadSampleData();
+  std::sort(thread_sample_data.begin(), thread_sample_data.end(),
+            [](const ThreadSampleData* lhs, const ThreadSampleData* rhs) {
+              return lhs->thread_id < rhs->thread_id;
+            });
+
+  for (const ThreadSampleData* data : thread_sample_data) {
+    std::vector<const orbit_client_data::SampledFunction*> sampled_functions;
+    sampled_functions.reserve(data->sampled_functions.size());
+    for (const orbit_client_data::SampledFunction& function : data->sampled_functions) {
+      sampled_functions.push_back(&function);
+    }
+    std::sort(sampled_functions.begin(), sampled_functions.end(),
+              [](const orbit_client_data::SampledFunction* lhs,
+                 const orbit_client_data::SampledFunction* rhs) {
+                return lhs->absolute_address < rhs->absolute_address;
+              });
+    for (const orbit_client_data::SampledFunction* function : sampled_functions) {
+      orbit_client_protos::SampledFunctionSummary* sampled_function =
+          entries->emplace_back().mutable_sampled_function();
+      sampled_function->set_tid(data->thread_id);
+      sampled_function->set_absolute_address(function->absolute_address);
+      sampled_function->set_exclusive_count(function->exclusive);
+      sampled_function->set_inclusive_count(function->inclusive);
+      sampled_function->set_unwind_errors_count(function->unwind_errors);
+      sampled_function->set_function_name(function->name);
+      sampled_function->set_module_path(function->module_path);
+    }
+
+    const absl::btree_map<uint64_t, uint32_t> callstack_id_to_count = [data] {
+      absl::btree_map<uint64_t, uint32_t> result;
+      for (const auto& [callstack_id, events] : data->sampled_callstack_id_to_events) {
+        result.emplace(callstack_id, events.size());
+      }
+      return result;
+    }();
+    for (const auto& [callstack_id, count] : callstack_id_to_count) {
+      orbit_client_protos::CallstackCountSummary* callstack_count =
+          entries->emplace_back().mutable_callstack_count();
+      callstack_count->set_tid(data->thread_id);
+      callstack_count->set_callstack_id(callstack_id);
+      callstack_count->set_count(count);
+    }
+  }
+}
+
+}  // namespace
+
+std::vector<CaptureSummaryEntry> CreateCaptureSummary(
+    const CaptureData& capture_data,
+    const PostProcessedSamplingData& post_processed_sampling_data) {
+  std::vector<CaptureSummaryEntry> entries;
+  AddScopeStatsEntries(capture_data, &entries);
+  AddThreadEntries(capture_data, post_processed_sampling_data, &entries);
+  AddSamplingEntries(post_processed_sampling_data, &entries);
+  return entries;
+}
+
+}  // namespace orbit_client_model
@@ -0,0 +1,149 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientModel/CaptureSummaryDiff.h"
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_format.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "CaptureFile/CaptureFile.h"
+#include "CaptureFile/CaptureFileHelpers.h"
+#include "ClientData/ModuleAndFunctionLookup.h"
+#include "OrbitBase/ThreadConstants.h"
+
+using orbit_client_protos::CaptureSummaryEntry;
+
+namespace orbit_client_model {
+
+namespace {
+
+// Accumulates the entries of both summaries by their key, which is the hash join of the two.
+class CaptureSummaryDiffBuilder {
+ public:
+  void AddEntries(const std::vector<CaptureSummaryEntry>& entries, bool is_baseline) {
+    for (const CaptureSummaryEntry& entry : entries) {
+      switch (entry.entry_case()) {
+        case CaptureSummaryEntry::kScopeStats:
+          AddScopeStats(entry.scope_stats(), is_baseline);
+          break;
+        case CaptureSummaryEntry::kThread:
+          if (entry.thread().tid() != orbit_base::kAllProcessThreadsTid) break;
+          (is_baseline ? diff_.baseline_samples_count : diff_.comparison_samples_count) =
+              entry.thread().samples_count();
+          break;
+        case CaptureSummaryEntry::kSampledFunction:
+          AddSampledFunction(entry.sampled_function(), is_baseline);
+          break;
+        case CaptureSummaryEntry::kCallstackCount:
+        case CaptureSummaryEntry::ENTRY_NOT_SET:
+          break;
+      }
+    }
+  }
+
+  [[nodiscard]] CaptureSummaryDiff Build() && {
+    diff_.sampled_functions.reserve(key_to_sampled_function_.size());
+    for (auto& [unused_key, sampled_function] : key_to_sampled_function_) {
+      diff_.sampled_functions.push_back(std::move(sampled_function));
+    }
+    std::sort(diff_.sampled_functions.begin(), diff_.sampled_functions.end(),
+              [](const SampledFunctionDiff& lhs, const SampledFunctionDiff& rhs) {
+                return std::tie(lhs.module_path, lhs.function_name) <
+                       std::tie(rhs.module_path, rhs.function_name);
+              });
+
+    diff_.scopes.reserve(name_to_scope_.size());
+    for (auto& [unused_name, scope] : name_to_scope_) {
+      diff_.scopes.push_back(std::move(scope));
+    }
+    std::sort(diff_.scopes.begin(), diff_.scopes.end(),
+              [](const ScopeDiff& lhs, const ScopeDiff& rhs) { return lhs.name < rhs.name; });
+    return std::move(diff_);
+  }
+
+ private:
+  void AddScopeStats(const orbit_client_protos::ScopeStatsSummary& scope_stats, bool is_baseline) {
+    if (scope_stats.name().empty()) return;
+    auto [it, inserted] = name_to_scope_.try_emplace(scope_stats.name());
+    ScopeDiff& scope = it->second;
+    if (inserted) scope.name = scope_stats.name();
+    // Scopes of different types can have the same name, in which case they are summed up.
+    if (is_baseline) {
+      scope.baseline_count += scope_stats.count();
+      scope.baseline_total_time_ns += scope_stats.total_time_ns();
+    } else {
+      scope.comparison_count += scope_stats.count();
+      scope.comparison_total_time_ns += scope_stats.total_time_ns();
+    }
+  }
+
+  void AddSampledFunction(const orbit_client_protos::SampledFunctionSummary& sampled_function,
+                          bool is_baseline) {
+    // Thread ids differ between captures, so only the counts over all threads are compared.
+    if (sampled_function.tid() != orbit_base::kAllProcessThreadsTid) return;
+    if (sampled_function.function_name().empty() ||
+        sampled_function.function_name() == orbit_client_data::kUnknownFunctionOrModuleName) {
+      return;
+    }
+
+    auto [it, inserted] = key_to_sampled_function_.try_emplace(
+        std::make_pair(sampled_function.module_path(), sampled_function.function_name()));
+    SampledFunctionDiff& function = it->second;
+    if (inserted) {
+      function.module_path = sampled_function.module_path();
+      function.function_name = sampled_function.function_name();
+    }
+    if (is_baseline) {
+      function.baseline_exclusive_count += sampled_function.exclusive_count();
+      function.baseline_inclusive_count += sampled_function.inclusive_count();
+    } else {
+      function.comparison_exclusive_count += sampled_function.exclusive_count();
+      function.comparison_inclusive_count += sampled_function.inclusive_count();
+    }
+  }
+
+  CaptureSummaryDiff diff_;
+  absl::flat_hash_map<std::pair<std::string, std::string>, SampledFunctionDiff>
+      key_to_sampled_function_;
+  absl::flat_hash_map<std::string, ScopeDiff> name_to_scope_;
+};
+
+[[nodiscard]] ErrorMessageOr<std::vector<CaptureSummaryEntry>> ReadCaptureSummaryFromFile(
+    const std::filesystem::path& file_path) {
+  OUTCOME_TRY(auto&& capture_file, orbit_capture_file::CaptureFile::OpenForReadWrite(file_path));
+  OUTCOME_TRY(auto&& entries, orbit_capture_file::ReadCaptureSummary(capture_file.get()));
+  if (!entries.has_value()) {
+    return ErrorMessage{
+        absl::StrFormat("Capture file \"%s\" has no capture summary", file_path.string())};
+  }
+  return std::move(entries.value());
+}
+
+}  // namespace
+
+CaptureSummaryDiff DiffCaptureSummaries(const std::vector<CaptureSummaryEntry>& baseline,
+                                        const std::vector<CaptureSummaryEntry>& comparison) {
+  CaptureSummaryDiffBuilder builder;
+  builder.AddEntries(baseline, /*is_baseline=*/true);
+  builder.AddEntries(comparison, /*is_baseline=*/false);
+  return std::move(builder).Build();
+}
+
+ErrorMessageOr<CaptureSummaryDiff> DiffCaptureFiles(
+    const std::filesystem::path& baseline_file_path,
+    const std::filesystem::path& comparison_file_path) {
+  OUTCOME_TRY(auto&& baseline, ReadCaptureSummaryFromFile(baseline_file_path));
+  OUTCOME_TRY(auto&& comparison, ReadCaptureSummaryFromFile(comparison_file_path));
+  return DiffCaptureSummaries(baseline, comparison);
+}
+
+}  // namespace orbit_client_model
@@ -0,0 +1,168 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CaptureFile/CaptureFileHelpers.h"
+#include "CaptureFile/CaptureFileOutputStream.h"
+#include "ClientModel/CaptureSummaryDiff.h"
+#include "ClientProtos/capture_summary.pb.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/ThreadConstants.h"
+#include "TestUtils/TemporaryDirectory.h"
+#include "TestUtils/TestUtils.h"
+
+using orbit_client_protos::CaptureSummaryEntry;
+using orbit_test_utils::HasErrorWithMessage;
+using orbit_test_utils::HasNoError;
+using testing::AllOf;
+using testing::ElementsAre;
+using testing::Field;
+
+namespace orbit_client_model {
+
+namespace {
+
+constexpr uint32_t kTid = 42;
+constexpr const char* kModulePath = "/path/to/module";
+
+void AddScopeStats(std::vector<CaptureSummaryEntry>* entries, uint64_t scope_id, std::string name,
+                   uint64_t count, uint64_t total_time_ns) {
+  orbit_client_protos::ScopeStatsSummary* scope_stats =
+      entries->emplace_back().mutable_scope_stats();
+  scope_stats->set_scope_id(scope_id);
+  scope_stats->set_name(std::move(name));
+  scope_stats->set_count(count);
+  scope_stats->set_total_time_ns(total_time_ns);
+}
+
+void AddSampledFunction(std::vector<CaptureSummaryEntry>* entries, uint32_t tid,
+                        uint64_t absolute_address, std::string function_name,
+                        uint32_t exclusive_count, uint32_t inclusive_count) {
+  orbit_client_protos::SampledFunctionSummary* sampled_function =
+      entries->emplace_back().mutable_sampled_function();
+  sampled_function->set_tid(tid);
+  sampled_function->set_absolute_address(absolute_address);
+  sampled_function->set_function_name(std::move(function_name));
+  sampled_function->set_module_path(kModulePath);
+  sampled_function->set_exclusive_count(exclusive_count);
+  sampled_function->set_inclusive_count(inclusive_count);
+}
+
+void AddAllThreadsSamplesCount(std::vector<CaptureSummaryEntry>* entries, uint32_t samples_count) {
+  orbit_client_protos::ThreadSummary* thread = entries->emplace_back().mutable_thread();
+  thread->set_tid(orbit_base::kAllProcessThreadsTid);
+  thread->set_samples_count(samples_count);
+}
+
+auto SampledFunctionDiffIs(std::string function_name, uint32_t baseline_exclusive_count,
+                           uint32_t baseline_inclusive_count, uint32_t comparison_exclusive_count,
+                           uint32_t comparison_inclusive_count) {
+  return AllOf(
+      Field(&SampledFunctionDiff::module_path, kModulePath),
+      Field(&SampledFunctionDiff::function_name, function_name),
+      Field(&SampledFunctionDiff::baseline_exclusive_count, baseline_exclusive_count),
+      Field(&SampledFunctionDiff::baseline_inclusive_count, baseline_inclusive_count),
+      Field(&SampledFunctionDiff::comparison_exclusive_count, comparison_exclusive_count),
+      Field(&SampledFunctionDiff::comparison_inclusive_count, comparison_inclusive_count));
+}
+
+auto ScopeDiffIs(std::string name, uint64_t baseline_count, uint64_t baseline_total_time_ns,
+                 uint64_t comparison_count, uint64_t comparison_total_time_ns) {
+  return AllOf(Field(&ScopeDiff::name, name), Field(&ScopeDiff::baseline_count, baseline_count),
+               Field(&ScopeDiff::baseline_total_time_ns, baseline_total_time_ns),
+               Field(&ScopeDiff::comparison_count, comparison_count),
+               Field(&ScopeDiff::comparison_total_time_ns, comparison_total_time_ns));
+}
+
+void CreateCaptureFile(const std::filesystem::path& file_path) {
+  auto output_stream_or_error = orbit_capture_file::CaptureFileOutputStream::Create(file_path);
+  ASSERT_THAT(output_stream_or_error, HasNoError());
+  orbit_grpc_protos::ClientCaptureEvent event;
+  event.mutable_interned_string()->set_key(1);
+  event.mutable_interned_string()->set_intern("foo");
+  ASSERT_THAT(output_stream_or_error.value()->WriteCaptureEvent(event), HasNoError());
+  ASSERT_THAT(output_stream_or_error.value()->Close(), HasNoError());
+}
+
+}  // namespace
+
+TEST(CaptureSummaryDiff, MatchesFunctionsAndScopesByName) {
+  std::vector<CaptureSummaryEntry> baseline;
+  AddScopeStats(&baseline, 1, "Render", 10, 1000);
+  AddScopeStats(&baseline, 2, "Update", 10, 300);
+  AddAllThreadsSamplesCount(&baseline, 100);
+  AddSampledFunction(&baseline, orbit_base::kAllProcessThreadsTid, 0x1000, "foo", 20, 50);
+  AddSampledFunction(&baseline, orbit_base::kAllProcessThreadsTid, 0x2000, "bar", 5, 5);
+  // Per-thread counts are not compared.
+  AddSampledFunction(&baseline, kTid, 0x1000, "foo", 20, 50);
+
+  std::vector<CaptureSummaryEntry> comparison;
+  // Scope ids and addresses differ from the baseline.
+  AddScopeStats(&comparison, 1, "Update", 12, 600);
+  AddScopeStats(&comparison, 2, "Render", 9, 900);
+  AddScopeStats(&comparison, 3, "Load", 1, 5000);
+  AddAllThreadsSamplesCount(&comparison, 120);
+  AddSampledFunction(&comparison, orbit_base::kAllProcessThreadsTid, 0x5000, "foo", 30, 60);
+  AddSampledFunction(&comparison, orbit_base::kAllProcessThreadsTid, 0x6000, "baz", 1, 2);
+
+  const CaptureSummaryDiff diff = DiffCaptureSummaries(baseline, comparison);
+  EXPECT_EQ(diff.baseline_samples_count, 100);
+  EXPECT_EQ(diff.comparison_samples_count, 120);
+  EXPECT_THAT(diff.sampled_functions,
+              ElementsAre(SampledFunctionDiffIs("bar", 5, 5, 0, 0),
+                          SampledFunctionDiffIs("baz", 0, 0, 1, 2),
+                          SampledFunctionDiffIs("foo", 20, 50, 30, 60)));
+  EXPECT_THAT(diff.scopes, ElementsAre(ScopeDiffIs("Load", 0, 0, 1, 5000),
+                                       ScopeDiffIs("Render", 10, 1000, 9, 900),
+                                       ScopeDiffIs("Update", 10, 300, 12, 600)));
+}
+
+TEST(CaptureSummaryDiff, SkipsEntriesWithoutNames) {
+  std::vector<CaptureSummaryEntry> baseline;
+  AddScopeStats(&baseline, 1, "", 10, 1000);
+  AddSampledFunction(&baseline, orbit_base::kAllProcessThreadsTid, 0x1000, "", 20, 50);
+  AddSampledFunction(&baseline, orbit_base::kAllProcessThreadsTid, 0x2000, "???", 5, 5);
+
+  const CaptureSummaryDiff diff = DiffCaptureSummaries(baseline, baseline);
+  EXPECT_TRUE(diff.sampled_functions.empty());
+  EXPECT_TRUE(diff.scopes.empty());
+}
+
+TEST(CaptureSummaryDiff, DiffCaptureFiles) {
+  auto temporary_dir_or_error = orbit_test_utils::TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_dir_or_error, HasNoError());
+  orbit_test_utils::TemporaryDirectory temporary_dir = std::move(temporary_dir_or_error.value());
+  const std::filesystem::path baseline_path = temporary_dir.GetDirectoryPath() / "baseline.orbit";
+  const std::filesystem::path comparison_path =
+      temporary_dir.GetDirectoryPath() / "comparison.orbit";
+  CreateCaptureFile(baseline_path);
+  CreateCaptureFile(comparison_path);
+
+  std::vector<CaptureSummaryEntry> baseline;
+  AddScopeStats(&baseline, 1, "Render", 10, 1000);
+  ASSERT_THAT(orbit_capture_file::WriteCaptureSummary(baseline_path, baseline), HasNoError());
+
+  EXPECT_THAT(DiffCaptureFiles(baseline_path, comparison_path),
+              HasErrorWithMessage("has no capture summary"));
+
+  std::vector<CaptureSummaryEntry> comparison;
+  AddScopeStats(&comparison, 7, "Render", 12, 1100);
+  ASSERT_THAT(orbit_capture_file::WriteCaptureSummary(comparison_path, comparison), HasNoError());
+
+  auto diff_or_error = DiffCaptureFiles(baseline_path, comparison_path);
+  ASSERT_THAT(diff_or_error, HasNoError());
+  EXPECT_TRUE(diff_or_error.value().sampled_functions.empty());
+  EXPECT_THAT(diff_or_error.value().scopes, ElementsAre(ScopeDiffIs("Render", 10, 1000, 12, 1100)));
+}
+
+}  // namespace orbit_client_model
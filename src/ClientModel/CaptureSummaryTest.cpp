@@ -0,0 +1,130 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/container/flat_hash_map.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/CaptureData.h"
+#include "ClientData/ModuleIdentifierProvider.h"
+#include "ClientData/PostProcessedSamplingData.h"
+#include "ClientModel/CaptureSummary.h"
+#include "ClientProtos/capture_data.pb.h"
+#include "ClientProtos/capture_summary.pb.h"
+#include "GrpcProtos/capture.pb.h"
+
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CaptureData;
+using orbit_client_data::PostProcessedSamplingData;
+using orbit_client_data::ThreadSampleData;
+using orbit_client_protos::CaptureSummaryEntry;
+using testing::ElementsAre;
+
+namespace orbit_client_model {
+
+namespace {
+
+constexpr uint64_t kFunctionId = 1;
+constexpr uint32_t kFirstTid = 42;
+constexpr uint32_t kSecondTid = 43;
+constexpr uint64_t kFunctionAddress = 0x1000;
+constexpr uint64_t kOtherFunctionAddress = 0x800;
+constexpr uint64_t kCallstackId = 7;
+
+[[nodiscard]] orbit_grpc_protos::CaptureStarted CreateCaptureStarted() {
+  orbit_grpc_protos::CaptureStarted capture_started;
+  orbit_grpc_protos::InstrumentedFunction* function =
+      capture_started.mutable_capture_options()->add_instrumented_functions();
+  function->set_function_id(kFunctionId);
+  function->set_function_name("foo()");
+  return capture_started;
+}
+
+[[nodiscard]] PostProcessedSamplingData CreatePostProcessedSamplingData() {
+  ThreadSampleData thread_sample_data;
+  thread_sample_data.thread_id = kFirstTid;
+  thread_sample_data.samples_count = 3;
+  thread_sample_data.unwinding_errors_count = 1;
+  thread_sample_data.sampled_callstack_id_to_events[kCallstackId] = {
+      CallstackEvent{100, kCallstackId, kFirstTid}, CallstackEvent{200, kCallstackId, kFirstTid}};
+  orbit_client_data::SampledFunction& function =
+      thread_sample_data.sampled_functions.emplace_back();
+  function.absolute_address = kFunctionAddress;
+  function.name = "foo";
+  function.module_path = "/path/to/module";
+  function.exclusive = 2;
+  function.inclusive = 3;
+  orbit_client_data::SampledFunction& other_function =
+      thread_sample_data.sampled_functions.emplace_back();
+  other_function.absolute_address = kOtherFunctionAddress;
+  other_function.inclusive = 1;
+
+  absl::flat_hash_map<uint32_t, ThreadSampleData> thread_id_to_sample_data;
+  thread_id_to_sample_data.emplace(kFirstTid, std::move(thread_sample_data));
+  return PostProcessedSamplingData{std::move(thread_id_to_sample_data), {}, {}, {}};
+}
+
+}  // namespace
+
+TEST(CaptureSummary, CreateCaptureSummary) {
+  orbit_client_data::ModuleIdentifierProvider module_identifier_provider;
+  CaptureData capture_data{CreateCaptureStarted(), std::nullopt, {},
+                           CaptureData::DataSource::kLiveCapture, &module_identifier_provider};
+  for (const uint64_t duration_ns : {1, 3, 5, 6}) {
+    orbit_client_protos::TimerInfo timer;
+    timer.set_function_id(kFunctionId);
+    timer.set_start(1000);
+    timer.set_end(1000 + duration_ns);
+    capture_data.UpdateScopeStats(timer);
+  }
+  capture_data.AddOrAssignThreadName(kSecondTid, "second");
+  capture_data.AddOrAssignThreadName(kFirstTid, "first");
+  capture_data.OnCaptureComplete();
+
+  const std::vector<CaptureSummaryEntry> entries =
+      CreateCaptureSummary(capture_data, CreatePostProcessedSamplingData());
+  ASSERT_EQ(entries.size(), 6);
+
+  ASSERT_TRUE(entries[0].has_scope_stats());
+  EXPECT_EQ(entries[0].scope_stats().name(), "foo()");
+  EXPECT_EQ(entries[0].scope_stats().count(), 4);
+  EXPECT_EQ(entries[0].scope_stats().total_time_ns(), 15);
+  EXPECT_EQ(entries[0].scope_stats().min_ns(), 1);
+  EXPECT_EQ(entries[0].scope_stats().max_ns(), 6);
+  EXPECT_THAT(entries[0].scope_stats().log2_duration_histogram(), ElementsAre(1, 1, 2));
+
+  ASSERT_TRUE(entries[1].has_thread());
+  EXPECT_EQ(entries[1].thread().tid(), kFirstTid);
+  EXPECT_EQ(entries[1].thread().name(), "first");
+  EXPECT_EQ(entries[1].thread().samples_count(), 3);
+  EXPECT_EQ(entries[1].thread().unwinding_errors_count(), 1);
+  ASSERT_TRUE(entries[2].has_thread());
+  EXPECT_EQ(entries[2].thread().tid(), kSecondTid);
+  EXPECT_EQ(entries[2].thread().name(), "second");
+  EXPECT_EQ(entries[2].thread().samples_count(), 0);
+
+  ASSERT_TRUE(entries[3].has_sampled_function());
+  EXPECT_EQ(entries[3].sampled_function().tid(), kFirstTid);
+  EXPECT_EQ(entries[3].sampled_function().absolute_address(), kOtherFunctionAddress);
+  EXPECT_EQ(entries[3].sampled_function().inclusive_count(), 1);
+  ASSERT_TRUE(entries[4].has_sampled_function());
+  EXPECT_EQ(entries[4].sampled_function().absolute_address(), kFunctionAddress);
+  EXPECT_EQ(entries[4].sampled_function().function_name(), "foo");
+  EXPECT_EQ(entries[4].sampled_function().module_path(), "/path/to/module");
+  EXPECT_EQ(entries[4].sampled_function().exclusive_count(), 2);
+  EXPECT_EQ(entries[4].sampled_function().inclusive_count(), 3);
+
+  ASSERT_TRUE(entries[5].has_callstack_count());
+  EXPECT_EQ(entries[5].callstack_count().tid(), kFirstTid);
+  EXPECT_EQ(entries[5].callstack_count().callstack_id(), kCallstackId);
+  EXPECT_EQ(entries[5].callstack_count().count(), 2);
+}
+
+}  // namespace orbit_client_model
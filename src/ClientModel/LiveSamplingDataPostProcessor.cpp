@@ -0,0 +1,193 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ClientModel/LiveSamplingDataPostProcessor.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ClientData/CallstackData.h"
+#include "ClientData/CallstackInfo.h"
+#include "ClientData/CallstackType.h"
+#include "ClientData/ModuleAndFunctionLookup.h"
+#include "OrbitBase/Logging.h"
+
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CallstackInfo;
+using orbit_client_data::CallstackType;
+using orbit_client_data::CaptureData;
+using orbit_client_data::ModuleManager;
+using orbit_client_data::PostProcessedSamplingData;
+using orbit_client_data::SampledFunction;
+using orbit_client_data::ThreadID;
+using orbit_client_data::ThreadSampleData;
+
+namespace orbit_client_model {
+
+LiveSamplingDataPostProcessor::LiveSamplingDataPostProcessor(const CaptureData* capture_data,
+                                                             const ModuleManager* module_manager,
+                                                             absl::Duration min_snapshot_interval,
+                                                             size_t top_function_count)
+    : capture_data_{capture_data},
+      module_manager_{module_manager},
+      min_snapshot_interval_{min_snapshot_interval},
+      top_function_count_{top_function_count} {
+  ORBIT_CHECK(capture_data_ != nullptr);
+  ORBIT_CHECK(module_manager_ != nullptr);
+}
+
+bool LiveSamplingDataPostProcessor::ProcessCallstackEvent(const CallstackEvent& event,
+                                                          absl::Time now) {
+  absl::MutexLock lock(&mutex_);
+  const ResolvedCallstack& callstack = GetOrResolveCallstack(event.callstack_id());
+
+  for (ThreadID thread_id : {event.thread_id(), orbit_base::kAllProcessThreadsTid}) {
+    ThreadCounters& counters = thread_id_to_counters_[thread_id];
+    ++counters.samples_count;
+    ++counters.function_address_to_exclusive_count[callstack.innermost_function_address];
+    for (uint64_t function_address : callstack.unique_function_addresses) {
+      ++counters.function_address_to_inclusive_count[function_address];
+    }
+    if (!callstack.is_complete) {
+      ++counters.unwinding_errors_count;
+      ++counters.function_address_to_error_count[callstack.innermost_function_address];
+    }
+  }
+
+  if (is_snapshot_requested_ || now - last_snapshot_time_ < min_snapshot_interval_) return false;
+  is_snapshot_requested_ = true;
+  return true;
+}
+
+const LiveSamplingDataPostProcessor::ResolvedCallstack&
+LiveSamplingDataPostProcessor::GetOrResolveCallstack(uint64_t callstack_id) {
+  mutex_.AssertHeld();
+  auto [it, inserted] = id_to_resolved_callstack_.try_emplace(callstack_id);
+  if (!inserted) return it->second;
+
+  const CallstackInfo* callstack_info =
+      capture_data_->GetCallstackData().GetCallstack(callstack_id);
+  ORBIT_CHECK(callstack_info != nullptr);
+  ORBIT_CHECK(!callstack_info->frames().empty());
+
+  auto get_function_address = [this](uint64_t address) {
+    auto [function_address_it, function_address_inserted] =
+        exact_address_to_function_address_.try_emplace(address, address);
+    if (function_address_inserted) {
+      std::optional<uint64_t> function_address =
+          orbit_client_data::FindFunctionAbsoluteAddressByInstructionAbsoluteAddress(
+              *module_manager_, *capture_data_, address);
+      if (function_address.has_value()) function_address_it->second = function_address.value();
+    }
+    return function_address_it->second;
+  };
+
+  ResolvedCallstack& resolved_callstack = it->second;
+  resolved_callstack.is_complete = callstack_info->type() == CallstackType::kComplete;
+  resolved_callstack.innermost_function_address =
+      get_function_address(callstack_info->frames()[0]);
+  if (resolved_callstack.is_complete) {
+    for (uint64_t address : callstack_info->frames()) {
+      resolved_callstack.unique_function_addresses.push_back(get_function_address(address));
+    }
+    // Recursive functions must only be counted once per sample.
+    std::sort(resolved_callstack.unique_function_addresses.begin(),
+              resolved_callstack.unique_function_addresses.end());
+    resolved_callstack.unique_function_addresses.erase(
+        std::unique(resolved_callstack.unique_function_addresses.begin(),
+                    resolved_callstack.unique_function_addresses.end()),
+        resolved_callstack.unique_function_addresses.end());
+  } else {
+    // For non-kComplete callstacks, only use the innermost frame for statistics.
+    resolved_callstack.unique_function_addresses.push_back(
+        resolved_callstack.innermost_function_address);
+  }
+  return resolved_callstack;
+}
+
+ThreadSampleData LiveSamplingDataPostProcessor::CreateThreadSampleData(
+    ThreadID thread_id, const ThreadCounters& counters) const {
+  mutex_.AssertHeld();
+  ThreadSampleData thread_sample_data;
+  thread_sample_data.thread_id = thread_id;
+  thread_sample_data.samples_count = counters.samples_count;
+  thread_sample_data.unwinding_errors_count = counters.unwinding_errors_count;
+
+  // Only the top functions are sorted, so that the cost of a snapshot is linear in the number of
+  // sampled functions.
+  std::vector<std::pair<uint64_t, uint32_t>> top_functions(
+      counters.function_address_to_inclusive_count.begin(),
+      counters.function_address_to_inclusive_count.end());
+  const size_t top_count = std::min(top_function_count_, top_functions.size());
+  std::partial_sort(top_functions.begin(), top_functions.begin() + top_count, top_functions.end(),
+                    [](const auto& lhs, const auto& rhs) {
+                      if (lhs.second != rhs.second) return lhs.second > rhs.second;
+                      return lhs.first < rhs.first;
+                    });
+  top_functions.resize(top_count);
+
+  auto get_count = [](const absl::flat_hash_map<uint64_t, uint32_t>& counts,
+                      uint64_t function_address) -> uint32_t {
+    auto it = counts.find(function_address);
+    return it != counts.end() ? it->second : 0;
+  };
+
+  const float samples_count = counters.samples_count;
+  thread_sample_data.sampled_functions.reserve(top_count);
+  for (const auto& [function_address, inclusive] : top_functions) {
+    SampledFunction function;
+    function.absolute_address = function_address;
+    function.inclusive = inclusive;
+    function.inclusive_percent = 100.f * inclusive / samples_count;
+    function.exclusive = get_count(counters.function_address_to_exclusive_count, function_address);
+    function.exclusive_percent = 100.f * function.exclusive / samples_count;
+    function.unwind_errors =
+        get_count(counters.function_address_to_error_count, function_address);
+    function.unwind_errors_percent = 100.f * function.unwind_errors / samples_count;
+    thread_sample_data.sampled_functions.push_back(function);
+
+    thread_sample_data.resolved_address_to_count.emplace(function_address, function.inclusive);
+    thread_sample_data.resolved_address_to_exclusive_count.emplace(function_address,
+                                                                   function.exclusive);
+    thread_sample_data.resolved_address_to_error_count.emplace(function_address,
+                                                               function.unwind_errors);
+    thread_sample_data.sorted_count_to_resolved_address.emplace(function.inclusive,
+                                                                function_address);
+  }
+  return thread_sample_data;
+}
+
+PostProcessedSamplingData LiveSamplingDataPostProcessor::CreateSnapshot(absl::Time now) {
+  absl::flat_hash_map<ThreadID, ThreadSampleData> thread_id_to_sample_data;
+  {
+    absl::MutexLock lock(&mutex_);
+    last_snapshot_time_ = now;
+    is_snapshot_requested_ = false;
+    for (const auto& [thread_id, counters] : thread_id_to_counters_) {
+      thread_id_to_sample_data.emplace(thread_id, CreateThreadSampleData(thread_id, counters));
+    }
+  }
+  // Only include the summary if there is more than 1 thread in the data.
+  if (thread_id_to_sample_data.size() == 2) {
+    thread_id_to_sample_data.erase(orbit_base::kAllProcessThreadsTid);
+  }
+
+  // The symbol lookups don't need the counters, so they are done without holding the lock.
+  for (auto& [unused_thread_id, thread_sample_data] : thread_id_to_sample_data) {
+    for (SampledFunction& function : thread_sample_data.sampled_functions) {
+      function.name = orbit_client_data::GetFunctionNameByAddress(*module_manager_, *capture_data_,
+                                                                  function.absolute_address);
+      function.module_path = orbit_client_data::GetModulePathByAddress(
+          *module_manager_, *capture_data_, function.absolute_address);
+    }
+  }
+
+  return {std::move(thread_id_to_sample_data), {}, {}, {}};
+}
+
+}  // namespace orbit_client_model
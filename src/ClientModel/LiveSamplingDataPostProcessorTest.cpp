@@ -0,0 +1,217 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/time/time.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/CallstackInfo.h"
+#include "ClientData/CallstackType.h"
+#include "ClientData/CaptureData.h"
+#include "ClientData/LinuxAddressInfo.h"
+#include "ClientData/ModuleIdentifierProvider.h"
+#include "ClientData/ModuleManager.h"
+#include "ClientData/PostProcessedSamplingData.h"
+#include "ClientModel/LiveSamplingDataPostProcessor.h"
+#include "ClientModel/SamplingDataPostProcessor.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/ThreadConstants.h"
+
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CallstackInfo;
+using orbit_client_data::CallstackType;
+using orbit_client_data::CaptureData;
+using orbit_client_data::LinuxAddressInfo;
+using orbit_client_data::ModuleManager;
+using orbit_client_data::PostProcessedSamplingData;
+using orbit_client_data::SampledFunction;
+using orbit_client_data::ThreadSampleData;
+using orbit_grpc_protos::CaptureStarted;
+
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAreArray;
+
+namespace orbit_client_model {
+
+namespace {
+
+constexpr uint32_t kThreadId1 = 42;
+constexpr uint32_t kThreadId2 = 43;
+
+constexpr uint64_t kFunction1Address = 0x10;
+constexpr uint64_t kFunction2Address = 0x20;
+constexpr uint64_t kFunction3Address = 0x30;
+
+constexpr uint64_t kCallstack1Id = 1;
+constexpr uint64_t kCallstack2Id = 2;
+constexpr uint64_t kCallstack3Id = 3;
+
+const absl::Time kStartTime = absl::FromUnixSeconds(1000);
+constexpr absl::Duration kSnapshotInterval = absl::Seconds(1);
+
+auto SampledFunctionProjection(const SampledFunction& function) {
+  return std::make_tuple(function.name, function.module_path, function.absolute_address,
+                         function.inclusive, function.inclusive_percent, function.exclusive,
+                         function.exclusive_percent, function.unwind_errors,
+                         function.unwind_errors_percent);
+}
+
+std::vector<decltype(SampledFunctionProjection(SampledFunction{}))> ProjectSampledFunctions(
+    const ThreadSampleData& thread_sample_data) {
+  std::vector<decltype(SampledFunctionProjection(SampledFunction{}))> result;
+  for (const SampledFunction& function : thread_sample_data.sampled_functions) {
+    result.push_back(SampledFunctionProjection(function));
+  }
+  return result;
+}
+
+class LiveSamplingDataPostProcessorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    AddAddressInfo("function1", kFunction1Address + 1, 1);
+    AddAddressInfo("function2", kFunction2Address + 2, 2);
+    AddAddressInfo("function3", kFunction3Address + 3, 3);
+
+    // Callstack 2 is recursive, callstack 3 has an unwinding error.
+    capture_data_.AddUniqueCallstack(
+        kCallstack1Id,
+        CallstackInfo{{kFunction2Address + 2, kFunction1Address + 1}, CallstackType::kComplete});
+    capture_data_.AddUniqueCallstack(
+        kCallstack2Id, CallstackInfo{{kFunction3Address + 3, kFunction3Address + 3,
+                                      kFunction1Address + 1},
+                                     CallstackType::kComplete});
+    capture_data_.AddUniqueCallstack(
+        kCallstack3Id, CallstackInfo{{kFunction3Address + 3, kFunction2Address + 2},
+                                     CallstackType::kDwarfUnwindingError});
+  }
+
+  void AddAddressInfo(std::string function_name, uint64_t absolute_address,
+                      uint64_t offset_in_function) {
+    capture_data_.InsertAddressInfo(
+        LinuxAddressInfo{absolute_address, offset_in_function, kModulePath, function_name});
+  }
+
+  // Adds the CallstackEvent both to the CaptureData and to the LiveSamplingDataPostProcessor, like
+  // OrbitApp does while capturing.
+  bool AddCallstackEvent(uint64_t callstack_id, uint32_t thread_id, absl::Time now = kStartTime) {
+    timestamp_ns_ += 100;
+    CallstackEvent event{timestamp_ns_, callstack_id, thread_id};
+    capture_data_.AddCallstackEvent(event);
+    return live_post_processor_.ProcessCallstackEvent(event, now);
+  }
+
+  void AddCallstackEventsInTwoThreads() {
+    (void)AddCallstackEvent(kCallstack1Id, kThreadId1);
+    (void)AddCallstackEvent(kCallstack1Id, kThreadId1);
+    (void)AddCallstackEvent(kCallstack2Id, kThreadId1);
+    (void)AddCallstackEvent(kCallstack3Id, kThreadId1);
+    (void)AddCallstackEvent(kCallstack2Id, kThreadId2);
+    (void)AddCallstackEvent(kCallstack3Id, kThreadId2);
+  }
+
+  static const inline std::string kModulePath = "/path/to/module";
+
+  orbit_client_data::ModuleIdentifierProvider module_identifier_provider_{};
+  CaptureData capture_data_{CaptureStarted{}, std::filesystem::path{},
+                            absl::flat_hash_set<uint64_t>{}, CaptureData::DataSource::kLiveCapture,
+                            &module_identifier_provider_};
+  ModuleManager module_manager_{&module_identifier_provider_};
+  LiveSamplingDataPostProcessor live_post_processor_{&capture_data_, &module_manager_,
+                                                     kSnapshotInterval, /*top_function_count=*/100};
+  uint64_t timestamp_ns_ = 0;
+};
+
+}  // namespace
+
+TEST_F(LiveSamplingDataPostProcessorTest, SnapshotWithoutCallstackEventsIsEmpty) {
+  PostProcessedSamplingData snapshot = live_post_processor_.CreateSnapshot(kStartTime);
+  EXPECT_TRUE(snapshot.GetSortedThreadSampleData().empty());
+  EXPECT_EQ(snapshot.GetSummary(), nullptr);
+}
+
+TEST_F(LiveSamplingDataPostProcessorTest, OneThreadDoesNotCreateSummary) {
+  (void)AddCallstackEvent(kCallstack1Id, kThreadId1);
+
+  PostProcessedSamplingData snapshot = live_post_processor_.CreateSnapshot(kStartTime);
+  EXPECT_EQ(snapshot.GetSummary(), nullptr);
+  ASSERT_NE(snapshot.GetThreadSampleDataByThreadId(kThreadId1), nullptr);
+  EXPECT_EQ(snapshot.GetThreadSampleDataByThreadId(kThreadId1)->samples_count, 1);
+}
+
+TEST_F(LiveSamplingDataPostProcessorTest, SnapshotMatchesFullPostProcessing) {
+  AddCallstackEventsInTwoThreads();
+
+  PostProcessedSamplingData snapshot = live_post_processor_.CreateSnapshot(kStartTime);
+  PostProcessedSamplingData full = CreatePostProcessedSamplingData(
+      capture_data_.GetCallstackData(), capture_data_, module_manager_);
+
+  for (uint32_t thread_id : {kThreadId1, kThreadId2, orbit_base::kAllProcessThreadsTid}) {
+    SCOPED_TRACE(thread_id);
+    const ThreadSampleData* live_thread_sample_data =
+        snapshot.GetThreadSampleDataByThreadId(thread_id);
+    const ThreadSampleData* full_thread_sample_data = full.GetThreadSampleDataByThreadId(thread_id);
+    ASSERT_NE(live_thread_sample_data, nullptr);
+    ASSERT_NE(full_thread_sample_data, nullptr);
+    EXPECT_EQ(live_thread_sample_data->samples_count, full_thread_sample_data->samples_count);
+    EXPECT_EQ(live_thread_sample_data->unwinding_errors_count,
+              full_thread_sample_data->unwinding_errors_count);
+    EXPECT_THAT(ProjectSampledFunctions(*live_thread_sample_data),
+                UnorderedElementsAreArray(ProjectSampledFunctions(*full_thread_sample_data)));
+    EXPECT_EQ(live_thread_sample_data->resolved_address_to_count,
+              full_thread_sample_data->resolved_address_to_count);
+  }
+  EXPECT_EQ(snapshot.GetCountOfFunction(kFunction1Address),
+            full.GetCountOfFunction(kFunction1Address));
+}
+
+TEST_F(LiveSamplingDataPostProcessorTest, SnapshotOnlyContainsTopFunctions) {
+  LiveSamplingDataPostProcessor live_post_processor{&capture_data_, &module_manager_,
+                                                    kSnapshotInterval, /*top_function_count=*/2};
+  for (uint64_t callstack_id : {kCallstack1Id, kCallstack1Id, kCallstack1Id, kCallstack2Id}) {
+    timestamp_ns_ += 100;
+    (void)live_post_processor.ProcessCallstackEvent(
+        CallstackEvent{timestamp_ns_, callstack_id, kThreadId1}, kStartTime);
+  }
+
+  PostProcessedSamplingData snapshot = live_post_processor.CreateSnapshot(kStartTime);
+  const ThreadSampleData* thread_sample_data = snapshot.GetThreadSampleDataByThreadId(kThreadId1);
+  ASSERT_NE(thread_sample_data, nullptr);
+  EXPECT_EQ(thread_sample_data->samples_count, 4);
+  // Function1 is in all four samples and function2 in three, function3 is dropped.
+  std::vector<uint64_t> function_addresses;
+  for (const SampledFunction& function : thread_sample_data->sampled_functions) {
+    function_addresses.push_back(function.absolute_address);
+  }
+  EXPECT_THAT(function_addresses, ElementsAre(kFunction1Address, kFunction2Address));
+  EXPECT_EQ(thread_sample_data->sampled_functions[1].name, "function2");
+  EXPECT_EQ(thread_sample_data->sampled_functions[1].module_path, kModulePath);
+}
+
+TEST_F(LiveSamplingDataPostProcessorTest, SnapshotsAreRequestedOncePerInterval) {
+  // The first CallstackEvent requests a snapshot, and no other until it has been created.
+  EXPECT_TRUE(AddCallstackEvent(kCallstack1Id, kThreadId1, kStartTime));
+  EXPECT_FALSE(AddCallstackEvent(kCallstack1Id, kThreadId1, kStartTime + kSnapshotInterval));
+
+  PostProcessedSamplingData first_snapshot =
+      live_post_processor_.CreateSnapshot(kStartTime + absl::Milliseconds(100));
+  EXPECT_EQ(first_snapshot.GetThreadSampleDataByThreadId(kThreadId1)->samples_count, 2);
+
+  EXPECT_FALSE(AddCallstackEvent(kCallstack2Id, kThreadId1, kStartTime + absl::Milliseconds(500)));
+  EXPECT_TRUE(AddCallstackEvent(kCallstack2Id, kThreadId1, kStartTime + absl::Milliseconds(1100)));
+  EXPECT_FALSE(AddCallstackEvent(kCallstack2Id, kThreadId1, kStartTime + absl::Milliseconds(1200)));
+
+  PostProcessedSamplingData second_snapshot =
+      live_post_processor_.CreateSnapshot(kStartTime + absl::Milliseconds(1200));
+  EXPECT_EQ(second_snapshot.GetThreadSampleDataByThreadId(kThreadId1)->samples_count, 5);
+}
+
+}  // namespace orbit_client_model
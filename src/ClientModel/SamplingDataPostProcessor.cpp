@@ -9,14 +9,18 @@
 #include <absl/container/flat_hash_set.h>
 #include <absl/hash/hash.h>
 #include <absl/meta/type_traits.h>
+#include <absl/time/time.h>
 #include <stddef.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <iterator>
 #include <map>
+#include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -24,8 +28,11 @@
 #include "ClientData/CallstackInfo.h"
 #include "ClientData/CallstackType.h"
 #include "ClientData/ModuleAndFunctionLookup.h"
+#include "OrbitBase/Future.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ThreadConstants.h"
+#include "OrbitBase/ThreadPool.h"
+#include "OrbitBase/UniqueResource.h"
 
 using orbit_client_data::CallstackData;
 using orbit_client_data::CallstackEvent;
@@ -74,30 +81,78 @@ struct CallstackInfoEq {
   }
 };
 
+// Below this number of CallstackEvents, the post-processing runs on the calling thread only, as
+// starting the threads would take longer than the work.
+constexpr size_t kMinCallstackEventCountForParallelProcessing = 10'000;
+// The addresses are mapped to functions in chunks of this size, to amortize the scheduling.
+constexpr size_t kAddressChunkSize = 1024;
+
+// Calls `function(i)` for each i in [0, count), spread over the threads of `thread_pool` and the
+// calling thread, and returns once all calls have completed. Without a thread pool, all calls run
+// on the calling thread.
+template <typename Function>
+void ParallelFor(orbit_base::ThreadPool* thread_pool, size_t thread_count, size_t count,
+                 Function&& function) {
+  if (thread_pool == nullptr || count <= 1) {
+    for (size_t i = 0; i < count; ++i) function(i);
+    return;
+  }
+
+  std::atomic<size_t> next_index = 0;
+  auto process_indices = [&next_index, count, &function]() {
+    for (size_t i = next_index++; i < count; i = next_index++) function(i);
+  };
+  std::vector<orbit_base::Future<void>> futures;
+  for (size_t i = 1; i < std::min(thread_count, count); ++i) {
+    futures.push_back(thread_pool->Schedule(process_indices));
+  }
+  process_indices();
+  for (const orbit_base::Future<void>& future : futures) future.Wait();
+}
+
 class SamplingDataPostProcessor {
  public:
-  explicit SamplingDataPostProcessor() = default;
-  SamplingDataPostProcessor& operator=(const SamplingDataPostProcessor& other) = default;
-  SamplingDataPostProcessor(const SamplingDataPostProcessor& other) = default;
-
-  SamplingDataPostProcessor(SamplingDataPostProcessor&& other) = default;
-  SamplingDataPostProcessor& operator=(SamplingDataPostProcessor&& other) = default;
+  // `thread_pool` can be null, in which case everything runs on the calling thread.
+  explicit SamplingDataPostProcessor(orbit_base::ThreadPool* thread_pool, size_t thread_count)
+      : thread_pool_{thread_pool}, thread_count_{thread_count} {}
 
   PostProcessedSamplingData ProcessSamples(const CallstackData& callstack_data,
                                            const CaptureData& capture_data,
                                            const ModuleManager& module_manager);
 
  private:
+  void CountSampledAddresses(ThreadSampleData* thread_sample_data) const;
+
   void ResolveCallstacks(const CallstackData& callstack_data, const CaptureData& capture_data,
                          const ModuleManager& module_manager);
 
-  void MapAddressToFunctionAddress(uint64_t absolute_address, const CaptureData& capture_data,
-                                   const ModuleManager& module_manager);
+  void MapAddressesToFunctionAddresses(const CaptureData& capture_data,
+                                       const ModuleManager& module_manager);
+
+  void CountResolvedAddresses(ThreadSampleData* thread_sample_data) const;
+
+  void FillThreadSampleDataSampleReport(ThreadSampleData* thread_sample_data,
+                                        const CaptureData& capture_data,
+                                        const ModuleManager& module_manager) const;
+
+  // Calls `function` with each ThreadSampleData, in parallel.
+  template <typename Function>
+  void ForEachThreadSampleDataInParallel(Function&& function) {
+    std::vector<ThreadSampleData*> thread_sample_datas;
+    thread_sample_datas.reserve(thread_id_to_sample_data_.size());
+    for (auto& [unused_tid, thread_sample_data] : thread_id_to_sample_data_) {
+      thread_sample_datas.push_back(&thread_sample_data);
+    }
+    ParallelFor(thread_pool_, thread_count_, thread_sample_datas.size(),
+                [&](size_t i) { function(thread_sample_datas[i]); });
+  }
 
-  void FillThreadSampleDataSampleReports(const CaptureData& capture_data,
-                                         const ModuleManager& module_manager);
+  orbit_base::ThreadPool* thread_pool_;
+  size_t thread_count_;
 
   // Filled by ProcessSamples.
+  // The unique callstacks of the CallstackData, read by the worker threads without locking.
+  absl::flat_hash_map<uint64_t, const CallstackInfo*> id_to_callstack_;
   absl::flat_hash_map<ThreadID, ThreadSampleData> thread_id_to_sample_data_;
   absl::flat_hash_map<uint64_t, CallstackInfo> id_to_resolved_callstack_;
   absl::flat_hash_map<orbit_client_data::CallstackInfo, uint64_t, CallstackInfoHash,
@@ -113,48 +168,47 @@ class SamplingDataPostProcessor {
 
 PostProcessedSamplingData CreatePostProcessedSamplingData(const CallstackData& callstack_data,
                                                           const CaptureData& capture_data,
-                                                          const ModuleManager& module_manager) {
+                                                          const ModuleManager& module_manager,
+                                                          size_t thread_count) {
   ORBIT_SCOPED_TIMED_LOG("CreatePostProcessedSamplingData");
-  return SamplingDataPostProcessor{}.ProcessSamples(callstack_data, capture_data, module_manager);
+  if (thread_count == 0) {
+    thread_count =
+        callstack_data.GetCallstackEventsCount() < kMinCallstackEventCountForParallelProcessing
+            ? 1
+            : std::max(1U, std::thread::hardware_concurrency());
+  }
+  if (thread_count == 1) {
+    return SamplingDataPostProcessor{nullptr, 1}.ProcessSamples(callstack_data, capture_data,
+                                                                module_manager);
+  }
+
+  // A dedicated thread pool, as the caller might itself run on a thread of a shared pool.
+  // The calling thread also does work, hence one thread less.
+  std::shared_ptr<orbit_base::ThreadPool> thread_pool =
+      orbit_base::ThreadPool::Create(thread_count - 1, thread_count - 1, absl::Seconds(1));
+  orbit_base::unique_resource shutdown_thread_pool{
+      thread_pool.get(), [](orbit_base::ThreadPool* pool) { pool->ShutdownAndWait(); }};
+  return SamplingDataPostProcessor{thread_pool.get(), thread_count}.ProcessSamples(
+      callstack_data, capture_data, module_manager);
 }
 
 namespace {
 PostProcessedSamplingData SamplingDataPostProcessor::ProcessSamples(
     const CallstackData& callstack_data, const CaptureData& capture_data,
     const ModuleManager& module_manager) {
-  // Unique call stacks and per thread data
-  callstack_data.ForEachCallstackEvent([this, &callstack_data](const CallstackEvent& event) {
-    const CallstackInfo* callstack_info = callstack_data.GetCallstack(event.callstack_id());
-    ORBIT_CHECK(callstack_info != nullptr);
-
-    std::vector<uint64_t> sorted_frames;
-    ORBIT_CHECK(!callstack_info->frames().empty());
-    if (callstack_info->type() == CallstackType::kComplete) {
-      for (uint64_t frame : callstack_info->frames()) {
-        sorted_frames.push_back(frame);
-      }
-    } else {
-      // For non-kComplete callstacks, only use the innermost frame for statistics, as it's the only
-      // one known to be correct. Note that, in the vast majority of cases, the innermost frame is
-      // also the only one available.
-      sorted_frames.push_back(callstack_info->frames()[0]);
-    }
+  callstack_data.ForEachUniqueCallstack(
+      [this](uint64_t callstack_id, const CallstackInfo& callstack) {
+        id_to_callstack_.emplace(callstack_id, &callstack);
+      });
 
-    // We need to consider duplicated frames (because of recursion) only once. We should use a set
-    // for better time complexity but sorting and comparing adjacent elements is faster in practice
-    // for a number of elements in the order of the number of frames in a callstack.
-    std::sort(sorted_frames.begin(), sorted_frames.end());
+  // Per thread data
+  callstack_data.ForEachCallstackEvent([this](const CallstackEvent& event) {
+    ORBIT_CHECK(id_to_callstack_.contains(event.callstack_id()));
 
     ThreadSampleData* thread_sample_data = &thread_id_to_sample_data_[event.thread_id()];
     thread_sample_data->thread_id = event.thread_id();
     thread_sample_data->samples_count++;
     thread_sample_data->sampled_callstack_id_to_events[event.callstack_id()].emplace_back(event);
-    for (size_t i = 0; i < sorted_frames.size(); ++i) {
-      if (i != 0 && sorted_frames[i] == sorted_frames[i - 1]) {
-        continue;
-      }
-      thread_sample_data->sampled_address_to_count[sorted_frames[i]]++;
-    }
 
     ThreadSampleData* all_thread_sample_data =
         &thread_id_to_sample_data_[orbit_base::kAllProcessThreadsTid];
@@ -162,85 +216,116 @@ PostProcessedSamplingData SamplingDataPostProcessor::ProcessSamples(
     all_thread_sample_data->samples_count++;
     all_thread_sample_data->sampled_callstack_id_to_events[event.callstack_id()].emplace_back(
         event);
-    for (size_t i = 0; i < sorted_frames.size(); ++i) {
-      if (i != 0 && sorted_frames[i] == sorted_frames[i - 1]) {
-        continue;
-      }
-      all_thread_sample_data->sampled_address_to_count[sorted_frames[i]]++;
-    }
   });
   // Only include the summary if there is more than 1 thread in the data.
   if (thread_id_to_sample_data_.size() == 2) {
     thread_id_to_sample_data_.erase(orbit_base::kAllProcessThreadsTid);
   }
 
+  ForEachThreadSampleDataInParallel(
+      [this](ThreadSampleData* thread_sample_data) { CountSampledAddresses(thread_sample_data); });
+
   ResolveCallstacks(callstack_data, capture_data, module_manager);
 
-  for (auto& sample_data_it : thread_id_to_sample_data_) {
-    ThreadSampleData* thread_sample_data = &sample_data_it.second;
+  ForEachThreadSampleDataInParallel(
+      [this](ThreadSampleData* thread_sample_data) { CountResolvedAddresses(thread_sample_data); });
 
-    // Address count per sample per thread
-    for (const auto& [sampled_callstack_id, callstack_events] :
-         thread_sample_data->sampled_callstack_id_to_events) {
-      uint64_t callstack_count = callstack_events.size();
-      uint64_t resolved_callstack_id = original_id_to_resolved_callstack_id_[sampled_callstack_id];
-      const CallstackInfo& resolved_callstack = id_to_resolved_callstack_.at(resolved_callstack_id);
+  ForEachThreadSampleDataInParallel(
+      [this, &capture_data, &module_manager](ThreadSampleData* thread_sample_data) {
+        FillThreadSampleDataSampleReport(thread_sample_data, capture_data, module_manager);
+      });
 
-      // "Exclusive" stat.
-      ORBIT_CHECK(!resolved_callstack.frames().empty());
-      thread_sample_data->resolved_address_to_exclusive_count[resolved_callstack.frames()[0]] +=
-          callstack_count;
+  return {std::move(thread_id_to_sample_data_), std::move(id_to_resolved_callstack_),
+          std::move(original_id_to_resolved_callstack_id_),
+          std::move(function_address_to_sampled_callstack_ids_)};
+}
 
-      absl::flat_hash_set<uint64_t> unique_resolved_addresses;
-      if (resolved_callstack.type() == CallstackType::kComplete) {
-        for (uint64_t resolved_address : resolved_callstack.frames()) {
-          unique_resolved_addresses.insert(resolved_address);
-        }
-      } else {
-        // For non-kComplete callstacks, only use the innermost frame for statistics.
-        unique_resolved_addresses.insert(resolved_callstack.frames()[0]);
-      }
+void SamplingDataPostProcessor::CountSampledAddresses(ThreadSampleData* thread_sample_data) const {
+  for (const auto& [sampled_callstack_id, callstack_events] :
+       thread_sample_data->sampled_callstack_id_to_events) {
+    const CallstackInfo& callstack_info = *id_to_callstack_.at(sampled_callstack_id);
 
-      // "Inclusive" stat.
-      for (uint64_t resolved_address : unique_resolved_addresses) {
-        thread_sample_data->resolved_address_to_count[resolved_address] += callstack_count;
+    std::vector<uint64_t> sorted_frames;
+    ORBIT_CHECK(!callstack_info.frames().empty());
+    if (callstack_info.type() == CallstackType::kComplete) {
+      sorted_frames = callstack_info.frames();
+    } else {
+      // For non-kComplete callstacks, only use the innermost frame for statistics, as it's the only
+      // one known to be correct. Note that, in the vast majority of cases, the innermost frame is
+      // also the only one available.
+      sorted_frames.push_back(callstack_info.frames()[0]);
+    }
+
+    // We need to consider duplicated frames (because of recursion) only once. We should use a set
+    // for better time complexity but sorting and comparing adjacent elements is faster in practice
+    // for a number of elements in the order of the number of frames in a callstack.
+    std::sort(sorted_frames.begin(), sorted_frames.end());
+
+    for (size_t i = 0; i < sorted_frames.size(); ++i) {
+      if (i != 0 && sorted_frames[i] == sorted_frames[i - 1]) {
+        continue;
       }
+      thread_sample_data->sampled_address_to_count[sorted_frames[i]] += callstack_events.size();
+    }
+  }
+}
 
-      // "Unwind errors" stat.
-      if (resolved_callstack.type() != CallstackType::kComplete) {
-        thread_sample_data->resolved_address_to_error_count[resolved_callstack.frames()[0]] +=
-            callstack_count;
+void SamplingDataPostProcessor::CountResolvedAddresses(ThreadSampleData* thread_sample_data) const {
+  // Address count per sample per thread
+  for (const auto& [sampled_callstack_id, callstack_events] :
+       thread_sample_data->sampled_callstack_id_to_events) {
+    uint64_t callstack_count = callstack_events.size();
+    uint64_t resolved_callstack_id = original_id_to_resolved_callstack_id_.at(sampled_callstack_id);
+    const CallstackInfo& resolved_callstack = id_to_resolved_callstack_.at(resolved_callstack_id);
+
+    // "Exclusive" stat.
+    ORBIT_CHECK(!resolved_callstack.frames().empty());
+    thread_sample_data->resolved_address_to_exclusive_count[resolved_callstack.frames()[0]] +=
+        callstack_count;
+
+    absl::flat_hash_set<uint64_t> unique_resolved_addresses;
+    if (resolved_callstack.type() == CallstackType::kComplete) {
+      for (uint64_t resolved_address : resolved_callstack.frames()) {
+        unique_resolved_addresses.insert(resolved_address);
       }
+    } else {
+      // For non-kComplete callstacks, only use the innermost frame for statistics.
+      unique_resolved_addresses.insert(resolved_callstack.frames()[0]);
     }
 
-    // For each thread, sort resolved (function) addresses by inclusive count.
-    for (const auto& address_count_it : thread_sample_data->resolved_address_to_count) {
-      const uint64_t address = address_count_it.first;
-      const uint32_t count = address_count_it.second;
-      thread_sample_data->sorted_count_to_resolved_address.insert(std::make_pair(count, address));
+    // "Inclusive" stat.
+    for (uint64_t resolved_address : unique_resolved_addresses) {
+      thread_sample_data->resolved_address_to_count[resolved_address] += callstack_count;
     }
-  }
 
-  FillThreadSampleDataSampleReports(capture_data, module_manager);
+    // "Unwind errors" stat.
+    if (resolved_callstack.type() != CallstackType::kComplete) {
+      thread_sample_data->resolved_address_to_error_count[resolved_callstack.frames()[0]] +=
+          callstack_count;
+    }
+  }
 
-  return {std::move(thread_id_to_sample_data_), std::move(id_to_resolved_callstack_),
-          std::move(original_id_to_resolved_callstack_id_),
-          std::move(function_address_to_sampled_callstack_ids_)};
+  // For each thread, sort resolved (function) addresses by inclusive count.
+  for (const auto& address_count_it : thread_sample_data->resolved_address_to_count) {
+    const uint64_t address = address_count_it.first;
+    const uint32_t count = address_count_it.second;
+    thread_sample_data->sorted_count_to_resolved_address.insert(std::make_pair(count, address));
+  }
 }
 
 void SamplingDataPostProcessor::ResolveCallstacks(const CallstackData& callstack_data,
                                                   const CaptureData& capture_data,
                                                   const ModuleManager& module_manager) {
-  callstack_data.ForEachUniqueCallstack([this, &capture_data, &module_manager](
-                                            uint64_t callstack_id, const CallstackInfo& callstack) {
+  MapAddressesToFunctionAddresses(capture_data, module_manager);
+
+  // Iterate in the order of the CallstackData, which determines the ids of the resolved callstacks.
+  callstack_data.ForEachUniqueCallstack([this](uint64_t callstack_id,
+                                               const CallstackInfo& callstack) {
     // A "resolved callstack" is a callstack where every address is replaced by the start address of
     // the function (if known).
     std::vector<uint64_t> resolved_callstack_frames;
 
     for (uint64_t address : callstack.frames()) {
-      if (!exact_address_to_function_address_.contains(address)) {
-        MapAddressToFunctionAddress(address, capture_data, module_manager);
-      }
       auto function_address_it = exact_address_to_function_address_.find(address);
       ORBIT_CHECK(function_address_it != exact_address_to_function_address_.end());
       resolved_callstack_frames.push_back(function_address_it->second);
@@ -282,63 +367,76 @@ void SamplingDataPostProcessor::ResolveCallstacks(const CallstackData& callstack
   });
 }
 
-void SamplingDataPostProcessor::MapAddressToFunctionAddress(uint64_t absolute_address,
-                                                            const CaptureData& capture_data,
-                                                            const ModuleManager& module_manager) {
+void SamplingDataPostProcessor::MapAddressesToFunctionAddresses(
+    const CaptureData& capture_data, const ModuleManager& module_manager) {
+  absl::flat_hash_set<uint64_t> unique_addresses;
+  for (const auto& [unused_callstack_id, callstack] : id_to_callstack_) {
+    unique_addresses.insert(callstack->frames().begin(), callstack->frames().end());
+  }
+  const std::vector<uint64_t> addresses(unique_addresses.begin(), unique_addresses.end());
+  std::vector<uint64_t> function_addresses(addresses.size());
+
+  const size_t chunk_count = (addresses.size() + kAddressChunkSize - 1) / kAddressChunkSize;
+  ParallelFor(thread_pool_, thread_count_, chunk_count, [&](size_t chunk_index) {
+    const size_t end = std::min(addresses.size(), (chunk_index + 1) * kAddressChunkSize);
+    for (size_t i = chunk_index * kAddressChunkSize; i < end; ++i) {
+      std::optional<uint64_t> absolute_function_address_option =
+          orbit_client_data::FindFunctionAbsoluteAddressByInstructionAbsoluteAddress(
+              module_manager, capture_data, addresses[i]);
+      function_addresses[i] = absolute_function_address_option.value_or(addresses[i]);
+    }
+  });
+
   // SamplingDataPostProcessor relies heavily on the association between address and function
   // address held by exact_address_to_function_address_, otherwise each address is considered a
   // different function. We are storing this mapping for faster lookup.
-  std::optional<uint64_t> absolute_function_address_option =
-      orbit_client_data::FindFunctionAbsoluteAddressByInstructionAbsoluteAddress(
-          module_manager, capture_data, absolute_address);
-  uint64_t absolute_function_address = absolute_function_address_option.value_or(absolute_address);
-
-  exact_address_to_function_address_[absolute_address] = absolute_function_address;
+  exact_address_to_function_address_.reserve(addresses.size());
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    exact_address_to_function_address_.emplace(addresses[i], function_addresses[i]);
+  }
 }
 
-void SamplingDataPostProcessor::FillThreadSampleDataSampleReports(
-    const CaptureData& capture_data, const ModuleManager& module_manager) {
-  for (auto& data : thread_id_to_sample_data_) {
-    ThreadSampleData* thread_sample_data = &data.second;
-    std::vector<SampledFunction>* sampled_functions = &thread_sample_data->sampled_functions;
-
-    for (auto sorted_it = thread_sample_data->sorted_count_to_resolved_address.rbegin();
-         sorted_it != thread_sample_data->sorted_count_to_resolved_address.rend(); ++sorted_it) {
-      uint32_t num_occurrences = sorted_it->first;
-      uint64_t absolute_address = sorted_it->second;
+void SamplingDataPostProcessor::FillThreadSampleDataSampleReport(
+    ThreadSampleData* thread_sample_data, const CaptureData& capture_data,
+    const ModuleManager& module_manager) const {
+  std::vector<SampledFunction>* sampled_functions = &thread_sample_data->sampled_functions;
 
-      SampledFunction function;
-      function.name = orbit_client_data::GetFunctionNameByAddress(module_manager, capture_data,
-                                                                  absolute_address);
+  for (auto sorted_it = thread_sample_data->sorted_count_to_resolved_address.rbegin();
+       sorted_it != thread_sample_data->sorted_count_to_resolved_address.rend(); ++sorted_it) {
+    uint32_t num_occurrences = sorted_it->first;
+    uint64_t absolute_address = sorted_it->second;
 
-      function.inclusive = num_occurrences;
-      function.inclusive_percent = 100.f * num_occurrences / thread_sample_data->samples_count;
+    SampledFunction function;
+    function.name = orbit_client_data::GetFunctionNameByAddress(module_manager, capture_data,
+                                                                absolute_address);
 
-      function.exclusive = 0;
-      function.exclusive_percent = 0.f;
+    function.inclusive = num_occurrences;
+    function.inclusive_percent = 100.f * num_occurrences / thread_sample_data->samples_count;
 
-      if (auto it = thread_sample_data->resolved_address_to_exclusive_count.find(absolute_address);
-          it != thread_sample_data->resolved_address_to_exclusive_count.end()) {
-        function.exclusive = it->second;
-        function.exclusive_percent = 100.f * it->second / thread_sample_data->samples_count;
-      }
+    function.exclusive = 0;
+    function.exclusive_percent = 0.f;
 
-      function.unwind_errors = 0;
-      function.unwind_errors_percent = 0.f;
-      if (auto it = thread_sample_data->resolved_address_to_error_count.find(absolute_address);
-          it != thread_sample_data->resolved_address_to_error_count.end()) {
-        function.unwind_errors = it->second;
-        // We only write the innermost frame into "resolved_address_to_error_count", so we get the
-        // sum of all samples with unwinding errors by computing the sum of errors per function.
-        thread_sample_data->unwinding_errors_count += function.unwind_errors;
-        function.unwind_errors_percent = 100.f * it->second / thread_sample_data->samples_count;
-      }
-      function.absolute_address = absolute_address;
-      function.module_path =
-          orbit_client_data::GetModulePathByAddress(module_manager, capture_data, absolute_address);
+    if (auto it = thread_sample_data->resolved_address_to_exclusive_count.find(absolute_address);
+        it != thread_sample_data->resolved_address_to_exclusive_count.end()) {
+      function.exclusive = it->second;
+      function.exclusive_percent = 100.f * it->second / thread_sample_data->samples_count;
+    }
 
-      sampled_functions->push_back(function);
+    function.unwind_errors = 0;
+    function.unwind_errors_percent = 0.f;
+    if (auto it = thread_sample_data->resolved_address_to_error_count.find(absolute_address);
+        it != thread_sample_data->resolved_address_to_error_count.end()) {
+      function.unwind_errors = it->second;
+      // We only write the innermost frame into "resolved_address_to_error_count", so we get the
+      // sum of all samples with unwinding errors by computing the sum of errors per function.
+      thread_sample_data->unwinding_errors_count += function.unwind_errors;
+      function.unwind_errors_percent = 100.f * it->second / thread_sample_data->samples_count;
     }
+    function.absolute_address = absolute_address;
+    function.module_path =
+        orbit_client_data::GetModulePathByAddress(module_manager, capture_data, absolute_address);
+
+    sampled_functions->push_back(function);
   }
 }
 
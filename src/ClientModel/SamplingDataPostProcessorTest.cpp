@@ -370,10 +370,10 @@ class SamplingDataPostProcessorTest : public ::testing::Test {
     AddCallstackEvent(kCallstack4Id, kThreadId2);
   }
 
-  void SetPostProcessedSamplingData() {
+  void SetPostProcessedSamplingData(size_t thread_count = 0) {
     orbit_client_data::ModuleManager module_manager{&module_identifier_provider_};
     ppsd_ = CreatePostProcessedSamplingData(capture_data_.GetCallstackData(), capture_data_,
-                                            module_manager);
+                                            module_manager, thread_count);
   }
 
   PostProcessedSamplingData ppsd_;
@@ -1690,4 +1690,39 @@ TEST_F(SamplingDataPostProcessorTest, TwoThreadsWithMixedCallstackTypes) {
   VerifyEmptySortedCallstackReport(kThreadIdNotSampled);
 }
 
+TEST_F(SamplingDataPostProcessorTest, TwoThreadsWithMixedCallstackTypesInParallel) {
+  AddAllCallstackInfosWithMixedCallstackTypes();
+  AddAllAddressInfos();
+
+  AddCallstackEventsInThreadId1And2();
+
+  SetPostProcessedSamplingData(/*thread_count=*/4);
+
+  VerifyAllCallstackInfosWithMixedCallstackTypes();
+
+  EXPECT_EQ(ppsd_.GetSortedThreadSampleData().size(), 3);
+  ASSERT_NE(ppsd_.GetSummary(), nullptr);
+
+  ASSERT_NE(ppsd_.GetThreadSampleDataByThreadId(kThreadId1), nullptr);
+  ASSERT_NE(ppsd_.GetThreadSampleDataByThreadId(kThreadId2), nullptr);
+  EXPECT_THAT(ppsd_.GetSortedThreadSampleData(),
+              ElementsAre(ppsd_.GetSummary(), ppsd_.GetThreadSampleDataByThreadId(kThreadId2),
+                          ppsd_.GetThreadSampleDataByThreadId(kThreadId1)));
+
+  VerifyThreadSampleDataForCallstackEventsInThreadId1And2WithMixedCallstackTypes(
+      *ppsd_.GetSummary(), orbit_base::kAllProcessThreadsTid);
+  VerifyThreadSampleDataForCallstackEventsInThreadId1WithMixedCallstackTypes(
+      *ppsd_.GetThreadSampleDataByThreadId(kThreadId1));
+  VerifyThreadSampleDataForCallstackEventsInThreadId2WithMixedCallstackTypes(
+      *ppsd_.GetThreadSampleDataByThreadId(kThreadId2));
+
+  VerifyGetCountOfFunctionWithMixedCallstackTypes();
+
+  VerifySortedCallstackReportForCallstackEventsAllInTheSameThreadWithMixedCallstackTypes(
+      orbit_base::kAllProcessThreadsTid);
+  VerifySortedCallstackReportForCallstackEventsInThreadId1WithMixedCallstackTypes();
+  VerifySortedCallstackReportForCallstackEventsInThreadId2WithMixedCallstackTypes();
+  VerifyEmptySortedCallstackReport(kThreadIdNotSampled);
+}
+
 }  // namespace orbit_client_model
@@ -0,0 +1,124 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_MODEL_CAPTURE_QUERY_H_
+#define CLIENT_MODEL_CAPTURE_QUERY_H_
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/types/span.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <vector>
+
+#include "ClientData/CallstackData.h"
+#include "ClientData/CaptureData.h"
+#include "OrbitBase/ThreadPool.h"
+
+// A small query layer to answer ad-hoc questions about a capture, like "the time spent in function
+// X per frame while thread Y was blocked", without writing a dedicated view:
+//
+//   EventTable timers = Filter(CreateTimerTable(capture_data), {.keys = {*function_x_scope_id}});
+//   EventTable blocked = Filter(CreateThreadStateSliceTable(capture_data),
+//                               {.thread_ids = {thread_y}, .keys = {kUninterruptibleSleep}});
+//   EventTable frames = Filter(CreateTimerTable(capture_data), {.keys = {*frame_scope_id}});
+//   std::vector<EventGroup> time_per_frame =
+//       GroupBy(IntersectTime(timers, blocked), GroupByColumn::kFrame, frames.start_ns());
+//
+// The events are copied once into columns, and each operation scans the columns it needs, in
+// chunks spread over the threads of `thread_pool`, if one is given. Only ClientData types are used,
+// so that both the UI and the command line tools can run queries.
+namespace orbit_client_model {
+
+// Columnar table of events. Each row is a time range [start_ns, end_ns) of a thread, with a key
+// whose meaning depends on where the rows come from: the scope id for timers, the processor for
+// scheduling slices, the ThreadState for thread state slices, the callstack id for callstack
+// samples. Callstack samples have the same start and end.
+class EventTable {
+ public:
+  void Reserve(size_t size);
+  void Append(uint64_t start_ns, uint64_t end_ns, uint32_t thread_id, uint64_t key);
+  void AppendRows(const EventTable& other);
+  // Sorts the rows by start, then by end, thread id and key.
+  void Sort();
+
+  [[nodiscard]] size_t size() const { return start_ns_.size(); }
+  [[nodiscard]] bool empty() const { return start_ns_.empty(); }
+  [[nodiscard]] absl::Span<const uint64_t> start_ns() const { return start_ns_; }
+  [[nodiscard]] absl::Span<const uint64_t> end_ns() const { return end_ns_; }
+  [[nodiscard]] absl::Span<const uint32_t> thread_ids() const { return thread_ids_; }
+  [[nodiscard]] absl::Span<const uint64_t> keys() const { return keys_; }
+
+ private:
+  std::vector<uint64_t> start_ns_;
+  std::vector<uint64_t> end_ns_;
+  std::vector<uint32_t> thread_ids_;
+  std::vector<uint64_t> keys_;
+};
+
+// The tables are sorted (see EventTable::Sort). The timers are those of the dynamically
+// instrumented functions and of the synchronous and asynchronous manual scopes.
+[[nodiscard]] EventTable CreateTimerTable(const orbit_client_data::CaptureData& capture_data);
+[[nodiscard]] EventTable CreateSchedulingSliceTable(
+    const orbit_client_data::CaptureData& capture_data);
+[[nodiscard]] EventTable CreateThreadStateSliceTable(
+    const orbit_client_data::CaptureData& capture_data);
+[[nodiscard]] EventTable CreateCallstackSampleTable(
+    const orbit_client_data::CallstackData& callstack_data);
+
+struct EventFilter {
+  // The rows that intersect [min_ns, max_ns] are kept.
+  uint64_t min_ns = 0;
+  uint64_t max_ns = std::numeric_limits<uint64_t>::max();
+  // If not empty, only the rows of these threads are kept.
+  absl::flat_hash_set<uint32_t> thread_ids;
+  // If not empty, only the rows with these keys are kept.
+  absl::flat_hash_set<uint64_t> keys;
+};
+
+// Returns the rows of `table` that match `filter`, in the same order.
+[[nodiscard]] EventTable Filter(const EventTable& table, const EventFilter& filter,
+                                orbit_base::ThreadPool* thread_pool = nullptr);
+
+enum class JoinThreads {
+  // A row of `events` is joined with the rows of `intervals` of any thread.
+  kAnyThread,
+  // A row of `events` is only joined with the rows of `intervals` of the same thread.
+  kSameThread,
+};
+
+// Time join: returns the parts of the rows of `events` during which at least one row of
+// `intervals` is ongoing, with the thread id and key of the row of `events`. Overlapping rows of
+// `intervals` are merged first, so the parts don't overlap. A row of `events` without duration,
+// like a callstack sample, is kept if it falls inside a row of `intervals`.
+[[nodiscard]] EventTable IntersectTime(const EventTable& events, const EventTable& intervals,
+                                       JoinThreads join_threads = JoinThreads::kAnyThread,
+                                       orbit_base::ThreadPool* thread_pool = nullptr);
+
+enum class GroupByColumn {
+  kThreadId,
+  kKey,
+  // The group is the index of the frame a row starts in, given the sorted start timestamps of the
+  // frames. The rows that start before the first frame are dropped; the last frame never ends.
+  kFrame,
+};
+
+struct EventGroup {
+  uint64_t group = 0;
+  uint64_t count = 0;
+  uint64_t total_duration_ns = 0;
+  uint64_t min_duration_ns = std::numeric_limits<uint64_t>::max();
+  uint64_t max_duration_ns = 0;
+};
+
+// Aggregates the rows of `table` by `column`. The groups are sorted by `group`.
+[[nodiscard]] std::vector<EventGroup> GroupBy(
+    const EventTable& table, GroupByColumn column,
+    absl::Span<const uint64_t> sorted_frame_starts_ns = {},
+    orbit_base::ThreadPool* thread_pool = nullptr);
+
+}  // namespace orbit_client_model
+
+#endif  // CLIENT_MODEL_CAPTURE_QUERY_H_
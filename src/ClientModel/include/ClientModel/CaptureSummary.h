@@ -0,0 +1,26 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_MODEL_CAPTURE_SUMMARY_H_
+#define CLIENT_MODEL_CAPTURE_SUMMARY_H_
+
+#include <vector>
+
+#include "ClientData/CaptureData.h"
+#include "ClientData/PostProcessedSamplingData.h"
+#include "ClientProtos/capture_summary.pb.h"
+
+namespace orbit_client_model {
+
+// Creates the entries of the CAPTURE_SUMMARY section (see orbit_capture_file::WriteCaptureSummary)
+// from a complete capture: the stats of all scopes, the threads, and the sampling counts of
+// `post_processed_sampling_data`. Entries are sorted by kind, then by scope id, thread id, function
+// address or callstack id.
+[[nodiscard]] std::vector<orbit_client_protos::CaptureSummaryEntry> CreateCaptureSummary(
+    const orbit_client_data::CaptureData& capture_data,
+    const orbit_client_data::PostProcessedSamplingData& post_processed_sampling_data);
+
+}  // namespace orbit_client_model
+
+#endif  // CLIENT_MODEL_CAPTURE_SUMMARY_H_
@@ -0,0 +1,64 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_MODEL_CAPTURE_SUMMARY_DIFF_H_
+#define CLIENT_MODEL_CAPTURE_SUMMARY_DIFF_H_
+
+#include <stdint.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "ClientProtos/capture_summary.pb.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_client_model {
+
+// Sampling counts of a function over all threads of the baseline and of the comparison capture. A
+// function only sampled in one of the captures has counts of 0 in the other.
+struct SampledFunctionDiff {
+  std::string module_path;
+  std::string function_name;
+  uint32_t baseline_exclusive_count = 0;
+  uint32_t baseline_inclusive_count = 0;
+  uint32_t comparison_exclusive_count = 0;
+  uint32_t comparison_inclusive_count = 0;
+};
+
+// Timer count and total time of a scope in the baseline and in the comparison capture.
+struct ScopeDiff {
+  std::string name;
+  uint64_t baseline_count = 0;
+  uint64_t baseline_total_time_ns = 0;
+  uint64_t comparison_count = 0;
+  uint64_t comparison_total_time_ns = 0;
+};
+
+struct CaptureSummaryDiff {
+  uint32_t baseline_samples_count = 0;
+  uint32_t comparison_samples_count = 0;
+  // Sorted by module path, then function name.
+  std::vector<SampledFunctionDiff> sampled_functions;
+  // Sorted by name.
+  std::vector<ScopeDiff> scopes;
+};
+
+// Matches the sampled functions of two capture summaries (see CreateCaptureSummary) by module path
+// and function name, and their scopes by name, as addresses and scope ids differ between captures.
+// Functions that couldn't be symbolized, and entries of summaries written before names were added,
+// are not matched and therefore omitted.
+[[nodiscard]] CaptureSummaryDiff DiffCaptureSummaries(
+    const std::vector<orbit_client_protos::CaptureSummaryEntry>& baseline,
+    const std::vector<orbit_client_protos::CaptureSummaryEntry>& comparison);
+
+// Reads the CAPTURE_SUMMARY sections of two capture files and diffs them, without reading the
+// Capture Sections. Returns an error if either file has no such section.
+[[nodiscard]] ErrorMessageOr<CaptureSummaryDiff> DiffCaptureFiles(
+    const std::filesystem::path& baseline_file_path,
+    const std::filesystem::path& comparison_file_path);
+
+}  // namespace orbit_client_model
+
+#endif  // CLIENT_MODEL_CAPTURE_SUMMARY_DIFF_H_
@@ -0,0 +1,92 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_MODEL_LIVE_SAMPLING_DATA_POST_PROCESSOR_H_
+#define CLIENT_MODEL_LIVE_SAMPLING_DATA_POST_PROCESSOR_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/CaptureData.h"
+#include "ClientData/ModuleManager.h"
+#include "ClientData/PostProcessedSamplingData.h"
+#include "OrbitBase/ThreadConstants.h"
+
+namespace orbit_client_model {
+
+// Keeps the sampling statistics up to date while the CallstackEvents of a capture arrive, so that a
+// report of the most sampled functions can be shown before the capture ends. Each unique callstack
+// is resolved to function addresses once, when its first CallstackEvent arrives, and every
+// CallstackEvent then only increments the per-function counters of its thread.
+//
+// CreateSnapshot builds a PostProcessedSamplingData with only the `top_function_count` most sampled
+// functions of each thread, so that its cost doesn't grow with the length of the capture. Snapshots
+// have no callstacks, and addresses are resolved with the symbols loaded when the callstack first
+// arrived, so the full post-processing at the end of the capture should replace the last snapshot.
+//
+// ProcessCallstackEvent and CreateSnapshot can be called from different threads.
+class LiveSamplingDataPostProcessor {
+ public:
+  LiveSamplingDataPostProcessor(const orbit_client_data::CaptureData* capture_data,
+                                const orbit_client_data::ModuleManager* module_manager,
+                                absl::Duration min_snapshot_interval, size_t top_function_count);
+
+  // Returns true if a snapshot is due, that is, if the last one is at least `min_snapshot_interval`
+  // old. Only returns true once until the next call to CreateSnapshot, so that the caller can
+  // schedule the snapshot without flooding its executor.
+  [[nodiscard]] bool ProcessCallstackEvent(const orbit_client_data::CallstackEvent& event,
+                                           absl::Time now);
+
+  [[nodiscard]] orbit_client_data::PostProcessedSamplingData CreateSnapshot(absl::Time now);
+
+ private:
+  struct ResolvedCallstack {
+    // The function addresses of the frames without duplicates, or only the innermost one if the
+    // callstack is not kComplete.
+    std::vector<uint64_t> unique_function_addresses;
+    uint64_t innermost_function_address;
+    bool is_complete;
+  };
+
+  struct ThreadCounters {
+    uint32_t samples_count = 0;
+    uint32_t unwinding_errors_count = 0;
+    absl::flat_hash_map<uint64_t, uint32_t> function_address_to_inclusive_count;
+    absl::flat_hash_map<uint64_t, uint32_t> function_address_to_exclusive_count;
+    absl::flat_hash_map<uint64_t, uint32_t> function_address_to_error_count;
+  };
+
+  [[nodiscard]] const ResolvedCallstack& GetOrResolveCallstack(uint64_t callstack_id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] orbit_client_data::ThreadSampleData CreateThreadSampleData(
+      orbit_client_data::ThreadID thread_id, const ThreadCounters& counters) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const orbit_client_data::CaptureData* capture_data_;
+  const orbit_client_data::ModuleManager* module_manager_;
+  const absl::Duration min_snapshot_interval_;
+  const size_t top_function_count_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<uint64_t, ResolvedCallstack> id_to_resolved_callstack_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<uint64_t, uint64_t> exact_address_to_function_address_
+      ABSL_GUARDED_BY(mutex_);
+  // Also contains the counters of all threads, under orbit_base::kAllProcessThreadsTid.
+  absl::flat_hash_map<orbit_client_data::ThreadID, ThreadCounters> thread_id_to_counters_
+      ABSL_GUARDED_BY(mutex_);
+  absl::Time last_snapshot_time_ ABSL_GUARDED_BY(mutex_) = absl::InfinitePast();
+  bool is_snapshot_requested_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace orbit_client_model
+
+#endif  // CLIENT_MODEL_LIVE_SAMPLING_DATA_POST_PROCESSOR_H_
@@ -5,16 +5,21 @@
 #ifndef CLIENT_MODEL_SAMPLING_DATA_POST_PROCESSOR_H_
 #define CLIENT_MODEL_SAMPLING_DATA_POST_PROCESSOR_H_
 
+#include <stddef.h>
+
 #include "ClientData/CallstackData.h"
 #include "ClientData/CaptureData.h"
 #include "ClientData/ModuleManager.h"
 #include "ClientData/PostProcessedSamplingData.h"
 
 namespace orbit_client_model {
+// The work is spread over `thread_count` threads, partitioned by thread id and by chunks of
+// addresses to resolve. With the default of 0, small inputs are processed on the calling thread
+// only, and larger ones on as many threads as there are cores.
 orbit_client_data::PostProcessedSamplingData CreatePostProcessedSamplingData(
     const orbit_client_data::CallstackData& callstack_data,
     const orbit_client_data::CaptureData& capture_data,
-    const orbit_client_data::ModuleManager& module_manager);
+    const orbit_client_data::ModuleManager& module_manager, size_t thread_count = 0);
 }  // namespace orbit_client_model
 
 #endif  // CLIENT_MODEL_SAMPLING_DATA_POST_PROCESSOR_H_
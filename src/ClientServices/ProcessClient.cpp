@@ -9,6 +9,7 @@
 #include <grpcpp/grpcpp.h>
 
 #include <chrono>
+#include <iterator>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -26,12 +27,20 @@ using orbit_grpc_protos::GetModuleListRequest;
 using orbit_grpc_protos::GetModuleListResponse;
 using orbit_grpc_protos::GetProcessListRequest;
 using orbit_grpc_protos::GetProcessListResponse;
+using orbit_grpc_protos::GetProcessMemoryRangesRequest;
+using orbit_grpc_protos::GetProcessMemoryRangesResponse;
 using orbit_grpc_protos::GetProcessMemoryRequest;
 using orbit_grpc_protos::GetProcessMemoryResponse;
 using orbit_grpc_protos::ModuleInfo;
 using orbit_grpc_protos::ProcessInfo;
+using orbit_grpc_protos::ResolveAddressesRequest;
+using orbit_grpc_protos::ResolveAddressesResponse;
+using orbit_grpc_protos::ResolvedAddress;
 
 constexpr uint64_t kGrpcDefaultTimeoutMilliseconds = 3000;
+// The first request for a module loads its symbols on the instance, which takes a while for large
+// modules.
+constexpr uint64_t kResolveAddressesTimeoutMilliseconds = 60000;
 
 std::unique_ptr<grpc::ClientContext> CreateContext(
     uint64_t timeout_milliseconds = kGrpcDefaultTimeoutMilliseconds) {
@@ -83,8 +92,9 @@ ErrorMessageOr<std::vector<ModuleInfo>> ProcessClient::LoadModuleList(uint32_t p
   return std::vector<ModuleInfo>(modules.begin(), modules.end());
 }
 
-ErrorMessageOr<orbit_base::NotFoundOr<std::filesystem::path>> ProcessClient::FindDebugInfoFile(
-    std::string_view module_path, absl::Span<const std::string> additional_search_directories) {
+ErrorMessageOr<orbit_base::NotFoundOr<RemoteDebugInfoFile>> ProcessClient::FindDebugInfoFile(
+    std::string_view module_path, absl::Span<const std::string> additional_search_directories,
+    bool accept_compressed_file) {
   ORBIT_SCOPE_FUNCTION;
   GetDebugInfoFileRequest request;
   GetDebugInfoFileResponse response;
@@ -92,13 +102,18 @@ ErrorMessageOr<orbit_base::NotFoundOr<std::filesystem::path>> ProcessClient::Fin
   request.set_module_path(module_path.data(), module_path.size());
   *request.mutable_additional_search_directories() = {additional_search_directories.begin(),
                                                       additional_search_directories.end()};
+  request.set_accept_compressed_file(accept_compressed_file);
 
   const std::unique_ptr<grpc::ClientContext> context = CreateContext();
 
   const grpc::Status status = process_service_->GetDebugInfoFile(context.get(), request, &response);
 
   if (status.ok()) {
-    return std::filesystem::path{response.debug_info_file_path()};
+    RemoteDebugInfoFile remote_debug_info_file{response.debug_info_file_path(), std::nullopt};
+    if (!response.compressed_debug_info_file_path().empty()) {
+      remote_debug_info_file.compressed_path = response.compressed_debug_info_file_path();
+    }
+    return remote_debug_info_file;
   }
 
   if (status.error_code() == grpc::StatusCode::NOT_FOUND) {
@@ -121,6 +136,43 @@ ErrorMessageOr<orbit_base::NotFoundOr<std::filesystem::path>> ProcessClient::Fin
   return ErrorMessage{error_message};
 }
 
+ErrorMessageOr<orbit_base::NotFoundOr<std::vector<ResolvedAddress>>>
+ProcessClient::ResolveAddresses(std::string_view module_path, std::string_view build_id,
+                                absl::Span<const std::string> additional_search_directories,
+                                absl::Span<const uint64_t> addresses) {
+  ORBIT_SCOPE_FUNCTION;
+  ResolveAddressesRequest request;
+  ResolveAddressesResponse response;
+
+  request.set_module_path(module_path.data(), module_path.size());
+  request.set_build_id(build_id.data(), build_id.size());
+  *request.mutable_additional_search_directories() = {additional_search_directories.begin(),
+                                                      additional_search_directories.end()};
+  *request.mutable_addresses() = {addresses.begin(), addresses.end()};
+
+  const std::unique_ptr<grpc::ClientContext> context =
+      CreateContext(kResolveAddressesTimeoutMilliseconds);
+
+  const grpc::Status status = process_service_->ResolveAddresses(context.get(), request, &response);
+
+  if (status.error_code() == grpc::StatusCode::NOT_FOUND) {
+    return orbit_base::NotFound{status.error_message()};
+  }
+  if (!status.ok()) {
+    ORBIT_ERROR("gRPC call to ResolveAddresses failed: %s", status.error_message());
+    return ErrorMessage(status.error_message());
+  }
+  if (response.resolved_addresses_size() != request.addresses_size()) {
+    return ErrorMessage{absl::StrFormat("Received %d resolved addresses for %d addresses.",
+                                        response.resolved_addresses_size(),
+                                        request.addresses_size())};
+  }
+
+  return std::vector<ResolvedAddress>(
+      std::make_move_iterator(response.mutable_resolved_addresses()->begin()),
+      std::make_move_iterator(response.mutable_resolved_addresses()->end()));
+}
+
 ErrorMessageOr<std::string> ProcessClient::LoadProcessMemory(uint32_t pid, uint64_t address,
                                                              uint64_t size) {
   ORBIT_SCOPE_FUNCTION;
@@ -142,4 +194,30 @@ ErrorMessageOr<std::string> ProcessClient::LoadProcessMemory(uint32_t pid, uint6
   return std::move(*response.mutable_memory());
 }
 
+ErrorMessageOr<std::vector<std::string>> ProcessClient::LoadProcessMemoryRanges(
+    uint32_t pid, absl::Span<const orbit_grpc_protos::MemoryRange> ranges) {
+  ORBIT_SCOPE_FUNCTION;
+  GetProcessMemoryRangesRequest request;
+  request.set_pid(pid);
+  *request.mutable_ranges() = {ranges.begin(), ranges.end()};
+
+  GetProcessMemoryRangesResponse response;
+
+  std::unique_ptr<grpc::ClientContext> context = CreateContext();
+
+  grpc::Status status =
+      process_service_->GetProcessMemoryRanges(context.get(), request, &response);
+  if (!status.ok()) {
+    ORBIT_ERROR("gRPC call to GetProcessMemoryRanges failed: %s", status.error_message());
+    return ErrorMessage(status.error_message());
+  }
+  if (static_cast<size_t>(response.memory_size()) != ranges.size()) {
+    return ErrorMessage(absl::StrFormat("Received memory of %d ranges instead of %u.",
+                                        response.memory_size(), ranges.size()));
+  }
+
+  return std::vector<std::string>(std::make_move_iterator(response.mutable_memory()->begin()),
+                                  std::make_move_iterator(response.mutable_memory()->end()));
+}
+
 }  // namespace orbit_client_services
@@ -41,21 +41,36 @@ class ProcessManagerImpl final : public ProcessManager {
   ErrorMessageOr<std::string> LoadProcessMemory(uint32_t pid, uint64_t address,
                                                 uint64_t size) override;
 
-  ErrorMessageOr<orbit_base::NotFoundOr<std::filesystem::path>> FindDebugInfoFile(
+  ErrorMessageOr<std::vector<std::string>> LoadProcessMemoryRanges(
+      uint32_t pid, absl::Span<const orbit_grpc_protos::MemoryRange> ranges) override;
+
+  ErrorMessageOr<orbit_base::NotFoundOr<RemoteDebugInfoFile>> FindDebugInfoFile(
       std::string_view module_path,
       absl::Span<const std::string> additional_search_directories) override;
 
+  ErrorMessageOr<orbit_base::NotFoundOr<std::vector<orbit_grpc_protos::ResolvedAddress>>>
+  ResolveAddresses(std::string_view module_path, std::string_view build_id,
+                   absl::Span<const std::string> additional_search_directories,
+                   absl::Span<const uint64_t> addresses) override;
+
   void Start();
   void ShutdownAndWait() override;
 
  private:
   void WorkerFunction();
+  [[nodiscard]] bool IsShutdownInitiatedOrRefreshRequested() const {
+    return shutdown_initiated_ || refresh_requested_;
+  }
 
   std::unique_ptr<ProcessClient> process_client_;
 
   absl::Duration refresh_timeout_;
   absl::Mutex shutdown_mutex_;
   bool shutdown_initiated_;
+  // The list is requested right away when this is set, instead of after `refresh_timeout_`. This
+  // is the case for the first request, so that the processes are shown as soon as the connection
+  // is up, and when a new listener is set, so that it doesn't wait for the next refresh.
+  bool refresh_requested_ = true;
 
   absl::Mutex process_list_update_listener_mutex_;
   std::function<void(std::vector<orbit_grpc_protos::ProcessInfo>)> process_list_update_listener_;
@@ -71,17 +86,32 @@ ProcessManagerImpl::ProcessManagerImpl(const std::shared_ptr<grpc::Channel>& cha
 
 void ProcessManagerImpl::SetProcessListUpdateListener(
     const std::function<void(std::vector<orbit_grpc_protos::ProcessInfo>)>& listener) {
-  absl::MutexLock lock(&process_list_update_listener_mutex_);
-  process_list_update_listener_ = listener;
+  {
+    absl::MutexLock lock(&process_list_update_listener_mutex_);
+    process_list_update_listener_ = listener;
+  }
+  if (listener != nullptr) {
+    absl::MutexLock lock(&shutdown_mutex_);
+    refresh_requested_ = true;
+  }
 }
 
 ErrorMessageOr<std::vector<ModuleInfo>> ProcessManagerImpl::LoadModuleList(uint32_t pid) {
   return process_client_->LoadModuleList(pid);
 }
 
-ErrorMessageOr<orbit_base::NotFoundOr<std::filesystem::path>> ProcessManagerImpl::FindDebugInfoFile(
+ErrorMessageOr<orbit_base::NotFoundOr<RemoteDebugInfoFile>> ProcessManagerImpl::FindDebugInfoFile(
     std::string_view module_path, absl::Span<const std::string> additional_search_directories) {
-  return process_client_->FindDebugInfoFile(module_path, additional_search_directories);
+  return process_client_->FindDebugInfoFile(module_path, additional_search_directories,
+                                            /*accept_compressed_file=*/true);
+}
+
+ErrorMessageOr<orbit_base::NotFoundOr<std::vector<orbit_grpc_protos::ResolvedAddress>>>
+ProcessManagerImpl::ResolveAddresses(std::string_view module_path, std::string_view build_id,
+                                     absl::Span<const std::string> additional_search_directories,
+                                     absl::Span<const uint64_t> addresses) {
+  return process_client_->ResolveAddresses(module_path, build_id, additional_search_directories,
+                                           addresses);
 }
 
 void ProcessManagerImpl::Start() {
@@ -98,18 +128,19 @@ void ProcessManagerImpl::ShutdownAndWait() {
   }
 }
 
-bool IsTrue(bool* var) { return *var; }
-
 void ProcessManagerImpl::WorkerFunction() {
   while (true) {
-    if (shutdown_mutex_.LockWhenWithTimeout(absl::Condition(IsTrue, &shutdown_initiated_),
-                                            refresh_timeout_)) {
+    shutdown_mutex_.LockWhenWithTimeout(
+        absl::Condition(this, &ProcessManagerImpl::IsShutdownInitiatedOrRefreshRequested),
+        refresh_timeout_);
+    if (shutdown_initiated_) {
       // Shutdown was initiated we need to exit
       shutdown_mutex_.Unlock();
       return;
     }
+    refresh_requested_ = false;
     shutdown_mutex_.Unlock();
-    // Timeout expired - refresh the list
+    // Timeout expired or a refresh was requested - refresh the list
 
     ErrorMessageOr<std::vector<ProcessInfo>> result = process_client_->GetProcessList();
     if (result.has_error()) {
@@ -134,6 +165,11 @@ ErrorMessageOr<std::string> ProcessManagerImpl::LoadProcessMemory(uint32_t pid,
   return process_client_->LoadProcessMemory(pid, address, size);
 }
 
+ErrorMessageOr<std::vector<std::string>> ProcessManagerImpl::LoadProcessMemoryRanges(
+    uint32_t pid, absl::Span<const orbit_grpc_protos::MemoryRange> ranges) {
+  return process_client_->LoadProcessMemoryRanges(pid, ranges);
+}
+
 }  // namespace
 
 std::unique_ptr<ProcessManager> ProcessManager::Create(
@@ -4,10 +4,15 @@
 
 #include "ClientServices/TracepointServiceClient.h"
 
+#include <absl/base/thread_annotations.h>
 #include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
+#include <stdint.h>
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "GrpcProtos/services.pb.h"
 #include "OrbitBase/Logging.h"
@@ -22,8 +27,28 @@ using orbit_grpc_protos::TracepointService;
 TracepointServiceClient::TracepointServiceClient(const std::shared_ptr<grpc::Channel>& channel)
     : tracepoint_service_(TracepointService::NewStub(channel)) {}
 
-ErrorMessageOr<std::vector<TracepointInfo>> TracepointServiceClient::GetTracepointList() const {
+namespace {
+
+// The last tracepoint list received, shared by all clients. A new connection, also to another
+// instance of OrbitService on the same machine, then only needs to receive the list again if it
+// changed.
+struct CachedTracepointList {
+  absl::Mutex mutex;
+  uint64_t list_hash ABSL_GUARDED_BY(mutex) = 0;
+  std::vector<TracepointInfo> tracepoints ABSL_GUARDED_BY(mutex);
+};
+
+CachedTracepointList& GetCachedTracepointList() {
+  static CachedTracepointList cached_tracepoint_list;
+  return cached_tracepoint_list;
+}
+
+}  // namespace
+
+ErrorMessageOr<GetTracepointListResponse> TracepointServiceClient::CallGetTracepointList(
+    uint64_t known_list_hash) const {
   GetTracepointListRequest request;
+  request.set_known_list_hash(known_list_hash);
   GetTracepointListResponse response;
 
   std::unique_ptr<grpc::ClientContext> context = std::make_unique<grpc::ClientContext>();
@@ -37,10 +62,35 @@ ErrorMessageOr<std::vector<TracepointInfo>> TracepointServiceClient::GetTracepoi
                 status.error_code());
     return ErrorMessage(error_message);
   }
+  return response;
+}
+
+ErrorMessageOr<std::vector<TracepointInfo>> TracepointServiceClient::GetTracepointList() const {
+  CachedTracepointList& cache = GetCachedTracepointList();
+  uint64_t known_list_hash = 0;
+  {
+    absl::MutexLock lock{&cache.mutex};
+    known_list_hash = cache.list_hash;
+  }
 
-  const auto& tracepoints = response.tracepoints();
+  ErrorMessageOr<GetTracepointListResponse> response_or_error =
+      CallGetTracepointList(known_list_hash);
+  if (response_or_error.has_value() && response_or_error.value().list_is_unchanged()) {
+    absl::MutexLock lock{&cache.mutex};
+    if (response_or_error.value().list_hash() == cache.list_hash) return cache.tracepoints;
+  }
+  if (response_or_error.has_value() && response_or_error.value().list_is_unchanged()) {
+    // Another call replaced the cached list in the meantime, so ask for the whole list.
+    response_or_error = CallGetTracepointList(0);
+  }
+  OUTCOME_TRY(GetTracepointListResponse response, std::move(response_or_error));
 
-  return std::vector<TracepointInfo>{tracepoints.begin(), tracepoints.end()};
+  const auto& tracepoints = response.tracepoints();
+  std::vector<TracepointInfo> result{tracepoints.begin(), tracepoints.end()};
+  absl::MutexLock lock{&cache.mutex};
+  cache.list_hash = response.list_hash();
+  cache.tracepoints = result;
+  return result;
 }
 
 std::unique_ptr<TracepointServiceClient> TracepointServiceClient::Create(
@@ -18,9 +18,11 @@
 #include <variant>
 #include <vector>
 
+#include "ClientServices/RemoteDebugInfoFile.h"
 #include "GrpcProtos/module.pb.h"
 #include "GrpcProtos/process.pb.h"
 #include "GrpcProtos/services.grpc.pb.h"
+#include "GrpcProtos/services.pb.h"
 #include "OrbitBase/NotFoundOr.h"
 #include "OrbitBase/Result.h"
 
@@ -37,12 +39,27 @@ class ProcessClient {
   [[nodiscard]] ErrorMessageOr<std::vector<orbit_grpc_protos::ModuleInfo>> LoadModuleList(
       uint32_t pid);
 
-  [[nodiscard]] ErrorMessageOr<orbit_base::NotFoundOr<std::filesystem::path>> FindDebugInfoFile(
-      std::string_view module_path, absl::Span<const std::string> additional_search_directories);
+  // If accept_compressed_file is set, OrbitService also offers a compressed copy of the file.
+  [[nodiscard]] ErrorMessageOr<orbit_base::NotFoundOr<RemoteDebugInfoFile>> FindDebugInfoFile(
+      std::string_view module_path, absl::Span<const std::string> additional_search_directories,
+      bool accept_compressed_file);
+
+  // Resolves addresses (in the address space of the module's symbols) to functions on the
+  // instance, without copying the symbols file of the module to the client.
+  [[nodiscard]] ErrorMessageOr<
+      orbit_base::NotFoundOr<std::vector<orbit_grpc_protos::ResolvedAddress>>>
+  ResolveAddresses(std::string_view module_path, std::string_view build_id,
+                   absl::Span<const std::string> additional_search_directories,
+                   absl::Span<const uint64_t> addresses);
 
   [[nodiscard]] ErrorMessageOr<std::string> LoadProcessMemory(uint32_t pid, uint64_t address,
                                                               uint64_t size);
 
+  // Reads many ranges of memory with a single call. Returns one entry per range, in the same
+  // order, holding the bytes that could be read from the start of the range.
+  [[nodiscard]] ErrorMessageOr<std::vector<std::string>> LoadProcessMemoryRanges(
+      uint32_t pid, absl::Span<const orbit_grpc_protos::MemoryRange> ranges);
+
  private:
   std::unique_ptr<orbit_grpc_protos::ProcessService::Stub> process_service_;
 };
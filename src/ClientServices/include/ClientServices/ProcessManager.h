@@ -18,8 +18,10 @@
 #include <thread>
 #include <vector>
 
+#include "ClientServices/RemoteDebugInfoFile.h"
 #include "GrpcProtos/module.pb.h"
 #include "GrpcProtos/process.pb.h"
+#include "GrpcProtos/services.pb.h"
 #include "GrpcProtos/symbol.pb.h"
 #include "OrbitBase/NotFoundOr.h"
 #include "OrbitBase/Result.h"
@@ -58,10 +60,21 @@ class ProcessManager {
   virtual ErrorMessageOr<std::string> LoadProcessMemory(uint32_t pid, uint64_t address,
                                                         uint64_t size) = 0;
 
-  virtual ErrorMessageOr<orbit_base::NotFoundOr<std::filesystem::path>> FindDebugInfoFile(
+  // Reads many ranges of memory with a single call. See ProcessClient.
+  virtual ErrorMessageOr<std::vector<std::string>> LoadProcessMemoryRanges(
+      uint32_t pid, absl::Span<const orbit_grpc_protos::MemoryRange> ranges) = 0;
+
+  // Also asks for a compressed copy of the debug info file, as the file is copied to the client.
+  virtual ErrorMessageOr<orbit_base::NotFoundOr<RemoteDebugInfoFile>> FindDebugInfoFile(
       std::string_view module_path,
       absl::Span<const std::string> additional_search_directories) = 0;
 
+  // Resolves addresses in the module to functions on the instance. See ProcessClient.
+  virtual ErrorMessageOr<orbit_base::NotFoundOr<std::vector<orbit_grpc_protos::ResolvedAddress>>>
+  ResolveAddresses(std::string_view module_path, std::string_view build_id,
+                   absl::Span<const std::string> additional_search_directories,
+                   absl::Span<const uint64_t> addresses) = 0;
+
   // Note that this method waits for the worker thread to stop, which could
   // take up to refresh_timeout.
   virtual void ShutdownAndWait() = 0;
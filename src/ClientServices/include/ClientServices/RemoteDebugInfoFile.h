@@ -0,0 +1,23 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CLIENT_SERVICES_REMOTE_DEBUG_INFO_FILE_H_
+#define CLIENT_SERVICES_REMOTE_DEBUG_INFO_FILE_H_
+
+#include <filesystem>
+#include <optional>
+
+namespace orbit_client_services {
+
+// A debug info file that OrbitService found on the instance. compressed_path is only set if a gzip
+// compressed copy was requested and OrbitService was able to create it. Both files have the same
+// (decompressed) content, but the compressed one is a lot faster to copy.
+struct RemoteDebugInfoFile {
+  std::filesystem::path path;
+  std::optional<std::filesystem::path> compressed_path;
+};
+
+}  // namespace orbit_client_services
+
+#endif  // CLIENT_SERVICES_REMOTE_DEBUG_INFO_FILE_H_
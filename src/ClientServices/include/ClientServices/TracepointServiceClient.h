@@ -6,11 +6,13 @@
 #define CLIENT_SERVICES_TRACEPOINT_SERVICE_CLIENT_H_
 
 #include <grpcpp/channel.h>
+#include <stdint.h>
 
 #include <memory>
 #include <vector>
 
 #include "GrpcProtos/services.grpc.pb.h"
+#include "GrpcProtos/services.pb.h"
 #include "GrpcProtos/tracepoint.pb.h"
 #include "OrbitBase/Result.h"
 
@@ -27,6 +29,9 @@ class TracepointServiceClient {
  private:
   explicit TracepointServiceClient(const std::shared_ptr<grpc::Channel>& channel);
 
+  [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::GetTracepointListResponse> CallGetTracepointList(
+      uint64_t known_list_hash) const;
+
   std::unique_ptr<orbit_grpc_protos::TracepointService::Stub> tracepoint_service_;
 };
 
@@ -39,7 +39,14 @@ static std::vector<std::string_view> SplitIntoLines(std::string_view source_file
   // We will show each source code line above the first related instruction
   absl::flat_hash_map<size_t, uint64_t> source_line_to_first_instruction_offset;
 
-  for (uint64_t current_offset = 0; current_offset < function_info.size(); ++current_offset) {
+  // Line table entries start at instructions, so it's enough to look up the start address of each
+  // instruction instead of every byte of the function. The instructions are in ascending order, so
+  // the first instruction of each source line is the one that is kept.
+  for (const uint64_t instruction_address : report.GetInstructionAddresses()) {
+    if (instruction_address < report.GetAbsoluteFunctionAddress()) continue;
+    const uint64_t current_offset = instruction_address - report.GetAbsoluteFunctionAddress();
+    if (current_offset >= function_info.size()) continue;
+
     const auto line_info_or_error = elf->GetLineInfo(current_offset + function_info.address());
     if (line_info_or_error.has_error()) continue;
     if (line_info_or_error.value().source_file() != location_info.source_file()) continue;
@@ -0,0 +1,36 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "CodeReport/DisassemblyCache.h"
+
+#include <absl/hash/hash.h>
+
+#include <utility>
+
+namespace orbit_code_report {
+
+Disassembler DisassemblyCache::GetOrDisassemble(std::string_view build_id, uint64_t address,
+                                                std::string_view machine_code,
+                                                const std::function<Disassembler()>& disassemble) {
+  Key key{std::string{build_id}, address, std::string{machine_code}};
+  {
+    absl::MutexLock lock(&mutex_);
+    if (auto it = disassemblies_.find(key); it != disassemblies_.end()) return it->second;
+  }
+
+  // Disassembled without holding the lock, so that other functions can be looked up meanwhile.
+  Disassembler disassembler = disassemble();
+
+  absl::MutexLock lock(&mutex_);
+  if (disassemblies_.size() >= kMaxSize) disassemblies_.clear();
+  disassemblies_.insert_or_assign(std::move(key), disassembler);
+  return disassembler;
+}
+
+void DisassemblyCache::Clear() {
+  absl::MutexLock lock(&mutex_);
+  disassemblies_.clear();
+}
+
+}  // namespace orbit_code_report
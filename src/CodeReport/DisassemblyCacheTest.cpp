@@ -0,0 +1,71 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stddef.h>
+
+#include <string>
+
+#include "CodeReport/Disassembler.h"
+#include "CodeReport/DisassemblyCache.h"
+
+namespace orbit_code_report {
+
+namespace {
+
+Disassembler CreateDisassembler(std::string line) {
+  Disassembler disassembler;
+  disassembler.AddLine(std::move(line), 0x1000);
+  return disassembler;
+}
+
+}  // namespace
+
+TEST(DisassemblyCache, ReusesDisassemblyOfSameFunctionAndCode) {
+  DisassemblyCache cache;
+  int num_disassemble_calls = 0;
+  auto disassemble = [&num_disassemble_calls]() {
+    ++num_disassemble_calls;
+    return CreateDisassembler("first");
+  };
+
+  EXPECT_EQ(cache.GetOrDisassemble("build_id", 0x1000, "code", disassemble).GetResult(),
+            "first\n");
+  EXPECT_EQ(cache.GetOrDisassemble("build_id", 0x1000, "code", disassemble).GetResult(),
+            "first\n");
+  EXPECT_EQ(num_disassemble_calls, 1);
+
+  // A different build id, address or machine code is a different disassembly.
+  (void)cache.GetOrDisassemble("other_build_id", 0x1000, "code", disassemble);
+  (void)cache.GetOrDisassemble("build_id", 0x2000, "code", disassemble);
+  (void)cache.GetOrDisassemble("build_id", 0x1000, "patched_code", disassemble);
+  EXPECT_EQ(num_disassemble_calls, 4);
+
+  cache.Clear();
+  const Disassembler disassembler = cache.GetOrDisassemble(
+      "build_id", 0x1000, "code", [] { return CreateDisassembler("second"); });
+  EXPECT_EQ(disassembler.GetResult(), "second\n");
+  EXPECT_EQ(disassembler.GetLineAtAddress(0x1000), 0);
+}
+
+TEST(DisassemblyCache, IsLimitedToMaxSize) {
+  DisassemblyCache cache;
+  int num_disassemble_calls = 0;
+  auto disassemble = [&num_disassemble_calls]() {
+    ++num_disassemble_calls;
+    return CreateDisassembler("line");
+  };
+
+  for (size_t i = 0; i <= DisassemblyCache::kMaxSize; ++i) {
+    (void)cache.GetOrDisassemble("build_id", i, "code", disassemble);
+  }
+  EXPECT_EQ(num_disassemble_calls, DisassemblyCache::kMaxSize + 1);
+
+  // The cache was full when the last disassembly was added, so only that one is left.
+  (void)cache.GetOrDisassemble("build_id", DisassemblyCache::kMaxSize, "code", disassemble);
+  (void)cache.GetOrDisassemble("build_id", 0, "code", disassemble);
+  EXPECT_EQ(num_disassemble_calls, DisassemblyCache::kMaxSize + 2);
+}
+
+}  // namespace orbit_code_report
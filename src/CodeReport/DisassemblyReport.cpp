@@ -10,39 +10,54 @@ std::optional<uint32_t> DisassemblyReport::GetNumSamplesAtLine(size_t line) cons
   // The given line number will be 1-indexed, but `Disassembler` works with 0-indexed line numbers.
   line -= 1;
 
-  uint64_t address = disasm_.GetAddressAtLine(line);
-  if (address == 0) {
+  if (disasm_.GetAddressAtLine(line) == 0) {
     // We return an empty optional when there is no data available for the current line.
     // That allows the user to differentiate between a line without samples and a line without data.
     return std::nullopt;
   }
 
-  if (function_count_ == 0) {
-    return 0;
-  }
-
-  // On calls the address sampled might not be the address of the
-  // beginning of the instruction, but instead at the end. Thus, we
-  // iterate over all addresses that fall into this instruction.
-  uint64_t next_address = disasm_.GetAddressAtLine(line + 1);
+  if (line >= num_samples_at_lines_.size()) return 0;
+  return num_samples_at_lines_[line];
+}
 
-  // If the current instruction is the last one (next address is 0), it
-  // can not be a call, thus we can only consider this address.
-  if (next_address == 0) {
-    next_address = address + 1;
-  }
-  if (!thread_sample_data_.has_value()) {
-    return 0;
+void DisassemblyReport::ComputeNumSamplesAtLines() {
+  if (function_count_ == 0 || !thread_sample_data_.has_value()) return;
+
+  const size_t num_lines = disasm_.GetNumLines();
+  num_samples_at_lines_.resize(num_lines, 0);
+  for (size_t line = 0; line < num_lines; ++line) {
+    uint64_t address = disasm_.GetAddressAtLine(line);
+    if (address == 0) continue;
+
+    // On calls the address sampled might not be the address of the
+    // beginning of the instruction, but instead at the end. Thus, we
+    // iterate over all addresses that fall into this instruction.
+    uint64_t next_address = disasm_.GetAddressAtLine(line + 1);
+
+    // If the current instruction is the last one (next address is 0), it
+    // can not be a call, thus we can only consider this address.
+    if (next_address == 0) {
+      next_address = address + 1;
+    }
+    uint32_t count = 0;
+    while (address < next_address) {
+      count += thread_sample_data_->GetCountForAddress(address);
+      address++;
+    }
+    num_samples_at_lines_[line] = count;
   }
-  uint32_t count = 0;
-  while (address < next_address) {
-    count += thread_sample_data_->GetCountForAddress(address);
-    address++;
-  }
-  return count;
 }
 
 std::optional<size_t> DisassemblyReport::GetLineAtAddress(uint64_t address) const {
   return disasm_.GetLineAtAddress(address);
 }
-}  // namespace orbit_code_report
\ No newline at end of file
+
+std::vector<uint64_t> DisassemblyReport::GetInstructionAddresses() const {
+  std::vector<uint64_t> instruction_addresses;
+  for (size_t line = 0; line < disasm_.GetNumLines(); ++line) {
+    const uint64_t address = disasm_.GetAddressAtLine(line);
+    if (address != 0) instruction_addresses.push_back(address);
+  }
+  return instruction_addresses;
+}
+}  // namespace orbit_code_report
@@ -0,0 +1,49 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CODE_REPORT_DISASSEMBLY_CACHE_H_
+#define CODE_REPORT_DISASSEMBLY_CACHE_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include "CodeReport/Disassembler.h"
+
+namespace orbit_code_report {
+
+// Keeps the disassembly of recently disassembled functions, so that opening the disassembly of a
+// function again doesn't run capstone and look up all callees again. A disassembly is identified by
+// the build id of the module, the absolute address of the function and its machine code, so that a
+// function whose code was changed in memory, e.g. by instrumentation, is disassembled again. Callee
+// names depend on the symbols that are loaded, so the cache needs to be cleared when symbols are
+// added. This class is thread-safe.
+class DisassemblyCache {
+ public:
+  static constexpr size_t kMaxSize = 64;
+
+  // Returns the cached disassembly, or the result of `disassemble`, which is then cached.
+  [[nodiscard]] Disassembler GetOrDisassemble(std::string_view build_id, uint64_t address,
+                                              std::string_view machine_code,
+                                              const std::function<Disassembler()>& disassemble);
+
+  void Clear();
+
+ private:
+  using Key = std::tuple<std::string, uint64_t, std::string>;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<Key, Disassembler> disassemblies_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace orbit_code_report
+
+#endif  // CODE_REPORT_DISASSEMBLY_CACHE_H_
@@ -10,6 +10,7 @@
 
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "ClientData/PostProcessedSamplingData.h"
 #include "CodeReport/CodeReport.h"
@@ -25,7 +26,9 @@ class DisassemblyReport : public orbit_code_report::CodeReport {
         thread_sample_data_{std::move(thread_sample_data)},
         function_count_{function_count},
         samples_count_(samples_count),
-        absolute_function_address_{absolute_function_address} {}
+        absolute_function_address_{absolute_function_address} {
+    ComputeNumSamplesAtLines();
+  }
 
   explicit DisassemblyReport(Disassembler disasm, uint64_t absolute_function_address)
       : disasm_{std::move(disasm)},
@@ -39,6 +42,9 @@ class DisassemblyReport : public orbit_code_report::CodeReport {
 
   [[nodiscard]] std::optional<size_t> GetLineAtAddress(uint64_t address) const;
 
+  // The addresses of all instructions, in the order of the lines they are on.
+  [[nodiscard]] std::vector<uint64_t> GetInstructionAddresses() const;
+
   [[nodiscard]] uint64_t GetAbsoluteFunctionAddress() const { return absolute_function_address_; }
 
  private:
@@ -47,6 +53,12 @@ class DisassemblyReport : public orbit_code_report::CodeReport {
   uint32_t function_count_;
   uint32_t samples_count_;
   uint64_t absolute_function_address_;
+
+  // The number of samples of each (0-indexed) line, computed once, as the dialog queries them on
+  // every repaint. Empty if there are no samples in the function.
+  std::vector<uint32_t> num_samples_at_lines_;
+
+  void ComputeNumSamplesAtLines();
 };
 
 }  // namespace orbit_code_report
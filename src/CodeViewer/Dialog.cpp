@@ -15,6 +15,7 @@
 #include <QTextDocument>
 #include <utility>
 
+#include "SyntaxHighlighter/LazySyntaxHighlighter.h"
 #include "ui_Dialog.h"
 
 namespace orbit_code_viewer {
@@ -43,6 +44,8 @@ void Dialog::SetMainContent(const QString& code,
   SetMainContent(code);
   syntax_highlighter_ = std::move(syntax_highlighter);
   syntax_highlighter_->setDocument(ui_->viewer->document());
+  ui_->viewer->SetLazySyntaxHighlighter(
+      dynamic_cast<orbit_syntax_highlighter::LazySyntaxHighlighter*>(syntax_highlighter_.get()));
 }
 
 void Dialog::SetHeatmap(FontSizeInEm heatmap_bar_width,
@@ -33,6 +33,8 @@
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include "SyntaxHighlighter/HighlightingMetadata.h"
 
@@ -76,6 +78,8 @@ Viewer::Viewer(QWidget* parent)
       right_sidebar_widget_{this} {
   UpdateBarsSize();
   QObject::connect(this, &QPlainTextEdit::blockCountChanged, this, &Viewer::UpdateBarsSize);
+  QObject::connect(this, &QPlainTextEdit::blockCountChanged, this,
+                   [this]() { heatmap_line_samples_.reset(); });
 
   QObject::connect(&top_bar_widget_, &PlaceHolderWidget::PaintEventTriggered, this,
                    &Viewer::DrawTopWidget);
@@ -132,6 +136,11 @@ Viewer::Viewer(QWidget* parent)
   setPalette(current_palette);
 }
 
+void Viewer::paintEvent(QPaintEvent* ev) {
+  HighlightVisibleBlocks();
+  QPlainTextEdit::paintEvent(ev);
+}
+
 void Viewer::resizeEvent(QResizeEvent* ev) {
   QPlainTextEdit::resizeEvent(ev);
 
@@ -236,9 +245,8 @@ void Viewer::DrawLineNumbers(QPaintEvent* event) {
       const QRect heatmap_rect{0, top_of(block), heatmap_bar_width_.ToPixels(fontMetrics()),
                                fontMetrics().height()};
 
-      const uint32_t num_samples_in_line =
-          code_report_->GetNumSamplesAtLine(line_number).value_or(0);
-      const uint32_t num_samples_in_function = code_report_->GetNumSamplesInFunction();
+      const uint32_t num_samples_in_line = GetNumSamplesAtLine(line_number).value_or(0);
+      const uint32_t num_samples_in_function = GetHeatmapLineSamples().num_samples_in_function;
 
       const int scaled_intensity = [&] {
         if (num_samples_in_function == 0) return 0;
@@ -327,7 +335,7 @@ void Viewer::DrawSampleCounters(QPaintEvent* event) {
       return metadata->line_number;
     }();
 
-    auto maybe_num_samples_in_lines = code_report_->GetNumSamplesAtLine(line_number);
+    auto maybe_num_samples_in_lines = GetNumSamplesAtLine(line_number);
     if (!maybe_num_samples_in_lines.has_value()) continue;
 
     const uint32_t num_samples_in_line = maybe_num_samples_in_lines.value();
@@ -347,8 +355,8 @@ void Viewer::DrawSampleCounters(QPaintEvent* event) {
                                fontMetrics().height()};
       painter.setPen(kLineNumberForegroundColor);
 
-      QString function_percentage_string =
-          FractionToPercentageString(num_samples_in_line, code_report_->GetNumSamplesInFunction());
+      QString function_percentage_string = FractionToPercentageString(
+          num_samples_in_line, GetHeatmapLineSamples().num_samples_in_function);
       painter.drawText(bounding_box, Qt::AlignRight, function_percentage_string);
       current += WidthPercentageColumn() + WidthMarginBetweenColumns();
     }
@@ -360,13 +368,48 @@ void Viewer::DrawSampleCounters(QPaintEvent* event) {
       painter.setPen(kLineNumberForegroundColor);
 
       QString total_percentage_string =
-          FractionToPercentageString(num_samples_in_line, code_report_->GetNumSamples());
+          FractionToPercentageString(num_samples_in_line, GetHeatmapLineSamples().num_samples);
       painter.drawText(bounding_box, Qt::AlignRight, total_percentage_string);
       current += WidthPercentageColumn() + right_margin_.ToPixels(fontMetrics());
     }
   }
 }
 
+void Viewer::HighlightVisibleBlocks() {
+  if (lazy_syntax_highlighter_ == nullptr) return;
+
+  const QTextBlock first_block = firstVisibleBlock();
+  if (!first_block.isValid()) return;
+
+  const int viewport_bottom = viewport()->rect().bottom();
+  QTextBlock last_block = first_block;
+  for (QTextBlock block = first_block.next(); block.isValid(); block = block.next()) {
+    if (blockBoundingGeometry(block).translated(contentOffset()).top() > viewport_bottom) break;
+    last_block = block;
+  }
+
+  lazy_syntax_highlighter_->HighlightBlocks(first_block, last_block);
+}
+
+std::optional<uint32_t> Viewer::GetNumSamplesAtLine(uint64_t line_number) {
+  ORBIT_CHECK(code_report_ != nullptr);
+  const HeatmapLineSamples& heatmap_line_samples = GetHeatmapLineSamples();
+  if (line_number == 0 || line_number > heatmap_line_samples.num_samples_at_lines.size()) {
+    return code_report_->GetNumSamplesAtLine(line_number);
+  }
+  return heatmap_line_samples.num_samples_at_lines[line_number - 1];
+}
+
+const HeatmapLineSamples& Viewer::GetHeatmapLineSamples() {
+  ORBIT_CHECK(code_report_ != nullptr);
+  if (!heatmap_line_samples_.has_value()) {
+    const uint64_t max_line_number = largest_occuring_line_numbers_.main_content.value_or(
+        static_cast<uint64_t>(blockCount()));
+    heatmap_line_samples_ = ComputeHeatmapLineSamples(*code_report_, max_line_number);
+  }
+  return heatmap_line_samples_.value();
+}
+
 uint64_t Viewer::LargestOccurringLineNumber() const {
   switch (line_number_types_) {
     case LineNumberTypes::kNone:
@@ -463,14 +506,22 @@ void Viewer::SetHeatmapBarWidth(FontSizeInEm width) {
 
 void Viewer::SetHeatmapSource(const orbit_code_report::CodeReport* code_report) {
   code_report_ = code_report;
+  heatmap_line_samples_.reset();
   UpdateBarsSize();
 }
 
 void Viewer::ClearHeatmapSource() {
   code_report_ = nullptr;
+  heatmap_line_samples_.reset();
   UpdateBarsSize();
 }
 
+void Viewer::SetLazySyntaxHighlighter(
+    orbit_syntax_highlighter::LazySyntaxHighlighter* highlighter) {
+  lazy_syntax_highlighter_ = highlighter;
+  viewport()->update();
+}
+
 void Viewer::SetHighlightCurrentLine(bool enabled) {
   if (is_current_line_highlighted_ == enabled) return;
 
@@ -523,6 +574,7 @@ int Viewer::TopWidgetHeight() const { return fontMetrics().height(); }
 void Viewer::SetAnnotatingContent(
     absl::Span<const orbit_code_report::AnnotatingLine> annotating_lines) {
   largest_occuring_line_numbers_ = SetAnnotatingContentInDocument(document(), annotating_lines);
+  heatmap_line_samples_.reset();
   UpdateBarsSize();
 }
 
@@ -606,4 +658,18 @@ LargestOccurringLineNumbers SetAnnotatingContentInDocument(
   return largest_occuring_line_numbers;
 }
 
+HeatmapLineSamples ComputeHeatmapLineSamples(const orbit_code_report::CodeReport& code_report,
+                                             uint64_t max_line_number) {
+  HeatmapLineSamples heatmap_line_samples{};
+  heatmap_line_samples.num_samples_in_function = code_report.GetNumSamplesInFunction();
+  heatmap_line_samples.num_samples = code_report.GetNumSamples();
+
+  heatmap_line_samples.num_samples_at_lines.reserve(max_line_number);
+  for (uint64_t line_number = 1; line_number <= max_line_number; ++line_number) {
+    heatmap_line_samples.num_samples_at_lines.push_back(
+        code_report.GetNumSamplesAtLine(line_number));
+  }
+  return heatmap_line_samples;
+}
+
 }  // namespace orbit_code_viewer
@@ -19,11 +19,13 @@
 #include <QWheelEvent>
 #include <Qt>
 #include <array>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <string_view>
 
 #include "CodeReport/AnnotatingLine.h"
+#include "CodeReport/CodeReport.h"
 #include "CodeViewer/Viewer.h"
 
 namespace orbit_code_viewer {
@@ -318,4 +320,40 @@ TEST(Viewer, HighlightCurrentLine) {
   viewer.SetHighlightCurrentLine(false);
   EXPECT_FALSE(viewer.IsCurrentLineHighlighted());
 }
+
+namespace {
+// Has data for the lines 2 to 4. The number of samples is the line number, doubled for line 3.
+class FakeCodeReport : public orbit_code_report::CodeReport {
+ public:
+  [[nodiscard]] uint32_t GetNumSamplesInFunction() const override { return 18; }
+  [[nodiscard]] uint32_t GetNumSamples() const override { return 100; }
+  [[nodiscard]] std::optional<uint32_t> GetNumSamplesAtLine(size_t line) const override {
+    if (line < 2 || line > 4) return std::nullopt;
+    return static_cast<uint32_t>(line * (line == 3 ? 2 : 1));
+  }
+};
+}  // namespace
+
+TEST(Viewer, ComputeHeatmapLineSamples) {
+  const FakeCodeReport code_report{};
+  const HeatmapLineSamples heatmap_line_samples = ComputeHeatmapLineSamples(code_report, 5);
+
+  EXPECT_EQ(heatmap_line_samples.num_samples_in_function, 18);
+  EXPECT_EQ(heatmap_line_samples.num_samples, 100);
+
+  ASSERT_EQ(heatmap_line_samples.num_samples_at_lines.size(), 5);
+  EXPECT_EQ(heatmap_line_samples.num_samples_at_lines[0], std::nullopt);
+  EXPECT_EQ(heatmap_line_samples.num_samples_at_lines[1], 2);
+  EXPECT_EQ(heatmap_line_samples.num_samples_at_lines[2], 6);
+  EXPECT_EQ(heatmap_line_samples.num_samples_at_lines[3], 4);
+  EXPECT_EQ(heatmap_line_samples.num_samples_at_lines[4], std::nullopt);
+}
+
+TEST(Viewer, ComputeHeatmapLineSamplesWithoutLines) {
+  const FakeCodeReport code_report{};
+  const HeatmapLineSamples heatmap_line_samples = ComputeHeatmapLineSamples(code_report, 0);
+
+  EXPECT_EQ(heatmap_line_samples.num_samples_in_function, 18);
+  EXPECT_TRUE(heatmap_line_samples.num_samples_at_lines.empty());
+}
 }  // namespace orbit_code_viewer
\ No newline at end of file
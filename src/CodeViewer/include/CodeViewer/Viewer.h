@@ -20,11 +20,13 @@
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <vector>
 
 #include "CodeReport/AnnotatingLine.h"
 #include "CodeReport/CodeReport.h"
 #include "CodeViewer/FontSizeInEm.h"
 #include "CodeViewer/PlaceHolderWidget.h"
+#include "SyntaxHighlighter/LazySyntaxHighlighter.h"
 
 namespace orbit_code_viewer {
 
@@ -33,6 +35,15 @@ struct LargestOccurringLineNumbers {
   std::optional<uint64_t> annotating_lines;
 };
 
+// The sample counts of a code report for all lines of the main content, computed in one pass so
+// that painting the heatmap and the sample counters doesn't query the report line by line.
+struct HeatmapLineSamples {
+  // Indexed by line number - 1. An empty optional means there is no data for this line.
+  std::vector<std::optional<uint32_t>> num_samples_at_lines;
+  uint32_t num_samples_in_function = 0;
+  uint32_t num_samples = 0;
+};
+
 /*
   Viewer is a for displaying source code. It derives from a QPlainTextEdit
   and adds some additional features like a left sidebar for displaying
@@ -75,6 +86,10 @@ class Viewer : public QPlainTextEdit {
   void SetHeatmapSource(const orbit_code_report::CodeReport* code_report);
   void ClearHeatmapSource();
 
+  // The highlighter needs to be attached to this viewer's document. It will then only be asked to
+  // highlight the blocks that are about to be painted.
+  void SetLazySyntaxHighlighter(orbit_syntax_highlighter::LazySyntaxHighlighter* highlighter);
+
   void SetHighlightCurrentLine(bool is_enabled);
   [[nodiscard]] bool IsCurrentLineHighlighted() const;
 
@@ -84,12 +99,17 @@ class Viewer : public QPlainTextEdit {
   [[nodiscard]] const QString& GetTopBarTitle() const { return top_bar_title_; }
 
  private:
+  void paintEvent(QPaintEvent* ev) override;
   void resizeEvent(QResizeEvent* ev) override;
   void wheelEvent(QWheelEvent* ev) override;
   void DrawTopWidget(QPaintEvent* event);
   void DrawLineNumbers(QPaintEvent* event);
   void DrawSampleCounters(QPaintEvent* event);
 
+  void HighlightVisibleBlocks();
+  [[nodiscard]] std::optional<uint32_t> GetNumSamplesAtLine(uint64_t line_number);
+  [[nodiscard]] const HeatmapLineSamples& GetHeatmapLineSamples();
+
   void UpdateBarsSize();
   void UpdateBarsPosition();
   void HighlightCurrentLine();
@@ -108,6 +128,10 @@ class Viewer : public QPlainTextEdit {
 
   FontSizeInEm heatmap_bar_width_ = FontSizeInEm{0.0f};
   const orbit_code_report::CodeReport* code_report_ = nullptr;
+  // Computed on first use from `code_report_` and reset whenever the report or the document change.
+  std::optional<HeatmapLineSamples> heatmap_line_samples_;
+
+  QPointer<orbit_syntax_highlighter::LazySyntaxHighlighter> lazy_syntax_highlighter_;
 
   bool is_current_line_highlighted_ = false;
 
@@ -128,6 +152,10 @@ class Viewer : public QPlainTextEdit {
 // `.reference_line`.
 [[nodiscard]] LargestOccurringLineNumbers SetAnnotatingContentInDocument(
     QTextDocument* document, absl::Span<const orbit_code_report::AnnotatingLine> annotating_lines);
+
+// Queries the code report once for each of the lines 1 to `max_line_number`.
+[[nodiscard]] HeatmapLineSamples ComputeHeatmapLineSamples(
+    const orbit_code_report::CodeReport& code_report, uint64_t max_line_number);
 }  // namespace orbit_code_viewer
 
 #endif  // CODE_VIEWER_VIEWER_H_
\ No newline at end of file
@@ -0,0 +1,64 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Containers/AppendOnlyVector.h"
+
+namespace orbit_containers {
+
+TEST(AppendOnlyVector, PushBackAcrossSegments) {
+  AppendOnlyVector<std::string> vector;
+  EXPECT_TRUE(vector.empty());
+
+  constexpr size_t kCount = 1000;
+  for (size_t i = 0; i < kCount; ++i) {
+    vector.push_back(std::to_string(i));
+  }
+
+  EXPECT_FALSE(vector.empty());
+  ASSERT_EQ(vector.size(), kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    EXPECT_EQ(vector[i], std::to_string(i));
+  }
+  EXPECT_EQ(vector.back(), std::to_string(kCount - 1));
+}
+
+TEST(AppendOnlyVector, ReferencesStayValid) {
+  AppendOnlyVector<int> vector;
+  vector.push_back(42);
+  const int* first = &vector[0];
+  for (int i = 0; i < 10'000; ++i) {
+    vector.push_back(i);
+  }
+  EXPECT_EQ(first, &vector[0]);
+  EXPECT_EQ(*first, 42);
+}
+
+TEST(AppendOnlyVector, ReadersSeeAllElementsBelowTheSize) {
+  constexpr size_t kCount = 200'000;
+  AppendOnlyVector<size_t> vector;
+  std::atomic<bool> reader_failed = false;
+
+  std::thread reader([&] {
+    size_t size = 0;
+    while (size < kCount) {
+      size = vector.size();
+      if (size > 0 && vector[size - 1] != size - 1) reader_failed = true;
+    }
+  });
+  for (size_t i = 0; i < kCount; ++i) {
+    vector.push_back(i);
+  }
+  reader.join();
+
+  EXPECT_FALSE(reader_failed);
+}
+
+}  // namespace orbit_containers
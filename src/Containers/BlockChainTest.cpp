@@ -2,10 +2,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Containers/BlockChain.h"
 
@@ -45,6 +47,18 @@ class MovableType {
   std::string value_;
 };
 
+class DestructionCountingType {
+ public:
+  explicit DestructionCountingType(int* destruction_count)
+      : destruction_count_{destruction_count} {}
+  DestructionCountingType(const DestructionCountingType&) = delete;
+  DestructionCountingType& operator=(const DestructionCountingType&) = delete;
+  ~DestructionCountingType() { ++*destruction_count_; }
+
+ private:
+  int* destruction_count_;
+};
+
 };  // namespace
 
 TEST(BlockChain, CreateAndMove) {
@@ -186,9 +200,8 @@ TEST(BlockChain, AddCopyableTypesN) {
   }
 }
 
-// "Reset" works like "clear", except that it does not actually free
-// any memory - it keeps the block's memory, just setting their
-// size to 0
+// "Reset" works like "clear", except that it keeps the blocks in the
+// chain, just setting their size to 0
 TEST(BlockChain, Reset) {
   BlockChain<int, 1024> chain;
   chain.push_back_n(5, 1024 * 3);
@@ -233,4 +246,56 @@ TEST(BlockChain, MovableType) {
   EXPECT_EQ(chain.root()->data()[1].value(), "v2");
 }
 
-}  // namespace orbit_containers
\ No newline at end of file
+TEST(BlockChain, ClearRecyclesTheBlocks) {
+  BlockChain<int, 1024> chain;
+  chain.push_back_n(5, 1024 * 3);
+  const Block<int, 1024>* root = chain.root();
+  std::vector<const Block<int, 1024>*> blocks = {root->next(), root->next()->next()};
+
+  chain.clear();
+  EXPECT_EQ(chain.size(), 0);
+  EXPECT_EQ(chain.root(), root);
+  EXPECT_EQ(chain.root()->next(), nullptr);
+
+  chain.push_back_n(10, 1024 * 3);
+  ASSERT_NE(chain.root()->next(), nullptr);
+  ASSERT_NE(chain.root()->next()->next(), nullptr);
+  EXPECT_THAT(blocks, testing::UnorderedElementsAre(chain.root()->next(),
+                                                    chain.root()->next()->next()));
+  EXPECT_EQ(chain.root()->next()->prev(), chain.root());
+  EXPECT_EQ(chain.root()->next()->next()->next(), nullptr);
+  for (int value : chain) {
+    EXPECT_EQ(value, 10);
+  }
+}
+
+TEST(BlockChain, DestroysTheElements) {
+  int destruction_count = 0;
+  {
+    BlockChain<DestructionCountingType, 16> chain;
+    for (int i = 0; i < 40; ++i) chain.emplace_back(&destruction_count);
+    chain.clear();
+    EXPECT_EQ(destruction_count, 40);
+
+    for (int i = 0; i < 20; ++i) chain.emplace_back(&destruction_count);
+    chain.Reset();
+    EXPECT_EQ(destruction_count, 60);
+
+    for (int i = 0; i < 10; ++i) chain.emplace_back(&destruction_count);
+  }
+  EXPECT_EQ(destruction_count, 70);
+}
+
+TEST(BlockChain, MoveAssignToNonEmpty) {
+  int destruction_count = 0;
+  BlockChain<DestructionCountingType, 16> source_chain;
+  source_chain.emplace_back(&destruction_count);
+  BlockChain<DestructionCountingType, 16> target_chain;
+  for (int i = 0; i < 20; ++i) target_chain.emplace_back(&destruction_count);
+
+  target_chain = std::move(source_chain);
+  EXPECT_EQ(destruction_count, 20);
+  EXPECT_EQ(target_chain.size(), 1);
+}
+
+}  // namespace orbit_containers
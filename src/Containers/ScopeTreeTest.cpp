@@ -181,6 +181,45 @@ TEST(ScopeTree, OutOfOrderScopes) {
   }
 }
 
+TEST(ScopeTree, BuildIsTheSameAsInsert) {
+  constexpr size_t kMaxNumNodes = 1024;
+  constexpr size_t kMaxDepth = 16;
+  constexpr size_t kNumSiblingsPerDepth = 4;
+  std::vector<TestScope*> test_scopes;
+  CreateNestedTestScopes(kMaxNumNodes, kMaxDepth, kNumSiblingsPerDepth, &test_scopes);
+  // Also add scopes with the same timestamps, and scopes that overlap without being nested.
+  test_scopes.push_back(CreateScope(test_scopes[0]->start(), test_scopes[0]->end()));
+  test_scopes.push_back(CreateScope(test_scopes[1]->start(), test_scopes[1]->end() + 1));
+  test_scopes.push_back(CreateScope(1, 2));
+  test_scopes.push_back(CreateScope(2, 3));
+
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::shuffle(test_scopes.begin(), test_scopes.end(), gen);
+
+  ScopeTree<TestScope> reference_tree;
+  for (TestScope* scope : test_scopes) {
+    reference_tree.Insert(scope);
+  }
+
+  ScopeTree<TestScope> tree;
+  tree.Build(test_scopes);
+  ValidateTree(tree);
+  EXPECT_EQ(tree.Size(), reference_tree.Size());
+  EXPECT_EQ(tree.Depth(), reference_tree.Depth());
+  EXPECT_EQ(tree.ToString(), reference_tree.ToString());
+}
+
+TEST(ScopeTree, BuildWithOverlappingTimers) {
+  ScopeTree<TestScope> tree;
+  tree.Build({CreateScope(1, 10), CreateScope(0, 200), CreateScope(2, 50), CreateScope(5, 100)});
+  EXPECT_EQ(tree.Depth(), 2);
+  EXPECT_EQ(tree.Size(), 5);
+  EXPECT_EQ(tree.GetOrderedNodesAtDepth(0).size(), 1);
+  EXPECT_EQ(tree.GetOrderedNodesAtDepth(1).size(), 3);
+  ValidateTree(tree);
+}
+
 TEST(ScopeTree, FindRelationships) {
   /* Create a tree to test edge cases:
       root
@@ -0,0 +1,76 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CONTAINERS_APPEND_ONLY_VECTOR_H_
+#define CONTAINERS_APPEND_ONLY_VECTOR_H_
+
+#include <absl/numeric/bits.h>
+#include <stddef.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_containers {
+
+// A vector that one thread appends to while other threads read it without locking. The elements
+// are stored in segments which double in size and are never moved, so references stay valid, and
+// push_back publishes the new size with release semantics: a reader that sees an index below
+// size() also sees the element at that index as it was appended. Elements that are modified after
+// being appended must take care of their own synchronization, e.g. by being atomics.
+//
+// Only one thread at a time may call the non-const methods.
+template <typename T>
+class AppendOnlyVector {
+ public:
+  AppendOnlyVector() = default;
+  AppendOnlyVector(const AppendOnlyVector&) = delete;
+  AppendOnlyVector& operator=(const AppendOnlyVector&) = delete;
+
+  template <typename U>
+  void push_back(U&& value) {
+    const size_t index = size_.load(std::memory_order_relaxed);
+    const auto [segment, offset] = GetSegmentAndOffset(index);
+    if (offset == 0) {
+      ORBIT_CHECK(segment < kMaxSegments);
+      segments_[segment] = std::make_unique<T[]>(kFirstSegmentSize << segment);
+    }
+    segments_[segment][offset] = std::forward<U>(value);
+    size_.store(index + 1, std::memory_order_release);
+  }
+
+  [[nodiscard]] size_t size() const { return size_.load(std::memory_order_acquire); }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  [[nodiscard]] const T& operator[](size_t index) const {
+    const auto [segment, offset] = GetSegmentAndOffset(index);
+    return segments_[segment][offset];
+  }
+  [[nodiscard]] T& operator[](size_t index) {
+    const auto [segment, offset] = GetSegmentAndOffset(index);
+    return segments_[segment][offset];
+  }
+  [[nodiscard]] T& back() { return (*this)[size_.load(std::memory_order_relaxed) - 1]; }
+
+ private:
+  static constexpr size_t kFirstSegmentSize = 16;
+  // Segment s holds kFirstSegmentSize * 2^s elements, so this is far more than can be allocated.
+  static constexpr size_t kMaxSegments = 48;
+
+  // Segment s starts at index kFirstSegmentSize * (2^s - 1).
+  [[nodiscard]] static std::pair<size_t, size_t> GetSegmentAndOffset(size_t index) {
+    const size_t segment = absl::bit_width(index / kFirstSegmentSize + 1) - 1;
+    return {segment, index - kFirstSegmentSize * ((size_t{1} << segment) - 1)};
+  }
+
+  std::array<std::unique_ptr<T[]>, kMaxSegments> segments_;
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace orbit_containers
+
+#endif  // CONTAINERS_APPEND_ONLY_VECTOR_H_
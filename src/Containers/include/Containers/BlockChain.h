@@ -6,7 +6,12 @@
 #define CONTAINERS_BLOCK_CHAIN_H_
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include "OrbitBase/Logging.h"
 
@@ -18,27 +23,41 @@ class BlockChain;
 template <class T, uint32_t BlockSize>
 class BlockIterator;
 
+// The elements are stored inline, so that a block is a single allocation and iterating over its
+// elements doesn't go through another pointer.
 template <class T, uint32_t Size>
 class Block final {
  public:
-  explicit Block(Block<T, Size>* prev) : prev_(prev), next_(nullptr) { data_.reserve(Size); }
+  explicit Block(Block<T, Size>* prev) : prev_(prev), next_(nullptr) {}
+  ~Block() { ResetSize(); }
+
+  Block(const Block& other) = delete;
+  Block& operator=(const Block& other) = delete;
+  Block(Block&& other) = delete;
+  Block& operator=(Block&& other) = delete;
 
   [[nodiscard]] bool HasNext() const { return next_ != nullptr; }
   [[nodiscard]] const Block<T, Size>* next() const { return next_; }
   [[nodiscard]] const Block<T, Size>* prev() const { return prev_; }
-  [[nodiscard]] uint32_t size() const { return data_.size(); }
-  [[nodiscard]] const T* data() const { return data_.data(); }
+  [[nodiscard]] uint32_t size() const { return size_; }
+  [[nodiscard]] const T* data() const { return std::launder(reinterpret_cast<const T*>(storage_)); }
   [[nodiscard]] bool at_capacity() const { return size() == Size; }
 
  private:
   friend class BlockIterator<T, Size>;
   friend class BlockChain<T, Size>;
 
-  [[nodiscard]] const T& Get(uint32_t index) const { return data_[index]; }
+  [[nodiscard]] const T& Get(uint32_t index) const { return data()[index]; }
   [[nodiscard]] Block<T, Size>* mutable_next() { return next_; }
   [[nodiscard]] Block<T, Size>* mutable_prev() { return prev_; }
+  [[nodiscard]] T* mutable_data() { return std::launder(reinterpret_cast<T*>(storage_)); }
 
-  void ResetSize() { data_.resize(0); }
+  void ResetSize() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      std::destroy_n(mutable_data(), size_);
+    }
+    size_ = 0;
+  }
 
   void Reset() {
     ResetSize();
@@ -50,12 +69,15 @@ class Block final {
   template <class... Args>
   T& emplace_back(Args&&... args) {
     ORBIT_CHECK(size() < Size);
-    return data_.emplace_back(std::forward<Args>(args)...);
+    T* item = new (storage_ + size_ * sizeof(T)) T(std::forward<Args>(args)...);
+    ++size_;
+    return *item;
   }
 
   Block<T, Size>* prev_;
   Block<T, Size>* next_;
-  std::vector<T> data_;
+  uint32_t size_ = 0;
+  alignas(T) unsigned char storage_[Size * sizeof(T)];
 };
 
 template <class T, uint32_t BlockSize>
@@ -96,45 +118,35 @@ class BlockIterator final {
   uint32_t index_;
 };
 
+// Blocks are never freed before the BlockChain is destroyed: Reset() keeps them in the chain, and
+// clear() moves all but the root to a list of free blocks, from which new blocks are taken first.
 template <class T, uint32_t BlockSize>
 class BlockChain final {
  public:
-  BlockChain() : root_{nullptr}, current_{nullptr}, size_{0} {}
+  BlockChain() : root_{nullptr}, current_{nullptr}, free_blocks_{nullptr}, size_{0} {}
 
   BlockChain(const BlockChain& other) = delete;
 
   BlockChain& operator=(const BlockChain& other) = delete;
 
-  BlockChain(BlockChain&& other) { *this = std::move(other); }
+  BlockChain(BlockChain&& other) : BlockChain() { *this = std::move(other); }
 
   BlockChain& operator=(BlockChain&& other) {
     if (this == &other) return *this;
 
+    DeleteBlocks();
     size_ = other.size_;
     root_ = other.root_;
     current_ = other.current_;
+    free_blocks_ = other.free_blocks_;
 
-    other.root_ = other.current_ = nullptr;
+    other.root_ = other.current_ = other.free_blocks_ = nullptr;
     other.size_ = 0;
 
     return *this;
   }
 
-  ~BlockChain() {
-    if (root_ == nullptr) return;
-
-    // Find last block in chain
-    while (current_->HasNext()) {
-      current_ = current_->mutable_next();
-    }
-
-    Block<T, BlockSize>* prev = current_;
-    while (prev) {
-      prev = current_->mutable_prev();
-      delete current_;
-      current_ = prev;
-    }
-  }
+  ~BlockChain() { DeleteBlocks(); }
 
   template <size_t size>
   void push_back(const std::array<T, size>& array) {
@@ -152,7 +164,7 @@ class BlockChain final {
   template <class... Args>
   T& emplace_back(Args&&... args) {
     if (root_ == nullptr) {
-      root_ = new Block<T, BlockSize>(nullptr);
+      root_ = TakeFreeBlockOrAllocate(nullptr);
       current_ = root_;
     }
 
@@ -165,16 +177,16 @@ class BlockChain final {
   void clear() {
     if (root_ == nullptr) return;
 
+    Block<T, BlockSize>* block = root_->mutable_next();
+    while (block != nullptr) {
+      Block<T, BlockSize>* next = block->mutable_next();
+      block->Reset();
+      block->next_ = free_blocks_;
+      free_blocks_ = block;
+      block = next;
+    }
     root_->Reset();
     size_ = 0;
-
-    Block<T, BlockSize>* prev = current_;
-    while (prev != root_) {
-      prev = current_->mutable_prev();
-      delete current_;
-      current_ = prev;
-    }
-
     current_ = root_;
   }
 
@@ -204,13 +216,39 @@ class BlockChain final {
  private:
   void AllocateOrRecycleBlock() {
     if (current_->next_ == nullptr) {
-      current_->next_ = new Block<T, BlockSize>(current_);
+      current_->next_ = TakeFreeBlockOrAllocate(current_);
     }
     current_ = current_->next_;
   }
 
+  [[nodiscard]] Block<T, BlockSize>* TakeFreeBlockOrAllocate(Block<T, BlockSize>* prev) {
+    if (free_blocks_ == nullptr) return new Block<T, BlockSize>(prev);
+    Block<T, BlockSize>* block = free_blocks_;
+    free_blocks_ = block->next_;
+    block->next_ = nullptr;
+    block->prev_ = prev;
+    return block;
+  }
+
+  static void DeleteList(Block<T, BlockSize>* block) {
+    while (block != nullptr) {
+      Block<T, BlockSize>* next = block->mutable_next();
+      delete block;
+      block = next;
+    }
+  }
+
+  void DeleteBlocks() {
+    DeleteList(root_);
+    DeleteList(free_blocks_);
+    root_ = current_ = free_blocks_ = nullptr;
+    size_ = 0;
+  }
+
   Block<T, BlockSize>* root_;
   Block<T, BlockSize>* current_;
+  // Singly linked through next_.
+  Block<T, BlockSize>* free_blocks_;
   uint32_t size_;
 };
 
@@ -5,9 +5,11 @@
 #ifndef CONTAINERS_SCOPE_TREE_H_
 #define CONTAINERS_SCOPE_TREE_H_
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "BlockChain.h"
@@ -23,6 +25,11 @@ namespace orbit_containers {
 // goal is to be able to generate the scope tree with different streams of scope data that can
 // arrive out of order. The underlying scope type needs to define the "uint64_t Start()" and
 // "uint64_t End()" methods. Note that ScopeTree is not thread safe in its current implementation.
+//
+// The nodes are allocated in a BlockChain, and each node keeps its children in a vector sorted by
+// start time, so that inserting a scope that ends the last one at its depth is amortized constant
+// time once its parent is found. When all the scopes are known upfront, e.g. for a loaded capture,
+// Build creates the tree in a single pass over the scopes sorted by start time.
 
 template <typename ScopeT>
 class ScopeNode {
@@ -39,8 +46,8 @@ class ScopeNode {
 
   [[nodiscard]] ScopeNode* GetLastChildBeforeOrAtTime(uint64_t time) const;
   [[nodiscard]] std::vector<ScopeNode*> GetChildrenInRange(uint64_t start, uint64_t end) const;
-  [[nodiscard]] const absl::btree_map<uint64_t, ScopeNode*>& GetChildrenByStartTime() const {
-    return *children_by_start_time_;
+  [[nodiscard]] const std::vector<ScopeNode*>& GetChildrenByStartTime() const {
+    return children_by_start_time_;
   }
 
   [[nodiscard]] uint64_t Start() const { return scope_->start(); }
@@ -51,10 +58,15 @@ class ScopeNode {
   [[nodiscard]] std::set<const ScopeNode*> GetAllNodesInSubtree() const;
   void SetDepth(uint32_t depth) { depth_ = depth; }
   void SetParent(ScopeNode* parent) { parent_ = parent; }
+  // Appends `node` as the last child. It must start after the current last child.
+  void AppendChild(ScopeNode* node);
   ScopeT* GetScope() { return scope_; }
 
  private:
   [[nodiscard]] ScopeNode* FindDeepestParentForNode(const ScopeNode* node);
+  // First child that starts at or after `time`.
+  [[nodiscard]] typename std::vector<ScopeNode*>::const_iterator ChildrenLowerBound(
+      uint64_t time) const;
   static void ToString(const ScopeNode* node, std::string* str, uint32_t depth = 0);
   static void CountNodesInSubtree(const ScopeNode* node, size_t* count);
   static void GetAllNodesInSubtree(const ScopeNode* node, std::set<const ScopeNode*>* node_set);
@@ -64,10 +76,8 @@ class ScopeNode {
   uint32_t depth_ = 0;
   ScopeNode* parent_ = nullptr;
 
-  // We use std::unique_ptr to work around an issue with absl::btree_map which complains about not
-  // knowing the size of ScopeT, which is not needed since ScopeNode only stores a ScopeTree*.
-  std::unique_ptr<absl::btree_map<uint64_t, ScopeNode<ScopeT>*>> children_by_start_time_ =
-      std::make_unique<absl::btree_map<uint64_t, ScopeNode<ScopeT>*>>();
+  // Sorted by start time, without two children with the same start time.
+  std::vector<ScopeNode*> children_by_start_time_;
 };
 
 template <typename ScopeT>
@@ -75,6 +85,10 @@ class ScopeTree {
  public:
   ScopeTree();
   void Insert(ScopeT* scope);
+  // Inserts all of `scopes` into a tree that has none yet. The result is the same as calling Insert
+  // for each of them, for properly nested scopes in any order, but each scope is only compared with
+  // the ones enclosing the previous scope.
+  void Build(std::vector<ScopeT*> scopes);
   void Print() const { ORBIT_LOG("%s", ToString()); }
   [[nodiscard]] std::string ToString() const;
 
@@ -82,6 +96,12 @@ class ScopeTree {
 
   [[nodiscard]] const ScopeNodeT* Root() const { return root_; }
   [[nodiscard]] size_t Size() const { return nodes_.size(); }
+  // Returns an estimate of the memory held by the tree: every node also has an entry in the
+  // children of its parent and in the index of its depth.
+  [[nodiscard]] uint64_t GetMemoryUsageBytes() const {
+    return Size() * (sizeof(ScopeNodeT) + sizeof(ScopeNodeT*) +
+                     sizeof(std::pair<const uint64_t, ScopeNodeT*>));
+  }
   [[nodiscard]] size_t CountOrderedNodesByDepth() const;
   [[nodiscard]] uint32_t Depth() const;
   [[nodiscard]] const absl::btree_map<uint64_t /*start time*/, ScopeNodeT*>& GetOrderedNodesAtDepth(
@@ -143,9 +163,9 @@ template <typename ScopeT>
 const ScopeT* ScopeTree<ScopeT>::FindFirstChild(const ScopeT& scope) const {
   const ScopeNode<ScopeT>* node = FindScopeNode(scope);
   ORBIT_CHECK(node != nullptr);
-  const auto children = node->GetChildrenByStartTime();
+  const auto& children = node->GetChildrenByStartTime();
   if (children.empty()) return nullptr;
-  return children.begin()->second->GetScope();
+  return children.front()->GetScope();
 }
 template <typename ScopeT>
 const absl::btree_map<uint64_t, ScopeNode<ScopeT>*>& ScopeTree<ScopeT>::GetOrderedNodesAtDepth(
@@ -189,7 +209,7 @@ template <typename ScopeT>
 const ScopeT* ScopeTree<ScopeT>::FindNextScopeAtDepth(const ScopeT& scope) const {
   const ScopeNode<ScopeT>* node = FindScopeNode(scope);
   ORBIT_CHECK(node != nullptr);
-  auto nodes_at_depth = GetOrderedNodesByDepth().at(node->Depth());
+  const auto& nodes_at_depth = GetOrderedNodesByDepth().at(node->Depth());
   auto node_it = nodes_at_depth.upper_bound(node->Start());
   if (node_it == nodes_at_depth.end()) return nullptr;
   return node_it->second->GetScope();
@@ -199,7 +219,7 @@ template <typename ScopeT>
 const ScopeT* ScopeTree<ScopeT>::FindPreviousScopeAtDepth(const ScopeT& scope) const {
   const ScopeNode<ScopeT>* node = FindScopeNode(scope);
   ORBIT_CHECK(node != nullptr);
-  auto nodes_at_depth = GetOrderedNodesByDepth().at(node->Depth());
+  const auto& nodes_at_depth = GetOrderedNodesByDepth().at(node->Depth());
   auto node_it = nodes_at_depth.lower_bound(node->Start());
   if (node_it == nodes_at_depth.begin()) return nullptr;
   return (--node_it)->second->GetScope();
@@ -213,6 +233,34 @@ void ScopeTree<ScopeT>::Insert(ScopeT* scope) {
   UpdateDepthInSubtree(new_node, new_node->Depth());
 }
 
+template <typename ScopeT>
+void ScopeTree<ScopeT>::Build(std::vector<ScopeT*> scopes) {
+  ORBIT_SCOPE_FUNCTION;
+  ORBIT_CHECK(Size() == 1);
+
+  // Sort enclosing scopes before the scopes they enclose: by start time, and longer ones first.
+  std::stable_sort(scopes.begin(), scopes.end(), [](const ScopeT* lhs, const ScopeT* rhs) {
+    if (lhs->start() != rhs->start()) return lhs->start() < rhs->start();
+    return lhs->end() > rhs->end();
+  });
+
+  // The last inserted node and the nodes enclosing it, from the root down.
+  std::vector<ScopeNodeT*> enclosing_nodes = {root_};
+  for (ScopeT* scope : scopes) {
+    ScopeNodeT* node = CreateNode(scope);
+    while (enclosing_nodes.size() > 1 && enclosing_nodes.back()->End() < node->End()) {
+      enclosing_nodes.pop_back();
+    }
+    ScopeNodeT* parent_node = enclosing_nodes.back();
+    node->SetDepth(parent_node->Depth() + 1);
+    node->SetParent(parent_node);
+    parent_node->AppendChild(node);
+    auto& nodes_at_depth = ordered_nodes_by_depth_[node->Depth()];
+    nodes_at_depth.emplace_hint(nodes_at_depth.end(), node->Start(), node);
+    enclosing_nodes.push_back(node);
+  }
+}
+
 template <typename ScopeT>
 void ScopeTree<ScopeT>::UpdateDepthInSubtree(ScopeNodeT* node, uint32_t new_depth) {
   uint32_t previous_depth = node->Depth();
@@ -225,7 +273,7 @@ void ScopeTree<ScopeT>::UpdateDepthInSubtree(ScopeNodeT* node, uint32_t new_dept
   }
 
   // Recurse before inserting the node at new depth to prevent overwriting a child.
-  for (auto& [unused_timestamp, child_node] : node->GetChildrenByStartTime()) {
+  for (ScopeNodeT* child_node : node->GetChildrenByStartTime()) {
     UpdateDepthInSubtree(child_node, new_depth + 1);
   }
 
@@ -264,7 +312,7 @@ void ScopeNode<ScopeT>::ToString(const ScopeNode* node, std::string* str, uint32
   absl::StrAppend(
       str, absl::StrFormat("d%u %s ScopeNode(%p) [%lu, %lu]\n", node->Depth(),
                            std::string(depth, ' '), node->scope_, node->Start(), node->End()));
-  for (auto& [unused_time, child_node] : node->GetChildrenByStartTime()) {
+  for (const ScopeNode* child_node : node->GetChildrenByStartTime()) {
     ToString(child_node, str, depth + 1);
   }
 }
@@ -280,7 +328,7 @@ template <typename ScopeT>
 void ScopeNode<ScopeT>::CountNodesInSubtree(const ScopeNode* node, size_t* count) {
   ORBIT_CHECK(count != nullptr);
   ++(*count);
-  for (const auto [unused_time, child] : node->GetChildrenByStartTime()) {
+  for (const ScopeNode* child : node->GetChildrenByStartTime()) {
     CountNodesInSubtree(child, count);
   }
 }
@@ -297,18 +345,36 @@ void ScopeNode<ScopeT>::GetAllNodesInSubtree(const ScopeNode* node,
                                              std::set<const ScopeNode*>* node_set) {
   ORBIT_CHECK(node_set != nullptr);
   node_set->insert(node);
-  for (const auto [unused_time, child] : node->GetChildrenByStartTime()) {
+  for (const ScopeNode* child : node->GetChildrenByStartTime()) {
     GetAllNodesInSubtree(child, node_set);
   }
 }
 
+template <typename ScopeT>
+typename std::vector<ScopeNode<ScopeT>*>::const_iterator ScopeNode<ScopeT>::ChildrenLowerBound(
+    uint64_t time) const {
+  return std::lower_bound(
+      children_by_start_time_.begin(), children_by_start_time_.end(), time,
+      [](const ScopeNode* child, uint64_t timestamp) { return child->Start() < timestamp; });
+}
+
 template <typename ScopeT>
 ScopeNode<ScopeT>* ScopeNode<ScopeT>::GetLastChildBeforeOrAtTime(uint64_t time) const {
   // Get first child before or exactly at "time".
-  if (children_by_start_time_->empty()) return nullptr;
-  auto next_node_it = children_by_start_time_->upper_bound(time);
-  if (next_node_it == children_by_start_time_->begin()) return nullptr;
-  return (--next_node_it)->second;
+  auto next_node_it =
+      std::upper_bound(children_by_start_time_.begin(), children_by_start_time_.end(), time,
+                       [](uint64_t timestamp, const ScopeNode* child) {
+                         return timestamp < child->Start();
+                       });
+  if (next_node_it == children_by_start_time_.begin()) return nullptr;
+  return *(--next_node_it);
+}
+
+template <typename ScopeT>
+void ScopeNode<ScopeT>::AppendChild(ScopeNode* node) {
+  ORBIT_CHECK(children_by_start_time_.empty() ||
+              children_by_start_time_.back()->Start() < node->Start());
+  children_by_start_time_.push_back(node);
 }
 
 template <typename ScopeT>
@@ -328,11 +394,10 @@ template <typename ScopeT>
 std::vector<ScopeNode<ScopeT>*> ScopeNode<ScopeT>::GetChildrenInRange(uint64_t start,
                                                                       uint64_t end) const {
   // Get children that are enclosed by start and end inclusively.
-  if (children_by_start_time_->empty()) return {};
   std::vector<ScopeNode*> nodes;
-  for (auto node_it = children_by_start_time_->lower_bound(start);
-       node_it != children_by_start_time_->end(); ++node_it) {
-    ScopeNode* node = node_it->second;
+  for (auto node_it = ChildrenLowerBound(start); node_it != children_by_start_time_.end();
+       ++node_it) {
+    ScopeNode* node = *node_it;
     if (node->Start() >= start && node->End() <= end) {
       nodes.push_back(node);
     } else {
@@ -353,14 +418,22 @@ void ScopeNode<ScopeT>::Insert(ScopeNode<ScopeT>* node) {
   node->SetParent(parent_node);
 
   // Migrate current children of the parent that are encompassed by the new node to the new node.
-  for (ScopeNode* encompassed_node : parent_node->GetChildrenInRange(node->Start(), node->End())) {
-    parent_node->children_by_start_time_->erase(encompassed_node->Start());
-    node->children_by_start_time_->emplace(encompassed_node->Start(), encompassed_node);
+  // They are consecutive, and the new node takes their place among the children of the parent.
+  std::vector<ScopeNode*>& siblings = parent_node->children_by_start_time_;
+  auto first_encompassed_it = siblings.begin() + (parent_node->ChildrenLowerBound(node->Start()) -
+                                                  siblings.cbegin());
+  auto last_encompassed_it = first_encompassed_it;
+  while (last_encompassed_it != siblings.end() && (*last_encompassed_it)->End() <= node->End()) {
+    ScopeNode* encompassed_node = *last_encompassed_it;
+    node->children_by_start_time_.push_back(encompassed_node);
     encompassed_node->SetParent(node);
+    ++last_encompassed_it;
   }
+  auto insert_it = siblings.erase(first_encompassed_it, last_encompassed_it);
 
-  // Add new node as child of parent_node.
-  parent_node->children_by_start_time_->emplace(node->Start(), node);
+  // Add new node as child of parent_node, unless it has a child with the same start time.
+  if (insert_it != siblings.end() && (*insert_it)->Start() == node->Start()) return;
+  siblings.insert(insert_it, node);
 }
 
 }  // namespace orbit_containers
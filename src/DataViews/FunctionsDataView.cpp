@@ -4,7 +4,9 @@
 
 #include "DataViews/FunctionsDataView.h"
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_split.h>
@@ -15,7 +17,10 @@
 #include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <numeric>
 #include <optional>
+#include <string_view>
+#include <utility>
 
 #include "ApiInterface/Orbit.h"
 #include "ClientData/CaptureData.h"
@@ -113,57 +118,141 @@ std::string FunctionsDataView::GetValue(int row, int column) {
   }
 }
 
-#define ORBIT_FUNC_SORT(Member)                                     \
-  [&](uint64_t a, uint64_t b) {                                     \
-    return orbit_data_views_internal::CompareAscendingOrDescending( \
-        functions_[a]->Member, functions_[b]->Member, ascending);   \
+namespace {
+
+// Sorts the chunks of `elements` in parallel and then merges them, also in parallel, as long as
+// there are several chunks left to merge. Like std::stable_sort, this keeps the order of equal
+// elements.
+template <typename T, typename Less>
+void ParallelStableSort(std::vector<T>& elements, const Less& less) {
+  constexpr size_t kNumElementsPerTask = 64 * 1024;
+  const size_t size = elements.size();
+  if (size <= kNumElementsPerTask) {
+    std::stable_sort(elements.begin(), elements.end(), less);
+    return;
   }
 
-#define ORBIT_CUSTOM_FUNC_SORT(Func)                                \
-  [&](uint64_t a, uint64_t b) {                                     \
-    return orbit_data_views_internal::CompareAscendingOrDescending( \
-        Func(*functions_[a]), Func(*functions_[b]), ascending);     \
+  {
+    orbit_base::TaskGroup task_group;
+    for (size_t begin = 0; begin < size; begin += kNumElementsPerTask) {
+      task_group.AddTask([&elements, &less, begin, size]() {
+        ORBIT_SCOPE("ParallelStableSort Sort");
+        std::stable_sort(elements.begin() + begin,
+                         elements.begin() + std::min(begin + kNumElementsPerTask, size), less);
+      });
+    }
+    task_group.Wait();
   }
 
-void FunctionsDataView::DoSort() {
+  for (size_t width = kNumElementsPerTask; width < size; width *= 2) {
+    orbit_base::TaskGroup task_group;
+    for (size_t begin = 0; begin + width < size; begin += 2 * width) {
+      task_group.AddTask([&elements, &less, begin, width, size]() {
+        ORBIT_SCOPE("ParallelStableSort Merge");
+        std::inplace_merge(elements.begin() + begin, elements.begin() + begin + width,
+                           elements.begin() + std::min(begin + 2 * width, size), less);
+      });
+    }
+    task_group.Wait();
+  }
+}
+
+// Returns the rank of each of the `num_elements` values in ascending order, where equal values get
+// the same rank. `get_value` should return a reference or a cheap to copy value.
+template <typename GetValue>
+[[nodiscard]] std::vector<uint32_t> ComputeRanks(size_t num_elements, const GetValue& get_value) {
+  std::vector<uint32_t> order(num_elements);
+  std::iota(order.begin(), order.end(), 0);
+  ParallelStableSort(order, [&get_value](uint32_t lhs, uint32_t rhs) {
+    return get_value(lhs) < get_value(rhs);
+  });
+
+  std::vector<uint32_t> ranks(num_elements);
+  for (size_t i = 1; i < num_elements; ++i) {
+    const bool is_greater = get_value(order[i - 1]) < get_value(order[i]);
+    ranks[order[i]] = ranks[order[i - 1]] + (is_greater ? 1 : 0);
+  }
+  return ranks;
+}
+
+}  // namespace
+
+const std::vector<uint32_t>& FunctionsDataView::GetSortKeys(int column) {
+  auto it = sort_keys_.find(column);
+  if (it != sort_keys_.end()) return it->second;
   ORBIT_SCOPE_FUNCTION;
-  // TODO(antonrohr): This sorting function can take a lot of time when a large
-  // number of functions is used (several seconds). This function is currently
-  // executed on the main thread and therefore freezes the UI and interrupts the
-  // ssh watchdog signals that are sent to the service. Therefore this should
-  // not be called on the main thread and as soon as this is done the watchdog
-  // timeout should be rolled back from 25 seconds to 10 seconds in
-  // OrbitService.h
-  bool ascending = sorting_orders_[sorting_column_] == SortingOrder::kAscending;
-  std::function<bool(uint64_t a, uint64_t b)> sorter = nullptr;
 
-  switch (sorting_column_) {
-    case kColumnSelected:
-      sorter = ORBIT_CUSTOM_FUNC_SORT(app_->IsFunctionSelected);
-      break;
+  std::vector<uint32_t> sort_keys;
+  switch (column) {
     case kColumnName:
-      sorter = ORBIT_FUNC_SORT(pretty_name());
+      sort_keys = ComputeRanks(functions_.size(), [this](uint32_t index) -> const std::string& {
+        return functions_[index]->pretty_name();
+      });
       break;
     case kColumnSize:
-      sorter = ORBIT_FUNC_SORT(size());
+      sort_keys = ComputeRanks(functions_.size(),
+                               [this](uint32_t index) { return functions_[index]->size(); });
       break;
     case kColumnModule: {
-      auto module_name = [](const orbit_client_data::FunctionInfo& function) {
-        return std::filesystem::path(function.module_path()).filename().string();
-      };
-      sorter = ORBIT_CUSTOM_FUNC_SORT(module_name);
+      // Only compute the file name once per module, not once per function.
+      std::vector<std::string> module_file_names;
+      std::vector<uint32_t> module_file_name_indices;
+      module_file_name_indices.reserve(functions_.size());
+      absl::flat_hash_map<std::string_view, uint32_t> module_path_to_index;
+      for (const FunctionInfo* function : functions_) {
+        auto [module_it, inserted] = module_path_to_index.try_emplace(
+            function->module_path(), static_cast<uint32_t>(module_file_names.size()));
+        if (inserted) {
+          module_file_names.push_back(
+              std::filesystem::path(function->module_path()).filename().string());
+        }
+        module_file_name_indices.push_back(module_it->second);
+      }
+      sort_keys = ComputeRanks(functions_.size(), [&](uint32_t index) -> const std::string& {
+        return module_file_names[module_file_name_indices[index]];
+      });
       break;
     }
     case kColumnAddressInModule:
-      sorter = ORBIT_FUNC_SORT(address());
+      sort_keys = ComputeRanks(functions_.size(),
+                               [this](uint32_t index) { return functions_[index]->address(); });
       break;
     default:
-      break;
+      ORBIT_UNREACHABLE();
   }
+  return sort_keys_.emplace(column, std::move(sort_keys)).first->second;
+}
+
+void FunctionsDataView::DoSort() {
+  ORBIT_SCOPE_FUNCTION;
+  bool ascending = sorting_orders_[sorting_column_] == SortingOrder::kAscending;
 
-  if (sorter) {
-    std::stable_sort(indices_.begin(), indices_.end(), sorter);
+  // The selection can change at any time, so it is evaluated again on every sort, but only once
+  // per function instead of in every comparison.
+  std::vector<uint32_t> selected_keys;
+  absl::Span<const uint32_t> sort_keys;
+  switch (sorting_column_) {
+    case kColumnSelected:
+      selected_keys.resize(functions_.size());
+      for (uint64_t index : indices_) {
+        selected_keys[index] = app_->IsFunctionSelected(*functions_[index]) ? 1 : 0;
+      }
+      sort_keys = selected_keys;
+      break;
+    case kColumnName:
+    case kColumnSize:
+    case kColumnModule:
+    case kColumnAddressInModule:
+      sort_keys = GetSortKeys(sorting_column_);
+      break;
+    default:
+      return;
   }
+
+  ParallelStableSort(indices_, [sort_keys, ascending](uint64_t a, uint64_t b) {
+    return orbit_data_views_internal::CompareAscendingOrDescending(sort_keys[a], sort_keys[b],
+                                                                   ascending);
+  });
 }
 
 DataView::ActionStatus FunctionsDataView::GetActionStatus(std::string_view action,
@@ -207,32 +296,35 @@ DataView::ActionStatus FunctionsDataView::GetActionStatus(std::string_view actio
 
 void FunctionsDataView::DoFilter() {
   ORBIT_SCOPE(absl::StrFormat("FunctionsDataView::DoFilter [%u]", functions_.size()).c_str());
-  filter_tokens_ = absl::StrSplit(absl::AsciiStrToLower(filter_), ' ');
+  UpdateLowercaseNames();
+  std::string lowercase_filter = absl::AsciiStrToLower(filter_);
+  filter_tokens_ = absl::StrSplit(lowercase_filter, ' ');
+
+  // If the filter was only extended, e.g. while typing, only the previous matches need to be
+  // checked. They are sorted by index again, so that the result doesn't depend on the previous
+  // sorting.
+  std::vector<uint64_t> candidates;
+  if (previous_lowercase_filter_.has_value() &&
+      absl::StartsWith(lowercase_filter, previous_lowercase_filter_.value())) {
+    candidates = std::move(indices_);
+    std::sort(candidates.begin(), candidates.end());
+  } else {
+    candidates.resize(functions_.size());
+    std::iota(candidates.begin(), candidates.end(), 0);
+  }
 
   constexpr size_t kNumFunctionsPerTask = 1024;
-  std::vector<absl::Span<const FunctionInfo*>> chunks =
-      orbit_base::CreateChunksOfSize(functions_, kNumFunctionsPerTask);
+  std::vector<absl::Span<uint64_t>> chunks =
+      orbit_base::CreateChunksOfSize(candidates, kNumFunctionsPerTask);
   std::vector<std::vector<uint64_t>> task_results(chunks.size());
   orbit_base::TaskGroup task_group;
 
   for (size_t i = 0; i < chunks.size(); ++i) {
     task_group.AddTask([&chunk = chunks[i], &result = task_results[i], this]() {
       ORBIT_SCOPE("FunctionsDataView::DoFilter Task");
-      for (const FunctionInfo*& function : chunk) {
-        ORBIT_CHECK(function != nullptr);
-        std::string name = absl::AsciiStrToLower(function->pretty_name());
-        std::string module = absl::AsciiStrToLower(
-            std::filesystem::path(function->module_path()).filename().string());
-
-        const auto is_token_found = [&name, &module](std::string_view token) {
-          return name.find(token) != std::string::npos || module.find(token) != std::string::npos;
-        };
-
-        if (std::all_of(filter_tokens_.begin(), filter_tokens_.end(), is_token_found)) {
-          size_t function_index = &function - functions_.data();
-          ORBIT_CHECK(function_index < functions_.size());
-          result.push_back(function_index);
-        }
+      for (uint64_t function_index : chunk) {
+        ORBIT_CHECK(function_index < functions_.size());
+        if (MatchesFilterTokens(function_index)) result.push_back(function_index);
       }
     });
   }
@@ -242,12 +334,61 @@ void FunctionsDataView::DoFilter() {
   for (std::vector<uint64_t>& result : task_results) {
     indices_.insert(indices_.end(), result.begin(), result.end());
   }
+  previous_lowercase_filter_ = std::move(lowercase_filter);
+}
+
+bool FunctionsDataView::MatchesFilterTokens(size_t function_index) const {
+  const std::string_view name =
+      std::string_view{lowercase_names_}.substr(lowercase_name_offsets_[function_index],
+                                                lowercase_name_offsets_[function_index + 1] -
+                                                    lowercase_name_offsets_[function_index]);
+  const std::string& module =
+      lowercase_module_file_names_[module_file_name_indices_[function_index]];
+
+  return std::all_of(filter_tokens_.begin(), filter_tokens_.end(), [&](std::string_view token) {
+    return name.find(token) != std::string_view::npos || module.find(token) != std::string::npos;
+  });
+}
+
+void FunctionsDataView::UpdateLowercaseNames() {
+  if (!lowercase_names_outdated_) return;
+  ORBIT_SCOPE_FUNCTION;
+
+  lowercase_names_.clear();
+  lowercase_name_offsets_.clear();
+  lowercase_name_offsets_.reserve(functions_.size() + 1);
+  lowercase_module_file_names_.clear();
+  module_file_name_indices_.clear();
+  module_file_name_indices_.reserve(functions_.size());
+
+  absl::flat_hash_map<std::string_view, uint32_t> module_path_to_index;
+  for (const FunctionInfo* function : functions_) {
+    ORBIT_CHECK(function != nullptr);
+    lowercase_name_offsets_.push_back(lowercase_names_.size());
+    for (const char c : function->pretty_name()) {
+      lowercase_names_.push_back(absl::ascii_tolower(static_cast<unsigned char>(c)));
+    }
+
+    auto [it, inserted] = module_path_to_index.try_emplace(
+        function->module_path(), static_cast<uint32_t>(lowercase_module_file_names_.size()));
+    if (inserted) {
+      lowercase_module_file_names_.push_back(absl::AsciiStrToLower(
+          std::filesystem::path(function->module_path()).filename().string()));
+    }
+    module_file_name_indices_.push_back(it->second);
+  }
+  lowercase_name_offsets_.push_back(lowercase_names_.size());
+
+  lowercase_names_outdated_ = false;
+  previous_lowercase_filter_ = std::nullopt;
 }
 
 void FunctionsDataView::AddFunctions(
     std::vector<const orbit_client_data::FunctionInfo*> functions) {
   ORBIT_SCOPE_FUNCTION;
   functions_.insert(functions_.end(), functions.begin(), functions.end());
+  lowercase_names_outdated_ = true;
+  sort_keys_.clear();
 }
 
 void FunctionsDataView::RemoveFunctionsOfModule(std::string_view module_path) {
@@ -257,11 +398,15 @@ void FunctionsDataView::RemoveFunctionsOfModule(std::string_view module_path) {
                                     return function_info->module_path() == module_path;
                                   }),
                    functions_.end());
+  lowercase_names_outdated_ = true;
+  sort_keys_.clear();
 }
 
 void FunctionsDataView::ClearFunctions() {
   ORBIT_SCOPE_FUNCTION;
   functions_.clear();
+  lowercase_names_outdated_ = true;
+  sort_keys_.clear();
   OnDataChanged();
 }
 
@@ -616,6 +616,45 @@ TEST_F(FunctionsDataViewTest, ColumnSorting) {
   verify_correct_sorting();
 }
 
+TEST_F(FunctionsDataViewTest, ColumnSortingAfterFunctionsChanged) {
+  EXPECT_CALL(app_, IsFunctionSelected(testing::A<const FunctionInfo&>()))
+      .Times(testing::AnyNumber())
+      .WillRepeatedly(testing::Return(false));
+  EXPECT_CALL(app_, IsFrameTrackEnabled)
+      .Times(testing::AnyNumber())
+      .WillRepeatedly(testing::Return(false));
+  EXPECT_CALL(app_, HasCaptureData)
+      .Times(testing::AnyNumber())
+      .WillRepeatedly(testing::Return(false));
+
+  constexpr int kNameColumn = 1;
+  view_.AddFunctions({&functions_[0], &functions_[1]});
+  view_.OnSort(kNameColumn, orbit_data_views::DataView::SortingOrder::kAscending);
+  view_.OnDataChanged();
+  ASSERT_EQ(view_.GetNumElements(), 2);
+  EXPECT_EQ(view_.GetValue(0, kNameColumn), "foo()");
+  EXPECT_EQ(view_.GetValue(1, kNameColumn), "main(int, char**)");
+
+  view_.AddFunctions({&functions_[3], &functions_[4]});
+  view_.OnDataChanged();
+  ASSERT_EQ(view_.GetNumElements(), 4);
+  EXPECT_EQ(view_.GetValue(0, kNameColumn), "bar(const char*)");
+  EXPECT_EQ(view_.GetValue(1, kNameColumn), "ffind(int)");
+  EXPECT_EQ(view_.GetValue(2, kNameColumn), "foo()");
+  EXPECT_EQ(view_.GetValue(3, kNameColumn), "main(int, char**)");
+
+  view_.OnSort(kNameColumn, orbit_data_views::DataView::SortingOrder::kDescending);
+  EXPECT_EQ(view_.GetValue(0, kNameColumn), "main(int, char**)");
+  EXPECT_EQ(view_.GetValue(3, kNameColumn), "bar(const char*)");
+
+  view_.RemoveFunctionsOfModule(functions_[1].module_path());
+  view_.OnDataChanged();
+  ASSERT_EQ(view_.GetNumElements(), 3);
+  EXPECT_EQ(view_.GetValue(0, kNameColumn), "foo()");
+  EXPECT_EQ(view_.GetValue(1, kNameColumn), "ffind(int)");
+  EXPECT_EQ(view_.GetValue(2, kNameColumn), "bar(const char*)");
+}
+
 TEST_F(FunctionsDataViewTest, ContextMenuActionsCallCorrespondingFunctionsInAppInterface) {
   EXPECT_CALL(app_, IsFunctionSelected(testing::A<const FunctionInfo&>()))
       .Times(testing::AnyNumber())
@@ -800,3 +839,50 @@ TEST_F(FunctionsDataViewTest, FilteringByFunctionAndModuleName) {
   view_.OnFilter("ffindCapitalizedModule");
   EXPECT_EQ(view_.GetNumElements(), 0);
 }
+
+TEST_F(FunctionsDataViewTest, FilteringWhileTypingAndAfterFunctionsChanged) {
+  // This functionality is not tested in this test case.
+  EXPECT_CALL(app_, IsFunctionSelected(testing::A<const FunctionInfo&>()))
+      .Times(testing::AnyNumber())
+      .WillRepeatedly(testing::Return(false));
+
+  // This functionality is not tested in this test case.
+  EXPECT_CALL(app_, IsFrameTrackEnabled)
+      .Times(testing::AnyNumber())
+      .WillRepeatedly(testing::Return(false));
+
+  // This functionality is not tested in this test case.
+  EXPECT_CALL(app_, HasCaptureData)
+      .Times(testing::AnyNumber())
+      .WillRepeatedly(testing::Return(false));
+
+  view_.AddFunctions({&functions_[0], &functions_[1], &functions_[2], &functions_[3]});
+  view_.OnDataChanged();
+
+  // Extending the filter narrows down the previous result.
+  view_.OnFilter("f");
+  EXPECT_EQ(view_.GetNumElements(), 2);
+  view_.OnFilter("ff");
+  EXPECT_EQ(view_.GetNumElements(), 1);
+  EXPECT_EQ(view_.GetValue(0, 1), functions_[3].pretty_name());
+  view_.OnFilter("ff module");
+  EXPECT_EQ(view_.GetNumElements(), 1);
+
+  // Shortening the filter finds the other functions again.
+  view_.OnFilter("f");
+  EXPECT_EQ(view_.GetNumElements(), 2);
+  view_.OnFilter("");
+  EXPECT_EQ(view_.GetNumElements(), 4);
+
+  // Functions that are added later are found with the same filter.
+  view_.OnFilter("bar");
+  EXPECT_EQ(view_.GetNumElements(), 0);
+  view_.AddFunctions({&functions_[4]});
+  view_.OnDataChanged();
+  EXPECT_EQ(view_.GetNumElements(), 1);
+  EXPECT_EQ(view_.GetValue(0, 1), functions_[4].pretty_name());
+
+  view_.RemoveFunctionsOfModule(functions_[4].module_path());
+  view_.OnDataChanged();
+  EXPECT_EQ(view_.GetNumElements(), 0);
+}
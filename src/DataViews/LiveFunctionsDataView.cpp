@@ -202,7 +202,7 @@ void LiveFunctionsDataView::OnSelect(absl::Span<const int> rows) {
 }
 
 #define ORBIT_STAT_SORT(Member)                                                                    \
-  [&](ScopeId a, ScopeId b) {                                                                      \
+  [this, ascending](ScopeId a, ScopeId b) {                                                        \
     const ScopeStats& stats_a = scope_stats_collection_->GetScopeStatsOrDefault(a);                \
     const ScopeStats& stats_b = scope_stats_collection_->GetScopeStatsOrDefault(b);                \
     return orbit_data_views_internal::CompareAscendingOrDescending(stats_a.Member, stats_b.Member, \
@@ -213,6 +213,14 @@ void LiveFunctionsDataView::DoSort() {
   if (!app_->HasCaptureData()) {
     return;
   }
+
+  std::function<bool(ScopeId a, ScopeId b)> sorter = MakeSorterForSortingColumn();
+  if (sorter) {
+    std::stable_sort(indices_.begin(), indices_.end(), MakeIndexSorter(sorter));
+  }
+}
+
+std::function<bool(ScopeId, ScopeId)> LiveFunctionsDataView::MakeSorterForSortingColumn() {
   bool ascending = sorting_orders_[sorting_column_] == SortingOrder::kAscending;
   std::function<bool(ScopeId a, ScopeId b)> sorter = nullptr;
 
@@ -274,10 +282,7 @@ void LiveFunctionsDataView::DoSort() {
     default:
       break;
   }
-
-  if (sorter) {
-    std::stable_sort(indices_.begin(), indices_.end(), MakeIndexSorter(sorter));
-  }
+  return sorter;
 }
 
 DataView::ActionStatus LiveFunctionsDataView::GetActionStatus(
@@ -476,6 +481,7 @@ void LiveFunctionsDataView::DoFilter() {
 void LiveFunctionsDataView::OnDataChanged() {
   UpdateHistogramWithScopeIds({});
   indices_.clear();
+  scope_id_to_count_on_last_timer_.clear();
 
   if (!app_->HasCaptureData()) {
     DataView::OnDataChanged();
@@ -489,8 +495,8 @@ void LiveFunctionsDataView::OnDataChanged() {
   DataView::OnDataChanged();
 }
 
-void LiveFunctionsDataView::OnTimer() {
-  if (!app_->IsCapturing()) return;
+DataView::TimerUpdate LiveFunctionsDataView::OnTimer() {
+  if (!app_->IsCapturing()) return {TimerUpdate::Type::kNone, {}};
 
   const std::vector<ScopeId> missing_scope_ids = FetchMissingScopeIds();
 
@@ -499,7 +505,30 @@ void LiveFunctionsDataView::OnTimer() {
     AddScope(scope_id);
   }
 
-  OnSort(sorting_column_, {});
+  std::vector<int> changed_rows;
+  for (size_t row = 0; row < indices_.size(); ++row) {
+    const ScopeId scope_id = GetScopeId(row);
+    const uint64_t count = scope_stats_collection_->GetScopeStatsOrDefault(scope_id).count();
+    auto [it, inserted] = scope_id_to_count_on_last_timer_.try_emplace(scope_id, count);
+    if (inserted || it->second != count) {
+      it->second = count;
+      changed_rows.push_back(static_cast<int>(row));
+    }
+  }
+
+  if (!missing_scope_ids.empty()) {
+    OnSort(sorting_column_, {});
+    return {TimerUpdate::Type::kLayout, {}};
+  }
+  if (changed_rows.empty()) return {TimerUpdate::Type::kNone, {}};
+
+  // The rows only need to be sorted again if the changed stats changed their order.
+  std::function<bool(ScopeId, ScopeId)> sorter = MakeSorterForSortingColumn();
+  if (sorter && !std::is_sorted(indices_.begin(), indices_.end(), MakeIndexSorter(sorter))) {
+    OnSort(sorting_column_, {});
+    return {TimerUpdate::Type::kLayout, {}};
+  }
+  return {TimerUpdate::Type::kRowValues, std::move(changed_rows)};
 }
 
 void LiveFunctionsDataView::OnRefresh(absl::Span<const int> visible_selected_indices,
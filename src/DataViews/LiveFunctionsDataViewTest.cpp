@@ -941,4 +941,39 @@ TEST_F(LiveFunctionsDataViewTest, OnDataChangedUsesScopeStatsCollectionUpdates)
       .WillRepeatedly(Return(std::vector<ScopeId>{kScopeIds[0]}));
   view_.OnDataChanged();
   EXPECT_EQ(view_.GetRowFromScopeId(kScopeIds[0]), 0);
-}
\ No newline at end of file
+}
+TEST_F(LiveFunctionsDataViewTest, OnTimerOnlyUpdatesRowsWithChangedStats) {
+  using TimerUpdateType = orbit_data_views::DataView::TimerUpdate::Type;
+  EXPECT_CALL(app_, IsCapturing).WillRepeatedly(Return(true));
+
+  std::array<ScopeStats, kNumFunctions> scope_stats = kScopeStats;
+  auto scope_stats_collection = std::make_shared<MockScopeStatsCollection>();
+  EXPECT_CALL(*scope_stats_collection, GetAllProvidedScopeIds)
+      .WillRepeatedly(Return(std::vector<ScopeId>(kScopeIds.begin(), kScopeIds.end())));
+  for (size_t i = 0; i < kNumFunctions; ++i) {
+    EXPECT_CALL(*scope_stats_collection, GetScopeStatsOrDefault(kScopeIds[i]))
+        .WillRepeatedly(ReturnRef(scope_stats[i]));
+  }
+  view_.SetScopeStatsCollection(scope_stats_collection);
+  view_.OnSort(kColumnCount, orbit_data_views::DataView::SortingOrder::kDescending);
+
+  // The first update after the data changed covers every row.
+  view_.OnTimer();
+  EXPECT_EQ(view_.OnTimer().type, TimerUpdateType::kNone);
+
+  // This doesn't change the order of the rows.
+  scope_stats[1].set_count(kCounts[1] + 1);
+  orbit_data_views::DataView::TimerUpdate update = view_.OnTimer();
+  EXPECT_EQ(update.type, TimerUpdateType::kRowValues);
+  EXPECT_THAT(update.changed_rows, testing::ElementsAre(1));
+  EXPECT_EQ(view_.GetRowFromScopeId(kScopeIds[1]), 1);
+  EXPECT_EQ(view_.GetValue(1, kColumnCount), GetExpectedDisplayCount(kCounts[1] + 1));
+
+  // This moves the last row to the top.
+  scope_stats[2].set_count(kCounts[0] + 1);
+  update = view_.OnTimer();
+  EXPECT_EQ(update.type, TimerUpdateType::kLayout);
+  EXPECT_EQ(view_.GetRowFromScopeId(kScopeIds[2]), 0);
+  EXPECT_EQ(view_.GetRowFromScopeId(kScopeIds[0]), 1);
+  EXPECT_EQ(view_.GetRowFromScopeId(kScopeIds[1]), 2);
+}
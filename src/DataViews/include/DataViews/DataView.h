@@ -107,6 +107,21 @@ class DataView {
   };
   using ActionGroup = std::vector<Action>;
 
+  // Describes what changed on OnTimer(), so that the UI only needs to update what actually changed.
+  struct TimerUpdate {
+    enum class Type {
+      // Nothing changed.
+      kNone,
+      // Only the values in `changed_rows` changed, but not the number or the order of the rows.
+      kRowValues,
+      // Rows were added, removed or reordered.
+      kLayout,
+    };
+    Type type = Type::kLayout;
+    // Sorted, only used with Type::kRowValues.
+    std::vector<int> changed_rows;
+  };
+
   explicit DataView(DataViewType type, AppInterface* app)
       : update_period_ms_(-1), type_(type), app_{app} {}
 
@@ -152,7 +167,7 @@ class DataView {
   [[nodiscard]] virtual std::vector<int> GetVisibleSelectedIndices();
   virtual void OnDoubleClicked(int /*index*/) {}
   virtual void OnDataChanged();
-  virtual void OnTimer() {}
+  virtual TimerUpdate OnTimer() { return {}; }
   virtual bool WantsDisplayColor() { return false; }
   // TODO(irinashkviro): return a Color instead of using out-parameters
   virtual bool GetDisplayColor(int /*row*/, int /*column*/, unsigned char& /*red*/,
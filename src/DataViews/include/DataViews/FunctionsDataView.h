@@ -5,8 +5,12 @@
 #ifndef DATA_VIEWS_FUNCTIONS_DATA_VIEW_H_
 #define DATA_VIEWS_FUNCTIONS_DATA_VIEW_H_
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/types/span.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -66,7 +70,34 @@ class FunctionsDataView : public DataView {
     return functions_[indices_[row]];
   }
 
+  // Creates the lowercase names and module file names of functions_ for filtering, unless they are
+  // up to date.
+  void UpdateLowercaseNames();
+  [[nodiscard]] bool MatchesFilterTokens(size_t function_index) const;
+  // Returns a key per element of functions_ for sorting by `column`, which is any column but
+  // kColumnSelected.
+  [[nodiscard]] const std::vector<uint32_t>& GetSortKeys(int column);
+
   std::vector<const orbit_client_data::FunctionInfo*> functions_;
+
+  // The lowercase names of functions_, one after the other. The name of the function at index i
+  // starts at lowercase_name_offsets_[i] and ends at lowercase_name_offsets_[i + 1]. The module
+  // file names are only stored once per module. These are only created again when functions_
+  // changed, instead of lowercasing every function on every change of the filter.
+  bool lowercase_names_outdated_ = true;
+  std::string lowercase_names_;
+  std::vector<size_t> lowercase_name_offsets_;
+  std::vector<std::string> lowercase_module_file_names_;
+  std::vector<uint32_t> module_file_name_indices_;
+
+  // The lowercase filter that indices_ were last filtered with, if functions_ didn't change since.
+  // As long as the filter only gets longer, its matches are a subset of the previous ones.
+  std::optional<std::string> previous_lowercase_filter_;
+
+  // Per column, the rank of each element of functions_ in ascending order, with equal ranks for
+  // equal values. Sorting then only compares two integers instead of two names, in either order.
+  // These are computed on the first sort by a column after functions_ changed.
+  absl::flat_hash_map<int, std::vector<uint32_t>> sort_keys_;
 };
 
 }  // namespace orbit_data_views
@@ -54,7 +54,7 @@ class LiveFunctionsDataView : public DataView {
 
   void OnSelect(absl::Span<const int> rows) override;
   void OnDataChanged() override;
-  void OnTimer() override;
+  TimerUpdate OnTimer() override;
   void OnRefresh(absl::Span<const int> visible_selected_indices, const RefreshMode& mode) override;
   [[nodiscard]] bool ResetOnRefresh() const override { return false; }
   std::optional<int> GetRowFromScopeId(ScopeId scope_id);
@@ -147,12 +147,19 @@ class LiveFunctionsDataView : public DataView {
     };
   }
 
+  // Returns nullptr if the view can't be sorted by the current sorting column.
+  [[nodiscard]] std::function<bool(ScopeId, ScopeId)> MakeSorterForSortingColumn();
+
   [[nodiscard]] std::vector<ScopeId> FetchMissingScopeIds() const;
 
   [[nodiscard]] const orbit_client_data::ScopeInfo& GetScopeInfo(ScopeId scope_id) const;
 
   std::shared_ptr<const orbit_client_data::ScopeStatsCollectionInterface> scope_stats_collection_ =
       std::make_shared<orbit_client_data::ScopeStatsCollection>();
+
+  // The count of each scope on the last OnTimer(). Every update of the stats of a scope increases
+  // its count, so a different count means that the row of the scope needs to be updated.
+  absl::flat_hash_map<ScopeId, uint64_t> scope_id_to_count_on_last_timer_;
 };
 
 }  // namespace orbit_data_views
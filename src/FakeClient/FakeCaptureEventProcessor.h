@@ -5,8 +5,20 @@
 #ifndef FAKE_CLIENT_FAKE_CAPTURE_EVENT_PROCESSOR_H_
 #define FAKE_CLIENT_FAKE_CAPTURE_EVENT_PROCESSOR_H_
 
+#include <absl/strings/str_format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
 #include "CaptureClient/CaptureEventProcessor.h"
+#include "CaptureClient/ClientCaptureEventBatches.h"
 #include "Flags.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
 #include "OrbitBase/WriteStringToFile.h"
 
 namespace orbit_fake_client {
@@ -15,28 +27,76 @@ namespace orbit_fake_client {
 // - keeping track of their number and total size, and writing these statistics to file;
 // - keeping track of the calls to the frame boundary function, and possibly writing the average
 //   frame time to file;
+// - writing a machine-readable report of the throughput of the capture, of the records lost and of
+//   the events discarded by OrbitService, and of the end-to-end latency of the events, i.e., the
+//   time from their timestamp to their reception. The latency is only meaningful because
+//   OrbitFakeClient runs on the same machine as OrbitService, hence with the same capture clock.
 class FakeCaptureEventProcessor : public orbit_capture_client::CaptureEventProcessor {
  public:
   void ProcessEvent(const orbit_grpc_protos::ClientCaptureEvent& event) override {
+    const uint64_t receive_timestamp_ns = orbit_base::CaptureTimestampNs();
+    if (event_count_ == 0) first_receive_timestamp_ns_ = receive_timestamp_ns;
+    last_receive_timestamp_ns_ = receive_timestamp_ns;
     ++event_count_;
     byte_count_ += event.ByteSizeLong();
 
-    // Keep track of the number of calls to the frame boundary function, of the timestamp of the
-    // first call, and of the timestamp of the last call. Below, the average frame time is then
-    // naively computed as (max_timestamp - min_timestamp) / (call_count - 1).
-    if (!event.has_function_call()) {
-      return;
+    switch (event.event_case()) {
+      case orbit_grpc_protos::ClientCaptureEvent::kFunctionCall:
+        ProcessFunctionCall(event.function_call(), receive_timestamp_ns);
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kFunctionCallBatch:
+        ProcessBatch(event.function_call_batch(),
+                     [this, receive_timestamp_ns](const orbit_grpc_protos::FunctionCall& call) {
+                       ProcessFunctionCall(call, receive_timestamp_ns);
+                     });
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kSchedulingSlice:
+        ProcessEventTimestamp(event.scheduling_slice().out_timestamp_ns(), receive_timestamp_ns);
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kSchedulingSliceBatch:
+        ProcessBatch(event.scheduling_slice_batch(),
+                     [this, receive_timestamp_ns](const orbit_grpc_protos::SchedulingSlice& slice) {
+                       ProcessEventTimestamp(slice.out_timestamp_ns(), receive_timestamp_ns);
+                     });
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kCallstackSample:
+        ProcessEventTimestamp(event.callstack_sample().timestamp_ns(), receive_timestamp_ns);
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kCallstackSampleBatch:
+        ProcessBatch(
+            event.callstack_sample_batch(),
+            [this, receive_timestamp_ns](const orbit_grpc_protos::CallstackSample& sample) {
+              ProcessEventTimestamp(sample.timestamp_ns(), receive_timestamp_ns);
+            });
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kThreadStateSlice:
+        ProcessEventTimestamp(event.thread_state_slice().end_timestamp_ns(), receive_timestamp_ns);
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kThreadStateSliceBatch:
+        ProcessBatch(
+            event.thread_state_slice_batch(),
+            [this, receive_timestamp_ns](const orbit_grpc_protos::ThreadStateSlice& slice) {
+              ProcessEventTimestamp(slice.end_timestamp_ns(), receive_timestamp_ns);
+            });
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kApiScopeStop:
+        ProcessEventTimestamp(event.api_scope_stop().timestamp_ns(), receive_timestamp_ns);
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kLostPerfRecordsEvent:
+        ++lost_perf_records_event_count_;
+        lost_perf_records_duration_ns_ += event.lost_perf_records_event().duration_ns();
+        break;
+      case orbit_grpc_protos::ClientCaptureEvent::kOutOfOrderEventsDiscardedEvent:
+        ++out_of_order_events_discarded_event_count_;
+        out_of_order_events_discarded_duration_ns_ +=
+            event.out_of_order_events_discarded_event().duration_ns();
+        break;
+      default:
+        // Other events are counted, but are either too infrequent or have no single timestamp to
+        // contribute to the latency.
+        ++individual_event_count_;
+        break;
     }
-    const orbit_grpc_protos::FunctionCall& function_call = event.function_call();
-    if (function_call.function_id() != kFrameBoundaryFunctionId) {
-      return;
-    }
-    ++frame_boundary_count_;
-    uint64_t start_timestamp_ns = function_call.end_timestamp_ns() - function_call.duration_ns();
-    frame_boundary_min_timestamp_ns_ =
-        std::min(frame_boundary_min_timestamp_ns_, start_timestamp_ns);
-    frame_boundary_max_timestamp_ns_ =
-        std::max(frame_boundary_max_timestamp_ns_, start_timestamp_ns);
   }
 
   ~FakeCaptureEventProcessor() override {
@@ -72,6 +132,15 @@ class FakeCaptureEventProcessor : public orbit_capture_client::CaptureEventProce
       ORBIT_FAIL_IF(frame_time_write_result.has_error(), "Writing to \"%s\": %s",
                     kFrameTimeFilename, frame_time_write_result.error().message());
     }
+
+    {
+      std::string report = BuildReport();
+      ORBIT_LOG("Capture report: %s", report);
+      ErrorMessageOr<void> report_write_result =
+          orbit_base::WriteStringToFile(file_path / kCaptureReportFilename, report);
+      ORBIT_FAIL_IF(report_write_result.has_error(), "Writing to \"%s\": %s",
+                    kCaptureReportFilename, report_write_result.error().message());
+    }
   }
 
   // Instrument a function with this function id in order for FakeCaptureEventProcessor to use it as
@@ -79,12 +148,91 @@ class FakeCaptureEventProcessor : public orbit_capture_client::CaptureEventProce
   static constexpr uint64_t kFrameBoundaryFunctionId = std::numeric_limits<uint64_t>::max();
 
  private:
+  template <typename Batch, typename Consumer>
+  void ProcessBatch(const Batch& batch, const Consumer& consumer) {
+    ErrorMessageOr<void> result = orbit_capture_client::ForEachEventInBatch(batch, consumer);
+    if (result.has_error()) ORBIT_ERROR("%s", result.error().message());
+  }
+
+  void ProcessEventTimestamp(uint64_t event_timestamp_ns, uint64_t receive_timestamp_ns) {
+    ++individual_event_count_;
+    // Don't let an event timestamped after its reception, e.g., with TSC timestamps converted in
+    // the target, wrap around.
+    const uint64_t latency_ns = receive_timestamp_ns > event_timestamp_ns
+                                    ? receive_timestamp_ns - event_timestamp_ns
+                                    : 0;
+    latencies_ns_.push_back(latency_ns);
+  }
+
+  void ProcessFunctionCall(const orbit_grpc_protos::FunctionCall& function_call,
+                           uint64_t receive_timestamp_ns) {
+    ProcessEventTimestamp(function_call.end_timestamp_ns(), receive_timestamp_ns);
+
+    // Keep track of the number of calls to the frame boundary function, of the timestamp of the
+    // first call, and of the timestamp of the last call. Below, the average frame time is then
+    // naively computed as (max_timestamp - min_timestamp) / (call_count - 1).
+    if (function_call.function_id() != kFrameBoundaryFunctionId) {
+      return;
+    }
+    ++frame_boundary_count_;
+    uint64_t start_timestamp_ns = function_call.end_timestamp_ns() - function_call.duration_ns();
+    frame_boundary_min_timestamp_ns_ =
+        std::min(frame_boundary_min_timestamp_ns_, start_timestamp_ns);
+    frame_boundary_max_timestamp_ns_ =
+        std::max(frame_boundary_max_timestamp_ns_, start_timestamp_ns);
+  }
+
+  [[nodiscard]] std::string BuildReport() {
+    const uint64_t receive_duration_ns = last_receive_timestamp_ns_ - first_receive_timestamp_ns_;
+    const double events_per_second =
+        receive_duration_ns == 0 ? 0.0
+                                 : static_cast<double>(individual_event_count_) * 1e9 /
+                                       static_cast<double>(receive_duration_ns);
+
+    auto latency_percentile_ns = [this](double percentile) -> uint64_t {
+      if (latencies_ns_.empty()) return 0;
+      const auto index =
+          static_cast<ptrdiff_t>(percentile * static_cast<double>(latencies_ns_.size() - 1));
+      auto nth = latencies_ns_.begin() + index;
+      std::nth_element(latencies_ns_.begin(), nth, latencies_ns_.end());
+      return *nth;
+    };
+    const uint64_t latency_p50_ns = latency_percentile_ns(0.5);
+    const uint64_t latency_p99_ns = latency_percentile_ns(0.99);
+    const uint64_t latency_max_ns =
+        latencies_ns_.empty() ? 0 : *std::max_element(latencies_ns_.begin(), latencies_ns_.end());
+
+    return absl::StrFormat(
+        "{\"message_count\": %u, \"byte_count\": %u, \"event_count\": %u, "
+        "\"receive_duration_ns\": %u, \"events_per_second\": %.1f, "
+        "\"lost_perf_records_event_count\": %u, \"lost_perf_records_duration_ns\": %u, "
+        "\"out_of_order_events_discarded_event_count\": %u, "
+        "\"out_of_order_events_discarded_duration_ns\": %u, \"latency_p50_ns\": %u, "
+        "\"latency_p99_ns\": %u, \"latency_max_ns\": %u}\n",
+        event_count_, byte_count_, individual_event_count_, receive_duration_ns, events_per_second,
+        lost_perf_records_event_count_, lost_perf_records_duration_ns_,
+        out_of_order_events_discarded_event_count_, out_of_order_events_discarded_duration_ns_,
+        latency_p50_ns, latency_p99_ns, latency_max_ns);
+  }
+
   static constexpr const char* kEventCountFilename = "OrbitFakeClient.event_count.txt";
   static constexpr const char* kByteCountFilename = "OrbitFakeClient.byte_count.txt";
   static constexpr const char* kFrameTimeFilename = "OrbitFakeClient.frame_time.txt";
+  static constexpr const char* kCaptureReportFilename = "OrbitFakeClient.capture_report.json";
 
+  // `event_count_` counts the received `ClientCaptureEvent`s, while `individual_event_count_`
+  // counts the individual events they contain, i.e., it also counts each event in a batch.
   uint64_t event_count_ = 0;
   uint64_t byte_count_ = 0;
+  uint64_t individual_event_count_ = 0;
+  uint64_t first_receive_timestamp_ns_ = 0;
+  uint64_t last_receive_timestamp_ns_ = 0;
+  std::vector<uint64_t> latencies_ns_;
+
+  uint64_t lost_perf_records_event_count_ = 0;
+  uint64_t lost_perf_records_duration_ns_ = 0;
+  uint64_t out_of_order_events_discarded_event_count_ = 0;
+  uint64_t out_of_order_events_discarded_duration_ns_ = 0;
 
   uint64_t frame_boundary_count_ = 0;
   uint64_t frame_boundary_min_timestamp_ns_ = std::numeric_limits<uint64_t>::max();
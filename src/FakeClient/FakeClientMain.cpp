@@ -9,6 +9,7 @@
 #include <absl/strings/match.h>
 #include <absl/strings/numbers.h>
 #include <absl/strings/str_format.h>
+#include <absl/strings/str_split.h>
 #include <absl/time/clock.h>
 #include <absl/time/time.h>
 #include <grpcpp/grpcpp.h>
@@ -53,9 +54,11 @@
 #include "OrbitBase/File.h"
 #include "OrbitBase/Future.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
 #include "OrbitBase/ReadFileToString.h"
 #include "OrbitBase/Result.h"
 #include "OrbitBase/ThreadPool.h"
+#include "OrbitBase/WriteStringToFile.h"
 
 namespace {
 
@@ -295,6 +298,98 @@ void WaitForFileModification(std::string_view file_path) {
   ORBIT_LOG("Stopped watching \"%s\"", file_path);
 }
 
+struct ProcessResourceUsage {
+  uint64_t cpu_time_ns = 0;
+  uint64_t rss_bytes = 0;
+};
+
+// Reads the user plus system CPU time and the resident set size of a process from
+// /proc/<pid>/stat.
+std::optional<ProcessResourceUsage> ReadProcessResourceUsage(int32_t pid) {
+  ErrorMessageOr<std::string> stat_or_error =
+      orbit_base::ReadFileToString(absl::StrFormat("/proc/%d/stat", pid));
+  if (stat_or_error.has_error()) {
+    ORBIT_ERROR("%s", stat_or_error.error().message());
+    return std::nullopt;
+  }
+  // The process name in the second field can contain spaces, so skip it.
+  const std::string& stat = stat_or_error.value();
+  const size_t name_end = stat.rfind(')');
+  if (name_end == std::string::npos) return std::nullopt;
+  std::vector<std::string_view> fields =
+      absl::StrSplit(std::string_view{stat}.substr(name_end + 1), ' ', absl::SkipEmpty());
+  // Indices of utime (14), stime (15), and rss (24) of proc(5), from the state (3).
+  constexpr size_t kUtimeIndex = 11;
+  constexpr size_t kStimeIndex = 12;
+  constexpr size_t kRssIndex = 21;
+  uint64_t utime_ticks = 0;
+  uint64_t stime_ticks = 0;
+  uint64_t rss_pages = 0;
+  if (fields.size() <= kRssIndex || !absl::SimpleAtoi(fields[kUtimeIndex], &utime_ticks) ||
+      !absl::SimpleAtoi(fields[kStimeIndex], &stime_ticks) ||
+      !absl::SimpleAtoi(fields[kRssIndex], &rss_pages)) {
+    ORBIT_ERROR("Unable to parse /proc/%d/stat", pid);
+    return std::nullopt;
+  }
+
+  static const uint64_t kTicksPerSecond = sysconf(_SC_CLK_TCK);
+  static const uint64_t kPageSize = sysconf(_SC_PAGESIZE);
+  return ProcessResourceUsage{(utime_ticks + stime_ticks) * 1'000'000'000 / kTicksPerSecond,
+                              rss_pages * kPageSize};
+}
+
+// Samples the CPU time and the RSS of OrbitService while capturing, including while the capture is
+// being finalized, to write them to file when the capture is done. As OrbitService could already
+// have been running for a while, the CPU time is reported relative to the start of the capture.
+class ServiceResourceUsageSampler {
+ public:
+  explicit ServiceResourceUsageSampler(int32_t service_pid) : service_pid_{service_pid} {
+    if (service_pid_ == 0) return;
+    start_timestamp_ns_ = orbit_base::CaptureTimestampNs();
+    std::optional<ProcessResourceUsage> usage = ReadProcessResourceUsage(service_pid_);
+    if (usage.has_value()) start_cpu_time_ns_ = usage->cpu_time_ns;
+  }
+
+  void Sample() {
+    if (service_pid_ == 0) return;
+    std::optional<ProcessResourceUsage> usage = ReadProcessResourceUsage(service_pid_);
+    if (!usage.has_value()) return;
+    last_cpu_time_ns_ = usage->cpu_time_ns;
+    max_rss_bytes_ = std::max(max_rss_bytes_, usage->rss_bytes);
+    rss_bytes_sum_ += usage->rss_bytes;
+    ++sample_count_;
+  }
+
+  void WriteReport() const {
+    if (service_pid_ == 0 || sample_count_ == 0) return;
+    const uint64_t wall_time_ns = orbit_base::CaptureTimestampNs() - start_timestamp_ns_;
+    const uint64_t cpu_time_ns = last_cpu_time_ns_ - start_cpu_time_ns_;
+    std::string report = absl::StrFormat(
+        "{\"service_wall_time_ns\": %u, \"service_cpu_time_ns\": %u, "
+        "\"service_cpu_utilization\": %.3f, \"service_rss_avg_bytes\": %u, "
+        "\"service_rss_max_bytes\": %u}\n",
+        wall_time_ns, cpu_time_ns,
+        static_cast<double>(cpu_time_ns) / static_cast<double>(wall_time_ns),
+        rss_bytes_sum_ / sample_count_, max_rss_bytes_);
+    ORBIT_LOG("OrbitService report: %s", report);
+
+    static constexpr const char* kServiceReportFilename = "OrbitFakeClient.service_report.json";
+    ErrorMessageOr<void> write_result = orbit_base::WriteStringToFile(
+        std::filesystem::path{absl::GetFlag(FLAGS_output_path)} / kServiceReportFilename, report);
+    ORBIT_FAIL_IF(write_result.has_error(), "Writing to \"%s\": %s", kServiceReportFilename,
+                  write_result.error().message());
+  }
+
+ private:
+  int32_t service_pid_;
+  uint64_t start_timestamp_ns_ = 0;
+  uint64_t start_cpu_time_ns_ = 0;
+  uint64_t last_cpu_time_ns_ = 0;
+  uint64_t max_rss_bytes_ = 0;
+  uint64_t rss_bytes_sum_ = 0;
+  uint64_t sample_count_ = 0;
+};
+
 }  // namespace
 
 // OrbitFakeClient is a simple command line client that connects to a local instance of
@@ -304,7 +399,9 @@ void WaitForFileModification(std::string_view file_path) {
 // with various capture options.
 // In general, received events are mostly discarded. Only minimal processing is applied to report
 // some basic metrics, such as event count and their total size, and average frame time of the
-// target process. See FakeCaptureEventProcessor.
+// target process. See FakeCaptureEventProcessor. With --service_pid, the CPU time and the RSS of
+// OrbitService during the capture are reported, too. contrib/scripts/run_capture_benchmark.py runs
+// it against OrbitTest with a sweep of configurations.
 int main(int argc, char* argv[]) {
   absl::SetProgramUsageMessage("Orbit fake client for testing");
   absl::ParseCommandLine(argc, argv);
@@ -331,11 +428,16 @@ int main(int argc, char* argv[]) {
   options.samples_per_second = absl::GetFlag(FLAGS_sampling_rate);
   ORBIT_LOG("samples_per_second=%.0f", options.samples_per_second);
   options.stack_dump_size = 65000;
-  options.unwinding_method =
-      absl::GetFlag(FLAGS_frame_pointers) ? CaptureOptions::kFramePointers : CaptureOptions::kDwarf;
-  ORBIT_LOG("unwinding_method=%s", options.unwinding_method == CaptureOptions::kFramePointers
-                                       ? "Frame pointers"
-                                       : "DWARF");
+  if (absl::GetFlag(FLAGS_lbr_callstacks)) {
+    options.unwinding_method = CaptureOptions::kLastBranchRecords;
+    ORBIT_LOG("unwinding_method=LBR");
+  } else {
+    options.unwinding_method = absl::GetFlag(FLAGS_frame_pointers) ? CaptureOptions::kFramePointers
+                                                                   : CaptureOptions::kDwarf;
+    ORBIT_LOG("unwinding_method=%s", options.unwinding_method == CaptureOptions::kFramePointers
+                                         ? "Frame pointers"
+                                         : "DWARF");
+  }
 
   std::string file_path = absl::GetFlag(FLAGS_instrument_path);
   uint64_t file_offset = absl::GetFlag(FLAGS_instrument_offset);
@@ -377,6 +479,31 @@ int main(int argc, char* argv[]) {
     options.memory_sampling_period_ms = 1'000 / absl::GetFlag(FLAGS_memory_sampling_rate);
     ORBIT_LOG("memory_sampling_period_ms=%u", options.memory_sampling_period_ms);
   }
+  options.page_fault_sampling_period = absl::GetFlag(FLAGS_page_fault_sampling_period);
+  ORBIT_LOG("page_fault_sampling_period=%u", options.page_fault_sampling_period);
+  options.pressure_stall_threshold_ms = absl::GetFlag(FLAGS_pressure_stall_threshold_ms);
+  options.pressure_stall_window_ms = absl::GetFlag(FLAGS_pressure_stall_window_ms);
+  ORBIT_LOG("pressure_stall_threshold_ms=%u", options.pressure_stall_threshold_ms);
+  options.sample_performance_counters = absl::GetFlag(FLAGS_sample_performance_counters);
+  ORBIT_LOG("sample_performance_counters=%d", options.sample_performance_counters);
+  options.use_ring_buffer_wakeups = absl::GetFlag(FLAGS_ring_buffer_wakeups);
+  ORBIT_LOG("use_ring_buffer_wakeups=%d", options.use_ring_buffer_wakeups);
+  options.ring_buffer_reader_thread_count = absl::GetFlag(FLAGS_ring_buffer_reader_threads);
+  ORBIT_LOG("ring_buffer_reader_thread_count=%u", options.ring_buffer_reader_thread_count);
+  options.unwinding_thread_count = absl::GetFlag(FLAGS_unwinding_threads);
+  ORBIT_LOG("unwinding_thread_count=%u", options.unwinding_thread_count);
+  options.flight_recorder_duration_ms = absl::GetFlag(FLAGS_flight_recorder_ms);
+  ORBIT_LOG("flight_recorder_duration_ms=%u", options.flight_recorder_duration_ms);
+  options.perf_record_dump_path = absl::GetFlag(FLAGS_perf_record_dump_path);
+  ORBIT_LOG("perf_record_dump_path=\"%s\"", options.perf_record_dump_path);
+  options.capture_file_path_on_target = absl::GetFlag(FLAGS_capture_file_path_on_target);
+  ORBIT_LOG("capture_file_path_on_target=\"%s\"", options.capture_file_path_on_target);
+  options.record_one_in_n_calls = absl::GetFlag(FLAGS_record_one_in_n_calls);
+  ORBIT_LOG("record_one_in_n_calls=%u", options.record_one_in_n_calls);
+  options.min_function_call_duration_ns = absl::GetFlag(FLAGS_min_function_call_duration_ns);
+  ORBIT_LOG("min_function_call_duration_ns=%u", options.min_function_call_duration_ns);
+  options.use_tsc_timestamps = absl::GetFlag(FLAGS_tsc_timestamps);
+  ORBIT_LOG("use_tsc_timestamps=%d", options.use_tsc_timestamps);
 
   uint32_t grpc_port = absl::GetFlag(FLAGS_port);
   std::string service_address = absl::StrFormat("127.0.0.1:%d", grpc_port);
@@ -459,6 +586,10 @@ int main(int argc, char* argv[]) {
       ORBIT_UNREACHABLE();
   }
 
+  const int32_t service_pid = absl::GetFlag(FLAGS_service_pid);
+  ORBIT_LOG("service_pid=%d", service_pid);
+  ServiceResourceUsageSampler service_resource_usage_sampler{service_pid};
+
   auto capture_outcome_future = capture_client.Capture(
       thread_pool.get(), std::move(capture_event_processor), module_manager, process_data, options);
   ORBIT_LOG("Asked to start capture");
@@ -467,10 +598,18 @@ int main(int argc, char* argv[]) {
   while (!exit_requested && absl::Now() < start_time + absl::Seconds(duration_s)) {
     std::this_thread::sleep_for(std::chrono::milliseconds{100});
     ORBIT_CHECK(!capture_outcome_future.IsFinished());
+    service_resource_usage_sampler.Sample();
   }
   ORBIT_CHECK(capture_client.StopCapture());
   ORBIT_LOG("Asked to stop capture");
 
+  while (!capture_outcome_future.IsFinished()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    service_resource_usage_sampler.Sample();
+  }
+  service_resource_usage_sampler.Sample();
+  service_resource_usage_sampler.WriteReport();
+
   auto capture_outcome_or_error = capture_outcome_future.Get();
   if (capture_outcome_or_error.has_error()) {
     ORBIT_FATAL("Capture failed: %s", capture_outcome_or_error.error().message());
@@ -42,6 +42,9 @@ ABSL_FLAG(uint32_t, duration, std::numeric_limits<uint32_t>::max(),
 ABSL_FLAG(uint16_t, sampling_rate, 1000,
           "Callstack sampling rate in samples per second (0: no sampling)");
 ABSL_FLAG(bool, frame_pointers, false, "Use frame pointers for unwinding");
+ABSL_FLAG(bool, lbr_callstacks, false,
+          "Sample callstacks with the Last Branch Record facility of Intel CPUs, instead of "
+          "unwinding them");
 ABSL_FLAG(std::string, instrument_path, "", "Path of the binary of the function to instrument");
 ABSL_FLAG(std::string, instrument_name, "", "Name of the function to instrument");
 ABSL_FLAG(uint64_t, instrument_offset, 0, "Offset in the binary of the function to instrument");
@@ -55,10 +58,43 @@ ABSL_FLAG(bool, gpu_jobs, true, "Collect GPU jobs");
 ABSL_FLAG(bool, orbit_api, false, "Enable Orbit API");
 ABSL_FLAG(uint16_t, memory_sampling_rate, 0,
           "Memory usage sampling rate in samples per second (0: no sampling)");
+ABSL_FLAG(uint64_t, page_fault_sampling_period, 0,
+          "Record the callstack of one in every this many minor page faults (0: no sampling)");
+ABSL_FLAG(uint64_t, pressure_stall_threshold_ms, 0,
+          "Threshold of the PSI triggers on the CPU, memory and IO pressure (0: no triggers)");
+ABSL_FLAG(uint64_t, pressure_stall_window_ms, 1000, "Window of the PSI triggers");
+ABSL_FLAG(bool, sample_performance_counters, false,
+          "Sample hardware performance counters at the callstack sampling rate");
 ABSL_FLAG(bool, frame_time, true, "Instrument vkQueuePresentKHR to compute avg. frame time");
+ABSL_FLAG(bool, ring_buffer_wakeups, false,
+          "Block on perf_event_open ring buffer wakeups instead of polling them");
+ABSL_FLAG(uint32_t, ring_buffer_reader_threads, 1,
+          "Number of threads reading the perf_event_open ring buffers");
+ABSL_FLAG(uint32_t, unwinding_threads, 0,
+          "Number of threads unwinding stack samples (0: unwind on the event processing thread)");
+ABSL_FLAG(uint64_t, flight_recorder_ms, 0,
+          "Only keep the events of the last this many milliseconds before the capture is stopped, "
+          "overwriting older ones in the ring buffers (0: disabled)");
+ABSL_FLAG(std::string, perf_record_dump_path, "",
+          "Also write the records read from the perf_event_open ring buffers to this file on the "
+          "target, to be replayed with PerfRecordDumpReplay");
+ABSL_FLAG(std::string, capture_file_path_on_target, "",
+          "Let OrbitService write the capture to this file on the target and only stream a "
+          "preview of it");
+ABSL_FLAG(uint32_t, record_one_in_n_calls, 0,
+          "Only record every this many calls of the instrumented function on each thread "
+          "(0: record all calls)");
+ABSL_FLAG(uint64_t, min_function_call_duration_ns, 0,
+          "Drop calls of the instrumented function shorter than this many nanoseconds");
+ABSL_FLAG(bool, tsc_timestamps, false,
+          "Take TSC timestamps in user space instrumentation and the Orbit API, converted to "
+          "capture timestamps by the producers in the target");
 ABSL_FLAG(EventProcessorType, event_processor, EventProcessorType::kFake, "");
 ABSL_FLAG(std::string, pid_file_path, "",
           "Path of the file to watch that will contain the target PID (the file must exists)");
 ABSL_FLAG(std::string, output_path, "", "Path of the output files");
+ABSL_FLAG(int32_t, service_pid, 0,
+          "PID of OrbitService, to also report its CPU time and RSS during the capture (0: don't "
+          "report)");
 
 #endif  // FAKE_CLIENT_FLAGS_H_
\ No newline at end of file
@@ -10,7 +10,9 @@
 #include <cstdint>
 
 #include "CaptureClient/CaptureEventProcessor.h"
+#include "CaptureClient/ClientCaptureEventBatches.h"
 #include "Flags.h"
+#include "OrbitBase/Logging.h"
 #include "OrbitBase/WriteStringToFile.h"
 
 namespace orbit_fake_client {
@@ -75,6 +77,17 @@ class GraphicsCaptureEventProcessor : public orbit_capture_client::CaptureEventP
       case orbit_grpc_protos::ClientCaptureEvent::kFunctionCall:
         ProcessFunctionCall(event.function_call());
         break;
+      case orbit_grpc_protos::ClientCaptureEvent::kFunctionCallBatch: {
+        ErrorMessageOr<void> result = orbit_capture_client::ForEachEventInBatch(
+            event.function_call_batch(),
+            [this](const orbit_grpc_protos::FunctionCall& function_call) {
+              ProcessFunctionCall(function_call);
+            });
+        if (result.has_error()) {
+          ORBIT_ERROR("Processing FunctionCallBatch: %s", result.error().message());
+        }
+        break;
+      }
       case orbit_grpc_protos::ClientCaptureEvent::kGpuQueueSubmission:
         ProcessGpuQueueSubmission(event.gpu_queue_submission());
         break;
@@ -54,6 +54,9 @@ class FakeProducerSideService : public orbit_grpc_protos::ProducerSideService::S
         case orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest::kAllEventsSent:
           OnAllEventsSentReceived();
           break;
+        case orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest::kSharedMemoryBufferCreated:
+          OnSharedMemoryBufferCreatedReceived(request.shared_memory_buffer_created().name());
+          break;
         case orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest::EVENT_NOT_SET:
           break;
       }
@@ -116,6 +119,7 @@ class FakeProducerSideService : public orbit_grpc_protos::ProducerSideService::S
   MOCK_METHOD(void, OnCaptureEventsReceived,
               (absl::Span<const orbit_grpc_protos::ProducerCaptureEvent> events), ());
   MOCK_METHOD(void, OnAllEventsSentReceived, (), ());
+  MOCK_METHOD(void, OnSharedMemoryBufferCreatedReceived, (const std::string& name), ());
 
  private:
   grpc::ServerContext* context_ ABSL_GUARDED_BY(context_and_stream_mutex_) = nullptr;
@@ -21,6 +21,10 @@ constexpr uint64_t kIntrospectionProducerId = 3;
 constexpr uint64_t kWindowsTracingProducerId = 4;
 constexpr uint64_t kExternalProducerStartingId = 1024;
 
+// OrbitService considers the client to be behind in processing the capture when the client reports
+// a ClientCaptureBacklog above this.
+constexpr uint64_t kClientCaptureBacklogThresholdBytes = 8 * 1024 * 1024;
+
 }  // namespace orbit_grpc_protos
 
 #endif  // GRPC_PROTOS_CONSTANTS_H_
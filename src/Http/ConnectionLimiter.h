@@ -0,0 +1,49 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef HTTP_CONNECTION_LIMITER_H_
+#define HTTP_CONNECTION_LIMITER_H_
+
+#include <stddef.h>
+
+#include <QObject>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_http {
+
+// Caps the number of requests that the downloads of a HttpDownloadManager have in flight at the
+// same time. A download that doesn't get a connection waits for `Released` and tries again. It is
+// only used on the thread of the HttpDownloadManager, so it needs no synchronization.
+class ConnectionLimiter : public QObject {
+  Q_OBJECT
+ public:
+  explicit ConnectionLimiter(size_t max_connections, QObject* parent = nullptr)
+      : QObject(parent), max_connections_(max_connections) {
+    ORBIT_CHECK(max_connections > 0);
+  }
+
+  [[nodiscard]] bool TryAcquire() {
+    if (connections_ == max_connections_) return false;
+    ++connections_;
+    return true;
+  }
+
+  void Release() {
+    ORBIT_CHECK(connections_ > 0);
+    --connections_;
+    emit Released();
+  }
+
+ signals:
+  void Released();
+
+ private:
+  size_t max_connections_;
+  size_t connections_ = 0;
+};
+
+}  // namespace orbit_http
+
+#endif  // HTTP_CONNECTION_LIMITER_H_
@@ -5,10 +5,12 @@
 #include "Http/HttpDownloadManager.h"
 
 #include <QList>
+#include <memory>
 #include <optional>
 #include <type_traits>
 #include <utility>
 
+#include "ConnectionLimiter.h"
 #include "HttpDownloadOperation.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Promise.h"
@@ -20,6 +22,10 @@ using orbit_base::NotFoundOr;
 using orbit_base::Promise;
 using orbit_base::StopToken;
 
+HttpDownloadManager::HttpDownloadManager(QObject* parent)
+    : QObject(parent),
+      connection_limiter_(std::make_unique<ConnectionLimiter>(kMaxConcurrentConnections)) {}
+
 HttpDownloadManager::~HttpDownloadManager() {
   for (const auto& download_operation : findChildren<HttpDownloadOperation*>()) {
     download_operation->Abort();
@@ -31,8 +37,9 @@ Future<ErrorMessageOr<CanceledOr<NotFoundOr<void>>>> HttpDownloadManager::Downlo
   Promise<ErrorMessageOr<CanceledOr<NotFoundOr<void>>>> promise;
   auto future = promise.GetFuture();
 
-  auto current_download_operation = new HttpDownloadOperation{
-      std::move(url), std::move(save_file_path), std::move(stop_token), &manager_, this};
+  auto current_download_operation =
+      new HttpDownloadOperation(std::move(url), std::move(save_file_path), std::move(stop_token),
+                                &manager_, connection_limiter_.get(), this);
 
   auto finish_handler = [current_download_operation, promise = std::move(promise)](
                             HttpDownloadOperation::State state,
@@ -6,11 +6,15 @@
 
 #include <absl/strings/str_format.h>
 
+#include <QByteArray>
 #include <QIODevice>
 #include <QMetaObject>
 #include <QNetworkRequest>
 #include <QUrl>
+#include <QVariant>
 #include <algorithm>
+#include <string_view>
+#include <vector>
 
 #include "OrbitBase/Future.h"
 #include "OrbitBase/ImmediateExecutor.h"
@@ -18,6 +22,26 @@
 
 namespace orbit_http {
 
+namespace {
+
+constexpr int kHttpStatusOk = 200;
+constexpr int kHttpStatusPartialContent = 206;
+
+[[nodiscard]] QNetworkRequest CreateRequest(const QUrl& url) {
+  QNetworkRequest request(url);
+  request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                       QNetworkRequest::NoLessSafeRedirectPolicy);
+  constexpr const int kMaximumAllowedRedirects = 10;
+  request.setMaximumRedirectsAllowed(kMaximumAllowedRedirects);
+  return request;
+}
+
+[[nodiscard]] int GetHttpStatusCode(const QNetworkReply* reply) {
+  return reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+}
+
+}  // namespace
+
 void HttpDownloadOperation::UpdateState(State state, std::optional<std::string> maybe_error_msg) {
   ORBIT_CHECK((state == State::kError) == maybe_error_msg.has_value());
   state_ = state;
@@ -50,9 +74,26 @@ void HttpDownloadOperation::UpdateState(State state, std::optional<std::string>
   }
 }
 
+void HttpDownloadOperation::OnConnectionReleased() {
+  if (state_ != State::kStarted) return;
+
+  switch (mode_) {
+    case Mode::kWaitingForConnection:
+      TrySendRequest();
+      break;
+    case Mode::kSingleRequest:
+      break;
+    case Mode::kRangeRequests:
+      SendRangeRequests();
+      MaybeFinishRangeRequests();
+      break;
+  }
+}
+
 void HttpDownloadOperation::OnDownloadFinished() {
   output_.write(reply_->readAll());
   output_.close();
+  connection_limiter_->Release();
 
   if (!reply_->error()) {
     UpdateState(State::kDone, std::nullopt);
@@ -74,6 +115,26 @@ void HttpDownloadOperation::OnDownloadFinished() {
 
 void HttpDownloadOperation::OnDownloadReadyRead() { output_.write(reply_->readAll()); }
 
+void HttpDownloadOperation::OnDownloadMetaDataChanged() {
+  if (state_ != State::kStarted || mode_ != Mode::kSingleRequest || !reply_) return;
+
+  // Also emitted for the responses that redirect, which are skipped by the status code.
+  if (GetHttpStatusCode(reply_) != kHttpStatusOk) return;
+  if (reply_->rawHeader("Accept-Ranges").trimmed().toLower() != "bytes") return;
+  // Ranges refer to the encoded content, which QNetworkReply decodes transparently.
+  if (!reply_->rawHeader("Content-Encoding").isEmpty()) return;
+
+  bool has_file_size = false;
+  const uint64_t file_size =
+      reply_->header(QNetworkRequest::ContentLengthHeader).toULongLong(&has_file_size);
+  if (!has_file_size || file_size < kMinFileSizeForRangeRequests) return;
+
+  std::string validator = reply_->rawHeader("ETag").toStdString();
+  if (validator.empty()) validator = reply_->rawHeader("Last-Modified").toStdString();
+
+  SwitchToRangeRequests(file_size, std::move(validator));
+}
+
 void HttpDownloadOperation::Start() {
   ORBIT_CHECK(state_ == State::kInitial);
 
@@ -84,16 +145,10 @@ void HttpDownloadOperation::Start() {
     return;
   }
 
-  QNetworkRequest request(QUrl(QString::fromStdString(url_)));
-  request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
-                       QNetworkRequest::NoLessSafeRedirectPolicy);
-  constexpr const int kMaximumAllowedRedirects = 10;
-  request.setMaximumRedirectsAllowed(kMaximumAllowedRedirects);
-
-  reply_ = manager_->get(request);
-  connect(reply_, &QNetworkReply::finished, this, &HttpDownloadOperation::OnDownloadFinished);
-  connect(reply_, &QNetworkReply::readyRead, this, &HttpDownloadOperation::OnDownloadReadyRead);
+  connect(connection_limiter_, &ConnectionLimiter::Released, this,
+          &HttpDownloadOperation::OnConnectionReleased);
   UpdateState(State::kStarted, std::nullopt);
+  TrySendRequest();
 
   orbit_base::ImmediateExecutor executor{};
   stop_token_.GetFuture().Then(&executor, [download = QPointer<HttpDownloadOperation>{this}]() {
@@ -103,7 +158,194 @@ void HttpDownloadOperation::Start() {
 }
 
 void HttpDownloadOperation::Abort() {
-  if (reply_) reply_->abort();
+  if (state_ != State::kStarted) return;
+
+  switch (mode_) {
+    case Mode::kWaitingForConnection:
+      output_.close();
+      output_.remove();
+      UpdateState(State::kCancelled, std::nullopt);
+      deleteLater();
+      break;
+    case Mode::kSingleRequest:
+      if (reply_) reply_->abort();
+      break;
+    case Mode::kRangeRequests:
+      range_requests_aborted_ = true;
+      AbortRangeRequests();
+      MaybeFinishRangeRequests();
+      break;
+  }
+}
+
+void HttpDownloadOperation::TrySendRequest() {
+  ORBIT_CHECK(mode_ == Mode::kWaitingForConnection);
+  if (!connection_limiter_->TryAcquire()) return;
+  mode_ = Mode::kSingleRequest;
+
+  reply_ = manager_->get(CreateRequest(QUrl(QString::fromStdString(url_))));
+  connect(reply_, &QNetworkReply::finished, this, &HttpDownloadOperation::OnDownloadFinished);
+  connect(reply_, &QNetworkReply::readyRead, this, &HttpDownloadOperation::OnDownloadReadyRead);
+  connect(reply_, &QNetworkReply::metaDataChanged, this,
+          &HttpDownloadOperation::OnDownloadMetaDataChanged);
+}
+
+void HttpDownloadOperation::SwitchToRangeRequests(uint64_t file_size, std::string validator) {
+  ORBIT_LOG("Downloading %s (%u bytes) with range requests", url_, file_size);
+  // After redirects, this is where the file actually is.
+  range_request_url_ = reply_->url();
+  disconnect(reply_, nullptr, this, nullptr);
+  reply_->abort();
+  reply_->deleteLater();
+  reply_ = nullptr;
+  output_.close();
+  output_.remove();
+  mode_ = Mode::kRangeRequests;
+
+  ErrorMessageOr<PartialDownload> partial_download_or_error =
+      PartialDownload::OpenOrCreate(save_file_path_, file_size, std::move(validator));
+  if (partial_download_or_error.has_error()) {
+    UpdateState(State::kError, absl::StrFormat("Failed to open save file: %s\n",
+                                               partial_download_or_error.error().message()));
+    connection_limiter_->Release();
+    deleteLater();
+    return;
+  }
+  partial_download_.emplace(std::move(partial_download_or_error.value()));
+
+  // Only released now, as releasing can already send the range requests of this download.
+  connection_limiter_->Release();
+  SendRangeRequests();
+  MaybeFinishRangeRequests();
+}
+
+void HttpDownloadOperation::SendRangeRequests() {
+  if (state_ != State::kStarted || range_requests_error_.has_value() || range_requests_aborted_) {
+    return;
+  }
+  ORBIT_CHECK(partial_download_.has_value());
+
+  while (range_requests_.size() < kMaxRangeRequestsPerDownload &&
+         partial_download_->HasPendingChunks() && connection_limiter_->TryAcquire()) {
+    const size_t chunk_index = partial_download_->TakeNextPendingChunk().value();
+    const auto [begin, end] = partial_download_->GetChunkRange(chunk_index);
+
+    QNetworkRequest request = CreateRequest(range_request_url_);
+    request.setRawHeader("Range",
+                         QByteArray::fromStdString(absl::StrFormat("bytes=%u-%u", begin, end - 1)));
+    request.setRawHeader("Accept-Encoding", "identity");
+
+    QNetworkReply* reply = manager_->get(request);
+    range_requests_.emplace(reply, RangeRequest{chunk_index, begin, end});
+    connect(reply, &QNetworkReply::readyRead, this,
+            [this, reply]() { OnRangeRequestReadyRead(reply); });
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply]() { OnRangeRequestFinished(reply); });
+  }
+}
+
+ErrorMessageOr<void> HttpDownloadOperation::WriteRangeRequestData(QNetworkReply* reply) {
+  auto it = range_requests_.find(reply);
+  ORBIT_CHECK(it != range_requests_.end());
+  RangeRequest& range_request = it->second;
+
+  if (GetHttpStatusCode(reply) != kHttpStatusPartialContent) {
+    return ErrorMessage{absl::StrFormat("Expected a partial response, got status %d.",
+                                        GetHttpStatusCode(reply))};
+  }
+  const QByteArray data = reply->readAll();
+  if (static_cast<uint64_t>(data.size()) >
+      range_request.end_offset - range_request.next_offset) {
+    return ErrorMessage{"Received more data than requested."};
+  }
+  OUTCOME_TRY(partial_download_->Write(range_request.next_offset,
+                                       std::string_view{data.constData(),
+                                                        static_cast<size_t>(data.size())}));
+  range_request.next_offset += static_cast<uint64_t>(data.size());
+  return outcome::success();
+}
+
+void HttpDownloadOperation::OnRangeRequestReadyRead(QNetworkReply* reply) {
+  if (range_requests_error_.has_value() || range_requests_aborted_) return;
+  if (!range_requests_.contains(reply)) return;
+
+  ErrorMessageOr<void> result = WriteRangeRequestData(reply);
+  if (result.has_error()) FailRangeRequests(result.error().message());
+}
+
+ErrorMessageOr<void> HttpDownloadOperation::CompleteRangeRequest(QNetworkReply* reply) {
+  if (reply->error() != QNetworkReply::NoError) {
+    return ErrorMessage{
+        absl::StrFormat("Failed to download: %s\n", reply->errorString().toStdString())};
+  }
+  OUTCOME_TRY(WriteRangeRequestData(reply));
+  const RangeRequest& range_request = range_requests_.at(reply);
+  if (range_request.next_offset != range_request.end_offset) {
+    return ErrorMessage{"The response ended before the requested range was complete."};
+  }
+  return partial_download_->CompleteChunk(range_request.chunk_index);
+}
+
+void HttpDownloadOperation::OnRangeRequestFinished(QNetworkReply* reply) {
+  if (!range_requests_.contains(reply)) return;
+
+  if (!range_requests_error_.has_value() && !range_requests_aborted_) {
+    ErrorMessageOr<void> result = CompleteRangeRequest(reply);
+    if (result.has_error()) range_requests_error_ = result.error().message();
+  }
+
+  range_requests_.erase(reply);
+  reply->deleteLater();
+  if (range_requests_error_.has_value()) AbortRangeRequests();
+  connection_limiter_->Release();
+
+  SendRangeRequests();
+  MaybeFinishRangeRequests();
+}
+
+void HttpDownloadOperation::FailRangeRequests(std::string error_message) {
+  range_requests_error_ = std::move(error_message);
+  AbortRangeRequests();
+  MaybeFinishRangeRequests();
+}
+
+void HttpDownloadOperation::AbortRangeRequests() {
+  // Aborting a reply runs OnRangeRequestFinished, which removes it from `range_requests_`.
+  std::vector<QPointer<QNetworkReply>> replies;
+  for (const auto& [reply, unused_range_request] : range_requests_) replies.emplace_back(reply);
+  for (const QPointer<QNetworkReply>& reply : replies) {
+    if (reply) reply->abort();
+  }
+}
+
+void HttpDownloadOperation::MaybeFinishRangeRequests() {
+  if (state_ != State::kStarted || !range_requests_.empty()) return;
+
+  // The completed chunks stay in the partial download, so that the next download resumes there.
+  if (range_requests_aborted_) {
+    partial_download_.reset();
+    UpdateState(State::kCancelled, std::nullopt);
+    deleteLater();
+    return;
+  }
+  if (range_requests_error_.has_value()) {
+    partial_download_.reset();
+    UpdateState(State::kError, range_requests_error_);
+    deleteLater();
+    return;
+  }
+  // Otherwise, the remaining chunks wait for connections.
+  if (!partial_download_->IsComplete()) return;
+
+  ErrorMessageOr<void> result = partial_download_->Finish();
+  partial_download_.reset();
+  if (result.has_error()) {
+    UpdateState(State::kError, absl::StrFormat("Failed to save the downloaded file: %s",
+                                               result.error().message()));
+  } else {
+    UpdateState(State::kDone, std::nullopt);
+  }
+  deleteLater();
 }
 
 }  // namespace orbit_http
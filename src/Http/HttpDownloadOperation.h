@@ -5,32 +5,50 @@
 #ifndef HTTP_HTTP_DOWNLOAD_OPERATION_H
 #define HTTP_HTTP_DOWNLOAD_OPERATION_H
 
+#include <absl/container/flat_hash_map.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include <QFile>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
 #include <QPointer>
 #include <QString>
+#include <QUrl>
 #include <filesystem>
 #include <optional>
 #include <string>
 #include <utility>
 
+#include "ConnectionLimiter.h"
+#include "OrbitBase/Result.h"
 #include "OrbitBase/StopToken.h"
+#include "PartialDownload.h"
 
 namespace orbit_http {
 
+// Downloads a file with a single request, unless the server announces that it supports range
+// requests for a file of at least kMinFileSizeForRangeRequests. Then the first request is dropped
+// after its headers arrived, and the file is fetched in chunks by up to
+// kMaxRangeRequestsPerDownload concurrent range requests into a PartialDownload, which also lets a
+// later download of the same file resume after a cancellation or an error. Every request needs a
+// connection from the ConnectionLimiter first.
 class HttpDownloadOperation : public QObject {
   Q_OBJECT
  public:
+  static constexpr uint64_t kMinFileSizeForRangeRequests = 2 * PartialDownload::kChunkSize;
+  static constexpr size_t kMaxRangeRequestsPerDownload = 4;
+
   explicit HttpDownloadOperation(std::string url, std::filesystem::path save_file_path,
                                  orbit_base::StopToken stop_token, QNetworkAccessManager* manager,
-                                 QObject* parent = nullptr)
+                                 ConnectionLimiter* connection_limiter, QObject* parent = nullptr)
       : QObject(parent),
         url_(std::move(url)),
         save_file_path_(std::move(save_file_path)),
         stop_token_(std::move(stop_token)),
-        manager_(manager) {}
+        manager_(manager),
+        connection_limiter_(connection_limiter) {}
 
   enum class State {
     kInitial,
@@ -48,22 +66,58 @@ class HttpDownloadOperation : public QObject {
   void finished(State state, std::optional<std::string> maybe_error_msg);
 
  private slots:
+  void OnConnectionReleased();
   void OnDownloadFinished();
   void OnDownloadReadyRead();
+  void OnDownloadMetaDataChanged();
 
  private:
+  enum class Mode {
+    kWaitingForConnection,
+    kSingleRequest,
+    kRangeRequests,
+  };
+
+  struct RangeRequest {
+    size_t chunk_index;
+    uint64_t next_offset;
+    uint64_t end_offset;
+  };
+
   void UpdateState(State state, std::optional<std::string> maybe_error_msg);
 
+  void TrySendRequest();
+  void SwitchToRangeRequests(uint64_t file_size, std::string validator);
+  void SendRangeRequests();
+  void OnRangeRequestReadyRead(QNetworkReply* reply);
+  void OnRangeRequestFinished(QNetworkReply* reply);
+  [[nodiscard]] ErrorMessageOr<void> WriteRangeRequestData(QNetworkReply* reply);
+  [[nodiscard]] ErrorMessageOr<void> CompleteRangeRequest(QNetworkReply* reply);
+  void FailRangeRequests(std::string error_message);
+  void AbortRangeRequests();
+  void MaybeFinishRangeRequests();
+
   State state_ = State::kInitial;
+  Mode mode_ = Mode::kWaitingForConnection;
 
   std::string url_;
   std::filesystem::path save_file_path_;
   orbit_base::StopToken stop_token_;
   QNetworkAccessManager* manager_;
+  ConnectionLimiter* connection_limiter_;
+
+  // Only used with Mode::kSingleRequest.
   QPointer<QNetworkReply> reply_;
   QFile output_;
+
+  // Only used with Mode::kRangeRequests.
+  QUrl range_request_url_;
+  std::optional<PartialDownload> partial_download_;
+  absl::flat_hash_map<QNetworkReply*, RangeRequest> range_requests_;
+  std::optional<std::string> range_requests_error_;
+  bool range_requests_aborted_ = false;
 };
 
 }  // namespace orbit_http
 
-#endif  // HTTP_HTTP_DOWNLOAD_OPERATION_H
\ No newline at end of file
+#endif  // HTTP_HTTP_DOWNLOAD_OPERATION_H
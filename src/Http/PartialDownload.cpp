@@ -0,0 +1,152 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "PartialDownload.h"
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_split.h>
+
+#include <algorithm>
+#include <string_view>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/WriteStringToFile.h"
+
+namespace orbit_http {
+
+namespace {
+
+[[nodiscard]] std::filesystem::path GetPartFilePath(const std::filesystem::path& file_path) {
+  return absl::StrCat(file_path.string(), ".part");
+}
+
+[[nodiscard]] std::filesystem::path GetStateFilePath(const std::filesystem::path& file_path) {
+  return absl::StrCat(file_path.string(), ".part.state");
+}
+
+// The state file has three lines: the size of the file, the validator, and a character per chunk
+// that is '1' for the completed chunks and '0' for all others.
+[[nodiscard]] std::optional<std::string> ReadCompletedChunks(
+    const std::filesystem::path& file_path, uint64_t file_size, std::string_view validator,
+    size_t chunk_count) {
+  if (validator.empty()) return std::nullopt;
+
+  ErrorMessageOr<std::string> state_or_error =
+      orbit_base::ReadFileToString(GetStateFilePath(file_path));
+  if (state_or_error.has_error()) return std::nullopt;
+  std::vector<std::string_view> lines = absl::StrSplit(state_or_error.value(), '\n');
+  uint64_t state_file_size = 0;
+  if (lines.size() != 3 || !absl::SimpleAtoi(lines[0], &state_file_size) ||
+      state_file_size != file_size || lines[1] != validator || lines[2].size() != chunk_count ||
+      lines[2].find_first_not_of("01") != std::string_view::npos) {
+    return std::nullopt;
+  }
+
+  ErrorMessageOr<uint64_t> part_file_size_or_error =
+      orbit_base::FileSize(GetPartFilePath(file_path));
+  if (part_file_size_or_error.has_error() || part_file_size_or_error.value() != file_size) {
+    return std::nullopt;
+  }
+  return std::string{lines[2]};
+}
+
+}  // namespace
+
+ErrorMessageOr<PartialDownload> PartialDownload::OpenOrCreate(
+    const std::filesystem::path& file_path, uint64_t file_size, std::string validator) {
+  const size_t chunk_count = (file_size + kChunkSize - 1) / kChunkSize;
+  const std::filesystem::path part_file_path = GetPartFilePath(file_path);
+
+  std::optional<std::string> completed_chunks =
+      ReadCompletedChunks(file_path, file_size, validator, chunk_count);
+  if (completed_chunks.has_value()) {
+    ErrorMessageOr<orbit_base::UniqueFd> part_file_or_error =
+        orbit_base::OpenExistingFileForReadWrite(part_file_path);
+    if (part_file_or_error.has_value()) {
+      std::vector<ChunkState> chunk_states;
+      for (char chunk_state : completed_chunks.value()) {
+        chunk_states.push_back(static_cast<ChunkState>(chunk_state));
+      }
+      ORBIT_LOG("Resuming the download of \"%s\" with %u of %u chunks already downloaded",
+                file_path.string(), std::count(chunk_states.begin(), chunk_states.end(),
+                                               ChunkState::kCompleted),
+                chunk_count);
+      return PartialDownload{file_path, file_size, std::move(validator),
+                             std::move(part_file_or_error.value()), std::move(chunk_states)};
+    }
+  }
+
+  OUTCOME_TRY(orbit_base::RemoveFile(part_file_path));
+  OUTCOME_TRY(orbit_base::UniqueFd part_file, orbit_base::OpenNewFileForReadWrite(part_file_path));
+  OUTCOME_TRY(orbit_base::ResizeFile(part_file_path, file_size));
+  PartialDownload partial_download{file_path, file_size, std::move(validator),
+                                   std::move(part_file),
+                                   std::vector<ChunkState>(chunk_count, ChunkState::kPending)};
+  OUTCOME_TRY(partial_download.WriteStateFile());
+  return partial_download;
+}
+
+size_t PartialDownload::GetCompletedChunkCount() const {
+  return std::count(chunk_states_.begin(), chunk_states_.end(), ChunkState::kCompleted);
+}
+
+std::pair<uint64_t, uint64_t> PartialDownload::GetChunkRange(size_t chunk_index) const {
+  ORBIT_CHECK(chunk_index < chunk_states_.size());
+  const uint64_t begin = chunk_index * kChunkSize;
+  return {begin, std::min(begin + kChunkSize, file_size_)};
+}
+
+std::optional<size_t> PartialDownload::TakeNextPendingChunk() {
+  auto it = std::find(chunk_states_.begin(), chunk_states_.end(), ChunkState::kPending);
+  if (it == chunk_states_.end()) return std::nullopt;
+  *it = ChunkState::kTaken;
+  return it - chunk_states_.begin();
+}
+
+bool PartialDownload::HasPendingChunks() const {
+  return std::find(chunk_states_.begin(), chunk_states_.end(), ChunkState::kPending) !=
+         chunk_states_.end();
+}
+
+ErrorMessageOr<void> PartialDownload::Write(uint64_t offset, std::string_view data) {
+  if (offset > file_size_ || data.size() > file_size_ - offset) {
+    return ErrorMessage{absl::StrFormat(
+        "Received %u bytes at offset %u, which is past the end of the file of %u bytes.",
+        data.size(), offset, file_size_)};
+  }
+  return orbit_base::WriteFullyAtOffset(part_file_, data.data(), data.size(),
+                                        static_cast<int64_t>(offset));
+}
+
+ErrorMessageOr<void> PartialDownload::CompleteChunk(size_t chunk_index) {
+  ORBIT_CHECK(chunk_index < chunk_states_.size());
+  ORBIT_CHECK(chunk_states_[chunk_index] == ChunkState::kTaken);
+  chunk_states_[chunk_index] = ChunkState::kCompleted;
+  return WriteStateFile();
+}
+
+ErrorMessageOr<void> PartialDownload::Finish() {
+  ORBIT_CHECK(IsComplete());
+  // Closed first, as an open file can't be renamed on Windows.
+  part_file_.release();
+  OUTCOME_TRY(orbit_base::MoveOrRenameFile(GetPartFilePath(file_path_), file_path_));
+  OUTCOME_TRY(orbit_base::RemoveFile(GetStateFilePath(file_path_)));
+  return outcome::success();
+}
+
+ErrorMessageOr<void> PartialDownload::WriteStateFile() const {
+  std::string completed_chunks;
+  completed_chunks.reserve(chunk_states_.size());
+  for (ChunkState chunk_state : chunk_states_) {
+    completed_chunks.push_back(chunk_state == ChunkState::kCompleted ? '1' : '0');
+  }
+  return orbit_base::WriteStringToFile(
+      GetStateFilePath(file_path_),
+      absl::StrFormat("%u\n%s\n%s", file_size_, validator_, completed_chunks));
+}
+
+}  // namespace orbit_http
@@ -0,0 +1,78 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef HTTP_PARTIAL_DOWNLOAD_H_
+#define HTTP_PARTIAL_DOWNLOAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_http {
+
+// The file of a download that is fetched in chunks with HTTP range requests, which can arrive in
+// any order. The chunks are written into "<file>.part", which is sized to the whole file up
+// front (sparse where the file system supports it), and the completed chunks are recorded in
+// "<file>.part.state". A download that was cancelled or failed is resumed from there, without
+// fetching the completed chunks again, as long as the remote file still has the same size and
+// validator (ETag or Last-Modified).
+class PartialDownload {
+ public:
+  static constexpr uint64_t kChunkSize = 32 * 1024 * 1024;
+
+  // Resumes the partial download of `file_path` if there is one for a remote file of the same
+  // size and validator, and creates a new one otherwise. Without a validator, nothing is resumed.
+  [[nodiscard]] static ErrorMessageOr<PartialDownload> OpenOrCreate(
+      const std::filesystem::path& file_path, uint64_t file_size, std::string validator);
+
+  [[nodiscard]] uint64_t GetFileSize() const { return file_size_; }
+  [[nodiscard]] size_t GetChunkCount() const { return chunk_states_.size(); }
+  [[nodiscard]] size_t GetCompletedChunkCount() const;
+  // The bytes [begin, end) of the file that make up the chunk.
+  [[nodiscard]] std::pair<uint64_t, uint64_t> GetChunkRange(size_t chunk_index) const;
+
+  // Returns a chunk that is neither completed nor taken yet, and marks it as taken.
+  [[nodiscard]] std::optional<size_t> TakeNextPendingChunk();
+  [[nodiscard]] bool HasPendingChunks() const;
+  [[nodiscard]] bool IsComplete() const { return GetCompletedChunkCount() == GetChunkCount(); }
+
+  [[nodiscard]] ErrorMessageOr<void> Write(uint64_t offset, std::string_view data);
+  // Records the taken chunk as completed, in memory and in the state file.
+  [[nodiscard]] ErrorMessageOr<void> CompleteChunk(size_t chunk_index);
+
+  // Moves the completed file to its final path and removes the state file.
+  [[nodiscard]] ErrorMessageOr<void> Finish();
+
+ private:
+  enum class ChunkState : char { kPending = '0', kCompleted = '1', kTaken = 't' };
+
+  PartialDownload(std::filesystem::path file_path, uint64_t file_size, std::string validator,
+                  orbit_base::UniqueFd part_file, std::vector<ChunkState> chunk_states)
+      : file_path_(std::move(file_path)),
+        file_size_(file_size),
+        validator_(std::move(validator)),
+        part_file_(std::move(part_file)),
+        chunk_states_(std::move(chunk_states)) {}
+
+  [[nodiscard]] ErrorMessageOr<void> WriteStateFile() const;
+
+  std::filesystem::path file_path_;
+  uint64_t file_size_;
+  std::string validator_;
+  orbit_base::UniqueFd part_file_;
+  std::vector<ChunkState> chunk_states_;
+};
+
+}  // namespace orbit_http
+
+#endif  // HTTP_PARTIAL_DOWNLOAD_H_
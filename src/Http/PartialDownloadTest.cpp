@@ -0,0 +1,128 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/Result.h"
+#include "PartialDownload.h"
+#include "TestUtils/TemporaryDirectory.h"
+#include "TestUtils/TestUtils.h"
+
+namespace orbit_http {
+
+using orbit_test_utils::HasErrorWithMessage;
+using orbit_test_utils::HasNoError;
+using orbit_test_utils::HasValue;
+
+namespace {
+
+constexpr uint64_t kThreeChunksFileSize = 2 * PartialDownload::kChunkSize + 10;
+
+class PartialDownloadTest : public ::testing::Test {
+ protected:
+  PartialDownloadTest() {
+    auto temporary_directory_or_error = orbit_test_utils::TemporaryDirectory::Create();
+    EXPECT_THAT(temporary_directory_or_error, HasNoError());
+    temporary_directory_.emplace(std::move(temporary_directory_or_error.value()));
+    file_path_ = temporary_directory_->GetDirectoryPath() / "download.bin";
+  }
+
+  std::optional<orbit_test_utils::TemporaryDirectory> temporary_directory_;
+  std::filesystem::path file_path_;
+};
+
+}  // namespace
+
+TEST_F(PartialDownloadTest, WritesChunksAndFinishes) {
+  ErrorMessageOr<PartialDownload> download_or_error =
+      PartialDownload::OpenOrCreate(file_path_, 10, "\"etag\"");
+  ASSERT_THAT(download_or_error, HasNoError());
+  PartialDownload& download = download_or_error.value();
+  ASSERT_EQ(download.GetChunkCount(), 1);
+  EXPECT_EQ(download.GetChunkRange(0), std::make_pair(uint64_t{0}, uint64_t{10}));
+
+  EXPECT_EQ(download.TakeNextPendingChunk(), 0);
+  EXPECT_FALSE(download.HasPendingChunks());
+  EXPECT_EQ(download.TakeNextPendingChunk(), std::nullopt);
+
+  EXPECT_THAT(download.Write(5, "56789"), HasNoError());
+  EXPECT_THAT(download.Write(0, "01234"), HasNoError());
+  EXPECT_THAT(download.Write(8, "too long"), HasErrorWithMessage("past the end of the file"));
+  EXPECT_THAT(download.CompleteChunk(0), HasNoError());
+  ASSERT_TRUE(download.IsComplete());
+  EXPECT_THAT(download.Finish(), HasNoError());
+
+  EXPECT_THAT(orbit_base::ReadFileToString(file_path_), HasValue("0123456789"));
+  EXPECT_THAT(orbit_base::FileOrDirectoryExists(file_path_.string() + ".part"), HasValue(false));
+  EXPECT_THAT(orbit_base::FileOrDirectoryExists(file_path_.string() + ".part.state"),
+              HasValue(false));
+}
+
+TEST_F(PartialDownloadTest, ResumesCompletedChunks) {
+  {
+    ErrorMessageOr<PartialDownload> download_or_error =
+        PartialDownload::OpenOrCreate(file_path_, kThreeChunksFileSize, "\"etag\"");
+    ASSERT_THAT(download_or_error, HasNoError());
+    PartialDownload& download = download_or_error.value();
+    ASSERT_EQ(download.GetChunkCount(), 3);
+    EXPECT_EQ(download.GetChunkRange(2),
+              std::make_pair(2 * PartialDownload::kChunkSize, kThreeChunksFileSize));
+
+    EXPECT_EQ(download.TakeNextPendingChunk(), 0);
+    EXPECT_EQ(download.TakeNextPendingChunk(), 1);
+    EXPECT_THAT(download.Write(PartialDownload::kChunkSize, "chunk1"), HasNoError());
+    EXPECT_THAT(download.CompleteChunk(1), HasNoError());
+    // Chunk 0 is taken but never completed, as if the download was cancelled.
+  }
+
+  ErrorMessageOr<PartialDownload> download_or_error =
+      PartialDownload::OpenOrCreate(file_path_, kThreeChunksFileSize, "\"etag\"");
+  ASSERT_THAT(download_or_error, HasNoError());
+  PartialDownload& download = download_or_error.value();
+  EXPECT_EQ(download.GetCompletedChunkCount(), 1);
+  EXPECT_EQ(download.TakeNextPendingChunk(), 0);
+  EXPECT_EQ(download.TakeNextPendingChunk(), 2);
+  EXPECT_EQ(download.TakeNextPendingChunk(), std::nullopt);
+  EXPECT_THAT(download.CompleteChunk(0), HasNoError());
+  EXPECT_THAT(download.CompleteChunk(2), HasNoError());
+  ASSERT_TRUE(download.IsComplete());
+  EXPECT_THAT(download.Finish(), HasNoError());
+
+  ErrorMessageOr<std::string> content_or_error = orbit_base::ReadFileToString(file_path_);
+  ASSERT_THAT(content_or_error, HasNoError());
+  ASSERT_EQ(content_or_error.value().size(), kThreeChunksFileSize);
+  EXPECT_EQ(content_or_error.value().substr(PartialDownload::kChunkSize, 6), "chunk1");
+}
+
+TEST_F(PartialDownloadTest, StartsOverWhenTheRemoteFileChanged) {
+  {
+    ErrorMessageOr<PartialDownload> download_or_error =
+        PartialDownload::OpenOrCreate(file_path_, kThreeChunksFileSize, "\"etag\"");
+    ASSERT_THAT(download_or_error, HasNoError());
+    EXPECT_EQ(download_or_error.value().TakeNextPendingChunk(), 0);
+    EXPECT_THAT(download_or_error.value().CompleteChunk(0), HasNoError());
+  }
+
+  for (const auto& [file_size, validator] :
+       {std::make_pair(kThreeChunksFileSize, "\"other etag\""),
+        std::make_pair(kThreeChunksFileSize + 1, "\"etag\""),
+        std::make_pair(kThreeChunksFileSize, "")}) {
+    ErrorMessageOr<PartialDownload> download_or_error =
+        PartialDownload::OpenOrCreate(file_path_, file_size, validator);
+    ASSERT_THAT(download_or_error, HasNoError());
+    EXPECT_EQ(download_or_error.value().GetCompletedChunkCount(), 0);
+  }
+}
+
+}  // namespace orbit_http
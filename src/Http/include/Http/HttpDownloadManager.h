@@ -5,10 +5,13 @@
 #ifndef HTTP_HTTP_DOWNLOAD_MANAGER_H
 #define HTTP_HTTP_DOWNLOAD_MANAGER_H
 
+#include <stddef.h>
+
 #include <QNetworkAccessManager>
 #include <QObject>
 #include <QString>
 #include <filesystem>
+#include <memory>
 #include <string>
 
 #include "Http/DownloadManager.h"
@@ -20,9 +23,16 @@
 
 namespace orbit_http {
 
+class ConnectionLimiter;
+
+// Large files are downloaded with several concurrent range requests, if the server supports them.
+// Across all downloads, at most kMaxConcurrentConnections requests are in flight at the same time;
+// further requests wait until one of them finished.
 class HttpDownloadManager : public QObject, public DownloadManager {
  public:
-  explicit HttpDownloadManager(QObject* parent = nullptr) : QObject(parent) {}
+  static constexpr size_t kMaxConcurrentConnections = 8;
+
+  explicit HttpDownloadManager(QObject* parent = nullptr);
   ~HttpDownloadManager() override;
 
   [[nodiscard]] orbit_base::Future<
@@ -32,6 +42,7 @@ class HttpDownloadManager : public QObject, public DownloadManager {
 
  private:
   QNetworkAccessManager manager_;
+  std::unique_ptr<ConnectionLimiter> connection_limiter_;
 };
 
 }  // namespace orbit_http
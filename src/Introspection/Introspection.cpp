@@ -33,7 +33,7 @@ ABSL_CONST_INIT static IntrospectionListener* global_introspection_listener
 
 // Introspection uses the same function table used by the Orbit API, but specifies its own
 // functions.
-orbit_api_v2 g_orbit_api;
+orbit_api_v3 g_orbit_api;
 
 namespace orbit_introspection {
 
@@ -53,6 +53,7 @@ IntrospectionListener::IntrospectionListener(IntrospectionEventCallback callback
   global_introspection_listener = this;
   active_ = true;
   shutdown_initiated_ = false;
+  g_orbit_api.enabled = 1;
 }
 
 IntrospectionListener::~IntrospectionListener() {
@@ -64,6 +65,8 @@ IntrospectionListener::~IntrospectionListener() {
     absl::MutexLock lock(&global_introspection_mutex);
     ORBIT_CHECK(IsActive());
     shutdown_initiated_ = true;
+    // Without a listener, the scopes don't need to reach DeferApiEventProcessing and its mutex.
+    g_orbit_api.enabled = 0;
   }
   // Purge deferred scopes.
   thread_pool_->Shutdown();
@@ -75,6 +78,18 @@ IntrospectionListener::~IntrospectionListener() {
   global_introspection_listener = nullptr;
 }
 
+bool ScopeSampler::TryAcquireRateLimit() {
+  constexpr uint64_t kNsPerSecond = 1'000'000'000;
+  const uint64_t now_s = orbit_base::CaptureTimestampNs() / kNsPerSecond;
+  uint64_t window_start_s = window_start_s_.load(std::memory_order_relaxed);
+  if (now_s != window_start_s &&
+      window_start_s_.compare_exchange_strong(window_start_s, now_s, std::memory_order_relaxed)) {
+    // Only the thread that moved the window resets the count.
+    recorded_in_window_.store(0, std::memory_order_relaxed);
+  }
+  return recorded_in_window_.fetch_add(1, std::memory_order_relaxed) < max_per_second_;
+}
+
 }  // namespace orbit_introspection
 
 namespace {
@@ -114,6 +129,16 @@ void orbit_api_start_v1(const char* name, orbit_api_color color, uint64_t group_
   IntrospectionListener::DeferApiEventProcessing(api_scope_start);
 }
 
+void orbit_api_start_with_name_id_v3(uint64_t /*name_id*/, const char* name,
+                                     orbit_api_color color, uint64_t group_id,
+                                     uint64_t caller_address) {
+  if (caller_address == kOrbitCallerAddressAuto) {
+    caller_address = ORBIT_GET_CALLER_PC();
+  }
+  // Listeners expect encoded names, and introspection has no interning to benefit from the id.
+  orbit_api_start_v1(name, color, group_id, caller_address);
+}
+
 void orbit_api_stop() {
   uint32_t thread_id = orbit_base::GetCurrentThreadId();
   uint64_t timestamp_ns = orbit_base::CaptureTimestampNs();
@@ -212,9 +237,9 @@ void InitializeIntrospection() {
   g_orbit_api.track_uint64 = &orbit_api_track_uint64;
   g_orbit_api.track_float = &orbit_api_track_float;
   g_orbit_api.track_double = &orbit_api_track_double;
+  g_orbit_api.start_with_name_id = &orbit_api_start_with_name_id_v3;
   std::atomic_thread_fence(std::memory_order_release);
   g_orbit_api.initialized = 1;
-  g_orbit_api.enabled = 1;
 }
 
 }  // namespace orbit_introspection
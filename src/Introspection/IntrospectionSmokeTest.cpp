@@ -8,6 +8,7 @@
 #include <stddef.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -112,4 +113,53 @@ TEST(Tracing, Scopes) {
   }
 }
 
+TEST(Tracing, ScopeSamplerRecordsOneInN) {
+  ScopeSampler sampler{4, 0};
+  EXPECT_FALSE(sampler.ShouldRecord());
+
+  IntrospectionListener listener([](const orbit_api::ApiEventVariant& /*api_event*/) {});
+  int recorded_count = 0;
+  for (int i = 0; i < 20; ++i) {
+    if (sampler.ShouldRecord()) ++recorded_count;
+  }
+  EXPECT_EQ(recorded_count, 5);
+}
+
+TEST(Tracing, ScopeSamplerIsRateLimited) {
+  ScopeSampler sampler{1, 3};
+  IntrospectionListener listener([](const orbit_api::ApiEventVariant& /*api_event*/) {});
+  int recorded_count = 0;
+  for (int i = 0; i < 10; ++i) {
+    if (sampler.ShouldRecord()) ++recorded_count;
+  }
+  // The loop could straddle the start of a new second.
+  EXPECT_GE(recorded_count, 3);
+  EXPECT_LE(recorded_count, 6);
+}
+
+static void TestSampledScopes() {
+  for (int i = 0; i < 10; ++i) {
+    ORBIT_SAMPLED_SCOPE(kIntrospectionCategoryDefault, "TEST_ORBIT_SAMPLED_SCOPE", 5, 0);
+  }
+}
+
+TEST(Tracing, SampledScopes) {
+  std::atomic<int> scope_start_count = 0;
+  std::atomic<int> scope_stop_count = 0;
+  {
+    IntrospectionListener listener(
+        [&scope_start_count, &scope_stop_count](const orbit_api::ApiEventVariant& api_event) {
+          if (std::holds_alternative<orbit_api::ApiScopeStart>(api_event)) ++scope_start_count;
+          if (std::holds_alternative<orbit_api::ApiScopeStop>(api_event)) ++scope_stop_count;
+        });
+    TestSampledScopes();
+  }
+  EXPECT_EQ(scope_start_count, 2);
+  EXPECT_EQ(scope_stop_count, 2);
+
+  // Without a listener, nothing is recorded.
+  TestSampledScopes();
+  EXPECT_EQ(scope_start_count, 2);
+}
+
 }  // namespace orbit_introspection
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <functional>
 #include <memory>
 
@@ -17,8 +18,32 @@
 
 #define ORBIT_SCOPE_FUNCTION ORBIT_SCOPE(__FUNCTION__)
 
+// Scopes of loops that run thousands of times per second, like the main loop of the tracer, would
+// perturb the measurements if all their iterations were recorded. ORBIT_SAMPLED_SCOPE records only
+// one in `one_in_n` executions of the scope, and at most `max_per_second` of them per second (0
+// means no limit). Each scope belongs to a category: the categories not in
+// ORBIT_INTROSPECTION_CATEGORY_MASK are compiled out, e.g. with
+// -DORBIT_INTROSPECTION_CATEGORY_MASK=0x1 only kIntrospectionCategoryDefault is kept.
+//
+//   ORBIT_SAMPLED_SCOPE(kIntrospectionCategoryTracerLoop, "TracerThread::Run iteration", 100, 50);
+#ifndef ORBIT_INTROSPECTION_CATEGORY_MASK
+#define ORBIT_INTROSPECTION_CATEGORY_MASK 0xffffffffu
+#endif
+
+#define ORBIT_SAMPLED_SCOPE(category, name, one_in_n, max_per_second)   \
+  ORBIT_SAMPLED_SCOPE_INTERNAL(category, name, one_in_n, max_per_second, \
+                               ORBIT_UNIQUE(ORBIT_SAMPLER))
+#define ORBIT_SAMPLED_SCOPE_INTERNAL(category, name, one_in_n, max_per_second, sampler_name) \
+  static ::orbit_introspection::ScopeSampler sampler_name{one_in_n, max_per_second};         \
+  ::orbit_introspection::SampledScope ORBIT_VAR(                                             \
+      name, (ORBIT_INTROSPECTION_CATEGORY_MASK & (category)) != 0 && sampler_name.ShouldRecord())
+
 namespace orbit_introspection {
 
+constexpr uint32_t kIntrospectionCategoryDefault = 1u << 0;
+constexpr uint32_t kIntrospectionCategoryTracerLoop = 1u << 1;
+constexpr uint32_t kIntrospectionCategoryEventProcessing = 1u << 2;
+
 using IntrospectionEventCallback = std::function<void(const orbit_api::ApiEventVariant& api_event)>;
 
 class IntrospectionListener {
@@ -42,6 +67,53 @@ class IntrospectionListener {
   inline static bool shutdown_initiated_ = true;
 };
 
+// Decides which executions of a scope are recorded, see ORBIT_SAMPLED_SCOPE. Thread-safe.
+class ScopeSampler {
+ public:
+  constexpr ScopeSampler(uint32_t one_in_n, uint32_t max_per_second)
+      : one_in_n_{one_in_n == 0 ? 1 : one_in_n}, max_per_second_{max_per_second} {}
+
+  // When no listener is active this is a single load and branch.
+  [[nodiscard]] bool ShouldRecord() {
+    if (!IntrospectionListener::IsActive()) return false;
+    if (one_in_n_ > 1 &&
+        execution_count_.fetch_add(1, std::memory_order_relaxed) % one_in_n_ != 0) {
+      return false;
+    }
+    return max_per_second_ == 0 || TryAcquireRateLimit();
+  }
+
+ private:
+  [[nodiscard]] bool TryAcquireRateLimit();
+
+  const uint32_t one_in_n_;
+  const uint32_t max_per_second_;
+  std::atomic<uint32_t> execution_count_ = 0;
+  std::atomic<uint64_t> window_start_s_ = 0;
+  std::atomic<uint32_t> recorded_in_window_ = 0;
+};
+
+// Like orbit_api::Scope, but only records the scope if `record` is true.
+class SampledScope {
+ public:
+  SampledScope(const char* name, bool record) : record_{record} {
+    if (record_) {
+      ORBIT_CALL(start, name, kOrbitColorAuto, kOrbitDefaultGroupId, kOrbitCallerAddressAuto);
+    }
+  }
+  ~SampledScope() {
+    if (record_) ORBIT_CALL(stop);
+  }
+
+  SampledScope(const SampledScope& other) = delete;
+  SampledScope& operator=(const SampledScope& other) = delete;
+  SampledScope(SampledScope&& other) = delete;
+  SampledScope& operator=(SampledScope&& other) = delete;
+
+ private:
+  bool record_;
+};
+
 }  // namespace orbit_introspection
 
 #endif  // INTROSPECTION_INTROSPECTION_H_
@@ -0,0 +1,46 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "FunctionCallSampler.h"
+
+namespace orbit_linux_capture_service {
+
+using orbit_grpc_protos::CaptureOptions;
+using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::InstrumentedFunction;
+
+FunctionCallSampler::FunctionCallSampler(
+    const CaptureOptions& capture_options,
+    const absl::flat_hash_set<uint64_t>& user_space_instrumented_function_ids) {
+  for (const InstrumentedFunction& function : capture_options.instrumented_functions()) {
+    if (function.record_one_in_n_calls() > 1 &&
+        !user_space_instrumented_function_ids.contains(function.function_id())) {
+      function_ids_to_call_sampling_periods_.emplace(function.function_id(),
+                                                     function.record_one_in_n_calls());
+    }
+    if (function.min_duration_ns() > 0) {
+      function_ids_to_min_durations_ns_.emplace(function.function_id(),
+                                                function.min_duration_ns());
+    }
+  }
+}
+
+bool FunctionCallSampler::ShouldKeep(const FunctionCall& function_call) {
+  const uint64_t function_id = function_call.function_id();
+
+  if (auto it = function_ids_to_call_sampling_periods_.find(function_id);
+      it != function_ids_to_call_sampling_periods_.end()) {
+    uint64_t& call_count = function_ids_and_tids_to_call_counts_[{function_id, function_call.tid()}];
+    if (call_count++ % it->second != 0) return false;
+  }
+
+  if (auto it = function_ids_to_min_durations_ns_.find(function_id);
+      it != function_ids_to_min_durations_ns_.end()) {
+    if (function_call.duration_ns() < it->second) return false;
+  }
+
+  return true;
+}
+
+}  // namespace orbit_linux_capture_service
@@ -0,0 +1,41 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_CAPTURE_SERVICE_FUNCTION_CALL_SAMPLER_H_
+#define LINUX_CAPTURE_SERVICE_FUNCTION_CALL_SAMPLER_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <stdint.h>
+
+#include <utility>
+
+#include "GrpcProtos/capture.pb.h"
+
+namespace orbit_linux_capture_service {
+
+// Applies InstrumentedFunction::record_one_in_n_calls and InstrumentedFunction::min_duration_ns to
+// the FunctionCalls produced by LinuxTracing.
+// Functions instrumented with user space instrumentation already skip the calls that are not
+// sampled in the target process, so for them only the duration threshold is applied here. The
+// duration threshold can't be applied in the target process, as the entry of a call would need to be
+// held back until its exit, which breaks the ordering of the events of a thread.
+// Not thread-safe: all calls are expected to come from the same thread.
+class FunctionCallSampler {
+ public:
+  FunctionCallSampler() = default;
+  FunctionCallSampler(const orbit_grpc_protos::CaptureOptions& capture_options,
+                      const absl::flat_hash_set<uint64_t>& user_space_instrumented_function_ids);
+
+  [[nodiscard]] bool ShouldKeep(const orbit_grpc_protos::FunctionCall& function_call);
+
+ private:
+  absl::flat_hash_map<uint64_t, uint32_t> function_ids_to_call_sampling_periods_;
+  absl::flat_hash_map<uint64_t, uint64_t> function_ids_to_min_durations_ns_;
+  absl::flat_hash_map<std::pair<uint64_t, uint32_t>, uint64_t> function_ids_and_tids_to_call_counts_;
+};
+
+}  // namespace orbit_linux_capture_service
+
+#endif  // LINUX_CAPTURE_SERVICE_FUNCTION_CALL_SAMPLER_H_
@@ -0,0 +1,81 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include "FunctionCallSampler.h"
+#include "GrpcProtos/capture.pb.h"
+
+namespace orbit_linux_capture_service {
+
+using orbit_grpc_protos::CaptureOptions;
+using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::InstrumentedFunction;
+
+namespace {
+
+constexpr uint64_t kSampledFunctionId = 1;
+constexpr uint64_t kThresholdFunctionId = 2;
+constexpr uint64_t kOtherFunctionId = 3;
+constexpr uint64_t kMinDurationNs = 1000;
+
+CaptureOptions CreateCaptureOptions(uint32_t record_one_in_n_calls) {
+  CaptureOptions capture_options;
+  InstrumentedFunction* sampled_function = capture_options.add_instrumented_functions();
+  sampled_function->set_function_id(kSampledFunctionId);
+  sampled_function->set_record_one_in_n_calls(record_one_in_n_calls);
+  InstrumentedFunction* threshold_function = capture_options.add_instrumented_functions();
+  threshold_function->set_function_id(kThresholdFunctionId);
+  threshold_function->set_min_duration_ns(kMinDurationNs);
+  capture_options.add_instrumented_functions()->set_function_id(kOtherFunctionId);
+  return capture_options;
+}
+
+FunctionCall CreateFunctionCall(uint64_t function_id, uint32_t tid, uint64_t duration_ns) {
+  FunctionCall function_call;
+  function_call.set_function_id(function_id);
+  function_call.set_tid(tid);
+  function_call.set_duration_ns(duration_ns);
+  return function_call;
+}
+
+}  // namespace
+
+TEST(FunctionCallSampler, DefaultConstructedKeepsEverything) {
+  FunctionCallSampler sampler;
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+}
+
+TEST(FunctionCallSampler, KeepsOneInNCallsPerThread) {
+  FunctionCallSampler sampler{CreateCaptureOptions(3), {}};
+
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 43, 0)));
+  EXPECT_FALSE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+  EXPECT_FALSE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+  EXPECT_FALSE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 43, 0)));
+
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kOtherFunctionId, 42, 0)));
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kOtherFunctionId, 42, 0)));
+}
+
+TEST(FunctionCallSampler, DoesNotSampleUserSpaceInstrumentedFunctions) {
+  FunctionCallSampler sampler{CreateCaptureOptions(3), {kSampledFunctionId}};
+
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kSampledFunctionId, 42, 0)));
+}
+
+TEST(FunctionCallSampler, DropsCallsShorterThanMinDuration) {
+  FunctionCallSampler sampler{CreateCaptureOptions(0), {kThresholdFunctionId}};
+
+  EXPECT_FALSE(sampler.ShouldKeep(CreateFunctionCall(kThresholdFunctionId, 42, kMinDurationNs - 1)));
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kThresholdFunctionId, 42, kMinDurationNs)));
+  EXPECT_TRUE(sampler.ShouldKeep(CreateFunctionCall(kOtherFunctionId, 42, 0)));
+}
+
+}  // namespace orbit_linux_capture_service
@@ -15,13 +15,18 @@
 namespace orbit_linux_capture_service {
 
 grpc::Status LinuxCaptureService::Capture(
-    grpc::ServerContext* /*context*/,
+    grpc::ServerContext* context,
     grpc::ServerReaderWriter<orbit_grpc_protos::CaptureResponse, orbit_grpc_protos::CaptureRequest>*
         reader_writer) {
   orbit_base::SetCurrentThreadName("CSImpl::Capture");
 
+  auto grpc_start_stop_capture_request_waiter =
+      std::make_shared<orbit_capture_service_base::GrpcStartStopCaptureRequestWaiter>(
+          reader_writer);
   orbit_producer_event_processor::GrpcClientCaptureEventCollector
-      grpc_client_capture_event_collector{reader_writer};
+      grpc_client_capture_event_collector{
+          reader_writer,
+          grpc_start_stop_capture_request_waiter->GetClientCaptureBacklogByteCountPtr()};
   CaptureServiceBase::CaptureInitializationResult initialization_result =
       InitializeCapture(&grpc_client_capture_event_collector);
   switch (initialization_result) {
@@ -32,11 +37,10 @@ grpc::Status LinuxCaptureService::Capture(
               "Cannot start capture because another capture is already in progress"};
   }
 
-  auto grpc_start_stop_capture_request_waiter =
-      std::make_shared<orbit_capture_service_base::GrpcStartStopCaptureRequestWaiter>(
-          reader_writer);
   const orbit_grpc_protos::CaptureOptions& capture_options =
       grpc_start_stop_capture_request_waiter->WaitForStartCaptureRequest();
+  orbit_capture_service_base::SetCaptureResponseCompression(capture_options, context);
+  SetUpCaptureFileOnTarget(capture_options);
   DoCapture(capture_options, grpc_start_stop_capture_request_waiter);
 
   return grpc::Status::OK;
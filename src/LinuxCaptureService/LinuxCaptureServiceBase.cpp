@@ -12,6 +12,7 @@
 #include <sys/types.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <filesystem>
 #include <map>
@@ -29,6 +30,7 @@
 #include "CaptureServiceBase/CommonProducerCaptureEventBuilders.h"
 #include "CaptureServiceBase/StopCaptureRequestWaiter.h"
 #include "ExtractSignalFromMinidump.h"
+#include "FunctionCallSampler.h"
 #include "GrpcProtos/Constants.h"
 #include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/services.pb.h"
@@ -39,6 +41,7 @@
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/StatsRegistry.h"
 #include "OrbitBase/ThreadUtils.h"
 #include "ProducerEventProcessor/ClientCaptureEventCollector.h"
 #include "ProducerEventProcessor/ProducerEventProcessor.h"
@@ -156,6 +159,10 @@ class ProducerEventProcessorHijackingFunctionEntryExitForLinuxTracing
     }
   }
 
+  void DropEventsOfProducersExcept(absl::flat_hash_set<uint64_t> producer_ids_to_keep) override {
+    producer_event_processor_->DropEventsOfProducersExcept(std::move(producer_ids_to_keep));
+  }
+
  private:
   ProducerEventProcessor* producer_event_processor_;
   TracingHandler* tracing_handler_;
@@ -243,10 +250,65 @@ TargetProcessStateAfterCapture GetTargetProcessStateAfterCapture(
   return result;
 }
 
+// Takes one of the load shedding steps of the memory watchdog, if it applies to this capture, and
+// tells the client about it with a WarningEvent.
+void TakeMemoryWatchdogLoadSheddingStep(MemoryWatchdogStep step,
+                                        const CaptureOptions& capture_options,
+                                        TracingHandler* tracing_handler,
+                                        ProducerEventProcessor* producer_event_processor) {
+  std::string message;
+  switch (step) {
+    case MemoryWatchdogStep::kReduceSamplingRate: {
+      if (capture_options.samples_per_second() <= 0 ||
+          capture_options.unwinding_method() == CaptureOptions::kUndefined) {
+        return;
+      }
+      constexpr uint32_t kSamplingRateReductionFactor = 4;
+      tracing_handler->ReduceSamplingRate(kSamplingRateReductionFactor);
+      message = absl::StrFormat(
+          "OrbitService is running low on memory: reduced the callstack sampling rate to %.1f "
+          "samples per second.",
+          capture_options.samples_per_second() / kSamplingRateReductionFactor);
+      break;
+    }
+    case MemoryWatchdogStep::kDropThreadStateChangeCallstacks:
+      if (!capture_options.trace_thread_state() ||
+          capture_options.thread_state_change_callstack_collection() !=
+              CaptureOptions::kThreadStateChangeCallStackCollection) {
+        return;
+      }
+      tracing_handler->DropThreadStateChangeCallstacks();
+      message =
+          "OrbitService is running low on memory: stopped collecting the callstacks of thread "
+          "state changes.";
+      break;
+    case MemoryWatchdogStep::kDropLowPriorityProducers:
+      // Only OrbitService itself and LinuxTracing are kept, the events from the memory tracing,
+      // introspection and external producers, e.g., the Vulkan layer, are dropped.
+      producer_event_processor->DropEventsOfProducersExcept(
+          {orbit_grpc_protos::kRootProducerId, orbit_grpc_protos::kLinuxTracingProducerId});
+      message =
+          "OrbitService is running low on memory: dropping the events of memory tracing, "
+          "introspection and external producers (e.g., the Vulkan layer).";
+      break;
+    case MemoryWatchdogStep::kNone:
+    case MemoryWatchdogStep::kStopCapture:
+      ORBIT_UNREACHABLE();
+  }
+
+  ORBIT_LOG("%s", message);
+  // This comes from the root producer, so that it is not dropped by kDropLowPriorityProducers.
+  producer_event_processor->ProcessEvent(
+      orbit_grpc_protos::kRootProducerId,
+      orbit_capture_service_base::CreateWarningEvent(orbit_base::CaptureTimestampNs(),
+                                                     std::move(message)));
+}
+
 }  // namespace
 
 CaptureServiceBase::StopCaptureReason
 LinuxCaptureServiceBase::WaitForStopCaptureRequestOrMemoryThresholdExceeded(
+    const CaptureOptions& capture_options, TracingHandler* tracing_handler,
     const std::shared_ptr<StopCaptureRequestWaiter>& stop_capture_request_waiter) {
   // wait_for_stop_capture_request_thread_ below outlives this method, hence the shared pointers.
   auto stop_capture_mutex = std::make_shared<absl::Mutex>();
@@ -281,6 +343,21 @@ LinuxCaptureServiceBase::WaitForStopCaptureRequestOrMemoryThresholdExceeded(
   static const uint64_t kWatchdogThresholdBytes = kMemTotalBytes / 2;
   ORBIT_LOG("Starting memory watchdog with threshold %u B because total physical memory is %u B",
             kWatchdogThresholdBytes, kMemTotalBytes);
+  // The last polled rss is published with the live stats, so that it can be compared to the
+  // threshold while capturing.
+  std::atomic<uint64_t> last_rss_bytes = 0;
+  MemoryWatchdogStep last_step = MemoryWatchdogStep::kNone;
+  // While the client reports being behind, the next load shedding step is taken every few polls, so
+  // that the events are eventually produced no faster than the client processes them. This never
+  // stops the capture, though.
+  static constexpr int kPollsPerClientBacklogStep = 5;
+  int consecutive_polls_with_client_behind = 0;
+  MemoryWatchdogStep client_backlog_step = MemoryWatchdogStep::kNone;
+  orbit_base::StatsRegistry& registry = orbit_base::StatsRegistry::GetDefault();
+  orbit_base::StatsRegistry::Registration rss_registration = registry.Register(
+      "memory_watchdog.rss_bytes", [&] { return last_rss_bytes.load(std::memory_order_relaxed); });
+  orbit_base::StatsRegistry::Registration threshold_registration =
+      registry.Register("memory_watchdog.threshold_bytes", [] { return kWatchdogThresholdBytes; });
   while (true) {
     {
       absl::MutexLock lock{stop_capture_mutex.get()};
@@ -298,7 +375,30 @@ LinuxCaptureServiceBase::WaitForStopCaptureRequestOrMemoryThresholdExceeded(
       ORBIT_ERROR_ONCE("Reading resident set size of OrbitService");
       continue;
     }
-    if (rss_bytes.value() > kWatchdogThresholdBytes) {
+    last_rss_bytes.store(rss_bytes.value(), std::memory_order_relaxed);
+
+    if (stop_capture_request_waiter->GetClientCaptureBacklogByteCount() >
+        orbit_grpc_protos::kClientCaptureBacklogThresholdBytes) {
+      ++consecutive_polls_with_client_behind;
+      if (consecutive_polls_with_client_behind % kPollsPerClientBacklogStep == 0 &&
+          client_backlog_step < MemoryWatchdogStep::kDropLowPriorityProducers) {
+        ORBIT_LOG("The client has been behind for %d s", consecutive_polls_with_client_behind);
+        client_backlog_step =
+            static_cast<MemoryWatchdogStep>(static_cast<int>(client_backlog_step) + 1);
+      }
+    } else {
+      consecutive_polls_with_client_behind = 0;
+    }
+
+    // The steps are taken in order, and only once each, even if the rss decreases in between.
+    const MemoryWatchdogStep step = std::max(
+        ComputeMemoryWatchdogStep(rss_bytes.value(), kWatchdogThresholdBytes), client_backlog_step);
+    while (last_step < step && step != MemoryWatchdogStep::kStopCapture) {
+      last_step = static_cast<MemoryWatchdogStep>(static_cast<int>(last_step) + 1);
+      TakeMemoryWatchdogLoadSheddingStep(last_step, capture_options, tracing_handler,
+                                         producer_event_processor_.get());
+    }
+    if (step == MemoryWatchdogStep::kStopCapture) {
       ORBIT_LOG("Memory threshold exceeded: stopping capture (and stopping memory watchdog)");
       absl::MutexLock lock{stop_capture_mutex.get()};
       *stop_capture = true;
@@ -349,6 +449,8 @@ void LinuxCaptureServiceBase::DoCapture(
   std::optional<std::string> error_enabling_user_space_instrumentation;
   std::optional<ProducerCaptureEvent> info_from_enabling_user_space_instrumentation;
   std::unique_ptr<UserSpaceInstrumentationAddressesImpl> user_space_instrumentation_addresses;
+  absl::flat_hash_set<uint64_t> user_space_instrumented_function_ids;
+  uint64_t function_call_overhead_ns = 0;
   if (capture_options.dynamic_instrumentation_method() ==
           CaptureOptions::kUserSpaceInstrumentation &&
       capture_options.instrumented_functions_size() != 0) {
@@ -377,10 +479,12 @@ void LinuxCaptureServiceBase::DoCapture(
               result_or_error.value().entry_trampoline_address_ranges,
               result_or_error.value().return_trampoline_address_range,
               result_or_error.value().injected_library_path.string());
+      user_space_instrumented_function_ids = result_or_error.value().instrumented_function_ids;
+      function_call_overhead_ns = result_or_error.value().function_call_overhead_ns;
     }
   }
 
-  StartEventProcessing(capture_options);
+  StartEventProcessing(capture_options, function_call_overhead_ns);
 
   if (error_enabling_orbit_api.has_value()) {
     producer_event_processor_->ProcessEvent(
@@ -408,8 +512,9 @@ void LinuxCaptureServiceBase::DoCapture(
     introspection_listener = CreateIntrospectionListener(producer_event_processor_.get());
   }
 
-  tracing_handler.Start(linux_tracing_capture_options,
-                        std::move(user_space_instrumentation_addresses));
+  tracing_handler.Start(
+      linux_tracing_capture_options, std::move(user_space_instrumentation_addresses),
+      FunctionCallSampler{capture_options, user_space_instrumented_function_ids});
 
   memory_info_handler.Start(capture_options);
   for (CaptureStartStopListener* listener : capture_start_stop_listeners_) {
@@ -417,7 +522,8 @@ void LinuxCaptureServiceBase::DoCapture(
   }
 
   StopCaptureReason stop_capture_reason =
-      WaitForStopCaptureRequestOrMemoryThresholdExceeded(stop_capture_request_waiter);
+      WaitForStopCaptureRequestOrMemoryThresholdExceeded(capture_options, &tracing_handler,
+                                                         stop_capture_request_waiter);
 
   // Disable Orbit API in tracee.
   if (capture_options.enable_api()) {
@@ -432,22 +538,10 @@ void LinuxCaptureServiceBase::DoCapture(
     }
   }
 
-  // Disable user space instrumentation.
-  if (capture_options.dynamic_instrumentation_method() ==
-          CaptureOptions::kUserSpaceInstrumentation &&
-      capture_options.instrumented_functions_size() != 0) {
-    const pid_t target_process_id = orbit_base::ToNativeProcessId(capture_options.pid());
-    auto result_tmp = instrumentation_manager_->UninstrumentProcess(target_process_id);
-    if (result_tmp.has_error()) {
-      ORBIT_ERROR("Disabling user space instrumentation: %s", result_tmp.error().message());
-      producer_event_processor_->ProcessEvent(
-          orbit_grpc_protos::kRootProducerId,
-          orbit_capture_service_base::CreateWarningEvent(
-              orbit_base::CaptureTimestampNs(),
-              absl::StrFormat("Could not disable user space instrumentation: %s",
-                              result_tmp.error().message())));
-    }
-  }
+  // User space instrumentation doesn't need to be disabled: the instrumented functions keep
+  // jumping into their trampolines, which return right away as soon as the target process is told
+  // that the capture has stopped. This avoids stopping the target process again. The prologues are
+  // restored when the InstrumentationManager is destroyed.
 
   StopInternalProducersAndCaptureStartStopListenersInParallel(
       &tracing_handler, &memory_info_handler, &capture_start_stop_listeners_);
@@ -459,8 +553,13 @@ void LinuxCaptureServiceBase::DoCapture(
   auto target_process_state = GetTargetProcessStateAfterCapture(
       orbit_base::ToNativeProcessId(capture_options.pid()), old_core_files);
 
+  orbit_grpc_protos::UnwindingCacheStats unwinding_cache_stats =
+      tracing_handler.GetUnwindingCacheStats();
+  ORBIT_LOG("Unwinding cache: %u hits, %u misses", unwinding_cache_stats.hit_count(),
+            unwinding_cache_stats.miss_count());
+
   FinalizeEventProcessing(stop_capture_reason, target_process_state.process_state,
-                          target_process_state.termination_signal);
+                          target_process_state.termination_signal, unwinding_cache_stats);
 
   TerminateCapture();
 }
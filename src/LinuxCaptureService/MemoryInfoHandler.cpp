@@ -6,6 +6,7 @@
 
 #include <sys/types.h>
 
+#include <memory>
 #include <utility>
 
 #include "GrpcProtos/Constants.h"
@@ -18,6 +19,20 @@
 namespace orbit_linux_capture_service {
 
 void MemoryInfoHandler::Start(const orbit_grpc_protos::CaptureOptions& capture_options) {
+  if (capture_options.pressure_stall_threshold_us() > 0) {
+    ORBIT_CHECK(pressure_stall_info_producer_ == nullptr);
+    pressure_stall_info_producer_ =
+        std::make_unique<orbit_memory_tracing::PressureStallInfoProducer>(
+            this, capture_options.pressure_stall_threshold_us(),
+            capture_options.pressure_stall_window_us(),
+            orbit_base::ToNativeProcessId(capture_options.pid()));
+    ErrorMessageOr<void> start_result = pressure_stall_info_producer_->Start();
+    if (start_result.has_error()) {
+      ORBIT_ERROR("Starting PressureStallInfoProducer: %s", start_result.error().message());
+      pressure_stall_info_producer_.reset();
+    }
+  }
+
   if (!capture_options.collect_memory_info()) return;
 
   SetSamplingStartTimestampNs(orbit_base::CaptureTimestampNs());
@@ -59,6 +74,11 @@ void MemoryInfoHandler::Stop() {
     process_memory_info_producer_->Stop();
     process_memory_info_producer_.reset();
   }
+
+  if (pressure_stall_info_producer_ != nullptr) {
+    pressure_stall_info_producer_->Stop();
+    pressure_stall_info_producer_.reset();
+  }
 }
 
 void MemoryInfoHandler::OnMemoryUsageEvent(orbit_grpc_protos::MemoryUsageEvent memory_usage_event) {
@@ -68,4 +88,12 @@ void MemoryInfoHandler::OnMemoryUsageEvent(orbit_grpc_protos::MemoryUsageEvent m
                                           std::move(event));
 }
 
+void MemoryInfoHandler::OnPressureStallEvent(
+    orbit_grpc_protos::PressureStallEvent pressure_stall_event) {
+  orbit_grpc_protos::ProducerCaptureEvent event;
+  *event.mutable_pressure_stall_event() = std::move(pressure_stall_event);
+  producer_event_processor_->ProcessEvent(orbit_grpc_protos::kMemoryInfoProducerId,
+                                          std::move(event));
+}
+
 }  // namespace orbit_linux_capture_service
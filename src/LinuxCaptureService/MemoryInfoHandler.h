@@ -10,6 +10,7 @@
 #include "GrpcProtos/capture.pb.h"
 #include "MemoryTracing/MemoryInfoListener.h"
 #include "MemoryTracing/MemoryInfoProducer.h"
+#include "MemoryTracing/PressureStallInfoProducer.h"
 #include "OrbitBase/Logging.h"
 #include "ProducerEventProcessor/ProducerEventProcessor.h"
 
@@ -18,8 +19,10 @@ namespace orbit_linux_capture_service {
 // This class controls the start and stop of the `MemoryInfoProducer`s. It receives the
 // `SystemMemoryUsage`, `CGroupMemoryUsage` and `ProcessMemoryUsage` events from different
 // `MemoryInfoProducer`s, gathers events collected in the same sampling window into a single
-// `MemoryUsageEvent` and then sends it to a `ProducerEventProcessor`.
-class MemoryInfoHandler : public orbit_memory_tracing::MemoryInfoListener {
+// `MemoryUsageEvent` and then sends it to a `ProducerEventProcessor`. It also controls the
+// `PressureStallInfoProducer` and forwards its `PressureStallEvent`s.
+class MemoryInfoHandler : public orbit_memory_tracing::MemoryInfoListener,
+                          public orbit_memory_tracing::PressureStallInfoListener {
  public:
   explicit MemoryInfoHandler(
       orbit_producer_event_processor::ProducerEventProcessor* producer_event_processor)
@@ -38,11 +41,13 @@ class MemoryInfoHandler : public orbit_memory_tracing::MemoryInfoListener {
 
  private:
   void OnMemoryUsageEvent(orbit_grpc_protos::MemoryUsageEvent memory_usage_event) override;
+  void OnPressureStallEvent(orbit_grpc_protos::PressureStallEvent pressure_stall_event) override;
 
   orbit_producer_event_processor::ProducerEventProcessor* producer_event_processor_;
   std::unique_ptr<orbit_memory_tracing::MemoryInfoProducer> cgroup_memory_info_producer_;
   std::unique_ptr<orbit_memory_tracing::MemoryInfoProducer> process_memory_info_producer_;
   std::unique_ptr<orbit_memory_tracing::MemoryInfoProducer> system_memory_info_producer_;
+  std::unique_ptr<orbit_memory_tracing::PressureStallInfoProducer> pressure_stall_info_producer_;
 };
 
 }  // namespace orbit_linux_capture_service
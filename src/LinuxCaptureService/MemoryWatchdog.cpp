@@ -68,4 +68,21 @@ std::optional<uint64_t> ReadRssInBytesFromProcPidStat() {
   return rss_pages.value() * page_size_bytes;
 }
 
+MemoryWatchdogStep ComputeMemoryWatchdogStep(uint64_t rss_bytes,
+                                              uint64_t stop_capture_threshold_bytes) {
+  if (rss_bytes > stop_capture_threshold_bytes) return MemoryWatchdogStep::kStopCapture;
+  // Dividing first avoids overflowing with thresholds close to the maximum.
+  const uint64_t tenth_of_threshold_bytes = stop_capture_threshold_bytes / 10;
+  if (rss_bytes > 8 * tenth_of_threshold_bytes) {
+    return MemoryWatchdogStep::kDropLowPriorityProducers;
+  }
+  if (rss_bytes > 7 * tenth_of_threshold_bytes) {
+    return MemoryWatchdogStep::kDropThreadStateChangeCallstacks;
+  }
+  if (rss_bytes > 6 * tenth_of_threshold_bytes) {
+    return MemoryWatchdogStep::kReduceSamplingRate;
+  }
+  return MemoryWatchdogStep::kNone;
+}
+
 }  // namespace orbit_linux_capture_service
@@ -20,6 +20,22 @@ namespace orbit_linux_capture_service {
 
 [[nodiscard]] std::optional<uint64_t> ReadRssInBytesFromProcPidStat();
 
+// The steps that the memory watchdog takes, in this order, as the resident set size of OrbitService
+// approaches the threshold at which the capture is stopped. Shedding load first lets a capture
+// survive a transient backlog with reduced fidelity instead of being lost.
+enum class MemoryWatchdogStep {
+  kNone = 0,
+  kReduceSamplingRate,
+  kDropThreadStateChangeCallstacks,
+  kDropLowPriorityProducers,
+  kStopCapture,
+};
+
+// Returns the last step whose threshold `rss_bytes` exceeds. The thresholds are 60%, 70%, 80% and
+// 100% of `stop_capture_threshold_bytes`.
+[[nodiscard]] MemoryWatchdogStep ComputeMemoryWatchdogStep(uint64_t rss_bytes,
+                                                           uint64_t stop_capture_threshold_bytes);
+
 }  // namespace orbit_linux_capture_service
 
 #endif  // LINUX_CAPTURE_SERVICE_MEMORY_WATCHDOG_H_
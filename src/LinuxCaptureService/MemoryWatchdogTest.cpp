@@ -57,6 +57,21 @@ static void IncreaseRss(uint64_t amount_words) {
   }
 }
 
+TEST(MemoryWatchdog, ComputeMemoryWatchdogStep) {
+  constexpr uint64_t kThresholdBytes = 1000;
+  EXPECT_EQ(ComputeMemoryWatchdogStep(0, kThresholdBytes), MemoryWatchdogStep::kNone);
+  EXPECT_EQ(ComputeMemoryWatchdogStep(600, kThresholdBytes), MemoryWatchdogStep::kNone);
+  EXPECT_EQ(ComputeMemoryWatchdogStep(601, kThresholdBytes),
+            MemoryWatchdogStep::kReduceSamplingRate);
+  EXPECT_EQ(ComputeMemoryWatchdogStep(701, kThresholdBytes),
+            MemoryWatchdogStep::kDropThreadStateChangeCallstacks);
+  EXPECT_EQ(ComputeMemoryWatchdogStep(801, kThresholdBytes),
+            MemoryWatchdogStep::kDropLowPriorityProducers);
+  EXPECT_EQ(ComputeMemoryWatchdogStep(1000, kThresholdBytes),
+            MemoryWatchdogStep::kDropLowPriorityProducers);
+  EXPECT_EQ(ComputeMemoryWatchdogStep(1001, kThresholdBytes), MemoryWatchdogStep::kStopCapture);
+}
+
 TEST(MemoryWatchdog, ReadRssInBytesFromProcPidStatReturnsIncreasingValuesOnRssIncrease) {
   std::optional<uint64_t> rss = ReadRssInBytesFromProcPidStat();
   ASSERT_TRUE(rss.has_value());
@@ -17,7 +17,9 @@ using orbit_grpc_protos::CaptureOptions;
 using orbit_grpc_protos::FullAddressInfo;
 using orbit_grpc_protos::FullCallstackSample;
 using orbit_grpc_protos::FullGpuJob;
+using orbit_grpc_protos::FullPageFaultSample;
 using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::PerformanceCounterSample;
 using orbit_grpc_protos::ProducerCaptureEvent;
 using orbit_grpc_protos::SchedulingSlice;
 using orbit_grpc_protos::ThreadName;
@@ -28,8 +30,10 @@ using orbit_grpc_protos::kLinuxTracingProducerId;
 
 void TracingHandler::Start(
     const CaptureOptions& capture_options,
-    std::unique_ptr<UserSpaceInstrumentationAddressesImpl> user_space_instrumentation_addresses) {
+    std::unique_ptr<UserSpaceInstrumentationAddressesImpl> user_space_instrumentation_addresses,
+    FunctionCallSampler function_call_sampler) {
   ORBIT_CHECK(tracer_ == nullptr);
+  function_call_sampler_ = std::move(function_call_sampler);
 
   tracer_ = orbit_linux_tracing::Tracer::Create(
       capture_options, std::move(user_space_instrumentation_addresses), this);
@@ -63,7 +67,21 @@ void TracingHandler::OnCallstackSample(FullCallstackSample callstack_sample) {
   producer_event_processor_->ProcessEvent(kLinuxTracingProducerId, std::move(event));
 }
 
+void TracingHandler::OnPageFaultSample(FullPageFaultSample page_fault_sample) {
+  ProducerCaptureEvent event;
+  *event.mutable_full_page_fault_sample() = std::move(page_fault_sample);
+  producer_event_processor_->ProcessEvent(kLinuxTracingProducerId, std::move(event));
+}
+
+void TracingHandler::OnPerformanceCounterSample(
+    PerformanceCounterSample performance_counter_sample) {
+  ProducerCaptureEvent event;
+  *event.mutable_performance_counter_sample() = std::move(performance_counter_sample);
+  producer_event_processor_->ProcessEvent(kLinuxTracingProducerId, std::move(event));
+}
+
 void TracingHandler::OnFunctionCall(FunctionCall function_call) {
+  if (!function_call_sampler_.ShouldKeep(function_call)) return;
   ProducerCaptureEvent event;
   *event.mutable_function_call() = std::move(function_call);
   producer_event_processor_->ProcessEvent(kLinuxTracingProducerId, std::move(event));
@@ -140,6 +158,14 @@ void TracingHandler::OnOutOfOrderEventsDiscardedEvent(
   producer_event_processor_->ProcessEvent(kLinuxTracingProducerId, std::move(event));
 }
 
+void TracingHandler::OnPerfEventProcessingStatsEvent(
+    orbit_grpc_protos::PerfEventProcessingStatsEvent perf_event_processing_stats_event) {
+  orbit_grpc_protos::ProducerCaptureEvent event;
+  *event.mutable_perf_event_processing_stats_event() =
+      std::move(perf_event_processing_stats_event);
+  producer_event_processor_->ProcessEvent(kLinuxTracingProducerId, std::move(event));
+}
+
 void TracingHandler::OnWarningInstrumentingWithUprobesEvent(
     orbit_grpc_protos::WarningInstrumentingWithUprobesEvent
         warning_instrumenting_with_uprobes_event) {
@@ -149,4 +175,10 @@ void TracingHandler::OnWarningInstrumentingWithUprobesEvent(
   producer_event_processor_->ProcessEvent(kLinuxTracingProducerId, std::move(event));
 }
 
+void TracingHandler::OnWarningEvent(orbit_grpc_protos::WarningEvent warning_event) {
+  orbit_grpc_protos::ProducerCaptureEvent event;
+  *event.mutable_warning_event() = std::move(warning_event);
+  producer_event_processor_->ProcessEvent(kLinuxTracingProducerId, std::move(event));
+}
+
 }  // namespace orbit_linux_capture_service
@@ -12,6 +12,7 @@
 #include <memory>
 #include <string>
 
+#include "FunctionCallSampler.h"
 #include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/tracepoint.pb.h"
 #include "Introspection/Introspection.h"
@@ -39,13 +40,23 @@ class TracingHandler : public orbit_linux_tracing::TracerListener {
   TracingHandler(TracingHandler&&) = delete;
   TracingHandler& operator=(TracingHandler&&) = delete;
 
+  // FunctionCalls rejected by `function_call_sampler` are dropped.
   void Start(
       const orbit_grpc_protos::CaptureOptions& capture_options,
-      std::unique_ptr<UserSpaceInstrumentationAddressesImpl> user_space_instrumentation_addresses);
+      std::unique_ptr<UserSpaceInstrumentationAddressesImpl> user_space_instrumentation_addresses,
+      FunctionCallSampler function_call_sampler);
   void Stop();
 
+  // Only meaningful after Stop() has returned.
+  [[nodiscard]] orbit_grpc_protos::UnwindingCacheStats GetUnwindingCacheStats() const {
+    return tracer_->GetUnwindingCacheStats();
+  }
+
   void OnSchedulingSlice(orbit_grpc_protos::SchedulingSlice scheduling_slice) override;
   void OnCallstackSample(orbit_grpc_protos::FullCallstackSample callstack_sample) override;
+  void OnPageFaultSample(orbit_grpc_protos::FullPageFaultSample page_fault_sample) override;
+  void OnPerformanceCounterSample(
+      orbit_grpc_protos::PerformanceCounterSample performance_counter_sample) override;
   void OnThreadStateSliceCallstack(orbit_grpc_protos::ThreadStateSliceCallstack callstack) override;
   void OnFunctionCall(orbit_grpc_protos::FunctionCall function_call) override;
   void OnGpuJob(orbit_grpc_protos::FullGpuJob gpu_job) override;
@@ -62,9 +73,16 @@ class TracingHandler : public orbit_linux_tracing::TracerListener {
       orbit_grpc_protos::LostPerfRecordsEvent lost_perf_records_event) override;
   void OnOutOfOrderEventsDiscardedEvent(orbit_grpc_protos::OutOfOrderEventsDiscardedEvent
                                             out_of_order_events_discarded_event) override;
+  void OnPerfEventProcessingStatsEvent(orbit_grpc_protos::PerfEventProcessingStatsEvent
+                                           perf_event_processing_stats_event) override;
   void OnWarningInstrumentingWithUprobesEvent(
       orbit_grpc_protos::WarningInstrumentingWithUprobesEvent
           warning_instrumenting_with_uprobes_event) override;
+  void OnWarningEvent(orbit_grpc_protos::WarningEvent warning_event) override;
+
+  // Only valid between Start() and Stop(). See orbit_linux_tracing::Tracer.
+  void ReduceSamplingRate(uint32_t factor) { tracer_->ReduceSamplingRate(factor); }
+  void DropThreadStateChangeCallstacks() { tracer_->DropThreadStateChangeCallstacks(); }
 
   void ProcessFunctionEntry(const orbit_grpc_protos::FunctionEntry& function_entry) {
     tracer_->ProcessFunctionEntry(function_entry);
@@ -76,6 +94,7 @@ class TracingHandler : public orbit_linux_tracing::TracerListener {
  private:
   orbit_producer_event_processor::ProducerEventProcessor* producer_event_processor_;
   std::unique_ptr<orbit_linux_tracing::Tracer> tracer_;
+  FunctionCallSampler function_call_sampler_;
 };
 
 }  // namespace orbit_linux_capture_service
@@ -23,12 +23,15 @@
 
 namespace orbit_linux_capture_service {
 
+class TracingHandler;
+
 // This class is gRPC-free and provides common functionality that is shared by the native Orbit
 // Linux capture service and the cloud collector.
 class LinuxCaptureServiceBase : public orbit_capture_service_base::CaptureServiceBase {
  public:
   LinuxCaptureServiceBase() {
-    instrumentation_manager_ = orbit_user_space_instrumentation::InstrumentationManager::Create();
+    instrumentation_manager_ = orbit_user_space_instrumentation::InstrumentationManager::Create(
+        kRelocatedPrologueCacheDirectory);
   }
 
   ~LinuxCaptureServiceBase() {
@@ -45,6 +48,10 @@ class LinuxCaptureServiceBase : public orbit_capture_service_base::CaptureServic
                      stop_capture_request_waiter);
 
  private:
+  // Where user space instrumentation keeps the relocated function prologues across runs.
+  static constexpr const char* kRelocatedPrologueCacheDirectory =
+      "/var/cache/OrbitService/RelocatedPrologues";
+
   std::unique_ptr<orbit_user_space_instrumentation::InstrumentationManager>
       instrumentation_manager_;
 
@@ -56,7 +63,11 @@ class LinuxCaptureServiceBase : public orbit_capture_service_base::CaptureServic
   //   CloudCollectorStartStopCaptureRequestWaiter::StopCapture is called.
   // - The resident set size of the current process exceeds the threshold (i.e., total physical
   //   memory / 2).
+  // Before that, as the resident set size approaches the threshold, the load is progressively shed
+  // using `tracing_handler` and producer_event_processor_, see MemoryWatchdogStep. The same steps,
+  // except stopping the capture, are also taken while the client reports a sustained backlog.
   [[nodiscard]] StopCaptureReason WaitForStopCaptureRequestOrMemoryThresholdExceeded(
+      const orbit_grpc_protos::CaptureOptions& capture_options, TracingHandler* tracing_handler,
       const std::shared_ptr<orbit_capture_service_base::StopCaptureRequestWaiter>&
           stop_capture_request_waiter);
   std::thread wait_for_stop_capture_request_thread_;
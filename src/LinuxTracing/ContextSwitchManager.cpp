@@ -4,7 +4,6 @@
 
 #include "ContextSwitchManager.h"
 
-#include <absl/meta/type_traits.h>
 #include <stdint.h>
 
 #include "OrbitBase/Logging.h"
@@ -17,25 +16,28 @@ void ContextSwitchManager::ProcessContextSwitchIn(std::optional<pid_t> pid, pid_
                                                   uint16_t core, uint64_t timestamp_ns) {
   // In case of lost out switches, a previous OpenSwitchIn for this core can be already present.
   // Simply overwrite it.
-  open_switches_by_core_.emplace(core, OpenSwitchIn{pid, tid, timestamp_ns});
+  if (core >= open_switches_by_core_.size()) {
+    open_switches_by_core_.resize(core + 1);
+  }
+  open_switches_by_core_[core].emplace(pid, tid, timestamp_ns);
 }
 
 std::optional<SchedulingSlice> ContextSwitchManager::ProcessContextSwitchOut(
     pid_t pid, pid_t tid, uint16_t core, uint64_t timestamp_ns) {
-  auto open_switch_it = open_switches_by_core_.find(core);
   // This can happen at the beginning or in case of lost in switches.
-  if (open_switch_it == open_switches_by_core_.end()) {
+  if (core >= open_switches_by_core_.size() || !open_switches_by_core_[core].has_value()) {
     return std::nullopt;
   }
+  std::optional<OpenSwitchIn>& open_switch = open_switches_by_core_[core];
 
-  std::optional<pid_t> open_pid = open_switch_it->second.pid;
-  pid_t open_tid = open_switch_it->second.tid;
-  uint64_t open_timestamp_ns = open_switch_it->second.timestamp_ns;
+  std::optional<pid_t> open_pid = open_switch->pid;
+  pid_t open_tid = open_switch->tid;
+  uint64_t open_timestamp_ns = open_switch->timestamp_ns;
 
   ORBIT_CHECK(timestamp_ns >= open_timestamp_ns);
 
   // Remove the OpenSwitchIn for this core before returning, as it will have been processed.
-  open_switches_by_core_.erase(core);
+  open_switch.reset();
 
   // This can happen in case of lost in/out switches.
   if ((open_pid.has_value() && pid != -1 && open_pid.value() != pid) || open_tid != tid) {
@@ -5,13 +5,12 @@
 #ifndef LINUX_TRACING_CONTEXT_SWITCH_MANAGER_H_
 #define LINUX_TRACING_CONTEXT_SWITCH_MANAGER_H_
 
-#include <absl/container/flat_hash_map.h>
-#include <absl/hash/hash.h>
 #include <stdint.h>
 #include <sys/types.h>
 
 #include <cstdint>
 #include <optional>
+#include <vector>
 
 #include "GrpcProtos/capture.pb.h"
 
@@ -20,6 +19,8 @@ namespace orbit_linux_tracing {
 // For each core, keeps the last context switch into a process and matches it
 // with the next context switch away from a process to produce SchedulingSlice
 // events. It assumes that context switches for the same core come in order.
+// Context switches are the most frequent events, so the open switches are kept in a vector indexed
+// by core instead of a hash map.
 class ContextSwitchManager {
  public:
   ContextSwitchManager() = default;
@@ -46,7 +47,8 @@ class ContextSwitchManager {
     uint64_t timestamp_ns;
   };
 
-  absl::flat_hash_map<uint16_t, OpenSwitchIn> open_switches_by_core_;
+  // Grows on demand to accommodate the highest core seen so far.
+  std::vector<std::optional<OpenSwitchIn>> open_switches_by_core_;
 };
 
 }  // namespace orbit_linux_tracing
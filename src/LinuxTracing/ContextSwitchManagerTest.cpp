@@ -240,6 +240,61 @@ TEST(ContextSwitchManager, TwoCoresOutOnDifferentCore) {
   ASSERT_FALSE(processed_scheduling_slice.has_value());
 }
 
+TEST(ContextSwitchManager, OneCoreOutMissing) {
+  constexpr pid_t kPid1 = 42;
+  constexpr pid_t kTid1 = 43;
+  constexpr pid_t kPid2 = 52;
+  constexpr pid_t kTid2 = 53;
+  constexpr uint16_t kCore = 1;
+  std::optional<SchedulingSlice> processed_scheduling_slice;
+  ContextSwitchManager context_switch_manager;
+
+  context_switch_manager.ProcessContextSwitchIn(kPid1, kTid1, kCore, 100);
+  context_switch_manager.ProcessContextSwitchIn(kPid2, kTid2, kCore, 102);
+
+  processed_scheduling_slice =
+      context_switch_manager.ProcessContextSwitchOut(kPid2, kTid2, kCore, 103);
+  ASSERT_TRUE(processed_scheduling_slice.has_value());
+  EXPECT_EQ(processed_scheduling_slice.value().pid(), kPid2);
+  EXPECT_EQ(processed_scheduling_slice.value().tid(), kTid2);
+  EXPECT_EQ(processed_scheduling_slice.value().core(), kCore);
+  EXPECT_EQ(processed_scheduling_slice.value().duration_ns(), 1);
+  EXPECT_EQ(processed_scheduling_slice.value().out_timestamp_ns(), 103);
+}
+
+TEST(ContextSwitchManager, HighCoreThenLowCore) {
+  constexpr pid_t kPid1 = 42;
+  constexpr pid_t kTid1 = 43;
+  constexpr uint16_t kCore1 = 511;
+  constexpr pid_t kPid2 = 52;
+  constexpr pid_t kTid2 = 53;
+  constexpr uint16_t kCore2 = 0;
+  std::optional<SchedulingSlice> processed_scheduling_slice;
+  ContextSwitchManager context_switch_manager;
+
+  context_switch_manager.ProcessContextSwitchIn(kPid1, kTid1, kCore1, 100);
+
+  processed_scheduling_slice =
+      context_switch_manager.ProcessContextSwitchOut(kPid2, kTid2, kCore2, 101);
+  ASSERT_FALSE(processed_scheduling_slice.has_value());
+
+  context_switch_manager.ProcessContextSwitchIn(kPid2, kTid2, kCore2, 102);
+
+  processed_scheduling_slice =
+      context_switch_manager.ProcessContextSwitchOut(kPid1, kTid1, kCore1, 103);
+  ASSERT_TRUE(processed_scheduling_slice.has_value());
+  EXPECT_EQ(processed_scheduling_slice.value().tid(), kTid1);
+  EXPECT_EQ(processed_scheduling_slice.value().core(), kCore1);
+  EXPECT_EQ(processed_scheduling_slice.value().duration_ns(), 3);
+
+  processed_scheduling_slice =
+      context_switch_manager.ProcessContextSwitchOut(kPid2, kTid2, kCore2, 104);
+  ASSERT_TRUE(processed_scheduling_slice.has_value());
+  EXPECT_EQ(processed_scheduling_slice.value().tid(), kTid2);
+  EXPECT_EQ(processed_scheduling_slice.value().core(), kCore2);
+  EXPECT_EQ(processed_scheduling_slice.value().duration_ns(), 2);
+}
+
 TEST(ContextSwitchManager, OneCoreOutOfOrder) {
   constexpr pid_t kPid = 42;
   constexpr pid_t kTid = 43;
@@ -7,6 +7,7 @@
 #include <sys/mman.h>
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -19,6 +20,37 @@
 #include "unwindstack/RegsX86_64.h"
 
 namespace orbit_linux_tracing {
+
+namespace {
+
+[[nodiscard]] bool IsExecutable(LibunwindstackMaps* maps, uint64_t address) {
+  std::shared_ptr<unwindstack::MapInfo> map_info = maps->Find(address);
+  return map_info != nullptr && (map_info->flags() & PROT_EXEC) != 0;
+}
+
+// Inserts `caller_pc` right after the innermost user-space frame, i.e., the leaf function.
+template <typename CallchainPerfEventDataT>
+void InsertCallerOfLeafFunction(const CallchainPerfEventDataT* event_data, uint64_t caller_pc) {
+  const std::vector<uint64_t> original_callchain = event_data->CopyOfIpsAsVector();
+  ORBIT_CHECK(original_callchain.size() >= 2);
+
+  std::vector<uint64_t> result;
+  result.reserve(original_callchain.size() + 1);
+  for (size_t i = 0; i < 2; ++i) {
+    result.push_back(original_callchain[i]);
+  }
+
+  result.push_back(caller_pc);
+
+  for (size_t i = 2; i < original_callchain.size(); ++i) {
+    result.push_back(original_callchain[i]);
+  }
+
+  event_data->SetIps(result);
+}
+
+}  // namespace
+
 template <typename CallchainPerfEventDataT>
 orbit_grpc_protos::Callstack::CallstackType LeafFunctionCallManager::PatchCallerOfLeafFunctionImpl(
     const CallchainPerfEventDataT* event_data, LibunwindstackMaps* current_maps,
@@ -49,6 +81,26 @@ orbit_grpc_protos::Callstack::CallstackType LeafFunctionCallManager::PatchCaller
     return orbit_grpc_protos::Callstack::kComplete;
   }
 
+  // Fast path: if the function has not set up a frame at the current instruction, the call frame
+  // information tells where the return address is on the stack, relative to $rsp. Then the caller
+  // can be read directly from the stack sample, without unwinding.
+  std::optional<uint64_t> return_address_offset_from_sp =
+      unwinder->GetReturnAddressOffsetFromSpWithoutFrameSetup(
+          rip, event_data->GetCallstackPidOrMinusOne(), current_maps->Get());
+  if (return_address_offset_from_sp.has_value()) {
+    if (*return_address_offset_from_sp + sizeof(uint64_t) > stack_dump_size_) {
+      return orbit_grpc_protos::Callstack::kStackTopForDwarfUnwindingTooSmall;
+    }
+    uint64_t return_address;
+    std::memcpy(&return_address, event_data->GetStackData() + *return_address_offset_from_sp,
+                sizeof(return_address));
+    if (!IsExecutable(current_maps, return_address)) {
+      return orbit_grpc_protos::Callstack::kStackTopDwarfUnwindingError;
+    }
+    InsertCallerOfLeafFunction(event_data, return_address);
+    return orbit_grpc_protos::Callstack::kComplete;
+  }
+
   // Perform one unwinding step. We will only need the memory from $rbp + 16 to $rsp (ensure to
   // include the previous frame pointer and the return address) for unwinding. If $rbp does not
   // change from unwinding, we need to patch in the pc after unwinding.
@@ -96,21 +148,10 @@ orbit_grpc_protos::Callstack::CallstackType LeafFunctionCallManager::PatchCaller
 
   // $rbp did non change during unwinding, i.e. we are in a leaf function. We need to patch in the
   // missing caller, which is the updated pc from unwinding.
-  const std::vector<uint64_t> original_callchain = event_data->CopyOfIpsAsVector();
-  ORBIT_CHECK(original_callchain.size() >= 2);
-
-  std::vector<uint64_t> result;
-  result.reserve(original_callchain.size() + 1);
-  for (size_t i = 0; i < 2; ++i) {
-    result.push_back(original_callchain[i]);
-  }
-
   uint64_t libunwindstack_leaf_caller_pc = new_regs.pc();
 
   // If the caller is not executable, we have an unwinding error.
-  std::shared_ptr<unwindstack::MapInfo> caller_map_info =
-      current_maps->Find(libunwindstack_leaf_caller_pc);
-  if (caller_map_info == nullptr || (caller_map_info->flags() & PROT_EXEC) == 0) {
+  if (!IsExecutable(current_maps, libunwindstack_leaf_caller_pc)) {
     // As above, if the error was because the stack sample was too small, the user can act and
     // increase the stack size. So we report that case separately.
     if (stack_size > stack_dump_size_) {
@@ -119,13 +160,7 @@ orbit_grpc_protos::Callstack::CallstackType LeafFunctionCallManager::PatchCaller
     return orbit_grpc_protos::Callstack::kStackTopDwarfUnwindingError;
   }
 
-  result.push_back(libunwindstack_leaf_caller_pc);
-
-  for (size_t i = 2; i < original_callchain.size(); ++i) {
-    result.push_back(original_callchain[i]);
-  }
-
-  event_data->SetIps(result);
+  InsertCallerOfLeafFunction(event_data, libunwindstack_leaf_caller_pc);
 
   return orbit_grpc_protos::Callstack::kComplete;
 }
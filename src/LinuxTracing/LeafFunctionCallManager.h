@@ -52,8 +52,12 @@ class LeafFunctionCallManager {
   }
 
  private:
-  // Let's unwind one frame using libunwindstack. With that unwinding step, the registers will get
-  // updated and we can detect if $rbp was modified.
+  // If the call frame information says that the function has not set up a frame at the current
+  // instruction, $rbp was not modified and the return address is at a known offset from $rsp. This
+  // holds for most samples in leaf functions, so in that case we read the caller directly from the
+  // stack sample instead of unwinding.
+  // Otherwise, let's unwind one frame using libunwindstack. With that unwinding step, the registers
+  // will get updated and we can detect if $rbp was modified.
   // (1) If $rbp did not change: We are in a leaf function, which has not modified $rbp. The
   // leaf's
   //     caller is missing in the callchain and needs to be patched in. The updated $rip (pc) from
@@ -74,6 +74,10 @@ class MockLibunwindstackUnwinder : public LibunwindstackUnwinder {
               (override));
   MOCK_METHOD(std::optional<bool>, HasFramePointerSet, (uint64_t, pid_t, unwindstack::Maps*),
               (override));
+  MOCK_METHOD(std::optional<uint64_t>, GetReturnAddressOffsetFromSpWithoutFrameSetup,
+              (uint64_t, pid_t, unwindstack::Maps*), (override));
+  MOCK_METHOD(void, ClearUnwindingCache, (), (override));
+  MOCK_METHOD(UnwindingCacheStats, GetUnwindingCacheStats, (), (const, override));
 };
 
 class LeafFunctionCallManagerTest : public ::testing::Test {
@@ -593,4 +597,113 @@ TEST_F(LeafFunctionCallManagerTest,
   EXPECT_EQ(event_data.GetCallchainSize(), callchain.size() + 1);
 }
 
+TEST_F(LeafFunctionCallManagerTest,
+       PatchCallerOfLeafFunctionPatchesCallchainFromStackSampleWithoutUnwindingWithoutFrameSetup) {
+  std::vector<uint64_t> callchain;
+  callchain.push_back(kKernelAddress);
+  callchain.push_back(kTargetAddress1);
+  // Increment by one as the return address is the next address.
+  callchain.push_back(kTargetAddress3 + 1);
+
+  CallchainSamplePerfEventData event_data = BuildFakeCallchainSamplePerfEventData(callchain);
+  RingBufferSampleRegsUserAll regs{};
+  regs.bp = kStackDumpSize / 2;
+  regs.sp = 10;
+  regs.ip = kTargetAddress1;
+  std::memcpy(event_data.regs.get(), &regs, sizeof(regs));
+
+  constexpr uint64_t kReturnAddressOffsetFromSp = 16;
+  event_data.data = make_unique_for_overwrite<uint8_t[]>(kStackDumpSize);
+  std::memset(event_data.data.get(), 0, kStackDumpSize);
+  const uint64_t return_address = kTargetAddress2 + 1;
+  std::memcpy(event_data.data.get() + kReturnAddressOffsetFromSp, &return_address,
+              sizeof(return_address));
+
+  unwindstack::Maps fake_maps{};
+  EXPECT_CALL(maps_, Get()).WillRepeatedly(Return(&fake_maps));
+  EXPECT_CALL(unwinder_, HasFramePointerSet(kTargetAddress1, _, &fake_maps))
+      .Times(1)
+      .WillOnce(Return(std::make_optional<bool>(false)));
+  EXPECT_CALL(unwinder_,
+              GetReturnAddressOffsetFromSpWithoutFrameSetup(kTargetAddress1, _, &fake_maps))
+      .Times(1)
+      .WillOnce(Return(std::make_optional<uint64_t>(kReturnAddressOffsetFromSp)));
+  EXPECT_CALL(unwinder_, Unwind).Times(0);
+
+  EXPECT_EQ(Callstack::kComplete,
+            leaf_function_call_manager_.PatchCallerOfLeafFunction(&event_data, &maps_, &unwinder_));
+
+  EXPECT_THAT(
+      event_data.CopyOfIpsAsVector(),
+      ElementsAre(kKernelAddress, kTargetAddress1, kTargetAddress2 + 1, kTargetAddress3 + 1));
+}
+
+TEST_F(LeafFunctionCallManagerTest,
+       PatchCallerOfLeafFunctionReturnsErrorWhenReturnAddressWithoutFrameSetupIsNotInStackSample) {
+  std::vector<uint64_t> callchain;
+  callchain.push_back(kKernelAddress);
+  callchain.push_back(kTargetAddress1);
+  // Increment by one as the return address is the next address.
+  callchain.push_back(kTargetAddress3 + 1);
+
+  CallchainSamplePerfEventData event_data = BuildFakeCallchainSamplePerfEventData(callchain);
+  RingBufferSampleRegsUserAll regs{};
+  regs.bp = kStackDumpSize / 2;
+  regs.sp = 10;
+  regs.ip = kTargetAddress1;
+  std::memcpy(event_data.regs.get(), &regs, sizeof(regs));
+
+  unwindstack::Maps fake_maps{};
+  EXPECT_CALL(maps_, Get()).WillRepeatedly(Return(&fake_maps));
+  EXPECT_CALL(unwinder_, HasFramePointerSet(kTargetAddress1, _, &fake_maps))
+      .Times(1)
+      .WillOnce(Return(std::make_optional<bool>(false)));
+  EXPECT_CALL(unwinder_,
+              GetReturnAddressOffsetFromSpWithoutFrameSetup(kTargetAddress1, _, &fake_maps))
+      .Times(1)
+      .WillOnce(Return(std::make_optional<uint64_t>(kStackDumpSize)));
+  EXPECT_CALL(unwinder_, Unwind).Times(0);
+
+  EXPECT_EQ(Callstack::kStackTopForDwarfUnwindingTooSmall,
+            leaf_function_call_manager_.PatchCallerOfLeafFunction(&event_data, &maps_, &unwinder_));
+
+  EXPECT_THAT(event_data.CopyOfIpsAsVector(), ElementsAreArray(callchain));
+}
+
+TEST_F(LeafFunctionCallManagerTest,
+       PatchCallerOfLeafFunctionReturnsErrorWhenReturnAddressWithoutFrameSetupIsNotExecutable) {
+  std::vector<uint64_t> callchain;
+  callchain.push_back(kKernelAddress);
+  callchain.push_back(kTargetAddress1);
+  // Increment by one as the return address is the next address.
+  callchain.push_back(kTargetAddress3 + 1);
+
+  CallchainSamplePerfEventData event_data = BuildFakeCallchainSamplePerfEventData(callchain);
+  RingBufferSampleRegsUserAll regs{};
+  regs.bp = kStackDumpSize / 2;
+  regs.sp = 10;
+  regs.ip = kTargetAddress1;
+  std::memcpy(event_data.regs.get(), &regs, sizeof(regs));
+
+  event_data.data = make_unique_for_overwrite<uint8_t[]>(kStackDumpSize);
+  const uint64_t return_address = kNonExecutableMapsStart;
+  std::memcpy(event_data.data.get(), &return_address, sizeof(return_address));
+
+  unwindstack::Maps fake_maps{};
+  EXPECT_CALL(maps_, Get()).WillRepeatedly(Return(&fake_maps));
+  EXPECT_CALL(unwinder_, HasFramePointerSet(kTargetAddress1, _, &fake_maps))
+      .Times(1)
+      .WillOnce(Return(std::make_optional<bool>(false)));
+  EXPECT_CALL(unwinder_,
+              GetReturnAddressOffsetFromSpWithoutFrameSetup(kTargetAddress1, _, &fake_maps))
+      .Times(1)
+      .WillOnce(Return(std::make_optional<uint64_t>(0)));
+  EXPECT_CALL(unwinder_, Unwind).Times(0);
+
+  EXPECT_EQ(Callstack::kStackTopDwarfUnwindingError,
+            leaf_function_call_manager_.PatchCallerOfLeafFunction(&event_data, &maps_, &unwinder_));
+
+  EXPECT_THAT(event_data.CopyOfIpsAsVector(), ElementsAreArray(callchain));
+}
+
 }  // namespace orbit_linux_tracing
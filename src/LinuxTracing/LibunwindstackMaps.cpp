@@ -31,9 +31,45 @@ class LibunwindstackMapsImpl : public LibunwindstackMaps {
                   std::string_view name) override;
 
  private:
+  // Inserts before `pos` the part [start, end) of `original` that is still mapped after a new map
+  // overlapped `original`, and returns an iterator pointing to it.
+  unwindstack::Maps::iterator InsertRemainderOf(
+      unwindstack::Maps::iterator pos, const std::shared_ptr<unwindstack::MapInfo>& original,
+      uint64_t start, uint64_t end);
+
   std::unique_ptr<unwindstack::BufferMaps> maps_;
 };
 
+[[nodiscard]] bool IsFileMapping(unwindstack::MapInfo* map_info) {
+  return !map_info->name().empty() && map_info->name().c_str()[0] != '[';
+}
+
+unwindstack::Maps::iterator LibunwindstackMapsImpl::InsertRemainderOf(
+    unwindstack::Maps::iterator pos, const std::shared_ptr<unwindstack::MapInfo>& original,
+    uint64_t start, uint64_t end) {
+  const bool is_file_mapping = IsFileMapping(original.get());
+  // A remainder of a file mapping still maps the same part of the file at the same addresses, so
+  // its offset moves with its start.
+  const uint64_t offset_delta = start - original->start();
+  const uint64_t offset =
+      (is_file_mapping || offset_delta == 0) ? original->offset() + offset_delta : 0;
+  auto map_info_it = maps_->Insert(pos, start, end, offset, original->flags(), original->name());
+
+  // Re-creating the Object from the file would throw away the unwind information that
+  // libunwindstack has already parsed and cached for `original`. As the remainder maps the same
+  // file at the same addresses, it can share the Object, with the offset from the start of the
+  // Object moved by the same amount, so that the relative pcs stay the same.
+  if (is_file_mapping && original->object() != nullptr) {
+    std::shared_ptr<unwindstack::MapInfo>& remainder = *map_info_it;
+    remainder->set_object(original->object());
+    remainder->set_object_offset(original->object_offset() + offset_delta);
+    remainder->set_object_start_offset(original->object_start_offset());
+    remainder->set_load_bias(original->load_bias());
+    remainder->set_memory_backed_object(original->memory_backed_object());
+  }
+  return map_info_it;
+}
+
 void LibunwindstackMapsImpl::AddAndSort(uint64_t start, uint64_t end, uint64_t offset,
                                         uint64_t flags, std::string_view name) {
   // First, remove existing maps that are fully contained in the new map, and resize or split
@@ -65,31 +101,31 @@ void LibunwindstackMapsImpl::AddAndSort(uint64_t start, uint64_t end, uint64_t o
       return;
     }
 
+    if (start == map_info->start() && end == map_info->end() && offset == map_info->offset() &&
+        flags == map_info->flags() && name == std::string_view{map_info->name()}) {
+      // The new map is the same as map_info, e.g., because the mapping was reported again. Keep
+      // map_info, and with it the Object and the unwind information it has already loaded.
+      return;
+    }
+
     if (start <= map_info->start() && end >= map_info->end()) {
       // The new map encloses map_info. Remove map_info.
       map_info_it = maps_->erase(map_info_it);
 
     } else if (start <= map_info->start()) {
-      uint64_t new_offset = 0;
-      if (!map_info->name().empty() && map_info->name().c_str()[0] != '[') {
-        // This was a file mapping: update the offset.
-        new_offset = map_info->offset() + (end - map_info->start());
-      }
       // The new map intersects the first part of map_info. Keep the second part of map_info but add
       // the new map before it.
       map_info_it = maps_->erase(map_info_it);
       map_info_it = maps_->Insert(map_info_it, start, end, offset, flags, std::string{name});
       ++map_info_it;
-      maps_->Insert(map_info_it, end, map_info->end(), new_offset, map_info->flags(),
-                    map_info->name());
+      InsertRemainderOf(map_info_it, map_info, end, map_info->end());
       // The new map will not intersect any other existing map, so stop.
       return;
 
     } else if (end >= map_info->end()) {
       // The new map intersects the second part of map_info. Keep the first part of map_info.
       map_info_it = maps_->erase(map_info_it);
-      map_info_it = maps_->Insert(map_info_it, map_info->start(), start, map_info->offset(),
-                                  map_info->flags(), map_info->name());
+      map_info_it = InsertRemainderOf(map_info_it, map_info, map_info->start(), start);
       ++map_info_it;
 
     } else {
@@ -99,8 +135,7 @@ void LibunwindstackMapsImpl::AddAndSort(uint64_t start, uint64_t end, uint64_t o
       map_info_it = maps_->erase(map_info_it);
       {
         // Keep the first part of map_info.
-        map_info_it = maps_->Insert(map_info_it, map_info->start(), start, map_info->offset(),
-                                    map_info->flags(), map_info->name());
+        map_info_it = InsertRemainderOf(map_info_it, map_info, map_info->start(), start);
         ++map_info_it;
       }
       {
@@ -110,13 +145,7 @@ void LibunwindstackMapsImpl::AddAndSort(uint64_t start, uint64_t end, uint64_t o
       }
       {
         // Keep the last part of map_info.
-        uint64_t new_offset = 0;
-        if (!map_info->name().empty() && map_info->name().c_str()[0] != '[') {
-          // This was a file mapping: update the offset.
-          new_offset = map_info->offset() + (end - map_info->start());
-        }
-        maps_->Insert(map_info_it, end, map_info->end(), new_offset, map_info->flags(),
-                      map_info->name());
+        InsertRemainderOf(map_info_it, map_info, end, map_info->end());
       }
       // The new map will not intersect any other existing map, so stop.
       return;
@@ -17,6 +17,9 @@ namespace orbit_linux_tracing {
 
 // Wrapper around unwindstack::Maps that simplifies keeping the initial snapshot up to date when new
 // mappings are created. It also handles the case of new mappings overlapping existing ones.
+// AddAndSort leaves the MapInfos that the new mapping doesn't overlap untouched, keeps an existing
+// MapInfo that is the same as the new mapping, and lets the remainders of a file mapping that was
+// partially overlapped share its Object, so that the unwind information already loaded is kept.
 class LibunwindstackMaps {
  public:
   virtual ~LibunwindstackMaps() = default;
@@ -12,6 +12,7 @@
 #include <string_view>
 
 #include "LibunwindstackMaps.h"
+#include "unwindstack/Elf.h"
 #include "unwindstack/MapInfo.h"
 #include "unwindstack/Maps.h"
 #include "unwindstack/SharedString.h"
@@ -231,4 +232,55 @@ TEST(LibunwindstackMaps, AddAndSortIntoEmpty) {
                                             "/path/to/newfile", nullptr, nullptr));
 }
 
+TEST(LibunwindstackMaps, AddAndSortKeepsTheSameMap) {
+  std::unique_ptr<LibunwindstackMaps> libunwindstack_maps =
+      LibunwindstackMaps::ParseMaps(kMapsInitialContent);
+  ASSERT_NE(libunwindstack_maps, nullptr);
+  unwindstack::Maps* maps = libunwindstack_maps->Get();
+  ASSERT_NE(maps, nullptr);
+  std::shared_ptr<unwindstack::MapInfo> file_map_info = maps->Get(0);
+
+  libunwindstack_maps->AddAndSort(0x101000, 0x104000, 0x1000, PROT_READ, "/path/to/file");
+  ASSERT_EQ(maps->Total(), 3);
+  EXPECT_EQ(maps->Get(0), file_map_info);
+
+  // A different map at the same addresses replaces the existing one.
+  libunwindstack_maps->AddAndSort(0x101000, 0x104000, 0x1000, PROT_READ | PROT_EXEC,
+                                  "/path/to/file");
+  ASSERT_EQ(maps->Total(), 3);
+  EXPECT_NE(maps->Get(0), file_map_info);
+  EXPECT_THAT(maps->Get(0).get(), MapInfoEq(0x101000, 0x104000, 0x1000, PROT_READ | PROT_EXEC,
+                                            "/path/to/file", nullptr, maps->Get(1)));
+}
+
+TEST(LibunwindstackMaps, AddAndSortSharesTheObjectOfTheRemaindersOfAFileMap) {
+  std::unique_ptr<LibunwindstackMaps> libunwindstack_maps =
+      LibunwindstackMaps::ParseMaps(kMapsInitialContent);
+  ASSERT_NE(libunwindstack_maps, nullptr);
+  unwindstack::Maps* maps = libunwindstack_maps->Get();
+  ASSERT_NE(maps, nullptr);
+  std::shared_ptr<unwindstack::Object> object = std::make_shared<unwindstack::Elf>(nullptr);
+  maps->Get(0)->set_object(object);
+  maps->Get(0)->set_object_offset(0x1000);
+  maps->Get(0)->set_load_bias(0x100);
+
+  libunwindstack_maps->AddAndSort(0x102000, 0x103000, 0x7000, PROT_READ | PROT_WRITE,
+                                  "/path/to/newfile");
+  ASSERT_EQ(maps->Total(), 5);
+
+  EXPECT_THAT(maps->Get(0).get(), MapInfoEq(0x101000, 0x102000, 0x1000, PROT_READ, "/path/to/file",
+                                            nullptr, maps->Get(1)));
+  EXPECT_EQ(maps->Get(0)->object(), object);
+  EXPECT_EQ(maps->Get(0)->object_offset(), 0x1000);
+  EXPECT_EQ(maps->Get(0)->load_bias(), 0x100);
+
+  EXPECT_EQ(maps->Get(1)->object(), nullptr);
+
+  EXPECT_THAT(maps->Get(2).get(), MapInfoEq(0x103000, 0x104000, 0x3000, PROT_READ, "/path/to/file",
+                                            maps->Get(1), maps->Get(3)));
+  EXPECT_EQ(maps->Get(2)->object(), object);
+  EXPECT_EQ(maps->Get(2)->object_offset(), 0x3000);
+  EXPECT_EQ(maps->Get(2)->load_bias(), 0x100);
+}
+
 }  // namespace orbit_linux_tracing
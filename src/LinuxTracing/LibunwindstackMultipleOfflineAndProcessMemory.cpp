@@ -5,7 +5,10 @@
 #include "LibunwindstackMultipleOfflineAndProcessMemory.h"
 
 #include <absl/types/span.h>
+#include <sys/mman.h>
 
+#include "unwindstack/MapInfo.h"
+#include "unwindstack/Maps.h"
 #include "unwindstack/Memory.h"
 
 namespace orbit_linux_tracing {
@@ -39,6 +42,9 @@ size_t LibunwindstackMultipleOfflineAndProcessMemory::Read(uint64_t addr, void*
 
   // If the requested range is entirely disjoint from the stack slices' address range, read from
   // the memory of the process.
+  if (process_memory_read_cache_ != nullptr && IsInNonWritableMapping(addr_start, addr_end)) {
+    return process_memory_read_cache_->Read(addr, dst, size);
+  }
   if (process_memory_ != nullptr) {
     return process_memory_->Read(addr, dst, size);
   }
@@ -46,6 +52,14 @@ size_t LibunwindstackMultipleOfflineAndProcessMemory::Read(uint64_t addr, void*
   return 0;
 }
 
+bool LibunwindstackMultipleOfflineAndProcessMemory::IsInNonWritableMapping(
+    uint64_t addr_start, uint64_t addr_end) const {
+  if (maps_ == nullptr) return false;
+  std::shared_ptr<unwindstack::MapInfo> map_info = maps_->Find(addr_start);
+  return map_info != nullptr && addr_end <= map_info->end() &&
+         (map_info->flags() & PROT_WRITE) == 0;
+}
+
 std::vector<LibunwindstackMultipleOfflineAndProcessMemory::LibunwindstackOfflineMemory>
 LibunwindstackMultipleOfflineAndProcessMemory::CreateOfflineStackMemories(
     absl::Span<const StackSliceView> stack_slices) {
@@ -67,6 +81,18 @@ LibunwindstackMultipleOfflineAndProcessMemory::CreateWithProcessMemory(
           unwindstack::Memory::CreateProcessMemoryCached(pid), std::move(stack_memories)));
 }
 
+std::shared_ptr<unwindstack::Memory>
+LibunwindstackMultipleOfflineAndProcessMemory::CreateWithCachedProcessMemory(
+    pid_t pid, std::shared_ptr<ProcessMemoryReadCache> process_memory_read_cache,
+    unwindstack::Maps* maps, absl::Span<const StackSliceView> stack_slices) {
+  std::vector<LibunwindstackOfflineMemory> stack_memories =
+      CreateOfflineStackMemories(stack_slices);
+  return std::shared_ptr<LibunwindstackMultipleOfflineAndProcessMemory>(
+      new LibunwindstackMultipleOfflineAndProcessMemory(
+          unwindstack::Memory::CreateProcessMemoryCached(pid), std::move(stack_memories),
+          std::move(process_memory_read_cache), maps));
+}
+
 std::shared_ptr<unwindstack::Memory>
 LibunwindstackMultipleOfflineAndProcessMemory::CreateWithoutProcessMemory(
     absl::Span<const StackSliceView> stack_slices) {
@@ -9,6 +9,7 @@
 #include <absl/types/span.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include <unwindstack/Maps.h>
 #include <unwindstack/Memory.h>
 
 #include <memory>
@@ -16,6 +17,8 @@
 #include <utility>
 #include <vector>
 
+#include "ProcessMemoryReadCache.h"
+
 namespace orbit_linux_tracing {
 
 // This class is a "view" of a stack slice (some copy of process memory). It contains a bare pointer
@@ -46,6 +49,8 @@ class StackSliceView {
 // Having multiple stack slices allows unwinding callstacks that have multiple stacks involved, such
 // as in the case of Wine system calls.
 // The process memory allows unwinding callstacks that involve virtual modules, such as vDSO.
+// If a ProcessMemoryReadCache is specified, the fallback reads that fall in a non-writable mapping
+// of `maps` go through it, so that they don't cost a syscall each time.
 class LibunwindstackMultipleOfflineAndProcessMemory : public unwindstack::Memory {
  public:
   size_t Read(uint64_t addr, void* dst, size_t size) override;
@@ -53,6 +58,11 @@ class LibunwindstackMultipleOfflineAndProcessMemory : public unwindstack::Memory
   static std::shared_ptr<Memory> CreateWithProcessMemory(
       pid_t pid, absl::Span<const StackSliceView> stack_slices);
 
+  // `maps` must outlive the returned object.
+  static std::shared_ptr<Memory> CreateWithCachedProcessMemory(
+      pid_t pid, std::shared_ptr<ProcessMemoryReadCache> process_memory_read_cache,
+      unwindstack::Maps* maps, absl::Span<const StackSliceView> stack_slices);
+
   static std::shared_ptr<Memory> CreateWithoutProcessMemory(
       absl::Span<const StackSliceView> stack_slices);
 
@@ -82,15 +92,23 @@ class LibunwindstackMultipleOfflineAndProcessMemory : public unwindstack::Memory
 
   LibunwindstackMultipleOfflineAndProcessMemory(
       std::shared_ptr<Memory> process_memory,
-      std::vector<LibunwindstackOfflineMemory> stack_memories)
+      std::vector<LibunwindstackOfflineMemory> stack_memories,
+      std::shared_ptr<ProcessMemoryReadCache> process_memory_read_cache = nullptr,
+      unwindstack::Maps* maps = nullptr)
       : process_memory_{std::move(process_memory)},
-        stack_memories_{std::move(std::move(stack_memories))} {}
+        stack_memories_{std::move(std::move(stack_memories))},
+        process_memory_read_cache_{std::move(process_memory_read_cache)},
+        maps_{maps} {}
+
+  [[nodiscard]] bool IsInNonWritableMapping(uint64_t addr_start, uint64_t addr_end) const;
 
   static std::vector<LibunwindstackOfflineMemory> CreateOfflineStackMemories(
       absl::Span<const StackSliceView> stack_slices);
 
   std::shared_ptr<Memory> process_memory_;
   std::vector<LibunwindstackOfflineMemory> stack_memories_;
+  std::shared_ptr<ProcessMemoryReadCache> process_memory_read_cache_;
+  unwindstack::Maps* maps_;
 };
 
 }  // namespace orbit_linux_tracing
@@ -4,19 +4,28 @@
 
 #include "LibunwindstackUnwinder.h"
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+#include <absl/synchronization/mutex.h>
 #include <absl/types/span.h>
 #include <unwindstack/Error.h>
 #include <unwindstack/Memory.h>
 #include <unwindstack/Regs.h>
 #include <unwindstack/RegsX86_64.h>
 
+#include <xxhash.h>
+
 #include <array>
 #include <cstddef>
+#include <list>
 #include <map>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 
 #include "LibunwindstackMultipleOfflineAndProcessMemory.h"
 #include "OrbitBase/Logging.h"  // IWYU pragma: keep
+#include "ProcessMemoryReadCache.h"
 #include "unwindstack/Arch.h"
 #include "unwindstack/DwarfLocation.h"
 #include "unwindstack/DwarfSection.h"
@@ -36,8 +45,10 @@ namespace {
 class LibunwindstackUnwinderImpl : public LibunwindstackUnwinder {
  public:
   explicit LibunwindstackUnwinderImpl(
-      const std::map<uint64_t, uint64_t>* absolute_address_to_size_of_functions_to_stop_at)
-      : absolute_address_to_size_of_functions_to_stop_at_{
+      const std::map<uint64_t, uint64_t>* absolute_address_to_size_of_functions_to_stop_at,
+      size_t unwinding_cache_capacity)
+      : unwinding_cache_capacity_{unwinding_cache_capacity},
+        absolute_address_to_size_of_functions_to_stop_at_{
             absolute_address_to_size_of_functions_to_stop_at} {}
   LibunwindstackResult Unwind(pid_t pid, unwindstack::Maps* maps,
                               const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
@@ -48,13 +59,71 @@ class LibunwindstackUnwinderImpl : public LibunwindstackUnwinder {
   std::optional<bool> HasFramePointerSet(uint64_t instruction_pointer, pid_t pid,
                                          unwindstack::Maps* maps) override;
 
+  std::optional<uint64_t> GetReturnAddressOffsetFromSpWithoutFrameSetup(
+      uint64_t instruction_pointer, pid_t pid, unwindstack::Maps* maps) override;
+
+  void ClearUnwindingCache() override;
+  [[nodiscard]] UnwindingCacheStats GetUnwindingCacheStats() const override;
+
  private:
+  struct UnwindingCacheKey {
+    pid_t pid;
+    bool offline_memory_only;
+    size_t max_frames;
+    uint64_t pc;
+    uint64_t sp;
+    // Hash of all registers and of the address and content of all stack slices.
+    uint64_t hash;
+
+    friend bool operator==(const UnwindingCacheKey& lhs, const UnwindingCacheKey& rhs) {
+      return std::tie(lhs.pid, lhs.offline_memory_only, lhs.max_frames, lhs.pc, lhs.sp, lhs.hash) ==
+             std::tie(rhs.pid, rhs.offline_memory_only, rhs.max_frames, rhs.pc, rhs.sp, rhs.hash);
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const UnwindingCacheKey& key) {
+      return H::combine(std::move(h), key.pid, key.offline_memory_only, key.max_frames, key.pc,
+                        key.sp, key.hash);
+    }
+  };
+
+  [[nodiscard]] static UnwindingCacheKey ComputeUnwindingCacheKey(
+      pid_t pid, const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      absl::Span<const StackSliceView> stack_slices, bool offline_memory_only, size_t max_frames);
+  [[nodiscard]] std::optional<LibunwindstackResult> FindInUnwindingCache(
+      const UnwindingCacheKey& key);
+  void AddToUnwindingCache(const UnwindingCacheKey& key, const LibunwindstackResult& result);
+
+  [[nodiscard]] LibunwindstackResult UnwindUncached(
+      pid_t pid, unwindstack::Maps* maps,
+      const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+      absl::Span<const StackSliceView> stack_slices, bool offline_memory_only, size_t max_frames);
+
+  [[nodiscard]] std::shared_ptr<ProcessMemoryReadCache> GetProcessMemoryReadCache(pid_t pid);
+
   static const std::array<size_t, unwindstack::X86_64_REG_LAST> kUnwindstackRegsToPerfRegs;
 
-  std::map<uint64_t, unwindstack::DwarfLocations>
-      debug_frame_loc_regs_cache_;  // Single row indexed by pc_end.
-  std::map<uint64_t, unwindstack::DwarfLocations>
-      eh_frame_loc_regs_cache_;  // Single row indexed by pc_end.
+  const size_t unwinding_cache_capacity_;
+  mutable absl::Mutex unwinding_cache_mutex_;
+  // Most recently used entries are at the front.
+  std::list<std::pair<UnwindingCacheKey, LibunwindstackResult>> unwinding_cache_entries_
+      ABSL_GUARDED_BY(unwinding_cache_mutex_);
+  absl::flat_hash_map<UnwindingCacheKey,
+                      std::list<std::pair<UnwindingCacheKey, LibunwindstackResult>>::iterator>
+      unwinding_cache_ ABSL_GUARDED_BY(unwinding_cache_mutex_);
+  UnwindingCacheStats unwinding_cache_stats_ ABSL_GUARDED_BY(unwinding_cache_mutex_);
+
+  // The rows of the call frame information looked up so far, per .debug_frame or .eh_frame
+  // section, indexed by pc_end. The sections are owned by the Elfs of the maps, hence these need to
+  // be cleared when the maps change.
+  absl::flat_hash_map<const unwindstack::DwarfSection*,
+                      std::map<uint64_t, unwindstack::DwarfLocations>>
+      loc_regs_caches_;
+
+  // Kept across unwinds, and cleared together with the unwinding cache when the maps change.
+  absl::Mutex process_memory_read_caches_mutex_;
+  absl::flat_hash_map<pid_t, std::shared_ptr<ProcessMemoryReadCache>> process_memory_read_caches_
+      ABSL_GUARDED_BY(process_memory_read_caches_mutex_);
 
   const std::map<uint64_t, uint64_t>* absolute_address_to_size_of_functions_to_stop_at_;
 };
@@ -67,9 +136,107 @@ const std::array<size_t, unwindstack::X86_64_REG_LAST>
         PERF_REG_X86_R15, PERF_REG_X86_IP,
     };
 
+LibunwindstackUnwinderImpl::UnwindingCacheKey LibunwindstackUnwinderImpl::ComputeUnwindingCacheKey(
+    pid_t pid, const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+    absl::Span<const StackSliceView> stack_slices, bool offline_memory_only, size_t max_frames) {
+  XXH64_state_t hash_state;
+  XXH64_reset(&hash_state, 0);
+  XXH64_update(&hash_state, perf_regs.data(), sizeof(perf_regs));
+  for (const StackSliceView& stack_slice : stack_slices) {
+    const uint64_t start_address = stack_slice.start_address();
+    XXH64_update(&hash_state, &start_address, sizeof(start_address));
+    const uint64_t size = stack_slice.size();
+    XXH64_update(&hash_state, &size, sizeof(size));
+    XXH64_update(&hash_state, stack_slice.data(), size);
+  }
+  return UnwindingCacheKey{.pid = pid,
+                           .offline_memory_only = offline_memory_only,
+                           .max_frames = max_frames,
+                           .pc = perf_regs[PERF_REG_X86_IP],
+                           .sp = perf_regs[PERF_REG_X86_SP],
+                           .hash = XXH64_digest(&hash_state)};
+}
+
+std::optional<LibunwindstackResult> LibunwindstackUnwinderImpl::FindInUnwindingCache(
+    const UnwindingCacheKey& key) {
+  absl::MutexLock lock{&unwinding_cache_mutex_};
+  auto it = unwinding_cache_.find(key);
+  if (it == unwinding_cache_.end()) {
+    ++unwinding_cache_stats_.miss_count;
+    return std::nullopt;
+  }
+  ++unwinding_cache_stats_.hit_count;
+  unwinding_cache_entries_.splice(unwinding_cache_entries_.begin(), unwinding_cache_entries_,
+                                  it->second);
+  return it->second->second;
+}
+
+void LibunwindstackUnwinderImpl::AddToUnwindingCache(const UnwindingCacheKey& key,
+                                                     const LibunwindstackResult& result) {
+  absl::MutexLock lock{&unwinding_cache_mutex_};
+  // Another thread might have unwound the same stack in the meantime.
+  if (unwinding_cache_.contains(key)) {
+    return;
+  }
+  if (unwinding_cache_.size() >= unwinding_cache_capacity_) {
+    unwinding_cache_.erase(unwinding_cache_entries_.back().first);
+    unwinding_cache_entries_.pop_back();
+  }
+  unwinding_cache_entries_.emplace_front(key, result);
+  unwinding_cache_.emplace(key, unwinding_cache_entries_.begin());
+}
+
+void LibunwindstackUnwinderImpl::ClearUnwindingCache() {
+  absl::MutexLock lock{&unwinding_cache_mutex_};
+  unwinding_cache_.clear();
+  unwinding_cache_entries_.clear();
+  loc_regs_caches_.clear();
+
+  absl::MutexLock process_memory_read_caches_lock{&process_memory_read_caches_mutex_};
+  for (auto& [unused_pid, process_memory_read_cache] : process_memory_read_caches_) {
+    process_memory_read_cache->Clear();
+  }
+}
+
+std::shared_ptr<ProcessMemoryReadCache> LibunwindstackUnwinderImpl::GetProcessMemoryReadCache(
+    pid_t pid) {
+  absl::MutexLock lock{&process_memory_read_caches_mutex_};
+  std::shared_ptr<ProcessMemoryReadCache>& process_memory_read_cache =
+      process_memory_read_caches_[pid];
+  if (process_memory_read_cache == nullptr) {
+    process_memory_read_cache = std::make_shared<ProcessMemoryReadCache>(pid);
+  }
+  return process_memory_read_cache;
+}
+
+UnwindingCacheStats LibunwindstackUnwinderImpl::GetUnwindingCacheStats() const {
+  absl::MutexLock lock{&unwinding_cache_mutex_};
+  return unwinding_cache_stats_;
+}
+
 LibunwindstackResult LibunwindstackUnwinderImpl::Unwind(
     pid_t pid, unwindstack::Maps* maps, const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
     absl::Span<const StackSliceView> stack_slices, bool offline_memory_only, size_t max_frames) {
+  if (unwinding_cache_capacity_ == 0) {
+    return UnwindUncached(pid, maps, perf_regs, stack_slices, offline_memory_only, max_frames);
+  }
+
+  const UnwindingCacheKey key =
+      ComputeUnwindingCacheKey(pid, perf_regs, stack_slices, offline_memory_only, max_frames);
+  std::optional<LibunwindstackResult> cached_result = FindInUnwindingCache(key);
+  if (cached_result.has_value()) {
+    return std::move(cached_result.value());
+  }
+
+  LibunwindstackResult result =
+      UnwindUncached(pid, maps, perf_regs, stack_slices, offline_memory_only, max_frames);
+  AddToUnwindingCache(key, result);
+  return result;
+}
+
+LibunwindstackResult LibunwindstackUnwinderImpl::UnwindUncached(
+    pid_t pid, unwindstack::Maps* maps, const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
+    absl::Span<const StackSliceView> stack_slices, bool offline_memory_only, size_t max_frames) {
   unwindstack::RegsX86_64 regs{};
   for (size_t perf_reg = 0; perf_reg < unwindstack::X86_64_REG_LAST; ++perf_reg) {
     regs[perf_reg] = perf_regs.at(kUnwindstackRegsToPerfRegs[perf_reg]);
@@ -80,8 +247,8 @@ LibunwindstackResult LibunwindstackUnwinderImpl::Unwind(
     memory =
         LibunwindstackMultipleOfflineAndProcessMemory::CreateWithoutProcessMemory(stack_slices);
   } else {
-    memory =
-        LibunwindstackMultipleOfflineAndProcessMemory::CreateWithProcessMemory(pid, stack_slices);
+    memory = LibunwindstackMultipleOfflineAndProcessMemory::CreateWithCachedProcessMemory(
+        pid, GetProcessMemoryReadCache(pid), maps, stack_slices);
   }
 
   unwindstack::Unwinder unwinder{max_frames, maps, &regs, memory};
@@ -98,6 +265,26 @@ LibunwindstackResult LibunwindstackUnwinderImpl::Unwind(
   return LibunwindstackResult{unwinder.ConsumeFrames(), regs, unwinder.LastErrorCode()};
 }
 
+// Returns the row of the call frame information in `dwarf_section` that covers `rel_pc`, or
+// nullptr if there is none. Rows are cached in `loc_regs_cache`, indexed by pc_end.
+const unwindstack::DwarfLocations* FindDwarfLocations(
+    uint64_t rel_pc, unwindstack::DwarfSection* dwarf_section,
+    std::map<uint64_t, unwindstack::DwarfLocations>* loc_regs_cache) {
+  auto cache_it = loc_regs_cache->upper_bound(rel_pc);
+  if (cache_it == loc_regs_cache->end() || rel_pc < cache_it->second.pc_start) {
+    const unwindstack::DwarfFde* fde = dwarf_section->GetFdeFromPc(rel_pc);
+    if (fde == nullptr) {
+      return nullptr;
+    }
+    unwindstack::DwarfLocations loc_regs;
+    if (!dwarf_section->GetCfaLocationInfo(rel_pc, fde, &loc_regs, unwindstack::ARCH_X86_64)) {
+      return nullptr;
+    }
+    cache_it = loc_regs_cache->emplace(loc_regs.pc_end, std::move(loc_regs)).first;
+  }
+  return &cache_it->second;
+}
+
 // This functions detects if a frame pointer register was set in the given program counter using
 // the given Dwarf section.
 // It does so by verifying if "Canonical Frame Address" gets computed immediately from $rbp (with
@@ -110,20 +297,12 @@ std::optional<bool> HasFramePointerSetFromDwarfSection(
     return false;
   }
 
-  auto cache_it = loc_regs_cache->upper_bound(rel_pc);
-  if (cache_it == loc_regs_cache->end() || rel_pc < cache_it->second.pc_start) {
-    const unwindstack::DwarfFde* fde = dwarf_section->GetFdeFromPc(rel_pc);
-    if (fde == nullptr) {
-      return std::nullopt;
-    }
-    unwindstack::DwarfLocations loc_regs;
-    if (!dwarf_section->GetCfaLocationInfo(rel_pc, fde, &loc_regs, unwindstack::ARCH_X86_64)) {
-      return std::nullopt;
-    }
-    cache_it = loc_regs_cache->emplace(loc_regs.pc_end, std::move(loc_regs)).first;
+  const unwindstack::DwarfLocations* loc_regs =
+      FindDwarfLocations(rel_pc, dwarf_section, loc_regs_cache);
+  if (loc_regs == nullptr) {
+    return std::nullopt;
   }
 
-  unwindstack::DwarfLocations* loc_regs = &cache_it->second;
   auto cfa_entry = loc_regs->find(unwindstack::CFA_REG);
   if (cfa_entry == loc_regs->end()) {
     return false;
@@ -144,9 +323,50 @@ std::optional<bool> HasFramePointerSetFromDwarfSection(
   return false;
 }
 
-std::optional<bool> LibunwindstackUnwinderImpl::HasFramePointerSet(uint64_t instruction_pointer,
-                                                                   pid_t pid,
-                                                                   unwindstack::Maps* maps) {
+// Returns the offset from $rsp of the return address if, according to `loc_regs`, the CFA is
+// computed from $rsp and $rbp has not been saved, i.e., the function has not set up a frame (yet).
+// This is the case everywhere in leaf functions compiled with -momit-leaf-frame-pointer, as well as
+// at the first instruction of all functions.
+std::optional<uint64_t> GetReturnAddressOffsetFromSpWithoutFrameSetupFromDwarfLocations(
+    const unwindstack::DwarfLocations& loc_regs) {
+  // If $rbp has a rule, it has been saved and might have been modified since.
+  if (loc_regs.find(unwindstack::X86_64_REG_RBP) != loc_regs.end()) {
+    return std::nullopt;
+  }
+
+  auto cfa_entry = loc_regs.find(unwindstack::CFA_REG);
+  if (cfa_entry == loc_regs.end() ||
+      cfa_entry->second.type != unwindstack::DWARF_LOCATION_REGISTER ||
+      cfa_entry->second.values[0] != unwindstack::X86_64_REG_RSP) {
+    return std::nullopt;
+  }
+  const uint64_t cfa_offset_from_sp = cfa_entry->second.values[1];
+
+  // The return address is expected at a (negative) offset from the CFA, usually -8. In the
+  // outermost frame, it is undefined instead.
+  auto return_address_entry = loc_regs.find(unwindstack::X86_64_REG_RIP);
+  if (return_address_entry == loc_regs.end() ||
+      return_address_entry->second.type != unwindstack::DWARF_LOCATION_OFFSET) {
+    return std::nullopt;
+  }
+  const auto return_address_offset_from_cfa =
+      static_cast<int64_t>(return_address_entry->second.values[0]);
+  if (return_address_offset_from_cfa >= 0 ||
+      static_cast<uint64_t>(-return_address_offset_from_cfa) > cfa_offset_from_sp) {
+    return std::nullopt;
+  }
+  return cfa_offset_from_sp - static_cast<uint64_t>(-return_address_offset_from_cfa);
+}
+
+struct ElfAndRelPc {
+  unwindstack::Elf* elf;
+  uint64_t rel_pc;
+};
+
+// Finds the ELF file that contains `instruction_pointer` and the corresponding relative pc. Returns
+// nullopt if the file could not be loaded, and an `elf` of nullptr if the file is not an ELF file.
+std::optional<ElfAndRelPc> FindElfAndRelPc(uint64_t instruction_pointer, pid_t pid,
+                                           unwindstack::Maps* maps) {
   std::shared_ptr<unwindstack::MapInfo> map_info = maps->Find(instruction_pointer);
   if (map_info == nullptr) {
     return std::nullopt;
@@ -162,21 +382,34 @@ std::optional<bool> LibunwindstackUnwinderImpl::HasFramePointerSet(uint64_t inst
   auto* elf = dynamic_cast<unwindstack::Elf*>(object);
   if (elf == nullptr) {
     // TODO(b/228599622): Handle the PeCoff case.
-    return false;
+    return ElfAndRelPc{.elf = nullptr, .rel_pc = 0};
   }
 
-  unwindstack::ElfInterface* elf_interface = elf->interface();
-  if (!elf->valid() || elf_interface == nullptr) {
+  if (!elf->valid() || elf->interface() == nullptr) {
     return std::nullopt;
   }
 
-  uint64_t rel_pc = object->GetRelPc(instruction_pointer, map_info.get());
+  return ElfAndRelPc{.elf = elf, .rel_pc = object->GetRelPc(instruction_pointer, map_info.get())};
+}
+
+std::optional<bool> LibunwindstackUnwinderImpl::HasFramePointerSet(uint64_t instruction_pointer,
+                                                                   pid_t pid,
+                                                                   unwindstack::Maps* maps) {
+  std::optional<ElfAndRelPc> elf_and_rel_pc = FindElfAndRelPc(instruction_pointer, pid, maps);
+  if (!elf_and_rel_pc.has_value()) {
+    return std::nullopt;
+  }
+  if (elf_and_rel_pc->elf == nullptr) {
+    return false;
+  }
+  const uint64_t rel_pc = elf_and_rel_pc->rel_pc;
+  unwindstack::ElfInterface* elf_interface = elf_and_rel_pc->elf->interface();
 
   unwindstack::DwarfSection* debug_frame = elf_interface->debug_frame();
 
   auto has_frame_pointer_set_from_debug_frame_or_error =
       orbit_linux_tracing::HasFramePointerSetFromDwarfSection(rel_pc, debug_frame,
-                                                              &debug_frame_loc_regs_cache_);
+                                                              &loc_regs_caches_[debug_frame]);
   if (!has_frame_pointer_set_from_debug_frame_or_error.has_value()) {
     return std::nullopt;
   }
@@ -184,21 +417,47 @@ std::optional<bool> LibunwindstackUnwinderImpl::HasFramePointerSet(uint64_t inst
     return true;
   }
 
-  unwindstack::DwarfSection* eh_frame = elf->interface()->eh_frame();
+  unwindstack::DwarfSection* eh_frame = elf_interface->eh_frame();
   auto has_frame_pointer_set_from_eh_frame_or_error =
       orbit_linux_tracing::HasFramePointerSetFromDwarfSection(rel_pc, eh_frame,
-                                                              &eh_frame_loc_regs_cache_);
+                                                              &loc_regs_caches_[eh_frame]);
   if (!has_frame_pointer_set_from_eh_frame_or_error.has_value()) {
     return std::nullopt;
   }
   return *has_frame_pointer_set_from_eh_frame_or_error;
 }
+
+std::optional<uint64_t> LibunwindstackUnwinderImpl::GetReturnAddressOffsetFromSpWithoutFrameSetup(
+    uint64_t instruction_pointer, pid_t pid, unwindstack::Maps* maps) {
+  std::optional<ElfAndRelPc> elf_and_rel_pc = FindElfAndRelPc(instruction_pointer, pid, maps);
+  if (!elf_and_rel_pc.has_value() || elf_and_rel_pc->elf == nullptr) {
+    return std::nullopt;
+  }
+  const uint64_t rel_pc = elf_and_rel_pc->rel_pc;
+  unwindstack::ElfInterface* elf_interface = elf_and_rel_pc->elf->interface();
+
+  // As in HasFramePointerSet, .debug_frame takes precedence over .eh_frame.
+  const unwindstack::DwarfLocations* loc_regs = nullptr;
+  unwindstack::DwarfSection* debug_frame = elf_interface->debug_frame();
+  if (debug_frame != nullptr) {
+    loc_regs = FindDwarfLocations(rel_pc, debug_frame, &loc_regs_caches_[debug_frame]);
+  }
+  unwindstack::DwarfSection* eh_frame = elf_interface->eh_frame();
+  if (loc_regs == nullptr && eh_frame != nullptr) {
+    loc_regs = FindDwarfLocations(rel_pc, eh_frame, &loc_regs_caches_[eh_frame]);
+  }
+  if (loc_regs == nullptr) {
+    return std::nullopt;
+  }
+  return GetReturnAddressOffsetFromSpWithoutFrameSetupFromDwarfLocations(*loc_regs);
+}
 }  // namespace
 
 std::unique_ptr<LibunwindstackUnwinder> LibunwindstackUnwinder::Create(
-    const std::map<uint64_t, uint64_t>* absolute_address_to_size_of_functions_to_stop_at) {
+    const std::map<uint64_t, uint64_t>* absolute_address_to_size_of_functions_to_stop_at,
+    size_t unwinding_cache_capacity) {
   return std::make_unique<LibunwindstackUnwinderImpl>(
-      absolute_address_to_size_of_functions_to_stop_at);
+      absolute_address_to_size_of_functions_to_stop_at, unwinding_cache_capacity);
 }
 
 std::string LibunwindstackUnwinder::LibunwindstackErrorString(unwindstack::ErrorCode error_code) {
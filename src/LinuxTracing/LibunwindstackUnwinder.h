@@ -50,10 +50,16 @@ class LibunwindstackResult {
   unwindstack::ErrorCode error_code_;
 };
 
+struct UnwindingCacheStats {
+  uint64_t hit_count = 0;
+  uint64_t miss_count = 0;
+};
+
 class LibunwindstackUnwinder {
  public:
   virtual ~LibunwindstackUnwinder() = default;
 
+
   virtual LibunwindstackResult Unwind(pid_t pid, unwindstack::Maps* maps,
                                       const std::array<uint64_t, PERF_REG_X86_64_MAX>& perf_regs,
                                       absl::Span<const StackSliceView> stack_slices,
@@ -66,9 +72,28 @@ class LibunwindstackUnwinder {
   virtual std::optional<bool> HasFramePointerSet(uint64_t instruction_pointer, pid_t pid,
                                                  unwindstack::Maps* maps) = 0;
 
+  // For a given instruction pointer (absolute address) at which the function has not set up a
+  // frame, that is, $rbp still holds the caller's value and was not saved, returns the offset from
+  // $rsp at which the return address is stored, as described by the call frame information. This
+  // allows retrieving the caller of a leaf function directly from the stack sample. Returns nullopt
+  // if the function has set up a frame or if the required debug information is not available.
+  virtual std::optional<uint64_t> GetReturnAddressOffsetFromSpWithoutFrameSetup(
+      uint64_t instruction_pointer, pid_t pid, unwindstack::Maps* maps) = 0;
+
+  // Cached results, including the call frame information cached per module by HasFramePointerSet
+  // and GetReturnAddressOffsetFromSpWithoutFrameSetup, become stale when the maps change, so this
+  // needs to be called when they do.
+  virtual void ClearUnwindingCache() = 0;
+  [[nodiscard]] virtual UnwindingCacheStats GetUnwindingCacheStats() const = 0;
+
+  // When created with a non-zero `unwinding_cache_capacity`, at most that many results are kept in
+  // a least-recently-used cache. A result is reused when the same pid, registers, and content of
+  // the stack slices are passed to Unwind again, which is common for threads that keep getting
+  // sampled at the same location, e.g., while waiting. Unwind is safe to call concurrently.
   static std::unique_ptr<LibunwindstackUnwinder> Create(
       const std::map<uint64_t, uint64_t>* absolute_address_to_size_of_functions_to_stop_at =
-          nullptr);
+          nullptr,
+      size_t unwinding_cache_capacity = 0);
   static std::string LibunwindstackErrorString(unwindstack::ErrorCode error_code);
 
  protected:
@@ -3,16 +3,22 @@
 // found in the LICENSE file.
 
 #include <absl/strings/str_format.h>
+#include <asm/perf_regs.h>
 #include <gtest/gtest.h>
 #include <sys/types.h>
 
+#include <array>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <vector>
 
 #include "LibunwindstackMaps.h"
+#include "LibunwindstackMultipleOfflineAndProcessMemory.h"
 #include "LibunwindstackUnwinder.h"
 #include "Test/Path.h"
 
@@ -212,4 +218,165 @@ TEST(LibunwindstackUnwinder, FramePointerDetectionWorksWithCaching) {
   }
 }
 
-}  // namespace orbit_linux_tracing
\ No newline at end of file
+TEST(LibunwindstackUnwinder, GetsReturnAddressOffsetInLeafFunction) {
+  auto unwinder = LibunwindstackUnwinder::Create();
+
+  auto maps = CreateFakeMapsEntry("target_fp");
+
+  //    122e:       7f 12                        jg     1242 <_Z9every_1usv+0x2d>
+  std::optional<uint64_t> return_address_offset =
+      unwinder->GetReturnAddressOffsetFromSpWithoutFrameSetup(0x122e, kProcessId, maps->Get());
+
+  ASSERT_TRUE(return_address_offset.has_value());
+  EXPECT_EQ(return_address_offset.value(), 0);
+}
+
+TEST(LibunwindstackUnwinder, GetsReturnAddressOffsetInFunctionWithoutFramePointer) {
+  auto unwinder = LibunwindstackUnwinder::Create();
+
+  auto maps = CreateFakeMapsEntry("target_no_fp");
+
+  //     12ad:       83 44 24 04 01              addl   $0x1,0x4(%rsp)
+  std::optional<uint64_t> return_address_offset =
+      unwinder->GetReturnAddressOffsetFromSpWithoutFrameSetup(0x12ad, kProcessId, maps->Get());
+
+  // The return address is above the 16 bytes reserved by `sub $0x10,%rsp`.
+  ASSERT_TRUE(return_address_offset.has_value());
+  EXPECT_EQ(return_address_offset.value(), 16);
+}
+
+TEST(LibunwindstackUnwinder, GetsReturnAddressOffsetOnlyBeforeFrameSetup) {
+  auto unwinder = LibunwindstackUnwinder::Create();
+
+  auto maps = CreateFakeMapsEntry("target_fp");
+
+  // Go through the instructions a couple of times, to also exercise the cached rows.
+  constexpr size_t kMaxRepetitions = 5;
+  for (size_t i = 0; i < kMaxRepetitions; i++) {
+    //    1248:       55                      push   %rbp
+    std::optional<uint64_t> return_address_offset =
+        unwinder->GetReturnAddressOffsetFromSpWithoutFrameSetup(0x1248, kProcessId, maps->Get());
+    ASSERT_TRUE(return_address_offset.has_value());
+    EXPECT_EQ(return_address_offset.value(), 0);
+
+    //    1249:       48 89 e5                mov    %rsp,%rbp
+    EXPECT_FALSE(unwinder->GetReturnAddressOffsetFromSpWithoutFrameSetup(0x1249, kProcessId,
+                                                                         maps->Get()));
+
+    //    124c:       48 83 ec 10             sub    $0x10,%rsp
+    EXPECT_FALSE(unwinder->GetReturnAddressOffsetFromSpWithoutFrameSetup(0x124c, kProcessId,
+                                                                         maps->Get()));
+
+    //    1279:       c3                      ret
+    return_address_offset =
+        unwinder->GetReturnAddressOffsetFromSpWithoutFrameSetup(0x1279, kProcessId, maps->Get());
+    ASSERT_TRUE(return_address_offset.has_value());
+    EXPECT_EQ(return_address_offset.value(), 0);
+
+    unwinder->ClearUnwindingCache();
+  }
+}
+
+namespace {
+
+constexpr uint64_t kStackStartAddress = 0x7fff0000;
+
+[[nodiscard]] std::array<uint64_t, PERF_REG_X86_64_MAX> MakeRegisters() {
+  std::array<uint64_t, PERF_REG_X86_64_MAX> registers{};
+  //    1265:       e8 ab ff ff ff           call   1215 <_Z9every_1usv>
+  registers[PERF_REG_X86_IP] = 0x1265;
+  registers[PERF_REG_X86_SP] = kStackStartAddress;
+  registers[PERF_REG_X86_BP] = kStackStartAddress + 0x10;
+  return registers;
+}
+
+[[nodiscard]] UnwindingCacheStats UnwindOfflineAndGetCacheStats(
+    LibunwindstackUnwinder* unwinder, LibunwindstackMaps* maps, const std::vector<uint8_t>& stack) {
+  StackSliceView stack_slice{kStackStartAddress, stack.size(), stack.data()};
+  std::ignore = unwinder->Unwind(kProcessId, maps->Get(), MakeRegisters(), {stack_slice},
+                                 /*offline_memory_only=*/true);
+  return unwinder->GetUnwindingCacheStats();
+}
+
+}  // namespace
+
+TEST(LibunwindstackUnwinder, UnwindingCacheIsDisabledByDefault) {
+  auto unwinder = LibunwindstackUnwinder::Create();
+  auto maps = CreateFakeMapsEntry("target_fp");
+  std::vector<uint8_t> stack(0x20, 0);
+
+  std::ignore = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), stack);
+  UnwindingCacheStats stats = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), stack);
+  EXPECT_EQ(stats.hit_count, 0);
+  EXPECT_EQ(stats.miss_count, 0);
+}
+
+TEST(LibunwindstackUnwinder, UnwindingCacheReusesResultsForIdenticalStacks) {
+  auto unwinder = LibunwindstackUnwinder::Create(nullptr, /*unwinding_cache_capacity=*/16);
+  auto maps = CreateFakeMapsEntry("target_fp");
+  std::vector<uint8_t> stack(0x20, 0);
+  StackSliceView stack_slice{kStackStartAddress, stack.size(), stack.data()};
+
+  LibunwindstackResult first_result = unwinder->Unwind(kProcessId, maps->Get(), MakeRegisters(),
+                                                       {stack_slice}, /*offline_memory_only=*/true);
+  LibunwindstackResult second_result = unwinder->Unwind(
+      kProcessId, maps->Get(), MakeRegisters(), {stack_slice}, /*offline_memory_only=*/true);
+
+  UnwindingCacheStats stats = unwinder->GetUnwindingCacheStats();
+  EXPECT_EQ(stats.hit_count, 1);
+  EXPECT_EQ(stats.miss_count, 1);
+  EXPECT_EQ(first_result.error_code(), second_result.error_code());
+  ASSERT_EQ(first_result.frames().size(), second_result.frames().size());
+  for (size_t i = 0; i < first_result.frames().size(); ++i) {
+    EXPECT_EQ(first_result.frames()[i].pc, second_result.frames()[i].pc);
+  }
+}
+
+TEST(LibunwindstackUnwinder, UnwindingCacheMissesWhenStackContentDiffers) {
+  auto unwinder = LibunwindstackUnwinder::Create(nullptr, /*unwinding_cache_capacity=*/16);
+  auto maps = CreateFakeMapsEntry("target_fp");
+  std::vector<uint8_t> stack(0x20, 0);
+
+  std::ignore = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), stack);
+  stack[0x18] = 0x42;
+  UnwindingCacheStats stats = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), stack);
+  EXPECT_EQ(stats.hit_count, 0);
+  EXPECT_EQ(stats.miss_count, 2);
+}
+
+TEST(LibunwindstackUnwinder, ClearUnwindingCacheDropsResults) {
+  auto unwinder = LibunwindstackUnwinder::Create(nullptr, /*unwinding_cache_capacity=*/16);
+  auto maps = CreateFakeMapsEntry("target_fp");
+  std::vector<uint8_t> stack(0x20, 0);
+
+  std::ignore = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), stack);
+  unwinder->ClearUnwindingCache();
+  UnwindingCacheStats stats = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), stack);
+  EXPECT_EQ(stats.hit_count, 0);
+  EXPECT_EQ(stats.miss_count, 2);
+}
+
+TEST(LibunwindstackUnwinder, UnwindingCacheEvictsLeastRecentlyUsedResult) {
+  auto unwinder = LibunwindstackUnwinder::Create(nullptr, /*unwinding_cache_capacity=*/2);
+  auto maps = CreateFakeMapsEntry("target_fp");
+  std::vector<uint8_t> first_stack(0x20, 1);
+  std::vector<uint8_t> second_stack(0x20, 2);
+  std::vector<uint8_t> third_stack(0x20, 3);
+
+  std::ignore = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), first_stack);
+  std::ignore = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), second_stack);
+  // This makes second_stack the least recently used.
+  UnwindingCacheStats stats =
+      UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), first_stack);
+  EXPECT_EQ(stats.hit_count, 1);
+  // This evicts second_stack.
+  std::ignore = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), third_stack);
+
+  stats = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), first_stack);
+  EXPECT_EQ(stats.hit_count, 2);
+  stats = UnwindOfflineAndGetCacheStats(unwinder.get(), maps.get(), second_stack);
+  EXPECT_EQ(stats.hit_count, 2);
+  EXPECT_EQ(stats.miss_count, 4);
+}
+
+}  // namespace orbit_linux_tracing
@@ -15,6 +15,9 @@ class MockTracerListener : public TracerListener {
  public:
   MOCK_METHOD(void, OnSchedulingSlice, (orbit_grpc_protos::SchedulingSlice), (override));
   MOCK_METHOD(void, OnCallstackSample, (orbit_grpc_protos::FullCallstackSample), (override));
+  MOCK_METHOD(void, OnPageFaultSample, (orbit_grpc_protos::FullPageFaultSample), (override));
+  MOCK_METHOD(void, OnPerformanceCounterSample, (orbit_grpc_protos::PerformanceCounterSample),
+              (override));
   MOCK_METHOD(void, OnFunctionCall, (orbit_grpc_protos::FunctionCall), (override));
   MOCK_METHOD(void, OnThreadStateSliceCallstack, (orbit_grpc_protos::ThreadStateSliceCallstack),
               (override));
@@ -31,8 +34,11 @@ class MockTracerListener : public TracerListener {
   MOCK_METHOD(void, OnLostPerfRecordsEvent, (orbit_grpc_protos::LostPerfRecordsEvent), (override));
   MOCK_METHOD(void, OnOutOfOrderEventsDiscardedEvent,
               (orbit_grpc_protos::OutOfOrderEventsDiscardedEvent), (override));
+  MOCK_METHOD(void, OnPerfEventProcessingStatsEvent,
+              (orbit_grpc_protos::PerfEventProcessingStatsEvent), (override));
   MOCK_METHOD(void, OnWarningInstrumentingWithUprobesEvent,
               (orbit_grpc_protos::WarningInstrumentingWithUprobesEvent), (override));
+  MOCK_METHOD(void, OnWarningEvent, (orbit_grpc_protos::WarningEvent), (override));
 };
 
 }  // namespace orbit_linux_tracing
@@ -0,0 +1,148 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ParallelStackUnwinder.h"
+
+#include <absl/strings/str_format.h>
+
+#include <utility>
+
+#include "Introspection/Introspection.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/ThreadUtils.h"
+
+namespace orbit_linux_tracing {
+
+ParallelStackUnwinder::ParallelStackUnwinder(LibunwindstackUnwinder* unwinder,
+                                             uint32_t thread_count,
+                                             UnwindingBudget* unwinding_budget)
+    : unwinder_{unwinder}, unwinding_budget_{unwinding_budget} {
+  ORBIT_CHECK(unwinder_ != nullptr);
+  ORBIT_CHECK(thread_count > 0);
+  for (uint32_t thread_index = 0; thread_index < thread_count; ++thread_index) {
+    workers_.emplace_back([this, thread_index] {
+      orbit_base::SetCurrentThreadName(absl::StrFormat("Unwinder%u", thread_index).c_str());
+      RunWorker();
+    });
+  }
+}
+
+ParallelStackUnwinder::~ParallelStackUnwinder() {
+  {
+    absl::MutexLock lock{&mutex_};
+    stop_workers_ = true;
+  }
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ParallelStackUnwinder::RunWorker() {
+  while (true) {
+    PendingUnwind* pending_unwind = nullptr;
+    {
+      absl::MutexLock lock{&mutex_};
+      mutex_.Await(absl::Condition(this, &ParallelStackUnwinder::HasUnwindsToStartOrIsStopping));
+      if (stop_workers_) {
+        return;
+      }
+      pending_unwind = unwinds_to_start_.front();
+      unwinds_to_start_.pop_front();
+    }
+
+    // pending_unwind stays valid as it can only be removed from pending_unwinds_ once its result
+    // has been set.
+    ORBIT_SCOPE("ParallelStackUnwinder::Unwind");
+    const Request& request = pending_unwind->request;
+    std::vector<StackSliceView> stack_slice_views;
+    stack_slice_views.reserve(request.stack_slices.size());
+    for (const StackSlice& stack_slice : request.stack_slices) {
+      stack_slice_views.emplace_back(stack_slice.start_address, stack_slice.data.size(),
+                                     stack_slice.data.data());
+    }
+    const uint64_t begin_ns = orbit_base::CaptureTimestampNs();
+    LibunwindstackResult result = unwinder_->Unwind(request.pid, request.maps, request.registers,
+                                                    stack_slice_views, request.offline_memory_only);
+    if (unwinding_budget_ != nullptr) {
+      unwinding_budget_->AddUnwindingTime(orbit_base::CaptureTimestampNs() - begin_ns);
+    }
+
+    absl::MutexLock lock{&mutex_};
+    pending_unwind->result.emplace(std::move(result));
+  }
+}
+
+bool ParallelStackUnwinder::HasUnwindsToStartOrIsStopping() const {
+  return stop_workers_ || !unwinds_to_start_.empty();
+}
+
+bool ParallelStackUnwinder::IsFrontOfPendingUnwindsCompleted() const {
+  return !pending_unwinds_.empty() && pending_unwinds_.front()->result.has_value();
+}
+
+std::vector<std::unique_ptr<ParallelStackUnwinder::PendingUnwind>>
+ParallelStackUnwinder::PopCompletedUnwinds() {
+  std::vector<std::unique_ptr<PendingUnwind>> completed_unwinds;
+  while (IsFrontOfPendingUnwindsCompleted()) {
+    completed_unwinds.emplace_back(std::move(pending_unwinds_.front()));
+    pending_unwinds_.pop_front();
+  }
+  return completed_unwinds;
+}
+
+void ParallelStackUnwinder::CallCallbacks(
+    absl::Span<const std::unique_ptr<PendingUnwind>> completed_unwinds) {
+  for (const std::unique_ptr<PendingUnwind>& completed_unwind : completed_unwinds) {
+    completed_unwind->callback(completed_unwind->result.value());
+  }
+}
+
+void ParallelStackUnwinder::Submit(Request request, Callback callback) {
+  std::vector<std::unique_ptr<PendingUnwind>> completed_unwinds;
+  {
+    absl::MutexLock lock{&mutex_};
+    if (pending_unwinds_.size() >= kMaxPendingUnwinds) {
+      ORBIT_SCOPE("ParallelStackUnwinder::Submit waiting");
+      mutex_.Await(absl::Condition(this, &ParallelStackUnwinder::IsFrontOfPendingUnwindsCompleted));
+    }
+    completed_unwinds = PopCompletedUnwinds();
+
+    auto pending_unwind = std::make_unique<PendingUnwind>(
+        PendingUnwind{std::move(request), std::move(callback), std::nullopt});
+    unwinds_to_start_.push_back(pending_unwind.get());
+    pending_unwinds_.push_back(std::move(pending_unwind));
+  }
+
+  CallCallbacks(completed_unwinds);
+}
+
+void ParallelStackUnwinder::ProcessCompletedUnwinds() {
+  std::vector<std::unique_ptr<PendingUnwind>> completed_unwinds;
+  {
+    absl::MutexLock lock{&mutex_};
+    completed_unwinds = PopCompletedUnwinds();
+  }
+
+  CallCallbacks(completed_unwinds);
+}
+
+void ParallelStackUnwinder::WaitForAllUnwinds() {
+  ORBIT_SCOPE_FUNCTION;
+  while (true) {
+    std::vector<std::unique_ptr<PendingUnwind>> completed_unwinds;
+    {
+      absl::MutexLock lock{&mutex_};
+      if (pending_unwinds_.empty()) {
+        return;
+      }
+      mutex_.Await(absl::Condition(this, &ParallelStackUnwinder::IsFrontOfPendingUnwindsCompleted));
+      completed_unwinds = PopCompletedUnwinds();
+    }
+
+    CallCallbacks(completed_unwinds);
+  }
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,108 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_PARALLEL_STACK_UNWINDER_H_
+#define LINUX_TRACING_PARALLEL_STACK_UNWINDER_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/types/span.h>
+#include <asm/perf_regs.h>
+#include <sys/types.h>
+#include <unwindstack/Maps.h>
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "LibunwindstackUnwinder.h"
+#include "UnwindingBudget.h"
+
+namespace orbit_linux_tracing {
+
+// ParallelStackUnwinder unwinds stacks with LibunwindstackUnwinder on a pool of worker threads.
+// The callback passed with each request receives the result of the unwinding. Callbacks are
+// called in the order in which the requests were submitted, and only on the thread that calls
+// Submit, ProcessCompletedUnwinds, and WaitForAllUnwinds. This way, the callbacks can access state
+// that is owned by that thread, e.g., the state of a visitor that processes events in order.
+// The caller needs to make sure that the unwindstack::Maps of pending requests are not modified
+// until WaitForAllUnwinds returns.
+class ParallelStackUnwinder {
+ public:
+  // A copy of a slice of the stack, as the memory the event was read into might not outlive the
+  // call to Submit.
+  struct StackSlice {
+    uint64_t start_address;
+    std::vector<uint8_t> data;
+  };
+
+  struct Request {
+    pid_t pid;
+    unwindstack::Maps* maps;
+    std::array<uint64_t, PERF_REG_X86_64_MAX> registers;
+    std::vector<StackSlice> stack_slices;
+    bool offline_memory_only;
+  };
+
+  using Callback = std::function<void(const LibunwindstackResult&)>;
+
+  // If `unwinding_budget` is set, the time each unwind takes is added to it.
+  explicit ParallelStackUnwinder(LibunwindstackUnwinder* unwinder, uint32_t thread_count,
+                                 UnwindingBudget* unwinding_budget = nullptr);
+
+  ParallelStackUnwinder(const ParallelStackUnwinder&) = delete;
+  ParallelStackUnwinder& operator=(const ParallelStackUnwinder&) = delete;
+  ParallelStackUnwinder(ParallelStackUnwinder&&) = delete;
+  ParallelStackUnwinder& operator=(ParallelStackUnwinder&&) = delete;
+
+  // Joins the worker threads. Callbacks of requests that are still pending are not called.
+  ~ParallelStackUnwinder();
+
+  // Blocks while kMaxPendingUnwinds requests are pending, calling the callbacks of the ones that
+  // complete in the meantime.
+  void Submit(Request request, Callback callback);
+  // Calls the callbacks of all requests that have completed and whose predecessors have completed.
+  void ProcessCompletedUnwinds();
+  // Blocks until all submitted requests have completed and their callbacks have been called.
+  void WaitForAllUnwinds();
+
+  static constexpr size_t kMaxPendingUnwinds = 1024;
+
+ private:
+  struct PendingUnwind {
+    Request request;
+    Callback callback;
+    std::optional<LibunwindstackResult> result;
+  };
+
+  void RunWorker();
+  [[nodiscard]] bool HasUnwindsToStartOrIsStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] bool IsFrontOfPendingUnwindsCompleted() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Removes the completed unwinds at the front of pending_unwinds_ and returns them.
+  [[nodiscard]] std::vector<std::unique_ptr<PendingUnwind>> PopCompletedUnwinds()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  static void CallCallbacks(absl::Span<const std::unique_ptr<PendingUnwind>> completed_unwinds);
+
+  LibunwindstackUnwinder* unwinder_;
+  UnwindingBudget* unwinding_budget_;
+
+  absl::Mutex mutex_;
+  // All requests that have been submitted but whose callback hasn't been called yet, in submission
+  // order.
+  std::deque<std::unique_ptr<PendingUnwind>> pending_unwinds_ ABSL_GUARDED_BY(mutex_);
+  // The subset of pending_unwinds_ that no worker has started unwinding yet.
+  std::deque<PendingUnwind*> unwinds_to_start_ ABSL_GUARDED_BY(mutex_);
+  bool stop_workers_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_PARALLEL_STACK_UNWINDER_H_
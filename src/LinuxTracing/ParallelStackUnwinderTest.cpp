@@ -0,0 +1,151 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/types/span.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <unwindstack/Error.h>
+#include <unwindstack/Unwinder.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "LibunwindstackMultipleOfflineAndProcessMemory.h"
+#include "LibunwindstackUnwinder.h"
+#include "ParallelStackUnwinder.h"
+#include "UprobesUnwindingVisitorTestCommon.h"
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+// Uses the pid as the program counter of the only frame, so that results can be told apart.
+[[nodiscard]] LibunwindstackResult MakeResultForPid(pid_t pid) {
+  unwindstack::FrameData frame{};
+  frame.pc = pid;
+  return LibunwindstackResult{{frame}, {}, unwindstack::ErrorCode::ERROR_NONE};
+}
+
+[[nodiscard]] ParallelStackUnwinder::Request MakeRequest(pid_t pid) {
+  return ParallelStackUnwinder::Request{.pid = pid,
+                                        .maps = nullptr,
+                                        .registers = {},
+                                        .stack_slices = {},
+                                        .offline_memory_only = false};
+}
+
+}  // namespace
+
+TEST(ParallelStackUnwinder, CallbacksAreCalledInSubmissionOrder) {
+  MockLibunwindstackUnwinder unwinder;
+  constexpr pid_t kRequestCount = 64;
+  EXPECT_CALL(unwinder, Unwind)
+      .Times(kRequestCount)
+      .WillRepeatedly(Invoke([](pid_t pid, unwindstack::Maps* /*maps*/,
+                                const std::array<uint64_t, PERF_REG_X86_64_MAX>& /*perf_regs*/,
+                                absl::Span<const StackSliceView> /*stack_slices*/,
+                                bool /*offline_memory_only*/, size_t /*max_frames*/) {
+        // Make earlier requests take longer, so that they tend to complete after later ones.
+        usleep((kRequestCount - pid) * 100);
+        return MakeResultForPid(pid);
+      }));
+
+  std::vector<pid_t> pids_in_callback_order;
+  {
+    ParallelStackUnwinder parallel_unwinder{&unwinder, 4};
+    for (pid_t pid = 0; pid < kRequestCount; ++pid) {
+      parallel_unwinder.Submit(MakeRequest(pid),
+                               [&pids_in_callback_order](const LibunwindstackResult& result) {
+                                 ASSERT_EQ(result.frames().size(), 1);
+                                 pids_in_callback_order.push_back(result.frames()[0].pc);
+                               });
+    }
+    parallel_unwinder.WaitForAllUnwinds();
+  }
+
+  ASSERT_EQ(pids_in_callback_order.size(), kRequestCount);
+  for (pid_t pid = 0; pid < kRequestCount; ++pid) {
+    EXPECT_EQ(pids_in_callback_order[pid], pid);
+  }
+}
+
+TEST(ParallelStackUnwinder, UnwindsWithCopiesOfTheStackSlices) {
+  MockLibunwindstackUnwinder unwinder;
+  constexpr uint64_t kFirstStartAddress = 0x1000;
+  constexpr uint64_t kSecondStartAddress = 0x2000;
+  std::vector<uint8_t> first_data;
+  std::vector<uint8_t> second_data;
+  bool offline_memory_only = false;
+  EXPECT_CALL(unwinder, Unwind(42, _, _, _, _, _))
+      .WillOnce(Invoke([&](pid_t pid, unwindstack::Maps* /*maps*/,
+                           const std::array<uint64_t, PERF_REG_X86_64_MAX>& /*perf_regs*/,
+                           absl::Span<const StackSliceView> stack_slices,
+                           bool actual_offline_memory_only, size_t /*max_frames*/) {
+        EXPECT_EQ(stack_slices.size(), 2);
+        EXPECT_EQ(stack_slices[0].start_address(), kFirstStartAddress);
+        first_data.assign(stack_slices[0].data(), stack_slices[0].data() + stack_slices[0].size());
+        EXPECT_EQ(stack_slices[1].start_address(), kSecondStartAddress);
+        second_data.assign(stack_slices[1].data(),
+                           stack_slices[1].data() + stack_slices[1].size());
+        offline_memory_only = actual_offline_memory_only;
+        return MakeResultForPid(pid);
+      }));
+
+  ParallelStackUnwinder parallel_unwinder{&unwinder, 2};
+  ParallelStackUnwinder::Request request = MakeRequest(42);
+  request.stack_slices.push_back({.start_address = kFirstStartAddress, .data = {1, 2, 3}});
+  request.stack_slices.push_back({.start_address = kSecondStartAddress, .data = {4, 5}});
+  request.offline_memory_only = true;
+  int callback_count = 0;
+  parallel_unwinder.Submit(std::move(request),
+                           [&callback_count](const LibunwindstackResult& /*result*/) {
+                             ++callback_count;
+                           });
+  parallel_unwinder.WaitForAllUnwinds();
+
+  EXPECT_EQ(callback_count, 1);
+  EXPECT_THAT(first_data, ElementsAre(1, 2, 3));
+  EXPECT_THAT(second_data, ElementsAre(4, 5));
+  EXPECT_TRUE(offline_memory_only);
+}
+
+TEST(ParallelStackUnwinder, ProcessCompletedUnwindsEventuallyCallsAllCallbacks) {
+  MockLibunwindstackUnwinder unwinder;
+  EXPECT_CALL(unwinder, Unwind).WillRepeatedly(Invoke(
+      [](pid_t pid, unwindstack::Maps* /*maps*/,
+         const std::array<uint64_t, PERF_REG_X86_64_MAX>& /*perf_regs*/,
+         absl::Span<const StackSliceView> /*stack_slices*/, bool /*offline_memory_only*/,
+         size_t /*max_frames*/) { return MakeResultForPid(pid); }));
+
+  ParallelStackUnwinder parallel_unwinder{&unwinder, 3};
+  constexpr int kRequestCount = 10;
+  int callback_count = 0;
+  for (pid_t pid = 0; pid < kRequestCount; ++pid) {
+    parallel_unwinder.Submit(MakeRequest(pid),
+                             [&callback_count](const LibunwindstackResult& /*result*/) {
+                               ++callback_count;
+                             });
+  }
+  while (callback_count < kRequestCount) {
+    parallel_unwinder.ProcessCompletedUnwinds();
+    usleep(100);
+  }
+  EXPECT_EQ(callback_count, kRequestCount);
+}
+
+TEST(ParallelStackUnwinder, WaitForAllUnwindsReturnsWithoutRequests) {
+  MockLibunwindstackUnwinder unwinder;
+  EXPECT_CALL(unwinder, Unwind).Times(0);
+  ParallelStackUnwinder parallel_unwinder{&unwinder, 1};
+  parallel_unwinder.WaitForAllUnwinds();
+  parallel_unwinder.ProcessCompletedUnwinds();
+}
+
+}  // namespace orbit_linux_tracing
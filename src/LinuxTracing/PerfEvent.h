@@ -23,6 +23,7 @@
 #include "OrbitBase/MakeUniqueForOverwrite.h"
 #include "PerfEventOrderedStream.h"
 #include "PerfEventRecords.h"
+#include "StackDataPool.h"
 
 namespace orbit_linux_tracing {
 
@@ -87,7 +88,9 @@ struct StackSamplePerfEventData {
   pid_t tid;
   std::unique_ptr<uint64_t[]> regs;
   uint64_t dyn_size;
-  std::unique_ptr<uint8_t[]> data;
+  StackDataPtr data;
+  // Set if the sample was taken on a minor page fault rather than on the CPU clock.
+  bool is_page_fault = false;
 };
 using StackSamplePerfEvent = TypedPerfEvent<StackSamplePerfEventData>;
 
@@ -121,10 +124,42 @@ struct CallchainSamplePerfEventData {
   mutable uint64_t ips_size;
   mutable std::unique_ptr<uint64_t[]> ips;
   std::unique_ptr<uint64_t[]> regs;
-  std::unique_ptr<uint8_t[]> data;
+  StackDataPtr data;
+  // Set if the sample was taken on a minor page fault rather than on the CPU clock.
+  bool is_page_fault = false;
 };
 using CallchainSamplePerfEvent = TypedPerfEvent<CallchainSamplePerfEventData>;
 
+// A sample with the user-space callstack recorded by the call-stack mode of the Last Branch Record
+// facility. The branch sources are the addresses of the call instructions, innermost first.
+struct LbrCallstackSamplePerfEventData {
+  [[nodiscard]] const uint64_t* GetBranchSources() const { return branch_sources.get(); }
+  [[nodiscard]] uint64_t GetBranchSourcesSize() const { return branch_sources_size; }
+  [[nodiscard]] pid_t GetCallstackPidOrMinusOne() const { return pid; }
+  [[nodiscard]] pid_t GetCallstackTid() const { return tid; }
+
+  pid_t pid;
+  pid_t tid;
+  uint64_t ip;
+  uint64_t branch_sources_size;
+  std::unique_ptr<uint64_t[]> branch_sources;
+};
+using LbrCallstackSamplePerfEvent = TypedPerfEvent<LbrCallstackSamplePerfEventData>;
+
+// The increases of the hardware performance counters of `cpu` since its previous sample, see
+// performance_counter_group_event_open. `pid` and `tid` are those of the thread running at the
+// time of the sample.
+struct PerformanceCounterSamplePerfEventData {
+  pid_t pid;
+  pid_t tid;
+  uint32_t cpu;
+  uint64_t cycles;
+  uint64_t instructions;
+  uint64_t cache_misses;
+  uint64_t branch_misses;
+};
+using PerformanceCounterSamplePerfEvent = TypedPerfEvent<PerformanceCounterSamplePerfEventData>;
+
 struct UprobesPerfEventData {
   pid_t pid;
   pid_t tid;
@@ -161,7 +196,7 @@ struct UprobesWithStackPerfEventData {
   // This mutablility allows moving the data out of this class in the UprobesUnwindingVisitor even
   // if we only have a const reference there. This requires the explicit knowledge that there is
   // only one visitor being applied to this event.
-  mutable std::unique_ptr<uint8_t[]> data;
+  mutable StackDataPtr data;
 };
 using UprobesWithStackPerfEvent = TypedPerfEvent<UprobesWithStackPerfEventData>;
 
@@ -302,7 +337,7 @@ struct SchedWakeupWithCallchainPerfEventData {
   mutable uint64_t ips_size;
   mutable std::unique_ptr<uint64_t[]> ips;
   std::unique_ptr<uint64_t[]> regs;
-  std::unique_ptr<uint8_t[]> data;
+  StackDataPtr data;
 };
 using SchedWakeupWithCallchainPerfEvent = TypedPerfEvent<SchedWakeupWithCallchainPerfEventData>;
 
@@ -339,7 +374,7 @@ struct SchedSwitchWithCallchainPerfEventData {
   mutable uint64_t ips_size;
   mutable std::unique_ptr<uint64_t[]> ips;
   std::unique_ptr<uint64_t[]> regs;
-  std::unique_ptr<uint8_t[]> data;
+  StackDataPtr data;
 };
 using SchedSwitchWithCallchainPerfEvent = TypedPerfEvent<SchedSwitchWithCallchainPerfEventData>;
 
@@ -366,7 +401,7 @@ struct SchedWakeupWithStackPerfEventData {
   pid_t was_unblocked_by_pid;
   std::unique_ptr<uint64_t[]> regs;
   uint64_t dyn_size;
-  std::unique_ptr<uint8_t[]> data;
+  StackDataPtr data;
 };
 using SchedWakeupWithStackPerfEvent = TypedPerfEvent<SchedWakeupWithStackPerfEventData>;
 
@@ -395,7 +430,7 @@ struct SchedSwitchWithStackPerfEventData {
   int32_t next_tid;
   std::unique_ptr<uint64_t[]> regs;
   uint64_t dyn_size;
-  std::unique_ptr<uint8_t[]> data;
+  StackDataPtr data;
 };
 using SchedSwitchWithStackPerfEvent = TypedPerfEvent<SchedSwitchWithStackPerfEventData>;
 
@@ -425,12 +460,14 @@ struct PerfEvent {
   uint64_t timestamp;
   PerfEventOrderedStream ordered_stream = PerfEventOrderedStream::kNone;
   std::variant<ForkPerfEventData, ExitPerfEventData, LostPerfEventData, DiscardedPerfEventData,
-               StackSamplePerfEventData, CallchainSamplePerfEventData, UprobesPerfEventData,
-               UprobesWithArgumentsPerfEventData, UprobesWithStackPerfEventData,
-               UretprobesPerfEventData, UretprobesWithReturnValuePerfEventData,
-               UserSpaceFunctionEntryPerfEventData, UserSpaceFunctionExitPerfEventData,
-               MmapPerfEventData, GenericTracepointPerfEventData, TaskNewtaskPerfEventData,
-               TaskRenamePerfEventData, SchedSwitchPerfEventData, SchedWakeupPerfEventData,
+               StackSamplePerfEventData, CallchainSamplePerfEventData,
+               LbrCallstackSamplePerfEventData, PerformanceCounterSamplePerfEventData,
+               UprobesPerfEventData, UprobesWithArgumentsPerfEventData,
+               UprobesWithStackPerfEventData, UretprobesPerfEventData,
+               UretprobesWithReturnValuePerfEventData, UserSpaceFunctionEntryPerfEventData,
+               UserSpaceFunctionExitPerfEventData, MmapPerfEventData,
+               GenericTracepointPerfEventData, TaskNewtaskPerfEventData, TaskRenamePerfEventData,
+               SchedSwitchPerfEventData, SchedWakeupPerfEventData,
                SchedSwitchWithCallchainPerfEventData, SchedWakeupWithCallchainPerfEventData,
                SchedSwitchWithStackPerfEventData, SchedWakeupWithStackPerfEventData,
                AmdgpuCsIoctlPerfEventData, AmdgpuSchedRunJobPerfEventData,
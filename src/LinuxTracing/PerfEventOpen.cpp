@@ -7,7 +7,10 @@
 #include <absl/base/casts.h>
 #include <linux/perf_event.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <cerrno>
 
 #include "LinuxTracingUtils.h"
@@ -17,7 +20,7 @@
 
 namespace orbit_linux_tracing {
 namespace {
-perf_event_attr generic_event_attr() {
+perf_event_attr generic_event_attr(RingBufferOptions ring_buffer_options) {
   perf_event_attr pe{};
   pe.size = sizeof(struct perf_event_attr);
   pe.sample_period = 1;
@@ -27,6 +30,14 @@ perf_event_attr generic_event_attr() {
   pe.disabled = 1;
   pe.sample_type = kSampleTypeTidTimeStreamidCpu;
 
+  // Only the file descriptor that owns the ring buffer determines when the kernel wakes up the
+  // threads polling on it. When no watermark is set, this happens when half the buffer is filled.
+  if (ring_buffer_options.wakeup_watermark_bytes > 0) {
+    pe.watermark = 1;
+    pe.wakeup_watermark = ring_buffer_options.wakeup_watermark_bytes;
+  }
+  pe.write_backward = ring_buffer_options.write_backward ? 1 : 0;
+
   return pe;
 }
 
@@ -38,8 +49,9 @@ int generic_event_open(perf_event_attr* attr, pid_t pid, int32_t cpu) {
   return fd;
 }
 
-perf_event_attr uprobe_event_attr(const char* module, uint64_t function_offset) {
-  perf_event_attr pe = generic_event_attr();
+perf_event_attr uprobe_event_attr(const char* module, uint64_t function_offset,
+                                  RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
 
   pe.type = 7;                                    // TODO: should be read from
                                                   //  "/sys/bus/event_source/devices/uprobe/type"
@@ -50,8 +62,8 @@ perf_event_attr uprobe_event_attr(const char* module, uint64_t function_offset)
 }
 }  // namespace
 
-int context_switch_event_open(pid_t pid, int32_t cpu) {
-  perf_event_attr pe = generic_event_attr();
+int context_switch_event_open(pid_t pid, int32_t cpu, RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
   pe.type = PERF_TYPE_SOFTWARE;
   pe.config = PERF_COUNT_SW_DUMMY;
   pe.context_switch = 1;
@@ -59,8 +71,8 @@ int context_switch_event_open(pid_t pid, int32_t cpu) {
   return generic_event_open(&pe, pid, cpu);
 }
 
-int mmap_task_event_open(pid_t pid, int32_t cpu) {
-  perf_event_attr pe = generic_event_attr();
+int mmap_task_event_open(pid_t pid, int32_t cpu, RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
   pe.type = PERF_TYPE_SOFTWARE;
   pe.config = PERF_COUNT_SW_DUMMY;
   // Generate events for mmap (and mprotect) calls with the PROT_EXEC flag set.
@@ -72,8 +84,9 @@ int mmap_task_event_open(pid_t pid, int32_t cpu) {
   return generic_event_open(&pe, pid, cpu);
 }
 
-int stack_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu, uint16_t stack_dump_size) {
-  perf_event_attr pe = generic_event_attr();
+int stack_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu, uint16_t stack_dump_size,
+                            RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
   pe.type = PERF_TYPE_SOFTWARE;
   pe.config = PERF_COUNT_SW_CPU_CLOCK;
   pe.sample_period = period_ns;
@@ -86,8 +99,8 @@ int stack_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu, uint16_t
 }
 
 int callchain_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
-                                uint16_t stack_dump_size) {
-  perf_event_attr pe = generic_event_attr();
+                                uint16_t stack_dump_size, RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
   pe.type = PERF_TYPE_SOFTWARE;
   pe.config = PERF_COUNT_SW_CPU_CLOCK;
   pe.sample_period = period_ns;
@@ -105,9 +118,101 @@ int callchain_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
   return generic_event_open(&pe, pid, cpu);
 }
 
+int page_fault_stack_sample_event_open(uint64_t period, pid_t pid, int32_t cpu,
+                                       uint16_t stack_dump_size,
+                                       RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
+  pe.type = PERF_TYPE_SOFTWARE;
+  pe.config = PERF_COUNT_SW_PAGE_FAULTS_MIN;
+  pe.sample_period = period;
+  pe.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
+  pe.sample_regs_user = kSampleRegsUserAll;
+
+  pe.sample_stack_user = stack_dump_size;
+
+  return generic_event_open(&pe, pid, cpu);
+}
+
+int page_fault_callchain_sample_event_open(uint64_t period, pid_t pid, int32_t cpu,
+                                           uint16_t stack_dump_size,
+                                           RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
+  pe.type = PERF_TYPE_SOFTWARE;
+  pe.config = PERF_COUNT_SW_PAGE_FAULTS_MIN;
+  pe.sample_period = period;
+  pe.sample_type |= PERF_SAMPLE_CALLCHAIN;
+  // TODO(b/239003729): Read this from /proc/sys/kernel/perf_event_max_stack
+  pe.sample_max_stack = 127;
+  pe.exclude_callchain_kernel = true;
+
+  // As for callchain_sample_event_open, for patching the callers of leaf functions.
+  pe.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
+  pe.sample_regs_user = kSampleRegsUserAll;
+  pe.sample_stack_user = stack_dump_size;
+
+  return generic_event_open(&pe, pid, cpu);
+}
+
+int lbr_callstack_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
+                                    RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
+  pe.type = PERF_TYPE_HARDWARE;
+  pe.config = PERF_COUNT_HW_CPU_CYCLES;
+  pe.freq = 1;
+  pe.sample_freq = std::max<uint64_t>(1'000'000'000 / period_ns, 1);
+  pe.sample_type |= PERF_SAMPLE_BRANCH_STACK | PERF_SAMPLE_REGS_USER;
+  pe.branch_sample_type = PERF_SAMPLE_BRANCH_USER | PERF_SAMPLE_BRANCH_CALL_STACK |
+                          PERF_SAMPLE_BRANCH_NO_FLAGS | PERF_SAMPLE_BRANCH_NO_CYCLES;
+  // PERF_SAMPLE_IP would break the assumption that all samples start with the sample_id fields,
+  // so take the instruction pointer from the user-space registers.
+  pe.sample_regs_user = kSampleRegsUserSpIp;
+
+  return generic_event_open(&pe, pid, cpu);
+}
+
+int performance_counter_group_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
+                                         RingBufferOptions ring_buffer_options,
+                                         std::vector<int>* counter_fds) {
+  ORBIT_CHECK(counter_fds != nullptr);
+  perf_event_attr leader_pe = generic_event_attr(ring_buffer_options);
+  leader_pe.type = PERF_TYPE_SOFTWARE;
+  leader_pe.config = PERF_COUNT_SW_CPU_CLOCK;
+  leader_pe.sample_period = period_ns;
+  leader_pe.sample_type |= PERF_SAMPLE_READ;
+  leader_pe.read_format = PERF_FORMAT_GROUP;
+
+  int leader_fd = generic_event_open(&leader_pe, pid, cpu);
+  if (leader_fd == -1) return -1;
+
+  // The order must be in sync with RingBufferReadFormatPerformanceCounterGroup. Adding a hardware
+  // event to a group led by a software event moves the whole group to the hardware context.
+  constexpr std::array<uint64_t, kPerformanceCounterCount> kCounterConfigs{
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES};
+  std::vector<int> opened_counter_fds;
+  for (uint64_t config : kCounterConfigs) {
+    // Counting only: the members of a group don't sample, and they are enabled with the leader.
+    perf_event_attr counter_pe{};
+    counter_pe.size = sizeof(struct perf_event_attr);
+    counter_pe.type = PERF_TYPE_HARDWARE;
+    counter_pe.config = config;
+    int counter_fd = perf_event_open(&counter_pe, pid, cpu, leader_fd, PERF_FLAG_FD_CLOEXEC);
+    if (counter_fd == -1) {
+      ORBIT_ERROR("perf_event_open for hardware counter %u: %s", config, SafeStrerror(errno));
+      for (int fd : opened_counter_fds) close(fd);
+      close(leader_fd);
+      return -1;
+    }
+    opened_counter_fds.push_back(counter_fd);
+  }
+
+  counter_fds->insert(counter_fds->end(), opened_counter_fds.begin(), opened_counter_fds.end());
+  return leader_fd;
+}
+
 int uprobes_retaddr_event_open(const char* module, uint64_t function_offset, pid_t pid,
-                               int32_t cpu) {
-  perf_event_attr pe = uprobe_event_attr(module, function_offset);
+                               int32_t cpu, RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = uprobe_event_attr(module, function_offset, ring_buffer_options);
   pe.config &= ~1ULL;
   pe.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
   pe.sample_regs_user = kSampleRegsUserSpIp;
@@ -120,8 +225,9 @@ int uprobes_retaddr_event_open(const char* module, uint64_t function_offset, pid
 }
 
 int uprobes_with_stack_and_sp_event_open(const char* module, uint64_t function_offset, pid_t pid,
-                                         int32_t cpu, uint16_t stack_dump_size) {
-  perf_event_attr pe = uprobe_event_attr(module, function_offset);
+                                         int32_t cpu, uint16_t stack_dump_size,
+                                         RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = uprobe_event_attr(module, function_offset, ring_buffer_options);
   pe.config &= ~1ULL;
   pe.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
   pe.sample_regs_user = kSampleRegsUserSp;
@@ -132,8 +238,8 @@ int uprobes_with_stack_and_sp_event_open(const char* module, uint64_t function_o
 }
 
 int uprobes_retaddr_args_event_open(const char* module, uint64_t function_offset, pid_t pid,
-                                    int32_t cpu) {
-  perf_event_attr pe = uprobe_event_attr(module, function_offset);
+                                    int32_t cpu, RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = uprobe_event_attr(module, function_offset, ring_buffer_options);
   pe.config &= ~1ULL;
   pe.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
   pe.sample_regs_user = kSampleRegsUserSpIpArguments;
@@ -142,16 +248,17 @@ int uprobes_retaddr_args_event_open(const char* module, uint64_t function_offset
   return generic_event_open(&pe, pid, cpu);
 }
 
-int uretprobes_event_open(const char* module, uint64_t function_offset, pid_t pid, int32_t cpu) {
-  perf_event_attr pe = uprobe_event_attr(module, function_offset);
+int uretprobes_event_open(const char* module, uint64_t function_offset, pid_t pid, int32_t cpu,
+                          RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = uprobe_event_attr(module, function_offset, ring_buffer_options);
   pe.config |= 1;  // Set bit 0 of config for uretprobe.
 
   return generic_event_open(&pe, pid, cpu);
 }
 
 int uretprobes_retval_event_open(const char* module, uint64_t function_offset, pid_t pid,
-                                 int32_t cpu) {
-  perf_event_attr pe = uprobe_event_attr(module, function_offset);
+                                 int32_t cpu, RingBufferOptions ring_buffer_options) {
+  perf_event_attr pe = uprobe_event_attr(module, function_offset, ring_buffer_options);
   pe.config |= 1;  // Set bit 0 of config for uretprobe.
 
   pe.sample_type |= PERF_SAMPLE_REGS_USER;
@@ -160,7 +267,7 @@ int uretprobes_retval_event_open(const char* module, uint64_t function_offset, p
   return generic_event_open(&pe, pid, cpu);
 }
 
-void* perf_event_open_mmap_ring_buffer(int fd, uint64_t mmap_length) {
+void* perf_event_open_mmap_ring_buffer(int fd, uint64_t mmap_length, bool overwrite) {
   // The size of the ring buffer excluding the metadata page must be a power of
   // two number of pages.
   if (mmap_length < GetPageSize() || __builtin_popcountl(mmap_length - GetPageSize()) != 1) {
@@ -169,7 +276,8 @@ void* perf_event_open_mmap_ring_buffer(int fd, uint64_t mmap_length) {
   }
 
   // Use mmap to get access to the ring buffer.
-  void* mmap_ret = mmap(nullptr, mmap_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int prot = overwrite ? PROT_READ : (PROT_READ | PROT_WRITE);
+  void* mmap_ret = mmap(nullptr, mmap_length, prot, MAP_SHARED, fd, 0);
   if (mmap_ret == MAP_FAILED) {
     ORBIT_ERROR("mmap: %s", SafeStrerror(errno));
     return nullptr;
@@ -179,12 +287,12 @@ void* perf_event_open_mmap_ring_buffer(int fd, uint64_t mmap_length) {
 }
 
 int tracepoint_event_open(const char* tracepoint_category, const char* tracepoint_name, pid_t pid,
-                          int32_t cpu) {
+                          int32_t cpu, RingBufferOptions ring_buffer_options) {
   int tp_id = GetTracepointId(tracepoint_category, tracepoint_name);
   if (tp_id == -1) {
     return -1;
   }
-  perf_event_attr pe = generic_event_attr();
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
   pe.type = PERF_TYPE_TRACEPOINT;
   pe.config = tp_id;
   pe.sample_type |= PERF_SAMPLE_RAW;
@@ -194,12 +302,13 @@ int tracepoint_event_open(const char* tracepoint_category, const char* tracepoin
 
 int tracepoint_with_callchain_event_open(const char* tracepoint_category,
                                          const char* tracepoint_name, pid_t pid, int32_t cpu,
-                                         uint16_t stack_dump_size) {
+                                         uint16_t stack_dump_size,
+                                         RingBufferOptions ring_buffer_options) {
   int tp_id = GetTracepointId(tracepoint_category, tracepoint_name);
   if (tp_id == -1) {
     return -1;
   }
-  perf_event_attr pe = generic_event_attr();
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
   pe.type = PERF_TYPE_TRACEPOINT;
   pe.config = tp_id;
   pe.sample_type |= PERF_SAMPLE_CALLCHAIN | PERF_SAMPLE_RAW;
@@ -217,12 +326,13 @@ int tracepoint_with_callchain_event_open(const char* tracepoint_category,
 }
 
 int tracepoint_with_stack_event_open(const char* tracepoint_category, const char* tracepoint_name,
-                                     pid_t pid, int32_t cpu, uint16_t stack_dump_size) {
+                                     pid_t pid, int32_t cpu, uint16_t stack_dump_size,
+                                     RingBufferOptions ring_buffer_options) {
   int tp_id = GetTracepointId(tracepoint_category, tracepoint_name);
   if (tp_id == -1) {
     return -1;
   }
-  perf_event_attr pe = generic_event_attr();
+  perf_event_attr pe = generic_event_attr(ring_buffer_options);
   pe.type = PERF_TYPE_TRACEPOINT;
   pe.config = tp_id;
   pe.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER | PERF_SAMPLE_RAW;
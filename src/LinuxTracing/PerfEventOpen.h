@@ -14,6 +14,7 @@
 
 #include <cerrno>
 #include <cstdint>
+#include <vector>
 
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/SafeStrerror.h"
@@ -46,6 +47,13 @@ inline void perf_event_disable(int file_descriptor) {
   }
 }
 
+inline void perf_event_set_period(int file_descriptor, uint64_t period) {
+  int ret = ioctl(file_descriptor, PERF_EVENT_IOC_PERIOD, &period);
+  if (ret != 0) {
+    ORBIT_ERROR("PERF_EVENT_IOC_PERIOD: %s", SafeStrerror(errno));
+  }
+}
+
 inline void perf_event_redirect(int from_fd, int to_fd) {
   int ret = ioctl(from_fd, PERF_EVENT_IOC_SET_OUTPUT, to_fd);
   if (ret != 0) {
@@ -113,50 +121,101 @@ static constexpr uint16_t kSampleStackUserSize8Bytes = 8;
 // See also `ClientFlags.cpp`.
 static constexpr uint16_t kMaxStackSampleUserSize = 65000;
 
+// The number of hardware counters that performance_counter_group_event_open adds to the group,
+// in addition to the leader. This must be in sync with
+// RingBufferReadFormatPerformanceCounterGroup in PerfEventRecords.h.
+static constexpr uint64_t kPerformanceCounterCount = 4;
+
+// Options for the ring buffer that a file descriptor opened by the functions below ends up owning.
+// All the file descriptors redirected to the same ring buffer must be opened with the same options.
+struct RingBufferOptions {
+  // Threads polling on the file descriptor are woken up every time this amount of bytes has been
+  // written into the buffer. 0 keeps the kernel's default, which is half the buffer size.
+  uint32_t wakeup_watermark_bytes = 0;
+  // Sets perf_event_attr::write_backward: the kernel writes records from the end of the ring buffer
+  // towards its beginning. Together with a read-only mapping (see PerfEventRingBuffer), this makes
+  // the kernel overwrite the oldest records when the buffer is full, while the newest ones can
+  // still be found starting from data_head.
+  bool write_backward = false;
+};
+
 // perf_event_open for context switches.
-int context_switch_event_open(pid_t pid, int32_t cpu);
+int context_switch_event_open(pid_t pid, int32_t cpu, RingBufferOptions ring_buffer_options);
 
 // perf_event_open for task (fork and exit) and mmap records in the same buffer.
-int mmap_task_event_open(pid_t pid, int32_t cpu);
+int mmap_task_event_open(pid_t pid, int32_t cpu, RingBufferOptions ring_buffer_options);
 
 // perf_event_open for stack sampling.
-int stack_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu, uint16_t stack_dump_size);
+int stack_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu, uint16_t stack_dump_size,
+                            RingBufferOptions ring_buffer_options);
 
 // perf_event_open for stack sampling using frame pointers.
 int callchain_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
-                                uint16_t stack_dump_size);
+                                uint16_t stack_dump_size, RingBufferOptions ring_buffer_options);
+
+// perf_event_open for sampling the stack, respectively the callchain using frame pointers, on one
+// in every `period` minor page faults. The records have the same layout as the ones of
+// stack_sample_event_open and callchain_sample_event_open.
+int page_fault_stack_sample_event_open(uint64_t period, pid_t pid, int32_t cpu,
+                                       uint16_t stack_dump_size,
+                                       RingBufferOptions ring_buffer_options);
+
+int page_fault_callchain_sample_event_open(uint64_t period, pid_t pid, int32_t cpu,
+                                           uint16_t stack_dump_size,
+                                           RingBufferOptions ring_buffer_options);
+
+// perf_event_open for sampling the user-space callstack from the call-stack mode of the Last
+// Branch Record facility, together with the user-space instruction pointer. This samples CPU
+// cycles at about 1/period_ns, as LBR is not available with software events.
+int lbr_callstack_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
+                                    RingBufferOptions ring_buffer_options);
+
+// perf_event_open for a group that counts CPU cycles, instructions, cache misses and branch misses
+// on `cpu`, led by a CPU clock event that samples every period_ns and reads the whole group in each
+// sample (PERF_SAMPLE_READ with PERF_FORMAT_GROUP). Returns the file descriptor of the leader, or
+// -1 in case of errors, and appends the file descriptors of the counters to `counter_fds`. The
+// counters are enabled and disabled with the leader, but still need to be closed separately.
+int performance_counter_group_event_open(uint64_t period_ns, pid_t pid, int32_t cpu,
+                                         RingBufferOptions ring_buffer_options,
+                                         std::vector<int>* counter_fds);
 
 // perf_event_open for uprobes and uretprobes.
 int uprobes_retaddr_event_open(const char* module, uint64_t function_offset, pid_t pid,
-                               int32_t cpu);
+                               int32_t cpu, RingBufferOptions ring_buffer_options);
 
 int uprobes_with_stack_and_sp_event_open(const char* module, uint64_t function_offset, pid_t pid,
-                                         int32_t cpu, uint16_t stack_dump_size);
+                                         int32_t cpu, uint16_t stack_dump_size,
+                                         RingBufferOptions ring_buffer_options);
 
 int uprobes_retaddr_args_event_open(const char* module, uint64_t function_offset, pid_t pid,
-                                    int32_t cpu);
+                                    int32_t cpu, RingBufferOptions ring_buffer_options);
 
-int uretprobes_event_open(const char* module, uint64_t function_offset, pid_t pid, int32_t cpu);
+int uretprobes_event_open(const char* module, uint64_t function_offset, pid_t pid, int32_t cpu,
+                          RingBufferOptions ring_buffer_options);
 
 int uretprobes_retval_event_open(const char* module, uint64_t function_offset, pid_t pid,
-                                 int32_t cpu);
+                                 int32_t cpu, RingBufferOptions ring_buffer_options);
 
-// Create the ring buffer to use perf_event_open in sampled mode.
-void* perf_event_open_mmap_ring_buffer(int fd, uint64_t mmap_length);
+// Create the ring buffer to use perf_event_open in sampled mode. With `overwrite`, the ring buffer
+// is mapped read-only, so that the kernel doesn't wait for data_tail to advance and overwrites old
+// records instead of dropping new ones.
+void* perf_event_open_mmap_ring_buffer(int fd, uint64_t mmap_length, bool overwrite);
 
 // perf_event_open for tracepoint events. This opens a perf event for the
 // tracepoint given by the category (for example, "sched") and the name
 // (for example, "sched_waking"). Returns the file descriptor for the
 // perf event or -1 in case of any errors.
 int tracepoint_event_open(const char* tracepoint_category, const char* tracepoint_name, pid_t pid,
-                          int32_t cpu);
+                          int32_t cpu, RingBufferOptions ring_buffer_options);
 
 int tracepoint_with_stack_event_open(const char* tracepoint_category, const char* tracepoint_name,
-                                     pid_t pid, int32_t cpu, uint16_t stack_dump_size);
+                                     pid_t pid, int32_t cpu, uint16_t stack_dump_size,
+                                     RingBufferOptions ring_buffer_options);
 
 int tracepoint_with_callchain_event_open(const char* tracepoint_category,
                                          const char* tracepoint_name, pid_t pid, int32_t cpu,
-                                         uint16_t stack_dump_size);
+                                         uint16_t stack_dump_size,
+                                         RingBufferOptions ring_buffer_options);
 
 }  // namespace orbit_linux_tracing
 
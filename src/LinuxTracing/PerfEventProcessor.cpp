@@ -85,23 +85,43 @@ std::optional<DiscardedPerfEvent> PerfEventProcessor::HandleOutOfOrderEvent(
   return optional_discarded_event;
 }
 
+void PerfEventProcessor::ProcessEvent(const PerfEvent& event) {
+  // Events are guaranteed to be processed in order of timestamp
+  // as out-of-order events are discarded in AddEvent.
+  ORBIT_CHECK(event.timestamp >= last_processed_timestamp_ns_);
+  last_processed_timestamp_ns_ = event.timestamp;
+  ++processed_event_count_;
+
+  if (visitor_times_ns_.empty()) {
+    for (PerfEventVisitor* visitor : visitors_) {
+      event.Accept(visitor);
+    }
+    return;
+  }
+
+  ORBIT_CHECK(visitor_times_ns_.size() == visitors_.size());
+  // The end of the time spent in one visitor is the beginning of the time spent in the next one.
+  uint64_t begin_ns = orbit_base::CaptureTimestampNs();
+  for (size_t i = 0; i < visitors_.size(); ++i) {
+    event.Accept(visitors_[i]);
+    const uint64_t end_ns = orbit_base::CaptureTimestampNs();
+    visitor_times_ns_[i] += end_ns - begin_ns;
+    ++visitor_event_counts_[i];
+    begin_ns = end_ns;
+  }
+}
+
 void PerfEventProcessor::ProcessAllEvents() {
   ORBIT_SCOPE("PerfEventProcessor::ProcessAllEvents");
   ORBIT_CHECK(!visitors_.empty());
   while (event_queue_.HasEvent()) {
-    const PerfEvent& event = event_queue_.TopEvent();
-    // Events are guaranteed to be processed in order of timestamp
-    // as out-of-order events are discarded in AddEvent.
-    ORBIT_CHECK(event.timestamp >= last_processed_timestamp_ns_);
-    last_processed_timestamp_ns_ = event.timestamp;
-    for (PerfEventVisitor* visitor : visitors_) {
-      event.Accept(visitor);
-    }
+    ProcessEvent(event_queue_.TopEvent());
     event_queue_.PopEvent();
   }
+  queued_event_count_.store(event_queue_.size(), std::memory_order_relaxed);
 }
 
-void PerfEventProcessor::ProcessOldEvents() {
+void PerfEventProcessor::ProcessOldEvents(uint64_t low_watermark_ns) {
   ORBIT_SCOPE("PerfEventProcessor::ProcessOldEvents");
   ORBIT_CHECK(!visitors_.empty());
   const uint64_t current_timestamp_ns = orbit_base::CaptureTimestampNs();
@@ -110,20 +130,32 @@ void PerfEventProcessor::ProcessOldEvents() {
     const PerfEvent& event = event_queue_.TopEvent();
     const uint64_t timestamp = event.timestamp;
 
-    // Do not read the most recent events as out-of-order events could (and will) arrive.
-    if (timestamp + kProcessingDelayMs * 1'000'000 >= current_timestamp_ns) {
+    // Do not read the most recent events as out-of-order events could (and will) arrive, unless
+    // the caller guarantees that no events older than the watermark can arrive anymore.
+    if (timestamp >= low_watermark_ns &&
+        timestamp + kProcessingDelayMs * 1'000'000 >= current_timestamp_ns) {
       break;
     }
-    // Events are guaranteed to be processed in order of timestamp
-    // as out-of-order events are discarded in AddEvent.
-    ORBIT_CHECK(timestamp >= last_processed_timestamp_ns_);
-    last_processed_timestamp_ns_ = timestamp;
+    ProcessEvent(event);
+    event_queue_.PopEvent();
+  }
+  queued_event_count_.store(event_queue_.size(), std::memory_order_relaxed);
+}
 
-    for (PerfEventVisitor* visitor : visitors_) {
-      event.Accept(visitor);
-    }
+void PerfEventProcessor::ProcessEventsOlderThan(uint64_t low_watermark_ns) {
+  ORBIT_SCOPE("PerfEventProcessor::ProcessEventsOlderThan");
+  ORBIT_CHECK(!visitors_.empty());
+  while (event_queue_.HasEvent() && event_queue_.TopEvent().timestamp < low_watermark_ns) {
+    ProcessEvent(event_queue_.TopEvent());
     event_queue_.PopEvent();
   }
+  queued_event_count_.store(event_queue_.size(), std::memory_order_relaxed);
+}
+
+void PerfEventProcessor::EnableVisitorTiming() {
+  ORBIT_CHECK(!visitors_.empty());
+  visitor_times_ns_.assign(visitors_.size(), 0);
+  visitor_event_counts_.assign(visitors_.size(), 0);
 }
 
 }  // namespace orbit_linux_tracing
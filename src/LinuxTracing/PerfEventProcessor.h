@@ -25,17 +25,47 @@ namespace orbit_linux_tracing {
 // we will never process events out of order.
 // If events older than kProcessingDelayMs are encountered anyway, these are discarded, and
 // DiscardedPerfEvents are generated and processed in their place.
+// When the caller knows that no event older than a certain timestamp (the low watermark) will be
+// added anymore, e.g., because all sources of events have been read up to that point, it can pass
+// that timestamp to ProcessOldEvents, so that events older than it are processed without waiting
+// for kProcessingDelayMs. The delay then only applies to the events newer than the watermark.
 class PerfEventProcessor {
  public:
   void AddEvent(PerfEvent&& event);
 
   void ProcessAllEvents();
 
-  void ProcessOldEvents();
+  // Processes the events older than kProcessingDelayMs, and also all the events older than
+  // low_watermark_ns. Pass 0 if no watermark is known.
+  void ProcessOldEvents(uint64_t low_watermark_ns = 0);
+
+  // Only processes the events older than low_watermark_ns, regardless of the current time. This is
+  // for replaying events, whose timestamps are unrelated to the current time.
+  void ProcessEventsOlderThan(uint64_t low_watermark_ns);
 
   void AddVisitor(PerfEventVisitor* visitor) { visitors_.push_back(visitor); }
 
-  void ClearVisitors() { visitors_.clear(); }
+  void ClearVisitors() {
+    visitors_.clear();
+    visitor_times_ns_.clear();
+    visitor_event_counts_.clear();
+  }
+
+  // Starts measuring the time spent in each of the visitors added so far, and counting the events
+  // passed to each of them. This reads the clock once per visitor and event, plus once per event.
+  void EnableVisitorTiming();
+  // Both indexed in the order in which the visitors were added. Empty if EnableVisitorTiming wasn't
+  // called.
+  [[nodiscard]] const std::vector<uint64_t>& GetVisitorTimesNs() const { return visitor_times_ns_; }
+  [[nodiscard]] const std::vector<uint64_t>& GetVisitorEventCounts() const {
+    return visitor_event_counts_;
+  }
+  [[nodiscard]] uint64_t GetProcessedEventCount() const { return processed_event_count_; }
+  // The number of events waiting to be processed, as of the end of the last call to one of the
+  // Process... methods. This can be called from any thread.
+  [[nodiscard]] size_t GetQueuedEventCount() const {
+    return queued_event_count_.load(std::memory_order_relaxed);
+  }
 
   void SetDiscardedOutOfOrderCounter(std::atomic<uint64_t>* discarded_out_of_order_counter) {
     discarded_out_of_order_counter_ = discarded_out_of_order_counter;
@@ -48,10 +78,16 @@ class PerfEventProcessor {
   static constexpr uint64_t kProcessingDelayMs = 333;
 
  private:
+  void ProcessEvent(const PerfEvent& event);
+
   uint64_t last_processed_timestamp_ns_ = 0;
+  uint64_t processed_event_count_ = 0;
+  std::vector<uint64_t> visitor_times_ns_;
+  std::vector<uint64_t> visitor_event_counts_;
   std::atomic<uint64_t>* discarded_out_of_order_counter_ = nullptr;
 
   PerfEventQueue event_queue_;
+  std::atomic<size_t> queued_event_count_ = 0;
   std::vector<PerfEventVisitor*> visitors_;
 
   [[nodiscard]] std::optional<DiscardedPerfEvent> HandleOutOfOrderEvent(
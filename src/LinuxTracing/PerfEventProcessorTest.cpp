@@ -19,6 +19,7 @@
 
 using ::testing::_;
 using ::testing::A;
+using ::testing::ElementsAre;
 using ::testing::Mock;
 
 namespace orbit_linux_tracing {
@@ -102,6 +103,70 @@ TEST_F(PerfEventProcessorTest, ProcessOldEvents) {
   EXPECT_EQ(discarded_out_of_order_counter_, 0);
 }
 
+TEST_F(PerfEventProcessorTest, ProcessOldEventsWithLowWatermark) {
+  const uint64_t first_timestamp_ns = orbit_base::CaptureTimestampNs();
+  processor_.AddEvent(MakeFakePerfEventOrderedInFd(11, first_timestamp_ns));
+  processor_.AddEvent(MakeFakePerfEventOrderedInFd(22, first_timestamp_ns + 1));
+  processor_.AddEvent(MakeFakePerfEventOrderedInFd(11, first_timestamp_ns + 2));
+
+  // Only the events older than the watermark are processed, without waiting for the delay.
+  EXPECT_CALL(mock_visitor_, Visit(first_timestamp_ns, A<const ForkPerfEventData&>())).Times(1);
+  EXPECT_CALL(mock_visitor_, Visit(first_timestamp_ns + 1, A<const ForkPerfEventData&>()))
+      .Times(1);
+  processor_.ProcessOldEvents(first_timestamp_ns + 2);
+  Mock::VerifyAndClearExpectations(&mock_visitor_);
+
+  // Without a watermark, the remaining event waits for the delay as usual.
+  EXPECT_CALL(mock_visitor_, Visit(_, A<const ForkPerfEventData&>())).Times(0);
+  processor_.ProcessOldEvents();
+  Mock::VerifyAndClearExpectations(&mock_visitor_);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(kDelayBeforeProcessOldEventsMs));
+
+  EXPECT_CALL(mock_visitor_, Visit(first_timestamp_ns + 2, A<const ForkPerfEventData&>()))
+      .Times(1);
+  processor_.ProcessOldEvents(first_timestamp_ns);
+  EXPECT_EQ(discarded_out_of_order_counter_, 0);
+}
+
+TEST_F(PerfEventProcessorTest, ProcessEventsOlderThanIgnoresTheCurrentTime) {
+  // Timestamps far in the past would be processed by ProcessOldEvents regardless of the watermark.
+  processor_.AddEvent(MakeFakePerfEventOrderedInFd(11, 100));
+  processor_.AddEvent(MakeFakePerfEventOrderedInFd(22, 200));
+  processor_.AddEvent(MakeFakePerfEventOrderedInFd(11, 300));
+
+  EXPECT_CALL(mock_visitor_, Visit(100, A<const ForkPerfEventData&>())).Times(1);
+  EXPECT_CALL(mock_visitor_, Visit(200, A<const ForkPerfEventData&>())).Times(1);
+  processor_.ProcessEventsOlderThan(300);
+  Mock::VerifyAndClearExpectations(&mock_visitor_);
+  EXPECT_EQ(processor_.GetProcessedEventCount(), 2);
+
+  EXPECT_CALL(mock_visitor_, Visit(300, A<const ForkPerfEventData&>())).Times(1);
+  processor_.ProcessEventsOlderThan(301);
+  EXPECT_EQ(processor_.GetProcessedEventCount(), 3);
+}
+
+TEST_F(PerfEventProcessorTest, VisitorTimingHasOneEntryPerVisitor) {
+  EXPECT_TRUE(processor_.GetVisitorTimesNs().empty());
+  MockVisitor other_mock_visitor;
+  processor_.AddVisitor(&other_mock_visitor);
+  processor_.EnableVisitorTiming();
+  EXPECT_EQ(processor_.GetVisitorTimesNs().size(), 2);
+
+  EXPECT_CALL(mock_visitor_, Visit(_, A<const ForkPerfEventData&>())).Times(2);
+  EXPECT_CALL(other_mock_visitor, Visit(_, A<const ForkPerfEventData&>())).Times(2);
+  processor_.AddEvent(MakeFakePerfEventOrderedInFd(11, 100));
+  processor_.AddEvent(MakeFakePerfEventOrderedInFd(11, 200));
+  processor_.ProcessAllEvents();
+  EXPECT_EQ(processor_.GetVisitorTimesNs().size(), 2);
+  EXPECT_THAT(processor_.GetVisitorEventCounts(), ElementsAre(2, 2));
+  EXPECT_EQ(processor_.GetProcessedEventCount(), 2);
+
+  processor_.ClearVisitors();
+  EXPECT_TRUE(processor_.GetVisitorTimesNs().empty());
+  EXPECT_TRUE(processor_.GetVisitorEventCounts().empty());
+}
+
 TEST_F(PerfEventProcessorTest, ProcessAllEvents) {
   EXPECT_CALL(mock_visitor_, Visit(_, A<const ForkPerfEventData&>())).Times(4);
   processor_.AddEvent(MakeFakePerfEventOrderedInFd(11, orbit_base::CaptureTimestampNs()));
@@ -17,6 +17,7 @@
 namespace orbit_linux_tracing {
 
 void PerfEventQueue::PushEvent(PerfEvent&& event) {
+  ++size_;
   const PerfEventOrderedStream order = event.ordered_stream;
   if (order == PerfEventOrderedStream::kNone) {
     priority_queue_of_events_not_ordered_in_stream_.push(std::move(event));
@@ -27,6 +28,7 @@ void PerfEventQueue::PushEvent(PerfEvent&& event) {
     ORBIT_CHECK(!queue->empty());
     // Fundamental assumption: events from the same file descriptor come already in order.
     ORBIT_CHECK(event.timestamp >= queue->back().timestamp);
+    // The front of the queue doesn't change, so neither does the tournament tree.
     queue->push(std::move(event));
   } else {
     queue_it = queues_of_events_ordered_in_stream_
@@ -35,13 +37,14 @@ void PerfEventQueue::PushEvent(PerfEvent&& event) {
     const std::unique_ptr<std::queue<PerfEvent>>& queue = queue_it->second;
 
     queue->push(std::move(event));
-    heap_of_queues_of_events_ordered_in_stream_.emplace_back(queue.get());
-    MoveUpBackOfHeapOfQueues();
+    const size_t leaf_index = AssignLeaf(queue.get());
+    UpdateTournamentTreeFromLeaf(leaf_index);
+    UpdateRunnerUpTimestamp();
   }
 }
 
 bool PerfEventQueue::HasEvent() const {
-  return !heap_of_queues_of_events_ordered_in_stream_.empty() ||
+  return !queues_of_events_ordered_in_stream_.empty() ||
          !priority_queue_of_events_not_ordered_in_stream_.empty();
 }
 
@@ -50,92 +53,140 @@ const PerfEvent& PerfEventQueue::TopEvent() {
   // top of the two queues. In case those two events have the exact same timestamp, return the one
   // at the top of priority_queue_of_events_not_ordered_in_stream_ (and do the same in PopEvent).
   if (priority_queue_of_events_not_ordered_in_stream_.empty()) {
-    ORBIT_CHECK(!heap_of_queues_of_events_ordered_in_stream_.empty());
-    ORBIT_CHECK(!heap_of_queues_of_events_ordered_in_stream_.front()->empty());
-    return heap_of_queues_of_events_ordered_in_stream_.front()->front();
+    ORBIT_CHECK(!queues_of_events_ordered_in_stream_.empty());
+    ORBIT_CHECK(!leaf_queues_[GetWinnerLeafIndex()]->empty());
+    return leaf_queues_[GetWinnerLeafIndex()]->front();
   }
-  if (heap_of_queues_of_events_ordered_in_stream_.empty()) {
+  if (queues_of_events_ordered_in_stream_.empty()) {
     ORBIT_CHECK(!priority_queue_of_events_not_ordered_in_stream_.empty());
     return priority_queue_of_events_not_ordered_in_stream_.top();
   }
-  return (heap_of_queues_of_events_ordered_in_stream_.front()->front().timestamp <
+  return (leaf_front_timestamps_[GetWinnerLeafIndex()] <
           priority_queue_of_events_not_ordered_in_stream_.top().timestamp)
-             ? heap_of_queues_of_events_ordered_in_stream_.front()->front()
+             ? leaf_queues_[GetWinnerLeafIndex()]->front()
              : priority_queue_of_events_not_ordered_in_stream_.top();
 }
 
 void PerfEventQueue::PopEvent() {
+  ORBIT_CHECK(size_ > 0);
+  --size_;
   if (!priority_queue_of_events_not_ordered_in_stream_.empty() &&
-      (heap_of_queues_of_events_ordered_in_stream_.empty() ||
+      (queues_of_events_ordered_in_stream_.empty() ||
        priority_queue_of_events_not_ordered_in_stream_.top().timestamp <=
-           heap_of_queues_of_events_ordered_in_stream_.front()->front().timestamp)) {
+           leaf_front_timestamps_[GetWinnerLeafIndex()])) {
     // The oldest event is at the top of the priority queue holding the events that cannot be
     // assumed sorted in any stream. Note in particular that we pop this event even if the event at
-    // the top of heap_of_queues_of_events_ordered_in_stream_ has the exact same timestamp, as we
-    // need to be consistent with TopEvent.
+    // the top of the tournament tree has the exact same timestamp, as we need to be consistent with
+    // TopEvent.
     priority_queue_of_events_not_ordered_in_stream_.pop();
     return;
   }
 
-  std::queue<PerfEvent>* top_queue = heap_of_queues_of_events_ordered_in_stream_.front();
+  ORBIT_CHECK(!queues_of_events_ordered_in_stream_.empty());
+  const size_t winner_leaf_index = GetWinnerLeafIndex();
+  std::queue<PerfEvent>* top_queue = leaf_queues_[winner_leaf_index];
   const PerfEventOrderedStream top_order = top_queue->front().ordered_stream;
   top_queue->pop();
 
   if (top_queue->empty()) {
+    FreeLeaf(winner_leaf_index);
     queues_of_events_ordered_in_stream_.erase(top_order);
-    std::swap(heap_of_queues_of_events_ordered_in_stream_.front(),
-              heap_of_queues_of_events_ordered_in_stream_.back());
-    heap_of_queues_of_events_ordered_in_stream_.pop_back();
+    UpdateTournamentTreeFromLeaf(winner_leaf_index);
+    UpdateRunnerUpTimestamp();
+    return;
   }
 
-  MoveDownFrontOfHeapOfQueues();
+  const uint64_t new_front_timestamp = top_queue->front().timestamp;
+  leaf_front_timestamps_[winner_leaf_index] = new_front_timestamp;
+  // The winner stays the same if its new front event is still strictly older than the front events
+  // of all other queues. Ties go through the tree, so that they are always broken the same way.
+  if (new_front_timestamp < runner_up_timestamp_) {
+    return;
+  }
+  UpdateTournamentTreeFromLeaf(winner_leaf_index);
+  UpdateRunnerUpTimestamp();
 }
 
-void PerfEventQueue::MoveDownFrontOfHeapOfQueues() {
-  if (heap_of_queues_of_events_ordered_in_stream_.empty()) {
-    return;
+bool PerfEventQueue::IsLeafBefore(size_t lhs_leaf_index, size_t rhs_leaf_index) const {
+  const uint64_t lhs_timestamp = leaf_front_timestamps_[lhs_leaf_index];
+  const uint64_t rhs_timestamp = leaf_front_timestamps_[rhs_leaf_index];
+  if (lhs_timestamp != rhs_timestamp) {
+    return lhs_timestamp < rhs_timestamp;
+  }
+  // An event could in principle have timestamp kFreeLeafTimestamp, so also check for free leaves.
+  const bool lhs_is_free = leaf_queues_[lhs_leaf_index] == nullptr;
+  const bool rhs_is_free = leaf_queues_[rhs_leaf_index] == nullptr;
+  if (lhs_is_free != rhs_is_free) {
+    return rhs_is_free;
   }
+  return lhs_leaf_index < rhs_leaf_index;
+}
 
-  size_t current_index = 0;
-  while (true) {
-    size_t new_index = current_index;
-    size_t left_index = current_index * 2 + 1;
-    size_t right_index = current_index * 2 + 2;
-    if (left_index < heap_of_queues_of_events_ordered_in_stream_.size() &&
-        heap_of_queues_of_events_ordered_in_stream_[left_index]->front().timestamp <
-            heap_of_queues_of_events_ordered_in_stream_[new_index]->front().timestamp) {
-      new_index = left_index;
-    }
-    if (right_index < heap_of_queues_of_events_ordered_in_stream_.size() &&
-        heap_of_queues_of_events_ordered_in_stream_[right_index]->front().timestamp <
-            heap_of_queues_of_events_ordered_in_stream_[new_index]->front().timestamp) {
-      new_index = right_index;
+size_t PerfEventQueue::AssignLeaf(std::queue<PerfEvent>* queue) {
+  if (free_leaf_indices_.empty()) {
+    const size_t old_leaf_count = leaf_queues_.size();
+    const size_t new_leaf_count = old_leaf_count == 0 ? kInitialLeafCount : 2 * old_leaf_count;
+    leaf_queues_.resize(new_leaf_count, nullptr);
+    leaf_front_timestamps_.resize(new_leaf_count, kFreeLeafTimestamp);
+    // Push in reverse order so that the leaves with lower indices are assigned first.
+    for (size_t leaf_index = new_leaf_count; leaf_index > old_leaf_count; --leaf_index) {
+      free_leaf_indices_.push_back(leaf_index - 1);
     }
-    if (new_index != current_index) {
-      std::swap(heap_of_queues_of_events_ordered_in_stream_[new_index],
-                heap_of_queues_of_events_ordered_in_stream_[current_index]);
-      current_index = new_index;
-    } else {
+    RebuildTournamentTree();
+  }
+
+  const size_t leaf_index = free_leaf_indices_.back();
+  free_leaf_indices_.pop_back();
+  leaf_queues_[leaf_index] = queue;
+  leaf_front_timestamps_[leaf_index] = queue->front().timestamp;
+  return leaf_index;
+}
+
+void PerfEventQueue::FreeLeaf(size_t leaf_index) {
+  leaf_queues_[leaf_index] = nullptr;
+  leaf_front_timestamps_[leaf_index] = kFreeLeafTimestamp;
+  free_leaf_indices_.push_back(leaf_index);
+}
+
+void PerfEventQueue::UpdateTournamentTreeFromLeaf(size_t leaf_index) {
+  const size_t leaf_count = leaf_queues_.size();
+  for (size_t node_index = (leaf_count + leaf_index) / 2; node_index > 0; node_index /= 2) {
+    const size_t left_winner = tournament_tree_[2 * node_index];
+    const size_t right_winner = tournament_tree_[2 * node_index + 1];
+    const size_t new_winner = IsLeafBefore(left_winner, right_winner) ? left_winner : right_winner;
+    // If a different leaf was and still is the winner of this subtree, nothing changes further up.
+    if (new_winner == tournament_tree_[node_index] && new_winner != leaf_index) {
       break;
     }
+    tournament_tree_[node_index] = new_winner;
   }
 }
 
-void PerfEventQueue::MoveUpBackOfHeapOfQueues() {
-  if (heap_of_queues_of_events_ordered_in_stream_.empty()) {
-    return;
+void PerfEventQueue::RebuildTournamentTree() {
+  const size_t leaf_count = leaf_queues_.size();
+  tournament_tree_.resize(2 * leaf_count);
+  for (size_t leaf_index = 0; leaf_index < leaf_count; ++leaf_index) {
+    tournament_tree_[leaf_count + leaf_index] = leaf_index;
+  }
+  for (size_t node_index = leaf_count - 1; node_index > 0; --node_index) {
+    const size_t left_winner = tournament_tree_[2 * node_index];
+    const size_t right_winner = tournament_tree_[2 * node_index + 1];
+    tournament_tree_[node_index] =
+        IsLeafBefore(left_winner, right_winner) ? left_winner : right_winner;
   }
+}
 
-  size_t current_index = heap_of_queues_of_events_ordered_in_stream_.size() - 1;
-  while (current_index > 0) {
-    size_t parent_index = (current_index - 1) / 2;
-    if (heap_of_queues_of_events_ordered_in_stream_[parent_index]->front().timestamp <=
-        heap_of_queues_of_events_ordered_in_stream_[current_index]->front().timestamp) {
-      break;
-    }
-    std::swap(heap_of_queues_of_events_ordered_in_stream_[parent_index],
-              heap_of_queues_of_events_ordered_in_stream_[current_index]);
-    current_index = parent_index;
+void PerfEventQueue::UpdateRunnerUpTimestamp() {
+  runner_up_timestamp_ = kFreeLeafTimestamp;
+  if (queues_of_events_ordered_in_stream_.empty()) {
+    return;
+  }
+  // The runner-up is the oldest among the winners of the subtrees that are siblings of the nodes on
+  // the path from the winner to the root.
+  const size_t leaf_count = leaf_queues_.size();
+  for (size_t node_index = leaf_count + GetWinnerLeafIndex(); node_index > 1; node_index /= 2) {
+    const size_t sibling_winner = tournament_tree_[node_index ^ 1];
+    runner_up_timestamp_ = std::min(runner_up_timestamp_, leaf_front_timestamps_[sibling_winner]);
   }
 }
 
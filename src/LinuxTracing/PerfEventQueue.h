@@ -8,7 +8,10 @@
 #include <absl/container/flat_hash_map.h>
 #include <absl/hash/hash.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <queue>
 #include <vector>
@@ -25,10 +28,18 @@ namespace orbit_linux_tracing {
 // Instead of keeping a single priority queue with all the events to process, on which push/pop
 // operations would be logarithmic in the number of events, we leverage the fact that some streams
 // of events are known to be already sorted; for example, most perf_event_open records coming from
-// the same perf_event_open ring buffer are already sorted. We then keep a priority queue of queues,
-// where the events in each queue come from the same sorted stream, identified by matching instances
-// of PerfEventOrderedStream. Whenever an event is removed from a queue, we need to move such queue
-// down the priority queue.
+// the same perf_event_open ring buffer are already sorted. We then merge queues of events, where
+// the events in each queue come from the same sorted stream, identified by matching instances of
+// PerfEventOrderedStream.
+//
+// The merge uses a tournament tree: each queue is assigned to a leaf, and each internal node holds
+// the leaf with the oldest front event in its subtree, so that the root holds the queue with the
+// oldest event overall. The timestamps of the front events are kept in a contiguous vector, so that
+// updating the tree after a pop doesn't need to touch the queues. In addition, we keep the
+// timestamp of the oldest front event among all other queues (the "runner-up"): as long as the new
+// front event of the winning queue is older, the tree doesn't change at all. This makes popping a
+// run of consecutive events from the same stream constant-time, which is common with many streams
+// (e.g., one per thread for uprobes).
 //
 // In order to be able to add an event to a queue, we also need to maintain the association between
 // a queue and its sorted stream, which is what the map is for. We use the PerfEventOrderedStream as
@@ -43,22 +54,44 @@ class PerfEventQueue {
   [[nodiscard]] bool HasEvent() const;
   [[nodiscard]] const PerfEvent& TopEvent();
   void PopEvent();
+  [[nodiscard]] size_t size() const { return size_; }
 
  private:
-  // Floats down the element at the top of the ordered_queues_heap_ to its correct place. Used when
-  // the key of the top element changes, or as part of the process of removing the top element.
-  void MoveDownFrontOfHeapOfQueues();
-  // Floats up an element that it is know should be further up in the heap. Used on insertion.
-  void MoveUpBackOfHeapOfQueues();
+  // Returns whether the front event of the queue at leaf lhs_leaf_index is to be processed before
+  // the one at leaf rhs_leaf_index. Free leaves come after all queues.
+  [[nodiscard]] bool IsLeafBefore(size_t lhs_leaf_index, size_t rhs_leaf_index) const;
+  [[nodiscard]] size_t GetWinnerLeafIndex() const { return tournament_tree_[1]; }
+  // Assigns a free leaf to the queue, doubling the number of leaves if needed.
+  [[nodiscard]] size_t AssignLeaf(std::queue<PerfEvent>* queue);
+  void FreeLeaf(size_t leaf_index);
+  // Recomputes the nodes on the path from the leaf to the root after the timestamp of the leaf has
+  // changed.
+  void UpdateTournamentTreeFromLeaf(size_t leaf_index);
+  void RebuildTournamentTree();
+  void UpdateRunnerUpTimestamp();
 
-  // This vector holds the heap of the queues each of which holds events coming from the same
-  // stream of events already in order by timestamp.
-  std::vector<std::queue<PerfEvent>*> heap_of_queues_of_events_ordered_in_stream_;
   // This map keeps the association between an ordered stream of events and the ordered queue of
   // events coming from that stream.
   absl::flat_hash_map<PerfEventOrderedStream, std::unique_ptr<std::queue<PerfEvent>>>
       queues_of_events_ordered_in_stream_;
 
+  // The queue assigned to each leaf of the tournament tree, or nullptr if the leaf is free, and the
+  // timestamp of its front event, or kFreeLeafTimestamp. The number of leaves is a power of two.
+  std::vector<std::queue<PerfEvent>*> leaf_queues_;
+  std::vector<uint64_t> leaf_front_timestamps_;
+  std::vector<size_t> free_leaf_indices_;
+  // The tournament tree, stored like a binary heap: node 1 is the root, the children of node i are
+  // nodes 2 * i and 2 * i + 1, and the leaves come last. Each node holds the index of the winning
+  // leaf in its subtree.
+  std::vector<size_t> tournament_tree_;
+  // The oldest front timestamp among all queues other than the winner.
+  uint64_t runner_up_timestamp_ = kFreeLeafTimestamp;
+  // The number of events in all the queues.
+  size_t size_ = 0;
+
+  static constexpr uint64_t kFreeLeafTimestamp = std::numeric_limits<uint64_t>::max();
+  static constexpr size_t kInitialLeafCount = 16;
+
   static constexpr auto kPerfEventReverseTimestampCompare =
       [](const PerfEvent& lhs, const PerfEvent& rhs) { return lhs.timestamp > rhs.timestamp; };
   // This priority queue holds all those events that cannot be assumed already sorted in a specific
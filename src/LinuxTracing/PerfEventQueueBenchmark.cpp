@@ -0,0 +1,241 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Microbenchmark comparing PerfEventQueue with the binary heap of queues it used to be based on.
+// Events are spread over many streams ordered by thread id, in runs of consecutive events from the
+// same thread, and are pushed and popped in batches like PerfEventProcessor does.
+
+#include <absl/base/attributes.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_format.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "OrbitBase/Logging.h"
+#include "PerfEvent.h"
+#include "PerfEventOrderedStream.h"
+#include "PerfEventQueue.h"
+
+namespace {
+
+using orbit_linux_tracing::ForkPerfEvent;
+using orbit_linux_tracing::PerfEvent;
+using orbit_linux_tracing::PerfEventOrderedStream;
+
+// The previous implementation of PerfEventQueue: a binary heap of queues, sifted on every pop. The
+// public methods are not inlined, like the ones of PerfEventQueue, which are in a different
+// translation unit.
+class HeapOfQueues {
+ public:
+  ABSL_ATTRIBUTE_NOINLINE void PushEvent(PerfEvent&& event) {
+    const PerfEventOrderedStream order = event.ordered_stream;
+    if (order == PerfEventOrderedStream::kNone) {
+      unordered_events_.push(std::move(event));
+    } else if (auto queue_it = queues_.find(order); queue_it != queues_.end()) {
+      const std::unique_ptr<std::queue<PerfEvent>>& queue = queue_it->second;
+
+      ORBIT_CHECK(!queue->empty());
+      // Fundamental assumption: events from the same file descriptor come already in order.
+      ORBIT_CHECK(event.timestamp >= queue->back().timestamp);
+      queue->push(std::move(event));
+    } else {
+      queue_it = queues_.emplace(order, std::make_unique<std::queue<PerfEvent>>()).first;
+      const std::unique_ptr<std::queue<PerfEvent>>& queue = queue_it->second;
+
+      queue->push(std::move(event));
+      heap_of_queues_.emplace_back(queue.get());
+      MoveUpBackOfHeapOfQueues();
+    }
+  }
+
+  [[nodiscard]] ABSL_ATTRIBUTE_NOINLINE bool HasEvent() const {
+    return !heap_of_queues_.empty() || !unordered_events_.empty();
+  }
+
+  [[nodiscard]] ABSL_ATTRIBUTE_NOINLINE const PerfEvent& TopEvent() {
+    // As we effectively have two priority queues, get the older event between the two events at the
+    // top of the two queues. In case those two events have the exact same timestamp, return the one
+    // at the top of unordered_events_ (and do the same in PopEvent).
+    if (unordered_events_.empty()) {
+      ORBIT_CHECK(!heap_of_queues_.empty());
+      ORBIT_CHECK(!heap_of_queues_.front()->empty());
+      return heap_of_queues_.front()->front();
+    }
+    if (heap_of_queues_.empty()) {
+      ORBIT_CHECK(!unordered_events_.empty());
+      return unordered_events_.top();
+    }
+    return (heap_of_queues_.front()->front().timestamp < unordered_events_.top().timestamp)
+               ? heap_of_queues_.front()->front()
+               : unordered_events_.top();
+  }
+
+  ABSL_ATTRIBUTE_NOINLINE void PopEvent() {
+    if (!unordered_events_.empty() &&
+        (heap_of_queues_.empty() ||
+         unordered_events_.top().timestamp <= heap_of_queues_.front()->front().timestamp)) {
+      // The oldest event is at the top of the priority queue holding the events that cannot be
+      // assumed sorted in any stream. Note in particular that we pop this event even if the event at
+      // the top of heap_of_queues_ has the exact same timestamp, as we need to be consistent with
+      // TopEvent.
+      unordered_events_.pop();
+      return;
+    }
+
+    std::queue<PerfEvent>* top_queue = heap_of_queues_.front();
+    const PerfEventOrderedStream top_order = top_queue->front().ordered_stream;
+    top_queue->pop();
+
+    if (top_queue->empty()) {
+      queues_.erase(top_order);
+      std::swap(heap_of_queues_.front(), heap_of_queues_.back());
+      heap_of_queues_.pop_back();
+    }
+
+    MoveDownFrontOfHeapOfQueues();
+  }
+
+ private:
+  void MoveDownFrontOfHeapOfQueues() {
+    if (heap_of_queues_.empty()) {
+      return;
+    }
+
+    size_t current_index = 0;
+    while (true) {
+      size_t new_index = current_index;
+      size_t left_index = current_index * 2 + 1;
+      size_t right_index = current_index * 2 + 2;
+      if (left_index < heap_of_queues_.size() &&
+          heap_of_queues_[left_index]->front().timestamp <
+              heap_of_queues_[new_index]->front().timestamp) {
+        new_index = left_index;
+      }
+      if (right_index < heap_of_queues_.size() &&
+          heap_of_queues_[right_index]->front().timestamp <
+              heap_of_queues_[new_index]->front().timestamp) {
+        new_index = right_index;
+      }
+      if (new_index != current_index) {
+        std::swap(heap_of_queues_[new_index], heap_of_queues_[current_index]);
+        current_index = new_index;
+      } else {
+        break;
+      }
+    }
+  }
+
+  void MoveUpBackOfHeapOfQueues() {
+    if (heap_of_queues_.empty()) {
+      return;
+    }
+
+    size_t current_index = heap_of_queues_.size() - 1;
+    while (current_index > 0) {
+      size_t parent_index = (current_index - 1) / 2;
+      if (heap_of_queues_[parent_index]->front().timestamp <=
+          heap_of_queues_[current_index]->front().timestamp) {
+        break;
+      }
+      std::swap(heap_of_queues_[parent_index], heap_of_queues_[current_index]);
+      current_index = parent_index;
+    }
+  }
+
+  std::vector<std::queue<PerfEvent>*> heap_of_queues_;
+  absl::flat_hash_map<PerfEventOrderedStream, std::unique_ptr<std::queue<PerfEvent>>> queues_;
+  std::priority_queue<PerfEvent, std::vector<PerfEvent>,
+                      std::function<bool(const PerfEvent&, const PerfEvent&)>>
+      unordered_events_{[](const PerfEvent& lhs, const PerfEvent& rhs) {
+        return lhs.timestamp > rhs.timestamp;
+      }};
+};
+
+[[nodiscard]] std::vector<std::pair<pid_t, uint64_t>> GenerateEvents(pid_t tid_count,
+                                                                     uint64_t max_run_length,
+                                                                     size_t event_count) {
+  std::mt19937 random_engine{42};
+  std::uniform_int_distribution<pid_t> tid_distribution{1, tid_count};
+  std::uniform_int_distribution<uint64_t> run_length_distribution{1, max_run_length};
+  std::vector<std::pair<pid_t, uint64_t>> events;
+  events.reserve(event_count);
+  uint64_t timestamp = 1;
+  while (events.size() < event_count) {
+    const pid_t tid = tid_distribution(random_engine);
+    const uint64_t run_length = run_length_distribution(random_engine);
+    for (uint64_t i = 0; i < run_length && events.size() < event_count; ++i) {
+      events.emplace_back(tid, timestamp++);
+    }
+  }
+  return events;
+}
+
+// Returns the average time per event, in nanoseconds, to push all events and pop them again.
+template <typename QueueT>
+[[nodiscard]] double RunBenchmark(const std::vector<std::pair<pid_t, uint64_t>>& events) {
+  constexpr size_t kBatchSize = 10'000;
+  QueueT queue;
+  uint64_t checksum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t batch_begin = 0; batch_begin < events.size(); batch_begin += kBatchSize) {
+    const size_t batch_end = std::min(batch_begin + kBatchSize, events.size());
+    for (size_t i = batch_begin; i < batch_end; ++i) {
+      queue.PushEvent(ForkPerfEvent{
+          .timestamp = events[i].second,
+          .ordered_stream = PerfEventOrderedStream::ThreadId(events[i].first),
+      });
+    }
+    // Keep half a batch in the queue, like the events that are more recent than the processing
+    // delay in PerfEventProcessor.
+    const uint64_t pop_before_timestamp = events[batch_end - 1].second - kBatchSize / 2;
+    while (queue.HasEvent() && queue.TopEvent().timestamp < pop_before_timestamp) {
+      checksum += queue.TopEvent().timestamp;
+      queue.PopEvent();
+    }
+  }
+  while (queue.HasEvent()) {
+    checksum += queue.TopEvent().timestamp;
+    queue.PopEvent();
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  uint64_t expected_checksum = 0;
+  for (const auto& [unused_tid, timestamp] : events) {
+    expected_checksum += timestamp;
+  }
+  ORBIT_CHECK(checksum == expected_checksum);
+
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         static_cast<double>(events.size());
+}
+
+}  // namespace
+
+int main() {
+  constexpr size_t kEventCount = 2'000'000;
+  absl::PrintF("%10s %10s %20s %20s\n", "streams", "max run", "heap [ns/event]",
+               "PerfEventQueue [ns/event]");
+  for (pid_t tid_count : {16, 256, 4096}) {
+    for (uint64_t max_run_length : {1, 8, 64}) {
+      const std::vector<std::pair<pid_t, uint64_t>> events =
+          GenerateEvents(tid_count, max_run_length, kEventCount);
+      const double heap_ns = RunBenchmark<HeapOfQueues>(events);
+      const double perf_event_queue_ns =
+          RunBenchmark<orbit_linux_tracing::PerfEventQueue>(events);
+      absl::PrintF("%10d %10u %20.1f %20.1f\n", tid_count, max_run_length, heap_ns,
+                   perf_event_queue_ns);
+    }
+  }
+  return 0;
+}
@@ -6,7 +6,11 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <memory>
+#include <random>
+#include <utility>
+#include <vector>
 
 #include "PerfEvent.h"
 #include "PerfEventOrderedStream.h"
@@ -80,6 +84,23 @@ TEST(PerfEventQueue, SingleFd) {
   EXPECT_FALSE(event_queue.HasEvent());
 }
 
+TEST(PerfEventQueue, SizeCountsEventsOfAllOrderTypes) {
+  PerfEventQueue event_queue;
+  EXPECT_EQ(event_queue.size(), 0);
+
+  event_queue.PushEvent(MakeTestEventOrderedInFd(11, 100));
+  event_queue.PushEvent(MakeTestEventOrderedInFd(11, 103));
+  event_queue.PushEvent(MakeTestEventOrderedInTid(22, 101));
+  event_queue.PushEvent(MakeTestEventNotOrdered(102));
+  EXPECT_EQ(event_queue.size(), 4);
+
+  for (size_t expected_size = 3; event_queue.HasEvent(); --expected_size) {
+    event_queue.PopEvent();
+    EXPECT_EQ(event_queue.size(), expected_size);
+  }
+  EXPECT_EQ(event_queue.size(), 0);
+}
+
 TEST(PerfEventQueue, FdWithDecreasingTimestamps) {
   PerfEventQueue event_queue;
 
@@ -419,4 +440,54 @@ TEST(
   EXPECT_NE(top_order, remaining_order);
 }
 
+TEST(PerfEventQueue, ManyStreamsWithRunsAndInterleavedPushesAndPops) {
+  // More streams than the initial number of leaves of the tournament tree, so that it has to grow.
+  constexpr pid_t kTidCount = 100;
+  constexpr uint64_t kEventsPerTid = 50;
+  std::mt19937 random_engine{42};
+  std::uniform_int_distribution<uint64_t> run_length_distribution{1, 5};
+
+  // Build a global sequence of timestamps where each thread gets runs of consecutive timestamps.
+  std::vector<std::pair<pid_t, uint64_t>> events;
+  std::vector<uint64_t> remaining_events_per_tid(kTidCount, kEventsPerTid);
+  uint64_t timestamp = 1000;
+  size_t remaining_event_count = kTidCount * kEventsPerTid;
+  std::uniform_int_distribution<pid_t> tid_distribution{0, kTidCount - 1};
+  while (remaining_event_count > 0) {
+    const pid_t tid = tid_distribution(random_engine);
+    const uint64_t run_length =
+        std::min(run_length_distribution(random_engine), remaining_events_per_tid[tid]);
+    for (uint64_t i = 0; i < run_length; ++i) {
+      events.emplace_back(tid, timestamp++);
+    }
+    remaining_events_per_tid[tid] -= run_length;
+    remaining_event_count -= run_length;
+  }
+
+  // Push the events in batches, popping part of the events in between, as PerfEventProcessor does.
+  PerfEventQueue event_queue;
+  std::vector<uint64_t> popped_timestamps;
+  constexpr size_t kBatchSize = 300;
+  for (size_t batch_begin = 0; batch_begin < events.size(); batch_begin += kBatchSize) {
+    const size_t batch_end = std::min(batch_begin + kBatchSize, events.size());
+    for (size_t i = batch_begin; i < batch_end; ++i) {
+      event_queue.PushEvent(MakeTestEventOrderedInTid(events[i].first, events[i].second));
+    }
+    const uint64_t pop_before_timestamp = events[batch_end - 1].second - kBatchSize / 2;
+    while (event_queue.HasEvent() && event_queue.TopEvent().timestamp < pop_before_timestamp) {
+      popped_timestamps.push_back(event_queue.TopEvent().timestamp);
+      event_queue.PopEvent();
+    }
+  }
+  while (event_queue.HasEvent()) {
+    popped_timestamps.push_back(event_queue.TopEvent().timestamp);
+    event_queue.PopEvent();
+  }
+
+  ASSERT_EQ(popped_timestamps.size(), events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(popped_timestamps[i], events[i].second);
+  }
+}
+
 }  // namespace orbit_linux_tracing
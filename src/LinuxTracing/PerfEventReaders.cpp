@@ -22,6 +22,7 @@
 #include "PerfEventOrderedStream.h"
 #include "PerfEventRecords.h"
 #include "PerfEventRingBuffer.h"
+#include "StackDataPool.h"
 
 namespace orbit_linux_tracing {
 
@@ -49,14 +50,14 @@ struct PerfRecordSample {
   uint32_t raw_size;                   /* if PERF_SAMPLE_RAW */
   std::unique_ptr<uint8_t[]> raw_data; /* if PERF_SAMPLE_RAW */
 
-  // uint64_t bnr;                        /* if PERF_SAMPLE_BRANCH_STACK */
-  // struct perf_branch_entry lbr[bnr];   /* if PERF_SAMPLE_BRANCH_STACK */
+  uint64_t bnr;                             /* if PERF_SAMPLE_BRANCH_STACK */
+  std::unique_ptr<perf_branch_entry[]> lbr; /* if PERF_SAMPLE_BRANCH_STACK */
 
   uint64_t abi;                     /* if PERF_SAMPLE_REGS_USER */
   std::unique_ptr<uint64_t[]> regs; /* if PERF_SAMPLE_REGS_USER */
 
   uint64_t stack_size;                   /* if PERF_SAMPLE_STACK_USER */
-  std::unique_ptr<uint8_t[]> stack_data; /* if PERF_SAMPLE_STACK_USER */
+  StackDataPtr stack_data; /* if PERF_SAMPLE_STACK_USER */
   uint64_t dyn_size;                     /* if PERF_SAMPLE_STACK_USER && size != 0 */
 
   // uint64_t weight;                     /* if PERF_SAMPLE_WEIGHT */
@@ -151,6 +152,17 @@ struct PerfRecordSample {
     current_offset += event.raw_size * sizeof(uint8_t);
   }
 
+  if ((flags.sample_type & PERF_SAMPLE_BRANCH_STACK) != 0u) {
+    ring_buffer->ReadRawAtOffset(&event.bnr, current_offset, sizeof(uint64_t));
+    current_offset += sizeof(uint64_t);
+    if (copy_stack_related_data) {
+      event.lbr = make_unique_for_overwrite<perf_branch_entry[]>(event.bnr);
+      ring_buffer->ReadRawAtOffset(event.lbr.get(), current_offset,
+                                   event.bnr * sizeof(perf_branch_entry));
+    }
+    current_offset += event.bnr * sizeof(perf_branch_entry);
+  }
+
   if ((flags.sample_type & PERF_SAMPLE_REGS_USER) != 0u) {
     ring_buffer->ReadRawAtOffset(&event.abi, current_offset, sizeof(uint64_t));
 
@@ -174,7 +186,7 @@ struct PerfRecordSample {
       // we can use it to not copy unnessary parts of the stack.
       ring_buffer->ReadRawAtOffset(
           &event.dyn_size, current_offset + (event.stack_size * sizeof(uint8_t)), sizeof(uint64_t));
-      event.stack_data = make_unique_for_overwrite<uint8_t[]>(event.dyn_size);
+      event.stack_data = StackDataPool::GetDefault().Allocate(event.dyn_size);
       ring_buffer->ReadRawAtOffset(event.stack_data.get(), current_offset,
                                    event.dyn_size * sizeof(uint8_t));
     }
@@ -364,6 +376,47 @@ CallchainSamplePerfEvent ConsumeCallchainSamplePerfEvent(PerfEventRingBuffer* ri
   return event;
 }
 
+LbrCallstackSamplePerfEvent ConsumeLbrCallstackSamplePerfEvent(PerfEventRingBuffer* ring_buffer,
+                                                               const perf_event_header& header) {
+  // The flags here are in sync with lbr_callstack_sample_event_open in PerfEventOpen.
+  const perf_event_attr flags{
+      .sample_type =
+          PERF_SAMPLE_BRANCH_STACK | PERF_SAMPLE_REGS_USER | kSampleTypeTidTimeStreamidCpu,
+      .sample_regs_user = kSampleRegsUserSpIp,
+  };
+
+  PerfRecordSample res = ConsumeRecordSample(ring_buffer, header, flags);
+  ring_buffer->SkipRecord(header);
+
+  RingBufferSampleRegsUserSpIp registers{};
+  if (res.regs != nullptr) {
+    // The registers are in the order of their PERF_REG_X86_* values: sp, then ip.
+    registers.sp = res.regs[0];
+    registers.ip = res.regs[1];
+  }
+
+  // Only keep the sources of the branches, i.e., the addresses of the call instructions.
+  auto branch_sources = make_unique_for_overwrite<uint64_t[]>(res.bnr);
+  for (uint64_t branch_index = 0; branch_index < res.bnr; ++branch_index) {
+    branch_sources[branch_index] = res.lbr[branch_index].from;
+  }
+
+  LbrCallstackSamplePerfEvent event{
+      .timestamp = res.time,
+      .ordered_stream = PerfEventOrderedStream::FileDescriptor(ring_buffer->GetFileDescriptor()),
+      .data =
+          {
+              .pid = static_cast<pid_t>(res.pid),
+              .tid = static_cast<pid_t>(res.tid),
+              .ip = registers.ip,
+              .branch_sources_size = res.bnr,
+              .branch_sources = std::move(branch_sources),
+          },
+  };
+
+  return event;
+}
+
 UprobesWithStackPerfEvent ConsumeUprobeWithStackPerfEvent(PerfEventRingBuffer* ring_buffer,
                                                           const perf_event_header& header) {
   // The flags here are in sync with uprobes_with_stack_and_sp_event_open in PerfEventOpen.
@@ -661,27 +714,28 @@ PerfEvent ConsumeSchedSwitchWithOrWithoutCallchainPerfEvent(PerfEventRingBuffer*
 template <typename EventType, typename StructType>
 [[nodiscard]] EventType ConsumeGpuEvent(PerfEventRingBuffer* ring_buffer,
                                         const perf_event_header& header) {
-  uint32_t tracepoint_size{};
-  ring_buffer->ReadValueAtOffset(&tracepoint_size, offsetof(RingBufferRawSampleFixed, size));
-
+  // The layout of the fixed part of the tracepoint data is known at compile time, so read it and
+  // then only the __data_loc string straight from the ring buffer, without copying the record.
   RingBufferRawSampleFixed ring_buffer_record;
   ring_buffer->ReadRawAtOffset(&ring_buffer_record, 0, sizeof(RingBufferRawSampleFixed));
-
-  std::unique_ptr<uint8_t[]> tracepoint_data =
-      make_unique_for_overwrite<uint8_t[]>(tracepoint_size);
-  ring_buffer->ReadRawAtOffset(
-      tracepoint_data.get(),
-      offsetof(RingBufferRawSampleFixed, size) + sizeof(RingBufferRawSampleFixed::size),
-      tracepoint_size);
-  const StructType& typed_tracepoint_data =
-      *reinterpret_cast<const StructType*>(tracepoint_data.get());
-  const auto data_loc_size = static_cast<int16_t>(typed_tracepoint_data.timeline >> 16);
-  const auto data_loc_offset = static_cast<int16_t>(typed_tracepoint_data.timeline & 0x00ff);
-  std::vector<char> data_loc_data(data_loc_size);
-  std::memcpy(data_loc_data.data(),
-              reinterpret_cast<const char*>(tracepoint_data.get()) + data_loc_offset,
-              data_loc_size);
-  data_loc_data[data_loc_data.size() - 1] = 0;
+  const uint32_t tracepoint_size = ring_buffer_record.size;
+  ORBIT_CHECK(tracepoint_size >= sizeof(StructType));
+
+  constexpr uint64_t kTracepointDataOffset = sizeof(RingBufferRawSampleFixed);
+  StructType typed_tracepoint_data;
+  ring_buffer->ReadValueAtOffset(&typed_tracepoint_data, kTracepointDataOffset);
+
+  // A __data_loc field holds the size of the data in the upper 16 bits and its offset from the
+  // start of the tracepoint data in the lower 16 bits. The data is a null-terminated string.
+  const auto data_loc_size = static_cast<uint16_t>(typed_tracepoint_data.timeline >> 16);
+  const auto data_loc_offset = static_cast<uint16_t>(typed_tracepoint_data.timeline & 0xffff);
+  std::string timeline_string;
+  if (data_loc_size > 0 && data_loc_offset + data_loc_size <= tracepoint_size) {
+    timeline_string.resize(data_loc_size);
+    ring_buffer->ReadRawAtOffset(timeline_string.data(), kTracepointDataOffset + data_loc_offset,
+                                 data_loc_size);
+    timeline_string.resize(strnlen(timeline_string.data(), data_loc_size - 1));
+  }
 
   // dma_fence_signaled events can be out of order of timestamp even on the same ring buffer, hence
   // why PerfEventOrderedStream::kNone. To be safe, do the same for the other GPU events.
@@ -694,7 +748,7 @@ template <typename EventType, typename StructType>
               .tid = static_cast<pid_t>(ring_buffer_record.sample_id.tid),
               .context = typed_tracepoint_data.context,
               .seqno = typed_tracepoint_data.seqno,
-              .timeline_string = std::string(data_loc_data.data()),
+              .timeline_string = std::move(timeline_string),
           },
   };
 
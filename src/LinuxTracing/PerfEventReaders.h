@@ -43,6 +43,9 @@ void ReadPerfSampleIdAll(PerfEventRingBuffer* ring_buffer, const perf_event_head
 [[nodiscard]] CallchainSamplePerfEvent ConsumeCallchainSamplePerfEvent(
     PerfEventRingBuffer* ring_buffer, const perf_event_header& header);
 
+[[nodiscard]] LbrCallstackSamplePerfEvent ConsumeLbrCallstackSamplePerfEvent(
+    PerfEventRingBuffer* ring_buffer, const perf_event_header& header);
+
 [[nodiscard]] GenericTracepointPerfEvent ConsumeGenericTracepointPerfEvent(
     PerfEventRingBuffer* ring_buffer, const perf_event_header& header);
 
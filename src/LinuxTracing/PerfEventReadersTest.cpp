@@ -0,0 +1,101 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <linux/perf_event.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "KernelTracepoints.h"
+#include "PerfEvent.h"
+#include "PerfEventOrderedStream.h"
+#include "PerfEventReaders.h"
+#include "PerfEventRecords.h"
+#include "PerfEventRingBuffer.h"
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+template <typename T>
+void AppendValue(std::vector<char>* record, const T& value) {
+  const size_t offset = record->size();
+  record->resize(offset + sizeof(T));
+  std::memcpy(record->data() + offset, &value, sizeof(T));
+}
+
+}  // namespace
+
+TEST(PerfEventReaders, ConsumeLbrCallstackSamplePerfEvent) {
+  // A record in the format requested by lbr_callstack_sample_event_open.
+  std::vector<char> record;
+  AppendValue(&record, perf_event_header{.type = PERF_RECORD_SAMPLE});
+  AppendValue(&record, RingBufferSampleIdTidTimeStreamidCpu{
+                           .pid = 10, .tid = 11, .time = 12345, .stream_id = 42, .cpu = 3});
+  AppendValue(&record, uint64_t{2});
+  AppendValue(&record, perf_branch_entry{.from = 0x1100, .to = 0x2000});
+  AppendValue(&record, perf_branch_entry{.from = 0x1200, .to = 0x1000});
+  AppendValue(&record, RingBufferSampleRegsUserSpIp{
+                           .abi = PERF_SAMPLE_REGS_ABI_64, .sp = 0x7FF0, .ip = 0x2010});
+  perf_event_header header{.type = PERF_RECORD_SAMPLE,
+                           .size = static_cast<uint16_t>(record.size())};
+  std::memcpy(record.data(), &header, sizeof(header));
+
+  PerfEventRingBuffer ring_buffer =
+      PerfEventRingBuffer::CreateFromRecords(record, 7, "sampling_3", 3);
+  LbrCallstackSamplePerfEvent event = ConsumeLbrCallstackSamplePerfEvent(&ring_buffer, header);
+
+  EXPECT_EQ(event.timestamp, 12345);
+  EXPECT_EQ(event.ordered_stream, PerfEventOrderedStream::FileDescriptor(7));
+  EXPECT_EQ(event.data.pid, 10);
+  EXPECT_EQ(event.data.tid, 11);
+  EXPECT_EQ(event.data.ip, 0x2010);
+  EXPECT_THAT(std::vector<uint64_t>(event.data.GetBranchSources(),
+                                    event.data.GetBranchSources() +
+                                        event.data.GetBranchSourcesSize()),
+              testing::ElementsAre(0x1100, 0x1200));
+  EXPECT_FALSE(ring_buffer.HasNewData());
+}
+
+TEST(PerfEventReaders, ConsumeDmaFenceSignaledPerfEvent) {
+  constexpr char kTimeline[] = "gfx";
+  const DmaFenceSignaledTracepointData tracepoint_data{
+      .timeline = static_cast<int32_t>(sizeof(kTimeline) << 16 |
+                                       sizeof(DmaFenceSignaledTracepointData)),
+      .context = 21,
+      .seqno = 22,
+  };
+  std::vector<char> record;
+  AppendValue(&record, perf_event_header{.type = PERF_RECORD_SAMPLE});
+  AppendValue(&record, RingBufferSampleIdTidTimeStreamidCpu{
+                           .pid = 10, .tid = 11, .time = 12345, .stream_id = 42, .cpu = 3});
+  AppendValue(&record, static_cast<uint32_t>(sizeof(tracepoint_data) + sizeof(kTimeline)));
+  AppendValue(&record, tracepoint_data);
+  AppendValue(&record, kTimeline);
+  // The kernel pads samples to a multiple of 8 bytes.
+  record.resize((record.size() + 7) / 8 * 8);
+  perf_event_header header{.type = PERF_RECORD_SAMPLE,
+                           .size = static_cast<uint16_t>(record.size())};
+  std::memcpy(record.data(), &header, sizeof(header));
+
+  PerfEventRingBuffer ring_buffer =
+      PerfEventRingBuffer::CreateFromRecords(record, 7, "gpu_tracing_3", 3);
+  DmaFenceSignaledPerfEvent event = ConsumeDmaFenceSignaledPerfEvent(&ring_buffer, header);
+
+  EXPECT_EQ(event.timestamp, 12345);
+  EXPECT_EQ(event.ordered_stream, PerfEventOrderedStream::kNone);
+  EXPECT_EQ(event.data.pid, 10);
+  EXPECT_EQ(event.data.tid, 11);
+  EXPECT_EQ(event.data.context, 21);
+  EXPECT_EQ(event.data.seqno, 22);
+  EXPECT_EQ(event.data.timeline_string, std::string{kTimeline});
+  EXPECT_FALSE(ring_buffer.HasNewData());
+}
+
+}  // namespace orbit_linux_tracing
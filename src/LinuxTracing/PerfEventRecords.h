@@ -136,6 +136,23 @@ struct __attribute__((__packed__)) RingBufferAxSample {
   RingBufferSampleRegsUserAx regs;
 };
 
+// This struct must be in sync with `kPerformanceCounterCount` and with the order in which
+// performance_counter_group_event_open in PerfEventOpen.cpp adds the counters to the group.
+struct __attribute__((__packed__)) RingBufferReadFormatPerformanceCounterGroup {
+  uint64_t nr; /* always kPerformanceCounterCount + 1 */
+  uint64_t leader_value;
+  uint64_t cycles;
+  uint64_t instructions;
+  uint64_t cache_misses;
+  uint64_t branch_misses;
+};
+
+struct __attribute__((__packed__)) RingBufferPerformanceCounterSample {
+  perf_event_header header;
+  RingBufferSampleIdTidTimeStreamidCpu sample_id;
+  RingBufferReadFormatPerformanceCounterGroup read; /* PERF_SAMPLE_READ with PERF_FORMAT_GROUP */
+};
+
 template <typename TracepointT>
 struct __attribute__((__packed__)) RingBufferRawSample {
   perf_event_header header;
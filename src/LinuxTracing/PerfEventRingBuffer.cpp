@@ -9,7 +9,9 @@
 #include <string.h>
 #include <sys/mman.h>
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "LinuxTracingUtils.h"
 #include "OrbitBase/Logging.h"
@@ -36,13 +38,16 @@ static inline void WriteRingBufferTail(perf_event_mmap_page* base, uint64_t tail
   smp_store_release(&base->data_tail, tail);
 }
 
-PerfEventRingBuffer::PerfEventRingBuffer(int perf_event_fd, uint64_t size_kb, std::string name) {
+PerfEventRingBuffer::PerfEventRingBuffer(int perf_event_fd, uint64_t size_kb, std::string name,
+                                         int32_t cpu, bool overwrite) {
   if (perf_event_fd < 0) {
     return;
   }
 
   file_descriptor_ = perf_event_fd;
   name_ = std::move(name);
+  cpu_ = cpu;
+  overwrite_ = overwrite;
 
   // The size of a perf_event_open ring buffer is required to be a power of two
   // memory pages (from perf_event_open's manpage: "The mmap size should be
@@ -55,7 +60,7 @@ PerfEventRingBuffer::PerfEventRingBuffer(int perf_event_fd, uint64_t size_kb, st
   ring_buffer_size_log2_ = __builtin_ffsl(ring_buffer_size_) - 1;
   mmap_length_ = GetPageSize() + ring_buffer_size_;
 
-  void* mmap_address = perf_event_open_mmap_ring_buffer(perf_event_fd, mmap_length_);
+  void* mmap_address = perf_event_open_mmap_ring_buffer(perf_event_fd, mmap_length_, overwrite_);
   if (mmap_address == nullptr) {
     return;
   }
@@ -68,6 +73,20 @@ PerfEventRingBuffer::PerfEventRingBuffer(int perf_event_fd, uint64_t size_kb, st
   ORBIT_CHECK(metadata_page_->data_offset == GetPageSize());
 }
 
+PerfEventRingBuffer PerfEventRingBuffer::CreateFromRecords(std::vector<char> records,
+                                                           int perf_event_fd, std::string name,
+                                                           int32_t cpu) {
+  PerfEventRingBuffer ring_buffer;
+  ring_buffer.file_descriptor_ = perf_event_fd;
+  ring_buffer.name_ = std::move(name);
+  ring_buffer.cpu_ = cpu;
+  ring_buffer.overwrite_ = true;
+  ring_buffer.from_records_ = true;
+  ring_buffer.ring_buffer_size_ = records.size();
+  ring_buffer.snapshot_ = std::move(records);
+  return ring_buffer;
+}
+
 PerfEventRingBuffer::PerfEventRingBuffer(PerfEventRingBuffer&& o) {
   std::swap(mmap_length_, o.mmap_length_);
   std::swap(metadata_page_, o.metadata_page_);
@@ -76,6 +95,11 @@ PerfEventRingBuffer::PerfEventRingBuffer(PerfEventRingBuffer&& o) {
   std::swap(ring_buffer_size_log2_, o.ring_buffer_size_log2_);
   std::swap(file_descriptor_, o.file_descriptor_);
   std::swap(name_, o.name_);
+  std::swap(cpu_, o.cpu_);
+  std::swap(overwrite_, o.overwrite_);
+  std::swap(from_records_, o.from_records_);
+  std::swap(snapshot_, o.snapshot_);
+  std::swap(snapshot_tail_, o.snapshot_tail_);
 }
 
 PerfEventRingBuffer& PerfEventRingBuffer::operator=(PerfEventRingBuffer&& o) {
@@ -87,6 +111,11 @@ PerfEventRingBuffer& PerfEventRingBuffer::operator=(PerfEventRingBuffer&& o) {
     std::swap(ring_buffer_size_log2_, o.ring_buffer_size_log2_);
     std::swap(file_descriptor_, o.file_descriptor_);
     std::swap(name_, o.name_);
+    std::swap(cpu_, o.cpu_);
+    std::swap(overwrite_, o.overwrite_);
+    std::swap(from_records_, o.from_records_);
+    std::swap(snapshot_, o.snapshot_);
+    std::swap(snapshot_tail_, o.snapshot_tail_);
   }
   return *this;
 }
@@ -100,21 +129,84 @@ PerfEventRingBuffer::~PerfEventRingBuffer() {
   }
 }
 
+uint64_t PerfEventRingBuffer::TakeSnapshot() {
+  ORBIT_CHECK(IsOpen());
+  ORBIT_CHECK(overwrite_);
+  ORBIT_CHECK(!from_records_);
+  snapshot_.clear();
+  snapshot_tail_ = 0;
+
+  // With write_backward, data_head starts at zero and decreases: the most recent record starts at
+  // data_head, and the records that follow it are increasingly older. So, until the ring buffer
+  // wraps around for the first time, the records occupy the -data_head bytes after data_head.
+  const uint64_t head = ReadRingBufferHead(metadata_page_);
+  const uint64_t written_size = std::min<uint64_t>(-head, ring_buffer_size_);
+  // Reduce data_head modulo the size of the ring buffer, so that adding offsets doesn't overflow.
+  const uint64_t head_index = head & (ring_buffer_size_ - 1);
+
+  // Offsets from data_head and sizes of the records, newest first.
+  std::vector<std::pair<uint64_t, uint16_t>> records;
+  uint64_t offset = 0;
+  while (offset + sizeof(perf_event_header) <= written_size) {
+    perf_event_header header;
+    CopyFromRingBuffer(&header, head_index + offset, sizeof(perf_event_header));
+    // The oldest record might have been partially overwritten by the newest ones.
+    if (header.size == 0 || offset + header.size > written_size) {
+      break;
+    }
+    records.emplace_back(offset, header.size);
+    offset += header.size;
+  }
+
+  snapshot_.resize(offset);
+  uint64_t snapshot_offset = 0;
+  for (auto record_it = records.rbegin(); record_it != records.rend(); ++record_it) {
+    const auto [record_offset, record_size] = *record_it;
+    CopyFromRingBuffer(snapshot_.data() + snapshot_offset, head_index + record_offset,
+                       record_size);
+    snapshot_offset += record_size;
+  }
+  return snapshot_.size();
+}
+
 bool PerfEventRingBuffer::HasNewData() {
   ORBIT_DCHECK(IsOpen());
+  if (overwrite_) {
+    return snapshot_tail_ < snapshot_.size();
+  }
   uint64_t head = ReadRingBufferHead(metadata_page_);
   ORBIT_DCHECK((metadata_page_->data_tail == head) ||
                (head >= metadata_page_->data_tail + sizeof(perf_event_header)));
   return head > metadata_page_->data_tail;
 }
 
+uint64_t PerfEventRingBuffer::GetUnreadSize() {
+  ORBIT_DCHECK(IsOpen());
+  if (overwrite_) {
+    return snapshot_.size() - snapshot_tail_;
+  }
+  return ReadRingBufferHead(metadata_page_) - metadata_page_->data_tail;
+}
+
 void PerfEventRingBuffer::ReadHeader(perf_event_header* header) {
   ReadAtTail(header, sizeof(perf_event_header));
   ORBIT_DCHECK(header->type != 0);
-  ORBIT_DCHECK(metadata_page_->data_tail + header->size <= ReadRingBufferHead(metadata_page_));
+  ORBIT_DCHECK(overwrite_ ? snapshot_tail_ + header->size <= snapshot_.size()
+                          : metadata_page_->data_tail + header->size <=
+                                ReadRingBufferHead(metadata_page_));
 }
 
 void PerfEventRingBuffer::SkipRecord(const perf_event_header& header) {
+  if (overwrite_) {
+    snapshot_tail_ += header.size;
+    if (snapshot_tail_ >= snapshot_.size()) {
+      // Release the memory of the snapshot as soon as it has been read entirely.
+      snapshot_ = {};
+      snapshot_tail_ = 0;
+    }
+    return;
+  }
+
   // Write back how far we read from the buffer.
   uint64_t new_tail = metadata_page_->data_tail + header.size;
   WriteRingBufferTail(metadata_page_, new_tail);
@@ -129,6 +221,16 @@ void PerfEventRingBuffer::ReadAtOffsetFromTail(void* dest, uint64_t offset_from_
                                                uint64_t count) {
   ORBIT_DCHECK(IsOpen());
 
+  if (overwrite_) {
+    if (snapshot_tail_ + offset_from_tail + count > snapshot_.size()) {
+      ORBIT_ERROR("Reading more data than it is available from the snapshot of ring buffer '%s'",
+                  name_.c_str());
+      return;
+    }
+    memcpy(dest, snapshot_.data() + snapshot_tail_ + offset_from_tail, count);
+    return;
+  }
+
   uint64_t head = ReadRingBufferHead(metadata_page_);
   if (offset_from_tail + count > head - metadata_page_->data_tail) {
     ORBIT_ERROR("Reading more data than it is available from ring buffer '%s'", name_.c_str());
@@ -141,7 +243,10 @@ void PerfEventRingBuffer::ReadAtOffsetFromTail(void* dest, uint64_t offset_from_
     ORBIT_ERROR("Too slow reading from ring buffer '%s'", name_.c_str());
   }
 
-  const uint64_t index = metadata_page_->data_tail + offset_from_tail;
+  CopyFromRingBuffer(dest, metadata_page_->data_tail + offset_from_tail, count);
+}
+
+void PerfEventRingBuffer::CopyFromRingBuffer(void* dest, uint64_t index, uint64_t count) const {
   const uint32_t exponent = ring_buffer_size_log2_;
 
   // As ring_buffer_size_ is a power of two, optimize index % ring_buffer_size_:
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include "OrbitBase/Logging.h"
 
@@ -16,7 +17,11 @@ namespace orbit_linux_tracing {
 
 class PerfEventRingBuffer {
  public:
-  explicit PerfEventRingBuffer(int perf_event_fd, uint64_t size_kb, std::string name);
+  // With `overwrite`, the file descriptor must have been opened with
+  // RingBufferOptions::write_backward. The kernel then keeps overwriting the oldest records, and
+  // the records can only be read after calling TakeSnapshot.
+  explicit PerfEventRingBuffer(int perf_event_fd, uint64_t size_kb, std::string name, int32_t cpu,
+                               bool overwrite = false);
   ~PerfEventRingBuffer();
 
   PerfEventRingBuffer(PerfEventRingBuffer&&);
@@ -25,11 +30,30 @@ class PerfEventRingBuffer {
   PerfEventRingBuffer(const PerfEventRingBuffer&) = delete;
   PerfEventRingBuffer& operator=(const PerfEventRingBuffer&) = delete;
 
-  [[nodiscard]] bool IsOpen() const { return ring_buffer_ != nullptr; }
+  // Creates a ring buffer that is not backed by a perf_event_open file descriptor, from which
+  // `records` are read as if they had been written by the kernel. This is used to replay the
+  // records of a PerfRecordDump. `perf_event_fd` is only returned by GetFileDescriptor.
+  [[nodiscard]] static PerfEventRingBuffer CreateFromRecords(std::vector<char> records,
+                                                             int perf_event_fd, std::string name,
+                                                             int32_t cpu);
+
+  [[nodiscard]] bool IsOpen() const { return ring_buffer_ != nullptr || from_records_; }
   [[nodiscard]] int GetFileDescriptor() const { return file_descriptor_; }
   [[nodiscard]] const std::string& GetName() const { return name_; }
+  // The CPU of all the perf_event_open file descriptors that output to this ring buffer.
+  [[nodiscard]] int32_t GetCpu() const { return cpu_; }
+  [[nodiscard]] bool IsOverwrite() const { return overwrite_; }
+
+  // Only for ring buffers in overwrite mode: copies the records currently in the ring buffer, in
+  // the order in which they were written, so that they can be read with the methods below. The
+  // kernel must not be writing to the buffer in the meantime, i.e., the events outputting to it
+  // need to have been disabled. Returns the number of bytes of records in the snapshot.
+  uint64_t TakeSnapshot();
 
   bool HasNewData();
+  // Number of bytes that have been written by the kernel but not consumed yet.
+  [[nodiscard]] uint64_t GetUnreadSize();
+  [[nodiscard]] uint64_t GetSize() const { return ring_buffer_size_; }
   void ReadHeader(perf_event_header* header);
   void SkipRecord(const perf_event_header& header);
 
@@ -49,6 +73,8 @@ class PerfEventRingBuffer {
   }
 
  private:
+  PerfEventRingBuffer() = default;
+
   uint64_t mmap_length_ = 0;
   perf_event_mmap_page* metadata_page_ = nullptr;
   char* ring_buffer_ = nullptr;
@@ -58,11 +84,22 @@ class PerfEventRingBuffer {
   uint32_t ring_buffer_size_log2_ = 0;
   int file_descriptor_ = -1;
   std::string name_;
+  int32_t cpu_ = -1;
+  bool overwrite_ = false;
+  // Set by CreateFromRecords. Such ring buffers are also in overwrite mode, so that all reads are
+  // served from snapshot_.
+  bool from_records_ = false;
+  // In overwrite mode, the records copied by TakeSnapshot, oldest first, and how far they have been
+  // read. All reads are served from here instead of from the ring buffer.
+  std::vector<char> snapshot_;
+  uint64_t snapshot_tail_ = 0;
 
   // ConsumeRawRecord reads header.size bytes into record buffer and then skips the record.
   void ConsumeRawRecord(const perf_event_header& header, void* record);
   void ReadAtTail(void* dest, uint64_t count) { return ReadAtOffsetFromTail(dest, 0, count); }
   void ReadAtOffsetFromTail(void* dest, uint64_t offset_from_tail, uint64_t count);
+  // Copies `count` bytes starting at `index`, which is taken modulo the size of the ring buffer.
+  void CopyFromRingBuffer(void* dest, uint64_t index, uint64_t count) const;
 };
 
 }  // namespace orbit_linux_tracing
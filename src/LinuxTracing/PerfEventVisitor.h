@@ -19,6 +19,10 @@ class PerfEventVisitor {
   }
   virtual void Visit(uint64_t /*event_timestamp*/,
                      const CallchainSamplePerfEventData& /*event_data*/) {}
+  virtual void Visit(uint64_t /*event_timestamp*/,
+                     const LbrCallstackSamplePerfEventData& /*event_data*/) {}
+  virtual void Visit(uint64_t /*event_timestamp*/,
+                     const PerformanceCounterSamplePerfEventData& /*event_data*/) {}
   virtual void Visit(uint64_t /*event_timestamp*/, const UprobesPerfEventData& /*event_data*/) {}
   virtual void Visit(uint64_t /*event_timestamp*/,
                      const UprobesWithStackPerfEventData& /*event_data*/) {}
@@ -0,0 +1,263 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "PerfRecordDump.h"
+
+#include <absl/strings/str_format.h>
+#include <string.h>
+
+#include <cstring>
+#include <string_view>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ReadFileToString.h"
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+template <typename T>
+void AppendValue(std::string* payload, const T& value) {
+  payload->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads PerfRecordDump payloads, making sure not to read past their end.
+class PayloadReader {
+ public:
+  explicit PayloadReader(std::string_view payload) : payload_{payload} {}
+
+  template <typename T>
+  [[nodiscard]] ErrorMessageOr<T> ReadValue() {
+    if (payload_.size() < sizeof(T)) {
+      return ErrorMessage{"Unexpected end of perf record dump chunk"};
+    }
+    T value;
+    std::memcpy(&value, payload_.data(), sizeof(T));
+    payload_.remove_prefix(sizeof(T));
+    return value;
+  }
+
+  [[nodiscard]] std::string_view ReadRemaining() {
+    std::string_view remaining = payload_;
+    payload_ = {};
+    return remaining;
+  }
+
+  [[nodiscard]] bool IsEmpty() const { return payload_.empty(); }
+
+ private:
+  std::string_view payload_;
+};
+
+ErrorMessageOr<void> ParseChunk(PerfRecordDumpChunkType type, std::string_view payload,
+                                PerfRecordDump* dump) {
+  PayloadReader reader{payload};
+  switch (type) {
+    case PerfRecordDumpChunkType::kCaptureOptions:
+      if (!dump->capture_options.ParseFromArray(payload.data(), static_cast<int>(payload.size()))) {
+        return ErrorMessage{"Unable to parse the CaptureOptions of the perf record dump"};
+      }
+      return outcome::success();
+    case PerfRecordDumpChunkType::kTargetMaps:
+      dump->target_maps = std::string{payload};
+      return outcome::success();
+    case PerfRecordDumpChunkType::kEffectiveCaptureStartTimestampNs: {
+      OUTCOME_TRY(uint64_t timestamp_ns, reader.ReadValue<uint64_t>());
+      dump->effective_capture_start_timestamp_ns = timestamp_ns;
+      return outcome::success();
+    }
+    case PerfRecordDumpChunkType::kStreamIdSet: {
+      std::vector<uint64_t>& stream_ids = dump->stream_id_sets.emplace_back();
+      while (!reader.IsEmpty()) {
+        OUTCOME_TRY(uint64_t stream_id, reader.ReadValue<uint64_t>());
+        stream_ids.push_back(stream_id);
+      }
+      return outcome::success();
+    }
+    case PerfRecordDumpChunkType::kStreamIdsToFunctionId:
+      while (!reader.IsEmpty()) {
+        OUTCOME_TRY(uint64_t stream_id, reader.ReadValue<uint64_t>());
+        OUTCOME_TRY(uint64_t function_id, reader.ReadValue<uint64_t>());
+        dump->stream_ids_to_function_id.emplace_back(stream_id, function_id);
+      }
+      return outcome::success();
+    case PerfRecordDumpChunkType::kStreamIdToTracepointInfo: {
+      OUTCOME_TRY(uint64_t stream_id, reader.ReadValue<uint64_t>());
+      std::string_view serialized_tracepoint_info = reader.ReadRemaining();
+      orbit_grpc_protos::TracepointInfo tracepoint_info;
+      if (!tracepoint_info.ParseFromArray(serialized_tracepoint_info.data(),
+                                          static_cast<int>(serialized_tracepoint_info.size()))) {
+        return ErrorMessage{"Unable to parse a TracepointInfo of the perf record dump"};
+      }
+      dump->stream_ids_to_tracepoint_info.emplace_back(stream_id, std::move(tracepoint_info));
+      return outcome::success();
+    }
+    case PerfRecordDumpChunkType::kRingBuffer: {
+      OUTCOME_TRY(int32_t file_descriptor, reader.ReadValue<int32_t>());
+      OUTCOME_TRY(int32_t cpu, reader.ReadValue<int32_t>());
+      OUTCOME_TRY(uint32_t type, reader.ReadValue<uint32_t>());
+      if (type >= kRingBufferTypeCount) {
+        return ErrorMessage{
+            absl::StrFormat("Invalid ring buffer type %u in perf record dump", type)};
+      }
+      PerfRecordDump::RingBuffer& ring_buffer = dump->ring_buffers.emplace_back();
+      ring_buffer.file_descriptor = file_descriptor;
+      ring_buffer.cpu = cpu;
+      ring_buffer.type = static_cast<RingBufferType>(type);
+      ring_buffer.name = std::string{reader.ReadRemaining()};
+      return outcome::success();
+    }
+    case PerfRecordDumpChunkType::kRecord: {
+      OUTCOME_TRY(uint32_t ring_buffer_index, reader.ReadValue<uint32_t>());
+      if (ring_buffer_index >= dump->ring_buffers.size()) {
+        return ErrorMessage{
+            absl::StrFormat("Record of unknown ring buffer %u in perf record dump",
+                            ring_buffer_index)};
+      }
+      std::string_view record = reader.ReadRemaining();
+      perf_event_header header;
+      if (record.size() < sizeof(header)) {
+        return ErrorMessage{"Truncated record in perf record dump"};
+      }
+      std::memcpy(&header, record.data(), sizeof(header));
+      if (header.size != record.size()) {
+        return ErrorMessage{"Record of inconsistent size in perf record dump"};
+      }
+      PerfRecordDump::RingBuffer& ring_buffer = dump->ring_buffers[ring_buffer_index];
+      ring_buffer.records.insert(ring_buffer.records.end(), record.begin(), record.end());
+      ++ring_buffer.record_count;
+      return outcome::success();
+    }
+  }
+  return ErrorMessage{
+      absl::StrFormat("Unknown chunk type %u in perf record dump", static_cast<uint32_t>(type))};
+}
+
+}  // namespace
+
+ErrorMessageOr<std::unique_ptr<PerfRecordDumpWriter>> PerfRecordDumpWriter::Create(
+    const std::filesystem::path& file_path) {
+  OUTCOME_TRY(orbit_base::UniqueFd fd, orbit_base::OpenFileForWriting(file_path));
+  std::string file_header{kPerfRecordDumpMagic, sizeof(kPerfRecordDumpMagic) - 1};
+  AppendValue(&file_header, kPerfRecordDumpVersion);
+  OUTCOME_TRY(orbit_base::WriteFully(fd, file_header));
+  return std::unique_ptr<PerfRecordDumpWriter>{new PerfRecordDumpWriter{std::move(fd)}};
+}
+
+PerfRecordDumpWriter::~PerfRecordDumpWriter() {
+  absl::MutexLock lock{&mutex_};
+  FlushIfNeeded(0);
+}
+
+void PerfRecordDumpWriter::WriteMetadata(const PerfRecordDump& metadata) {
+  absl::MutexLock lock{&mutex_};
+  AppendChunk(PerfRecordDumpChunkType::kCaptureOptions,
+              metadata.capture_options.SerializeAsString());
+  AppendChunk(PerfRecordDumpChunkType::kTargetMaps, metadata.target_maps);
+  std::string payload;
+  AppendValue(&payload, metadata.effective_capture_start_timestamp_ns);
+  AppendChunk(PerfRecordDumpChunkType::kEffectiveCaptureStartTimestampNs, payload);
+
+  for (const std::vector<uint64_t>& stream_ids : metadata.stream_id_sets) {
+    payload.clear();
+    for (uint64_t stream_id : stream_ids) {
+      AppendValue(&payload, stream_id);
+    }
+    AppendChunk(PerfRecordDumpChunkType::kStreamIdSet, payload);
+  }
+
+  payload.clear();
+  for (const auto& [stream_id, function_id] : metadata.stream_ids_to_function_id) {
+    AppendValue(&payload, stream_id);
+    AppendValue(&payload, function_id);
+  }
+  AppendChunk(PerfRecordDumpChunkType::kStreamIdsToFunctionId, payload);
+
+  for (const auto& [stream_id, tracepoint_info] : metadata.stream_ids_to_tracepoint_info) {
+    payload.clear();
+    AppendValue(&payload, stream_id);
+    payload.append(tracepoint_info.SerializeAsString());
+    AppendChunk(PerfRecordDumpChunkType::kStreamIdToTracepointInfo, payload);
+  }
+
+  for (const PerfRecordDump::RingBuffer& ring_buffer : metadata.ring_buffers) {
+    payload.clear();
+    AppendValue(&payload, static_cast<int32_t>(ring_buffer.file_descriptor));
+    AppendValue(&payload, ring_buffer.cpu);
+    AppendValue(&payload, static_cast<uint32_t>(ring_buffer.type));
+    payload.append(ring_buffer.name);
+    AppendChunk(PerfRecordDumpChunkType::kRingBuffer, payload);
+  }
+}
+
+void PerfRecordDumpWriter::WriteRecord(uint32_t ring_buffer_index, const perf_event_header& header,
+                                       PerfEventRingBuffer* ring_buffer) {
+  absl::MutexLock lock{&mutex_};
+  const PerfRecordDumpChunkHeader chunk_header{
+      .type = PerfRecordDumpChunkType::kRecord,
+      .size = static_cast<uint32_t>(sizeof(ring_buffer_index) + header.size),
+  };
+  AppendValue(&buffer_, chunk_header);
+  AppendValue(&buffer_, ring_buffer_index);
+  const size_t record_offset = buffer_.size();
+  buffer_.resize(record_offset + header.size);
+  ring_buffer->ReadRawAtOffset(buffer_.data() + record_offset, 0, header.size);
+  FlushIfNeeded(kFlushThresholdBytes);
+}
+
+void PerfRecordDumpWriter::AppendChunk(PerfRecordDumpChunkType type, std::string_view payload) {
+  const PerfRecordDumpChunkHeader chunk_header{.type = type,
+                                               .size = static_cast<uint32_t>(payload.size())};
+  AppendValue(&buffer_, chunk_header);
+  buffer_.append(payload);
+  FlushIfNeeded(kFlushThresholdBytes);
+}
+
+void PerfRecordDumpWriter::FlushIfNeeded(size_t min_size) {
+  if (buffer_.size() < min_size || buffer_.empty()) return;
+  // Only report the first error, as all the following writes are then likely to fail too.
+  if (!write_failed_) {
+    if (ErrorMessageOr<void> result = orbit_base::WriteFully(fd_, buffer_); result.has_error()) {
+      ORBIT_ERROR("Writing perf record dump: %s", result.error().message());
+      write_failed_ = true;
+    }
+  }
+  buffer_.clear();
+}
+
+ErrorMessageOr<PerfRecordDump> ReadPerfRecordDump(const std::filesystem::path& file_path) {
+  OUTCOME_TRY(std::string content, orbit_base::ReadFileToString(file_path));
+  std::string_view remaining{content};
+
+  constexpr size_t kMagicSize = sizeof(kPerfRecordDumpMagic) - 1;
+  if (remaining.size() < kMagicSize + sizeof(uint32_t) ||
+      remaining.substr(0, kMagicSize) != std::string_view{kPerfRecordDumpMagic, kMagicSize}) {
+    return ErrorMessage{absl::StrFormat("\"%s\" is not a perf record dump", file_path.string())};
+  }
+  remaining.remove_prefix(kMagicSize);
+  uint32_t version = 0;
+  std::memcpy(&version, remaining.data(), sizeof(version));
+  remaining.remove_prefix(sizeof(version));
+  if (version != kPerfRecordDumpVersion) {
+    return ErrorMessage{absl::StrFormat("Unsupported perf record dump version %u", version)};
+  }
+
+  PerfRecordDump dump;
+  while (!remaining.empty()) {
+    PerfRecordDumpChunkHeader chunk_header;
+    if (remaining.size() < sizeof(chunk_header)) {
+      return ErrorMessage{"Truncated chunk header in perf record dump"};
+    }
+    std::memcpy(&chunk_header, remaining.data(), sizeof(chunk_header));
+    remaining.remove_prefix(sizeof(chunk_header));
+    if (remaining.size() < chunk_header.size) {
+      return ErrorMessage{"Truncated chunk in perf record dump"};
+    }
+    OUTCOME_TRY(ParseChunk(chunk_header.type, remaining.substr(0, chunk_header.size), &dump));
+    remaining.remove_prefix(chunk_header.size);
+  }
+  return dump;
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,130 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_PERF_RECORD_DUMP_H_
+#define LINUX_TRACING_PERF_RECORD_DUMP_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+#include "GrpcProtos/tracepoint.pb.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/Result.h"
+#include "PerfEventRingBuffer.h"
+#include "RingBufferSizing.h"
+
+namespace orbit_linux_tracing {
+
+// A perf record dump contains the raw records that TracerImpl read from its perf_event_open ring
+// buffers during a capture, together with what TracerImpl needs to interpret them again. This
+// allows replaying a capture deterministically and offline, e.g., to measure the throughput of
+// PerfEventProcessor and of the visitors.
+//
+// The file starts with kPerfRecordDumpMagic and kPerfRecordDumpVersion, followed by chunks. Each
+// chunk is a PerfRecordDumpChunkHeader followed by `size` bytes of payload. All the metadata chunks
+// come before the first kRecord chunk.
+struct PerfRecordDump {
+  struct RingBuffer {
+    int file_descriptor = -1;
+    int32_t cpu = -1;
+    RingBufferType type = RingBufferType::kMmapTask;
+    std::string name;
+    // The records read from this ring buffer, in the order in which they were read.
+    std::vector<char> records;
+    // Only set by ReadPerfRecordDump.
+    uint64_t record_count = 0;
+  };
+
+  orbit_grpc_protos::CaptureOptions capture_options;
+  // The content of /proc/<pid>/maps of the target process at the beginning of the capture.
+  std::string target_maps;
+  uint64_t effective_capture_start_timestamp_ns = 0;
+  // The stream ids of the file descriptors, grouped by how TracerImpl handles their samples. The
+  // meaning of each group is given by its index, which only TracerImpl knows.
+  std::vector<std::vector<uint64_t>> stream_id_sets;
+  std::vector<std::pair<uint64_t, uint64_t>> stream_ids_to_function_id;
+  std::vector<std::pair<uint64_t, orbit_grpc_protos::TracepointInfo>>
+      stream_ids_to_tracepoint_info;
+  std::vector<RingBuffer> ring_buffers;
+};
+
+inline constexpr char kPerfRecordDumpMagic[] = "ORBITPRD";
+inline constexpr uint32_t kPerfRecordDumpVersion = 1;
+
+enum class PerfRecordDumpChunkType : uint32_t {
+  // Serialized CaptureOptions.
+  kCaptureOptions = 1,
+  kTargetMaps,
+  kEffectiveCaptureStartTimestampNs,
+  // An array of uint64_t stream ids. The index of the set is the number of kStreamIdSet chunks
+  // that precede this one.
+  kStreamIdSet,
+  // An array of pairs of uint64_t: stream id and function id.
+  kStreamIdsToFunctionId,
+  // A uint64_t stream id followed by a serialized TracepointInfo.
+  kStreamIdToTracepointInfo,
+  // An int32_t file descriptor, an int32_t cpu, a uint32_t RingBufferType, then the name. Ring
+  // buffers are numbered in the order of their kRingBuffer chunks.
+  kRingBuffer,
+  // A uint32_t ring buffer number followed by the raw record, starting with its perf_event_header.
+  kRecord,
+};
+
+struct PerfRecordDumpChunkHeader {
+  PerfRecordDumpChunkType type;
+  uint32_t size;
+};
+
+// Writes a perf record dump. WriteRecord can be called concurrently from multiple threads.
+class PerfRecordDumpWriter {
+ public:
+  [[nodiscard]] static ErrorMessageOr<std::unique_ptr<PerfRecordDumpWriter>> Create(
+      const std::filesystem::path& file_path);
+
+  PerfRecordDumpWriter(const PerfRecordDumpWriter&) = delete;
+  PerfRecordDumpWriter& operator=(const PerfRecordDumpWriter&) = delete;
+  PerfRecordDumpWriter(PerfRecordDumpWriter&&) = delete;
+  PerfRecordDumpWriter& operator=(PerfRecordDumpWriter&&) = delete;
+
+  // Flushes the records that are still buffered.
+  ~PerfRecordDumpWriter();
+
+  // Writes everything in `metadata` except the records of the ring buffers. Call this once, before
+  // the first call to WriteRecord.
+  void WriteMetadata(const PerfRecordDump& metadata);
+
+  // Copies the record at the tail of `ring_buffer`, whose header is `header`, without consuming it.
+  void WriteRecord(uint32_t ring_buffer_index, const perf_event_header& header,
+                   PerfEventRingBuffer* ring_buffer);
+
+ private:
+  explicit PerfRecordDumpWriter(orbit_base::UniqueFd fd) : fd_{std::move(fd)} {}
+
+  void AppendChunk(PerfRecordDumpChunkType type, std::string_view payload)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void FlushIfNeeded(size_t min_size) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  static constexpr size_t kFlushThresholdBytes = 1024 * 1024;
+
+  orbit_base::UniqueFd fd_;
+  absl::Mutex mutex_;
+  std::string buffer_ ABSL_GUARDED_BY(mutex_);
+  bool write_failed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+[[nodiscard]] ErrorMessageOr<PerfRecordDump> ReadPerfRecordDump(
+    const std::filesystem::path& file_path);
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_PERF_RECORD_DUMP_H_
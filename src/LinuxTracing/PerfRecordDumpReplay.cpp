@@ -0,0 +1,105 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Replays a perf record dump, as written by TracerImpl when CaptureOptions::perf_record_dump_path
+// is set, through TracerImpl, PerfEventProcessor and the visitors, discarding the resulting events.
+// Reports the throughput overall and the time spent in each visitor. As the same records are
+// processed every time, this allows comparing changes to the processing of the events on a real
+// workload, without root and without the target process.
+
+#include <absl/strings/str_format.h>
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+
+#include "GrpcProtos/capture.pb.h"
+#include "LinuxTracing/TracerListener.h"
+#include "OrbitBase/Result.h"
+#include "PerfRecordDump.h"
+#include "TracerImpl.h"
+
+namespace {
+
+using orbit_linux_tracing::PerfRecordDump;
+using orbit_linux_tracing::TracerImpl;
+
+class NullTracerListener : public orbit_linux_tracing::TracerListener {
+ public:
+  void OnSchedulingSlice(orbit_grpc_protos::SchedulingSlice /*scheduling_slice*/) override {}
+  void OnCallstackSample(orbit_grpc_protos::FullCallstackSample /*callstack_sample*/) override {}
+  void OnPageFaultSample(orbit_grpc_protos::FullPageFaultSample /*page_fault_sample*/) override {}
+  void OnPerformanceCounterSample(
+      orbit_grpc_protos::PerformanceCounterSample /*performance_counter_sample*/) override {}
+  void OnThreadStateSliceCallstack(
+      orbit_grpc_protos::ThreadStateSliceCallstack /*callstack*/) override {}
+  void OnFunctionCall(orbit_grpc_protos::FunctionCall /*function_call*/) override {}
+  void OnGpuJob(orbit_grpc_protos::FullGpuJob /*gpu_job*/) override {}
+  void OnThreadName(orbit_grpc_protos::ThreadName /*thread_name*/) override {}
+  void OnThreadNamesSnapshot(
+      orbit_grpc_protos::ThreadNamesSnapshot /*thread_names_snapshot*/) override {}
+  void OnThreadStateSlice(orbit_grpc_protos::ThreadStateSlice /*thread_state_slice*/) override {}
+  void OnAddressInfo(orbit_grpc_protos::FullAddressInfo /*full_address_info*/) override {}
+  void OnTracepointEvent(orbit_grpc_protos::FullTracepointEvent /*tracepoint_event*/) override {}
+  void OnModulesSnapshot(orbit_grpc_protos::ModulesSnapshot /*modules_snapshot*/) override {}
+  void OnModuleUpdate(orbit_grpc_protos::ModuleUpdateEvent /*module_update_event*/) override {}
+  void OnErrorsWithPerfEventOpenEvent(
+      orbit_grpc_protos::ErrorsWithPerfEventOpenEvent /*errors_with_perf_event_open_event*/)
+      override {}
+  void OnLostPerfRecordsEvent(
+      orbit_grpc_protos::LostPerfRecordsEvent /*lost_perf_records_event*/) override {}
+  void OnOutOfOrderEventsDiscardedEvent(
+      orbit_grpc_protos::OutOfOrderEventsDiscardedEvent /*out_of_order_events_discarded_event*/)
+      override {}
+  void OnPerfEventProcessingStatsEvent(
+      orbit_grpc_protos::PerfEventProcessingStatsEvent /*perf_event_processing_stats_event*/)
+      override {}
+  void OnWarningInstrumentingWithUprobesEvent(
+      orbit_grpc_protos::WarningInstrumentingWithUprobesEvent
+      /*warning_instrumenting_with_uprobes_event*/) override {}
+  void OnWarningEvent(orbit_grpc_protos::WarningEvent /*warning_event*/) override {}
+};
+
+[[nodiscard]] double PerSecond(uint64_t count, uint64_t duration_ns) {
+  if (duration_ns == 0) return 0;
+  return static_cast<double>(count) * 1e9 / static_cast<double>(duration_ns);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    absl::FPrintF(stderr, "Usage: %s <perf record dump>\n", argv[0]);
+    return 1;
+  }
+
+  ErrorMessageOr<PerfRecordDump> dump = orbit_linux_tracing::ReadPerfRecordDump(argv[1]);
+  if (dump.has_error()) {
+    absl::FPrintF(stderr, "%s\n", dump.error().message());
+    return 1;
+  }
+
+  NullTracerListener listener;
+  // Replay the records with the capture options with which they were recorded.
+  TracerImpl tracer{dump.value().capture_options, nullptr, &listener};
+  ErrorMessageOr<TracerImpl::PerfRecordDumpReplayStats> stats =
+      tracer.ReplayPerfRecordDump(std::move(dump.value()));
+  if (stats.has_error()) {
+    absl::FPrintF(stderr, "%s\n", stats.error().message());
+    return 1;
+  }
+
+  const TracerImpl::PerfRecordDumpReplayStats& replay_stats = stats.value();
+  absl::PrintF("%u records and %u events in %.3f s\n", replay_stats.record_count,
+               replay_stats.event_count, static_cast<double>(replay_stats.duration_ns) / 1e9);
+  absl::PrintF("%.0f records/s, %.0f events/s\n",
+               PerSecond(replay_stats.record_count, replay_stats.duration_ns),
+               PerSecond(replay_stats.event_count, replay_stats.duration_ns));
+  absl::PrintF("%30s %16s %20s\n", "visitor", "time [ms]", "events/s");
+  for (const auto& [visitor_name, time_ns] : replay_stats.visitor_times_ns) {
+    absl::PrintF("%30s %16.1f %20.0f\n", visitor_name, static_cast<double>(time_ns) / 1e6,
+                 PerSecond(replay_stats.event_count, time_ns));
+  }
+  return 0;
+}
@@ -0,0 +1,190 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <linux/perf_event.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/Result.h"
+#include "PerfEventRingBuffer.h"
+#include "PerfRecordDump.h"
+#include "TestUtils/TemporaryFile.h"
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+// Appends a record of type `type` whose payload is `payload_size` bytes of `fill`.
+void AppendRecord(std::vector<char>* records, uint32_t type, uint16_t payload_size, char fill) {
+  perf_event_header header{};
+  header.type = type;
+  header.size = static_cast<uint16_t>(sizeof(header) + payload_size);
+  const size_t offset = records->size();
+  records->resize(offset + header.size, fill);
+  std::memcpy(records->data() + offset, &header, sizeof(header));
+}
+
+[[nodiscard]] PerfRecordDump MakeMetadata() {
+  PerfRecordDump metadata;
+  metadata.capture_options.set_pid(42);
+  metadata.capture_options.set_samples_per_second(1000);
+  metadata.target_maps = "7f0000000000-7f0000001000 r-xp 00000000 00:00 0 /path/to/lib.so\n";
+  metadata.effective_capture_start_timestamp_ns = 123456789;
+  metadata.stream_id_sets = {{1, 2, 3}, {}, {4}};
+  metadata.stream_ids_to_function_id = {{1, 10}, {2, 20}};
+  orbit_grpc_protos::TracepointInfo tracepoint_info;
+  tracepoint_info.set_category("sched");
+  tracepoint_info.set_name("sched_switch");
+  metadata.stream_ids_to_tracepoint_info = {{5, tracepoint_info}};
+  metadata.ring_buffers.push_back(PerfRecordDump::RingBuffer{
+      .file_descriptor = 7, .cpu = 0, .type = RingBufferType::kSampling, .name = "sampling_0"});
+  metadata.ring_buffers.push_back(PerfRecordDump::RingBuffer{
+      .file_descriptor = 8, .cpu = 1, .type = RingBufferType::kThreadNames, .name = "names_1"});
+  return metadata;
+}
+
+// Writes all records of `ring_buffer` to `writer` the way TracerImpl does, consuming them.
+void WriteAllRecords(PerfRecordDumpWriter* writer, uint32_t ring_buffer_index,
+                     PerfEventRingBuffer* ring_buffer) {
+  while (ring_buffer->HasNewData()) {
+    perf_event_header header;
+    ring_buffer->ReadHeader(&header);
+    writer->WriteRecord(ring_buffer_index, header, ring_buffer);
+    ring_buffer->SkipRecord(header);
+  }
+}
+
+}  // namespace
+
+TEST(PerfEventRingBuffer, CreateFromRecordsReadsTheRecordsInOrder) {
+  std::vector<char> records;
+  AppendRecord(&records, PERF_RECORD_SAMPLE, 16, 'a');
+  AppendRecord(&records, PERF_RECORD_MMAP, 8, 'b');
+  PerfEventRingBuffer ring_buffer =
+      PerfEventRingBuffer::CreateFromRecords(records, 7, "sampling_0", 3);
+  EXPECT_TRUE(ring_buffer.IsOpen());
+  EXPECT_EQ(ring_buffer.GetFileDescriptor(), 7);
+  EXPECT_EQ(ring_buffer.GetName(), "sampling_0");
+  EXPECT_EQ(ring_buffer.GetCpu(), 3);
+
+  ASSERT_TRUE(ring_buffer.HasNewData());
+  perf_event_header header;
+  ring_buffer.ReadHeader(&header);
+  EXPECT_EQ(header.type, PERF_RECORD_SAMPLE);
+  EXPECT_EQ(header.size, sizeof(perf_event_header) + 16);
+  char payload_byte = 0;
+  ring_buffer.ReadValueAtOffset(&payload_byte, sizeof(perf_event_header));
+  EXPECT_EQ(payload_byte, 'a');
+  ring_buffer.SkipRecord(header);
+
+  ASSERT_TRUE(ring_buffer.HasNewData());
+  ring_buffer.ReadHeader(&header);
+  EXPECT_EQ(header.type, PERF_RECORD_MMAP);
+  ring_buffer.SkipRecord(header);
+  EXPECT_FALSE(ring_buffer.HasNewData());
+}
+
+TEST(PerfRecordDump, WriteAndReadBack) {
+  ErrorMessageOr<orbit_test_utils::TemporaryFile> temporary_file_or_error =
+      orbit_test_utils::TemporaryFile::Create();
+  ASSERT_TRUE(temporary_file_or_error.has_value()) << temporary_file_or_error.error().message();
+  orbit_test_utils::TemporaryFile temporary_file = std::move(temporary_file_or_error.value());
+
+  std::vector<char> records_0;
+  AppendRecord(&records_0, PERF_RECORD_SAMPLE, 16, 'a');
+  AppendRecord(&records_0, PERF_RECORD_SAMPLE, 32, 'b');
+  std::vector<char> records_1;
+  AppendRecord(&records_1, PERF_RECORD_FORK, 24, 'c');
+
+  const PerfRecordDump metadata = MakeMetadata();
+  {
+    ErrorMessageOr<std::unique_ptr<PerfRecordDumpWriter>> writer_or_error =
+        PerfRecordDumpWriter::Create(temporary_file.file_path());
+    ASSERT_TRUE(writer_or_error.has_value()) << writer_or_error.error().message();
+    PerfRecordDumpWriter* writer = writer_or_error.value().get();
+    writer->WriteMetadata(metadata);
+    PerfEventRingBuffer ring_buffer_0 =
+        PerfEventRingBuffer::CreateFromRecords(records_0, 7, "sampling_0", 0);
+    PerfEventRingBuffer ring_buffer_1 =
+        PerfEventRingBuffer::CreateFromRecords(records_1, 8, "names_1", 1);
+    WriteAllRecords(writer, 1, &ring_buffer_1);
+    WriteAllRecords(writer, 0, &ring_buffer_0);
+  }
+
+  ErrorMessageOr<PerfRecordDump> dump_or_error = ReadPerfRecordDump(temporary_file.file_path());
+  ASSERT_TRUE(dump_or_error.has_value()) << dump_or_error.error().message();
+  const PerfRecordDump& dump = dump_or_error.value();
+  EXPECT_EQ(dump.capture_options.pid(), 42);
+  EXPECT_EQ(dump.capture_options.samples_per_second(), 1000);
+  EXPECT_EQ(dump.target_maps, metadata.target_maps);
+  EXPECT_EQ(dump.effective_capture_start_timestamp_ns, 123456789);
+  EXPECT_EQ(dump.stream_id_sets, metadata.stream_id_sets);
+  EXPECT_EQ(dump.stream_ids_to_function_id, metadata.stream_ids_to_function_id);
+  ASSERT_EQ(dump.stream_ids_to_tracepoint_info.size(), 1);
+  EXPECT_EQ(dump.stream_ids_to_tracepoint_info[0].first, 5);
+  EXPECT_EQ(dump.stream_ids_to_tracepoint_info[0].second.category(), "sched");
+  EXPECT_EQ(dump.stream_ids_to_tracepoint_info[0].second.name(), "sched_switch");
+
+  ASSERT_EQ(dump.ring_buffers.size(), 2);
+  EXPECT_EQ(dump.ring_buffers[0].file_descriptor, 7);
+  EXPECT_EQ(dump.ring_buffers[0].cpu, 0);
+  EXPECT_EQ(dump.ring_buffers[0].type, RingBufferType::kSampling);
+  EXPECT_EQ(dump.ring_buffers[0].name, "sampling_0");
+  EXPECT_EQ(dump.ring_buffers[0].records, records_0);
+  EXPECT_EQ(dump.ring_buffers[0].record_count, 2);
+  EXPECT_EQ(dump.ring_buffers[1].file_descriptor, 8);
+  EXPECT_EQ(dump.ring_buffers[1].cpu, 1);
+  EXPECT_EQ(dump.ring_buffers[1].type, RingBufferType::kThreadNames);
+  EXPECT_EQ(dump.ring_buffers[1].name, "names_1");
+  EXPECT_EQ(dump.ring_buffers[1].records, records_1);
+  EXPECT_EQ(dump.ring_buffers[1].record_count, 1);
+}
+
+TEST(PerfRecordDump, ReadRejectsFilesThatAreNotPerfRecordDumps) {
+  ErrorMessageOr<orbit_test_utils::TemporaryFile> temporary_file_or_error =
+      orbit_test_utils::TemporaryFile::Create();
+  ASSERT_TRUE(temporary_file_or_error.has_value()) << temporary_file_or_error.error().message();
+  orbit_test_utils::TemporaryFile temporary_file = std::move(temporary_file_or_error.value());
+  ASSERT_TRUE(orbit_base::WriteFully(temporary_file.fd(), "not a perf record dump").has_value());
+
+  ErrorMessageOr<PerfRecordDump> dump_or_error = ReadPerfRecordDump(temporary_file.file_path());
+  ASSERT_TRUE(dump_or_error.has_error());
+  EXPECT_THAT(dump_or_error.error().message(), testing::HasSubstr("is not a perf record dump"));
+}
+
+TEST(PerfRecordDump, ReadRejectsTruncatedFiles) {
+  ErrorMessageOr<orbit_test_utils::TemporaryFile> temporary_file_or_error =
+      orbit_test_utils::TemporaryFile::Create();
+  ASSERT_TRUE(temporary_file_or_error.has_value()) << temporary_file_or_error.error().message();
+  orbit_test_utils::TemporaryFile temporary_file = std::move(temporary_file_or_error.value());
+  {
+    ErrorMessageOr<std::unique_ptr<PerfRecordDumpWriter>> writer_or_error =
+        PerfRecordDumpWriter::Create(temporary_file.file_path());
+    ASSERT_TRUE(writer_or_error.has_value()) << writer_or_error.error().message();
+    writer_or_error.value()->WriteMetadata(MakeMetadata());
+  }
+  ErrorMessageOr<std::string> content = orbit_base::ReadFileToString(temporary_file.file_path());
+  ASSERT_TRUE(content.has_value());
+  content.value().resize(content.value().size() - 1);
+  {
+    ErrorMessageOr<orbit_base::UniqueFd> fd =
+        orbit_base::OpenFileForWriting(temporary_file.file_path());
+    ASSERT_TRUE(fd.has_value());
+    ASSERT_TRUE(orbit_base::WriteFully(fd.value(), content.value()).has_value());
+  }
+
+  EXPECT_TRUE(ReadPerfRecordDump(temporary_file.file_path()).has_error());
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,48 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_PERFORMANCE_COUNTER_VISITOR_H_
+#define LINUX_TRACING_PERFORMANCE_COUNTER_VISITOR_H_
+
+#include "GrpcProtos/capture.pb.h"
+#include "LinuxTracing/TracerListener.h"
+#include "OrbitBase/Logging.h"
+#include "PerfEvent.h"
+#include "PerfEventVisitor.h"
+
+namespace orbit_linux_tracing {
+
+// This class processes PerformanceCounterSamplePerfEvents and sends the corresponding
+// PerformanceCounterSamples to the TracerListener. Going through the PerfEventProcessor, rather
+// than sending them directly from the threads reading the ring buffers, sorts the samples of each
+// thread by timestamp even when the thread migrates between CPUs.
+class PerformanceCounterVisitor : public PerfEventVisitor {
+ public:
+  explicit PerformanceCounterVisitor(TracerListener* listener) : listener_{listener} {
+    ORBIT_CHECK(listener_ != nullptr);
+  }
+
+  void Visit(uint64_t event_timestamp,
+             const PerformanceCounterSamplePerfEventData& event_data) override {
+    orbit_grpc_protos::PerformanceCounterSample performance_counter_sample;
+    performance_counter_sample.set_pid(event_data.pid);
+    performance_counter_sample.set_tid(event_data.tid);
+    performance_counter_sample.set_cpu(static_cast<int32_t>(event_data.cpu));
+    performance_counter_sample.set_timestamp_ns(event_timestamp);
+    performance_counter_sample.set_cycles(event_data.cycles);
+    performance_counter_sample.set_instructions(event_data.instructions);
+    performance_counter_sample.set_cache_misses(event_data.cache_misses);
+    performance_counter_sample.set_branch_misses(event_data.branch_misses);
+
+    ORBIT_CHECK(listener_ != nullptr);
+    listener_->OnPerformanceCounterSample(std::move(performance_counter_sample));
+  }
+
+ private:
+  TracerListener* listener_;
+};
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_PERFORMANCE_COUNTER_VISITOR_H_
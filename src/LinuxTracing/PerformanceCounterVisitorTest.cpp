@@ -0,0 +1,56 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "GrpcProtos/capture.pb.h"
+#include "MockTracerListener.h"
+#include "PerfEvent.h"
+#include "PerformanceCounterVisitor.h"
+
+namespace orbit_linux_tracing {
+
+TEST(PerformanceCounterVisitor, NeedsListener) {
+  EXPECT_DEATH(PerformanceCounterVisitor{nullptr}, "listener_ != nullptr");
+}
+
+TEST(PerformanceCounterVisitor,
+     VisitPerformanceCounterSamplePerfEventCallsOnPerformanceCounterSample) {
+  MockTracerListener mock_listener;
+  PerformanceCounterVisitor visitor{&mock_listener};
+
+  constexpr uint64_t kTimestampNs = 1234;
+  PerfEvent event{PerformanceCounterSamplePerfEvent{
+      .timestamp = kTimestampNs,
+      .data =
+          {
+              .pid = 10,
+              .tid = 11,
+              .cpu = 3,
+              .cycles = 2'000'000,
+              .instructions = 3'000'000,
+              .cache_misses = 4'000,
+              .branch_misses = 500,
+          },
+  }};
+
+  orbit_grpc_protos::PerformanceCounterSample actual_performance_counter_sample;
+  EXPECT_CALL(mock_listener, OnPerformanceCounterSample)
+      .Times(1)
+      .WillOnce(::testing::SaveArg<0>(&actual_performance_counter_sample));
+  event.Accept(&visitor);
+
+  EXPECT_EQ(actual_performance_counter_sample.pid(), 10);
+  EXPECT_EQ(actual_performance_counter_sample.tid(), 11);
+  EXPECT_EQ(actual_performance_counter_sample.cpu(), 3);
+  EXPECT_EQ(actual_performance_counter_sample.timestamp_ns(), kTimestampNs);
+  EXPECT_EQ(actual_performance_counter_sample.cycles(), 2'000'000);
+  EXPECT_EQ(actual_performance_counter_sample.instructions(), 3'000'000);
+  EXPECT_EQ(actual_performance_counter_sample.cache_misses(), 4'000);
+  EXPECT_EQ(actual_performance_counter_sample.branch_misses(), 500);
+}
+
+}  // namespace orbit_linux_tracing
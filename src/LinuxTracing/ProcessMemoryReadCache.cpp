@@ -0,0 +1,91 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ProcessMemoryReadCache.h"
+
+#include <absl/base/casts.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace orbit_linux_tracing {
+
+size_t ProcessMemoryReadCache::Read(uint64_t addr, void* dst, size_t size) {
+  if (size == 0 || addr + size < addr) return 0;
+
+  const uint64_t first_page_address = addr & ~(kPageSize - 1);
+  const uint64_t last_page_address = (addr + size - 1) & ~(kPageSize - 1);
+  const size_t page_count = (last_page_address - first_page_address) / kPageSize + 1;
+
+  absl::MutexLock lock{&mutex_};
+  if (page_count > kMaxCachedReadPages) {
+    ++read_syscall_count_;
+    iovec local_iov{dst, size};
+    iovec remote_iov{absl::bit_cast<void*>(addr), size};
+    ssize_t bytes_read = process_vm_readv(pid_, &local_iov, 1, &remote_iov, 1, 0);
+    return bytes_read < 0 ? 0 : static_cast<size_t>(bytes_read);
+  }
+
+  CachePages(first_page_address, page_count);
+
+  size_t bytes_read = 0;
+  while (bytes_read < size) {
+    const uint64_t current_addr = addr + bytes_read;
+    auto page_it = pages_.find(current_addr & ~(kPageSize - 1));
+    if (page_it == pages_.end()) break;
+    const uint64_t offset_in_page = current_addr & (kPageSize - 1);
+    const size_t bytes_to_copy = std::min<size_t>(size - bytes_read, kPageSize - offset_in_page);
+    std::memcpy(static_cast<uint8_t*>(dst) + bytes_read, page_it->second->data() + offset_in_page,
+                bytes_to_copy);
+    bytes_read += bytes_to_copy;
+  }
+  return bytes_read;
+}
+
+void ProcessMemoryReadCache::CachePages(uint64_t first_page_address, size_t page_count) {
+  std::vector<uint64_t> missing_page_addresses;
+  for (size_t i = 0; i < page_count; ++i) {
+    const uint64_t page_address = first_page_address + i * kPageSize;
+    if (!pages_.contains(page_address)) missing_page_addresses.push_back(page_address);
+  }
+  if (missing_page_addresses.empty()) return;
+
+  if (pages_.size() + missing_page_addresses.size() > capacity_pages_) {
+    pages_.clear();
+  }
+
+  std::vector<std::unique_ptr<Page>> missing_pages;
+  std::vector<iovec> local_iovs;
+  std::vector<iovec> remote_iovs;
+  for (uint64_t page_address : missing_page_addresses) {
+    missing_pages.push_back(std::make_unique<Page>());
+    local_iovs.push_back({missing_pages.back()->data(), kPageSize});
+    remote_iovs.push_back({absl::bit_cast<void*>(page_address), kPageSize});
+  }
+
+  ++read_syscall_count_;
+  ssize_t bytes_read = process_vm_readv(pid_, local_iovs.data(), local_iovs.size(),
+                                        remote_iovs.data(), remote_iovs.size(), 0);
+  if (bytes_read <= 0) return;
+
+  // process_vm_readv stops at the first page that can't be read, leaving the following ones unread.
+  const size_t pages_read = static_cast<size_t>(bytes_read) / kPageSize;
+  for (size_t i = 0; i < pages_read; ++i) {
+    pages_.emplace(missing_page_addresses[i], std::move(missing_pages[i]));
+  }
+}
+
+void ProcessMemoryReadCache::Clear() {
+  absl::MutexLock lock{&mutex_};
+  pages_.clear();
+}
+
+uint64_t ProcessMemoryReadCache::GetReadSyscallCount() const {
+  absl::MutexLock lock{&mutex_};
+  return read_syscall_count_;
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,61 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_PROCESS_MEMORY_READ_CACHE_H_
+#define LINUX_TRACING_PROCESS_MEMORY_READ_CACHE_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <array>
+#include <memory>
+
+namespace orbit_linux_tracing {
+
+// Page-granular cache of the memory of a process, kept across unwinds. It is meant for the reads
+// that LibunwindstackMultipleOfflineAndProcessMemory can't serve from the stack slices and that
+// hit memory that doesn't change, like the unwind information of the vDSO or of JIT code, which
+// would otherwise cost one syscall per read. The pages a read needs that are not cached yet are
+// read from the process with a single `process_vm_readv` call.
+// The cache doesn't know when the memory of the process changes: only use it for non-writable
+// mappings, and call Clear when the mappings change. Thread-safe.
+class ProcessMemoryReadCache {
+ public:
+  static constexpr uint64_t kPageSize = 4096;
+  // When the cache would exceed this many pages, it is cleared.
+  static constexpr size_t kDefaultCapacityPages = 1024;
+  // Larger reads are not cached.
+  static constexpr size_t kMaxCachedReadPages = 16;
+
+  explicit ProcessMemoryReadCache(pid_t pid, size_t capacity_pages = kDefaultCapacityPages)
+      : pid_{pid}, capacity_pages_{capacity_pages} {}
+
+  // Same semantics as unwindstack::Memory::Read: returns the number of bytes read from the start
+  // of the range, which is less than `size` if part of the range couldn't be read.
+  size_t Read(uint64_t addr, void* dst, size_t size);
+  void Clear();
+
+  [[nodiscard]] uint64_t GetReadSyscallCount() const;
+
+ private:
+  using Page = std::array<uint8_t, kPageSize>;
+
+  // Reads the `page_count` pages starting at `first_page_address` that are not cached already.
+  void CachePages(uint64_t first_page_address, size_t page_count)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const pid_t pid_;
+  const size_t capacity_pages_;
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<uint64_t, std::unique_ptr<Page>> pages_ ABSL_GUARDED_BY(mutex_);
+  uint64_t read_syscall_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_PROCESS_MEMORY_READ_CACHE_H_
@@ -0,0 +1,103 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/base/casts.h>
+#include <gtest/gtest.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstring>
+
+#include "ProcessMemoryReadCache.h"
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+class ProcessMemoryReadCacheTest : public ::testing::Test {
+ protected:
+  static constexpr size_t kPageCount = 4;
+  static constexpr size_t kSize = kPageCount * ProcessMemoryReadCache::kPageSize;
+
+  void SetUp() override {
+    memory_ = static_cast<uint8_t*>(
+        mmap(nullptr, kSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    ASSERT_NE(memory_, MAP_FAILED);
+    for (size_t i = 0; i < kSize; ++i) memory_[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  void TearDown() override { munmap(memory_, kSize); }
+
+  [[nodiscard]] uint64_t address(size_t offset) const {
+    return absl::bit_cast<uint64_t>(memory_ + offset);
+  }
+
+  uint8_t* memory_ = nullptr;
+};
+
+}  // namespace
+
+TEST_F(ProcessMemoryReadCacheTest, ReadsAcrossPagesWithOneSyscall) {
+  ProcessMemoryReadCache cache{getpid()};
+  constexpr size_t kOffset = ProcessMemoryReadCache::kPageSize - 3;
+  std::array<uint8_t, 8> destination{};
+
+  EXPECT_EQ(cache.Read(address(kOffset), destination.data(), destination.size()),
+            destination.size());
+  EXPECT_EQ(std::memcmp(destination.data(), memory_ + kOffset, destination.size()), 0);
+  EXPECT_EQ(cache.GetReadSyscallCount(), 1);
+
+  // Both pages are cached now.
+  EXPECT_EQ(cache.Read(address(kOffset + 4), destination.data(), destination.size()),
+            destination.size());
+  EXPECT_EQ(std::memcmp(destination.data(), memory_ + kOffset + 4, destination.size()), 0);
+  EXPECT_EQ(cache.GetReadSyscallCount(), 1);
+}
+
+TEST_F(ProcessMemoryReadCacheTest, ClearDropsTheCachedPages) {
+  ProcessMemoryReadCache cache{getpid()};
+  uint8_t value = 0;
+  ASSERT_EQ(cache.Read(address(10), &value, 1), 1);
+  EXPECT_EQ(value, memory_[10]);
+
+  memory_[10] = memory_[10] + 1;
+  ASSERT_EQ(cache.Read(address(10), &value, 1), 1);
+  EXPECT_EQ(value, static_cast<uint8_t>(memory_[10] - 1));
+
+  cache.Clear();
+  ASSERT_EQ(cache.Read(address(10), &value, 1), 1);
+  EXPECT_EQ(value, memory_[10]);
+  EXPECT_EQ(cache.GetReadSyscallCount(), 2);
+}
+
+TEST_F(ProcessMemoryReadCacheTest, ReadStopsAtAnUnreadablePage) {
+  ASSERT_EQ(mprotect(memory_ + 2 * ProcessMemoryReadCache::kPageSize,
+                     ProcessMemoryReadCache::kPageSize, PROT_NONE),
+            0);
+  ProcessMemoryReadCache cache{getpid()};
+  std::array<uint8_t, 16> destination{};
+
+  EXPECT_EQ(cache.Read(address(2 * ProcessMemoryReadCache::kPageSize - 4), destination.data(),
+                       destination.size()),
+            4);
+  EXPECT_EQ(cache.Read(address(2 * ProcessMemoryReadCache::kPageSize), destination.data(),
+                       destination.size()),
+            0);
+}
+
+TEST_F(ProcessMemoryReadCacheTest, IsClearedWhenFull) {
+  ProcessMemoryReadCache cache{getpid(), /*capacity_pages=*/2};
+  uint8_t value = 0;
+  for (size_t page = 0; page < kPageCount; ++page) {
+    ASSERT_EQ(cache.Read(address(page * ProcessMemoryReadCache::kPageSize), &value, 1), 1);
+  }
+  // The first page was dropped when the third one was read.
+  ASSERT_EQ(cache.Read(address(0), &value, 1), 1);
+  EXPECT_EQ(cache.GetReadSyscallCount(), kPageCount + 1);
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,121 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "RingBufferSizing.h"
+
+#include <algorithm>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+// These values are supposed to be large enough to accommodate enough events in case the threads
+// reading the ring buffers are not scheduled for a few tens of milliseconds. They are used for the
+// ring buffers whose amount of records can't be estimated from the capture options.
+constexpr uint64_t kMmapTaskRingBufferSizeKb = 64;
+constexpr uint64_t kThreadNamesRingBufferSizeKb = 64;
+constexpr uint64_t kContextSwitchesAndThreadStateRingBufferSizeKb = 2 * 1024;
+constexpr uint64_t kContextSwitchesAndThreadStateWithStacksRingBufferSizeKb = 64 * 1024;
+constexpr uint64_t kGpuTracingRingBufferSizeKb = 256;
+constexpr uint64_t kInstrumentedTracepointsRingBufferSizeKb = 8 * 1024;
+
+// The rate of uprobes depends on the instrumented functions, so only their number is considered.
+constexpr uint64_t kUprobesRingBufferSizeKbPerInstrumentedFunction = 256;
+constexpr uint64_t kMinUprobesRingBufferSizeKb = 1024;
+constexpr uint64_t kMaxUprobesRingBufferSizeKb = 8 * 1024;
+
+// Approximate size of a sample record besides the copy of the stack: the header, the sample_id
+// fields, and the registers or the callchain.
+constexpr uint64_t kStackSampleRecordOverheadBytes = 256;
+constexpr uint64_t kCallchainSampleRecordOverheadBytes = 1024;
+// Sampling ring buffers hold between half and all of the samples taken on a CPU in this time, and
+// at least half of kMinSampleRecordCount samples.
+constexpr double kSamplingBufferedDurationS = 0.5;
+constexpr uint64_t kMinSampleRecordCount = 8;
+// Ring buffers for uprobes with stack hold between half and all of this many records.
+constexpr uint64_t kUprobesWithStackBufferedRecordCount = 2048;
+
+[[nodiscard]] uint64_t FloorPowerOfTwo(uint64_t value) {
+  ORBIT_CHECK(value > 0);
+  return uint64_t{1} << (63 - __builtin_clzll(value));
+}
+
+[[nodiscard]] uint64_t EstimateRingBufferSizeKb(RingBufferType type,
+                                                const RingBufferSizingParameters& parameters) {
+  switch (type) {
+    case RingBufferType::kUprobes:
+      return std::clamp<uint64_t>(
+          parameters.instrumented_function_count * kUprobesRingBufferSizeKbPerInstrumentedFunction,
+          kMinUprobesRingBufferSizeKb, kMaxUprobesRingBufferSizeKb);
+    case RingBufferType::kUprobesWithStack:
+      return kUprobesWithStackBufferedRecordCount *
+             (parameters.stack_dump_size + kStackSampleRecordOverheadBytes) / 1024;
+    case RingBufferType::kMmapTask:
+      return kMmapTaskRingBufferSizeKb;
+    case RingBufferType::kSampling: {
+      if (parameters.sampling_period_ns == 0) {
+        return kMinRingBufferSizeKb;
+      }
+      const uint64_t record_size =
+          parameters.stack_dump_size + (parameters.callchain_sampling
+                                            ? kCallchainSampleRecordOverheadBytes
+                                            : kStackSampleRecordOverheadBytes);
+      const double samples_per_second = 1e9 / static_cast<double>(parameters.sampling_period_ns);
+      const auto size_kb = static_cast<uint64_t>(samples_per_second * kSamplingBufferedDurationS *
+                                                 static_cast<double>(record_size) / 1024);
+      return std::max(size_kb, kMinSampleRecordCount * record_size / 1024);
+    }
+    case RingBufferType::kThreadNames:
+      return kThreadNamesRingBufferSizeKb;
+    case RingBufferType::kContextSwitchesAndThreadState:
+      return kContextSwitchesAndThreadStateRingBufferSizeKb;
+    case RingBufferType::kContextSwitchesAndThreadStateWithStacks:
+      return kContextSwitchesAndThreadStateWithStacksRingBufferSizeKb;
+    case RingBufferType::kGpuTracing:
+      return kGpuTracingRingBufferSizeKb;
+    case RingBufferType::kInstrumentedTracepoints:
+      return kInstrumentedTracepointsRingBufferSizeKb;
+  }
+  ORBIT_UNREACHABLE();
+}
+
+}  // namespace
+
+uint64_t ComputeRingBufferSizeKb(RingBufferType type, const RingBufferSizingParameters& parameters,
+                                 int size_log2_adjustment) {
+  uint64_t size_kb =
+      FloorPowerOfTwo(std::max<uint64_t>(EstimateRingBufferSizeKb(type, parameters), 1));
+  if (size_log2_adjustment >= 0) {
+    size_kb <<= size_log2_adjustment;
+  } else {
+    size_kb >>= -size_log2_adjustment;
+  }
+  // Both bounds are powers of two, so the result is one too.
+  return std::clamp(size_kb, kMinRingBufferSizeKb, kMaxRingBufferSizeKb);
+}
+
+int RingBufferSizeFeedback::GetSizeLog2Adjustment(RingBufferType type) const {
+  absl::MutexLock lock{&mutex_};
+  return size_log2_adjustments_[static_cast<size_t>(type)];
+}
+
+void RingBufferSizeFeedback::Update(RingBufferType type, uint64_t lost_record_count,
+                                    double max_fill_fraction) {
+  absl::MutexLock lock{&mutex_};
+  int& size_log2_adjustment = size_log2_adjustments_[static_cast<size_t>(type)];
+  if (lost_record_count > 0) {
+    size_log2_adjustment = std::min(size_log2_adjustment + 1, kMaxSizeLog2Adjustment);
+  } else if (max_fill_fraction < kShrinkBelowFillFraction) {
+    size_log2_adjustment = std::max(size_log2_adjustment - 1, kMinSizeLog2Adjustment);
+  }
+}
+
+RingBufferSizeFeedback& RingBufferSizeFeedback::GetDefault() {
+  static auto* feedback = new RingBufferSizeFeedback();
+  return *feedback;
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,77 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_RING_BUFFER_SIZING_H_
+#define LINUX_TRACING_RING_BUFFER_SIZING_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace orbit_linux_tracing {
+
+// The kinds of perf_event_open ring buffers that TracerImpl opens. There is one ring buffer of each
+// kind per CPU.
+enum class RingBufferType : size_t {
+  kUprobes = 0,
+  kUprobesWithStack,
+  kMmapTask,
+  kSampling,
+  kThreadNames,
+  kContextSwitchesAndThreadState,
+  kContextSwitchesAndThreadStateWithStacks,
+  kGpuTracing,
+  kInstrumentedTracepoints,
+};
+inline constexpr size_t kRingBufferTypeCount = 9;
+
+// The properties of a capture that the expected amount of records in some ring buffers depends on.
+struct RingBufferSizingParameters {
+  // 0 if there is no sampling.
+  uint64_t sampling_period_ns = 0;
+  // Whether samples contain a callchain or an LBR callstack, as opposed to only registers and a
+  // copy of the stack.
+  bool callchain_sampling = false;
+  uint16_t stack_dump_size = 0;
+  size_t instrumented_function_count = 0;
+};
+
+// Returns the size, in KiB, of each ring buffer of `type`. This is a power of two estimated from
+// `parameters`, then multiplied by 2^size_log2_adjustment, and clamped to
+// [kMinRingBufferSizeKb, kMaxRingBufferSizeKb].
+[[nodiscard]] uint64_t ComputeRingBufferSizeKb(RingBufferType type,
+                                               const RingBufferSizingParameters& parameters,
+                                               int size_log2_adjustment);
+
+inline constexpr uint64_t kMinRingBufferSizeKb = 64;
+inline constexpr uint64_t kMaxRingBufferSizeKb = 512 * 1024;
+
+// RingBufferSizeFeedback remembers, across captures, how much larger or smaller than their estimate
+// the ring buffers of each type should be. At the end of each capture, the tracer reports for each
+// type whether records were lost and how full the ring buffers got. Each type grows by a factor of
+// two after a capture that lost records, and shrinks by a factor of two after a capture in which
+// the ring buffers never got more than kShrinkBelowFillFraction full.
+class RingBufferSizeFeedback {
+ public:
+  [[nodiscard]] int GetSizeLog2Adjustment(RingBufferType type) const;
+  void Update(RingBufferType type, uint64_t lost_record_count, double max_fill_fraction);
+
+  // The feedback shared by all captures of this process. It is never destroyed.
+  [[nodiscard]] static RingBufferSizeFeedback& GetDefault();
+
+  static constexpr int kMinSizeLog2Adjustment = -2;
+  static constexpr int kMaxSizeLog2Adjustment = 3;
+  static constexpr double kShrinkBelowFillFraction = 0.125;
+
+ private:
+  mutable absl::Mutex mutex_;
+  std::array<int, kRingBufferTypeCount> size_log2_adjustments_ ABSL_GUARDED_BY(mutex_){};
+};
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_RING_BUFFER_SIZING_H_
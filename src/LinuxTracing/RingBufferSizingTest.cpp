@@ -0,0 +1,113 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "RingBufferSizing.h"
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+constexpr uint64_t kOneMsInNs = 1'000'000;
+
+[[nodiscard]] RingBufferSizingParameters MakeDwarfSamplingParameters() {
+  return RingBufferSizingParameters{.sampling_period_ns = kOneMsInNs,
+                                    .callchain_sampling = false,
+                                    .stack_dump_size = 65000,
+                                    .instrumented_function_count = 0};
+}
+
+[[nodiscard]] bool IsPowerOfTwo(uint64_t value) { return value != 0 && (value & (value - 1)) == 0; }
+
+}  // namespace
+
+TEST(ComputeRingBufferSizeKb, DwarfSamplingAtOneKilohertzKeepsTheFormerDefaultSize) {
+  EXPECT_EQ(ComputeRingBufferSizeKb(RingBufferType::kSampling, MakeDwarfSamplingParameters(), 0),
+            16 * 1024);
+}
+
+TEST(ComputeRingBufferSizeKb, SamplingSizeFollowsRateAndRecordSize) {
+  RingBufferSizingParameters parameters = MakeDwarfSamplingParameters();
+  const uint64_t dwarf_size_kb = ComputeRingBufferSizeKb(RingBufferType::kSampling, parameters, 0);
+
+  parameters.sampling_period_ns = kOneMsInNs / 4;
+  EXPECT_EQ(ComputeRingBufferSizeKb(RingBufferType::kSampling, parameters, 0), 4 * dwarf_size_kb);
+
+  parameters.sampling_period_ns = kOneMsInNs;
+  parameters.callchain_sampling = true;
+  parameters.stack_dump_size = 512;
+  const uint64_t callchain_size_kb =
+      ComputeRingBufferSizeKb(RingBufferType::kSampling, parameters, 0);
+  EXPECT_LT(callchain_size_kb, dwarf_size_kb / 16);
+  EXPECT_TRUE(IsPowerOfTwo(callchain_size_kb));
+}
+
+TEST(ComputeRingBufferSizeKb, SamplingBuffersHoldAFewRecordsAtLowRates) {
+  RingBufferSizingParameters parameters = MakeDwarfSamplingParameters();
+  parameters.sampling_period_ns = 1'000 * kOneMsInNs;
+  EXPECT_GE(ComputeRingBufferSizeKb(RingBufferType::kSampling, parameters, 0) * 1024,
+            4 * parameters.stack_dump_size);
+}
+
+TEST(ComputeRingBufferSizeKb, UprobesSizeGrowsWithInstrumentedFunctions) {
+  RingBufferSizingParameters parameters{};
+  parameters.instrumented_function_count = 1;
+  const uint64_t few_functions_size_kb =
+      ComputeRingBufferSizeKb(RingBufferType::kUprobes, parameters, 0);
+  parameters.instrumented_function_count = 1000;
+  const uint64_t many_functions_size_kb =
+      ComputeRingBufferSizeKb(RingBufferType::kUprobes, parameters, 0);
+  EXPECT_LT(few_functions_size_kb, many_functions_size_kb);
+  EXPECT_EQ(many_functions_size_kb, 8 * 1024);
+}
+
+TEST(ComputeRingBufferSizeKb, AppliesAdjustmentAndClamps) {
+  const RingBufferSizingParameters parameters = MakeDwarfSamplingParameters();
+  EXPECT_EQ(ComputeRingBufferSizeKb(RingBufferType::kSampling, parameters, 1), 32 * 1024);
+  EXPECT_EQ(ComputeRingBufferSizeKb(RingBufferType::kSampling, parameters, -2), 4 * 1024);
+  EXPECT_EQ(ComputeRingBufferSizeKb(RingBufferType::kMmapTask, parameters, -2),
+            kMinRingBufferSizeKb);
+
+  RingBufferSizingParameters high_rate_parameters = parameters;
+  high_rate_parameters.sampling_period_ns = kOneMsInNs / 64;
+  EXPECT_EQ(ComputeRingBufferSizeKb(RingBufferType::kSampling, high_rate_parameters, 3),
+            kMaxRingBufferSizeKb);
+}
+
+TEST(RingBufferSizeFeedback, GrowsOnLostRecordsAndShrinksWhenMostlyEmpty) {
+  RingBufferSizeFeedback feedback;
+  EXPECT_EQ(feedback.GetSizeLog2Adjustment(RingBufferType::kSampling), 0);
+
+  feedback.Update(RingBufferType::kSampling, /*lost_record_count=*/10, /*max_fill_fraction=*/1.0);
+  EXPECT_EQ(feedback.GetSizeLog2Adjustment(RingBufferType::kSampling), 1);
+
+  // Records weren't lost, but the ring buffers got too full to shrink them.
+  feedback.Update(RingBufferType::kSampling, 0, 0.5);
+  EXPECT_EQ(feedback.GetSizeLog2Adjustment(RingBufferType::kSampling), 1);
+
+  feedback.Update(RingBufferType::kSampling, 0, 0.01);
+  EXPECT_EQ(feedback.GetSizeLog2Adjustment(RingBufferType::kSampling), 0);
+
+  // Other types are not affected.
+  EXPECT_EQ(feedback.GetSizeLog2Adjustment(RingBufferType::kUprobes), 0);
+}
+
+TEST(RingBufferSizeFeedback, AdjustmentIsBounded) {
+  RingBufferSizeFeedback feedback;
+  for (int i = 0; i < 10; ++i) {
+    feedback.Update(RingBufferType::kUprobes, 1, 1.0);
+  }
+  EXPECT_EQ(feedback.GetSizeLog2Adjustment(RingBufferType::kUprobes),
+            RingBufferSizeFeedback::kMaxSizeLog2Adjustment);
+  for (int i = 0; i < 20; ++i) {
+    feedback.Update(RingBufferType::kUprobes, 0, 0.0);
+  }
+  EXPECT_EQ(feedback.GetSizeLog2Adjustment(RingBufferType::kUprobes),
+            RingBufferSizeFeedback::kMinSizeLog2Adjustment);
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,81 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "StackDataPool.h"
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_linux_tracing {
+
+void StackDataDeleter::operator()(uint8_t* data) const {
+  if (data == nullptr) return;
+  if (pool_ == nullptr) {
+    delete[] data;
+    return;
+  }
+  pool_->Recycle(data, size_class_index_);
+}
+
+StackDataPool::~StackDataPool() {
+  absl::MutexLock lock{&mutex_};
+  for (std::vector<uint8_t*>& free_buffers : free_buffers_) {
+    for (uint8_t* buffer : free_buffers) {
+      delete[] buffer;
+    }
+    free_buffers.clear();
+  }
+  cached_bytes_ = 0;
+}
+
+StackDataPtr StackDataPool::Allocate(uint64_t size) {
+  if (size > kMaxSizeClassBytes) {
+    return StackDataPtr{new uint8_t[size]};
+  }
+
+  size_t size_class_index = 0;
+  while (GetSizeClassBytes(size_class_index) < size) {
+    ++size_class_index;
+  }
+  ORBIT_CHECK(size_class_index < kSizeClassCount);
+
+  {
+    absl::MutexLock lock{&mutex_};
+    std::vector<uint8_t*>& free_buffers = free_buffers_[size_class_index];
+    if (!free_buffers.empty()) {
+      uint8_t* buffer = free_buffers.back();
+      free_buffers.pop_back();
+      cached_bytes_ -= GetSizeClassBytes(size_class_index);
+      return StackDataPtr{buffer, StackDataDeleter{this, size_class_index}};
+    }
+  }
+
+  return StackDataPtr{new uint8_t[GetSizeClassBytes(size_class_index)],
+                      StackDataDeleter{this, size_class_index}};
+}
+
+void StackDataPool::Recycle(uint8_t* data, size_t size_class_index) {
+  ORBIT_CHECK(size_class_index < kSizeClassCount);
+  const uint64_t size_class_bytes = GetSizeClassBytes(size_class_index);
+  {
+    absl::MutexLock lock{&mutex_};
+    if (cached_bytes_ + size_class_bytes <= max_cached_bytes_) {
+      free_buffers_[size_class_index].push_back(data);
+      cached_bytes_ += size_class_bytes;
+      return;
+    }
+  }
+  delete[] data;
+}
+
+uint64_t StackDataPool::GetCachedBytes() const {
+  absl::MutexLock lock{&mutex_};
+  return cached_bytes_;
+}
+
+StackDataPool& StackDataPool::GetDefault() {
+  static auto* pool = new StackDataPool();
+  return *pool;
+}
+
+}  // namespace orbit_linux_tracing
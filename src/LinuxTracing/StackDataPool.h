@@ -0,0 +1,93 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_STACK_DATA_POOL_H_
+#define LINUX_TRACING_STACK_DATA_POOL_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace orbit_linux_tracing {
+
+class StackDataPool;
+
+// Deleter of StackDataPtr: returns the buffer to the StackDataPool it was allocated from, or
+// deletes it with delete[] if it doesn't come from a pool.
+class StackDataDeleter {
+ public:
+  StackDataDeleter() = default;
+  // NOLINTNEXTLINE(google-explicit-constructor): Allows converting std::unique_ptr<uint8_t[]>.
+  StackDataDeleter(std::default_delete<uint8_t[]> /*default_delete*/) {}
+
+  void operator()(uint8_t* data) const;
+
+ private:
+  friend class StackDataPool;
+  StackDataDeleter(StackDataPool* pool, size_t size_class_index)
+      : pool_{pool}, size_class_index_{size_class_index} {}
+
+  StackDataPool* pool_ = nullptr;
+  size_t size_class_index_ = 0;
+};
+
+// Owns the copy of the user stack of a sample. A std::unique_ptr<uint8_t[]> converts implicitly to
+// this type, so that buffers allocated with new[] can still be used, e.g., in tests.
+using StackDataPtr = std::unique_ptr<uint8_t[], StackDataDeleter>;
+
+// StackDataPool recycles the buffers into which the user stacks of samples are copied out of the
+// ring buffers. As stack samples are taken at a high rate and are up to kMaxStackSampleUserSize
+// bytes large, this avoids a large amount of calls to malloc and free, which would also happen on
+// different threads (the ring buffer readers and the thread that visits the events).
+// Buffers are grouped in size classes that are powers of two. Buffers larger than the largest size
+// class are not pooled. At most max_cached_bytes of free buffers are kept for later reuse.
+// The pool must outlive the buffers allocated from it.
+class StackDataPool {
+ public:
+  explicit StackDataPool(uint64_t max_cached_bytes = kDefaultMaxCachedBytes)
+      : max_cached_bytes_{max_cached_bytes} {}
+
+  StackDataPool(const StackDataPool&) = delete;
+  StackDataPool& operator=(const StackDataPool&) = delete;
+  StackDataPool(StackDataPool&&) = delete;
+  StackDataPool& operator=(StackDataPool&&) = delete;
+
+  ~StackDataPool();
+
+  // The content of the returned buffer is uninitialized, like with make_unique_for_overwrite.
+  [[nodiscard]] StackDataPtr Allocate(uint64_t size);
+
+  [[nodiscard]] uint64_t GetCachedBytes() const;
+
+  // The pool used for the stack samples read from the ring buffers. It is never destroyed, so that
+  // it outlives all events.
+  [[nodiscard]] static StackDataPool& GetDefault();
+
+  static constexpr uint64_t kMinSizeClassBytes = 4 * 1024;
+  static constexpr size_t kSizeClassCount = 5;
+  static constexpr uint64_t kMaxSizeClassBytes = kMinSizeClassBytes << (kSizeClassCount - 1);
+  static constexpr uint64_t kDefaultMaxCachedBytes = 64 * 1024 * 1024;
+
+ private:
+  friend class StackDataDeleter;
+  void Recycle(uint8_t* data, size_t size_class_index);
+
+  [[nodiscard]] static uint64_t GetSizeClassBytes(size_t size_class_index) {
+    return kMinSizeClassBytes << size_class_index;
+  }
+
+  const uint64_t max_cached_bytes_;
+  mutable absl::Mutex mutex_;
+  std::array<std::vector<uint8_t*>, kSizeClassCount> free_buffers_ ABSL_GUARDED_BY(mutex_);
+  uint64_t cached_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_STACK_DATA_POOL_H_
@@ -0,0 +1,80 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "StackDataPool.h"
+
+namespace orbit_linux_tracing {
+
+TEST(StackDataPool, RecyclesBuffersOfTheSameSizeClass) {
+  StackDataPool pool;
+  uint8_t* first_buffer = nullptr;
+  {
+    StackDataPtr data = pool.Allocate(1000);
+    ASSERT_NE(data, nullptr);
+    std::memset(data.get(), 0xAB, 1000);
+    first_buffer = data.get();
+  }
+  EXPECT_EQ(pool.GetCachedBytes(), StackDataPool::kMinSizeClassBytes);
+
+  StackDataPtr data = pool.Allocate(StackDataPool::kMinSizeClassBytes);
+  EXPECT_EQ(data.get(), first_buffer);
+  EXPECT_EQ(pool.GetCachedBytes(), 0);
+}
+
+TEST(StackDataPool, DoesNotReuseBuffersOfASmallerSizeClass) {
+  StackDataPool pool;
+  uint8_t* small_buffer = nullptr;
+  {
+    StackDataPtr data = pool.Allocate(StackDataPool::kMinSizeClassBytes);
+    small_buffer = data.get();
+  }
+
+  StackDataPtr data = pool.Allocate(StackDataPool::kMinSizeClassBytes + 1);
+  EXPECT_NE(data.get(), small_buffer);
+  std::memset(data.get(), 0, StackDataPool::kMinSizeClassBytes + 1);
+  EXPECT_EQ(pool.GetCachedBytes(), StackDataPool::kMinSizeClassBytes);
+}
+
+TEST(StackDataPool, DoesNotPoolBuffersLargerThanTheLargestSizeClass) {
+  StackDataPool pool;
+  { StackDataPtr data = pool.Allocate(StackDataPool::kMaxSizeClassBytes + 1); }
+  EXPECT_EQ(pool.GetCachedBytes(), 0);
+}
+
+TEST(StackDataPool, RespectsMaxCachedBytes) {
+  StackDataPool pool{StackDataPool::kMinSizeClassBytes};
+  {
+    StackDataPtr first_data = pool.Allocate(1);
+    StackDataPtr second_data = pool.Allocate(1);
+  }
+  EXPECT_EQ(pool.GetCachedBytes(), StackDataPool::kMinSizeClassBytes);
+}
+
+TEST(StackDataPool, AcceptsBuffersAllocatedWithNew) {
+  StackDataPtr data = std::make_unique<uint8_t[]>(16);
+  data[15] = 42;
+  EXPECT_EQ(data[15], 42);
+}
+
+TEST(StackDataPool, BuffersCanBeFreedOnOtherThreads) {
+  StackDataPool pool;
+  constexpr size_t kBufferCount = 100;
+  std::vector<StackDataPtr> buffers;
+  for (size_t i = 0; i < kBufferCount; ++i) {
+    buffers.emplace_back(pool.Allocate(StackDataPool::kMaxSizeClassBytes));
+  }
+  std::thread thread{[&buffers] { buffers.clear(); }};
+  thread.join();
+  EXPECT_EQ(pool.GetCachedBytes(), kBufferCount * StackDataPool::kMaxSizeClassBytes);
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,219 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Microbenchmark replaying a synthetic sched:sched_switch and sched:sched_wakeup trace through
+// ContextSwitchManager and ThreadStateManager, like SwitchesStatesNamesVisitor does. The trace
+// simulates threads migrating between CPUs, going to sleep and being woken up. ContextSwitchManager
+// is compared with the hash map keyed by core it used to be based on.
+
+#include <absl/base/attributes.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_format.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "ContextSwitchManager.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Logging.h"
+#include "ThreadStateManager.h"
+
+namespace {
+
+using orbit_grpc_protos::SchedulingSlice;
+using orbit_grpc_protos::ThreadStateSlice;
+using orbit_linux_tracing::ContextSwitchManager;
+using orbit_linux_tracing::ThreadStateManager;
+
+// The previous implementation of ContextSwitchManager, with the open switches in a hash map keyed
+// by core. The public methods are not inlined, like the ones of ContextSwitchManager, which are
+// in a different translation unit.
+class HashMapContextSwitchManager {
+ public:
+  ABSL_ATTRIBUTE_NOINLINE void ProcessContextSwitchIn(std::optional<pid_t> pid, pid_t tid,
+                                                      uint16_t core, uint64_t timestamp_ns) {
+    open_switches_by_core_.insert_or_assign(core, OpenSwitchIn{pid, tid, timestamp_ns});
+  }
+
+  ABSL_ATTRIBUTE_NOINLINE std::optional<SchedulingSlice> ProcessContextSwitchOut(
+      pid_t pid, pid_t tid, uint16_t core, uint64_t timestamp_ns) {
+    auto open_switch_it = open_switches_by_core_.find(core);
+    if (open_switch_it == open_switches_by_core_.end()) {
+      return std::nullopt;
+    }
+    const OpenSwitchIn open_switch = open_switch_it->second;
+    open_switches_by_core_.erase(open_switch_it);
+    if ((open_switch.pid.has_value() && pid != -1 && open_switch.pid.value() != pid) ||
+        open_switch.tid != tid) {
+      return std::nullopt;
+    }
+    SchedulingSlice scheduling_slice;
+    scheduling_slice.set_pid(pid != -1 ? pid : open_switch.pid.value_or(-1));
+    scheduling_slice.set_tid(tid);
+    scheduling_slice.set_core(core);
+    scheduling_slice.set_duration_ns(timestamp_ns - open_switch.timestamp_ns);
+    scheduling_slice.set_out_timestamp_ns(timestamp_ns);
+    return scheduling_slice;
+  }
+
+ private:
+  struct OpenSwitchIn {
+    std::optional<pid_t> pid;
+    pid_t tid;
+    uint64_t timestamp_ns;
+  };
+
+  absl::flat_hash_map<uint16_t, OpenSwitchIn> open_switches_by_core_;
+};
+
+struct SchedEvent {
+  enum class Type : uint8_t { kSwitch, kWakeup };
+  Type type;
+  uint16_t cpu;
+  // For kSwitch, the thread switched out and the thread switched in. For kWakeup, the thread woken
+  // up and the thread waking it up.
+  pid_t prev_tid;
+  pid_t next_tid;
+  ThreadStateSlice::ThreadState prev_state;
+  uint64_t timestamp_ns;
+};
+
+// Each thread belongs to the process whose pid is the tid rounded down to a multiple of 16.
+[[nodiscard]] pid_t PidOfTid(pid_t tid) { return tid & ~0xF; }
+
+[[nodiscard]] std::vector<SchedEvent> GenerateTrace(uint16_t cpu_count, pid_t tid_count,
+                                                    size_t event_count) {
+  ORBIT_CHECK(tid_count > cpu_count);
+  std::mt19937 random_engine{42};
+  std::uniform_int_distribution<uint16_t> cpu_distribution{0,
+                                                           static_cast<uint16_t>(cpu_count - 1)};
+  std::bernoulli_distribution goes_to_sleep_distribution{0.5};
+  std::bernoulli_distribution wakeup_distribution{0.5};
+
+  std::vector<pid_t> running_tid_by_cpu;
+  std::deque<pid_t> runnable_tids;
+  std::vector<pid_t> sleeping_tids;
+  for (pid_t tid = 1; tid <= tid_count; ++tid) {
+    if (tid <= cpu_count) {
+      running_tid_by_cpu.push_back(tid);
+    } else {
+      runnable_tids.push_back(tid);
+    }
+  }
+
+  std::vector<SchedEvent> events;
+  events.reserve(event_count);
+  uint64_t timestamp_ns = 1;
+  while (events.size() < event_count) {
+    if (runnable_tids.empty() ||
+        (!sleeping_tids.empty() && wakeup_distribution(random_engine))) {
+      std::uniform_int_distribution<size_t> sleeping_index_distribution{0,
+                                                                        sleeping_tids.size() - 1};
+      const size_t sleeping_index = sleeping_index_distribution(random_engine);
+      const pid_t woken_tid = sleeping_tids[sleeping_index];
+      sleeping_tids[sleeping_index] = sleeping_tids.back();
+      sleeping_tids.pop_back();
+      const uint16_t cpu = cpu_distribution(random_engine);
+      events.push_back(SchedEvent{SchedEvent::Type::kWakeup, cpu, woken_tid,
+                                  running_tid_by_cpu[cpu], ThreadStateSlice::kRunnable,
+                                  timestamp_ns++});
+      runnable_tids.push_back(woken_tid);
+      continue;
+    }
+
+    const uint16_t cpu = cpu_distribution(random_engine);
+    const pid_t prev_tid = running_tid_by_cpu[cpu];
+    const pid_t next_tid = runnable_tids.front();
+    runnable_tids.pop_front();
+    ThreadStateSlice::ThreadState prev_state{};
+    if (goes_to_sleep_distribution(random_engine)) {
+      prev_state = ThreadStateSlice::kInterruptibleSleep;
+      sleeping_tids.push_back(prev_tid);
+    } else {
+      prev_state = ThreadStateSlice::kRunnable;
+      runnable_tids.push_back(prev_tid);
+    }
+    events.push_back(
+        SchedEvent{SchedEvent::Type::kSwitch, cpu, prev_tid, next_tid, prev_state, timestamp_ns++});
+    running_tid_by_cpu[cpu] = next_tid;
+  }
+  return events;
+}
+
+// Returns the average time per event, in nanoseconds, to process all context switches.
+template <typename ContextSwitchManagerT>
+[[nodiscard]] double RunContextSwitchBenchmark(const std::vector<SchedEvent>& events) {
+  ContextSwitchManagerT manager;
+  uint64_t slice_count = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (const SchedEvent& event : events) {
+    if (event.type != SchedEvent::Type::kSwitch) continue;
+    if (manager
+            .ProcessContextSwitchOut(PidOfTid(event.prev_tid), event.prev_tid, event.cpu,
+                                     event.timestamp_ns)
+            .has_value()) {
+      ++slice_count;
+    }
+    manager.ProcessContextSwitchIn(PidOfTid(event.next_tid), event.next_tid, event.cpu,
+                                   event.timestamp_ns);
+  }
+  const auto end = std::chrono::steady_clock::now();
+  ORBIT_CHECK(slice_count > 0);
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         static_cast<double>(events.size());
+}
+
+// Returns the average time per event, in nanoseconds, to process all context switches and wakeups.
+[[nodiscard]] double RunThreadStateBenchmark(const std::vector<SchedEvent>& events,
+                                             pid_t tid_count) {
+  ThreadStateManager manager;
+  for (pid_t tid = 1; tid <= tid_count; ++tid) {
+    manager.OnInitialState(0, tid, ThreadStateSlice::kRunnable);
+  }
+  uint64_t slice_count = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (const SchedEvent& event : events) {
+    if (event.type == SchedEvent::Type::kWakeup) {
+      slice_count += manager
+                         .OnSchedWakeup(event.timestamp_ns, event.prev_tid, event.next_tid,
+                                        PidOfTid(event.next_tid))
+                         .has_value();
+      continue;
+    }
+    slice_count +=
+        manager.OnSchedSwitchOut(event.timestamp_ns, event.prev_tid, event.prev_state).has_value();
+    slice_count += manager.OnSchedSwitchIn(event.timestamp_ns, event.next_tid).has_value();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  ORBIT_CHECK(slice_count > 0);
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         static_cast<double>(events.size());
+}
+
+}  // namespace
+
+int main() {
+  constexpr size_t kEventCount = 2'000'000;
+  absl::PrintF("%6s %8s %24s %28s %28s\n", "cpus", "threads", "hash map [ns/event]",
+               "ContextSwitchManager [ns/event]", "ThreadStateManager [ns/event]");
+  for (uint16_t cpu_count : {8, 64, 256}) {
+    for (pid_t tid_count : {512, 16384}) {
+      const std::vector<SchedEvent> events = GenerateTrace(cpu_count, tid_count, kEventCount);
+      const double hash_map_ns = RunContextSwitchBenchmark<HashMapContextSwitchManager>(events);
+      const double context_switch_manager_ns =
+          RunContextSwitchBenchmark<ContextSwitchManager>(events);
+      const double thread_state_manager_ns = RunThreadStateBenchmark(events, tid_count);
+      absl::PrintF("%6u %8d %24.1f %28.1f %28.1f\n", cpu_count, tid_count, hash_map_ns,
+                   context_switch_manager_ns, thread_state_manager_ns);
+    }
+  }
+  return 0;
+}
@@ -147,11 +147,10 @@ void SwitchesStatesNamesVisitor::VisitSchedSwitch(uint64_t event_timestamp,
     std::optional<ThreadStateSlice> out_slice = state_manager_.OnSchedSwitchOut(
         event_timestamp, event_data.prev_tid, new_state, has_switch_out_callstack);
     if (out_slice.has_value()) {
-      listener_->OnThreadStateSlice(std::move(out_slice.value()));
-      if (thread_state_counter_ != nullptr) {
-        ++(*thread_state_counter_);
-      }
+      SendThreadStateSlice(std::move(out_slice.value()));
     }
+  } else if (has_switch_out_callstack) {
+    DiscardCallstack(event_data.prev_tid, event_timestamp);
   }
 
   // Process the context switch in for thread state.
@@ -159,10 +158,7 @@ void SwitchesStatesNamesVisitor::VisitSchedSwitch(uint64_t event_timestamp,
     std::optional<ThreadStateSlice> in_slice =
         state_manager_.OnSchedSwitchIn(event_timestamp, event_data.next_tid);
     if (in_slice.has_value()) {
-      listener_->OnThreadStateSlice(std::move(in_slice.value()));
-      if (thread_state_counter_ != nullptr) {
-        ++(*thread_state_counter_);
-      }
+      SendThreadStateSlice(std::move(in_slice.value()));
     }
   }
 }
@@ -187,6 +183,7 @@ void SwitchesStatesNamesVisitor::VisitSchedWakeup(uint64_t event_timestamp,
                                                   const SchedWakeupPerfEventDataT& event_data,
                                                   bool has_wakeup_callstack) {
   if (!TidMatchesPidFilter(event_data.woken_tid)) {
+    if (has_wakeup_callstack) DiscardCallstack(event_data.woken_tid, event_timestamp);
     return;
   }
 
@@ -194,10 +191,7 @@ void SwitchesStatesNamesVisitor::VisitSchedWakeup(uint64_t event_timestamp,
       event_timestamp, event_data.woken_tid, event_data.was_unblocked_by_tid,
       event_data.was_unblocked_by_pid, has_wakeup_callstack);
   if (state_slice.has_value()) {
-    listener_->OnThreadStateSlice(std::move(state_slice.value()));
-    if (thread_state_counter_ != nullptr) {
-      ++(*thread_state_counter_);
-    }
+    SendThreadStateSlice(std::move(state_slice.value()));
   }
 }
 
@@ -219,10 +213,26 @@ void SwitchesStatesNamesVisitor::Visit(uint64_t event_timestamp,
 void SwitchesStatesNamesVisitor::ProcessRemainingOpenStates(uint64_t timestamp_ns) {
   std::vector<ThreadStateSlice> state_slices = state_manager_.OnCaptureFinished(timestamp_ns);
   for (ThreadStateSlice& slice : state_slices) {
-    listener_->OnThreadStateSlice(slice);
-    if (thread_state_counter_ != nullptr) {
-      ++(*thread_state_counter_);
-    }
+    SendThreadStateSlice(std::move(slice));
+  }
+}
+
+void SwitchesStatesNamesVisitor::SendThreadStateSlice(ThreadStateSlice slice) {
+  if (callstack_resolver_ != nullptr) {
+    callstack_resolver_->ResolveThreadStateSliceCallstack(
+        slice.tid(), slice.end_timestamp_ns() - slice.duration_ns(),
+        slice.switch_out_or_wakeup_callstack_status() == ThreadStateSlice::kWaitingForCallstack);
+  }
+  listener_->OnThreadStateSlice(std::move(slice));
+  if (thread_state_counter_ != nullptr) {
+    ++(*thread_state_counter_);
+  }
+}
+
+void SwitchesStatesNamesVisitor::DiscardCallstack(pid_t tid, uint64_t timestamp_ns) {
+  if (callstack_resolver_ != nullptr) {
+    callstack_resolver_->ResolveThreadStateSliceCallstack(tid, timestamp_ns,
+                                                          /*keep_callstack=*/false);
   }
 }
 
@@ -25,6 +25,7 @@
 #include "PerfEvent.h"
 #include "PerfEventVisitor.h"
 #include "ThreadStateManager.h"
+#include "ThreadStateSliceCallstackResolver.h"
 
 namespace orbit_linux_tracing {
 
@@ -57,6 +58,17 @@ class SwitchesStatesNamesVisitor : public PerfEventVisitor {
     thread_state_pid_filters_ = std::move(pids);
   }
 
+  // See ThreadStateManager::SetMinOffCpuDurationForCallstacksNs.
+  void SetMinOffCpuDurationForCallstacksNs(uint64_t min_off_cpu_duration_ns) {
+    state_manager_.SetMinOffCpuDurationForCallstacksNs(min_off_cpu_duration_ns);
+  }
+  // When set, `callstack_resolver` is told, for each slice and for each switch out or wakeup of a
+  // thread whose thread states are not collected, whether the callstack is needed.
+  void SetThreadStateSliceCallstackResolver(
+      ThreadStateSliceCallstackResolver* callstack_resolver) {
+    callstack_resolver_ = callstack_resolver;
+  }
+
   void ProcessInitialTidToPidAssociation(pid_t tid, pid_t pid);
   void Visit(uint64_t event_timestamp, const ForkPerfEventData& event_data) override;
   void Visit(uint64_t event_timestamp, const ExitPerfEventData& event_data) override;
@@ -85,8 +97,12 @@ class SwitchesStatesNamesVisitor : public PerfEventVisitor {
   void VisitSchedWakeup(uint64_t timestamp, const SchedWakeupPerfEventDataT& event_data,
                         bool has_wakeup_callstack);
 
+  void SendThreadStateSlice(orbit_grpc_protos::ThreadStateSlice slice);
+  void DiscardCallstack(pid_t tid, uint64_t timestamp_ns);
+
   TracerListener* listener_;
   std::atomic<uint64_t>* thread_state_counter_ = nullptr;
+  ThreadStateSliceCallstackResolver* callstack_resolver_ = nullptr;
 
   bool produce_scheduling_slices_ = false;
 
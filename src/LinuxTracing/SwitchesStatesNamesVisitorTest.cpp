@@ -21,6 +21,7 @@
 #include "OrbitBase/MakeUniqueForOverwrite.h"
 #include "PerfEvent.h"
 #include "SwitchesStatesNamesVisitor.h"
+#include "ThreadStateSliceCallstackResolver.h"
 
 using ::testing::SaveArg;
 
@@ -646,4 +647,74 @@ TEST_F(SwitchesStatesNamesVisitorTest, VariousThreadStateSlicesOnOneThreadWaitin
               ThreadStateSlice::kWaitingForCallstack))));
 }
 
+namespace {
+class MockThreadStateSliceCallstackResolver : public ThreadStateSliceCallstackResolver {
+ public:
+  MOCK_METHOD(void, ResolveThreadStateSliceCallstack,
+              (pid_t tid, uint64_t begin_timestamp_ns, bool keep_callstack), (override));
+};
+}  // namespace
+
+TEST_F(SwitchesStatesNamesVisitorTest,
+       MinOffCpuDurationForCallstacksKeepsCallstacksOfLongOffCpuIntervalsAndResolvesThem) {
+  MockThreadStateSliceCallstackResolver mock_resolver;
+  visitor_.SetThreadStatePidFilters({kPid1});
+  visitor_.SetMinOffCpuDurationForCallstacksNs(kWakeTimestampNs2 - kOutTimestampNs1);
+  visitor_.SetThreadStateSliceCallstackResolver(&mock_resolver);
+
+  visitor_.ProcessInitialTidToPidAssociation(kTid1, kPid1);
+  visitor_.ProcessInitialTidToPidAssociation(kTid2, kPid2);
+
+  std::vector<ThreadStateSlice> actual_thread_state_slices;
+  const auto save_thread_state_slice_arg = [&](ThreadStateSlice actual_thread_state_slice) {
+    actual_thread_state_slices.emplace_back(std::move(actual_thread_state_slice));
+  };
+  EXPECT_CALL(mock_listener_, OnThreadStateSlice)
+      .Times(4)
+      .WillRepeatedly(save_thread_state_slice_arg);
+  {
+    ::testing::InSequence in_sequence;
+    // kTid2 is not of an interesting process, so its callstack is dropped right away.
+    EXPECT_CALL(mock_resolver, ResolveThreadStateSliceCallstack(kTid2, kWakeTimestampNs1, false));
+    EXPECT_CALL(mock_resolver, ResolveThreadStateSliceCallstack(kTid1, kStartTimestampNs, false));
+    EXPECT_CALL(mock_resolver, ResolveThreadStateSliceCallstack(kTid1, kInTimestampNs1, false));
+    EXPECT_CALL(mock_resolver, ResolveThreadStateSliceCallstack(kTid1, kOutTimestampNs1, true));
+    // The runnable interval is still ongoing at the end of the capture.
+    EXPECT_CALL(mock_resolver, ResolveThreadStateSliceCallstack(kTid1, kWakeTimestampNs2, false));
+  }
+
+  visitor_.ProcessInitialState(kStartTimestampNs, kTid1, 'R');
+  PerfEvent{MakeFakeSchedSwitchWithStackPerfEvent(kCpu2, kPid2, kTid2, kInterruptibleSleepStateMask,
+                                                  kNextTid, kWakeTimestampNs1)}
+      .Accept(&visitor_);
+  PerfEvent{MakeFakeSchedSwitchPerfEvent(kCpu1, kPrevTid, kPrevTid, kRunnableStateMask, kTid1,
+                                         kInTimestampNs1)}
+      .Accept(&visitor_);
+  PerfEvent{MakeFakeSchedSwitchWithStackPerfEvent(kCpu1, kPid1, kTid1, kInterruptibleSleepStateMask,
+                                                  kNextTid, kOutTimestampNs1)}
+      .Accept(&visitor_);
+  PerfEvent{MakeFakeSchedWakeupWithStackPerfEvent(kTid1, kTid3, kPid1, kWakeTimestampNs2)}.Accept(
+      &visitor_);
+
+  visitor_.ProcessRemainingOpenStates(kStopTimestampNs);
+
+  EXPECT_THAT(
+      actual_thread_state_slices,
+      ::testing::ElementsAre(
+          ThreadStateSliceEq(MakeThreadStateSlice(kTid1, ThreadStateSlice::kRunnable,
+                                                  kInTimestampNs1 - kStartTimestampNs,
+                                                  kInTimestampNs1)),
+          ThreadStateSliceEq(MakeThreadStateSlice(kTid1, ThreadStateSlice::kRunning,
+                                                  kOutTimestampNs1 - kInTimestampNs1,
+                                                  kOutTimestampNs1)),
+          ThreadStateSliceEq(MakeThreadStateSlice(
+              kTid1, ThreadStateSlice::kInterruptibleSleep, kWakeTimestampNs2 - kOutTimestampNs1,
+              kWakeTimestampNs2, ThreadStateSlice::kNotApplicable, 0, 0,
+              ThreadStateSlice::kWaitingForCallstack)),
+          ThreadStateSliceEq(MakeThreadStateSlice(
+              kTid1, ThreadStateSlice::kRunnable, kStopTimestampNs - kWakeTimestampNs2,
+              kStopTimestampNs, ThreadStateSlice::kUnblocked, kTid3, kPid1,
+              ThreadStateSlice::kNoCallstack))));
+}
+
 }  // namespace orbit_linux_tracing
@@ -27,25 +27,55 @@ using orbit_grpc_protos::ThreadStateSlice;
 // all these cases, we discard the previous known state (the one retrieved at the beginning, with a
 // larger timestamp) and replace it with the thread state carried by the tracepoint.
 
+ThreadStateSlice ThreadStateManager::CreateSlice(pid_t tid, const OpenState& open_state,
+                                                 uint64_t timestamp_ns) const {
+  ThreadStateSlice slice;
+  slice.set_tid(tid);
+  slice.set_thread_state(open_state.state());
+  slice.set_duration_ns(timestamp_ns - open_state.begin_timestamp_ns);
+  slice.set_end_timestamp_ns(timestamp_ns);
+  slice.set_wakeup_reason(open_state.wakeup_reason());
+  slice.set_wakeup_tid(open_state.wakeup_tid);
+  slice.set_wakeup_pid(open_state.wakeup_pid);
+  bool has_callstack = open_state.has_wakeup_or_switch_out_callstack;
+  // A slice with the callstack of a switch out is the off-CPU interval started by that switch out.
+  // The callstack of a wakeup was already filtered on the interval it ended, in OnSchedWakeup.
+  if (has_callstack && min_off_cpu_duration_for_callstacks_ns_ > 0 &&
+      open_state.wakeup_reason() == ThreadStateSlice::kNotApplicable) {
+    has_callstack = slice.duration_ns() >= min_off_cpu_duration_for_callstacks_ns_;
+  }
+  if (has_callstack) {
+    slice.set_switch_out_or_wakeup_callstack_status(
+        orbit_grpc_protos::ThreadStateSlice::kWaitingForCallstack);
+  } else {
+    slice.set_switch_out_or_wakeup_callstack_status(
+        orbit_grpc_protos::ThreadStateSlice::kNoCallstack);
+  }
+  return slice;
+}
+
 void ThreadStateManager::OnInitialState(uint64_t timestamp_ns, pid_t tid,
                                         ThreadStateSlice::ThreadState state) {
-  ORBIT_CHECK(!tid_open_states_.contains(tid));
-  tid_open_states_.emplace(tid, OpenState{state, timestamp_ns});
+  const bool inserted = tid_open_states_.try_emplace(tid, state, timestamp_ns).second;
+  ORBIT_CHECK(inserted);
 }
 
 void ThreadStateManager::OnNewTask(uint64_t timestamp_ns, pid_t tid, pid_t was_created_by_tid,
                                    pid_t was_created_by_pid) {
   static constexpr ThreadStateSlice::ThreadState kNewState = ThreadStateSlice::kRunnable;
 
-  if (auto open_state_it = tid_open_states_.find(tid);
-      open_state_it != tid_open_states_.end() &&
-      timestamp_ns >= open_state_it->second.begin_timestamp_ns) {
+  const OpenState new_open_state{kNewState, timestamp_ns,
+                                 orbit_grpc_protos::ThreadStateSlice::kCreated, was_created_by_tid,
+                                 was_created_by_pid};
+  auto [open_state_it, inserted] = tid_open_states_.try_emplace(tid, new_open_state);
+  if (inserted) {
+    return;
+  }
+  if (timestamp_ns >= open_state_it->second.begin_timestamp_ns) {
     ORBIT_ERROR("Processed task:task_newtask but thread %d was already known", tid);
     return;
   }
-  tid_open_states_.insert_or_assign(
-      tid, OpenState{kNewState, timestamp_ns, orbit_grpc_protos::ThreadStateSlice::kCreated,
-                     was_created_by_tid, was_created_by_pid});
+  open_state_it->second = new_open_state;
 }
 
 std::optional<ThreadStateSlice> ThreadStateManager::OnSchedWakeup(uint64_t timestamp_ns, pid_t tid,
@@ -54,54 +84,50 @@ std::optional<ThreadStateSlice> ThreadStateManager::OnSchedWakeup(uint64_t times
                                                                   bool has_wakeup_callstack) {
   static constexpr ThreadStateSlice::ThreadState kNewState = ThreadStateSlice::kRunnable;
 
-  auto open_state_it = tid_open_states_.find(tid);
-  if (open_state_it == tid_open_states_.end()) {
+  const OpenState new_open_state{kNewState,
+                                 timestamp_ns,
+                                 orbit_grpc_protos::ThreadStateSlice::kUnblocked,
+                                 was_unblocked_by_tid,
+                                 was_unblocked_by_pid,
+                                 has_wakeup_callstack};
+  // Without knowing how long the thread was off-CPU, its wakeup callstack can't be kept.
+  auto drop_wakeup_callstack_if_filtering = [this](OpenState* open_state) {
+    if (min_off_cpu_duration_for_callstacks_ns_ > 0) {
+      open_state->has_wakeup_or_switch_out_callstack = false;
+    }
+  };
+  auto [open_state_it, inserted] = tid_open_states_.try_emplace(tid, new_open_state);
+  if (inserted) {
     ORBIT_ERROR("Processed sched:sched_wakeup but previous state of thread %d is unknown", tid);
-    tid_open_states_.insert_or_assign(
-        tid, OpenState{kNewState, timestamp_ns, orbit_grpc_protos::ThreadStateSlice::kUnblocked,
-                       was_unblocked_by_tid, was_unblocked_by_pid, has_wakeup_callstack});
+    drop_wakeup_callstack_if_filtering(&open_state_it->second);
     return std::nullopt;
   }
 
-  const OpenState& open_state = open_state_it->second;
+  OpenState& open_state = open_state_it->second;
   if (timestamp_ns < open_state.begin_timestamp_ns) {
     // As noted above, overwrite the thread state retrieved at the beginning.
-    tid_open_states_.insert_or_assign(
-        tid, OpenState{kNewState, timestamp_ns, orbit_grpc_protos::ThreadStateSlice::kUnblocked,
-                       was_unblocked_by_tid, was_unblocked_by_pid, has_wakeup_callstack});
+    open_state = new_open_state;
+    drop_wakeup_callstack_if_filtering(&open_state);
     return std::nullopt;
   }
 
-  if (open_state.state == kNewState || open_state.state == ThreadStateSlice::kRunning) {
+  if (open_state.state() == kNewState || open_state.state() == ThreadStateSlice::kRunning) {
     // It seems to be somewhat common for a thread to receive a wakeup
     // while already in runnable or running state: disregard the state change.
     return std::nullopt;
   }
 
-  if (open_state.state == ThreadStateSlice::kZombie ||
-      open_state.state == ThreadStateSlice::kDead) {
+  if (open_state.state() == ThreadStateSlice::kZombie ||
+      open_state.state() == ThreadStateSlice::kDead) {
     ORBIT_ERROR("Processed sched:sched_wakeup for thread %d but unexpected previous state %s", tid,
-                ThreadStateSlice::ThreadState_Name(open_state.state));
+                ThreadStateSlice::ThreadState_Name(open_state.state()));
   }
 
-  ThreadStateSlice slice;
-  slice.set_tid(tid);
-  slice.set_thread_state(open_state.state);
-  slice.set_duration_ns(timestamp_ns - open_state.begin_timestamp_ns);
-  slice.set_end_timestamp_ns(timestamp_ns);
-  slice.set_wakeup_reason(open_state.wakeup_reason);
-  slice.set_wakeup_tid(open_state.wakeup_tid);
-  slice.set_wakeup_pid(open_state.wakeup_pid);
-  if (open_state.has_wakeup_or_switch_out_callstack) {
-    slice.set_switch_out_or_wakeup_callstack_status(
-        orbit_grpc_protos::ThreadStateSlice::kWaitingForCallstack);
-  } else {
-    slice.set_switch_out_or_wakeup_callstack_status(
-        orbit_grpc_protos::ThreadStateSlice::kNoCallstack);
+  ThreadStateSlice slice = CreateSlice(tid, open_state, timestamp_ns);
+  open_state = new_open_state;
+  if (slice.duration_ns() < min_off_cpu_duration_for_callstacks_ns_) {
+    open_state.has_wakeup_or_switch_out_callstack = false;
   }
-  tid_open_states_.insert_or_assign(
-      tid, OpenState{kNewState, timestamp_ns, orbit_grpc_protos::ThreadStateSlice::kUnblocked,
-                     was_unblocked_by_tid, was_unblocked_by_pid, has_wakeup_callstack});
   return slice;
 }
 
@@ -109,70 +135,54 @@ std::optional<ThreadStateSlice> ThreadStateManager::OnSchedSwitchIn(uint64_t tim
                                                                     pid_t tid) {
   static constexpr ThreadStateSlice::ThreadState kNewState = ThreadStateSlice::kRunning;
 
-  auto open_state_it = tid_open_states_.find(tid);
-  if (open_state_it == tid_open_states_.end()) {
+  const OpenState new_open_state{kNewState, timestamp_ns};
+  auto [open_state_it, inserted] = tid_open_states_.try_emplace(tid, new_open_state);
+  if (inserted) {
     ORBIT_ERROR("Processed sched:sched_switch(in) but previous state of thread %d is unknown", tid);
-    tid_open_states_.insert_or_assign(tid, OpenState{kNewState, timestamp_ns});
     return std::nullopt;
   }
 
-  const OpenState& open_state = open_state_it->second;
+  OpenState& open_state = open_state_it->second;
   if (timestamp_ns < open_state.begin_timestamp_ns) {
-    tid_open_states_.insert_or_assign(tid, OpenState{kNewState, timestamp_ns});
+    open_state = new_open_state;
     return std::nullopt;
   }
 
-  if (open_state.state == kNewState) {
+  if (open_state.state() == kNewState) {
     // No state change: do nothing and don't overwrite the previous begin timestamp.
     return std::nullopt;
   }
 
-  // Don't print an error even if open_state.state != ThreadStateSlice::kRunnable: it seems to be
-  // sometimes possible for a thread to go from a non-runnable state directly to running, skipping
-  // the sched:sched_wakeup event.
+  // Don't print an error even if open_state.state() != ThreadStateSlice::kRunnable: it seems to
+  // be sometimes possible for a thread to go from a non-runnable state directly to running,
+  // skipping the sched:sched_wakeup event.
 
-  ThreadStateSlice slice;
-  slice.set_tid(tid);
-  slice.set_thread_state(open_state.state);
-  slice.set_duration_ns(timestamp_ns - open_state.begin_timestamp_ns);
-  slice.set_end_timestamp_ns(timestamp_ns);
-  slice.set_wakeup_reason(open_state.wakeup_reason);
-  slice.set_wakeup_tid(open_state.wakeup_tid);
-  slice.set_wakeup_pid(open_state.wakeup_pid);
-  if (open_state.has_wakeup_or_switch_out_callstack) {
-    slice.set_switch_out_or_wakeup_callstack_status(
-        orbit_grpc_protos::ThreadStateSlice::kWaitingForCallstack);
-  } else {
-    slice.set_switch_out_or_wakeup_callstack_status(
-        orbit_grpc_protos::ThreadStateSlice::kNoCallstack);
-  }
-  tid_open_states_.insert_or_assign(tid, OpenState{kNewState, timestamp_ns});
+  ThreadStateSlice slice = CreateSlice(tid, open_state, timestamp_ns);
+  open_state = new_open_state;
   return slice;
 }
 
 std::optional<ThreadStateSlice> ThreadStateManager::OnSchedSwitchOut(
     uint64_t timestamp_ns, pid_t tid, ThreadStateSlice::ThreadState new_state,
     bool has_switch_out_callstack) {
-  auto open_state_it = tid_open_states_.find(tid);
-  if (open_state_it == tid_open_states_.end()) {
+  const OpenState new_open_state{new_state, timestamp_ns, has_switch_out_callstack};
+  auto [open_state_it, inserted] = tid_open_states_.try_emplace(tid, new_open_state);
+  if (inserted) {
     ORBIT_ERROR("Processed sched:sched_switch(out) but previous state of thread %d is unknown",
                 tid);
-    tid_open_states_.insert_or_assign(tid,
-                                      OpenState{new_state, timestamp_ns, has_switch_out_callstack});
     return std::nullopt;
   }
 
-  const OpenState& open_state = open_state_it->second;
+  OpenState& open_state = open_state_it->second;
   if (timestamp_ns < open_state.begin_timestamp_ns) {
-    tid_open_states_.insert_or_assign(tid,
-                                      OpenState{new_state, timestamp_ns, has_switch_out_callstack});
+    open_state = new_open_state;
     return std::nullopt;
   }
 
   // As we are switching out of a CPU, if the previous state was kRunnable, assume it was kRunning.
   // This is because when we retrieve the initial thread states we have no way to distinguish
   // between kRunnable and kRunning. After all, for the OS they are the same state.
-  ThreadStateSlice::ThreadState adjusted_open_state_state = open_state.state;
+  ThreadStateSlice::ThreadState adjusted_open_state_state = open_state.state();
   if (adjusted_open_state_state == ThreadStateSlice::kRunnable) {
     adjusted_open_state_state = ThreadStateSlice::kRunning;
   }
@@ -191,36 +201,25 @@ std::optional<ThreadStateSlice> ThreadStateManager::OnSchedSwitchOut(
   slice.set_thread_state(adjusted_open_state_state);
   slice.set_duration_ns(timestamp_ns - open_state.begin_timestamp_ns);
   slice.set_end_timestamp_ns(timestamp_ns);
-  slice.set_wakeup_reason(open_state.wakeup_reason);
+  slice.set_wakeup_reason(open_state.wakeup_reason());
   slice.set_wakeup_tid(open_state.wakeup_tid);
   slice.set_wakeup_pid(open_state.wakeup_pid);
 
   // Note: If the thread exits but the new_state is kZombie instead of kDead,
   // the switch to kDead will never be reported.
-  tid_open_states_.insert_or_assign(tid,
-                                    OpenState{new_state, timestamp_ns, has_switch_out_callstack});
+  open_state = new_open_state;
   return slice;
 }
 
 std::vector<ThreadStateSlice> ThreadStateManager::OnCaptureFinished(uint64_t timestamp_ns) {
   std::vector<ThreadStateSlice> slices;
   for (const auto& [tid, open_state] : tid_open_states_) {
-    ThreadStateSlice slice;
-    slice.set_tid(tid);
-    slice.set_thread_state(open_state.state);
-    slice.set_duration_ns(timestamp_ns - open_state.begin_timestamp_ns);
-    slice.set_end_timestamp_ns(timestamp_ns);
-    slice.set_wakeup_reason(open_state.wakeup_reason);
-    slice.set_wakeup_tid(open_state.wakeup_tid);
-    slice.set_wakeup_pid(open_state.wakeup_pid);
-    if (open_state.has_wakeup_or_switch_out_callstack) {
-      slice.set_switch_out_or_wakeup_callstack_status(
-          orbit_grpc_protos::ThreadStateSlice::kWaitingForCallstack);
-    } else {
-      slice.set_switch_out_or_wakeup_callstack_status(
-          orbit_grpc_protos::ThreadStateSlice::kNoCallstack);
+    ThreadStateSlice& slice = slices.emplace_back(CreateSlice(tid, open_state, timestamp_ns));
+    // When filtering, callstacks are only unwound once their interval is known to be long enough,
+    // which is no longer possible once the capture has finished.
+    if (min_off_cpu_duration_for_callstacks_ns_ > 0) {
+      slice.set_switch_out_or_wakeup_callstack_status(ThreadStateSlice::kNoCallstack);
     }
-    slices.emplace_back(std::move(slice));
   }
   return slices;
 }
@@ -47,6 +47,13 @@ namespace orbit_linux_tracing {
 
 class ThreadStateManager {
  public:
+  // If not 0, the callstacks of thread state changes are only kept around off-CPU intervals lasting
+  // at least `min_off_cpu_duration_ns`, see CaptureOptions in capture.proto. The decision is taken
+  // when the interval ends, and slices whose callstack was dropped have kNoCallstack.
+  void SetMinOffCpuDurationForCallstacksNs(uint64_t min_off_cpu_duration_ns) {
+    min_off_cpu_duration_for_callstacks_ns_ = min_off_cpu_duration_ns;
+  }
+
   void OnInitialState(uint64_t timestamp_ns, pid_t tid,
                       orbit_grpc_protos::ThreadStateSlice::ThreadState state);
   void OnNewTask(uint64_t timestamp_ns, pid_t tid, pid_t was_created_by_tid,
@@ -63,34 +70,45 @@ class ThreadStateManager {
       uint64_t timestamp_ns);
 
  private:
+  // OpenState is kept compact, as there is one for each thread of the system and it is accessed on
+  // every context switch: the two enums are stored in one byte each and the fields are ordered to
+  // avoid padding.
   struct OpenState {
     OpenState(orbit_grpc_protos::ThreadStateSlice::ThreadState state, uint64_t begin_timestamp_ns,
               bool has_wakeup_or_switch_out_callstack = false)
-        : state{state},
-          begin_timestamp_ns{begin_timestamp_ns},
-          wakeup_reason{orbit_grpc_protos::ThreadStateSlice::kNotApplicable},
-          wakeup_tid{0},
-          wakeup_pid{0},
-          has_wakeup_or_switch_out_callstack{has_wakeup_or_switch_out_callstack} {}
+        : OpenState{state,
+                    begin_timestamp_ns,
+                    orbit_grpc_protos::ThreadStateSlice::kNotApplicable,
+                    /*wakeup_tid=*/0,
+                    /*wakeup_pid=*/0,
+                    has_wakeup_or_switch_out_callstack} {}
     OpenState(orbit_grpc_protos::ThreadStateSlice::ThreadState state, uint64_t begin_timestamp_ns,
               orbit_grpc_protos::ThreadStateSlice::WakeupReason wakeup_reason, pid_t wakeup_tid,
               pid_t wakeup_pid, bool has_wakeup_or_switch_out_callstack = false)
-        : state{state},
-          begin_timestamp_ns{begin_timestamp_ns},
-          wakeup_reason{wakeup_reason},
+        : begin_timestamp_ns{begin_timestamp_ns},
           wakeup_tid{wakeup_tid},
           wakeup_pid{wakeup_pid},
+          state_value{static_cast<uint8_t>(state)},
+          wakeup_reason_value{static_cast<uint8_t>(wakeup_reason)},
           has_wakeup_or_switch_out_callstack{has_wakeup_or_switch_out_callstack} {}
-    orbit_grpc_protos::ThreadStateSlice::ThreadState state;
+
+    [[nodiscard]] orbit_grpc_protos::ThreadStateSlice::ThreadState state() const {
+      return static_cast<orbit_grpc_protos::ThreadStateSlice::ThreadState>(state_value);
+    }
+    // This explains the relation between this thread and the thread that woke it up (identified by
+    // wakeup_tid and wakeup_pid below).
+    [[nodiscard]] orbit_grpc_protos::ThreadStateSlice::WakeupReason wakeup_reason() const {
+      return static_cast<orbit_grpc_protos::ThreadStateSlice::WakeupReason>(wakeup_reason_value);
+    }
+
     uint64_t begin_timestamp_ns;
-    // The following field explains the relation between this thread and the thread that woke it up
-    // (identified by wakeup_tid and wakeup_pid below).
-    orbit_grpc_protos::ThreadStateSlice::WakeupReason wakeup_reason;
-    // The next two fields are optional, and only meaningful when wakeup_reason != kNotApplicable.
+    // The next two fields are optional, and only meaningful when wakeup_reason() != kNotApplicable.
     // We use them to indicate which tid and pid caused the thread to transition from a non-runnable
     // to the runnable state.
     pid_t wakeup_tid;
     pid_t wakeup_pid;
+    uint8_t state_value;
+    uint8_t wakeup_reason_value;
     // We allow the user to collect callstacks on sched_wakeup and sched_switch out events. This
     // field indicates if there was a callstack collected together with this open state. The
     // callstack itself gets processed in the UprobesUnwindingVisitor, but this field indicates
@@ -98,7 +116,13 @@ class ThreadStateManager {
     bool has_wakeup_or_switch_out_callstack;
   };
 
+  // Fills in the fields of a ThreadStateSlice ending at timestamp_ns that come from open_state.
+  [[nodiscard]] orbit_grpc_protos::ThreadStateSlice CreateSlice(pid_t tid,
+                                                                const OpenState& open_state,
+                                                                uint64_t timestamp_ns) const;
+
   absl::flat_hash_map<pid_t, OpenState> tid_open_states_;
+  uint64_t min_off_cpu_duration_for_callstacks_ns_ = 0;
 };
 
 }  // namespace orbit_linux_tracing
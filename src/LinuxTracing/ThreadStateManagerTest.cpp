@@ -590,4 +590,83 @@ TEST(ThreadStateManager, SwitchOutAndWakeupWaitForCallstacks) {
   EXPECT_EQ(slice->switch_out_or_wakeup_callstack_id(), kSwitchOutOrWakeupCallstackIdNotApplicable);
 }
 
+TEST(ThreadStateManager, MinOffCpuDurationForCallstacksKeepsCallstacksOfLongOffCpuIntervals) {
+  constexpr pid_t kTid = 42;
+  constexpr pid_t kWasUnblockedByTid = 420;
+  constexpr pid_t kWasUnblockedByPid = 4200;
+  ThreadStateManager manager;
+  manager.SetMinOffCpuDurationForCallstacksNs(100);
+  std::optional<ThreadStateSlice> slice;
+
+  manager.OnInitialState(100, kTid, ThreadStateSlice::kRunning);
+
+  // Short blocked interval: neither the switch out nor the wakeup keep their callstack.
+  slice = manager.OnSchedSwitchOut(200, kTid, ThreadStateSlice::kInterruptibleSleep,
+                                   /*has_wakeup_or_switch_out_callstack*/ true);
+  ASSERT_TRUE(slice.has_value());
+
+  slice = manager.OnSchedWakeup(250, kTid, kWasUnblockedByTid, kWasUnblockedByPid,
+                                /*has_wakeup_or_switch_out_callstack*/ true);
+  ASSERT_TRUE(slice.has_value());
+  EXPECT_EQ(slice->thread_state(), ThreadStateSlice::kInterruptibleSleep);
+  EXPECT_EQ(slice->duration_ns(), 50);
+  EXPECT_EQ(slice->switch_out_or_wakeup_callstack_status(),
+            orbit_grpc_protos::ThreadStateSlice::kNoCallstack);
+
+  slice = manager.OnSchedSwitchIn(300, kTid);
+  ASSERT_TRUE(slice.has_value());
+  EXPECT_EQ(slice->thread_state(), ThreadStateSlice::kRunnable);
+  EXPECT_EQ(slice->switch_out_or_wakeup_callstack_status(),
+            orbit_grpc_protos::ThreadStateSlice::kNoCallstack);
+
+  // Blocked interval as long as the threshold: both keep their callstack, even though the
+  // runnable interval that follows the wakeup is short.
+  slice = manager.OnSchedSwitchOut(400, kTid, ThreadStateSlice::kUninterruptibleSleep,
+                                   /*has_wakeup_or_switch_out_callstack*/ true);
+  ASSERT_TRUE(slice.has_value());
+  slice = manager.OnSchedWakeup(500, kTid, kWasUnblockedByTid, kWasUnblockedByPid,
+                                /*has_wakeup_or_switch_out_callstack*/ true);
+  ASSERT_TRUE(slice.has_value());
+  EXPECT_EQ(slice->thread_state(), ThreadStateSlice::kUninterruptibleSleep);
+  EXPECT_EQ(slice->duration_ns(), 100);
+  EXPECT_EQ(slice->switch_out_or_wakeup_callstack_status(),
+            orbit_grpc_protos::ThreadStateSlice::kWaitingForCallstack);
+
+  slice = manager.OnSchedSwitchIn(510, kTid);
+  ASSERT_TRUE(slice.has_value());
+  EXPECT_EQ(slice->thread_state(), ThreadStateSlice::kRunnable);
+  EXPECT_EQ(slice->wakeup_reason(), orbit_grpc_protos::ThreadStateSlice::kUnblocked);
+  EXPECT_EQ(slice->switch_out_or_wakeup_callstack_status(),
+            orbit_grpc_protos::ThreadStateSlice::kWaitingForCallstack);
+
+  // Long preemption: the switch out keeps its callstack.
+  slice = manager.OnSchedSwitchOut(600, kTid, ThreadStateSlice::kRunnable,
+                                   /*has_wakeup_or_switch_out_callstack*/ true);
+  ASSERT_TRUE(slice.has_value());
+  slice = manager.OnSchedSwitchIn(800, kTid);
+  ASSERT_TRUE(slice.has_value());
+  EXPECT_EQ(slice->thread_state(), ThreadStateSlice::kRunnable);
+  EXPECT_EQ(slice->switch_out_or_wakeup_callstack_status(),
+            orbit_grpc_protos::ThreadStateSlice::kWaitingForCallstack);
+}
+
+TEST(ThreadStateManager, MinOffCpuDurationForCallstacksDropsCallstacksAtCaptureFinished) {
+  constexpr pid_t kTid = 42;
+  ThreadStateManager manager;
+  manager.SetMinOffCpuDurationForCallstacksNs(100);
+  std::optional<ThreadStateSlice> slice;
+
+  manager.OnInitialState(100, kTid, ThreadStateSlice::kRunning);
+  slice = manager.OnSchedSwitchOut(200, kTid, ThreadStateSlice::kInterruptibleSleep,
+                                   /*has_wakeup_or_switch_out_callstack*/ true);
+  ASSERT_TRUE(slice.has_value());
+
+  std::vector<ThreadStateSlice> slices = manager.OnCaptureFinished(1000);
+  ASSERT_EQ(slices.size(), 1);
+  EXPECT_EQ(slices[0].thread_state(), ThreadStateSlice::kInterruptibleSleep);
+  EXPECT_EQ(slices[0].duration_ns(), 800);
+  EXPECT_EQ(slices[0].switch_out_or_wakeup_callstack_status(),
+            orbit_grpc_protos::ThreadStateSlice::kNoCallstack);
+}
+
 }  // namespace orbit_linux_tracing
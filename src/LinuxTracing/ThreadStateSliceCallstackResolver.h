@@ -0,0 +1,29 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_THREAD_STATE_SLICE_CALLSTACK_RESOLVER_H_
+#define LINUX_TRACING_THREAD_STATE_SLICE_CALLSTACK_RESOLVER_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+
+namespace orbit_linux_tracing {
+
+// Receives, right before a ThreadStateSlice is sent, whether the callstack collected at the
+// beginning of the slice (on the switch out or on the wakeup of thread `tid` at
+// `begin_timestamp_ns`) is needed. This allows to only unwind the callstacks that are actually
+// attached to a slice. If `keep_callstack` is true, the callstack needs to have been passed to the
+// TracerListener when this returns, as ProducerEventProcessor expects it before the slice.
+class ThreadStateSliceCallstackResolver {
+ public:
+  virtual ~ThreadStateSliceCallstackResolver() = default;
+
+  virtual void ResolveThreadStateSliceCallstack(pid_t tid, uint64_t begin_timestamp_ns,
+                                                bool keep_callstack) = 0;
+};
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_THREAD_STATE_SLICE_CALLSTACK_RESOLVER_H_
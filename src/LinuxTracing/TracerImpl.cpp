@@ -11,17 +11,23 @@
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_join.h>
 #include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
 #include <absl/types/span.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
+#include <iterator>
 #include <limits>
 #include <string>
 #include <string_view>
 #include <thread>
 #include <utility>
+#include <variant>
 
 #include "ApiInterface/Orbit.h"
 #include "GrpcProtos/capture.pb.h"
@@ -38,11 +44,14 @@
 #include "OrbitBase/GetProcessIds.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/SafeStrerror.h"
+#include "OrbitBase/TaskGroup.h"
 #include "OrbitBase/ThreadUtils.h"
 #include "PerfEventOpen.h"
 #include "PerfEventOrderedStream.h"
 #include "PerfEventReaders.h"
 #include "PerfEventRecords.h"
+#include "RingBufferSizing.h"
 
 using orbit_base::GetAllPids;
 using orbit_base::GetTidsOfProcess;
@@ -72,14 +81,26 @@ TracerImpl::TracerImpl(
     : trace_context_switches_{capture_options.trace_context_switches()},
       introspection_enabled_{capture_options.enable_introspection()},
       target_pid_{orbit_base::ToNativeProcessId(capture_options.pid())},
+      page_fault_sampling_period_{capture_options.page_fault_sampling_period()},
+      sample_performance_counters_{capture_options.sample_performance_counters()},
       unwinding_method_{capture_options.unwinding_method()},
       trace_thread_state_{capture_options.trace_thread_state()},
       trace_gpu_driver_{capture_options.trace_gpu_driver()},
+      use_ring_buffer_wakeups_{capture_options.use_ring_buffer_wakeups()},
+      ring_buffer_reader_thread_count_{capture_options.ring_buffer_reader_thread_count()},
+      unwinding_thread_count_{capture_options.unwinding_thread_count()},
+      flight_recorder_duration_ns_{capture_options.flight_recorder_duration_ms() * 1'000'000},
+      perf_record_dump_path_{capture_options.perf_record_dump_path()},
       user_space_instrumentation_addresses_{std::move(user_space_instrumentation_addresses)},
       listener_{listener} {
   ORBIT_CHECK(listener_ != nullptr);
+  for (uint32_t pid : capture_options.additional_thread_state_pids()) {
+    additional_thread_state_pids_.push_back(orbit_base::ToNativeProcessId(pid));
+  }
   thread_state_change_callstack_collection_ =
       capture_options.thread_state_change_callstack_collection();
+  thread_state_change_callstack_min_off_cpu_duration_ns_ =
+      capture_options.thread_state_change_callstack_min_off_cpu_duration_ns();
 
   uint32_t thread_state_change_callstack_stack_dump_size =
       capture_options.thread_state_change_callstack_stack_dump_size();
@@ -141,20 +162,49 @@ TracerImpl::TracerImpl(
     info.set_category(instrumented_tracepoint.category());
     instrumented_tracepoints_.emplace_back(info);
   }
+
+  if (IsFlightRecorderEnabled() && user_space_instrumentation_addresses_ != nullptr) {
+    ORBIT_ERROR("User space instrumentation is not supported in flight recorder mode");
+  }
+
+  if (!perf_record_dump_path_.empty()) {
+    perf_record_dump_capture_options_ = capture_options;
+    perf_record_dump_capture_options_.clear_perf_record_dump_path();
+  }
 }
 
 void TracerImpl::Start() {
   stop_run_thread_ = false;
+  if (use_ring_buffer_wakeups_) {
+    stop_run_thread_event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_run_thread_event_fd_ == -1) {
+      ORBIT_ERROR("eventfd: %s", SafeStrerror(errno));
+      ORBIT_LOG("Falling back to polling the ring buffers");
+      use_ring_buffer_wakeups_ = false;
+    }
+  }
   run_thread_ = std::thread(&TracerImpl::Run, this);
 }
 
 void TracerImpl::Stop() {
   stop_run_thread_ = true;
+  if (stop_run_thread_event_fd_ != -1) {
+    constexpr uint64_t kEventFdIncrement = 1;
+    if (write(stop_run_thread_event_fd_, &kEventFdIncrement, sizeof(kEventFdIncrement)) == -1) {
+      ORBIT_ERROR("Writing to eventfd: %s", SafeStrerror(errno));
+    }
+  }
   ORBIT_CHECK(run_thread_.joinable());
   run_thread_.join();
+  if (stop_run_thread_event_fd_ != -1) {
+    close(stop_run_thread_event_fd_);
+    stop_run_thread_event_fd_ = -1;
+  }
 }
 
 void TracerImpl::ProcessFunctionEntry(const orbit_grpc_protos::FunctionEntry& function_entry) {
+  // Unlike the records in the ring buffers, these events would accumulate for the entire capture.
+  if (IsFlightRecorderEnabled()) return;
   UserSpaceFunctionEntryPerfEvent event{
       .timestamp = function_entry.timestamp_ns(),
       .ordered_stream =
@@ -171,7 +221,19 @@ void TracerImpl::ProcessFunctionEntry(const orbit_grpc_protos::FunctionEntry& fu
   DeferEvent(event);
 }
 
+orbit_grpc_protos::UnwindingCacheStats TracerImpl::GetUnwindingCacheStats() const {
+  orbit_grpc_protos::UnwindingCacheStats unwinding_cache_stats;
+  if (unwinder_ == nullptr) {
+    return unwinding_cache_stats;
+  }
+  UnwindingCacheStats stats = unwinder_->GetUnwindingCacheStats();
+  unwinding_cache_stats.set_hit_count(stats.hit_count);
+  unwinding_cache_stats.set_miss_count(stats.miss_count);
+  return unwinding_cache_stats;
+}
+
 void TracerImpl::ProcessFunctionExit(const orbit_grpc_protos::FunctionExit& function_exit) {
+  if (IsFlightRecorderEnabled()) return;
   UserSpaceFunctionExitPerfEvent event{
       .timestamp = function_exit.timestamp_ns(),
       .ordered_stream =
@@ -201,7 +263,7 @@ static void OpenRingBuffersOrRedirectOnExisting(
     const absl::flat_hash_map<int32_t, int>& fds_per_cpu,
     absl::flat_hash_map<int32_t, int>* ring_buffer_fds_per_cpu,
     std::vector<PerfEventRingBuffer>* ring_buffers, uint64_t ring_buffer_size_kb,
-    std::string_view buffer_name_prefix) {
+    std::string_view buffer_name_prefix, bool overwrite) {
   ORBIT_SCOPE_FUNCTION;
   // Redirect all events on the same cpu to a single ring buffer.
   for (const auto& [cpu, fd] : fds_per_cpu) {
@@ -213,22 +275,18 @@ static void OpenRingBuffersOrRedirectOnExisting(
       // Create a ring buffer for this cpu.
       int ring_buffer_fd = fd;
       std::string buffer_name = absl::StrFormat("%s_%d", buffer_name_prefix, cpu);
-      ring_buffers->emplace_back(ring_buffer_fd, ring_buffer_size_kb, buffer_name);
+      ring_buffers->emplace_back(ring_buffer_fd, ring_buffer_size_kb, buffer_name, cpu, overwrite);
       ring_buffer_fds_per_cpu->emplace(cpu, ring_buffer_fd);
     }
   }
 }
 
-void TracerImpl::InitUprobesEventVisitor() {
+void TracerImpl::InitUprobesEventVisitor(const std::string& target_maps) {
   ORBIT_SCOPE_FUNCTION;
-  ErrorMessageOr<std::string> maps = orbit_module_utils::ReadMaps(target_pid_);
-  if (maps.has_error()) {
-    ORBIT_ERROR("%s", maps.error().message());
-  }
-  maps_ = LibunwindstackMaps::ParseMaps(maps.has_value() ? maps.value() : "");
+  maps_ = LibunwindstackMaps::ParseMaps(target_maps);
 
-  unwinder_ =
-      LibunwindstackUnwinder::Create(&absolute_address_to_size_of_functions_to_stop_unwinding_at_);
+  unwinder_ = LibunwindstackUnwinder::Create(
+      &absolute_address_to_size_of_functions_to_stop_unwinding_at_, kUnwindingCacheCapacity);
   return_address_manager_.emplace(user_space_instrumentation_addresses_.get());
   leaf_function_call_manager_ = std::make_unique<LeafFunctionCallManager>(stack_dump_size_);
   uprobes_unwinding_visitor_ = std::make_unique<UprobesUnwindingVisitor>(
@@ -238,21 +296,36 @@ void TracerImpl::InitUprobesEventVisitor() {
       &absolute_address_to_size_of_functions_to_stop_unwinding_at_);
   uprobes_unwinding_visitor_->SetUnwindErrorsAndDiscardedSamplesCounters(
       &stats_.unwind_error_count, &stats_.samples_in_uretprobes_count);
+  if (unwinding_method_ == CaptureOptions::kDwarf && sampling_period_ns_.has_value()) {
+    unwinding_budget_ = std::make_unique<UnwindingBudget>(
+        kUnwindingBudgetCoresPerUnwindingThread * std::max<uint32_t>(unwinding_thread_count_, 1));
+    uprobes_unwinding_visitor_->SetUnwindingBudget(unwinding_budget_.get());
+  }
+  if (unwinding_thread_count_ > 0) {
+    parallel_stack_unwinder_ = std::make_unique<ParallelStackUnwinder>(
+        unwinder_.get(), unwinding_thread_count_, unwinding_budget_.get());
+    uprobes_unwinding_visitor_->SetParallelStackUnwinder(parallel_stack_unwinder_.get());
+  }
+  if (FiltersThreadStateChangeCallstacksByOffCpuDuration()) {
+    uprobes_unwinding_visitor_->SetDeferThreadStateSliceCallstacks(true);
+  }
   event_processor_.AddVisitor(uprobes_unwinding_visitor_.get());
+  visitor_names_.emplace_back("UprobesUnwindingVisitor");
 }
 
 bool TracerImpl::OpenUprobes(const orbit_grpc_protos::InstrumentedFunction& function,
                              absl::Span<const int32_t> cpus,
-                             absl::flat_hash_map<int32_t, int>* fds_per_cpu) {
+                             absl::flat_hash_map<int32_t, int>* fds_per_cpu) const {
   ORBIT_SCOPE_FUNCTION;
   const char* module = function.file_path().c_str();
   const uint64_t offset = function.file_offset();
+  const RingBufferOptions ring_buffer_options = ComputeRingBufferOptions(RingBufferType::kUprobes);
   for (int32_t cpu : cpus) {
     int fd{};
     if (function.record_arguments()) {
-      fd = uprobes_retaddr_args_event_open(module, offset, /*pid=*/-1, cpu);
+      fd = uprobes_retaddr_args_event_open(module, offset, /*pid=*/-1, cpu, ring_buffer_options);
     } else {
-      fd = uprobes_retaddr_event_open(module, offset, /*pid=*/-1, cpu);
+      fd = uprobes_retaddr_event_open(module, offset, /*pid=*/-1, cpu, ring_buffer_options);
     }
     if (fd < 0) {
       ORBIT_ERROR("Opening uprobe %s+%#x on cpu %d", function.file_path(), function.file_offset(),
@@ -266,16 +339,17 @@ bool TracerImpl::OpenUprobes(const orbit_grpc_protos::InstrumentedFunction& func
 
 bool TracerImpl::OpenUretprobes(const orbit_grpc_protos::InstrumentedFunction& function,
                                 absl::Span<const int32_t> cpus,
-                                absl::flat_hash_map<int32_t, int>* fds_per_cpu) {
+                                absl::flat_hash_map<int32_t, int>* fds_per_cpu) const {
   ORBIT_SCOPE_FUNCTION;
   const char* module = function.file_path().c_str();
   const uint64_t offset = function.file_offset();
+  const RingBufferOptions ring_buffer_options = ComputeRingBufferOptions(RingBufferType::kUprobes);
   for (int32_t cpu : cpus) {
     int fd{};
     if (function.record_return_value()) {
-      fd = uretprobes_retval_event_open(module, offset, /*pid=*/-1, cpu);
+      fd = uretprobes_retval_event_open(module, offset, /*pid=*/-1, cpu, ring_buffer_options);
     } else {
-      fd = uretprobes_event_open(module, offset, /*pid=*/-1, cpu);
+      fd = uretprobes_event_open(module, offset, /*pid=*/-1, cpu, ring_buffer_options);
     }
     if (fd < 0) {
       ORBIT_ERROR("Opening uretprobe %s+%#x on cpu %d", function.file_path(),
@@ -323,14 +397,43 @@ bool TracerImpl::OpenUserSpaceProbes(absl::Span<const int32_t> cpus) {
   ORBIT_SCOPE_FUNCTION;
   bool uprobes_event_open_errors = false;
 
-  absl::flat_hash_map<int32_t, int> fds_per_cpu_for_redirection{};
-  for (const auto& function : instrumented_functions_) {
+  // Each perf_event_open of a uprobe or uretprobe is slow, as the kernel registers the probe in the
+  // file, and there are two per function and per cpu. So the file descriptors are opened in
+  // parallel on the default thread pool, in groups of functions. Only then, and in the order of the
+  // functions, are the stream ids recorded and the file descriptors redirected to the ring buffers.
+  struct UserSpaceProbesFds {
+    bool success = false;
     absl::flat_hash_map<int32_t, int> uprobes_fds_per_cpu;
     absl::flat_hash_map<int32_t, int> uretprobes_fds_per_cpu;
+  };
+  std::vector<UserSpaceProbesFds> fds_per_function(instrumented_functions_.size());
+  {
+    constexpr size_t kFunctionsPerTask = 16;
+    orbit_base::TaskGroup task_group;
+    for (size_t begin_index = 0; begin_index < instrumented_functions_.size();
+         begin_index += kFunctionsPerTask) {
+      task_group.AddTask([this, cpus, &fds_per_function, begin_index] {
+        const size_t end_index =
+            std::min(instrumented_functions_.size(), begin_index + kFunctionsPerTask);
+        for (size_t function_index = begin_index; function_index < end_index; ++function_index) {
+          const auto& function = instrumented_functions_[function_index];
+          UserSpaceProbesFds& fds = fds_per_function[function_index];
+          fds.success = OpenUprobes(function, cpus, &fds.uprobes_fds_per_cpu) &&
+                        OpenUretprobes(function, cpus, &fds.uretprobes_fds_per_cpu);
+        }
+      });
+    }
+  }
 
-    bool success = OpenUprobes(function, cpus, &uprobes_fds_per_cpu) &&
-                   OpenUretprobes(function, cpus, &uretprobes_fds_per_cpu);
-    if (!success) {
+  absl::flat_hash_map<int32_t, int> fds_per_cpu_for_redirection{};
+  for (size_t function_index = 0; function_index < instrumented_functions_.size();
+       ++function_index) {
+    const auto& function = instrumented_functions_[function_index];
+    const UserSpaceProbesFds& fds = fds_per_function[function_index];
+    const absl::flat_hash_map<int32_t, int>& uprobes_fds_per_cpu = fds.uprobes_fds_per_cpu;
+    const absl::flat_hash_map<int32_t, int>& uretprobes_fds_per_cpu = fds.uretprobes_fds_per_cpu;
+
+    if (!fds.success) {
       CloseFileDescriptors(uprobes_fds_per_cpu);
       CloseFileDescriptors(uretprobes_fds_per_cpu);
       uprobes_event_open_errors = true;
@@ -343,11 +446,13 @@ bool TracerImpl::OpenUserSpaceProbes(absl::Span<const int32_t> cpus) {
     AddUprobesFileDescriptors(uprobes_fds_per_cpu, function);
 
     OpenRingBuffersOrRedirectOnExisting(uretprobes_fds_per_cpu, &fds_per_cpu_for_redirection,
-                                        &ring_buffers_, kUprobesRingBufferSizeKb,
-                                        "uprobes_uretprobes");
+                                        &ring_buffers_,
+                                        GetRingBufferSizeKb(RingBufferType::kUprobes),
+                                        "uprobes_uretprobes", IsFlightRecorderEnabled());
     OpenRingBuffersOrRedirectOnExisting(uprobes_fds_per_cpu, &fds_per_cpu_for_redirection,
-                                        &ring_buffers_, kUprobesRingBufferSizeKb,
-                                        "uprobes_uretprobes");
+                                        &ring_buffers_,
+                                        GetRingBufferSizeKb(RingBufferType::kUprobes),
+                                        "uprobes_uretprobes", IsFlightRecorderEnabled());
   }
 
   return !uprobes_event_open_errors;
@@ -359,9 +464,11 @@ bool TracerImpl::OpenUprobesWithStack(
   ORBIT_SCOPE_FUNCTION;
   const char* module = function.file_path().c_str();
   const uint64_t offset = function.file_offset();
+  const RingBufferOptions ring_buffer_options =
+      ComputeRingBufferOptions(RingBufferType::kUprobesWithStack);
   for (int32_t cpu : cpus) {
-    int fd =
-        uprobes_with_stack_and_sp_event_open(module, offset, /*pid=*/-1, cpu, stack_dump_size_);
+    int fd = uprobes_with_stack_and_sp_event_open(module, offset, /*pid=*/-1, cpu, stack_dump_size_,
+                                                  ring_buffer_options);
     if (fd < 0) {
       ORBIT_ERROR("Opening uprobe %s+%#x with stack on cpu %d", function.file_path(),
                   function.file_offset(), cpu);
@@ -392,8 +499,9 @@ bool TracerImpl::OpenUprobesToRecordAdditionalStackOn(absl::Span<const int32_t>
       tracing_fds_by_type_["uprobe_additional_stack"].push_back(fd);
     }
     OpenRingBuffersOrRedirectOnExisting(uprobes_fds_per_cpu, &fds_per_cpu_for_redirection,
-                                        &ring_buffers_, kUprobesWithStackRingBufferSizeKb,
-                                        "uprobes_with_stack");
+                                        &ring_buffers_,
+                                        GetRingBufferSizeKb(RingBufferType::kUprobesWithStack),
+                                        "uprobes_with_stack", IsFlightRecorderEnabled());
   }
 
   return !uprobes_event_open_errors;
@@ -403,10 +511,13 @@ bool TracerImpl::OpenMmapTask(absl::Span<const int32_t> cpus) {
   ORBIT_SCOPE_FUNCTION;
   std::vector<int> mmap_task_tracing_fds;
   std::vector<PerfEventRingBuffer> mmap_task_ring_buffers;
+  const uint64_t ring_buffer_size_kb = GetRingBufferSizeKb(RingBufferType::kMmapTask);
+  const RingBufferOptions ring_buffer_options = ComputeRingBufferOptions(RingBufferType::kMmapTask);
   for (int32_t cpu : cpus) {
-    int mmap_task_fd = mmap_task_event_open(-1, cpu);
+    int mmap_task_fd = mmap_task_event_open(-1, cpu, ring_buffer_options);
     std::string buffer_name = absl::StrFormat("mmap_task_%d", cpu);
-    PerfEventRingBuffer mmap_task_ring_buffer{mmap_task_fd, kMmapTaskRingBufferSizeKb, buffer_name};
+    PerfEventRingBuffer mmap_task_ring_buffer{mmap_task_fd, ring_buffer_size_kb, buffer_name, cpu,
+                                              ring_buffer_options.write_backward};
     if (mmap_task_ring_buffer.IsOpen()) {
       mmap_task_tracing_fds.push_back(mmap_task_fd);
       mmap_task_ring_buffers.push_back(std::move(mmap_task_ring_buffer));
@@ -430,20 +541,30 @@ bool TracerImpl::OpenSampling(absl::Span<const int32_t> cpus) {
   ORBIT_SCOPE_FUNCTION;
   ORBIT_CHECK(sampling_period_ns_.has_value());
   ORBIT_CHECK(unwinding_method_ == CaptureOptions::kFramePointers ||
-              unwinding_method_ == CaptureOptions::kDwarf);
+              unwinding_method_ == CaptureOptions::kDwarf ||
+              unwinding_method_ == CaptureOptions::kLastBranchRecords);
 
   std::vector<int> sampling_tracing_fds;
   std::vector<PerfEventRingBuffer> sampling_ring_buffers;
+  const uint64_t ring_buffer_size_kb = GetRingBufferSizeKb(RingBufferType::kSampling);
+  const RingBufferOptions ring_buffer_options = ComputeRingBufferOptions(RingBufferType::kSampling);
   for (int32_t cpu : cpus) {
     int sampling_fd{};
     switch (unwinding_method_) {
       case CaptureOptions::kFramePointers:
-        sampling_fd =
-            callchain_sample_event_open(sampling_period_ns_.value(), -1, cpu, stack_dump_size_);
+        sampling_fd = callchain_sample_event_open(sampling_period_ns_.value(), -1, cpu,
+                                                  stack_dump_size_, ring_buffer_options);
         break;
       case CaptureOptions::kDwarf:
-        sampling_fd =
-            stack_sample_event_open(sampling_period_ns_.value(), -1, cpu, stack_dump_size_);
+        sampling_fd = stack_sample_event_open(sampling_period_ns_.value(), -1, cpu,
+                                              stack_dump_size_, ring_buffer_options);
+        break;
+      case CaptureOptions::kLastBranchRecords:
+        sampling_fd = lbr_callstack_sample_event_open(sampling_period_ns_.value(), -1, cpu,
+                                                      ring_buffer_options);
+        if (sampling_fd == -1) {
+          ORBIT_ERROR("LBR callstacks require an Intel CPU with LBR support (Haswell or later)");
+        }
         break;
       case CaptureOptions::kUndefined:
       default:
@@ -453,7 +574,8 @@ bool TracerImpl::OpenSampling(absl::Span<const int32_t> cpus) {
     }
 
     std::string buffer_name = absl::StrFormat("sampling_%d", cpu);
-    PerfEventRingBuffer sampling_ring_buffer{sampling_fd, kSamplingRingBufferSizeKb, buffer_name};
+    PerfEventRingBuffer sampling_ring_buffer{sampling_fd, ring_buffer_size_kb, buffer_name, cpu,
+                                             ring_buffer_options.write_backward};
     if (sampling_ring_buffer.IsOpen()) {
       sampling_tracing_fds.push_back(sampling_fd);
       sampling_ring_buffers.push_back(std::move(sampling_ring_buffer));
@@ -464,6 +586,25 @@ bool TracerImpl::OpenSampling(absl::Span<const int32_t> cpus) {
     }
   }
 
+  // A perf_event_open file descriptor can't change what it samples, so for DWARF unwinding the
+  // frame-pointer sampling that SwitchSamplingToFramePointers falls back to is opened in advance,
+  // disabled, and redirected to the same ring buffers. Without it, sampling just never falls back.
+  std::vector<int> fallback_tracing_fds;
+  if (unwinding_method_ == CaptureOptions::kDwarf) {
+    for (size_t i = 0; i < cpus.size(); ++i) {
+      int fallback_fd = callchain_sample_event_open(sampling_period_ns_.value(), -1, cpus[i],
+                                                    stack_dump_size_, ring_buffer_options);
+      if (fallback_fd == -1) {
+        ORBIT_ERROR("Opening frame-pointer sampling fallback for cpu %d", cpus[i]);
+        CloseFileDescriptors(fallback_tracing_fds);
+        fallback_tracing_fds.clear();
+        break;
+      }
+      perf_event_redirect(fallback_fd, sampling_tracing_fds[i]);
+      fallback_tracing_fds.push_back(fallback_fd);
+    }
+  }
+
   for (int fd : sampling_tracing_fds) {
     tracing_fds_by_type_["sampling"].push_back(fd);
     uint64_t stream_id = perf_event_get_id(fd);
@@ -471,14 +612,111 @@ bool TracerImpl::OpenSampling(absl::Span<const int32_t> cpus) {
       stack_sampling_ids_.insert(stream_id);
     } else if (unwinding_method_ == CaptureOptions::kFramePointers) {
       callchain_sampling_ids_.insert(stream_id);
+    } else if (unwinding_method_ == CaptureOptions::kLastBranchRecords) {
+      lbr_callstack_sampling_ids_.insert(stream_id);
     }
   }
+  for (int fd : fallback_tracing_fds) {
+    tracing_fds_by_type_["sampling_fallback"].push_back(fd);
+    callchain_sampling_ids_.insert(perf_event_get_id(fd));
+  }
   for (PerfEventRingBuffer& buffer : sampling_ring_buffers) {
     ring_buffers_.emplace_back(std::move(buffer));
   }
   return true;
 }
 
+bool TracerImpl::OpenPageFaultSampling(absl::Span<const int32_t> cpus) {
+  ORBIT_SCOPE_FUNCTION;
+  ORBIT_CHECK(page_fault_sampling_period_ > 0);
+  if (unwinding_method_ != CaptureOptions::kFramePointers &&
+      unwinding_method_ != CaptureOptions::kDwarf) {
+    // LBR callstacks are only recorded with hardware events, while page faults are software events.
+    ORBIT_ERROR("Page fault sampling requires DWARF or frame pointer unwinding");
+    return false;
+  }
+
+  std::vector<int> page_fault_tracing_fds;
+  std::vector<PerfEventRingBuffer> page_fault_ring_buffers;
+  const uint64_t ring_buffer_size_kb = GetRingBufferSizeKb(RingBufferType::kSampling);
+  const RingBufferOptions ring_buffer_options = ComputeRingBufferOptions(RingBufferType::kSampling);
+  for (int32_t cpu : cpus) {
+    int page_fault_fd =
+        (unwinding_method_ == CaptureOptions::kDwarf)
+            ? page_fault_stack_sample_event_open(page_fault_sampling_period_, -1, cpu,
+                                                 stack_dump_size_, ring_buffer_options)
+            : page_fault_callchain_sample_event_open(page_fault_sampling_period_, -1, cpu,
+                                                     stack_dump_size_, ring_buffer_options);
+
+    std::string buffer_name = absl::StrFormat("page_faults_%d", cpu);
+    PerfEventRingBuffer page_fault_ring_buffer{page_fault_fd, ring_buffer_size_kb, buffer_name, cpu,
+                                               ring_buffer_options.write_backward};
+    if (page_fault_ring_buffer.IsOpen()) {
+      page_fault_tracing_fds.push_back(page_fault_fd);
+      page_fault_ring_buffers.push_back(std::move(page_fault_ring_buffer));
+    } else {
+      ORBIT_ERROR("Opening page fault sampling for cpu %d", cpu);
+      CloseFileDescriptors(page_fault_tracing_fds);
+      return false;
+    }
+  }
+
+  for (int fd : page_fault_tracing_fds) {
+    tracing_fds_by_type_["page_faults"].push_back(fd);
+    uint64_t stream_id = perf_event_get_id(fd);
+    if (unwinding_method_ == CaptureOptions::kDwarf) {
+      page_fault_stack_sampling_ids_.insert(stream_id);
+    } else {
+      page_fault_callchain_sampling_ids_.insert(stream_id);
+    }
+  }
+  for (PerfEventRingBuffer& buffer : page_fault_ring_buffers) {
+    ring_buffers_.emplace_back(std::move(buffer));
+  }
+  return true;
+}
+
+bool TracerImpl::OpenPerformanceCounterSampling(absl::Span<const int32_t> cpus) {
+  ORBIT_SCOPE_FUNCTION;
+  ORBIT_CHECK(sampling_period_ns_.has_value());
+
+  std::vector<int> leader_fds;
+  std::vector<int> counter_fds;
+  std::vector<PerfEventRingBuffer> performance_counter_ring_buffers;
+  const uint64_t ring_buffer_size_kb = GetRingBufferSizeKb(RingBufferType::kSampling);
+  const RingBufferOptions ring_buffer_options = ComputeRingBufferOptions(RingBufferType::kSampling);
+  for (int32_t cpu : cpus) {
+    int leader_fd = performance_counter_group_event_open(sampling_period_ns_.value(), -1, cpu,
+                                                         ring_buffer_options, &counter_fds);
+    std::string buffer_name = absl::StrFormat("performance_counters_%d", cpu);
+    PerfEventRingBuffer performance_counter_ring_buffer{leader_fd, ring_buffer_size_kb, buffer_name,
+                                                        cpu, ring_buffer_options.write_backward};
+    if (performance_counter_ring_buffer.IsOpen()) {
+      leader_fds.push_back(leader_fd);
+      performance_counter_ring_buffers.push_back(std::move(performance_counter_ring_buffer));
+    } else {
+      ORBIT_ERROR("Opening performance counter sampling for cpu %d", cpu);
+      CloseFileDescriptors(counter_fds);
+      CloseFileDescriptors(leader_fds);
+      return false;
+    }
+  }
+
+  for (int fd : leader_fds) {
+    // The leaders sample at the sampling period, so they follow its reductions too.
+    tracing_fds_by_type_["sampling"].push_back(fd);
+    performance_counter_sampling_ids_.insert(perf_event_get_id(fd));
+  }
+  for (int fd : counter_fds) {
+    tracing_fds_by_type_["performance_counters"].push_back(fd);
+  }
+  for (PerfEventRingBuffer& buffer : performance_counter_ring_buffers) {
+    ring_buffers_.emplace_back(std::move(buffer));
+  }
+  last_performance_counters_per_cpu_.resize(std::max(GetNumCores(), 1));
+  return true;
+}
+
 namespace {
 
 struct TracepointToOpen {
@@ -500,7 +738,8 @@ static bool OpenFileDescriptorsAndRingBuffersForAllTracepoints(
     absl::flat_hash_map<std::string, std::vector<int>>* tracing_fds_by_type,
     uint64_t ring_buffer_size_kb,
     absl::flat_hash_map<int32_t, int>* tracepoint_ring_buffer_fds_per_cpu_for_redirection,
-    std::vector<PerfEventRingBuffer>* ring_buffers, uint32_t stack_dump_size = 0,
+    std::vector<PerfEventRingBuffer>* ring_buffers, RingBufferOptions ring_buffer_options,
+    uint32_t stack_dump_size = 0,
     const CaptureOptions::ThreadStateChangeCallStackCollection
         thread_state_change_callstack_collection =
             CaptureOptions::kNoThreadStateChangeCallStackCollection,
@@ -518,14 +757,15 @@ static bool OpenFileDescriptorsAndRingBuffersForAllTracepoints(
       if (thread_state_change_callstack_collection ==
               CaptureOptions::kThreadStateChangeCallStackCollection &&
           unwinding_method == CaptureOptions::kFramePointers) {
-        tracepoint_fd = tracepoint_with_callchain_event_open(tracepoint_category, tracepoint_name,
-                                                             -1, cpu, stack_dump_size);
+        tracepoint_fd = tracepoint_with_callchain_event_open(
+            tracepoint_category, tracepoint_name, -1, cpu, stack_dump_size, ring_buffer_options);
       } else if (thread_state_change_callstack_collection ==
                  CaptureOptions::kThreadStateChangeCallStackCollection) {
-        tracepoint_fd = tracepoint_with_stack_event_open(tracepoint_category, tracepoint_name, -1,
-                                                         cpu, stack_dump_size);
+        tracepoint_fd = tracepoint_with_stack_event_open(
+            tracepoint_category, tracepoint_name, -1, cpu, stack_dump_size, ring_buffer_options);
       } else {
-        tracepoint_fd = tracepoint_event_open(tracepoint_category, tracepoint_name, -1, cpu);
+        tracepoint_fd = tracepoint_event_open(tracepoint_category, tracepoint_name, -1, cpu,
+                                              ring_buffer_options);
       }
       if (tracepoint_fd == -1) {
         ORBIT_ERROR("Opening %s:%s tracepoint for cpu %d", tracepoint_category, tracepoint_name,
@@ -569,7 +809,8 @@ static bool OpenFileDescriptorsAndRingBuffersForAllTracepoints(
 
     OpenRingBuffersOrRedirectOnExisting(
         tracepoint_fds_per_cpu, tracepoint_ring_buffer_fds_per_cpu_for_redirection, ring_buffers,
-        ring_buffer_size_kb, absl::StrFormat("%s:%s", tracepoint_category, tracepoint_name));
+        ring_buffer_size_kb, absl::StrFormat("%s:%s", tracepoint_category, tracepoint_name),
+        ring_buffer_options.write_backward);
   }
   return true;
 }
@@ -579,8 +820,9 @@ bool TracerImpl::OpenThreadNameTracepoints(absl::Span<const int32_t> cpus) {
   absl::flat_hash_map<int32_t, int> thread_name_tracepoint_ring_buffer_fds_per_cpu;
   return OpenFileDescriptorsAndRingBuffersForAllTracepoints(
       {{"task", "task_newtask", &task_newtask_ids_}, {"task", "task_rename", &task_rename_ids_}},
-      cpus, &tracing_fds_by_type_, kThreadNamesRingBufferSizeKb,
-      &thread_name_tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_);
+      cpus, &tracing_fds_by_type_, GetRingBufferSizeKb(RingBufferType::kThreadNames),
+      &thread_name_tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_,
+      ComputeRingBufferOptions(RingBufferType::kThreadNames));
 }
 
 void TracerImpl::InitSwitchesStatesNamesVisitor() {
@@ -588,16 +830,28 @@ void TracerImpl::InitSwitchesStatesNamesVisitor() {
   switches_states_names_visitor_ = std::make_unique<SwitchesStatesNamesVisitor>(listener_);
   switches_states_names_visitor_->SetProduceSchedulingSlices(trace_context_switches_);
   if (trace_thread_state_) {
-    // Filter thread states using target process id. We also send OrbitService's thread states when
-    // introspection is enabled for more context on what our own threads are doing when capturing.
+    // Filter thread states using target process id and the additionally requested ones. We also
+    // send OrbitService's thread states when introspection is enabled for more context on what our
+    // own threads are doing when capturing.
     absl::flat_hash_set<pid_t> pids = {target_pid_};
+    pids.insert(additional_thread_state_pids_.begin(), additional_thread_state_pids_.end());
     if (introspection_enabled_) {
       pids.insert(orbit_base::GetCurrentProcessIdNative());
     }
     switches_states_names_visitor_->SetThreadStatePidFilters(std::move(pids));
   }
   switches_states_names_visitor_->SetThreadStateCounter(&stats_.thread_state_count);
+  if (FiltersThreadStateChangeCallstacksByOffCpuDuration()) {
+    // The UprobesUnwindingVisitor was added before, so it visits the events with a callstack
+    // before this visitor decides whether the slices they start keep it.
+    ORBIT_CHECK(uprobes_unwinding_visitor_ != nullptr);
+    switches_states_names_visitor_->SetMinOffCpuDurationForCallstacksNs(
+        thread_state_change_callstack_min_off_cpu_duration_ns_);
+    switches_states_names_visitor_->SetThreadStateSliceCallstackResolver(
+        uprobes_unwinding_visitor_.get());
+  }
   event_processor_.AddVisitor(switches_states_names_visitor_.get());
+  visitor_names_.emplace_back("SwitchesStatesNamesVisitor");
 }
 
 bool TracerImpl::OpenContextSwitchAndThreadStateTracepoints(absl::Span<const int32_t> cpus) {
@@ -607,7 +861,10 @@ bool TracerImpl::OpenContextSwitchAndThreadStateTracepoints(absl::Span<const int
   absl::flat_hash_set<uint64_t>* current_sched_wakeup_ids = &sched_wakeup_ids_;
   if (thread_state_change_callstack_collection_ ==
       CaptureOptions::kThreadStateChangeCallStackCollection) {
-    if (unwinding_method_ == CaptureOptions::kDwarf) {
+    // The LBR is not available with tracepoints, so these callstacks are unwound with DWARF when
+    // sampling with LBR callstacks.
+    if (unwinding_method_ == CaptureOptions::kDwarf ||
+        unwinding_method_ == CaptureOptions::kLastBranchRecords) {
       current_sched_switch_ids = &sched_switch_with_stack_ids_;
       current_sched_wakeup_ids = &sched_wakeup_with_stack_ids_;
     } else if (unwinding_method_ == CaptureOptions::kFramePointers) {
@@ -628,17 +885,12 @@ bool TracerImpl::OpenContextSwitchAndThreadStateTracepoints(absl::Span<const int
   }
 
   absl::flat_hash_map<int32_t, int> thread_state_tracepoint_ring_buffer_fds_per_cpu;
-  uint64_t ring_buffer_size{};
-  if (thread_state_change_callstack_collection_ ==
-      CaptureOptions::kThreadStateChangeCallStackCollection) {
-    ring_buffer_size = kContextSwitchesAndThreadStateWithStacksRingBufferSizeKb;
-  } else {
-    ring_buffer_size = kContextSwitchesAndThreadStateRingBufferSizeKb;
-  }
+  const RingBufferType ring_buffer_type = GetContextSwitchAndThreadStateRingBufferType();
   return OpenFileDescriptorsAndRingBuffersForAllTracepoints(
-      tracepoints_to_open, cpus, &tracing_fds_by_type_, ring_buffer_size,
+      tracepoints_to_open, cpus, &tracing_fds_by_type_, GetRingBufferSizeKb(ring_buffer_type),
       &thread_state_tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_,
-      thread_state_change_callstack_stack_dump_size_, thread_state_change_callstack_collection_,
+      ComputeRingBufferOptions(ring_buffer_type), thread_state_change_callstack_stack_dump_size_,
+      thread_state_change_callstack_collection_,
       unwinding_method_);
 }
 
@@ -646,6 +898,7 @@ void TracerImpl::InitGpuTracepointEventVisitor() {
   ORBIT_SCOPE_FUNCTION;
   gpu_event_visitor_ = std::make_unique<GpuTracepointVisitor>(listener_);
   event_processor_.AddVisitor(gpu_event_visitor_.get());
+  visitor_names_.emplace_back("GpuTracepointVisitor");
 }
 
 // This method enables events for GPU event tracing. We trace three events that correspond to the
@@ -667,8 +920,9 @@ bool TracerImpl::OpenGpuTracepoints(absl::Span<const int32_t> cpus) {
       {{"amdgpu", "amdgpu_cs_ioctl", &amdgpu_cs_ioctl_ids_},
        {"amdgpu", "amdgpu_sched_run_job", &amdgpu_sched_run_job_ids_},
        {"dma_fence", "dma_fence_signaled", &dma_fence_signaled_ids_}},
-      cpus, &tracing_fds_by_type_, kGpuTracingRingBufferSizeKb,
-      &gpu_tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_);
+      cpus, &tracing_fds_by_type_, GetRingBufferSizeKb(RingBufferType::kGpuTracing),
+      &gpu_tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_,
+      ComputeRingBufferOptions(RingBufferType::kGpuTracing));
 }
 
 bool TracerImpl::OpenInstrumentedTracepoints(absl::Span<const int32_t> cpus) {
@@ -680,8 +934,9 @@ bool TracerImpl::OpenInstrumentedTracepoints(absl::Span<const int32_t> cpus) {
     absl::flat_hash_set<uint64_t> stream_ids;
     tracepoint_event_open_errors |= !OpenFileDescriptorsAndRingBuffersForAllTracepoints(
         {{selected_tracepoint.category().c_str(), selected_tracepoint.name().c_str(), &stream_ids}},
-        cpus, &tracing_fds_by_type_, kInstrumentedTracepointsRingBufferSizeKb,
-        &tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_);
+        cpus, &tracing_fds_by_type_, GetRingBufferSizeKb(RingBufferType::kInstrumentedTracepoints),
+        &tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_,
+        ComputeRingBufferOptions(RingBufferType::kInstrumentedTracepoints));
 
     for (const auto& stream_id : stream_ids) {
       ids_to_tracepoint_info_.emplace(stream_id, selected_tracepoint);
@@ -695,6 +950,14 @@ void TracerImpl::InitLostAndDiscardedEventVisitor() {
   ORBIT_SCOPE_FUNCTION;
   lost_and_discarded_event_visitor_ = std::make_unique<LostAndDiscardedEventVisitor>(listener_);
   event_processor_.AddVisitor(lost_and_discarded_event_visitor_.get());
+  visitor_names_.emplace_back("LostAndDiscardedEventVisitor");
+}
+
+void TracerImpl::InitPerformanceCounterVisitor() {
+  ORBIT_SCOPE_FUNCTION;
+  performance_counter_visitor_ = std::make_unique<PerformanceCounterVisitor>(listener_);
+  event_processor_.AddVisitor(performance_counter_visitor_.get());
+  visitor_names_.emplace_back("PerformanceCounterVisitor");
 }
 
 static WarningInstrumentingWithUprobesEvent CreateWarningInstrumentingWithUprobesEvent(
@@ -711,30 +974,45 @@ static WarningInstrumentingWithUprobesEvent CreateWarningInstrumentingWithUprobe
   return event;
 }
 
-static std::vector<ThreadName> RetrieveInitialThreadNamesSystemWide(uint64_t initial_timestamp_ns) {
-  std::vector<ThreadName> thread_names;
-  for (pid_t pid : GetAllPids()) {
-    for (pid_t tid : GetTidsOfProcess(pid)) {
-      std::string name = orbit_base::GetThreadNameNative(tid);
-      if (name.empty()) {
-        continue;
-      }
-
-      ThreadName thread_name;
-      thread_name.set_pid(pid);
-      thread_name.set_tid(tid);
-      thread_name.set_name(std::move(name));
-      thread_name.set_timestamp_ns(initial_timestamp_ns);
-      thread_names.push_back(std::move(thread_name));
+// Returns all the threads of the system, with their pid and their name. The name is empty if it
+// couldn't be read. Walking /proc takes long on systems with many threads, so groups of processes
+// are handled in parallel on the default thread pool.
+static std::vector<ThreadName> RetrieveInitialThreadsSystemWide(uint64_t initial_timestamp_ns) {
+  ORBIT_SCOPE_FUNCTION;
+  const std::vector<pid_t> pids = GetAllPids();
+  constexpr size_t kPidsPerTask = 64;
+  std::vector<std::vector<ThreadName>> threads_per_task((pids.size() + kPidsPerTask - 1) /
+                                                        kPidsPerTask);
+  {
+    orbit_base::TaskGroup task_group;
+    for (size_t task_index = 0; task_index < threads_per_task.size(); ++task_index) {
+      task_group.AddTask([&pids, &threads_per_task, task_index, initial_timestamp_ns] {
+        const size_t end_index = std::min(pids.size(), (task_index + 1) * kPidsPerTask);
+        for (size_t pid_index = task_index * kPidsPerTask; pid_index < end_index; ++pid_index) {
+          const pid_t pid = pids[pid_index];
+          for (pid_t tid : GetTidsOfProcess(pid)) {
+            ThreadName& thread = threads_per_task[task_index].emplace_back();
+            thread.set_pid(pid);
+            thread.set_tid(tid);
+            thread.set_name(orbit_base::GetThreadNameNative(tid));
+            thread.set_timestamp_ns(initial_timestamp_ns);
+          }
+        }
+      });
     }
   }
 
-  return thread_names;
+  std::vector<ThreadName> threads;
+  for (std::vector<ThreadName>& task_threads : threads_per_task) {
+    std::move(task_threads.begin(), task_threads.end(), std::back_inserter(threads));
+  }
+  return threads;
 }
 
 void TracerImpl::Startup() {
   ORBIT_SCOPE_FUNCTION;
   Reset();
+  ComputeRingBufferSizes();
 
   // perf_event_open refers to cores as "CPUs".
 
@@ -770,6 +1048,7 @@ void TracerImpl::Startup() {
     perf_event_open_error_details.emplace_back("mmap events, fork and exit events");
     perf_event_open_errors = true;
   }
+  SetTypeOfNewRingBuffers(RingBufferType::kMmapTask);
 
   bool uprobes_errors = false;
   if (!instrumented_functions_.empty()) {
@@ -778,12 +1057,14 @@ void TracerImpl::Startup() {
       perf_event_open_errors = true;
       uprobes_errors = true;
     }
+    SetTypeOfNewRingBuffers(RingBufferType::kUprobes);
   }
   if (!functions_to_record_additional_stack_on_.empty()) {
     if (bool opened = OpenUprobesToRecordAdditionalStackOn(cpuset_cpus); !opened) {
       perf_event_open_error_details.emplace_back("uprobes to record additional stack on");
       perf_event_open_errors = true;
     }
+    SetTypeOfNewRingBuffers(RingBufferType::kUprobesWithStack);
   }
 
   // This takes an initial snapshot of the maps. Note that, if at least one
@@ -792,13 +1073,37 @@ void TracerImpl::Startup() {
   // one of those functions has already been called after the corresponding
   // uprobes file descriptor has been opened by OpenUserSpaceProbes (opening is
   // enough, it doesn't need to have been enabled).
-  InitUprobesEventVisitor();
+  ErrorMessageOr<std::string> target_maps = orbit_module_utils::ReadMaps(target_pid_);
+  if (target_maps.has_error()) {
+    ORBIT_ERROR("%s", target_maps.error().message());
+  }
+  const std::string initial_target_maps = target_maps.has_value() ? target_maps.value() : "";
+  InitUprobesEventVisitor(initial_target_maps);
 
   if (sampling_period_ns_.has_value()) {
     if (bool opened = OpenSampling(cpuset_cpus); !opened) {
       perf_event_open_error_details.emplace_back("sampling");
       perf_event_open_errors = true;
     }
+    SetTypeOfNewRingBuffers(RingBufferType::kSampling);
+  }
+
+  if (page_fault_sampling_period_ > 0) {
+    if (bool opened = OpenPageFaultSampling(cpuset_cpus); !opened) {
+      perf_event_open_error_details.emplace_back("page fault sampling");
+      perf_event_open_errors = true;
+    }
+    SetTypeOfNewRingBuffers(RingBufferType::kSampling);
+  }
+
+  if (sample_performance_counters_ && sampling_period_ns_.has_value()) {
+    if (bool opened = OpenPerformanceCounterSampling(cpuset_cpus); opened) {
+      InitPerformanceCounterVisitor();
+    } else {
+      perf_event_open_error_details.emplace_back("hardware performance counters");
+      perf_event_open_errors = true;
+    }
+    SetTypeOfNewRingBuffers(RingBufferType::kSampling);
   }
 
   InitSwitchesStatesNamesVisitor();
@@ -807,12 +1112,14 @@ void TracerImpl::Startup() {
         "task:task_newtask and task:task_rename tracepoints");
     perf_event_open_errors = true;
   }
+  SetTypeOfNewRingBuffers(RingBufferType::kThreadNames);
   if (trace_context_switches_ || trace_thread_state_) {
     if (bool opened = OpenContextSwitchAndThreadStateTracepoints(all_cpus); !opened) {
       perf_event_open_error_details.emplace_back(
           "sched:sched_switch and sched:sched_wakeup tracepoints");
       perf_event_open_errors = true;
     }
+    SetTypeOfNewRingBuffers(GetContextSwitchAndThreadStateRingBufferType());
   }
 
   if (trace_gpu_driver_) {
@@ -822,12 +1129,15 @@ void TracerImpl::Startup() {
     } else {
       ORBIT_LOG("There were errors opening GPU tracepoint events");
     }
+    SetTypeOfNewRingBuffers(RingBufferType::kGpuTracing);
   }
 
   if (bool opened = OpenInstrumentedTracepoints(all_cpus); !opened) {
     perf_event_open_error_details.emplace_back("selected tracepoints");
     perf_event_open_errors = true;
   }
+  SetTypeOfNewRingBuffers(RingBufferType::kInstrumentedTracepoints);
+  ORBIT_CHECK(ring_buffer_usages_.size() == ring_buffers_.size());
 
   if (perf_event_open_errors) {
     ORBIT_ERROR("With perf_event_open: did you forget to run as root?");
@@ -841,8 +1151,15 @@ void TracerImpl::Startup() {
     listener_->OnErrorsWithPerfEventOpenEvent(std::move(errors_with_perf_event_open_event));
   }
 
-  // Start recording events.
-  for (const auto& [unused_name, fds] : tracing_fds_by_type_) {
+  IndexSampleStreamTypes();
+  // All the visitors have been added. Measuring the time spent in each is cheap enough to always
+  // do it, and tells which one to blame when the capture loses events.
+  event_processor_.EnableVisitorTiming();
+
+  // Start recording events. The sampling fallback only starts if SwitchSamplingToFramePointers is
+  // called.
+  for (const auto& [name, fds] : tracing_fds_by_type_) {
+    if (name == "sampling_fallback") continue;
     for (int fd : fds) {
       perf_event_enable(fd);
     }
@@ -882,32 +1199,146 @@ void TracerImpl::Startup() {
   // timestamp. As these events will be the first events of the capture, this prevents later events
   // from having a lower timestamp. After all, the timestamp of the initial ThreadName events is
   // approximate.
-  std::vector<ThreadName> thread_names =
-      RetrieveInitialThreadNamesSystemWide(effective_capture_start_timestamp_ns_);
+  // The same walk of /proc also gives the initial association of tids to pids.
+  const std::vector<ThreadName> initial_threads =
+      RetrieveInitialThreadsSystemWide(effective_capture_start_timestamp_ns_);
 
   ThreadNamesSnapshot thread_names_snapshot;
   thread_names_snapshot.set_timestamp_ns(effective_capture_start_timestamp_ns_);
-  *thread_names_snapshot.mutable_thread_names() = {thread_names.begin(), thread_names.end()};
+  for (const ThreadName& thread : initial_threads) {
+    if (!thread.name().empty()) {
+      *thread_names_snapshot.add_thread_names() = thread;
+    }
+  }
 
   listener_->OnThreadNamesSnapshot(std::move(thread_names_snapshot));
 
-  // Get the initial association of tids to pids and pass it to switches_states_names_visitor_.
-  RetrieveInitialTidToPidAssociationSystemWide();
+  // Pass the initial association of tids to pids to switches_states_names_visitor_.
+  ProcessInitialTidToPidAssociations(initial_threads);
 
   if (trace_thread_state_) {
     // Get the initial thread states and pass them to switches_states_names_visitor_.
-    RetrieveInitialThreadStatesOfTarget();
+    RetrieveInitialThreadStates();
+  }
+
+  if (!perf_record_dump_path_.empty()) {
+    StartPerfRecordDump(initial_target_maps);
   }
 
   stats_.Reset();
 }
 
+void TracerImpl::StartPerfRecordDump(std::string target_maps) {
+  ORBIT_SCOPE_FUNCTION;
+  ErrorMessageOr<std::unique_ptr<PerfRecordDumpWriter>> writer =
+      PerfRecordDumpWriter::Create(perf_record_dump_path_);
+  if (writer.has_error()) {
+    ORBIT_ERROR("Creating perf record dump \"%s\": %s", perf_record_dump_path_,
+                writer.error().message());
+    return;
+  }
+  perf_record_dump_writer_ = std::move(writer.value());
+
+  PerfRecordDump metadata;
+  metadata.capture_options = perf_record_dump_capture_options_;
+  metadata.target_maps = std::move(target_maps);
+  metadata.effective_capture_start_timestamp_ns = effective_capture_start_timestamp_ns_;
+  for (const absl::flat_hash_set<uint64_t>* stream_ids : GetStreamIdSetsInDumpOrder()) {
+    metadata.stream_id_sets.emplace_back(stream_ids->begin(), stream_ids->end());
+  }
+  metadata.stream_ids_to_function_id.assign(uprobes_uretprobes_ids_to_function_id_.begin(),
+                                            uprobes_uretprobes_ids_to_function_id_.end());
+  metadata.stream_ids_to_tracepoint_info.assign(ids_to_tracepoint_info_.begin(),
+                                                ids_to_tracepoint_info_.end());
+  for (size_t i = 0; i < ring_buffers_.size(); ++i) {
+    metadata.ring_buffers.push_back(PerfRecordDump::RingBuffer{
+        .file_descriptor = ring_buffers_[i].GetFileDescriptor(),
+        .cpu = ring_buffers_[i].GetCpu(),
+        .type = ring_buffer_usages_[i].type,
+        .name = ring_buffers_[i].GetName(),
+    });
+  }
+  perf_record_dump_writer_->WriteMetadata(metadata);
+  ORBIT_LOG("Dumping perf records to \"%s\"", perf_record_dump_path_);
+}
+
+std::vector<absl::flat_hash_set<uint64_t>*> TracerImpl::GetStreamIdSetsInDumpOrder() {
+  // Only append to this list, so that older perf record dumps can still be replayed.
+  return {
+      &uprobes_ids_,
+      &uprobes_with_args_ids_,
+      &uprobes_with_stack_ids_,
+      &uretprobes_ids_,
+      &uretprobes_with_retval_ids_,
+      &stack_sampling_ids_,
+      &callchain_sampling_ids_,
+      &task_newtask_ids_,
+      &task_rename_ids_,
+      &sched_switch_ids_,
+      &sched_wakeup_ids_,
+      &sched_switch_with_callchain_ids_,
+      &sched_wakeup_with_callchain_ids_,
+      &sched_switch_with_stack_ids_,
+      &sched_wakeup_with_stack_ids_,
+      &amdgpu_cs_ioctl_ids_,
+      &amdgpu_sched_run_job_ids_,
+      &dma_fence_signaled_ids_,
+      &lbr_callstack_sampling_ids_,
+      &page_fault_stack_sampling_ids_,
+      &page_fault_callchain_sampling_ids_,
+      &performance_counter_sampling_ids_,
+  };
+}
+
+void TracerImpl::IndexSampleStreamTypes() {
+  sample_stream_types_by_id_.clear();
+  auto index_stream_ids = [this](const absl::flat_hash_set<uint64_t>& stream_ids,
+                                 SampleStreamType type) {
+    for (uint64_t stream_id : stream_ids) {
+      auto [unused_it, inserted] = sample_stream_types_by_id_.emplace(stream_id, type);
+      // A stream id belongs to at most one set.
+      ORBIT_CHECK(inserted);
+    }
+  };
+  index_stream_ids(uprobes_ids_, SampleStreamType::kUprobe);
+  index_stream_ids(uprobes_with_args_ids_, SampleStreamType::kUprobeWithArgs);
+  index_stream_ids(uprobes_with_stack_ids_, SampleStreamType::kUprobeWithStack);
+  index_stream_ids(uretprobes_ids_, SampleStreamType::kUretprobe);
+  index_stream_ids(uretprobes_with_retval_ids_, SampleStreamType::kUretprobeWithRetval);
+  index_stream_ids(stack_sampling_ids_, SampleStreamType::kStackSample);
+  index_stream_ids(callchain_sampling_ids_, SampleStreamType::kCallchainSample);
+  index_stream_ids(lbr_callstack_sampling_ids_, SampleStreamType::kLbrCallstackSample);
+  index_stream_ids(page_fault_stack_sampling_ids_, SampleStreamType::kPageFaultStackSample);
+  index_stream_ids(page_fault_callchain_sampling_ids_,
+                   SampleStreamType::kPageFaultCallchainSample);
+  index_stream_ids(performance_counter_sampling_ids_, SampleStreamType::kPerformanceCounterSample);
+  index_stream_ids(task_newtask_ids_, SampleStreamType::kTaskNewtask);
+  index_stream_ids(task_rename_ids_, SampleStreamType::kTaskRename);
+  index_stream_ids(sched_switch_ids_, SampleStreamType::kSchedSwitch);
+  index_stream_ids(sched_wakeup_ids_, SampleStreamType::kSchedWakeup);
+  index_stream_ids(sched_switch_with_callchain_ids_, SampleStreamType::kSchedSwitchWithCallchain);
+  index_stream_ids(sched_wakeup_with_callchain_ids_, SampleStreamType::kSchedWakeupWithCallchain);
+  index_stream_ids(sched_switch_with_stack_ids_, SampleStreamType::kSchedSwitchWithStack);
+  index_stream_ids(sched_wakeup_with_stack_ids_, SampleStreamType::kSchedWakeupWithStack);
+  index_stream_ids(amdgpu_cs_ioctl_ids_, SampleStreamType::kAmdgpuCsIoctl);
+  index_stream_ids(amdgpu_sched_run_job_ids_, SampleStreamType::kAmdgpuSchedRunJob);
+  index_stream_ids(dma_fence_signaled_ids_, SampleStreamType::kDmaFenceSignaled);
+  for (const auto& [stream_id, unused_tracepoint_info] : ids_to_tracepoint_info_) {
+    auto [unused_it, inserted] = sample_stream_types_by_id_.emplace(
+        stream_id, SampleStreamType::kUserInstrumentedTracepoint);
+    ORBIT_CHECK(inserted);
+  }
+}
+
 void TracerImpl::Shutdown() {
   ORBIT_SCOPE_FUNCTION;
   if (trace_thread_state_) {
     switches_states_names_visitor_->ProcessRemainingOpenStates(orbit_base::CaptureTimestampNs());
   }
 
+  // All records have been read, so this flushes the perf record dump.
+  perf_record_dump_writer_.reset();
+
   // Stop recording.
   size_t num_fds = 0;
   for (const auto& [unused_fd_type, fds] : tracing_fds_by_type_) {
@@ -937,11 +1368,14 @@ void TracerImpl::Shutdown() {
   }
 }
 
-void TracerImpl::ProcessOneRecord(PerfEventRingBuffer* ring_buffer) {
+uint64_t TracerImpl::ProcessOneRecord(PerfEventRingBuffer* ring_buffer) {
   uint64_t event_timestamp_ns = 0;
 
   perf_event_header header;
   ring_buffer->ReadHeader(&header);
+  if (perf_record_dump_writer_ != nullptr) {
+    perf_record_dump_writer_->WriteRecord(GetRingBufferIndex(ring_buffer), header, ring_buffer);
+  }
 
   // perf_event_header::type contains the type of record, e.g.,
   // PERF_RECORD_SAMPLE, PERF_RECORD_MMAP, etc., defined in enum
@@ -981,71 +1415,591 @@ void TracerImpl::ProcessOneRecord(PerfEventRingBuffer* ring_buffer) {
   }
 
   if (event_timestamp_ns != 0) {
-    fds_to_last_timestamp_ns_.insert_or_assign(ring_buffer->GetFileDescriptor(),
-                                               event_timestamp_ns);
+    // All entries have been added by Run, so this is safe even with multiple reader threads, as
+    // each ring buffer is only read by one of them.
+    auto it = fds_to_last_timestamp_ns_.find(ring_buffer->GetFileDescriptor());
+    ORBIT_CHECK(it != fds_to_last_timestamp_ns_.end());
+    it->second = event_timestamp_ns;
+    // Records in the same ring buffer come in order of timestamp.
+    AdvanceRingBufferWatermark(ring_buffer, event_timestamp_ns);
   }
+
+  return header.size;
 }
 
-void TracerImpl::Run() {
-  orbit_base::SetCurrentThreadName("Tracer::Run");
+bool TracerImpl::ProcessRecordsWithinBudget(PerfEventRingBuffer* ring_buffer, uint64_t budget) {
+  bool processed_records = false;
+  uint64_t cost = 0;
+  while (cost < budget && !stop_run_thread_ && ring_buffer->HasNewData()) {
+    cost += ProcessOneRecord(ring_buffer) + kRecordProcessingBaseCost;
+    processed_records = true;
+  }
+  return processed_records;
+}
 
-  Startup();
+bool TracerImpl::DrainNearlyFullRingBuffers(absl::Span<PerfEventRingBuffer* const> ring_buffers) {
+  std::vector<std::pair<double, PerfEventRingBuffer*>> nearly_full_ring_buffers;
+  for (PerfEventRingBuffer* ring_buffer : ring_buffers) {
+    const uint64_t unread_size = ring_buffer->GetUnreadSize();
+    const size_t ring_buffer_index = GetRingBufferIndex(ring_buffer);
+    RingBufferUsage& usage = ring_buffer_usages_[ring_buffer_index];
+    usage.max_unread_size = std::max(usage.max_unread_size, unread_size);
+    if (ring_buffer_fill_permilles_ != nullptr) {
+      ring_buffer_fill_permilles_[ring_buffer_index].store(
+          unread_size * 1000 / ring_buffer->GetSize(), std::memory_order_relaxed);
+    }
+    const double fill_fraction =
+        static_cast<double>(unread_size) / static_cast<double>(ring_buffer->GetSize());
+    if (fill_fraction > kNearlyFullRingBufferFraction) {
+      nearly_full_ring_buffers.emplace_back(fill_fraction, ring_buffer);
+    }
+  }
+  if (nearly_full_ring_buffers.empty()) {
+    return false;
+  }
+
+  ORBIT_SCOPE("DrainNearlyFullRingBuffers");
+  ORBIT_UINT64("Nearly full ring buffers", nearly_full_ring_buffers.size());
+  std::sort(nearly_full_ring_buffers.begin(), nearly_full_ring_buffers.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+  for (const auto& [fill_fraction, ring_buffer] : nearly_full_ring_buffers) {
+    ORBIT_SCOPE(ring_buffer->GetName().c_str());
+    const auto target_unread_size = static_cast<uint64_t>(
+        kNearlyFullRingBufferFraction * static_cast<double>(ring_buffer->GetSize()));
+    while (!stop_run_thread_ && ring_buffer->GetUnreadSize() > target_unread_size) {
+      ProcessOneRecord(ring_buffer);
+    }
+  }
+  return true;
+}
+
+RingBufferOptions TracerImpl::ComputeRingBufferOptions(RingBufferType type) const {
+  RingBufferOptions options;
+  options.write_backward = IsFlightRecorderEnabled();
+  // In flight recorder mode, no thread waits for the ring buffers to fill up.
+  if (use_ring_buffer_wakeups_ && !options.write_backward) {
+    options.wakeup_watermark_bytes = static_cast<uint32_t>(GetRingBufferSizeKb(type) * 1024 /
+                                                           kRingBufferWakeupWatermarkFraction);
+  }
+  return options;
+}
+
+bool TracerImpl::FiltersThreadStateChangeCallstacksByOffCpuDuration() const {
+  return thread_state_change_callstack_collection_ ==
+             CaptureOptions::kThreadStateChangeCallStackCollection &&
+         thread_state_change_callstack_min_off_cpu_duration_ns_ > 0;
+}
+
+RingBufferType TracerImpl::GetContextSwitchAndThreadStateRingBufferType() const {
+  if (thread_state_change_callstack_collection_ ==
+      CaptureOptions::kThreadStateChangeCallStackCollection) {
+    return RingBufferType::kContextSwitchesAndThreadStateWithStacks;
+  }
+  return RingBufferType::kContextSwitchesAndThreadState;
+}
+
+void TracerImpl::ComputeRingBufferSizes() {
+  const RingBufferSizingParameters parameters{
+      .sampling_period_ns = sampling_period_ns_.value_or(0),
+      .callchain_sampling = unwinding_method_ == CaptureOptions::kFramePointers ||
+                            unwinding_method_ == CaptureOptions::kLastBranchRecords,
+      // LBR callstack samples contain no copy of the stack.
+      .stack_dump_size = unwinding_method_ == CaptureOptions::kLastBranchRecords
+                             ? uint16_t{0}
+                             : stack_dump_size_,
+      .instrumented_function_count = instrumented_functions_.size(),
+  };
+  const RingBufferSizeFeedback& feedback = RingBufferSizeFeedback::GetDefault();
+  for (size_t type_index = 0; type_index < kRingBufferTypeCount; ++type_index) {
+    const auto type = static_cast<RingBufferType>(type_index);
+    ring_buffer_sizes_kb_[type_index] =
+        ComputeRingBufferSizeKb(type, parameters, feedback.GetSizeLog2Adjustment(type));
+  }
+}
+
+void TracerImpl::SetTypeOfNewRingBuffers(RingBufferType type) {
+  while (ring_buffer_usages_.size() < ring_buffers_.size()) {
+    ring_buffer_usages_.push_back(RingBufferUsage{.type = type});
+  }
+}
+
+void TracerImpl::ReportRingBufferUsage() const {
+  std::array<bool, kRingBufferTypeCount> type_was_used{};
+  std::array<uint64_t, kRingBufferTypeCount> lost_record_counts{};
+  std::array<double, kRingBufferTypeCount> max_fill_fractions{};
+  for (size_t i = 0; i < ring_buffers_.size(); ++i) {
+    const RingBufferUsage& usage = ring_buffer_usages_[i];
+    const auto type_index = static_cast<size_t>(usage.type);
+    type_was_used[type_index] = true;
+    lost_record_counts[type_index] += usage.lost_record_count;
+    const double max_fill_fraction = static_cast<double>(usage.max_unread_size) /
+                                     static_cast<double>(ring_buffers_[i].GetSize());
+    max_fill_fractions[type_index] = std::max(max_fill_fractions[type_index], max_fill_fraction);
+  }
+
+  RingBufferSizeFeedback& feedback = RingBufferSizeFeedback::GetDefault();
+  for (size_t type_index = 0; type_index < kRingBufferTypeCount; ++type_index) {
+    if (type_was_used[type_index]) {
+      feedback.Update(static_cast<RingBufferType>(type_index), lost_record_counts[type_index],
+                      max_fill_fractions[type_index]);
+    }
+  }
+}
+
+void TracerImpl::ReduceSamplingRate(uint32_t factor) {
+  ORBIT_CHECK(factor >= 1);
+  requested_sampling_rate_reduction_factor_.store(factor, std::memory_order_relaxed);
+}
+
+void TracerImpl::DropThreadStateChangeCallstacks() {
+  drop_thread_state_change_callstacks_.store(true, std::memory_order_relaxed);
+}
+
+void TracerImpl::ApplyRequestedSamplingRateReduction() {
+  const uint32_t factor = requested_sampling_rate_reduction_factor_.load(std::memory_order_relaxed);
+  if (factor == applied_sampling_rate_reduction_factor_ || !sampling_period_ns_.has_value()) {
+    return;
+  }
+  applied_sampling_rate_reduction_factor_ = factor;
+  const uint64_t sampling_period_ns = sampling_period_ns_.value() * factor;
+  ORBIT_LOG("Reducing the sampling rate by a factor of %u, to a period of %u ns", factor,
+            sampling_period_ns);
+  auto sampling_fds_it = tracing_fds_by_type_.find("sampling");
+  if (sampling_fds_it == tracing_fds_by_type_.end()) return;
+  for (int fd : sampling_fds_it->second) {
+    perf_event_set_period(fd, sampling_period_ns);
+  }
+  // Keep the fallback in sync, so that switching to it doesn't undo the reduction.
+  auto fallback_fds_it = tracing_fds_by_type_.find("sampling_fallback");
+  if (fallback_fds_it == tracing_fds_by_type_.end()) return;
+  for (int fd : fallback_fds_it->second) {
+    perf_event_set_period(fd, sampling_period_ns);
+  }
+}
+
+void TracerImpl::SwitchSamplingToFramePointers(double unwinding_cores) {
+  // This is only attempted once: the switch is not undone if unwinding gets cheaper again.
+  switched_sampling_to_frame_pointers_ = true;
+  auto fallback_fds_it = tracing_fds_by_type_.find("sampling_fallback");
+  if (fallback_fds_it == tracing_fds_by_type_.end()) {
+    ORBIT_ERROR("DWARF unwinding exceeds its budget, but there is no sampling to fall back to");
+    return;
+  }
+
+  // Enable the fallback first, so that no sampling period goes without a sample.
+  for (int fd : fallback_fds_it->second) {
+    perf_event_enable(fd);
+  }
+  // The performance counter group leaders are also "sampling" file descriptors, and keep running.
+  for (int fd : tracing_fds_by_type_.at("sampling")) {
+    if (stack_sampling_ids_.contains(perf_event_get_id(fd))) {
+      perf_event_disable(fd);
+    }
+  }
+
+  std::string message = absl::StrFormat(
+      "DWARF unwinding used %.1f cores on average, more than its budget of %.1f cores, so "
+      "callstack sampling switched to frame pointers for the rest of the capture. Callstacks "
+      "through code compiled without frame pointers might be incomplete. Page fault and thread "
+      "state change callstacks are still unwound with DWARF information.",
+      unwinding_cores, unwinding_budget_->GetMaxCores());
+  ORBIT_LOG("%s", message);
+  orbit_grpc_protos::WarningEvent warning_event;
+  warning_event.set_timestamp_ns(orbit_base::CaptureTimestampNs());
+  warning_event.set_message(std::move(message));
+  listener_->OnWarningEvent(std::move(warning_event));
+}
+
+void TracerImpl::RegisterLiveStats() {
+  orbit_base::StatsRegistry& registry = orbit_base::StatsRegistry::GetDefault();
+  live_stats_registrations_.push_back(registry.Register(
+      "tracer.lost_records", [this] { return total_lost_count_.load(std::memory_order_relaxed); }));
+  live_stats_registrations_.push_back(
+      registry.Register("tracer.ring_buffer_max_fill_permille", [this] {
+        uint64_t max_fill_permille = 0;
+        for (size_t i = 0; i < ring_buffers_.size(); ++i) {
+          max_fill_permille = std::max(
+              max_fill_permille, ring_buffer_fill_permilles_[i].load(std::memory_order_relaxed));
+        }
+        return max_fill_permille;
+      }));
+  live_stats_registrations_.push_back(registry.Register(
+      "tracer.deferred_event_queue_size", [this] { return deferred_events_.size_approx(); }));
+  live_stats_registrations_.push_back(registry.Register(
+      "tracer.perf_event_queue_size", [this] { return event_processor_.GetQueuedEventCount(); }));
+}
+
+void TracerImpl::ReportPerfEventProcessingStats() {
+  const std::vector<uint64_t>& visitor_times_ns = event_processor_.GetVisitorTimesNs();
+  const std::vector<uint64_t>& visitor_event_counts = event_processor_.GetVisitorEventCounts();
+  ORBIT_CHECK(visitor_times_ns.size() == visitor_names_.size());
+  ORBIT_CHECK(visitor_event_counts.size() == visitor_names_.size());
+
+  orbit_grpc_protos::PerfEventProcessingStatsEvent perf_event_processing_stats_event;
+  perf_event_processing_stats_event.set_timestamp_ns(orbit_base::CaptureTimestampNs());
+  for (size_t i = 0; i < visitor_names_.size(); ++i) {
+    orbit_grpc_protos::PerfEventVisitorStats* visitor_stats =
+        perf_event_processing_stats_event.add_visitor_stats();
+    visitor_stats->set_name(visitor_names_[i]);
+    visitor_stats->set_processing_time_ns(visitor_times_ns[i]);
+    visitor_stats->set_event_count(visitor_event_counts[i]);
+    ORBIT_LOG("%s: %.3f ms for %u events", visitor_names_[i],
+              static_cast<double>(visitor_times_ns[i]) / 1'000'000, visitor_event_counts[i]);
+  }
+  listener_->OnPerfEventProcessingStatsEvent(std::move(perf_event_processing_stats_event));
+}
+
+int TracerImpl::CreateRingBuffersEpoll(absl::Span<PerfEventRingBuffer* const> ring_buffers) const {
+  ORBIT_SCOPE_FUNCTION;
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd == -1) {
+    ORBIT_ERROR("epoll_create1: %s", SafeStrerror(errno));
+    return -1;
+  }
+
+  auto add_to_epoll = [epoll_fd](int fd) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+      ORBIT_ERROR("epoll_ctl: %s", SafeStrerror(errno));
+      return false;
+    }
+    return true;
+  };
+
+  bool success = add_to_epoll(stop_run_thread_event_fd_);
+  for (const PerfEventRingBuffer* ring_buffer : ring_buffers) {
+    if (!success) break;
+    success = add_to_epoll(ring_buffer->GetFileDescriptor());
+  }
+
+  if (!success) {
+    close(epoll_fd);
+    return -1;
+  }
+  return epoll_fd;
+}
+
+// Returns whether the thread was woken up because of new data, as opposed to a timeout.
+static bool WaitForRingBufferWakeup(int epoll_fd, int timeout_ms) {
+  ORBIT_SCOPE_FUNCTION;
+  // All ring buffers are read after every wakeup, so there is no need to know which ones are ready.
+  epoll_event event{};
+  int ret = epoll_wait(epoll_fd, &event, 1, timeout_ms);
+  if (ret == -1 && errno != EINTR) {
+    ORBIT_ERROR("epoll_wait: %s", SafeStrerror(errno));
+  }
+  return ret > 0;
+}
+
+std::vector<std::vector<PerfEventRingBuffer*>> TracerImpl::AssignRingBuffersToReaderThreads() {
+  // Each reader thread owns the ring buffers of a slice of the CPUs, so that all the ring buffers
+  // of the same CPU are read by the same thread.
+  const uint32_t thread_count =
+      std::clamp<uint32_t>(ring_buffer_reader_thread_count_, 1, std::max(GetNumCores(), 1));
+  std::vector<std::vector<PerfEventRingBuffer*>> ring_buffers_per_thread(thread_count);
+  for (PerfEventRingBuffer& ring_buffer : ring_buffers_) {
+    ring_buffers_per_thread[ring_buffer.GetCpu() % thread_count].push_back(&ring_buffer);
+  }
+  return ring_buffers_per_thread;
+}
+
+void TracerImpl::ReadRingBuffers(absl::Span<PerfEventRingBuffer* const> ring_buffers,
+                                 bool print_stats) {
+  int epoll_fd = -1;
+  if (use_ring_buffer_wakeups_) {
+    epoll_fd = CreateRingBuffersEpoll(ring_buffers);
+    if (epoll_fd == -1) {
+      ORBIT_LOG("Falling back to polling the ring buffers");
+    }
+  }
 
   bool last_iteration_saw_events = false;
-  std::thread deferred_events_thread(&TracerImpl::ProcessDeferredEvents, this);
 
   while (!stop_run_thread_) {
-    ORBIT_SCOPE("TracerThread::Run iteration");
+    ORBIT_SAMPLED_SCOPE(orbit_introspection::kIntrospectionCategoryTracerLoop,
+                        "TracerThread::Run iteration", kTracerLoopScopeOneInN,
+                        kTracerLoopScopeMaxPerSecond);
 
+    bool woken_up_by_ring_buffer = false;
     if (!last_iteration_saw_events) {
-      // Periodically print event statistics.
-      PrintStatsIfTimerElapsed();
+      if (print_stats) {
+        // Periodically print event statistics.
+        PrintStatsIfTimerElapsed();
+        ApplyRequestedSamplingRateReduction();
+      }
 
-      // Sleep if there was no new event in the last iteration so that we are
-      // not constantly polling. Don't sleep so long that ring buffers overflow.
-      {
+      if (epoll_fd != -1) {
+        // Block until a ring buffer crosses its wakeup watermark, or until the timeout expires.
+        woken_up_by_ring_buffer = WaitForRingBufferWakeup(epoll_fd, kMaxRingBufferWakeupWaitMs);
+        if (woken_up_by_ring_buffer) {
+          ++stats_.ring_buffer_wakeup_count;
+        } else {
+          ++stats_.ring_buffer_wakeup_timeout_count;
+        }
+      } else {
+        // Sleep if there was no new event in the last iteration so that we are
+        // not constantly polling. Don't sleep so long that ring buffers overflow.
         ORBIT_SCOPE("Sleep");
         usleep(kIdleTimeOnEmptyRingBuffersUs);
       }
     }
 
-    last_iteration_saw_events = false;
+    // Buffers that are about to overflow are drained first, so that we lose as few records as
+    // possible when we can't keep up with all the buffers.
+    last_iteration_saw_events = DrainNearlyFullRingBuffers(ring_buffers);
 
     // Read and process events from all ring buffers. In order to ensure that no
     // buffer is read constantly while others overflow, we schedule the reading
-    // using round-robin like scheduling.
-    for (PerfEventRingBuffer& ring_buffer : ring_buffers_) {
+    // using round-robin like scheduling, with a budget based on the size of the records.
+    for (PerfEventRingBuffer* ring_buffer : ring_buffers) {
       if (stop_run_thread_) {
         break;
       }
+      const uint64_t read_timestamp_ns = orbit_base::CaptureTimestampNs();
+      last_iteration_saw_events |=
+          ProcessRecordsWithinBudget(ring_buffer, kRoundRobinPollingBudget);
+      // An empty ring buffer has nothing older than the time we started reading it, up to the
+      // slack. This also lets the watermark of ring buffers without records advance.
+      if (!ring_buffer->HasNewData() && read_timestamp_ns > kEmptyRingBufferWatermarkSlackNs) {
+        AdvanceRingBufferWatermark(ring_buffer,
+                                   read_timestamp_ns - kEmptyRingBufferWatermarkSlackNs);
+      }
+    }
 
-      // Read up to ROUND_ROBIN_POLLING_BATCH_SIZE (5) new events.
-      // TODO: Some event types (e.g., stack samples) have a much longer
-      //  processing time but are less frequent than others (e.g., context
-      //  switches). Take this into account in our scheduling algorithm.
-      for (int32_t read_from_this_buffer = 0; read_from_this_buffer < kRoundRobinPollingBatchSize;
-           ++read_from_this_buffer) {
-        if (stop_run_thread_) {
-          break;
-        }
-        if (!ring_buffer.HasNewData()) {
-          break;
-        }
+    if (woken_up_by_ring_buffer && last_iteration_saw_events) {
+      ++stats_.ring_buffer_wakeup_with_data_count;
+    }
+  }
+
+  if (epoll_fd != -1) {
+    close(epoll_fd);
+  }
+}
+
+// In flight recorder mode, events older than the window that is kept are still processed if later
+// events depend on the state they establish, i.e., the address space and the threads of processes.
+[[nodiscard]] static bool IsNeededBeforeFlightRecorderWindow(const PerfEvent& event) {
+  return std::holds_alternative<MmapPerfEventData>(event.data) ||
+         std::holds_alternative<ForkPerfEventData>(event.data) ||
+         std::holds_alternative<ExitPerfEventData>(event.data) ||
+         std::holds_alternative<TaskNewtaskPerfEventData>(event.data) ||
+         std::holds_alternative<TaskRenamePerfEventData>(event.data);
+}
+
+void TracerImpl::RunFlightRecorder() {
+  ORBIT_SCOPE_FUNCTION;
+  ORBIT_LOG("Flight recorder mode: keeping the last %u ms of events in the ring buffers",
+            flight_recorder_duration_ns_ / 1'000'000);
+  // Stopping the capture is the trigger to dump the ring buffers. Until then, the kernel keeps
+  // overwriting the oldest records and there is nothing to do.
+  while (!stop_run_thread_) {
+    usleep(kFlightRecorderStopCheckIntervalUs);
+  }
+  const uint64_t trigger_timestamp_ns = orbit_base::CaptureTimestampNs();
+
+  // Freeze the content of the ring buffers before taking the snapshots.
+  for (const auto& [unused_name, fds] : tracing_fds_by_type_) {
+    for (int fd : fds) {
+      perf_event_disable(fd);
+    }
+  }
 
-        last_iteration_saw_events = true;
-        ProcessOneRecord(&ring_buffer);
+  // Events are only handed to event_processor_ after all ring buffers have been read, as the events
+  // in the snapshots are all older than PerfEventProcessor::kProcessingDelayMs.
+  uint64_t snapshot_bytes = 0;
+  for (PerfEventRingBuffer& ring_buffer : ring_buffers_) {
+    ORBIT_SCOPE(ring_buffer.GetName().c_str());
+    snapshot_bytes += ring_buffer.TakeSnapshot();
+    while (ring_buffer.HasNewData()) {
+      ProcessOneRecord(&ring_buffer);
+    }
+  }
+  ORBIT_LOG("Flight recorder mode: read %u bytes of records from %u ring buffers", snapshot_bytes,
+            ring_buffers_.size());
+
+  const uint64_t window_start_timestamp_ns =
+      (trigger_timestamp_ns > flight_recorder_duration_ns_)
+          ? trigger_timestamp_ns - flight_recorder_duration_ns_
+          : 0;
+  while (deferred_events_.try_dequeue_bulk(std::back_inserter(deferred_events_to_process_),
+                                           kMaxDeferredEventsPerBatch) > 0) {
+    for (std::optional<PerfEvent>& event : deferred_events_to_process_) {
+      if (event->timestamp < window_start_timestamp_ns &&
+          !IsNeededBeforeFlightRecorderWindow(event.value())) {
+        continue;
       }
+      event_processor_.AddEvent(std::move(event.value()));
     }
+    deferred_events_to_process_.clear();
+  }
+}
+
+void TracerImpl::Run() {
+  orbit_base::SetCurrentThreadName("Tracer::Run");
+
+  Startup();
+
+  // Register all ring buffers before starting the reader threads, so that they only ever update
+  // existing entries.
+  for (const PerfEventRingBuffer& ring_buffer : ring_buffers_) {
+    fds_to_last_timestamp_ns_.emplace(ring_buffer.GetFileDescriptor(), 0);
+  }
+  ring_buffer_watermarks_ns_ = std::make_unique<std::atomic<uint64_t>[]>(ring_buffers_.size());
+  ring_buffer_fill_permilles_ = std::make_unique<std::atomic<uint64_t>[]>(ring_buffers_.size());
+  for (size_t i = 0; i < ring_buffers_.size(); ++i) {
+    ring_buffer_watermarks_ns_[i] = 0;
+    ring_buffer_fill_permilles_[i] = 0;
+  }
+  RegisterLiveStats();
+
+  if (IsFlightRecorderEnabled()) {
+    RunFlightRecorder();
+  } else {
+    std::thread deferred_events_thread(&TracerImpl::ProcessDeferredEvents, this);
+
+    // This thread reads the first slice of ring buffers itself, additional threads read the others.
+    std::vector<std::vector<PerfEventRingBuffer*>> ring_buffers_per_thread =
+        AssignRingBuffersToReaderThreads();
+    std::vector<std::thread> additional_reader_threads;
+    for (size_t thread_index = 1; thread_index < ring_buffers_per_thread.size(); ++thread_index) {
+      additional_reader_threads.emplace_back([this, thread_index, &ring_buffers_per_thread] {
+        orbit_base::SetCurrentThreadName(absl::StrFormat("Tracer::Read%u", thread_index).c_str());
+        ReadRingBuffers(ring_buffers_per_thread[thread_index], /*print_stats=*/false);
+      });
+    }
+    ReadRingBuffers(ring_buffers_per_thread[0], /*print_stats=*/true);
+    for (std::thread& reader_thread : additional_reader_threads) {
+      reader_thread.join();
+    }
+
+    deferred_events_.enqueue(std::nullopt);
+    deferred_events_thread.join();
   }
 
   // Finish processing all deferred events.
-  stop_deferred_thread_ = true;
-  deferred_events_thread.join();
   event_processor_.ProcessAllEvents();
+  if (parallel_stack_unwinder_ != nullptr) {
+    parallel_stack_unwinder_->WaitForAllUnwinds();
+  }
+
+  // Ring buffers in overwrite mode are always full and never lose records, so they tell nothing
+  // about their size.
+  if (!IsFlightRecorderEnabled()) {
+    ReportRingBufferUsage();
+  }
+  ReportPerfEventProcessingStats();
 
+  live_stats_registrations_.clear();
   Shutdown();
 }
 
+ErrorMessageOr<TracerImpl::PerfRecordDumpReplayStats> TracerImpl::ReplayPerfRecordDump(
+    PerfRecordDump dump) {
+  ORBIT_SCOPE_FUNCTION;
+  Reset();
+  const std::vector<absl::flat_hash_set<uint64_t>*> stream_id_sets = GetStreamIdSetsInDumpOrder();
+  if (dump.stream_id_sets.size() != stream_id_sets.size()) {
+    return ErrorMessage{absl::StrFormat("Perf record dump has %u sets of stream ids instead of %u",
+                                        dump.stream_id_sets.size(), stream_id_sets.size())};
+  }
+
+  // Set up the visitors in the same order as Startup.
+  event_processor_.SetDiscardedOutOfOrderCounter(&stats_.discarded_out_of_order_count);
+  InitLostAndDiscardedEventVisitor();
+  InitUprobesEventVisitor(dump.target_maps);
+  if (sample_performance_counters_ && sampling_period_ns_.has_value()) {
+    InitPerformanceCounterVisitor();
+  }
+  InitSwitchesStatesNamesVisitor();
+  if (trace_gpu_driver_) {
+    InitGpuTracepointEventVisitor();
+  }
+  event_processor_.EnableVisitorTiming();
+
+  for (size_t i = 0; i < stream_id_sets.size(); ++i) {
+    stream_id_sets[i]->insert(dump.stream_id_sets[i].begin(), dump.stream_id_sets[i].end());
+  }
+  uprobes_uretprobes_ids_to_function_id_.insert(dump.stream_ids_to_function_id.begin(),
+                                                dump.stream_ids_to_function_id.end());
+  ids_to_tracepoint_info_.insert(dump.stream_ids_to_tracepoint_info.begin(),
+                                 dump.stream_ids_to_tracepoint_info.end());
+  IndexSampleStreamTypes();
+
+  PerfRecordDumpReplayStats replay_stats;
+  for (PerfRecordDump::RingBuffer& ring_buffer : dump.ring_buffers) {
+    replay_stats.record_count += ring_buffer.record_count;
+    fds_to_last_timestamp_ns_.emplace(ring_buffer.file_descriptor, 0);
+    ring_buffer_usages_.push_back(RingBufferUsage{.type = ring_buffer.type});
+    ring_buffers_.push_back(PerfEventRingBuffer::CreateFromRecords(
+        std::move(ring_buffer.records), ring_buffer.file_descriptor, std::move(ring_buffer.name),
+        ring_buffer.cpu));
+    // The dump might come from a machine with more CPUs than this one.
+    last_performance_counters_per_cpu_.resize(std::max<size_t>(
+        last_performance_counters_per_cpu_.size(), std::max(ring_buffer.cpu, 0) + 1));
+  }
+  ring_buffer_watermarks_ns_ = std::make_unique<std::atomic<uint64_t>[]>(ring_buffers_.size());
+  for (size_t i = 0; i < ring_buffers_.size(); ++i) {
+    ring_buffer_watermarks_ns_[i] = 0;
+  }
+  effective_capture_start_timestamp_ns_ = dump.effective_capture_start_timestamp_ns;
+  stats_.Reset();
+
+  // Read the ring buffers in the same round-robin fashion as ReadRingBuffers, but process the
+  // events as soon as the watermarks allow it, as there is no point in waiting for the kernel.
+  const uint64_t replay_begin_ns = orbit_base::CaptureTimestampNs();
+  stop_run_thread_ = false;
+  std::vector<PerfEventRingBuffer*> ring_buffers_to_read;
+  for (PerfEventRingBuffer& ring_buffer : ring_buffers_) {
+    ring_buffers_to_read.push_back(&ring_buffer);
+  }
+  auto move_deferred_events_to_processor = [this] {
+    while (deferred_events_.try_dequeue_bulk(std::back_inserter(deferred_events_to_process_),
+                                             kMaxDeferredEventsPerBatch) > 0) {
+      for (std::optional<PerfEvent>& event : deferred_events_to_process_) {
+        event_processor_.AddEvent(std::move(event.value()));
+      }
+      deferred_events_to_process_.clear();
+    }
+  };
+  while (!ring_buffers_to_read.empty()) {
+    for (PerfEventRingBuffer* ring_buffer : ring_buffers_to_read) {
+      ProcessRecordsWithinBudget(ring_buffer, kRoundRobinPollingBudget);
+      if (!ring_buffer->HasNewData()) {
+        // No more records will be read from this ring buffer.
+        AdvanceRingBufferWatermark(ring_buffer, std::numeric_limits<uint64_t>::max());
+      }
+    }
+    ring_buffers_to_read.erase(
+        std::remove_if(ring_buffers_to_read.begin(), ring_buffers_to_read.end(),
+                       [](PerfEventRingBuffer* ring_buffer) { return !ring_buffer->HasNewData(); }),
+        ring_buffers_to_read.end());
+    move_deferred_events_to_processor();
+    event_processor_.ProcessEventsOlderThan(ComputeLowWatermarkNs());
+    if (parallel_stack_unwinder_ != nullptr) {
+      parallel_stack_unwinder_->ProcessCompletedUnwinds();
+    }
+  }
+  move_deferred_events_to_processor();
+  event_processor_.ProcessAllEvents();
+  if (parallel_stack_unwinder_ != nullptr) {
+    parallel_stack_unwinder_->WaitForAllUnwinds();
+  }
+  stop_run_thread_ = true;
+
+  replay_stats.duration_ns = orbit_base::CaptureTimestampNs() - replay_begin_ns;
+  replay_stats.event_count = event_processor_.GetProcessedEventCount();
+  const std::vector<uint64_t>& visitor_times_ns = event_processor_.GetVisitorTimesNs();
+  ORBIT_CHECK(visitor_times_ns.size() == visitor_names_.size());
+  for (size_t i = 0; i < visitor_names_.size(); ++i) {
+    replay_stats.visitor_times_ns.emplace_back(visitor_names_[i], visitor_times_ns[i]);
+  }
+  Reset();
+  return replay_stats;
+}
+
 uint64_t TracerImpl::ProcessForkEventAndReturnTimestamp(const perf_event_header& header,
                                                         PerfEventRingBuffer* ring_buffer) {
   RingBufferForkExit ring_buffer_record;
@@ -1120,34 +2074,35 @@ uint64_t TracerImpl::ProcessSampleEventAndReturnTimestamp(const perf_event_heade
   }
 
   uint64_t stream_id = ReadSampleRecordStreamId(ring_buffer);
-  bool is_uprobe = uprobes_ids_.contains(stream_id);
-  bool is_uprobe_with_args = uprobes_with_args_ids_.contains(stream_id);
-  bool is_uprobe_with_stack = uprobes_with_stack_ids_.contains(stream_id);
-  bool is_uretprobe = uretprobes_ids_.contains(stream_id);
-  bool is_uretprobe_with_retval = uretprobes_with_retval_ids_.contains(stream_id);
-  bool is_stack_sample = stack_sampling_ids_.contains(stream_id);
-  bool is_callchain_sample = callchain_sampling_ids_.contains(stream_id);
-  bool is_task_newtask = task_newtask_ids_.contains(stream_id);
-  bool is_task_rename = task_rename_ids_.contains(stream_id);
-  bool is_sched_switch = sched_switch_ids_.contains(stream_id);
-  bool is_sched_wakeup = sched_wakeup_ids_.contains(stream_id);
-  bool is_sched_switch_with_callchain = sched_switch_with_callchain_ids_.contains(stream_id);
-  bool is_sched_wakeup_with_callchain = sched_wakeup_with_callchain_ids_.contains(stream_id);
-  bool is_sched_switch_with_stack = sched_switch_with_stack_ids_.contains(stream_id);
-  bool is_sched_wakeup_with_stack = sched_wakeup_with_stack_ids_.contains(stream_id);
-  bool is_amdgpu_cs_ioctl_event = amdgpu_cs_ioctl_ids_.contains(stream_id);
-  bool is_amdgpu_sched_run_job_event = amdgpu_sched_run_job_ids_.contains(stream_id);
-  bool is_dma_fence_signaled_event = dma_fence_signaled_ids_.contains(stream_id);
-  bool is_user_instrumented_tracepoint = ids_to_tracepoint_info_.contains(stream_id);
-
-  ORBIT_CHECK(is_uprobe + is_uprobe_with_args + is_uprobe_with_stack + is_uretprobe +
-                  is_uretprobe_with_retval + is_stack_sample + is_callchain_sample +
-                  is_task_newtask + is_task_rename + is_sched_switch + is_sched_wakeup +
-                  is_sched_switch_with_callchain + is_sched_wakeup_with_callchain +
-                  is_sched_switch_with_stack + is_sched_wakeup_with_stack +
-                  is_amdgpu_cs_ioctl_event + is_amdgpu_sched_run_job_event +
-                  is_dma_fence_signaled_event + is_user_instrumented_tracepoint <=
-              1);
+  // Stream ids are indexed by IndexSampleStreamTypes, which also guarantees that each belongs to at
+  // most one set, so a single lookup is needed per record.
+  const auto type_it = sample_stream_types_by_id_.find(stream_id);
+  const SampleStreamType type =
+      type_it != sample_stream_types_by_id_.end() ? type_it->second : SampleStreamType::kUnknown;
+  const bool is_uprobe = type == SampleStreamType::kUprobe;
+  const bool is_uprobe_with_args = type == SampleStreamType::kUprobeWithArgs;
+  const bool is_uprobe_with_stack = type == SampleStreamType::kUprobeWithStack;
+  const bool is_uretprobe = type == SampleStreamType::kUretprobe;
+  const bool is_uretprobe_with_retval = type == SampleStreamType::kUretprobeWithRetval;
+  const bool is_stack_sample = type == SampleStreamType::kStackSample;
+  const bool is_callchain_sample = type == SampleStreamType::kCallchainSample;
+  const bool is_page_fault_stack_sample = type == SampleStreamType::kPageFaultStackSample;
+  const bool is_page_fault_callchain_sample = type == SampleStreamType::kPageFaultCallchainSample;
+  const bool is_lbr_callstack_sample = type == SampleStreamType::kLbrCallstackSample;
+  const bool is_performance_counter_sample = type == SampleStreamType::kPerformanceCounterSample;
+  const bool is_task_newtask = type == SampleStreamType::kTaskNewtask;
+  const bool is_task_rename = type == SampleStreamType::kTaskRename;
+  const bool is_sched_switch = type == SampleStreamType::kSchedSwitch;
+  const bool is_sched_wakeup = type == SampleStreamType::kSchedWakeup;
+  const bool is_sched_switch_with_callchain = type == SampleStreamType::kSchedSwitchWithCallchain;
+  const bool is_sched_wakeup_with_callchain = type == SampleStreamType::kSchedWakeupWithCallchain;
+  const bool is_sched_switch_with_stack = type == SampleStreamType::kSchedSwitchWithStack;
+  const bool is_sched_wakeup_with_stack = type == SampleStreamType::kSchedWakeupWithStack;
+  const bool is_amdgpu_cs_ioctl_event = type == SampleStreamType::kAmdgpuCsIoctl;
+  const bool is_amdgpu_sched_run_job_event = type == SampleStreamType::kAmdgpuSchedRunJob;
+  const bool is_dma_fence_signaled_event = type == SampleStreamType::kDmaFenceSignaled;
+  const bool is_user_instrumented_tracepoint =
+      type == SampleStreamType::kUserInstrumentedTracepoint;
 
   int fd = ring_buffer->GetFileDescriptor();
 
@@ -1267,7 +2222,7 @@ uint64_t TracerImpl::ProcessSampleEventAndReturnTimestamp(const perf_event_heade
     DeferEvent(event);
     ++stats_.uprobes_count;
 
-  } else if (is_stack_sample) {
+  } else if (is_stack_sample || is_page_fault_stack_sample) {
     pid_t pid = ReadSampleRecordPid(ring_buffer);
 
     const size_t size_of_stack_sample = sizeof(RingBufferStackSampleFixed) +
@@ -1293,10 +2248,15 @@ uint64_t TracerImpl::ProcessSampleEventAndReturnTimestamp(const perf_event_heade
     // in general they seem to produce valid callstacks.
 
     StackSamplePerfEvent event = ConsumeStackSamplePerfEvent(ring_buffer, header);
+    event.data.is_page_fault = is_page_fault_stack_sample;
     DeferEvent(std::move(event));
-    ++stats_.sample_count;
+    if (is_page_fault_stack_sample) {
+      ++stats_.page_fault_sample_count;
+    } else {
+      ++stats_.sample_count;
+    }
 
-  } else if (is_callchain_sample) {
+  } else if (is_callchain_sample || is_page_fault_callchain_sample) {
     pid_t pid = ReadSampleRecordPid(ring_buffer);
 
     if (pid != target_pid_) {
@@ -1304,10 +2264,67 @@ uint64_t TracerImpl::ProcessSampleEventAndReturnTimestamp(const perf_event_heade
       return timestamp_ns;
     }
 
-    PerfEvent event = ConsumeCallchainSamplePerfEvent(ring_buffer, header);
+    CallchainSamplePerfEvent event = ConsumeCallchainSamplePerfEvent(ring_buffer, header);
+    event.data.is_page_fault = is_page_fault_callchain_sample;
+    DeferEvent(std::move(event));
+    if (is_page_fault_callchain_sample) {
+      ++stats_.page_fault_sample_count;
+    } else {
+      ++stats_.sample_count;
+    }
+
+  } else if (is_lbr_callstack_sample) {
+    pid_t pid = ReadSampleRecordPid(ring_buffer);
+
+    if (pid != target_pid_) {
+      ring_buffer->SkipRecord(header);
+      return timestamp_ns;
+    }
+
+    PerfEvent event = ConsumeLbrCallstackSamplePerfEvent(ring_buffer, header);
     DeferEvent(std::move(event));
     ++stats_.sample_count;
 
+  } else if (is_performance_counter_sample) {
+    ORBIT_CHECK(header.size == sizeof(RingBufferPerformanceCounterSample));
+    RingBufferPerformanceCounterSample ring_buffer_record;
+    ring_buffer->ConsumeRecord(header, &ring_buffer_record);
+    ORBIT_CHECK(ring_buffer_record.read.nr == kPerformanceCounterCount + 1);
+    const uint32_t cpu = ring_buffer_record.sample_id.cpu;
+    ORBIT_CHECK(cpu < last_performance_counters_per_cpu_.size());
+
+    // The counters count whatever runs on the CPU, so the samples of all processes update the last
+    // values, even though only the ones of the target process are sent.
+    const RingBufferReadFormatPerformanceCounterGroup counters = ring_buffer_record.read;
+    const std::optional<RingBufferReadFormatPerformanceCounterGroup> previous_counters =
+        std::exchange(last_performance_counters_per_cpu_[cpu], counters);
+    if (!previous_counters.has_value() ||
+        static_cast<pid_t>(ring_buffer_record.sample_id.pid) != target_pid_) {
+      return timestamp_ns;
+    }
+    // The group doesn't count while the kernel multiplexes it out in favor of other hardware
+    // events, in which case there is nothing to report.
+    if (counters.cycles == previous_counters->cycles) {
+      return timestamp_ns;
+    }
+
+    PerformanceCounterSamplePerfEvent event{
+        .timestamp = ring_buffer_record.sample_id.time,
+        .ordered_stream = PerfEventOrderedStream::FileDescriptor(fd),
+        .data =
+            {
+                .pid = static_cast<pid_t>(ring_buffer_record.sample_id.pid),
+                .tid = static_cast<pid_t>(ring_buffer_record.sample_id.tid),
+                .cpu = cpu,
+                .cycles = counters.cycles - previous_counters->cycles,
+                .instructions = counters.instructions - previous_counters->instructions,
+                .cache_misses = counters.cache_misses - previous_counters->cache_misses,
+                .branch_misses = counters.branch_misses - previous_counters->branch_misses,
+            },
+    };
+    DeferEvent(event);
+    ++stats_.performance_counter_sample_count;
+
   } else if (is_task_newtask) {
     ORBIT_CHECK(header.size == sizeof(RingBufferRawSample<TaskNewtaskTracepointData>));
     RingBufferRawSample<TaskNewtaskTracepointData> ring_buffer_record;
@@ -1383,7 +2400,9 @@ uint64_t TracerImpl::ProcessSampleEventAndReturnTimestamp(const perf_event_heade
     // When the switch out is caused by the thread exiting, the sample record's pid is "-1".
     // For simplicity, we accept that we discard the callstack in this case.
     pid_t pid_or_minus_one = ReadSampleRecordPid(ring_buffer);
-    bool copy_stack_related_data = pid_or_minus_one == target_pid_;
+    bool copy_stack_related_data =
+        pid_or_minus_one == target_pid_ &&
+        !drop_thread_state_change_callstacks_.load(std::memory_order_relaxed);
     PerfEvent event = ConsumeSchedSwitchWithOrWithoutCallchainPerfEvent(ring_buffer, header,
                                                                         copy_stack_related_data);
     DeferEvent(std::move(event));
@@ -1391,14 +2410,17 @@ uint64_t TracerImpl::ProcessSampleEventAndReturnTimestamp(const perf_event_heade
 
   } else if (is_sched_wakeup_with_callchain) {
     pid_t pid = ReadSampleRecordPid(ring_buffer);
-    bool copy_stack_related_data = pid == target_pid_;
+    bool copy_stack_related_data =
+        pid == target_pid_ && !drop_thread_state_change_callstacks_.load(std::memory_order_relaxed);
     PerfEvent event = ConsumeSchedWakeupWithOrWithoutCallchainPerfEvent(ring_buffer, header,
                                                                         copy_stack_related_data);
     DeferEvent(std::move(event));
   } else if (is_sched_switch_with_stack) {
     // See comment in "is_sched_switch_with_stack" case above for reasoning about "-1".
     pid_t pid_or_minus_one = ReadSampleRecordPid(ring_buffer);
-    bool copy_stack_related_data = pid_or_minus_one == target_pid_;
+    bool copy_stack_related_data =
+        pid_or_minus_one == target_pid_ &&
+        !drop_thread_state_change_callstacks_.load(std::memory_order_relaxed);
     PerfEvent event =
         ConsumeSchedSwitchWithOrWithoutStackPerfEvent(ring_buffer, header, copy_stack_related_data);
     DeferEvent(std::move(event));
@@ -1406,7 +2428,8 @@ uint64_t TracerImpl::ProcessSampleEventAndReturnTimestamp(const perf_event_heade
 
   } else if (is_sched_wakeup_with_stack) {
     pid_t pid = ReadSampleRecordPid(ring_buffer);
-    bool copy_stack_related_data = pid == target_pid_;
+    bool copy_stack_related_data =
+        pid == target_pid_ && !drop_thread_state_change_callstacks_.load(std::memory_order_relaxed);
     PerfEvent event =
         ConsumeSchedWakeupWithOrWithoutStackPerfEvent(ring_buffer, header, copy_stack_related_data);
     DeferEvent(std::move(event));
@@ -1459,7 +2482,12 @@ uint64_t TracerImpl::ProcessLostEventAndReturnTimestamp(const perf_event_header&
   uint64_t timestamp = ring_buffer_record.sample_id.time;
 
   stats_.lost_count += ring_buffer_record.lost;
-  stats_.lost_count_per_buffer[ring_buffer] += ring_buffer_record.lost;
+  total_lost_count_.fetch_add(ring_buffer_record.lost, std::memory_order_relaxed);
+  ring_buffer_usages_[GetRingBufferIndex(ring_buffer)].lost_record_count += ring_buffer_record.lost;
+  {
+    absl::MutexLock lock{&stats_.lost_count_per_buffer_mutex};
+    stats_.lost_count_per_buffer[ring_buffer] += ring_buffer_record.lost;
+  }
 
   // Fetch the timestamp of the last event that preceded this PERF_RECORD_LOST in this same ring
   // buffer.
@@ -1496,15 +2524,18 @@ uint64_t TracerImpl::ProcessThrottleUnthrottleEventAndReturnTimestamp(
 
   ring_buffer->SkipRecord(header);
 
-  // Simply log throttle/unthrottle events. If they are generated, they are quite low frequency.
+  // Simply log throttle/unthrottle events. They are usually low frequency, but with heavy
+  // throttling they can come in bursts, and this runs on the thread that reads the ring buffers.
   switch (header.type) {
     case PERF_RECORD_THROTTLE:
-      ORBIT_LOG("PERF_RECORD_THROTTLE in ring buffer '%s' at timestamp %u", ring_buffer->GetName(),
-                timestamp_ns);
+      ORBIT_LOG_RATE_LIMITED(absl::Seconds(1),
+                             "PERF_RECORD_THROTTLE in ring buffer '%s' at timestamp %u",
+                             ring_buffer->GetName(), timestamp_ns);
       break;
     case PERF_RECORD_UNTHROTTLE:
-      ORBIT_LOG("PERF_RECORD_UNTHROTTLE in ring buffer '%s' at timestamp %u",
-                ring_buffer->GetName(), timestamp_ns);
+      ORBIT_LOG_RATE_LIMITED(absl::Seconds(1),
+                             "PERF_RECORD_UNTHROTTLE in ring buffer '%s' at timestamp %u",
+                             ring_buffer->GetName(), timestamp_ns);
       break;
     default:
       ORBIT_UNREACHABLE();
@@ -1513,64 +2544,116 @@ uint64_t TracerImpl::ProcessThrottleUnthrottleEventAndReturnTimestamp(
   return timestamp_ns;
 }
 
+size_t TracerImpl::GetRingBufferIndex(const PerfEventRingBuffer* ring_buffer) const {
+  const auto ring_buffer_index = static_cast<size_t>(ring_buffer - ring_buffers_.data());
+  ORBIT_CHECK(ring_buffer_index < ring_buffers_.size());
+  return ring_buffer_index;
+}
+
+void TracerImpl::AdvanceRingBufferWatermark(const PerfEventRingBuffer* ring_buffer,
+                                            uint64_t timestamp_ns) {
+  std::atomic<uint64_t>& watermark_ns = ring_buffer_watermarks_ns_[GetRingBufferIndex(ring_buffer)];
+  // Each ring buffer is only read by one thread, which is also the only one writing its watermark.
+  if (timestamp_ns > watermark_ns.load(std::memory_order_relaxed)) {
+    watermark_ns.store(timestamp_ns, std::memory_order_release);
+  }
+}
+
+uint64_t TracerImpl::ComputeLowWatermarkNs() const {
+  // Events from user space instrumentation don't come from the ring buffers, and GPU events can be
+  // out of order even in the same ring buffer. In these cases, fall back to the processing delay.
+  if (user_space_instrumentation_addresses_ != nullptr || trace_gpu_driver_ ||
+      ring_buffers_.empty()) {
+    return 0;
+  }
+  uint64_t low_watermark_ns = std::numeric_limits<uint64_t>::max();
+  for (size_t i = 0; i < ring_buffers_.size(); ++i) {
+    low_watermark_ns =
+        std::min(low_watermark_ns, ring_buffer_watermarks_ns_[i].load(std::memory_order_acquire));
+  }
+  return low_watermark_ns;
+}
+
 void TracerImpl::DeferEvent(PerfEvent&& event) {
-  absl::MutexLock lock{&deferred_events_being_buffered_mutex_};
-  deferred_events_being_buffered_.emplace_back(std::move(event));
+  deferred_events_.enqueue(std::optional<PerfEvent>{std::move(event)});
 }
 
 void TracerImpl::ProcessDeferredEvents() {
   orbit_base::SetCurrentThreadName("Proc.Def.Events");
+  deferred_events_to_process_.reserve(kMaxDeferredEventsPerBatch);
   bool should_exit = false;
-  while (!should_exit) {
+  while (true) {
     ORBIT_SCOPE("ProcessDeferredEvents iteration");
-    // When "should_exit" becomes true, we know that we have stopped generating
-    // deferred events. The last iteration will consume all remaining events.
-    should_exit = stop_deferred_thread_;
-
-    {
-      absl::MutexLock lock{&deferred_events_being_buffered_mutex_};
-      deferred_events_being_buffered_.swap(deferred_events_to_process_);
-    }
-
-    if (deferred_events_to_process_.empty()) {
-      ORBIT_SCOPE("Sleep");
-      usleep(kIdleTimeOnEmptyDeferredEventsUs);
-      continue;
+    // The reader threads advance the watermarks after deferring the corresponding events, so all
+    // the events older than this watermark have already been enqueued when we dequeue below.
+    uint64_t low_watermark_ns = ComputeLowWatermarkNs();
+    if (!should_exit) {
+      ORBIT_SCOPE("Wait");
+      deferred_events_.wait_dequeue_bulk(std::back_inserter(deferred_events_to_process_),
+                                         kMaxDeferredEventsPerBatch);
+    } else {
+      // All threads generating deferred events have been joined before the end-of-events marker
+      // was enqueued, so this will eventually consume all remaining events.
+      deferred_events_.try_dequeue_bulk(std::back_inserter(deferred_events_to_process_),
+                                        kMaxDeferredEventsPerBatch);
+      if (deferred_events_to_process_.empty()) {
+        break;
+      }
     }
 
     {
-      ORBIT_SCOPE("AddEvents");
-      for (auto& event : deferred_events_to_process_) {
-        event_processor_.AddEvent(std::move(event));
+      ORBIT_SAMPLED_SCOPE(orbit_introspection::kIntrospectionCategoryEventProcessing, "AddEvents",
+                          kTracerLoopScopeOneInN, kTracerLoopScopeMaxPerSecond);
+      for (std::optional<PerfEvent>& event : deferred_events_to_process_) {
+        if (!event.has_value()) {
+          should_exit = true;
+          continue;
+        }
+        event_processor_.AddEvent(std::move(event.value()));
       }
     }
     // Note (https://en.cppreference.com/w/cpp/container/vector/clear): std::vector::clear() "Leaves
-    // the capacity() of the vector unchanged", which is desired as deferred_events_being_buffered_
-    // won't have to be grown again after the swap.
+    // the capacity() of the vector unchanged", which is desired as deferred_events_to_process_
+    // won't have to be grown again by the next batch.
+    // If the batch was full, older events might still be waiting in the queue.
+    if (deferred_events_to_process_.size() >= kMaxDeferredEventsPerBatch) {
+      low_watermark_ns = 0;
+    }
     deferred_events_to_process_.clear();
     {
-      ORBIT_SCOPE("ProcessOldEvents");
-      event_processor_.ProcessOldEvents();
+      ORBIT_SAMPLED_SCOPE(orbit_introspection::kIntrospectionCategoryEventProcessing,
+                          "ProcessOldEvents", kTracerLoopScopeOneInN, kTracerLoopScopeMaxPerSecond);
+      event_processor_.ProcessOldEvents(low_watermark_ns);
+    }
+    if (parallel_stack_unwinder_ != nullptr) {
+      ORBIT_SAMPLED_SCOPE(orbit_introspection::kIntrospectionCategoryEventProcessing,
+                          "ProcessCompletedUnwinds", kTracerLoopScopeOneInN,
+                          kTracerLoopScopeMaxPerSecond);
+      parallel_stack_unwinder_->ProcessCompletedUnwinds();
     }
   }
 }
 
-void TracerImpl::RetrieveInitialTidToPidAssociationSystemWide() {
-  for (pid_t pid : GetAllPids()) {
-    for (pid_t tid : GetTidsOfProcess(pid)) {
-      switches_states_names_visitor_->ProcessInitialTidToPidAssociation(tid, pid);
-    }
+void TracerImpl::ProcessInitialTidToPidAssociations(absl::Span<const ThreadName> threads) {
+  for (const ThreadName& thread : threads) {
+    switches_states_names_visitor_->ProcessInitialTidToPidAssociation(
+        static_cast<pid_t>(thread.tid()), static_cast<pid_t>(thread.pid()));
   }
 }
 
-void TracerImpl::RetrieveInitialThreadStatesOfTarget() {
-  for (pid_t tid : GetTidsOfProcess(target_pid_)) {
-    uint64_t timestamp_ns = orbit_base::CaptureTimestampNs();
-    std::optional<char> state = GetThreadState(tid);
-    if (!state.has_value()) {
-      continue;
+void TracerImpl::RetrieveInitialThreadStates() {
+  std::vector<pid_t> pids = {target_pid_};
+  pids.insert(pids.end(), additional_thread_state_pids_.begin(),
+              additional_thread_state_pids_.end());
+  for (pid_t pid : pids) {
+    for (pid_t tid : GetTidsOfProcess(pid)) {
+      uint64_t timestamp_ns = orbit_base::CaptureTimestampNs();
+      std::optional<char> state = GetThreadState(tid);
+      if (!state.has_value()) {
+        continue;
+      }
+      switches_states_names_visitor_->ProcessInitialState(timestamp_ns, tid, state.value());
     }
-    switches_states_names_visitor_->ProcessInitialState(timestamp_ns, tid, state.value());
   }
 }
 
@@ -1579,14 +2662,23 @@ void TracerImpl::Reset() {
   tracing_fds_by_type_.clear();
   ring_buffers_.clear();
   fds_to_last_timestamp_ns_.clear();
+  ring_buffer_watermarks_ns_.reset();
+  ring_buffer_fill_permilles_.reset();
+  ring_buffer_usages_.clear();
+  perf_record_dump_writer_.reset();
 
   uprobes_uretprobes_ids_to_function_id_.clear();
   uprobes_ids_.clear();
   uprobes_with_args_ids_.clear();
   uretprobes_ids_.clear();
   uretprobes_with_retval_ids_.clear();
+  uprobes_with_stack_ids_.clear();
   stack_sampling_ids_.clear();
   callchain_sampling_ids_.clear();
+  lbr_callstack_sampling_ids_.clear();
+  page_fault_stack_sampling_ids_.clear();
+  page_fault_callchain_sampling_ids_.clear();
+  performance_counter_sampling_ids_.clear();
   task_newtask_ids_.clear();
   task_rename_ids_.clear();
   sched_switch_ids_.clear();
@@ -1599,21 +2691,27 @@ void TracerImpl::Reset() {
   amdgpu_sched_run_job_ids_.clear();
   dma_fence_signaled_ids_.clear();
   ids_to_tracepoint_info_.clear();
+  sample_stream_types_by_id_.clear();
 
   effective_capture_start_timestamp_ns_ = 0;
+  last_performance_counters_per_cpu_.clear();
 
-  stop_deferred_thread_ = false;
-  {
-    absl::MutexLock lock{&deferred_events_being_buffered_mutex_};
-    deferred_events_being_buffered_.clear();
+  while (deferred_events_.try_dequeue_bulk(std::back_inserter(deferred_events_to_process_),
+                                          kMaxDeferredEventsPerBatch) > 0) {
+    deferred_events_to_process_.clear();
   }
   deferred_events_to_process_.clear();
   uprobes_unwinding_visitor_.reset();
+  parallel_stack_unwinder_.reset();
+  unwinding_budget_.reset();
+  switched_sampling_to_frame_pointers_ = false;
   leaf_function_call_manager_.reset();
   return_address_manager_.reset();
   switches_states_names_visitor_.reset();
   gpu_event_visitor_.reset();
+  performance_counter_visitor_.reset();
   event_processor_.ClearVisitors();
+  visitor_names_.clear();
 }
 
 void TracerImpl::PrintStatsIfTimerElapsed() {
@@ -1628,25 +2726,42 @@ void TracerImpl::PrintStatsIfTimerElapsed() {
   ORBIT_CHECK(actual_window_s > 0.0);
 
   ORBIT_LOG("Events per second (and total) last %.3f s:", actual_window_s);
-  ORBIT_LOG("  sched switches: %.0f/s (%lu)", stats_.sched_switch_count / actual_window_s,
-            stats_.sched_switch_count);
-  ORBIT_LOG("  samples: %.0f/s (%lu)", stats_.sample_count / actual_window_s, stats_.sample_count);
-  ORBIT_LOG("  u(ret)probes: %.0f/s (%lu)", stats_.uprobes_count / actual_window_s,
-            stats_.uprobes_count);
-  ORBIT_LOG("  uprobes with stack: %.0f/s (%lu)", stats_.uprobes_with_stack_count / actual_window_s,
-            stats_.uprobes_with_stack_count);
-  ORBIT_LOG("  gpu events: %.0f/s (%lu)", stats_.gpu_events_count / actual_window_s,
-            stats_.gpu_events_count);
-  ORBIT_LOG("  mmap events: %.0f/s (%lu)", stats_.mmap_count / actual_window_s, stats_.mmap_count);
-
-  if (stats_.lost_count_per_buffer.empty()) {
-    ORBIT_LOG("  lost: %.0f/s (%lu)", stats_.lost_count / actual_window_s, stats_.lost_count);
-  } else {
-    ORBIT_LOG("  LOST: %.0f/s (%lu), of which:", stats_.lost_count / actual_window_s,
-              stats_.lost_count);
-    for (const auto& buffer_and_lost_count : stats_.lost_count_per_buffer) {
-      ORBIT_LOG("    from %s: %.0f/s (%lu)", buffer_and_lost_count.first->GetName().c_str(),
-                buffer_and_lost_count.second / actual_window_s, buffer_and_lost_count.second);
+  uint64_t sched_switch_count = stats_.sched_switch_count;
+  ORBIT_LOG("  sched switches: %.0f/s (%lu)", sched_switch_count / actual_window_s,
+            sched_switch_count);
+  uint64_t sample_count = stats_.sample_count;
+  ORBIT_LOG("  samples: %.0f/s (%lu)", sample_count / actual_window_s, sample_count);
+  if (page_fault_sampling_period_ > 0) {
+    uint64_t page_fault_sample_count = stats_.page_fault_sample_count;
+    ORBIT_LOG("  page fault samples: %.0f/s (%lu)", page_fault_sample_count / actual_window_s,
+              page_fault_sample_count);
+  }
+  if (!performance_counter_sampling_ids_.empty()) {
+    uint64_t performance_counter_sample_count = stats_.performance_counter_sample_count;
+    ORBIT_LOG("  performance counter samples: %.0f/s (%lu)",
+              performance_counter_sample_count / actual_window_s, performance_counter_sample_count);
+  }
+  uint64_t uprobes_count = stats_.uprobes_count;
+  ORBIT_LOG("  u(ret)probes: %.0f/s (%lu)", uprobes_count / actual_window_s, uprobes_count);
+  uint64_t uprobes_with_stack_count = stats_.uprobes_with_stack_count;
+  ORBIT_LOG("  uprobes with stack: %.0f/s (%lu)", uprobes_with_stack_count / actual_window_s,
+            uprobes_with_stack_count);
+  uint64_t gpu_events_count = stats_.gpu_events_count;
+  ORBIT_LOG("  gpu events: %.0f/s (%lu)", gpu_events_count / actual_window_s, gpu_events_count);
+  uint64_t mmap_count = stats_.mmap_count;
+  ORBIT_LOG("  mmap events: %.0f/s (%lu)", mmap_count / actual_window_s, mmap_count);
+
+  uint64_t lost_count = stats_.lost_count;
+  {
+    absl::MutexLock lock{&stats_.lost_count_per_buffer_mutex};
+    if (stats_.lost_count_per_buffer.empty()) {
+      ORBIT_LOG("  lost: %.0f/s (%lu)", lost_count / actual_window_s, lost_count);
+    } else {
+      ORBIT_LOG("  LOST: %.0f/s (%lu), of which:", lost_count / actual_window_s, lost_count);
+      for (const auto& buffer_and_lost_count : stats_.lost_count_per_buffer) {
+        ORBIT_LOG("    from %s: %.0f/s (%lu)", buffer_and_lost_count.first->GetName().c_str(),
+                  buffer_and_lost_count.second / actual_window_s, buffer_and_lost_count.second);
+      }
     }
   }
 
@@ -1656,21 +2771,51 @@ void TracerImpl::PrintStatsIfTimerElapsed() {
       discarded_out_of_order_count == 0 ? "discarded as out of order" : "DISCARDED AS OUT OF ORDER",
       discarded_out_of_order_count / actual_window_s, discarded_out_of_order_count);
 
-  // Ensure we can divide by 0.0 safely in case stats_.sample_count is zero.
+  // Ensure we can divide by 0.0 safely in case sample_count is zero.
   static_assert(std::numeric_limits<double>::is_iec559);
 
   uint64_t unwind_error_count = stats_.unwind_error_count;
   ORBIT_LOG("  unwind errors: %.0f/s (%lu) [%.1f%%]", unwind_error_count / actual_window_s,
-            unwind_error_count, 100.0 * unwind_error_count / stats_.sample_count);
+            unwind_error_count, 100.0 * unwind_error_count / sample_count);
   uint64_t discarded_samples_in_uretprobes_count = stats_.samples_in_uretprobes_count;
   ORBIT_LOG("  samples in u(ret)probes: %.0f/s (%lu) [%.1f%%]",
             discarded_samples_in_uretprobes_count / actual_window_s,
             discarded_samples_in_uretprobes_count,
-            100.0 * discarded_samples_in_uretprobes_count / stats_.sample_count);
+            100.0 * discarded_samples_in_uretprobes_count / sample_count);
+
+  if (unwinding_budget_ != nullptr) {
+    UnwindingBudget::WindowStats unwinding_stats =
+        unwinding_budget_->EndWindow(timestamp_ns - stats_.event_count_begin_ns);
+    ORBIT_LOG("  DWARF unwinding: %.2f cores (budget: %.2f)", unwinding_stats.cores,
+              unwinding_budget_->GetMaxCores());
+    const size_t module_count = std::min(unwinding_stats.unwind_error_counts_per_module.size(),
+                                         kMaxModulesWithUnwindErrorsToLog);
+    for (size_t i = 0; i < module_count; ++i) {
+      const auto& [module_name, module_unwind_error_count] =
+          unwinding_stats.unwind_error_counts_per_module[i];
+      ORBIT_LOG("    unwind errors in %s: %lu [%.1f%%]", module_name, module_unwind_error_count,
+                100.0 * module_unwind_error_count / sample_count);
+    }
+    if (unwinding_stats.budget_exceeded && !switched_sampling_to_frame_pointers_) {
+      SwitchSamplingToFramePointers(unwinding_stats.cores);
+    }
+  }
 
   uint64_t thread_state_count = stats_.thread_state_count;
   ORBIT_LOG("  target's thread states: %.0f/s (%lu)", thread_state_count / actual_window_s,
             thread_state_count);
+
+  if (use_ring_buffer_wakeups_) {
+    uint64_t ring_buffer_wakeup_count = stats_.ring_buffer_wakeup_count;
+    uint64_t ring_buffer_wakeup_with_data_count = stats_.ring_buffer_wakeup_with_data_count;
+    uint64_t ring_buffer_wakeup_timeout_count = stats_.ring_buffer_wakeup_timeout_count;
+    ORBIT_LOG("  ring buffer wakeups: %.0f/s (%lu), of which with data: %lu [%.1f%%]",
+              ring_buffer_wakeup_count / actual_window_s, ring_buffer_wakeup_count,
+              ring_buffer_wakeup_with_data_count,
+              100.0 * ring_buffer_wakeup_with_data_count / ring_buffer_wakeup_count);
+    ORBIT_LOG("  ring buffer wait timeouts: %.0f/s (%lu)",
+              ring_buffer_wakeup_timeout_count / actual_window_s, ring_buffer_wakeup_timeout_count);
+  }
   stats_.Reset();
 }
 
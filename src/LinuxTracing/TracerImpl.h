@@ -14,13 +14,16 @@
 #include <sys/types.h>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <limits>
 #include <map>
 #include <memory>
 #include <optional>
+#include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "GpuTracepointVisitor.h"
@@ -34,13 +37,23 @@
 #include "LinuxTracing/UserSpaceInstrumentationAddresses.h"
 #include "LostAndDiscardedEventVisitor.h"
 #include "OrbitBase/Profiling.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/StatsRegistry.h"
+#include "ParallelStackUnwinder.h"
 #include "PerfEvent.h"
+#include "PerfEventOpen.h"
 #include "PerfEventProcessor.h"
+#include "PerfEventRecords.h"
 #include "PerfEventRingBuffer.h"
+#include "PerfRecordDump.h"
+#include "PerformanceCounterVisitor.h"
+#include "RingBufferSizing.h"
 #include "SwitchesStatesNamesVisitor.h"
+#include "UnwindingBudget.h"
 #include "UprobesFunctionCallManager.h"
 #include "UprobesReturnAddressManager.h"
 #include "UprobesUnwindingVisitor.h"
+#include "blockingconcurrentqueue.h"
 
 namespace orbit_linux_tracing {
 
@@ -62,25 +75,65 @@ class TracerImpl : public Tracer {
   void ProcessFunctionEntry(const orbit_grpc_protos::FunctionEntry& function_entry) override;
   void ProcessFunctionExit(const orbit_grpc_protos::FunctionExit& function_exit) override;
 
+  [[nodiscard]] orbit_grpc_protos::UnwindingCacheStats GetUnwindingCacheStats() const override;
+
+  void ReduceSamplingRate(uint32_t factor) override;
+  void DropThreadStateChangeCallstacks() override;
+
+  struct PerfRecordDumpReplayStats {
+    uint64_t record_count = 0;
+    uint64_t event_count = 0;
+    uint64_t duration_ns = 0;
+    // The visitors in the order in which they process each event, with the time spent in them.
+    std::vector<std::pair<std::string, uint64_t>> visitor_times_ns;
+  };
+
+  // Instead of tracing, processes the records in `dump` as fast as possible, passing the resulting
+  // events to the listener like during a capture. `dump` needs to have been recorded with the same
+  // capture options that this TracerImpl was created with. Don't call this together with Start.
+  [[nodiscard]] ErrorMessageOr<PerfRecordDumpReplayStats> ReplayPerfRecordDump(
+      PerfRecordDump dump);
+
  private:
   void Run();
+  // In flight recorder mode, Run calls this instead of reading the ring buffers during the capture.
+  // Waits until the capture is stopped, then processes the records that are still in the ring
+  // buffers, dropping the events older than flight_recorder_duration_ns_.
+  void RunFlightRecorder();
   void Startup();
   void Shutdown();
-  void ProcessOneRecord(PerfEventRingBuffer* ring_buffer);
-  void InitUprobesEventVisitor();
+  // Creates perf_record_dump_writer_ and writes the state that ProcessOneRecord depends on.
+  void StartPerfRecordDump(std::string target_maps);
+  // Returns the sets of stream ids in the order in which they are stored in a PerfRecordDump.
+  [[nodiscard]] std::vector<absl::flat_hash_set<uint64_t>*> GetStreamIdSetsInDumpOrder();
+  // Fills sample_stream_types_by_id_ from the sets of stream ids. Call this once all the file
+  // descriptors have been opened, before the first record is processed.
+  void IndexSampleStreamTypes();
+  // Returns the size of the record that was consumed.
+  uint64_t ProcessOneRecord(PerfEventRingBuffer* ring_buffer);
+  // Consumes records from `ring_buffer` until their cost exceeds `budget` or the buffer is empty.
+  // Returns whether at least one record was consumed.
+  bool ProcessRecordsWithinBudget(PerfEventRingBuffer* ring_buffer, uint64_t budget);
+  // Consumes records from the ring buffers that are close to overflowing, fullest first, until
+  // they are below kNearlyFullRingBufferFraction. Returns whether at least one record was consumed.
+  bool DrainNearlyFullRingBuffers(absl::Span<PerfEventRingBuffer* const> ring_buffers);
+  void InitUprobesEventVisitor(const std::string& target_maps);
   [[nodiscard]] bool OpenUserSpaceProbes(absl::Span<const int32_t> cpus);
   [[nodiscard]] bool OpenUprobesToRecordAdditionalStackOn(absl::Span<const int32_t> cpus);
-  [[nodiscard]] static bool OpenUprobes(const orbit_grpc_protos::InstrumentedFunction& function,
-                                        absl::Span<const int32_t> cpus,
-                                        absl::flat_hash_map<int32_t, int>* fds_per_cpu);
+  [[nodiscard]] bool OpenUprobes(const orbit_grpc_protos::InstrumentedFunction& function,
+                                 absl::Span<const int32_t> cpus,
+                                 absl::flat_hash_map<int32_t, int>* fds_per_cpu) const;
   [[nodiscard]] bool OpenUprobesWithStack(
       const orbit_grpc_protos::FunctionToRecordAdditionalStackOn& function,
       absl::Span<const int32_t> cpus, absl::flat_hash_map<int32_t, int>* fds_per_cpu) const;
-  [[nodiscard]] static bool OpenUretprobes(const orbit_grpc_protos::InstrumentedFunction& function,
-                                           absl::Span<const int32_t> cpus,
-                                           absl::flat_hash_map<int32_t, int>* fds_per_cpu);
+  [[nodiscard]] bool OpenUretprobes(const orbit_grpc_protos::InstrumentedFunction& function,
+                                    absl::Span<const int32_t> cpus,
+                                    absl::flat_hash_map<int32_t, int>* fds_per_cpu) const;
   [[nodiscard]] bool OpenMmapTask(absl::Span<const int32_t> cpus);
   [[nodiscard]] bool OpenSampling(absl::Span<const int32_t> cpus);
+  [[nodiscard]] bool OpenPageFaultSampling(absl::Span<const int32_t> cpus);
+  [[nodiscard]] bool OpenPerformanceCounterSampling(absl::Span<const int32_t> cpus);
+  void InitPerformanceCounterVisitor();
 
   void AddUprobesFileDescriptors(const absl::flat_hash_map<int32_t, int>& uprobes_fds_per_cpu,
                                  const orbit_grpc_protos::InstrumentedFunction& function);
@@ -99,6 +152,42 @@ class TracerImpl : public Tracer {
 
   void InitLostAndDiscardedEventVisitor();
 
+  [[nodiscard]] bool IsFlightRecorderEnabled() const { return flight_recorder_duration_ns_ > 0; }
+  [[nodiscard]] RingBufferOptions ComputeRingBufferOptions(RingBufferType type) const;
+  [[nodiscard]] uint64_t GetRingBufferSizeKb(RingBufferType type) const {
+    return ring_buffer_sizes_kb_[static_cast<size_t>(type)];
+  }
+  [[nodiscard]] RingBufferType GetContextSwitchAndThreadStateRingBufferType() const;
+  // Whether only the callstacks of thread state changes around long enough off-CPU intervals are
+  // unwound and sent, see thread_state_change_callstack_min_off_cpu_duration_ns in capture.proto.
+  [[nodiscard]] bool FiltersThreadStateChangeCallstacksByOffCpuDuration() const;
+  // Fills ring_buffer_sizes_kb_ from the capture options and RingBufferSizeFeedback::GetDefault().
+  void ComputeRingBufferSizes();
+  // Assigns `type` to the ring buffers that were added to ring_buffers_ since the last call.
+  void SetTypeOfNewRingBuffers(RingBufferType type);
+  // Passes how full the ring buffers of each type got, and how many records they lost, to
+  // RingBufferSizeFeedback::GetDefault(), so that the next captures can size them accordingly.
+  void ReportRingBufferUsage() const;
+  void RegisterLiveStats();
+  // Applies the factor requested with ReduceSamplingRate to the period of the sampling file
+  // descriptors. Only called by the thread that owns tracing_fds_by_type_.
+  void ApplyRequestedSamplingRateReduction();
+  // Enables the "sampling_fallback" file descriptors, which sample with frame pointers, and
+  // disables the DWARF "sampling" ones. Called once unwinding_budget_ has been exceeded, by the
+  // thread that owns tracing_fds_by_type_.
+  void SwitchSamplingToFramePointers(double unwinding_cores);
+  // Sends the time spent in each visitor, as measured by event_processor_, to the listener.
+  void ReportPerfEventProcessingStats();
+  // Returns an epoll file descriptor that `ring_buffers` and stop_run_thread_event_fd_ have been
+  // added to, or -1 on error.
+  [[nodiscard]] int CreateRingBuffersEpoll(
+      absl::Span<PerfEventRingBuffer* const> ring_buffers) const;
+
+  [[nodiscard]] std::vector<std::vector<PerfEventRingBuffer*>> AssignRingBuffersToReaderThreads();
+  // Reads from `ring_buffers` until stop_run_thread_ is set. This can run on multiple threads at
+  // the same time, as long as each ring buffer is only passed to one of them.
+  void ReadRingBuffers(absl::Span<PerfEventRingBuffer* const> ring_buffers, bool print_stats);
+
   [[nodiscard]] uint64_t ProcessForkEventAndReturnTimestamp(const perf_event_header& header,
                                                             PerfEventRingBuffer* ring_buffer);
   [[nodiscard]] uint64_t ProcessExitEventAndReturnTimestamp(const perf_event_header& header,
@@ -112,52 +201,101 @@ class TracerImpl : public Tracer {
   [[nodiscard]] static uint64_t ProcessThrottleUnthrottleEventAndReturnTimestamp(
       const perf_event_header& header, PerfEventRingBuffer* ring_buffer);
 
+  [[nodiscard]] size_t GetRingBufferIndex(const PerfEventRingBuffer* ring_buffer) const;
+  // Ring buffer watermarks only increase. Only call this from the thread reading `ring_buffer`.
+  void AdvanceRingBufferWatermark(const PerfEventRingBuffer* ring_buffer, uint64_t timestamp_ns);
+  // Returns a timestamp such that no event older than it will be deferred anymore, or 0 if this
+  // can't be guaranteed.
+  [[nodiscard]] uint64_t ComputeLowWatermarkNs() const;
+
   void DeferEvent(PerfEvent&& event);
   void ProcessDeferredEvents();
 
-  void RetrieveInitialTidToPidAssociationSystemWide();
-  void RetrieveInitialThreadStatesOfTarget();
+  // Passes the tid-to-pid association of each of `threads` to switches_states_names_visitor_.
+  void ProcessInitialTidToPidAssociations(absl::Span<const orbit_grpc_protos::ThreadName> threads);
+  void RetrieveInitialThreadStates();
 
   void PrintStatsIfTimerElapsed();
 
   void Reset();
 
-  // Number of records to read consecutively from a perf_event_open ring buffer
-  // before switching to another one.
-  static constexpr int32_t kRoundRobinPollingBatchSize = 5;
-
-  // These values are supposed to be large enough to accommodate enough events
-  // in case TracerThread::Run's thread is not scheduled for a few tens of
-  // milliseconds.
-  static constexpr uint64_t kUprobesRingBufferSizeKb = 8 * 1024;
-  static constexpr uint64_t kMmapTaskRingBufferSizeKb = 64;
-  static constexpr uint64_t kSamplingRingBufferSizeKb = 16 * 1024;
-  static constexpr uint64_t kThreadNamesRingBufferSizeKb = 64;
-  static constexpr uint64_t kContextSwitchesAndThreadStateRingBufferSizeKb = 2 * 1024;
-  static constexpr uint64_t kContextSwitchesAndThreadStateWithStacksRingBufferSizeKb = 64 * 1024;
-  static constexpr uint64_t kGpuTracingRingBufferSizeKb = 256;
-  static constexpr uint64_t kInstrumentedTracepointsRingBufferSizeKb = 8 * 1024;
-  static constexpr uint64_t kUprobesWithStackRingBufferSizeKb = 64 * 1024;
+  // Records are read from the perf_event_open ring buffers in a round-robin fashion: from each
+  // buffer, records are read consecutively until their cost exceeds this budget. The cost of a
+  // record is its size plus kRecordProcessingBaseCost, which approximates the overhead that every
+  // record has independently of its size. This way, a large stack sample uses up most of the
+  // budget, while many small records like context switches can be read in one go.
+  static constexpr uint64_t kRoundRobinPollingBudget = 64 * 1024;
+  static constexpr uint64_t kRecordProcessingBaseCost = 256;
+  // Before each round-robin pass, ring buffers with more than this fraction of their size unread
+  // are drained first, in decreasing order of fill level.
+  static constexpr double kNearlyFullRingBufferFraction = 0.5;
+
+  // Maximum number of DWARF unwinding results that LibunwindstackUnwinder keeps for reuse.
+  static constexpr size_t kUnwindingCacheCapacity = 4096;
+
+  // Fraction of the unwinding threads (or of one core, without ParallelStackUnwinder) that DWARF
+  // unwinding may keep busy before sampling falls back to frame pointers.
+  static constexpr double kUnwindingBudgetCoresPerUnwindingThread = 0.8;
+  // Number of modules with the most unwinding errors that PrintStatsIfTimerElapsed logs.
+  static constexpr size_t kMaxModulesWithUnwindErrorsToLog = 5;
 
   static constexpr uint32_t kIdleTimeOnEmptyRingBuffersUs = 5000;
-  static constexpr uint32_t kIdleTimeOnEmptyDeferredEventsUs = 5000;
+
+  // When use_ring_buffer_wakeups_ is set, the kernel wakes up Run's thread every time a ring buffer
+  // has been filled by this fraction of its size since the last wakeup.
+  static constexpr uint64_t kRingBufferWakeupWatermarkFraction = 16;
+  // Records in ring buffers that don't reach their watermark still need to be read well before
+  // PerfEventProcessor::kProcessingDelayMs has elapsed, so don't block longer than this.
+  static constexpr int kMaxRingBufferWakeupWaitMs = 50;
+  // Maximum number of deferred events that ProcessDeferredEvents moves to event_processor_ before
+  // calling PerfEventProcessor::ProcessOldEvents.
+  static constexpr size_t kMaxDeferredEventsPerBatch = 4096;
+  // When a ring buffer is found empty, records with a timestamp older than the time of the read
+  // minus this slack are assumed to have been read already. The slack accounts for the time between
+  // the kernel taking the timestamp of a record and making the record visible in the ring buffer.
+  static constexpr uint64_t kEmptyRingBufferWatermarkSlackNs = 20'000'000;
+  // In flight recorder mode, how often RunFlightRecorder checks whether the capture was stopped.
+  static constexpr uint32_t kFlightRecorderStopCheckIntervalUs = 100'000;
+  // The introspection scopes of the loops of Run and ProcessDeferredEvents only record one in this
+  // many iterations, and at most this many iterations per second.
+  static constexpr uint32_t kTracerLoopScopeOneInN = 16;
+  static constexpr uint32_t kTracerLoopScopeMaxPerSecond = 200;
 
   bool trace_context_switches_;
   bool introspection_enabled_;
   pid_t target_pid_;
+  std::vector<pid_t> additional_thread_state_pids_;
   std::optional<uint64_t> sampling_period_ns_;
+  std::atomic<uint32_t> requested_sampling_rate_reduction_factor_ = 1;
+  uint32_t applied_sampling_rate_reduction_factor_ = 1;
+  // One in every page_fault_sampling_period_ minor page faults is sampled. 0 means never.
+  uint64_t page_fault_sampling_period_;
+  // Whether a group of hardware performance counters is sampled along with the callstacks.
+  bool sample_performance_counters_;
   uint16_t stack_dump_size_;
   orbit_grpc_protos::CaptureOptions::UnwindingMethod unwinding_method_;
   orbit_grpc_protos::CaptureOptions::ThreadStateChangeCallStackCollection
       thread_state_change_callstack_collection_;
   uint16_t thread_state_change_callstack_stack_dump_size_;
+  uint64_t thread_state_change_callstack_min_off_cpu_duration_ns_;
+  std::atomic<bool> drop_thread_state_change_callstacks_ = false;
   std::vector<orbit_grpc_protos::InstrumentedFunction> instrumented_functions_;
   std::vector<orbit_grpc_protos::FunctionToRecordAdditionalStackOn>
       functions_to_record_additional_stack_on_;
   std::map<uint64_t, uint64_t> absolute_address_to_size_of_functions_to_stop_unwinding_at_;
   bool trace_thread_state_;
   bool trace_gpu_driver_;
+  bool use_ring_buffer_wakeups_;
+  uint32_t ring_buffer_reader_thread_count_;
+  uint32_t unwinding_thread_count_;
+  // In flight recorder mode, the ring buffers are overwritten and only read when the capture is
+  // stopped. 0 means that flight recorder mode is disabled.
+  uint64_t flight_recorder_duration_ns_;
   std::vector<orbit_grpc_protos::TracepointInfo> instrumented_tracepoints_;
+  // When not empty, all records read from the ring buffers are also written to this file.
+  std::string perf_record_dump_path_;
+  // The capture options that are stored in the perf record dump, without perf_record_dump_path.
+  orbit_grpc_protos::CaptureOptions perf_record_dump_capture_options_;
 
   std::unique_ptr<UserSpaceInstrumentationAddresses> user_space_instrumentation_addresses_;
 
@@ -165,10 +303,29 @@ class TracerImpl : public Tracer {
 
   std::atomic<bool> stop_run_thread_ = true;
   std::thread run_thread_;
+  // Only used with use_ring_buffer_wakeups_: written by Stop to interrupt the reader threads
+  // waiting for ring buffer wakeups.
+  int stop_run_thread_event_fd_ = -1;
 
   absl::flat_hash_map<std::string, std::vector<int>> tracing_fds_by_type_;
+  std::array<uint64_t, kRingBufferTypeCount> ring_buffer_sizes_kb_{};
   std::vector<PerfEventRingBuffer> ring_buffers_;
+  struct RingBufferUsage {
+    RingBufferType type;
+    uint64_t lost_record_count = 0;
+    uint64_t max_unread_size = 0;
+  };
+  // Indexed like ring_buffers_. Each entry is only updated by the thread reading that ring buffer.
+  std::vector<RingBufferUsage> ring_buffer_usages_;
+  // Entries are added before the reader threads start, which then only modify the values.
   absl::flat_hash_map<int, uint64_t> fds_to_last_timestamp_ns_;
+  // Indexed like ring_buffers_ and allocated by Run. For each ring buffer, the reader thread
+  // guarantees that no record older than this timestamp will be read from it anymore.
+  std::unique_ptr<std::atomic<uint64_t>[]> ring_buffer_watermarks_ns_;
+  // Indexed like ring_buffers_ and allocated by Run. The fill level, in thousandths, of each ring
+  // buffer the last time its reader thread looked at it, for the live stats.
+  std::unique_ptr<std::atomic<uint64_t>[]> ring_buffer_fill_permilles_;
+  std::unique_ptr<PerfRecordDumpWriter> perf_record_dump_writer_;
 
   absl::flat_hash_map<uint64_t, uint64_t> uprobes_uretprobes_ids_to_function_id_;
   absl::flat_hash_set<uint64_t> uprobes_ids_;
@@ -178,6 +335,10 @@ class TracerImpl : public Tracer {
   absl::flat_hash_set<uint64_t> uretprobes_with_retval_ids_;
   absl::flat_hash_set<uint64_t> stack_sampling_ids_;
   absl::flat_hash_set<uint64_t> callchain_sampling_ids_;
+  absl::flat_hash_set<uint64_t> lbr_callstack_sampling_ids_;
+  absl::flat_hash_set<uint64_t> page_fault_stack_sampling_ids_;
+  absl::flat_hash_set<uint64_t> page_fault_callchain_sampling_ids_;
+  absl::flat_hash_set<uint64_t> performance_counter_sampling_ids_;
   absl::flat_hash_set<uint64_t> task_newtask_ids_;
   absl::flat_hash_set<uint64_t> task_rename_ids_;
   absl::flat_hash_set<uint64_t> sched_switch_ids_;
@@ -191,59 +352,122 @@ class TracerImpl : public Tracer {
   absl::flat_hash_set<uint64_t> dma_fence_signaled_ids_;
   absl::flat_hash_map<uint64_t, orbit_grpc_protos::TracepointInfo> ids_to_tracepoint_info_;
 
+  // How the samples of each stream id are handled. This is the union of the sets above, so that
+  // ProcessSampleEventAndReturnTimestamp only needs a single lookup per record.
+  enum class SampleStreamType {
+    kUnknown,
+    kUprobe,
+    kUprobeWithArgs,
+    kUprobeWithStack,
+    kUretprobe,
+    kUretprobeWithRetval,
+    kStackSample,
+    kCallchainSample,
+    kLbrCallstackSample,
+    kPageFaultStackSample,
+    kPageFaultCallchainSample,
+    kPerformanceCounterSample,
+    kTaskNewtask,
+    kTaskRename,
+    kSchedSwitch,
+    kSchedWakeup,
+    kSchedSwitchWithCallchain,
+    kSchedWakeupWithCallchain,
+    kSchedSwitchWithStack,
+    kSchedWakeupWithStack,
+    kAmdgpuCsIoctl,
+    kAmdgpuSchedRunJob,
+    kDmaFenceSignaled,
+    kUserInstrumentedTracepoint,
+  };
+  absl::flat_hash_map<uint64_t, SampleStreamType> sample_stream_types_by_id_;
+
   uint64_t effective_capture_start_timestamp_ns_ = 0;
 
-  std::atomic<bool> stop_deferred_thread_ = false;
-  std::vector<PerfEvent> deferred_events_being_buffered_
-      ABSL_GUARDED_BY(deferred_events_being_buffered_mutex_);
-  absl::Mutex deferred_events_being_buffered_mutex_;
-  std::vector<PerfEvent> deferred_events_to_process_;
+  // Indexed by CPU and sized by OpenPerformanceCounterSampling. The values of the performance
+  // counter group of each CPU at its last sample, from which the next sample computes the
+  // increases.
+  // Each entry is only accessed by the thread reading the ring buffers of that CPU.
+  std::vector<std::optional<RingBufferReadFormatPerformanceCounterGroup>>
+      last_performance_counters_per_cpu_;
+
+  // Events are handed from the threads reading the ring buffers to ProcessDeferredEvents through
+  // this queue. An empty optional is enqueued by Run to signal that no more events will follow.
+  moodycamel::BlockingConcurrentQueue<std::optional<PerfEvent>> deferred_events_;
+  std::vector<std::optional<PerfEvent>> deferred_events_to_process_;
 
   UprobesFunctionCallManager function_call_manager_;
   std::optional<UprobesReturnAddressManager> return_address_manager_;
   std::unique_ptr<LibunwindstackMaps> maps_;
   std::unique_ptr<LibunwindstackUnwinder> unwinder_;
+  std::unique_ptr<ParallelStackUnwinder> parallel_stack_unwinder_;
+  // Only set when sampling with DWARF unwinding.
+  std::unique_ptr<UnwindingBudget> unwinding_budget_;
+  bool switched_sampling_to_frame_pointers_ = false;
   std::unique_ptr<LeafFunctionCallManager> leaf_function_call_manager_;
   std::unique_ptr<UprobesUnwindingVisitor> uprobes_unwinding_visitor_;
   std::unique_ptr<SwitchesStatesNamesVisitor> switches_states_names_visitor_;
   std::unique_ptr<GpuTracepointVisitor> gpu_event_visitor_;
   std::unique_ptr<LostAndDiscardedEventVisitor> lost_and_discarded_event_visitor_;
+  std::unique_ptr<PerformanceCounterVisitor> performance_counter_visitor_;
   PerfEventProcessor event_processor_;
+  // The names of the visitors added to event_processor_, in the same order.
+  std::vector<std::string> visitor_names_;
 
   struct EventStats {
     void Reset() {
       event_count_begin_ns = orbit_base::CaptureTimestampNs();
       sched_switch_count = 0;
       sample_count = 0;
+      page_fault_sample_count = 0;
+      performance_counter_sample_count = 0;
       uprobes_count = 0;
       uprobes_with_stack_count = 0;
       gpu_events_count = 0;
       mmap_count = 0;
       lost_count = 0;
-      lost_count_per_buffer.clear();
+      {
+        absl::MutexLock lock{&lost_count_per_buffer_mutex};
+        lost_count_per_buffer.clear();
+      }
       discarded_out_of_order_count = 0;
       unwind_error_count = 0;
       samples_in_uretprobes_count = 0;
       thread_state_count = 0;
+      ring_buffer_wakeup_count = 0;
+      ring_buffer_wakeup_timeout_count = 0;
+      ring_buffer_wakeup_with_data_count = 0;
     }
 
+    // The counters are updated by all the reader threads.
     uint64_t event_count_begin_ns = 0;
-    uint64_t sched_switch_count = 0;
-    uint64_t sample_count = 0;
-    uint64_t uprobes_count = 0;
-    uint64_t uprobes_with_stack_count = 0;
-    uint64_t gpu_events_count = 0;
-    uint64_t mmap_count = 0;
-    uint64_t lost_count = 0;
-    absl::flat_hash_map<PerfEventRingBuffer*, uint64_t> lost_count_per_buffer{};
+    std::atomic<uint64_t> sched_switch_count = 0;
+    std::atomic<uint64_t> sample_count = 0;
+    std::atomic<uint64_t> page_fault_sample_count = 0;
+    std::atomic<uint64_t> performance_counter_sample_count = 0;
+    std::atomic<uint64_t> uprobes_count = 0;
+    std::atomic<uint64_t> uprobes_with_stack_count = 0;
+    std::atomic<uint64_t> gpu_events_count = 0;
+    std::atomic<uint64_t> mmap_count = 0;
+    std::atomic<uint64_t> lost_count = 0;
+    absl::Mutex lost_count_per_buffer_mutex;
+    absl::flat_hash_map<PerfEventRingBuffer*, uint64_t> lost_count_per_buffer
+        ABSL_GUARDED_BY(lost_count_per_buffer_mutex){};
     std::atomic<uint64_t> discarded_out_of_order_count = 0;
     std::atomic<uint64_t> unwind_error_count = 0;
     std::atomic<uint64_t> samples_in_uretprobes_count = 0;
     std::atomic<uint64_t> thread_state_count = 0;
+    std::atomic<uint64_t> ring_buffer_wakeup_count = 0;
+    std::atomic<uint64_t> ring_buffer_wakeup_timeout_count = 0;
+    std::atomic<uint64_t> ring_buffer_wakeup_with_data_count = 0;
   };
 
   static constexpr uint64_t kEventStatsWindowS = 5;
   EventStats stats_{};
+  // Unlike stats_.lost_count, this is not reset periodically.
+  std::atomic<uint64_t> total_lost_count_ = 0;
+  // The counters published to StatsRegistry::GetDefault() while Run is running.
+  std::vector<orbit_base::StatsRegistry::Registration> live_stats_registrations_;
 
   static constexpr uint64_t kNsPerSecond = 1'000'000'000;
 };
@@ -0,0 +1,44 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "UnwindingBudget.h"
+
+#include <algorithm>
+
+namespace orbit_linux_tracing {
+
+void UnwindingBudget::AddUnwindingError(const std::string& module_name) {
+  absl::MutexLock lock{&unwind_error_counts_mutex_};
+  ++unwind_error_counts_per_module_[module_name];
+}
+
+UnwindingBudget::WindowStats UnwindingBudget::EndWindow(uint64_t window_duration_ns) {
+  WindowStats stats;
+  stats.unwinding_time_ns = unwinding_time_ns_.exchange(0, std::memory_order_relaxed);
+  if (window_duration_ns > 0) {
+    stats.cores =
+        static_cast<double>(stats.unwinding_time_ns) / static_cast<double>(window_duration_ns);
+  }
+
+  {
+    absl::MutexLock lock{&unwind_error_counts_mutex_};
+    stats.unwind_error_counts_per_module.assign(unwind_error_counts_per_module_.begin(),
+                                                unwind_error_counts_per_module_.end());
+    unwind_error_counts_per_module_.clear();
+  }
+  std::sort(stats.unwind_error_counts_per_module.begin(),
+            stats.unwind_error_counts_per_module.end(), [](const auto& lhs, const auto& rhs) {
+              return lhs.second > rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+            });
+
+  if (stats.cores > max_cores_) {
+    ++consecutive_windows_over_budget_;
+  } else {
+    consecutive_windows_over_budget_ = 0;
+  }
+  stats.budget_exceeded = consecutive_windows_over_budget_ >= kWindowsOverBudgetBeforeExceeded;
+  return stats;
+}
+
+}  // namespace orbit_linux_tracing
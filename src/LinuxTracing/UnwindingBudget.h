@@ -0,0 +1,67 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_UNWINDING_BUDGET_H_
+#define LINUX_TRACING_UNWINDING_BUDGET_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace orbit_linux_tracing {
+
+// Measures the CPU time spent unwinding stacks with DWARF information against a budget, and counts
+// the unwinding errors per module, i.e., per module of the frame at which unwinding stopped. The
+// time is summed over all threads that unwind, so `max_cores` is the number of cores unwinding can
+// keep busy on average, e.g., the number of threads of ParallelStackUnwinder. When DWARF unwinding
+// exceeds the budget over several consecutive windows, the service can't keep up with the samples
+// and falls behind, which TracerImpl prevents by falling back to frame-pointer sampling.
+// AddUnwindingTime and AddUnwindingError are thread-safe, EndWindow must be called from one thread.
+class UnwindingBudget {
+ public:
+  // The budget needs to be exceeded for this many consecutive windows, so that short bursts of
+  // samples, e.g., in code whose unwind information isn't cached yet, don't trigger the fallback.
+  static constexpr uint32_t kWindowsOverBudgetBeforeExceeded = 2;
+
+  explicit UnwindingBudget(double max_cores) : max_cores_{max_cores} {}
+
+  [[nodiscard]] double GetMaxCores() const { return max_cores_; }
+
+  void AddUnwindingTime(uint64_t duration_ns) {
+    unwinding_time_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+  }
+  void AddUnwindingError(const std::string& module_name);
+
+  struct WindowStats {
+    uint64_t unwinding_time_ns = 0;
+    // The average number of cores used for unwinding during the window.
+    double cores = 0.0;
+    // Sorted by decreasing count.
+    std::vector<std::pair<std::string, uint64_t>> unwind_error_counts_per_module;
+    // Whether the budget was exceeded for kWindowsOverBudgetBeforeExceeded consecutive windows.
+    bool budget_exceeded = false;
+  };
+
+  // Returns the statistics of the window of `window_duration_ns` that ends now, and starts the
+  // next one.
+  [[nodiscard]] WindowStats EndWindow(uint64_t window_duration_ns);
+
+ private:
+  const double max_cores_;
+  uint32_t consecutive_windows_over_budget_ = 0;
+  std::atomic<uint64_t> unwinding_time_ns_ = 0;
+  absl::Mutex unwind_error_counts_mutex_;
+  absl::flat_hash_map<std::string, uint64_t> unwind_error_counts_per_module_
+      ABSL_GUARDED_BY(unwind_error_counts_mutex_);
+};
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_UNWINDING_BUDGET_H_
@@ -0,0 +1,65 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "UnwindingBudget.h"
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::Pair;
+
+namespace orbit_linux_tracing {
+
+namespace {
+constexpr uint64_t kWindowDurationNs = 1'000'000'000;
+}  // namespace
+
+TEST(UnwindingBudget, IsExceededAfterConsecutiveWindowsOverBudget) {
+  UnwindingBudget budget{/*max_cores=*/1.5};
+
+  // Two threads each unwinding for most of the window.
+  budget.AddUnwindingTime(900'000'000);
+  budget.AddUnwindingTime(900'000'000);
+  UnwindingBudget::WindowStats stats = budget.EndWindow(kWindowDurationNs);
+  EXPECT_EQ(stats.unwinding_time_ns, 1'800'000'000);
+  EXPECT_DOUBLE_EQ(stats.cores, 1.8);
+  EXPECT_FALSE(stats.budget_exceeded);
+
+  // A window under the budget resets the count of consecutive windows over it.
+  budget.AddUnwindingTime(1'000'000'000);
+  stats = budget.EndWindow(kWindowDurationNs);
+  EXPECT_DOUBLE_EQ(stats.cores, 1.0);
+  EXPECT_FALSE(stats.budget_exceeded);
+
+  for (uint32_t i = 0; i < UnwindingBudget::kWindowsOverBudgetBeforeExceeded - 1; ++i) {
+    budget.AddUnwindingTime(2'000'000'000);
+    EXPECT_FALSE(budget.EndWindow(kWindowDurationNs).budget_exceeded);
+  }
+  budget.AddUnwindingTime(2'000'000'000);
+  EXPECT_TRUE(budget.EndWindow(kWindowDurationNs).budget_exceeded);
+}
+
+TEST(UnwindingBudget, CountsUnwindingErrorsPerModule) {
+  UnwindingBudget budget{/*max_cores=*/1.0};
+  budget.AddUnwindingError("/path/to/libfoo.so");
+  budget.AddUnwindingError("/path/to/libbar.so");
+  budget.AddUnwindingError("/path/to/libfoo.so");
+  budget.AddUnwindingError("/path/to/libbaz.so");
+
+  UnwindingBudget::WindowStats stats = budget.EndWindow(kWindowDurationNs);
+  EXPECT_EQ(stats.unwinding_time_ns, 0);
+  EXPECT_THAT(stats.unwind_error_counts_per_module,
+              ElementsAre(Pair("/path/to/libfoo.so", 2), Pair("/path/to/libbar.so", 1),
+                          Pair("/path/to/libbaz.so", 1)));
+
+  EXPECT_THAT(budget.EndWindow(kWindowDurationNs).unwind_error_counts_per_module, IsEmpty());
+}
+
+}  // namespace orbit_linux_tracing
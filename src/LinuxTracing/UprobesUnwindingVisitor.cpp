@@ -5,6 +5,7 @@
 #include "UprobesUnwindingVisitor.h"
 
 #include <absl/types/span.h>
+#include <asm/perf_regs.h>
 #include <sys/mman.h>
 #include <unwindstack/MapInfo.h>
 #include <unwindstack/Object.h>
@@ -13,6 +14,7 @@
 #include <unwindstack/Unwinder.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -20,12 +22,15 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <variant>
+#include <vector>
 
 #include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/module.pb.h"
 #include "LibunwindstackMultipleOfflineAndProcessMemory.h"
 #include "ModuleUtils/ReadLinuxModules.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
 #include "OrbitBase/Result.h"
 #include "PerfEvent.h"
 #include "unwindstack/Arch.h"
@@ -37,9 +42,12 @@ namespace orbit_linux_tracing {
 using orbit_grpc_protos::Callstack;
 using orbit_grpc_protos::FullAddressInfo;
 using orbit_grpc_protos::FullCallstackSample;
+using orbit_grpc_protos::FullPageFaultSample;
 using orbit_grpc_protos::FunctionCall;
 using orbit_grpc_protos::ThreadStateSliceCallstack;
 
+static const std::string kUnknownModuleName{"[unknown]"};
+
 static bool CallstackIsInUserSpaceInstrumentation(
     absl::Span<const unwindstack::FrameData> frames,
     const UserSpaceInstrumentationAddresses& user_space_instrumentation_addresses) {
@@ -215,19 +223,66 @@ UprobesUnwindingVisitor::ComputeCallstackTypeFromStackSample(
     if (unwind_error_counter_ != nullptr) {
       ++(*unwind_error_counter_);
     }
+    if (unwinding_budget_ != nullptr) {
+      // Unwinding usually stops at the frame whose module lacks the unwind information.
+      const unwindstack::FrameData& last_frame = libunwindstack_result.frames().back();
+      if (last_frame.map_info != nullptr) {
+        unwinding_budget_->AddUnwindingError(last_frame.map_info->name());
+      } else {
+        unwinding_budget_->AddUnwindingError(kUnknownModuleName);
+      }
+    }
     return Callstack::kDwarfUnwindingError;
   }
 
   return Callstack::kComplete;
 }
 
-template <typename StackPerfEventDataT>
-bool UprobesUnwindingVisitor::UnwindStack(const StackPerfEventDataT& event_data,
-                                          Callstack* resulting_callstack,
-                                          bool offline_memory_only) {
-  ORBIT_CHECK(listener_ != nullptr);
-  ORBIT_CHECK(current_maps_ != nullptr);
+bool UprobesUnwindingVisitor::FillCallstackFromLibunwindstackResult(
+    const LibunwindstackResult& libunwindstack_result, Callstack* resulting_callstack) {
+  if (libunwindstack_result.frames().empty()) {
+    // Even with unwinding errors this is not expected because we should at least get the program
+    // counter. Do nothing in case this doesn't hold for a reason we don't know.
+    ORBIT_ERROR("Unwound callstack has no frames");
+    return false;
+  }
 
+  resulting_callstack->set_type(ComputeCallstackTypeFromStackSample(libunwindstack_result));
+  for (const unwindstack::FrameData& libunwindstack_frame : libunwindstack_result.frames()) {
+    SendFullAddressInfoToListener(libunwindstack_frame);
+    resulting_callstack->add_pcs(libunwindstack_frame.pc);
+  }
+
+  ORBIT_CHECK(!resulting_callstack->pcs().empty());
+  return true;
+}
+
+// The stack slices are copied, as neither the event nor the slices of user stack collected with
+// uprobes outlive the visit of the event.
+[[nodiscard]] static ParallelStackUnwinder::Request CreateUnwindRequest(
+    pid_t pid, unwindstack::Maps* maps,
+    const std::array<uint64_t, PERF_REG_X86_64_MAX>& registers,
+    const std::vector<StackSliceView>& stack_slices, bool offline_memory_only) {
+  ParallelStackUnwinder::Request request{.pid = pid,
+                                         .maps = maps,
+                                         .registers = registers,
+                                         .stack_slices = {},
+                                         .offline_memory_only = offline_memory_only};
+  request.stack_slices.reserve(stack_slices.size());
+  for (const StackSliceView& stack_slice : stack_slices) {
+    const uint8_t* data = stack_slice.data();
+    request.stack_slices.push_back(ParallelStackUnwinder::StackSlice{
+        .start_address = stack_slice.start_address(),
+        .data = std::vector<uint8_t>(data, data + stack_slice.size())});
+  }
+  return request;
+}
+
+template <typename StackPerfEventDataT>
+std::vector<StackSliceView> UprobesUnwindingVisitor::PatchAndCollectStackSlices(
+    const StackPerfEventDataT& event_data) {
+  // Patching depends on the dynamically instrumented functions the thread is in at the time of the
+  // sample, so this always needs to happen in order, even when unwinding itself doesn't.
   return_address_manager_->PatchSample(event_data.GetCallstackTid(), event_data.GetRegisters().sp,
                                        event_data.GetMutableStackData(), event_data.GetStackSize());
 
@@ -242,6 +297,16 @@ bool UprobesUnwindingVisitor::UnwindStack(const StackPerfEventDataT& event_data,
                                 user_stack_slice.data.get());
     }
   }
+  return stack_slices;
+}
+
+template <typename StackPerfEventDataT, typename OnCallstackT>
+void UprobesUnwindingVisitor::UnwindStack(const StackPerfEventDataT& event_data,
+                                          bool offline_memory_only, OnCallstackT on_callstack) {
+  ORBIT_CHECK(listener_ != nullptr);
+  ORBIT_CHECK(current_maps_ != nullptr);
+
+  const std::vector<StackSliceView> stack_slices = PatchAndCollectStackSlices(event_data);
 
   // There might be rare cases where the callstack's pid is "-1". This happens on callstacks on
   // "sched out" switches where the thread exits. This is not a big problem for unwinding, as
@@ -250,73 +315,151 @@ bool UprobesUnwindingVisitor::UnwindStack(const StackPerfEventDataT& event_data,
   // But this is not likely to happen.
   // TODO(b/246519821) It would be possible to retrieve the information from
   //  SwitchesStatesNamesVisitor::GetPidOfTid, but this requires major refactoring.
+  if (parallel_stack_unwinder_ != nullptr) {
+    parallel_stack_unwinder_->Submit(
+        CreateUnwindRequest(event_data.GetCallstackPidOrMinusOne(), current_maps_->Get(),
+                            event_data.GetRegistersAsArray(), stack_slices, offline_memory_only),
+        [this, on_callstack = std::move(on_callstack)](
+            const LibunwindstackResult& libunwindstack_result) {
+          Callstack callstack;
+          if (FillCallstackFromLibunwindstackResult(libunwindstack_result, &callstack)) {
+            on_callstack(std::move(callstack));
+          }
+        });
+    return;
+  }
+
+  const uint64_t begin_ns = orbit_base::CaptureTimestampNs();
   LibunwindstackResult libunwindstack_result =
       unwinder_->Unwind(event_data.GetCallstackPidOrMinusOne(), current_maps_->Get(),
                         event_data.GetRegistersAsArray(), stack_slices, offline_memory_only);
-
-  if (libunwindstack_result.frames().empty()) {
-    // Even with unwinding errors this is not expected because we should at least get the program
-    // counter. Do nothing in case this doesn't hold for a reason we don't know.
-    ORBIT_ERROR("Unwound callstack has no frames");
-    return false;
+  if (unwinding_budget_ != nullptr) {
+    unwinding_budget_->AddUnwindingTime(orbit_base::CaptureTimestampNs() - begin_ns);
   }
-
-  resulting_callstack->set_type(ComputeCallstackTypeFromStackSample(libunwindstack_result));
-  for (const unwindstack::FrameData& libunwindstack_frame : libunwindstack_result.frames()) {
-    SendFullAddressInfoToListener(libunwindstack_frame);
-    resulting_callstack->add_pcs(libunwindstack_frame.pc);
+  Callstack callstack;
+  if (FillCallstackFromLibunwindstackResult(libunwindstack_result, &callstack)) {
+    on_callstack(std::move(callstack));
   }
-
-  ORBIT_CHECK(!resulting_callstack->pcs().empty());
-  return true;
 }
 
 void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
                                     const StackSamplePerfEventData& event_data) {
-  FullCallstackSample sample;
-  sample.set_pid(event_data.pid);
-  sample.set_tid(event_data.tid);
-  sample.set_timestamp_ns(event_timestamp);
+  if (event_data.is_page_fault) {
+    UnwindStack(event_data, /*offline_memory_only=*/false,
+                [this, pid = event_data.pid, tid = event_data.tid,
+                 event_timestamp](Callstack&& callstack) {
+                  FullPageFaultSample sample;
+                  sample.set_pid(pid);
+                  sample.set_tid(tid);
+                  sample.set_timestamp_ns(event_timestamp);
+                  *sample.mutable_callstack() = std::move(callstack);
+                  listener_->OnPageFaultSample(std::move(sample));
+                });
+    return;
+  }
 
-  const bool success = UnwindStack(event_data, sample.mutable_callstack());
+  UnwindStack(event_data, /*offline_memory_only=*/false,
+              [this, pid = event_data.pid, tid = event_data.tid,
+               event_timestamp](Callstack&& callstack) {
+                FullCallstackSample sample;
+                sample.set_pid(pid);
+                sample.set_tid(tid);
+                sample.set_timestamp_ns(event_timestamp);
+                *sample.mutable_callstack() = std::move(callstack);
+                listener_->OnCallstackSample(std::move(sample));
+              });
+}
 
-  if (!success) {
-    return;
+template <typename StackPerfEventDataT>
+void UprobesUnwindingVisitor::DeferThreadStateSliceStack(pid_t tid, uint64_t timestamp_ns,
+                                                         const StackPerfEventDataT& event_data) {
+  const std::vector<StackSliceView> stack_slices = PatchAndCollectStackSlices(event_data);
+  tid_to_deferred_thread_state_slice_callstacks_[tid].push_back(DeferredThreadStateSliceCallstack{
+      timestamp_ns, CreateUnwindRequest(event_data.GetCallstackPidOrMinusOne(),
+                                        current_maps_->Get(), event_data.GetRegistersAsArray(),
+                                        stack_slices, /*offline_memory_only=*/true)});
+}
+
+void UprobesUnwindingVisitor::ResolveThreadStateSliceCallstack(pid_t tid,
+                                                               uint64_t begin_timestamp_ns,
+                                                               bool keep_callstack) {
+  auto deferred_callstacks_it = tid_to_deferred_thread_state_slice_callstacks_.find(tid);
+  if (deferred_callstacks_it == tid_to_deferred_thread_state_slice_callstacks_.end()) return;
+  std::vector<DeferredThreadStateSliceCallstack>& deferred_callstacks =
+      deferred_callstacks_it->second;
+
+  // The callstacks are in the order of their events. The ones before `begin_timestamp_ns` belong
+  // to thread state changes that didn't produce a slice, e.g., because the previous state of the
+  // thread was unknown, so they are dropped as well.
+  auto resolved_end = std::find_if(deferred_callstacks.begin(), deferred_callstacks.end(),
+                                   [begin_timestamp_ns](const auto& deferred_callstack) {
+                                     return deferred_callstack.timestamp_ns > begin_timestamp_ns;
+                                   });
+  for (auto it = deferred_callstacks.begin(); it != resolved_end; ++it) {
+    if (!keep_callstack || it->timestamp_ns != begin_timestamp_ns) continue;
+
+    ThreadStateSliceCallstack thread_state_slice_callstack;
+    thread_state_slice_callstack.set_thread_state_slice_tid(tid);
+    thread_state_slice_callstack.set_timestamp_ns(begin_timestamp_ns);
+    if (auto* request = std::get_if<ParallelStackUnwinder::Request>(&it->stack_or_callstack)) {
+      std::vector<StackSliceView> stack_slices;
+      stack_slices.reserve(request->stack_slices.size());
+      for (const ParallelStackUnwinder::StackSlice& stack_slice : request->stack_slices) {
+        stack_slices.emplace_back(stack_slice.start_address, stack_slice.data.size(),
+                                  stack_slice.data.data());
+      }
+      // The maps might have changed since the event, but the code of a thread that is off-CPU is
+      // very unlikely to be unmapped in the meantime.
+      LibunwindstackResult libunwindstack_result =
+          unwinder_->Unwind(request->pid, request->maps, request->registers, stack_slices,
+                            request->offline_memory_only);
+      if (!FillCallstackFromLibunwindstackResult(
+              libunwindstack_result, thread_state_slice_callstack.mutable_callstack())) {
+        continue;
+      }
+    } else {
+      *thread_state_slice_callstack.mutable_callstack() =
+          std::move(std::get<Callstack>(it->stack_or_callstack));
+    }
+    listener_->OnThreadStateSliceCallstack(std::move(thread_state_slice_callstack));
   }
 
-  listener_->OnCallstackSample(std::move(sample));
+  deferred_callstacks.erase(deferred_callstacks.begin(), resolved_end);
+  if (deferred_callstacks.empty()) {
+    tid_to_deferred_thread_state_slice_callstacks_.erase(deferred_callstacks_it);
+  }
 }
 
 void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
                                     const SchedWakeupWithStackPerfEventData& event_data) {
-  ThreadStateSliceCallstack thread_state_slice_callstack;
-  thread_state_slice_callstack.set_thread_state_slice_tid(event_data.woken_tid);
-  thread_state_slice_callstack.set_timestamp_ns(event_timestamp);
-
-  const bool success = UnwindStack(event_data, thread_state_slice_callstack.mutable_callstack(),
-                                   /*offline_memory_only=*/true);
-
-  if (!success) {
+  if (defer_thread_state_slice_callstacks_) {
+    DeferThreadStateSliceStack(event_data.woken_tid, event_timestamp, event_data);
     return;
   }
-
-  listener_->OnThreadStateSliceCallstack(std::move(thread_state_slice_callstack));
+  UnwindStack(event_data, /*offline_memory_only=*/true,
+              [this, woken_tid = event_data.woken_tid, event_timestamp](Callstack&& callstack) {
+                ThreadStateSliceCallstack thread_state_slice_callstack;
+                thread_state_slice_callstack.set_thread_state_slice_tid(woken_tid);
+                thread_state_slice_callstack.set_timestamp_ns(event_timestamp);
+                *thread_state_slice_callstack.mutable_callstack() = std::move(callstack);
+                listener_->OnThreadStateSliceCallstack(std::move(thread_state_slice_callstack));
+              });
 }
 
 void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
                                     const SchedSwitchWithStackPerfEventData& event_data) {
-  ThreadStateSliceCallstack thread_state_slice_callstack;
-  thread_state_slice_callstack.set_thread_state_slice_tid(event_data.prev_tid);
-  thread_state_slice_callstack.set_timestamp_ns(event_timestamp);
-
-  const bool success = UnwindStack(event_data, thread_state_slice_callstack.mutable_callstack(),
-                                   /*offline_memory_only=*/true);
-
-  if (!success) {
+  if (defer_thread_state_slice_callstacks_) {
+    DeferThreadStateSliceStack(event_data.prev_tid, event_timestamp, event_data);
     return;
   }
-
-  listener_->OnThreadStateSliceCallstack(std::move(thread_state_slice_callstack));
+  UnwindStack(event_data, /*offline_memory_only=*/true,
+              [this, prev_tid = event_data.prev_tid, event_timestamp](Callstack&& callstack) {
+                ThreadStateSliceCallstack thread_state_slice_callstack;
+                thread_state_slice_callstack.set_thread_state_slice_tid(prev_tid);
+                thread_state_slice_callstack.set_timestamp_ns(event_timestamp);
+                *thread_state_slice_callstack.mutable_callstack() = std::move(callstack);
+                listener_->OnThreadStateSliceCallstack(std::move(thread_state_slice_callstack));
+              });
 }
 
 template <typename CallchainPerfEventDataT>
@@ -448,6 +591,17 @@ void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
   ORBIT_CHECK(listener_ != nullptr);
   ORBIT_CHECK(current_maps_ != nullptr);
 
+  if (event_data.is_page_fault) {
+    FullPageFaultSample sample;
+    sample.set_pid(event_data.pid);
+    sample.set_tid(event_data.tid);
+    sample.set_timestamp_ns(event_timestamp);
+    if (!VisitCallchainEvent(event_data, sample.mutable_callstack())) return;
+    ORBIT_CHECK(!sample.callstack().pcs().empty());
+    listener_->OnPageFaultSample(std::move(sample));
+    return;
+  }
+
   FullCallstackSample sample;
   sample.set_pid(event_data.pid);
   sample.set_tid(event_data.tid);
@@ -463,6 +617,67 @@ void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
   listener_->OnCallstackSample(std::move(sample));
 }
 
+orbit_grpc_protos::Callstack::CallstackType
+UprobesUnwindingVisitor::ComputeCallstackTypeFromLbrCallstack(
+    const LbrCallstackSamplePerfEventData& event_data) {
+  // As with callchains, some samples fall inside u(ret)probes code.
+  std::shared_ptr<unwindstack::MapInfo> ip_map_info = current_maps_->Find(event_data.ip);
+  if (ip_map_info != nullptr && ip_map_info->name() == "[uprobes]") {
+    if (samples_in_uretprobes_counter_ != nullptr) {
+      ++(*samples_in_uretprobes_counter_);
+    }
+    return Callstack::kInUprobes;
+  }
+
+  // The trampolines of user space instrumentation jump back to the instrumented function instead of
+  // calling it, so a trampoline can only be in the LBR callstack if the sample fell inside the
+  // trampoline or inside a function the trampoline called.
+  if (user_space_instrumentation_addresses_ != nullptr &&
+      (user_space_instrumentation_addresses_->IsInEntryOrReturnTrampoline(event_data.ip) ||
+       std::any_of(event_data.GetBranchSources(),
+                   event_data.GetBranchSources() + event_data.GetBranchSourcesSize(),
+                   [this](uint64_t branch_source) {
+                     return user_space_instrumentation_addresses_->IsInEntryOrReturnTrampoline(
+                         branch_source);
+                   }))) {
+    return Callstack::kInUserSpaceInstrumentation;
+  }
+
+  // Unlike callchains, LBR callstacks need neither leaf function patching nor
+  // UprobesReturnAddressManager::PatchCallchain: the LBR records the calls themselves, so neither
+  // missing frame pointers nor return addresses hijacked by uretprobes affect them.
+  return Callstack::kComplete;
+}
+
+void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
+                                    const LbrCallstackSamplePerfEventData& event_data) {
+  ORBIT_CHECK(listener_ != nullptr);
+  ORBIT_CHECK(current_maps_ != nullptr);
+
+  // The user-space registers, and hence the sampled address, are missing if the thread had no
+  // user-space context.
+  if (event_data.ip == 0) {
+    return;
+  }
+
+  FullCallstackSample sample;
+  sample.set_pid(event_data.pid);
+  sample.set_tid(event_data.tid);
+  sample.set_timestamp_ns(event_timestamp);
+  Callstack* callstack = sample.mutable_callstack();
+  callstack->set_type(ComputeCallstackTypeFromLbrCallstack(event_data));
+
+  callstack->add_pcs(event_data.ip);
+  // The branch sources are the addresses of the call instructions, so, unlike with the return
+  // addresses of callchains, there is no need to subtract 1.
+  for (uint64_t branch_index = 0; branch_index < event_data.GetBranchSourcesSize();
+       ++branch_index) {
+    callstack->add_pcs(event_data.GetBranchSources()[branch_index]);
+  }
+
+  listener_->OnCallstackSample(std::move(sample));
+}
+
 void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
                                     const SchedWakeupWithCallchainPerfEventData& event_data) {
   ThreadStateSliceCallstack thread_state_slice_callstack;
@@ -476,6 +691,13 @@ void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
     return;
   }
 
+  if (defer_thread_state_slice_callstacks_) {
+    tid_to_deferred_thread_state_slice_callstacks_[event_data.woken_tid].push_back(
+        DeferredThreadStateSliceCallstack{
+            event_timestamp, std::move(*thread_state_slice_callstack.mutable_callstack())});
+    return;
+  }
+
   listener_->OnThreadStateSliceCallstack(std::move(thread_state_slice_callstack));
 }
 
@@ -492,6 +714,13 @@ void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp,
     return;
   }
 
+  if (defer_thread_state_slice_callstacks_) {
+    tid_to_deferred_thread_state_slice_callstacks_[event_data.prev_tid].push_back(
+        DeferredThreadStateSliceCallstack{
+            event_timestamp, std::move(*thread_state_slice_callstack.mutable_callstack())});
+    return;
+  }
+
   listener_->OnThreadStateSliceCallstack(std::move(thread_state_slice_callstack));
 }
 
@@ -721,6 +950,13 @@ void UprobesUnwindingVisitor::Visit(uint64_t event_timestamp, const MmapPerfEven
   ORBIT_CHECK(listener_ != nullptr);
   ORBIT_CHECK(current_maps_ != nullptr);
 
+  // Stacks that are still being unwound on other threads use the maps that are about to change.
+  if (parallel_stack_unwinder_ != nullptr) {
+    parallel_stack_unwinder_->WaitForAllUnwinds();
+  }
+  // Results unwound with the previous maps might no longer be valid.
+  unwinder_->ClearUnwindingCache();
+
   // PERF_RECORD_MMAP events do not contain the flags, but only distinguish between executable and
   // non-executable. This is all we need, so simply assume PROT_READ | PROT_EXEC for executable
   // mappings and PROT_READ for non-executable mappings. If we wanted the exact flags, we could
@@ -17,6 +17,7 @@
 #include <optional>
 #include <tuple>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "GrpcProtos/capture.pb.h"
@@ -26,9 +27,13 @@
 #include "LinuxTracing/TracerListener.h"
 #include "LinuxTracing/UserSpaceInstrumentationAddresses.h"
 #include "OrbitBase/Logging.h"
+#include "ParallelStackUnwinder.h"
 #include "PerfEvent.h"
 #include "PerfEventRecords.h"
 #include "PerfEventVisitor.h"
+#include "StackDataPool.h"
+#include "ThreadStateSliceCallstackResolver.h"
+#include "UnwindingBudget.h"
 #include "UprobesFunctionCallManager.h"
 #include "UprobesReturnAddressManager.h"
 #include "unwindstack/Unwinder.h"
@@ -47,7 +52,7 @@ namespace orbit_linux_tracing {
 // addresses before they are hijacked, and patches them into the time-based stack samples. Such
 // return addresses can be retrieved by getting the eight bytes at the top of the stack when
 // entering a dynamically instrumented function (e.g., when hitting uprobes).
-class UprobesUnwindingVisitor : public PerfEventVisitor {
+class UprobesUnwindingVisitor : public PerfEventVisitor, public ThreadStateSliceCallstackResolver {
  public:
   explicit UprobesUnwindingVisitor(
       TracerListener* listener, UprobesFunctionCallManager* function_call_manager,
@@ -85,6 +90,34 @@ class UprobesUnwindingVisitor : public PerfEventVisitor {
     samples_in_uretprobes_counter_ = samples_in_uretprobes_counter;
   }
 
+  // When set, stacks are unwound on the threads of `parallel_stack_unwinder`. The resulting
+  // callstacks are then sent to the listener when the unwinder calls back, still in the order of
+  // the samples. The owner needs to call ParallelStackUnwinder::ProcessCompletedUnwinds regularly
+  // and ParallelStackUnwinder::WaitForAllUnwinds before destroying this visitor.
+  void SetParallelStackUnwinder(ParallelStackUnwinder* parallel_stack_unwinder) {
+    parallel_stack_unwinder_ = parallel_stack_unwinder;
+  }
+
+  // When set, the time spent unwinding stacks on the calling thread and the DWARF unwinding errors
+  // are added to `unwinding_budget`. Pass it to ParallelStackUnwinder for the time on its threads.
+  void SetUnwindingBudget(UnwindingBudget* unwinding_budget) {
+    unwinding_budget_ = unwinding_budget;
+  }
+
+  // When set, the callstacks of thread state changes are not sent when the sched:sched_switch or
+  // sched:sched_wakeup event is visited, but only if ResolveThreadStateSliceCallstack later says
+  // that the slice starting with the event needs it. Stacks are copied in the meantime, and only
+  // unwound then. This is for when most of them are discarded, see
+  // ThreadStateManager::SetMinOffCpuDurationForCallstacksNs. As ProducerEventProcessor expects
+  // the callstack before the slice, these stacks are unwound on the calling thread even if a
+  // ParallelStackUnwinder has been set.
+  void SetDeferThreadStateSliceCallstacks(bool defer_thread_state_slice_callstacks) {
+    defer_thread_state_slice_callstacks_ = defer_thread_state_slice_callstacks;
+  }
+
+  void ResolveThreadStateSliceCallstack(pid_t tid, uint64_t begin_timestamp_ns,
+                                        bool keep_callstack) override;
+
   void Visit(uint64_t event_timestamp, const StackSamplePerfEventData& event_data) override;
   void Visit(uint64_t event_timestamp,
              const SchedWakeupWithCallchainPerfEventData& event_data) override;
@@ -95,6 +128,7 @@ class UprobesUnwindingVisitor : public PerfEventVisitor {
   void Visit(uint64_t event_timestamp,
              const SchedSwitchWithStackPerfEventData& event_data) override;
   void Visit(uint64_t event_timestamp, const CallchainSamplePerfEventData& event_data) override;
+  void Visit(uint64_t event_timestamp, const LbrCallstackSamplePerfEventData& event_data) override;
   void Visit(uint64_t event_timestamp, const UprobesPerfEventData& event_data) override;
   void Visit(uint64_t event_timestamp, const UprobesWithStackPerfEventData& event_data) override;
   void Visit(uint64_t event_timestamp,
@@ -113,7 +147,7 @@ class UprobesUnwindingVisitor : public PerfEventVisitor {
   struct StackSlice {
     uint64_t start_address;
     uint64_t size;
-    std::unique_ptr<uint8_t[]> data;
+    StackDataPtr data;
   };
 
   void OnUprobes(uint64_t timestamp_ns, pid_t tid, uint32_t cpu, uint64_t sp, uint64_t ip,
@@ -129,12 +163,37 @@ class UprobesUnwindingVisitor : public PerfEventVisitor {
   [[nodiscard]] orbit_grpc_protos::Callstack::CallstackType
   ComputeCallstackTypeFromCallchainAndPatch(const CallchainPerfEventDataT& event_data);
 
+  [[nodiscard]] orbit_grpc_protos::Callstack::CallstackType ComputeCallstackTypeFromLbrCallstack(
+      const LbrCallstackSamplePerfEventData& event_data);
+
   void SendFullAddressInfoToListener(const unwindstack::FrameData& libunwindstack_frame);
 
+  [[nodiscard]] bool FillCallstackFromLibunwindstackResult(
+      const LibunwindstackResult& libunwindstack_result,
+      orbit_grpc_protos::Callstack* resulting_callstack);
+
+  // A callstack of a thread state change kept until ResolveThreadStateSliceCallstack is called:
+  // either the copy of the stack to unwind, or the callstack already computed from a callchain.
+  struct DeferredThreadStateSliceCallstack {
+    uint64_t timestamp_ns;
+    std::variant<ParallelStackUnwinder::Request, orbit_grpc_protos::Callstack> stack_or_callstack;
+  };
+
+  // Patches the stack of `event` (see UprobesReturnAddressManager::PatchSample) and returns it
+  // together with the slices of user stack collected for the same thread by uprobes.
+  template <typename StackPerfEventDataT>
+  [[nodiscard]] std::vector<StackSliceView> PatchAndCollectStackSlices(
+      const StackPerfEventDataT& event);
+
+  // Calls `on_callstack` with the callstack unwound from `event`, unless unwinding didn't produce
+  // any frame. This happens later, on ParallelStackUnwinder's callback, if one has been set.
+  template <typename StackPerfEventDataT, typename OnCallstackT>
+  void UnwindStack(const StackPerfEventDataT& event, bool offline_memory_only,
+                   OnCallstackT on_callstack);
+
   template <typename StackPerfEventDataT>
-  [[nodiscard]] bool UnwindStack(const StackPerfEventDataT& event,
-                                 orbit_grpc_protos::Callstack* resulting_callstack,
-                                 bool offline_memory_only = false);
+  void DeferThreadStateSliceStack(pid_t tid, uint64_t timestamp_ns,
+                                  const StackPerfEventDataT& event);
 
   template <typename CallchainPerfEventDataT>
   [[nodiscard]] bool VisitCallchainEvent(const CallchainPerfEventDataT& event_data,
@@ -155,6 +214,13 @@ class UprobesUnwindingVisitor : public PerfEventVisitor {
   std::atomic<uint64_t>* unwind_error_counter_ = nullptr;
   std::atomic<uint64_t>* samples_in_uretprobes_counter_ = nullptr;
 
+  ParallelStackUnwinder* parallel_stack_unwinder_ = nullptr;
+  UnwindingBudget* unwinding_budget_ = nullptr;
+
+  bool defer_thread_state_slice_callstacks_ = false;
+  absl::flat_hash_map<pid_t, std::vector<DeferredThreadStateSliceCallstack>>
+      tid_to_deferred_thread_state_slice_callstacks_{};
+
   absl::flat_hash_map<pid_t, std::vector<std::tuple<uint64_t, uint64_t, uint32_t>>>
       uprobe_sps_ips_cpus_per_thread_{};
   absl::flat_hash_set<uint64_t> known_linux_address_infos_{};
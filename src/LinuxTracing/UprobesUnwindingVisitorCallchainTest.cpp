@@ -149,6 +149,23 @@ CallchainSamplePerfEvent BuildFakeCallchainSamplePerfEvent(absl::Span<const uint
   return event;
 }
 
+LbrCallstackSamplePerfEvent BuildFakeLbrCallstackSamplePerfEvent(
+    uint64_t ip, const std::vector<uint64_t>& branch_sources) {
+  LbrCallstackSamplePerfEvent event{
+      .timestamp = 15,
+      .data =
+          {
+              .pid = 10,
+              .tid = 11,
+              .ip = ip,
+              .branch_sources_size = branch_sources.size(),
+              .branch_sources = std::make_unique<uint64_t[]>(branch_sources.size()),
+          },
+  };
+  std::copy(branch_sources.begin(), branch_sources.end(), event.data.branch_sources.get());
+  return event;
+}
+
 }  // namespace
 
 TEST_F(UprobesUnwindingVisitorCallchainTest,
@@ -560,4 +577,85 @@ TEST_F(
   EXPECT_EQ(discarded_samples_in_uretprobes_counter, 0);
 }
 
+TEST_F(UprobesUnwindingVisitorCallchainTest, VisitLbrCallstackSampleSendsCompleteCallstack) {
+  // The branch sources are the call instructions themselves, so they are sent unchanged.
+  LbrCallstackSamplePerfEvent event =
+      BuildFakeLbrCallstackSamplePerfEvent(kTargetAddress1, {kTargetAddress2, kTargetAddress3});
+
+  EXPECT_CALL(maps_, Find).WillRepeatedly(Return(kTargetMapInfo));
+  EXPECT_CALL(return_address_manager_, PatchCallchain).Times(0);
+  EXPECT_CALL(leaf_function_call_manager_, PatchCallerOfLeafFunction).Times(0);
+
+  orbit_grpc_protos::FullCallstackSample actual_callstack_sample;
+  EXPECT_CALL(listener_, OnCallstackSample).Times(1).WillOnce(SaveArg<0>(&actual_callstack_sample));
+
+  std::atomic<uint64_t> unwinding_errors = 0;
+  std::atomic<uint64_t> discarded_samples_in_uretprobes_counter = 0;
+  visitor_.SetUnwindErrorsAndDiscardedSamplesCounters(&unwinding_errors,
+                                                      &discarded_samples_in_uretprobes_counter);
+
+  PerfEvent{std::move(event)}.Accept(&visitor_);
+
+  EXPECT_EQ(actual_callstack_sample.pid(), 10);
+  EXPECT_EQ(actual_callstack_sample.tid(), 11);
+  EXPECT_EQ(actual_callstack_sample.timestamp_ns(), 15);
+  EXPECT_THAT(actual_callstack_sample.callstack().pcs(),
+              ElementsAre(kTargetAddress1, kTargetAddress2, kTargetAddress3));
+  EXPECT_EQ(actual_callstack_sample.callstack().type(), Callstack::kComplete);
+
+  EXPECT_EQ(unwinding_errors, 0);
+  EXPECT_EQ(discarded_samples_in_uretprobes_counter, 0);
+}
+
+TEST_F(UprobesUnwindingVisitorCallchainTest,
+       VisitLbrCallstackSampleInsideUprobeCodeSendsInUprobesCallstack) {
+  LbrCallstackSamplePerfEvent event =
+      BuildFakeLbrCallstackSamplePerfEvent(kUprobesMapsStart, {kTargetAddress2, kTargetAddress3});
+
+  EXPECT_CALL(maps_, Find(_)).WillRepeatedly(Return(kTargetMapInfo));
+  EXPECT_CALL(maps_, Find(kUprobesMapsStart)).WillRepeatedly(Return(kUprobesMapInfo));
+
+  orbit_grpc_protos::FullCallstackSample actual_callstack_sample;
+  EXPECT_CALL(listener_, OnCallstackSample).Times(1).WillOnce(SaveArg<0>(&actual_callstack_sample));
+
+  std::atomic<uint64_t> unwinding_errors = 0;
+  std::atomic<uint64_t> discarded_samples_in_uretprobes_counter = 0;
+  visitor_.SetUnwindErrorsAndDiscardedSamplesCounters(&unwinding_errors,
+                                                      &discarded_samples_in_uretprobes_counter);
+
+  PerfEvent{std::move(event)}.Accept(&visitor_);
+
+  EXPECT_THAT(actual_callstack_sample.callstack().pcs(),
+              ElementsAre(kUprobesMapsStart, kTargetAddress2, kTargetAddress3));
+  EXPECT_EQ(actual_callstack_sample.callstack().type(), Callstack::kInUprobes);
+
+  EXPECT_EQ(unwinding_errors, 0);
+  EXPECT_EQ(discarded_samples_in_uretprobes_counter, 1);
+}
+
+TEST_F(UprobesUnwindingVisitorCallchainTest,
+       VisitLbrCallstackSampleCalledByTrampolineSendsInUserSpaceInstrumentationCallstack) {
+  LbrCallstackSamplePerfEvent event = BuildFakeLbrCallstackSamplePerfEvent(
+      kUserSpaceLibraryAddress, {kEntryTrampolineAddress, kTargetAddress2, kTargetAddress3});
+
+  EXPECT_CALL(maps_, Find(_)).WillRepeatedly(Return(kTargetMapInfo));
+  EXPECT_CALL(maps_, Find(kUserSpaceLibraryAddress))
+      .WillRepeatedly(Return(kUserSpaceLibraryMapInfo));
+
+  orbit_grpc_protos::FullCallstackSample actual_callstack_sample;
+  EXPECT_CALL(listener_, OnCallstackSample).Times(1).WillOnce(SaveArg<0>(&actual_callstack_sample));
+
+  PerfEvent{std::move(event)}.Accept(&visitor_);
+
+  EXPECT_EQ(actual_callstack_sample.callstack().type(), Callstack::kInUserSpaceInstrumentation);
+}
+
+TEST_F(UprobesUnwindingVisitorCallchainTest, VisitLbrCallstackSampleWithoutIpDoesNothing) {
+  LbrCallstackSamplePerfEvent event = BuildFakeLbrCallstackSamplePerfEvent(0, {kTargetAddress2});
+
+  EXPECT_CALL(listener_, OnCallstackSample).Times(0);
+
+  PerfEvent{std::move(event)}.Accept(&visitor_);
+}
+
 }  // namespace orbit_linux_tracing
@@ -1800,6 +1800,47 @@ REGISTER_TYPED_TEST_SUITE_P(
     VisitTwoValidStackSamplesSendsAddressInfosOnlyOnce,
     VisitValidStackSampleWithNullptrMapInfosSendsCompleteCallstackAndAddressInfosWithoutModuleName);
 
+TEST_F(UprobesUnwindingVisitorDwarfUnwindingTestBase,
+       DeferredThreadStateSliceStacksAreOnlyUnwoundWhenTheirSliceKeepsThem) {
+  visitor_.SetDeferThreadStateSliceCallstacks(true);
+  auto event1 = BuildFakePerfEventWithStack<SchedSwitchWithStackPerfEvent>();
+  auto event2 = BuildFakePerfEventWithStack<SchedSwitchWithStackPerfEvent>();
+  event2.timestamp = 25;
+  const pid_t tid = event1.data.prev_tid;
+
+  // Patching needs to happen in order, so already when visiting.
+  EXPECT_CALL(return_address_manager_, PatchSample).Times(2);
+  EXPECT_CALL(maps_, Get).Times(2).WillRepeatedly(::testing::Return(nullptr));
+  EXPECT_CALL(unwinder_, Unwind).Times(0);
+  EXPECT_CALL(listener_, OnThreadStateSliceCallstack).Times(0);
+  PerfEvent{std::move(event1)}.Accept(&visitor_);
+  PerfEvent{std::move(event2)}.Accept(&visitor_);
+  ::testing::Mock::VerifyAndClearExpectations(&unwinder_);
+  ::testing::Mock::VerifyAndClearExpectations(&listener_);
+
+  EXPECT_CALL(unwinder_,
+              Unwind(10, nullptr, ::testing::_, ::testing::SizeIs(1), true, ::testing::_))
+      .Times(1)
+      .WillOnce(::testing::Return(LibunwindstackResult{
+          std::vector<unwindstack::FrameData>{kFrame1, kFrame2}, {},
+          unwindstack::ErrorCode::ERROR_NONE}));
+  EXPECT_CALL(listener_, OnAddressInfo).Times(2);
+  orbit_grpc_protos::ThreadStateSliceCallstack actual_callstack;
+  EXPECT_CALL(listener_, OnThreadStateSliceCallstack)
+      .Times(1)
+      .WillOnce(::testing::SaveArg<0>(&actual_callstack));
+
+  visitor_.ResolveThreadStateSliceCallstack(tid, 15, /*keep_callstack=*/false);
+  visitor_.ResolveThreadStateSliceCallstack(tid, 25, /*keep_callstack=*/true);
+  // Both callstacks have already been resolved.
+  visitor_.ResolveThreadStateSliceCallstack(tid, 25, /*keep_callstack=*/true);
+
+  EXPECT_EQ(actual_callstack.thread_state_slice_tid(), tid);
+  EXPECT_EQ(actual_callstack.timestamp_ns(), 25);
+  EXPECT_THAT(actual_callstack.callstack().pcs(),
+              ::testing::ElementsAre(kTargetAddress1, kTargetAddress2));
+}
+
 template <typename T, typename U>
 struct DwarfUnwindingTestType {
   using PerfEventT = T;
@@ -38,6 +38,10 @@ class MockLibunwindstackUnwinder : public LibunwindstackUnwinder {
               (override));
   MOCK_METHOD(std::optional<bool>, HasFramePointerSet, (uint64_t, pid_t, unwindstack::Maps*),
               (override));
+  MOCK_METHOD(std::optional<uint64_t>, GetReturnAddressOffsetFromSpWithoutFrameSetup,
+              (uint64_t, pid_t, unwindstack::Maps*), (override));
+  MOCK_METHOD(void, ClearUnwindingCache, (), (override));
+  MOCK_METHOD(UnwindingCacheStats, GetUnwindingCacheStats, (), (const, override));
 };
 
 class MockUprobesReturnAddressManager : public UprobesReturnAddressManager {
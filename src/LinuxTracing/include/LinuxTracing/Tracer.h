@@ -5,6 +5,8 @@
 #ifndef LINUX_TRACING_TRACER_H_
 #define LINUX_TRACING_TRACER_H_
 
+#include <stdint.h>
+
 #include <atomic>
 #include <memory>
 #include <thread>
@@ -28,6 +30,16 @@ class Tracer {
   virtual void ProcessFunctionEntry(const orbit_grpc_protos::FunctionEntry& function_entry) = 0;
   virtual void ProcessFunctionExit(const orbit_grpc_protos::FunctionExit& function_exit) = 0;
 
+  // These reduce the overhead of a running capture, e.g., when OrbitService is running out of
+  // memory. They can be called from any thread after Start() and cannot be undone.
+  // Callstacks are sampled `factor` times less frequently than requested in the CaptureOptions.
+  virtual void ReduceSamplingRate(uint32_t factor) = 0;
+  // Thread state changes are still traced, but without their callstacks.
+  virtual void DropThreadStateChangeCallstacks() = 0;
+
+  // Only complete once Stop() has returned.
+  [[nodiscard]] virtual orbit_grpc_protos::UnwindingCacheStats GetUnwindingCacheStats() const = 0;
+
   virtual ~Tracer() = default;
 
   [[nodiscard]] static std::unique_ptr<Tracer> Create(
@@ -14,6 +14,9 @@ class TracerListener {
   virtual ~TracerListener() = default;
   virtual void OnSchedulingSlice(orbit_grpc_protos::SchedulingSlice scheduling_slice) = 0;
   virtual void OnCallstackSample(orbit_grpc_protos::FullCallstackSample callstack_sample) = 0;
+  virtual void OnPageFaultSample(orbit_grpc_protos::FullPageFaultSample page_fault_sample) = 0;
+  virtual void OnPerformanceCounterSample(
+      orbit_grpc_protos::PerformanceCounterSample performance_counter_sample) = 0;
   virtual void OnThreadStateSliceCallstack(
       orbit_grpc_protos::ThreadStateSliceCallstack callstack) = 0;
   virtual void OnFunctionCall(orbit_grpc_protos::FunctionCall function_call) = 0;
@@ -32,9 +35,12 @@ class TracerListener {
       orbit_grpc_protos::LostPerfRecordsEvent lost_perf_records_event) = 0;
   virtual void OnOutOfOrderEventsDiscardedEvent(
       orbit_grpc_protos::OutOfOrderEventsDiscardedEvent out_of_order_events_discarded_event) = 0;
+  virtual void OnPerfEventProcessingStatsEvent(
+      orbit_grpc_protos::PerfEventProcessingStatsEvent perf_event_processing_stats_event) = 0;
   virtual void OnWarningInstrumentingWithUprobesEvent(
       orbit_grpc_protos::WarningInstrumentingWithUprobesEvent
           warning_instrumenting_with_uprobes_event) = 0;
+  virtual void OnWarningEvent(orbit_grpc_protos::WarningEvent warning_event) = 0;
 };
 
 }  // namespace orbit_linux_tracing
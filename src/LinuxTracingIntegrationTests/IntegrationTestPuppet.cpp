@@ -26,9 +26,9 @@
 // This executable is used by LinuxTracingIntegrationTest to test the generation of specific
 // perf_event_open events. The behavior is controlled by commands sent on standard input.
 
-// Hack: Don't use ORBIT_API_INSTANTIATE as it would redefine `struct orbit_api_v2 g_orbit_api`,
+// Hack: Don't use ORBIT_API_INSTANTIATE as it would redefine `struct orbit_api_v3 g_orbit_api`,
 // which is already defined by the Introspection target.
-void* orbit_api_get_function_table_address_v2() { return &g_orbit_api; }
+void* orbit_api_get_function_table_address_v3() { return &g_orbit_api; }
 
 namespace orbit_linux_tracing_integration_tests {
 
@@ -118,7 +118,8 @@ extern "C" __attribute__((noinline)) void UseOrbitApi() {
     ORBIT_LOG("Using OrbitApi");
     constexpr absl::Duration kDelayBetweenEvents = absl::Microseconds(100);
     {
-      ORBIT_SCOPE_WITH_COLOR_AND_GROUP_ID(
+      // ORBIT_START_WITH_COLOR_AND_GROUP_ID below covers the variant that takes a name string.
+      ORBIT_SCOPE_LITERAL_WITH_COLOR_AND_GROUP_ID(
           PuppetConstants::kOrbitApiScopeName,
           static_cast<orbit_api_color>(PuppetConstants::kOrbitApiScopeColor),
           PuppetConstants::kOrbitApiScopeGroupId);
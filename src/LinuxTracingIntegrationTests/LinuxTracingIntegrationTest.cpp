@@ -95,6 +95,25 @@ class BufferTracerListener : public orbit_linux_tracing::TracerListener {
     }
   }
 
+  void OnPageFaultSample(orbit_grpc_protos::FullPageFaultSample page_fault_sample) override {
+    orbit_grpc_protos::ProducerCaptureEvent event;
+    *event.mutable_full_page_fault_sample() = std::move(page_fault_sample);
+    {
+      absl::MutexLock lock{&events_mutex_};
+      events_.emplace_back(std::move(event));
+    }
+  }
+
+  void OnPerformanceCounterSample(
+      orbit_grpc_protos::PerformanceCounterSample performance_counter_sample) override {
+    orbit_grpc_protos::ProducerCaptureEvent event;
+    *event.mutable_performance_counter_sample() = std::move(performance_counter_sample);
+    {
+      absl::MutexLock lock{&events_mutex_};
+      events_.emplace_back(std::move(event));
+    }
+  }
+
   void OnFunctionCall(orbit_grpc_protos::FunctionCall function_call) override {
     orbit_grpc_protos::ProducerCaptureEvent event;
     *event.mutable_function_call() = std::move(function_call);
@@ -214,6 +233,17 @@ class BufferTracerListener : public orbit_linux_tracing::TracerListener {
     }
   }
 
+  void OnPerfEventProcessingStatsEvent(orbit_grpc_protos::PerfEventProcessingStatsEvent
+                                           perf_event_processing_stats_event) override {
+    orbit_grpc_protos::ProducerCaptureEvent event;
+    *event.mutable_perf_event_processing_stats_event() =
+        std::move(perf_event_processing_stats_event);
+    {
+      absl::MutexLock lock{&events_mutex_};
+      events_.emplace_back(std::move(event));
+    }
+  }
+
   void OnWarningInstrumentingWithUprobesEvent(
       orbit_grpc_protos::WarningInstrumentingWithUprobesEvent
           warning_instrumenting_with_uprobes_event) override {
@@ -226,6 +256,15 @@ class BufferTracerListener : public orbit_linux_tracing::TracerListener {
     }
   }
 
+  void OnWarningEvent(orbit_grpc_protos::WarningEvent warning_event) override {
+    orbit_grpc_protos::ProducerCaptureEvent event;
+    *event.mutable_warning_event() = std::move(warning_event);
+    {
+      absl::MutexLock lock{&events_mutex_};
+      events_.emplace_back(std::move(event));
+    }
+  }
+
   [[nodiscard]] std::vector<orbit_grpc_protos::ProducerCaptureEvent> GetAndClearEvents() {
     absl::MutexLock lock{&events_mutex_};
     std::vector<orbit_grpc_protos::ProducerCaptureEvent> events = std::move(events_);
@@ -369,6 +408,8 @@ void VerifyOrderOfAllEvents(absl::Span<const orbit_grpc_protos::ProducerCaptureE
         ORBIT_UNREACHABLE();
       case orbit_grpc_protos::ProducerCaptureEvent::kApiTrackUint64:
         ORBIT_UNREACHABLE();
+      case orbit_grpc_protos::ProducerCaptureEvent::kApiTrackValueSummary:
+        ORBIT_UNREACHABLE();
       case orbit_grpc_protos::ProducerCaptureEvent::kCallstackSample:
         ORBIT_UNREACHABLE();
       case orbit_grpc_protos::ProducerCaptureEvent::kCaptureFinished:
@@ -436,6 +477,13 @@ void VerifyOrderOfAllEvents(absl::Span<const orbit_grpc_protos::ProducerCaptureE
         previous_event_timestamp_ns =
             event.out_of_order_events_discarded_event().end_timestamp_ns();
         break;
+      case orbit_grpc_protos::ProducerCaptureEvent::kPackedApiEvents:
+        ORBIT_UNREACHABLE();
+      case orbit_grpc_protos::ProducerCaptureEvent::kPerfEventProcessingStatsEvent:
+        EXPECT_GE(event.perf_event_processing_stats_event().timestamp_ns(),
+                  previous_event_timestamp_ns);
+        previous_event_timestamp_ns = event.perf_event_processing_stats_event().timestamp_ns();
+        break;
       case orbit_grpc_protos::ProducerCaptureEvent::kSchedulingSlice:
         EXPECT_GE(event.scheduling_slice().out_timestamp_ns(), previous_event_timestamp_ns);
         previous_event_timestamp_ns = event.scheduling_slice().out_timestamp_ns();
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/match.h>
 #include <absl/strings/str_format.h>
 #include <absl/synchronization/mutex.h>
@@ -364,6 +365,22 @@ static std::pair<uint64_t, uint64_t> GetUseOrbitApiFunctionVirtualAddressRange(p
   ORBIT_UNREACHABLE();
 }
 
+// Names of scopes and string events can be interned by the producer.
+template <typename NamedApiEvent>
+static std::string GetApiEventName(
+    const NamedApiEvent& api_event,
+    const absl::flat_hash_map<uint64_t, std::string>& interned_strings) {
+  if (api_event.name_key() != 0) {
+    auto it = interned_strings.find(api_event.name_key());
+    return it != interned_strings.end() ? it->second : "";
+  }
+  return orbit_api::DecodeString(
+      api_event.encoded_name_1(), api_event.encoded_name_2(), api_event.encoded_name_3(),
+      api_event.encoded_name_4(), api_event.encoded_name_5(), api_event.encoded_name_6(),
+      api_event.encoded_name_7(), api_event.encoded_name_8(),
+      api_event.encoded_name_additional().data(), api_event.encoded_name_additional_size());
+}
+
 TEST(OrbitServiceIntegrationTest, OrbitApi) {
   if (!CheckIsRunningAsRoot()) {
     GTEST_SKIP();
@@ -401,21 +418,20 @@ TEST(OrbitServiceIntegrationTest, OrbitApi) {
   uint64_t api_track_float_count = 0;
   uint64_t api_track_double_count = 0;
   uint64_t previous_timestamp_ns = 0;
+  absl::flat_hash_map<uint64_t, std::string> interned_strings;
   for (const ClientCaptureEvent& event : events) {
     switch (event.event_case()) {
+      case ClientCaptureEvent::kInternedString:
+        interned_strings.emplace(event.interned_string().key(), event.interned_string().intern());
+        break;
+
       case ClientCaptureEvent::kApiScopeStart: {
         const orbit_grpc_protos::ApiScopeStart& api_scope_start = event.api_scope_start();
         EXPECT_EQ(api_scope_start.pid(), fixture.GetPuppetPid());
         EXPECT_EQ(api_scope_start.tid(), fixture.GetPuppetPid());
         EXPECT_GT(api_scope_start.timestamp_ns(), previous_timestamp_ns);
         previous_timestamp_ns = api_scope_start.timestamp_ns();
-        std::string decoded_name = orbit_api::DecodeString(
-            api_scope_start.encoded_name_1(), api_scope_start.encoded_name_2(),
-            api_scope_start.encoded_name_3(), api_scope_start.encoded_name_4(),
-            api_scope_start.encoded_name_5(), api_scope_start.encoded_name_6(),
-            api_scope_start.encoded_name_7(), api_scope_start.encoded_name_8(),
-            api_scope_start.encoded_name_additional().data(),
-            api_scope_start.encoded_name_additional_size());
+        std::string decoded_name = GetApiEventName(api_scope_start, interned_strings);
         if (expect_next_api_scope_start_coming_from_scope) {
           EXPECT_EQ(decoded_name, PuppetConstants::kOrbitApiScopeName);
           EXPECT_EQ(api_scope_start.color_rgba(), PuppetConstants::kOrbitApiScopeColor);
@@ -449,13 +465,7 @@ TEST(OrbitServiceIntegrationTest, OrbitApi) {
         EXPECT_EQ(api_scope_start_async.tid(), fixture.GetPuppetPid());
         EXPECT_GT(api_scope_start_async.timestamp_ns(), previous_timestamp_ns);
         previous_timestamp_ns = api_scope_start_async.timestamp_ns();
-        std::string decoded_name = orbit_api::DecodeString(
-            api_scope_start_async.encoded_name_1(), api_scope_start_async.encoded_name_2(),
-            api_scope_start_async.encoded_name_3(), api_scope_start_async.encoded_name_4(),
-            api_scope_start_async.encoded_name_5(), api_scope_start_async.encoded_name_6(),
-            api_scope_start_async.encoded_name_7(), api_scope_start_async.encoded_name_8(),
-            api_scope_start_async.encoded_name_additional().data(),
-            api_scope_start_async.encoded_name_additional_size());
+        std::string decoded_name = GetApiEventName(api_scope_start_async, interned_strings);
         EXPECT_EQ(decoded_name, PuppetConstants::kOrbitApiStartAsyncName);
         EXPECT_EQ(api_scope_start_async.id(), PuppetConstants::kOrbitApiStartAsyncId);
         EXPECT_EQ(api_scope_start_async.color_rgba(), PuppetConstants::kOrbitApiStartAsyncColor);
@@ -479,13 +489,7 @@ TEST(OrbitServiceIntegrationTest, OrbitApi) {
         EXPECT_EQ(api_async_string.tid(), fixture.GetPuppetPid());
         EXPECT_GT(api_async_string.timestamp_ns(), previous_timestamp_ns);
         previous_timestamp_ns = api_async_string.timestamp_ns();
-        std::string decoded_name = orbit_api::DecodeString(
-            api_async_string.encoded_name_1(), api_async_string.encoded_name_2(),
-            api_async_string.encoded_name_3(), api_async_string.encoded_name_4(),
-            api_async_string.encoded_name_5(), api_async_string.encoded_name_6(),
-            api_async_string.encoded_name_7(), api_async_string.encoded_name_8(),
-            api_async_string.encoded_name_additional().data(),
-            api_async_string.encoded_name_additional_size());
+        std::string decoded_name = GetApiEventName(api_async_string, interned_strings);
         EXPECT_EQ(decoded_name, PuppetConstants::kOrbitApiAsyncStringName);
         EXPECT_EQ(api_async_string.id(), PuppetConstants::kOrbitApiStartAsyncId);
         EXPECT_EQ(api_async_string.color_rgba(), PuppetConstants::kOrbitApiAsyncStringColor);
@@ -8,6 +8,7 @@
 #include <absl/time/clock.h>
 #include <absl/time/time.h>
 
+#include <memory>
 #include <thread>
 
 #include "GrpcProtos/capture.pb.h"
@@ -59,10 +60,12 @@ void MemoryInfoProducer::Run() {
 std::unique_ptr<MemoryInfoProducer> CreateSystemMemoryInfoProducer(MemoryInfoListener* listener,
                                                                    uint64_t sampling_period_ns,
                                                                    int32_t pid) {
+  // The reader keeps the files open between samples. It is only used by the producer's thread.
+  auto reader = std::make_shared<SystemMemoryUsageReader>();
   std::unique_ptr<MemoryInfoProducer> system_memory_info_producer =
       std::make_unique<MemoryInfoProducer>(
-          sampling_period_ns, pid, [](MemoryInfoListener* listener, int32_t /*pid*/) {
-            ErrorMessageOr<SystemMemoryUsage> system_memory_usage = GetSystemMemoryUsage();
+          sampling_period_ns, pid, [reader](MemoryInfoListener* listener, int32_t /*pid*/) {
+            ErrorMessageOr<SystemMemoryUsage> system_memory_usage = reader->Read();
             if (system_memory_usage.has_value()) {
               listener->OnSystemMemoryUsage(system_memory_usage.value());
             }
@@ -75,10 +78,11 @@ std::unique_ptr<MemoryInfoProducer> CreateSystemMemoryInfoProducer(MemoryInfoLis
 std::unique_ptr<MemoryInfoProducer> CreateCGroupMemoryInfoProducer(MemoryInfoListener* listener,
                                                                    uint64_t sampling_period_ns,
                                                                    int32_t pid) {
+  auto reader = std::make_shared<CGroupMemoryUsageReader>(pid);
   std::unique_ptr<MemoryInfoProducer> cgroup_memory_info_producer =
       std::make_unique<MemoryInfoProducer>(
-          sampling_period_ns, pid, [](MemoryInfoListener* listener, int32_t pid) {
-            ErrorMessageOr<CGroupMemoryUsage> cgroup_memory_usage = GetCGroupMemoryUsage(pid);
+          sampling_period_ns, pid, [reader](MemoryInfoListener* listener, int32_t /*pid*/) {
+            ErrorMessageOr<CGroupMemoryUsage> cgroup_memory_usage = reader->Read();
             if (cgroup_memory_usage.has_value()) {
               listener->OnCGroupMemoryUsage(cgroup_memory_usage.value());
             }
@@ -91,10 +95,11 @@ std::unique_ptr<MemoryInfoProducer> CreateCGroupMemoryInfoProducer(MemoryInfoLis
 std::unique_ptr<MemoryInfoProducer> CreateProcessMemoryInfoProducer(MemoryInfoListener* listener,
                                                                     uint64_t sampling_period_ns,
                                                                     int32_t pid) {
+  auto reader = std::make_shared<ProcessMemoryUsageReader>(pid);
   std::unique_ptr<MemoryInfoProducer> process_memory_info_producer =
       std::make_unique<MemoryInfoProducer>(
-          sampling_period_ns, pid, [](MemoryInfoListener* listener, int32_t pid) {
-            ErrorMessageOr<ProcessMemoryUsage> process_memory_usage = GetProcessMemoryUsage(pid);
+          sampling_period_ns, pid, [reader](MemoryInfoListener* listener, int32_t /*pid*/) {
+            ErrorMessageOr<ProcessMemoryUsage> process_memory_usage = reader->Read();
             if (process_memory_usage.has_value()) {
               listener->OnProcessMemoryUsage(process_memory_usage.value());
             }
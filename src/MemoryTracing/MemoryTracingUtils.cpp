@@ -8,15 +8,17 @@
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
 
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "GrpcProtos/Constants.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
-#include "OrbitBase/ReadFileToString.h"
 #include "OrbitBase/Result.h"
 
 namespace orbit_memory_tracing {
@@ -42,9 +44,9 @@ ErrorMessageOr<void> UpdateSystemMemoryUsageFromMemInfo(std::string_view meminfo
                                                         SystemMemoryUsage* system_memory_usage) {
   if (meminfo_content.empty()) return ErrorMessage("Empty file content.");
 
-  std::vector<std::string> lines = absl::StrSplit(meminfo_content, '\n', absl::SkipEmpty());
+  std::vector<std::string_view> lines = absl::StrSplit(meminfo_content, '\n', absl::SkipEmpty());
   constexpr size_t kNumLines = 5;
-  std::vector<std::string> top_lines(
+  std::vector<std::string_view> top_lines(
       lines.begin(), lines.begin() + (lines.size() > kNumLines ? kNumLines : lines.size()));
   std::string error_message;
   for (std::string_view line : top_lines) {
@@ -55,7 +57,7 @@ ErrorMessageOr<void> UpdateSystemMemoryUsageFromMemInfo(std::string_view meminfo
     // definition in http://en.wikipedia.org/wiki/Kilobyte. We keep consistent with the definition
     // in /proc/meminfo: we report in "kB" and consider 1 kB = 1 KiloBytes = 1024 Bytes.
     // If the line format is wrong or the unit size isn't "kB", SystemMemoryUsage won't be updated.
-    std::vector<std::string> splits = absl::StrSplit(line, ' ', absl::SkipWhitespace{});
+    std::vector<std::string_view> splits = absl::StrSplit(line, ' ', absl::SkipWhitespace{});
     if (splits.size() < 3 || splits[2] != "kB") {
       absl::StrAppend(&error_message, "Wrong format in line: ", line, "\n");
       continue;
@@ -88,12 +90,12 @@ ErrorMessageOr<void> UpdateSystemMemoryUsageFromVmStat(std::string_view vmstat_c
                                                        SystemMemoryUsage* system_memory_usage) {
   if (vmstat_content.empty()) return ErrorMessage("Empty file content.");
 
-  std::vector<std::string> lines = absl::StrSplit(vmstat_content, '\n', absl::SkipEmpty());
+  std::vector<std::string_view> lines = absl::StrSplit(vmstat_content, '\n', absl::SkipEmpty());
   std::string error_message;
   for (std::string_view line : lines) {
     // Each line of the /proc/vmstat file consists a single name-value pair, delimited by white
     // space. In /proc/vmstat, the pgfault and pgmajfault fields report cumulative values.
-    std::vector<std::string> splits = absl::StrSplit(line, ' ', absl::SkipWhitespace{});
+    std::vector<std::string_view> splits = absl::StrSplit(line, ' ', absl::SkipWhitespace{});
     if (splits.size() < 2) {
       absl::StrAppend(&error_message, "Wrong format in line: ", line, "\n");
       continue;
@@ -116,13 +118,11 @@ ErrorMessageOr<void> UpdateSystemMemoryUsageFromVmStat(std::string_view vmstat_c
   return outcome::success();
 }
 
-ErrorMessageOr<SystemMemoryUsage> GetSystemMemoryUsage() {
+ErrorMessageOr<SystemMemoryUsage> SystemMemoryUsageReader::Read() {
   SystemMemoryUsage system_memory_usage = CreateAndInitializeSystemMemoryUsage();
   system_memory_usage.set_timestamp_ns(orbit_base::CaptureTimestampNs());
 
-  const std::string system_memory_usage_filename = "/proc/meminfo";
-  ErrorMessageOr<std::string> reading_result =
-      orbit_base::ReadFileToString(system_memory_usage_filename);
+  ErrorMessageOr<std::string_view> reading_result = meminfo_reader_.Read();
   if (reading_result.has_error()) {
     ORBIT_ERROR("%s", reading_result.error().message());
     return reading_result.error();
@@ -130,25 +130,28 @@ ErrorMessageOr<SystemMemoryUsage> GetSystemMemoryUsage() {
   ErrorMessageOr<void> updating_result =
       UpdateSystemMemoryUsageFromMemInfo(reading_result.value(), &system_memory_usage);
   if (updating_result.has_error()) {
-    ORBIT_ERROR("Updating SystemMemoryUsage from %s: %s", system_memory_usage_filename,
+    ORBIT_ERROR("Updating SystemMemoryUsage from %s: %s", meminfo_reader_.path().string(),
                 updating_result.error().message());
   }
 
-  const std::string system_page_faults_filename = "/proc/vmstat";
-  reading_result = orbit_base::ReadFileToString(system_page_faults_filename);
+  reading_result = vmstat_reader_.Read();
   if (reading_result.has_error()) {
     ORBIT_ERROR("%s", reading_result.error().message());
     return reading_result.error();
   }
   updating_result = UpdateSystemMemoryUsageFromVmStat(reading_result.value(), &system_memory_usage);
   if (updating_result.has_error()) {
-    ORBIT_ERROR("Updating SystemMemoryUsage from %s: %s", system_page_faults_filename,
+    ORBIT_ERROR("Updating SystemMemoryUsage from %s: %s", vmstat_reader_.path().string(),
                 updating_result.error().message());
   }
 
   return system_memory_usage;
 }
 
+ErrorMessageOr<SystemMemoryUsage> GetSystemMemoryUsage() {
+  return SystemMemoryUsageReader{}.Read();
+}
+
 ProcessMemoryUsage CreateAndInitializeProcessMemoryUsage() {
   ProcessMemoryUsage process_memory_usage;
   process_memory_usage.set_rss_anon_kb(kMissingInfo);
@@ -168,7 +171,7 @@ ErrorMessageOr<void> UpdateProcessMemoryUsageFromProcessStat(
   //   Field index | Name   | Format | Meaning
   //    10         | minflt | %lu    | # of minor faults the process has made
   //    12         | majflt | %lu    | # of major faults the process has made
-  std::vector<std::string> splits = absl::StrSplit(stat_content, ' ', absl::SkipWhitespace{});
+  std::vector<std::string_view> splits = absl::StrSplit(stat_content, ' ', absl::SkipWhitespace{});
   if (splits.size() != 52) {
     return ErrorMessage(absl::StrFormat("Wrong format: only %d fields", splits.size()));
   }
@@ -194,9 +197,9 @@ ErrorMessageOr<void> UpdateProcessMemoryUsageFromProcessStat(
 ErrorMessageOr<int64_t> ExtractRssAnonFromProcessStatus(std::string_view status_content) {
   if (status_content.empty()) return ErrorMessage("Empty file content.");
 
-  std::vector<std::string> lines = absl::StrSplit(status_content, '\n', absl::SkipEmpty());
+  std::vector<std::string_view> lines = absl::StrSplit(status_content, '\n', absl::SkipEmpty());
   for (std::string_view line : lines) {
-    std::vector<std::string> splits =
+    std::vector<std::string_view> splits =
         absl::StrSplit(line, absl::ByAnyChar(": \t"), absl::SkipWhitespace{});
     if (splits[0] == "RssAnon") {
       if (splits.size() < 3 || splits[2] != "kB") {
@@ -215,14 +218,17 @@ ErrorMessageOr<int64_t> ExtractRssAnonFromProcessStatus(std::string_view status_
   return ErrorMessage("RssAnon value not found in the file content.");
 }
 
-ErrorMessageOr<ProcessMemoryUsage> GetProcessMemoryUsage(pid_t pid) {
+ProcessMemoryUsageReader::ProcessMemoryUsageReader(pid_t pid)
+    : pid_(pid),
+      stat_reader_(absl::StrFormat("/proc/%d/stat", pid)),
+      status_reader_(absl::StrFormat("/proc/%d/status", pid)) {}
+
+ErrorMessageOr<ProcessMemoryUsage> ProcessMemoryUsageReader::Read() {
   ProcessMemoryUsage process_memory_usage = CreateAndInitializeProcessMemoryUsage();
-  process_memory_usage.set_pid(pid);
+  process_memory_usage.set_pid(pid_);
   process_memory_usage.set_timestamp_ns(orbit_base::CaptureTimestampNs());
 
-  const std::string process_page_faults_filename = absl::StrFormat("/proc/%d/stat", pid);
-  ErrorMessageOr<std::string> reading_result =
-      orbit_base::ReadFileToString(process_page_faults_filename);
+  ErrorMessageOr<std::string_view> reading_result = stat_reader_.Read();
   if (reading_result.has_error()) {
     ORBIT_ERROR("%s", reading_result.error().message());
     return reading_result.error();
@@ -230,12 +236,11 @@ ErrorMessageOr<ProcessMemoryUsage> GetProcessMemoryUsage(pid_t pid) {
   ErrorMessageOr<void> updating_result =
       UpdateProcessMemoryUsageFromProcessStat(reading_result.value(), &process_memory_usage);
   if (updating_result.has_error()) {
-    ORBIT_ERROR("Updating ProcessMemoryUsage from %s: %s", process_page_faults_filename,
+    ORBIT_ERROR("Updating ProcessMemoryUsage from %s: %s", stat_reader_.path().string(),
                 updating_result.error().message());
   }
 
-  const std::string process_memory_usage_filename = absl::StrFormat("/proc/%u/status", pid);
-  reading_result = orbit_base::ReadFileToString(process_memory_usage_filename);
+  reading_result = status_reader_.Read();
   if (reading_result.has_error()) {
     ORBIT_ERROR("%s", reading_result.error().message());
     return reading_result.error();
@@ -243,7 +248,7 @@ ErrorMessageOr<ProcessMemoryUsage> GetProcessMemoryUsage(pid_t pid) {
   ErrorMessageOr<int64_t> extracting_result =
       ExtractRssAnonFromProcessStatus(reading_result.value());
   if (extracting_result.has_error()) {
-    ORBIT_ERROR("Extracting process RssAnon from %s: %s", process_memory_usage_filename,
+    ORBIT_ERROR("Extracting process RssAnon from %s: %s", status_reader_.path().string(),
                 extracting_result.error().message());
   } else {
     process_memory_usage.set_rss_anon_kb(extracting_result.value());
@@ -252,6 +257,10 @@ ErrorMessageOr<ProcessMemoryUsage> GetProcessMemoryUsage(pid_t pid) {
   return process_memory_usage;
 }
 
+ErrorMessageOr<ProcessMemoryUsage> GetProcessMemoryUsage(pid_t pid) {
+  return ProcessMemoryUsageReader{pid}.Read();
+}
+
 CGroupMemoryUsage CreateAndInitializeCGroupMemoryUsage() {
   CGroupMemoryUsage cgroup_memory_usage;
   cgroup_memory_usage.set_limit_bytes(kMissingInfo);
@@ -270,11 +279,11 @@ CGroupMemoryUsage CreateAndInitializeCGroupMemoryUsage() {
 std::string GetProcessMemoryCGroupName(std::string_view cgroup_content) {
   if (cgroup_content.empty()) return "";
 
-  std::vector<std::string> lines = absl::StrSplit(cgroup_content, '\n', absl::SkipEmpty());
+  std::vector<std::string_view> lines = absl::StrSplit(cgroup_content, '\n', absl::SkipEmpty());
   for (std::string_view line : lines) {
-    std::vector<std::string> splits = absl::StrSplit(line, absl::MaxSplits(':', 2));
+    std::vector<std::string_view> splits = absl::StrSplit(line, absl::MaxSplits(':', 2));
     // If we find the memory cgroup, return the cgroup name without the leading "/".
-    if (splits.size() == 3 && splits[1] == "memory") return splits[2].substr(1);
+    if (splits.size() == 3 && splits[1] == "memory") return std::string{splits[2].substr(1)};
   }
 
   return "";
@@ -298,10 +307,11 @@ ErrorMessageOr<void> UpdateCGroupMemoryUsageFromMemoryStat(std::string_view memo
                                                            CGroupMemoryUsage* cgroup_memory_usage) {
   if (memory_stat_content.empty()) return ErrorMessage("Empty file content.");
 
-  std::vector<std::string> lines = absl::StrSplit(memory_stat_content, '\n', absl::SkipEmpty());
+  std::vector<std::string_view> lines =
+      absl::StrSplit(memory_stat_content, '\n', absl::SkipEmpty());
   std::string error_message;
   for (std::string_view line : lines) {
-    std::vector<std::string> splits = absl::StrSplit(line, ' ', absl::SkipWhitespace{});
+    std::vector<std::string_view> splits = absl::StrSplit(line, ' ', absl::SkipWhitespace{});
     // According to the document https://www.kernel.org/doc/Documentation/cgroup-v1/memory.txt:
     // Each line of the memory.stat file consists of a parameter name, followed by a whitespace,
     // and the value of the parameter. Also the memory size unit is fixed to "bytes".
@@ -341,12 +351,13 @@ ErrorMessageOr<void> UpdateCGroupMemoryUsageFromMemoryStat(std::string_view memo
   return outcome::success();
 }
 
-ErrorMessageOr<CGroupMemoryUsage> GetCGroupMemoryUsage(pid_t pid) {
+CGroupMemoryUsageReader::CGroupMemoryUsageReader(pid_t pid)
+    : pid_(pid), cgroup_reader_(absl::StrFormat("/proc/%d/cgroup", pid)) {}
+
+ErrorMessageOr<CGroupMemoryUsage> CGroupMemoryUsageReader::Read() {
   uint64_t current_timestamp_ns = orbit_base::CaptureTimestampNs();
 
-  const std::string process_c_groups_filename = absl::StrFormat("/proc/%d/cgroup", pid);
-  ErrorMessageOr<std::string> reading_result =
-      orbit_base::ReadFileToString(process_c_groups_filename);
+  ErrorMessageOr<std::string_view> reading_result = cgroup_reader_.Read();
   if (reading_result.has_error()) {
     ORBIT_ERROR("%s", reading_result.error().message());
     return reading_result.error();
@@ -354,18 +365,26 @@ ErrorMessageOr<CGroupMemoryUsage> GetCGroupMemoryUsage(pid_t pid) {
   std::string cgroup_name = GetProcessMemoryCGroupName(reading_result.value());
   if (cgroup_name.empty()) {
     std::string error_message =
-        absl::StrFormat("Fail to extract the cgroup name of the target process %u.", pid);
+        absl::StrFormat("Fail to extract the cgroup name of the target process %u.", pid_);
     ORBIT_ERROR("%s", error_message);
     return ErrorMessage{std::move(error_message)};
   }
 
+  // The process can be moved to a different cgroup, in which case the files to read change.
+  if (cgroup_name != cgroup_name_ || !memory_limit_reader_.has_value() ||
+      !memory_stat_reader_.has_value()) {
+    memory_limit_reader_.emplace(
+        absl::StrFormat("/sys/fs/cgroup/memory/%s/memory.limit_in_bytes", cgroup_name));
+    memory_stat_reader_.emplace(
+        absl::StrFormat("/sys/fs/cgroup/memory/%s/memory.stat", cgroup_name));
+    cgroup_name_ = cgroup_name;
+  }
+
   CGroupMemoryUsage cgroup_memory_usage = CreateAndInitializeCGroupMemoryUsage();
   cgroup_memory_usage.set_cgroup_name(cgroup_name);
   cgroup_memory_usage.set_timestamp_ns(current_timestamp_ns);
 
-  const std::string c_group_memory_limit_filename =
-      absl::StrFormat("/sys/fs/cgroup/memory/%s/memory.limit_in_bytes", cgroup_name);
-  reading_result = orbit_base::ReadFileToString(c_group_memory_limit_filename);
+  reading_result = memory_limit_reader_->Read();
   if (reading_result.has_error()) {
     ORBIT_ERROR("%s", reading_result.error().message());
     return reading_result.error();
@@ -373,13 +392,11 @@ ErrorMessageOr<CGroupMemoryUsage> GetCGroupMemoryUsage(pid_t pid) {
   ErrorMessageOr<void> updating_result =
       UpdateCGroupMemoryUsageFromMemoryLimitInBytes(reading_result.value(), &cgroup_memory_usage);
   if (updating_result.has_error()) {
-    ORBIT_ERROR("Updating CGroupMemoryUsage from %s: %s", c_group_memory_limit_filename,
+    ORBIT_ERROR("Updating CGroupMemoryUsage from %s: %s", memory_limit_reader_->path().string(),
                 updating_result.error().message());
   }
 
-  const std::string c_group_memory_usage_and_page_faults_filename =
-      absl::StrFormat("/sys/fs/cgroup/memory/%s/memory.stat", cgroup_name);
-  reading_result = orbit_base::ReadFileToString(c_group_memory_usage_and_page_faults_filename);
+  reading_result = memory_stat_reader_->Read();
   if (reading_result.has_error()) {
     ORBIT_ERROR("%s", reading_result.error().message());
     return reading_result.error();
@@ -387,11 +404,56 @@ ErrorMessageOr<CGroupMemoryUsage> GetCGroupMemoryUsage(pid_t pid) {
   updating_result =
       UpdateCGroupMemoryUsageFromMemoryStat(reading_result.value(), &cgroup_memory_usage);
   if (updating_result.has_error()) {
-    ORBIT_ERROR("Updating CGroupMemoryUsage from %s: %s",
-                c_group_memory_usage_and_page_faults_filename, updating_result.error().message());
+    ORBIT_ERROR("Updating CGroupMemoryUsage from %s: %s", memory_stat_reader_->path().string(),
+                updating_result.error().message());
   }
 
   return cgroup_memory_usage;
 }
 
+ErrorMessageOr<CGroupMemoryUsage> GetCGroupMemoryUsage(pid_t pid) {
+  return CGroupMemoryUsageReader{pid}.Read();
+}
+
+ErrorMessageOr<PressureStallTotals> ParsePressureStallTotals(std::string_view pressure_content) {
+  std::optional<uint64_t> some_total_us;
+  uint64_t full_total_us = 0;
+  std::vector<std::string_view> lines = absl::StrSplit(pressure_content, '\n', absl::SkipEmpty());
+  for (std::string_view line : lines) {
+    std::vector<std::string_view> splits = absl::StrSplit(line, ' ', absl::SkipEmpty());
+    if (splits.empty()) continue;
+    for (std::string_view split : splits) {
+      if (!absl::ConsumePrefix(&split, "total=")) continue;
+      uint64_t total_us{};
+      if (!absl::SimpleAtoi(split, &total_us)) {
+        return ErrorMessage(absl::StrFormat("Fail to extract the total stall time from: %s", line));
+      }
+      if (splits[0] == "some") {
+        some_total_us = total_us;
+      } else if (splits[0] == "full") {
+        full_total_us = total_us;
+      }
+    }
+  }
+
+  if (!some_total_us.has_value()) {
+    return ErrorMessage(
+        absl::StrFormat("Fail to find the \"some\" total stall time in: %s", pressure_content));
+  }
+  return PressureStallTotals{some_total_us.value(), full_total_us};
+}
+
+std::optional<std::string> GetProcessUnifiedCGroupPath(std::string_view cgroup_content) {
+  std::vector<std::string_view> lines = absl::StrSplit(cgroup_content, '\n', absl::SkipEmpty());
+  for (std::string_view line : lines) {
+    std::vector<std::string_view> splits = absl::StrSplit(line, absl::MaxSplits(':', 2));
+    // The cgroup v2 hierarchy has the id 0 and no controllers, e.g., "0::/user.slice".
+    if (splits.size() == 3 && splits[0] == "0" && splits[1].empty() &&
+        absl::ConsumePrefix(&splits[2], "/")) {
+      return std::string{splits[2]};
+    }
+  }
+  return std::nullopt;
+}
+
 }  // namespace orbit_memory_tracing
@@ -7,6 +7,7 @@
 #include <gtest/gtest.h>
 #include <stdint.h>
 
+#include <optional>
 #include <string>
 
 #include "GrpcProtos/capture.pb.h"
@@ -598,4 +599,42 @@ rss_huge 0)";
   }
 }
 
+TEST(MemoryUtils, ParsePressureStallTotals) {
+  {
+    ErrorMessageOr<PressureStallTotals> totals =
+        ParsePressureStallTotals(R"(some avg10=1.50 avg60=0.25 avg300=0.05 total=123456
+full avg10=0.50 avg60=0.10 avg300=0.01 total=7890
+)");
+    ASSERT_TRUE(totals.has_value()) << totals.error().message();
+    EXPECT_EQ(totals.value().some_total_us, 123456);
+    EXPECT_EQ(totals.value().full_total_us, 7890);
+  }
+
+  {
+    ErrorMessageOr<PressureStallTotals> totals =
+        ParsePressureStallTotals("some avg10=0.00 avg60=0.00 avg300=0.00 total=42\n");
+    ASSERT_TRUE(totals.has_value()) << totals.error().message();
+    EXPECT_EQ(totals.value().some_total_us, 42);
+    EXPECT_EQ(totals.value().full_total_us, 0);
+  }
+
+  EXPECT_TRUE(
+      ParsePressureStallTotals("full avg10=0.00 avg60=0.00 avg300=0.00 total=42\n").has_error());
+  EXPECT_TRUE(
+      ParsePressureStallTotals("some avg10=0.00 avg60=0.00 avg300=0.00 total=abc\n").has_error());
+  EXPECT_TRUE(ParsePressureStallTotals("").has_error());
+}
+
+TEST(MemoryUtils, GetProcessUnifiedCGroupPath) {
+  EXPECT_EQ(GetProcessUnifiedCGroupPath("0::/user.slice/user-1000.slice/session-3.scope\n"),
+            "user.slice/user-1000.slice/session-3.scope");
+  EXPECT_EQ(GetProcessUnifiedCGroupPath(R"(10:memory:/user.slice
+1:name=systemd:/user.slice/user-1000.slice/session-3.scope
+0::/user.slice/user-1000.slice/session-3.scope)"),
+            "user.slice/user-1000.slice/session-3.scope");
+  EXPECT_EQ(GetProcessUnifiedCGroupPath("0::/\n"), "");
+  EXPECT_EQ(GetProcessUnifiedCGroupPath("10:memory:/user.slice\n"), std::nullopt);
+  EXPECT_EQ(GetProcessUnifiedCGroupPath(""), std::nullopt);
+}
+
 }  // namespace orbit_memory_tracing
\ No newline at end of file
@@ -0,0 +1,180 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "MemoryTracing/PressureStallInfoProducer.h"
+
+#include <absl/strings/str_format.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/SafeStrerror.h"
+#include "OrbitBase/ThreadUtils.h"
+
+namespace orbit_memory_tracing {
+
+using orbit_grpc_protos::PressureStallEvent;
+
+namespace {
+
+[[nodiscard]] ErrorMessageOr<PressureStallTotals> ReadPressureStallTotals(
+    const orbit_base::UniqueFd& fd) {
+  // A pressure file has at most two lines of about 60 characters.
+  std::array<char, 256> buffer{};
+  OUTCOME_TRY(size_t size, orbit_base::ReadFullyAtOffset(fd, buffer.data(), buffer.size(), 0));
+  return ParsePressureStallTotals(std::string_view{buffer.data(), size});
+}
+
+}  // namespace
+
+ErrorMessageOr<void> PressureStallInfoProducer::AddPressureFile(
+    const std::filesystem::path& path, PressureStallEvent::Resource resource, bool is_cgroup) {
+  OUTCOME_TRY(orbit_base::UniqueFd fd, orbit_base::OpenExistingFileForReadWrite(path));
+  OUTCOME_TRY(PressureStallTotals totals, ReadPressureStallTotals(fd));
+
+  // Writing the trigger to the file registers it, until the file is closed. The kernel replaces the
+  // last character written with the null terminator, so the terminator has to be written, too.
+  const std::string trigger = absl::StrFormat("some %u %u", threshold_us_, window_us_);
+  ErrorMessageOr<void> write_result =
+      orbit_base::WriteFully(fd, trigger.c_str(), trigger.size() + 1);
+  if (write_result.has_error()) {
+    return ErrorMessage{absl::StrFormat("Unable to register the trigger \"%s\" on \"%s\": %s",
+                                        trigger, path.string(), write_result.error().message())};
+  }
+
+  pressure_files_.push_back(
+      PressureFile{resource, is_cgroup, std::move(fd), totals, orbit_base::CaptureTimestampNs()});
+  return outcome::success();
+}
+
+ErrorMessageOr<void> PressureStallInfoProducer::Start() {
+  ORBIT_CHECK(thread_ == nullptr);
+  ORBIT_CHECK(listener_ != nullptr);
+
+  constexpr uint64_t kDefaultWindowUs = 1'000'000;
+  if (window_us_ == 0) window_us_ = kDefaultWindowUs;
+
+  std::string errors;
+  auto add_pressure_file = [this, &errors](const std::filesystem::path& path,
+                                           PressureStallEvent::Resource resource, bool is_cgroup) {
+    ErrorMessageOr<void> result = AddPressureFile(path, resource, is_cgroup);
+    if (result.has_error()) {
+      errors += absl::StrFormat("%s: %s\n", path.string(), result.error().message());
+    }
+  };
+  add_pressure_file("/proc/pressure/cpu", PressureStallEvent::kCpu, false);
+  add_pressure_file("/proc/pressure/memory", PressureStallEvent::kMemory, false);
+  add_pressure_file("/proc/pressure/io", PressureStallEvent::kIo, false);
+
+  ErrorMessageOr<std::string> cgroup_content =
+      orbit_base::ReadFileToString(absl::StrFormat("/proc/%d/cgroup", pid_));
+  if (cgroup_content.has_value()) {
+    std::optional<std::string> cgroup_path = GetProcessUnifiedCGroupPath(cgroup_content.value());
+    // The root cgroup has no pressure files, the system ones apply.
+    if (cgroup_path.has_value() && !cgroup_path->empty()) {
+      add_pressure_file(absl::StrFormat("/sys/fs/cgroup/%s/memory.pressure", cgroup_path.value()),
+                        PressureStallEvent::kMemory, true);
+    }
+  }
+
+  if (pressure_files_.empty()) {
+    return ErrorMessage{absl::StrFormat("Unable to register any PSI trigger:\n%s", errors)};
+  }
+  if (!errors.empty()) {
+    ORBIT_ERROR("Registering some of the PSI triggers:\n%s", errors);
+  }
+
+  stop_event_fd_ = orbit_base::UniqueFd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)};
+  if (!stop_event_fd_.valid()) {
+    pressure_files_.clear();
+    return ErrorMessage{absl::StrFormat("eventfd: %s", SafeStrerror(errno))};
+  }
+
+  thread_ = std::make_unique<std::thread>(&PressureStallInfoProducer::Run, this);
+  return outcome::success();
+}
+
+void PressureStallInfoProducer::Stop() {
+  if (thread_ == nullptr) return;
+
+  constexpr uint64_t kEventFdIncrement = 1;
+  if (write(stop_event_fd_.get(), &kEventFdIncrement, sizeof(kEventFdIncrement)) == -1) {
+    ORBIT_ERROR("Writing to eventfd: %s", SafeStrerror(errno));
+  }
+  thread_->join();
+  thread_.reset();
+
+  // Closing the files unregisters the triggers.
+  pressure_files_.clear();
+  stop_event_fd_.release();
+}
+
+void PressureStallInfoProducer::Run() {
+  orbit_base::SetCurrentThreadName("PsiPr::Run");
+
+  std::vector<pollfd> poll_fds;
+  for (const PressureFile& pressure_file : pressure_files_) {
+    poll_fds.push_back({pressure_file.fd.get(), POLLPRI, 0});
+  }
+  poll_fds.push_back({stop_event_fd_.get(), POLLIN, 0});
+  const size_t stop_event_index = poll_fds.size() - 1;
+
+  while (true) {
+    int poll_result = poll(poll_fds.data(), poll_fds.size(), /*timeout=*/-1);
+    if (poll_result == -1) {
+      if (errno == EINTR) continue;
+      ORBIT_ERROR("poll on PSI triggers: %s", SafeStrerror(errno));
+      return;
+    }
+    if (poll_fds[stop_event_index].revents != 0) return;
+
+    for (size_t i = 0; i < pressure_files_.size(); ++i) {
+      const int16_t revents = poll_fds[i].revents;
+      if ((revents & (POLLERR | POLLNVAL)) != 0) {
+        // The trigger was destroyed, e.g., because the cgroup was removed. A negative fd makes
+        // `poll` ignore the entry.
+        ORBIT_ERROR("PSI trigger on fd %d is no longer valid", poll_fds[i].fd);
+        poll_fds[i].fd = -1;
+      } else if ((revents & POLLPRI) != 0) {
+        OnTriggerFired(&pressure_files_[i]);
+      }
+    }
+  }
+}
+
+void PressureStallInfoProducer::OnTriggerFired(PressureFile* pressure_file) {
+  const uint64_t timestamp_ns = orbit_base::CaptureTimestampNs();
+  ErrorMessageOr<PressureStallTotals> totals = ReadPressureStallTotals(pressure_file->fd);
+  if (totals.has_error()) {
+    ORBIT_ERROR("Reading PSI totals: %s", totals.error().message());
+    return;
+  }
+
+  constexpr uint64_t kUsToNs = 1'000;
+  PressureStallEvent event;
+  event.set_resource(pressure_file->resource);
+  event.set_is_cgroup(pressure_file->is_cgroup);
+  event.set_timestamp_ns(timestamp_ns);
+  event.set_duration_ns(timestamp_ns - pressure_file->previous_timestamp_ns);
+  event.set_some_stall_ns(
+      (totals.value().some_total_us - pressure_file->previous_totals.some_total_us) * kUsToNs);
+  event.set_full_stall_ns(
+      (totals.value().full_total_us - pressure_file->previous_totals.full_total_us) * kUsToNs);
+
+  pressure_file->previous_totals = totals.value();
+  pressure_file->previous_timestamp_ns = timestamp_ns;
+  listener_->OnPressureStallEvent(std::move(event));
+}
+
+}  // namespace orbit_memory_tracing
@@ -0,0 +1,36 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "MemoryTracing/ProcFileReader.h"
+
+#include <absl/strings/str_format.h>
+#include <stddef.h>
+
+namespace orbit_memory_tracing {
+
+ErrorMessageOr<std::string_view> ProcFileReader::Read() {
+  if (!fd_.valid()) {
+    OUTCOME_TRY(fd_, orbit_base::OpenFileForReading(path_));
+  }
+  if (buffer_.empty()) buffer_.resize(kInitialBufferSize);
+
+  while (true) {
+    ErrorMessageOr<size_t> bytes_read_or_error =
+        orbit_base::ReadFullyAtOffset(fd_, buffer_.data(), buffer_.size(), 0);
+    if (bytes_read_or_error.has_error()) {
+      fd_.release();
+      return ErrorMessage{absl::StrFormat("Unable to read \"%s\": %s", path_.string(),
+                                          bytes_read_or_error.error().message())};
+    }
+    // The content might not have fit into the buffer. Grow it and read the whole file again, as the
+    // content is only consistent within a single read.
+    if (bytes_read_or_error.value() == buffer_.size()) {
+      buffer_.resize(2 * buffer_.size());
+      continue;
+    }
+    return std::string_view{buffer_.data(), bytes_read_or_error.value()};
+  }
+}
+
+}  // namespace orbit_memory_tracing
@@ -0,0 +1,74 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "MemoryTracing/ProcFileReader.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/WriteStringToFile.h"
+#include "TestUtils/TemporaryFile.h"
+#include "TestUtils/TestUtils.h"
+
+namespace orbit_memory_tracing {
+
+using orbit_test_utils::HasErrorWithMessage;
+using orbit_test_utils::HasNoError;
+using orbit_test_utils::HasValue;
+using orbit_test_utils::TemporaryFile;
+
+namespace {
+
+TemporaryFile CreateTemporaryFile() {
+  ErrorMessageOr<TemporaryFile> temporary_file_or_error = TemporaryFile::Create();
+  ORBIT_CHECK(temporary_file_or_error.has_value());
+  return std::move(temporary_file_or_error.value());
+}
+
+}  // namespace
+
+TEST(ProcFileReader, ReadsTheCurrentContentOnEveryCall) {
+  TemporaryFile temporary_file = CreateTemporaryFile();
+  ProcFileReader reader{temporary_file.file_path()};
+
+  ASSERT_THAT(orbit_base::WriteStringToFile(temporary_file.file_path(), "first content"),
+              HasNoError());
+  EXPECT_THAT(reader.Read(), HasValue("first content"));
+
+  ASSERT_THAT(orbit_base::WriteStringToFile(temporary_file.file_path(), "second"), HasNoError());
+  EXPECT_THAT(reader.Read(), HasValue("second"));
+
+  ASSERT_THAT(orbit_base::WriteStringToFile(temporary_file.file_path(), ""), HasNoError());
+  EXPECT_THAT(reader.Read(), HasValue(""));
+}
+
+TEST(ProcFileReader, ReadsContentLargerThanTheInitialBuffer) {
+  TemporaryFile temporary_file = CreateTemporaryFile();
+  ProcFileReader reader{temporary_file.file_path()};
+
+  const std::string content(20000, 'x');
+  ASSERT_THAT(orbit_base::WriteStringToFile(temporary_file.file_path(), content), HasNoError());
+  EXPECT_THAT(reader.Read(), HasValue(content));
+  EXPECT_THAT(reader.Read(), HasValue(content));
+}
+
+TEST(ProcFileReader, ReadsProcFiles) {
+  ProcFileReader reader{"/proc/self/status"};
+  ErrorMessageOr<std::string_view> content = reader.Read();
+  ASSERT_THAT(content, HasNoError());
+  EXPECT_THAT(std::string{content.value()}, testing::HasSubstr("RssAnon:"));
+}
+
+TEST(ProcFileReader, FailsForNonExistingFile) {
+  ProcFileReader reader{"/proc/this/file/does/not/exist"};
+  EXPECT_THAT(reader.Read(), HasErrorWithMessage("does/not/exist"));
+  EXPECT_THAT(reader.Read(), HasErrorWithMessage("does/not/exist"));
+}
+
+}  // namespace orbit_memory_tracing
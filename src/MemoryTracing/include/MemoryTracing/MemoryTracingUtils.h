@@ -8,10 +8,12 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <optional>
 #include <string>
 #include <string_view>
 
 #include "GrpcProtos/capture.pb.h"
+#include "MemoryTracing/ProcFileReader.h"
 #include "OrbitBase/Result.h"
 
 namespace orbit_memory_tracing {
@@ -27,6 +29,17 @@ namespace orbit_memory_tracing {
     std::string_view vmstat_content, orbit_grpc_protos::SystemMemoryUsage* system_memory_usage);
 [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::SystemMemoryUsage> GetSystemMemoryUsage();
 
+// The following readers produce the same results as the corresponding Get methods, but keep the
+// files they read open between calls to `Read`. Prefer them when sampling repeatedly.
+class SystemMemoryUsageReader {
+ public:
+  [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::SystemMemoryUsage> Read();
+
+ private:
+  ProcFileReader meminfo_reader_{"/proc/meminfo"};
+  ProcFileReader vmstat_reader_{"/proc/vmstat"};
+};
+
 [[nodiscard]] orbit_grpc_protos::ProcessMemoryUsage CreateAndInitializeProcessMemoryUsage();
 [[nodiscard]] ErrorMessageOr<void> UpdateProcessMemoryUsageFromProcessStat(
     std::string_view stat_content, orbit_grpc_protos::ProcessMemoryUsage* process_memory_usage);
@@ -35,6 +48,17 @@ namespace orbit_memory_tracing {
 [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::ProcessMemoryUsage> GetProcessMemoryUsage(
     pid_t pid);
 
+class ProcessMemoryUsageReader {
+ public:
+  explicit ProcessMemoryUsageReader(pid_t pid);
+  [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::ProcessMemoryUsage> Read();
+
+ private:
+  pid_t pid_;
+  ProcFileReader stat_reader_;
+  ProcFileReader status_reader_;
+};
+
 [[nodiscard]] orbit_grpc_protos::CGroupMemoryUsage CreateAndInitializeCGroupMemoryUsage();
 [[nodiscard]] std::string GetProcessMemoryCGroupName(std::string_view cgroup_content);
 [[nodiscard]] ErrorMessageOr<void> UpdateCGroupMemoryUsageFromMemoryLimitInBytes(
@@ -45,6 +69,37 @@ namespace orbit_memory_tracing {
     orbit_grpc_protos::CGroupMemoryUsage* cgroup_memory_usage);
 [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::CGroupMemoryUsage> GetCGroupMemoryUsage(pid_t pid);
 
+class CGroupMemoryUsageReader {
+ public:
+  explicit CGroupMemoryUsageReader(pid_t pid);
+  [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::CGroupMemoryUsage> Read();
+
+ private:
+  pid_t pid_;
+  ProcFileReader cgroup_reader_;
+  // Recreated when the memory cgroup of the process changes.
+  std::string cgroup_name_;
+  std::optional<ProcFileReader> memory_limit_reader_;
+  std::optional<ProcFileReader> memory_stat_reader_;
+};
+
+// The cumulative stall times in a PSI pressure file like "/proc/pressure/memory".
+struct PressureStallTotals {
+  uint64_t some_total_us = 0;
+  uint64_t full_total_us = 0;
+};
+// Parses the "total" fields of the content of a pressure file, e.g.:
+//   some avg10=0.00 avg60=0.00 avg300=0.00 total=12345
+//   full avg10=0.00 avg60=0.00 avg300=0.00 total=6789
+// Before Linux 5.13, "/proc/pressure/cpu" has no "full" line, and `full_total_us` is then 0.
+[[nodiscard]] ErrorMessageOr<PressureStallTotals> ParsePressureStallTotals(
+    std::string_view pressure_content);
+// Returns the path of the cgroup v2 of a process relative to "/sys/fs/cgroup", without the leading
+// "/", from the content of "/proc/<pid>/cgroup". Returns std::nullopt if the process isn't in a
+// cgroup v2 hierarchy.
+[[nodiscard]] std::optional<std::string> GetProcessUnifiedCGroupPath(
+    std::string_view cgroup_content);
+
 }  // namespace orbit_memory_tracing
 
 #endif  // MEMORY_TRACING_MEMORY_TRACING_UTILS_H_
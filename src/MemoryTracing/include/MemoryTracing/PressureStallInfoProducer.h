@@ -0,0 +1,77 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEMORY_TRACING_PRESSURE_STALL_INFO_PRODUCER_H_
+#define MEMORY_TRACING_PRESSURE_STALL_INFO_PRODUCER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+#include "MemoryTracing/MemoryTracingUtils.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_memory_tracing {
+
+class PressureStallInfoListener {
+ public:
+  virtual ~PressureStallInfoListener() = default;
+  virtual void OnPressureStallEvent(orbit_grpc_protos::PressureStallEvent pressure_stall_event) = 0;
+};
+
+// This class registers PSI (pressure stall information) triggers on the CPU, memory and IO pressure
+// files of the system and on the memory pressure file of the cgroup v2 of the target process. A
+// trigger fires when the tasks were stalled on the resource for at least `threshold_us` within a
+// window of `window_us`, and the kernel notifies it at most once per window. Instead of sampling
+// periodically, the thread of the producer blocks in `poll` on the triggers, and sends a
+// `PressureStallEvent` to the listener each time one fires.
+class PressureStallInfoProducer {
+ public:
+  explicit PressureStallInfoProducer(PressureStallInfoListener* listener, uint64_t threshold_us,
+                                     uint64_t window_us, pid_t pid)
+      : listener_(listener), threshold_us_(threshold_us), window_us_(window_us), pid_(pid) {}
+
+  PressureStallInfoProducer(const PressureStallInfoProducer&) = delete;
+  PressureStallInfoProducer& operator=(const PressureStallInfoProducer&) = delete;
+  PressureStallInfoProducer(PressureStallInfoProducer&&) = delete;
+  PressureStallInfoProducer& operator=(PressureStallInfoProducer&&) = delete;
+
+  // Fails if no trigger could be registered, e.g., with a kernel built without CONFIG_PSI.
+  [[nodiscard]] ErrorMessageOr<void> Start();
+  void Stop();
+
+ private:
+  struct PressureFile {
+    orbit_grpc_protos::PressureStallEvent::Resource resource;
+    bool is_cgroup;
+    orbit_base::UniqueFd fd;
+    PressureStallTotals previous_totals;
+    uint64_t previous_timestamp_ns;
+  };
+
+  [[nodiscard]] ErrorMessageOr<void> AddPressureFile(
+      const std::filesystem::path& path, orbit_grpc_protos::PressureStallEvent::Resource resource,
+      bool is_cgroup);
+  void Run();
+  void OnTriggerFired(PressureFile* pressure_file);
+
+  PressureStallInfoListener* listener_;
+  uint64_t threshold_us_;
+  uint64_t window_us_;
+  pid_t pid_;
+  std::vector<PressureFile> pressure_files_;
+  // Written to by Stop, to wake up the thread blocked in `poll`.
+  orbit_base::UniqueFd stop_event_fd_;
+  std::unique_ptr<std::thread> thread_;
+};
+
+}  // namespace orbit_memory_tracing
+
+#endif  // MEMORY_TRACING_PRESSURE_STALL_INFO_PRODUCER_H_
@@ -0,0 +1,41 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEMORY_TRACING_PROC_FILE_READER_H_
+#define MEMORY_TRACING_PROC_FILE_READER_H_
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_memory_tracing {
+
+// Reads the whole content of a file like "/proc/meminfo", whose content the kernel generates anew
+// on every read from offset zero. The file is kept open between reads and read with `pread` into a
+// buffer that is reused, so that sampling at high rates doesn't reopen the file and reallocate
+// every time. If opening or reading fails, the file is opened again on the next call.
+class ProcFileReader {
+ public:
+  explicit ProcFileReader(std::filesystem::path path) : path_(std::move(path)) {}
+
+  // The returned view is only valid until the next call.
+  [[nodiscard]] ErrorMessageOr<std::string_view> Read();
+
+  [[nodiscard]] const std::filesystem::path& path() const { return path_; }
+
+ private:
+  static constexpr size_t kInitialBufferSize = 4096;
+
+  std::filesystem::path path_;
+  orbit_base::UniqueFd fd_;
+  std::string buffer_;
+};
+
+}  // namespace orbit_memory_tracing
+
+#endif  // MEMORY_TRACING_PROC_FILE_READER_H_
@@ -39,8 +39,9 @@ using ::orbit_mizar_base::TID;
   std::atomic<bool> capture_loading_cancellation_requested = false;
 
   // The treatment is the same for CaptureOutcome::kComplete, CaptureOutcome::kCancelled
-  std::ignore = orbit_capture_client::LoadCapture(data, capture_file.get(),
-                                                  &capture_loading_cancellation_requested);
+  std::ignore = orbit_capture_client::LoadCapture(
+      data, capture_file.get(), &capture_loading_cancellation_requested,
+      orbit_mizar_data::MizarData::GetLoadCaptureFilter());
   return outcome::success();
 }
 
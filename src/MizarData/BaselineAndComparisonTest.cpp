@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <string>
@@ -203,7 +204,7 @@ const orbit_client_data::ScopeStats kNonEmptyScopeStats = [] {
   return result;
 }();
 
-constexpr orbit_client_data::ScopeStats kEmptyScopeStats;
+const orbit_client_data::ScopeStats kEmptyScopeStats;
 
 constexpr double kStatistic = 1.234;
 constexpr std::array<double, kSfidCount> kPvalues = {0.01, 0.02, 0.05};
@@ -230,6 +231,14 @@ class MockPairedData {
     std::for_each(std::begin(callstacks_), std::end(callstacks_), std::forward<Action>(action));
   }
 
+  template <typename Action>
+  void ForEachCallstackWithCount(TID /*tid*/, RelativeTimeNs /*min_timestamp*/,
+                                 RelativeTimeNs /*max_timestamp*/, Action&& action) const {
+    for (const std::vector<SampledFunctionId>& callstack : callstacks_) {
+      std::invoke(action, callstack, uint64_t{1});
+    }
+  }
+
   [[nodiscard]] orbit_client_data::ScopeStats ActiveInvocationTimeStats(
       const absl::flat_hash_set<TID>& /*tids*/, FrameTrackId /*frame_track_scope_id*/,
       RelativeTimeNs /*min_relative_timestamp_ns*/,
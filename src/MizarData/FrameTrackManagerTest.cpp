@@ -18,7 +18,6 @@
 
 #include "ClientData/ScopeId.h"
 #include "ClientData/ScopeInfo.h"
-#include "ClientProtos/capture_data.pb.h"
 #include "GrpcProtos/capture.pb.h"
 #include "MizarBase/Time.h"
 #include "MizarData/FrameTrack.h"
@@ -29,7 +28,6 @@
 
 using ::orbit_client_data::ScopeId;
 using ::orbit_client_data::ScopeInfo;
-using ::orbit_client_protos::TimerInfo;
 using ::orbit_grpc_protos::PresentEvent;
 using ::orbit_mizar_base::TimestampNs;
 using ::orbit_test_utils::MakeMap;
@@ -44,8 +42,6 @@ namespace {
 
 class MockCaptureData {
  public:
-  MOCK_METHOD(std::vector<const TimerInfo*>, GetTimersForScope, (ScopeId, uint64_t, uint64_t),
-              (const));
   MOCK_METHOD(std::vector<ScopeId>, GetAllProvidedScopeIds, (), (const));
   MOCK_METHOD(ScopeInfo, GetScopeInfo, (ScopeId scope_id), (const));
 };
@@ -55,6 +51,8 @@ class MockMizarData {
   MOCK_METHOD(const MockCaptureData&, GetCaptureData, (), (const));
   MOCK_METHOD((absl::flat_hash_map<PresentEvent::Source, std::vector<PresentEvent>>),
               source_to_present_events, (), (const));
+  MOCK_METHOD(std::vector<TimestampNs>, GetScopeFrameStarts, (ScopeId, TimestampNs, TimestampNs),
+              (const));
 };
 
 }  // namespace
@@ -80,34 +78,8 @@ static const std::vector<TimestampNs> kSecondScopeStarts = MakeTimestamps({200,
 static const std::vector<std::vector<TimestampNs>> kScopeFrameTrackStartLists = {
     kFirstScopeStarts, kSecondScopeStarts};
 
-// Re-wrap the values form `TimestampNs` into `TimerInfos`
-static std::vector<TimerInfo> ToTimerInfos(absl::Span<const TimestampNs> starts) {
-  std::vector<TimerInfo> result;
-  std::transform(std::begin(starts), std::end(starts), std::back_inserter(result),
-                 [](TimestampNs start) {
-                   TimerInfo timer;
-                   timer.set_start(*start);
-                   return timer;
-                 });
-  return result;
-}
-
-static const std::vector<TimerInfo> kFirstScopeTimers = ToTimerInfos(kFirstScopeStarts);
-static const std::vector<TimerInfo> kSecondScopeTimers = ToTimerInfos(kSecondScopeStarts);
-
-static std::vector<const TimerInfo*> MakePtrs(absl::Span<const TimerInfo> timers) {
-  std::vector<const TimerInfo*> result;
-  std::transform(std::begin(timers), std::end(timers), std::back_inserter(result),
-                 [](const TimerInfo& timer) { return &timer; });
-  return result;
-}
-
-static const std::vector<const TimerInfo*> kFirstScopeTimerPtrs = MakePtrs(kFirstScopeTimers);
-static const std::vector<const TimerInfo*> kSecondScopeTimerPtrs = MakePtrs(kSecondScopeTimers);
-
-static const absl::flat_hash_map<ScopeId, std::vector<const TimerInfo*>> kScopeIdToSTimerInfoPtrs =
-    MakeMap(kScopeIds, std::vector<std::vector<const TimerInfo*>>{kFirstScopeTimerPtrs,
-                                                                  kSecondScopeTimerPtrs});
+static const absl::flat_hash_map<ScopeId, std::vector<TimestampNs>> kScopeIdToFrameStarts =
+    MakeMap(kScopeIds, kScopeFrameTrackStartLists);
 static const absl::flat_hash_map<ScopeId, ScopeInfo> kScopeIdToInfo =
     MakeMap(kScopeIds, kScopeInfos);
 static const absl::flat_hash_map<ScopeInfo, std::vector<TimestampNs>> kScopeInfoToFrameStarts =
@@ -167,9 +139,9 @@ class ExpectFrameTracksHasFrameStartsForScopes : public ::testing::Test {
     EXPECT_CALL(capture_data_, GetScopeInfo).WillRepeatedly(Invoke([](const ScopeId id) {
       return kScopeIdToInfo.at(id);
     }));
-    EXPECT_CALL(capture_data_, GetTimersForScope)
-        .WillRepeatedly(Invoke([](const ScopeId id, uint64_t /*min*/, uint64_t /*max*/) {
-          return kScopeIdToSTimerInfoPtrs.at(id);
+    EXPECT_CALL(data_, GetScopeFrameStarts)
+        .WillRepeatedly(Invoke([](const ScopeId id, TimestampNs /*min*/, TimestampNs /*max*/) {
+          return kScopeIdToFrameStarts.at(id);
         }));
   }
 
@@ -224,8 +196,8 @@ TEST_F(ExpectFrameTracksHasFrameStartsForScopes, FrameTracksAreCorrectForScopesA
 
   ExpectGetFrameTracksIsCorrect(kScopeInfos, {});
 
-  // Filtering of scopes w.r.t min/max timestamp is handles by Capture data, it is not covered
-  // in the test, hence we just pass zeroes. The MockCaptureData ignores these anyway.
+  // Filtering of scopes w.r.t min/max timestamp is handles by Mizar data, it is not covered
+  // in the test, hence we just pass zeroes. The MockMizarData ignores these anyway.
   ExpectGetFrameTracksReturnsExpectedValueForEachFrameTrack(TimestampNs(0), TimestampNs(0));
 }
 
@@ -4,16 +4,19 @@
 
 #include "MizarData/MizarData.h"
 
+#include <absl/algorithm/container.h>
 #include <absl/container/flat_hash_set.h>
 #include <absl/types/span.h>
 
 #include <QString>
 #include <QStringLiteral>
+#include <algorithm>
 #include <filesystem>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "ClientData/CallstackData.h"
 #include "ClientData/CallstackInfo.h"
@@ -22,8 +25,8 @@
 #include "ClientData/ModuleManager.h"
 #include "ClientData/ProcessData.h"
 #include "ClientData/ScopeInfo.h"
-#include "ClientData/ThreadTrackDataProvider.h"
 #include "ClientSymbols/QSettingsBasedStorageManager.h"
+#include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/symbol.pb.h"
 #include "MizarBase/AbsoluteAddress.h"
 #include "ObjectUtils/SymbolsFile.h"
@@ -33,7 +36,9 @@
 
 using ::orbit_mizar_base::AbsoluteAddress;
 using ::orbit_mizar_base::ForEachFrame;
+using ::orbit_grpc_protos::ClientCaptureEvent;
 using ::orbit_mizar_base::FunctionSymbol;
+using ::orbit_mizar_base::TimestampNs;
 
 namespace orbit_mizar_data {
 
@@ -84,6 +89,26 @@ void MizarData::OnCaptureStarted(const orbit_grpc_protos::CaptureStarted& captur
       std::make_unique<orbit_client_data::ModuleManager>(module_identifier_provider_.get());
 }
 
+void MizarData::OnCaptureFinished(const orbit_grpc_protos::CaptureFinished& /*capture_finished*/) {
+  GetMutableCaptureData().OnCaptureComplete();
+  for (auto& [unused_scope_id, frame_starts] : scope_id_to_frame_starts_) {
+    absl::c_sort(frame_starts);
+  }
+  LoadSymbolsForAllModules();
+}
+
+orbit_capture_client::LoadCaptureFilter MizarData::GetLoadCaptureFilter() {
+  orbit_capture_client::LoadCaptureFilter filter;
+  filter.event_cases = {
+      ClientCaptureEvent::kFunctionCall,    ClientCaptureEvent::kFunctionCallBatch,
+      ClientCaptureEvent::kApiScopeStart,   ClientCaptureEvent::kApiScopeStop,
+      ClientCaptureEvent::kCallstackSample, ClientCaptureEvent::kCallstackSampleBatch,
+      ClientCaptureEvent::kPresentEvent};
+  return filter;
+}
+
+// Only the start timestamps are kept, rather than the `TimerInfo`s in the `CaptureData`, as that is
+// all the frame tracks need.
 void MizarData::OnTimer(const orbit_client_protos::TimerInfo& timer_info) {
   const std::optional<ScopeId> scope_id = GetCaptureData().ProvideScopeId(timer_info);
   if (!scope_id.has_value()) return;
@@ -92,10 +117,19 @@ void MizarData::OnTimer(const orbit_client_protos::TimerInfo& timer_info) {
       GetCaptureData().GetScopeInfo(scope_id.value()).GetType();
   if (scope_type == orbit_client_data::ScopeType::kDynamicallyInstrumentedFunction ||
       scope_type == orbit_client_data::ScopeType::kApiScope) {
-    GetMutableCaptureData().GetThreadTrackDataProvider()->AddTimer(timer_info);
+    scope_id_to_frame_starts_[scope_id.value()].emplace_back(timer_info.start());
   }
 }
 
+std::vector<TimestampNs> MizarData::GetScopeFrameStarts(ScopeId scope_id, TimestampNs min_start,
+                                                        TimestampNs max_start) const {
+  const auto it = scope_id_to_frame_starts_.find(scope_id);
+  if (it == scope_id_to_frame_starts_.end()) return {};
+  const std::vector<TimestampNs>& frame_starts = it->second;
+  return {std::lower_bound(frame_starts.begin(), frame_starts.end(), min_start),
+          std::upper_bound(frame_starts.begin(), frame_starts.end(), max_start)};
+}
+
 std::optional<std::string> MizarData::GetFunctionNameFromAddress(AbsoluteAddress address) const {
   const std::string name =
       orbit_client_data::GetFunctionNameByAddress(*module_manager_, GetCaptureData(), *address);
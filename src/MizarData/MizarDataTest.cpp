@@ -2,11 +2,11 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <absl/algorithm/container.h>
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
 #include <absl/hash/hash.h>
 #include <gmock/gmock.h>
-#include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
 #include <stddef.h>
 
@@ -15,6 +15,7 @@
 #include <cstdint>
 #include <filesystem>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -27,6 +28,7 @@
 #include "ClientData/CallstackType.h"
 #include "ClientData/CaptureData.h"
 #include "ClientData/LinuxAddressInfo.h"
+#include "ClientData/ScopeId.h"
 #include "ClientData/ScopeInfo.h"
 #include "ClientData/TimerTrackDataIdManager.h"
 #include "ClientProtos/capture_data.pb.h"
@@ -34,15 +36,20 @@
 #include "GrpcProtos/module.pb.h"
 #include "MizarBase/AbsoluteAddress.h"
 #include "MizarBase/FunctionSymbols.h"
+#include "MizarBase/Time.h"
 #include "MizarData/MizarData.h"
 #include "OrbitBase/Typedef.h"
 
+using ::orbit_client_data::ScopeId;
 using ::orbit_mizar_base::AbsoluteAddress;
 using ::orbit_mizar_base::FunctionSymbol;
+using ::orbit_mizar_base::TimestampNs;
+using ::testing::ElementsAre;
 using ::testing::Invoke;
+using ::testing::IsEmpty;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
-using ::testing::UnorderedPointwise;
+using ::testing::UnorderedElementsAreArray;
 
 namespace {
 class MockMizarData : public orbit_mizar_data::MizarData {
@@ -56,7 +63,7 @@ class MockMizarData : public orbit_mizar_data::MizarData {
 
 namespace orbit_mizar_data {
 
-using google::protobuf::util::MessageDifferencer;
+constexpr TimestampNs kMaxTimestamp(std::numeric_limits<uint64_t>::max());
 
 constexpr size_t kTimersNum = 5;
 constexpr std::array<uint64_t, kTimersNum> kStarts{10, 20, 30, 40, 50};
@@ -104,23 +111,12 @@ const orbit_grpc_protos::CaptureStarted kCaptureStarted = [] {
   return result;
 }();
 
-const absl::flat_hash_set<orbit_client_data::ScopeType> kStoredScopeTypes = {
-    orbit_client_data::ScopeType::kApiScope,
-    orbit_client_data::ScopeType::kDynamicallyInstrumentedFunction};
-
 static void CallOnCaptureStarted(MizarData& data) {
   orbit_grpc_protos::CaptureStarted capture_started;
   capture_started.capture_options().instrumented_functions();
   data.OnCaptureStarted(kCaptureStarted, "path/to/file", {});
 }
 
-MATCHER(TimerInfosEq, "") {
-  const TimerInfo& a = std::get<0>(arg);
-  const TimerInfo& b = std::get<1>(arg);
-
-  return MessageDifferencer::Equivalent(a, b);
-}
-
 TEST(MizarDataTest, OnCaptureStartedInitializesCaptureData) {
   MizarData data;
   EXPECT_FALSE(data.HasCaptureData());
@@ -141,13 +137,41 @@ TEST(MizarDataTest, OnTimerAddsDAndMSAndOnlyThem) {
   }
   data.OnCaptureFinished({});
 
-  std::vector<const TimerInfo*> stored_timers_ptrs =
-      data.GetCaptureData().GetAllScopeTimers(kStoredScopeTypes);
-  std::vector<TimerInfo> stored_timers;
-  std::transform(std::begin(stored_timers_ptrs), std::end(stored_timers_ptrs),
-                 std::back_inserter(stored_timers), [](const TimerInfo* ptr) { return (*ptr); });
+  std::vector<TimestampNs> stored_starts;
+  for (const ScopeId scope_id : data.GetCaptureData().GetAllProvidedScopeIds()) {
+    const std::vector<TimestampNs> starts =
+        data.GetScopeFrameStarts(scope_id, TimestampNs(0), kMaxTimestamp);
+    stored_starts.insert(stored_starts.end(), starts.begin(), starts.end());
+  }
+  std::vector<TimestampNs> expected_starts;
+  absl::c_transform(kTimersToStore, std::back_inserter(expected_starts),
+                    [](const TimerInfo& timer) { return TimestampNs(timer.start()); });
+
+  EXPECT_THAT(stored_starts, UnorderedElementsAreArray(expected_starts));
+}
+
+TEST(MizarDataTest, GetScopeFrameStartsIsSortedAndFiltered) {
+  MizarData data;
+  CallOnCaptureStarted(data);
+  std::for_each(kTimersToStore.rbegin(), kTimersToStore.rend(),
+                [&data](const TimerInfo& timer) { data.OnTimer(timer); });
+  data.OnCaptureFinished({});
 
-  EXPECT_THAT(stored_timers, UnorderedPointwise(TimerInfosEq(), kTimersToStore));
+  const std::optional<ScopeId> function_scope_id =
+      data.GetCaptureData().ProvideScopeId(kTimersToStore[0]);
+  ASSERT_TRUE(function_scope_id.has_value());
+  EXPECT_THAT(data.GetScopeFrameStarts(function_scope_id.value(), TimestampNs(0), kMaxTimestamp),
+              ElementsAre(TimestampNs(10), TimestampNs(20), TimestampNs(30)));
+  EXPECT_THAT(data.GetScopeFrameStarts(function_scope_id.value(), TimestampNs(15), TimestampNs(30)),
+              ElementsAre(TimestampNs(20), TimestampNs(30)));
+  EXPECT_THAT(data.GetScopeFrameStarts(function_scope_id.value(), TimestampNs(31), kMaxTimestamp),
+              IsEmpty());
+
+  const std::optional<ScopeId> api_scope_id =
+      data.GetCaptureData().ProvideScopeId(kTimersToStore[3]);
+  ASSERT_TRUE(api_scope_id.has_value());
+  EXPECT_THAT(data.GetScopeFrameStarts(api_scope_id.value(), TimestampNs(0), kMaxTimestamp),
+              ElementsAre(TimestampNs(40), TimestampNs(50)));
 }
 
 constexpr AbsoluteAddress kFunctionAddress(0xBEAF);
@@ -288,6 +288,35 @@ TEST_F(MizarPairedDataTest, ForeachCallstackIsCorrect) {
   EXPECT_THAT(actual_ids_fed_to_action, UnorderedElementsAre(kAnotherCompleteCallstackIds));
 }
 
+TEST_F(MizarPairedDataTest, ForEachCallstackWithCountIsCorrect) {
+  MizarPairedDataUnderTest mizar_paired_data(std::move(data_), kAddressToId);
+  std::vector<std::pair<std::vector<SampledFunctionId>, uint64_t>> actual_ids_and_counts;
+  auto action = [&actual_ids_and_counts](const std::vector<SampledFunctionId>& ids,
+                                         uint64_t count) {
+    actual_ids_and_counts.emplace_back(ids, count);
+  };
+
+  // all timestamps
+  actual_ids_and_counts.clear();
+  mizar_paired_data.ForEachCallstackWithCount(kTID, RelativeTimeNs(0), kRelativeTime5, action);
+  EXPECT_THAT(actual_ids_and_counts,
+              UnorderedElementsAre(std::make_pair(kCompleteCallstackIds, uint64_t{2}),
+                                   std::make_pair(kInCompleteCallstackIds, uint64_t{1})));
+
+  actual_ids_and_counts.clear();
+  mizar_paired_data.ForEachCallstackWithCount(kAnotherTID, RelativeTimeNs(0), kRelativeTime5,
+                                              action);
+  EXPECT_THAT(actual_ids_and_counts,
+              UnorderedElementsAre(std::make_pair(kAnotherCompleteCallstackIds, uint64_t{1})));
+
+  //  some timestamps
+  actual_ids_and_counts.clear();
+  mizar_paired_data.ForEachCallstackWithCount(kTID, kRelativeTime1, kRelativeTime5, action);
+  EXPECT_THAT(actual_ids_and_counts,
+              UnorderedElementsAre(std::make_pair(kCompleteCallstackIds, uint64_t{1}),
+                                   std::make_pair(kInCompleteCallstackIds, uint64_t{1})));
+}
+
 constexpr RelativeTimeNs kDoubledSamplingPeriod = Times(kSamplingPeriod, uint64_t{2});
 
 const auto kExpectedInvocationTimes = {kDoubledSamplingPeriod, kDoubledSamplingPeriod};
@@ -120,15 +120,16 @@ class BaselineAndComparisonTmpl {
     uint64_t total_callstacks = 0;
     absl::flat_hash_map<SFID, InclusiveAndExclusive> counts;
     for (const TID tid : config.tids) {
-      data.ForEachCallstackEvent(tid, config.start_relative, config.EndRelative(),
-                                 [&total_callstacks, &counts](absl::Span<const SFID> callstack) {
-                                   total_callstacks++;
-                                   if (callstack.empty()) return;
-                                   for (const SFID sfid : callstack) {
-                                     counts[sfid].inclusive++;
-                                   }
-                                   counts[callstack.front()].exclusive++;
-                                 });
+      data.ForEachCallstackWithCount(
+          tid, config.start_relative, config.EndRelative(),
+          [&total_callstacks, &counts](absl::Span<const SFID> callstack, uint64_t count) {
+            total_callstacks += count;
+            if (callstack.empty()) return;
+            for (const SFID sfid : callstack) {
+              counts[sfid].inclusive += count;
+            }
+            counts[callstack.front()].exclusive += count;
+          });
     }
 
     return SamplingCounts(std::move(counts), total_callstacks);
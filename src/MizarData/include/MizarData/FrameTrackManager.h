@@ -59,15 +59,7 @@ class FrameTrackManagerTmpl {
   [[nodiscard]] std::vector<TimestampNs> GetScopeFrameStarts(TimestampNs min_start,
                                                              TimestampNs max_start,
                                                              ScopeId scope_id) const {
-    const std::vector<const TimerInfo*> timers =
-        GetCaptureData().GetTimersForScope(scope_id, *min_start, *max_start);
-
-    std::vector<TimestampNs> result;
-    result.reserve(timers.size());
-    absl::c_transform(timers, std::back_inserter(result), [](const TimerInfo* timer) {
-      return orbit_mizar_base::TimestampNs(timer->start());
-    });
-    return result;
+    return data_->GetScopeFrameStarts(scope_id, min_start, max_start);
   }
 
   [[nodiscard]] std::vector<TimestampNs> GetEtwFrameStarts(TimestampNs min_start,
@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "CaptureClient/AbstractCaptureListener.h"
+#include "CaptureClient/LoadCapture.h"
 #include "ClientData/ApiStringEvent.h"
 #include "ClientData/ApiTrackValue.h"
 #include "ClientData/CaptureData.h"
@@ -30,6 +31,8 @@
 #include "ClientData/ScopeId.h"
 #include "ClientData/SystemMemoryInfo.h"
 #include "ClientData/ThreadStateSliceInfo.h"
+#include "ClientData/TracepointEventInfo.h"
+#include "ClientData/TracepointInfo.h"
 #include "ClientData/TimerTrackDataIdManager.h"
 #include "ClientProtos/capture_data.pb.h"
 #include "GrpcProtos/capture.pb.h"
@@ -45,6 +48,9 @@ namespace orbit_mizar_data {
 
 // This class is used by Mizar to read a capture file and load the symbols.
 // Also owns a map from the function absolute addresses to their names.
+// Only the data Mizar compares is kept: sampled callstacks, the start timestamps of dynamically
+// instrumented functions and manual scopes, and present events. Everything else is dropped while
+// loading, and `GetLoadCaptureFilter` lets `LoadCapture` skip most of it without parsing.
 class MizarData : public orbit_capture_client::AbstractCaptureListener<MizarData>,
                   public MizarDataProvider {
   using ScopeId = ::orbit_client_data::ScopeId;
@@ -86,14 +92,18 @@ class MizarData : public orbit_capture_client::AbstractCaptureListener<MizarData
         static_cast<uint64_t>(1'000'000'000 / samples_per_second));
   }
 
+  [[nodiscard]] std::vector<orbit_mizar_base::TimestampNs> GetScopeFrameStarts(
+      ScopeId scope_id, orbit_mizar_base::TimestampNs min_start,
+      orbit_mizar_base::TimestampNs max_start) const override;
+
+  // The event kinds Mizar needs. Events that other events depend on are loaded regardless.
+  [[nodiscard]] static orbit_capture_client::LoadCaptureFilter GetLoadCaptureFilter();
+
   void OnCaptureStarted(const orbit_grpc_protos::CaptureStarted& capture_started,
                         std::optional<std::filesystem::path> file_path,
                         absl::flat_hash_set<uint64_t> frame_track_function_ids) override;
 
-  void OnCaptureFinished(const orbit_grpc_protos::CaptureFinished& /*capture_finished*/) override {
-    GetMutableCaptureData().OnCaptureComplete();
-    LoadSymbolsForAllModules();
-  }
+  void OnCaptureFinished(const orbit_grpc_protos::CaptureFinished& /*capture_finished*/) override;
 
   void OnTimer(const orbit_client_protos::TimerInfo& timer_info) override;
 
@@ -118,9 +128,19 @@ class MizarData : public orbit_capture_client::AbstractCaptureListener<MizarData
                         /*page_faults_info*/) override {}
   void OnSystemMemoryInfo(const orbit_client_data::SystemMemoryInfo&
                           /*system_memory_info*/) override {}
+  void OnPressureStallEvent(const orbit_grpc_protos::PressureStallEvent&
+                            /*pressure_stall_event*/) override {}
+  void OnPerformanceCounterSample(const orbit_grpc_protos::PerformanceCounterSample&
+                                  /*performance_counter_sample*/) override {}
   void OnKeyAndString(uint64_t /*key*/, std::string /*str*/) override {}
   void OnThreadStateSlice(orbit_client_data::ThreadStateSliceInfo /*thread_state_slice*/) override {
   }
+  void OnThreadStateSlices(
+      absl::Span<const orbit_client_data::ThreadStateSliceInfo> /*thread_state_slices*/) override {}
+  void OnUniqueTracepointInfo(uint64_t /*tracepoint_id*/,
+                              orbit_client_data::TracepointInfo /*tracepoint_info*/) override {}
+  void OnTracepointEvent(
+      orbit_client_data::TracepointEventInfo /*tracepoint_event_info*/) override {}
   void OnApiStringEvent(const orbit_client_data::ApiStringEvent& /*unused*/) override {}
   void OnApiTrackValue(const orbit_client_data::ApiTrackValue& /*unused*/) override {}
   void OnWarningEvent(orbit_grpc_protos::WarningEvent /*warning_event*/) override {}
@@ -143,6 +163,8 @@ class MizarData : public orbit_capture_client::AbstractCaptureListener<MizarData
       orbit_grpc_protos::LostPerfRecordsEvent /*lost_perf_records_event*/) override {}
   void OnOutOfOrderEventsDiscardedEvent(orbit_grpc_protos::OutOfOrderEventsDiscardedEvent
                                         /*out_of_order_events_discarded_event*/) override {}
+  void OnPerfEventProcessingStatsEvent(orbit_grpc_protos::PerfEventProcessingStatsEvent
+                                       /*perf_event_processing_stats_event*/) override {}
 
  private:
   void UpdateModules(absl::Span<const orbit_grpc_protos::ModuleInfo> module_infos);
@@ -157,6 +179,9 @@ class MizarData : public orbit_capture_client::AbstractCaptureListener<MizarData
   std::unique_ptr<orbit_client_data::ModuleManager> module_manager_;
   orbit_symbols::SymbolHelper symbol_helper_{orbit_paths::CreateOrGetCacheDirUnsafe()};
   absl::flat_hash_map<PresentEvent::Source, std::vector<PresentEvent>> source_to_present_events_;
+  // Sorted in `OnCaptureFinished`.
+  absl::flat_hash_map<ScopeId, std::vector<orbit_mizar_base::TimestampNs>>
+      scope_id_to_frame_starts_;
 };
 
 }  // namespace orbit_mizar_data
@@ -9,8 +9,10 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "ClientData/CaptureDataHolder.h"
+#include "ClientData/ScopeId.h"
 #include "MizarBase/AbsoluteAddress.h"
 #include "MizarBase/FunctionSymbols.h"
 #include "MizarBase/Time.h"
@@ -41,6 +43,12 @@ class MizarDataProvider : public orbit_client_data::CaptureDataHolder {
   [[nodiscard]] virtual absl::flat_hash_map<AbsoluteAddress, orbit_mizar_base::FunctionSymbol>
   AllAddressToFunctionSymbol() const = 0;
 
+  // Returns the sorted start timestamps of the timers of `scope_id` that start in
+  // [`min_start`, `max_start`].
+  [[nodiscard]] virtual std::vector<orbit_mizar_base::TimestampNs> GetScopeFrameStarts(
+      orbit_client_data::ScopeId scope_id, orbit_mizar_base::TimestampNs min_start,
+      orbit_mizar_base::TimestampNs max_start) const = 0;
+
   [[nodiscard]] virtual orbit_mizar_base::TimestampNs GetCaptureStartTimestampNs() const = 0;
 
   [[nodiscard]] virtual orbit_mizar_base::RelativeTimeNs GetNominalSamplingPeriodNs() const = 0;
@@ -13,6 +13,7 @@
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <utility>
@@ -31,6 +32,7 @@
 #include "MizarData/FrameTrack.h"
 #include "MizarData/FrameTrackManager.h"
 #include "MizarData/MizarDataProvider.h"
+#include "OrbitBase/Logging.h"
 
 namespace orbit_mizar_data {
 
@@ -58,6 +60,7 @@ class MizarPairedDataTmpl {
         address_to_sfid_(std::move(address_to_sfid)),
         frame_tracks_(data_.get()) {
     SetThreadNamesAndCallstackCounts();
+    SetCallstackIdToSFIDs();
   }
 
   // The function estimates how much of CPU-time has been actually spent by the threads in `tids`
@@ -123,10 +126,7 @@ class MizarPairedDataTmpl {
                              RelativeTimeNs max_relative_timestamp, Action&& action) const {
     auto action_on_callstack_events =
         [this, &action](const orbit_client_data::CallstackEvent& event) -> void {
-      const orbit_client_data::CallstackInfo* callstack =
-          GetCallstackData().GetCallstack(event.callstack_id());
-      const std::vector<SFID> sfids = CallstackWithSFIDs(callstack);
-      std::invoke(action, sfids);
+      std::invoke(action, GetSFIDs(event.callstack_id()));
     };
 
     const auto [min_timestamp_ns, max_timestamp_ns] =
@@ -135,6 +135,21 @@ class MizarPairedDataTmpl {
                                           action_on_callstack_events);
   }
 
+  // Action is a void callable that takes a `const std::vector<SFID>&` representing a distinct
+  // callstack and a `uint64_t`, the number of samples of that callstack. Unlike
+  // `ForEachCallstackEvent`, the action is invoked once per callstack rather than once per sample.
+  template <typename Action>
+  void ForEachCallstackWithCount(TID tid, RelativeTimeNs min_relative_timestamp,
+                                 RelativeTimeNs max_relative_timestamp, Action&& action) const {
+    const auto [min_timestamp_ns, max_timestamp_ns] =
+        RelativeToAbsoluteTimestampRange(min_relative_timestamp, max_relative_timestamp);
+    ORBIT_CHECK(*min_timestamp_ns <= *max_timestamp_ns);
+    for (const auto& [callstack_id, count] :
+         GetCallstackIdToCountOfTidInTimeRange(tid, min_timestamp_ns, max_timestamp_ns)) {
+      std::invoke(action, GetSFIDs(callstack_id), uint64_t{count});
+    }
+  }
+
   [[nodiscard]] RelativeTimeNs CaptureDurationNs() const {
     return Sub(orbit_mizar_base::TimestampNs(GetCallstackData().max_time()),
                data_->GetCaptureStartTimestampNs());
@@ -190,6 +205,21 @@ class MizarPairedDataTmpl {
         });
   }
 
+  // The callstacks are converted to SFIDs once, so that recomputing the statistics for another
+  // time range or set of threads only reduces over the cached callstacks.
+  void SetCallstackIdToSFIDs() {
+    GetCallstackData().ForEachUniqueCallstack(
+        [this](uint64_t callstack_id, const orbit_client_data::CallstackInfo& callstack) {
+          callstack_id_to_sfids_.try_emplace(callstack_id, CallstackWithSFIDs(&callstack));
+        });
+  }
+
+  [[nodiscard]] const std::vector<SFID>& GetSFIDs(uint64_t callstack_id) const {
+    const auto it = callstack_id_to_sfids_.find(callstack_id);
+    ORBIT_CHECK(it != callstack_id_to_sfids_.end());
+    return it->second;
+  }
+
   template <typename Action>
   void ForEachCallstackEventOfTidInTimeRange(TID tid, TimestampNs min_timestamp_ns,
                                              TimestampNs max_timestamp_ns,
@@ -198,11 +228,25 @@ class MizarPairedDataTmpl {
         *tid, *min_timestamp_ns, *max_timestamp_ns, action_on_callstack_events);
   }
 
+  // Counted from the per-block histograms of CallstackData, so that long ranges don't visit each of
+  // their CallstackEvents. Like ForEachCallstackEventOfTidInTimeRange, `max_timestamp_ns` is
+  // included.
+  [[nodiscard]] absl::flat_hash_map<uint64_t, uint32_t> GetCallstackIdToCountOfTidInTimeRange(
+      TID tid, TimestampNs min_timestamp_ns, TimestampNs max_timestamp_ns) const {
+    const uint64_t time_end = *max_timestamp_ns == std::numeric_limits<uint64_t>::max()
+                                  ? *max_timestamp_ns
+                                  : *max_timestamp_ns + 1;
+    return GetCallstackData().GetCallstackIdToCountOfTidInTimeRange(*tid, *min_timestamp_ns,
+                                                                    time_end);
+  }
+
   [[nodiscard]] uint64_t CountCallstackSamples(TID tid, TimestampNs min_timestamp_ns,
                                                TimestampNs max_timestamp_ns) const {
     uint64_t count = 0;
-    ForEachCallstackEventOfTidInTimeRange(tid, min_timestamp_ns, max_timestamp_ns,
-                                          [&count](const auto& /*callstack*/) { count++; });
+    for (const auto& [unused_callstack_id, callstack_count] :
+         GetCallstackIdToCountOfTidInTimeRange(tid, min_timestamp_ns, max_timestamp_ns)) {
+      count += callstack_count;
+    }
     return count;
   }
 
@@ -246,6 +290,7 @@ class MizarPairedDataTmpl {
   FrameTracks frame_tracks_;
   absl::flat_hash_map<TID, std::string> tid_to_names_;
   absl::flat_hash_map<TID, uint64_t> tid_to_callstack_samples_counts_;
+  absl::flat_hash_map<uint64_t, std::vector<SFID>> callstack_id_to_sfids_;
 };
 
 using MizarPairedData =
@@ -5,14 +5,15 @@
 #include "ModuleUtils/ReadLinuxMaps.h"
 
 #include <absl/strings/ascii.h>
-#include <absl/strings/numbers.h>
 #include <absl/strings/str_format.h>
-#include <absl/strings/str_split.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
-#include <algorithm>
+#include <charconv>
 #include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 #include "OrbitBase/Logging.h"
@@ -26,40 +27,65 @@ ErrorMessageOr<std::string> ReadMaps(pid_t pid) {
   return std::move(proc_pid_maps_content);
 }
 
-std::vector<LinuxMemoryMapping> ParseMaps(std::string_view proc_pid_maps_content) {
-  const std::vector<std::string> proc_pid_maps_lines = absl::StrSplit(proc_pid_maps_content, '\n');
-  std::vector<LinuxMemoryMapping> result;
+namespace {
 
-  for (const std::string& line : proc_pid_maps_lines) {
-    // The number of spaces from the inode to the path is variable, and the path can contain spaces,
-    // so we need to limit the number of splits and remove leading spaces from the path separately.
-    std::vector<std::string> tokens = absl::StrSplit(line, absl::MaxSplits(' ', 5));
-    if (tokens.size() < 5) continue;
-    ORBIT_CHECK(tokens.size() == 5 || tokens.size() == 6);
+// Returns the part of `*str` up to the first `delimiter` (or all of `*str`) and removes it from
+// `*str`, together with the delimiter.
+[[nodiscard]] std::string_view ConsumeToken(std::string_view* str, char delimiter) {
+  const size_t delimiter_index = str->find(delimiter);
+  std::string_view token = str->substr(0, delimiter_index);
+  str->remove_prefix(delimiter_index == std::string_view::npos ? str->size()
+                                                               : delimiter_index + 1);
+  return token;
+}
 
-    const std::vector<std::string> start_and_end = absl::StrSplit(tokens[0], '-');
-    if (start_and_end.size() != 2) continue;
-    const uint64_t start = std::stoull(start_and_end[0], nullptr, 16);
-    const uint64_t end = std::stoull(start_and_end[1], nullptr, 16);
+[[nodiscard]] bool ParseUint64(std::string_view str, int base, uint64_t* value) {
+  if (str.empty()) return false;
+  const auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), *value, base);
+  return error == std::errc{} && end == str.data() + str.size();
+}
 
-    const uint64_t offset = std::stoull(tokens[2], nullptr, 16);
+}  // namespace
 
-    if (tokens[1].size() < 4) continue;
+std::vector<LinuxMemoryMapping> ParseMaps(std::string_view proc_pid_maps_content) {
+  std::vector<LinuxMemoryMapping> result;
+  // A line has at least about 50 characters.
+  constexpr size_t kMinLineSize = 50;
+  result.reserve(proc_pid_maps_content.size() / kMinLineSize);
+
+  // This parses the lines in place, only the paths are copied.
+  while (!proc_pid_maps_content.empty()) {
+    std::string_view line = ConsumeToken(&proc_pid_maps_content, '\n');
+
+    std::string_view address_range = ConsumeToken(&line, ' ');
+    const std::string_view perms_token = ConsumeToken(&line, ' ');
+    const std::string_view offset_token = ConsumeToken(&line, ' ');
+    const std::string_view device_token = ConsumeToken(&line, ' ');
+    if (device_token.empty()) continue;
+    const std::string_view inode_token = ConsumeToken(&line, ' ');
+
+    const std::string_view start_token = ConsumeToken(&address_range, '-');
+    uint64_t start{};
+    uint64_t end{};
+    if (!ParseUint64(start_token, 16, &start) || !ParseUint64(address_range, 16, &end)) continue;
+
+    uint64_t offset{};
+    if (!ParseUint64(offset_token, 16, &offset)) continue;
+
+    if (perms_token.size() < 4) continue;
     uint64_t perms = 0;
-    if (tokens[1][0] == 'r') perms |= PROT_READ;
-    if (tokens[1][1] == 'w') perms |= PROT_WRITE;
-    if (tokens[1][2] == 'x') perms |= PROT_EXEC;
+    if (perms_token[0] == 'r') perms |= PROT_READ;
+    if (perms_token[1] == 'w') perms |= PROT_WRITE;
+    if (perms_token[2] == 'x') perms |= PROT_EXEC;
 
     uint64_t inode{};
-    if (!absl::SimpleAtoi(tokens[4], &inode)) continue;
+    if (!ParseUint64(inode_token, 10, &inode)) continue;
 
-    std::string pathname;
-    if (tokens.size() == 6) {
-      absl::StripLeadingAsciiWhitespace(&tokens[5]);
-      pathname = std::move(tokens[5]);
-    }
+    // The number of spaces from the inode to the path is variable, and the path can contain spaces,
+    // so only the leading spaces are removed.
+    const std::string_view pathname = absl::StripLeadingAsciiWhitespace(line);
 
-    result.emplace_back(start, end, perms, offset, inode, std::move(pathname));
+    result.emplace_back(start, end, perms, offset, inode, std::string{pathname});
   }
 
   return result;
@@ -75,6 +75,10 @@ TEST(ReadLinuxMaps, ParseMapsFromInvalidProcPidMapsContent) {
   maps = ParseMaps("00400000-00452000 r-x 00000000 08:02 173521      /usr/bin/dbus-daemon");
   EXPECT_EQ(maps.size(), 0);
 
+  // Non-hexadecimal address.
+  maps = ParseMaps("0040000g-00452000 r-xp 00000000 08:02 173521      /usr/bin/dbus-daemon\n");
+  EXPECT_EQ(maps.size(), 0);
+
   // Non-numeric inode.
   maps = ParseMaps("00400000-00452000 r-xp 00000000 08:02 173521a      /usr/bin/dbus-daemon\n");
   EXPECT_EQ(maps.size(), 0);
@@ -4,11 +4,17 @@
 
 #include "ModuleUtils/ReadLinuxModules.h"
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
 #include <absl/strings/match.h>
 #include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include <absl/types/span.h>
+#include <errno.h>
 #include <stdint.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include <unistd.h>
 
 #include <algorithm>
@@ -17,7 +23,6 @@
 #include <memory>
 #include <optional>
 #include <string>
-#include <system_error>
 #include <utility>
 #include <vector>
 
@@ -27,6 +32,7 @@
 #include "OrbitBase/Align.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/SafeStrerror.h"
 
 using orbit_grpc_protos::ModuleInfo;
 using orbit_object_utils::CreateObjectFile;
@@ -34,25 +40,32 @@ using orbit_object_utils::ObjectFile;
 
 namespace orbit_module_utils {
 
-ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path,
-                                        uint64_t start_address, uint64_t end_address) {
-  // This excludes mapped character or block devices.
-  if (absl::StartsWith(module_path.string(), "/dev/")) {
-    return ErrorMessage(absl::StrFormat(
-        "The module \"%s\" is a character or block device (is in /dev/)", module_path));
-  }
+namespace {
 
-  if (!std::filesystem::exists(module_path)) {
-    return ErrorMessage(absl::StrFormat("The module file \"%s\" does not exist", module_path));
+// Identifies a version of a file: replacing or modifying the file changes the inode or the
+// modification time.
+struct FileVersion {
+  std::string path;
+  dev_t device;
+  ino_t inode;
+  int64_t modification_time_ns;
+  uint64_t size;
+
+  friend bool operator==(const FileVersion& lhs, const FileVersion& rhs) {
+    return lhs.path == rhs.path && lhs.device == rhs.device && lhs.inode == rhs.inode &&
+           lhs.modification_time_ns == rhs.modification_time_ns && lhs.size == rhs.size;
   }
 
-  std::error_code error;
-  uint64_t file_size = std::filesystem::file_size(module_path, error);
-  if (error) {
-    return ErrorMessage(
-        absl::StrFormat("Unable to get size of \"%s\": %s", module_path, error.message()));
+  template <typename H>
+  friend H AbslHashValue(H h, const FileVersion& version) {
+    return H::combine(std::move(h), version.path, version.device, version.inode,
+                      version.modification_time_ns, version.size);
   }
+};
 
+// Creates the `ModuleInfo` of an object file, without the address range it is mapped at.
+ErrorMessageOr<ModuleInfo> CreateModuleWithoutAddressRange(const std::filesystem::path& module_path,
+                                                           uint64_t file_size) {
   auto object_file_or_error = CreateObjectFile(module_path);
   if (object_file_or_error.has_error()) {
     return ErrorMessage(absl::StrFormat("Unable to create module from object file: %s",
@@ -62,8 +75,6 @@ ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path
   ModuleInfo module_info;
   module_info.set_file_path(module_path);
   module_info.set_file_size(file_size);
-  module_info.set_address_start(start_address);
-  module_info.set_address_end(end_address);
   module_info.set_name(object_file_or_error.value()->GetName());
   module_info.set_load_bias(object_file_or_error.value()->GetLoadBias());
   module_info.set_build_id(object_file_or_error.value()->GetBuildId());
@@ -88,6 +99,65 @@ ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path
   return module_info;
 }
 
+// Parsing an object file to get its build id and segments is by far the most expensive part of
+// reading the modules of a process, and it is repeated for the same files on every request and on
+// every mmap. So the results are cached per version of the file.
+class ModuleInfoCache {
+ public:
+  [[nodiscard]] ErrorMessageOr<ModuleInfo> GetOrCreate(const std::filesystem::path& module_path,
+                                                       const struct stat& file_stat) {
+    FileVersion version{module_path.string(), file_stat.st_dev, file_stat.st_ino,
+                        file_stat.st_mtim.tv_sec * 1'000'000'000 + file_stat.st_mtim.tv_nsec,
+                        static_cast<uint64_t>(file_stat.st_size)};
+    {
+      absl::MutexLock lock(&mutex_);
+      auto it = module_infos_.find(version);
+      if (it != module_infos_.end()) return it->second;
+    }
+
+    ErrorMessageOr<ModuleInfo> module_info =
+        CreateModuleWithoutAddressRange(module_path, version.size);
+    absl::MutexLock lock(&mutex_);
+    module_infos_.try_emplace(std::move(version), module_info);
+    return module_info;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<FileVersion, ErrorMessageOr<ModuleInfo>> module_infos_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+ModuleInfoCache& GetModuleInfoCache() {
+  static ModuleInfoCache cache;
+  return cache;
+}
+
+}  // namespace
+
+ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path,
+                                        uint64_t start_address, uint64_t end_address) {
+  // This excludes mapped character or block devices.
+  if (absl::StartsWith(module_path.string(), "/dev/")) {
+    return ErrorMessage(absl::StrFormat(
+        "The module \"%s\" is a character or block device (is in /dev/)", module_path));
+  }
+
+  struct stat file_stat {};
+  if (stat(module_path.c_str(), &file_stat) != 0) {
+    if (errno == ENOENT) {
+      return ErrorMessage(absl::StrFormat("The module file \"%s\" does not exist", module_path));
+    }
+    return ErrorMessage(
+        absl::StrFormat("Unable to get size of \"%s\": %s", module_path, SafeStrerror(errno)));
+  }
+
+  OUTCOME_TRY(ModuleInfo module_info, GetModuleInfoCache().GetOrCreate(module_path, file_stat));
+  module_info.set_address_start(start_address);
+  module_info.set_address_end(end_address);
+  return module_info;
+}
+
 ErrorMessageOr<std::vector<ModuleInfo>> ReadModules(pid_t pid) {
   OUTCOME_TRY(auto&& maps, ReadAndParseMaps(pid));
   return ReadModulesFromMaps(maps);
@@ -153,24 +223,15 @@ class FileMappedIntoMemory {
   FileMappedIntoMemory(std::string file_path, uint64_t first_map_start, uint64_t first_map_offset)
       : file_path_{std::move(file_path)},
         first_map_start_{first_map_start},
-        first_map_offset_{first_map_offset} {
-    if (absl::StartsWith(file_path_, "/dev/")) {
-      // This is a device file.
-      return;
-    }
-
-    ErrorMessageOr<std::unique_ptr<ObjectFile>> object_file_or_error = CreateObjectFile(file_path_);
-    if (object_file_or_error.has_error()) {
-      return;
-    }
-
-    object_file_ = std::move(object_file_or_error.value());
-  }
+        first_map_offset_{first_map_offset},
+        is_device_{absl::StartsWith(file_path_, "/dev/")} {}
 
   [[nodiscard]] const std::string& GetFilePath() const { return file_path_; }
 
   void AddExecFileMap(uint64_t map_start, uint64_t map_end) {
-    if (object_file_ == nullptr) {
+    // Whether the file is an object file is only determined when creating the module, so that the
+    // many files that are never mapped as executable are not parsed.
+    if (is_device_) {
       return;
     }
 
@@ -189,7 +250,8 @@ class FileMappedIntoMemory {
   }
 
   void AddAnonExecMapIfCoffTextSection(uint64_t map_start, uint64_t map_end) {
-    if (object_file_ == nullptr) {
+    const ObjectFile* object_file = GetObjectFile();
+    if (object_file == nullptr) {
       return;
     }
 
@@ -201,7 +263,7 @@ class FileMappedIntoMemory {
 
     // Remember: we are only detecting anonymous maps that correspond to executable sections of PEs,
     // because loadable segments of ELF files can always be file-mapped.
-    if (!object_file_->IsCoff()) {
+    if (!object_file->IsCoff()) {
       ORBIT_LOG("%s: object file is not a PE", error_message);
       return;
     }
@@ -220,7 +282,7 @@ class FileMappedIntoMemory {
     constexpr uint64_t kPageSize = 0x1000;
     // The end address of the map in which the last byte of the PE is mapped.
     const uint64_t end_address =
-        base_address + orbit_base::AlignUp<kPageSize>(object_file_->GetImageSize());
+        base_address + orbit_base::AlignUp<kPageSize>(object_file->GetImageSize());
     // We validate that the executable map is fully contained in the address range at which the PE
     // is supposed to be mapped.
     if (map_end > end_address) {
@@ -250,9 +312,26 @@ class FileMappedIntoMemory {
   }
 
  private:
+  // Only anonymous executable maps need the object file itself, which is rare, so it is created on
+  // first use.
+  [[nodiscard]] const ObjectFile* GetObjectFile() {
+    if (is_device_) return nullptr;
+    if (!object_file_created_) {
+      object_file_created_ = true;
+      ErrorMessageOr<std::unique_ptr<ObjectFile>> object_file_or_error =
+          CreateObjectFile(file_path_);
+      if (object_file_or_error.has_value()) {
+        object_file_ = std::move(object_file_or_error.value());
+      }
+    }
+    return object_file_.get();
+  }
+
   std::string file_path_;
   uint64_t first_map_start_;
   uint64_t first_map_offset_;
+  bool is_device_;
+  bool object_file_created_ = false;
   std::unique_ptr<ObjectFile> object_file_;
 
   uint64_t min_exec_map_start = std::numeric_limits<uint64_t>::max();
@@ -71,6 +71,48 @@ TEST(ReadLinuxModules, CreateModuleElf) {
   VerifyObjectSegmentsForHelloWorldElf(result.value().object_segments());
 }
 
+TEST(ReadLinuxModules, CreateModuleAgainWithOtherAddressesAndAfterFileChanged) {
+  const std::filesystem::path test_path = orbit_test::GetTestdataDir();
+  ErrorMessageOr<std::string> hello_world_contents_or_error =
+      orbit_base::ReadFileToString(test_path / "hello_world_elf");
+  ASSERT_THAT(hello_world_contents_or_error, HasNoError());
+  ErrorMessageOr<std::string> no_symbols_contents_or_error =
+      orbit_base::ReadFileToString(test_path / "no_symbols_elf");
+  ASSERT_THAT(no_symbols_contents_or_error, HasNoError());
+
+  auto temporary_file_or_error = orbit_test_utils::TemporaryFile::Create();
+  ASSERT_THAT(temporary_file_or_error, HasNoError());
+  orbit_test_utils::TemporaryFile& temporary_file = temporary_file_or_error.value();
+  ASSERT_THAT(orbit_base::WriteFully(temporary_file.fd(), hello_world_contents_or_error.value()),
+              HasNoError());
+
+  auto result1 = CreateModule(temporary_file.file_path(), 23, 8004);
+  ASSERT_THAT(result1, HasNoError());
+  EXPECT_EQ(result1.value().address_start(), 23);
+  EXPECT_EQ(result1.value().address_end(), 8004);
+  EXPECT_EQ(result1.value().build_id(), kHelloWorldElfBuildId);
+
+  // The same file at other addresses.
+  auto result2 = CreateModule(temporary_file.file_path(), 42, 4242);
+  ASSERT_THAT(result2, HasNoError());
+  EXPECT_EQ(result2.value().address_start(), 42);
+  EXPECT_EQ(result2.value().address_end(), 4242);
+  EXPECT_EQ(result2.value().build_id(), kHelloWorldElfBuildId);
+
+  // The file is replaced by another object file at the same path.
+  temporary_file.CloseAndRemove();
+  ErrorMessageOr<orbit_base::UniqueFd> fd_or_error =
+      orbit_base::OpenNewFileForWriting(temporary_file.file_path());
+  ASSERT_THAT(fd_or_error, HasNoError());
+  ASSERT_THAT(orbit_base::WriteFully(fd_or_error.value(), no_symbols_contents_or_error.value()),
+              HasNoError());
+
+  auto result3 = CreateModule(temporary_file.file_path(), 23, 8004);
+  ASSERT_THAT(result3, HasNoError());
+  EXPECT_EQ(result3.value().build_id(), "b5413574bbacec6eacb3b89b1012d0e2cd92ec6b");
+  EXPECT_EQ(result3.value().file_size(), 18768);
+}
+
 TEST(ReadLinuxModules, CreateModuleInDev) {
   const std::filesystem::path dev_zero_path = "/dev/zero";
 
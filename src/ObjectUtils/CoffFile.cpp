@@ -20,7 +20,6 @@
 #include <llvm/DebugInfo/DWARF/DWARFContext.h>
 #include <llvm/DebugInfo/DWARF/DWARFDie.h>
 #include <llvm/DebugInfo/DWARF/DWARFUnit.h>
-#include <llvm/Demangle/Demangle.h>
 #include <llvm/Object/Binary.h>
 #include <llvm/Object/COFF.h>
 #include <llvm/Object/CVDebugRecord.h>
@@ -43,6 +42,7 @@
 #include "GrpcProtos/module.pb.h"
 #include "GrpcProtos/symbol.pb.h"
 #include "Introspection/Introspection.h"
+#include "ObjectUtils/DemangleCache.h"
 #include "ObjectUtils/SymbolsFile.h"
 #include "ObjectUtils/WindowsBuildIdUtils.h"
 #include "OrbitBase/Logging.h"
@@ -166,7 +166,7 @@ std::optional<SymbolInfo> CoffFileImpl::CreateSymbolInfo(
   const uint64_t symbol_virtual_address = GetLoadBias() + section_offset.value() + value.get();
 
   SymbolInfo symbol_info;
-  symbol_info.set_demangled_name(llvm::demangle(name.get().str()));
+  symbol_info.set_demangled_name(DemangleCache::GetDefault().Demangle(name.get()));
   symbol_info.set_address(symbol_virtual_address);
 
   // The COFF symbol table doesn't contain the size of symbols. Set a placeholder which indicates
@@ -294,7 +294,7 @@ void CoffFileImpl::AddNewDebugSymbolsFromDwarf(llvm::DWARFContext* dwarf_context
       // so this should never return an empty name.
       std::string name(full_die.getName(llvm::DINameKind::LinkageName));
       ORBIT_CHECK(!name.empty());
-      symbol_info.set_demangled_name(llvm::demangle(name));
+      symbol_info.set_demangled_name(DemangleCache::GetDefault().Demangle(name));
       symbol_info.set_address(low_pc);
       symbol_info.set_size(high_pc - low_pc);
       // We currently only support hotpatchable functions in elf files.
@@ -0,0 +1,57 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ObjectUtils/DemangleCache.h"
+
+#include <llvm/Demangle/Demangle.h>
+#include <xxhash.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace orbit_object_utils {
+
+namespace {
+constexpr uint64_t kMangledNameHashSeed = 0x9E3779B97F4A7C15;
+}  // namespace
+
+DemangleCache::DemangleCache(size_t max_size)
+    : max_size_per_shard_{std::max<size_t>(1, max_size / kShardCount)} {}
+
+std::string DemangleCache::Demangle(std::string_view mangled_name) {
+  const uint64_t hash = XXH64(mangled_name.data(), mangled_name.size(), kMangledNameHashSeed);
+  Shard& shard = shards_[hash % kShardCount];
+  {
+    absl::ReaderMutexLock lock(&shard.mutex);
+    auto it = shard.demangled_names.find(hash);
+    if (it != shard.demangled_names.end()) return it->second;
+  }
+
+  // Demangled outside of the lock, so that other threads are not blocked meanwhile. If two threads
+  // demangle the same name at the same time, both get the same result.
+  std::string demangled_name = llvm::demangle(std::string{mangled_name});
+  if (demangled_name == mangled_name) return demangled_name;
+
+  absl::MutexLock lock(&shard.mutex);
+  if (shard.demangled_names.size() < max_size_per_shard_) {
+    shard.demangled_names.try_emplace(hash, demangled_name);
+  }
+  return demangled_name;
+}
+
+size_t DemangleCache::size() const {
+  size_t size = 0;
+  for (const Shard& shard : shards_) {
+    absl::ReaderMutexLock lock(&shard.mutex);
+    size += shard.demangled_names.size();
+  }
+  return size;
+}
+
+DemangleCache& DemangleCache::GetDefault() {
+  static auto* cache = new DemangleCache();
+  return *cache;
+}
+
+}  // namespace orbit_object_utils
@@ -0,0 +1,61 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_cat.h>
+#include <gtest/gtest.h>
+#include <llvm/Demangle/Demangle.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ObjectUtils/DemangleCache.h"
+
+namespace orbit_object_utils {
+
+TEST(DemangleCache, DemanglesLikeLlvm) {
+  DemangleCache cache;
+  for (const char* name : {"_ZN3foo3barEv", "_Z3bazIiEvT_", "?foo@@YAXH@Z", "main", ""}) {
+    EXPECT_EQ(cache.Demangle(name), llvm::demangle(name));
+  }
+  EXPECT_EQ(cache.Demangle("_ZN3foo3barEv"), "foo::bar()");
+}
+
+TEST(DemangleCache, StoresOnlyMangledNames) {
+  DemangleCache cache;
+  EXPECT_EQ(cache.Demangle("main"), "main");
+  EXPECT_EQ(cache.size(), 0);
+
+  EXPECT_EQ(cache.Demangle("_ZN3foo3barEv"), "foo::bar()");
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.Demangle("_ZN3foo3barEv"), "foo::bar()");
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(DemangleCache, StopsGrowingWhenFull) {
+  constexpr size_t kMaxSize = 64;
+  DemangleCache cache(kMaxSize);
+  for (int i = 0; i < 1000; ++i) {
+    const std::string name = absl::StrCat("function", i);
+    EXPECT_EQ(cache.Demangle(absl::StrCat("_Z", name.size(), name, "v")), name + "()");
+  }
+  EXPECT_LE(cache.size(), kMaxSize);
+}
+
+TEST(DemangleCache, CanBeUsedByMultipleThreads) {
+  DemangleCache cache;
+  std::vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < 4; ++thread_index) {
+    threads.emplace_back([&cache] {
+      for (int i = 0; i < 1000; ++i) {
+        const std::string name = absl::StrCat("function", i % 100);
+        EXPECT_EQ(cache.Demangle(absl::StrCat("_Z", name.size(), name, "v")), name + "()");
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(cache.size(), 100);
+}
+
+}  // namespace orbit_object_utils
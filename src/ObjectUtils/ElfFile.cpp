@@ -23,8 +23,6 @@
 #include <llvm/DebugInfo/DWARF/DWARFDebugLine.h>
 #include <llvm/DebugInfo/DWARF/DWARFDie.h>
 #include <llvm/DebugInfo/DWARF/DWARFFormValue.h>
-#include <llvm/DebugInfo/Symbolize/Symbolize.h>
-#include <llvm/Demangle/Demangle.h>
 #include <llvm/Object/Binary.h>
 #include <llvm/Object/ELF.h>
 #include <llvm/Object/ELFObjectFile.h>
@@ -46,6 +44,7 @@
 #include "GrpcProtos/module.pb.h"
 #include "GrpcProtos/symbol.pb.h"
 #include "Introspection/Introspection.h"
+#include "ObjectUtils/DemangleCache.h"
 #include "OrbitBase/File.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
@@ -103,11 +102,16 @@ class ElfFileImpl : public ElfFile {
       const llvm::object::ELFSymbolRef& symbol_ref,
       const absl::flat_hash_set<uint64_t>& hotpachable_addresses);
   [[nodiscard]] absl::flat_hash_set<uint64_t> LoadHotpatchableAddresses();
+  // Creates the DWARFContext on first use. The context parses the headers of the compile units
+  // and the index from address ranges to compile units only once, the latter from .debug_aranges
+  // or, for the compile units not covered by it, from their unit DIEs. All the DIEs and the line
+  // table of a compile unit are only parsed once an address in it is queried.
+  [[nodiscard]] llvm::DWARFContext& GetDwarfContext();
 
   const std::filesystem::path file_path_;
   llvm::object::OwningBinary<llvm::object::ObjectFile> owning_binary_;
   llvm::object::ELFObjectFile<ElfT>* object_file_;
-  llvm::symbolize::LLVMSymbolizer symbolizer_;
+  std::unique_ptr<llvm::DWARFContext> dwarf_context_;
   std::string build_id_;
   std::string soname_;
   bool has_symtab_section_;
@@ -393,7 +397,7 @@ ErrorMessageOr<SymbolInfo> ElfFileImpl<ElfT>::CreateSymbolInfo(
   }
 
   SymbolInfo symbol_info;
-  symbol_info.set_demangled_name(llvm::demangle(name));
+  symbol_info.set_demangled_name(DemangleCache::GetDefault().Demangle(name));
   symbol_info.set_address(maybe_value.get());
   symbol_info.set_size(symbol_ref.getSize());
   symbol_info.set_is_hotpatchable(IsHotpatchable(hotpachable_addresses, maybe_value.get()));
@@ -716,29 +720,32 @@ const std::filesystem::path& ElfFileImpl<ElfT>::GetFilePath() const {
 }
 
 template <typename ElfT>
-ErrorMessageOr<LineInfo> orbit_object_utils::ElfFileImpl<ElfT>::GetLineInfo(uint64_t address) {
-  ORBIT_CHECK(has_debug_info_section_);
-  auto line_info_or_error =
-      symbolizer_.symbolizeInlinedCode(std::string{object_file_->getFileName()},
-                                       {address, llvm::object::SectionedAddress::UndefSection});
-  if (!line_info_or_error) {
-    return ErrorMessage(
-        absl::StrFormat("Unable to get line number info for \"%s\", address=0x%x: %s",
-                        std::string{object_file_->getFileName()}, address,
-                        llvm::toString(line_info_or_error.takeError())));
+llvm::DWARFContext& orbit_object_utils::ElfFileImpl<ElfT>::GetDwarfContext() {
+  if (dwarf_context_ == nullptr) {
+    dwarf_context_ = llvm::DWARFContext::create(*owning_binary_.getBinary());
+    ORBIT_CHECK(dwarf_context_ != nullptr);
   }
+  return *dwarf_context_;
+}
 
-  auto& symbolizer_line_info = line_info_or_error.get();
-  const uint32_t number_of_frames = symbolizer_line_info.getNumberOfFrames();
+template <typename ElfT>
+ErrorMessageOr<LineInfo> orbit_object_utils::ElfFileImpl<ElfT>::GetLineInfo(uint64_t address) {
+  ORBIT_CHECK(has_debug_info_section_);
+  // Function names are not needed, so they are not looked up.
+  const llvm::DILineInfoSpecifier specifier{
+      llvm::DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath, llvm::DINameKind::None};
+  const llvm::DIInliningInfo inlining_info = GetDwarfContext().getInliningInfoForAddress(
+      {address, llvm::object::SectionedAddress::UndefSection}, specifier);
+  const uint32_t number_of_frames = inlining_info.getNumberOfFrames();
 
   // Getting back zero frames means there was some kind of problem. We will return a error.
   if (number_of_frames == 0) {
     return ErrorMessage(absl::StrFormat("Unable to get line info for address=0x%x", address));
   }
 
-  const auto& last_frame = symbolizer_line_info.getFrame(number_of_frames - 1);
+  const auto& last_frame = inlining_info.getFrame(number_of_frames - 1);
 
-  // This is what symbolizer returns in case of an error. We convert it to a ErrorMessage here.
+  // This is what DWARFContext returns in case of an error. We convert it to a ErrorMessage here.
   if (last_frame.FileName == "<invalid>" && last_frame.Line == 0) {
     return ErrorMessage(absl::StrFormat("Unable to get line info for address=0x%x", address));
   }
@@ -752,8 +759,7 @@ ErrorMessageOr<LineInfo> orbit_object_utils::ElfFileImpl<ElfT>::GetLineInfo(uint
 template <typename ElfT>
 ErrorMessageOr<LineInfo> orbit_object_utils::ElfFileImpl<ElfT>::GetDeclarationLocationOfFunction(
     uint64_t address) {
-  const auto dwarf_context = llvm::DWARFContext::create(*owning_binary_.getBinary());
-  if (dwarf_context == nullptr) return ErrorMessage{"Could not read DWARF information."};
+  llvm::DWARFContext* const dwarf_context = &GetDwarfContext();
 
   const auto offset = dwarf_context->getDebugAranges()->findAddress(address);
   auto* const compile_unit = dwarf_context->getCompileUnitForOffset(offset);
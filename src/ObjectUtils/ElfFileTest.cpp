@@ -547,6 +547,31 @@ TEST(ElfFile, LineInfoInlining) {
             "LineInfoTestBinary.cpp");
 }
 
+TEST(ElfFile, LineInfoAndDeclarationLocationShareTheDebugInfo) {
+  const std::filesystem::path file_path = orbit_test::GetTestdataDir() / "line_info_test_binary";
+
+  auto program = CreateElfFile(file_path);
+  ASSERT_THAT(program, HasNoError());
+
+  // The queries reuse the debug info parsed by the ones before, whichever kind they are.
+  constexpr uint64_t kAddressOfMainFunction = 0x401140;
+  constexpr uint64_t kFirstInstructionOfInlinedPrintHelloWorld = 0x401141;
+  for (int i = 0; i < 2; ++i) {
+    ErrorMessageOr<orbit_grpc_protos::LineInfo> line_info =
+        program.value()->GetLineInfo(kFirstInstructionOfInlinedPrintHelloWorld);
+    ASSERT_THAT(line_info, HasNoError());
+    EXPECT_EQ(line_info.value().source_line(), 13);
+
+    ErrorMessageOr<orbit_grpc_protos::LineInfo> decl_line_info =
+        program.value()->GetDeclarationLocationOfFunction(kAddressOfMainFunction);
+    ASSERT_THAT(decl_line_info, HasNoError());
+    EXPECT_EQ(decl_line_info.value().source_line(), 12);
+  }
+
+  EXPECT_THAT(program.value()->GetLineInfo(0x10),
+              HasErrorWithMessage("Unable to get line info for address=0x10"));
+}
+
 TEST(ElfFile, CompressedDebugInfo) {
   const std::filesystem::path file_path =
       orbit_test::GetTestdataDir() / "line_info_test_binary_compressed";
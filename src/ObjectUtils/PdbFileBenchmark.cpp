@@ -0,0 +1,66 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "GrpcProtos/symbol.pb.h"
+#include "ObjectUtils/PdbFile.h"
+#include "ObjectUtils/SymbolsFile.h"
+#include "OrbitBase/Result.h"
+#include "PdbFileLlvm.h"
+
+#ifdef _WIN32
+#include "PdbFileDia.h"
+#endif
+
+// Loads the symbols of a PDB file with each of the backends. The file is the one given in the
+// environment variable ORBIT_PDB_BENCHMARK_FILE, as the interesting ones are large PDB files of
+// games, or a small PDB file from the testdata otherwise.
+
+namespace orbit_object_utils {
+namespace {
+
+[[nodiscard]] std::filesystem::path GetBenchmarkPdbFilePath() {
+  const char* const pdb_file_path = std::getenv("ORBIT_PDB_BENCHMARK_FILE");
+  if (pdb_file_path != nullptr) return std::string{pdb_file_path};
+  return std::filesystem::path{ORBIT_OBJECT_UTILS_TESTDATA_DIR} / "dllmain.pdb";
+}
+
+template <typename PdbFileT>
+void BM_LoadDebugSymbols(benchmark::State& state) {
+  const std::filesystem::path pdb_file_path = GetBenchmarkPdbFilePath();
+  const ObjectFileInfo object_file_info{0x180000000};
+
+  size_t symbol_count = 0;
+  for (auto _ : state) {
+    ErrorMessageOr<std::unique_ptr<PdbFile>> pdb_file_or_error =
+        PdbFileT::CreatePdbFile(pdb_file_path, object_file_info);
+    if (pdb_file_or_error.has_error()) {
+      state.SkipWithError(pdb_file_or_error.error().message().c_str());
+      return;
+    }
+    ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> symbols_or_error =
+        pdb_file_or_error.value()->LoadDebugSymbols();
+    if (symbols_or_error.has_error()) {
+      state.SkipWithError(symbols_or_error.error().message().c_str());
+      return;
+    }
+    symbol_count = symbols_or_error.value().symbol_infos_size();
+    benchmark::DoNotOptimize(symbols_or_error);
+  }
+  state.counters["Symbols"] = static_cast<double>(symbol_count);
+}
+
+BENCHMARK(BM_LoadDebugSymbols<PdbFileLlvm>)->Unit(benchmark::kMillisecond)->UseRealTime();
+#ifdef _WIN32
+BENCHMARK(BM_LoadDebugSymbols<PdbFileDia>)->Unit(benchmark::kMillisecond)->UseRealTime();
+#endif
+
+}  // namespace
+}  // namespace orbit_object_utils
@@ -13,6 +13,7 @@
 #include <absl/memory/memory.h>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
+#include <absl/time/time.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/ADT/iterator.h>
 #include <llvm/DebugInfo/CodeView/CVRecord.h>
@@ -44,24 +45,31 @@
 #include <llvm/DebugInfo/PDB/PDB.h>
 #include <llvm/DebugInfo/PDB/PDBSymbolExe.h>
 #include <llvm/DebugInfo/PDB/PDBTypes.h>
-#include <llvm/Demangle/Demangle.h>
 #include <llvm/Object/COFF.h>
 #include <llvm/Support/BinaryStreamArray.h>
 #include <llvm/Support/BinaryStreamRef.h>
+#include <llvm/Support/Allocator.h>
 #include <llvm/Support/Endian.h>
 #include <llvm/Support/Error.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <memory>
+#include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "GrpcProtos/symbol.pb.h"
+#include "ObjectUtils/DemangleCache.h"
 #include "ObjectUtils/ObjectFile.h"
+#include "OrbitBase/Future.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/ThreadPool.h"
+#include "OrbitBase/UniqueResource.h"
 
 using orbit_grpc_protos::ModuleSymbols;
 using orbit_grpc_protos::SymbolInfo;
@@ -70,9 +78,12 @@ namespace orbit_object_utils {
 
 namespace {
 
+// Below this number of module streams, loading them in parallel is not worth starting threads.
+constexpr size_t kMinModuleCountForParallelLoading = 64;
+
 [[nodiscard]] uint64_t ComputeAddress(
     uint64_t offset_in_section, uint16_t section, uint64_t image_base,
-    const llvm::FixedStreamArray<llvm::object::coff_section>& section_headers) {
+    const std::vector<llvm::object::coff_section>& section_headers) {
   // Unlike DIA, LLVM won't give us the RVA directly, but the symbol's offset in the respective
   // section. We can compute the RVA as the section's RVA + the symbol's offset.
   // Note: The segments are numbered starting at 1 and match what you observe using
@@ -88,119 +99,131 @@ namespace {
   return rva + image_base;
 }
 
+// Calls `function(i)` for each i in [0, count), spread over the threads of `thread_pool` and the
+// calling thread, and returns once all calls have completed. Without a thread pool, all calls run
+// on the calling thread.
+template <typename Function>
+void ParallelFor(orbit_base::ThreadPool* thread_pool, size_t thread_count, size_t count,
+                 Function&& function) {
+  if (thread_pool == nullptr || count <= 1) {
+    for (size_t i = 0; i < count; ++i) function(i);
+    return;
+  }
+
+  std::atomic<size_t> next_index = 0;
+  auto process_indices = [&next_index, count, &function]() {
+    for (size_t i = next_index++; i < count; i = next_index++) function(i);
+  };
+  std::vector<orbit_base::Future<void>> futures;
+  for (size_t i = 1; i < std::min(thread_count, count); ++i) {
+    futures.push_back(thread_pool->Schedule(process_indices));
+  }
+  process_indices();
+  for (const orbit_base::Future<void>& future : futures) future.Wait();
+}
+
+// What we need from a ProcSym record of a module debug stream. The argument list of the function
+// is not part of it, as it needs the type info stream, which can't be read from several threads.
+struct ProcSymbolInfo {
+  std::string demangled_name;
+  uint64_t address;
+  uint32_t size;
+  llvm::codeview::TypeIndex function_type;
+};
+
 // Codeview debug records from a PDB file can be accessed through llvm using a visitor
 // interface (using llvm::codeview::CVSymbolVisitor::visitSymbolStream). This can be
-// customized by implementing one's own visitor class, which we do here to fill out
-// all symbol info required for functions.
-class SymbolInfoVisitor : public llvm::codeview::SymbolVisitorCallbacks {
+// customized by implementing one's own visitor class, which we do here to collect the
+// functions of a module debug stream.
+class ProcSymbolVisitor : public llvm::codeview::SymbolVisitorCallbacks {
  public:
-  SymbolInfoVisitor(std::vector<SymbolInfo>* symbol_infos,
-                    absl::flat_hash_set<uint64_t>* addresses_from_module_debug_stream,
+  ProcSymbolVisitor(std::vector<ProcSymbolInfo>* proc_symbol_infos,
                     const ObjectFileInfo& object_file_info,
-                    llvm::FixedStreamArray<llvm::object::coff_section>* section_headers,
-                    llvm::pdb::TpiStream* type_info_stream)
-      : symbol_infos_(symbol_infos),
-        addresses_from_module_debug_stream_(addresses_from_module_debug_stream),
+                    const std::vector<llvm::object::coff_section>* section_headers)
+      : proc_symbol_infos_(proc_symbol_infos),
         object_file_info_(object_file_info),
-        section_headers_(section_headers),
-        type_info_stream_(type_info_stream) {
-    ORBIT_CHECK(symbol_infos != nullptr);
-    ORBIT_CHECK(type_info_stream != nullptr);
+        section_headers_(section_headers) {
+    ORBIT_CHECK(proc_symbol_infos != nullptr);
+    ORBIT_CHECK(section_headers != nullptr);
   }
 
   // This is the only record type (ProcSym) we are interested in, so we only override this
   // method. Other records will simply return llvm::Error::success without any work done.
   llvm::Error visitKnownRecord(llvm::codeview::CVSymbol& /*unused*/,
                                llvm::codeview::ProcSym& proc) override {
-    SymbolInfo symbol_info;
-    symbol_info.set_demangled_name(llvm::demangle(proc.Name.str()));
-
-    // The ProcSym's name does not contain an argument list. However, this information is required
-    // when dealing with overloads and it is available in the type info stream. See:
-    // https://llvm.org/docs/PDB/TpiStream.html
-    llvm::StringRef argument_list = RetrieveArgumentList(proc);
-    if (!argument_list.empty()) {
-      symbol_info.set_demangled_name(
-          absl::StrCat(symbol_info.demangled_name(), argument_list.data()));
-    }
-
-    uint64_t address = ComputeAddress(proc.CodeOffset, proc.Segment, object_file_info_.load_bias,
-                                      *section_headers_);
-    symbol_info.set_address(address);
-    symbol_info.set_size(proc.CodeSize);
-    // We currently only support hotpatchable functions in elf files.
-    symbol_info.set_is_hotpatchable(false);
-
-    ORBIT_CHECK(addresses_from_module_debug_stream_ != nullptr);
-    addresses_from_module_debug_stream_->insert(symbol_info.address());
-    ORBIT_CHECK(symbol_infos_ != nullptr);
-    symbol_infos_->emplace_back(std::move(symbol_info));
-
+    ProcSymbolInfo proc_symbol_info;
+    proc_symbol_info.demangled_name = DemangleCache::GetDefault().Demangle(proc.Name);
+    proc_symbol_info.address = ComputeAddress(proc.CodeOffset, proc.Segment,
+                                              object_file_info_.load_bias, *section_headers_);
+    proc_symbol_info.size = proc.CodeSize;
+    proc_symbol_info.function_type = proc.FunctionType;
+    proc_symbol_infos_->emplace_back(std::move(proc_symbol_info));
     return llvm::Error::success();
   }
 
  private:
-  [[nodiscard]] llvm::StringRef RetrieveArgumentList(const llvm::codeview::ProcSym& proc) const {
-    ORBIT_CHECK(type_info_stream_ != nullptr);
-    llvm::codeview::LazyRandomTypeCollection& type_collection = type_info_stream_->typeCollection();
-
-    // We expect function types being either LF_PROCEDURE or LF_MFUNCTION, which are non-simple
-    // types. However, there are cases where the function type is "<no type>", which is a simple
-    // type. In those cases, we can't retrieve the argument list. Other simple types are not
-    // expected here (as they are mostly base types). However, the call to `getType` below will fail
-    // on any simple type. So we check for all simple types here, instead of only for "<no type>".
-    if (proc.FunctionType.isSimple()) {
-      llvm::StringRef function_type = type_collection.getTypeName(proc.FunctionType);
-      ORBIT_ERROR(
-          "Unable to retrieve parameter list for function \"%s\"; The function type is \"%s\"",
-          proc.Name.data(), function_type.data());
-      return "";
-    }
+  std::vector<ProcSymbolInfo>* proc_symbol_infos_;
+  ObjectFileInfo object_file_info_;
+  const std::vector<llvm::object::coff_section>* section_headers_;
+};
+
+// The ProcSym's name does not contain an argument list. However, this information is required
+// when dealing with overloads and it is available in the type info stream. See:
+// https://llvm.org/docs/PDB/TpiStream.html
+[[nodiscard]] llvm::StringRef RetrieveArgumentList(const ProcSymbolInfo& proc_symbol_info,
+                                                   llvm::pdb::TpiStream& type_info_stream) {
+  llvm::codeview::LazyRandomTypeCollection& type_collection = type_info_stream.typeCollection();
+
+  // We expect function types being either LF_PROCEDURE or LF_MFUNCTION, which are non-simple
+  // types. However, there are cases where the function type is "<no type>", which is a simple
+  // type. In those cases, we can't retrieve the argument list. Other simple types are not
+  // expected here (as they are mostly base types). However, the call to `getType` below will fail
+  // on any simple type. So we check for all simple types here, instead of only for "<no type>".
+  if (proc_symbol_info.function_type.isSimple()) {
+    llvm::StringRef function_type = type_collection.getTypeName(proc_symbol_info.function_type);
+    ORBIT_ERROR(
+        "Unable to retrieve parameter list for function \"%s\"; The function type is \"%s\"",
+        proc_symbol_info.demangled_name, function_type.data());
+    return "";
+  }
 
-    llvm::codeview::CVType function_type = type_info_stream_->getType(proc.FunctionType);
-    switch (function_type.kind()) {
-      case llvm::codeview::LF_PROCEDURE: {
-        llvm::codeview::ProcedureRecord procedure_record;
-        llvm::Error error =
-            llvm::codeview::TypeDeserializer::deserializeAs<llvm::codeview::ProcedureRecord>(
-                function_type, procedure_record);
-        if (error) {
-          ORBIT_ERROR(
-              "Unable to retrieve parameter list for function \"%s\"; The function is of type "
-              "\"LF_PROCEDURE\", but we can not deserialize it to a \"ProcedureRecord\".",
-              proc.Name.data());
-          return "";
-        }
-
-        llvm::StringRef parameter_list = type_collection.getTypeName(procedure_record.ArgumentList);
-        return parameter_list;
+  llvm::codeview::CVType function_type = type_info_stream.getType(proc_symbol_info.function_type);
+  switch (function_type.kind()) {
+    case llvm::codeview::LF_PROCEDURE: {
+      llvm::codeview::ProcedureRecord procedure_record;
+      llvm::Error error =
+          llvm::codeview::TypeDeserializer::deserializeAs<llvm::codeview::ProcedureRecord>(
+              function_type, procedure_record);
+      if (error) {
+        ORBIT_ERROR(
+            "Unable to retrieve parameter list for function \"%s\"; The function is of type "
+            "\"LF_PROCEDURE\", but we can not deserialize it to a \"ProcedureRecord\".",
+            proc_symbol_info.demangled_name);
+        return "";
       }
-      case llvm::codeview::LF_MFUNCTION: {
-        llvm::codeview::MemberFunctionRecord member_function_record;
-        llvm::Error error =
-            llvm::codeview::TypeDeserializer::deserializeAs<llvm::codeview::MemberFunctionRecord>(
-                function_type, member_function_record);
-        if (error) {
-          ORBIT_ERROR(
-              "Unable to retrieve parameter list for function \"%s\"; The function is of type "
-              "\"LF_MFUNCTION\", but we can not deserialize it to a \"MemberFunctionRecord\".",
-              proc.Name.data());
-          return "";
-        }
-
-        return type_collection.getTypeName(member_function_record.ArgumentList);
+
+      llvm::StringRef parameter_list = type_collection.getTypeName(procedure_record.ArgumentList);
+      return parameter_list;
+    }
+    case llvm::codeview::LF_MFUNCTION: {
+      llvm::codeview::MemberFunctionRecord member_function_record;
+      llvm::Error error =
+          llvm::codeview::TypeDeserializer::deserializeAs<llvm::codeview::MemberFunctionRecord>(
+              function_type, member_function_record);
+      if (error) {
+        ORBIT_ERROR(
+            "Unable to retrieve parameter list for function \"%s\"; The function is of type "
+            "\"LF_MFUNCTION\", but we can not deserialize it to a \"MemberFunctionRecord\".",
+            proc_symbol_info.demangled_name);
+        return "";
       }
-      default:
-        ORBIT_UNREACHABLE();
+
+      return type_collection.getTypeName(member_function_record.ArgumentList);
     }
+    default:
+      ORBIT_UNREACHABLE();
   }
-
-  std::vector<SymbolInfo>* symbol_infos_;
-  absl::flat_hash_set<uint64_t>* addresses_from_module_debug_stream_;
-  ObjectFileInfo object_file_info_;
-  llvm::FixedStreamArray<llvm::object::coff_section>* section_headers_;
-  llvm::pdb::TpiStream* type_info_stream_;
-};
+}
 
 // This visitor will try to deduce the missing size information from the given symbol using
 // the section contributions information.
@@ -210,7 +233,7 @@ class SectionContributionsVisitor : public llvm::pdb::ISectionContribVisitor {
  public:
   SectionContributionsVisitor(
       const ObjectFileInfo& object_file_info,
-      llvm::FixedStreamArray<llvm::object::coff_section>* section_headers,
+      const std::vector<llvm::object::coff_section>* section_headers,
       absl::flat_hash_map<uint64_t, std::vector<SymbolInfo*>>* address_to_symbols_with_missing_size)
       : object_file_info_(object_file_info),
         section_headers_(section_headers),
@@ -237,58 +260,117 @@ class SectionContributionsVisitor : public llvm::pdb::ISectionContribVisitor {
 
  private:
   ObjectFileInfo object_file_info_;
-  llvm::FixedStreamArray<llvm::object::coff_section>* section_headers_{};
+  const std::vector<llvm::object::coff_section>* section_headers_{};
   const absl::flat_hash_map<uint64_t, std::vector<SymbolInfo*>>*
       address_to_symbols_with_missing_size_{};
 };
 
+// Reads the functions of a single module debug stream. This only reads from the memory the PDB
+// file is mapped to, and uses its own allocator for the stream, so several module debug streams
+// can be loaded at the same time.
+ErrorMessageOr<std::vector<ProcSymbolInfo>> LoadProcSymbolsFromModuleStream(
+    const llvm::pdb::PDBFile& pdb_file, const llvm::pdb::DbiModuleDescriptor& module,
+    const std::vector<llvm::object::coff_section>& section_headers,
+    const ObjectFileInfo& object_file_info) {
+  // Holds the blocks of the stream that are not contiguous in the file, so it has to outlive the
+  // stream.
+  llvm::BumpPtrAllocator allocator;
+  std::unique_ptr<llvm::msf::MappedBlockStream> mod_stream_data =
+      llvm::msf::MappedBlockStream::createIndexedStream(
+          pdb_file.getMsfLayout(), pdb_file.getMsfBuffer(), module.getModuleStreamIndex(),
+          allocator);
+  llvm::pdb::ModuleDebugStreamRef mod_debug_stream(module, std::move(mod_stream_data));
+
+  // This line is critical, otherwise the stream will not have any data.
+  llvm::Error reload_error = mod_debug_stream.reload();
+  if (reload_error) {
+    return ErrorMessage{
+        absl::StrFormat("Error trying to reload module debug stream with llvm error: %s",
+                        llvm::toString(std::move(reload_error)))};
+  }
+
+  std::vector<ProcSymbolInfo> proc_symbol_infos;
+  llvm::codeview::SymbolVisitorCallbackPipeline pipeline;
+  llvm::codeview::SymbolDeserializer deserializer(nullptr, llvm::codeview::CodeViewContainer::Pdb);
+  pipeline.addCallbackToPipeline(deserializer);
+  ProcSymbolVisitor symbol_visitor(&proc_symbol_infos, object_file_info, &section_headers);
+  pipeline.addCallbackToPipeline(symbol_visitor);
+  llvm::codeview::CVSymbolVisitor visitor(pipeline);
+
+  llvm::BinarySubstreamRef symbol_substream = mod_debug_stream.getSymbolsSubstream();
+  const llvm::codeview::CVSymbolArray& symbol_array = mod_debug_stream.getSymbolArray();
+
+  // Not sure why it's necessary to pass the symbol stream offset here, but this is
+  // following the implementation of llvm-pdbutil in llvm/tools.
+  llvm::Error error = visitor.visitSymbolStream(symbol_array, symbol_substream.Offset);
+  if (error) {
+    return ErrorMessage{
+        absl::StrFormat("Error while reading symbols from PDB debug info stream: %s",
+                        llvm::toString(std::move(error)))};
+  }
+  return proc_symbol_infos;
+}
+
+// Large PDB files have thousands of module debug streams, so these are read in parallel. Only the
+// argument lists, which come from the type info stream, are then added on the calling thread, in
+// the order of the modules, so the result is the same as when reading the modules one by one.
 ErrorMessageOr<void> LoadDebugSymbolsFromModuleStreams(
     llvm::pdb::PDBFile& pdb_file, llvm::pdb::DbiStream& debug_info_stream,
     llvm::pdb::TpiStream& type_info_stream,
-    llvm::FixedStreamArray<llvm::object::coff_section>& section_headers,
+    const std::vector<llvm::object::coff_section>& section_headers,
     const ObjectFileInfo& object_file_info, std::vector<SymbolInfo>* symbol_infos,
     absl::flat_hash_set<uint64_t>* addresses_from_module_debug_stream) {
+  // Reading the module descriptors uses the shared DBI stream, so it happens up front.
   const llvm::pdb::DbiModuleList& modules = debug_info_stream.modules();
-
+  std::vector<llvm::pdb::DbiModuleDescriptor> module_descriptors;
   for (uint32_t index = 0; index < modules.getModuleCount(); ++index) {
-    auto modi = modules.getModuleDescriptor(index);
-    uint16_t modi_stream_index = modi.getModuleStreamIndex();
-
-    if (modi_stream_index == llvm::pdb::kInvalidStreamIndex) {
+    llvm::pdb::DbiModuleDescriptor modi = modules.getModuleDescriptor(index);
+    if (modi.getModuleStreamIndex() == llvm::pdb::kInvalidStreamIndex) {
       continue;
     }
+    module_descriptors.push_back(modi);
+  }
 
-    std::unique_ptr<llvm::msf::MappedBlockStream> mod_stream_data =
-        pdb_file.createIndexedStream(modi_stream_index);
-    llvm::pdb::ModuleDebugStreamRef mod_debug_stream(modi, std::move(mod_stream_data));
+  std::vector<ErrorMessageOr<std::vector<ProcSymbolInfo>>> proc_symbol_infos_by_module(
+      module_descriptors.size(), outcome::success());
+  auto load_module = [&](size_t index) {
+    proc_symbol_infos_by_module[index] = LoadProcSymbolsFromModuleStream(
+        pdb_file, module_descriptors[index], section_headers, object_file_info);
+  };
+  const size_t thread_count = module_descriptors.size() < kMinModuleCountForParallelLoading
+                                  ? 1
+                                  : std::max(1U, std::thread::hardware_concurrency());
+  if (thread_count == 1) {
+    ParallelFor(nullptr, 1, module_descriptors.size(), load_module);
+  } else {
+    // A dedicated thread pool, as the caller might itself run on a thread of a shared pool.
+    // The calling thread also does work, hence one thread less.
+    std::shared_ptr<orbit_base::ThreadPool> thread_pool =
+        orbit_base::ThreadPool::Create(thread_count - 1, thread_count - 1, absl::Seconds(1));
+    orbit_base::unique_resource shutdown_thread_pool{
+        thread_pool.get(), [](orbit_base::ThreadPool* pool) { pool->ShutdownAndWait(); }};
+    ParallelFor(thread_pool.get(), thread_count, module_descriptors.size(), load_module);
+  }
 
-    // This line is critical, otherwise the stream will not have any data.
-    llvm::Error reload_error = mod_debug_stream.reload();
-    if (reload_error) {
-      return ErrorMessage{
-          absl::StrFormat("Error trying to reload module debug stream with llvm error: %s",
-                          llvm::toString(std::move(reload_error)))};
-    }
+  for (ErrorMessageOr<std::vector<ProcSymbolInfo>>& proc_symbol_infos :
+       proc_symbol_infos_by_module) {
+    OUTCOME_TRY(proc_symbol_infos);
+    for (ProcSymbolInfo& proc_symbol_info : proc_symbol_infos.value()) {
+      SymbolInfo symbol_info;
+      llvm::StringRef argument_list = RetrieveArgumentList(proc_symbol_info, type_info_stream);
+      if (argument_list.empty()) {
+        symbol_info.set_demangled_name(std::move(proc_symbol_info.demangled_name));
+      } else {
+        symbol_info.set_demangled_name(
+            absl::StrCat(proc_symbol_info.demangled_name, argument_list.data()));
+      }
+      symbol_info.set_address(proc_symbol_info.address);
+      symbol_info.set_size(proc_symbol_info.size);
+      // We currently only support hotpatchable functions in elf files.
+      symbol_info.set_is_hotpatchable(false);
 
-    llvm::codeview::SymbolVisitorCallbackPipeline pipeline;
-    llvm::codeview::SymbolDeserializer deserializer(nullptr,
-                                                    llvm::codeview::CodeViewContainer::Pdb);
-    pipeline.addCallbackToPipeline(deserializer);
-    SymbolInfoVisitor symbol_visitor(symbol_infos, addresses_from_module_debug_stream,
-                                     object_file_info, &section_headers, &type_info_stream);
-    pipeline.addCallbackToPipeline(symbol_visitor);
-    llvm::codeview::CVSymbolVisitor visitor(pipeline);
-
-    llvm::BinarySubstreamRef symbol_substream = mod_debug_stream.getSymbolsSubstream();
-    const llvm::codeview::CVSymbolArray& symbol_array = mod_debug_stream.getSymbolArray();
-
-    // Not sure why it's necessary to pass the symbol stream offset here, but this is
-    // following the implementation of llvm-pdbutil in llvm/tools.
-    llvm::Error error = visitor.visitSymbolStream(symbol_array, symbol_substream.Offset);
-    if (error) {
-      return ErrorMessage{
-          absl::StrFormat("Error while reading symbols from PDB debug info stream: %s",
-                          llvm::toString(std::move(error)))};
+      addresses_from_module_debug_stream->insert(symbol_info.address());
+      symbol_infos->emplace_back(std::move(symbol_info));
     }
   }
   return outcome::success();
@@ -296,7 +378,7 @@ ErrorMessageOr<void> LoadDebugSymbolsFromModuleStreams(
 
 void LoadDebugSymbolsFromPublicSymbolStream(
     llvm::pdb::PublicsStream& public_symbol_stream, llvm::pdb::SymbolStream& symbol_stream,
-    llvm::FixedStreamArray<llvm::object::coff_section>& section_headers,
+    const std::vector<llvm::object::coff_section>& section_headers,
     const ObjectFileInfo& object_file_info,
     const absl::flat_hash_set<uint64_t>& addresses_from_module_debug_stream,
     std::vector<SymbolInfo>* symbol_infos) {
@@ -320,7 +402,7 @@ void LoadDebugSymbolsFromPublicSymbolStream(
 
     SymbolInfo symbol_info;
     symbol_info.set_address(address);
-    symbol_info.set_demangled_name(llvm::demangle(record->Name.str()));
+    symbol_info.set_demangled_name(DemangleCache::GetDefault().Demangle(record->Name));
     // The PDB public symbols don't contain the size of symbols. Set a placeholder which indicates
     // that the size is unknown for now and try to deduce it later. We will later use that
     // placeholder to look-up the size in `SectionContributionsVisitor` or in
@@ -379,8 +461,12 @@ uint32_t PdbFileLlvm::GetAge() const {
   llvm::Expected<llvm::pdb::TpiStream&> type_info_stream = pdb_file.getPDBTpiStream();
   ORBIT_CHECK(type_info_stream);
 
-  llvm::FixedStreamArray<llvm::object::coff_section> section_headers =
+  // A copy, so that the module debug streams can be read on several threads without sharing the
+  // stream the section headers are read from.
+  const llvm::FixedStreamArray<llvm::object::coff_section> section_header_array =
       debug_info_stream->getSectionHeaders();
+  const std::vector<llvm::object::coff_section> section_headers(section_header_array.begin(),
+                                                                section_header_array.end());
 
   std::vector<SymbolInfo> symbol_infos;
   absl::flat_hash_set<uint64_t> addresses_from_module_debug_stream;
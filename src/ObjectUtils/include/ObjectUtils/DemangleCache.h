@@ -0,0 +1,59 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OBJECT_UTILS_DEMANGLE_CACHE_H_
+#define OBJECT_UTILS_DEMANGLE_CACHE_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <string>
+#include <string_view>
+
+namespace orbit_object_utils {
+
+// Remembers the results of llvm::demangle across the symbol files that are loaded, as the same
+// template instantiations and inline functions show up in many modules. Names are looked up by a
+// 64-bit hash of the mangled name. Names that are not mangled are not stored, and once the cache
+// is full, further names are demangled without being stored. It can be used by several threads at
+// the same time; the entries are spread over shards with their own mutex to reduce contention.
+class DemangleCache {
+ public:
+  static constexpr size_t kDefaultMaxSize = 1 << 20;
+
+  explicit DemangleCache(size_t max_size = kDefaultMaxSize);
+
+  DemangleCache(const DemangleCache&) = delete;
+  DemangleCache& operator=(const DemangleCache&) = delete;
+  DemangleCache(DemangleCache&&) = delete;
+  DemangleCache& operator=(DemangleCache&&) = delete;
+
+  // Same result as llvm::demangle.
+  [[nodiscard]] std::string Demangle(std::string_view mangled_name);
+
+  [[nodiscard]] size_t size() const;
+
+  // The cache used when loading symbols from elf, coff and pdb files. It is never destroyed, so
+  // that it can be used by threads that outlive main.
+  [[nodiscard]] static DemangleCache& GetDefault();
+
+ private:
+  static constexpr size_t kShardCount = 16;
+
+  struct Shard {
+    mutable absl::Mutex mutex;
+    absl::flat_hash_map<uint64_t, std::string> demangled_names ABSL_GUARDED_BY(mutex);
+  };
+
+  size_t max_size_per_shard_;
+  std::array<Shard, kShardCount> shards_;
+};
+
+}  // namespace orbit_object_utils
+
+#endif  // OBJECT_UTILS_DEMANGLE_CACHE_H_
@@ -5,6 +5,7 @@
 #include "OrbitBase/Logging.h"
 
 #include <absl/base/const_init.h>
+#include <absl/base/thread_annotations.h>
 #include <absl/debugging/stacktrace.h>
 #include <absl/debugging/symbolize.h>
 #include <absl/strings/str_format.h>
@@ -13,8 +14,13 @@
 #include <errno.h>
 
 #include <array>
+#include <atomic>
 #include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "LoggingUtils.h"
@@ -28,6 +34,112 @@ static absl::Mutex log_file_mutex(absl::kConstInit);
 static orbit_base::unique_resource log_file{static_cast<std::FILE*>(nullptr), [](std::FILE* f) {
                                               if (f != nullptr) std::fclose(f);
                                             }};
+
+static void WriteToLogFile(std::string_view message) {
+  absl::MutexLock lock(&log_file_mutex);
+  if (log_file.get() != nullptr) {
+    // Ignore any errors that can happen, we cannot do anything about them at this point anyways.
+    std::fwrite(message.data(), message.size(), 1, log_file.get());
+    std::fflush(log_file.get());
+  }
+}
+
+namespace {
+
+// Collects the messages in memory and writes them to the log file from a background thread, so
+// that the logging threads only ever wait for a short copy. Once kMaxPendingBytes are waiting to be
+// written, further messages are dropped and counted instead.
+class AsynchronousLogFileWriter {
+ public:
+  static constexpr size_t kMaxPendingBytes = 4 * 1024 * 1024;
+
+  AsynchronousLogFileWriter() : thread_{[this] { Run(); }} {}
+
+  // Returns false if the writer was already stopped, in which case the caller should write
+  // `message` itself.
+  [[nodiscard]] bool Append(std::string_view message) {
+    absl::MutexLock lock(&mutex_);
+    if (stop_requested_) return false;
+    if (pending_messages_.size() + message.size() > kMaxPendingBytes) {
+      ++num_dropped_messages_;
+      return true;
+    }
+    pending_messages_.append(message);
+    return true;
+  }
+
+  // Blocks until all messages appended so far are written.
+  void Flush() {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        +[](AsynchronousLogFileWriter* self) ABSL_EXCLUSIVE_LOCKS_REQUIRED(self->mutex_) {
+          return (self->pending_messages_.empty() && self->num_dropped_messages_ == 0 &&
+                  !self->is_writing_) ||
+                 self->is_stopped_;
+        },
+        this));
+  }
+
+  // Writes all pending messages and stops the background thread. Must only be called once.
+  void Stop() {
+    {
+      absl::MutexLock lock(&mutex_);
+      stop_requested_ = true;
+    }
+    thread_.join();
+  }
+
+ private:
+  void Run() {
+    std::string messages;
+    while (true) {
+      uint64_t num_dropped_messages;
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(
+            +[](AsynchronousLogFileWriter* self) ABSL_EXCLUSIVE_LOCKS_REQUIRED(self->mutex_) {
+              return !self->pending_messages_.empty() || self->num_dropped_messages_ > 0 ||
+                     self->stop_requested_;
+            },
+            this));
+        if (pending_messages_.empty() && num_dropped_messages_ == 0) {
+          is_stopped_ = true;
+          return;
+        }
+        std::swap(messages, pending_messages_);
+        num_dropped_messages = std::exchange(num_dropped_messages_, 0);
+        is_writing_ = true;
+      }
+
+      if (num_dropped_messages > 0) {
+        messages.append(absl::StrFormat("[%u log messages were dropped]\n", num_dropped_messages));
+      }
+      WriteToLogFile(messages);
+      messages.clear();
+
+      absl::MutexLock lock(&mutex_);
+      is_writing_ = false;
+    }
+  }
+
+  absl::Mutex mutex_;
+  std::string pending_messages_ ABSL_GUARDED_BY(mutex_);
+  uint64_t num_dropped_messages_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool is_writing_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stop_requested_ ABSL_GUARDED_BY(mutex_) = false;
+  bool is_stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  std::thread thread_;
+};
+
+// Only set once and never destroyed, as messages can be logged until the very end of the process.
+std::atomic<AsynchronousLogFileWriter*> asynchronous_log_file_writer = nullptr;
+
+void StopAsynchronousLogFileWriter() {
+  AsynchronousLogFileWriter* writer = asynchronous_log_file_writer.load();
+  if (writer != nullptr) writer->Stop();
+}
+
+}  // namespace
 std::string GetLogFileName() {
   std::string timestamp_string = absl::FormatTime(orbit_base_internal::kLogFileNameTimeFormat,
                                                   absl::Now(), absl::UTCTimeZone());
@@ -43,26 +155,39 @@ ErrorMessageOr<void> TryRemoveOldLogFiles(const std::filesystem::path& log_dir)
   return orbit_base_internal::RemoveFiles(old_files);
 }
 
-void InitLogFile(const std::filesystem::path& path) {
-  absl::MutexLock lock(&log_file_mutex);
-  // Do not call CHECK here - it will end up calling LogToFile,
-  // which tries to lock on the same mutex a second time. This will
-  // lead to an error since the mutex is not recursive.
-  if (log_file.get() != nullptr) {
-    ORBIT_INTERNAL_PLATFORM_ABORT();
-  }
-
-  // O_WRONLY, O_CLOEXEC for glibc, O_BINARY for windows
+void InitLogFile(const std::filesystem::path& path, LogFileWrites writes) {
+  bool log_file_already_initialized = false;
+  bool log_file_opened = false;
+  {
+    absl::MutexLock lock(&log_file_mutex);
+    log_file_already_initialized = log_file.get() != nullptr;
+    if (!log_file_already_initialized) {
+      // O_WRONLY, O_CLOEXEC for glibc, O_BINARY for windows
 #if defined(_WIN32)
-  log_file.reset(std::fopen(path.string().c_str(), "wb"));
+      log_file.reset(std::fopen(path.string().c_str(), "wb"));
 #else
-  log_file.reset(std::fopen(path.string().c_str(), "wbe"));
+      log_file.reset(std::fopen(path.string().c_str(), "wbe"));
 #endif
+      log_file_opened = log_file.get() != nullptr;
+    }
+  }
+  // Do not call CHECK here or abort while holding the mutex - it will end up calling LogToFile or
+  // FlushLogFile, which try to lock on the same mutex a second time. This will lead to an error
+  // since the mutex is not recursive.
+  if (log_file_already_initialized) {
+    ORBIT_INTERNAL_PLATFORM_ABORT();
+  }
 
-  if (log_file.get() == nullptr) {
+  if (!log_file_opened) {
     // Log a error (to stderr)
     std::fprintf(stderr, "Error: Unable to open logfile \"%s\": %s\n", path.string().c_str(),
                  SafeStrerror(errno));
+    return;
+  }
+
+  if (writes == LogFileWrites::kAsynchronous) {
+    asynchronous_log_file_writer.store(new AsynchronousLogFileWriter());
+    std::atexit(&StopAsynchronousLogFileWriter);
   }
 }
 
@@ -85,12 +210,14 @@ void LogStacktrace() {
 namespace orbit_base_internal {
 
 void LogToFile(std::string_view message) {
-  absl::MutexLock lock(&orbit_base::log_file_mutex);
-  if (orbit_base::log_file.get() != nullptr) {
-    // Ignore any errors that can happen, we cannot do anything about them at this point anyways.
-    std::fwrite(message.data(), message.size(), 1, orbit_base::log_file.get());
-    std::fflush(orbit_base::log_file.get());
-  }
+  orbit_base::AsynchronousLogFileWriter* writer = orbit_base::asynchronous_log_file_writer.load();
+  if (writer != nullptr && writer->Append(message)) return;
+  orbit_base::WriteToLogFile(message);
+}
+
+void FlushLogFile() {
+  orbit_base::AsynchronousLogFileWriter* writer = orbit_base::asynchronous_log_file_writer.load();
+  if (writer != nullptr) writer->Flush();
 }
 
 }  // namespace orbit_base_internal
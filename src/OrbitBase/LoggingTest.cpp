@@ -0,0 +1,63 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_base_internal {
+
+TEST(LogRateLimiter, FirstCallLogs) {
+  LogRateLimiter rate_limiter{absl::Hours(1)};
+  uint64_t num_skipped = 42;
+  EXPECT_TRUE(rate_limiter.ShouldLog(&num_skipped));
+  EXPECT_EQ(num_skipped, 0);
+}
+
+TEST(LogRateLimiter, SkipsCallsWithinInterval) {
+  LogRateLimiter rate_limiter{absl::Hours(1)};
+  uint64_t num_skipped = 0;
+  ASSERT_TRUE(rate_limiter.ShouldLog(&num_skipped));
+  EXPECT_FALSE(rate_limiter.ShouldLog(&num_skipped));
+  EXPECT_FALSE(rate_limiter.ShouldLog(&num_skipped));
+}
+
+TEST(LogRateLimiter, ReportsSkippedCallsAfterInterval) {
+  LogRateLimiter rate_limiter{absl::Milliseconds(100)};
+  uint64_t num_skipped = 0;
+  ASSERT_TRUE(rate_limiter.ShouldLog(&num_skipped));
+  constexpr uint64_t kNumCallsInInterval = 3;
+  for (uint64_t i = 0; i < kNumCallsInInterval; ++i) {
+    // Only fails if the machine stalls for longer than the interval.
+    (void)rate_limiter.ShouldLog(&num_skipped);
+  }
+  absl::SleepFor(absl::Milliseconds(150));
+  ASSERT_TRUE(rate_limiter.ShouldLog(&num_skipped));
+  EXPECT_LE(num_skipped, kNumCallsInInterval);
+  EXPECT_GT(num_skipped, 0);
+
+  EXPECT_FALSE(rate_limiter.ShouldLog(&num_skipped));
+}
+
+TEST(LogRateLimiter, ZeroIntervalAlwaysLogs) {
+  LogRateLimiter rate_limiter{absl::ZeroDuration()};
+  uint64_t num_skipped = 0;
+  for (int i = 0; i < 3; ++i) {
+    absl::SleepFor(absl::Microseconds(1));
+    EXPECT_TRUE(rate_limiter.ShouldLog(&num_skipped));
+    EXPECT_EQ(num_skipped, 0);
+  }
+}
+
+}  // namespace orbit_base_internal
+
+TEST(Logging, LogRateLimitedCompiles) {
+  for (int i = 0; i < 3; ++i) {
+    ORBIT_LOG_RATE_LIMITED(absl::Seconds(1), "Rate limited message %d", i);
+    ORBIT_ERROR_RATE_LIMITED(absl::Seconds(1), "Rate limited error %d", i);
+  }
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "OrbitBase/ParallelFor.h"
+#include "OrbitBase/ThreadPool.h"
+
+TEST(ParallelFor, NoElements) {
+  bool called = false;
+  orbit_base::ParallelFor(0, [&called](size_t /*index*/) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(ParallelFor, AllIndicesAreProcessedOnce) {
+  constexpr size_t kNumElements = 10'001;
+  for (size_t chunk_size : {1, 7, 100, 20'000}) {
+    std::vector<std::atomic<uint32_t>> counters(kNumElements);
+    orbit_base::ParallelFor(
+        kNumElements, [&counters](size_t index) { ++counters[index]; }, chunk_size);
+    for (const std::atomic<uint32_t>& counter : counters) {
+      EXPECT_EQ(counter, 1);
+    }
+  }
+}
+
+TEST(ParallelFor, CanBeNestedInTasksOfTheSameThreadPool) {
+  std::shared_ptr<orbit_base::ThreadPool> thread_pool =
+      orbit_base::ThreadPool::Create(1, 2, absl::Milliseconds(100));
+  constexpr size_t kNumOuterElements = 8;
+  constexpr size_t kNumInnerElements = 100;
+  std::atomic<size_t> count = 0;
+
+  orbit_base::ParallelFor(thread_pool.get(), kNumOuterElements, [&](size_t /*outer_index*/) {
+    orbit_base::ParallelFor(thread_pool.get(), kNumInnerElements,
+                            [&count](size_t /*inner_index*/) { ++count; });
+  });
+
+  EXPECT_EQ(count, kNumOuterElements * kNumInnerElements);
+  thread_pool->ShutdownAndWait();
+}
@@ -0,0 +1,177 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitBase/SharedMemoryRingBuffer.h"
+
+#include <absl/strings/str_format.h>
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "OrbitBase/Align.h"
+#include "OrbitBase/Logging.h"
+
+namespace orbit_base {
+
+namespace {
+
+constexpr uint64_t kMagic = 0x4f52424954524e47;  // "ORBITRNG"
+constexpr uint64_t kCacheLineSize = 64;
+
+// Marks the rest of the buffer as skipped, see `TryReserveRecord`.
+constexpr uint64_t kSkipToStartMarker = UINT64_MAX;
+
+}  // namespace
+
+// Lives at the start of the shared memory. The two indices are byte offsets that never wrap around,
+// and are on separate cache lines for the same reason as in SpscRingBuffer.
+struct SharedMemoryRingBuffer::Header {
+  uint64_t magic;
+  uint64_t capacity;
+  alignas(kCacheLineSize) std::atomic<uint64_t> write_index;
+  alignas(kCacheLineSize) std::atomic<uint64_t> read_index;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Atomics in shared memory need to be lock-free.");
+
+SharedMemoryRingBuffer::SharedMemoryRingBuffer(std::string name, void* mapping,
+                                               uint64_t mapping_size, bool is_owner)
+    : name_{std::move(name)},
+      mapping_{mapping},
+      mapping_size_{mapping_size},
+      is_owner_{is_owner},
+      header_{static_cast<Header*>(mapping)},
+      data_{static_cast<char*>(mapping) + kDataOffset},
+      capacity_{header_->capacity} {}
+
+SharedMemoryRingBuffer::SharedMemoryRingBuffer(SharedMemoryRingBuffer&& other)
+    : name_{std::move(other.name_)},
+      mapping_{std::exchange(other.mapping_, nullptr)},
+      mapping_size_{std::exchange(other.mapping_size_, 0)},
+      is_owner_{std::exchange(other.is_owner_, false)},
+      handle_{std::exchange(other.handle_, nullptr)},
+      header_{std::exchange(other.header_, nullptr)},
+      data_{std::exchange(other.data_, nullptr)},
+      capacity_{std::exchange(other.capacity_, 0)},
+      cached_read_index_{other.cached_read_index_},
+      reserved_write_index_{other.reserved_write_index_} {}
+
+SharedMemoryRingBuffer& SharedMemoryRingBuffer::operator=(SharedMemoryRingBuffer&& other) {
+  if (this != &other) {
+    Release();
+    name_ = std::move(other.name_);
+    mapping_ = std::exchange(other.mapping_, nullptr);
+    mapping_size_ = std::exchange(other.mapping_size_, 0);
+    is_owner_ = std::exchange(other.is_owner_, false);
+    handle_ = std::exchange(other.handle_, nullptr);
+    header_ = std::exchange(other.header_, nullptr);
+    data_ = std::exchange(other.data_, nullptr);
+    capacity_ = std::exchange(other.capacity_, 0);
+    cached_read_index_ = other.cached_read_index_;
+    reserved_write_index_ = other.reserved_write_index_;
+  }
+  return *this;
+}
+
+SharedMemoryRingBuffer::~SharedMemoryRingBuffer() { Release(); }
+
+void SharedMemoryRingBuffer::InitializeHeader(void* mapping, uint64_t capacity) {
+  static_assert(sizeof(Header) <= kDataOffset);
+  auto* header = new (mapping) Header{};
+  header->magic = kMagic;
+  header->capacity = capacity;
+  header->write_index.store(0, std::memory_order_relaxed);
+  header->read_index.store(0, std::memory_order_release);
+}
+
+ErrorMessageOr<void> SharedMemoryRingBuffer::ValidateHeader(const void* mapping,
+                                                            uint64_t mapping_size) {
+  if (mapping_size < kDataOffset) return ErrorMessage("Shared memory is too small.");
+  const auto* header = static_cast<const Header*>(mapping);
+  if (header->magic != kMagic) return ErrorMessage("Shared memory is not a ring buffer.");
+  const uint64_t capacity = header->capacity;
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0 || capacity > mapping_size - kDataOffset) {
+    return ErrorMessage(
+        absl::StrFormat("Ring buffer capacity %u doesn't fit shared memory size %u.", capacity,
+                        mapping_size));
+  }
+  return outcome::success();
+}
+
+char* SharedMemoryRingBuffer::TryReserveRecord(uint64_t size) {
+  if (size > GetMaxRecordSize()) return nullptr;
+  const uint64_t record_size = AlignUp<kRecordHeaderSize>(kRecordHeaderSize + size);
+  uint64_t write_index = header_->write_index.load(std::memory_order_relaxed);
+  const uint64_t offset = write_index & (capacity_ - 1);
+  const uint64_t space_until_end = capacity_ - offset;
+  const uint64_t skipped_size = space_until_end < record_size ? space_until_end : 0;
+
+  const uint64_t required_size = skipped_size + record_size;
+  if (capacity_ - (write_index - cached_read_index_) < required_size) {
+    cached_read_index_ = header_->read_index.load(std::memory_order_acquire);
+    if (capacity_ - (write_index - cached_read_index_) < required_size) return nullptr;
+  }
+
+  if (skipped_size > 0) {
+    std::memcpy(data_ + offset, &kSkipToStartMarker, sizeof(kSkipToStartMarker));
+    write_index += skipped_size;
+  }
+  char* record = data_ + (write_index & (capacity_ - 1));
+  std::memcpy(record, &size, sizeof(size));
+  reserved_write_index_ = write_index + record_size;
+  return record + kRecordHeaderSize;
+}
+
+void SharedMemoryRingBuffer::CommitRecord() {
+  ORBIT_CHECK(reserved_write_index_ != 0);
+  header_->write_index.store(reserved_write_index_, std::memory_order_release);
+  reserved_write_index_ = 0;
+}
+
+bool SharedMemoryRingBuffer::TryWriteRecord(absl::Span<const char> record) {
+  char* destination = TryReserveRecord(record.size());
+  if (destination == nullptr) return false;
+  std::memcpy(destination, record.data(), record.size());
+  CommitRecord();
+  return true;
+}
+
+ErrorMessageOr<uint64_t> SharedMemoryRingBuffer::ReadRecords(
+    const std::function<void(absl::Span<const char>)>& consumer) {
+  uint64_t read_index = header_->read_index.load(std::memory_order_relaxed);
+  const uint64_t write_index = header_->write_index.load(std::memory_order_acquire);
+  if (write_index - read_index > capacity_) {
+    header_->read_index.store(write_index, std::memory_order_release);
+    return ErrorMessage("Ring buffer indices are corrupted.");
+  }
+
+  uint64_t record_count = 0;
+  while (read_index != write_index) {
+    const uint64_t offset = read_index & (capacity_ - 1);
+    uint64_t size = 0;
+    std::memcpy(&size, data_ + offset, sizeof(size));
+    if (size == kSkipToStartMarker) {
+      read_index += capacity_ - offset;
+      continue;
+    }
+    const uint64_t record_size =
+        size <= GetMaxRecordSize() ? AlignUp<kRecordHeaderSize>(kRecordHeaderSize + size) : 0;
+    if (record_size == 0 || record_size > capacity_ - offset ||
+        record_size > write_index - read_index) {
+      header_->read_index.store(write_index, std::memory_order_release);
+      return ErrorMessage(absl::StrFormat("Ring buffer record of size %u is corrupted.", size));
+    }
+    consumer(absl::Span<const char>(data_ + offset + kRecordHeaderSize, size));
+    read_index += record_size;
+    ++record_count;
+  }
+
+  header_->read_index.store(read_index, std::memory_order_release);
+  return record_count;
+}
+
+}  // namespace orbit_base
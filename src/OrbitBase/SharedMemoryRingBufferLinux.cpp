@@ -0,0 +1,92 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_format.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/SafeStrerror.h"
+#include "OrbitBase/SharedMemoryRingBuffer.h"
+
+namespace orbit_base {
+
+namespace {
+
+// Names of POSIX shared memory objects start with a slash.
+[[nodiscard]] std::string GetShmName(std::string_view name) { return absl::StrFormat("/%s", name); }
+
+}  // namespace
+
+ErrorMessageOr<SharedMemoryRingBuffer> SharedMemoryRingBuffer::Create(std::string_view name,
+                                                                      uint64_t capacity) {
+  ORBIT_CHECK(capacity > 0 && (capacity & (capacity - 1)) == 0);
+  const std::string shm_name = GetShmName(name);
+  // OrbitService runs as root, so the owner is the only one that needs access.
+  const int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    return ErrorMessage(
+        absl::StrFormat("Unable to create shared memory \"%s\": %s", name, SafeStrerror(errno)));
+  }
+
+  const uint64_t mapping_size = kDataOffset + capacity;
+  void* mapping = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(mapping_size)) == 0) {
+    mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  const int error = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(shm_name.c_str());
+    return ErrorMessage(
+        absl::StrFormat("Unable to map shared memory \"%s\": %s", name, SafeStrerror(error)));
+  }
+
+  InitializeHeader(mapping, capacity);
+  return SharedMemoryRingBuffer{std::string{name}, mapping, mapping_size, /*is_owner=*/true};
+}
+
+ErrorMessageOr<SharedMemoryRingBuffer> SharedMemoryRingBuffer::Open(std::string_view name) {
+  const std::string shm_name = GetShmName(name);
+  const int fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+  if (fd == -1) {
+    return ErrorMessage(
+        absl::StrFormat("Unable to open shared memory \"%s\": %s", name, SafeStrerror(errno)));
+  }
+
+  struct stat file_stat {};
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    mapping = mmap(nullptr, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  const int error = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return ErrorMessage(
+        absl::StrFormat("Unable to map shared memory \"%s\": %s", name, SafeStrerror(error)));
+  }
+
+  const auto mapping_size = static_cast<uint64_t>(file_stat.st_size);
+  if (auto result = ValidateHeader(mapping, mapping_size); result.has_error()) {
+    munmap(mapping, mapping_size);
+    return ErrorMessage(absl::StrFormat("Unable to open shared memory \"%s\": %s", name,
+                                        result.error().message()));
+  }
+  return SharedMemoryRingBuffer{std::string{name}, mapping, mapping_size, /*is_owner=*/false};
+}
+
+void SharedMemoryRingBuffer::Release() {
+  if (mapping_ == nullptr) return;
+  munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+  if (is_owner_) {
+    shm_unlink(GetShmName(name_).c_str());
+  }
+}
+
+}  // namespace orbit_base
@@ -0,0 +1,144 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_format.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "OrbitBase/SharedMemoryRingBuffer.h"
+#include "OrbitBase/ThreadUtils.h"
+#include "TestUtils/TestUtils.h"
+
+namespace orbit_base {
+
+using orbit_test_utils::HasError;
+using orbit_test_utils::HasErrorWithMessage;
+using orbit_test_utils::HasNoError;
+using testing::ElementsAre;
+
+namespace {
+
+[[nodiscard]] std::string GetUniqueName() {
+  static int counter = 0;
+  return absl::StrFormat("orbit-shared-memory-ring-buffer-test-%u-%d", GetCurrentProcessId(),
+                         counter++);
+}
+
+[[nodiscard]] std::vector<std::string> ReadAllRecords(SharedMemoryRingBuffer& buffer) {
+  std::vector<std::string> records;
+  auto result = buffer.ReadRecords([&records](absl::Span<const char> record) {
+    records.emplace_back(record.data(), record.size());
+  });
+  EXPECT_THAT(result, HasNoError());
+  if (result.has_value()) {
+    EXPECT_EQ(result.value(), records.size());
+  }
+  return records;
+}
+
+}  // namespace
+
+TEST(SharedMemoryRingBuffer, WriteAndReadRecords) {
+  auto producer_or_error = SharedMemoryRingBuffer::Create(GetUniqueName(), 256);
+  ASSERT_THAT(producer_or_error, HasNoError());
+  SharedMemoryRingBuffer& producer = producer_or_error.value();
+  EXPECT_EQ(producer.GetCapacity(), 256);
+
+  auto consumer_or_error = SharedMemoryRingBuffer::Open(producer.GetName());
+  ASSERT_THAT(consumer_or_error, HasNoError());
+  SharedMemoryRingBuffer& consumer = consumer_or_error.value();
+  EXPECT_EQ(consumer.GetCapacity(), 256);
+
+  EXPECT_THAT(ReadAllRecords(consumer), ElementsAre());
+
+  EXPECT_TRUE(producer.TryWriteRecord(std::string{"first"}));
+  EXPECT_TRUE(producer.TryWriteRecord(std::string{""}));
+  char* reserved = producer.TryReserveRecord(6);
+  ASSERT_NE(reserved, nullptr);
+  std::memcpy(reserved, "second", 6);
+  // Not committed yet.
+  EXPECT_THAT(ReadAllRecords(consumer), ElementsAre("first", ""));
+
+  producer.CommitRecord();
+  EXPECT_THAT(ReadAllRecords(consumer), ElementsAre("second"));
+}
+
+TEST(SharedMemoryRingBuffer, FailsToWriteWhenFullAndWrapsAround) {
+  auto producer_or_error = SharedMemoryRingBuffer::Create(GetUniqueName(), 64);
+  ASSERT_THAT(producer_or_error, HasNoError());
+  SharedMemoryRingBuffer& producer = producer_or_error.value();
+  auto consumer_or_error = SharedMemoryRingBuffer::Open(producer.GetName());
+  ASSERT_THAT(consumer_or_error, HasNoError());
+  SharedMemoryRingBuffer& consumer = consumer_or_error.value();
+
+  EXPECT_EQ(producer.GetMaxRecordSize(), 24);
+  EXPECT_FALSE(producer.TryWriteRecord(std::string(25, 'x')));
+
+  // Each of these records takes 24 bytes, including the header and the padding.
+  EXPECT_TRUE(producer.TryWriteRecord(std::string(10, 'a')));
+  EXPECT_TRUE(producer.TryWriteRecord(std::string(10, 'b')));
+  EXPECT_FALSE(producer.TryWriteRecord(std::string(10, 'c')));
+  EXPECT_THAT(ReadAllRecords(consumer), ElementsAre(std::string(10, 'a'), std::string(10, 'b')));
+
+  // Only 16 bytes are left until the end of the buffer, so this record starts at the beginning.
+  EXPECT_TRUE(producer.TryWriteRecord(std::string(10, 'c')));
+  EXPECT_TRUE(producer.TryWriteRecord(std::string(10, 'd')));
+  EXPECT_FALSE(producer.TryWriteRecord(std::string(10, 'e')));
+  EXPECT_THAT(ReadAllRecords(consumer), ElementsAre(std::string(10, 'c'), std::string(10, 'd')));
+}
+
+TEST(SharedMemoryRingBuffer, OpenFailsForUnknownName) {
+  EXPECT_THAT(SharedMemoryRingBuffer::Open(GetUniqueName()), HasErrorWithMessage("Unable to open"));
+}
+
+TEST(SharedMemoryRingBuffer, NameIsReleasedOnDestruction) {
+  const std::string name = GetUniqueName();
+  {
+    auto producer_or_error = SharedMemoryRingBuffer::Create(name, 64);
+    ASSERT_THAT(producer_or_error, HasNoError());
+    EXPECT_THAT(SharedMemoryRingBuffer::Create(name, 64), HasError());
+  }
+  EXPECT_THAT(SharedMemoryRingBuffer::Open(name), HasError());
+  EXPECT_THAT(SharedMemoryRingBuffer::Create(name, 64), HasNoError());
+}
+
+TEST(SharedMemoryRingBuffer, ConcurrentProducerAndConsumer) {
+  constexpr uint64_t kRecordCount = 100'000;
+  auto producer_or_error = SharedMemoryRingBuffer::Create(GetUniqueName(), 1024);
+  ASSERT_THAT(producer_or_error, HasNoError());
+  SharedMemoryRingBuffer& producer = producer_or_error.value();
+  auto consumer_or_error = SharedMemoryRingBuffer::Open(producer.GetName());
+  ASSERT_THAT(consumer_or_error, HasNoError());
+  SharedMemoryRingBuffer& consumer = consumer_or_error.value();
+
+  std::thread producer_thread{[&producer] {
+    for (uint64_t i = 0; i < kRecordCount; ++i) {
+      // Records of varying size, such that they hit the end of the buffer at different offsets.
+      const std::string record(i % 17, static_cast<char>(i));
+      while (!producer.TryWriteRecord(record)) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  uint64_t expected = 0;
+  while (expected < kRecordCount) {
+    auto result = consumer.ReadRecords([&expected](absl::Span<const char> record) {
+      EXPECT_EQ(std::string(record.data(), record.size()),
+                std::string(expected % 17, static_cast<char>(expected)));
+      ++expected;
+    });
+    ASSERT_THAT(result, HasNoError());
+    if (result.value() == 0) std::this_thread::yield();
+  }
+  producer_thread.join();
+}
+
+}  // namespace orbit_base
@@ -0,0 +1,88 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_format.h>
+#include <windows.h>
+
+#include <string>
+
+#include "OrbitBase/GetLastError.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/SharedMemoryRingBuffer.h"
+
+namespace orbit_base {
+
+namespace {
+
+// The file mapping lives in the namespace of the current session.
+[[nodiscard]] std::string GetFileMappingName(std::string_view name) {
+  return absl::StrFormat("Local\\%s", name);
+}
+
+}  // namespace
+
+ErrorMessageOr<SharedMemoryRingBuffer> SharedMemoryRingBuffer::Create(std::string_view name,
+                                                                      uint64_t capacity) {
+  ORBIT_CHECK(capacity > 0 && (capacity & (capacity - 1)) == 0);
+  const uint64_t mapping_size = kDataOffset + capacity;
+  HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, /*lpFileMappingAttributes=*/nullptr,
+                                     PAGE_READWRITE, static_cast<DWORD>(mapping_size >> 32),
+                                     static_cast<DWORD>(mapping_size),
+                                     GetFileMappingName(name).c_str());
+  if (handle == nullptr) return GetLastErrorAsErrorMessage("CreateFileMappingA");
+  if (::GetLastError() == ERROR_ALREADY_EXISTS) {
+    CloseHandle(handle);
+    return ErrorMessage(absl::StrFormat("Shared memory \"%s\" already exists.", name));
+  }
+
+  void* mapping = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, mapping_size);
+  if (mapping == nullptr) {
+    ErrorMessage error = GetLastErrorAsErrorMessage("MapViewOfFile");
+    CloseHandle(handle);
+    return error;
+  }
+
+  InitializeHeader(mapping, capacity);
+  SharedMemoryRingBuffer buffer{std::string{name}, mapping, mapping_size, /*is_owner=*/true};
+  buffer.handle_ = handle;
+  return buffer;
+}
+
+ErrorMessageOr<SharedMemoryRingBuffer> SharedMemoryRingBuffer::Open(std::string_view name) {
+  HANDLE handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, /*bInheritHandle=*/FALSE,
+                                   GetFileMappingName(name).c_str());
+  if (handle == nullptr) return GetLastErrorAsErrorMessage("OpenFileMappingA");
+
+  void* mapping = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, /*dwNumberOfBytesToMap=*/0);
+  if (mapping == nullptr) {
+    ErrorMessage error = GetLastErrorAsErrorMessage("MapViewOfFile");
+    CloseHandle(handle);
+    return error;
+  }
+
+  // The size of the view is the size of the file mapping, rounded up to full pages.
+  MEMORY_BASIC_INFORMATION memory_info{};
+  const uint64_t mapping_size =
+      VirtualQuery(mapping, &memory_info, sizeof(memory_info)) != 0 ? memory_info.RegionSize : 0;
+  if (auto result = ValidateHeader(mapping, mapping_size); result.has_error()) {
+    UnmapViewOfFile(mapping);
+    CloseHandle(handle);
+    return ErrorMessage(absl::StrFormat("Unable to open shared memory \"%s\": %s", name,
+                                        result.error().message()));
+  }
+
+  SharedMemoryRingBuffer buffer{std::string{name}, mapping, mapping_size, /*is_owner=*/false};
+  buffer.handle_ = handle;
+  return buffer;
+}
+
+void SharedMemoryRingBuffer::Release() {
+  if (mapping_ == nullptr) return;
+  UnmapViewOfFile(mapping_);
+  mapping_ = nullptr;
+  CloseHandle(handle_);
+  handle_ = nullptr;
+}
+
+}  // namespace orbit_base
@@ -0,0 +1,79 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "OrbitBase/SpscRingBuffer.h"
+
+namespace orbit_base {
+
+using testing::ElementsAre;
+
+TEST(SpscRingBuffer, PushAndPop) {
+  SpscRingBuffer<int> ring_buffer{4};
+  EXPECT_EQ(ring_buffer.GetCapacity(), 4);
+  EXPECT_TRUE(ring_buffer.HasFreeSlots(4));
+  EXPECT_FALSE(ring_buffer.HasFreeSlots(5));
+
+  EXPECT_TRUE(ring_buffer.TryPush(1));
+  EXPECT_TRUE(ring_buffer.TryPush(2));
+  EXPECT_TRUE(ring_buffer.TryPush(3));
+  EXPECT_TRUE(ring_buffer.HasFreeSlots(1));
+  EXPECT_FALSE(ring_buffer.HasFreeSlots(2));
+
+  std::vector<int> output(4);
+  EXPECT_EQ(ring_buffer.TryPopBulk(output.data(), 2), 2);
+  EXPECT_THAT(output, ElementsAre(1, 2, 0, 0));
+  EXPECT_TRUE(ring_buffer.HasFreeSlots(3));
+
+  EXPECT_EQ(ring_buffer.TryPopBulk(output.data(), 4), 1);
+  EXPECT_EQ(output[0], 3);
+  EXPECT_EQ(ring_buffer.TryPopBulk(output.data(), 4), 0);
+}
+
+TEST(SpscRingBuffer, FailsToPushWhenFull) {
+  SpscRingBuffer<int> ring_buffer{2};
+  EXPECT_TRUE(ring_buffer.TryPush(1));
+  EXPECT_TRUE(ring_buffer.TryPush(2));
+  EXPECT_FALSE(ring_buffer.TryPush(3));
+
+  std::vector<int> output(2);
+  EXPECT_EQ(ring_buffer.TryPopBulk(output.data(), 1), 1);
+  EXPECT_TRUE(ring_buffer.TryPush(4));
+
+  EXPECT_EQ(ring_buffer.TryPopBulk(output.data(), 2), 2);
+  EXPECT_THAT(output, ElementsAre(2, 4));
+}
+
+TEST(SpscRingBuffer, ConcurrentProducerAndConsumer) {
+  constexpr uint64_t kElementCount = 100'000;
+  SpscRingBuffer<uint64_t> ring_buffer{64};
+
+  std::thread producer{[&ring_buffer] {
+    for (uint64_t i = 0; i < kElementCount; ++i) {
+      while (!ring_buffer.TryPush(uint64_t{i})) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  std::vector<uint64_t> output(16);
+  uint64_t expected = 0;
+  while (expected < kElementCount) {
+    const size_t count = ring_buffer.TryPopBulk(output.data(), output.size());
+    if (count == 0) std::this_thread::yield();
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(output[i], expected);
+      ++expected;
+    }
+  }
+  producer.join();
+}
+
+}  // namespace orbit_base
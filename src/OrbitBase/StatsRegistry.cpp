@@ -0,0 +1,55 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitBase/StatsRegistry.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_base {
+
+void StatsRegistry::Registration::Reset() {
+  if (registry_ == nullptr) return;
+  registry_->Unregister(id_);
+  registry_ = nullptr;
+}
+
+StatsRegistry& StatsRegistry::GetDefault() {
+  // Never destroyed, so that stats can be unregistered during static destruction.
+  static auto* const kDefaultRegistry = new StatsRegistry();
+  return *kDefaultRegistry;
+}
+
+StatsRegistry::Registration StatsRegistry::Register(std::string name,
+                                                    ValueFunction value_function) {
+  ORBIT_CHECK(value_function != nullptr);
+  absl::MutexLock lock{&mutex_};
+  const uint64_t id = next_id_++;
+  stats_.emplace(id, std::make_pair(std::move(name), std::move(value_function)));
+  return Registration{this, id};
+}
+
+void StatsRegistry::Unregister(uint64_t id) {
+  absl::MutexLock lock{&mutex_};
+  ORBIT_CHECK(stats_.erase(id) == 1);
+}
+
+std::vector<StatsRegistry::Stat> StatsRegistry::GetStats() const {
+  std::vector<Stat> stats;
+  {
+    absl::ReaderMutexLock lock{&mutex_};
+    stats.reserve(stats_.size());
+    for (const auto& [unused_id, name_and_value_function] : stats_) {
+      const auto& [name, value_function] = name_and_value_function;
+      stats.push_back({name, value_function()});
+    }
+  }
+  std::sort(stats.begin(), stats.end(),
+            [](const Stat& lhs, const Stat& rhs) { return lhs.name < rhs.name; });
+  return stats;
+}
+
+}  // namespace orbit_base
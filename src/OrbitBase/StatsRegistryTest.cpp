@@ -0,0 +1,80 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "OrbitBase/StatsRegistry.h"
+
+namespace orbit_base {
+
+using testing::ElementsAre;
+using testing::Field;
+using testing::IsEmpty;
+
+[[nodiscard]] static auto StatIs(const std::string& name, uint64_t value) {
+  return testing::AllOf(Field(&StatsRegistry::Stat::name, name),
+                        Field(&StatsRegistry::Stat::value, value));
+}
+
+TEST(StatsRegistry, GetStatsCallsTheValueFunctionsAndSortsByName) {
+  StatsRegistry registry;
+  std::atomic<uint64_t> counter = 1;
+  StatsRegistry::Registration registration_b =
+      registry.Register("b", [&counter] { return counter.load(); });
+  StatsRegistry::Registration registration_a = registry.Register("a", [] { return 42; });
+
+  EXPECT_THAT(registry.GetStats(), ElementsAre(StatIs("a", 42), StatIs("b", 1)));
+  counter = 2;
+  EXPECT_THAT(registry.GetStats(), ElementsAre(StatIs("a", 42), StatIs("b", 2)));
+}
+
+TEST(StatsRegistry, RegistrationUnregistersWhenResetOrDestroyed) {
+  StatsRegistry registry;
+  StatsRegistry::Registration registration_a = registry.Register("a", [] { return 1; });
+  {
+    StatsRegistry::Registration registration_b = registry.Register("b", [] { return 2; });
+    EXPECT_THAT(registry.GetStats(), ElementsAre(StatIs("a", 1), StatIs("b", 2)));
+  }
+  EXPECT_THAT(registry.GetStats(), ElementsAre(StatIs("a", 1)));
+
+  registration_a.Reset();
+  EXPECT_THAT(registry.GetStats(), IsEmpty());
+  // Resetting again has no effect.
+  registration_a.Reset();
+  EXPECT_THAT(registry.GetStats(), IsEmpty());
+}
+
+TEST(StatsRegistry, MovedRegistrationKeepsTheStatRegistered) {
+  StatsRegistry registry;
+  std::vector<StatsRegistry::Registration> registrations;
+  {
+    StatsRegistry::Registration registration = registry.Register("a", [] { return 1; });
+    registrations.push_back(std::move(registration));
+  }
+  EXPECT_THAT(registry.GetStats(), ElementsAre(StatIs("a", 1)));
+
+  StatsRegistry::Registration other = registry.Register("b", [] { return 2; });
+  // Move-assigning unregisters the stat previously held.
+  other = std::move(registrations[0]);
+  EXPECT_THAT(registry.GetStats(), ElementsAre(StatIs("a", 1)));
+  registrations.clear();
+  EXPECT_THAT(registry.GetStats(), ElementsAre(StatIs("a", 1)));
+  other.Reset();
+  EXPECT_THAT(registry.GetStats(), IsEmpty());
+}
+
+TEST(StatsRegistry, StatsWithTheSameNameAreAllReported) {
+  StatsRegistry registry;
+  StatsRegistry::Registration registration_1 = registry.Register("a", [] { return 1; });
+  StatsRegistry::Registration registration_2 = registry.Register("a", [] { return 1; });
+  EXPECT_THAT(registry.GetStats(), ElementsAre(StatIs("a", 1), StatIs("a", 1)));
+}
+
+}  // namespace orbit_base
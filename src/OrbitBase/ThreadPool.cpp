@@ -14,6 +14,7 @@
 #include <absl/time/time.h>
 
 #include <algorithm>
+#include <deque>
 #include <list>
 #include <thread>
 #include <type_traits>
@@ -55,12 +56,25 @@ class ThreadPoolImpl : public ThreadPool {
   void CreateWorker();
   void WorkerFunction();
 
+  // The actions scheduled from one of the worker threads of this pool are put on that worker's own
+  // deque. A worker runs the newest action of its own deque first, as it likely works on the same
+  // data as the action that scheduled it, then the oldest action of the shared queue, and otherwise
+  // steals the oldest action of another worker's deque.
+  struct Worker {
+    ThreadPoolImpl* thread_pool;
+    std::deque<std::unique_ptr<Action>> local_actions;
+  };
+  static thread_local Worker* current_worker_;
+
   // Non-virtual implementations of Shutdown and Wait that can be called from the destructor.
   void ShutdownInternal();
   void WaitInternal();
 
   absl::Mutex mutex_;
   std::list<std::unique_ptr<Action>> scheduled_actions_;
+  std::vector<Worker*> workers_;
+  // The number of actions in scheduled_actions_ and in the local deques of all workers_.
+  size_t num_scheduled_actions_ = 0;
   absl::flat_hash_map<std::thread::id, std::thread> worker_threads_;
   std::vector<std::thread> finished_threads_;
   size_t thread_pool_min_size_;
@@ -73,6 +87,8 @@ class ThreadPoolImpl : public ThreadPool {
   Executor::ScopedHandle executor_handle_{this};
 };
 
+thread_local ThreadPoolImpl::Worker* ThreadPoolImpl::current_worker_ = nullptr;
+
 ThreadPoolImpl::ThreadPoolImpl(size_t thread_pool_min_size, size_t thread_pool_max_size,
                                absl::Duration thread_ttl,
                                std::function<void(const std::unique_ptr<Action>&)> run_action)
@@ -111,8 +127,13 @@ void ThreadPoolImpl::ScheduleImpl(std::unique_ptr<Action> action) {
   absl::MutexLock lock(&mutex_);
   ORBIT_CHECK(!shutdown_initiated_);
 
-  scheduled_actions_.push_back(std::move(wrapped_action));
-  if (idle_threads_ < scheduled_actions_.size() && worker_threads_.size() < thread_pool_max_size_) {
+  if (current_worker_ != nullptr && current_worker_->thread_pool == this) {
+    current_worker_->local_actions.push_back(std::move(wrapped_action));
+  } else {
+    scheduled_actions_.push_back(std::move(wrapped_action));
+  }
+  ++num_scheduled_actions_;
+  if (idle_threads_ < num_scheduled_actions_ && worker_threads_.size() < thread_pool_max_size_) {
     CreateWorker();
   }
 
@@ -154,7 +175,7 @@ void ThreadPoolImpl::WaitInternal() {
 }
 
 bool ThreadPoolImpl::ActionsAvailableOrShutdownInitiated() {
-  return !scheduled_actions_.empty() || shutdown_initiated_;
+  return num_scheduled_actions_ > 0 || shutdown_initiated_;
 }
 
 std::unique_ptr<Action> ThreadPoolImpl::TakeAction() {
@@ -173,17 +194,42 @@ std::unique_ptr<Action> ThreadPoolImpl::TakeAction() {
     }
   }
 
-  if (scheduled_actions_.empty()) {
+  if (num_scheduled_actions_ == 0) {
     return nullptr;
   }
+  --num_scheduled_actions_;
 
-  std::unique_ptr<Action> action = std::move(scheduled_actions_.front());
-  scheduled_actions_.pop_front();
+  std::deque<std::unique_ptr<Action>>& own_actions = current_worker_->local_actions;
+  if (!own_actions.empty()) {
+    std::unique_ptr<Action> action = std::move(own_actions.back());
+    own_actions.pop_back();
+    return action;
+  }
 
-  return action;
+  if (!scheduled_actions_.empty()) {
+    std::unique_ptr<Action> action = std::move(scheduled_actions_.front());
+    scheduled_actions_.pop_front();
+    return action;
+  }
+
+  for (Worker* worker : workers_) {
+    if (worker->local_actions.empty()) continue;
+    std::unique_ptr<Action> action = std::move(worker->local_actions.front());
+    worker->local_actions.pop_front();
+    return action;
+  }
+
+  ORBIT_UNREACHABLE();
 }
 
 void ThreadPoolImpl::WorkerFunction() {
+  Worker worker{this, {}};
+  current_worker_ = &worker;
+  {
+    absl::MutexLock lock(&mutex_);
+    workers_.push_back(&worker);
+  }
+
   while (true) {
     absl::MutexLock lock(&mutex_);
     std::unique_ptr<Action> action = TakeAction();
@@ -192,6 +238,11 @@ void ThreadPoolImpl::WorkerFunction() {
     --idle_threads_;
 
     if (!action) {
+      // Only happens when there are no actions left, so the own deque is empty.
+      ORBIT_CHECK(worker.local_actions.empty());
+      workers_.erase(std::find(workers_.begin(), workers_.end(), &worker));
+      current_worker_ = nullptr;
+
       // Move this thread from the worker_threads_ to finished_threads_.
       std::thread::id thread_id = std::this_thread::get_id();
       auto it = worker_threads_.find(thread_id);
@@ -31,6 +31,18 @@ TEST(ThreadUtils, GetCurrentThreadId) {
   EXPECT_TRUE(worker_tid != current_tid);
 }
 
+TEST(ThreadUtils, GetCurrentThreadCpuTimeNs) {
+  const uint64_t start_cpu_time_ns = orbit_base::GetCurrentThreadCpuTimeNs();
+  // Busy loop until the thread has consumed some CPU time, as the resolution can be coarse.
+  uint64_t cpu_time_ns = start_cpu_time_ns;
+  volatile uint64_t counter = 0;
+  while (cpu_time_ns == start_cpu_time_ns) {
+    for (int i = 0; i < 1000; ++i) counter = counter + 1;
+    cpu_time_ns = orbit_base::GetCurrentThreadCpuTimeNs();
+  }
+  EXPECT_GT(cpu_time_ns, start_cpu_time_ns);
+}
+
 TEST(ThreadUtils, GetSetCurrentThreadShortName) {
   // Set thread name of exactly 15 characters. This should work on both Linux and Windows.
   constexpr const char* kThreadName = "123456789012345";
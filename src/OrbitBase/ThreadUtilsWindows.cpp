@@ -36,6 +36,20 @@ bool IsValidProcessId(uint32_t pid) {
   return pid != orbit_base::kInvalidProcessId && IsMultipleOfFour(pid);
 }
 
+uint64_t GetCurrentThreadCpuTimeNs() {
+  FILETIME creation_time{};
+  FILETIME exit_time{};
+  FILETIME kernel_time{};
+  FILETIME user_time{};
+  if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time)) {
+    return 0;
+  }
+  auto to_100ns_units = [](const FILETIME& file_time) {
+    return (static_cast<uint64_t>(file_time.dwHighDateTime) << 32) | file_time.dwLowDateTime;
+  };
+  return (to_100ns_units(kernel_time) + to_100ns_units(user_time)) * 100;
+}
+
 uint32_t GetCurrentThreadIdNative() {
   thread_local uint32_t current_tid = ::GetCurrentThreadId();
   return current_tid;
@@ -0,0 +1,87 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitBase/Tsc.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#include <cpuid.h>
+#endif
+
+#include <chrono>
+#include <thread>
+
+#include "OrbitBase/Profiling.h"
+
+namespace orbit_base {
+
+namespace {
+
+// CPUID.80000007H:EDX[8] is the invariant TSC bit, on both Intel and AMD.
+[[maybe_unused]] constexpr unsigned int kAdvancedPowerManagementLeaf = 0x80000007;
+[[maybe_unused]] constexpr unsigned int kInvariantTscBit = 1u << 8;
+
+struct ReferencePoint {
+  uint64_t tsc;
+  uint64_t timestamp_ns;
+};
+
+// Reads both clocks as close together as possible: the attempt with the shortest time between the
+// two calls to `CaptureTimestampNs` surrounding `ReadTsc` wins.
+[[nodiscard]] ReferencePoint TakeReferencePoint() {
+  constexpr int kAttempts = 16;
+  ReferencePoint reference_point{};
+  uint64_t min_duration_ns = UINT64_MAX;
+  for (int i = 0; i < kAttempts; ++i) {
+    const uint64_t timestamp_before_ns = CaptureTimestampNs();
+    const uint64_t tsc = ReadTsc();
+    const uint64_t timestamp_after_ns = CaptureTimestampNs();
+    const uint64_t duration_ns = timestamp_after_ns - timestamp_before_ns;
+    if (duration_ns < min_duration_ns) {
+      min_duration_ns = duration_ns;
+      reference_point = {tsc, timestamp_before_ns + duration_ns / 2};
+    }
+  }
+  return reference_point;
+}
+
+[[nodiscard]] double MeasureNsPerTick() {
+  const ReferencePoint start = TakeReferencePoint();
+  // The error of each reference point is in the order of tens of nanoseconds, which makes for a
+  // relative error of the frequency of about 1e-5 with this duration.
+  constexpr std::chrono::milliseconds kMeasurementDuration{5};
+  std::this_thread::sleep_for(kMeasurementDuration);
+  const ReferencePoint end = TakeReferencePoint();
+  if (end.tsc == start.tsc) return 0;
+  return static_cast<double>(end.timestamp_ns - start.timestamp_ns) /
+         static_cast<double>(end.tsc - start.tsc);
+}
+
+}  // namespace
+
+bool HasInvariantTsc() {
+#if defined(_WIN32)
+  int registers[4] = {};
+  __cpuid(registers, 0x80000000);
+  if (static_cast<unsigned int>(registers[0]) < kAdvancedPowerManagementLeaf) return false;
+  __cpuid(registers, kAdvancedPowerManagementLeaf);
+  return (static_cast<unsigned int>(registers[3]) & kInvariantTscBit) != 0;
+#elif defined(__x86_64__)
+  unsigned int eax = 0;
+  unsigned int ebx = 0;
+  unsigned int ecx = 0;
+  unsigned int edx = 0;
+  if (__get_cpuid(kAdvancedPowerManagementLeaf, &eax, &ebx, &ecx, &edx) == 0) return false;
+  return (edx & kInvariantTscBit) != 0;
+#else
+  return false;
+#endif
+}
+
+TscConverter TscConverter::Create() {
+  static const double kNsPerTick = MeasureNsPerTick();
+  const ReferencePoint reference_point = TakeReferencePoint();
+  return TscConverter{reference_point.tsc, reference_point.timestamp_ns, kNsPerTick};
+}
+
+}  // namespace orbit_base
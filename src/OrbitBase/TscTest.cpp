@@ -0,0 +1,37 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/Tsc.h"
+
+namespace orbit_base {
+
+TEST(Tsc, ConvertsToCaptureTimestamps) {
+  if (!HasInvariantTsc()) {
+    GTEST_SKIP() << "No invariant TSC";
+  }
+
+  const TscConverter converter = TscConverter::Create();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  const uint64_t timestamp_before_ns = CaptureTimestampNs();
+  const uint64_t tsc = ReadTsc();
+  const uint64_t timestamp_after_ns = CaptureTimestampNs();
+
+  // Allow for some error of the calibration.
+  constexpr uint64_t kToleranceNs = 100'000;
+  const uint64_t converted_timestamp_ns = converter.ToCaptureTimestampNs(tsc);
+  EXPECT_GE(converted_timestamp_ns, timestamp_before_ns - kToleranceNs);
+  EXPECT_LE(converted_timestamp_ns, timestamp_after_ns + kToleranceNs);
+
+  // Values of the time stamp counter from before the reference point are converted, too.
+  EXPECT_LT(converter.ToCaptureTimestampNs(tsc - 1'000'000), converted_timestamp_ns);
+}
+
+}  // namespace orbit_base
@@ -64,6 +64,9 @@ class InternalFutureBase {
   [[nodiscard]] FutureRegisterContinuationResult RegisterContinuation(
       Invocable&& continuation) const {
     if (!IsValid()) return FutureRegisterContinuationResult::kFutureNotValid;
+    if (this->shared_state_->IsFinishedWithoutLock()) {
+      return FutureRegisterContinuationResult::kFutureAlreadyCompleted;
+    }
 
     absl::MutexLock lock{&this->shared_state_->mutex};
     if (this->shared_state_->IsFinished()) {
@@ -79,6 +82,7 @@ class InternalFutureBase {
 
   [[nodiscard]] bool IsFinished() const {
     if (this->shared_state_.use_count() == 0) return false;
+    if (this->shared_state_->IsFinishedWithoutLock()) return true;
 
     absl::MutexLock lock{&this->shared_state_->mutex};
     return this->shared_state_->IsFinished();
@@ -86,6 +90,7 @@ class InternalFutureBase {
 
   void Wait() const {
     ORBIT_CHECK(IsValid());
+    if (this->shared_state_->IsFinishedWithoutLock()) return;
     absl::MutexLock lock{&this->shared_state_->mutex};
     this->shared_state_->mutex.Await(absl::Condition(
         +[](const std::shared_ptr<SharedState<T>>* shared_state) ABSL_EXCLUSIVE_LOCKS_REQUIRED(
@@ -112,12 +117,14 @@ class InternalFuture : public orbit_base_internal::InternalFutureBase<T, Derived
   InternalFuture(const T& val)  // NOLINT(google-explicit-constructor)
       : InternalFutureBase<T, Derived>{std::make_shared<SharedState<T>>()} {
     this->shared_state_->result.emplace(val);
+    this->shared_state_->is_finished = true;
   }
 
   // Constructs a completed future
   InternalFuture(T&& val)  // NOLINT(google-explicit-constructor)
       : InternalFutureBase<T, Derived>{std::make_shared<SharedState<T>>()} {
     this->shared_state_->result.emplace(std::move(val));
+    this->shared_state_->is_finished = true;
   }
 
   // Constructs a completed future
@@ -125,13 +132,12 @@ class InternalFuture : public orbit_base_internal::InternalFutureBase<T, Derived
   explicit InternalFuture(std::in_place_t, Args&&... args)
       : InternalFutureBase<T, Derived>{std::make_shared<SharedState<T>>()} {
     this->shared_state_->result.emplace(std::forward<Args>(args)...);
+    this->shared_state_->is_finished = true;
   }
 
   const T& Get() const {
     this->Wait();
-
-    absl::MutexLock lock{&this->shared_state_->mutex};
-    return this->shared_state_->result.value();
+    return this->shared_state_->GetFinishedResultWithoutLock();
   }
 
   // This is syntactic sugar for MainThreadExecutor (or maybe other executors in the future).
@@ -167,6 +173,7 @@ class InternalFuture<void, Derived>
       : orbit_base_internal::InternalFutureBase<void, Derived>{
             std::make_shared<orbit_base_internal::SharedState<void>>()} {
     this->shared_state_->finished = true;
+    this->shared_state_->is_finished = true;
   }
 
   // This is syntactic sugar for MainThreadExecutor (or maybe other executors in the future).
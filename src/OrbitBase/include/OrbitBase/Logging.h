@@ -11,8 +11,11 @@
 #include <absl/time/time.h>
 #include <stdlib.h>
 
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
 #include <filesystem>
+#include <limits>
 #include <mutex>
 #include <string>
 #include <string_view>
@@ -53,6 +56,22 @@ constexpr const char* kLogTimeFormat = "%Y-%m-%dT%H:%M:%E6S";
 
 #define ORBIT_ERROR_ONCE(format, ...) ORBIT_LOG_ONCE("Error: " format, ##__VA_ARGS__)
 
+// Logs at most once per `min_interval` (an absl::Duration) from the same call site, and reports how
+// many messages from there were skipped in between. For messages that could be logged at a high
+// rate, for example triggered by events in the tracing threads.
+#define ORBIT_LOG_RATE_LIMITED(min_interval, format, ...)                                     \
+  do {                                                                                        \
+    static orbit_base_internal::LogRateLimiter rate_limiter__{min_interval};                  \
+    uint64_t num_skipped__ = 0;                                                               \
+    if (rate_limiter__.ShouldLog(&num_skipped__)) {                                           \
+      if (num_skipped__ > 0) ORBIT_LOG("Skipped %u messages logged from here", num_skipped__); \
+      ORBIT_LOG(format, ##__VA_ARGS__);                                                       \
+    }                                                                                         \
+  } while (0)
+
+#define ORBIT_ERROR_RATE_LIMITED(min_interval, format, ...) \
+  ORBIT_LOG_RATE_LIMITED(min_interval, "Error: " format, ##__VA_ARGS__)
+
 #define ORBIT_FATAL(format, ...)                \
   do {                                          \
     ORBIT_LOG("Fatal: " format, ##__VA_ARGS__); \
@@ -136,10 +155,11 @@ struct FuzzingException {};
     orbit_base_internal::OutputToDebugger(message); \
     orbit_base_internal::LogToFile(message);        \
   } while (0)
-#define ORBIT_INTERNAL_PLATFORM_ABORT() \
-  do {                                  \
-    __debugbreak();                     \
-    abort();                            \
+#define ORBIT_INTERNAL_PLATFORM_ABORT()  \
+  do {                                   \
+    orbit_base_internal::FlushLogFile(); \
+    __debugbreak();                      \
+    abort();                             \
   } while (0)
 #else
 #define ORBIT_INTERNAL_PLATFORM_LOG(message) \
@@ -147,7 +167,11 @@ struct FuzzingException {};
     (void)std::fputs(message, stderr);       \
     orbit_base_internal::LogToFile(message); \
   } while (0)
-#define ORBIT_INTERNAL_PLATFORM_ABORT() abort()
+#define ORBIT_INTERNAL_PLATFORM_ABORT()  \
+  do {                                   \
+    orbit_base_internal::FlushLogFile(); \
+    abort();                             \
+  } while (0)
 #endif
 
 #ifdef __clang__
@@ -161,7 +185,14 @@ std::string GetLogFileName();
 // applications. If so, both the file name and the error message will be recorded in the log file.
 ErrorMessageOr<void> TryRemoveOldLogFiles(const std::filesystem::path& log_dir);
 
-void InitLogFile(const std::filesystem::path& path);
+enum class LogFileWrites { kSynchronous, kAsynchronous };
+
+// With LogFileWrites::kAsynchronous, logging only copies the message to memory, and a background
+// thread writes it to the file, so that logging never waits for the disk. If the background thread
+// falls behind by several MB, messages are dropped, and the number of dropped messages is logged.
+// Pending messages are still written before aborting on a failed check and at exit.
+void InitLogFile(const std::filesystem::path& path,
+                 LogFileWrites writes = LogFileWrites::kSynchronous);
 
 void LogStacktrace();
 
@@ -179,6 +210,35 @@ inline std::string to_string(const char* value) { return value; }
 namespace orbit_base_internal {
 
 void LogToFile(std::string_view message);
+// Blocks until all messages passed to LogToFile are written to the log file.
+void FlushLogFile();
+
+// Used by ORBIT_LOG_RATE_LIMITED.
+class LogRateLimiter {
+ public:
+  explicit LogRateLimiter(absl::Duration min_interval)
+      : min_interval_ns_{absl::ToInt64Nanoseconds(min_interval)} {}
+
+  // Returns true if at least `min_interval` passed since the last call that returned true. Then
+  // `num_skipped` is set to the number of calls that returned false in between.
+  [[nodiscard]] bool ShouldLog(uint64_t* num_skipped) {
+    const int64_t now_ns = absl::GetCurrentTimeNanos();
+    int64_t next_log_time_ns = next_log_time_ns_.load(std::memory_order_relaxed);
+    if (now_ns < next_log_time_ns ||
+        !next_log_time_ns_.compare_exchange_strong(next_log_time_ns, now_ns + min_interval_ns_,
+                                                   std::memory_order_relaxed)) {
+      num_skipped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    *num_skipped = num_skipped_.exchange(0, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  const int64_t min_interval_ns_;
+  std::atomic<int64_t> next_log_time_ns_ = std::numeric_limits<int64_t>::min();
+  std::atomic<uint64_t> num_skipped_ = 0;
+};
 
 #ifdef _WIN32
 // Add one indirection so that we can #include <Windows.h> in the .cpp instead of in this header.
@@ -0,0 +1,96 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_BASE_PARALLEL_FOR_H_
+#define ORBIT_BASE_PARALLEL_FOR_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "OrbitBase/Executor.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ThreadPool.h"
+
+namespace orbit_base {
+
+// Calls `function(index)` for each index in [0, num_elements) and returns once all calls returned.
+// The calls are made from the calling thread and from up to one task per logical core on
+// `executor`, which claim chunks of `chunk_size` consecutive indices until none are left. This way
+// threads that are done early take over the remaining work, and fine-grained work doesn't pay for
+// scheduling an action per element. ParallelFor doesn't wait for tasks that only start once all
+// indices are claimed, so it can also be called from a task of `executor` without ever waiting for
+// tasks queued behind it.
+//
+// Usage:
+//
+// orbit_base::ParallelFor(objects.size(), [&objects](size_t i) { ProcessObject(objects[i]); });
+//
+template <typename Function>
+void ParallelFor(Executor* executor, size_t num_elements, Function&& function,
+                 size_t chunk_size = 1) {
+  ORBIT_CHECK(chunk_size > 0);
+  const size_t num_chunks = (num_elements + chunk_size - 1) / chunk_size;
+  if (num_chunks == 0) return;
+
+  // Shared with the tasks, which can outlive this call.
+  struct State {
+    std::atomic<size_t> next_index = 0;
+    absl::Mutex mutex;
+    size_t num_running_tasks ABSL_GUARDED_BY(mutex) = 0;
+  };
+  auto state = std::make_shared<State>();
+
+  auto process_chunks = [num_elements, chunk_size](State& state, Function& function) {
+    while (true) {
+      const size_t begin_index = state.next_index.fetch_add(chunk_size, std::memory_order_relaxed);
+      if (begin_index >= num_elements) return;
+      const size_t end_index = std::min(num_elements, begin_index + chunk_size);
+      for (size_t index = begin_index; index < end_index; ++index) {
+        function(index);
+      }
+    }
+  };
+
+  const size_t num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  const size_t num_tasks = std::min(num_chunks, num_threads) - 1;
+  for (size_t i = 0; i < num_tasks; ++i) {
+    executor->Schedule([state, process_chunks, function = &function, num_elements]() {
+      {
+        absl::MutexLock lock{&state->mutex};
+        // `function` can only be used while this call hasn't returned, which it doesn't as long as
+        // indices are left or tasks are running.
+        if (state->next_index.load(std::memory_order_relaxed) >= num_elements) return;
+        ++state->num_running_tasks;
+      }
+      process_chunks(*state, *function);
+      absl::MutexLock lock{&state->mutex};
+      --state->num_running_tasks;
+    });
+  }
+
+  process_chunks(*state, function);
+  absl::MutexLock lock{&state->mutex};
+  state->mutex.Await(absl::Condition(
+      +[](State* state) ABSL_EXCLUSIVE_LOCKS_REQUIRED(state->mutex) {
+        return state->num_running_tasks == 0;
+      },
+      state.get()));
+}
+
+template <typename Function>
+void ParallelFor(size_t num_elements, Function&& function, size_t chunk_size = 1) {
+  ParallelFor(ThreadPool::GetDefaultThreadPool(), num_elements, std::forward<Function>(function),
+              chunk_size);
+}
+
+}  // namespace orbit_base
+
+#endif  // ORBIT_BASE_PARALLEL_FOR_H_
@@ -75,6 +75,7 @@ class Promise : public orbit_base_internal::PromiseBase<T> {
     }
 
     this->shared_state_->result.emplace(std::move(result));
+    this->shared_state_->MarkFinished();
   }
 
   [[nodiscard]] bool HasResult() const {
@@ -97,6 +98,7 @@ class Promise<void> : public orbit_base_internal::PromiseBase<void> {
     }
 
     this->shared_state_->finished = true;
+    this->shared_state_->MarkFinished();
   }
 
   [[nodiscard]] bool IsFinished() const {
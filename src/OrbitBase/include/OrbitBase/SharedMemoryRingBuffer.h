@@ -0,0 +1,99 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_BASE_SHARED_MEMORY_RING_BUFFER_H_
+#define ORBIT_BASE_SHARED_MEMORY_RING_BUFFER_H_
+
+#include <absl/types/span.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "OrbitBase/Result.h"
+
+namespace orbit_base {
+
+// A ring buffer of variable-size records in memory shared between two processes, for exactly one
+// producer and one consumer. The producer creates the buffer and passes its name to the consumer
+// through some other channel, then the consumer opens it.
+//
+// Each record is a 8-byte header containing the size of the record, followed by the payload and
+// padded to a multiple of 8 bytes. Records are never split at the end of the buffer: if a record
+// doesn't fit, the rest of the buffer is marked as skipped and the record is written at the start.
+// When the buffer is full, `TryReserveRecord` fails instead of blocking or overwriting.
+//
+// The consumer must not trust the content of the buffer, as the producer is a different process.
+// `ReadRecords` validates every record header and drops the content of the buffer on corruption.
+class SharedMemoryRingBuffer {
+ public:
+  // Creates a new shared memory object called `name` with room for `capacity` bytes of records.
+  // `capacity` needs to be a power of two. The name is only valid until this instance is destroyed,
+  // afterwards the memory stays mapped in the processes that have opened it.
+  [[nodiscard]] static ErrorMessageOr<SharedMemoryRingBuffer> Create(std::string_view name,
+                                                                     uint64_t capacity);
+  // Opens the shared memory object called `name`, created by another process with `Create`.
+  [[nodiscard]] static ErrorMessageOr<SharedMemoryRingBuffer> Open(std::string_view name);
+
+  SharedMemoryRingBuffer(const SharedMemoryRingBuffer&) = delete;
+  SharedMemoryRingBuffer& operator=(const SharedMemoryRingBuffer&) = delete;
+  SharedMemoryRingBuffer(SharedMemoryRingBuffer&& other);
+  SharedMemoryRingBuffer& operator=(SharedMemoryRingBuffer&& other);
+  ~SharedMemoryRingBuffer();
+
+  [[nodiscard]] const std::string& GetName() const { return name_; }
+  [[nodiscard]] uint64_t GetCapacity() const { return capacity_; }
+  // Larger records are always rejected by `TryReserveRecord`.
+  [[nodiscard]] uint64_t GetMaxRecordSize() const { return capacity_ / 2 - kRecordHeaderSize; }
+
+  // Producer side. Returns where to write a record of `size` bytes, or nullptr if there isn't
+  // enough free space. The record only becomes visible to the consumer with `CommitRecord`, and
+  // there can only be one reserved record at a time.
+  [[nodiscard]] char* TryReserveRecord(uint64_t size);
+  void CommitRecord();
+  // Producer side. Copies `record` to the buffer if there is enough free space.
+  [[nodiscard]] bool TryWriteRecord(absl::Span<const char> record);
+
+  // Consumer side. Calls `consumer` with each record committed so far, then releases their space
+  // at once. Returns the number of records read.
+  ErrorMessageOr<uint64_t> ReadRecords(
+      const std::function<void(absl::Span<const char>)>& consumer);
+
+ private:
+  struct Header;
+  static constexpr uint64_t kRecordHeaderSize = 8;
+  // The records start on the page following the header.
+  static constexpr uint64_t kDataOffset = 4096;
+
+  SharedMemoryRingBuffer(std::string name, void* mapping, uint64_t mapping_size, bool is_owner);
+  // Unmaps the memory and deletes the shared memory object if owned. Implemented in the platform
+  // specific source files, together with `Create` and `Open`.
+  void Release();
+
+  static void InitializeHeader(void* mapping, uint64_t capacity);
+  [[nodiscard]] static ErrorMessageOr<void> ValidateHeader(const void* mapping,
+                                                           uint64_t mapping_size);
+
+  std::string name_;
+  void* mapping_ = nullptr;
+  uint64_t mapping_size_ = 0;
+  // Whether this instance has created the shared memory object and needs to delete it.
+  bool is_owner_ = false;
+  // Only used on Windows: the file mapping object, which keeps the name valid while it's open.
+  void* handle_ = nullptr;
+  Header* header_ = nullptr;
+  char* data_ = nullptr;
+  uint64_t capacity_ = 0;
+
+  // Only used by the producer.
+  uint64_t cached_read_index_ = 0;
+  uint64_t reserved_write_index_ = 0;
+};
+
+}  // namespace orbit_base
+
+#endif  // ORBIT_BASE_SHARED_MEMORY_RING_BUFFER_H_
@@ -6,11 +6,12 @@
 #define ORBIT_BASE_SHARED_STATE_H_
 
 #include <absl/base/thread_annotations.h>
+#include <absl/container/inlined_vector.h>
 #include <absl/synchronization/mutex.h>
 
+#include <atomic>
 #include <optional>
 #include <variant>
-#include <vector>
 
 #include "OrbitBase/AnyInvocable.h"
 
@@ -19,24 +20,47 @@ namespace orbit_base_internal {
 // SharedState<T> is an implementation detail of the Future<T> / Promise<T> facility.
 //
 // Don't use this class outside of Promise<T> / Future<T>!
+//
+// Most futures get at most one continuation, which is stored inline. `is_finished` is set once the
+// result is set, after which the result doesn't change anymore. So a future that is already
+// completed can be checked for and read without taking `mutex`.
 template <typename T>
 struct SharedState {
   absl::Mutex mutex;
   std::optional<T> result ABSL_GUARDED_BY(mutex);
-  std::vector<orbit_base::AnyInvocable<void(const T&)>> continuations ABSL_GUARDED_BY(mutex);
+  absl::InlinedVector<orbit_base::AnyInvocable<void(const T&)>, 1> continuations
+      ABSL_GUARDED_BY(mutex);
+  std::atomic<bool> is_finished = false;
 
   [[nodiscard]] bool IsFinished() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
     return result.has_value();
   }
+  void MarkFinished() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    is_finished.store(true, std::memory_order_release);
+  }
+  [[nodiscard]] bool IsFinishedWithoutLock() const {
+    return is_finished.load(std::memory_order_acquire);
+  }
+  // Must only be called after IsFinishedWithoutLock() returned true.
+  [[nodiscard]] const T& GetFinishedResultWithoutLock() const ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    return result.value();
+  }
 };
 
 template <>
 struct SharedState<void> {
   absl::Mutex mutex;
   bool finished ABSL_GUARDED_BY(mutex) = false;
-  std::vector<orbit_base::AnyInvocable<void()>> continuations ABSL_GUARDED_BY(mutex);
+  absl::InlinedVector<orbit_base::AnyInvocable<void()>, 1> continuations ABSL_GUARDED_BY(mutex);
+  std::atomic<bool> is_finished = false;
 
   [[nodiscard]] bool IsFinished() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) { return finished; }
+  void MarkFinished() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    is_finished.store(true, std::memory_order_release);
+  }
+  [[nodiscard]] bool IsFinishedWithoutLock() const {
+    return is_finished.load(std::memory_order_acquire);
+  }
 };
 
 }  // namespace orbit_base_internal
@@ -0,0 +1,82 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_BASE_SPSC_RING_BUFFER_H_
+#define ORBIT_BASE_SPSC_RING_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_base {
+
+// A lock-free ring buffer of fixed capacity for exactly one producer thread and one consumer
+// thread. All the memory is allocated in the constructor, so pushing never allocates. When the
+// buffer is full, `TryPush` fails instead of blocking or overwriting, and it is up to the caller to
+// account for the lost element.
+//
+// `TryPush` and `HasFreeSlots` must only be called by the producer, `TryPopBulk` only by the
+// consumer. The read and the write index live on separate cache lines, and the producer caches the
+// read index, such that the two threads only share a cache line when the producer runs out of
+// free slots according to its cached value.
+template <typename T>
+class SpscRingBuffer {
+ public:
+  // `capacity` needs to be a power of two.
+  explicit SpscRingBuffer(size_t capacity)
+      : capacity_{capacity}, elements_{std::make_unique<T[]>(capacity)} {
+    ORBIT_CHECK(capacity > 0 && (capacity & (capacity - 1)) == 0);
+  }
+
+  [[nodiscard]] size_t GetCapacity() const { return capacity_; }
+
+  // Producer side. Returns whether at least `count` elements can be pushed. Elements popped
+  // concurrently might not be accounted for yet.
+  [[nodiscard]] bool HasFreeSlots(size_t count) {
+    const uint64_t write_index = write_index_.load(std::memory_order_relaxed);
+    if (capacity_ - (write_index - cached_read_index_) >= count) return true;
+    cached_read_index_ = read_index_.load(std::memory_order_acquire);
+    return capacity_ - (write_index - cached_read_index_) >= count;
+  }
+
+  // Producer side.
+  [[nodiscard]] bool TryPush(T&& element) {
+    if (!HasFreeSlots(1)) return false;
+    const uint64_t write_index = write_index_.load(std::memory_order_relaxed);
+    elements_[write_index & (capacity_ - 1)] = std::move(element);
+    write_index_.store(write_index + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Moves up to `max_count` elements to `output` and returns their number.
+  size_t TryPopBulk(T* output, size_t max_count) {
+    const uint64_t read_index = read_index_.load(std::memory_order_relaxed);
+    const uint64_t write_index = write_index_.load(std::memory_order_acquire);
+    const size_t count = std::min<uint64_t>(write_index - read_index, max_count);
+    for (size_t i = 0; i < count; ++i) {
+      output[i] = std::move(elements_[(read_index + i) & (capacity_ - 1)]);
+    }
+    read_index_.store(read_index + count, std::memory_order_release);
+    return count;
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  const size_t capacity_;
+  std::unique_ptr<T[]> elements_;
+  alignas(kCacheLineSize) std::atomic<uint64_t> write_index_ = 0;
+  uint64_t cached_read_index_ = 0;
+  alignas(kCacheLineSize) std::atomic<uint64_t> read_index_ = 0;
+};
+
+}  // namespace orbit_base
+
+#endif  // ORBIT_BASE_SPSC_RING_BUFFER_H_
@@ -0,0 +1,94 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_BASE_STATS_REGISTRY_H_
+#define ORBIT_BASE_STATS_REGISTRY_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace orbit_base {
+
+// This class is a registry of named counters and gauges, which components register while they run,
+// e.g., for the duration of a capture, so that their current values can be queried at any time from
+// another thread. The values are not stored in the registry: each stat is a function that is
+// only called when the stats are queried, so registering a stat costs nothing on the hot path of
+// the component, as long as the function only reads atomics or otherwise thread-safe state.
+//
+// Usage example:
+//
+// std::atomic<uint64_t> event_count = 0;
+// StatsRegistry::Registration registration = StatsRegistry::GetDefault().Register(
+//     "component.event_count", [&event_count] { return event_count.load(); });
+// ...
+// /* Unregisters the stat. From then on, the function is no longer called. */
+// registration.Reset();
+class StatsRegistry {
+ public:
+  using ValueFunction = std::function<uint64_t()>;
+
+  // Unregisters its stat when destroyed or reset, waiting for a concurrent query to complete, so
+  // that the captures of the function can be destroyed right after.
+  class Registration {
+   public:
+    Registration() = default;
+    Registration(const Registration&) = delete;
+    Registration& operator=(const Registration&) = delete;
+    Registration(Registration&& other) noexcept
+        : registry_{std::exchange(other.registry_, nullptr)}, id_{other.id_} {}
+    Registration& operator=(Registration&& other) noexcept {
+      if (this != &other) {
+        Reset();
+        registry_ = std::exchange(other.registry_, nullptr);
+        id_ = other.id_;
+      }
+      return *this;
+    }
+    ~Registration() { Reset(); }
+
+    void Reset();
+
+   private:
+    friend class StatsRegistry;
+    Registration(StatsRegistry* registry, uint64_t id) : registry_{registry}, id_{id} {}
+
+    StatsRegistry* registry_ = nullptr;
+    uint64_t id_ = 0;
+  };
+
+  struct Stat {
+    std::string name;
+    uint64_t value;
+  };
+
+  // The registry that OrbitService exposes with its ServiceStatsService.
+  [[nodiscard]] static StatsRegistry& GetDefault();
+
+  // Names don't need to be unique: a stat registered more than once, e.g., by two captures that
+  // overlap, is reported once per registration. `value_function` is called with the lock of the
+  // registry held, so it must not call into the registry.
+  [[nodiscard]] Registration Register(std::string name, ValueFunction value_function);
+
+  // Returns the current values of all the registered stats, sorted by name.
+  [[nodiscard]] std::vector<Stat> GetStats() const;
+
+ private:
+  void Unregister(uint64_t id);
+
+  mutable absl::Mutex mutex_;
+  uint64_t next_id_ ABSL_GUARDED_BY(mutex_) = 1;
+  absl::flat_hash_map<uint64_t, std::pair<std::string, ValueFunction>> stats_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace orbit_base
+
+#endif  // ORBIT_BASE_STATS_REGISTRY_H_
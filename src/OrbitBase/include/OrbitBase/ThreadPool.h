@@ -57,6 +57,9 @@ class ThreadPool : public orbit_base::Executor {
   //
   // Whenever an action is Scheduled the thread pool puts it in an internal
   // queue. Worker threads pick actions from the queue and execute them.
+  // Actions scheduled from a worker thread go to a queue of that worker, which
+  // runs the most recently scheduled of them first. Idle workers steal from
+  // the queues of busy ones.
   // If at the time of scheduling new action there are no idle worker threads,
   // the thread pool creates a new worker thread if current number of worker
   // threads is less than maximum pool size.
@@ -58,6 +58,10 @@ namespace orbit_base {
 void SetCurrentThreadName(const char* thread_name);
 [[nodiscard]] std::string GetThreadName(uint32_t tid);
 
+// Returns the CPU time, user and kernel, consumed so far by the calling thread. Only meaningful as
+// the difference between two calls on the same thread.
+[[nodiscard]] uint64_t GetCurrentThreadCpuTimeNs();
+
 // Platform-specific.
 #ifdef _WIN32
 [[nodiscard]] uint32_t GetCurrentThreadIdNative();
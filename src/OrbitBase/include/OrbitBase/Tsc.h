@@ -0,0 +1,59 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_BASE_TSC_H_
+#define ORBIT_BASE_TSC_H_
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <intrin.h>
+#elif defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace orbit_base {
+
+// Reading the time stamp counter is considerably cheaper than `CaptureTimestampNs`, which is what
+// event producers on a hot path can use instead, if they convert the raw values later with a
+// `TscConverter`. This is only meaningful if `HasInvariantTsc` returns true.
+[[nodiscard]] inline uint64_t ReadTsc() {
+#if defined(_WIN32) || defined(__x86_64__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// Returns whether the CPU has an invariant time stamp counter, i.e., one that ticks at a constant
+// rate regardless of frequency scaling and sleep states.
+[[nodiscard]] bool HasInvariantTsc();
+
+// Converts values of `ReadTsc` to the time domain of `CaptureTimestampNs`, based on a pair of
+// values of both clocks taken on creation. The frequency of the time stamp counter is measured only
+// once per process, which takes a few milliseconds on the first call to `Create`.
+class TscConverter {
+ public:
+  [[nodiscard]] static TscConverter Create();
+
+  [[nodiscard]] uint64_t ToCaptureTimestampNs(uint64_t tsc) const {
+    const auto ticks_since_reference = static_cast<int64_t>(tsc - reference_tsc_);
+    return reference_timestamp_ns_ +
+           static_cast<int64_t>(static_cast<double>(ticks_since_reference) * ns_per_tick_);
+  }
+
+ private:
+  TscConverter(uint64_t reference_tsc, uint64_t reference_timestamp_ns, double ns_per_tick)
+      : reference_tsc_{reference_tsc},
+        reference_timestamp_ns_{reference_timestamp_ns},
+        ns_per_tick_{ns_per_tick} {}
+
+  uint64_t reference_tsc_;
+  uint64_t reference_timestamp_ns_;
+  double ns_per_tick_;
+};
+
+}  // namespace orbit_base
+
+#endif  // ORBIT_BASE_TSC_H_
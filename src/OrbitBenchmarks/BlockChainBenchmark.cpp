@@ -0,0 +1,77 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "Containers/BlockChain.h"
+
+namespace {
+
+using orbit_containers::BlockChain;
+
+constexpr uint32_t kBlockSize = 1024;
+
+void BM_BlockChainEmplaceBack(benchmark::State& state) {
+  const auto item_count = static_cast<uint64_t>(state.range(0));
+  for (auto _ : state) {
+    BlockChain<uint64_t, kBlockSize> chain;
+    for (uint64_t i = 0; i < item_count; ++i) {
+      chain.emplace_back(i);
+    }
+    benchmark::DoNotOptimize(chain.size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * item_count));
+}
+BENCHMARK(BM_BlockChainEmplaceBack)->Arg(1'000)->Arg(1'000'000);
+
+// After clear(), the blocks are recycled instead of being allocated again.
+void BM_BlockChainEmplaceBackAfterClear(benchmark::State& state) {
+  const auto item_count = static_cast<uint64_t>(state.range(0));
+  BlockChain<uint64_t, kBlockSize> chain;
+  for (auto _ : state) {
+    chain.clear();
+    for (uint64_t i = 0; i < item_count; ++i) {
+      chain.emplace_back(i);
+    }
+    benchmark::DoNotOptimize(chain.size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * item_count));
+}
+BENCHMARK(BM_BlockChainEmplaceBackAfterClear)->Arg(1'000)->Arg(1'000'000);
+
+void BM_BlockChainEmplaceBackString(benchmark::State& state) {
+  const auto item_count = static_cast<uint64_t>(state.range(0));
+  const std::string value(64, 'x');
+  for (auto _ : state) {
+    BlockChain<std::string, kBlockSize> chain;
+    for (uint64_t i = 0; i < item_count; ++i) {
+      chain.emplace_back(value);
+    }
+    benchmark::DoNotOptimize(chain.size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * item_count));
+}
+BENCHMARK(BM_BlockChainEmplaceBackString)->Arg(100'000);
+
+void BM_BlockChainIterate(benchmark::State& state) {
+  const auto item_count = static_cast<uint64_t>(state.range(0));
+  BlockChain<uint64_t, kBlockSize> chain;
+  for (uint64_t i = 0; i < item_count; ++i) {
+    chain.emplace_back(i);
+  }
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (uint64_t value : chain) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * item_count));
+}
+BENCHMARK(BM_BlockChainIterate)->Arg(1'000'000);
+
+}  // namespace
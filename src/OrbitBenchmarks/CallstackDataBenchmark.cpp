@@ -0,0 +1,56 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "ClientData/CallstackData.h"
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/CallstackInfo.h"
+#include "ClientData/CallstackType.h"
+
+namespace {
+
+using orbit_client_data::CallstackData;
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CallstackInfo;
+using orbit_client_data::CallstackType;
+
+constexpr uint64_t kUniqueCallstackCount = 1024;
+
+void AddUniqueCallstacks(CallstackData* callstack_data) {
+  for (uint64_t callstack_id = 0; callstack_id < kUniqueCallstackCount; ++callstack_id) {
+    std::vector<uint64_t> frames;
+    for (uint64_t frame = 0; frame < 16; ++frame) {
+      frames.push_back(0x1000 * (frame + 1) + callstack_id);
+    }
+    callstack_data->AddUniqueCallstack(callstack_id,
+                                       CallstackInfo{std::move(frames), CallstackType::kComplete});
+  }
+}
+
+// Samples from `state.range(0)` threads, interleaved, as from sampling all cores.
+void BM_CallstackDataAddCallstackEvent(benchmark::State& state) {
+  constexpr uint64_t kEventCount = 100'000;
+  const auto thread_count = static_cast<uint32_t>(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    CallstackData callstack_data;
+    AddUniqueCallstacks(&callstack_data);
+    state.ResumeTiming();
+    for (uint64_t i = 0; i < kEventCount; ++i) {
+      callstack_data.AddCallstackEvent(CallstackEvent{
+          /*timestamp_ns=*/i * 1000, /*callstack_id=*/i % kUniqueCallstackCount,
+          /*thread_id=*/static_cast<uint32_t>(i % thread_count) + 1});
+    }
+    benchmark::DoNotOptimize(callstack_data.GetCallstackEventsCount());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEventCount));
+}
+BENCHMARK(BM_CallstackDataAddCallstackEvent)->Arg(1)->Arg(64);
+
+}  // namespace
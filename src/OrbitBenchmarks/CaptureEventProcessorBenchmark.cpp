@@ -0,0 +1,192 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/container/flat_hash_set.h>
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "CaptureClient/CaptureEventProcessor.h"
+#include "CaptureClient/CaptureListener.h"
+#include "ClientData/ApiStringEvent.h"
+#include "ClientData/ApiTrackValue.h"
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/CallstackInfo.h"
+#include "ClientData/CgroupAndProcessMemoryInfo.h"
+#include "ClientData/LinuxAddressInfo.h"
+#include "ClientData/PageFaultsInfo.h"
+#include "ClientData/SystemMemoryInfo.h"
+#include "ClientData/ThreadStateSliceInfo.h"
+#include "ClientData/TracepointEventInfo.h"
+#include "ClientData/TracepointInfo.h"
+#include "ClientProtos/capture_data.pb.h"
+#include "GrpcProtos/capture.pb.h"
+#include "GrpcProtos/module.pb.h"
+
+namespace {
+
+using orbit_capture_client::CaptureEventProcessor;
+using orbit_capture_client::CaptureListener;
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CallstackInfo;
+using orbit_client_data::LinuxAddressInfo;
+using orbit_client_protos::TimerInfo;
+using orbit_grpc_protos::Callstack;
+using orbit_grpc_protos::CallstackSample;
+using orbit_grpc_protos::ClientCaptureEvent;
+using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::InternedCallstack;
+using orbit_grpc_protos::SchedulingSlice;
+
+constexpr uint64_t kEventCount = 100'000;
+constexpr uint64_t kUniqueCallstackCount = 1024;
+
+class NullCaptureListener : public CaptureListener {
+ public:
+  void OnCaptureStarted(const orbit_grpc_protos::CaptureStarted& /*capture_started*/,
+                        std::optional<std::filesystem::path> /*file_path*/,
+                        absl::flat_hash_set<uint64_t> /*frame_track_function_ids*/) override {}
+  void OnCaptureFinished(const orbit_grpc_protos::CaptureFinished& /*capture_finished*/) override {}
+  void OnTimer(const TimerInfo& /*timer_info*/) override {}
+  void OnCgroupAndProcessMemoryInfo(const orbit_client_data::CgroupAndProcessMemoryInfo&
+                                    /*cgroup_and_process_memory_info*/) override {}
+  void OnPageFaultsInfo(const orbit_client_data::PageFaultsInfo& /*page_faults_info*/) override {}
+  void OnSystemMemoryInfo(
+      const orbit_client_data::SystemMemoryInfo& /*system_memory_info*/) override {}
+  void OnKeyAndString(uint64_t /*key*/, std::string /*str*/) override {}
+  void OnUniqueCallstack(uint64_t /*callstack_id*/, CallstackInfo /*callstack*/) override {}
+  void OnCallstackEvent(CallstackEvent /*callstack_event*/) override {}
+  void OnPageFaultCallstackEvent(CallstackEvent /*callstack_event*/) override {}
+  void OnThreadName(uint32_t /*thread_id*/, std::string /*thread_name*/) override {}
+  void OnThreadStateSlice(orbit_client_data::ThreadStateSliceInfo /*thread_state_slice*/) override {
+  }
+  void OnOffCpuTimeSummary(
+      const orbit_grpc_protos::OffCpuTimeSummary& /*off_cpu_time_summary*/) override {}
+  void OnAddressInfo(LinuxAddressInfo /*address_info*/) override {}
+  void OnUniqueTracepointInfo(uint64_t /*tracepoint_id*/,
+                              orbit_client_data::TracepointInfo /*tracepoint_info*/) override {}
+  void OnTracepointEvent(
+      orbit_client_data::TracepointEventInfo /*tracepoint_event_info*/) override {}
+  void OnModuleUpdate(uint64_t /*timestamp_ns*/,
+                      orbit_grpc_protos::ModuleInfo /*module_info*/) override {}
+  void OnModulesSnapshot(uint64_t /*timestamp_ns*/,
+                         std::vector<orbit_grpc_protos::ModuleInfo> /*module_infos*/) override {}
+  void OnPresentEvent(const orbit_grpc_protos::PresentEvent& /*present_event*/) override {}
+  void OnPressureStallEvent(
+      const orbit_grpc_protos::PressureStallEvent& /*pressure_stall_event*/) override {}
+  void OnPerformanceCounterSample(
+      const orbit_grpc_protos::PerformanceCounterSample& /*performance_counter_sample*/) override {}
+  void OnApiStringEvent(const orbit_client_data::ApiStringEvent& /*api_string_event*/) override {}
+  void OnApiTrackValue(const orbit_client_data::ApiTrackValue& /*api_track_value*/) override {}
+  void OnWarningEvent(orbit_grpc_protos::WarningEvent /*warning_event*/) override {}
+  void OnClockResolutionEvent(
+      orbit_grpc_protos::ClockResolutionEvent /*clock_resolution_event*/) override {}
+  void OnErrorsWithPerfEventOpenEvent(
+      orbit_grpc_protos::ErrorsWithPerfEventOpenEvent /*errors_with_perf_event_open_event*/)
+      override {}
+  void OnWarningInstrumentingWithUprobesEvent(
+      orbit_grpc_protos::WarningInstrumentingWithUprobesEvent
+      /*warning_instrumenting_with_uprobes_event*/) override {}
+  void OnErrorEnablingOrbitApiEvent(
+      orbit_grpc_protos::ErrorEnablingOrbitApiEvent /*error_enabling_orbit_api_event*/) override {}
+  void OnErrorEnablingUserSpaceInstrumentationEvent(
+      orbit_grpc_protos::ErrorEnablingUserSpaceInstrumentationEvent /*error_event*/) override {}
+  void OnWarningInstrumentingWithUserSpaceInstrumentationEvent(
+      orbit_grpc_protos::WarningInstrumentingWithUserSpaceInstrumentationEvent /*warning_event*/)
+      override {}
+  void OnLostPerfRecordsEvent(
+      orbit_grpc_protos::LostPerfRecordsEvent /*lost_perf_records_event*/) override {}
+  void OnOutOfOrderEventsDiscardedEvent(orbit_grpc_protos::OutOfOrderEventsDiscardedEvent
+                                        /*out_of_order_events_discarded_event*/) override {}
+  void OnPerfEventProcessingStatsEvent(orbit_grpc_protos::PerfEventProcessingStatsEvent
+                                       /*perf_event_processing_stats_event*/) override {}
+};
+
+[[nodiscard]] std::unique_ptr<CaptureEventProcessor> CreateCaptureEventProcessor(
+    CaptureListener* capture_listener) {
+  return CaptureEventProcessor::CreateForCaptureListener(capture_listener, std::filesystem::path{},
+                                                         {});
+}
+
+// Processes `events` with a new CaptureEventProcessor per iteration, after `setup_events`, which
+// are processed outside of the timed region.
+void RunCaptureEventProcessorBenchmark(benchmark::State& state,
+                                       const std::vector<ClientCaptureEvent>& setup_events,
+                                       const std::vector<ClientCaptureEvent>& events) {
+  NullCaptureListener listener;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<CaptureEventProcessor> capture_event_processor =
+        CreateCaptureEventProcessor(&listener);
+    for (const ClientCaptureEvent& event : setup_events) {
+      capture_event_processor->ProcessEvent(event);
+    }
+    state.ResumeTiming();
+    for (const ClientCaptureEvent& event : events) {
+      capture_event_processor->ProcessEvent(event);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * events.size()));
+}
+
+void BM_CaptureEventProcessorSchedulingSlice(benchmark::State& state) {
+  std::vector<ClientCaptureEvent> events(kEventCount);
+  for (uint64_t i = 0; i < kEventCount; ++i) {
+    SchedulingSlice* scheduling_slice = events[i].mutable_scheduling_slice();
+    scheduling_slice->set_pid(42);
+    scheduling_slice->set_tid(static_cast<uint32_t>(42 + i % 64));
+    scheduling_slice->set_core(static_cast<uint32_t>(i % 16));
+    scheduling_slice->set_duration_ns(500);
+    scheduling_slice->set_out_timestamp_ns(1000 * (i + 1));
+  }
+  RunCaptureEventProcessorBenchmark(state, {}, events);
+}
+BENCHMARK(BM_CaptureEventProcessorSchedulingSlice);
+
+void BM_CaptureEventProcessorFunctionCall(benchmark::State& state) {
+  std::vector<ClientCaptureEvent> events(kEventCount);
+  for (uint64_t i = 0; i < kEventCount; ++i) {
+    FunctionCall* function_call = events[i].mutable_function_call();
+    function_call->set_pid(42);
+    function_call->set_tid(static_cast<uint32_t>(42 + i % 64));
+    function_call->set_function_id(i % 128 + 1);
+    function_call->set_duration_ns(500);
+    function_call->set_end_timestamp_ns(1000 * (i + 1));
+    function_call->set_depth(static_cast<int32_t>(i % 8));
+  }
+  RunCaptureEventProcessorBenchmark(state, {}, events);
+}
+BENCHMARK(BM_CaptureEventProcessorFunctionCall);
+
+void BM_CaptureEventProcessorCallstackSample(benchmark::State& state) {
+  std::vector<ClientCaptureEvent> interned_callstack_events(kUniqueCallstackCount);
+  for (uint64_t callstack_id = 0; callstack_id < kUniqueCallstackCount; ++callstack_id) {
+    InternedCallstack* interned_callstack =
+        interned_callstack_events[callstack_id].mutable_interned_callstack();
+    interned_callstack->set_key(callstack_id + 1);
+    Callstack* callstack = interned_callstack->mutable_intern();
+    callstack->set_type(Callstack::kComplete);
+    for (uint64_t frame = 0; frame < 16; ++frame) {
+      callstack->add_pcs(0x1000 * (frame + 1) + callstack_id);
+    }
+  }
+
+  std::vector<ClientCaptureEvent> events(kEventCount);
+  for (uint64_t i = 0; i < kEventCount; ++i) {
+    CallstackSample* callstack_sample = events[i].mutable_callstack_sample();
+    callstack_sample->set_pid(42);
+    callstack_sample->set_tid(static_cast<uint32_t>(42 + i % 64));
+    callstack_sample->set_callstack_id(i % kUniqueCallstackCount + 1);
+    callstack_sample->set_timestamp_ns(1000 * (i + 1));
+  }
+  RunCaptureEventProcessorBenchmark(state, interned_callstack_events, events);
+}
+BENCHMARK(BM_CaptureEventProcessorCallstackSample);
+
+}  // namespace
@@ -0,0 +1,68 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "CaptureFile/BufferOutputStream.h"
+#include "CaptureFile/CaptureFileOutputStream.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Result.h"
+
+namespace {
+
+using orbit_capture_file::BufferOutputStream;
+using orbit_capture_file::CaptureFileOutputStream;
+using orbit_grpc_protos::CallstackSample;
+using orbit_grpc_protos::ClientCaptureEvent;
+using orbit_grpc_protos::FunctionCall;
+
+constexpr uint64_t kEventCount = 100'000;
+
+// Writes a mix of callstack samples and function calls into memory, which isolates the
+// serialization from the file system.
+void BM_CaptureFileOutputStreamWriteCaptureEvent(benchmark::State& state) {
+  std::vector<ClientCaptureEvent> events(kEventCount);
+  for (uint64_t i = 0; i < kEventCount; ++i) {
+    if (i % 2 == 0) {
+      CallstackSample* callstack_sample = events[i].mutable_callstack_sample();
+      callstack_sample->set_pid(42);
+      callstack_sample->set_tid(static_cast<uint32_t>(42 + i % 64));
+      callstack_sample->set_callstack_id(i % 1024 + 1);
+      callstack_sample->set_timestamp_ns(1000 * (i + 1));
+    } else {
+      FunctionCall* function_call = events[i].mutable_function_call();
+      function_call->set_pid(42);
+      function_call->set_tid(static_cast<uint32_t>(42 + i % 64));
+      function_call->set_function_id(i % 128 + 1);
+      function_call->set_duration_ns(500);
+      function_call->set_end_timestamp_ns(1000 * (i + 1));
+      function_call->set_depth(static_cast<int32_t>(i % 8));
+    }
+  }
+
+  int64_t bytes_written = 0;
+  for (auto _ : state) {
+    BufferOutputStream buffer_output_stream;
+    std::unique_ptr<CaptureFileOutputStream> output_stream =
+        CaptureFileOutputStream::Create(&buffer_output_stream);
+    for (const ClientCaptureEvent& event : events) {
+      ErrorMessageOr<void> result = output_stream->WriteCaptureEvent(event);
+      ORBIT_CHECK(!result.has_error());
+    }
+    ORBIT_CHECK(!output_stream->Close().has_error());
+    state.PauseTiming();
+    bytes_written += static_cast<int64_t>(buffer_output_stream.TakeBuffer().size());
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEventCount));
+  state.SetBytesProcessed(bytes_written);
+}
+BENCHMARK(BM_CaptureFileOutputStreamWriteCaptureEvent);
+
+}  // namespace
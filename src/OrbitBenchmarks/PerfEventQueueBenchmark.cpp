@@ -0,0 +1,84 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "PerfEvent.h"
+#include "PerfEventOrderedStream.h"
+#include "PerfEventQueue.h"
+
+namespace {
+
+using orbit_linux_tracing::ForkPerfEvent;
+using orbit_linux_tracing::PerfEventOrderedStream;
+using orbit_linux_tracing::PerfEventQueue;
+
+// Returns pairs of thread id and timestamp, in runs of up to `max_run_length` consecutive events
+// from the same thread.
+[[nodiscard]] std::vector<std::pair<pid_t, uint64_t>> GenerateEvents(pid_t thread_count,
+                                                                     uint64_t max_run_length,
+                                                                     size_t event_count) {
+  std::mt19937 random_engine{42};
+  std::uniform_int_distribution<pid_t> tid_distribution{1, thread_count};
+  std::uniform_int_distribution<uint64_t> run_length_distribution{1, max_run_length};
+  std::vector<std::pair<pid_t, uint64_t>> events;
+  events.reserve(event_count);
+  uint64_t timestamp_ns = 1;
+  while (events.size() < event_count) {
+    const pid_t tid = tid_distribution(random_engine);
+    const uint64_t run_length = run_length_distribution(random_engine);
+    for (uint64_t i = 0; i < run_length && events.size() < event_count; ++i) {
+      events.emplace_back(tid, timestamp_ns++);
+    }
+  }
+  return events;
+}
+
+// Pushes and pops events in batches, like PerfEventProcessor does, keeping half a batch in the
+// queue like the events that are more recent than the processing delay.
+void BM_PerfEventQueuePushAndPop(benchmark::State& state) {
+  constexpr size_t kEventCount = 200'000;
+  constexpr size_t kBatchSize = 10'000;
+  const std::vector<std::pair<pid_t, uint64_t>> events = GenerateEvents(
+      static_cast<pid_t>(state.range(0)), static_cast<uint64_t>(state.range(1)), kEventCount);
+  for (auto _ : state) {
+    PerfEventQueue queue;
+    uint64_t checksum = 0;
+    for (size_t batch_begin = 0; batch_begin < events.size(); batch_begin += kBatchSize) {
+      const size_t batch_end = std::min(batch_begin + kBatchSize, events.size());
+      for (size_t i = batch_begin; i < batch_end; ++i) {
+        queue.PushEvent(ForkPerfEvent{
+            .timestamp = events[i].second,
+            .ordered_stream = PerfEventOrderedStream::ThreadId(events[i].first),
+        });
+      }
+      const uint64_t pop_before_timestamp_ns = events[batch_end - 1].second - kBatchSize / 2;
+      while (queue.HasEvent() && queue.TopEvent().timestamp < pop_before_timestamp_ns) {
+        checksum += queue.TopEvent().timestamp;
+        queue.PopEvent();
+      }
+    }
+    while (queue.HasEvent()) {
+      checksum += queue.TopEvent().timestamp;
+      queue.PopEvent();
+    }
+    benchmark::DoNotOptimize(checksum);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEventCount));
+}
+BENCHMARK(BM_PerfEventQueuePushAndPop)
+    ->ArgNames({"threads", "max_run"})
+    ->Args({16, 1})
+    ->Args({256, 8})
+    ->Args({4096, 64});
+
+}  // namespace
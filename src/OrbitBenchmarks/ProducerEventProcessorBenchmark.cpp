@@ -0,0 +1,89 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+#include "ProducerEventProcessor/ClientCaptureEventCollector.h"
+#include "ProducerEventProcessor/ProducerEventProcessor.h"
+
+namespace {
+
+using orbit_grpc_protos::Callstack;
+using orbit_grpc_protos::ClientCaptureEvent;
+using orbit_grpc_protos::FullCallstackSample;
+using orbit_grpc_protos::ProducerCaptureEvent;
+using orbit_grpc_protos::SchedulingSlice;
+using orbit_producer_event_processor::ClientCaptureEventCollector;
+using orbit_producer_event_processor::ProducerEventProcessor;
+
+constexpr uint64_t kProducerId = 1;
+constexpr uint64_t kEventCount = 100'000;
+
+class NullClientCaptureEventCollector : public ClientCaptureEventCollector {
+ public:
+  void AddEvent(ClientCaptureEvent&& event) override { benchmark::DoNotOptimize(event); }
+  void StopAndWait() override {}
+};
+
+// Processes the events returned by `create_events`, which is called outside of the timed region.
+template <typename CreateEvents>
+void RunProducerEventProcessorBenchmark(benchmark::State& state, CreateEvents create_events) {
+  NullClientCaptureEventCollector collector;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<ProducerEventProcessor> producer_event_processor =
+        ProducerEventProcessor::Create(&collector);
+    std::vector<ProducerCaptureEvent> events = create_events();
+    state.ResumeTiming();
+    for (ProducerCaptureEvent& event : events) {
+      producer_event_processor->ProcessEvent(kProducerId, std::move(event));
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kEventCount));
+}
+
+void BM_ProducerEventProcessorSchedulingSlice(benchmark::State& state) {
+  RunProducerEventProcessorBenchmark(state, [] {
+    std::vector<ProducerCaptureEvent> events(kEventCount);
+    for (uint64_t i = 0; i < kEventCount; ++i) {
+      SchedulingSlice* scheduling_slice = events[i].mutable_scheduling_slice();
+      scheduling_slice->set_pid(42);
+      scheduling_slice->set_tid(static_cast<uint32_t>(42 + i % 64));
+      scheduling_slice->set_core(static_cast<uint32_t>(i % 16));
+      scheduling_slice->set_duration_ns(500);
+      scheduling_slice->set_out_timestamp_ns(1000 * (i + 1));
+    }
+    return events;
+  });
+}
+BENCHMARK(BM_ProducerEventProcessorSchedulingSlice);
+
+// Full callstacks out of `state.range(0)` distinct ones, which ProducerEventProcessor interns.
+void BM_ProducerEventProcessorFullCallstackSample(benchmark::State& state) {
+  const auto unique_callstack_count = static_cast<uint64_t>(state.range(0));
+  RunProducerEventProcessorBenchmark(state, [unique_callstack_count] {
+    std::vector<ProducerCaptureEvent> events(kEventCount);
+    for (uint64_t i = 0; i < kEventCount; ++i) {
+      FullCallstackSample* callstack_sample = events[i].mutable_full_callstack_sample();
+      callstack_sample->set_pid(42);
+      callstack_sample->set_tid(static_cast<uint32_t>(42 + i % 64));
+      callstack_sample->set_timestamp_ns(1000 * (i + 1));
+      Callstack* callstack = callstack_sample->mutable_callstack();
+      callstack->set_type(Callstack::kComplete);
+      for (uint64_t frame = 0; frame < 16; ++frame) {
+        callstack->add_pcs(0x1000 * (frame + 1) + i % unique_callstack_count);
+      }
+    }
+    return events;
+  });
+}
+BENCHMARK(BM_ProducerEventProcessorFullCallstackSample)->Arg(16)->Arg(4096);
+
+}  // namespace
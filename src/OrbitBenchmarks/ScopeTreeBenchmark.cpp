@@ -0,0 +1,100 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Containers/ScopeTree.h"
+
+namespace {
+
+using orbit_containers::ScopeTree;
+
+struct Scope {
+  [[nodiscard]] uint64_t start() const { return start_ns; }
+  [[nodiscard]] uint64_t end() const { return end_ns; }
+  uint64_t start_ns;
+  uint64_t end_ns;
+};
+
+// Appends `sibling_count` consecutive scopes per level, each containing the scopes of the next
+// level, up to `max_depth` levels: the shape of the call tree of an instrumented thread.
+void AppendNestedScopes(uint64_t start_ns, uint64_t end_ns, size_t depth, size_t max_depth,
+                        size_t sibling_count, std::vector<Scope>* scopes) {
+  if (depth == max_depth) return;
+  const uint64_t sibling_duration_ns = (end_ns - start_ns) / sibling_count;
+  for (size_t i = 0; i < sibling_count; ++i) {
+    // Leave a gap between siblings, so that no two scopes share start or end.
+    const uint64_t sibling_start_ns = start_ns + i * sibling_duration_ns + 1;
+    const uint64_t sibling_end_ns = sibling_start_ns + sibling_duration_ns - 2;
+    scopes->push_back(Scope{sibling_start_ns, sibling_end_ns});
+    AppendNestedScopes(sibling_start_ns, sibling_end_ns, depth + 1, max_depth, sibling_count,
+                       scopes);
+  }
+}
+
+[[nodiscard]] std::vector<Scope> CreateNestedScopes(size_t max_depth, size_t sibling_count) {
+  std::vector<Scope> scopes;
+  AppendNestedScopes(0, 1'000'000'000'000, 0, max_depth, sibling_count, &scopes);
+  return scopes;
+}
+
+// Scopes are inserted in the order in which they end, like timers arrive during a capture.
+void BM_ScopeTreeInsertInOrderOfEnd(benchmark::State& state) {
+  std::vector<Scope> scopes = CreateNestedScopes(static_cast<size_t>(state.range(0)),
+                                                 static_cast<size_t>(state.range(1)));
+  std::sort(scopes.begin(), scopes.end(),
+            [](const Scope& lhs, const Scope& rhs) { return lhs.end_ns < rhs.end_ns; });
+  for (auto _ : state) {
+    ScopeTree<Scope> tree;
+    for (Scope& scope : scopes) {
+      tree.Insert(&scope);
+    }
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * scopes.size()));
+}
+BENCHMARK(BM_ScopeTreeInsertInOrderOfEnd)->Args({4, 16})->Args({10, 3});
+
+// Scopes from different threads are merged, so they are not always inserted in order.
+void BM_ScopeTreeInsertShuffled(benchmark::State& state) {
+  std::vector<Scope> scopes = CreateNestedScopes(static_cast<size_t>(state.range(0)),
+                                                 static_cast<size_t>(state.range(1)));
+  std::shuffle(scopes.begin(), scopes.end(), std::mt19937{42});
+  for (auto _ : state) {
+    ScopeTree<Scope> tree;
+    for (Scope& scope : scopes) {
+      tree.Insert(&scope);
+    }
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * scopes.size()));
+}
+BENCHMARK(BM_ScopeTreeInsertShuffled)->Args({4, 16})->Args({10, 3});
+
+// All scopes are known upfront when a capture is loaded.
+void BM_ScopeTreeBuild(benchmark::State& state) {
+  std::vector<Scope> scopes = CreateNestedScopes(static_cast<size_t>(state.range(0)),
+                                                 static_cast<size_t>(state.range(1)));
+  std::sort(scopes.begin(), scopes.end(),
+            [](const Scope& lhs, const Scope& rhs) { return lhs.end_ns < rhs.end_ns; });
+  std::vector<Scope*> scope_pointers;
+  for (Scope& scope : scopes) {
+    scope_pointers.push_back(&scope);
+  }
+  for (auto _ : state) {
+    ScopeTree<Scope> tree;
+    tree.Build(scope_pointers);
+    benchmark::DoNotOptimize(tree.Size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * scopes.size()));
+}
+BENCHMARK(BM_ScopeTreeBuild)->Args({4, 16})->Args({10, 3});
+
+}  // namespace
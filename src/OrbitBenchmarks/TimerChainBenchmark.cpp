@@ -0,0 +1,92 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "ClientData/CompactTimerBlock.h"
+#include "ClientData/TimerChain.h"
+#include "ClientProtos/capture_data.pb.h"
+
+namespace {
+
+using orbit_client_data::CompactTimerBlock;
+using orbit_client_data::TimerBlock;
+using orbit_client_data::TimerChain;
+using orbit_client_protos::TimerInfo;
+
+[[nodiscard]] TimerInfo MakeTimer(uint64_t index) {
+  TimerInfo timer;
+  timer.set_start(index * 100);
+  timer.set_end(index * 100 + 50);
+  timer.set_thread_id(42);
+  timer.set_function_id(index % 16);
+  return timer;
+}
+
+void BM_TimerChainEmplaceBack(benchmark::State& state) {
+  const auto timer_count = static_cast<uint64_t>(state.range(0));
+  const TimerInfo timer = MakeTimer(1);
+  for (auto _ : state) {
+    TimerChain chain;
+    for (uint64_t i = 0; i < timer_count; ++i) {
+      chain.emplace_back(timer);
+    }
+    benchmark::DoNotOptimize(chain.size());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * timer_count));
+}
+BENCHMARK(BM_TimerChainEmplaceBack)->Arg(1'000)->Arg(100'000);
+
+// Like rendering does, visits the blocks that intersect a time range, then the timers in them.
+void BM_TimerChainIterateRange(benchmark::State& state) {
+  constexpr uint64_t kTimerCount = 1'000'000;
+  TimerChain chain;
+  for (uint64_t i = 0; i < kTimerCount; ++i) {
+    chain.emplace_back(MakeTimer(i));
+  }
+  // The middle tenth of the capture.
+  const uint64_t min_ns = kTimerCount * 100 * 9 / 20;
+  const uint64_t max_ns = kTimerCount * 100 * 11 / 20;
+  for (auto _ : state) {
+    uint64_t visible_timer_count = 0;
+    for (const TimerBlock& block : chain) {
+      if (!block.Intersects(min_ns, max_ns)) continue;
+      for (size_t i = 0; i < block.size(); ++i) {
+        const TimerInfo& timer = block[i];
+        visible_timer_count += timer.start() <= max_ns && timer.end() >= min_ns;
+      }
+    }
+    benchmark::DoNotOptimize(visible_timer_count);
+  }
+}
+BENCHMARK(BM_TimerChainIterateRange);
+
+// Same as BM_TimerChainIterateRange, but reading the columns of CompactTimerBlocks.
+void BM_CompactTimerBlocksIterateRange(benchmark::State& state) {
+  constexpr uint64_t kTimerCount = 1'000'000;
+  std::vector<CompactTimerBlock> blocks(1);
+  for (uint64_t i = 0; i < kTimerCount; ++i) {
+    if (blocks.back().at_capacity()) blocks.emplace_back();
+    blocks.back().Add(MakeTimer(i));
+  }
+  const uint64_t min_ns = kTimerCount * 100 * 9 / 20;
+  const uint64_t max_ns = kTimerCount * 100 * 11 / 20;
+  for (auto _ : state) {
+    uint64_t visible_timer_count = 0;
+    for (const CompactTimerBlock& block : blocks) {
+      if (!block.Intersects(min_ns, max_ns)) continue;
+      for (size_t i = 0; i < block.size(); ++i) {
+        visible_timer_count += block.GetStart(i) <= max_ns && block.GetEnd(i) >= min_ns;
+      }
+    }
+    benchmark::DoNotOptimize(visible_timer_count);
+  }
+}
+BENCHMARK(BM_CompactTimerBlocksIterateRange);
+
+}  // namespace
@@ -34,6 +34,12 @@ ABSL_FLAG(bool, frame_pointer_unwinding, false, "Use frame pointers for unwindin
 ABSL_FLAG(bool, thread_state, false, "Collect thread states");
 ABSL_FLAG(uint64_t, max_local_marker_depth_per_command_buffer, std::numeric_limits<uint64_t>::max(),
           "Max local marker depth per command buffer");
+ABSL_FLAG(bool, save_capture_on_service, false,
+          "Let OrbitService write the capture file directly, so that only a preview of the capture "
+          "is streamed to this service. The preview is saved next to the capture file.");
+ABSL_FLAG(uint64_t, flight_recorder_ms, 0,
+          "Only keep the events of the last this many milliseconds before the capture is stopped "
+          "(0: disabled)");
 
 namespace {
 
@@ -0,0 +1,72 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitClientGgp/CaptureAlignment.h"
+
+#include <absl/strings/str_format.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CaptureFile/CaptureFile.h"
+#include "CaptureFile/ProtoSectionInputStream.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Result.h"
+#include "OrbitClientGgp/CaptureAnalyzer.h"
+
+namespace orbit_client_ggp {
+
+ErrorMessageOr<CaptureClock> ReadCaptureClock(const std::filesystem::path& capture_file_path) {
+  OUTCOME_TRY(std::unique_ptr<orbit_capture_file::CaptureFile> capture_file,
+              orbit_capture_file::CaptureFile::OpenForReadWrite(capture_file_path));
+  std::unique_ptr<orbit_capture_file::ProtoSectionInputStream> input_stream =
+      capture_file->CreateCaptureSectionInputStream();
+
+  orbit_grpc_protos::ClientCaptureEvent event;
+  OUTCOME_TRY(input_stream->ReadMessage(&event));
+  if (!event.has_capture_started()) {
+    return ErrorMessage{absl::StrFormat("Capture \"%s\" doesn't start with CaptureStarted",
+                                        capture_file_path.string())};
+  }
+  return CaptureClock{capture_file_path, event.capture_started().capture_start_timestamp_ns(),
+                      event.capture_started().capture_start_unix_time_ns()};
+}
+
+std::vector<int64_t> ComputeCaptureTimestampOffsets(absl::Span<const CaptureClock> capture_clocks) {
+  std::vector<int64_t> offsets;
+  if (capture_clocks.empty()) return offsets;
+
+  // The difference between the wall-clock time and the timestamps of a capture is the same for all
+  // its events, so the offset between two captures is the difference of theirs.
+  auto wall_clock_minus_timestamp = [](const CaptureClock& clock) {
+    return static_cast<int64_t>(clock.capture_start_unix_time_ns) -
+           static_cast<int64_t>(clock.capture_start_timestamp_ns);
+  };
+  const int64_t reference = wall_clock_minus_timestamp(capture_clocks.front());
+  offsets.reserve(capture_clocks.size());
+  for (const CaptureClock& clock : capture_clocks) {
+    offsets.push_back(wall_clock_minus_timestamp(clock) - reference);
+  }
+  return offsets;
+}
+
+std::string FormatCaptureAlignmentAsJson(absl::Span<const CaptureClock> capture_clocks) {
+  const std::vector<int64_t> offsets = ComputeCaptureTimestampOffsets(capture_clocks);
+  std::string json = "[";
+  for (size_t i = 0; i < capture_clocks.size(); ++i) {
+    const CaptureClock& clock = capture_clocks[i];
+    json.append(i == 0 ? "\n" : ",\n");
+    json.append("{\"file_path\":");
+    AppendJsonString(&json, clock.file_path.string());
+    json.append(absl::StrFormat(
+        R"(,"capture_start_timestamp_ns":%u,"capture_start_unix_time_ns":%u,)"
+        R"("timestamp_offset_ns":%d})",
+        clock.capture_start_timestamp_ns, clock.capture_start_unix_time_ns, offsets[i]));
+  }
+  json.append("\n]\n");
+  return json;
+}
+
+}  // namespace orbit_client_ggp
@@ -0,0 +1,46 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "OrbitClientGgp/CaptureAlignment.h"
+
+namespace orbit_client_ggp {
+
+TEST(CaptureAlignment, ComputeCaptureTimestampOffsetsOfNoCaptures) {
+  EXPECT_TRUE(ComputeCaptureTimestampOffsets({}).empty());
+}
+
+TEST(CaptureAlignment, ComputeCaptureTimestampOffsetsRelativeToTheFirstCapture) {
+  // The second machine booted 500s before the first one and started capturing 2ms later, the third
+  // one booted 100s after it and started capturing 1ms earlier.
+  const std::vector<CaptureClock> capture_clocks = {
+      {"first.orbit", 1'000'000'000'000, 1'600'000'000'000'000'000},
+      {"second.orbit", 1'500'002'000'000, 1'600'000'000'002'000'000},
+      {"third.orbit", 899'999'000'000, 1'600'000'000'000'000'000 - 1'000'000}};
+
+  EXPECT_THAT(ComputeCaptureTimestampOffsets(capture_clocks),
+              testing::ElementsAre(0, -500'000'000'000, 100'000'000'000));
+}
+
+TEST(CaptureAlignment, FormatCaptureAlignmentAsJson) {
+  const std::vector<CaptureClock> capture_clocks = {{"first.orbit", 1000, 5000},
+                                                    {"second \"host\".orbit", 3000, 5500}};
+
+  EXPECT_EQ(FormatCaptureAlignmentAsJson(capture_clocks),
+            "[\n"
+            R"({"file_path":"first.orbit","capture_start_timestamp_ns":1000,)"
+            R"("capture_start_unix_time_ns":5000,"timestamp_offset_ns":0},)"
+            "\n"
+            R"({"file_path":"second \"host\".orbit","capture_start_timestamp_ns":3000,)"
+            R"("capture_start_unix_time_ns":5500,"timestamp_offset_ns":-1500})"
+            "\n]\n");
+}
+
+}  // namespace orbit_client_ggp
@@ -0,0 +1,447 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitClientGgp/CaptureAnalyzer.h"
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/str_format.h>
+#include <absl/types/span.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CaptureClient/AbstractCaptureListener.h"
+#include "CaptureClient/CaptureListener.h"
+#include "CaptureClient/LoadCapture.h"
+#include "CaptureFile/CaptureFile.h"
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/CaptureData.h"
+#include "ClientData/CaptureDataHolder.h"
+#include "ClientData/ModuleIdentifierProvider.h"
+#include "ClientData/ModuleManager.h"
+#include "ClientData/PostProcessedSamplingData.h"
+#include "ClientData/ScopeId.h"
+#include "ClientData/ScopeInfo.h"
+#include "ClientModel/SamplingDataPostProcessor.h"
+#include "ClientProtos/capture_data.pb.h"
+#include "GrpcProtos/capture.pb.h"
+#include "GrpcProtos/module.pb.h"
+#include "OrbitBase/Logging.h"
+
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CaptureData;
+using orbit_client_data::ScopeId;
+using orbit_grpc_protos::ClientCaptureEvent;
+
+namespace orbit_client_ggp {
+
+namespace {
+
+// Keeps what the analysis needs from a loaded capture in a `CaptureData`, and the start
+// timestamps of the frame scope. All other events are dropped.
+class CaptureAnalysisListener
+    : public orbit_capture_client::AbstractCaptureListener<CaptureAnalysisListener>,
+      public orbit_client_data::CaptureDataHolder {
+ public:
+  explicit CaptureAnalysisListener(std::string frame_scope_name)
+      : frame_scope_name_(std::move(frame_scope_name)) {}
+
+  [[nodiscard]] static orbit_capture_client::LoadCaptureFilter GetLoadCaptureFilter() {
+    orbit_capture_client::LoadCaptureFilter filter;
+    filter.event_cases = {ClientCaptureEvent::kFunctionCall,
+                          ClientCaptureEvent::kFunctionCallBatch,
+                          ClientCaptureEvent::kApiScopeStart,
+                          ClientCaptureEvent::kApiScopeStop,
+                          ClientCaptureEvent::kApiScopeStartAsync,
+                          ClientCaptureEvent::kApiScopeStopAsync,
+                          ClientCaptureEvent::kCallstackSample,
+                          ClientCaptureEvent::kCallstackSampleBatch};
+    return filter;
+  }
+
+  [[nodiscard]] const orbit_client_data::ModuleManager& module_manager() const {
+    return *module_manager_;
+  }
+  [[nodiscard]] uint64_t capture_duration_ns() const {
+    return max_timestamp_ns_ - std::min(capture_start_timestamp_ns_, max_timestamp_ns_);
+  }
+  [[nodiscard]] std::vector<uint64_t>& mutable_frame_starts() { return frame_starts_; }
+
+  void OnCaptureStarted(const orbit_grpc_protos::CaptureStarted& capture_started,
+                        std::optional<std::filesystem::path> file_path,
+                        absl::flat_hash_set<uint64_t> frame_track_function_ids) override {
+    module_identifier_provider_ = std::make_unique<orbit_client_data::ModuleIdentifierProvider>();
+    ConstructCaptureData(capture_started, std::move(file_path), std::move(frame_track_function_ids),
+                         CaptureData::DataSource::kLoadedCapture,
+                         module_identifier_provider_.get());
+    module_manager_ =
+        std::make_unique<orbit_client_data::ModuleManager>(module_identifier_provider_.get());
+    capture_start_timestamp_ns_ = capture_started.capture_start_timestamp_ns();
+  }
+
+  void OnCaptureFinished(const orbit_grpc_protos::CaptureFinished& /*capture_finished*/) override {
+    GetMutableCaptureData().OnCaptureComplete();
+  }
+
+  void OnTimer(const orbit_client_protos::TimerInfo& timer_info) override {
+    GetMutableCaptureData().UpdateScopeStats(timer_info);
+    max_timestamp_ns_ = std::max(max_timestamp_ns_, timer_info.end());
+    if (IsFrameScope(timer_info)) frame_starts_.push_back(timer_info.start());
+  }
+
+  void OnCallstackEvent(CallstackEvent callstack_event) override {
+    max_timestamp_ns_ = std::max(max_timestamp_ns_, callstack_event.timestamp_ns());
+    AbstractCaptureListener::OnCallstackEvent(callstack_event);
+  }
+
+  void OnCallstackEvents(absl::Span<const CallstackEvent> callstack_events) override {
+    for (const CallstackEvent& callstack_event : callstack_events) {
+      max_timestamp_ns_ = std::max(max_timestamp_ns_, callstack_event.timestamp_ns());
+    }
+    AbstractCaptureListener::OnCallstackEvents(callstack_events);
+  }
+
+  void OnModuleUpdate(uint64_t /*timestamp_ns*/,
+                      orbit_grpc_protos::ModuleInfo module_info) override {
+    UpdateModules({module_info});
+    GetMutableCaptureData().mutable_process()->AddOrUpdateModuleInfo(module_info);
+  }
+  void OnModulesSnapshot(uint64_t /*timestamp_ns*/,
+                         std::vector<orbit_grpc_protos::ModuleInfo> module_infos) override {
+    UpdateModules(module_infos);
+  }
+
+  // The following events are ignored, as they are not part of the analysis.
+  void OnCgroupAndProcessMemoryInfo(const orbit_client_data::CgroupAndProcessMemoryInfo&
+                                    /*cgroup_and_process_memory_info*/) override {}
+  void OnPageFaultsInfo(const orbit_client_data::PageFaultsInfo& /*page_faults_info*/) override {}
+  void OnSystemMemoryInfo(
+      const orbit_client_data::SystemMemoryInfo& /*system_memory_info*/) override {}
+  void OnPresentEvent(const orbit_grpc_protos::PresentEvent& /*present_event*/) override {}
+  void OnPressureStallEvent(
+      const orbit_grpc_protos::PressureStallEvent& /*pressure_stall_event*/) override {}
+  void OnPerformanceCounterSample(
+      const orbit_grpc_protos::PerformanceCounterSample& /*performance_counter_sample*/) override {}
+  void OnKeyAndString(uint64_t /*key*/, std::string /*str*/) override {}
+  void OnThreadStateSlice(orbit_client_data::ThreadStateSliceInfo /*thread_state_slice*/) override {
+  }
+  void OnOffCpuTimeSummary(
+      const orbit_grpc_protos::OffCpuTimeSummary& /*off_cpu_time_summary*/) override {}
+  void OnThreadStateSlices(
+      absl::Span<const orbit_client_data::ThreadStateSliceInfo> /*thread_state_slices*/) override {}
+  void OnUniqueTracepointInfo(uint64_t /*tracepoint_id*/,
+                              orbit_client_data::TracepointInfo /*tracepoint_info*/) override {}
+  void OnTracepointEvent(
+      orbit_client_data::TracepointEventInfo /*tracepoint_event_info*/) override {}
+  void OnApiStringEvent(const orbit_client_data::ApiStringEvent& /*unused*/) override {}
+  void OnApiTrackValue(const orbit_client_data::ApiTrackValue& /*unused*/) override {}
+  void OnWarningEvent(orbit_grpc_protos::WarningEvent /*warning_event*/) override {}
+  void OnClockResolutionEvent(
+      orbit_grpc_protos::ClockResolutionEvent /*clock_resolution_event*/) override {}
+  void OnErrorsWithPerfEventOpenEvent(
+      orbit_grpc_protos::ErrorsWithPerfEventOpenEvent /*errors_with_perf_event_open_event*/)
+      override {}
+  void OnWarningInstrumentingWithUprobesEvent(
+      orbit_grpc_protos::WarningInstrumentingWithUprobesEvent
+      /*warning_instrumenting_with_uprobes_event*/) override {}
+  void OnErrorEnablingOrbitApiEvent(
+      orbit_grpc_protos::ErrorEnablingOrbitApiEvent /*error_enabling_orbit_api_event*/) override {}
+  void OnErrorEnablingUserSpaceInstrumentationEvent(
+      orbit_grpc_protos::ErrorEnablingUserSpaceInstrumentationEvent /*error_event*/) override {}
+  void OnWarningInstrumentingWithUserSpaceInstrumentationEvent(
+      orbit_grpc_protos::WarningInstrumentingWithUserSpaceInstrumentationEvent
+      /*warning_event*/) override {}
+  void OnLostPerfRecordsEvent(
+      orbit_grpc_protos::LostPerfRecordsEvent /*lost_perf_records_event*/) override {}
+  void OnOutOfOrderEventsDiscardedEvent(orbit_grpc_protos::OutOfOrderEventsDiscardedEvent
+                                        /*out_of_order_events_discarded_event*/) override {}
+  void OnPerfEventProcessingStatsEvent(orbit_grpc_protos::PerfEventProcessingStatsEvent
+                                       /*perf_event_processing_stats_event*/) override {}
+
+ private:
+  [[nodiscard]] bool IsFrameScope(const orbit_client_protos::TimerInfo& timer_info) {
+    if (frame_scope_name_.empty()) return false;
+    const std::optional<ScopeId> scope_id = GetCaptureData().ProvideScopeId(timer_info);
+    if (!scope_id.has_value()) return false;
+    auto [it, inserted] = scope_id_is_frame_scope_.try_emplace(scope_id.value(), false);
+    if (inserted) {
+      it->second = GetCaptureData().GetScopeInfo(scope_id.value()).GetName() == frame_scope_name_;
+    }
+    return it->second;
+  }
+
+  void UpdateModules(absl::Span<const orbit_grpc_protos::ModuleInfo> module_infos) {
+    for (const auto* not_updated_module :
+         module_manager_->AddOrUpdateNotLoadedModules(module_infos)) {
+      ORBIT_LOG("Module %s is not updated", not_updated_module->file_path());
+    }
+    GetMutableCaptureData().mutable_process()->UpdateModuleInfos(module_infos);
+  }
+
+  std::string frame_scope_name_;
+  std::unique_ptr<orbit_client_data::ModuleIdentifierProvider> module_identifier_provider_;
+  std::unique_ptr<orbit_client_data::ModuleManager> module_manager_;
+  uint64_t capture_start_timestamp_ns_ = 0;
+  uint64_t max_timestamp_ns_ = 0;
+  absl::flat_hash_map<ScopeId, bool> scope_id_is_frame_scope_;
+  std::vector<uint64_t> frame_starts_;
+};
+
+[[nodiscard]] std::vector<SampledFunctionSummary> GetTopFunctions(
+    const orbit_client_data::ThreadSampleData& summary, size_t top_function_count) {
+  std::vector<const orbit_client_data::SampledFunction*> sampled_functions;
+  sampled_functions.reserve(summary.sampled_functions.size());
+  for (const orbit_client_data::SampledFunction& function : summary.sampled_functions) {
+    sampled_functions.push_back(&function);
+  }
+  const size_t count = std::min(top_function_count, sampled_functions.size());
+  std::partial_sort(sampled_functions.begin(), sampled_functions.begin() + count,
+                    sampled_functions.end(),
+                    [](const orbit_client_data::SampledFunction* lhs,
+                       const orbit_client_data::SampledFunction* rhs) {
+                      if (lhs->inclusive != rhs->inclusive) return lhs->inclusive > rhs->inclusive;
+                      if (lhs->exclusive != rhs->exclusive) return lhs->exclusive > rhs->exclusive;
+                      return lhs->name < rhs->name;
+                    });
+
+  std::vector<SampledFunctionSummary> top_functions;
+  top_functions.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    const orbit_client_data::SampledFunction& function = *sampled_functions[i];
+    top_functions.push_back(SampledFunctionSummary{function.name, function.module_path,
+                                                   function.inclusive, function.exclusive});
+  }
+  return top_functions;
+}
+
+[[nodiscard]] std::vector<ScopeSummary> GetScopeSummaries(const CaptureData& capture_data) {
+  std::vector<ScopeSummary> scopes;
+  for (const ScopeId scope_id : capture_data.GetAllProvidedScopeIds()) {
+    const std::vector<uint64_t>* durations =
+        capture_data.GetSortedTimerDurationsForScopeId(scope_id);
+    if (durations == nullptr || durations->empty()) continue;
+    scopes.push_back(ScopeSummary{capture_data.GetScopeInfo(scope_id).GetName(),
+                                  ComputeDurationSummary(*durations)});
+  }
+  std::sort(scopes.begin(), scopes.end(), [](const ScopeSummary& lhs, const ScopeSummary& rhs) {
+    if (lhs.durations.total_ns != rhs.durations.total_ns) {
+      return lhs.durations.total_ns > rhs.durations.total_ns;
+    }
+    return lhs.name < rhs.name;
+  });
+  return scopes;
+}
+
+[[nodiscard]] std::optional<FrameTimeSummary> GetFrameTimeSummary(std::string_view scope_name,
+                                                                  std::vector<uint64_t>* starts) {
+  if (starts->size() < 2) return std::nullopt;
+  std::sort(starts->begin(), starts->end());
+  std::vector<uint64_t> frame_times;
+  frame_times.reserve(starts->size() - 1);
+  for (size_t i = 1; i < starts->size(); ++i) {
+    frame_times.push_back((*starts)[i] - (*starts)[i - 1]);
+  }
+  std::sort(frame_times.begin(), frame_times.end());
+
+  FrameTimeSummary summary;
+  summary.scope_name = std::string{scope_name};
+  summary.frame_times = ComputeDurationSummary(frame_times);
+  constexpr uint64_t kHitchFactor = 2;
+  summary.hitch_count = static_cast<uint64_t>(
+      frame_times.end() - std::upper_bound(frame_times.begin(), frame_times.end(),
+                                           summary.frame_times.average_ns * kHitchFactor));
+  return summary;
+}
+
+void AppendJsonDurationSummary(std::string* out, const DurationSummary& summary) {
+  out->append(absl::StrFormat(
+      R"("count":%u,"total_ns":%u,"min_ns":%u,"average_ns":%u,"median_ns":%u,"p90_ns":%u,)"
+      R"("p99_ns":%u,"max_ns":%u)",
+      summary.count, summary.total_ns, summary.min_ns, summary.average_ns, summary.median_ns,
+      summary.p90_ns, summary.p99_ns, summary.max_ns));
+}
+
+[[nodiscard]] std::string FormatValueForCsv(std::string_view value) {
+  std::string result = "\"";
+  for (const char c : value) {
+    // Quotes are escaped by doubling them.
+    if (c == '"') result.push_back('"');
+    result.push_back(c);
+  }
+  result.push_back('"');
+  return result;
+}
+
+[[nodiscard]] std::string FormatDurationSummaryForCsv(const DurationSummary& summary) {
+  return absl::StrFormat("%u,%u,%u,%u,%u,%u,%u,%u", summary.count, summary.total_ns,
+                         summary.min_ns, summary.average_ns, summary.median_ns, summary.p90_ns,
+                         summary.p99_ns, summary.max_ns);
+}
+
+}  // namespace
+
+void AppendJsonString(std::string* out, std::string_view str) {
+  out->append("\"");
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out->append(absl::StrFormat("\\u%04x", static_cast<int>(c)));
+        } else {
+          out->push_back(c);
+        }
+    }
+  }
+  out->append("\"");
+}
+
+DurationSummary ComputeDurationSummary(const std::vector<uint64_t>& sorted_durations_ns) {
+  ORBIT_CHECK(std::is_sorted(sorted_durations_ns.begin(), sorted_durations_ns.end()));
+  DurationSummary summary;
+  if (sorted_durations_ns.empty()) return summary;
+
+  const size_t count = sorted_durations_ns.size();
+  auto percentile = [&sorted_durations_ns, count](size_t percent) {
+    // Nearest rank: the smallest duration such that at least `percent`% of them are not larger.
+    const size_t rank = std::max<size_t>((count * percent + 99) / 100, 1);
+    return sorted_durations_ns[rank - 1];
+  };
+
+  summary.count = count;
+  for (const uint64_t duration_ns : sorted_durations_ns) summary.total_ns += duration_ns;
+  summary.min_ns = sorted_durations_ns.front();
+  summary.average_ns = summary.total_ns / count;
+  summary.median_ns = percentile(50);
+  summary.p90_ns = percentile(90);
+  summary.p99_ns = percentile(99);
+  summary.max_ns = sorted_durations_ns.back();
+  return summary;
+}
+
+ErrorMessageOr<CaptureAnalysis> AnalyzeCaptureFile(const std::filesystem::path& capture_file_path,
+                                                   const CaptureAnalysisOptions& options) {
+  OUTCOME_TRY(std::unique_ptr<orbit_capture_file::CaptureFile> capture_file,
+              orbit_capture_file::CaptureFile::OpenForReadWrite(capture_file_path));
+
+  CaptureAnalysisListener listener{options.frame_scope_name};
+  std::atomic<bool> cancellation_requested = false;
+  OUTCOME_TRY(orbit_capture_client::CaptureListener::CaptureOutcome outcome,
+              orbit_capture_client::LoadCapture(&listener, capture_file.get(),
+                                                &cancellation_requested,
+                                                CaptureAnalysisListener::GetLoadCaptureFilter()));
+  if (outcome != orbit_capture_client::CaptureListener::CaptureOutcome::kComplete ||
+      !listener.HasCaptureData()) {
+    return ErrorMessage{
+        absl::StrFormat("Capture \"%s\" could not be loaded completely",
+                        capture_file_path.string())};
+  }
+
+  CaptureData& capture_data = listener.GetMutableCaptureData();
+  capture_data.FilterBrokenCallstacks();
+  const orbit_client_data::PostProcessedSamplingData post_processed_sampling_data =
+      orbit_client_model::CreatePostProcessedSamplingData(capture_data.GetCallstackData(),
+                                                          capture_data, listener.module_manager());
+
+  CaptureAnalysis analysis;
+  analysis.capture_duration_ns = listener.capture_duration_ns();
+  if (const orbit_client_data::ThreadSampleData* summary =
+          post_processed_sampling_data.GetSummary();
+      summary != nullptr) {
+    analysis.samples_count = summary->samples_count;
+    analysis.top_functions = GetTopFunctions(*summary, options.top_function_count);
+  }
+  analysis.scopes = GetScopeSummaries(capture_data);
+  analysis.frame_times =
+      GetFrameTimeSummary(options.frame_scope_name, &listener.mutable_frame_starts());
+  return analysis;
+}
+
+std::string FormatCaptureAnalysisAsJson(const CaptureAnalysis& analysis) {
+  std::string json = absl::StrFormat("{\n\"capture_duration_ns\":%u,\n\"samples_count\":%u,\n",
+                                     analysis.capture_duration_ns, analysis.samples_count);
+
+  json.append("\"top_functions\":[");
+  for (size_t i = 0; i < analysis.top_functions.size(); ++i) {
+    const SampledFunctionSummary& function = analysis.top_functions[i];
+    json.append(i == 0 ? "\n" : ",\n");
+    json.append("{\"name\":");
+    AppendJsonString(&json, function.name);
+    json.append(",\"module_path\":");
+    AppendJsonString(&json, function.module_path);
+    json.append(absl::StrFormat(R"(,"inclusive_count":%u,"exclusive_count":%u})",
+                                function.inclusive_count, function.exclusive_count));
+  }
+  json.append("\n],\n");
+
+  json.append("\"scopes\":[");
+  for (size_t i = 0; i < analysis.scopes.size(); ++i) {
+    const ScopeSummary& scope = analysis.scopes[i];
+    json.append(i == 0 ? "\n" : ",\n");
+    json.append("{\"name\":");
+    AppendJsonString(&json, scope.name);
+    json.append(",");
+    AppendJsonDurationSummary(&json, scope.durations);
+    json.append("}");
+  }
+  json.append("\n]");
+
+  if (analysis.frame_times.has_value()) {
+    json.append(",\n\"frame_times\":{\"scope_name\":");
+    AppendJsonString(&json, analysis.frame_times->scope_name);
+    json.append(",");
+    AppendJsonDurationSummary(&json, analysis.frame_times->frame_times);
+    json.append(absl::StrFormat(R"(,"hitch_count":%u})", analysis.frame_times->hitch_count));
+  }
+  json.append("\n}\n");
+  return json;
+}
+
+std::string FormatCaptureAnalysisAsCsv(const CaptureAnalysis& analysis) {
+  constexpr std::string_view kLineSeparator = "\r\n";
+  std::string csv =
+      "section,name,module_path,inclusive_count,exclusive_count,count,total_ns,min_ns,average_ns,"
+      "median_ns,p90_ns,p99_ns,max_ns,hitch_count";
+  csv.append(kLineSeparator);
+
+  for (const SampledFunctionSummary& function : analysis.top_functions) {
+    csv.append(absl::StrFormat("function,%s,%s,%u,%u,,,,,,,,,", FormatValueForCsv(function.name),
+                               FormatValueForCsv(function.module_path), function.inclusive_count,
+                               function.exclusive_count));
+    csv.append(kLineSeparator);
+  }
+  for (const ScopeSummary& scope : analysis.scopes) {
+    csv.append(absl::StrFormat("scope,%s,,,,%s,", FormatValueForCsv(scope.name),
+                               FormatDurationSummaryForCsv(scope.durations)));
+    csv.append(kLineSeparator);
+  }
+  if (analysis.frame_times.has_value()) {
+    csv.append(absl::StrFormat("frame_time,%s,,,,%s,%u",
+                               FormatValueForCsv(analysis.frame_times->scope_name),
+                               FormatDurationSummaryForCsv(analysis.frame_times->frame_times),
+                               analysis.frame_times->hitch_count));
+    csv.append(kLineSeparator);
+  }
+  return csv;
+}
+
+}  // namespace orbit_client_ggp
@@ -0,0 +1,91 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "OrbitClientGgp/CaptureAnalyzer.h"
+
+namespace orbit_client_ggp {
+
+TEST(CaptureAnalyzer, ComputeDurationSummaryOfNoDurations) {
+  const DurationSummary summary = ComputeDurationSummary({});
+  EXPECT_EQ(summary.count, 0);
+  EXPECT_EQ(summary.total_ns, 0);
+  EXPECT_EQ(summary.max_ns, 0);
+}
+
+TEST(CaptureAnalyzer, ComputeDurationSummaryUsesNearestRank) {
+  std::vector<uint64_t> durations;
+  for (uint64_t duration = 1; duration <= 100; ++duration) durations.push_back(duration);
+
+  const DurationSummary summary = ComputeDurationSummary(durations);
+  EXPECT_EQ(summary.count, 100);
+  EXPECT_EQ(summary.total_ns, 5050);
+  EXPECT_EQ(summary.min_ns, 1);
+  EXPECT_EQ(summary.average_ns, 50);
+  EXPECT_EQ(summary.median_ns, 50);
+  EXPECT_EQ(summary.p90_ns, 90);
+  EXPECT_EQ(summary.p99_ns, 99);
+  EXPECT_EQ(summary.max_ns, 100);
+}
+
+TEST(CaptureAnalyzer, ComputeDurationSummaryOfOneDuration) {
+  const DurationSummary summary = ComputeDurationSummary({42});
+  EXPECT_EQ(summary.min_ns, 42);
+  EXPECT_EQ(summary.median_ns, 42);
+  EXPECT_EQ(summary.p99_ns, 42);
+  EXPECT_EQ(summary.max_ns, 42);
+}
+
+namespace {
+
+CaptureAnalysis CreateCaptureAnalysis() {
+  CaptureAnalysis analysis;
+  analysis.capture_duration_ns = 1000;
+  analysis.samples_count = 10;
+  analysis.top_functions.push_back(
+      SampledFunctionSummary{"foo<int, \"bar\">", "/path/to/module", 8, 3});
+  analysis.scopes.push_back(ScopeSummary{"Frame", ComputeDurationSummary({10, 20, 30})});
+  return analysis;
+}
+
+}  // namespace
+
+TEST(CaptureAnalyzer, FormatCaptureAnalysisAsJson) {
+  CaptureAnalysis analysis = CreateCaptureAnalysis();
+  std::string json = FormatCaptureAnalysisAsJson(analysis);
+  EXPECT_THAT(json, testing::HasSubstr(R"("capture_duration_ns":1000,)"));
+  EXPECT_THAT(json, testing::HasSubstr(R"("samples_count":10,)"));
+  EXPECT_THAT(json, testing::HasSubstr(
+                        R"({"name":"foo<int, \"bar\">","module_path":"/path/to/module",)"
+                        R"("inclusive_count":8,"exclusive_count":3})"));
+  EXPECT_THAT(json, testing::HasSubstr(
+                        R"({"name":"Frame","count":3,"total_ns":60,"min_ns":10,"average_ns":20,)"
+                        R"("median_ns":20,"p90_ns":30,"p99_ns":30,"max_ns":30})"));
+  EXPECT_THAT(json, testing::Not(testing::HasSubstr("frame_times")));
+
+  analysis.frame_times = FrameTimeSummary{"Frame", ComputeDurationSummary({16, 16, 40}), 1};
+  json = FormatCaptureAnalysisAsJson(analysis);
+  EXPECT_THAT(json, testing::HasSubstr(R"("frame_times":{"scope_name":"Frame","count":3,)"));
+  EXPECT_THAT(json, testing::HasSubstr(R"("max_ns":40,"hitch_count":1})"));
+}
+
+TEST(CaptureAnalyzer, FormatCaptureAnalysisAsCsv) {
+  CaptureAnalysis analysis = CreateCaptureAnalysis();
+  analysis.frame_times = FrameTimeSummary{"Frame", ComputeDurationSummary({16, 16, 40}), 1};
+
+  EXPECT_EQ(FormatCaptureAnalysisAsCsv(analysis),
+            "section,name,module_path,inclusive_count,exclusive_count,count,total_ns,min_ns,"
+            "average_ns,median_ns,p90_ns,p99_ns,max_ns,hitch_count\r\n"
+            "function,\"foo<int, \"\"bar\"\">\",\"/path/to/module\",8,3,,,,,,,,,\r\n"
+            "scope,\"Frame\",,,,3,60,10,20,20,30,30,30,\r\n"
+            "frame_time,\"Frame\",,,,3,72,16,24,16,40,40,40,1\r\n");
+}
+
+}  // namespace orbit_client_ggp
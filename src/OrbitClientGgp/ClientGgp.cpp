@@ -42,6 +42,8 @@
 
 ABSL_DECLARE_FLAG(bool, thread_state);
 ABSL_DECLARE_FLAG(uint64_t, max_local_marker_depth_per_command_buffer);
+ABSL_DECLARE_FLAG(bool, save_capture_on_service);
+ABSL_DECLARE_FLAG(uint64_t, flight_recorder_ms);
 
 using orbit_base::Future;
 
@@ -116,13 +118,25 @@ ErrorMessageOr<void> ClientGgp::RequestStartCapture(orbit_base::ThreadPool* thre
   options.selected_functions = selected_functions_;
   options.stack_dump_size = options_.stack_dump_size;
   options.samples_per_second = options_.samples_per_second;
+  options.flight_recorder_duration_ms = absl::GetFlag(FLAGS_flight_recorder_ms);
 
   std::filesystem::path file_path = GenerateFilePath();
+  capture_file_path_ = file_path;
 
   ORBIT_LOG("Saving capture to \"%s\"", file_path.string());
 
+  // OrbitClientGgp runs on the same machine as OrbitService, so the service can write the file in
+  // place, while this client only receives and saves a preview.
+  std::filesystem::path client_file_path = file_path;
+  if (absl::GetFlag(FLAGS_save_capture_on_service)) {
+    options.capture_file_path_on_target = file_path.string();
+    client_file_path.replace_filename(
+        absl::StrFormat("%s_preview%s", file_path.stem().string(), file_path.extension().string()));
+    ORBIT_LOG("Saving capture preview to \"%s\"", client_file_path.string());
+  }
+
   OUTCOME_TRY(auto&& event_processor, CaptureEventProcessor::CreateSaveToFileProcessor(
-                                          GenerateFilePath(), [](const ErrorMessage& error) {
+                                          client_file_path, [](const ErrorMessage& error) {
                                             ORBIT_ERROR("%s", error.message());
                                           }));
 
@@ -216,13 +230,15 @@ ErrorMessageOr<void> ClientGgp::LoadModuleAndSymbols() {
   // Load symbols for the module
   const std::string& module_path = main_module_->file_path();
   ORBIT_LOG("Looking for debug info file for %s", module_path);
-  OUTCOME_TRY(orbit_base::NotFoundOr<std::filesystem::path> && find_result,
-              process_client_->FindDebugInfoFile(module_path, {}));
+  // The client runs on the instance, so it reads the uncompressed file directly.
+  OUTCOME_TRY(orbit_base::NotFoundOr<orbit_client_services::RemoteDebugInfoFile> && find_result,
+              process_client_->FindDebugInfoFile(module_path, {},
+                                                 /*accept_compressed_file=*/false));
   if (orbit_base::IsNotFound(find_result)) {
     return ErrorMessage{
         absl::StrFormat("Symbols not found: %s", orbit_base::GetNotFoundMessage(find_result))};
   }
-  const auto& main_executable_debug_file{orbit_base::GetFound(find_result)};
+  const auto& main_executable_debug_file{orbit_base::GetFound(find_result).path};
   ORBIT_LOG("Found file: %s", main_executable_debug_file);
   ORBIT_LOG("Loading symbols");
   orbit_object_utils::ObjectFileInfo object_file_info{main_module_->load_bias()};
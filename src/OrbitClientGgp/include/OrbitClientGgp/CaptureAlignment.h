@@ -0,0 +1,44 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_CLIENT_GGP_CAPTURE_ALIGNMENT_H_
+#define ORBIT_CLIENT_GGP_CAPTURE_ALIGNMENT_H_
+
+#include <absl/types/span.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "OrbitBase/Result.h"
+
+// Captures taken at the same time on several machines, e.g. with --start_at_unix_time_ms, have
+// timestamps from the monotonic clock of each machine, which have unrelated origins. Each capture
+// also records the wall-clock time at which it started, so, with the wall clocks of the machines
+// synchronized (e.g. by NTP), the timestamps of all captures can be put on a common timeline.
+namespace orbit_client_ggp {
+
+struct CaptureClock {
+  std::filesystem::path file_path;
+  uint64_t capture_start_timestamp_ns = 0;
+  uint64_t capture_start_unix_time_ns = 0;
+};
+
+// Reads the start of the capture from the CaptureStarted event of the capture file.
+[[nodiscard]] ErrorMessageOr<CaptureClock> ReadCaptureClock(
+    const std::filesystem::path& capture_file_path);
+
+// Returns, for each capture, the value to add to its timestamps to express them in the timestamps
+// of the first capture. The precision is that of the synchronization of the wall clocks.
+[[nodiscard]] std::vector<int64_t> ComputeCaptureTimestampOffsets(
+    absl::Span<const CaptureClock> capture_clocks);
+
+// Formats `capture_clocks` with the offsets of ComputeCaptureTimestampOffsets as a JSON array.
+[[nodiscard]] std::string FormatCaptureAlignmentAsJson(
+    absl::Span<const CaptureClock> capture_clocks);
+
+}  // namespace orbit_client_ggp
+
+#endif  // ORBIT_CLIENT_GGP_CAPTURE_ALIGNMENT_H_
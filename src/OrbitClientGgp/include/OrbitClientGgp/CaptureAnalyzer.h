@@ -0,0 +1,92 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_CLIENT_GGP_CAPTURE_ANALYZER_H_
+#define ORBIT_CLIENT_GGP_CAPTURE_ANALYZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "OrbitBase/Result.h"
+
+namespace orbit_client_ggp {
+
+// Statistics of a set of durations. Percentiles use the nearest-rank method.
+struct DurationSummary {
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t min_ns = 0;
+  uint64_t average_ns = 0;
+  uint64_t median_ns = 0;
+  uint64_t p90_ns = 0;
+  uint64_t p99_ns = 0;
+  uint64_t max_ns = 0;
+};
+
+// `sorted_durations_ns` must be sorted in ascending order.
+[[nodiscard]] DurationSummary ComputeDurationSummary(
+    const std::vector<uint64_t>& sorted_durations_ns);
+
+struct SampledFunctionSummary {
+  std::string name;
+  std::string module_path;
+  uint32_t inclusive_count = 0;
+  uint32_t exclusive_count = 0;
+};
+
+struct ScopeSummary {
+  std::string name;
+  DurationSummary durations;
+};
+
+struct FrameTimeSummary {
+  std::string scope_name;
+  DurationSummary frame_times;
+  // Frames that took more than twice the average frame time.
+  uint64_t hitch_count = 0;
+};
+
+struct CaptureAnalysis {
+  uint64_t capture_duration_ns = 0;
+  uint32_t samples_count = 0;
+  // Sorted by decreasing inclusive count, then by decreasing exclusive count.
+  std::vector<SampledFunctionSummary> top_functions;
+  // Sorted by decreasing total time.
+  std::vector<ScopeSummary> scopes;
+  std::optional<FrameTimeSummary> frame_times;
+};
+
+struct CaptureAnalysisOptions {
+  // Number of functions with the most inclusive samples to report.
+  size_t top_function_count = 20;
+  // If not empty, the time between the starts of two consecutive instances of the scope (a
+  // dynamically instrumented function or a manual scope) with this name is reported as frame time.
+  std::string frame_scope_name;
+};
+
+// Loads the capture file without any UI: the scope statistics are computed while loading, and the
+// callstack samples are post-processed on all cores once the capture is loaded. Only the events
+// that the analysis needs are loaded. Symbols are not loaded, the function names come from the
+// address infos collected by OrbitService during the capture.
+[[nodiscard]] ErrorMessageOr<CaptureAnalysis> AnalyzeCaptureFile(
+    const std::filesystem::path& capture_file_path, const CaptureAnalysisOptions& options);
+
+[[nodiscard]] std::string FormatCaptureAnalysisAsJson(const CaptureAnalysis& analysis);
+
+// One row per function, scope and frame time summary, with a "section" column to tell them apart.
+// The columns that don't apply to a row are left empty.
+[[nodiscard]] std::string FormatCaptureAnalysisAsCsv(const CaptureAnalysis& analysis);
+
+// Appends `str` to `out` as a quoted and escaped JSON string.
+void AppendJsonString(std::string* out, std::string_view str);
+
+}  // namespace orbit_client_ggp
+
+#endif  // ORBIT_CLIENT_GGP_CAPTURE_ANALYZER_H_
@@ -42,6 +42,11 @@ class ClientGgp {
   ErrorMessageOr<void> RequestStartCapture(orbit_base::ThreadPool* thread_pool);
   bool StopCapture();
   void UpdateCaptureFunctions(std::vector<std::string> capture_functions);
+  // The path of the complete capture, written by this client or, with --save_capture_on_service,
+  // by OrbitService. Set by RequestStartCapture.
+  [[nodiscard]] const std::filesystem::path& capture_file_path() const {
+    return capture_file_path_;
+  }
 
   // CaptureListener implementation
 
@@ -49,6 +54,7 @@ class ClientGgp {
   std::filesystem::path GenerateFilePath();
 
   ClientGgpOptions options_;
+  std::filesystem::path capture_file_path_;
   std::shared_ptr<grpc::Channel> grpc_channel_;
   std::unique_ptr<orbit_client_data::ProcessData> target_process_;
   orbit_client_data::ModuleIdentifierProvider module_identifier_provider_;
@@ -14,15 +14,19 @@
 #include <algorithm>
 #include <cstdint>
 #include <filesystem>
+#include <iostream>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "OrbitBase/File.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
 #include "OrbitBase/ThreadPool.h"
+#include "OrbitClientGgp/CaptureAlignment.h"
+#include "OrbitClientGgp/CaptureAnalyzer.h"
 #include "OrbitClientGgp/ClientGgp.h"
 #include "OrbitClientGgp/ClientGgpOptions.h"
 #include "OrbitVersion/OrbitVersion.h"
@@ -44,6 +48,30 @@ ABSL_FLAG(bool, frame_pointer_unwinding, false, "Use frame pointers for unwindin
 ABSL_FLAG(bool, thread_state, false, "Collect thread states");
 ABSL_FLAG(uint64_t, max_local_marker_depth_per_command_buffer, std::numeric_limits<uint64_t>::max(),
           "Max local marker depth per command buffer");
+ABSL_FLAG(bool, save_capture_on_service, false,
+          "Let OrbitService write the capture file directly, so that only a preview of the capture "
+          "is streamed to this client. The preview is saved next to the capture file.");
+ABSL_FLAG(uint64_t, flight_recorder_ms, 0,
+          "Only keep the events of the last this many milliseconds before the capture is stopped "
+          "(0: disabled)");
+ABSL_FLAG(std::string, analyze_capture, "",
+          "Analyze this capture file instead of taking a capture, then exit");
+ABSL_FLAG(bool, analyze, false, "Analyze the capture once it is taken");
+ABSL_FLAG(std::string, summary_format, "json", "Format of the analysis summary: json or csv");
+ABSL_FLAG(std::string, summary_output, "",
+          "File the analysis or alignment summary is written to (default: the standard output)");
+ABSL_FLAG(uint32_t, top_functions, 20,
+          "Number of functions with the most inclusive samples in the analysis summary");
+ABSL_FLAG(std::string, frame_scope, "",
+          "Name of the instrumented function or manual scope that marks the frames, whose frame "
+          "times are added to the analysis summary");
+ABSL_FLAG(uint64_t, start_at_unix_time_ms, 0,
+          "Wait until this wall-clock time, in milliseconds since the Unix epoch, to start the "
+          "capture, so that the captures on several machines start together (0: start now)");
+ABSL_FLAG(std::vector<std::string>, align_captures, {},
+          "Write the offsets that put the timestamps of these capture files, taken at the same "
+          "time on different machines, on the timeline of the first one (comma-separated), then "
+          "exit");
 
 namespace {
 
@@ -55,6 +83,48 @@ std::string GetLogFilePath(std::string_view log_directory) {
   return log_file_path;
 }
 
+ErrorMessageOr<void> WriteSummary(const std::string& summary) {
+  const std::string summary_output = absl::GetFlag(FLAGS_summary_output);
+  if (summary_output.empty()) {
+    std::cout << summary << std::flush;
+    return outcome::success();
+  }
+  OUTCOME_TRY(orbit_base::UniqueFd fd, orbit_base::OpenFileForWriting(summary_output));
+  OUTCOME_TRY(orbit_base::WriteFully(fd, summary));
+  ORBIT_LOG("Summary written to \"%s\"", summary_output);
+  return outcome::success();
+}
+
+ErrorMessageOr<void> AnalyzeCaptureAndWriteSummary(const std::filesystem::path& capture_file_path) {
+  const std::string summary_format = absl::GetFlag(FLAGS_summary_format);
+  if (summary_format != "json" && summary_format != "csv") {
+    return ErrorMessage{absl::StrFormat("Unknown summary format \"%s\"", summary_format)};
+  }
+
+  orbit_client_ggp::CaptureAnalysisOptions options;
+  options.top_function_count = absl::GetFlag(FLAGS_top_functions);
+  options.frame_scope_name = absl::GetFlag(FLAGS_frame_scope);
+  ORBIT_LOG("Analyzing capture \"%s\"", capture_file_path.string());
+  OUTCOME_TRY(orbit_client_ggp::CaptureAnalysis analysis,
+              orbit_client_ggp::AnalyzeCaptureFile(capture_file_path, options));
+  const std::string summary = summary_format == "json"
+                                  ? orbit_client_ggp::FormatCaptureAnalysisAsJson(analysis)
+                                  : orbit_client_ggp::FormatCaptureAnalysisAsCsv(analysis);
+
+  return WriteSummary(summary);
+}
+
+ErrorMessageOr<void> AlignCapturesAndWriteSummary(
+    const std::vector<std::string>& capture_file_paths) {
+  std::vector<orbit_client_ggp::CaptureClock> capture_clocks;
+  for (const std::string& capture_file_path : capture_file_paths) {
+    OUTCOME_TRY(orbit_client_ggp::CaptureClock capture_clock,
+                orbit_client_ggp::ReadCaptureClock(capture_file_path));
+    capture_clocks.push_back(std::move(capture_clock));
+  }
+  return WriteSummary(orbit_client_ggp::FormatCaptureAlignmentAsJson(capture_clocks));
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -67,6 +137,26 @@ int main(int argc, char** argv) {
     orbit_base::InitLogFile(GetLogFilePath(log_directory));
   }
 
+  const std::string analyze_capture = absl::GetFlag(FLAGS_analyze_capture);
+  if (!analyze_capture.empty()) {
+    ErrorMessageOr<void> analyze_result = AnalyzeCaptureAndWriteSummary(analyze_capture);
+    if (analyze_result.has_error()) {
+      ORBIT_ERROR("Unable to analyze the capture: %s", analyze_result.error().message());
+      return -1;
+    }
+    return 0;
+  }
+
+  const std::vector<std::string> align_captures = absl::GetFlag(FLAGS_align_captures);
+  if (!align_captures.empty()) {
+    ErrorMessageOr<void> align_result = AlignCapturesAndWriteSummary(align_captures);
+    if (align_result.has_error()) {
+      ORBIT_ERROR("Unable to align the captures: %s", align_result.error().message());
+      return -1;
+    }
+    return 0;
+  }
+
   if (absl::GetFlag(FLAGS_pid) == 0) {
     ORBIT_FATAL("pid to capture not provided; set using -pid");
   }
@@ -89,6 +179,14 @@ int main(int argc, char** argv) {
     return -1;
   }
 
+  if (const uint64_t start_at_unix_time_ms = absl::GetFlag(FLAGS_start_at_unix_time_ms);
+      start_at_unix_time_ms != 0) {
+    const absl::Time start_time =
+        absl::FromUnixMillis(static_cast<int64_t>(start_at_unix_time_ms));
+    ORBIT_LOG("Waiting until %s to start the capture", absl::FormatTime(start_time));
+    absl::SleepFor(start_time - absl::Now());
+  }
+
   // The request is done in a separate thread to avoid blocking main()
   // It is needed to provide a thread pool
   std::shared_ptr<orbit_base::ThreadPool> thread_pool =
@@ -114,6 +212,15 @@ int main(int argc, char** argv) {
   ORBIT_LOG("Shut down the thread and wait for it to finish");
   thread_pool->ShutdownAndWait();
 
+  if (absl::GetFlag(FLAGS_analyze)) {
+    ErrorMessageOr<void> analyze_result =
+        AnalyzeCaptureAndWriteSummary(client_ggp.capture_file_path());
+    if (analyze_result.has_error()) {
+      ORBIT_ERROR("Unable to analyze the capture: %s", analyze_result.error().message());
+      return -1;
+    }
+  }
+
   ORBIT_LOG("All done");
   return 0;
 }
@@ -20,6 +20,7 @@
 #include "ClientProtos/capture_data.pb.h"
 #include "DisplayFormats/DisplayFormats.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitGl/AsyncTrackLanes.h"
 #include "OrbitGl/GlUtils.h"
 #include "OrbitGl/ManualInstrumentationManager.h"
 #include "OrbitGl/OrbitApp.h"
@@ -79,14 +80,9 @@ AsyncTrack::AsyncTrack(CaptureViewElement* parent,
 }
 
 void AsyncTrack::OnTimer(const orbit_client_protos::TimerInfo& timer_info) {
-  // Find the first row that that can receive the new timeslice with no overlap.
-  // If none of the existing rows works, add a new row.
-  uint32_t depth = 0;
-  while (max_span_time_by_depth_[depth] > timer_info.start()) ++depth;
-  max_span_time_by_depth_[depth] = timer_info.end();
-
+  // Put the new timeslice in the first row that can receive it with no overlap, or in a new row.
   orbit_client_protos::TimerInfo new_timer_info = timer_info;
-  new_timer_info.set_depth(depth);
+  new_timer_info.set_depth(lanes_.AssignLane(timer_info.start(), timer_info.end()));
   TimerTrack::OnTimer(new_timer_info);
 }
 
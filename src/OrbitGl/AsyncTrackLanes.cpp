@@ -0,0 +1,50 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitGl/AsyncTrackLanes.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace orbit_gl {
+
+uint32_t AsyncTrackLanes::AssignLane(uint64_t start, uint64_t end) {
+  uint32_t lane = 0;
+  if (lane_count_ == 0 || min_end_tree_[1] > start) {
+    // All lanes are busy at `start`.
+    if (lane_count_ == capacity_) Grow();
+    lane = lane_count_++;
+  } else {
+    size_t node = 1;
+    while (node < capacity_) {
+      node = min_end_tree_[2 * node] <= start ? 2 * node : 2 * node + 1;
+    }
+    lane = static_cast<uint32_t>(node - capacity_);
+  }
+  SetLaneEnd(lane, end);
+  return lane;
+}
+
+void AsyncTrackLanes::Grow() {
+  const size_t new_capacity = std::max<size_t>(1, 2 * capacity_);
+  std::vector<uint64_t> new_tree(2 * new_capacity, std::numeric_limits<uint64_t>::max());
+  std::copy(min_end_tree_.begin() + capacity_, min_end_tree_.begin() + capacity_ + lane_count_,
+            new_tree.begin() + new_capacity);
+  for (size_t node = new_capacity - 1; node > 0; --node) {
+    new_tree[node] = std::min(new_tree[2 * node], new_tree[2 * node + 1]);
+  }
+  min_end_tree_ = std::move(new_tree);
+  capacity_ = new_capacity;
+}
+
+void AsyncTrackLanes::SetLaneEnd(uint32_t lane, uint64_t end) {
+  size_t node = capacity_ + lane;
+  min_end_tree_[node] = end;
+  for (node /= 2; node > 0; node /= 2) {
+    min_end_tree_[node] = std::min(min_end_tree_[2 * node], min_end_tree_[2 * node + 1]);
+  }
+}
+
+}  // namespace orbit_gl
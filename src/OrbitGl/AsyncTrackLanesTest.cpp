@@ -0,0 +1,54 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/container/flat_hash_map.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "OrbitGl/AsyncTrackLanes.h"
+
+namespace orbit_gl {
+
+TEST(AsyncTrackLanes, TimersGoToTheLowestFreeLane) {
+  AsyncTrackLanes lanes;
+  EXPECT_EQ(lanes.AssignLane(0, 10), 0);
+  EXPECT_EQ(lanes.AssignLane(5, 20), 1);
+  EXPECT_EQ(lanes.AssignLane(8, 30), 2);
+  // Lane 0 is free again: a timer can start when the previous one of the lane ends.
+  EXPECT_EQ(lanes.AssignLane(10, 40), 0);
+  EXPECT_EQ(lanes.AssignLane(25, 50), 1);
+  EXPECT_EQ(lanes.GetLaneCount(), 3);
+}
+
+TEST(AsyncTrackLanes, TimersOutOfOrderOfStart) {
+  AsyncTrackLanes lanes;
+  EXPECT_EQ(lanes.AssignLane(100, 110), 0);
+  // Lane 0 only becomes free at 110.
+  EXPECT_EQ(lanes.AssignLane(50, 60), 1);
+  EXPECT_EQ(lanes.AssignLane(120, 130), 0);
+  EXPECT_EQ(lanes.AssignLane(60, 70), 1);
+}
+
+TEST(AsyncTrackLanes, SameLanesAsLinearSearch) {
+  std::mt19937_64 random_engine{42};
+  std::uniform_int_distribution<uint64_t> start_distribution{0, 100'000};
+  std::uniform_int_distribution<uint64_t> duration_distribution{0, 5'000};
+
+  AsyncTrackLanes lanes;
+  absl::flat_hash_map<uint32_t, uint64_t> max_span_time_by_depth;
+  for (int i = 0; i < 10'000; ++i) {
+    const uint64_t start = start_distribution(random_engine);
+    const uint64_t end = start + duration_distribution(random_engine);
+
+    uint32_t expected_lane = 0;
+    while (max_span_time_by_depth[expected_lane] > start) ++expected_lane;
+    max_span_time_by_depth[expected_lane] = end;
+
+    ASSERT_EQ(lanes.AssignLane(start, end), expected_lane);
+  }
+}
+
+}  // namespace orbit_gl
@@ -28,6 +28,7 @@ using orbit_client_data::ThreadSampleData;
 CallTreeNode::~CallTreeNode() = default;
 
 const std::vector<const CallTreeNode*>& CallTreeNode::children() const {
+  ExpandPendingCallstacks();
   if (children_cache_.has_value()) {
     return *children_cache_;
   }
@@ -108,6 +109,55 @@ CallTreeUnwindErrors* CallTreeNode::AddAndGetUnwindErrors() {
   return unwind_errors_child_.get();
 }
 
+void CallTreeNode::AddPendingCallstack(CallTreeCallstack* callstack) {
+  ORBIT_CHECK(callstack != nullptr);
+  pending_callstacks_.push_back({callstack, 0});
+}
+
+void CallTreeNode::ExpandPendingCallstacks() const {
+  if (pending_callstacks_.empty()) return;
+  ORBIT_SCOPE_FUNCTION;
+
+  // The children are part of the tree from the start as far as the users of the tree are concerned,
+  // they are just created late. So this is not a logical modification of the node.
+  auto* self = const_cast<CallTreeNode*>(this);
+  std::vector<PendingCallstack> pending_callstacks;
+  std::swap(pending_callstacks, self->pending_callstacks_);
+
+  for (const auto& [callstack, frame_index] : pending_callstacks) {
+    CallTreeNode* child = nullptr;
+    if (frame_index < callstack->frames.size()) {
+      const uint64_t frame = callstack->frames[frame_index];
+      child = self->GetFunctionOrNull(frame);
+      if (child == nullptr) child = self->AddAndGetFunction(frame);
+    } else {
+      ORBIT_CHECK(callstack->thread_id.has_value());
+      child = self->GetThreadOrNull(callstack->thread_id.value());
+      if (child == nullptr) {
+        child = self->AddAndGetThread(callstack->thread_id.value(), callstack->thread_name);
+      }
+    }
+    child->IncreaseSampleCount(callstack->sample_count);
+
+    const bool is_last_node = frame_index >= callstack->frames.size() ||
+                              (frame_index + 1 == callstack->frames.size() &&
+                               !callstack->thread_id.has_value());
+    if (!is_last_node) {
+      child->pending_callstacks_.push_back({callstack, frame_index + 1});
+      continue;
+    }
+
+    // Nothing refers to the callstack anymore after this.
+    if (child->exclusive_callstack_events_.empty()) {
+      child->exclusive_callstack_events_ = std::move(callstack->callstack_events);
+    } else {
+      child->AddExclusiveCallstackEvents(callstack->callstack_events);
+    }
+    callstack->callstack_events = {};
+    callstack->frames = {};
+  }
+}
+
 std::string CallTreeFunction::RetrieveFunctionName(
     const orbit_client_data::ModuleManager& module_manager,
     const orbit_client_data::CaptureData& capture_data) const {
@@ -157,19 +207,20 @@ std::string CallTreeFunction::RetrieveModuleBuildId(
 
 static void AddCallstackToTopDownThread(
     CallTreeThread* thread_node, const CallstackInfo& resolved_callstack,
-    absl::Span<const orbit_client_data::CallstackEvent> callstack_events) {
-  uint64_t callstack_sample_count = callstack_events.size();
-
-  CallTreeNode* current_thread_or_function = thread_node;
-  for (auto frame_it = resolved_callstack.frames().rbegin();
-       frame_it != resolved_callstack.frames().rend(); ++frame_it) {
-    uint64_t frame = *frame_it;
-
-    CallTreeFunction* function_node = GetOrCreateFunctionNode(current_thread_or_function, frame);
-    function_node->IncreaseSampleCount(callstack_sample_count);
-    current_thread_or_function = function_node;
+    absl::Span<const orbit_client_data::CallstackEvent> callstack_events,
+    std::vector<std::unique_ptr<CallTreeCallstack>>* callstacks) {
+  if (resolved_callstack.frames().empty()) {
+    thread_node->AddExclusiveCallstackEvents(callstack_events);
+    return;
   }
-  current_thread_or_function->AddExclusiveCallstackEvents(callstack_events);
+
+  auto callstack = std::make_unique<CallTreeCallstack>();
+  callstack->frames.assign(resolved_callstack.frames().rbegin(),
+                          resolved_callstack.frames().rend());
+  callstack->callstack_events.assign(callstack_events.begin(), callstack_events.end());
+  callstack->sample_count = callstack_events.size();
+  thread_node->AddPendingCallstack(callstack.get());
+  callstacks->push_back(std::move(callstack));
 }
 
 static void AddUnwindErrorToTopDownThread(
@@ -195,18 +246,25 @@ static void AddUnwindErrorToTopDownThread(
   function_node->AddExclusiveCallstackEvents(callstack_events);
 }
 
+[[nodiscard]] static std::string GetThreadName(
+    uint32_t tid, std::string_view process_name,
+    const absl::flat_hash_map<uint32_t, std::string>& thread_names) {
+  if (tid == orbit_base::kAllProcessThreadsTid) {
+    return std::string{process_name};
+  }
+  if (auto thread_name_it = thread_names.find(tid); thread_name_it != thread_names.end()) {
+    return thread_name_it->second;
+  }
+  return "";
+}
+
 [[nodiscard]] static CallTreeThread* GetOrCreateThreadNode(
     CallTreeNode* current_node, uint32_t tid, std::string_view process_name,
     const absl::flat_hash_map<uint32_t, std::string>& thread_names) {
   CallTreeThread* thread_node = current_node->GetThreadOrNull(tid);
   if (thread_node == nullptr) {
-    std::string thread_name;
-    if (tid == orbit_base::kAllProcessThreadsTid) {
-      thread_name = process_name;
-    } else if (auto thread_name_it = thread_names.find(tid); thread_name_it != thread_names.end()) {
-      thread_name = thread_name_it->second;
-    }
-    thread_node = current_node->AddAndGetThread(tid, std::move(thread_name));
+    thread_node =
+        current_node->AddAndGetThread(tid, GetThreadName(tid, process_name, thread_names));
   }
   return thread_node;
 }
@@ -218,6 +276,7 @@ std::unique_ptr<CallTreeView> CallTreeView::CreateTopDownViewFromPostProcessedSa
   ORBIT_SCOPED_TIMED_LOG("CreateTopDownViewFromPostProcessedSamplingData");
 
   auto top_down_view_root = std::make_unique<CallTreeRoot>();
+  std::vector<std::unique_ptr<CallTreeCallstack>> callstacks;
   const std::string& process_name = capture_data->process_name();
   const absl::flat_hash_map<uint32_t, std::string>& thread_names = capture_data->thread_names();
 
@@ -241,27 +300,17 @@ std::unique_ptr<CallTreeView> CallTreeView::CreateTopDownViewFromPostProcessedSa
       const CallstackInfo& resolved_callstack =
           post_processed_sampling_data.GetResolvedCallstack(callstack_id);
       if (resolved_callstack.type() == CallstackType::kComplete) {
-        AddCallstackToTopDownThread(thread_node, resolved_callstack, callstack_events);
+        AddCallstackToTopDownThread(thread_node, resolved_callstack, callstack_events,
+                                    &callstacks);
       } else {
         AddUnwindErrorToTopDownThread(thread_node, resolved_callstack, callstack_events);
       }
     }
   }
-  return absl::WrapUnique<CallTreeView>(
-      new CallTreeView(std::move(top_down_view_root), module_manager, capture_data));
+  return absl::WrapUnique<CallTreeView>(new CallTreeView(
+      std::move(top_down_view_root), std::move(callstacks), module_manager, capture_data));
 }
 
-[[nodiscard]] static CallTreeNode* AddReversedCallstackToBottomUpViewAndReturnLastFunction(
-    CallTreeRoot* bottom_up_view_root, const CallstackInfo& resolved_callstack,
-    uint64_t callstack_sample_count) {
-  CallTreeNode* current_node = bottom_up_view_root;
-  for (uint64_t frame : resolved_callstack.frames()) {
-    CallTreeFunction* function_node = GetOrCreateFunctionNode(current_node, frame);
-    function_node->IncreaseSampleCount(callstack_sample_count);
-    current_node = function_node;
-  }
-  return current_node;
-}
 
 [[nodiscard]] static CallTreeUnwindErrorType*
 AddUnwindErrorToBottomUpViewAndReturnUnwindErrorTypeNode(CallTreeRoot* bottom_up_view_root,
@@ -293,6 +342,7 @@ std::unique_ptr<CallTreeView> CallTreeView::CreateBottomUpViewFromPostProcessedS
   ORBIT_SCOPED_TIMED_LOG("CreateBottomUpViewFromPostProcessedSamplingData");
 
   auto bottom_up_view_root = std::make_unique<CallTreeRoot>();
+  std::vector<std::unique_ptr<CallTreeCallstack>> callstacks;
   const std::string& process_name = capture_data->process_name();
   const absl::flat_hash_map<uint32_t, std::string>& thread_names = capture_data->thread_names();
 
@@ -310,14 +360,21 @@ std::unique_ptr<CallTreeView> CallTreeView::CreateBottomUpViewFromPostProcessedS
 
       const CallstackInfo& resolved_callstack =
           post_processed_sampling_data.GetResolvedCallstack(callstack_id);
-      CallTreeNode* last_node{};
       if (resolved_callstack.type() == CallstackType::kComplete) {
-        last_node = AddReversedCallstackToBottomUpViewAndReturnLastFunction(
-            bottom_up_view_root.get(), resolved_callstack, sample_count);
-      } else {
-        last_node = AddUnwindErrorToBottomUpViewAndReturnUnwindErrorTypeNode(
-            bottom_up_view_root.get(), resolved_callstack, sample_count);
+        // The nodes for the frames and the thread are only created when they are expanded.
+        auto callstack = std::make_unique<CallTreeCallstack>();
+        callstack->frames = resolved_callstack.frames();
+        callstack->thread_id = tid;
+        callstack->thread_name = GetThreadName(tid, process_name, thread_names);
+        callstack->callstack_events.assign(callstack_events.begin(), callstack_events.end());
+        callstack->sample_count = sample_count;
+        bottom_up_view_root->AddPendingCallstack(callstack.get());
+        callstacks.push_back(std::move(callstack));
+        continue;
       }
+
+      CallTreeNode* last_node = AddUnwindErrorToBottomUpViewAndReturnUnwindErrorTypeNode(
+          bottom_up_view_root.get(), resolved_callstack, sample_count);
       CallTreeThread* thread_node =
           GetOrCreateThreadNode(last_node, tid, process_name, thread_names);
       thread_node->IncreaseSampleCount(sample_count);
@@ -325,6 +382,6 @@ std::unique_ptr<CallTreeView> CallTreeView::CreateBottomUpViewFromPostProcessedS
     }
   }
 
-  return absl::WrapUnique<CallTreeView>(
-      new CallTreeView(std::move(bottom_up_view_root), module_manager, capture_data));
+  return absl::WrapUnique<CallTreeView>(new CallTreeView(
+      std::move(bottom_up_view_root), std::move(callstacks), module_manager, capture_data));
 }
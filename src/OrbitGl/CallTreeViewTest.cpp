@@ -0,0 +1,151 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/container/flat_hash_set.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ClientData/CallstackEvent.h"
+#include "ClientData/CallstackInfo.h"
+#include "ClientData/CallstackType.h"
+#include "ClientData/CaptureData.h"
+#include "ClientData/ModuleIdentifierProvider.h"
+#include "ClientData/ModuleManager.h"
+#include "ClientData/PostProcessedSamplingData.h"
+#include "ClientModel/SamplingDataPostProcessor.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitGl/CallTreeView.h"
+
+using orbit_client_data::CallstackEvent;
+using orbit_client_data::CallstackInfo;
+using orbit_client_data::CallstackType;
+using orbit_client_data::CaptureData;
+
+namespace {
+
+constexpr uint32_t kThreadId = 42;
+constexpr uint64_t kCallstackId1 = 1;
+constexpr uint64_t kCallstackId2 = 2;
+constexpr uint64_t kOuterFunction = 0x30;
+constexpr uint64_t kMiddleFunction = 0x20;
+constexpr uint64_t kInnerFunction1 = 0x10;
+constexpr uint64_t kInnerFunction2 = 0x11;
+
+class CallTreeViewTest : public testing::Test {
+ public:
+  CallTreeViewTest()
+      : capture_data_{orbit_grpc_protos::CaptureStarted{}, std::nullopt,
+                      absl::flat_hash_set<uint64_t>{}, CaptureData::DataSource::kLiveCapture,
+                      &module_identifier_provider_} {
+    // The frames of a callstack start with the innermost one.
+    capture_data_.AddUniqueCallstack(
+        kCallstackId1, CallstackInfo{{kInnerFunction1, kMiddleFunction, kOuterFunction},
+                                     CallstackType::kComplete});
+    capture_data_.AddUniqueCallstack(
+        kCallstackId2, CallstackInfo{{kInnerFunction2, kMiddleFunction, kOuterFunction},
+                                     CallstackType::kComplete});
+    capture_data_.AddCallstackEvent(CallstackEvent{1000, kCallstackId1, kThreadId});
+    capture_data_.AddCallstackEvent(CallstackEvent{2000, kCallstackId1, kThreadId});
+    capture_data_.AddCallstackEvent(CallstackEvent{3000, kCallstackId2, kThreadId});
+
+    sampling_data_ = orbit_client_model::CreatePostProcessedSamplingData(
+        capture_data_.GetCallstackData(), capture_data_, module_manager_);
+  }
+
+ protected:
+  orbit_client_data::ModuleIdentifierProvider module_identifier_provider_;
+  orbit_client_data::ModuleManager module_manager_{&module_identifier_provider_};
+  CaptureData capture_data_;
+  orbit_client_data::PostProcessedSamplingData sampling_data_;
+};
+
+[[nodiscard]] const CallTreeFunction* GetFunctionChild(const CallTreeNode& node,
+                                                       uint64_t function_address) {
+  for (const CallTreeNode* child : node.children()) {
+    const auto* function = dynamic_cast<const CallTreeFunction*>(child);
+    if (function != nullptr && function->function_absolute_address() == function_address) {
+      return function;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST_F(CallTreeViewTest, TopDownViewCreatesChildrenWhenNeeded) {
+  std::unique_ptr<CallTreeView> view = CallTreeView::CreateTopDownViewFromPostProcessedSamplingData(
+      sampling_data_, &module_manager_, &capture_data_);
+  EXPECT_EQ(view->sample_count(), 3);
+
+  const CallTreeRoot* root = view->GetCallTreeRoot();
+  ASSERT_EQ(root->child_count(), 1);
+  const auto* thread = dynamic_cast<const CallTreeThread*>(root->children()[0]);
+  ASSERT_NE(thread, nullptr);
+  EXPECT_EQ(thread->thread_id(), kThreadId);
+  EXPECT_EQ(thread->sample_count(), 3);
+  EXPECT_EQ(thread->GetExclusiveSampleCount(), 0);
+
+  ASSERT_EQ(thread->child_count(), 1);
+  const CallTreeFunction* outer = GetFunctionChild(*thread, kOuterFunction);
+  ASSERT_NE(outer, nullptr);
+  EXPECT_EQ(outer->sample_count(), 3);
+
+  ASSERT_EQ(outer->child_count(), 1);
+  const CallTreeFunction* middle = GetFunctionChild(*outer, kMiddleFunction);
+  ASSERT_NE(middle, nullptr);
+  EXPECT_EQ(middle->sample_count(), 3);
+  EXPECT_EQ(middle->GetExclusiveSampleCount(), 0);
+
+  ASSERT_EQ(middle->child_count(), 2);
+  const CallTreeFunction* inner1 = GetFunctionChild(*middle, kInnerFunction1);
+  ASSERT_NE(inner1, nullptr);
+  EXPECT_EQ(inner1->sample_count(), 2);
+  EXPECT_EQ(inner1->GetExclusiveSampleCount(), 2);
+  EXPECT_EQ(inner1->child_count(), 0);
+
+  const CallTreeFunction* inner2 = GetFunctionChild(*middle, kInnerFunction2);
+  ASSERT_NE(inner2, nullptr);
+  EXPECT_EQ(inner2->sample_count(), 1);
+  EXPECT_EQ(inner2->GetExclusiveSampleCount(), 1);
+  EXPECT_EQ(inner2->child_count(), 0);
+}
+
+TEST_F(CallTreeViewTest, BottomUpViewCreatesChildrenWhenNeeded) {
+  std::unique_ptr<CallTreeView> view =
+      CallTreeView::CreateBottomUpViewFromPostProcessedSamplingData(
+          sampling_data_, &module_manager_, &capture_data_);
+  EXPECT_EQ(view->sample_count(), 3);
+
+  const CallTreeRoot* root = view->GetCallTreeRoot();
+  ASSERT_EQ(root->child_count(), 2);
+  const CallTreeFunction* inner1 = GetFunctionChild(*root, kInnerFunction1);
+  ASSERT_NE(inner1, nullptr);
+  EXPECT_EQ(inner1->sample_count(), 2);
+  const CallTreeFunction* inner2 = GetFunctionChild(*root, kInnerFunction2);
+  ASSERT_NE(inner2, nullptr);
+  EXPECT_EQ(inner2->sample_count(), 1);
+
+  ASSERT_EQ(inner1->child_count(), 1);
+  const CallTreeFunction* middle = GetFunctionChild(*inner1, kMiddleFunction);
+  ASSERT_NE(middle, nullptr);
+  EXPECT_EQ(middle->sample_count(), 2);
+
+  ASSERT_EQ(middle->child_count(), 1);
+  const CallTreeFunction* outer = GetFunctionChild(*middle, kOuterFunction);
+  ASSERT_NE(outer, nullptr);
+  EXPECT_EQ(outer->sample_count(), 2);
+
+  ASSERT_EQ(outer->child_count(), 1);
+  const auto* thread = dynamic_cast<const CallTreeThread*>(outer->children()[0]);
+  ASSERT_NE(thread, nullptr);
+  EXPECT_EQ(thread->thread_id(), kThreadId);
+  EXPECT_EQ(thread->sample_count(), 2);
+  EXPECT_EQ(thread->GetExclusiveSampleCount(), 2);
+  EXPECT_EQ(thread->child_count(), 0);
+}
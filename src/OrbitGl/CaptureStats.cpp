@@ -4,6 +4,7 @@
 
 #include "OrbitGl/CaptureStats.h"
 
+#include <absl/strings/str_format.h>
 #include <absl/types/span.h>
 
 #include <utility>
@@ -37,5 +38,35 @@ ErrorMessageOr<void> CaptureStats::Generate(CaptureWindow* capture_window, uint6
   };
   SchedulingStats scheduling_stats(sched_scopes, thread_name_provider, start_ns, end_ns);
   summary_ = scheduling_stats.ToString();
+  if (capture_data->perf_event_processing_stats().has_value()) {
+    summary_ += FormatPerfEventProcessingStats(capture_data->perf_event_processing_stats().value());
+  }
   return outcome::success();
 }
+
+std::string CaptureStats::FormatPerfEventProcessingStats(
+    const orbit_grpc_protos::PerfEventProcessingStatsEvent& perf_event_processing_stats) {
+  uint64_t total_processing_time_ns = 0;
+  for (const orbit_grpc_protos::PerfEventVisitorStats& visitor_stats :
+       perf_event_processing_stats.visitor_stats()) {
+    total_processing_time_ns += visitor_stats.processing_time_ns();
+  }
+
+  std::string result = "Perf event processing (whole capture):\n";
+  for (const orbit_grpc_protos::PerfEventVisitorStats& visitor_stats :
+       perf_event_processing_stats.visitor_stats()) {
+    const double time_ms = static_cast<double>(visitor_stats.processing_time_ns()) / 1'000'000;
+    const double fraction = total_processing_time_ns == 0
+                                ? 0
+                                : static_cast<double>(visitor_stats.processing_time_ns()) /
+                                      static_cast<double>(total_processing_time_ns);
+    const double ns_per_event = visitor_stats.event_count() == 0
+                                    ? 0
+                                    : static_cast<double>(visitor_stats.processing_time_ns()) /
+                                          static_cast<double>(visitor_stats.event_count());
+    absl::StrAppendFormat(&result, "  %s: %.3f ms (%.1f%%), %u events, %.0f ns/event\n",
+                          visitor_stats.name(), time_ms, fraction * 100,
+                          visitor_stats.event_count(), ns_per_event);
+  }
+  return result;
+}
@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "ClientProtos/capture_data.pb.h"
+#include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Result.h"
 #include "OrbitGl/CaptureStats.h"
 #include "OrbitGl/SchedulingStats.h"
@@ -24,6 +25,25 @@ TEST(CaptureStats, NullCaptureWindow) {
   EXPECT_EQ(result.has_error(), true);
 }
 
+TEST(CaptureStats, FormatPerfEventProcessingStats) {
+  orbit_grpc_protos::PerfEventProcessingStatsEvent perf_event_processing_stats;
+  orbit_grpc_protos::PerfEventVisitorStats* unwinding_visitor_stats =
+      perf_event_processing_stats.add_visitor_stats();
+  unwinding_visitor_stats->set_name("UprobesUnwindingVisitor");
+  unwinding_visitor_stats->set_processing_time_ns(3'000'000);
+  unwinding_visitor_stats->set_event_count(1000);
+  orbit_grpc_protos::PerfEventVisitorStats* gpu_visitor_stats =
+      perf_event_processing_stats.add_visitor_stats();
+  gpu_visitor_stats->set_name("GpuTracepointVisitor");
+  gpu_visitor_stats->set_processing_time_ns(1'000'000);
+  gpu_visitor_stats->set_event_count(1000);
+
+  EXPECT_EQ(CaptureStats::FormatPerfEventProcessingStats(perf_event_processing_stats),
+            "Perf event processing (whole capture):\n"
+            "  UprobesUnwindingVisitor: 3.000 ms (75.0%), 1000 events, 3000 ns/event\n"
+            "  GpuTracepointVisitor: 1.000 ms (25.0%), 1000 events, 1000 ns/event\n");
+}
+
 TEST(SchedulingStats, ZeroSchedulingScopes) {
   std::vector<const orbit_client_protos::TimerInfo*> scheduling_scopes;
   SchedulingStats::ThreadNameProvider thread_name_provider = [](uint32_t thread_id) {
@@ -12,9 +12,11 @@
 #include <string_view>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "Introspection/Introspection.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/TaskGroup.h"
 #include "OrbitGl/BatchRenderGroup.h"
 #include "OrbitGl/Viewport.h"
 
@@ -64,6 +66,28 @@ void CaptureViewElement::UpdatePrimitives(PrimitiveAssembler& primitive_assemble
   PostRender(std::move(previous_groups), primitive_assembler, text_renderer);
 }
 
+void CaptureViewElement::PrepareUpdatePrimitives(uint64_t min_tick, uint64_t max_tick) {
+  ORBIT_SCOPE_FUNCTION;
+  std::vector<CaptureViewElement*> elements;
+  CollectElementsToUpdatePrimitives(&elements);
+
+  orbit_base::TaskGroup task_group;
+  for (CaptureViewElement* element : elements) {
+    task_group.AddTask(
+        [element, min_tick, max_tick] { element->DoPrepareUpdatePrimitives(min_tick, max_tick); });
+  }
+  task_group.Wait();
+}
+
+// Follows the same traversal as UpdatePrimitives.
+void CaptureViewElement::CollectElementsToUpdatePrimitives(
+    std::vector<CaptureViewElement*>* elements) {
+  elements->push_back(this);
+  for (CaptureViewElement* child : GetChildrenVisibleInViewport()) {
+    if (child->ShouldBeRendered()) child->CollectElementsToUpdatePrimitives(elements);
+  }
+}
+
 CaptureViewElement::EventResult CaptureViewElement::OnMouseWheel(
     const Vec2& /*mouse_pos*/, int /*delta*/, const ModifierKeys& /*modifiers*/) {
   return EventResult::kIgnored;
@@ -96,7 +120,7 @@ void CaptureViewElement::UpdateLayout() {
   DoUpdateLayout();
 
   // Recurse into children
-  for (CaptureViewElement* child : GetAllChildren()) {
+  for (CaptureViewElement* child : GetChildrenToUpdateLayout()) {
     child->UpdateLayout();
   }
 }
@@ -71,6 +71,12 @@ using orbit_gl::TextRenderer;
 constexpr const char* kTimingDraw = "Draw";
 constexpr const char* kTimingDrawAndUpdatePrimitives = "Draw & Update Primitives";
 constexpr const char* kTimingFrame = "Complete Frame";
+// The phases of a frame. Primitive update and batching only run in frames that update the
+// primitives. GL submit only measures the CPU time of issuing the draw calls.
+constexpr const char* kTimingPrimitiveUpdate = "Primitive Update";
+constexpr const char* kTimingBatching = "Batching";
+constexpr const char* kTimingGlSubmit = "GL Submit";
+constexpr const char* kTimingTextRendering = "Text Rendering";
 
 class AccessibleCaptureWindow : public AccessibleWidgetBridge {
  public:
@@ -108,6 +114,10 @@ CaptureWindow::CaptureWindow(
   scoped_frame_times_[kTimingDrawAndUpdatePrimitives] =
       std::make_unique<orbit_gl::SimpleTimings>(30);
   scoped_frame_times_[kTimingFrame] = std::make_unique<orbit_gl::SimpleTimings>(30);
+  for (const char* timing : {kTimingPrimitiveUpdate, kTimingBatching, kTimingGlSubmit,
+                             kTimingTextRendering}) {
+    scoped_frame_times_[timing] = std::make_unique<orbit_gl::SimpleTimings>(30);
+  }
 }
 
 void CaptureWindow::PreRender() {
@@ -491,7 +501,10 @@ void CaptureWindow::SetIsMouseOver(bool value) {
   }
 }
 
-bool CaptureWindow::ShouldAutoZoom() const { return capture_client_app_->IsCapturing(); }
+bool CaptureWindow::ShouldAutoZoom() const {
+  // A loading capture grows like a live one, as its events are processed in the order of the file.
+  return capture_client_app_->IsCapturing() || (app_ != nullptr && app_->IsLoadingCapture());
+}
 
 std::unique_ptr<AccessibleInterface> CaptureWindow::CreateAccessibleInterface() {
   return std::make_unique<AccessibleCaptureWindow>(this);
@@ -529,14 +542,22 @@ void CaptureWindow::Draw(QPainter* painter) {
     if (draw_help_) {
       RenderHelpUi();
     }
+    if (time_graph_layout_->GetDrawFrameTimings()) {
+      RenderFrameTimingsUi();
+    }
   }
 
   if (picking_mode_ == PickingMode::kNone) {
     double update_duration_in_ms = (orbit_base::CaptureTimestampNs() - start_time_ns) / 1000000.0;
     if (update_primitives_was_needed) {
-      scoped_frame_times_[kTimingDrawAndUpdatePrimitives]->PushTimeMs(update_duration_in_ms);
+      PushFrameTimeMs(kTimingDrawAndUpdatePrimitives, update_duration_in_ms);
     } else {
-      scoped_frame_times_[kTimingDraw]->PushTimeMs(update_duration_in_ms);
+      PushFrameTimeMs(kTimingDraw, update_duration_in_ms);
+    }
+    if (time_graph_ != nullptr && time_graph_->GetLastUpdatePrimitivesTimings().has_value()) {
+      PushFrameTimeMs(kTimingPrimitiveUpdate,
+                      time_graph_->GetLastUpdatePrimitivesTimings()->query_ms);
+      PushFrameTimeMs(kTimingBatching, time_graph_->GetLastUpdatePrimitivesTimings()->batching_ms);
     }
   }
 
@@ -546,36 +567,71 @@ void CaptureWindow::Draw(QPainter* painter) {
     if (last_frame_start_time_ != 0) {
       double frame_duration_in_ms =
           (orbit_base::CaptureTimestampNs() - last_frame_start_time_) / 1000000.0;
-      scoped_frame_times_[kTimingFrame]->PushTimeMs(frame_duration_in_ms);
+      PushFrameTimeMs(kTimingFrame, frame_duration_in_ms);
     }
   }
 
   last_frame_start_time_ = orbit_base::CaptureTimestampNs();
 }
 
-void CaptureWindow::RenderAllLayers(QPainter* painter) {
+std::vector<orbit_gl::BatchRenderGroupId> CaptureWindow::GetSortedRenderGroups() const {
+  ORBIT_SCOPE("Layer gathering and sorting");
   std::vector<orbit_gl::BatchRenderGroupId> all_groups_sorted{};
-
-  {
-    ORBIT_SCOPE("Layer gathering and sorting");
-    if (time_graph_ != nullptr) {
-      all_groups_sorted = time_graph_->GetBatcher().GetNonEmptyRenderGroups();
-      orbit_base::Append(all_groups_sorted, time_graph_->GetTextRenderer()->GetRenderGroups());
+  if (time_graph_ != nullptr) {
+    all_groups_sorted = time_graph_->GetBatcher().GetNonEmptyRenderGroups();
+    orbit_base::Append(all_groups_sorted, time_graph_->GetTextRenderer()->GetRenderGroups());
+  }
+  orbit_base::Append(all_groups_sorted, ui_batcher_.GetNonEmptyRenderGroups());
+  orbit_base::Append(all_groups_sorted, text_renderer_.GetRenderGroups());
+
+  // Sort and remove duplicates.
+  std::sort(all_groups_sorted.begin(), all_groups_sorted.end());
+  auto it = std::unique(all_groups_sorted.begin(), all_groups_sorted.end());
+  all_groups_sorted.erase(it, all_groups_sorted.end());
+  return all_groups_sorted;
+}
+
+PickingId CaptureWindow::GetPickingIdAt(int x, int y) {
+  ORBIT_SCOPE_FUNCTION;
+  // The center of the pixel, which is where the picking frame would be sampled.
+  const Vec2 pos(static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f);
+  const std::vector<orbit_gl::BatchRenderGroupId> sorted_groups = GetSortedRenderGroups();
+  // Later groups, and for each group the ui batcher, are drawn on top.
+  for (auto group_it = sorted_groups.rbegin(); group_it != sorted_groups.rend(); ++group_it) {
+    orbit_gl::StencilConfig stencil = render_group_manager_.GetGroupState(group_it->name).stencil;
+    if (stencil.enabled) {
+      Vec2i stencil_screen_pos = viewport_.WorldToScreen(Vec2(stencil.pos[0], stencil.pos[1]));
+      Vec2i stencil_screen_size = viewport_.WorldToScreen(Vec2(stencil.size[0], stencil.size[1]));
+      if (x < stencil_screen_pos[0] || x >= stencil_screen_pos[0] + stencil_screen_size[0] ||
+          y < stencil_screen_pos[1] || y >= stencil_screen_pos[1] + stencil_screen_size[1]) {
+        continue;
+      }
     }
-    orbit_base::Append(all_groups_sorted, ui_batcher_.GetNonEmptyRenderGroups());
-    orbit_base::Append(all_groups_sorted, text_renderer_.GetRenderGroups());
 
-    // Sort and remove duplicates.
-    std::sort(all_groups_sorted.begin(), all_groups_sorted.end());
-    auto it = std::unique(all_groups_sorted.begin(), all_groups_sorted.end());
-    all_groups_sorted.erase(it, all_groups_sorted.end());
+    if (std::optional<PickingId> id = ui_batcher_.PickRenderGroup(*group_it, pos)) return *id;
+    if (time_graph_ == nullptr) continue;
+    if (std::optional<PickingId> id = time_graph_->GetBatcher().PickRenderGroup(*group_it, pos)) {
+      return *id;
+    }
   }
+  // What the cleared picking frame would hold.
+  return PickingId::FromPixelValue(0);
+}
+
+void CaptureWindow::RenderAllLayers(QPainter* painter) {
+  // Picking is resolved on the CPU, see GetPickingIdAt, so the picking frame only needs to be drawn
+  // when it is shown.
+  if (picking_mode_ != PickingMode::kNone && !draw_as_if_picking_) return;
+
+  const std::vector<orbit_gl::BatchRenderGroupId> all_groups_sorted = GetSortedRenderGroups();
 
   if (time_graph_layout_->GetRenderDebugLayers() && picking_mode_ == PickingMode::kNone) {
     DrawLayerDebugInfo(all_groups_sorted, painter);
     return;
   }
 
+  uint64_t gl_submit_duration_ns = 0;
+  uint64_t text_rendering_duration_ns = 0;
   for (const orbit_gl::BatchRenderGroupId& group : all_groups_sorted) {
     orbit_gl::StencilConfig stencil = render_group_manager_.GetGroupState(group.name).stencil;
     if (stencil.enabled) {
@@ -588,10 +644,12 @@ void CaptureWindow::RenderAllLayers(QPainter* painter) {
       painter->setClipping(false);
     }
 
+    const uint64_t gl_submit_start_ns = orbit_base::CaptureTimestampNs();
     if (time_graph_ != nullptr) {
       time_graph_->GetBatcher().DrawRenderGroup(group, picking_mode_ != PickingMode::kNone);
     }
     ui_batcher_.DrawRenderGroup(group, picking_mode_ != PickingMode::kNone);
+    gl_submit_duration_ns += orbit_base::CaptureTimestampNs() - gl_submit_start_ns;
 
     // The painter is in "native painting mode" all the time and we merely leave it for rendering
     // the text here. Compare GlCanvas::Render - that's where we enter native painting.
@@ -599,16 +657,30 @@ void CaptureWindow::RenderAllLayers(QPainter* painter) {
     painter->endNativePainting();
 
     if (picking_mode_ == PickingMode::kNone) {
+      const uint64_t text_rendering_start_ns = orbit_base::CaptureTimestampNs();
       text_renderer_.DrawRenderGroup(painter, render_group_manager_, group);
       if (time_graph_ != nullptr) {
         ORBIT_SCOPE("CaptureWindow: Text Rendering");
         time_graph_->GetTextRenderer()->DrawRenderGroup(painter, render_group_manager_, group);
       }
+      text_rendering_duration_ns += orbit_base::CaptureTimestampNs() - text_rendering_start_ns;
     }
 
     painter->beginNativePainting();
     PrepareGlState();
   }
+
+  if (picking_mode_ == PickingMode::kNone) {
+    PushFrameTimeMs(kTimingGlSubmit, static_cast<double>(gl_submit_duration_ns) / 1000000.0);
+    PushFrameTimeMs(kTimingTextRendering,
+                    static_cast<double>(text_rendering_duration_ns) / 1000000.0);
+  }
+}
+
+void CaptureWindow::PushFrameTimeMs(const char* timing_name, double time_ms) {
+  scoped_frame_times_.at(timing_name)->PushTimeMs(time_ms);
+  // Makes the timings show up as value tracks when Orbit profiles itself.
+  ORBIT_DOUBLE(absl::StrFormat("CaptureWindow: %s (ms)", timing_name).c_str(), time_ms);
 }
 
 void CaptureWindow::ToggleRecording() {
@@ -620,8 +692,12 @@ void CaptureWindow::ToggleRecording() {
 }
 
 bool CaptureWindow::ShouldSkipRendering() const {
-  // Don't render when loading a capture to avoid contention with the loading thread.
-  return app_->IsLoadingCapture();
+  // While loading a capture, only render a few frames per second. This shows the tracks loaded so
+  // far while limiting the contention with the loading thread. Skipped frames don't update
+  // last_frame_start_time_.
+  constexpr uint64_t kMinLoadingCaptureFrameIntervalNs = 250'000'000;
+  return app_->IsLoadingCapture() && orbit_base::CaptureTimestampNs() - last_frame_start_time_ <
+                                         kMinLoadingCaptureFrameIntervalNs;
 }
 
 void CaptureWindow::set_draw_help(bool draw_help) {
@@ -752,6 +828,32 @@ void CaptureWindow::RenderHelpUi() {
                                      GlCanvas::kZValueUi, kRoundingRadius, box_color, kMargin);
 }
 
+void CaptureWindow::RenderFrameTimingsUi() {
+  std::string frame_timings;
+  for (const auto& [name, timings] : scoped_frame_times_) {
+    absl::StrAppendFormat(&frame_timings, "%s: avg %.2f ms, max %.2f ms\n", name,
+                          timings->GetAverageTimeMs(), timings->GetMaxTimeMs());
+  }
+
+  // Placed at the bottom left, so that it doesn't hide the help.
+  constexpr int kOffset = 30;
+  Vec2 world_pos = viewport_.ScreenToWorld(Vec2i(kOffset, viewport_.GetScreenHeight() - kOffset));
+  TextRenderer::TextFormatting formatting{time_graph_layout_->GetFontSize(),
+                                          Color(255, 255, 255, 255), -1.f /*max_size*/};
+  formatting.valign = TextRenderer::VAlign::Bottom;
+
+  Vec2 text_bounding_box_pos;
+  Vec2 text_bounding_box_size;
+  text_renderer_.AddText(frame_timings.c_str(), world_pos[0], world_pos[1], GlCanvas::kZValueUi,
+                         formatting, &text_bounding_box_pos, &text_bounding_box_size);
+
+  const Color box_color(50, 50, 50, 243);
+  constexpr float kMargin = 10.f;
+  constexpr float kRoundingRadius = 10.f;
+  primitive_assembler_.AddRoundedBox(text_bounding_box_pos, text_bounding_box_size,
+                                     GlCanvas::kZValueUi, kRoundingRadius, box_color, kMargin);
+}
+
 std::string CaptureWindow::GetHelpText() const {
   decltype(auto) help_message{
       u8"Start/Stop Capture: F5\n\n"
@@ -170,12 +170,18 @@ std::string FrameTrack::GetTooltip() const {
       "<b>Frame count:</b> %u<br/>"
       "<b>Maximum frame time:</b> %s<br/>"
       "<b>Minimum frame time:</b> %s<br/>"
-      "<b>Average frame time:</b> %s<br/>",
+      "<b>Average frame time:</b> %s<br/>"
+      "<b>Median frame time:</b> %s<br/>"
+      "<b>95th percentile frame time:</b> %s<br/>"
+      "<b>99th percentile frame time:</b> %s<br/>",
       function_name, kHeightCapAverageMultipleUint64, function_name,
       std::filesystem::path(function_.module_path()).filename().string(), stats_.count(),
       orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats_.max_ns())),
       orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats_.min_ns())),
-      orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats_.ComputeAverageTimeNs())));
+      orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats_.ComputeAverageTimeNs())),
+      orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats_.ComputePercentileNs(50))),
+      orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats_.ComputePercentileNs(95))),
+      orbit_display_formats::GetDisplayTime(absl::Nanoseconds(stats_.ComputePercentileNs(99))));
 }
 
 std::string FrameTrack::GetBoxTooltip(const PrimitiveAssembler& primitive_assembler,
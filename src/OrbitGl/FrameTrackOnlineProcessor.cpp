@@ -8,6 +8,7 @@
 #include <absl/container/flat_hash_set.h>
 
 #include <limits>
+#include <optional>
 #include <utility>
 
 #include "ClientData/CaptureData.h"
@@ -36,6 +37,7 @@ FrameTrackOnlineProcessor::FrameTrackOnlineProcessor(
     current_frame_track_function_ids_.insert(function_id);
     function_id_to_previous_timestamp_ns_.insert(
         std::make_pair(function_id, std::numeric_limits<uint64_t>::max()));
+    function_id_to_recent_frame_time_stats_.try_emplace(function_id, kRecentFrameTimesWindowSize);
   }
 }
 
@@ -56,6 +58,8 @@ void FrameTrackOnlineProcessor::ProcessTimer(const orbit_client_protos::TimerInf
     CreateFrameTrackTimer(function_id, previous_timestamp_ns, timer_info.start(),
                           current_frame_index_++, &frame_timer);
     time_graph_->ProcessTimer(frame_timer);
+    function_id_to_recent_frame_time_stats_.at(function_id)
+        .AddFrameTime(timer_info.start() - previous_timestamp_ns);
     function_id_to_previous_timestamp_ns_[function_id] = timer_info.start();
   }
 }
@@ -64,11 +68,20 @@ void FrameTrackOnlineProcessor::AddFrameTrack(uint64_t function_id) {
   current_frame_track_function_ids_.insert(function_id);
   function_id_to_previous_timestamp_ns_.insert(
       std::make_pair(function_id, std::numeric_limits<uint64_t>::max()));
+  function_id_to_recent_frame_time_stats_.try_emplace(function_id, kRecentFrameTimesWindowSize);
 }
 
 void FrameTrackOnlineProcessor::RemoveFrameTrack(uint64_t function_id) {
   current_frame_track_function_ids_.erase(function_id);
   function_id_to_previous_timestamp_ns_.erase(function_id);
+  function_id_to_recent_frame_time_stats_.erase(function_id);
+}
+
+std::optional<RollingFrameTimeStats::Summary>
+FrameTrackOnlineProcessor::ComputeRecentFrameTimeStats(uint64_t function_id) const {
+  auto it = function_id_to_recent_frame_time_stats_.find(function_id);
+  if (it == function_id_to_recent_frame_time_stats_.end()) return std::nullopt;
+  return it->second.ComputeSummary();
 }
 
 }  // namespace orbit_gl
\ No newline at end of file
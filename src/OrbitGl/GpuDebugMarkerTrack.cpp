@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <memory>
 #include <optional>
+#include <string_view>
 
 #include "ClientProtos/capture_data.pb.h"
 #include "DisplayFormats/DisplayFormats.h"
@@ -69,7 +70,7 @@ Color GpuDebugMarkerTrack::GetTimerColor(const TimerInfo& timer_info, bool is_se
             static_cast<uint8_t>(timer_info.color().blue()),
             static_cast<uint8_t>(timer_info.color().alpha())};
   }
-  std::string marker_text = string_manager_->Get(timer_info.user_data_key()).value_or("");
+  std::string_view marker_text = string_manager_->GetView(timer_info.user_data_key()).value_or("");
   return TimeGraph::GetColor(marker_text);
 }
 
@@ -77,8 +78,8 @@ std::string GpuDebugMarkerTrack::GetTimesliceText(const TimerInfo& timer_info) c
   ORBIT_CHECK(timer_info.type() == TimerInfo::kGpuDebugMarker);
 
   std::string time = GetDisplayTime(timer_info);
-  return absl::StrFormat("%s  %s", string_manager_->Get(timer_info.user_data_key()).value_or(""),
-                         time);
+  return absl::StrFormat(
+      "%s  %s", string_manager_->GetView(timer_info.user_data_key()).value_or(""), time);
 }
 
 std::string GpuDebugMarkerTrack::GetBoxTooltip(const PrimitiveAssembler& primitive_assembler,
@@ -90,7 +91,7 @@ std::string GpuDebugMarkerTrack::GetBoxTooltip(const PrimitiveAssembler& primiti
 
   ORBIT_CHECK(timer_info->type() == TimerInfo::kGpuDebugMarker);
 
-  std::string marker_text = string_manager_->Get(timer_info->user_data_key()).value_or("");
+  std::string_view marker_text = string_manager_->GetView(timer_info->user_data_key()).value_or("");
   return absl::StrFormat(
       "<b>Vulkan Debug Marker</b><br/>"
       "<i>At the marker's begin and end `vkCmdWriteTimestamp`s have been "
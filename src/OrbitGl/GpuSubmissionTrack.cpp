@@ -9,6 +9,7 @@
 
 #include <memory>
 #include <optional>
+#include <string_view>
 
 #include "ClientData/TimerChain.h"
 #include "ClientProtos/capture_data.pb.h"
@@ -106,7 +107,7 @@ Color GpuSubmissionTrack::GetTimerColor(const TimerInfo& timer_info, bool is_sel
   // We disambiguate the different types of GPU activity based on the
   // string that is displayed on their timeslice.
   float coeff = 1.0f;
-  std::string gpu_stage = string_manager_->Get(timer_info.user_data_key()).value_or("");
+  std::string_view gpu_stage = string_manager_->GetView(timer_info.user_data_key()).value_or("");
   if (gpu_stage == kSwQueueString) {
     coeff = 0.5f;
   } else if (gpu_stage == kHwQueueString) {
@@ -160,7 +161,7 @@ float GpuSubmissionTrack::GetYFromTimer(const TimerInfo& timer_info) const {
 // When track or its parent is collapsed, only draw "hardware execution" timers.
 bool GpuSubmissionTrack::TimerFilter(const TimerInfo& timer_info) const {
   if (IsCollapsed()) {
-    std::string gpu_stage = string_manager_->Get(timer_info.user_data_key()).value_or("");
+    std::string_view gpu_stage = string_manager_->GetView(timer_info.user_data_key()).value_or("");
     return gpu_stage == kHwExecutionString;
   }
   return true;
@@ -171,8 +172,8 @@ std::string GpuSubmissionTrack::GetTimesliceText(const TimerInfo& timer_info) co
               timer_info.type() == TimerInfo::kGpuCommandBuffer);
   std::string time = GetDisplayTime(timer_info);
 
-  return absl::StrFormat("%s  %s", string_manager_->Get(timer_info.user_data_key()).value_or(""),
-                         time);
+  return absl::StrFormat(
+      "%s  %s", string_manager_->GetView(timer_info.user_data_key()).value_or(""), time);
 }
 
 float GpuSubmissionTrack::GetHeight() const {
@@ -209,7 +210,7 @@ std::string GpuSubmissionTrack::GetBoxTooltip(const PrimitiveAssembler& primitiv
     return "";
   }
 
-  std::string gpu_stage = string_manager_->Get(timer_info->user_data_key()).value_or("");
+  std::string_view gpu_stage = string_manager_->GetView(timer_info->user_data_key()).value_or("");
   if (gpu_stage == kSwQueueString) {
     return GetSwQueueTooltip(*timer_info);
   }
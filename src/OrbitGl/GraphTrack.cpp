@@ -11,20 +11,16 @@
 
 #include <algorithm>
 #include <array>
-#include <iterator>
 #include <memory>
-#include <numeric>
 #include <optional>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 #include "ApiInterface/Orbit.h"
-#include "ClientData/FastRenderingUtils.h"
 #include "OrbitGl/BatcherInterface.h"
 #include "OrbitGl/Geometry.h"
 #include "OrbitGl/GlCanvas.h"
-#include "OrbitGl/GraphTrackDataAggregator.h"
 #include "OrbitGl/TextRenderer.h"
 #include "OrbitGl/TimeGraph.h"
 #include "OrbitGl/TimeGraphLayout.h"
@@ -245,71 +241,40 @@ void GraphTrack::DrawLegend(PrimitiveAssembler& primitive_assembler, TextRendere
 
 void GraphTrack::DrawSeries(PrimitiveAssembler& primitive_assembler, uint64_t min_tick,
                             uint64_t max_tick, float z) {
-  auto entries = series_.GetEntriesAffectedByTimeRange(min_tick, max_tick);
+  // For the stacked graph, computing y positions from the normalized values results in some
+  // floating error. Event if the sum of values is fixed, the top of the stacked graph may not be
+  // flat. To address this problem, we compute y positions from the normalized cumulative values.
+  // Entries in the same pixel come already merged, so the cost doesn't depend on the zoom level.
+  const uint32_t resolution_in_pixels = viewport_->WorldToScreen({GetWidth(), 0})[0];
+  auto entries = series_.GetDecimatedEntriesAffectedByTimeRange(
+      min_tick, max_tick, resolution_in_pixels,
+      orbit_gl::MultivariateTimeSeries::ValueKind::kStackedValues);
   if (entries.empty()) return;
 
   double min = GetGraphMinValue();
   double inverse_value_range = GetInverseOfGraphValueRange();
-  auto current_it = entries.begin();
-  auto last_it = std::prev(entries.end());
-
-  orbit_gl::GraphTrackDataAggregator aggr;
-
-  const uint32_t resolution_in_pixels = viewport_->WorldToScreen({GetWidth(), 0})[0];
-  uint64_t next_pixel_start_ns = orbit_client_data::GetNextPixelBoundaryTimeNs(
-      min_tick, resolution_in_pixels, min_tick, max_tick);
-
-  // We skip the last element because we can't calculate time passed between last element
-  // and the next one.
-  while (current_it != last_it) {
-    std::vector<double> cumulative_values = current_it->second;
-    std::partial_sum(cumulative_values.begin(), cumulative_values.end(), cumulative_values.begin());
-    // For the stacked graph, computing y positions from the normalized values results in some
-    // floating error. Event if the sum of values is fixed, the top of the stacked graph may not be
-    // flat. To address this problem, we compute y positions from the normalized cumulative values.
-    std::vector<float> normalized_cumulative_values(GetDimension());
-    std::transform(cumulative_values.begin(), cumulative_values.end(),
+  std::vector<float> normalized_cumulative_values(GetDimension());
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const orbit_gl::MultivariateTimeSeries::DecimatedEntry& entry = entries[i];
+    const bool is_last = i + 1 == entries.size();
+    // We skip the last entry on its own because we can't calculate time passed between it and the
+    // next one.
+    if (is_last && entry.first_time_ns == entry.last_time_ns) break;
+
+    uint64_t start_tick = std::max(entry.first_time_ns, min_tick);
+    uint64_t end_tick =
+        std::min(is_last ? entry.last_time_ns : entries[i + 1].first_time_ns, max_tick);
+    // When drawing we only use max values - for every usage of this track this is currently the
+    // best representation. If we draw multiple boxes on the same pixel, the largest box would
+    // overdraw the smaller ones.
+    std::transform(entry.max_values.begin(), entry.max_values.end(),
                    normalized_cumulative_values.begin(), [min, inverse_value_range](double value) {
                      return static_cast<float>((value - min) * inverse_value_range);
                    });
-
-    uint64_t current_time = std::max(current_it->first, min_tick);
-    auto next_it = std::next(current_it);
-    uint64_t next_time = std::min(next_it->first, max_tick);
-
-    if (aggr.GetAccumulatedEntry() == nullptr) {
-      aggr.SetEntry(current_time, next_time, normalized_cumulative_values);
-    } else {
-      // If the current data point fits into the same pixel as the entry we are currently
-      // accumulating.
-      if (current_time < next_pixel_start_ns) {
-        // Add the current data to accumulated_entry
-        aggr.MergeDataIntoEntry(current_time, next_time, normalized_cumulative_values);
-      } else {
-        // Otherwise, draw the accumulated_entry and start accumulating a new one
-        // When drawing we only use max values - for every usage of this track
-        // this is currently the best representation.
-        // If we draw multiple boxes on the same pixel, the largest box would
-        // overdraw the smaller ones.
-        DrawSingleSeriesEntry(primitive_assembler, aggr.GetAccumulatedEntry()->start_tick,
-                              aggr.GetAccumulatedEntry()->end_tick,
-                              aggr.GetAccumulatedEntry()->max_vals, z);
-
-        // Must be done before the next `SetEntry` call - we are using the end tick value of the
-        // current entry to calculate the next pixel border.
-        next_pixel_start_ns = orbit_client_data::GetNextPixelBoundaryTimeNs(
-            aggr.GetAccumulatedEntry()->end_tick, resolution_in_pixels, min_tick, max_tick);
-
-        aggr.SetEntry(current_time, next_time, normalized_cumulative_values);
-      }
-    }
-    current_it = next_it;
+    DrawSingleSeriesEntry(primitive_assembler, start_tick, end_tick, normalized_cumulative_values,
+                          z);
   }
-
-  // Draw the leftover entry
-  DrawSingleSeriesEntry(primitive_assembler, aggr.GetAccumulatedEntry()->start_tick,
-                        aggr.GetAccumulatedEntry()->end_tick, aggr.GetAccumulatedEntry()->max_vals,
-                        z);
 }
 
 void GraphTrack::DrawSingleSeriesEntry(PrimitiveAssembler& primitive_assembler, uint64_t start_tick,
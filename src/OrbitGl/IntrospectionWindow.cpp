@@ -175,12 +175,19 @@ class IntrospectionCaptureListener : public orbit_capture_client::CaptureListene
   void OnCallstackEvent(orbit_client_data::CallstackEvent /*callstack_event*/) override {
     ORBIT_UNREACHABLE();
   }
+  void OnPageFaultCallstackEvent(orbit_client_data::CallstackEvent /*callstack_event*/) override {
+    ORBIT_UNREACHABLE();
+  }
   void OnThreadName(uint32_t /*thread_id*/, std::string /*thread_name*/) override {
     ORBIT_UNREACHABLE();
   }
   void OnThreadStateSlice(orbit_client_data::ThreadStateSliceInfo /*thread_state_slice*/) override {
     ORBIT_UNREACHABLE();
   }
+  void OnOffCpuTimeSummary(
+      const orbit_grpc_protos::OffCpuTimeSummary& /*off_cpu_time_summary*/) override {
+    ORBIT_UNREACHABLE();
+  }
   void OnAddressInfo(orbit_client_data::LinuxAddressInfo /*address_info*/) override {
     ORBIT_UNREACHABLE();
   }
@@ -203,6 +210,14 @@ class IntrospectionCaptureListener : public orbit_capture_client::CaptureListene
   void OnPresentEvent(const orbit_grpc_protos::PresentEvent& /*present_event*/) override {
     ORBIT_UNREACHABLE();
   }
+  void OnPressureStallEvent(
+      const orbit_grpc_protos::PressureStallEvent& /*pressure_stall_event*/) override {
+    ORBIT_UNREACHABLE();
+  }
+  void OnPerformanceCounterSample(
+      const orbit_grpc_protos::PerformanceCounterSample& /*performance_counter_sample*/) override {
+    ORBIT_UNREACHABLE();
+  }
   void OnWarningEvent(orbit_grpc_protos::WarningEvent /*warning_event*/) override {
     ORBIT_UNREACHABLE();
   }
@@ -241,6 +256,10 @@ class IntrospectionCaptureListener : public orbit_capture_client::CaptureListene
                                         /*out_of_order_events_discarded_event*/) override {
     ORBIT_UNREACHABLE();
   }
+  void OnPerfEventProcessingStatsEvent(orbit_grpc_protos::PerfEventProcessingStatsEvent
+                                       /*perf_event_processing_stats_event*/) override {
+    ORBIT_UNREACHABLE();
+  }
 
   IntrospectionWindow* introspection_window_;
 };
@@ -9,14 +9,11 @@
 #include <stddef.h>
 
 #include <algorithm>
-#include <iterator>
 #include <utility>
 #include <vector>
 
-#include "ClientData/FastRenderingUtils.h"
 #include "OrbitGl/CoreMath.h"
 #include "OrbitGl/Geometry.h"
-#include "OrbitGl/GraphTrackDataAggregator.h"
 #include "OrbitGl/MultivariateTimeSeries.h"
 #include "OrbitGl/TimelineInfoInterface.h"
 #include "OrbitGl/Viewport.h"
@@ -60,104 +57,62 @@ float LineGraphTrack::GetLabelYFromValues(absl::Span<const double> values) const
 
 void LineGraphTrack::DrawSeries(PrimitiveAssembler& primitive_assembler, uint64_t min_tick,
                                 uint64_t max_tick, float z) {
-  auto entries = series_.GetEntriesAffectedByTimeRange(min_tick, max_tick);
+  // Entries in the same pixel come already merged, so the cost doesn't depend on the zoom level.
+  const uint32_t resolution_in_pixels = GetViewport()->WorldToScreen({GetWidth(), 0})[0];
+  auto entries = series_.GetDecimatedEntriesAffectedByTimeRange(
+      min_tick, max_tick, resolution_in_pixels, MultivariateTimeSeries::ValueKind::kValues);
   if (entries.empty()) return;
 
   double min = GetGraphMinValue();
   double inverse_value_range = GetInverseOfGraphValueRange();
 
-  auto curr_iterator = entries.begin();
-  auto last_iterator = std::prev(entries.end());
-
   // Normalized values that were last used for drawing.
   std::vector<float> prev_drawn_values =
-      GetNormalizedValues(curr_iterator->second, min, inverse_value_range);
+      GetNormalizedValues(entries.front().first_values, min, inverse_value_range);
+  // Each entry is drawn from the last time of the previous one.
+  uint64_t prev_end_tick = entries.front().first_time_ns;
+  bool is_last = false;
 
-  // Normalized values of the last entry we've iterated over.
-  std::vector<float> last_entry_values = prev_drawn_values;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const MultivariateTimeSeries::DecimatedEntry& entry = entries[i];
+    // A first entry on its own only provides the values to start from.
+    if (i == 0 && entry.first_time_ns == entry.last_time_ns) continue;
+    is_last = i + 1 == entries.size() && entry.last_time_ns >= max_tick;
 
-  GraphTrackDataAggregator aggr;
-
-  const uint32_t resolution_in_pixels = GetViewport()->WorldToScreen({GetWidth(), 0})[0];
-  uint64_t next_pixel_start_ns = orbit_client_data::GetNextPixelBoundaryTimeNs(
-      min_tick, resolution_in_pixels, min_tick, max_tick);
-
-  // Issues draws for the aggregated entry depending on `aggregation_mode_` and updates
-  // `prev_normalized_values` with last drawn values.
-  auto draw_aggregated = [&](const GraphTrackDataAggregator::AccumulatedEntry& accumulated_entry,
-                             bool is_last) {
     // First draw the entry for the max values.
-    DrawSingleSeriesEntry(primitive_assembler, accumulated_entry.start_tick,
-                          accumulated_entry.end_tick, prev_drawn_values, accumulated_entry.max_vals,
-                          z, is_last);
-    prev_drawn_values = accumulated_entry.max_vals;
+    std::vector<float> max_values = GetNormalizedValues(entry.max_values, min, inverse_value_range);
+    DrawSingleSeriesEntry(primitive_assembler, prev_end_tick, entry.last_time_ns, prev_drawn_values,
+                          max_values, z, is_last);
+    prev_drawn_values = std::move(max_values);
 
     // Draw min values if needed.
-    if (aggregation_mode_ == AggregationMode::kMinMax &&
-        accumulated_entry.min_vals != accumulated_entry.max_vals) {
-      // Draw a single-sized entry (starts and ends at `end_tick`) that goes from max to min
+    if (aggregation_mode_ == AggregationMode::kMinMax && entry.min_values != entry.max_values) {
+      // Draw a single-sized entry (starts and ends at the last time) that goes from max to min
       // values.
-      DrawSingleSeriesEntry(primitive_assembler, accumulated_entry.end_tick,
-                            accumulated_entry.end_tick, prev_drawn_values,
-                            accumulated_entry.min_vals, z, is_last);
-      prev_drawn_values = accumulated_entry.min_vals;
+      std::vector<float> min_values =
+          GetNormalizedValues(entry.min_values, min, inverse_value_range);
+      DrawSingleSeriesEntry(primitive_assembler, entry.last_time_ns, entry.last_time_ns,
+                            prev_drawn_values, min_values, z, is_last);
+      prev_drawn_values = std::move(min_values);
     }
 
-    // Finally, draw the last entry. This ensures that the horizontal line from this pixel to
+    // Finally, draw the last values. This ensures that the horizontal line from this pixel to
     // the next entry would be at the same position both zoomed in and out.
-    if (last_entry_values != prev_drawn_values) {
-      DrawSingleSeriesEntry(primitive_assembler, accumulated_entry.end_tick,
-                            accumulated_entry.end_tick, prev_drawn_values, last_entry_values, z,
-                            is_last);
-      prev_drawn_values = last_entry_values;
+    std::vector<float> last_values =
+        GetNormalizedValues(entry.last_values, min, inverse_value_range);
+    if (last_values != prev_drawn_values) {
+      DrawSingleSeriesEntry(primitive_assembler, entry.last_time_ns, entry.last_time_ns,
+                            prev_drawn_values, last_values, z, is_last);
+      prev_drawn_values = std::move(last_values);
     }
-  };
-
-  while (curr_iterator != last_iterator) {
-    uint64_t prev_time = curr_iterator->first;
-    curr_iterator = std::next(curr_iterator);
-
-    uint64_t curr_time = curr_iterator->first;
-    std::vector<float> curr_normalized_values =
-        GetNormalizedValues(curr_iterator->second, min, inverse_value_range);
-
-    if (aggr.GetAccumulatedEntry() == nullptr) {
-      aggr.SetEntry(prev_time, curr_time, curr_normalized_values);
-      last_entry_values = curr_normalized_values;
-      continue;
-    }
-
-    // If the current data point fits into the same pixel as the entry we are currently
-    // accumulating.
-    if (curr_time < next_pixel_start_ns) {
-      // Add the current data to accumulated_entry
-      aggr.MergeDataIntoEntry(prev_time, curr_time, curr_normalized_values);
-    } else {
-      auto accumulated_entry = *aggr.GetAccumulatedEntry();
-      // Otherwise, draw the accumulated_entry and start accumulating a new one
-      draw_aggregated(accumulated_entry, false);
-
-      // Must be done before the next `SetEntry` call - we are using the end tick value of the
-      // current entry to calculate the next pixel border.
-      next_pixel_start_ns = orbit_client_data::GetNextPixelBoundaryTimeNs(
-          aggr.GetAccumulatedEntry()->end_tick, resolution_in_pixels, min_tick, max_tick);
-
-      aggr.SetEntry(prev_time, curr_time, curr_normalized_values);
-    }
-
-    last_entry_values = curr_normalized_values;
+    prev_end_tick = entry.last_time_ns;
   }
 
-  bool is_accumulated_entry_last = aggr.GetAccumulatedEntry()->end_tick >= max_tick;
-  // Draw the leftover entry
-  auto accumulated_entry = *aggr.GetAccumulatedEntry();
-  draw_aggregated(accumulated_entry, is_accumulated_entry_last);
-
   // If there was not enough data to reach the end tick, draw an entry until the
   // end.
-  if (!is_accumulated_entry_last) {
-    DrawSingleSeriesEntry(primitive_assembler, accumulated_entry.end_tick, max_tick,
-                          prev_drawn_values, prev_drawn_values, z, true);
+  if (!is_last) {
+    DrawSingleSeriesEntry(primitive_assembler, prev_end_tick, max_tick, prev_drawn_values,
+                          prev_drawn_values, z, true);
   }
 }
 
@@ -4,19 +4,77 @@
 
 #include "OrbitGl/MultivariateTimeSeries.h"
 
+#include <absl/base/casts.h>
+#include <string.h>
+
 #include <algorithm>
-#include <iterator>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <optional>
 
+#include "ClientData/FastRenderingUtils.h"
 #include "OrbitBase/Logging.h"
 
 namespace orbit_gl {
 
+namespace {
+
+void AppendVarint(uint64_t value, std::vector<uint8_t>* data) {
+  while (value >= 0x80) {
+    data->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  data->push_back(static_cast<uint8_t>(value));
+}
+
+[[nodiscard]] uint64_t ReadVarint(const uint8_t** data) {
+  uint64_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    const uint8_t byte = *(*data)++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return value;
+  }
+}
+
+[[nodiscard]] uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+[[nodiscard]] int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+enum SeriesEncoding : uint8_t { kRawValues = 0, kFixedPointDeltas = 1 };
+
+// Returns the values in fixed point with the given scale, if they all convert back bit by bit.
+[[nodiscard]] std::optional<std::vector<int64_t>> ToFixedPoint(const std::vector<double>& values,
+                                                              double scale) {
+  // Beyond this, not all integers are representable as double.
+  constexpr double kMaxFixedPointValue = 9007199254740992.0;  // 2^53
+  std::vector<int64_t> fixed_point_values(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    const double scaled = values[i] * scale;
+    if (!(std::abs(scaled) < kMaxFixedPointValue)) return std::nullopt;
+    fixed_point_values[i] = std::llround(scaled);
+    const double decoded = static_cast<double>(fixed_point_values[i]) / scale;
+    if (absl::bit_cast<uint64_t>(decoded) != absl::bit_cast<uint64_t>(values[i])) {
+      return std::nullopt;
+    }
+  }
+  return fixed_point_values;
+}
+
+}  // namespace
+
 MultivariateTimeSeries::MultivariateTimeSeries(std::vector<std::string> series_names,
                                                uint8_t value_decimal_digits, std::string value_unit)
     : series_names_{std::move(series_names)},
       value_decimal_digits_{value_decimal_digits},
       value_unit_{std::move(value_unit)} {
   ORBIT_CHECK(!series_names_.empty());
+  last_block_.series_values.resize(series_names_.size());
 }
 
 double MultivariateTimeSeries::GetMin() const {
@@ -31,50 +89,88 @@ double MultivariateTimeSeries::GetMax() const {
 
 bool MultivariateTimeSeries::IsEmpty() const {
   absl::MutexLock lock(&mutex_);
-  return time_to_series_values_.empty();
+  return GetEntryCount() == 0;
 }
 
 size_t MultivariateTimeSeries::GetTimeToSeriesValuesSize() const {
   absl::MutexLock lock(&mutex_);
-  return time_to_series_values_.size();
+  return GetEntryCount();
 }
 
 uint64_t MultivariateTimeSeries::StartTimeInNs() const {
   absl::MutexLock lock(&mutex_);
-  ORBIT_CHECK(!time_to_series_values_.empty());
-  return time_to_series_values_.begin()->first;
+  ORBIT_CHECK(GetEntryCount() > 0);
+  return GetFirstTimestamp();
 }
 
 uint64_t MultivariateTimeSeries::EndTimeInNs() const {
   absl::MutexLock lock(&mutex_);
-  ORBIT_CHECK(!time_to_series_values_.empty());
-  return time_to_series_values_.rbegin()->first;
+  ORBIT_CHECK(GetEntryCount() > 0);
+  return GetLastTimestamp();
 }
 
 std::vector<double> MultivariateTimeSeries::GetPreviousOrFirstEntry(uint64_t time) const {
   absl::MutexLock lock(&mutex_);
-  return GetPreviousOrFirstEntryIterator(time)->second;
+  return GetValuesAt(GetPreviousOrFirstEntryIndex(time), ValueKind::kValues);
 }
 
 std::vector<std::pair<uint64_t, std::vector<double>>>
 MultivariateTimeSeries::GetEntriesAffectedByTimeRange(uint64_t min_time, uint64_t max_time) const {
   absl::MutexLock lock(&mutex_);
-  if (time_to_series_values_.empty() || min_time >= max_time ||
-      min_time >= time_to_series_values_.rbegin()->first ||
-      max_time <= time_to_series_values_.begin()->first) {
+  if (GetEntryCount() == 0 || min_time >= max_time || min_time >= GetLastTimestamp() ||
+      max_time <= GetFirstTimestamp()) {
     return {};
   }
 
-  auto current_it = GetPreviousOrFirstEntryIterator(min_time);
-  auto last_iterator = GetNextOrLastEntryIterator(max_time);
+  const size_t first_index = GetPreviousOrFirstEntryIndex(min_time);
+  const size_t last_index = GetNextOrLastEntryIndex(max_time);
 
   std::vector<std::pair<uint64_t, std::vector<double>>> result;
-  result.push_back(*current_it);
-  do {
-    ++current_it;
-    result.push_back(*current_it);
-  } while (current_it != last_iterator);
+  for (size_t index = first_index; index <= last_index; ++index) {
+    result.emplace_back(GetTimestampAt(index), GetValuesAt(index, ValueKind::kValues));
+  }
+  return result;
+}
+
+std::vector<MultivariateTimeSeries::DecimatedEntry>
+MultivariateTimeSeries::GetDecimatedEntriesAffectedByTimeRange(uint64_t min_time,
+                                                               uint64_t max_time,
+                                                               uint32_t resolution,
+                                                               ValueKind value_kind) const {
+  absl::MutexLock lock(&mutex_);
+  if (GetEntryCount() == 0 || min_time >= max_time || min_time >= GetLastTimestamp() ||
+      max_time <= GetFirstTimestamp()) {
+    return {};
+  }
+
+  const size_t dimension = GetDimension();
+  const size_t end_index = GetNextOrLastEntryIndex(max_time) + 1;
+  std::vector<double> min_max(2 * dimension);
+  std::vector<DecimatedEntry> result;
+  size_t begin = GetPreviousOrFirstEntryIndex(min_time);
+  while (begin < end_index) {
+    const uint64_t time = GetTimestampAt(begin);
+    size_t end = begin + 1;
+    if (time >= min_time && time < max_time) {
+      const uint64_t next_pixel_start_ns = std::min(
+          orbit_client_data::GetNextPixelBoundaryTimeNs(time, resolution, min_time, max_time),
+          max_time);
+      end = FindFirstEntryIndex(next_pixel_start_ns, /*strictly_greater=*/false, end, end_index);
+    }
 
+    std::fill(min_max.begin(), min_max.begin() + dimension, std::numeric_limits<double>::max());
+    std::fill(min_max.begin() + dimension, min_max.end(), std::numeric_limits<double>::lowest());
+    MergeEntryRangeInto(begin, end, value_kind, absl::MakeSpan(min_max));
+
+    DecimatedEntry& entry = result.emplace_back();
+    entry.first_time_ns = time;
+    entry.last_time_ns = GetTimestampAt(end - 1);
+    entry.first_values = GetValuesAt(begin, value_kind);
+    entry.last_values = GetValuesAt(end - 1, value_kind);
+    entry.min_values.assign(min_max.begin(), min_max.begin() + dimension);
+    entry.max_values.assign(min_max.begin() + dimension, min_max.end());
+    begin = end;
+  }
   return result;
 }
 
@@ -82,26 +178,389 @@ void MultivariateTimeSeries::AddValues(uint64_t timestamp_ns, absl::Span<const d
   ORBIT_CHECK(values.size() == series_names_.size());
 
   absl::MutexLock lock(&mutex_);
-  time_to_series_values_[timestamp_ns] = std::vector(values.begin(), values.end());
   for (double value : values) UpdateMinAndMax(value);
+
+  const size_t num_entries = GetEntryCount();
+  if (num_entries == 0 || timestamp_ns > GetLastTimestamp()) {
+    last_block_.timestamps.push_back(timestamp_ns);
+    for (size_t i = 0; i < values.size(); ++i) last_block_.series_values[i].push_back(values[i]);
+    UpdatePyramidAfterAppend();
+    if (last_block_.timestamps.size() == kEntriesPerBlock) {
+      compact_blocks_.push_back(EncodeBlock(last_block_));
+      last_block_.timestamps.clear();
+      for (std::vector<double>& series_values : last_block_.series_values) series_values.clear();
+    }
+    return;
+  }
+
+  const size_t index =
+      FindFirstEntryIndex(timestamp_ns, /*strictly_greater=*/false, 0, num_entries);
+  const size_t block_index = index / kEntriesPerBlock;
+  const size_t index_in_block = index % kEntriesPerBlock;
+  if (GetTimestampAt(index) == timestamp_ns) {
+    if (block_index == compact_blocks_.size()) {
+      for (size_t i = 0; i < values.size(); ++i) {
+        last_block_.series_values[i][index_in_block] = values[i];
+      }
+    } else {
+      DecodedBlock block;
+      DecodeBlock(compact_blocks_[block_index], &block);
+      for (size_t i = 0; i < values.size(); ++i) block.series_values[i][index_in_block] = values[i];
+      compact_blocks_[block_index] = EncodeBlock(block);
+      InvalidateDecodedBlockCache();
+    }
+    UpdatePyramidAfterOverwrite(index);
+    return;
+  }
+
+  // Values are almost always added in order, so decoding and compacting all blocks again, as well
+  // as rebuilding the pyramid, is fine here.
+  DecodedBlock entries;
+  entries.series_values.resize(GetDimension());
+  for (size_t block = 0; block <= compact_blocks_.size(); ++block) {
+    const DecodedBlock& decoded_block = GetBlock(block);
+    entries.timestamps.insert(entries.timestamps.end(), decoded_block.timestamps.begin(),
+                              decoded_block.timestamps.end());
+    for (size_t i = 0; i < values.size(); ++i) {
+      entries.series_values[i].insert(entries.series_values[i].end(),
+                                      decoded_block.series_values[i].begin(),
+                                      decoded_block.series_values[i].end());
+    }
+  }
+  entries.timestamps.insert(entries.timestamps.begin() + index, timestamp_ns);
+  for (size_t i = 0; i < values.size(); ++i) {
+    entries.series_values[i].insert(entries.series_values[i].begin() + index, values[i]);
+  }
+  StoreEntries(std::move(entries));
+  RebuildPyramid();
+}
+
+size_t MultivariateTimeSeries::GetEntryCount() const {
+  return compact_blocks_.size() * kEntriesPerBlock + last_block_.timestamps.size();
 }
 
-MultivariateTimeSeries::TimeSeriesEntryIter MultivariateTimeSeries::GetPreviousOrFirstEntryIterator(
-    uint64_t time) const {
-  ORBIT_CHECK(!time_to_series_values_.empty());
+uint64_t MultivariateTimeSeries::GetFirstTimestamp() const {
+  if (!compact_blocks_.empty()) return compact_blocks_.front().first_timestamp_ns;
+  ORBIT_CHECK(!last_block_.timestamps.empty());
+  return last_block_.timestamps.front();
+}
 
-  auto iterator_lower = time_to_series_values_.upper_bound(time);
-  if (iterator_lower != time_to_series_values_.begin()) --iterator_lower;
-  return iterator_lower;
+uint64_t MultivariateTimeSeries::GetLastTimestamp() const {
+  if (!last_block_.timestamps.empty()) return last_block_.timestamps.back();
+  ORBIT_CHECK(!compact_blocks_.empty());
+  return compact_blocks_.back().last_timestamp_ns;
 }
 
-MultivariateTimeSeries::TimeSeriesEntryIter MultivariateTimeSeries::GetNextOrLastEntryIterator(
-    uint64_t time) const {
-  ORBIT_CHECK(!time_to_series_values_.empty());
+uint64_t MultivariateTimeSeries::GetTimestampAt(size_t index) const {
+  return GetBlock(index / kEntriesPerBlock).timestamps[index % kEntriesPerBlock];
+}
 
-  auto iterator_higher = time_to_series_values_.lower_bound(time);
-  if (iterator_higher == time_to_series_values_.end()) --iterator_higher;
-  return iterator_higher;
+const MultivariateTimeSeries::DecodedBlock& MultivariateTimeSeries::GetBlock(
+    size_t block_index) const {
+  if (block_index == compact_blocks_.size()) return last_block_;
+  ORBIT_CHECK(block_index < compact_blocks_.size());
+
+  for (size_t i = 0; i < decoded_block_cache_.size(); ++i) {
+    if (decoded_block_cache_[i].block_index == block_index) {
+      next_cache_entry_to_evict_ = (i + 1) % decoded_block_cache_.size();
+      return decoded_block_cache_[i].block;
+    }
+  }
+  DecodedBlockCacheEntry& cache_entry = decoded_block_cache_[next_cache_entry_to_evict_];
+  next_cache_entry_to_evict_ = (next_cache_entry_to_evict_ + 1) % decoded_block_cache_.size();
+  cache_entry.block_index = block_index;
+  DecodeBlock(compact_blocks_[block_index], &cache_entry.block);
+  return cache_entry.block;
+}
+
+MultivariateTimeSeries::CompactBlock MultivariateTimeSeries::EncodeBlock(
+    const DecodedBlock& block) const {
+  ORBIT_CHECK(block.timestamps.size() == kEntriesPerBlock);
+  CompactBlock compact_block;
+  compact_block.first_timestamp_ns = block.timestamps.front();
+  compact_block.last_timestamp_ns = block.timestamps.back();
+  std::vector<uint8_t>& data = compact_block.data;
+  for (size_t j = 1; j < kEntriesPerBlock; ++j) {
+    AppendVarint(block.timestamps[j] - block.timestamps[j - 1], &data);
+  }
+
+  const double scale = std::pow(10, value_decimal_digits_);
+  for (const std::vector<double>& values : block.series_values) {
+    std::optional<std::vector<int64_t>> fixed_point_values = ToFixedPoint(values, scale);
+    if (!fixed_point_values.has_value()) {
+      data.push_back(kRawValues);
+      const size_t offset = data.size();
+      data.resize(offset + kEntriesPerBlock * sizeof(double));
+      memcpy(data.data() + offset, values.data(), kEntriesPerBlock * sizeof(double));
+      continue;
+    }
+    data.push_back(kFixedPointDeltas);
+    int64_t previous_value = 0;
+    for (int64_t value : fixed_point_values.value()) {
+      AppendVarint(ZigZagEncode(value - previous_value), &data);
+      previous_value = value;
+    }
+  }
+  data.shrink_to_fit();
+  return compact_block;
+}
+
+void MultivariateTimeSeries::DecodeBlock(const CompactBlock& compact_block,
+                                         DecodedBlock* block) const {
+  std::vector<uint64_t>& timestamps = block->timestamps;
+  timestamps.resize(kEntriesPerBlock);
+  const uint8_t* data = compact_block.data.data();
+  timestamps[0] = compact_block.first_timestamp_ns;
+  for (size_t j = 1; j < kEntriesPerBlock; ++j) {
+    timestamps[j] = timestamps[j - 1] + ReadVarint(&data);
+  }
+
+  const double scale = std::pow(10, value_decimal_digits_);
+  block->series_values.resize(GetDimension());
+  for (std::vector<double>& values : block->series_values) {
+    values.resize(kEntriesPerBlock);
+    const uint8_t encoding = *data++;
+    if (encoding == kRawValues) {
+      memcpy(values.data(), data, kEntriesPerBlock * sizeof(double));
+      data += kEntriesPerBlock * sizeof(double);
+      continue;
+    }
+    ORBIT_CHECK(encoding == kFixedPointDeltas);
+    int64_t value = 0;
+    for (double& decoded_value : values) {
+      value += ZigZagDecode(ReadVarint(&data));
+      decoded_value = static_cast<double>(value) / scale;
+    }
+  }
+  ORBIT_CHECK(data == compact_block.data.data() + compact_block.data.size());
+}
+
+void MultivariateTimeSeries::StoreEntries(DecodedBlock entries) {
+  InvalidateDecodedBlockCache();
+  compact_blocks_.clear();
+  const size_t num_entries = entries.timestamps.size();
+  const size_t num_compact_blocks = num_entries / kEntriesPerBlock;
+  DecodedBlock block;
+  block.series_values.resize(GetDimension());
+  for (size_t block_index = 0; block_index < num_compact_blocks; ++block_index) {
+    const size_t begin = block_index * kEntriesPerBlock;
+    block.timestamps.assign(entries.timestamps.begin() + begin,
+                            entries.timestamps.begin() + begin + kEntriesPerBlock);
+    for (size_t i = 0; i < block.series_values.size(); ++i) {
+      block.series_values[i].assign(entries.series_values[i].begin() + begin,
+                                    entries.series_values[i].begin() + begin + kEntriesPerBlock);
+    }
+    compact_blocks_.push_back(EncodeBlock(block));
+  }
+
+  const size_t last_block_begin = num_compact_blocks * kEntriesPerBlock;
+  entries.timestamps.erase(entries.timestamps.begin(),
+                           entries.timestamps.begin() + last_block_begin);
+  for (std::vector<double>& series_values : entries.series_values) {
+    series_values.erase(series_values.begin(), series_values.begin() + last_block_begin);
+  }
+  last_block_ = std::move(entries);
+}
+
+void MultivariateTimeSeries::InvalidateDecodedBlockCache() const {
+  for (DecodedBlockCacheEntry& cache_entry : decoded_block_cache_) {
+    cache_entry.block_index = std::numeric_limits<size_t>::max();
+  }
+}
+
+size_t MultivariateTimeSeries::FindFirstEntryIndex(uint64_t time, bool strictly_greater,
+                                                   size_t begin, size_t end) const {
+  if (begin >= end) return end;
+  // Skip the compact blocks whose entries all come before, so that only one block is decoded.
+  size_t block_index = begin / kEntriesPerBlock;
+  if (block_index < compact_blocks_.size()) {
+    const size_t end_block_index =
+        std::min(compact_blocks_.size(), (end + kEntriesPerBlock - 1) / kEntriesPerBlock);
+    block_index = std::partition_point(compact_blocks_.begin() + block_index,
+                                       compact_blocks_.begin() + end_block_index,
+                                       [time, strictly_greater](const CompactBlock& block) {
+                                         return strictly_greater ? block.last_timestamp_ns <= time
+                                                                 : block.last_timestamp_ns < time;
+                                       }) -
+                  compact_blocks_.begin();
+  }
+  const size_t block_begin = block_index * kEntriesPerBlock;
+  if (block_begin >= end) return end;
+
+  const std::vector<uint64_t>& timestamps = GetBlock(block_index).timestamps;
+  auto first = timestamps.begin() + (std::max(begin, block_begin) - block_begin);
+  auto last = timestamps.begin() + std::min(end - block_begin, timestamps.size());
+  auto it = strictly_greater ? std::upper_bound(first, last, time)
+                             : std::lower_bound(first, last, time);
+  return block_begin + (it - timestamps.begin());
+}
+
+size_t MultivariateTimeSeries::GetPreviousOrFirstEntryIndex(uint64_t time) const {
+  const size_t num_entries = GetEntryCount();
+  ORBIT_CHECK(num_entries > 0);
+
+  const size_t index = FindFirstEntryIndex(time, /*strictly_greater=*/true, 0, num_entries);
+  return index > 0 ? index - 1 : 0;
+}
+
+size_t MultivariateTimeSeries::GetNextOrLastEntryIndex(uint64_t time) const {
+  const size_t num_entries = GetEntryCount();
+  ORBIT_CHECK(num_entries > 0);
+
+  const size_t index = FindFirstEntryIndex(time, /*strictly_greater=*/false, 0, num_entries);
+  return index < num_entries ? index : num_entries - 1;
+}
+
+std::vector<double> MultivariateTimeSeries::GetValuesAt(size_t index, ValueKind value_kind) const {
+  const DecodedBlock& block = GetBlock(index / kEntriesPerBlock);
+  std::vector<double> values(GetDimension());
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = block.series_values[i][index % kEntriesPerBlock];
+  }
+  if (value_kind == ValueKind::kStackedValues) {
+    std::partial_sum(values.begin(), values.end(), values.begin());
+  }
+  return values;
+}
+
+size_t MultivariateTimeSeries::GetPyramidBlockOffset(ValueKind value_kind) const {
+  return value_kind == ValueKind::kValues ? 0 : 2 * GetDimension();
+}
+
+void MultivariateTimeSeries::MergeEntriesInto(size_t begin, size_t end, ValueKind value_kind,
+                                              absl::Span<double> min_max) const {
+  ORBIT_CHECK(end - begin <= kEntriesPerBlock);
+  const size_t dimension = GetDimension();
+  const size_t count = end - begin;
+  const DecodedBlock& block = GetBlock(begin / kEntriesPerBlock);
+  const size_t begin_in_block = begin % kEntriesPerBlock;
+  ORBIT_CHECK(count == 0 || begin_in_block + count <= block.timestamps.size());
+  // The loops run over contiguous values of one series, so that they can be vectorized.
+  std::array<double, kEntriesPerBlock> stacked_values{};
+  for (size_t i = 0; i < dimension; ++i) {
+    const double* values = block.series_values[i].data() + begin_in_block;
+    if (value_kind == ValueKind::kStackedValues) {
+      for (size_t j = 0; j < count; ++j) stacked_values[j] += values[j];
+      values = stacked_values.data();
+    }
+    double min = min_max[i];
+    double max = min_max[dimension + i];
+    for (size_t j = 0; j < count; ++j) {
+      min = std::min(min, values[j]);
+      max = std::max(max, values[j]);
+    }
+    min_max[i] = min;
+    min_max[dimension + i] = max;
+  }
+}
+
+void MultivariateTimeSeries::MergeEntryRangeInto(size_t begin, size_t end, ValueKind value_kind,
+                                                 absl::Span<double> min_max) const {
+  const size_t dimension = GetDimension();
+  const size_t block_offset = GetPyramidBlockOffset(value_kind);
+  const size_t block_size = 4 * dimension;
+  size_t index = begin;
+  while (index < end) {
+    // Find the highest level with a complete block starting at `index` and ending before `end`.
+    size_t num_levels = 0;
+    size_t entries_per_block = 1;
+    while (num_levels < pyramid_levels_.size()) {
+      const size_t next_entries_per_block =
+          num_levels == 0 ? kEntriesPerBlock : entries_per_block * kPyramidFanout;
+      if (index % next_entries_per_block != 0 || index + next_entries_per_block > end ||
+          (index / next_entries_per_block + 1) * block_size > pyramid_levels_[num_levels].size()) {
+        break;
+      }
+      entries_per_block = next_entries_per_block;
+      ++num_levels;
+    }
+
+    if (num_levels == 0) {
+      const size_t next_index = std::min(end, (index / kEntriesPerBlock + 1) * kEntriesPerBlock);
+      MergeEntriesInto(index, next_index, value_kind, min_max);
+      index = next_index;
+      continue;
+    }
+
+    const double* block = pyramid_levels_[num_levels - 1].data() +
+                          (index / entries_per_block) * block_size + block_offset;
+    for (size_t i = 0; i < dimension; ++i) {
+      min_max[i] = std::min(min_max[i], block[i]);
+      min_max[dimension + i] = std::max(min_max[dimension + i], block[dimension + i]);
+    }
+    index += entries_per_block;
+  }
+}
+
+void MultivariateTimeSeries::ComputePyramidBlock(size_t level, size_t block_index) {
+  const size_t dimension = GetDimension();
+  const size_t block_size = 4 * dimension;
+  if (pyramid_levels_.size() <= level) pyramid_levels_.resize(level + 1);
+  std::vector<double>& blocks = pyramid_levels_[level];
+  if (blocks.size() < (block_index + 1) * block_size) blocks.resize((block_index + 1) * block_size);
+
+  absl::Span<double> block = absl::MakeSpan(blocks).subspan(block_index * block_size, block_size);
+  for (size_t offset = 0; offset < block_size; offset += 2 * dimension) {
+    std::fill(block.begin() + offset, block.begin() + offset + dimension,
+              std::numeric_limits<double>::max());
+    std::fill(block.begin() + offset + dimension, block.begin() + offset + 2 * dimension,
+              std::numeric_limits<double>::lowest());
+  }
+
+  if (level == 0) {
+    const size_t begin = block_index * kEntriesPerBlock;
+    for (ValueKind value_kind : {ValueKind::kValues, ValueKind::kStackedValues}) {
+      MergeEntriesInto(begin, begin + kEntriesPerBlock, value_kind,
+                       block.subspan(GetPyramidBlockOffset(value_kind), 2 * dimension));
+    }
+    return;
+  }
+
+  const std::vector<double>& children = pyramid_levels_[level - 1];
+  for (size_t child = block_index * kPyramidFanout; child < (block_index + 1) * kPyramidFanout;
+       ++child) {
+    const double* child_block = children.data() + child * block_size;
+    for (size_t offset = 0; offset < block_size; offset += 2 * dimension) {
+      for (size_t i = 0; i < dimension; ++i) {
+        block[offset + i] = std::min(block[offset + i], child_block[offset + i]);
+        block[offset + dimension + i] =
+            std::max(block[offset + dimension + i], child_block[offset + dimension + i]);
+      }
+    }
+  }
+}
+
+void MultivariateTimeSeries::UpdatePyramidAfterAppend() {
+  const size_t num_entries = GetEntryCount();
+  size_t entries_per_block = kEntriesPerBlock;
+  for (size_t level = 0; num_entries % entries_per_block == 0; ++level) {
+    ComputePyramidBlock(level, num_entries / entries_per_block - 1);
+    entries_per_block *= kPyramidFanout;
+  }
+}
+
+void MultivariateTimeSeries::UpdatePyramidAfterOverwrite(size_t index) {
+  const size_t block_size = 4 * GetDimension();
+  size_t entries_per_block = kEntriesPerBlock;
+  for (size_t level = 0; level < pyramid_levels_.size(); ++level) {
+    const size_t block_index = index / entries_per_block;
+    // Only complete blocks are stored.
+    if ((block_index + 1) * block_size > pyramid_levels_[level].size()) break;
+    ComputePyramidBlock(level, block_index);
+    entries_per_block *= kPyramidFanout;
+  }
+}
+
+void MultivariateTimeSeries::RebuildPyramid() {
+  pyramid_levels_.clear();
+  const size_t num_entries = GetEntryCount();
+  size_t entries_per_block = kEntriesPerBlock;
+  for (size_t level = 0; num_entries / entries_per_block > 0; ++level) {
+    for (size_t block_index = 0; block_index < num_entries / entries_per_block; ++block_index) {
+      ComputePyramidBlock(level, block_index);
+    }
+    entries_per_block *= kPyramidFanout;
+  }
 }
 
 void MultivariateTimeSeries::UpdateMinAndMax(double value) {
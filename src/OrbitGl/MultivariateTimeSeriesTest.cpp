@@ -6,7 +6,10 @@
 #include <gtest/gtest.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -105,4 +108,123 @@ TEST(MultivariateTimeSeries, GetEntriesAffectedByTimeRange) {
   }
 }
 
-}  // namespace orbit_gl
\ No newline at end of file
+TEST(MultivariateTimeSeries, GetDecimatedEntriesAffectedByTimeRangeMergesEntriesPerPixel) {
+  MultivariateTimeSeries series{kSeriesNames, kDefaultValueDecimalDigits, kDefaultValueUnits};
+  AddTestValuesToSeries(series);
+
+  // With 2 pixels covering [0, 500), the first pixel holds the entries at 100 and 200.
+  auto entries = series.GetDecimatedEntriesAffectedByTimeRange(
+      0, 500, 2, MultivariateTimeSeries::ValueKind::kValues);
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_EQ(entries[0].first_time_ns, kTimestamp1);
+  EXPECT_EQ(entries[0].last_time_ns, kTimestamp2);
+  EXPECT_THAT(entries[0].first_values, testing::ElementsAre(1.1, 1.2, 1.3));
+  EXPECT_THAT(entries[0].last_values, testing::ElementsAre(2.1, 2.2, 2.3));
+  EXPECT_THAT(entries[0].min_values, testing::ElementsAre(1.1, 1.2, 1.3));
+  EXPECT_THAT(entries[0].max_values, testing::ElementsAre(2.1, 2.2, 2.3));
+  EXPECT_EQ(entries[1].first_time_ns, kTimestamp3);
+  EXPECT_EQ(entries[1].last_time_ns, kTimestamp3);
+
+  // The entry at 100 is before the time range, so it is not merged with the one at 200.
+  auto stacked_entries = series.GetDecimatedEntriesAffectedByTimeRange(
+      150, 350, 1, MultivariateTimeSeries::ValueKind::kStackedValues);
+  ASSERT_EQ(stacked_entries.size(), 2);
+  EXPECT_EQ(stacked_entries[0].first_time_ns, kTimestamp1);
+  EXPECT_EQ(stacked_entries[1].first_time_ns, kTimestamp2);
+  EXPECT_EQ(stacked_entries[1].last_time_ns, kTimestamp3);
+  EXPECT_THAT(stacked_entries[1].min_values,
+              testing::ElementsAre(testing::DoubleEq(2.1), testing::DoubleEq(4.3),
+                                   testing::DoubleEq(6.6)));
+  EXPECT_THAT(stacked_entries[1].max_values,
+              testing::ElementsAre(testing::DoubleEq(3.1), testing::DoubleEq(6.3),
+                                   testing::DoubleEq(9.6)));
+}
+
+TEST(MultivariateTimeSeries, GetDecimatedEntriesAffectedByTimeRangeMatchesAllEntries) {
+  MultivariateTimeSeries series{{"Series A", "Series B"}, kDefaultValueDecimalDigits,
+                                kDefaultValueUnits};
+  constexpr uint64_t kNumEntries = 10000;
+  // Add values out of order and overwrite some, which the pyramid has to follow.
+  auto value_at = [](uint64_t i, uint64_t seed) {
+    return static_cast<double>((i * 7919 + seed * 104729) % 1000) - 500.0;
+  };
+  for (uint64_t i = 0; i < kNumEntries; ++i) {
+    series.AddValues(i * 10, std::array<double, 2>{value_at(i, 1), value_at(i, 2)});
+  }
+  series.AddValues(12345, std::array<double, 2>{-1000.0, 1000.0});
+  for (uint64_t i = 0; i < kNumEntries; i += 3) {
+    series.AddValues(i * 10, std::array<double, 2>{value_at(i, 3), value_at(i, 4)});
+  }
+
+  constexpr uint64_t kMinTime = 1234;
+  constexpr uint64_t kMaxTime = 98765;
+  constexpr uint32_t kResolution = 37;
+  auto all_entries = series.GetEntriesAffectedByTimeRange(kMinTime, kMaxTime);
+  for (auto value_kind : {MultivariateTimeSeries::ValueKind::kValues,
+                          MultivariateTimeSeries::ValueKind::kStackedValues}) {
+    auto entries = series.GetDecimatedEntriesAffectedByTimeRange(kMinTime, kMaxTime, kResolution,
+                                                                 value_kind);
+    size_t all_entries_index = 0;
+    for (const auto& entry : entries) {
+      std::array<double, 2> min_values{std::numeric_limits<double>::max(),
+                                       std::numeric_limits<double>::max()};
+      std::array<double, 2> max_values{std::numeric_limits<double>::lowest(),
+                                       std::numeric_limits<double>::lowest()};
+      ASSERT_EQ(all_entries[all_entries_index].first, entry.first_time_ns);
+      uint64_t last_time = 0;
+      for (; all_entries_index < all_entries.size() &&
+             all_entries[all_entries_index].first <= entry.last_time_ns;
+           ++all_entries_index) {
+        std::vector<double> values = all_entries[all_entries_index].second;
+        if (value_kind == MultivariateTimeSeries::ValueKind::kStackedValues) values[1] += values[0];
+        for (size_t i = 0; i < 2; ++i) {
+          min_values[i] = std::min(min_values[i], values[i]);
+          max_values[i] = std::max(max_values[i], values[i]);
+        }
+        last_time = all_entries[all_entries_index].first;
+      }
+      EXPECT_EQ(last_time, entry.last_time_ns);
+      EXPECT_THAT(entry.min_values, testing::ElementsAreArray(min_values));
+      EXPECT_THAT(entry.max_values, testing::ElementsAreArray(max_values));
+    }
+    EXPECT_EQ(all_entries_index, all_entries.size());
+    EXPECT_LE(entries.size(), kResolution + 2);
+  }
+}
+
+TEST(MultivariateTimeSeries, StoresValuesOfAnyPrecisionExactly) {
+  constexpr uint8_t kValueDecimalDigits = 2;
+  MultivariateTimeSeries series{{"Rounded", "Not rounded"}, kValueDecimalDigits,
+                                kDefaultValueUnits};
+  constexpr uint64_t kNumEntries = 1000;
+  // The first series is rounded to the decimal digits, except for a negative zero, while values of
+  // the second series need more digits.
+  auto values_at = [](uint64_t i) {
+    const double rounded = i == 500 ? -0.0 : std::round(static_cast<double>(i) * 12.34) / 100;
+    return std::array<double, 2>{rounded, static_cast<double>(i) / 3};
+  };
+  for (uint64_t i = 0; i < kNumEntries; ++i) {
+    if (i == 100) continue;
+    series.AddValues(i * 1000 + i % 7, values_at(i));
+  }
+  // Insert and overwrite entries that are not in the last block anymore.
+  series.AddValues(100 * 1000 + 100 % 7, values_at(100));
+  series.AddValues(200 * 1000 + 200 % 7, std::array<double, 2>{-1.5, -1.0 / 7});
+
+  auto entries = series.GetEntriesAffectedByTimeRange(0, kNumEntries * 1000);
+  ASSERT_EQ(entries.size(), kNumEntries);
+  for (uint64_t i = 0; i < kNumEntries; ++i) {
+    EXPECT_EQ(entries[i].first, i * 1000 + i % 7);
+    const std::array<double, 2> expected_values =
+        i == 200 ? std::array<double, 2>{-1.5, -1.0 / 7} : values_at(i);
+    ASSERT_EQ(entries[i].second.size(), 2);
+    for (size_t j = 0; j < 2; ++j) {
+      EXPECT_EQ(entries[i].second[j], expected_values[j]);
+      EXPECT_EQ(std::signbit(entries[i].second[j]), std::signbit(expected_values[j]));
+    }
+  }
+  EXPECT_THAT(series.GetPreviousOrFirstEntry(500 * 1000 + 500 % 7 + 1),
+              testing::ElementsAre(0.0, 500.0 / 3));
+}
+
+}  // namespace orbit_gl
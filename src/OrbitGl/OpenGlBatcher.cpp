@@ -6,12 +6,20 @@
 
 #include <GteVector.h>
 #include <GteVector2.h>
+#include <absl/flags/flag.h>
 #include <stddef.h>
 
-#include <QOpenGLFunctions>
+#include <QMatrix4x4>
+#include <QOpenGLContext>
+#include <QOpenGLShader>
+#include <QSurfaceFormat>
+#include <QString>
+#include <QtGlobal>
 #include <algorithm>
+#include <cmath>
 #include <utility>
 
+#include "ClientFlags/ClientFlags.h"
 #include "Introspection/Introspection.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitGl/BatchRenderGroup.h"
@@ -126,7 +134,11 @@ void OpenGlBatcher::DrawRenderGroup(const BatchRenderGroupId& group, bool pickin
   glEnableClientState(GL_COLOR_ARRAY);
   glEnable(GL_TEXTURE_2D);
 
-  DrawBoxBuffer(group, picking);
+  if (IsInstancedBoxRenderingAvailable()) {
+    DrawBoxBufferInstanced(group, picking);
+  } else {
+    DrawBoxBuffer(group, picking);
+  }
   DrawLineBuffer(group, picking);
   DrawTriangleBuffer(group, picking);
 
@@ -155,6 +167,145 @@ void OpenGlBatcher::DrawBoxBuffer(const BatchRenderGroupId& group, bool picking)
   }
 }
 
+namespace {
+constexpr GLuint kBoxPositionLocation = 0;
+constexpr GLuint kBoxSizeLocation = 1;
+// The colors of the four vertices use the consecutive locations starting at this one.
+constexpr GLuint kBoxColorsLocation = 2;
+
+constexpr const char* kBoxVertexShader = R"(
+#version 330 core
+uniform mat4 projection;
+in vec2 box_position;
+in vec2 box_size;
+in vec4 box_color_0;
+in vec4 box_color_1;
+in vec4 box_color_2;
+in vec4 box_color_3;
+out vec4 color;
+
+void main() {
+  // The triangle strip goes through the corners (0, 0), (0, 1), (1, 0), (1, 1), which are the
+  // vertices 0, 1, 3 and 2 of the box.
+  vec2 corner = vec2(gl_VertexID / 2, gl_VertexID % 2);
+  if (gl_VertexID == 0) {
+    color = box_color_0;
+  } else if (gl_VertexID == 1) {
+    color = box_color_1;
+  } else if (gl_VertexID == 2) {
+    color = box_color_3;
+  } else {
+    color = box_color_2;
+  }
+  gl_Position = projection * vec4(box_position + corner * box_size, 0.0, 1.0);
+}
+)";
+
+constexpr const char* kBoxFragmentShader = R"(
+#version 330 core
+in vec4 color;
+out vec4 fragment_color;
+
+void main() { fragment_color = color; }
+)";
+}  // namespace
+
+bool OpenGlBatcher::IsInstancedBoxRenderingAvailable() {
+  if (instanced_box_rendering_ != InstancedBoxRendering::kUninitialized) {
+    return instanced_box_rendering_ == InstancedBoxRendering::kAvailable;
+  }
+
+  instanced_box_rendering_ = InstancedBoxRendering::kUnavailable;
+  const QOpenGLContext* context = QOpenGLContext::currentContext();
+  if (absl::GetFlag(FLAGS_disable_instanced_rendering) || context == nullptr ||
+      context->isOpenGLES() || context->format().version() < qMakePair(3, 3)) {
+    return false;
+  }
+
+  auto program = std::make_unique<QOpenGLShaderProgram>();
+  program->addShaderFromSourceCode(QOpenGLShader::Vertex, kBoxVertexShader);
+  program->addShaderFromSourceCode(QOpenGLShader::Fragment, kBoxFragmentShader);
+  program->bindAttributeLocation("box_position", kBoxPositionLocation);
+  program->bindAttributeLocation("box_size", kBoxSizeLocation);
+  for (GLuint i = 0; i < 4; ++i) {
+    program->bindAttributeLocation(QString("box_color_%1").arg(i).toUtf8(),
+                                   kBoxColorsLocation + i);
+  }
+  if (!program->link()) {
+    ORBIT_ERROR("Unable to link the box shader, falling back to vertex arrays: %s",
+                program->log().toStdString());
+    return false;
+  }
+  if (!box_instance_buffer_.create()) {
+    ORBIT_ERROR("Unable to create the box instance buffer, falling back to vertex arrays");
+    return false;
+  }
+  box_instance_buffer_.setUsagePattern(QOpenGLBuffer::StreamDraw);
+
+  box_program_ = std::move(program);
+  instanced_box_rendering_ = InstancedBoxRendering::kAvailable;
+  return true;
+}
+
+void OpenGlBatcher::DrawBoxBufferInstanced(const BatchRenderGroupId& group, bool picking) {
+  const auto& box_buffer = primitive_buffers_by_group_.at(group).box_buffer;
+  if (box_buffer.boxes_.size() == 0) return;
+
+  box_instances_.clear();
+  box_instances_.reserve(box_buffer.boxes_.size());
+  auto color_it = !picking ? box_buffer.colors_.begin() : box_buffer.picking_colors_.begin();
+  for (const Quad& box : box_buffer.boxes_) {
+    BoxInstance& instance = box_instances_.emplace_back();
+    instance.position = box.vertices[0];
+    instance.size = box.vertices[2] - box.vertices[0];
+    for (Color& color : instance.colors) {
+      color = *color_it;
+      ++color_it;
+    }
+  }
+
+  // Re-allocating the whole buffer lets the driver orphan the storage still used by the previous
+  // frame instead of waiting for it.
+  box_instance_buffer_.bind();
+  box_instance_buffer_.allocate(box_instances_.data(),
+                                static_cast<int>(box_instances_.size() * sizeof(BoxInstance)));
+
+  // The fixed-function pipeline is set up with the pixel coordinates of the batcher.
+  std::array<GLfloat, 16> projection_values{};
+  std::array<GLfloat, 16> model_view_values{};
+  glGetFloatv(GL_PROJECTION_MATRIX, projection_values.data());
+  glGetFloatv(GL_MODELVIEW_MATRIX, model_view_values.data());
+  // QMatrix4x4 takes its values in row-major order, OpenGL returns them in column-major order.
+  const QMatrix4x4 projection = QMatrix4x4(projection_values.data()).transposed() *
+                                QMatrix4x4(model_view_values.data()).transposed();
+
+  box_program_->bind();
+  box_program_->setUniformValue("projection", projection);
+  constexpr int kStride = sizeof(BoxInstance);
+  box_program_->setAttributeBuffer(kBoxPositionLocation, GL_FLOAT,
+                                   offsetof(BoxInstance, position), 2, kStride);
+  box_program_->setAttributeBuffer(kBoxSizeLocation, GL_FLOAT, offsetof(BoxInstance, size), 2,
+                                   kStride);
+  for (GLuint i = 0; i < 4; ++i) {
+    box_program_->setAttributeBuffer(kBoxColorsLocation + i, GL_UNSIGNED_BYTE,
+                                     offsetof(BoxInstance, colors) + i * sizeof(Color), 4,
+                                     kStride);
+  }
+  for (GLuint location = kBoxPositionLocation; location < kBoxColorsLocation + 4; ++location) {
+    box_program_->enableAttributeArray(location);
+    glVertexAttribDivisor(location, 1);
+  }
+
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(box_instances_.size()));
+
+  for (GLuint location = kBoxPositionLocation; location < kBoxColorsLocation + 4; ++location) {
+    glVertexAttribDivisor(location, 0);
+    box_program_->disableAttributeArray(location);
+  }
+  box_program_->release();
+  box_instance_buffer_.release();
+}
+
 void OpenGlBatcher::DrawLineBuffer(const BatchRenderGroupId& group, bool picking) {
   auto& line_buffer = primitive_buffers_by_group_.at(group).line_buffer;
   const orbit_containers::Block<Line, orbit_gl_internal::LineBuffer::NUM_LINES_PER_BLOCK>*
@@ -194,6 +345,87 @@ void OpenGlBatcher::DrawTriangleBuffer(const BatchRenderGroupId& group, bool pic
   }
 }
 
+namespace {
+// The hit tests below sample at `pos`, which is the center of a pixel, like the rasterization of
+// the picking frame does.
+[[nodiscard]] bool BoxContains(const Quad& box, const Vec2& pos) {
+  // Boxes are axis-aligned, with vertices[0] and vertices[2] as opposite corners, see MakeBox.
+  const float min_x = std::min(box.vertices[0][0], box.vertices[2][0]);
+  const float max_x = std::max(box.vertices[0][0], box.vertices[2][0]);
+  const float min_y = std::min(box.vertices[0][1], box.vertices[2][1]);
+  const float max_y = std::max(box.vertices[0][1], box.vertices[2][1]);
+  return pos[0] >= min_x && pos[0] < max_x && pos[1] >= min_y && pos[1] < max_y;
+}
+
+// Lines are rasterized one pixel wide, so a line covers the pixels whose center is closer than
+// half a pixel to it.
+[[nodiscard]] bool LineContains(const Line& line, const Vec2& pos) {
+  const Vec2 direction = line.end_point - line.start_point;
+  const float squared_length = direction[0] * direction[0] + direction[1] * direction[1];
+  float t = 0.f;
+  if (squared_length > 0.f) {
+    const Vec2 to_pos = pos - line.start_point;
+    t = std::clamp((to_pos[0] * direction[0] + to_pos[1] * direction[1]) / squared_length, 0.f,
+                   1.f);
+  }
+  const Vec2 closest = line.start_point + direction * t;
+  return std::abs(pos[0] - closest[0]) < 0.5f && std::abs(pos[1] - closest[1]) < 0.5f;
+}
+
+[[nodiscard]] float EdgeFunction(const Vec2& from, const Vec2& to, const Vec2& pos) {
+  return (to[0] - from[0]) * (pos[1] - from[1]) - (to[1] - from[1]) * (pos[0] - from[0]);
+}
+
+[[nodiscard]] bool TriangleContains(const Triangle& triangle, const Vec2& pos) {
+  const float e0 = EdgeFunction(triangle.vertices[0], triangle.vertices[1], pos);
+  const float e1 = EdgeFunction(triangle.vertices[1], triangle.vertices[2], pos);
+  const float e2 = EdgeFunction(triangle.vertices[2], triangle.vertices[0], pos);
+  // Either winding order is drawn, as face culling is disabled.
+  return (e0 >= 0.f && e1 >= 0.f && e2 >= 0.f) || (e0 <= 0.f && e1 <= 0.f && e2 <= 0.f);
+}
+
+// Returns the picking color of the last primitive in `primitives` that contains `pos`, as that one
+// is drawn on top. Each primitive has `kVerticesPerPrimitive` picking colors, which are all equal.
+template <size_t kVerticesPerPrimitive, typename PrimitiveChain, typename ColorChain,
+          typename Contains>
+[[nodiscard]] std::optional<Color> FindTopmostPickingColor(const PrimitiveChain& primitives,
+                                                           const ColorChain& picking_colors,
+                                                           const Vec2& pos, Contains&& contains) {
+  std::optional<Color> result;
+  auto color_it = picking_colors.begin();
+  for (const auto& primitive : primitives) {
+    if (contains(primitive, pos)) result = *color_it;
+    for (size_t i = 0; i < kVerticesPerPrimitive; ++i) ++color_it;
+  }
+  return result;
+}
+}  // namespace
+
+std::optional<PickingId> OpenGlBatcher::PickRenderGroup(const BatchRenderGroupId& group,
+                                                        const Vec2& pos) const {
+  ORBIT_SCOPE_FUNCTION;
+  auto buffers_it = primitive_buffers_by_group_.find(group);
+  if (buffers_it == primitive_buffers_by_group_.end()) return std::nullopt;
+  const orbit_gl_internal::PrimitiveBuffers& buffers = buffers_it->second;
+
+  // DrawRenderGroup draws the boxes first, then the lines and then the triangles.
+  std::optional<Color> picking_color = FindTopmostPickingColor<3>(
+      buffers.triangle_buffer.triangles_, buffers.triangle_buffer.picking_colors_, pos,
+      TriangleContains);
+  if (!picking_color.has_value()) {
+    picking_color = FindTopmostPickingColor<2>(buffers.line_buffer.lines_,
+                                               buffers.line_buffer.picking_colors_, pos,
+                                               LineContains);
+  }
+  if (!picking_color.has_value()) {
+    picking_color = FindTopmostPickingColor<4>(buffers.box_buffer.boxes_,
+                                               buffers.box_buffer.picking_colors_, pos,
+                                               BoxContains);
+  }
+  if (!picking_color.has_value()) return std::nullopt;
+  return PickingId::FromColor(picking_color.value());
+}
+
 const PickingUserData* OpenGlBatcher::GetUserData(PickingId id) const {
   ORBIT_CHECK(id.element_id >= 0);
   ORBIT_CHECK(id.batcher_id == GetBatcherId());
@@ -262,7 +494,11 @@ size_t CalculateBlockChainNonEmptyBlockCount(const orbit_containers::BlockChain<
     result.stored_vertices += layer.second.line_buffer.lines_.size() * 2;
     result.stored_vertices += layer.second.triangle_buffer.triangles_.size() * 3;
 
-    result.draw_calls += CalculateBlockChainNonEmptyBlockCount(layer.second.box_buffer.boxes_);
+    if (instanced_box_rendering_ == InstancedBoxRendering::kAvailable) {
+      if (layer.second.box_buffer.boxes_.size() != 0) ++result.draw_calls;
+    } else {
+      result.draw_calls += CalculateBlockChainNonEmptyBlockCount(layer.second.box_buffer.boxes_);
+    }
     result.draw_calls += CalculateBlockChainNonEmptyBlockCount(layer.second.line_buffer.lines_);
     result.draw_calls +=
         CalculateBlockChainNonEmptyBlockCount(layer.second.triangle_buffer.triangles_);
@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -189,6 +190,48 @@ TEST(OpenGlBatcher, PickingSimpleElements) {
   ExpectCustomDataEq(batcher, batcher.GetDrawnBoxColors()[0], box_custom_data);
 }
 
+TEST(OpenGlBatcher, PickRenderGroupReturnsTopmostElement) {
+  FakeOpenGlBatcher batcher(BatcherId::kUi);
+
+  std::string line_custom_data = "line custom data";
+  auto line_user_data = std::make_unique<PickingUserData>();
+  line_user_data->custom_data_ = &line_custom_data;
+
+  std::string triangle_custom_data = "triangle custom data";
+  auto triangle_user_data = std::make_unique<PickingUserData>();
+  triangle_user_data->custom_data_ = &triangle_custom_data;
+
+  std::string box_custom_data = "box custom data";
+  auto box_user_data = std::make_unique<PickingUserData>();
+  box_user_data->custom_data_ = &box_custom_data;
+
+  batcher.AddBoxHelper(MakeBox(Vec2(0, 0), Vec2(10, 10)), 0, Color(255, 0, 0, 255),
+                       std::move(box_user_data));
+  batcher.AddTriangleHelper(Triangle(Vec2(0, 0), Vec2(0, 5), Vec2(5, 0)), 0, Color(0, 255, 0, 255),
+                            std::move(triangle_user_data));
+  batcher.AddLineHelper(Vec2(20, 0), Vec2(20, 10), 0, Color(255, 255, 255, 255),
+                        std::move(line_user_data));
+
+  std::vector<BatchRenderGroupId> groups = batcher.GetNonEmptyRenderGroups();
+  ASSERT_EQ(groups.size(), 1);
+  const BatchRenderGroupId& group = groups[0];
+
+  auto expect_picked = [&](const Vec2& pos, const std::string& expected_custom_data) {
+    std::optional<PickingId> id = batcher.PickRenderGroup(group, pos);
+    ASSERT_TRUE(id.has_value());
+    const PickingUserData* user_data = batcher.GetUserData(id.value());
+    ASSERT_NE(user_data, nullptr);
+    EXPECT_EQ(*static_cast<const std::string*>(user_data->custom_data_), expected_custom_data);
+  };
+
+  // The triangle is drawn on top of the box.
+  expect_picked(Vec2(1, 1), triangle_custom_data);
+  expect_picked(Vec2(8, 8), box_custom_data);
+  expect_picked(Vec2(20.2f, 5), line_custom_data);
+  EXPECT_FALSE(batcher.PickRenderGroup(group, Vec2(15, 5)).has_value());
+  EXPECT_FALSE(batcher.PickRenderGroup(group, Vec2(8, 20)).has_value());
+}
+
 TEST(OpenGlBatcher, MultipleDrawCalls) {
   FakeOpenGlBatcher batcher(BatcherId::kUi);
 
@@ -9,6 +9,7 @@
 #include <absl/flags/flag.h>
 #include <absl/hash/hash.h>
 #include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_join.h>
@@ -18,6 +19,7 @@
 #include <absl/time/time.h>
 #include <absl/types/span.h>
 #include <errno.h>
+#include <google/protobuf/descriptor.h>
 #include <google/protobuf/stubs/port.h>
 #include <stdio.h>
 
@@ -48,6 +50,7 @@
 #include "CaptureFile/CaptureFile.h"
 #include "CaptureFile/CaptureFileHelpers.h"
 #include "ClientData/CallstackData.h"
+#include "ClientData/CallstackInfo.h"
 #include "ClientData/CallstackType.h"
 #include "ClientData/ModuleData.h"
 #include "ClientData/ModuleIdentifier.h"
@@ -64,8 +67,11 @@
 #include "ClientData/UserDefinedCaptureData.h"
 #include "ClientFlags/ClientFlags.h"
 #include "ClientModel/CaptureSerializer.h"
+#include "ClientModel/CaptureSummary.h"
+#include "ClientModel/LiveSamplingDataPostProcessor.h"
 #include "ClientModel/SamplingDataPostProcessor.h"
 #include "ClientProtos/capture_data.pb.h"
+#include "ClientProtos/capture_summary.pb.h"
 #include "ClientProtos/preset.pb.h"
 #include "ClientProtos/user_defined_capture_info.pb.h"
 #include "ClientServices/TracepointServiceClient.h"
@@ -126,6 +132,7 @@ using orbit_capture_client::CaptureClient;
 using orbit_capture_client::CaptureEventProcessor;
 using orbit_capture_client::CaptureListener;
 using orbit_capture_client::ClientCaptureOptions;
+using orbit_capture_client::LoadCaptureFilter;
 
 using orbit_capture_file::CaptureFile;
 
@@ -255,6 +262,76 @@ orbit_data_views::PresetLoadState GetPresetLoadStateForProcess(const PresetFile&
   return prioritized_modules;
 }
 
+// Returns for each module the number of callstack samples with a frame in the module.
+[[nodiscard]] absl::flat_hash_map<const ModuleData*, uint64_t> CountCallstackSamplesByModule(
+    const CallstackData& callstack_data, const ProcessData& process,
+    const orbit_client_data::ModuleManager& module_manager) {
+  absl::flat_hash_map<uint64_t, uint64_t> count_by_callstack_id;
+  callstack_data.ForEachCallstackEvent(
+      [&](const CallstackEvent& event) { ++count_by_callstack_id[event.callstack_id()]; });
+
+  absl::flat_hash_map<const ModuleData*, uint64_t> count_by_module;
+  absl::flat_hash_set<const ModuleData*> modules_of_callstack;
+  callstack_data.ForEachUniqueCallstack(
+      [&](uint64_t callstack_id, const orbit_client_data::CallstackInfo& callstack) {
+        const auto count_it = count_by_callstack_id.find(callstack_id);
+        if (count_it == count_by_callstack_id.end()) return;
+
+        modules_of_callstack.clear();
+        for (uint64_t frame : callstack.frames()) {
+          ErrorMessageOr<orbit_client_data::ModuleInMemory> module_in_memory =
+              process.FindModuleByAddress(frame);
+          if (module_in_memory.has_error()) continue;
+          const ModuleData* module =
+              module_manager.GetModuleByModuleIdentifier(module_in_memory.value().module_id());
+          if (module != nullptr) modules_of_callstack.insert(module);
+        }
+        for (const ModuleData* module : modules_of_callstack) {
+          count_by_module[module] += count_it->second;
+        }
+      });
+  return count_by_module;
+}
+
+[[nodiscard]] uint64_t MillisecondsToNanoseconds(uint64_t milliseconds) {
+  constexpr uint64_t kNanosecondsPerMillisecond = 1'000'000;
+  if (milliseconds > std::numeric_limits<uint64_t>::max() / kNanosecondsPerMillisecond) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return milliseconds * kNanosecondsPerMillisecond;
+}
+
+[[nodiscard]] ErrorMessageOr<LoadCaptureFilter> CreateLoadCaptureFilterFromFlags() {
+  LoadCaptureFilter filter;
+  filter.min_relative_timestamp_ns =
+      MillisecondsToNanoseconds(absl::GetFlag(FLAGS_load_capture_min_time_ms));
+  filter.max_relative_timestamp_ns =
+      MillisecondsToNanoseconds(absl::GetFlag(FLAGS_load_capture_max_time_ms));
+
+  for (const std::string& thread_id : absl::GetFlag(FLAGS_load_capture_thread_ids)) {
+    uint32_t tid = 0;
+    if (!absl::SimpleAtoi(thread_id, &tid)) {
+      return ErrorMessage{absl::StrFormat("Invalid thread id \"%s\" in --load_capture_thread_ids",
+                                          thread_id)};
+    }
+    filter.thread_ids.insert(tid);
+  }
+
+  // The field numbers of the ClientCaptureEvent oneof are the values of its EventCase enum.
+  const google::protobuf::Descriptor* descriptor =
+      orbit_grpc_protos::ClientCaptureEvent::descriptor();
+  for (const std::string& event_type : absl::GetFlag(FLAGS_load_capture_event_types)) {
+    const google::protobuf::FieldDescriptor* field = descriptor->FindFieldByName(event_type);
+    if (field == nullptr || field->containing_oneof() == nullptr) {
+      return ErrorMessage{absl::StrFormat(
+          "Invalid event type \"%s\" in --load_capture_event_types", event_type)};
+    }
+    filter.event_cases.insert(
+        static_cast<orbit_grpc_protos::ClientCaptureEvent::EventCase>(field->number()));
+  }
+  return filter;
+}
+
 }  // namespace
 
 bool DoZoom = false;
@@ -380,6 +457,12 @@ void OrbitApp::OnCaptureStarted(const orbit_grpc_protos::CaptureStarted& capture
 
     frame_track_online_processor_ =
         orbit_gl::FrameTrackOnlineProcessor(GetCaptureData(), GetMutableTimeGraph());
+    if (data_source_ == CaptureData::DataSource::kLiveCapture) {
+      live_sampling_data_post_processor_ =
+          std::make_unique<orbit_client_model::LiveSamplingDataPostProcessor>(
+              GetCaptureDataPointer(), module_manager_.get(), kLiveSamplingReportInterval,
+              kLiveSamplingReportFunctionCount);
+    }
 
     ORBIT_CHECK(capture_started_callback_ != nullptr);
     capture_started_callback_(file_path);
@@ -425,39 +508,77 @@ Future<void> OrbitApp::OnCaptureComplete() {
   GetMutableCaptureData().ComputeVirtualAddressOfInstrumentedFunctionsIfNecessary(*module_manager_);
 
   GetMutableCaptureData().FilterBrokenCallstacks();
+
+  ORBIT_LOG("The capture contains %u intervals with incomplete data",
+            GetCaptureData().incomplete_data_intervals().size());
+
+  // The timeline of a loaded capture is complete once the ScopeTrees are built, so show it before
+  // post-processing the callstack samples for the sampling reports, which can take about as long
+  // as the loading itself. For live captures, the capture stays in the stopping state until then.
+  if (IsLoadingCapture()) {
+    return main_thread_executor_
+        ->Schedule([this]() {
+          ORBIT_SCOPE("OnCaptureComplete: show the timeline");
+          TrySaveUserDefinedCaptureInfo();
+          RefreshFrameTracks();
+          RefreshCaptureView();
+        })
+        .Then(thread_pool_.get(), [this]() {
+          PostProcessedSamplingData post_processed_sampling_data =
+              orbit_client_model::CreatePostProcessedSamplingData(
+                  GetCaptureData().GetCallstackData(), GetCaptureData(), *module_manager_);
+          // Scheduling from here moves the data to the main thread instead of copying it through
+          // the result of a future.
+          return main_thread_executor_->Schedule(
+              [this, post_processed_sampling_data =
+                         std::move(post_processed_sampling_data)]() mutable {
+                ORBIT_SCOPE("OnCaptureComplete");
+                OnPostProcessedSamplingDataCreated(std::move(post_processed_sampling_data));
+              });
+        });
+  }
+
   PostProcessedSamplingData post_processed_sampling_data =
       orbit_client_model::CreatePostProcessedSamplingData(GetCaptureData().GetCallstackData(),
                                                           GetCaptureData(), *module_manager_);
 
-  ORBIT_LOG("The capture contains %u intervals with incomplete data",
-            GetCaptureData().incomplete_data_intervals().size());
+  TrySaveCaptureSummary(post_processed_sampling_data);
 
   return main_thread_executor_->Schedule(
       [this, post_processed_sampling_data = std::move(post_processed_sampling_data)]() mutable {
         ORBIT_SCOPE("OnCaptureComplete");
         TrySaveUserDefinedCaptureInfo();
         RefreshFrameTracks();
-        GetMutableCaptureData().set_post_processed_sampling_data(
-            std::move(post_processed_sampling_data));
-        RefreshCaptureView();
+        OnPostProcessedSamplingDataCreated(std::move(post_processed_sampling_data));
+      });
+}
 
-        full_capture_selection_ = std::make_unique<SelectionData>(
-            module_manager_.get(), GetCaptureDataPointer(),
-            GetCaptureData().post_processed_sampling_data(), &GetCaptureData().GetCallstackData());
-        main_window_->SetSelection(*full_capture_selection_);
+void OrbitApp::OnPostProcessedSamplingDataCreated(
+    PostProcessedSamplingData post_processed_sampling_data) {
+  GetMutableCaptureData().set_post_processed_sampling_data(std::move(post_processed_sampling_data));
+  RefreshCaptureView();
 
-        ORBIT_CHECK(capture_stopped_callback_);
-        capture_stopped_callback_();
+  full_capture_selection_ = std::make_unique<SelectionData>(
+      module_manager_.get(), GetCaptureDataPointer(),
+      GetCaptureData().post_processed_sampling_data(), &GetCaptureData().GetCallstackData());
+  main_window_->SetSelection(*full_capture_selection_);
+  SetPageFaultsBottomUpView(GetCaptureData());
+  // The sampling report doesn't point to the live snapshot anymore.
+  live_sampling_data_post_processor_.reset();
+  live_sampling_snapshot_.reset();
+  live_sampling_snapshot_thread_count_ = 0;
 
-        if (GetCaptureData().GetAllProvidedScopeIds().empty()) {
-          main_window_->SelectTopDownTab();
-        }
-        FireRefreshCallbacks();
+  ORBIT_CHECK(capture_stopped_callback_);
+  capture_stopped_callback_();
 
-        if (absl::GetFlag(FLAGS_auto_symbol_loading)) {
-          std::ignore = LoadAllSymbols();
-        }
-      });
+  if (GetCaptureData().GetAllProvidedScopeIds().empty()) {
+    main_window_->SelectTopDownTab();
+  }
+  FireRefreshCallbacks();
+
+  if (absl::GetFlag(FLAGS_auto_symbol_loading)) {
+    std::ignore = LoadAllSymbols();
+  }
 }
 
 Future<void> OrbitApp::OnCaptureCancelled() {
@@ -495,6 +616,40 @@ void OrbitApp::OnTimer(const TimerInfo& timer_info) {
   frame_track_online_processor_.ProcessTimer(timer_info);
 }
 
+void OrbitApp::OnCallstackEvent(CallstackEvent callstack_event) {
+  AbstractCaptureListener::OnCallstackEvent(callstack_event);
+
+  if (live_sampling_data_post_processor_ != nullptr &&
+      live_sampling_data_post_processor_->ProcessCallstackEvent(callstack_event, absl::Now())) {
+    main_thread_executor_->Schedule([this]() { RefreshLiveSamplingReport(); });
+  }
+}
+
+void OrbitApp::OnTimers(absl::Span<const TimerInfo> timer_infos) {
+  CaptureData& capture_data = GetMutableCaptureData();
+  TimeGraph* time_graph = GetMutableTimeGraph();
+  for (const TimerInfo& timer_info : timer_infos) {
+    capture_data.UpdateScopeStats(timer_info);
+    time_graph->ProcessTimer(timer_info);
+    frame_track_online_processor_.ProcessTimer(timer_info);
+  }
+}
+
+void OrbitApp::OnCallstackEvents(absl::Span<const CallstackEvent> callstack_events) {
+  AbstractCaptureListener::OnCallstackEvents(callstack_events);
+
+  if (live_sampling_data_post_processor_ == nullptr) return;
+  bool refresh_live_sampling_report = false;
+  const absl::Time now = absl::Now();
+  for (const CallstackEvent& callstack_event : callstack_events) {
+    refresh_live_sampling_report |=
+        live_sampling_data_post_processor_->ProcessCallstackEvent(callstack_event, now);
+  }
+  if (refresh_live_sampling_report) {
+    main_thread_executor_->Schedule([this]() { RefreshLiveSamplingReport(); });
+  }
+}
+
 void OrbitApp::OnCgroupAndProcessMemoryInfo(
     const orbit_client_data::CgroupAndProcessMemoryInfo& cgroup_and_process_memory_info) {
   GetMutableTimeGraph()->ProcessCgroupAndProcessMemoryInfo(cgroup_and_process_memory_info);
@@ -557,6 +712,16 @@ void OrbitApp::OnModulesSnapshot(uint64_t /*timestamp_ns*/, std::vector<ModuleIn
 
 void OrbitApp::OnPresentEvent(const orbit_grpc_protos::PresentEvent& /*present_event*/) {}
 
+void OrbitApp::OnPressureStallEvent(
+    const orbit_grpc_protos::PressureStallEvent& pressure_stall_event) {
+  GetMutableTimeGraph()->ProcessPressureStallEvent(pressure_stall_event);
+}
+
+void OrbitApp::OnPerformanceCounterSample(
+    const orbit_grpc_protos::PerformanceCounterSample& performance_counter_sample) {
+  GetMutableTimeGraph()->ProcessPerformanceCounterSample(performance_counter_sample);
+}
+
 void OrbitApp::OnWarningEvent(orbit_grpc_protos::WarningEvent warning_event) {
   main_thread_executor_->Schedule([this, warning_event = std::move(warning_event)]() {
     main_window_->AppendToCaptureLog(MainWindowInterface::CaptureLogSeverity::kWarning,
@@ -731,6 +896,14 @@ void OrbitApp::OnOutOfOrderEventsDiscardedEvent(
   });
 }
 
+void OrbitApp::OnPerfEventProcessingStatsEvent(
+    orbit_grpc_protos::PerfEventProcessingStatsEvent perf_event_processing_stats_event) {
+  main_thread_executor_->Schedule([this, perf_event_processing_stats_event =
+                                             std::move(perf_event_processing_stats_event)]() {
+    GetMutableCaptureData().set_perf_event_processing_stats(perf_event_processing_stats_event);
+  });
+}
+
 std::unique_ptr<OrbitApp> OrbitApp::Create(orbit_gl::MainWindowInterface* main_window,
                                            orbit_base::Executor* main_thread_executor) {
   return std::make_unique<OrbitApp>(main_window, main_thread_executor);
@@ -877,10 +1050,14 @@ void OrbitApp::Disassemble(uint32_t pid, const FunctionInfo& function) {
     }
 
     const std::string& memory = result.value();
-    orbit_code_report::Disassembler disasm;
-    disasm.AddLine(absl::StrFormat("asm: /* %s */", function.pretty_name()));
-    disasm.Disassemble(*process_, *module_manager_, memory.data(), memory.size(), absolute_address,
-                       is_64_bit);
+    orbit_code_report::Disassembler disasm = disassembly_cache_.GetOrDisassemble(
+        function.module_build_id(), absolute_address, memory, [&]() {
+          orbit_code_report::Disassembler disassembler;
+          disassembler.AddLine(absl::StrFormat("asm: /* %s */", function.pretty_name()));
+          disassembler.Disassemble(*process_, *module_manager_, memory.data(), memory.size(),
+                                   absolute_address, is_64_bit);
+          return disassembler;
+        });
     if (!HasCaptureData() || !GetCaptureData().has_post_processed_sampling_data()) {
       orbit_code_report::DisassemblyReport empty_report(disasm, absolute_address);
       SendDisassemblyToUi(function, disasm.GetResult(), std::move(empty_report));
@@ -980,6 +1157,34 @@ void OrbitApp::MainTick() {
     RequestUpdatePrimitives();
     DoZoom = false;
   }
+
+  if (IsCapturing()) StopCaptureIfMemoryBudgetIsExceeded();
+}
+
+void OrbitApp::StopCaptureIfMemoryBudgetIsExceeded() {
+  const uint64_t memory_budget_mb = absl::GetFlag(FLAGS_capture_memory_budget_mb);
+  if (memory_budget_mb == 0 || !HasCaptureData() ||
+      data_source_ != CaptureData::DataSource::kLiveCapture) {
+    return;
+  }
+
+  const absl::Time now = absl::Now();
+  if (now - last_capture_memory_budget_check_time_ < kCaptureMemoryBudgetCheckInterval) return;
+  last_capture_memory_budget_check_time_ = now;
+
+  const uint64_t memory_usage_bytes = GetCaptureData().GetMemoryUsageBytes();
+  if (memory_usage_bytes <= memory_budget_mb * 1024 * 1024) return;
+
+  // StopCapture is ignored while the capture is still starting or already stopping, so only warn
+  // once the capture is actually being stopped.
+  if (!capture_client_->StopCapture()) return;
+  ORBIT_CHECK(capture_stop_requested_callback_);
+  capture_stop_requested_callback_();
+  SendWarningToUi("Capture stopped",
+                  absl::StrFormat("The capture was stopped because its data takes about %u MB, "
+                                  "more than the budget of %u MB set with "
+                                  "--capture_memory_budget_mb.",
+                                  memory_usage_bytes / (1024 * 1024), memory_budget_mb));
 }
 
 void OrbitApp::SetCaptureWindow(CaptureWindow* capture) {
@@ -1054,6 +1259,24 @@ void OrbitApp::ClearSelectionBottomUpView() {
   main_window_->SetSelectionBottomUpView(std::make_unique<CallTreeView>());
 }
 
+void OrbitApp::SetPageFaultsBottomUpView(const CaptureData& capture_data) {
+  const CallstackData& page_fault_callstack_data = capture_data.GetPageFaultCallstackData();
+  if (page_fault_callstack_data.GetCallstackEventsCount() == 0) {
+    ClearPageFaultsBottomUpView();
+    return;
+  }
+  const PostProcessedSamplingData page_fault_sampling_data =
+      orbit_client_model::CreatePostProcessedSamplingData(page_fault_callstack_data, capture_data,
+                                                          *module_manager_);
+  main_window_->SetPageFaultsBottomUpView(
+      CallTreeView::CreateBottomUpViewFromPostProcessedSamplingData(
+          page_fault_sampling_data, module_manager_.get(), &capture_data));
+}
+
+void OrbitApp::ClearPageFaultsBottomUpView() {
+  main_window_->SetPageFaultsBottomUpView(std::make_unique<CallTreeView>());
+}
+
 absl::Duration OrbitApp::GetCaptureTime() const {
   const TimeGraph* time_graph = GetTimeGraph();
   return absl::Nanoseconds((time_graph == nullptr) ? 0 : time_graph->GetCaptureTimeSpanNs());
@@ -1138,6 +1361,8 @@ Future<ErrorMessageOr<CaptureListener::CaptureOutcome>> OrbitApp::LoadCaptureFro
       [this, file_path]() -> ErrorMessageOr<CaptureListener::CaptureOutcome> {
         capture_loading_cancellation_requested_ = false;
 
+        OUTCOME_TRY(const LoadCaptureFilter load_capture_filter,
+                    CreateLoadCaptureFilterFromFlags());
         OUTCOME_TRY(const std::unique_ptr<CaptureFile> capture_file,
                     CaptureFile::OpenForReadWrite(file_path));
 
@@ -1149,7 +1374,8 @@ Future<ErrorMessageOr<CaptureListener::CaptureOutcome>> OrbitApp::LoadCaptureFro
                                                }};
 
         ErrorMessageOr<CaptureListener::CaptureOutcome> load_result =
-            LoadCapture(this, capture_file.get(), &capture_loading_cancellation_requested_);
+            LoadCapture(this, capture_file.get(), &capture_loading_cancellation_requested_,
+                        load_capture_filter);
 
         if (load_result.has_value() && load_result.value() == CaptureOutcome::kComplete) {
           OnCaptureComplete();
@@ -1367,6 +1593,10 @@ void OrbitApp::StartCapture() {
   options.collect_gpu_jobs = !IsDevMode() || data_manager_->trace_gpu_submissions();
   options.enable_api = data_manager_->enable_api();
   options.enable_introspection = IsDevMode() && data_manager_->enable_introspection();
+  options.api_track_aggregation_window_ns =
+      absl::GetFlag(FLAGS_api_track_aggregation_window_ms) * 1'000'000;
+  options.off_cpu_time_aggregation_interval_ns =
+      absl::GetFlag(FLAGS_off_cpu_time_aggregation_interval_ms) * 1'000'000;
   options.dynamic_instrumentation_method = data_manager_->dynamic_instrumentation_method();
   options.samples_per_second = data_manager_->samples_per_second();
   options.stack_dump_size = data_manager_->stack_dump_size();
@@ -1378,13 +1608,30 @@ void OrbitApp::StartCapture() {
 
   options.collect_memory_info = data_manager_->collect_memory_info();
   options.memory_sampling_period_ms = data_manager_->memory_sampling_period_ms();
+  options.page_fault_sampling_period = absl::GetFlag(FLAGS_page_fault_sampling_period);
+  options.pressure_stall_threshold_ms = absl::GetFlag(FLAGS_pressure_stall_threshold_ms);
+  options.pressure_stall_window_ms = absl::GetFlag(FLAGS_pressure_stall_window_ms);
+  options.sample_performance_counters = absl::GetFlag(FLAGS_sample_performance_counters);
   options.selected_functions = std::move(selected_functions_map);
   options.functions_to_record_additional_stack_on =
       std::move(functions_to_record_additional_stack_on);
   options.absolute_address_to_size_of_functions_to_stop_unwinding_at =
       std::move(absolute_address_to_size_of_functions_to_stop_unwinding_at);
   options.process_id = process->pid();
+  for (const std::string& pid_string : absl::GetFlag(FLAGS_additional_thread_state_pids)) {
+    uint32_t pid = 0;
+    if (!absl::SimpleAtoi(pid_string, &pid)) {
+      ORBIT_ERROR("Invalid pid \"%s\" in --additional_thread_state_pids", pid_string);
+      continue;
+    }
+    options.additional_thread_state_process_ids.push_back(pid);
+  }
   options.record_return_values = absl::GetFlag(FLAGS_show_return_values);
+  options.subtract_instrumentation_overhead =
+      absl::GetFlag(FLAGS_subtract_instrumentation_overhead);
+  options.capture_response_compression = absl::GetFlag(FLAGS_compress_capture_responses)
+                                             ? orbit_grpc_protos::CaptureOptions::kGzip
+                                             : orbit_grpc_protos::CaptureOptions::kNoCompression;
   options.record_arguments = false;
   options.enable_auto_frame_track = data_manager_->enable_auto_frame_track();
   options.thread_state_change_callstack_collection =
@@ -1446,10 +1693,18 @@ void OrbitApp::ClearCapture() {
   ORBIT_SCOPE_FUNCTION;
 
   ClearSamplingRelatedViews();
+  live_sampling_data_post_processor_.reset();
+  live_sampling_snapshot_.reset();
+  live_sampling_snapshot_thread_count_ = 0;
   if (capture_window_ != nullptr) {
     capture_window_->ClearTimeGraph();
   }
   ResetCaptureData();
+  {
+    // The next capture can be saved to the same file, so don't compare with writes to this one.
+    absl::MutexLock lock{&user_defined_capture_info_write_mutex_};
+    ++capture_number_;
+  }
 
   string_manager_.Clear();
 
@@ -1579,6 +1834,8 @@ void OrbitApp::AddSymbols(const orbit_client_data::ModulePathAndBuildId& module_
     functions_data_view_->RemoveFunctionsOfModule(module_data->file_path());
   }
   module_data->AddSymbols(module_symbols);
+  // Disassemblies show the names of callees, which can be in this module.
+  disassembly_cache_.Clear();
 
   const std::optional<ModuleIdentifier> module_identifier =
       module_identifier_provider_.GetModuleIdentifier(module_path_and_build_id);
@@ -1602,6 +1859,7 @@ void OrbitApp::AddFallbackSymbols(
   ORBIT_SCOPE_FUNCTION;
   ModuleData* module_data = GetMutableModuleByModulePathAndBuildId(module_path_and_build_id);
   module_data->AddFallbackSymbols(fallback_symbols);
+  disassembly_cache_.Clear();
 
   const std::optional<ModuleIdentifier> module_identifier =
       module_identifier_provider_.GetModuleIdentifier(module_path_and_build_id);
@@ -1892,16 +2150,34 @@ Future<std::vector<ErrorMessageOr<CanceledOr<void>>>> OrbitApp::LoadAllSymbols()
 
   const ProcessData& process = GetConnectedOrLoadedProcess();
 
+  // Modules that appear in the callstacks of the capture go first, the most sampled first, as
+  // these are the ones the reports need symbols of.
+  std::vector<const ModuleData*> modules = module_manager_->GetAllModuleData();
+  if (HasCaptureData()) {
+    const absl::flat_hash_map<const ModuleData*, uint64_t> sample_count_by_module =
+        CountCallstackSamplesByModule(GetCaptureData().GetCallstackData(), process,
+                                      *module_manager_);
+    auto get_sample_count = [&](const ModuleData* module) -> uint64_t {
+      const auto it = sample_count_by_module.find(module);
+      return it == sample_count_by_module.end() ? 0 : it->second;
+    };
+    std::stable_sort(modules.begin(), modules.end(),
+                     [&](const ModuleData* lhs, const ModuleData* rhs) {
+                       return get_sample_count(lhs) > get_sample_count(rhs);
+                     });
+  }
   std::vector<const ModuleData*> sorted_module_list = SortModuleListWithPrioritizationList(
-      module_manager_->GetAllModuleData(),
-      {kGgpVlkModulePathSubstring, kNtdllSoFileName, process.full_path()});
+      std::move(modules), {kGgpVlkModulePathSubstring, kNtdllSoFileName, process.full_path()});
 
   std::vector<Future<ErrorMessageOr<CanceledOr<void>>>> loading_futures;
 
+  // The priorities keep the order of the list, below those of symbols loaded manually.
+  uint64_t priority = sorted_module_list.size();
   for (const ModuleData* module : sorted_module_list) {
+    --priority;
     if (module->AreDebugSymbolsLoaded()) continue;
 
-    loading_futures.push_back(symbol_loader_->RetrieveModuleAndLoadSymbols(module));
+    loading_futures.push_back(symbol_loader_->RetrieveModuleAndLoadSymbols(module, priority));
   }
   if (data_manager_->enable_auto_frame_track()) {
     // Orbit will try to add the default frame track while loading all symbols.
@@ -2329,6 +2605,7 @@ void OrbitApp::ClearSelectionTabs() {
   ClearSelectionReport();
   ClearSelectionTopDownView();
   ClearSelectionBottomUpView();
+  ClearPageFaultsBottomUpView();
 }
 
 void OrbitApp::ClearInspection() {
@@ -2373,6 +2650,7 @@ void OrbitApp::UpdateAfterSymbolLoading() {
   SetSelectionBottomUpView(capture_data.selection_post_processed_sampling_data(), &capture_data);
   main_window_->UpdateSelectionReport(&capture_data.selection_callstack_data(),
                                       &capture_data.selection_post_processed_sampling_data());
+  SetPageFaultsBottomUpView(capture_data);
 }
 
 void OrbitApp::UpdateAfterSymbolLoadingThrottled() {
@@ -2380,6 +2658,24 @@ void OrbitApp::UpdateAfterSymbolLoadingThrottled() {
   update_after_symbol_loading_throttle_.Fire();
 }
 
+void OrbitApp::RefreshLiveSamplingReport() {
+  ORBIT_SCOPE_FUNCTION;
+  // The capture might have completed since this refresh was scheduled.
+  if (live_sampling_data_post_processor_ == nullptr) return;
+
+  live_sampling_snapshot_ = live_sampling_data_post_processor_->CreateSnapshot(absl::Now());
+  const CallstackData* callstack_data = &GetCaptureData().GetCallstackData();
+  // UpdateSamplingReport only refreshes the tabs of the threads that are already shown.
+  const size_t thread_count = live_sampling_snapshot_->GetSortedThreadSampleData().size();
+  if (thread_count != live_sampling_snapshot_thread_count_) {
+    main_window_->SetSamplingReport(callstack_data, &live_sampling_snapshot_.value());
+    live_sampling_snapshot_thread_count_ = thread_count;
+  } else {
+    main_window_->UpdateSamplingReport(callstack_data, &live_sampling_snapshot_.value());
+  }
+  FireRefreshCallbacks(DataViewType::kSampling);
+}
+
 void OrbitApp::ClearSamplingRelatedViews() {
   ClearSamplingReport();
   ClearSelectionReport();
@@ -2750,15 +3046,70 @@ void OrbitApp::TrySaveUserDefinedCaptureInfo() {
   const auto& frame_track_function_ids = GetCaptureData().frame_track_function_ids();
   *capture_info.mutable_frame_tracks_info()->mutable_frame_track_function_ids() = {
       frame_track_function_ids.begin(), frame_track_function_ids.end()};
-  thread_pool_->Schedule([this, capture_info = std::move(capture_info),
+
+  absl::MutexLock lock{&user_defined_capture_info_write_mutex_};
+  // Replaces the previous state if its write hasn't started yet.
+  pending_user_defined_capture_info_write_ =
+      UserDefinedCaptureInfoWrite{capture_number_, file_path.value(), std::move(capture_info)};
+  if (user_defined_capture_info_write_scheduled_) return;
+  user_defined_capture_info_write_scheduled_ = true;
+  thread_pool_->Schedule([this] { WritePendingUserDefinedCaptureInfo(); });
+}
+
+void OrbitApp::WritePendingUserDefinedCaptureInfo() {
+  while (true) {
+    UserDefinedCaptureInfoWrite write;
+    {
+      absl::MutexLock lock{&user_defined_capture_info_write_mutex_};
+      if (!pending_user_defined_capture_info_write_.has_value()) {
+        user_defined_capture_info_write_scheduled_ = false;
+        return;
+      }
+      write = std::move(pending_user_defined_capture_info_write_.value());
+      pending_user_defined_capture_info_write_.reset();
+    }
+
+    std::string serialized_capture_info = write.capture_info.SerializeAsString();
+    absl::MutexLock lock{&capture_file_mutex_};
+    if (last_written_user_defined_capture_info_.has_value() &&
+        last_written_user_defined_capture_info_->first == write.capture_number &&
+        last_written_user_defined_capture_info_->second == serialized_capture_info) {
+      continue;
+    }
+
+    ORBIT_LOG("Saving user defined capture info to \"%s\"", write.file_path.string());
+    auto write_result = orbit_capture_file::WriteUserData(write.file_path, write.capture_info);
+    if (write_result.has_error()) {
+      last_written_user_defined_capture_info_.reset();
+      SendErrorToUi("Save failed",
+                    absl::StrFormat("Save to \"%s\" failed: %s", write.file_path.string(),
+                                    write_result.error().message()));
+    } else {
+      last_written_user_defined_capture_info_.emplace(write.capture_number,
+                                                      std::move(serialized_capture_info));
+    }
+    capture_file_info_manager_.AddOrTouchCaptureFile(write.file_path, GetCaptureTime());
+  }
+}
+
+void OrbitApp::TrySaveCaptureSummary(
+    const PostProcessedSamplingData& post_processed_sampling_data) {
+  // Loaded captures either contain the summary already or were saved before it was introduced.
+  if (IsLoadingCapture()) return;
+
+  const auto& file_path = GetCaptureData().file_path();
+  if (!file_path.has_value()) return;
+
+  std::vector<orbit_client_protos::CaptureSummaryEntry> capture_summary =
+      orbit_client_model::CreateCaptureSummary(GetCaptureData(), post_processed_sampling_data);
+  thread_pool_->Schedule([this, capture_summary = std::move(capture_summary),
                           file_path = file_path.value()] {
-    ORBIT_LOG("Saving user defined capture info to \"%s\"", file_path.string());
-    auto write_result = orbit_capture_file::WriteUserData(file_path, capture_info);
+    ORBIT_SCOPED_TIMED_LOG("Saving capture summary to \"%s\"", file_path.string());
+    absl::MutexLock lock{&capture_file_mutex_};
+    auto write_result = orbit_capture_file::WriteCaptureSummary(file_path, capture_summary);
     if (write_result.has_error()) {
-      SendErrorToUi("Save failed", absl::StrFormat("Save to \"%s\" failed: %s", file_path.string(),
-                                                   write_result.error().message()));
+      ORBIT_ERROR("Unable to save capture summary: %s", write_result.error().message());
     }
-    capture_file_info_manager_.AddOrTouchCaptureFile(file_path, GetCaptureTime());
   });
 }
 
@@ -14,15 +14,20 @@
 #include <QFontDatabase>
 #include <QFontMetrics>
 #include <QPainter>
+#include <QPointF>
 #include <QRect>
+#include <QSizeF>
+#include <QStaticText>
 #include <QString>
 #include <QStringList>
+#include <QTransform>
 #include <Qt>
 #include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -36,6 +41,16 @@ namespace orbit_gl {
 
 namespace {
 
+// Bounds the memory of the text caches: a cache of a font size is cleared once it holds that many
+// strings, e.g. after scrolling through many different timers.
+constexpr int kMaxCachedTextsPerCache = 1 << 16;
+
+[[nodiscard]] QFont GetFont(uint32_t font_size) {
+  QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
+  font.setPixelSize(static_cast<int>(font_size));
+  return font;
+}
+
 // Qt offers a QFontMetrics::horizontalAdvance to determine the width of a rendered string. This
 // method is fairly slow. For rendering the text in the timers we therefore use a different method:
 // We compute a lookup table storing the rendered width of all the characters and sum over all the
@@ -92,30 +107,42 @@ namespace {
 void QtTextRenderer::DrawRenderGroup(QPainter* painter, BatchRenderGroupStateManager& manager,
                                      const BatchRenderGroupId& group) {
   ORBIT_SCOPE_FUNCTION;
-  QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
   auto text_for_layer = stored_text_.find(group);
   if (text_for_layer == stored_text_.end()) {
     return;
   }
+
+  auto stencil = manager.GetGroupState(group.name).stencil;
+  if (stencil.enabled) {
+    Vec2i stencil_screen_pos = viewport_->WorldToScreen(Vec2(stencil.pos[0], stencil.pos[1]));
+    Vec2i stencil_screen_size = viewport_->WorldToScreen(Vec2(stencil.size[0], stencil.size[1]));
+    painter->setClipRect(QRect(stencil_screen_pos[0], stencil_screen_pos[1],
+                               stencil_screen_size[0], stencil_screen_size[1]));
+    painter->setClipping(true);
+  } else {
+    painter->setClipping(false);
+  }
+
+  // Changing the font or the pen flushes the batched glyphs, so this only happens when they differ
+  // from the previous text.
+  std::optional<uint32_t> current_font_size;
+  std::optional<Color> current_color;
   for (const auto& text_entry : text_for_layer->second) {
-    font.setPixelSize(text_entry.formatting.font_size);
-    painter->setFont(font);
-    painter->setPen(QColor(text_entry.formatting.color[0], text_entry.formatting.color[1],
-                           text_entry.formatting.color[2], text_entry.formatting.color[3]));
-
-    auto stencil = manager.GetGroupState(group.name).stencil;
-    if (stencil.enabled) {
-      Vec2i stencil_screen_pos = viewport_->WorldToScreen(Vec2(stencil.pos[0], stencil.pos[1]));
-      Vec2i stencil_screen_size = viewport_->WorldToScreen(Vec2(stencil.size[0], stencil.size[1]));
-      painter->setClipRect(QRect(stencil_screen_pos[0], stencil_screen_pos[1],
-                                 stencil_screen_size[0], stencil_screen_size[1]));
-      painter->setClipping(true);
-    } else {
-      painter->setClipping(false);
+    if (current_font_size != text_entry.formatting.font_size) {
+      current_font_size = text_entry.formatting.font_size;
+      painter->setFont(GetFont(text_entry.formatting.font_size));
+    }
+    if (current_color != text_entry.formatting.color) {
+      current_color = text_entry.formatting.color;
+      painter->setPen(QColor(text_entry.formatting.color[0], text_entry.formatting.color[1],
+                             text_entry.formatting.color[2], text_entry.formatting.color[3]));
     }
 
-    painter->drawText(text_entry.x, text_entry.y, text_entry.w, text_entry.h, Qt::AlignCenter,
-                      text_entry.text);
+    // Centers the text in its box, as Qt::AlignCenter does.
+    const QSizeF text_size = text_entry.text.size();
+    painter->drawStaticText(QPointF(text_entry.x + (text_entry.w - text_size.width()) / 2,
+                                    text_entry.y + (text_entry.h - text_size.height()) / 2),
+                            text_entry.text);
   }
 }
 
@@ -154,21 +181,19 @@ void QtTextRenderer::AddText(const char* text, float x, float y, float z, TextFo
   current_render_group_.layer = transformed.z;
 
   const int max_width = static_cast<int>(viewport_->WorldToScreen({formatting.max_size, 0})[0]);
-  QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
-  font.setPixelSize(formatting.font_size);
-  QFontMetrics metrics(font);
   float y_offset = GetYOffsetFromAlignment(formatting.valign, height_entire_text);
   const float single_line_height = GetSingleLineStringHeight(formatting.font_size);
   QStringList lines = text_as_qstring.split("\n");
   float max_line_width = 0.f;
   for (const auto& line : lines) {
-    QString elided_line =
-        formatting.max_size == -1.f ? line : metrics.elidedText(line, Qt::ElideRight, max_width);
+    const QString& elided_line = formatting.max_size == -1.f
+                                     ? line
+                                     : GetElidedText(line, formatting.font_size, max_width);
     const float width = GetStringWidth(elided_line, formatting.font_size);
     max_line_width = std::max(max_line_width, width);
     const float x_offset = GetXOffsetFromAlignment(formatting.halign, width);
     stored_text_[current_render_group_].emplace_back(
-        elided_line, std::lround(transformed.xy[0] + x_offset),
+        GetStaticText(elided_line, formatting.font_size), std::lround(transformed.xy[0] + x_offset),
         std::lround(transformed.xy[1] + y_offset), std::lround(width),
         std::lround(single_line_height), formatting);
     y_offset += single_line_height;
@@ -241,12 +266,43 @@ float QtTextRenderer::GetStringHeight(const char* text, uint32_t font_size) {
   return static_cast<float>(number_of_lines) * GetSingleLineStringHeight(font_size);
 }
 
+const QFontMetrics& QtTextRenderer::GetFontMetrics(uint32_t font_size) {
+  auto it = font_metrics_cache_.find(font_size);
+  if (it == font_metrics_cache_.end()) {
+    it = font_metrics_cache_.emplace(font_size, QFontMetrics(GetFont(font_size))).first;
+  }
+  return it->second;
+}
+
+const QStaticText& QtTextRenderer::GetStaticText(const QString& text, uint32_t font_size) {
+  QHash<QString, QStaticText>& cache = static_text_cache_[font_size];
+  auto it = cache.find(text);
+  if (it != cache.end()) return it.value();
+
+  if (cache.size() >= kMaxCachedTextsPerCache) cache.clear();
+  QStaticText static_text(text);
+  static_text.setTextFormat(Qt::PlainText);
+  // Lays the text out now, which also makes QStaticText::size available for the alignment.
+  static_text.prepare(QTransform(), GetFont(font_size));
+  return cache.insert(text, static_text).value();
+}
+
+const QString& QtTextRenderer::GetElidedText(const QString& text, uint32_t font_size,
+                                             int max_width) {
+  QHash<QString, QString>& cache = elided_text_cache_[std::make_pair(font_size, max_width)];
+  auto it = cache.find(text);
+  if (it != cache.end()) return it.value();
+
+  if (cache.size() >= kMaxCachedTextsPerCache) cache.clear();
+  return cache
+      .insert(text, GetFontMetrics(font_size).elidedText(text, Qt::ElideRight, max_width))
+      .value();
+}
+
 float QtTextRenderer::GetStringWidth(const QString& text, uint32_t font_size) {
   QStringList lines = text.split("\n");
   float max_width = 0.f;
-  QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
-  font.setPixelSize(static_cast<int>(font_size));
-  QFontMetrics metrics(font);
+  const QFontMetrics& metrics = GetFontMetrics(font_size);
   for (const QString& line : lines) {
     max_width =
         std::max(max_width, viewport_->ScreenToWorld(Vec2i(metrics.horizontalAdvance(line), 0))[0]);
@@ -271,10 +327,7 @@ float QtTextRenderer::GetSingleLineStringHeight(uint32_t font_size) {
   int metrics_height = 0;
   auto it = single_line_height_cache_.find(font_size);
   if (it == single_line_height_cache_.end()) {
-    QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
-    font.setPixelSize(static_cast<int>(font_size));
-    QFontMetrics metrics(font);
-    int height = metrics.height();
+    int height = GetFontMetrics(font_size).height();
     metrics_height = single_line_height_cache_[font_size] = height;
   } else {
     metrics_height = it->second;
@@ -286,9 +339,7 @@ const QtTextRenderer::CharacterWidthLookup& QtTextRenderer::GetCharacterWidthLoo
     uint32_t font_size) {
   auto it = character_width_lookup_cache_.find(font_size);
   if (it == character_width_lookup_cache_.end()) {
-    QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
-    font.setPixelSize(static_cast<int>(font_size));
-    QFontMetrics metrics(font);
+    const QFontMetrics& metrics = GetFontMetrics(font_size);
     CharacterWidthLookup lut;
     for (int i = 0; i < 256; i++) {
       lut[i] = metrics.horizontalAdvance(QChar(i));
@@ -345,8 +396,9 @@ float QtTextRenderer::AddFittingSingleLineText(const QString& text, float x, flo
   current_render_group_.layer = transformed.z;
 
   stored_text_[current_render_group_].emplace_back(
-      text, std::lround(transformed.xy[0] + x_offset), std::lround(transformed.xy[1] + y_offset),
-      std::lround(width), std::lround(single_line_height), formatting);
+      GetStaticText(text, formatting.font_size), std::lround(transformed.xy[0] + x_offset),
+      std::lround(transformed.xy[1] + y_offset), std::lround(width),
+      std::lround(single_line_height), formatting);
   return width;
 }
 
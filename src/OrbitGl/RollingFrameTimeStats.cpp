@@ -0,0 +1,51 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitGl/RollingFrameTimeStats.h"
+
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_gl {
+
+RollingFrameTimeStats::RollingFrameTimeStats(uint64_t window_size) : window_size_(window_size) {
+  ORBIT_CHECK(window_size_ > 0);
+}
+
+void RollingFrameTimeStats::AddFrameTime(uint64_t frame_time_ns) {
+  if (current_window_.histogram.count() == window_size_) {
+    previous_window_ = std::move(current_window_);
+    current_window_ = Window{};
+  }
+
+  const uint64_t previous_frame_count =
+      previous_window_.histogram.count() + current_window_.histogram.count();
+  const uint64_t previous_total_ns = previous_window_.total_ns + current_window_.total_ns;
+  // Same as frame_time_ns > kHitchFactor * average, without the division.
+  if (previous_frame_count > 0 &&
+      frame_time_ns * previous_frame_count > kHitchFactor * previous_total_ns) {
+    ++current_window_.hitch_count;
+  }
+
+  current_window_.histogram.Add(frame_time_ns);
+  current_window_.total_ns += frame_time_ns;
+}
+
+RollingFrameTimeStats::Summary RollingFrameTimeStats::ComputeSummary() const {
+  orbit_statistics::LogLinearHistogram histogram = previous_window_.histogram;
+  histogram.Merge(current_window_.histogram);
+
+  Summary summary;
+  summary.frame_count = histogram.count();
+  if (summary.frame_count == 0) return summary;
+  summary.average_ns = (previous_window_.total_ns + current_window_.total_ns) / summary.frame_count;
+  summary.median_ns = histogram.ComputeQuantile(0.5);
+  summary.p99_ns = histogram.ComputeQuantile(0.99);
+  summary.max_ns = histogram.ComputeQuantile(1.0);
+  summary.hitch_count = previous_window_.hitch_count + current_window_.hitch_count;
+  return summary;
+}
+
+}  // namespace orbit_gl
@@ -0,0 +1,73 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "OrbitGl/RollingFrameTimeStats.h"
+
+namespace orbit_gl {
+
+TEST(RollingFrameTimeStats, EmptyStatsAreZero) {
+  RollingFrameTimeStats stats(4);
+  RollingFrameTimeStats::Summary summary = stats.ComputeSummary();
+  EXPECT_EQ(summary.frame_count, 0);
+  EXPECT_EQ(summary.average_ns, 0);
+  EXPECT_EQ(summary.max_ns, 0);
+  EXPECT_EQ(summary.hitch_count, 0);
+}
+
+TEST(RollingFrameTimeStats, ComputesStatisticsOfTheFrames) {
+  RollingFrameTimeStats stats(4);
+  stats.AddFrameTime(10);
+  stats.AddFrameTime(20);
+  stats.AddFrameTime(30);
+
+  RollingFrameTimeStats::Summary summary = stats.ComputeSummary();
+  EXPECT_EQ(summary.frame_count, 3);
+  EXPECT_EQ(summary.average_ns, 20);
+  EXPECT_EQ(summary.median_ns, 20);
+  EXPECT_EQ(summary.p99_ns, 30);
+  EXPECT_EQ(summary.max_ns, 30);
+  EXPECT_EQ(summary.hitch_count, 0);
+}
+
+TEST(RollingFrameTimeStats, CountsFramesMuchLongerThanTheAverageAsHitches) {
+  RollingFrameTimeStats stats(8);
+  for (int i = 0; i < 4; ++i) stats.AddFrameTime(16);
+  // Twice the average is not a hitch yet.
+  stats.AddFrameTime(32);
+  stats.AddFrameTime(100);
+
+  EXPECT_EQ(stats.ComputeSummary().hitch_count, 1);
+}
+
+TEST(RollingFrameTimeStats, ForgetsFramesOlderThanTheWindows) {
+  RollingFrameTimeStats stats(2);
+  stats.AddFrameTime(1'000);
+  stats.AddFrameTime(1'000);
+  for (int i = 0; i < 4; ++i) stats.AddFrameTime(10);
+
+  RollingFrameTimeStats::Summary summary = stats.ComputeSummary();
+  EXPECT_EQ(summary.frame_count, 4);
+  EXPECT_EQ(summary.average_ns, 10);
+  EXPECT_EQ(summary.max_ns, 10);
+
+  // The windows cover between one and two window sizes of frames.
+  stats.AddFrameTime(10);
+  EXPECT_EQ(stats.ComputeSummary().frame_count, 3);
+}
+
+TEST(RollingFrameTimeStats, ForgetsTheHitchesOfOldFrames) {
+  RollingFrameTimeStats stats(2);
+  stats.AddFrameTime(10);
+  stats.AddFrameTime(100);
+  EXPECT_EQ(stats.ComputeSummary().hitch_count, 1);
+
+  for (int i = 0; i < 4; ++i) stats.AddFrameTime(10);
+  EXPECT_EQ(stats.ComputeSummary().hitch_count, 0);
+}
+
+}  // namespace orbit_gl
@@ -10,10 +10,12 @@
 
 #include <algorithm>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include "ApiInterface/Orbit.h"
 #include "ClientData/CaptureData.h"
+#include "ClientData/SchedulingOccupancyPyramid.h"
 #include "ClientData/TimerChain.h"
 #include "ClientProtos/capture_data.pb.h"
 #include "OrbitBase/Logging.h"
@@ -48,7 +50,7 @@ SchedulerTrack::SchedulerTrack(CaptureViewElement* parent,
 }
 
 void SchedulerTrack::OnTimer(const orbit_client_protos::TimerInfo& timer_info) {
-  TimerTrack::OnTimer(timer_info);
+  occupancy_pyramid_.AddSlice(timer_data_->AddTimer(timer_info, timer_info.depth()));
   if (num_cores_ <= static_cast<uint32_t>(timer_info.processor())) {
     num_cores_ = timer_info.processor() + 1;
   }
@@ -60,6 +62,20 @@ float SchedulerTrack::GetHeight() const {
          (num_gaps * layout_->GetSpaceBetweenCores()) + layout_->GetTrackContentBottomMargin();
 }
 
+uint32_t SchedulerTrack::GetResolutionInPixels() const {
+  return viewport_->WorldToScreen({GetWidth(), 0})[0];
+}
+
+void SchedulerTrack::DoPrepareUpdatePrimitives(uint64_t min_tick, uint64_t max_tick) {
+  if (UseOccupancy(min_tick, max_tick)) return;
+  UpdateTimersAtAllDepthsDiscretized(GetResolutionInPixels(), min_tick, max_tick);
+}
+
+bool SchedulerTrack::UseOccupancy(uint64_t min_tick, uint64_t max_tick) const {
+  return orbit_client_data::SchedulingOccupancyPyramid::CanSummarizePixels(
+      min_tick, max_tick, GetResolutionInPixels());
+}
+
 void SchedulerTrack::DoUpdatePrimitives(PrimitiveAssembler& primitive_assembler,
                                         TextRenderer& /*text_renderer*/, uint64_t min_tick,
                                         uint64_t max_tick, PickingMode /*picking_mode*/) {
@@ -77,13 +93,17 @@ void SchedulerTrack::DoUpdatePrimitives(PrimitiveAssembler& primitive_assembler,
                   IsCollapsed(), app_->selected_timer(), app_->GetScopeIdToHighlight(),
                   app_->GetGroupIdToHighlight(), app_->GetHistogramSelectionRange());
 
-  const uint32_t resolution_in_pixels = viewport_->WorldToScreen({GetWidth(), 0})[0];
-  const float box_height = GetDefaultBoxHeight();
+  if (UseOccupancy(min_tick, max_tick)) {
+    DrawOccupancy(primitive_assembler, draw_data, min_tick, max_tick);
+    return;
+  }
 
-  for (uint32_t depth = 0; depth < GetDepth(); depth++) {
+  const float box_height = GetDefaultBoxHeight();
+  const std::vector<std::vector<const TimerInfo*>>& timers_by_depth =
+      GetTimersAtAllDepthsDiscretized(GetResolutionInPixels(), min_tick, max_tick);
+  for (uint32_t depth = 0; depth < timers_by_depth.size(); depth++) {
     const float world_timer_y = GetYFromDepth(depth);
-    for (const TimerInfo* timer_info : timer_data_->GetTimersAtDepthDiscretized(
-             depth, resolution_in_pixels, min_tick, max_tick)) {
+    for (const TimerInfo* timer_info : timers_by_depth[depth]) {
       ++visible_timer_count_;
       const bool is_selected = timer_info == draw_data.selected_timer;
 
@@ -100,6 +120,58 @@ void SchedulerTrack::DoUpdatePrimitives(PrimitiveAssembler& primitive_assembler,
   }
 }
 
+void SchedulerTrack::DrawOccupancy(PrimitiveAssembler& primitive_assembler,
+                                   const internal::DrawData& draw_data, uint64_t min_tick,
+                                   uint64_t max_tick) {
+  using PixelOccupancy = orbit_client_data::SchedulingOccupancyPyramid::PixelOccupancy;
+  const float box_height = GetDefaultBoxHeight();
+  const uint32_t resolution = GetResolutionInPixels();
+
+  // Consecutive pixels with the same dominant thread and a similar occupancy are drawn as one box,
+  // colored like their dominant slice and more transparent the less busy the core is.
+  auto to_alpha = [](float busy_fraction) {
+    constexpr int kAlphaLevels = 8;
+    const int level = std::max(1, static_cast<int>(busy_fraction * kAlphaLevels + 0.5f));
+    return static_cast<unsigned char>(std::min(255, level * 256 / kAlphaLevels));
+  };
+  for (uint32_t core = 0; core < num_cores_; ++core) {
+    std::optional<std::vector<PixelOccupancy>> pixels =
+        occupancy_pyramid_.GetPixelOccupancies(core, min_tick, max_tick, resolution);
+    if (!pixels.has_value()) continue;
+    const float world_timer_y = GetYFromDepth(core);
+
+    auto draw_box = [&](const PixelOccupancy& first, const PixelOccupancy& last) {
+      ++visible_timer_count_;
+      const TimerInfo& dominant_slice = *first.dominant_slice;
+      const bool is_selected = &dominant_slice == draw_data.selected_timer;
+      Color color = GetTimerColor(dominant_slice, is_selected, /*is_highlighted=*/false, draw_data);
+      color[3] = std::min(color[3], to_alpha(first.busy_fraction));
+
+      auto [box_start_x, box_width] =
+          timeline_info_->GetBoxPosXAndWidthFromTicks(first.start_ns, last.end_ns);
+      const Vec2 pos = {box_start_x, world_timer_y};
+      const Vec2 size = {box_width, box_height};
+      primitive_assembler.AddShadedBox(pos, size, draw_data.z, color,
+                                       CreatePickingUserData(primitive_assembler, dominant_slice));
+    };
+
+    size_t first_index = 0;
+    for (size_t i = 1; i <= pixels->size(); ++i) {
+      if (i < pixels->size()) {
+        const PixelOccupancy& first = (*pixels)[first_index];
+        const PixelOccupancy& current = (*pixels)[i];
+        if (current.start_ns == (*pixels)[i - 1].end_ns &&
+            current.dominant_slice->thread_id() == first.dominant_slice->thread_id() &&
+            to_alpha(current.busy_fraction) == to_alpha(first.busy_fraction)) {
+          continue;
+        }
+      }
+      draw_box((*pixels)[first_index], (*pixels)[i - 1]);
+      first_index = i;
+    }
+  }
+}
+
 bool SchedulerTrack::IsTimerActive(const TimerInfo& timer_info) const {
   bool is_same_tid_as_selected = timer_info.thread_id() == app_->selected_thread_id();
 
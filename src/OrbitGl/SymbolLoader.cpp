@@ -7,6 +7,7 @@
 #include <absl/flags/flag.h>
 #include <absl/hash/hash.h>
 #include <absl/meta/type_traits.h>
+#include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 
 #include <algorithm>
@@ -19,6 +20,7 @@
 #include "ClientFlags/ClientFlags.h"
 #include "ClientSymbols/QSettingsBasedStorageManager.h"
 #include "Introspection/Introspection.h"
+#include "ClientServices/RemoteDebugInfoFile.h"
 #include "ObjectUtils/ElfFile.h"
 #include "ObjectUtils/SymbolsFile.h"
 #include "OrbitBase/Executor.h"
@@ -26,8 +28,10 @@
 #include "OrbitBase/ImmediateExecutor.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/NotFoundOr.h"
+#include "OrbitBase/Promise.h"
 #include "OrbitBase/StopToken.h"
 #include "SymbolProvider/SymbolLoadingOutcome.h"
+#include "Symbols/CompressedFile.h"
 #include "Symbols/SymbolUtils.h"
 
 using orbit_base::CanceledOr;
@@ -36,6 +40,7 @@ using orbit_base::NotFoundOr;
 using orbit_base::StopToken;
 
 using orbit_client_data::ModuleData;
+using orbit_client_services::RemoteDebugInfoFile;
 
 using orbit_data_views::SymbolLoadingState;
 
@@ -89,7 +94,7 @@ void SymbolLoader::InitRemoteSymbolProviders() {
 }
 
 Future<ErrorMessageOr<CanceledOr<void>>> SymbolLoader::RetrieveModuleAndLoadSymbols(
-    const orbit_client_data::ModuleData* module_data) {
+    const orbit_client_data::ModuleData* module_data, uint64_t priority) {
   ORBIT_SCOPE_FUNCTION;
   ORBIT_CHECK(main_thread_id_ == std::this_thread::get_id());
   ORBIT_CHECK(module_data != nullptr);
@@ -108,16 +113,82 @@ Future<ErrorMessageOr<CanceledOr<void>>> SymbolLoader::RetrieveModuleAndLoadSymb
 
   const auto it = symbols_currently_loading_.find(module_identifier.value());
   if (it != symbols_currently_loading_.end()) {
+    // Requesting a module that is still waiting again can move it ahead of the others.
+    const auto pending_it = pending_modules_.find(module_identifier.value());
+    if (pending_it != pending_modules_.end()) {
+      pending_it->second.priority = std::max(pending_it->second.priority, priority);
+    }
     return it->second;
   }
 
+  orbit_base::Promise<ErrorMessageOr<CanceledOr<void>>> promise;
+  Future<ErrorMessageOr<CanceledOr<void>>> future = promise.GetFuture();
+  pending_modules_.emplace(
+      module_identifier.value(),
+      PendingModule{.module_path_and_build_id = std::move(module_path_and_build_id),
+                    .priority = priority,
+                    .sequence_number = next_pending_module_sequence_number_++,
+                    .promise = std::move(promise)});
+
+  future.Then(main_thread_executor_, [this, module_id = module_identifier.value()](
+                                         const ErrorMessageOr<CanceledOr<void>>& result) mutable {
+    if (result.has_error()) {
+      modules_with_symbol_loading_error_.emplace(module_id);
+    }
+    symbols_currently_loading_.erase(module_id);
+    app_interface_->OnModuleListUpdated();
+  });
+
+  symbols_currently_loading_.emplace(module_identifier.value(), future);
+  StartPendingModules();
+  app_interface_->OnModuleListUpdated();
+
+  return future;
+}
+
+void SymbolLoader::StartPendingModules() {
+  ORBIT_CHECK(main_thread_id_ == std::this_thread::get_id());
+  while (num_modules_loading_ < kMaxModulesLoadingConcurrently && !pending_modules_.empty()) {
+    // A linear search is fine, as there are at most a few thousand modules.
+    auto next_it = std::min_element(
+        pending_modules_.begin(), pending_modules_.end(), [](const auto& lhs, const auto& rhs) {
+          if (lhs.second.priority != rhs.second.priority) {
+            return lhs.second.priority > rhs.second.priority;
+          }
+          return lhs.second.sequence_number < rhs.second.sequence_number;
+        });
+    PendingModule pending_module = std::move(next_it->second);
+    pending_modules_.erase(next_it);
+
+    const ModuleData* module_data =
+        app_interface_->GetModuleByModulePathAndBuildId(pending_module.module_path_and_build_id);
+    if (module_data != nullptr && module_data->AreDebugSymbolsLoaded()) {
+      pending_module.promise.SetResult(CanceledOr<void>{outcome::success()});
+      continue;
+    }
+
+    ++num_modules_loading_;
+    RetrieveModuleAndLoadSymbolsOrFallbackSymbols(pending_module.module_path_and_build_id)
+        .Then(main_thread_executor_,
+              [this, promise = std::move(pending_module.promise)](
+                  const ErrorMessageOr<CanceledOr<void>>& result) mutable {
+                --num_modules_loading_;
+                promise.SetResult(result);
+                StartPendingModules();
+              });
+  }
+}
+
+Future<ErrorMessageOr<CanceledOr<void>>>
+SymbolLoader::RetrieveModuleAndLoadSymbolsOrFallbackSymbols(
+    const orbit_client_data::ModulePathAndBuildId& module_path_and_build_id) {
   Future<ErrorMessageOr<CanceledOr<void>>> retrieve_module_symbols_and_load_symbols_future =
       RetrieveModuleSymbolsAndLoadSymbols(module_path_and_build_id);
 
   Future<ErrorMessageOr<CanceledOr<void>>> retrieve_module_itself_and_load_fallback_symbols_future =
       retrieve_module_symbols_and_load_symbols_future.Then(
           main_thread_executor_,
-          [this, module_path_and_build_id = std::move(module_path_and_build_id)](
+          [this, module_path_and_build_id](
               const ErrorMessageOr<CanceledOr<void>>&
                   retrieve_module_symbols_and_load_symbols_result)
               -> Future<ErrorMessageOr<CanceledOr<void>>> {
@@ -158,20 +229,6 @@ Future<ErrorMessageOr<CanceledOr<void>>> SymbolLoader::RetrieveModuleAndLoadSymb
                       });
           });
 
-  retrieve_module_itself_and_load_fallback_symbols_future.Then(
-      main_thread_executor_, [this, module_id = module_identifier.value()](
-                                 const ErrorMessageOr<CanceledOr<void>>& result) mutable {
-        if (result.has_error()) {
-          modules_with_symbol_loading_error_.emplace(module_id);
-        }
-        symbols_currently_loading_.erase(module_id);
-        app_interface_->OnModuleListUpdated();
-      });
-
-  symbols_currently_loading_.emplace(module_identifier.value(),
-                                     retrieve_module_itself_and_load_fallback_symbols_future);
-  app_interface_->OnModuleListUpdated();
-
   return retrieve_module_itself_and_load_fallback_symbols_future;
 }
 
@@ -459,9 +516,9 @@ Future<ErrorMessageOr<CanceledOr<std::filesystem::path>>> SymbolLoader::Retrieve
   ORBIT_SCOPE_FUNCTION;
   ORBIT_CHECK(std::this_thread::get_id() == main_thread_id_);
 
-  Future<ErrorMessageOr<NotFoundOr<std::filesystem::path>>> check_file_on_remote =
+  Future<ErrorMessageOr<NotFoundOr<RemoteDebugInfoFile>>> check_file_on_remote =
       thread_pool_->Schedule([this, module_file_path = std::string{module_file_path}]()
-                                 -> ErrorMessageOr<NotFoundOr<std::filesystem::path>> {
+                                 -> ErrorMessageOr<NotFoundOr<RemoteDebugInfoFile>> {
         std::vector<std::string> additional_instance_folder;
         if (!absl::GetFlag(FLAGS_instance_symbols_folder).empty()) {
           additional_instance_folder.emplace_back(absl::GetFlag(FLAGS_instance_symbols_folder));
@@ -472,46 +529,69 @@ Future<ErrorMessageOr<CanceledOr<std::filesystem::path>>> SymbolLoader::Retrieve
 
   auto download_file = [this, module_file_path = std::string{module_file_path},
                         stop_token = std::move(stop_token)](
-                           const NotFoundOr<std::filesystem::path>& remote_search_outcome) mutable
+                           const NotFoundOr<RemoteDebugInfoFile>& remote_search_outcome) mutable
       -> Future<ErrorMessageOr<CanceledOr<std::filesystem::path>>> {
     // TODO(b/231455031): For now, we treat the ErrorMessage and the NotFound the same way.
     if (orbit_base::IsNotFound(remote_search_outcome)) {
       return {ErrorMessage{orbit_base::GetNotFoundMessage(remote_search_outcome)}};
     }
-    const std::filesystem::path& remote_debug_file_path =
+    const RemoteDebugInfoFile& remote_debug_info_file =
         orbit_base::GetFound(remote_search_outcome);
     ORBIT_LOG("Found symbols file on the remote: \"%s\" - loading it using scp...",
-              remote_debug_file_path.string());
+              remote_debug_info_file.path.string());
 
     const std::filesystem::path local_debug_file_path =
         symbol_helper_.GenerateCachedFilePath(module_file_path);
 
+    // If OrbitService offers a compressed copy, that one is copied and decompressed into the cache.
+    const bool is_compressed = remote_debug_info_file.compressed_path.has_value();
+    const std::filesystem::path remote_copy_path =
+        is_compressed ? remote_debug_info_file.compressed_path.value()
+                      : remote_debug_info_file.path;
+    const std::filesystem::path local_copy_path =
+        is_compressed ? std::filesystem::path{absl::StrCat(local_debug_file_path.string(), ".gz")}
+                      : local_debug_file_path;
+
     const std::chrono::time_point<std::chrono::steady_clock> copy_begin =
         std::chrono::steady_clock::now();
-    ORBIT_LOG("Copying \"%s\" started", remote_debug_file_path.string());
+    ORBIT_LOG("Copying \"%s\" started", remote_copy_path.string());
     Future<ErrorMessageOr<CanceledOr<void>>> copy_result = app_interface_->DownloadFileFromInstance(
-        remote_debug_file_path, local_debug_file_path, std::move(stop_token));
+        remote_copy_path, local_copy_path, std::move(stop_token));
 
-    orbit_base::ImmediateExecutor immediate_executor{};
-    return copy_result.Then(&immediate_executor,
-                            [remote_debug_file_path, local_debug_file_path,
-                             copy_begin](ErrorMessageOr<CanceledOr<void>> sftp_result)
-                                -> ErrorMessageOr<CanceledOr<std::filesystem::path>> {
-                              if (sftp_result.has_error()) {
-                                return ErrorMessage{absl::StrFormat(
-                                    "Could not copy debug info file from the remote: %s",
-                                    sftp_result.error().message())};
-                              }
-                              if (orbit_base::IsCanceled(sftp_result.value())) {
-                                return orbit_base::Canceled{};
-                              }
-                              const auto duration =
-                                  std::chrono::duration_cast<std::chrono::milliseconds>(
-                                      std::chrono::steady_clock::now() - copy_begin);
-                              ORBIT_LOG("Copying \"%s\" took %.3f ms",
-                                        remote_debug_file_path.string(), duration.count());
-                              return local_debug_file_path;
-                            });
+    return copy_result.Then(
+        thread_pool_,
+        [remote_copy_path, local_copy_path, local_debug_file_path, is_compressed,
+         copy_begin](ErrorMessageOr<CanceledOr<void>> sftp_result)
+            -> ErrorMessageOr<CanceledOr<std::filesystem::path>> {
+          if (sftp_result.has_error()) {
+            const std::string error_message = sftp_result.error().message();
+            return ErrorMessage{absl::StrFormat(
+                "Could not copy debug info file from the remote: %s", error_message)};
+          }
+          if (orbit_base::IsCanceled(sftp_result.value())) {
+            return orbit_base::Canceled{};
+          }
+          const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - copy_begin);
+          ORBIT_LOG("Copying \"%s\" took %.3f ms", remote_copy_path.string(), duration.count());
+
+          if (is_compressed) {
+            ErrorMessageOr<void> decompress_result =
+                orbit_symbols::DecompressFile(local_copy_path, local_debug_file_path);
+            ErrorMessageOr<bool> remove_result = orbit_base::RemoveFile(local_copy_path);
+            if (remove_result.has_error()) {
+              ORBIT_ERROR("%s", remove_result.error().message());
+            }
+            if (decompress_result.has_error()) {
+              // Don't leave a partially decompressed file in the cache.
+              (void)orbit_base::RemoveFile(local_debug_file_path);
+              return ErrorMessage{
+                  absl::StrFormat("Could not decompress debug info file copied from the remote: %s",
+                                  decompress_result.error().message())};
+            }
+          }
+          return local_debug_file_path;
+        });
   };
 
   return check_file_on_remote.ThenIfSuccess(main_thread_executor_, std::move(download_file));
@@ -693,7 +773,8 @@ Future<ErrorMessageOr<void>> SymbolLoader::LoadSymbols(
             app_interface_->GetModuleByModulePathAndBuildId(module_path_and_build_id);
         orbit_object_utils::ObjectFileInfo object_file_info{module_data->load_bias()};
         ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> symbols_or_error =
-            orbit_symbols::SymbolHelper::LoadSymbolsFromFile(symbols_path, object_file_info);
+            symbol_helper_.LoadSymbolsUsingCache(symbols_path, module_data->build_id(),
+                                                 object_file_info);
         if (symbols_or_error.has_value()) return symbols_or_error;
         return {ErrorMessage{absl::StrFormat("Could not load debug symbols from \"%s\": %s",
                                              symbols_path.string(),
@@ -791,6 +872,15 @@ Future<ErrorMessageOr<std::filesystem::path>> SymbolLoader::RetrieveModuleWithDe
 
 void SymbolLoader::RequestSymbolDownloadStop(std::string_view module_path) {
   ORBIT_CHECK(main_thread_id_ == std::this_thread::get_id());
+  // Modules that are still waiting are canceled right away.
+  for (auto it = pending_modules_.begin(); it != pending_modules_.end();) {
+    if (it->second.module_path_and_build_id.module_path == module_path) {
+      it->second.promise.SetResult(CanceledOr<void>{orbit_base::Canceled{}});
+      pending_modules_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
   if (symbol_files_currently_downloading_.contains(module_path)) {
     symbol_files_currently_downloading_.at(module_path).stop_source.RequestStop();
   }
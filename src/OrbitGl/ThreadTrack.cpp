@@ -266,6 +266,11 @@ bool ThreadTrack::IsEmpty() const {
          thread_track_data_provider_->IsEmpty(thread_id_);
 }
 
+Vec2 ThreadTrack::GetThreadStateBarPos() const {
+  return {GetPos()[0] + layout_->GetTrackHeaderWidth(),
+          GetPos()[1] + layout_->GetTrackContentTopMargin()};
+}
+
 void ThreadTrack::UpdatePositionOfSubtracks() {
   const float thread_state_track_height = layout_->GetThreadStateTrackHeight();
   const float event_track_height = layout_->GetEventTrackHeightFromTid(GetThreadId());
@@ -376,6 +381,22 @@ void ThreadTrack::OnTimer(const TimerInfo& timer_info) {
   thread_track_data_provider_->AddTimer(timer_info);
 }
 
+uint32_t ThreadTrack::GetResolutionInPixels() const {
+  return viewport_->WorldToScreen({GetWidth() - header_->GetWidth(), 0})[0];
+}
+
+std::vector<const TimerInfo*> ThreadTrack::GetTimersAtDepthDiscretized(uint32_t depth,
+                                                                       uint32_t resolution,
+                                                                       uint64_t min_tick,
+                                                                       uint64_t max_tick) const {
+  return thread_track_data_provider_->GetTimersAtDepthDiscretized(thread_id_, depth, resolution,
+                                                                  min_tick, max_tick);
+}
+
+void ThreadTrack::DoPrepareUpdatePrimitives(uint64_t min_tick, uint64_t max_tick) {
+  UpdateTimersAtAllDepthsDiscretized(GetResolutionInPixels(), min_tick, max_tick);
+}
+
 // We minimize overdraw when drawing lines for small events by discarding events that would just
 // draw over an already drawn pixel line. When zoomed in enough that all events are drawn as boxes,
 // this has no effect. When zoomed  out, many events will be discarded quickly.
@@ -395,12 +416,12 @@ void ThreadTrack::DoUpdatePrimitives(PrimitiveAssembler& primitive_assembler,
                   IsCollapsed(), app_->selected_timer(), app_->GetScopeIdToHighlight(),
                   app_->GetGroupIdToHighlight(), app_->GetHistogramSelectionRange());
 
-  uint64_t resolution_in_pixels = draw_data.viewport->WorldToScreen({draw_data.track_width, 0})[0];
-  for (uint32_t depth = 0; depth < GetDepth(); depth++) {
+  const std::vector<std::vector<const TimerInfo*>>& timers_by_depth =
+      GetTimersAtAllDepthsDiscretized(GetResolutionInPixels(), min_tick, max_tick);
+  for (uint32_t depth = 0; depth < timers_by_depth.size(); depth++) {
     float world_timer_y = GetYFromDepth(depth);
 
-    for (const TimerInfo* timer_info : thread_track_data_provider_->GetTimersAtDepthDiscretized(
-             thread_id_, depth, resolution_in_pixels, min_tick, max_tick)) {
+    for (const TimerInfo* timer_info : timers_by_depth[depth]) {
       ++visible_timer_count_;
 
       Color color = GetTimerColor(*timer_info, draw_data);
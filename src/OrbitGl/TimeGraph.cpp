@@ -6,12 +6,14 @@
 
 #include <GteVector.h>
 #include <absl/flags/flag.h>
+#include <absl/strings/str_format.h>
 #include <stddef.h>
 
 #include <algorithm>
 #include <cmath>
 #include <limits>
 #include <string>
+#include <string_view>
 
 #include "ApiInterface/Orbit.h"
 #include "CaptureClient/CaptureEventProcessor.h"
@@ -22,6 +24,7 @@
 #include "GrpcProtos/Constants.h"
 #include "Introspection/Introspection.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
 #include "OrbitBase/Typedef.h"
 #include "OrbitGl/AccessibleTimeGraph.h"
 #include "OrbitGl/AsyncTrack.h"
@@ -327,13 +330,13 @@ void TimeGraph::ProcessTimer(const TimerInfo& timer_info) {
     case TimerInfo::kNone: {
       // TODO (http://b/198135618): Create tracks only before drawing.
       track_manager->GetOrCreateThreadTrack(timer_info.thread_id());
-      thread_track_data_provider_->AddTimer(timer_info);
+      thread_track_data_provider_->AddTimer(timer_info, capture_data_->ProvideScopeId(timer_info));
       break;
     }
     case TimerInfo::kApiScope: {
       // TODO (http://b/198135618): Create tracks only before drawing.
       track_manager->GetOrCreateThreadTrack(timer_info.thread_id());
-      thread_track_data_provider_->AddTimer(timer_info);
+      thread_track_data_provider_->AddTimer(timer_info, capture_data_->ProvideScopeId(timer_info));
       break;
     }
     case TimerInfo::kApiScopeAsync: {
@@ -359,6 +362,65 @@ void TimeGraph::ProcessApiTrackValueEvent(
   track->AddValue(time, track_event.value());
 }
 
+void TimeGraph::ProcessPressureStallEvent(
+    const orbit_grpc_protos::PressureStallEvent& pressure_stall_event) const {
+  if (pressure_stall_event.duration_ns() == 0) return;
+
+  std::string_view resource_name;
+  switch (pressure_stall_event.resource()) {
+    case orbit_grpc_protos::PressureStallEvent::kCpu:
+      resource_name = "CPU";
+      break;
+    case orbit_grpc_protos::PressureStallEvent::kMemory:
+      resource_name = "Memory";
+      break;
+    case orbit_grpc_protos::PressureStallEvent::kIo:
+      resource_name = "IO";
+      break;
+    default:
+      return;
+  }
+  const std::string track_name =
+      absl::StrFormat("%s pressure (%s) [%% stalled]", resource_name,
+                      pressure_stall_event.is_cgroup() ? "cgroup" : "system");
+  VariableTrack* track = GetTrackManager()->GetOrCreateVariableTrack(track_name);
+
+  // The percentage of the time since the previous event in which some tasks were stalled.
+  constexpr double kPercent = 100.0;
+  track->AddValue(pressure_stall_event.timestamp_ns(),
+                  kPercent * static_cast<double>(pressure_stall_event.some_stall_ns()) /
+                      static_cast<double>(pressure_stall_event.duration_ns()));
+}
+
+void TimeGraph::ProcessPerformanceCounterSample(
+    const orbit_grpc_protos::PerformanceCounterSample& performance_counter_sample) const {
+  // Each sample holds the counts of the thread since the previous sample on the same CPU. Without
+  // retired instructions, neither the IPC nor the misses per kilo-instruction are defined.
+  if (performance_counter_sample.cycles() == 0 || performance_counter_sample.instructions() == 0) {
+    return;
+  }
+
+  const uint32_t tid = performance_counter_sample.tid();
+  const uint64_t timestamp_ns = performance_counter_sample.timestamp_ns();
+  const auto instructions = static_cast<double>(performance_counter_sample.instructions());
+  constexpr double kInstructionsPerKiloInstruction = 1000.0;
+
+  GetTrackManager()
+      ->GetOrCreateVariableTrack(absl::StrFormat("IPC [%u]", tid))
+      ->AddValue(timestamp_ns,
+                 instructions / static_cast<double>(performance_counter_sample.cycles()));
+  GetTrackManager()
+      ->GetOrCreateVariableTrack(absl::StrFormat("Cache misses per kilo-instruction [%u]", tid))
+      ->AddValue(timestamp_ns, kInstructionsPerKiloInstruction *
+                                   static_cast<double>(performance_counter_sample.cache_misses()) /
+                                   instructions);
+  GetTrackManager()
+      ->GetOrCreateVariableTrack(absl::StrFormat("Branch misses per kilo-instruction [%u]", tid))
+      ->AddValue(timestamp_ns, kInstructionsPerKiloInstruction *
+                                   static_cast<double>(performance_counter_sample.branch_misses()) /
+                                   instructions);
+}
+
 void TimeGraph::ProcessSystemMemoryInfo(
     const orbit_client_data::SystemMemoryInfo& system_memory_info) {
   SystemMemoryTrack* track = GetTrackManager()->GetSystemMemoryTrack();
@@ -578,43 +640,16 @@ const TimerInfo* TimeGraph::FindNextScopeTimer(ScopeId scope_id, uint64_t curren
 
 const TimerInfo* TimeGraph::FindNextThreadTrackTimer(ScopeId scope_id, uint64_t current_time,
                                                      std::optional<uint32_t> thread_id) const {
-  const TimerInfo* next_timer = nullptr;
-  uint64_t goal_time = std::numeric_limits<uint64_t>::max();
-  std::vector<const TimerChain*> chains = GetAllThreadTrackTimerChains();
-  for (const TimerChain* chain : chains) {
-    ORBIT_CHECK(chain != nullptr);
-    for (const auto& block : *chain) {
-      if (!block.Intersects(current_time, goal_time)) continue;
-      for (uint64_t i = 0; i < block.size(); i++) {
-        const TimerInfo& timer_info = block[i];
-        if (ThreadMatches(thread_id, &timer_info) &&
-            capture_data_->ProvideScopeId(timer_info) == scope_id) {
-          UpdateNextTimerAndGoalTime(&next_timer, goal_time, &timer_info, current_time);
-        }
-      }
-    }
-  }
-  return next_timer;
+  ORBIT_CHECK(thread_track_data_provider_ != nullptr);
+  return thread_track_data_provider_->GetScopeTimerIndex().FindNext(scope_id, current_time,
+                                                                    thread_id);
 }
 
 const TimerInfo* TimeGraph::FindPreviousThreadTrackTimer(ScopeId scope_id, uint64_t current_time,
                                                          std::optional<uint32_t> thread_id) const {
-  const TimerInfo* previous_timer = nullptr;
-  uint64_t goal_time = std::numeric_limits<uint64_t>::lowest();
-  std::vector<const TimerChain*> chains = GetAllThreadTrackTimerChains();
-  for (const TimerChain* chain : chains) {
-    for (const auto& block : *chain) {
-      if (!block.Intersects(goal_time, current_time)) continue;
-      for (uint64_t i = 0; i < block.size(); i++) {
-        const TimerInfo& timer_info = block[i];
-        if (ThreadMatches(thread_id, &timer_info) &&
-            capture_data_->ProvideScopeId(timer_info) == scope_id) {
-          UpdatePreviousTimerAndGoalTime(&previous_timer, &goal_time, &timer_info, current_time);
-        }
-      }
-    }
-  }
-  return previous_timer;
+  ORBIT_CHECK(thread_track_data_provider_ != nullptr);
+  return thread_track_data_provider_->GetScopeTimerIndex().FindPrevious(scope_id, current_time,
+                                                                        thread_id);
 }
 
 std::vector<const TimerChain*> TimeGraph::GetAllThreadTrackTimerChains() const {
@@ -635,17 +670,12 @@ static void UpdateMinMaxTimers(const TimerInfo** min_timer, const TimerInfo** ma
 
 std::pair<const TimerInfo*, const TimerInfo*> TimeGraph::GetMinMaxTimerForThreadTrackScope(
     ScopeId scope_id) const {
+  ORBIT_CHECK(thread_track_data_provider_ != nullptr);
   const TimerInfo* min_timer = nullptr;
   const TimerInfo* max_timer = nullptr;
-  std::vector<const TimerChain*> chains = GetAllThreadTrackTimerChains();
-  for (const TimerChain* chain : chains) {
-    for (const auto& block : *chain) {
-      for (size_t i = 0; i < block.size(); i++) {
-        const TimerInfo& timer_info = block[i];
-        if (capture_data_->ProvideScopeId(timer_info) != scope_id) continue;
-        UpdateMinMaxTimers(&min_timer, &max_timer, &timer_info);
-      }
-    }
+  for (const TimerInfo* timer_info :
+       thread_track_data_provider_->GetScopeTimerIndex().GetTimers(scope_id)) {
+    UpdateMinMaxTimers(&min_timer, &max_timer, timer_info);
   }
   return std::make_pair(min_timer, max_timer);
 }
@@ -683,9 +713,18 @@ void TimeGraph::PrepareBatcherAndUpdatePrimitives(PickingMode picking_mode) {
   uint64_t max_tick = GetTickFromUs(max_time_us_);
 
   // Only update the primitives to draw if the time interval is non-empty.
+  UpdatePrimitivesTimings& timings = last_update_primitives_timings_.emplace();
   if (min_tick < max_tick) {
+    // The capture data is queried on worker threads first, filling the batcher stays on this
+    // thread as it assigns the picking ids in order.
+    const uint64_t query_start_ns = orbit_base::CaptureTimestampNs();
+    CaptureViewElement::PrepareUpdatePrimitives(min_tick, max_tick);
+    const uint64_t batching_start_ns = orbit_base::CaptureTimestampNs();
     CaptureViewElement::UpdatePrimitives(primitive_assembler_, text_renderer_static_, min_tick,
                                          max_tick, picking_mode);
+    timings.query_ms = static_cast<double>(batching_start_ns - query_start_ns) / 1000000.0;
+    timings.batching_ms =
+        static_cast<double>(orbit_base::CaptureTimestampNs() - batching_start_ns) / 1000000.0;
   }
 
   if (absl::GetFlag(FLAGS_enforce_full_redraw)) {
@@ -875,6 +914,7 @@ void TimeGraph::DrawAllElements(PrimitiveAssembler& primitive_assembler,
     current_mouse_time_ns = std::nullopt;
   }
   DrawContext context{current_mouse_time_ns, picking_mode};
+  last_update_primitives_timings_.reset();
   // `Draw` is called in any case - the batcher has already been cleared if this method is called,
   // so we need to re-fill it.
   Draw(primitive_assembler, text_renderer, context);
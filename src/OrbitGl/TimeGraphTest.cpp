@@ -3,7 +3,9 @@
 // found in the LICENSE file.
 
 #include <GteVector.h>
+#include <absl/strings/str_format.h>
 #include <gtest/gtest.h>
+#include <stddef.h>
 
 #include <memory>
 #include <vector>
@@ -16,7 +18,10 @@
 #include "OrbitGl/StaticTimeGraphLayout.h"
 #include "OrbitGl/TimeGraph.h"
 #include "OrbitGl/TimelineUi.h"
+#include "OrbitGl/TrackContainer.h"
+#include "OrbitGl/TrackManager.h"
 #include "OrbitGl/TrackTestData.h"
+#include "OrbitGl/VariableTrack.h"
 #include "OrbitGl/Viewport.h"
 
 namespace orbit_gl {
@@ -158,4 +163,38 @@ TEST_F(UnitTestTimeGraph, MouseWheel) {
   EXPECT_EQ(min_visible_ns, time_graph->GetMinTimeUs());
 }
 
+TEST_F(UnitTestTimeGraph, TrackContainerOnlyReturnsTracksInTheViewport) {
+  constexpr size_t kNumTracks = 100;
+  TrackContainer* track_container = GetTimeGraph()->GetTrackContainer();
+  for (size_t i = 0; i < kNumTracks; ++i) {
+    VariableTrack* track = track_container->GetTrackManager()->GetOrCreateVariableTrack(
+        absl::StrFormat("Variable %u", i));
+    track->AddValue(0, static_cast<double>(i));
+  }
+  SimulatePreRender();
+
+  auto expect_tracks_in_viewport = [this, track_container]() {
+    std::vector<CaptureViewElement*> expected_tracks;
+    for (CaptureViewElement* track : track_container->GetNonHiddenChildren()) {
+      const float top_y = track->GetPos()[1];
+      if (top_y < GetTimeGraph()->GetHeight() && top_y + track->GetHeight() > 0) {
+        expected_tracks.push_back(track);
+      }
+    }
+    EXPECT_FALSE(expected_tracks.empty());
+    EXPECT_LT(expected_tracks.size(), kNumTracks);
+    EXPECT_EQ(track_container->GetChildrenVisibleInViewport(), expected_tracks);
+  };
+
+  expect_tracks_in_viewport();
+
+  track_container->SetVerticalScrollingOffset(track_container->GetVisibleTracksTotalHeight() / 2);
+  SimulatePreRender();
+  expect_tracks_in_viewport();
+
+  track_container->SetVerticalScrollingOffset(track_container->GetVisibleTracksTotalHeight());
+  SimulatePreRender();
+  expect_tracks_in_viewport();
+}
+
 }  // namespace orbit_gl
\ No newline at end of file
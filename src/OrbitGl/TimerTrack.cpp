@@ -347,6 +347,36 @@ void TimerTrack::DoUpdatePrimitives(PrimitiveAssembler& primitive_assembler,
   }
 }
 
+void TimerTrack::UpdateTimersAtAllDepthsDiscretized(uint32_t resolution, uint64_t min_tick,
+                                                    uint64_t max_tick) {
+  // The number of timers is read before querying them, so that timers added meanwhile during a
+  // capture invalidate the cache.
+  const size_t timer_count = GetNumberOfTimers();
+  const uint32_t depth_count = GetDepth();
+  if (discretized_timers_cache_.has_value() &&
+      discretized_timers_cache_->resolution == resolution &&
+      discretized_timers_cache_->min_tick == min_tick &&
+      discretized_timers_cache_->max_tick == max_tick &&
+      discretized_timers_cache_->timer_count == timer_count &&
+      discretized_timers_cache_->timers_by_depth.size() == depth_count) {
+    return;
+  }
+
+  DiscretizedTimers discretized_timers{resolution, min_tick, max_tick, timer_count, {}};
+  discretized_timers.timers_by_depth.reserve(depth_count);
+  for (uint32_t depth = 0; depth < depth_count; ++depth) {
+    discretized_timers.timers_by_depth.push_back(
+        GetTimersAtDepthDiscretized(depth, resolution, min_tick, max_tick));
+  }
+  discretized_timers_cache_ = std::move(discretized_timers);
+}
+
+const std::vector<std::vector<const TimerInfo*>>& TimerTrack::GetTimersAtAllDepthsDiscretized(
+    uint32_t resolution, uint64_t min_tick, uint64_t max_tick) {
+  UpdateTimersAtAllDepthsDiscretized(resolution, min_tick, max_tick);
+  return discretized_timers_cache_->timers_by_depth;
+}
+
 void TimerTrack::OnTimer(const TimerInfo& timer_info) {
   timer_data_->AddTimer(timer_info, timer_info.depth());
 }
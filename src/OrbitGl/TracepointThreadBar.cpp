@@ -64,6 +64,7 @@ void TracepointThreadBar::DoUpdatePrimitives(PrimitiveAssembler& primitive_assem
   float z = GlCanvas::kZValueEvent;
   float track_height = layout_->GetEventTrackHeightFromTid(GetThreadId());
   const bool picking = picking_mode != PickingMode::kNone;
+  uint32_t resolution_in_pixels = viewport_->WorldToScreen({GetWidth(), 0})[0];
 
   const Color white(255, 255, 255, 255);
   const Color white_transparent(255, 255, 255, 190);
@@ -72,8 +73,8 @@ void TracepointThreadBar::DoUpdatePrimitives(PrimitiveAssembler& primitive_assem
   ORBIT_CHECK(capture_data_ != nullptr);
 
   if (!picking) {
-    capture_data_->ForEachTracepointEventOfThreadInTimeRange(
-        GetThreadId(), min_tick, max_tick,
+    capture_data_->ForEachTracepointEventOfThreadInTimeRangeDiscretized(
+        GetThreadId(), min_tick, max_tick, resolution_in_pixels,
         [&](const orbit_client_data::TracepointEventInfo& tracepoint) {
           uint64_t time = tracepoint.timestamp_ns();
           float radius = track_height / 4;
@@ -94,8 +95,8 @@ void TracepointThreadBar::DoUpdatePrimitives(PrimitiveAssembler& primitive_assem
     constexpr float kPickingBoxWidth = 9.0f;
     constexpr float kPickingBoxOffset = kPickingBoxWidth / 2.0f;
 
-    capture_data_->ForEachTracepointEventOfThreadInTimeRange(
-        GetThreadId(), min_tick, max_tick,
+    capture_data_->ForEachTracepointEventOfThreadInTimeRangeDiscretized(
+        GetThreadId(), min_tick, max_tick, resolution_in_pixels,
         [&](const orbit_client_data::TracepointEventInfo& tracepoint) {
           uint64_t time = tracepoint.timestamp_ns();
           Vec2 pos(timeline_info_->GetWorldFromTick(time) - kPickingBoxOffset,
@@ -61,16 +61,6 @@ TrackContainer::TrackContainer(CaptureViewElement* parent, TimelineInfoInterface
   track_manager_->GetOrCreateSchedulerTrack();
 }
 
-float TrackContainer::GetVisibleTracksTotalHeight() const {
-  float visible_tracks_total_height = 0.f;
-
-  // Track height including space between them.
-  for (auto& track : GetNonHiddenChildren()) {
-    visible_tracks_total_height += (track->GetHeight() + layout_->GetSpaceBetweenTracks());
-  }
-  return visible_tracks_total_height;
-}
-
 void TrackContainer::VerticalZoom(float real_ratio, float mouse_screen_y_position) {
   // Adjust the scrolling offset such that the point under the mouse stays the same if possible.
   // For this, calculate the "global" position (including scaling and scrolling offset) of the point
@@ -115,17 +105,29 @@ void TrackContainer::DoUpdateLayout() {
 
 void TrackContainer::UpdateTracksPosition() {
   const float track_pos_x = GetPos()[0];
+  const float tracks_top_y = GetPos()[1] - vertical_scrolling_offset_;
+  const std::vector<Track*>& tracks = track_manager_->GetVisibleTracks();
 
-  float current_y = GetPos()[1] - vertical_scrolling_offset_;
+  track_tops_.resize(tracks.size());
+  track_bottoms_.resize(tracks.size());
+  moving_track_index_ = std::nullopt;
 
   // Track height including space between them
-  for (const auto& track : track_manager_->GetVisibleTracks()) {
-    if (!track->IsMoving()) {
-      track->SetPos(track_pos_x, current_y);
+  float current_y = 0;
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    Track* track = tracks[i];
+    if (track->IsMoving()) {
+      moving_track_index_ = i;
+    } else {
+      track->SetPos(track_pos_x, tracks_top_y + current_y);
     }
     track->SetWidth(GetWidth());
-    current_y += (track->GetHeight() + layout_->GetSpaceBetweenTracks());
+    track_tops_[i] = current_y;
+    float height = track->GetHeight();
+    track_bottoms_[i] = current_y + height;
+    current_y += (height + layout_->GetSpaceBetweenTracks());
   }
+  visible_tracks_total_height_ = current_y;
 }
 
 namespace {
@@ -496,6 +498,45 @@ std::vector<CaptureViewElement*> TrackContainer::GetNonHiddenChildren() const {
   return {all_tracks.begin(), all_tracks.end()};
 }
 
+std::vector<CaptureViewElement*> TrackContainer::GetChildrenVisibleInViewport() const {
+  const std::vector<Track*>& tracks = track_manager_->GetVisibleTracks();
+  // The track list changed since the last layout update.
+  if (tracks.size() != track_tops_.size()) {
+    return CaptureViewElement::GetChildrenVisibleInViewport();
+  }
+
+  auto is_visible_in_viewport = [this](const Track* track) {
+    const float top_y = track->GetPos()[1];
+    return top_y < viewport_->GetWorldHeight() && top_y + track->GetHeight() > 0;
+  };
+
+  // The viewport in the coordinates of track_tops_ and track_bottoms_.
+  const float tracks_top_y = GetPos()[1] - vertical_scrolling_offset_;
+  const float viewport_top = -tracks_top_y;
+  const float viewport_bottom = viewport_->GetWorldHeight() - tracks_top_y;
+  const size_t begin =
+      std::upper_bound(track_bottoms_.begin(), track_bottoms_.end(), viewport_top) -
+      track_bottoms_.begin();
+  const size_t end = std::max(
+      begin, static_cast<size_t>(
+                 std::lower_bound(track_tops_.begin(), track_tops_.end(), viewport_bottom) -
+                 track_tops_.begin()));
+
+  std::vector<CaptureViewElement*> result;
+  if (moving_track_index_.has_value() && moving_track_index_.value() < begin &&
+      is_visible_in_viewport(tracks[moving_track_index_.value()])) {
+    result.push_back(tracks[moving_track_index_.value()]);
+  }
+  for (size_t i = begin; i < end; ++i) {
+    if (is_visible_in_viewport(tracks[i])) result.push_back(tracks[i]);
+  }
+  if (moving_track_index_.has_value() && moving_track_index_.value() >= end &&
+      is_visible_in_viewport(tracks[moving_track_index_.value()])) {
+    result.push_back(tracks[moving_track_index_.value()]);
+  }
+  return result;
+}
+
 std::unique_ptr<orbit_accessibility::AccessibleInterface>
 TrackContainer::CreateAccessibleInterface() {
   return std::make_unique<AccessibleCaptureViewElement>(
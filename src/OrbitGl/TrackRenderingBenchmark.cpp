@@ -0,0 +1,163 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "ClientData/TimerData.h"
+#include "ClientProtos/capture_data.pb.h"
+#include "OrbitGl/BatchRenderGroup.h"
+#include "OrbitGl/MockBatcher.h"
+#include "OrbitGl/MockTextRenderer.h"
+#include "OrbitGl/MockTimelineInfo.h"
+#include "OrbitGl/PickingManager.h"
+#include "OrbitGl/PrimitiveAssembler.h"
+#include "OrbitGl/StaticTimeGraphLayout.h"
+#include "OrbitGl/SystemMemoryTrack.h"
+#include "OrbitGl/Track.h"
+#include "OrbitGl/VariableTrack.h"
+#include "OrbitGl/Viewport.h"
+
+// Replays a fixed sequence of zooms and pans over synthetic capture data, one frame per benchmark
+// iteration, so that the time per iteration is the time of one frame of the track type.
+
+namespace orbit_gl {
+namespace {
+
+constexpr uint64_t kCaptureDurationNs = 60'000'000'000;
+constexpr int kViewportWidth = 1920;
+constexpr int kViewportHeight = 1080;
+
+// The visible part of the capture in each frame, as fractions of the capture: zooming into the
+// middle, then panning over the capture at a high zoom level.
+constexpr std::array<std::pair<double, double>, 10> kScriptedViews{{
+    {0.0, 1.0},
+    {0.25, 0.75},
+    {0.45, 0.55},
+    {0.495, 0.505},
+    {0.4995, 0.5005},
+    {0.1, 0.1001},
+    {0.3, 0.3001},
+    {0.6, 0.6001},
+    {0.9, 0.9001},
+    {0.0, 1.0},
+}};
+
+[[nodiscard]] std::pair<uint64_t, uint64_t> GetScriptedView(size_t frame) {
+  const auto& [start, end] = kScriptedViews[frame % kScriptedViews.size()];
+  return {static_cast<uint64_t>(start * kCaptureDurationNs),
+          static_cast<uint64_t>(end * kCaptureDurationNs)};
+}
+
+class TrackRenderingBenchmark {
+ public:
+  TrackRenderingBenchmark()
+      : viewport_(kViewportWidth, kViewportHeight),
+        timeline_info_(kViewportWidth),
+        primitive_assembler_(&batcher_, &state_manager_, &picking_manager_) {}
+
+  [[nodiscard]] const TimelineInfoInterface* GetTimelineInfo() const { return &timeline_info_; }
+  [[nodiscard]] Viewport* GetViewport() { return &viewport_; }
+  [[nodiscard]] TimeGraphLayout* GetLayout() { return &layout_; }
+
+  void Run(benchmark::State& state, Track& track) {
+    track.SetWidth(static_cast<float>(kViewportWidth));
+    track.UpdateLayout();
+
+    size_t frame = 0;
+    int64_t num_primitives = 0;
+    for (auto _ : state) {
+      const auto [min_tick, max_tick] = GetScriptedView(frame++);
+      timeline_info_.SetMinMax(min_tick, max_tick);
+      primitive_assembler_.StartNewFrame();
+      text_renderer_.Clear();
+      track.UpdatePrimitives(primitive_assembler_, text_renderer_, min_tick, max_tick,
+                             PickingMode::kNone);
+      num_primitives +=
+          batcher_.GetNumLines() + batcher_.GetNumBoxes() + batcher_.GetNumTriangles();
+    }
+    state.counters["primitives_per_frame"] =
+        benchmark::Counter(static_cast<double>(num_primitives), benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  Viewport viewport_;
+  MockTimelineInfo timeline_info_;
+  StaticTimeGraphLayout layout_;
+  MockBatcher batcher_;
+  MockTextRenderer text_renderer_;
+  PickingManager picking_manager_;
+  BatchRenderGroupStateManager state_manager_;
+  PrimitiveAssembler primitive_assembler_;
+};
+
+[[nodiscard]] double GetSampleValue(uint64_t index) {
+  return std::sin(static_cast<double>(index) / 1000.0) * 100.0 + static_cast<double>(index % 7);
+}
+
+void BM_VariableTrackUpdatePrimitives(benchmark::State& state) {
+  const auto num_samples = static_cast<uint64_t>(state.range(0));
+  TrackRenderingBenchmark benchmark;
+  VariableTrack track(nullptr, benchmark.GetTimelineInfo(), benchmark.GetViewport(),
+                      benchmark.GetLayout(), "Variable", nullptr, nullptr);
+  for (uint64_t i = 0; i < num_samples; ++i) {
+    track.AddValue(i * (kCaptureDurationNs / num_samples), GetSampleValue(i));
+  }
+  benchmark.Run(state, track);
+}
+BENCHMARK(BM_VariableTrackUpdatePrimitives)->Arg(10'000)->Arg(1'000'000);
+
+void BM_SystemMemoryTrackUpdatePrimitives(benchmark::State& state) {
+  const auto num_samples = static_cast<uint64_t>(state.range(0));
+  TrackRenderingBenchmark benchmark;
+  SystemMemoryTrack track(nullptr, benchmark.GetTimelineInfo(), benchmark.GetViewport(),
+                          benchmark.GetLayout(), nullptr, nullptr);
+  for (uint64_t i = 0; i < num_samples; ++i) {
+    const double used = 1000.0 + GetSampleValue(i);
+    track.AddValues(i * (kCaptureDurationNs / num_samples), {used, 500.0, 4000.0 - used});
+  }
+  benchmark.Run(state, track);
+}
+BENCHMARK(BM_SystemMemoryTrackUpdatePrimitives)->Arg(10'000)->Arg(1'000'000);
+
+// Timer tracks need OrbitApp to update their primitives, so this covers what ThreadTrack queries
+// for each frame: the discretized timers of every depth.
+void BM_ThreadTrackTimerQueries(benchmark::State& state) {
+  const auto num_timers = static_cast<uint64_t>(state.range(0));
+  constexpr uint32_t kDepth = 8;
+  orbit_client_data::TimerData timer_data;
+  const uint64_t timer_duration_ns = kCaptureDurationNs / num_timers;
+  for (uint64_t i = 0; i < num_timers; ++i) {
+    // Nested timers, each depth half as long as the one above.
+    for (uint32_t depth = 0; depth < kDepth; ++depth) {
+      orbit_client_protos::TimerInfo timer;
+      timer.set_start(i * timer_duration_ns);
+      timer.set_end(i * timer_duration_ns + (timer_duration_ns >> (depth + 1)));
+      timer.set_depth(depth);
+      timer_data.AddTimer(std::move(timer), depth);
+    }
+  }
+
+  size_t frame = 0;
+  int64_t num_timers_drawn = 0;
+  for (auto _ : state) {
+    const auto [min_tick, max_tick] = GetScriptedView(frame++);
+    for (uint32_t depth = 0; depth < kDepth; ++depth) {
+      num_timers_drawn += static_cast<int64_t>(
+          timer_data.GetTimersAtDepthDiscretized(depth, kViewportWidth, min_tick, max_tick).size());
+    }
+  }
+  state.counters["timers_per_frame"] = benchmark::Counter(static_cast<double>(num_timers_drawn),
+                                                          benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ThreadTrackTimerQueries)->Arg(10'000)->Arg(100'000);
+
+}  // namespace
+}  // namespace orbit_gl
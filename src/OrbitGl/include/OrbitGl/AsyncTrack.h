@@ -17,6 +17,7 @@
 #include "ClientData/TimerData.h"
 #include "ClientData/TimerTrackDataIdManager.h"
 #include "ClientProtos/capture_data.pb.h"
+#include "OrbitGl/AsyncTrackLanes.h"
 #include "OrbitGl/CaptureViewElement.h"
 #include "OrbitGl/CoreMath.h"
 #include "OrbitGl/PickingManager.h"
@@ -60,7 +61,7 @@ class AsyncTrack final : public TimerTrack {
 
   std::string name_;
   // Used for determining what row can receive a new timer with no overlap.
-  absl::flat_hash_map<uint32_t, uint64_t> max_span_time_by_depth_;
+  orbit_gl::AsyncTrackLanes lanes_;
 };
 
 #endif  // ORBIT_GL_ASYNC_TRACK_H_
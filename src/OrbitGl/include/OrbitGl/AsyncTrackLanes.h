@@ -0,0 +1,42 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_GL_ASYNC_TRACK_LANES_H_
+#define ORBIT_GL_ASYNC_TRACK_LANES_H_
+
+#include <stddef.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace orbit_gl {
+
+// Assigns the timers of an AsyncTrack to lanes (depths) so that the timers of a lane don't overlap:
+// a timer goes to the lowest lane whose last timer ends no later than the timer starts, or to a new
+// lane if there is none. The last end of each lane is kept in a min segment tree, so each
+// assignment is logarithmic in the number of lanes, also when the timers don't arrive in order of
+// start.
+class AsyncTrackLanes {
+ public:
+  // Returns the lane of the timer [start, end) and makes `end` the last end of that lane.
+  [[nodiscard]] uint32_t AssignLane(uint64_t start, uint64_t end);
+
+  [[nodiscard]] uint32_t GetLaneCount() const { return lane_count_; }
+
+ private:
+  void Grow();
+  void SetLaneEnd(uint32_t lane, uint64_t end);
+
+  uint32_t lane_count_ = 0;
+  // Number of leaves of the tree, a power of two. The leaves of lanes that don't exist yet hold the
+  // maximum timestamp, so that they are never selected.
+  size_t capacity_ = 0;
+  // Node i has children 2 * i and 2 * i + 1 and holds the minimum of their values; the root is
+  // node 1, and the leaf of lane l is node capacity_ + l.
+  std::vector<uint64_t> min_end_tree_;
+};
+
+}  // namespace orbit_gl
+
+#endif  // ORBIT_GL_ASYNC_TRACK_LANES_H_
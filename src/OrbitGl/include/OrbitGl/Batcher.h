@@ -8,11 +8,13 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <optional>
 #include <string>
 #include <utility>
 
 #include "OrbitGl/BatchRenderGroup.h"
 #include "OrbitGl/BatcherInterface.h"
+#include "OrbitGl/CoreMath.h"
 #include "OrbitGl/PickingManager.h"
 #include "OrbitGl/TranslationStack.h"
 
@@ -42,6 +44,12 @@ class Batcher : public BatcherInterface {
   };
 
   [[nodiscard]] virtual Statistics GetStatistics() const = 0;
+
+  // Returns the id of the topmost primitive of `group` drawn at the screen position `pos`, or
+  // nullopt if there is none. This resolves picking on the CPU, from the picking colors that
+  // DrawRenderGroup would draw with `picking` set, instead of reading them back from a frame.
+  [[nodiscard]] virtual std::optional<PickingId> PickRenderGroup(const BatchRenderGroupId& group,
+                                                                 const Vec2& pos) const = 0;
   [[nodiscard]] std::string GetCurrentRenderGroupName() const override {
     return current_render_group_.name;
   }
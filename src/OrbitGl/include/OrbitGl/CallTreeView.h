@@ -9,6 +9,7 @@
 #include <absl/container/node_hash_map.h>
 #include <absl/hash/hash.h>
 #include <absl/types/span.h>
+#include <stddef.h>
 
 #include <algorithm>
 #include <cstdint>
@@ -32,6 +33,21 @@ class CallTreeFunction;
 class CallTreeUnwindErrors;
 class CallTreeUnwindErrorType;
 
+// A unique complete callstack of a thread, together with all of its samples. Instead of building
+// the whole tree upfront, a CallTreeView keeps these and a node only creates the part of the tree
+// below it from them when its children are first needed.
+struct CallTreeCallstack {
+  // The frames in the order in which their nodes appear on the path from the root of the tree.
+  std::vector<uint64_t> frames;
+  // If set, a node for this thread is created below the node of the last frame and gets the
+  // callstack events, as in the bottom-up view. Otherwise the node of the last frame gets them.
+  std::optional<uint32_t> thread_id;
+  std::string thread_name;
+  // Moved to the node that gets them once that node is created.
+  std::vector<orbit_client_data::CallstackEvent> callstack_events;
+  uint64_t sample_count = 0;
+};
+
 class CallTreeNode {
  public:
   explicit CallTreeNode(CallTreeNode* parent) : parent_{parent} {}
@@ -41,11 +57,15 @@ class CallTreeNode {
   [[nodiscard]] const CallTreeNode* parent() const { return parent_; }
 
   [[nodiscard]] uint64_t child_count() const {
+    ExpandPendingCallstacks();
     return thread_children_.size() + function_children_.size() +
            unwind_error_type_children_.size() + (unwind_errors_child_ != nullptr ? 1 : 0);
   }
 
-  [[nodiscard]] uint64_t thread_count() const { return thread_children_.size(); }
+  [[nodiscard]] uint64_t thread_count() const {
+    ExpandPendingCallstacks();
+    return thread_children_.size();
+  }
 
   [[nodiscard]] const std::vector<const CallTreeNode*>& children() const;
 
@@ -67,6 +87,11 @@ class CallTreeNode {
 
   [[nodiscard]] CallTreeUnwindErrors* AddAndGetUnwindErrors();
 
+  // Adds `callstack` to the part of the tree below this node, starting with its first frame. The
+  // nodes for its frames are only created when the children of this node are needed. `callstack`
+  // needs to outlive this node.
+  void AddPendingCallstack(CallTreeCallstack* callstack);
+
   [[nodiscard]] uint64_t sample_count() const { return sample_count_; }
 
   void IncreaseSampleCount(uint64_t sample_count_increase) {
@@ -104,6 +129,17 @@ class CallTreeNode {
   }
 
  private:
+  struct PendingCallstack {
+    CallTreeCallstack* callstack;
+    // The index of the frame in `callstack->frames` that the child of this node is created for.
+    size_t frame_index;
+  };
+
+  // Creates the children of this node for the pending callstacks, which only become pending
+  // callstacks of those children. This is only called from the UI thread, which is the only one
+  // accessing the tree after it was created.
+  void ExpandPendingCallstacks() const;
+
   absl::flat_hash_map<uint32_t, std::unique_ptr<CallTreeThread>> thread_children_{};
   absl::flat_hash_map<uint64_t, std::unique_ptr<CallTreeFunction>> function_children_{};
   absl::flat_hash_map<orbit_client_data::CallstackType, std::unique_ptr<CallTreeUnwindErrorType>>
@@ -117,6 +153,8 @@ class CallTreeNode {
 
   // Filled lazily when children() is called, invalidated when children are invalidated.
   mutable std::optional<std::vector<const CallTreeNode*>> children_cache_{};
+
+  std::vector<PendingCallstack> pending_callstacks_;
 };
 
 class CallTreeFunction : public CallTreeNode {
@@ -224,14 +262,18 @@ class CallTreeView {
 
  private:
   CallTreeView(std::unique_ptr<CallTreeRoot> call_tree_root,
+               std::vector<std::unique_ptr<CallTreeCallstack>> callstacks,
                const orbit_client_data::ModuleManager* module_manager,
                const orbit_client_data::CaptureData* capture_data)
-      : call_tree_root_{std::move(call_tree_root)},
+      : callstacks_{std::move(callstacks)},
+        call_tree_root_{std::move(call_tree_root)},
         module_manager_{module_manager},
         capture_data_{capture_data} {
     ORBIT_CHECK(call_tree_root_ != nullptr);
   }
 
+  // The callstacks that the nodes of the tree are created from when they are expanded.
+  std::vector<std::unique_ptr<CallTreeCallstack>> callstacks_;
   std::unique_ptr<CallTreeRoot> call_tree_root_;
   const orbit_client_data::ModuleManager* module_manager_{};
   const orbit_client_data::CaptureData* capture_data_{};
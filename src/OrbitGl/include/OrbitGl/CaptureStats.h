@@ -9,6 +9,7 @@
 
 #include <string>
 
+#include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Result.h"
 
 class CaptureWindow;
@@ -20,6 +21,12 @@ class CaptureStats {
   ErrorMessageOr<void> Generate(CaptureWindow* capture_window, uint64_t start_ns, uint64_t end_ns);
   [[nodiscard]] const std::string& GetSummary() const { return summary_; }
 
+  // Lists the time spent in each visitor of the perf_event_open events of the capture, which is
+  // not limited to the selected time period. This tells which of them was the bottleneck when the
+  // capture lost events.
+  [[nodiscard]] static std::string FormatPerfEventProcessingStats(
+      const orbit_grpc_protos::PerfEventProcessingStatsEvent& perf_event_processing_stats);
+
  private:
   std::string summary_;
 };
@@ -94,7 +94,7 @@ class CaptureViewElement : public Pickable, public AccessibleInterfaceProvider {
   [[nodiscard]] virtual CaptureViewElement* GetParent() const { return parent_; }
   [[nodiscard]] virtual std::vector<CaptureViewElement*> GetAllChildren() const { return {}; }
   [[nodiscard]] virtual std::vector<CaptureViewElement*> GetNonHiddenChildren() const;
-  [[nodiscard]] std::vector<CaptureViewElement*> GetChildrenVisibleInViewport() const;
+  [[nodiscard]] virtual std::vector<CaptureViewElement*> GetChildrenVisibleInViewport() const;
 
   // Specifies the type of render data that has been invalidated and needs update
   enum class RequestUpdateScope {
@@ -148,6 +148,9 @@ class CaptureViewElement : public Pickable, public AccessibleInterfaceProvider {
             const DrawContext& draw_context);
   void UpdatePrimitives(PrimitiveAssembler& primitive_assembler, TextRenderer& text_renderer,
                         uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode);
+  // Calls DoPrepareUpdatePrimitives, in parallel, for this element and all the children that the
+  // next UpdatePrimitives will update, and returns once all of them have completed.
+  void PrepareUpdatePrimitives(uint64_t min_tick, uint64_t max_tick);
 
   virtual void DoDraw(PrimitiveAssembler& /*primitive_assembler*/, TextRenderer& /*text_renderer*/,
                       const DrawContext& /*draw_context*/) {}
@@ -155,8 +158,18 @@ class CaptureViewElement : public Pickable, public AccessibleInterfaceProvider {
   virtual void DoUpdatePrimitives(PrimitiveAssembler& /*primitive_assembler*/,
                                   TextRenderer& /*text_renderer*/, uint64_t /*min_tick*/,
                                   uint64_t /*max_tick*/, PickingMode /*picking_mode*/) {}
+  // Runs on a worker thread, concurrently with the same method of other elements, before
+  // DoUpdatePrimitives is called with the same ticks. Override this to query the capture data that
+  // DoUpdatePrimitives will draw. It must not touch the batcher, the text renderer or other state
+  // shared between elements.
+  virtual void DoPrepareUpdatePrimitives(uint64_t /*min_tick*/, uint64_t /*max_tick*/) {}
 
   virtual void DoUpdateLayout() {}
+  // The children UpdateLayout recurses into, after DoUpdateLayout of this element. Elements with
+  // many children can restrict this to the children that will be drawn.
+  [[nodiscard]] virtual std::vector<CaptureViewElement*> GetChildrenToUpdateLayout() const {
+    return GetAllChildren();
+  }
 
   [[nodiscard]] bool ContainsPoint(const Vec2& pos) const;
   [[nodiscard]] virtual EventResult OnMouseWheel(const Vec2& mouse_pos, int delta,
@@ -177,6 +190,8 @@ class CaptureViewElement : public Pickable, public AccessibleInterfaceProvider {
   [[nodiscard]] uint32_t GetUid() const { return uid_; }
 
  private:
+  void CollectElementsToUpdatePrimitives(std::vector<CaptureViewElement*>* elements);
+
   bool is_mouse_over_ = false;
   uint32_t uid_;
 
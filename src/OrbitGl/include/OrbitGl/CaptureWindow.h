@@ -74,6 +74,8 @@ class CaptureWindow : public GlCanvas, public orbit_gl::CaptureWindowDebugInterf
  protected:
   void Draw(QPainter* painter) override;
 
+  // Returns the render groups of all batchers and text renderers, in the order they are drawn.
+  [[nodiscard]] std::vector<orbit_gl::BatchRenderGroupId> GetSortedRenderGroups() const;
   void RenderAllLayers(QPainter* painter);
 
   virtual bool ShouldSkipRendering() const;
@@ -81,12 +83,18 @@ class CaptureWindow : public GlCanvas, public orbit_gl::CaptureWindowDebugInterf
   virtual void ToggleRecording();
 
   void RenderHelpUi();
+  // Draws the per-frame timings of the phases of rendering, see scoped_frame_times_.
+  void RenderFrameTimingsUi();
+  void PushFrameTimeMs(const char* timing_name, double time_ms);
   void RenderSelectionOverlay();
   void SelectTimer(const orbit_client_protos::TimerInfo* timer_info);
 
   [[nodiscard]] virtual std::string GetHelpText() const;
   [[nodiscard]] virtual bool ShouldAutoZoom() const;
   void HandlePickedElement(PickingMode picking_mode, PickingId picking_id, int x, int y) override;
+  // Hit-tests the primitives of the batchers, which hold the picking colors of the picking pass,
+  // instead of drawing them and reading back the pixel.
+  [[nodiscard]] PickingId GetPickingIdAt(int x, int y) override;
   orbit_gl::Batcher& GetBatcherById(BatcherId batcher_id);
 
   std::unique_ptr<TimeGraph> time_graph_ = nullptr;
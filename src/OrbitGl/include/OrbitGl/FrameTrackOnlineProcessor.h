@@ -10,11 +10,13 @@
 #include <absl/hash/hash.h>
 
 #include <cstdint>
+#include <optional>
 
 #include "ClientData/CaptureData.h"
 #include "ClientData/TimerTrackDataIdManager.h"
 #include "ClientProtos/capture_data.pb.h"
 #include "GrpcProtos/capture.pb.h"
+#include "OrbitGl/RollingFrameTimeStats.h"
 #include "OrbitGl/TimeGraph.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -24,9 +26,13 @@ namespace orbit_gl {
 void CreateFrameTrackTimer(uint64_t function_id, uint64_t start_ns, uint64_t end_ns, int frame_id,
                            orbit_client_protos::TimerInfo* timer_info);
 
-// FrameTrackOnlineProcessor is used to create frame track timers during a capture.
+// FrameTrackOnlineProcessor is used to create frame track timers during a capture. It also keeps
+// statistics of the recent frame times of each frame track, see RollingFrameTimeStats.
 class FrameTrackOnlineProcessor {
  public:
+  // About five seconds at 60 frames per second.
+  static constexpr uint64_t kRecentFrameTimesWindowSize = 300;
+
   FrameTrackOnlineProcessor() = default;
   FrameTrackOnlineProcessor(const orbit_client_data::CaptureData& capture_data,
                             TimeGraph* time_graph);
@@ -35,9 +41,15 @@ class FrameTrackOnlineProcessor {
   void AddFrameTrack(uint64_t function_id);
   void RemoveFrameTrack(uint64_t function_id);
 
+  // Returns std::nullopt if there is no frame track for `function_id`. Like ProcessTimer, this must
+  // be called on the thread that processes the capture.
+  [[nodiscard]] std::optional<RollingFrameTimeStats::Summary> ComputeRecentFrameTimeStats(
+      uint64_t function_id) const;
+
  private:
   absl::flat_hash_set<uint64_t> current_frame_track_function_ids_;
   absl::flat_hash_map<uint64_t, uint64_t> function_id_to_previous_timestamp_ns_;
+  absl::flat_hash_map<uint64_t, RollingFrameTimeStats> function_id_to_recent_frame_time_stats_;
 
   TimeGraph* time_graph_{nullptr};
   int current_frame_index_ = 0;
@@ -141,6 +141,9 @@ class GlCanvas : public orbit_gl::AccessibleInterfaceProvider, protected QOpenGL
   [[nodiscard]] std::unique_ptr<orbit_accessibility::AccessibleInterface>
   CreateAccessibleInterface() override;
   void Pick(PickingMode picking_mode, int x, int y);
+  // Returns the id of the element at the screen position (x, y). By default, it is read back from
+  // the picking frame that was just rendered.
+  [[nodiscard]] virtual PickingId GetPickingIdAt(int x, int y);
   virtual void HandlePickedElement(PickingMode /*picking_mode*/, PickingId /*picking_id*/,
                                    int /*x*/, int /*y*/) = 0;
 };
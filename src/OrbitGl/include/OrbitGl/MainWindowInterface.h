@@ -92,6 +92,8 @@ class MainWindowInterface {
   virtual void SetBottomUpView(std::shared_ptr<const CallTreeView> view) = 0;
   virtual void SetSelectionTopDownView(std::shared_ptr<const CallTreeView> view) = 0;
   virtual void SetSelectionBottomUpView(std::shared_ptr<const CallTreeView> view) = 0;
+  // The bottom-up view of the callstacks of the sampled page faults.
+  virtual void SetPageFaultsBottomUpView(std::shared_ptr<const CallTreeView> view) = 0;
   virtual void SetSamplingReport(
       const orbit_client_data::CallstackData* callstack_data,
       const orbit_client_data::PostProcessedSamplingData* post_processed_sampling_data) = 0;
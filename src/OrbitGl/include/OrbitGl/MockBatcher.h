@@ -14,6 +14,7 @@
 #include <array>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <set>
 #include <unordered_set>
 #include <vector>
@@ -51,6 +52,11 @@ class MockBatcher : public Batcher {
 
   [[nodiscard]] Statistics GetStatistics() const override { return {}; }
 
+  [[nodiscard]] std::optional<PickingId> PickRenderGroup(const BatchRenderGroupId& /*group*/,
+                                                         const Vec2& /*pos*/) const override {
+    return std::nullopt;
+  }
+
   [[nodiscard]] const PickingUserData* GetUserData(PickingId /*id*/) const override {
     return nullptr;
   }
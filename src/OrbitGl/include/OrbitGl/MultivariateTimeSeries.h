@@ -6,12 +6,12 @@
 #define ORBIT_GL_MULTIVARIATE_TIME_SERIES_H_
 
 #include <absl/base/thread_annotations.h>
-#include <absl/container/btree_map.h>
 #include <absl/synchronization/mutex.h>
 #include <absl/types/span.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#include <array>
 #include <limits>
 #include <optional>
 #include <string>
@@ -49,19 +49,113 @@ class MultivariateTimeSeries {
   [[nodiscard]] std::vector<std::pair<uint64_t, std::vector<double>>> GetEntriesAffectedByTimeRange(
       uint64_t min_time, uint64_t max_time) const;
 
-  void AddValues(uint64_t timestamp_ns, absl::Span<const double> values);
+  enum class ValueKind {
+    kValues,
+    // The value of series i is the sum of the values of the series 0 to i, as in stacked graphs.
+    kStackedValues,
+  };
+
+  // A run of consecutive entries, summarized by the minimum and the maximum of each series.
+  struct DecimatedEntry {
+    uint64_t first_time_ns = 0;
+    uint64_t last_time_ns = 0;
+    std::vector<double> first_values;
+    std::vector<double> last_values;
+    std::vector<double> min_values;
+    std::vector<double> max_values;
+  };
 
-  using TimeSeriesEntryIter = absl::btree_map<uint64_t, std::vector<double>>::const_iterator;
+  // Returns the entries affected by the time range [min_time, max_time], see
+  // GetEntriesAffectedByTimeRange, where all consecutive entries whose time falls into the same of
+  // `resolution` pixels covering [min_time, max_time) are merged into one. Entries outside of that
+  // range are never merged. The cost per returned entry is logarithmic in the number of entries it
+  // merges, so it only depends on the resolution, and not on the zoom level.
+  [[nodiscard]] std::vector<DecimatedEntry> GetDecimatedEntriesAffectedByTimeRange(
+      uint64_t min_time, uint64_t max_time, uint32_t resolution, ValueKind value_kind) const;
+
+  void AddValues(uint64_t timestamp_ns, absl::Span<const double> values);
 
  private:
-  [[nodiscard]] TimeSeriesEntryIter GetPreviousOrFirstEntryIterator(uint64_t time) const
+  // The entries are stored in blocks of this many consecutive entries, see CompactBlock, and each
+  // block of the lowest level of the pyramid summarizes one of them.
+  static constexpr size_t kEntriesPerBlock = 64;
+  // Each block of the higher levels of the pyramid summarizes this many blocks of the level below.
+  static constexpr size_t kPyramidFanout = 16;
+
+  // The entries of a block stored by column: timestamps is sorted and series_values[i][j] is the
+  // value of series i at timestamps[j].
+  struct DecodedBlock {
+    std::vector<uint64_t> timestamps;
+    std::vector<std::vector<double>> series_values;
+  };
+
+  // A complete block of kEntriesPerBlock entries, encoded as the varints of the differences
+  // between consecutive timestamps, followed by each series. A series is encoded as the zigzag
+  // varints of the differences between consecutive values in fixed point with
+  // value_decimal_digits_ digits if that represents all of its values exactly, and as the values
+  // themselves otherwise. Memory usage samples are rounded to those digits and change slowly, so
+  // this mostly takes one to three bytes per timestamp and value instead of eight.
+  struct CompactBlock {
+    uint64_t first_timestamp_ns = 0;
+    uint64_t last_timestamp_ns = 0;
+    std::vector<uint8_t> data;
+  };
+
+  [[nodiscard]] size_t GetEntryCount() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] uint64_t GetFirstTimestamp() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] uint64_t GetLastTimestamp() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] uint64_t GetTimestampAt(size_t index) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the block with the given index, decoding it if needed. The reference is only valid
+  // until the next call, as decoded blocks are cached.
+  [[nodiscard]] const DecodedBlock& GetBlock(size_t block_index) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] CompactBlock EncodeBlock(const DecodedBlock& block) const;
+  // Decodes into `block`, reusing its memory.
+  void DecodeBlock(const CompactBlock& compact_block, DecodedBlock* block) const;
+  // Stores `entries`, which can be of any size, as compact blocks and the last block.
+  void StoreEntries(DecodedBlock entries) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void InvalidateDecodedBlockCache() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the index of the first entry in [begin, end) whose time is not less than `time`, or
+  // greater than `time` if `strictly_greater`, and `end` if there is none.
+  [[nodiscard]] size_t FindFirstEntryIndex(uint64_t time, bool strictly_greater, size_t begin,
+                                           size_t end) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] size_t GetPreviousOrFirstEntryIndex(uint64_t time) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] size_t GetNextOrLastEntryIndex(uint64_t time) const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
-  [[nodiscard]] TimeSeriesEntryIter GetNextOrLastEntryIterator(uint64_t time) const
+  [[nodiscard]] std::vector<double> GetValuesAt(size_t index, ValueKind value_kind) const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  [[nodiscard]] size_t GetPyramidBlockOffset(ValueKind value_kind) const;
+  // Merges the minimum and the maximum of the entries [begin, end), which must be in the same
+  // block, into `min_max`, which holds the minima followed by the maxima.
+  void MergeEntriesInto(size_t begin, size_t end, ValueKind value_kind,
+                        absl::Span<double> min_max) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Same as above, for any range of entries, using the pyramid for the complete blocks inside it.
+  void MergeEntryRangeInto(size_t begin, size_t end, ValueKind value_kind,
+                           absl::Span<double> min_max) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void ComputePyramidBlock(size_t level, size_t block_index) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void UpdatePyramidAfterAppend() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void UpdatePyramidAfterOverwrite(size_t index) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void RebuildPyramid() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void UpdateMinAndMax(double value) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   mutable absl::Mutex mutex_;
-  absl::btree_map<uint64_t, std::vector<double>> time_to_series_values_ ABSL_GUARDED_BY(mutex_);
+  // All but the last block are complete and compacted. The last block holds the remaining entries,
+  // fewer than kEntriesPerBlock, and is kept decoded so that entries can be appended to it.
+  std::vector<CompactBlock> compact_blocks_ ABSL_GUARDED_BY(mutex_);
+  DecodedBlock last_block_ ABSL_GUARDED_BY(mutex_);
+  // Rendering reads the entries of the visible time range, so the same few blocks are decoded over
+  // and over. Two are kept, as the first and the last entry of a pixel can be in different ones.
+  struct DecodedBlockCacheEntry {
+    size_t block_index = std::numeric_limits<size_t>::max();
+    DecodedBlock block;
+  };
+  mutable std::array<DecodedBlockCacheEntry, 2> decoded_block_cache_ ABSL_GUARDED_BY(mutex_);
+  mutable size_t next_cache_entry_to_evict_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Level l holds a block for each complete run of kEntriesPerBlock * kPyramidFanout^l entries,
+  // starting at a multiple of that size. A block holds, for the values and then for the stacked
+  // values, the minimum of each series followed by the maximum of each series.
+  std::vector<std::vector<double>> pyramid_levels_ ABSL_GUARDED_BY(mutex_);
   double min_ ABSL_GUARDED_BY(mutex_) = std::numeric_limits<double>::max();
   double max_ ABSL_GUARDED_BY(mutex_) = std::numeric_limits<double>::lowest();
 
@@ -10,11 +10,14 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
 #include <algorithm>
 #include <array>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -89,7 +92,11 @@ struct PrimitiveBuffers {
 // NOTE: The OpenGlBatcher assumes x/y coordinates are in pixels and will automatically round those
 // down to the next integer in all Batcher::AddXXX methods. This fixes the issue of primitives
 // "jumping" around when their coordinates are changed slightly.
-class OpenGlBatcher : public Batcher, protected QOpenGLFunctions {
+//
+// If the context supports OpenGL 3.3, boxes are drawn with a single instanced draw call per render
+// group, uploading one BoxInstance per box instead of four vertices with their colors. Lines and
+// triangles, and boxes on older contexts, are drawn from client-side vertex arrays.
+class OpenGlBatcher : public Batcher, protected QOpenGLExtraFunctions {
  public:
   explicit OpenGlBatcher(BatcherId batcher_id) : Batcher(batcher_id) {}
 
@@ -111,6 +118,9 @@ class OpenGlBatcher : public Batcher, protected QOpenGLFunctions {
 
   [[nodiscard]] Statistics GetStatistics() const override;
 
+  [[nodiscard]] std::optional<PickingId> PickRenderGroup(const BatchRenderGroupId& group,
+                                                         const Vec2& pos) const override;
+
  protected:
   absl::flat_hash_map<BatchRenderGroupId, orbit_gl_internal::PrimitiveBuffers>
       primitive_buffers_by_group_;
@@ -120,6 +130,25 @@ class OpenGlBatcher : public Batcher, protected QOpenGLFunctions {
   void DrawLineBuffer(const BatchRenderGroupId& group, bool picking);
   void DrawBoxBuffer(const BatchRenderGroupId& group, bool picking);
   void DrawTriangleBuffer(const BatchRenderGroupId& group, bool picking);
+
+  // Returns whether DrawBoxBufferInstanced can be used, compiling its shader on the first call.
+  [[nodiscard]] bool IsInstancedBoxRenderingAvailable();
+  void DrawBoxBufferInstanced(const BatchRenderGroupId& group, bool picking);
+
+  // All boxes are axis-aligned, see MakeBox, so a box is described by its top-left corner, its size
+  // and the colors of its vertices, in the order of Quad::vertices.
+  struct BoxInstance {
+    Vec2 position;
+    Vec2 size;
+    std::array<Color, 4> colors;
+  };
+
+  enum class InstancedBoxRendering { kUninitialized, kAvailable, kUnavailable };
+  InstancedBoxRendering instanced_box_rendering_ = InstancedBoxRendering::kUninitialized;
+  std::unique_ptr<QOpenGLShaderProgram> box_program_;
+  QOpenGLBuffer box_instance_buffer_{QOpenGLBuffer::VertexBuffer};
+  // Reused between draw calls to avoid allocations.
+  std::vector<BoxInstance> box_instances_;
 };
 
 }  // namespace orbit_gl
@@ -6,7 +6,9 @@
 #define ORBIT_GL_APP_H_
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/base/thread_annotations.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
 #include <absl/time/time.h>
 #include <absl/types/span.h>
 #include <grpc/impl/codegen/connectivity_state.h>
@@ -54,10 +56,13 @@
 #include "ClientData/ThreadStateSliceInfo.h"
 #include "ClientData/TimerChain.h"
 #include "ClientData/WineSyscallHandlingMethod.h"
+#include "ClientModel/LiveSamplingDataPostProcessor.h"
 #include "ClientProtos/capture_data.pb.h"
 #include "ClientProtos/preset.pb.h"
+#include "ClientProtos/user_defined_capture_info.pb.h"
 #include "ClientServices/CrashManager.h"
 #include "ClientServices/ProcessManager.h"
+#include "CodeReport/DisassemblyCache.h"
 #include "CodeReport/DisassemblyReport.h"
 #include "DataViews/AppInterface.h"
 #include "DataViews/CallstackDataView.h"
@@ -164,6 +169,10 @@ class OrbitApp final : public DataViewFactory,
                         absl::flat_hash_set<uint64_t> frame_track_function_ids) override;
   void OnCaptureFinished(const orbit_grpc_protos::CaptureFinished& capture_finished) override;
   void OnTimer(const orbit_client_protos::TimerInfo& timer_info) override;
+  void OnCallstackEvent(orbit_client_data::CallstackEvent callstack_event) override;
+  void OnTimers(absl::Span<const orbit_client_protos::TimerInfo> timer_infos) override;
+  void OnCallstackEvents(
+      absl::Span<const orbit_client_data::CallstackEvent> callstack_events) override;
   void OnCgroupAndProcessMemoryInfo(
       const orbit_client_data::CgroupAndProcessMemoryInfo& cgroup_and_process_memory_info) override;
   void OnPageFaultsInfo(const orbit_client_data::PageFaultsInfo& page_faults_info) override;
@@ -174,6 +183,10 @@ class OrbitApp final : public DataViewFactory,
   void OnModulesSnapshot(uint64_t timestamp_ns,
                          std::vector<orbit_grpc_protos::ModuleInfo> module_infos) override;
   void OnPresentEvent(const orbit_grpc_protos::PresentEvent& present_event) override;
+  void OnPressureStallEvent(
+      const orbit_grpc_protos::PressureStallEvent& pressure_stall_event) override;
+  void OnPerformanceCounterSample(
+      const orbit_grpc_protos::PerformanceCounterSample& performance_counter_sample) override;
   void OnApiStringEvent(const orbit_client_data::ApiStringEvent& api_string_event) override;
   void OnApiTrackValue(const orbit_client_data::ApiTrackValue& api_track_value) override;
   void OnWarningEvent(orbit_grpc_protos::WarningEvent warning_event) override;
@@ -195,6 +208,8 @@ class OrbitApp final : public DataViewFactory,
       orbit_grpc_protos::LostPerfRecordsEvent lost_perf_records_event) override;
   void OnOutOfOrderEventsDiscardedEvent(orbit_grpc_protos::OutOfOrderEventsDiscardedEvent
                                             out_of_order_events_discarded_event) override;
+  void OnPerfEventProcessingStatsEvent(orbit_grpc_protos::PerfEventProcessingStatsEvent
+                                           perf_event_processing_stats_event) override;
 
   void SetCaptureWindow(CaptureWindow* capture);
   [[nodiscard]] const TimeGraph* GetTimeGraph() const {
@@ -230,6 +245,9 @@ class OrbitApp final : public DataViewFactory,
       const orbit_client_data::CaptureData* capture_data);
   void ClearSelectionBottomUpView();
 
+  void SetPageFaultsBottomUpView(const orbit_client_data::CaptureData& capture_data);
+  void ClearPageFaultsBottomUpView();
+
   // This needs to be called from the main thread.
   [[nodiscard]] bool IsCaptureConnected(
       const orbit_client_data::CaptureData& capture) const override;
@@ -282,6 +300,8 @@ class OrbitApp final : public DataViewFactory,
   void UpdateAfterSymbolLoading();
   void UpdateAfterSymbolLoadingThrottled();
   void ClearSamplingRelatedViews();
+  // Shows the latest snapshot of live_sampling_data_post_processor_ in the sampling report.
+  void RefreshLiveSamplingReport();
 
   // Load the functions and add frame tracks from a particular module of a preset file.
   orbit_base::Future<ErrorMessageOr<void>> LoadPresetModule(
@@ -507,6 +527,7 @@ class OrbitApp final : public DataViewFactory,
   void ClearThreadAndTimeRangeSelection();
 
  private:
+  void StopCaptureIfMemoryBudgetIsExceeded();
   void UpdateModulesAbortCaptureIfModuleWithoutBuildIdNeedsReload(
       absl::Span<const orbit_grpc_protos::ModuleInfo> module_infos);
   [[nodiscard]] ErrorMessageOr<std::vector<const orbit_client_data::ModuleData*>>
@@ -545,11 +566,22 @@ class OrbitApp final : public DataViewFactory,
                                absl::Span<const std::string> function_names);
   void AddFrameTrackTimers(uint64_t instrumented_function_id);
   void RefreshFrameTracks();
+  // Writes the UserDefinedCaptureInfo to the file of the capture on thread_pool_. Edits that come
+  // in while a write is in progress are coalesced into one write of the latest state.
   void TrySaveUserDefinedCaptureInfo();
+  void WritePendingUserDefinedCaptureInfo();
+  // Adds the CAPTURE_SUMMARY section to the file of a capture that was just taken, so that loading
+  // it doesn't need to recompute these results. The file is written on thread_pool_, and failures
+  // are only logged.
+  void TrySaveCaptureSummary(
+      const orbit_client_data::PostProcessedSamplingData& post_processed_sampling_data);
 
   orbit_base::Future<void> OnCaptureFailed(ErrorMessage error_message);
   orbit_base::Future<void> OnCaptureCancelled();
   orbit_base::Future<void> OnCaptureComplete();
+  // The part of OnCaptureComplete that runs on the main thread once the sampling data is ready.
+  void OnPostProcessedSamplingDataCreated(
+      orbit_client_data::PostProcessedSamplingData post_processed_sampling_data);
 
   void RequestUpdatePrimitives();
 
@@ -591,10 +623,31 @@ class OrbitApp final : public DataViewFactory,
   orbit_base::Executor* main_thread_executor_;
   std::thread::id main_thread_id_;
   std::shared_ptr<orbit_base::ThreadPool> thread_pool_;
+  // Serializes modifications of the capture file by tasks on thread_pool_.
+  absl::Mutex capture_file_mutex_;
+  struct UserDefinedCaptureInfoWrite {
+    // Incremented for each capture, as a new capture can be saved to the path of the previous one.
+    uint64_t capture_number = 0;
+    std::filesystem::path file_path;
+    orbit_client_protos::UserDefinedCaptureInfo capture_info;
+  };
+  absl::Mutex user_defined_capture_info_write_mutex_;
+  uint64_t capture_number_ ABSL_GUARDED_BY(user_defined_capture_info_write_mutex_) = 0;
+  // The latest UserDefinedCaptureInfo that hasn't been written yet, and whether a task on
+  // thread_pool_ that writes it is scheduled or running. There is at most one such task.
+  std::optional<UserDefinedCaptureInfoWrite> pending_user_defined_capture_info_write_
+      ABSL_GUARDED_BY(user_defined_capture_info_write_mutex_);
+  bool user_defined_capture_info_write_scheduled_
+      ABSL_GUARDED_BY(user_defined_capture_info_write_mutex_) = false;
+  // The capture number and the serialized UserDefinedCaptureInfo of the last successful write, so
+  // that the section isn't rewritten with the same content.
+  std::optional<std::pair<uint64_t, std::string>> last_written_user_defined_capture_info_
+      ABSL_GUARDED_BY(capture_file_mutex_);
   std::unique_ptr<orbit_capture_client::CaptureClient> capture_client_;
   orbit_client_services::ProcessManager* process_manager_ = nullptr;
   std::unique_ptr<orbit_client_data::ModuleManager> module_manager_;
   orbit_client_data::ModuleIdentifierProvider module_identifier_provider_{};
+  orbit_code_report::DisassemblyCache disassembly_cache_;
   std::unique_ptr<orbit_client_data::DataManager> data_manager_;
   std::unique_ptr<orbit_client_services::CrashManager> crash_manager_;
   std::unique_ptr<ManualInstrumentationManager> manual_instrumentation_manager_;
@@ -603,6 +656,21 @@ class OrbitApp final : public DataViewFactory,
 
   orbit_gl::FrameTrackOnlineProcessor frame_track_online_processor_;
 
+  // Only exists during a live capture. It is created and destroyed on the main thread while the
+  // capture thread doesn't deliver CallstackEvents, and used from both threads in between.
+  std::unique_ptr<orbit_client_model::LiveSamplingDataPostProcessor>
+      live_sampling_data_post_processor_;
+  static constexpr absl::Duration kLiveSamplingReportInterval = absl::Seconds(1);
+  static constexpr size_t kLiveSamplingReportFunctionCount = 100;
+  // The sampling report points to this while capturing.
+  std::optional<orbit_client_data::PostProcessedSamplingData> live_sampling_snapshot_;
+  size_t live_sampling_snapshot_thread_count_ = 0;
+
+  // While capturing, MainTick compares the size of the capture data with
+  // --capture_memory_budget_mb at this interval.
+  static constexpr absl::Duration kCaptureMemoryBudgetCheckInterval = absl::Seconds(1);
+  absl::Time last_capture_memory_budget_check_time_ = absl::InfinitePast();
+
   orbit_capture_file_info::Manager capture_file_info_manager_{};
 
   const orbit_statistics::WilsonBinomialConfidenceIntervalEstimator confidence_interval_estimator_;
@@ -101,6 +101,11 @@ struct PickingId {
     return absl::bit_cast<uint32_t>(layout);
   }
 
+  [[nodiscard]] static PickingId FromColor(const Color& color) {
+    const std::array<uint8_t, 4> color_values{color[0], color[1], color[2], color[3]};
+    return FromPixelValue(absl::bit_cast<uint32_t>(color_values));
+  }
+
   [[nodiscard]] static Color ToColor(PickingType type, uint32_t element_id,
                                      BatcherId batcher_id = BatcherId::kTimeGraph) {
     uint32_t pixel_value = Create(type, element_id, batcher_id).ToPixelValue();
@@ -8,11 +8,15 @@
 #include <absl/container/flat_hash_map.h>
 #include <absl/hash/hash.h>
 
+#include <QFontMetrics>
+#include <QHash>
 #include <QPainter>
+#include <QStaticText>
 #include <QString>
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "OrbitGl/BatchRenderGroup.h"
@@ -23,6 +27,9 @@
 namespace orbit_gl {
 
 // Qt implementation of TextRenderer.
+// Texts are drawn as QStaticText, whose layout is cached across frames per string and font size,
+// so that only new strings are laid out. Drawing them goes through the glyph cache of the OpenGL
+// paint engine. Elided strings are cached as well, per string, font size and maximum width.
 class QtTextRenderer : public TextRenderer {
  public:
   void Init() override{};
@@ -50,6 +57,10 @@ class QtTextRenderer : public TextRenderer {
  private:
   using CharacterWidthLookup = std::array<int, 256>;
 
+  [[nodiscard]] const QFontMetrics& GetFontMetrics(uint32_t font_size);
+  [[nodiscard]] const QStaticText& GetStaticText(const QString& text, uint32_t font_size);
+  [[nodiscard]] const QString& GetElidedText(const QString& text, uint32_t font_size,
+                                             int max_width);
   [[nodiscard]] float GetStringWidth(const QString& text, uint32_t font_size);
   [[nodiscard]] float GetSingleLineStringHeight(uint32_t font_size);
   [[nodiscard]] const CharacterWidthLookup& GetCharacterWidthLookup(uint32_t font_size);
@@ -62,9 +73,9 @@ class QtTextRenderer : public TextRenderer {
                                                const CharacterWidthLookup& lookup);
   struct StoredText {
     StoredText() = default;
-    StoredText(const QString& text, int x, int y, int w, int h, TextFormatting formatting)
+    StoredText(const QStaticText& text, int x, int y, int w, int h, TextFormatting formatting)
         : text(text), x(x), y(y), w(w), h(h), formatting(formatting) {}
-    QString text;
+    QStaticText text;
     int x = 0;
     int y = 0;
     int w = 0;
@@ -75,6 +86,11 @@ class QtTextRenderer : public TextRenderer {
   absl::flat_hash_map<uint32_t, float> minimum_string_width_cache_;
   absl::flat_hash_map<uint32_t, CharacterWidthLookup> character_width_lookup_cache_;
   absl::flat_hash_map<uint32_t, int> single_line_height_cache_;
+  absl::flat_hash_map<uint32_t, QFontMetrics> font_metrics_cache_;
+  // Keyed by font size. The caches are cleared when they grow too large, see GetStaticText.
+  absl::flat_hash_map<uint32_t, QHash<QString, QStaticText>> static_text_cache_;
+  // Keyed by font size and maximum width in pixels.
+  absl::flat_hash_map<std::pair<uint32_t, int>, QHash<QString, QString>> elided_text_cache_;
 };
 
 }  // namespace orbit_gl
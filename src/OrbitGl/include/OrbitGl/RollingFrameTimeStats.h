@@ -0,0 +1,57 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_GL_ROLLING_FRAME_TIME_STATS_H_
+#define ORBIT_GL_ROLLING_FRAME_TIME_STATS_H_
+
+#include <stddef.h>
+
+#include <cstdint>
+
+#include "Statistics/LogLinearHistogram.h"
+
+namespace orbit_gl {
+
+// Statistics of the recent frame times of a frame track, updated in constant time per frame so that
+// they can be kept up to date during a live capture without rescanning the timers. The frames are
+// added to the current window, and once it holds `window_size` frames it replaces the previous
+// window. The statistics are over both windows, i.e., over the last `window_size` to
+// 2 * `window_size` frames.
+// A frame is a hitch if it is more than kHitchFactor times as long as the average of the frames
+// that precede it in the windows.
+class RollingFrameTimeStats {
+ public:
+  static constexpr uint64_t kHitchFactor = 2;
+
+  struct Summary {
+    uint64_t frame_count = 0;
+    uint64_t average_ns = 0;
+    uint64_t median_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t hitch_count = 0;
+  };
+
+  explicit RollingFrameTimeStats(uint64_t window_size);
+
+  void AddFrameTime(uint64_t frame_time_ns);
+
+  // Merges the two windows, so this is linear in the number of buckets of the histograms.
+  [[nodiscard]] Summary ComputeSummary() const;
+
+ private:
+  struct Window {
+    orbit_statistics::LogLinearHistogram histogram;
+    uint64_t total_ns = 0;
+    uint64_t hitch_count = 0;
+  };
+
+  uint64_t window_size_;
+  Window previous_window_;
+  Window current_window_;
+};
+
+}  // namespace orbit_gl
+
+#endif  // ORBIT_GL_ROLLING_FRAME_TIME_STATS_H_
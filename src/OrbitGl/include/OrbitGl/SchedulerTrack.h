@@ -13,6 +13,7 @@
 
 #include "ClientData/CaptureData.h"
 #include "ClientData/ModuleManager.h"
+#include "ClientData/SchedulingOccupancyPyramid.h"
 #include "ClientData/TimerData.h"
 #include "ClientData/TimerTrackDataIdManager.h"
 #include "ClientProtos/capture_data.pb.h"
@@ -59,6 +60,13 @@ class SchedulerTrack final : public TimerTrack {
   void DoUpdatePrimitives(orbit_gl::PrimitiveAssembler& primitive_assembler,
                           orbit_gl::TextRenderer& text_renderer, uint64_t min_tick,
                           uint64_t max_tick, PickingMode picking_mode) override;
+  void DoPrepareUpdatePrimitives(uint64_t min_tick, uint64_t max_tick) override;
+  [[nodiscard]] uint32_t GetResolutionInPixels() const;
+  // Whether the track is zoomed out enough for each pixel to be drawn from the occupancy of the
+  // cores rather than from the slices.
+  [[nodiscard]] bool UseOccupancy(uint64_t min_tick, uint64_t max_tick) const;
+  void DrawOccupancy(orbit_gl::PrimitiveAssembler& primitive_assembler,
+                     const internal::DrawData& draw_data, uint64_t min_tick, uint64_t max_tick);
   [[nodiscard]] bool IsTimerActive(const orbit_client_protos::TimerInfo& timer_info) const override;
   [[nodiscard]] Color GetTimerColor(const orbit_client_protos::TimerInfo& timer_info,
                                     bool is_selected, bool is_highlighted,
@@ -68,6 +76,7 @@ class SchedulerTrack final : public TimerTrack {
 
  private:
   uint32_t num_cores_;
+  orbit_client_data::SchedulingOccupancyPyramid occupancy_pyramid_;
 };
 
 #endif  // ORBIT_GL_SCHEDULER_TRACK_H_
@@ -109,6 +109,7 @@ class StaticTimeGraphLayout : public TimeGraphLayout {
   [[nodiscard]] bool GetDrawTimeGraphMasks() const override { return false; }
 
   [[nodiscard]] bool GetRenderDebugLayers() const override { return kRenderDebugLayers; }
+  [[nodiscard]] bool GetDrawFrameTimings() const override { return false; }
 
  private:
   constexpr static float kTextBoxHeight = 20.f;
@@ -7,9 +7,11 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <filesystem>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -27,6 +29,7 @@
 #include "OrbitBase/CanceledOr.h"
 #include "OrbitBase/Executor.h"
 #include "OrbitBase/Future.h"
+#include "OrbitBase/Promise.h"
 #include "OrbitBase/Result.h"
 #include "OrbitBase/StopSource.h"
 #include "OrbitBase/StopToken.h"
@@ -66,11 +69,20 @@ class SymbolLoader {
                orbit_client_services::ProcessManager* process_manager,
                const orbit_client_data::ModuleIdentifierProvider* module_identifier_provider);
 
+  // Symbols of at most this many modules are retrieved and loaded at the same time, so that the
+  // modules that matter most don't compete with all the others for the network and the threads.
+  static constexpr size_t kMaxModulesLoadingConcurrently = 8;
+  // Modules requested with a higher priority start loading first, so requests with the default
+  // priority, e.g. when the user loads symbols manually, go ahead of all automatic ones waiting.
+  static constexpr uint64_t kHighestPriority = std::numeric_limits<uint64_t>::max();
+
   // RetrieveModuleAndLoadSymbols tries to retrieve and load the module symbols by calling
   // `RetrieveModuleSymbolsAndLoadSymbols`. If this fails, it falls back on
-  // `RetrieveModuleItselfAndLoadFallbackSymbols`.
+  // `RetrieveModuleItselfAndLoadFallbackSymbols`. If kMaxModulesLoadingConcurrently modules are
+  // already loading, the module waits until it has the highest `priority` of the waiting modules.
+  // Requesting a module that is loading or waiting returns the same future.
   orbit_base::Future<ErrorMessageOr<orbit_base::CanceledOr<void>>> RetrieveModuleAndLoadSymbols(
-      const orbit_client_data::ModuleData* module_data);
+      const orbit_client_data::ModuleData* module_data, uint64_t priority = kHighestPriority);
 
   // This method is pretty similar to `RetrieveModuleSymbols`, but it also requires debug
   // information to be present.
@@ -94,8 +106,23 @@ class SymbolLoader {
     orbit_base::Future<ErrorMessageOr<orbit_base::CanceledOr<std::filesystem::path>>> future;
   };
 
+  struct PendingModule {
+    orbit_client_data::ModulePathAndBuildId module_path_and_build_id;
+    uint64_t priority;
+    // Orders modules of the same priority by the time they were requested.
+    uint64_t sequence_number;
+    orbit_base::Promise<ErrorMessageOr<orbit_base::CanceledOr<void>>> promise;
+  };
+
   void InitRemoteSymbolProviders();
 
+  // Starts loading the waiting modules of the highest priority until kMaxModulesLoadingConcurrently
+  // modules are loading.
+  void StartPendingModules();
+  orbit_base::Future<ErrorMessageOr<orbit_base::CanceledOr<void>>>
+  RetrieveModuleAndLoadSymbolsOrFallbackSymbols(
+      const orbit_client_data::ModulePathAndBuildId& module_path_and_build_id);
+
   // RetrieveModuleSymbolsAndLoadSymbols retrieves the module symbols by calling
   // `RetrieveModuleSymbols` and afterwards loads the symbols by calling `LoadSymbols`.
   orbit_base::Future<ErrorMessageOr<orbit_base::CanceledOr<void>>>
@@ -161,6 +188,13 @@ class SymbolLoader {
                       orbit_base::Future<ErrorMessageOr<orbit_base::CanceledOr<void>>>>
       symbols_currently_loading_;
 
+  // Modules that are in symbols_currently_loading_, but wait for other modules to finish loading.
+  // ONLY access this from the main thread.
+  absl::flat_hash_map<orbit_client_data::ModuleIdentifier, PendingModule> pending_modules_;
+  uint64_t next_pending_module_sequence_number_ = 0;
+  // ONLY access this from the main thread.
+  size_t num_modules_loading_ = 0;
+
   // Set of modules where a symbol loading error has occurred. The module identifier consists of
   // file path and build ID.
   // ONLY access this from the main thread.
@@ -92,7 +92,9 @@ class ThreadTrack final : public TimerTrack {
 
   [[nodiscard]] bool IsCollapsible() const override { return GetDepth() > 1; }
 
-  [[nodiscard]] Vec2 GetThreadStateBarPos() const { return thread_state_bar_->GetPos(); }
+  // Where UpdatePositionOfSubtracks puts the thread state bar. This doesn't rely on the layout of
+  // the track being up to date, as tracks outside of the viewport are not laid out.
+  [[nodiscard]] Vec2 GetThreadStateBarPos() const;
   [[nodiscard]] float GetThreadStateBarHeight() const { return thread_state_bar_->GetHeight(); }
 
   [[nodiscard]] std::vector<CaptureViewElement*> GetAllChildren() const override;
@@ -101,6 +103,10 @@ class ThreadTrack final : public TimerTrack {
   void DoUpdatePrimitives(orbit_gl::PrimitiveAssembler& primitive_assembler,
                           orbit_gl::TextRenderer& text_renderer, uint64_t min_tick,
                           uint64_t max_tick, PickingMode picking_mode) override;
+  void DoPrepareUpdatePrimitives(uint64_t min_tick, uint64_t max_tick) override;
+  [[nodiscard]] std::vector<const orbit_client_protos::TimerInfo*> GetTimersAtDepthDiscretized(
+      uint32_t depth, uint32_t resolution, uint64_t min_tick, uint64_t max_tick) const override;
+  [[nodiscard]] uint32_t GetResolutionInPixels() const;
 
   [[nodiscard]] int64_t GetThreadId() const { return thread_id_; }
   [[nodiscard]] bool IsTimerActive(const orbit_client_protos::TimerInfo& timer) const override;
@@ -26,6 +26,7 @@
 #include "ClientData/TimerChain.h"
 #include "ClientData/TimerTrackDataIdManager.h"
 #include "ClientProtos/capture_data.pb.h"
+#include "GrpcProtos/capture.pb.h"
 #include "OrbitAccessibility/AccessibleInterface.h"
 #include "OrbitGl/AccessibleInterfaceProvider.h"
 #include "OrbitGl/BatchRenderGroup.h"
@@ -73,6 +74,10 @@ class TimeGraph : public orbit_gl::CaptureViewElement, public orbit_gl::Timeline
   void ProcessSystemMemoryInfo(const orbit_client_data::SystemMemoryInfo& system_memory_info);
   void ProcessApiStringEvent(const orbit_client_data::ApiStringEvent& string_event);
   void ProcessApiTrackValueEvent(const orbit_client_data::ApiTrackValue& track_event) const;
+  void ProcessPressureStallEvent(
+      const orbit_grpc_protos::PressureStallEvent& pressure_stall_event) const;
+  void ProcessPerformanceCounterSample(
+      const orbit_grpc_protos::PerformanceCounterSample& performance_counter_sample) const;
 
   [[nodiscard]] const orbit_client_data::CaptureData* GetCaptureData() const {
     return capture_data_;
@@ -157,6 +162,19 @@ class TimeGraph : public orbit_gl::CaptureViewElement, public orbit_gl::Timeline
     return RedrawType::kNone;
   }
 
+  // How long the phases of updating the primitives took in the last call of DrawAllElements, or
+  // std::nullopt if that call didn't update them.
+  struct UpdatePrimitivesTimings {
+    // Querying the capture data for what to draw, see CaptureViewElement::PrepareUpdatePrimitives.
+    double query_ms = 0;
+    // Filling the batcher and the text renderer, see CaptureViewElement::UpdatePrimitives.
+    double batching_ms = 0;
+  };
+  [[nodiscard]] const std::optional<UpdatePrimitivesTimings>& GetLastUpdatePrimitivesTimings()
+      const {
+    return last_update_primitives_timings_;
+  }
+
   [[nodiscard]] orbit_gl::TextRenderer* GetTextRenderer() { return &text_renderer_static_; }
   [[nodiscard]] orbit_gl::Batcher& GetBatcher() { return batcher_; }
 
@@ -244,6 +262,7 @@ class TimeGraph : public orbit_gl::CaptureViewElement, public orbit_gl::Timeline
 
   orbit_gl::OpenGlBatcher batcher_;
   orbit_gl::PrimitiveAssembler primitive_assembler_;
+  std::optional<UpdatePrimitivesTimings> last_update_primitives_timings_;
 
   std::unique_ptr<orbit_gl::TrackContainer> track_container_;
   std::unique_ptr<orbit_gl::TimelineUi> timeline_ui_;
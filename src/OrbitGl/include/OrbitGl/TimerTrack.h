@@ -173,6 +173,21 @@ class TimerTrack : public Track {
     return width_of_single_char < width;
   }
 
+  [[nodiscard]] virtual std::vector<const orbit_client_protos::TimerInfo*>
+  GetTimersAtDepthDiscretized(uint32_t depth, uint32_t resolution, uint64_t min_tick,
+                              uint64_t max_tick) const {
+    return timer_data_->GetTimersAtDepthDiscretized(depth, resolution, min_tick, max_tick);
+  }
+  // Queries GetTimersAtDepthDiscretized for all depths, unless the result for the same query is
+  // cached and no timers were added since. This can be called from DoPrepareUpdatePrimitives.
+  // As the positions of the boxes are only computed when drawing, vertically scrolling or
+  // selecting a timer reuses the cached timers.
+  void UpdateTimersAtAllDepthsDiscretized(uint32_t resolution, uint64_t min_tick,
+                                          uint64_t max_tick);
+  // Returns GetTimersAtDepthDiscretized for all depths, see UpdateTimersAtAllDepthsDiscretized.
+  [[nodiscard]] const std::vector<std::vector<const orbit_client_protos::TimerInfo*>>&
+  GetTimersAtAllDepthsDiscretized(uint32_t resolution, uint64_t min_tick, uint64_t max_tick);
+
   [[nodiscard]] bool ShouldHaveBorder(
       const orbit_client_protos::TimerInfo* timer,
       const std::optional<orbit_statistics::HistogramSelectionRange>& range, float width) const;
@@ -185,6 +200,16 @@ class TimerTrack : public Track {
 
   orbit_client_data::TimerData* timer_data_;
   absl::flat_hash_map<uint32_t, float> width_of_single_char_cache_;
+
+ private:
+  struct DiscretizedTimers {
+    uint32_t resolution;
+    uint64_t min_tick;
+    uint64_t max_tick;
+    size_t timer_count;
+    std::vector<std::vector<const orbit_client_protos::TimerInfo*>> timers_by_depth;
+  };
+  std::optional<DiscretizedTimers> discretized_timers_cache_;
 };
 
 #endif  // ORBIT_GL_TIMER_TRACK_H_
@@ -47,7 +47,8 @@ class TrackContainer final : public CaptureViewElement {
 
   [[nodiscard]] float GetHeight() const override { return height_; };
   void SetHeight(float height) { height_ = height; }
-  [[nodiscard]] float GetVisibleTracksTotalHeight() const;
+  // As of the last layout update.
+  [[nodiscard]] float GetVisibleTracksTotalHeight() const { return visible_tracks_total_height_; }
 
   [[nodiscard]] TrackManager* GetTrackManager() { return track_manager_.get(); }
 
@@ -82,11 +83,16 @@ class TrackContainer final : public CaptureViewElement {
 
   [[nodiscard]] std::vector<CaptureViewElement*> GetAllChildren() const override;
   [[nodiscard]] std::vector<CaptureViewElement*> GetNonHiddenChildren() const override;
+  [[nodiscard]] std::vector<CaptureViewElement*> GetChildrenVisibleInViewport() const override;
 
   [[nodiscard]] bool RequestSeparateRenderGroup() const override { return true; }
 
  protected:
   void DoUpdateLayout() override;
+  // Only the tracks in the viewport are laid out, the others are laid out once they get into it.
+  [[nodiscard]] std::vector<CaptureViewElement*> GetChildrenToUpdateLayout() const override {
+    return GetChildrenVisibleInViewport();
+  }
   void DoDraw(PrimitiveAssembler& primitive_assembler, TextRenderer& text_renderer,
               const DrawContext& draw_context) override;
 
@@ -115,6 +121,15 @@ class TrackContainer final : public CaptureViewElement {
   float vertical_scrolling_offset_ = 0;
   float height_ = 0;
 
+  // The top and the bottom of each track of GetVisibleTracks(), relative to the top of the first
+  // track and without scrolling, as of the last call to UpdateTracksPosition. Both are sorted, so
+  // the tracks intersecting the viewport are found by binary search instead of visiting all tracks.
+  std::vector<float> track_tops_;
+  std::vector<float> track_bottoms_;
+  float visible_tracks_total_height_ = 0;
+  // A moving track is positioned by dragging, not by the sums above.
+  std::optional<size_t> moving_track_index_;
+
   std::unique_ptr<TrackManager> track_manager_;
 
   const orbit_client_data::CaptureData* capture_data_ = nullptr;
@@ -422,7 +422,7 @@ void HistogramWidget::UpdateData(const std::vector<uint64_t>* data, std::string
 
   if (scope_data_.has_value() && data != nullptr) {
     std::optional<orbit_statistics::Histogram> histogram =
-        orbit_statistics::BuildHistogram(*scope_data_.value().data);
+        orbit_statistics::BuildHistogramFromSortedData(*scope_data_.value().data);
     if (histogram) {
       histogram_stack_.push(std::move(*histogram));
     }
@@ -530,7 +530,7 @@ void HistogramWidget::mouseReleaseEvent(QMouseEvent* /* event*/) {
         return;
       }
 
-      auto histogram = orbit_statistics::BuildHistogram(selection);
+      auto histogram = orbit_statistics::BuildHistogramFromSortedData(selection);
       if (histogram) {
         histogram_stack_.push(std::move(*histogram));
         ranges_stack_.push({min, max});
@@ -51,6 +51,7 @@ TimeGraphLayoutWidget::TimeGraphLayoutWidget(QWidget* parent)
   AddWidgetForProperty(&draw_as_if_picking_);
   AddWidgetForProperty(&scale_);
   AddWidgetForProperty(&render_debug_layers_);
+  AddWidgetForProperty(&draw_frame_timings_);
 }
 
 float TimeGraphLayoutWidget::GetCollapseButtonSize(int indentation_level) const {
@@ -49,6 +49,8 @@ class HistogramWidget : public QWidget {
  public:
   using QWidget::QWidget;
 
+  // `data` has to be sorted in ascending order, like the durations returned by
+  // `ScopeStatsCollection::GetSortedTimerDurationsForScopeId`.
   void UpdateData(const std::vector<uint64_t>* data, std::string scope_name,
                   std::optional<ScopeId> scope_id);
 
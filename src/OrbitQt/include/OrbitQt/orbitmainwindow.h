@@ -106,6 +106,8 @@ class OrbitMainWindow final : public QMainWindow, public orbit_gl::MainWindowInt
   void SetBottomUpView(std::shared_ptr<const CallTreeView> bottom_up_view) override;
   void SetSelectionBottomUpView(
       std::shared_ptr<const CallTreeView> selection_bottom_up_view) override;
+  void SetPageFaultsBottomUpView(
+      std::shared_ptr<const CallTreeView> page_faults_bottom_up_view) override;
 
   void OpenCapture(std::string_view filepath);
   void OnCaptureCleared() override;
@@ -46,7 +46,9 @@ class OrbitTableModel : public QAbstractTableModel {
   bool IsSortingAllowed() { return GetDataView()->IsSortingAllowed(); }
   std::pair<int, Qt::SortOrder> GetDefaultSortingColumnAndOrder();
 
-  void OnTimer();
+  [[nodiscard]] orbit_data_views::DataView::TimerUpdate OnTimer();
+  // Notifies the views that the values of these rows changed. `rows` must be sorted.
+  void OnRowsChanged(absl::Span<const int> rows);
   void OnFilter(const QString& filter);
   void OnRowsSelected(absl::Span<const int> rows);
 
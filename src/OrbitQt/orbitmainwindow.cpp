@@ -388,6 +388,7 @@ void OrbitMainWindow::SetupMainWindow() {
   ui->selectionTopDownWidget->Initialize(app_.get());
   ui->bottomUpWidget->Initialize(app_.get());
   ui->selectionBottomUpWidget->Initialize(app_.get());
+  ui->pageFaultsBottomUpWidget->Initialize(app_.get());
 
   ui->MainTabWidget->tabBar()->installEventFilter(this);
   ui->RightTabWidget->tabBar()->installEventFilter(this);
@@ -619,6 +620,8 @@ void OrbitMainWindow::UpdateCaptureStateDependentWidgets() {
 
   const bool has_data = app_->HasCaptureData();
   const bool has_selection = has_data && ui->selectionReport->HasSamples();
+  const bool has_page_fault_samples =
+      has_data && app_->GetCaptureData().GetPageFaultCallstackData().GetCallstackEventsCount() > 0;
   CaptureClient::State capture_state = app_->GetCaptureState();
   const bool is_capturing = capture_state != CaptureClient::State::kStopped;
   const bool is_target_process_running = target_process_state_ == TargetProcessState::kRunning;
@@ -626,12 +629,14 @@ void OrbitMainWindow::UpdateCaptureStateDependentWidgets() {
   set_tab_enabled(ui->SymbolsTab, true);
   set_tab_enabled(ui->CaptureTab, true);
   set_tab_enabled(ui->liveTab, has_data);
-  set_tab_enabled(ui->samplingTab, has_data && !is_capturing);
+  // While capturing, the sampling report shows the live snapshot of the most sampled functions.
+  set_tab_enabled(ui->samplingTab, has_data);
   set_tab_enabled(ui->topDownTab, has_data && !is_capturing);
   set_tab_enabled(ui->bottomUpTab, has_data && !is_capturing);
   set_tab_enabled(ui->selectionSamplingTab, has_selection);
   set_tab_enabled(ui->selectionTopDownTab, has_selection);
   set_tab_enabled(ui->selectionBottomUpTab, has_selection);
+  set_tab_enabled(ui->pageFaultsBottomUpTab, has_page_fault_samples && !is_capturing);
 
   ui->actionToggle_Capture->setEnabled(
       capture_state == CaptureClient::State::kStarted ||
@@ -760,6 +765,7 @@ QTabWidget* OrbitMainWindow::FindParentTabWidget(const QWidget* widget) const {
 }
 
 OrbitMainWindow::~OrbitMainWindow() {
+  ui->pageFaultsBottomUpWidget->Deinitialize();
   ui->selectionBottomUpWidget->Deinitialize();
   ui->bottomUpWidget->Deinitialize();
   ui->selectionTopDownWidget->Deinitialize();
@@ -874,6 +880,11 @@ void OrbitMainWindow::SetSelectionBottomUpView(
   ui->selectionBottomUpWidget->SetBottomUpView(std::move(selection_bottom_up_view));
 }
 
+void OrbitMainWindow::SetPageFaultsBottomUpView(
+    std::shared_ptr<const CallTreeView> page_faults_bottom_up_view) {
+  ui->pageFaultsBottomUpWidget->SetBottomUpView(std::move(page_faults_bottom_up_view));
+}
+
 std::string OrbitMainWindow::OnGetSaveFileName(std::string_view extension) {
   QFileDialog dialog(this);
   dialog.setFileMode(QFileDialog::FileMode::AnyFile);
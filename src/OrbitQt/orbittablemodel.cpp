@@ -99,7 +99,21 @@ std::pair<int, Qt::SortOrder> OrbitTableModel::GetDefaultSortingColumnAndOrder()
   return std::make_pair(column, order);
 }
 
-void OrbitTableModel::OnTimer() { data_view_->OnTimer(); }
+orbit_data_views::DataView::TimerUpdate OrbitTableModel::OnTimer() {
+  return data_view_->OnTimer();
+}
+
+void OrbitTableModel::OnRowsChanged(absl::Span<const int> rows) {
+  const int last_column = columnCount() - 1;
+  // Emit one signal per range of consecutive rows.
+  size_t begin = 0;
+  while (begin < rows.size()) {
+    size_t end = begin + 1;
+    while (end < rows.size() && rows[end] == rows[end - 1] + 1) ++end;
+    emit dataChanged(index(rows[begin], 0), index(rows[end - 1], last_column));
+    begin = end;
+  }
+}
 
 void OrbitTableModel::OnFilter(const QString& filter) {
   data_view_->OnFilter(filter.toStdString());
@@ -133,9 +133,18 @@ void OrbitTreeView::OnFilter(const QString& filter) {
 }
 
 void OrbitTreeView::OnTimer() {
-  if (model_ != nullptr && isVisible() && !model_->GetDataView()->SkipTimer()) {
-    model_->OnTimer();
-    Refresh();
+  if (model_ == nullptr || !isVisible() || model_->GetDataView()->SkipTimer()) return;
+
+  const orbit_data_views::DataView::TimerUpdate update = model_->OnTimer();
+  switch (update.type) {
+    case orbit_data_views::DataView::TimerUpdate::Type::kNone:
+      break;
+    case orbit_data_views::DataView::TimerUpdate::Type::kRowValues:
+      model_->OnRowsChanged(update.changed_rows);
+      break;
+    case orbit_data_views::DataView::TimerUpdate::Type::kLayout:
+      Refresh();
+      break;
   }
 }
 
@@ -4,6 +4,7 @@
 
 #include "OrbitSsh/Channel.h"
 
+#include <absl/types/span.h>
 #include <libssh2.h>
 
 #include <memory>
@@ -69,6 +70,14 @@ outcome::result<std::string> Channel::ReadStdOut(int buffer_size) {
   return outcome::success(std::move(buffer));
 }
 
+outcome::result<size_t> Channel::ReadStdOutInto(absl::Span<char> buffer) {
+  const auto rc = libssh2_channel_read(raw_channel_ptr_.get(), buffer.data(), buffer.size());
+
+  if (rc < 0) return static_cast<Error>(rc);
+
+  return outcome::success(static_cast<size_t>(rc));
+}
+
 outcome::result<std::string> Channel::ReadStdErr(int buffer_size) {
   std::string buffer(buffer_size, '\0');
   const int rc = libssh2_channel_read_stderr(raw_channel_ptr_.get(), buffer.data(), buffer.size());
@@ -6,6 +6,7 @@
 
 #include <libssh2.h>
 
+#include <optional>
 #include <utility>
 
 #include "LibSsh2Utils.h"
@@ -49,6 +50,24 @@ outcome::result<std::string> SftpFile::Read(size_t max_length_in_bytes) {
   return buffer;
 }
 
+void SftpFile::Seek(uint64_t offset) { libssh2_sftp_seek64(file_ptr_.get(), offset); }
+
+outcome::result<std::optional<uint64_t>> SftpFile::GetFileSize() {
+  LIBSSH2_SFTP_ATTRIBUTES attributes{};
+  const auto result = libssh2_sftp_fstat(file_ptr_.get(), &attributes);
+
+  if (result < 0) {
+    if (result != LIBSSH2_ERROR_EAGAIN) {
+      ORBIT_ERROR("Unable to stat sftp file \"%s\": %s", filepath_,
+                  LibSsh2SessionLastError(session_->GetRawSessionPtr()).second);
+    }
+    return static_cast<Error>(result);
+  }
+
+  if ((attributes.flags & LIBSSH2_SFTP_ATTR_SIZE) == 0) return std::nullopt;
+  return attributes.filesize;
+}
+
 outcome::result<void> SftpFile::Close() {
   // There is a bug in libssh2 which lets libssh2_sftp_close_handle sometimes not complete when in
   // non-blocking mode. As a workaround we quickly switch to blocking and back.
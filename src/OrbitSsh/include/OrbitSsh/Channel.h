@@ -5,6 +5,7 @@
 #ifndef ORBIT_SSH_CHANNEL_H_
 #define ORBIT_SSH_CHANNEL_H_
 
+#include <absl/types/span.h>
 #include <libssh2.h>
 #include <stddef.h>
 
@@ -30,6 +31,10 @@ class Channel {
 
   outcome::result<std::string> ReadStdOut(int buffer_size = 0x400);
   outcome::result<std::string> ReadStdErr(int buffer_size = 0x400);
+  // Reads at most `buffer.size()` bytes from stdout into `buffer`, which avoids allocating a new
+  // buffer for every read of a large chunk. Returns the number of bytes read, zero meaning that the
+  // remote side closed the channel.
+  outcome::result<size_t> ReadStdOutInto(absl::Span<char> buffer);
 
   // Returns the accumulated number of bytes available to read from all data streams. That's usually
   // stdout and stderr but there could be more streams.
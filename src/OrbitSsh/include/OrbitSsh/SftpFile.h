@@ -10,6 +10,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -40,6 +41,11 @@ class SftpFile {
                                         FxfFlags flags, int64_t mode);
 
   outcome::result<std::string> Read(size_t max_length_in_bytes);
+  // Moves the position that the next Read starts at. This drops the data that libssh2 has already
+  // requested ahead of the previous position.
+  void Seek(uint64_t offset);
+  // Returns std::nullopt if the server doesn't report the size of the file.
+  outcome::result<std::optional<uint64_t>> GetFileSize();
   outcome::result<void> Close();
   outcome::result<size_t> Write(std::string_view data);
 
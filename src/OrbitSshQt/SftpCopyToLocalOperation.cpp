@@ -8,11 +8,16 @@
 #include <stddef.h>
 
 #include <QIODevice>
+#include <algorithm>
+#include <limits>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/StopToken.h"
+#include "OrbitSsh/Error.h"
 #include "OrbitSsh/SftpFile.h"
 #include "OrbitSshQt/Error.h"
 #include "OrbitSshQt/ScopedConnection.h"
@@ -22,6 +27,29 @@
 
 namespace orbit_ssh_qt {
 
+namespace {
+
+constexpr size_t kReadBufferMaxSize = 1 * 1024 * 1024;
+
+}  // namespace
+
+std::vector<SftpCopyToLocalOperation::Segment> SftpCopyToLocalOperation::ComputeSegments(
+    std::optional<uint64_t> file_size) {
+  // The last segment goes to the end of the file, wherever that is when it's read.
+  constexpr uint64_t kEndOfFile = std::numeric_limits<uint64_t>::max();
+  if (!file_size.has_value() || file_size.value() < kMinFileSizeForParallelReads) {
+    return {Segment{0, kEndOfFile}};
+  }
+
+  const uint64_t segment_size = (file_size.value() + kMaxParallelReads - 1) / kMaxParallelReads;
+  std::vector<Segment> segments;
+  for (size_t i = 0; i < kMaxParallelReads; ++i) {
+    segments.push_back(Segment{i * segment_size, (i + 1) * segment_size});
+  }
+  segments.back().end_offset = kEndOfFile;
+  return segments;
+}
+
 SftpCopyToLocalOperation::SftpCopyToLocalOperation(Session* session, SftpChannel* channel,
                                                    orbit_base::StopToken stop_token)
     : session_(session), channel_(channel), stop_token_(std::move(stop_token)) {
@@ -46,6 +74,8 @@ void SftpCopyToLocalOperation::Stop() {
       SetState(State::kCloseEventConnections);
       break;
     }
+    case State::kReadRemoteFileSize:
+    case State::kOpenAdditionalRemoteFiles:
     case State::kOpenLocalFile: {
       SetState(State::kCloseRemoteFile);
       break;
@@ -71,6 +101,8 @@ outcome::result<void> SftpCopyToLocalOperation::shutdown() {
   switch (CurrentState()) {
     case State::kInitialized:
     case State::kOpenRemoteFile:
+    case State::kReadRemoteFileSize:
+    case State::kOpenAdditionalRemoteFiles:
     case State::kOpenLocalFile:
     case State::kStarted:
       ORBIT_UNREACHABLE();
@@ -92,7 +124,10 @@ outcome::result<void> SftpCopyToLocalOperation::shutdown() {
       ABSL_FALLTHROUGH_INTENDED;
     }
     case State::kCloseRemoteFile: {
-      OUTCOME_TRY(sftp_file_->Close());
+      while (!sftp_files_.empty()) {
+        OUTCOME_TRY(sftp_files_.back().Close());
+        sftp_files_.pop_back();
+      }
       SetState(State::kCloseEventConnections);
       ABSL_FALLTHROUGH_INTENDED;
     }
@@ -114,23 +149,44 @@ outcome::result<void> SftpCopyToLocalOperation::shutdown() {
 outcome::result<void> SftpCopyToLocalOperation::run() {
   ORBIT_CHECK(CurrentState() == State::kStarted);
 
-  constexpr size_t kReadBufferMaxSize = 1 * 1024 * 1024;
-
   while (true) {
     if (stop_token_.IsStopRequested()) {
       SetState(State::kCloseAndDeletePartialFile);
       break;
     }
 
-    OUTCOME_TRY(auto&& read_buffer, sftp_file_->Read(kReadBufferMaxSize));
-    if (read_buffer.empty()) {
-      // This is end of file
+    // Reads from every segment that has data available, so that the segments that wait for data
+    // don't hold up the others.
+    bool has_read_data = false;
+    bool has_remaining_segments = false;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+      Segment& segment = segments_[i];
+      if (segment.next_offset >= segment.end_offset) continue;
+      has_remaining_segments = true;
 
+      outcome::result<std::string> read_result = sftp_files_[i].Read(kReadBufferMaxSize);
+      if (orbit_ssh::ShouldITryAgain(read_result)) continue;
+      OUTCOME_TRY(auto&& read_buffer, read_result);
+      if (read_buffer.empty()) {
+        // This is end of file
+        segment.end_offset = segment.next_offset;
+        continue;
+      }
+
+      // libssh2 reads ahead, so the read can go past the segment, into the next one.
+      const size_t size =
+          std::min<uint64_t>(read_buffer.size(), segment.end_offset - segment.next_offset);
+      local_file_.seek(static_cast<qint64>(segment.next_offset));
+      local_file_.write(read_buffer.data(), static_cast<qint64>(size));
+      segment.next_offset += size;
+      has_read_data = true;
+    }
+
+    if (!has_remaining_segments) {
       SetState(State::kCloseLocalFile);
       break;
     }
-
-    local_file_.write(read_buffer.data(), read_buffer.size());
+    if (!has_read_data) return orbit_ssh::Error::kEagain;
   }
   return outcome::success();
 }
@@ -148,7 +204,25 @@ outcome::result<void> SftpCopyToLocalOperation::startup() {
                   orbit_ssh::SftpFile::Open(session_->GetRawSession(), channel_->GetRawSftp(),
                                             source_.string(), orbit_ssh::FxfFlags::kRead,
                                             0 /* mode - not applicable for kRead */));
-      sftp_file_ = std::move(sftp_file);
+      sftp_files_.push_back(std::move(sftp_file));
+      SetState(State::kReadRemoteFileSize);
+      ABSL_FALLTHROUGH_INTENDED;
+    }
+    case State::kReadRemoteFileSize: {
+      OUTCOME_TRY(std::optional<uint64_t> file_size, sftp_files_.front().GetFileSize());
+      segments_ = ComputeSegments(file_size);
+      SetState(State::kOpenAdditionalRemoteFiles);
+      ABSL_FALLTHROUGH_INTENDED;
+    }
+    case State::kOpenAdditionalRemoteFiles: {
+      while (sftp_files_.size() < segments_.size()) {
+        OUTCOME_TRY(auto&& sftp_file,
+                    orbit_ssh::SftpFile::Open(session_->GetRawSession(), channel_->GetRawSftp(),
+                                              source_.string(), orbit_ssh::FxfFlags::kRead,
+                                              0 /* mode - not applicable for kRead */));
+        sftp_file.Seek(segments_[sftp_files_.size()].next_offset);
+        sftp_files_.push_back(std::move(sftp_file));
+      }
       SetState(State::kOpenLocalFile);
       ABSL_FALLTHROUGH_INTENDED;
     }
@@ -181,7 +255,7 @@ void SftpCopyToLocalOperation::SetError(std::error_code e) {
 
   StateMachineHelper::SetError(e);
 
-  sftp_file_ = std::nullopt;
+  sftp_files_.clear();
   local_file_.close();
 }
 
@@ -5,11 +5,15 @@
 #include "OrbitSshQt/Tunnel.h"
 
 #include <absl/base/attributes.h>
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+#include <absl/types/span.h>
 #include <stddef.h>
 
 #include <QByteArray>
 #include <QHostAddress>
 #include <QTimer>
+#include <memory>
 #include <string_view>
 #include <tuple>
 #include <utility>
@@ -42,6 +46,14 @@ static void deleteByEventLoop(P* parent, std::optional<T>* opt) {
 }
 
 namespace orbit_ssh_qt {
+namespace {
+// libssh2 tops up the receive window of a channel to its initial size (2 MiB) plus the size of the
+// pending read. So the size of the reads bounds how much data the remote side can send before it
+// has to wait for a window adjustment, which limits the throughput on links with a large
+// bandwidth-delay product.
+constexpr size_t kReadChunkSize = 16 * 1024 * 1024;
+}  // namespace
+
 Tunnel::Tunnel(Session* session, std::string remote_host, uint16_t remote_port, QObject* parent)
     : StateMachineHelper(parent),
       session_(session),
@@ -122,6 +134,7 @@ outcome::result<void> Tunnel::startup() {
       });
 
       SetState(State::kServerListening);
+      start_time_ = absl::Now();
       emit tunnelOpened(GetListenPort());
       break;
     }
@@ -175,6 +188,7 @@ outcome::result<void> Tunnel::shutdown() {
     case State::kWaitRemoteClosed: {
       OUTCOME_TRY(channel_->WaitClosed());
       SetState(State::kStopped);
+      LogThroughput();
       data_event_connection_ = std::nullopt;
       about_to_shutdown_connection_ = std::nullopt;
       channel_ = std::nullopt;
@@ -191,9 +205,9 @@ outcome::result<void> Tunnel::shutdown() {
 
 outcome::result<void> Tunnel::readFromChannel() {
   ORBIT_SCOPE_FUNCTION;
+  if (read_chunk_ == nullptr) read_chunk_ = std::make_unique<char[]>(kReadChunkSize);
   while (true) {
-    constexpr size_t kChunkSize = 1024 * 1024;
-    const auto result = channel_->ReadStdOut(kChunkSize);
+    const auto result = channel_->ReadStdOutInto(absl::MakeSpan(read_chunk_.get(), kReadChunkSize));
 
     if (!result && !orbit_ssh::ShouldITryAgain(result)) {
       return outcome::failure(result.error());
@@ -203,12 +217,13 @@ outcome::result<void> Tunnel::readFromChannel() {
       HandleEagain();
       break;
     }
-    if (result.value().empty()) {
+    if (result.value() == 0) {
       // Empty result means remote socket was closed.
       return Error::kRemoteSocketClosed;
     }
-    ORBIT_UINT64("readFromChannel bytes read", result.value().size());
-    read_buffer_.append(result.value());
+    ORBIT_UINT64("readFromChannel bytes read", result.value());
+    read_buffer_.append(read_chunk_.get(), result.value());
+    bytes_read_from_channel_ += result.value();
   }
 
   if ((local_socket_ != nullptr) && !read_buffer_.empty()) {
@@ -227,14 +242,30 @@ outcome::result<void> Tunnel::readFromChannel() {
 
 outcome::result<void> Tunnel::writeToChannel() {
   ORBIT_SCOPE_FUNCTION;
-  if (!write_buffer_.empty()) {
-    const std::string_view buffer_view{write_buffer_.data(), write_buffer_.size()};
-    OUTCOME_TRY(auto&& bytes_written, channel_->Write(buffer_view));
-    ORBIT_CHECK(static_cast<size_t>(bytes_written) <= write_buffer_.size());
-    write_buffer_.erase(write_buffer_.begin(), write_buffer_.begin() + bytes_written);
-    ORBIT_UINT64("writeToChannel bytes written", bytes_written);
+  // libssh2 sends at most one packet per write, so keep writing until the buffer is empty or the
+  // send window of the channel is exhausted. Erasing the written bytes only once at the end avoids
+  // moving the rest of the buffer after every packet.
+  size_t total_bytes_written = 0;
+  outcome::result<void> result = outcome::success();
+  while (total_bytes_written < write_buffer_.size()) {
+    const std::string_view buffer_view{write_buffer_.data() + total_bytes_written,
+                                       write_buffer_.size() - total_bytes_written};
+    const auto bytes_written = channel_->Write(buffer_view);
+    if (!bytes_written) {
+      result = outcome::failure(bytes_written.error());
+      break;
+    }
+    ORBIT_CHECK(static_cast<size_t>(bytes_written.value()) <= buffer_view.size());
+    if (bytes_written.value() == 0) break;
+    total_bytes_written += bytes_written.value();
   }
-  return outcome::success();
+
+  if (total_bytes_written > 0) {
+    write_buffer_.erase(0, total_bytes_written);
+    bytes_written_to_channel_ += total_bytes_written;
+    ORBIT_UINT64("writeToChannel bytes written", total_bytes_written);
+  }
+  return result;
 }
 
 outcome::result<void> Tunnel::run() {
@@ -244,6 +275,7 @@ outcome::result<void> Tunnel::run() {
 }
 
 void Tunnel::SetError(std::error_code e) {
+  LogThroughput();
   data_event_connection_ = std::nullopt;
   about_to_shutdown_connection_ = std::nullopt;
   StateMachineHelper::SetError(e);
@@ -282,4 +314,19 @@ void Tunnel::HandleEagain() {
   }
 }
 
+void Tunnel::LogThroughput() const {
+  if (start_time_ == absl::InfinitePast()) return;
+
+  const double duration_s = absl::ToDoubleSeconds(absl::Now() - start_time_);
+  if (duration_s <= 0.0) return;
+  constexpr double kBytesPerMb = 1024.0 * 1024.0;
+  ORBIT_LOG(
+      "Tunnel to %s:%u was open for %.1f s, read %u bytes from the channel (%.2f MB/s) and "
+      "wrote %u bytes to it (%.2f MB/s)",
+      remote_host_, remote_port_, duration_s, bytes_read_from_channel_,
+      static_cast<double>(bytes_read_from_channel_) / kBytesPerMb / duration_s,
+      bytes_written_to_channel_,
+      static_cast<double>(bytes_written_to_channel_) / kBytesPerMb / duration_s);
+}
+
 }  // namespace orbit_ssh_qt
@@ -150,4 +150,46 @@ TEST_F(SshTunnelTest, ReadAndWrite) {
   }
 }
 
+TEST_F(SshTunnelTest, ReadAndWriteMessageLargerThanWindows) {
+  orbit_ssh_qt::Tunnel tunnel{GetSession(), "127.0.0.1", GetEchoServerPort()};
+  std::ignore = tunnel.Start();
+
+  if (!tunnel.IsStarted()) {
+    QSignalSpy started_signal{&tunnel, &orbit_ssh_qt::Tunnel::started};
+    EXPECT_TRUE(started_signal.wait());
+  }
+
+  QTcpSocket socket{};
+  socket.connectToHost("127.0.0.1", tunnel.GetListenPort());
+  ASSERT_TRUE(socket.waitForConnected(5000 /* ms */));
+
+  // Larger than the packets, the send window and the read chunks, so that the data needs many
+  // writes to and reads from the channel in each direction.
+  constexpr size_t kSize = 20 * 1024 * 1024;
+  QByteArray input(kSize, '\0');
+  for (size_t i = 0; i < kSize; ++i) {
+    input[static_cast<int>(i)] = static_cast<char>(i % 251);
+  }
+  socket.write(input);
+
+  QByteArray output;
+  ASSERT_TRUE(QTest::qWaitFor(
+      [&socket, &output]() {
+        output.append(socket.readAll());
+        return static_cast<size_t>(output.size()) >= kSize;
+      },
+      60'000 /* ms */));
+
+  EXPECT_TRUE(output == input);
+  EXPECT_EQ(tunnel.GetBytesWrittenToChannel(), kSize);
+  EXPECT_EQ(tunnel.GetBytesReadFromChannel(), kSize);
+
+  std::ignore = tunnel.Stop();
+
+  if (!tunnel.IsStopped()) {
+    QSignalSpy stopped_signal{&tunnel, &orbit_ssh_qt::Tunnel::stopped};
+    EXPECT_TRUE(stopped_signal.wait());
+  }
+}
+
 }  // namespace orbit_ssh_qt
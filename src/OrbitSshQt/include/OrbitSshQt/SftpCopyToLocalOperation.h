@@ -5,6 +5,9 @@
 #ifndef ORBIT_SSH_QT_SFTP_COPY_TO_LOCAL_OPERATION_H_
 #define ORBIT_SSH_QT_SFTP_COPY_TO_LOCAL_OPERATION_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <QFile>
 #include <QObject>
 #include <QPointer>
@@ -12,6 +15,7 @@
 #include <filesystem>
 #include <optional>
 #include <system_error>
+#include <vector>
 
 #include "OrbitBase/Result.h"
 #include "OrbitBase/StopToken.h"
@@ -26,6 +30,8 @@ namespace details {
 enum class SftpCopyToLocalOperationState {
   kInitialized,
   kOpenRemoteFile,
+  kReadRemoteFileSize,
+  kOpenAdditionalRemoteFiles,
   kOpenLocalFile,
   kStarted,  // This is the running state, where the data transfer happens
   kStopping,
@@ -43,6 +49,11 @@ enum class SftpCopyToLocalOperationState {
   subsystem. It needs an established SftpChannel for operation.
 
   This operation implements remote -> local copying.
+
+  Large files are split into kMaxParallelReads segments, which are read through separate file
+  handles. libssh2 keeps read requests in flight for each handle, so several of them are
+  outstanding at any time, and the data is written to the local file at the offsets of the
+  segments as it arrives.
 */
 class SftpCopyToLocalOperation
     : public StateMachineHelper<SftpCopyToLocalOperation, details::SftpCopyToLocalOperationState> {
@@ -50,6 +61,9 @@ class SftpCopyToLocalOperation
   friend StateMachineHelper;
 
  public:
+  static constexpr size_t kMaxParallelReads = 4;
+  static constexpr uint64_t kMinFileSizeForParallelReads = 16 * 1024 * 1024;
+
   explicit SftpCopyToLocalOperation(Session* session, SftpChannel* channel,
                                     orbit_base::StopToken stop_token);
 
@@ -69,8 +83,15 @@ class SftpCopyToLocalOperation
   std::optional<ScopedConnection> data_event_connection_;
   std::optional<ScopedConnection> about_to_shutdown_connection_;
 
+  struct Segment {
+    uint64_t next_offset;
+    uint64_t end_offset;
+  };
+
   QPointer<SftpChannel> channel_;
-  std::optional<orbit_ssh::SftpFile> sftp_file_;
+  // The segment at an index is read through the file at the same index.
+  std::vector<orbit_ssh::SftpFile> sftp_files_;
+  std::vector<Segment> segments_;
   QFile local_file_;
 
   std::filesystem::path source_;
@@ -78,6 +99,8 @@ class SftpCopyToLocalOperation
 
   orbit_base::StopToken stop_token_;
 
+  [[nodiscard]] static std::vector<Segment> ComputeSegments(std::optional<uint64_t> file_size);
+
   void HandleChannelShutdown();
   void HandleEagain();
 
@@ -5,6 +5,7 @@
 #ifndef ORBIT_SSH_QT_TUNNEL_H_
 #define ORBIT_SSH_QT_TUNNEL_H_
 
+#include <absl/time/time.h>
 #include <stdint.h>
 
 #include <QObject>
@@ -13,6 +14,7 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <deque>
+#include <memory>
 #include <optional>
 #include <string>
 #include <system_error>
@@ -52,6 +54,9 @@ enum class TunnelState {
   tunnelOpen(uint16_t) signal or the GetListenPort() member function.
 
   Tunnel needs a open and running Session to work.
+
+  The number of bytes transferred in each direction and the achieved throughput
+  are logged when the tunnel stops.
 */
 class Tunnel : public StateMachineHelper<Tunnel, details::TunnelState> {
   Q_OBJECT
@@ -67,6 +72,8 @@ class Tunnel : public StateMachineHelper<Tunnel, details::TunnelState> {
   [[nodiscard]] uint16_t GetListenPort() const {
     return local_server_ ? local_server_->serverPort() : 0;
   }
+  [[nodiscard]] uint64_t GetBytesReadFromChannel() const { return bytes_read_from_channel_; }
+  [[nodiscard]] uint64_t GetBytesWrittenToChannel() const { return bytes_written_to_channel_; }
 
  signals:
   void tunnelOpened(int listen_port);
@@ -89,6 +96,7 @@ class Tunnel : public StateMachineHelper<Tunnel, details::TunnelState> {
   void HandleSessionShutdown();
   void HandleIncomingDataLocalSocket();
   void HandleEagain();
+  void LogThroughput() const;
 
   using StateMachineHelper::SetError;
   void SetError(std::error_code);
@@ -98,6 +106,12 @@ class Tunnel : public StateMachineHelper<Tunnel, details::TunnelState> {
   QPointer<QTcpSocket> local_socket_;
   std::string write_buffer_;
   std::string read_buffer_;
+  // Allocated once, as reading large chunks is what keeps the receive window of the channel large.
+  std::unique_ptr<char[]> read_chunk_;
+
+  absl::Time start_time_ = absl::InfinitePast();
+  uint64_t bytes_read_from_channel_ = 0;
+  uint64_t bytes_written_to_channel_ = 0;
 
   std::optional<ScopedConnection> data_event_connection_;
   std::optional<ScopedConnection> about_to_shutdown_connection_;
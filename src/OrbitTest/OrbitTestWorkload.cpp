@@ -0,0 +1,207 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/flags/flag.h>
+#include <absl/flags/parse.h>
+#include <absl/flags/usage.h>
+#include <absl/strings/str_format.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ApiInterface/Orbit.h"
+#include "OrbitBase/Attributes.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ThreadUtils.h"
+
+ORBIT_API_INSTANTIATE;
+
+ABSL_FLAG(uint32_t, threads, 4, "Number of worker threads");
+ABSL_FLAG(uint32_t, depth, 10,
+          "Depth of the callstack of the worker threads while they run the workload");
+ABSL_FLAG(uint32_t, calls_per_second, 1000,
+          "Calls of the function InstrumentedFunction per second and per thread");
+ABSL_FLAG(uint32_t, scopes_per_second, 1000, "ORBIT_SCOPEs per second and per thread");
+ABSL_FLAG(uint32_t, ints_per_second, 100, "ORBIT_INTs per second and per thread");
+ABSL_FLAG(uint32_t, allocations_per_second, 0,
+          "Heap allocations, whose pages are all touched, per second and per thread");
+ABSL_FLAG(uint32_t, allocation_size, 64 * 1024,
+          "Maximum size in bytes of the allocations, the actual size is random");
+ABSL_FLAG(uint32_t, context_switches_per_second, 100,
+          "Voluntary context switches per second and per thread, by sleeping for 1 us");
+ABSL_FLAG(uint32_t, seed, 0, "Seed of the pseudo-random values, so that runs are reproducible");
+ABSL_FLAG(uint32_t, duration_s, 0,
+          "Run for this many seconds (0: until a character is read from the standard input)");
+
+namespace {
+
+std::atomic<bool> exit_requested = false;
+
+enum Activity : size_t {
+  kCall = 0,
+  kScope,
+  kInt,
+  kAllocation,
+  kContextSwitch,
+  kActivityCount,
+};
+
+constexpr std::array<const char*, kActivityCount> kActivityNames = {
+    "calls", "scopes", "ints", "allocations", "context switches"};
+
+// Aligned to avoid false sharing between the threads.
+struct alignas(64) WorkerStats {
+  std::array<uint64_t, kActivityCount> counts{};
+};
+
+// The statements with side effects keep the compiler from optimizing the functions away.
+std::atomic<uint64_t> sink = 0;
+
+void ORBIT_NOINLINE InstrumentedFunction() { sink.fetch_add(1, std::memory_order_relaxed); }
+
+void ORBIT_NOINLINE ScopedFunction() {
+  ORBIT_SCOPE("OrbitTestWorkload scope");
+  sink.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ORBIT_NOINLINE AllocateAndTouch(size_t size) {
+  auto buffer = std::make_unique<char[]>(size);
+  // Touching every byte causes the page faults of the allocation.
+  memset(buffer.get(), 1, size);
+  sink.fetch_add(buffer[size - 1], std::memory_order_relaxed);
+}
+
+// Each activity of a worker thread is performed periodically. Between two activities the thread
+// busy-waits instead of sleeping, so that the only voluntary context switches are the requested
+// ones, and so that the callstacks sampled on the thread have the requested depth.
+void RunWorkload(uint32_t thread_index, WorkerStats* stats) {
+  using Clock = std::chrono::steady_clock;
+  const std::array<uint32_t, kActivityCount> rates = {
+      absl::GetFlag(FLAGS_calls_per_second), absl::GetFlag(FLAGS_scopes_per_second),
+      absl::GetFlag(FLAGS_ints_per_second), absl::GetFlag(FLAGS_allocations_per_second),
+      absl::GetFlag(FLAGS_context_switches_per_second)};
+  const uint32_t max_allocation_size = std::max<uint32_t>(absl::GetFlag(FLAGS_allocation_size), 1);
+
+  // Each thread has its own generator, seeded from the seed and from the index of the thread, so
+  // that the values don't depend on how the threads are scheduled.
+  std::mt19937_64 generator{absl::GetFlag(FLAGS_seed) * 1'000'003ULL + thread_index};
+  std::uniform_int_distribution<uint32_t> allocation_size_distribution{1, max_allocation_size};
+  // [[maybe_unused]] prevents "unused variable" compilation error if ORBIT_API_ENABLED is set to 0.
+  [[maybe_unused]] std::uniform_int_distribution<int> int_distribution{0, 100};
+
+  // The first occurrence of each activity is shifted by a random phase, so that the threads don't
+  // all perform the same activity at the same time.
+  std::array<Clock::duration, kActivityCount> periods{};
+  std::array<Clock::time_point, kActivityCount> next_times{};
+  const Clock::time_point start_time = Clock::now();
+  for (size_t activity = 0; activity < kActivityCount; ++activity) {
+    if (rates[activity] == 0) {
+      next_times[activity] = Clock::time_point::max();
+      continue;
+    }
+    periods[activity] = std::chrono::nanoseconds{1'000'000'000 / rates[activity]};
+    std::uniform_int_distribution<Clock::rep> phase_distribution{0, periods[activity].count()};
+    next_times[activity] = start_time + Clock::duration{phase_distribution(generator)};
+  }
+
+  while (!exit_requested) {
+    const Clock::time_point now = Clock::now();
+    for (size_t activity = 0; activity < kActivityCount; ++activity) {
+      if (now < next_times[activity]) continue;
+      switch (activity) {
+        case kCall:
+          InstrumentedFunction();
+          break;
+        case kScope:
+          ScopedFunction();
+          break;
+        case kInt:
+          ORBIT_INT("OrbitTestWorkload int", int_distribution(generator));
+          break;
+        case kAllocation:
+          AllocateAndTouch(allocation_size_distribution(generator));
+          break;
+        case kContextSwitch:
+          std::this_thread::sleep_for(std::chrono::microseconds{1});
+          break;
+        default:
+          ORBIT_UNREACHABLE();
+      }
+      ++stats->counts[activity];
+      next_times[activity] += periods[activity];
+      // Don't try to catch up with a burst when falling behind, e.g., after being preempted.
+      if (next_times[activity] < now) next_times[activity] = now + periods[activity];
+    }
+  }
+}
+
+void ORBIT_NOINLINE RunWorkloadAtDepth(uint32_t depth, uint32_t thread_index,
+                                       WorkerStats* stats) {
+  if (depth <= 1) {
+    RunWorkload(thread_index, stats);
+    return;
+  }
+  RunWorkloadAtDepth(depth - 1, thread_index, stats);
+  // Prevents the recursive call from becoming a tail call, which would not create a new frame.
+  sink.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// OrbitTestWorkload is a synthetic workload for benchmarking the capture pipeline, e.g., with
+// OrbitFakeClient. All the knobs are flags, with rates per thread, so that a specific part of the
+// pipeline can be stressed: the instrumentation with the calls of InstrumentedFunction, the Orbit
+// API with the scopes and the ints (capture with the Orbit API enabled), memory tracing and page
+// fault sampling with the allocations, and scheduling and callstack sampling with the context
+// switches and the depth.
+int main(int argc, char* argv[]) {
+  absl::SetProgramUsageMessage("Synthetic workload for benchmarking Orbit");
+  absl::ParseCommandLine(argc, argv);
+
+  const uint32_t thread_count = absl::GetFlag(FLAGS_threads);
+  const uint32_t depth = absl::GetFlag(FLAGS_depth);
+  ORBIT_LOG("Starting OrbitTestWorkload with %u threads at depth %u", thread_count, depth);
+
+  std::vector<WorkerStats> stats(thread_count);
+  std::vector<std::thread> threads;
+  for (uint32_t thread_index = 0; thread_index < thread_count; ++thread_index) {
+    threads.emplace_back([thread_index, depth, &stats] {
+      orbit_base::SetCurrentThreadName(absl::StrFormat("Workload_%u", thread_index).c_str());
+      RunWorkloadAtDepth(depth, thread_index, &stats[thread_index]);
+    });
+  }
+
+  const uint32_t duration_s = absl::GetFlag(FLAGS_duration_s);
+  const auto start_time = std::chrono::steady_clock::now();
+  if (duration_s == 0) {
+    getchar();
+  } else {
+    std::this_thread::sleep_for(std::chrono::seconds{duration_s});
+  }
+  exit_requested = true;
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Report the achieved rates, which are lower than the requested ones when the threads can't
+  // keep up, e.g., with more threads than cores.
+  const double elapsed_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  for (size_t activity = 0; activity < kActivityCount; ++activity) {
+    uint64_t total = 0;
+    for (const WorkerStats& worker_stats : stats) total += worker_stats.counts[activity];
+    ORBIT_LOG("%s: %u (%.1f per second and per thread)", kActivityNames[activity], total,
+              static_cast<double>(total) / elapsed_s / std::max<uint32_t>(thread_count, 1));
+  }
+  return 0;
+}
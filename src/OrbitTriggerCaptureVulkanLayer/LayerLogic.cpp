@@ -4,12 +4,14 @@
 
 #include "LayerLogic.h"
 
+#include <stddef.h>
 #include <unistd.h>
 
 #include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <optional>
 #include <ratio>
 #include <string>
 #include <vector>
@@ -21,6 +23,9 @@
 namespace {
 constexpr const int kCaptureClientResultSuccess = 1;
 constexpr uint16_t kGrpcPort = 44767;
+// About ten seconds at 60 frames per second.
+constexpr size_t kFrameTimeWindowSize = 600;
+constexpr std::chrono::seconds kStartCaptureRetryInterval{1};
 }  // namespace
 
 void LayerLogic::StartOrbitCaptureService() {
@@ -78,28 +83,37 @@ void LayerLogic::Destroy() {
     data_initialized_ = false;
     orbit_capture_running_ = false;
     skip_logic_call_ = true;
+    trigger_time_.reset();
   }
 }
 
 // QueuePresentKHR is called once per frame so we can calculate the time per frame. When this value
 // is higher than a certain threshold, an Orbit capture is started and runs during a certain period
-// of time; after which is stopped and saved.
+// of time; after which is stopped and saved. In flight recorder mode, the capture is already
+// running and is stopped and saved shortly after such a frame instead.
 void LayerLogic::ProcessQueuePresentKHR() {
   std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
+  const bool flight_recorder_mode = layer_options_.GetFlightRecorderMilliseconds() > 0;
   // Ignore logic on the first call because times are not initialized. Also skipped right after a
   // capture has been stopped
   if (skip_logic_call_) {
     skip_logic_call_ = false;
     last_frame_time_ = current_time;
+    // A flight recorder capture needs to be running before the slow frame it should contain.
+    if (flight_recorder_mode && !orbit_capture_running_) {
+      RunCapture();
+    }
     return;
   }
 
-  if (!orbit_capture_running_) {
-    auto frame_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
-        current_time - last_frame_time_);
-    if (std::isgreater(frame_time.count(), layer_options_.GetFrameTimeThresholdMilliseconds())) {
+  const double frame_time_ms =
+      std::chrono::duration<double, std::milli>(current_time - last_frame_time_).count();
+  if (flight_recorder_mode) {
+    ProcessFrameInFlightRecorderMode(current_time, frame_time_ms);
+  } else if (!orbit_capture_running_) {
+    if (IsSlowFrame(frame_time_ms)) {
       ORBIT_LOG("Time frame is %fms and exceeds the %fms threshold; starting capture",
-                frame_time.count(), layer_options_.GetFrameTimeThresholdMilliseconds());
+                frame_time_ms, layer_options_.GetFrameTimeThresholdMilliseconds());
       RunCapture();
     }
   } else {
@@ -113,10 +127,76 @@ void LayerLogic::ProcessQueuePresentKHR() {
     }
   }
 
+  RecordFrameTime(frame_time_ms);
   last_frame_time_ = current_time;
 }
 
+void LayerLogic::ProcessFrameInFlightRecorderMode(
+    std::chrono::steady_clock::time_point current_time, double frame_time_ms) {
+  if (!orbit_capture_running_) {
+    // Starting the capture failed, e.g., because the service is not ready yet.
+    if (current_time - last_start_capture_attempt_time_ >= kStartCaptureRetryInterval) {
+      RunCapture();
+    }
+    return;
+  }
+
+  const std::chrono::milliseconds post_trigger_duration{
+      layer_options_.GetPostTriggerCaptureMilliseconds()};
+  if (!trigger_time_.has_value()) {
+    // Before the capture has been running for the rest of the window, it would not contain the
+    // frames leading up to the slow one.
+    const std::chrono::milliseconds pre_trigger_duration{
+        layer_options_.GetFlightRecorderMilliseconds() -
+        layer_options_.GetPostTriggerCaptureMilliseconds()};
+    if (current_time - capture_started_time_ < pre_trigger_duration ||
+        !IsSlowFrame(frame_time_ms)) {
+      return;
+    }
+    ORBIT_LOG("Time frame is %fms and exceeds the threshold; stopping capture in %dms",
+              frame_time_ms, post_trigger_duration.count());
+    trigger_time_ = current_time;
+  }
+
+  if (current_time - trigger_time_.value() >= post_trigger_duration) {
+    ORBIT_LOG("Stopping capture to save the frames around the slow one");
+    StopCapture();
+  }
+}
+
+bool LayerLogic::IsSlowFrame(double frame_time_ms) {
+  if (!std::isgreater(frame_time_ms, layer_options_.GetFrameTimeThresholdMilliseconds())) {
+    return false;
+  }
+  const double percentile = layer_options_.GetFrameTimePercentile();
+  if (percentile <= 0) {
+    return true;
+  }
+
+  // The percentile is only computed for the rare frames above the threshold, so that on all other
+  // frames the rolling measurement only costs storing the frame time.
+  if (recent_frame_times_ms_.size() < kFrameTimeWindowSize) {
+    return false;
+  }
+  std::vector<double> frame_times_ms = recent_frame_times_ms_;
+  auto percentile_it =
+      frame_times_ms.begin() +
+      static_cast<ptrdiff_t>(percentile / 100 * static_cast<double>(frame_times_ms.size() - 1));
+  std::nth_element(frame_times_ms.begin(), percentile_it, frame_times_ms.end());
+  return std::isgreater(frame_time_ms, *percentile_it);
+}
+
+void LayerLogic::RecordFrameTime(double frame_time_ms) {
+  if (recent_frame_times_ms_.size() < kFrameTimeWindowSize) {
+    recent_frame_times_ms_.push_back(frame_time_ms);
+    return;
+  }
+  recent_frame_times_ms_[next_frame_time_index_] = frame_time_ms;
+  next_frame_time_index_ = (next_frame_time_index_ + 1) % kFrameTimeWindowSize;
+}
+
 void LayerLogic::RunCapture() {
+  last_start_capture_attempt_time_ = std::chrono::steady_clock::now();
   int capture_started = ggp_capture_client_->StartCapture();
   if (capture_started == kCaptureClientResultSuccess) {
     capture_started_time_ = std::chrono::steady_clock::now();
@@ -130,5 +210,6 @@ void LayerLogic::StopCapture() {
     orbit_capture_running_ = false;
     // The frame time is expected to be longer the next call so we skip the check
     skip_logic_call_ = true;
+    trigger_time_.reset();
   }
 }
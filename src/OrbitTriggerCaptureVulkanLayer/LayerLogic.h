@@ -5,17 +5,26 @@
 #ifndef ORBIT_TRIGGER_CAPTURE_VULKAN_LAYER_LAYER_LOGIC_H_
 #define ORBIT_TRIGGER_CAPTURE_VULKAN_LAYER_LAYER_LOGIC_H_
 
+#include <stddef.h>
+
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "LayerOptions.h"
 #include "OrbitCaptureGgpClient/OrbitCaptureGgpClient.h"
 #include "OrbitTriggerCaptureVulkanLayer/layer_config.pb.h"
 
 // Contains the logic of the OrbitTriggerCaptureVulkanLayer to run Orbit captures automatically when
-// the time per frame is higher than a certain threshold. It also instantiates the classes and
-// variables needed for this so the layer itself is transparent to it.
+// the time per frame is higher than a certain threshold, and optionally higher than a percentile of
+// the recent frame times. It also instantiates the classes and variables needed for this so the
+// layer itself is transparent to it.
+//
+// In flight recorder mode, a capture runs all the time but only keeps its most recent events. After
+// a slow frame, it keeps running for a little longer and is then stopped, so that only the frames
+// around the slow one are saved, and a new capture is started.
 class LayerLogic {
  public:
   LayerLogic() : data_initialized_{false}, orbit_capture_running_{false}, skip_logic_call_{true} {}
@@ -31,11 +40,21 @@ class LayerLogic {
   std::unique_ptr<CaptureClientGgpClient> ggp_capture_client_;
   std::chrono::steady_clock::time_point last_frame_time_;
   std::chrono::steady_clock::time_point capture_started_time_;
+  std::chrono::steady_clock::time_point last_start_capture_attempt_time_;
+  std::optional<std::chrono::steady_clock::time_point> trigger_time_;
   LayerOptions layer_options_;
 
+  // Ring buffer with the frame times in milliseconds of the most recent frames.
+  std::vector<double> recent_frame_times_ms_;
+  size_t next_frame_time_index_ = 0;
+
   void StartOrbitCaptureService();
   void RunCapture();
   void StopCapture();
+  void ProcessFrameInFlightRecorderMode(std::chrono::steady_clock::time_point current_time,
+                                        double frame_time_ms);
+  [[nodiscard]] bool IsSlowFrame(double frame_time_ms);
+  void RecordFrameTime(double frame_time_ms);
 };
 
 #endif  // ORBIT_TRIGGER_CAPTURE_VULKAN_LAYER_LAYER_LOGIC_H_
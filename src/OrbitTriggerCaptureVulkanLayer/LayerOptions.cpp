@@ -70,6 +70,32 @@ uint32_t LayerOptions::GetCaptureLengthSeconds() {
   return kCaptureLengthSecondsDefault;
 }
 
+double LayerOptions::GetFrameTimePercentile() {
+  if (layer_config_.has_layer_options() &&
+      layer_config_.layer_options().frame_time_percentile() > 0 &&
+      layer_config_.layer_options().frame_time_percentile() < 100) {
+    return layer_config_.layer_options().frame_time_percentile();
+  }
+  return 0;
+}
+
+uint64_t LayerOptions::GetFlightRecorderMilliseconds() {
+  if (layer_config_.has_capture_service_arguments()) {
+    return layer_config_.capture_service_arguments().flight_recorder_ms();
+  }
+  return 0;
+}
+
+uint64_t LayerOptions::GetPostTriggerCaptureMilliseconds() {
+  const uint64_t flight_recorder_ms = GetFlightRecorderMilliseconds();
+  if (layer_config_.has_layer_options() &&
+      layer_config_.layer_options().post_trigger_capture_ms() > 0) {
+    return std::min<uint64_t>(layer_config_.layer_options().post_trigger_capture_ms(),
+                              flight_recorder_ms);
+  }
+  return flight_recorder_ms / 2;
+}
+
 std::vector<std::string> LayerOptions::BuildOrbitCaptureServiceArgv(std::string_view game_pid) {
   std::vector<std::string> argv;
 
@@ -89,8 +115,9 @@ std::vector<std::string> LayerOptions::BuildOrbitCaptureServiceArgv(std::string_
   }
 
   // Set optional arguments if set by the user; otherwise not included in the call
-  // Available optional arguments are: functions, file_directory and sample_rate
-  // file_directory and sample_rate are given default values in OrbitCaptureGgpService
+  // Available optional arguments are: functions, file_directory, sample_rate and
+  // flight_recorder_ms. file_directory and sample_rate are given default values in
+  // OrbitCaptureGgpService
   if (layer_config_.has_capture_service_arguments() &&
       layer_config_.capture_service_arguments().functions_size() > 0) {
     argv.emplace_back("-functions");
@@ -119,5 +146,10 @@ std::vector<std::string> LayerOptions::BuildOrbitCaptureServiceArgv(std::string_
     argv.push_back(sampling_rate_str);
   }
 
+  if (GetFlightRecorderMilliseconds() > 0) {
+    argv.emplace_back("-flight_recorder_ms");
+    argv.push_back(absl::StrFormat("%d", GetFlightRecorderMilliseconds()));
+  }
+
   return argv;
 }
@@ -18,6 +18,11 @@ class LayerOptions {
   void Init();
   double GetFrameTimeThresholdMilliseconds();
   uint32_t GetCaptureLengthSeconds();
+  // Returns 0 if no percentile is configured.
+  double GetFrameTimePercentile();
+  // Returns 0 if flight recorder mode is disabled.
+  uint64_t GetFlightRecorderMilliseconds();
+  uint64_t GetPostTriggerCaptureMilliseconds();
   std::vector<std::string> BuildOrbitCaptureServiceArgv(std::string_view);
 
  private:
@@ -8,12 +8,23 @@
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
+#include <time.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
 
 namespace orbit_vulkan_layer {
 
+// The Vulkan time domain of `orbit_base::kOrbitCaptureClock`, used to calibrate GPU timestamps
+// against the capture clock with VK_EXT_calibrated_timestamps.
+constexpr VkTimeDomainEXT kCaptureClockTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+static_assert(orbit_base::kOrbitCaptureClock == CLOCK_MONOTONIC);
+
 /*
  * This class maintains a mapping from logical to physical devices (via `vkCreateDevice` and
  * `vkDestroyDevice`).
@@ -25,6 +36,11 @@ namespace orbit_vulkan_layer {
  * information (using `vkGetPhysicalDeviceProperties`). These properties can be used e.g. for
  * converting clock cycles to nanosecond timestamps.
  *
+ * It also determines for each logical device whether its GPU timestamps can be calibrated against
+ * the capture clock, that is whether VK_EXT_calibrated_timestamps is enabled on the device and
+ * supports both the device and the capture clock time domain. This can be queried using
+ * `IsCaptureClockCalibrationSupported`.
+ *
  * Thread-Safety: This class is internally synchronized (using read/write locks) and can be safely
  * accessed from different threads.
  */
@@ -46,6 +62,10 @@ class DeviceManager {
       physical_device_to_logical_devices_.at(physical_device).insert(logical_device);
     }
 
+    logical_device_supports_capture_clock_calibration_[logical_device] =
+        dispatch_table_->IsCalibratedTimestampsExtensionSupported(logical_device) &&
+        SupportsCaptureClockCalibration(physical_device);
+
     if (physical_device_to_properties_.contains(physical_device)) {
       return;
     }
@@ -66,6 +86,7 @@ class DeviceManager {
     ORBIT_CHECK(logical_device_to_physical_device_.contains(logical_device));
     VkPhysicalDevice physical_device = logical_device_to_physical_device_.at(logical_device);
     logical_device_to_physical_device_.erase(logical_device);
+    logical_device_supports_capture_clock_calibration_.erase(logical_device);
 
     ORBIT_CHECK(physical_device_to_logical_devices_.contains(physical_device));
     absl::flat_hash_set<VkDevice>& logical_devices =
@@ -87,11 +108,38 @@ class DeviceManager {
     return physical_device_to_properties_.at(physical_device);
   }
 
+  [[nodiscard]] bool IsCaptureClockCalibrationSupported(VkDevice logical_device) {
+    absl::ReaderMutexLock lock(&mutex_);
+    ORBIT_CHECK(logical_device_supports_capture_clock_calibration_.contains(logical_device));
+    return logical_device_supports_capture_clock_calibration_.at(logical_device);
+  }
+
  private:
+  [[nodiscard]] bool SupportsCaptureClockCalibration(VkPhysicalDevice physical_device) {
+    PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT get_time_domains_function =
+        dispatch_table_->GetPhysicalDeviceCalibrateableTimeDomainsEXT(physical_device);
+    uint32_t time_domain_count = 0;
+    if (get_time_domains_function(physical_device, &time_domain_count, nullptr) != VK_SUCCESS) {
+      return false;
+    }
+    std::vector<VkTimeDomainEXT> time_domains(time_domain_count);
+    if (get_time_domains_function(physical_device, &time_domain_count, time_domains.data()) !=
+        VK_SUCCESS) {
+      return false;
+    }
+    time_domains.resize(time_domain_count);
+    auto supports = [&time_domains](VkTimeDomainEXT time_domain) {
+      return std::find(time_domains.begin(), time_domains.end(), time_domain) !=
+             time_domains.end();
+    };
+    return supports(VK_TIME_DOMAIN_DEVICE_EXT) && supports(kCaptureClockTimeDomain);
+  }
+
   absl::Mutex mutex_;
   DispatchTable* dispatch_table_;
   absl::flat_hash_map<VkPhysicalDevice, VkPhysicalDeviceProperties> physical_device_to_properties_;
   absl::flat_hash_map<VkDevice, VkPhysicalDevice> logical_device_to_physical_device_;
+  absl::flat_hash_map<VkDevice, bool> logical_device_supports_capture_clock_calibration_;
   absl::flat_hash_map<VkPhysicalDevice, absl::flat_hash_set<VkDevice>>
       physical_device_to_logical_devices_;
 };
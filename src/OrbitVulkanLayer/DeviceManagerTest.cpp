@@ -6,6 +6,7 @@
 #include <gtest/gtest.h>
 #include <vulkan/vulkan_core.h>
 
+#include <array>
 #include <memory>
 
 #include "DeviceManager.h"
@@ -20,6 +21,10 @@ class MockDispatchTable {
  public:
   MOCK_METHOD(PFN_vkGetPhysicalDeviceProperties, GetPhysicalDeviceProperties,
               (VkPhysicalDevice dispatchable_object));
+  MOCK_METHOD(PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT,
+              GetPhysicalDeviceCalibrateableTimeDomainsEXT,
+              (VkPhysicalDevice dispatchable_object));
+  MOCK_METHOD(bool, IsCalibratedTimestampsExtensionSupported, (VkDevice dispatchable_object));
 };
 
 }  // namespace
@@ -95,4 +100,74 @@ TEST(DeviceManager, UntrackingRemovesDeviceProperties) {
   EXPECT_DEATH({ (void)manager.GetPhysicalDeviceProperties(physical_device); }, "");
 }
 
+TEST(DeviceManager, CaptureClockCalibrationIsNotSupportedWithoutExtension) {
+  MockDispatchTable dispatch_table;
+  DeviceManager<MockDispatchTable> manager(&dispatch_table);
+  VkDevice logical_device = {};
+  VkPhysicalDevice physical_device = {};
+
+  EXPECT_CALL(dispatch_table, GetPhysicalDeviceProperties)
+      .WillOnce(Return(&MockGetPhysicalDeviceProperties));
+  EXPECT_CALL(dispatch_table, IsCalibratedTimestampsExtensionSupported).WillOnce(Return(false));
+  EXPECT_CALL(dispatch_table, GetPhysicalDeviceCalibrateableTimeDomainsEXT).Times(0);
+
+  manager.TrackLogicalDevice(physical_device, logical_device);
+  EXPECT_FALSE(manager.IsCaptureClockCalibrationSupported(logical_device));
+}
+
+TEST(DeviceManager, CaptureClockCalibrationIsSupportedWithDeviceAndCaptureClockTimeDomains) {
+  MockDispatchTable dispatch_table;
+  DeviceManager<MockDispatchTable> manager(&dispatch_table);
+  VkDevice logical_device = {};
+  VkPhysicalDevice physical_device = {};
+
+  PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT mock_get_time_domains =
+      +[](VkPhysicalDevice /*physical_device*/, uint32_t* time_domain_count,
+          VkTimeDomainEXT* time_domains) -> VkResult {
+    static constexpr std::array<VkTimeDomainEXT, 2> kTimeDomains = {VK_TIME_DOMAIN_DEVICE_EXT,
+                                                                    kCaptureClockTimeDomain};
+    if (time_domains != nullptr) {
+      std::copy(kTimeDomains.begin(), kTimeDomains.end(), time_domains);
+    }
+    *time_domain_count = kTimeDomains.size();
+    return VK_SUCCESS;
+  };
+  EXPECT_CALL(dispatch_table, GetPhysicalDeviceProperties)
+      .WillOnce(Return(&MockGetPhysicalDeviceProperties));
+  EXPECT_CALL(dispatch_table, IsCalibratedTimestampsExtensionSupported).WillOnce(Return(true));
+  EXPECT_CALL(dispatch_table, GetPhysicalDeviceCalibrateableTimeDomainsEXT)
+      .WillOnce(Return(mock_get_time_domains));
+
+  manager.TrackLogicalDevice(physical_device, logical_device);
+  EXPECT_TRUE(manager.IsCaptureClockCalibrationSupported(logical_device));
+
+  manager.UntrackLogicalDevice(logical_device);
+  EXPECT_DEATH({ (void)manager.IsCaptureClockCalibrationSupported(logical_device); }, "");
+}
+
+TEST(DeviceManager, CaptureClockCalibrationIsNotSupportedWithoutCaptureClockTimeDomain) {
+  MockDispatchTable dispatch_table;
+  DeviceManager<MockDispatchTable> manager(&dispatch_table);
+  VkDevice logical_device = {};
+  VkPhysicalDevice physical_device = {};
+
+  PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT mock_get_time_domains =
+      +[](VkPhysicalDevice /*physical_device*/, uint32_t* time_domain_count,
+          VkTimeDomainEXT* time_domains) -> VkResult {
+    if (time_domains != nullptr) {
+      *time_domains = VK_TIME_DOMAIN_DEVICE_EXT;
+    }
+    *time_domain_count = 1;
+    return VK_SUCCESS;
+  };
+  EXPECT_CALL(dispatch_table, GetPhysicalDeviceProperties)
+      .WillOnce(Return(&MockGetPhysicalDeviceProperties));
+  EXPECT_CALL(dispatch_table, IsCalibratedTimestampsExtensionSupported).WillOnce(Return(true));
+  EXPECT_CALL(dispatch_table, GetPhysicalDeviceCalibrateableTimeDomainsEXT)
+      .WillOnce(Return(mock_get_time_domains));
+
+  manager.TrackLogicalDevice(physical_device, logical_device);
+  EXPECT_FALSE(manager.IsCaptureClockCalibrationSupported(logical_device));
+}
+
 }  // namespace orbit_vulkan_layer
@@ -20,6 +20,10 @@ void DispatchTable::CreateInstanceDispatchTable(
           next_get_instance_proc_addr_function(instance, "vkEnumerateDeviceExtensionProperties"));
   dispatch_table.GetPhysicalDeviceProperties = absl::bit_cast<PFN_vkGetPhysicalDeviceProperties>(
       next_get_instance_proc_addr_function(instance, "vkGetPhysicalDeviceProperties"));
+  dispatch_table.GetPhysicalDeviceCalibrateableTimeDomainsEXT =
+      absl::bit_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+          next_get_instance_proc_addr_function(instance,
+                                               "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
 
   dispatch_table.CreateDebugUtilsMessengerEXT = absl::bit_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
       next_get_instance_proc_addr_function(instance, "vkCreateDebugUtilsMessengerEXT"));
@@ -124,6 +128,9 @@ void DispatchTable::CreateDeviceDispatchTable(
   dispatch_table.GetQueryPoolResults = absl::bit_cast<PFN_vkGetQueryPoolResults>(
       next_get_device_proc_addr_function(device, "vkGetQueryPoolResults"));
 
+  dispatch_table.GetCalibratedTimestampsEXT = absl::bit_cast<PFN_vkGetCalibratedTimestampsEXT>(
+      next_get_device_proc_addr_function(device, "vkGetCalibratedTimestampsEXT"));
+
   dispatch_table.CmdBeginDebugUtilsLabelEXT = absl::bit_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(
       next_get_device_proc_addr_function(device, "vkCmdBeginDebugUtilsLabelEXT"));
   dispatch_table.CmdEndDebugUtilsLabelEXT = absl::bit_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(
@@ -178,6 +185,10 @@ void DispatchTable::CreateDeviceDispatchTable(
         dispatch_table.DebugMarkerSetObjectTagEXT != nullptr &&
         dispatch_table.DebugMarkerSetObjectNameEXT != nullptr &&
         dispatch_table.CmdDebugMarkerInsertEXT != nullptr;
+
+    ORBIT_CHECK(!device_supports_calibrated_timestamps_extension_.contains(key));
+    device_supports_calibrated_timestamps_extension_[key] =
+        dispatch_table.GetCalibratedTimestampsEXT != nullptr;
   }
 }
 
@@ -194,6 +205,9 @@ void DispatchTable::RemoveDeviceDispatchTable(VkDevice device) {
 
     ORBIT_CHECK(device_supports_debug_marker_extension_.contains(key));
     device_supports_debug_marker_extension_.erase(key);
+
+    ORBIT_CHECK(device_supports_calibrated_timestamps_extension_.contains(key));
+    device_supports_calibrated_timestamps_extension_.erase(key);
   }
 }
 
@@ -277,6 +277,44 @@ class DispatchTable {
     }
   }
 
+  // ----------------------------------------------------------------------------
+  // Calibrated timestamps extension:
+  // ----------------------------------------------------------------------------
+  template <typename DispatchableType>
+  PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT GetPhysicalDeviceCalibrateableTimeDomainsEXT(
+      DispatchableType dispatchable_object) {
+    void* key = GetDispatchTableKey(dispatchable_object);
+    {
+      absl::ReaderMutexLock lock(&mutex_);
+      ORBIT_CHECK(instance_dispatch_table_.contains(key));
+      ORBIT_CHECK(instance_dispatch_table_.at(key).GetPhysicalDeviceCalibrateableTimeDomainsEXT !=
+                  nullptr);
+      return instance_dispatch_table_.at(key).GetPhysicalDeviceCalibrateableTimeDomainsEXT;
+    }
+  }
+
+  template <typename DispatchableType>
+  PFN_vkGetCalibratedTimestampsEXT GetCalibratedTimestampsEXT(
+      DispatchableType dispatchable_object) {
+    void* key = GetDispatchTableKey(dispatchable_object);
+    {
+      absl::ReaderMutexLock lock(&mutex_);
+      ORBIT_CHECK(device_dispatch_table_.contains(key));
+      ORBIT_CHECK(device_dispatch_table_.at(key).GetCalibratedTimestampsEXT != nullptr);
+      return device_dispatch_table_.at(key).GetCalibratedTimestampsEXT;
+    }
+  }
+
+  template <typename DispatchableType>
+  bool IsCalibratedTimestampsExtensionSupported(DispatchableType dispatchable_object) {
+    void* key = GetDispatchTableKey(dispatchable_object);
+    {
+      absl::ReaderMutexLock lock(&mutex_);
+      ORBIT_CHECK(device_supports_calibrated_timestamps_extension_.contains(key));
+      return device_supports_calibrated_timestamps_extension_.at(key);
+    }
+  }
+
   // ----------------------------------------------------------------------------
   // Debug marker extension:
   // ----------------------------------------------------------------------------
@@ -577,6 +615,7 @@ class DispatchTable {
   absl::flat_hash_map<void*, VkLayerDispatchTable> device_dispatch_table_;
 
   absl::flat_hash_map<void*, bool> device_supports_debug_marker_extension_;
+  absl::flat_hash_map<void*, bool> device_supports_calibrated_timestamps_extension_;
   absl::flat_hash_map<void*, bool> device_supports_debug_utils_extension_;
   absl::flat_hash_map<void*, bool> instance_supports_debug_utils_extension_;
   absl::flat_hash_map<void*, bool> instance_supports_debug_report_extension_;
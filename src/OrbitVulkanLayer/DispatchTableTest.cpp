@@ -130,6 +130,7 @@ TEST(DispatchTable, NoDeviceExtensionAvailable) {
   dispatch_table.CreateDeviceDispatchTable(device, next_get_device_proc_addr_function);
   EXPECT_FALSE(dispatch_table.IsDebugUtilsExtensionSupported(device));
   EXPECT_FALSE(dispatch_table.IsDebugMarkerExtensionSupported(device));
+  EXPECT_FALSE(dispatch_table.IsCalibratedTimestampsExtensionSupported(device));
 }
 
 TEST(DispatchTable, NoInstanceExtensionAvailable) {
@@ -307,6 +308,26 @@ TEST(DispatchTable, CanSupportDebugMarkerExtension) {
   EXPECT_TRUE(dispatch_table.IsDebugMarkerExtensionSupported(device));
 }
 
+TEST(DispatchTable, CanSupportDeviceCalibratedTimestampsExtension) {
+  VkLayerDispatchTable some_dispatch_table = {};
+  auto* device = absl::bit_cast<VkDevice>(&some_dispatch_table);
+  PFN_vkGetDeviceProcAddr next_get_device_proc_addr_function =
+      +[](VkDevice /*device*/, const char* name) -> PFN_vkVoidFunction {
+    if (strcmp(name, "vkGetCalibratedTimestampsEXT") == 0) {
+      PFN_vkGetCalibratedTimestampsEXT function =
+          +[](VkDevice /*device*/, uint32_t /*timestamp_count*/,
+              const VkCalibratedTimestampInfoEXT* /*timestamp_infos*/, uint64_t* /*timestamps*/,
+              uint64_t* /*max_deviation*/) -> VkResult { return VK_SUCCESS; };
+      return absl::bit_cast<PFN_vkVoidFunction>(function);
+    }
+    return nullptr;
+  };
+
+  DispatchTable dispatch_table = {};
+  dispatch_table.CreateDeviceDispatchTable(device, next_get_device_proc_addr_function);
+  EXPECT_TRUE(dispatch_table.IsCalibratedTimestampsExtensionSupported(device));
+}
+
 TEST(DispatchTable, CanCallEnumerateDeviceExtensionProperties) {
   VkLayerInstanceDispatchTable some_dispatch_table = {};
   auto* instance = absl::bit_cast<VkInstance>(&some_dispatch_table);
@@ -5,15 +5,22 @@
 #ifndef ORBIT_VULKAN_LAYER_SUBMISSION_TRACKER_H_
 #define ORBIT_VULKAN_LAYER_SUBMISSION_TRACKER_H_
 
+#include <absl/base/casts.h>
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <stack>
 
+#include "DeviceManager.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
 #include "OrbitBase/ThreadUtils.h"
@@ -32,13 +39,19 @@ namespace orbit_vulkan_layer {
  * Upon every `VkQueuePresentKHR` it will check if the last timestamp of a certain submission is
  * already available, and if so, it will assume that all timestamps are available and it will send
  * the results over to the `VulkanLayerProducer`.
+ * If the device supports it (VK_EXT_calibrated_timestamps), it also calibrates the GPU clock
+ * against the capture clock on every `VkQueuePresentKHR` and converts the GPU timestamps to capture
+ * timestamps before sending them, so that the client doesn't need the GPU driver tracepoints to
+ * place them on the CPU timeline.
  *
  * See also `DispatchTable` (for vulkan dispatch), `TimerQueryPool` (to manage the timestamp slots),
  * and `DeviceManager` (to retrieve device properties).
  *
- * Thread-Safety: This class is internally synchronized (using read/write locks), and can be
- * safely accessed from different threads. This is needed, as in Vulkan submits and command buffer
- * modifications can happen from multiple threads.
+ * Thread-Safety: This class is internally synchronized, and can be safely accessed from different
+ * threads. This is needed, as in Vulkan submits and command buffer modifications can happen from
+ * multiple threads. The state of each command buffer has its own lock, so that recording command
+ * buffers on different threads doesn't serialize. A read/write lock only guards the allocation and
+ * deallocation of command buffers, and another lock the state of the queues.
  */
 template <class DispatchTable, class DeviceManager, class TimerQueryPool>
 class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
@@ -168,14 +181,12 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   void TrackCommandBuffers(VkDevice device, VkCommandPool pool,
                            const VkCommandBuffer* command_buffers, uint32_t count) {
     absl::WriterMutexLock lock(&mutex_);
-    auto associated_cbs_it = pool_to_command_buffers_.find(pool);
-    if (associated_cbs_it == pool_to_command_buffers_.end()) {
-      associated_cbs_it = pool_to_command_buffers_.try_emplace(pool).first;
-    }
+    absl::flat_hash_set<VkCommandBuffer>& associated_command_buffers =
+        pool_to_command_buffers_[pool];
     for (uint32_t i = 0; i < count; ++i) {
-      VkCommandBuffer cb = command_buffers[i];
-      associated_cbs_it->second.insert(cb);
-      command_buffer_to_device_[cb] = device;
+      VkCommandBuffer command_buffer = command_buffers[i];
+      associated_command_buffers.insert(command_buffer);
+      tracked_command_buffers_[command_buffer] = std::make_unique<TrackedCommandBuffer>(device);
     }
   }
 
@@ -189,23 +200,25 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       VkCommandBuffer command_buffer = command_buffers[i];
       associated_command_buffers.erase(command_buffer);
 
+      auto tracked_command_buffer_it = tracked_command_buffers_.find(command_buffer);
+      ORBIT_CHECK(tracked_command_buffer_it != tracked_command_buffers_.end());
+      TrackedCommandBuffer* tracked_command_buffer = tracked_command_buffer_it->second.get();
+      ORBIT_CHECK(tracked_command_buffer->device == device);
+
       // vkFreeCommandBuffers (and thus this method) can be also called on command bufers in
       // "recording" or executable state and has similar effect as vkResetCommandBuffer has.
-      // In `OnCaptureFinished`, we reset all the timer slots left in `command_buffer_to_state_`.
-      // If we would not reset them here and clear the state, we would try to reset those command
-      // buffers there. However, the mapping to the device (which is needed) would be missing.
-      if (command_buffer_to_state_.contains(command_buffer)) {
-        // Note: This will "rollback" the slot indices (rather then actually resetting them on the
-        // Gpu). This is fine, as we remove the command buffer state right after submission. Thus,
-        // There can not be a value in the respective slot.
-        ResetCommandBufferUnsafe(command_buffer);
-
-        command_buffer_to_state_.erase(command_buffer);
+      // In `OnCaptureFinished`, we reset all the timer slots left in the tracked command buffers.
+      // If we would not reset them here, we would try to reset those command buffers there.
+      // However, the command buffer (and its device) would be missing.
+      // Note: This will "rollback" the slot indices (rather then actually resetting them on the
+      // Gpu). This is fine, as we remove the command buffer state right after submission. Thus,
+      // There can not be a value in the respective slot.
+      {
+        absl::MutexLock state_lock(&tracked_command_buffer->mutex);
+        ResetCommandBufferLocked(tracked_command_buffer);
       }
 
-      ORBIT_CHECK(command_buffer_to_device_.contains(command_buffer));
-      ORBIT_CHECK(command_buffer_to_device_.at(command_buffer) == device);
-      command_buffer_to_device_.erase(command_buffer);
+      tracked_command_buffers_.erase(tracked_command_buffer_it);
     }
     if (associated_command_buffers.empty()) {
       pool_to_command_buffers_.erase(pool);
@@ -213,7 +226,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   void MarkCommandBufferBegin(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
+    TrackedCommandBuffer* tracked_command_buffer = GetTrackedCommandBuffer(command_buffer);
+    absl::MutexLock lock(&tracked_command_buffer->mutex);
     // Even when we are not capturing we create state for this command buffer to allow the
     // debug marker tracking. In order to compute the correct depth of a debug marker and being able
     // to match an "end" marker with the corresponding "begin" marker, we maintain a stack of all
@@ -222,34 +236,31 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     // state here that allows us to store the debug markers into it and maintain that stack on
     // submission. We will not write timestamps in this case and thus don't store any information
     // other than the debug markers then.
-    {
-      if (command_buffer_to_state_.contains(command_buffer)) {
-        // We end up in this case, if we have used the command buffer before and want to write new
-        // commands to it without resetting the command buffer. Per specification,
-        // "vkBeginCommandBuffer" does also reset the command buffer, in addition to putting it
-        // into the executable state.
-        ResetCommandBufferUnsafe(command_buffer);
-      }
-      command_buffer_to_state_[command_buffer] = {};
-    }
+    // If we have used the command buffer before and want to write new commands to it without
+    // resetting the command buffer, there is still a state. Per specification,
+    // "vkBeginCommandBuffer" does also reset the command buffer, in addition to putting it into the
+    // executable state.
+    ResetCommandBufferLocked(tracked_command_buffer);
+    tracked_command_buffer->state.emplace();
     if (!is_capturing_) {
       return;
     }
 
     uint32_t slot_index{};
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
-      ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-      command_buffer_to_state_.at(command_buffer).command_buffer_begin_slot_index =
+    if (RecordTimestamp(command_buffer, tracked_command_buffer->device,
+                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
+      tracked_command_buffer->state->command_buffer_begin_slot_index =
           std::make_optional(slot_index);
     }
   }
 
   void MarkCommandBufferEnd(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
+    TrackedCommandBuffer* tracked_command_buffer = GetTrackedCommandBuffer(command_buffer);
+    absl::MutexLock lock(&tracked_command_buffer->mutex);
     if (!is_capturing_) {
       return;
     }
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    if (!tracked_command_buffer->state.has_value()) {
       ORBIT_ERROR_ONCE(
           "Calling vkEndCommandBuffer on a command buffer that is in the initial state "
           "(i.e. either freshly allocated or reset with vkResetCommandBuffer).");
@@ -257,65 +268,57 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     uint32_t slot_index{};
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
-      // MarkCommandBufferBegin/End are called from within the same submit, and as the
-      // `MarkCommandBufferBegin` will always insert the state, we can assume that it is there.
-      ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& command_buffer_state = command_buffer_to_state_.at(command_buffer);
-      command_buffer_state.command_buffer_end_slot_index = std::make_optional(slot_index);
+    if (RecordTimestamp(command_buffer, tracked_command_buffer->device,
+                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
+      tracked_command_buffer->state->command_buffer_end_slot_index = std::make_optional(slot_index);
     }
   }
 
   void MarkDebugMarkerBegin(VkCommandBuffer command_buffer, const char* text, Color color) {
-    absl::WriterMutexLock lock(&mutex_);
     // It is ensured by the Vulkan spec. that `text` must not be nullptr.
     ORBIT_CHECK(text != nullptr);
-    bool marker_depth_exceeds_maximum = false;
-    {
-      if (!command_buffer_to_state_.contains(command_buffer)) {
-        ORBIT_ERROR_ONCE(
-            "Calling vkCmdDebugMarkerBeginEXT/vkCmdBeginDebugUtilsLabelEXT on a command buffer "
-            "that is in the initial state (i.e. either freshly allocated or reset with "
-            "vkResetCommandBuffer).");
-        return;
-      }
-      ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
-      ++state.local_marker_stack_size;
-      marker_depth_exceeds_maximum =
-          state.local_marker_stack_size > max_local_marker_depth_per_command_buffer_;
-      Marker marker{.type = MarkerType::kDebugMarkerBegin,
-                    .label_name = std::string(text),
-                    .color = color,
-                    .cut_off = marker_depth_exceeds_maximum};
-      state.markers.emplace_back(std::move(marker));
+    TrackedCommandBuffer* tracked_command_buffer = GetTrackedCommandBuffer(command_buffer);
+    absl::MutexLock lock(&tracked_command_buffer->mutex);
+    if (!tracked_command_buffer->state.has_value()) {
+      ORBIT_ERROR_ONCE(
+          "Calling vkCmdDebugMarkerBeginEXT/vkCmdBeginDebugUtilsLabelEXT on a command buffer "
+          "that is in the initial state (i.e. either freshly allocated or reset with "
+          "vkResetCommandBuffer).");
+      return;
     }
+    CommandBufferState& state = tracked_command_buffer->state.value();
+    ++state.local_marker_stack_size;
+    const bool marker_depth_exceeds_maximum =
+        state.local_marker_stack_size > max_local_marker_depth_per_command_buffer_;
+    Marker marker{.type = MarkerType::kDebugMarkerBegin,
+                  .label_name = std::string(text),
+                  .color = color,
+                  .cut_off = marker_depth_exceeds_maximum};
+    state.markers.emplace_back(std::move(marker));
 
     if (!is_capturing_ || marker_depth_exceeds_maximum) {
       return;
     }
 
     uint32_t slot_index{};
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
-      ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    if (RecordTimestamp(command_buffer, tracked_command_buffer->device,
+                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
       state.markers.back().slot_index = std::make_optional(slot_index);
     }
   }
 
   void MarkDebugMarkerEnd(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
-
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    TrackedCommandBuffer* tracked_command_buffer = GetTrackedCommandBuffer(command_buffer);
+    absl::MutexLock lock(&tracked_command_buffer->mutex);
+    if (!tracked_command_buffer->state.has_value()) {
       ORBIT_ERROR_ONCE(
           "Calling vkCmdDebugMarkerEndEXT/vkCmdEndDebugUtilsLabelEXT on a command buffer "
           "that is in the initial state (i.e. either freshly allocated or reset with "
           "vkResetCommandBuffer).");
       return;
     }
-    ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
-    bool marker_depth_exceeds_maximum =
+    CommandBufferState& state = tracked_command_buffer->state.value();
+    const bool marker_depth_exceeds_maximum =
         state.local_marker_stack_size > max_local_marker_depth_per_command_buffer_;
     Marker marker{.type = MarkerType::kDebugMarkerEnd, .cut_off = marker_depth_exceeds_maximum};
     state.markers.emplace_back(std::move(marker));
@@ -330,9 +333,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     uint32_t slot_index = 0;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
-      ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    if (RecordTimestamp(command_buffer, tracked_command_buffer->device,
+                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
       state.markers.back().slot_index = std::make_optional(slot_index);
     }
   }
@@ -348,7 +350,6 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   // This allows us to map submissions from the Vulkan layer to the driver submissions.
   [[nodiscard]] std::optional<QueueSubmission> PersistCommandBuffersOnSubmit(
       VkQueue queue, uint32_t submit_count, const VkSubmitInfo* submits) {
-    absl::WriterMutexLock lock(&mutex_);
     if (!is_capturing_) {
       // `OnCaptureFinished` has already been called and has taken care of resetting slots.
       return std::nullopt;
@@ -373,8 +374,12 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       SubmitInfo& submitted_submit_info = queue_submission.submit_infos.back();
       for (uint32_t command_buffer_index = 0; command_buffer_index < submit_info.commandBufferCount;
            ++command_buffer_index) {
-        VkCommandBuffer command_buffer = submit_info.pCommandBuffers[command_buffer_index];
-        PersistSingleCommandBufferOnSubmit(device, command_buffer, &queue_submission,
+        TrackedCommandBuffer* tracked_command_buffer =
+            GetTrackedCommandBuffer(submit_info.pCommandBuffers[command_buffer_index]);
+        if (device == VK_NULL_HANDLE) {
+          device = tracked_command_buffer->device;
+        }
+        PersistSingleCommandBufferOnSubmit(tracked_command_buffer, &queue_submission,
                                            &submitted_submit_info, &query_slots_not_needed_to_read);
       }
     }
@@ -405,12 +410,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   void PersistDebugMarkersOnSubmit(VkQueue queue, uint32_t submit_count,
                                    const VkSubmitInfo* submits,
                                    std::optional<QueueSubmission> queue_submission_optional) {
-    absl::WriterMutexLock lock(&mutex_);
-    if (!queue_to_markers_.contains(queue)) {
-      queue_to_markers_[queue] = {};
-    }
-    ORBIT_CHECK(queue_to_markers_.contains(queue));
-    QueueMarkerState& markers = queue_to_markers_.at(queue);
+    absl::MutexLock lock(&queue_mutex_);
+    QueueMarkerState& markers = queue_to_markers_[queue];
 
     // If we consider that we are still capturing, take a cpu timestamp as "post submission" such
     // that the submission "meta information" is complete. We can then attach that also to each
@@ -426,13 +427,14 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       VkSubmitInfo submit_info = submits[submit_index];
       for (uint32_t command_buffer_index = 0; command_buffer_index < submit_info.commandBufferCount;
            ++command_buffer_index) {
-        VkCommandBuffer command_buffer = submit_info.pCommandBuffers[command_buffer_index];
+        TrackedCommandBuffer* tracked_command_buffer =
+            GetTrackedCommandBuffer(submit_info.pCommandBuffers[command_buffer_index]);
         if (device == VK_NULL_HANDLE) {
-          ORBIT_CHECK(command_buffer_to_device_.contains(command_buffer));
-          device = command_buffer_to_device_.at(command_buffer);
+          device = tracked_command_buffer->device;
         }
-        PersistDebugMarkersOfASingleCommandBufferOnSubmit(
-            command_buffer, &queue_submission_optional, &markers, &marker_slots_not_needed_to_read);
+        PersistDebugMarkersOfASingleCommandBufferOnSubmit(tracked_command_buffer,
+                                                          &queue_submission_optional, &markers,
+                                                          &marker_slots_not_needed_to_read);
       }
     }
 
@@ -468,7 +470,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   // This method also resets all the timer slots that have been read.
   // It is assumed to be called periodically, e.g. on `vkQueuePresentKHR`.
   void CompleteSubmits(VkDevice device) {
-    absl::WriterMutexLock lock(&mutex_);
+    absl::MutexLock lock(&queue_mutex_);
     VkQueryPool query_pool = timer_query_pool_->GetQueryPool(device);
 
     if (queue_to_submission_priority_queue_.empty()) {
@@ -482,34 +484,62 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     std::vector<uint32_t> query_slots_done_reading = {};
     std::vector<QueueSubmission> submissions_to_send = {};
 
-    // The submits of a specific queue in `submissions_queue_` are sorted by "pre submission CPU"
-    // timestamp and we want to make sure we send events to the client in that order. Therefore, we
-    // stop as soon as a query failed.
+    // Take the pending submissions of every queue out of the priority queues, ordered by "pre
+    // submission CPU" timestamp, so that all the slots they are waiting for can be read at once.
+    std::vector<std::vector<QueueSubmission>> pending_submissions_per_queue;
+    std::vector<uint32_t> pending_slot_indices;
     for (auto& [unused_queue, submissions] : queue_to_submission_priority_queue_) {
+      std::vector<QueueSubmission>& pending_submissions =
+          pending_submissions_per_queue.emplace_back();
       while (!submissions.empty()) {
-        QueueSubmission completed_submission = submissions.top();
+        pending_submissions.emplace_back(submissions.top());
         submissions.pop();
-        bool command_buffer_queries_succeeded = QueryCommandBufferTimestamps(
-            &completed_submission, &query_slots_done_reading, device, query_pool, timestamp_period);
-
-        // We only need to read the debug marker timestamps, if querying the command buffers
-        // succeeded.
-        bool marker_queries_succeeded = false;
-        if (command_buffer_queries_succeeded) {
-          marker_queries_succeeded =
-              QueryDebugMarkerTimestamps(&completed_submission, &query_slots_done_reading, device,
-                                         query_pool, timestamp_period);
-        }
+        AppendPendingSlotIndices(pending_submissions.back(), &pending_slot_indices);
+      }
+    }
+    const AvailableTimestamps available_timestamps =
+        QueryAvailableTimestamps(device, query_pool, std::move(pending_slot_indices));
 
-        if (command_buffer_queries_succeeded && marker_queries_succeeded) {
-          submissions_to_send.emplace_back(std::move(completed_submission));
-        } else {
-          submissions.emplace(std::move(completed_submission));
-          break;
+    // The submits of a specific queue are sorted by "pre submission CPU" timestamp and we want to
+    // make sure we send events to the client in that order. Therefore, we stop as soon as a query
+    // failed, and put this and all later submissions of the queue back.
+    size_t queue_index = 0;
+    for (auto& [unused_queue, submissions] : queue_to_submission_priority_queue_) {
+      std::vector<QueueSubmission>& pending_submissions =
+          pending_submissions_per_queue[queue_index++];
+      bool all_queries_succeeded = true;
+      for (QueueSubmission& completed_submission : pending_submissions) {
+        if (all_queries_succeeded) {
+          bool command_buffer_queries_succeeded = QueryCommandBufferTimestamps(
+              &completed_submission, &query_slots_done_reading, available_timestamps,
+              timestamp_period);
+
+          // We only need to read the debug marker timestamps, if querying the command buffers
+          // succeeded.
+          bool marker_queries_succeeded = false;
+          if (command_buffer_queries_succeeded) {
+            marker_queries_succeeded =
+                QueryDebugMarkerTimestamps(&completed_submission, &query_slots_done_reading,
+                                           available_timestamps, timestamp_period);
+          }
+          all_queries_succeeded = command_buffer_queries_succeeded && marker_queries_succeeded;
+          if (all_queries_succeeded) {
+            submissions_to_send.emplace_back(std::move(completed_submission));
+            continue;
+          }
         }
+        submissions.emplace(std::move(completed_submission));
       }
     }
 
+    // Calibrate once for all the submissions sent now, so that the conversion of their timestamps
+    // is consistent.
+    std::optional<uint64_t> gpu_to_capture_timestamp_offset_ns;
+    if (!submissions_to_send.empty()) {
+      gpu_to_capture_timestamp_offset_ns =
+          CalibrateGpuToCaptureTimestampOffsetNs(device, timestamp_period);
+    }
+
     for (const auto& completed_submission : submissions_to_send) {
       orbit_grpc_protos::ProducerCaptureEvent capture_event;
       orbit_grpc_protos::GpuQueueSubmission* submission_proto =
@@ -519,6 +549,11 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       bool has_command_buffer_timestamps =
           WriteCommandBufferTimings(completed_submission, submission_proto);
       bool has_debug_marker_timestamps = WriteDebugMarkers(completed_submission, submission_proto);
+      if (gpu_to_capture_timestamp_offset_ns.has_value()) {
+        ConvertGpuTimestampsToCaptureTimestamps(gpu_to_capture_timestamp_offset_ns.value(),
+                                                submission_proto);
+        submission_proto->set_queue_id(absl::bit_cast<uintptr_t>(completed_submission.queue));
+      }
 
       if (vulkan_layer_producer_ != nullptr &&
           (has_command_buffer_timestamps || has_debug_marker_timestamps)) {
@@ -532,27 +567,27 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   void ResetCommandBuffer(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
-    ResetCommandBufferUnsafe(command_buffer);
+    TrackedCommandBuffer* tracked_command_buffer = GetTrackedCommandBuffer(command_buffer);
+    absl::MutexLock lock(&tracked_command_buffer->mutex);
+    ResetCommandBufferLocked(tracked_command_buffer);
   }
 
   void ResetCommandPool(VkCommandPool command_pool) {
-    absl::flat_hash_set<VkCommandBuffer> command_buffers;
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      if (!pool_to_command_buffers_.contains(command_pool)) {
-        return;
-      }
-      ORBIT_CHECK(pool_to_command_buffers_.contains(command_pool));
-      command_buffers = pool_to_command_buffers_.at(command_pool);
+    absl::ReaderMutexLock lock(&mutex_);
+    auto command_buffers_it = pool_to_command_buffers_.find(command_pool);
+    if (command_buffers_it == pool_to_command_buffers_.end()) {
+      return;
     }
-    for (const auto& command_buffer : command_buffers) {
-      ResetCommandBuffer(command_buffer);
+    for (VkCommandBuffer command_buffer : command_buffers_it->second) {
+      ORBIT_CHECK(tracked_command_buffers_.contains(command_buffer));
+      TrackedCommandBuffer* tracked_command_buffer =
+          tracked_command_buffers_.at(command_buffer).get();
+      absl::MutexLock state_lock(&tracked_command_buffer->mutex);
+      ResetCommandBufferLocked(tracked_command_buffer);
     }
   }
 
   void OnCaptureStart(orbit_grpc_protos::CaptureOptions capture_options) override {
-    absl::WriterMutexLock lock(&mutex_);
     SetMaxLocalMarkerDepthPerCommandBuffer(
         capture_options.max_local_marker_depth_per_command_buffer());
     is_capturing_ = true;
@@ -561,16 +596,23 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   void OnCaptureStop() override {}
 
   void OnCaptureFinished() override {
-    absl::WriterMutexLock lock(&mutex_);
+    // This happens before taking the lock of any command buffer below. So every command buffer
+    // operation that still sees that we are capturing completes before we reset the slots of that
+    // command buffer.
+    is_capturing_ = false;
+
+    absl::ReaderMutexLock lock(&mutex_);
     std::vector<uint32_t> slots_not_needed_to_read_anymore;
 
     VkDevice device = VK_NULL_HANDLE;
 
-    for (auto& [command_buffer, command_buffer_state] : command_buffer_to_state_) {
+    for (auto& [unused_command_buffer, tracked_command_buffer] : tracked_command_buffers_) {
+      absl::MutexLock state_lock(&tracked_command_buffer->mutex);
+      if (!tracked_command_buffer->state.has_value()) continue;
+      CommandBufferState& command_buffer_state = tracked_command_buffer->state.value();
       if (command_buffer_state.pre_submission_cpu_timestamp.has_value()) continue;
       if (device == VK_NULL_HANDLE) {
-        ORBIT_CHECK(command_buffer_to_device_.contains(command_buffer));
-        device = command_buffer_to_device_.at(command_buffer);
+        device = tracked_command_buffer->device;
       }
       if (command_buffer_state.command_buffer_begin_slot_index.has_value()) {
         slots_not_needed_to_read_anymore.push_back(
@@ -594,8 +636,6 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     if (!slots_not_needed_to_read_anymore.empty()) {
       timer_query_pool_->MarkQuerySlotsDoneReading(device, slots_not_needed_to_read_anymore);
     }
-
-    is_capturing_ = false;
   }
 
  private:
@@ -639,13 +679,30 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     uint32_t local_marker_stack_size = 0;
   };
 
-  bool RecordTimestamp(VkCommandBuffer command_buffer, VkPipelineStageFlagBits pipeline_stage_flags,
-                       uint32_t* slot_index) {
-    mutex_.AssertReaderHeld();
+  // Everything we know about a command buffer between its allocation and its deallocation. Vulkan
+  // requires the application to synchronize the recording into and the submission of a command
+  // buffer externally, so `mutex` is only ever contended when a capture finishes or the command
+  // pool gets reset. This is what allows many threads to record command buffers in parallel.
+  struct TrackedCommandBuffer {
+    explicit TrackedCommandBuffer(VkDevice device) : device(device) {}
+
+    const VkDevice device;
+    absl::Mutex mutex;
+    // Empty while the command buffer is in the initial state.
+    std::optional<CommandBufferState> state ABSL_GUARDED_BY(mutex);
+  };
 
-    ORBIT_CHECK(command_buffer_to_device_.contains(command_buffer));
-    VkDevice device = command_buffer_to_device_.at(command_buffer);
+  // The returned pointer stays valid until the command buffer is freed, which Vulkan doesn't allow
+  // while the command buffer is in use, so it can be used after releasing `mutex_`.
+  [[nodiscard]] TrackedCommandBuffer* GetTrackedCommandBuffer(VkCommandBuffer command_buffer) {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto tracked_command_buffer_it = tracked_command_buffers_.find(command_buffer);
+    ORBIT_CHECK(tracked_command_buffer_it != tracked_command_buffers_.end());
+    return tracked_command_buffer_it->second.get();
+  }
 
+  bool RecordTimestamp(VkCommandBuffer command_buffer, VkDevice device,
+                       VkPipelineStageFlagBits pipeline_stage_flags, uint32_t* slot_index) {
     VkQueryPool query_pool = timer_query_pool_->GetQueryPool(device);
 
     if (!timer_query_pool_->NextReadyQuerySlot(device, slot_index)) {
@@ -659,20 +716,144 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     return true;
   }
 
-  std::optional<uint64_t> QueryGpuTimestampNs(VkDevice device, VkQueryPool query_pool,
-                                              uint32_t slot_index, float timestamp_period) {
-    static constexpr VkDeviceSize kResultStride = sizeof(uint64_t);
+  // The raw GPU timestamps of the query slots whose results are available, by slot index.
+  using AvailableTimestamps = absl::flat_hash_map<uint32_t, uint64_t>;
+
+  // Collects the slots of the command buffers and debug markers of the submission that haven't been
+  // read yet.
+  static void AppendPendingSlotIndices(const QueueSubmission& submission,
+                                       std::vector<uint32_t>* slot_indices) {
+    for (const SubmitInfo& submit_info : submission.submit_infos) {
+      for (const SubmittedCommandBuffer& command_buffer : submit_info.command_buffers) {
+        if (!command_buffer.end_timestamp.has_value()) {
+          ORBIT_CHECK(command_buffer.command_buffer_end_slot_index.has_value());
+          slot_indices->push_back(command_buffer.command_buffer_end_slot_index.value());
+        }
+        if (command_buffer.command_buffer_begin_slot_index.has_value() &&
+            !command_buffer.begin_timestamp.has_value()) {
+          slot_indices->push_back(command_buffer.command_buffer_begin_slot_index.value());
+        }
+      }
+    }
+    for (const SubmittedMarkerSlice& marker_slice : submission.completed_markers) {
+      if (!marker_slice.end_info.timestamp.has_value()) {
+        slot_indices->push_back(marker_slice.end_info.slot_index);
+      }
+      if (marker_slice.begin_info.has_value() && !marker_slice.begin_info->timestamp.has_value()) {
+        slot_indices->push_back(marker_slice.begin_info->slot_index);
+      }
+    }
+  }
 
-    uint64_t timestamp = 0;
-    VkResult result_status = dispatch_table_->GetQueryPoolResults(device)(
-        device, query_pool, slot_index, 1, sizeof(timestamp), &timestamp, kResultStride,
-        VK_QUERY_RESULT_64_BIT);
+  // Reads the results of the given slots with one vkGetQueryPoolResults per run of consecutive slot
+  // indices, instead of one call per slot. Slots whose result is not available yet are left out.
+  [[nodiscard]] AvailableTimestamps QueryAvailableTimestamps(VkDevice device,
+                                                             VkQueryPool query_pool,
+                                                             std::vector<uint32_t> slot_indices) {
+    std::sort(slot_indices.begin(), slot_indices.end());
+    slot_indices.erase(std::unique(slot_indices.begin(), slot_indices.end()), slot_indices.end());
+
+    struct TimestampWithAvailability {
+      uint64_t timestamp;
+      uint64_t availability;
+    };
+    static constexpr VkDeviceSize kResultStride = sizeof(TimestampWithAvailability);
+
+    AvailableTimestamps available_timestamps;
+    std::vector<TimestampWithAvailability> results;
+    size_t run_begin = 0;
+    while (run_begin < slot_indices.size()) {
+      size_t run_end = run_begin + 1;
+      while (run_end < slot_indices.size() &&
+             slot_indices[run_end] == slot_indices[run_end - 1] + 1) {
+        ++run_end;
+      }
+      const uint32_t first_slot_index = slot_indices[run_begin];
+      const auto num_slots = static_cast<uint32_t>(run_end - run_begin);
+      run_begin = run_end;
+
+      results.assign(num_slots, {});
+      VkResult result_status = dispatch_table_->GetQueryPoolResults(device)(
+          device, query_pool, first_slot_index, num_slots,
+          results.size() * sizeof(TimestampWithAvailability), results.data(), kResultStride,
+          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+      // With VK_NOT_READY, the results of the available slots are still written.
+      if (result_status != VK_SUCCESS && result_status != VK_NOT_READY) {
+        continue;
+      }
+      for (uint32_t i = 0; i < num_slots; ++i) {
+        if (results[i].availability != 0) {
+          available_timestamps.emplace(first_slot_index + i, results[i].timestamp);
+        }
+      }
+    }
+    return available_timestamps;
+  }
 
-    if (result_status != VK_SUCCESS) {
+  [[nodiscard]] static std::optional<uint64_t> GetAvailableTimestampNs(
+      const AvailableTimestamps& available_timestamps, uint32_t slot_index,
+      float timestamp_period) {
+    auto timestamp_it = available_timestamps.find(slot_index);
+    if (timestamp_it == available_timestamps.end()) {
+      return std::nullopt;
+    }
+    return static_cast<uint64_t>(static_cast<double>(timestamp_it->second) * timestamp_period);
+  }
+
+  // Returns the offset to add to a GPU timestamp (in nanoseconds, see `GetAvailableTimestampNs`)
+  // of the device to get the capture timestamp, or `std::nullopt` if the device's GPU clock can't
+  // be calibrated against the capture clock.
+  [[nodiscard]] std::optional<uint64_t> CalibrateGpuToCaptureTimestampOffsetNs(
+      VkDevice device, float timestamp_period) {
+    if (!device_manager_->IsCaptureClockCalibrationSupported(device)) {
+      return std::nullopt;
+    }
+    static constexpr std::array<VkCalibratedTimestampInfoEXT, 2> kTimestampInfos = {
+        VkCalibratedTimestampInfoEXT{.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+                                     .pNext = nullptr,
+                                     .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT},
+        VkCalibratedTimestampInfoEXT{.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+                                     .pNext = nullptr,
+                                     .timeDomain = kCaptureClockTimeDomain}};
+    std::array<uint64_t, kTimestampInfos.size()> timestamps{};
+    uint64_t max_deviation = 0;
+    VkResult result = dispatch_table_->GetCalibratedTimestampsEXT(device)(
+        device, kTimestampInfos.size(), kTimestampInfos.data(), timestamps.data(), &max_deviation);
+    if (result != VK_SUCCESS) {
       return std::nullopt;
     }
+    const auto gpu_timestamp_ns =
+        static_cast<uint64_t>(static_cast<double>(timestamps[0]) * timestamp_period);
+    // Unsigned arithmetic wraps around, so this also works if the GPU clock is ahead.
+    return timestamps[1] - gpu_timestamp_ns;
+  }
 
-    return static_cast<uint64_t>(static_cast<double>(timestamp) * timestamp_period);
+  static void ConvertGpuTimestampsToCaptureTimestamps(
+      uint64_t gpu_to_capture_timestamp_offset_ns,
+      orbit_grpc_protos::GpuQueueSubmission* submission_proto) {
+    for (orbit_grpc_protos::GpuSubmitInfo& submit_info :
+         *submission_proto->mutable_submit_infos()) {
+      for (orbit_grpc_protos::GpuCommandBuffer& command_buffer :
+           *submit_info.mutable_command_buffers()) {
+        // A begin timestamp of 0 means that we haven't captured the begin.
+        if (command_buffer.begin_gpu_timestamp_ns() != 0) {
+          command_buffer.set_begin_gpu_timestamp_ns(command_buffer.begin_gpu_timestamp_ns() +
+                                                    gpu_to_capture_timestamp_offset_ns);
+        }
+        command_buffer.set_end_gpu_timestamp_ns(command_buffer.end_gpu_timestamp_ns() +
+                                                gpu_to_capture_timestamp_offset_ns);
+      }
+    }
+    for (orbit_grpc_protos::GpuDebugMarker& marker :
+         *submission_proto->mutable_completed_markers()) {
+      marker.set_end_gpu_timestamp_ns(marker.end_gpu_timestamp_ns() +
+                                      gpu_to_capture_timestamp_offset_ns);
+      if (marker.has_begin_marker()) {
+        marker.mutable_begin_marker()->set_gpu_timestamp_ns(
+            marker.begin_marker().gpu_timestamp_ns() + gpu_to_capture_timestamp_offset_ns);
+      }
+    }
+    submission_proto->set_gpu_timestamps_are_capture_timestamps(true);
   }
 
   static void WriteMetaInfo(const SubmissionMetaInformation& meta_info,
@@ -683,17 +864,16 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     target_proto->set_post_submission_cpu_timestamp(meta_info.post_submission_cpu_timestamp);
   }
 
-  [[nodiscard]] bool QuerySingleCommandBufferTimestamps(SubmittedCommandBuffer* command_buffer,
-                                                        std::vector<uint32_t>* query_slots_to_reset,
-                                                        VkDevice device, VkQueryPool query_pool,
-                                                        float timestamp_period) {
+  [[nodiscard]] static bool QuerySingleCommandBufferTimestamps(
+      SubmittedCommandBuffer* command_buffer, std::vector<uint32_t>* query_slots_to_reset,
+      const AvailableTimestamps& available_timestamps, float timestamp_period) {
     ORBIT_CHECK(command_buffer != nullptr);
 
     if (!command_buffer->end_timestamp.has_value()) {
       ORBIT_CHECK(command_buffer->command_buffer_end_slot_index.has_value());
       uint32_t slot_index = command_buffer->command_buffer_end_slot_index.value();
       std::optional<uint64_t> end_timestamp =
-          QueryGpuTimestampNs(device, query_pool, slot_index, timestamp_period);
+          GetAvailableTimestampNs(available_timestamps, slot_index, timestamp_period);
       if (end_timestamp.has_value()) {
         command_buffer->end_timestamp = end_timestamp;
         query_slots_to_reset->push_back(slot_index);
@@ -711,7 +891,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     if (!command_buffer->begin_timestamp.has_value()) {
       uint32_t slot_index = command_buffer->command_buffer_begin_slot_index.value();
       std::optional<uint64_t> begin_timestamp =
-          QueryGpuTimestampNs(device, query_pool, slot_index, timestamp_period);
+          GetAvailableTimestampNs(available_timestamps, slot_index, timestamp_period);
       if (begin_timestamp.has_value()) {
         command_buffer->begin_timestamp = begin_timestamp;
         query_slots_to_reset->push_back(slot_index);
@@ -723,29 +903,28 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     return true;
   }
 
-  [[nodiscard]] bool QueryCommandBufferTimestamps(QueueSubmission* completed_submission,
-                                                  std::vector<uint32_t>* query_slots_to_reset,
-                                                  VkDevice device, VkQueryPool query_pool,
-                                                  float timestamp_period) {
+  [[nodiscard]] static bool QueryCommandBufferTimestamps(
+      QueueSubmission* completed_submission, std::vector<uint32_t>* query_slots_to_reset,
+      const AvailableTimestamps& available_timestamps, float timestamp_period) {
     for (auto& completed_submit : completed_submission->submit_infos) {
       for (auto& completed_command_buffer : completed_submit.command_buffers) {
-        bool queries_succeeded = QuerySingleCommandBufferTimestamps(
-            &completed_command_buffer, query_slots_to_reset, device, query_pool, timestamp_period);
+        bool queries_succeeded =
+            QuerySingleCommandBufferTimestamps(&completed_command_buffer, query_slots_to_reset,
+                                               available_timestamps, timestamp_period);
         if (!queries_succeeded) return false;
       }
     }
     return true;
   }
 
-  [[nodiscard]] bool QuerySingleDebugMarkerTimestamps(SubmittedMarkerSlice* marker_slice,
-                                                      std::vector<uint32_t>* query_slots_to_reset,
-                                                      VkDevice device, VkQueryPool query_pool,
-                                                      float timestamp_period) {
+  [[nodiscard]] static bool QuerySingleDebugMarkerTimestamps(
+      SubmittedMarkerSlice* marker_slice, std::vector<uint32_t>* query_slots_to_reset,
+      const AvailableTimestamps& available_timestamps, float timestamp_period) {
     ORBIT_CHECK(marker_slice != nullptr);
 
     if (!marker_slice->end_info.timestamp.has_value()) {
-      std::optional<uint64_t> end_timestamp = QueryGpuTimestampNs(
-          device, query_pool, marker_slice->end_info.slot_index, timestamp_period);
+      std::optional<uint64_t> end_timestamp = GetAvailableTimestampNs(
+          available_timestamps, marker_slice->end_info.slot_index, timestamp_period);
       if (end_timestamp.has_value()) {
         marker_slice->end_info.timestamp = end_timestamp;
         query_slots_to_reset->push_back(marker_slice->end_info.slot_index);
@@ -759,8 +938,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     if (!marker_slice->begin_info->timestamp.has_value()) {
-      std::optional<uint64_t> begin_timestamp = QueryGpuTimestampNs(
-          device, query_pool, marker_slice->begin_info->slot_index, timestamp_period);
+      std::optional<uint64_t> begin_timestamp = GetAvailableTimestampNs(
+          available_timestamps, marker_slice->begin_info->slot_index, timestamp_period);
       if (begin_timestamp.has_value()) {
         marker_slice->begin_info->timestamp = begin_timestamp;
         query_slots_to_reset->push_back(marker_slice->begin_info->slot_index);
@@ -771,13 +950,12 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     return true;
   }
 
-  [[nodiscard]] bool QueryDebugMarkerTimestamps(QueueSubmission* completed_submission,
-                                                std::vector<uint32_t>* query_slots_to_reset,
-                                                VkDevice device, VkQueryPool query_pool,
-                                                float timestamp_period) {
+  [[nodiscard]] static bool QueryDebugMarkerTimestamps(
+      QueueSubmission* completed_submission, std::vector<uint32_t>* query_slots_to_reset,
+      const AvailableTimestamps& available_timestamps, float timestamp_period) {
     for (auto& marker_slice : completed_submission->completed_markers) {
       bool queries_succeeded = QuerySingleDebugMarkerTimestamps(
-          &marker_slice, query_slots_to_reset, device, query_pool, timestamp_period);
+          &marker_slice, query_slots_to_reset, available_timestamps, timestamp_period);
       if (!queries_succeeded) return false;
     }
     return true;
@@ -861,16 +1039,13 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     return has_at_least_one_timestamp;
   }
 
-  // This method does not acquire a lock and MUST NOT be called without holding the `mutex_`.
-  void ResetCommandBufferUnsafe(VkCommandBuffer command_buffer) {
-    mutex_.AssertHeld();
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+  void ResetCommandBufferLocked(TrackedCommandBuffer* tracked_command_buffer)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(tracked_command_buffer->mutex) {
+    if (!tracked_command_buffer->state.has_value()) {
       return;
     }
-    ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
-    ORBIT_CHECK(command_buffer_to_device_.contains(command_buffer));
-    VkDevice device = command_buffer_to_device_.at(command_buffer);
+    const CommandBufferState& state = tracked_command_buffer->state.value();
+    VkDevice device = tracked_command_buffer->device;
     std::vector<uint32_t> query_slots_to_reset{};
     if (state.command_buffer_begin_slot_index.has_value()) {
       query_slots_to_reset.push_back(state.command_buffer_begin_slot_index.value());
@@ -889,26 +1064,26 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       timer_query_pool_->RollbackPendingQuerySlots(device, query_slots_to_reset);
     }
 
-    command_buffer_to_state_.erase(command_buffer);
+    tracked_command_buffer->state.reset();
   }
 
-  void PersistSingleCommandBufferOnSubmit(VkDevice device, VkCommandBuffer command_buffer,
+  void PersistSingleCommandBufferOnSubmit(TrackedCommandBuffer* tracked_command_buffer,
                                           QueueSubmission* queue_submission,
                                           SubmitInfo* submitted_submit_info,
                                           std::vector<uint32_t>* query_slots_not_needed_to_read) {
-    mutex_.AssertHeld();
+    ORBIT_CHECK(tracked_command_buffer != nullptr);
     ORBIT_CHECK(queue_submission != nullptr);
     ORBIT_CHECK(submitted_submit_info != nullptr);
     ORBIT_CHECK(query_slots_not_needed_to_read != nullptr);
 
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    absl::MutexLock lock(&tracked_command_buffer->mutex);
+    if (!tracked_command_buffer->state.has_value()) {
       ORBIT_ERROR_ONCE(
           "Calling vkQueueSubmit on a command buffer that is in the initial state (i.e. "
           "either freshly allocated or reset with vkResetCommandBuffer).");
       return;
     }
-    ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    CommandBufferState& state = tracked_command_buffer->state.value();
     bool has_been_submitted_before = state.pre_submission_cpu_timestamp.has_value();
 
     // Mark that this command buffer in the current state was already submitted. If the command
@@ -922,10 +1097,6 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     state.pre_submission_cpu_timestamp =
         queue_submission->meta_information.pre_submission_cpu_timestamp;
 
-    if (device == VK_NULL_HANDLE) {
-      device = command_buffer_to_device_.at(command_buffer);
-    }
-
     // If we haven't recorded neither the end nor the begin of a command buffer, we have no
     // information to send.
     if (!state.command_buffer_end_slot_index.has_value()) {
@@ -951,21 +1122,23 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   void PersistDebugMarkersOfASingleCommandBufferOnSubmit(
-      VkCommandBuffer command_buffer, std::optional<QueueSubmission>* queue_submission_optional,
-      QueueMarkerState* markers, std::vector<uint32_t>* marker_slots_not_needed_to_read) {
-    mutex_.AssertHeld();
+      TrackedCommandBuffer* tracked_command_buffer,
+      std::optional<QueueSubmission>* queue_submission_optional, QueueMarkerState* markers,
+      std::vector<uint32_t>* marker_slots_not_needed_to_read)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(queue_mutex_) {
+    ORBIT_CHECK(tracked_command_buffer != nullptr);
     ORBIT_CHECK(queue_submission_optional != nullptr);
     ORBIT_CHECK(markers != nullptr);
     ORBIT_CHECK(marker_slots_not_needed_to_read != nullptr);
 
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    absl::MutexLock lock(&tracked_command_buffer->mutex);
+    if (!tracked_command_buffer->state.has_value()) {
       ORBIT_ERROR_ONCE(
           "Calling vkQueueSubmit on a command buffer that is in the initial state (i.e. "
           "either freshly allocated or reset with vkResetCommandBuffer).");
       return;
     }
-    ORBIT_CHECK(command_buffer_to_state_.contains(command_buffer));
-    const CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    const CommandBufferState& state = tracked_command_buffer->state.value();
 
     for (const Marker& marker : state.markers) {
       std::optional<SubmittedMarker> submitted_marker = std::nullopt;
@@ -1029,11 +1202,17 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
   }
 
+  // Only taken as a writer to allocate and free command buffers. Looking up a command buffer takes
+  // it as a reader, which doesn't block other threads that record or submit command buffers.
   absl::Mutex mutex_;
-  absl::flat_hash_map<VkCommandPool, absl::flat_hash_set<VkCommandBuffer>> pool_to_command_buffers_;
-  absl::flat_hash_map<VkCommandBuffer, VkDevice> command_buffer_to_device_;
+  absl::flat_hash_map<VkCommandPool, absl::flat_hash_set<VkCommandBuffer>> pool_to_command_buffers_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<VkCommandBuffer, std::unique_ptr<TrackedCommandBuffer>>
+      tracked_command_buffers_ ABSL_GUARDED_BY(mutex_);
 
-  absl::flat_hash_map<VkCommandBuffer, CommandBufferState> command_buffer_to_state_;
+  // Guards the debug marker stacks and the pending submissions of the queues. When taken together
+  // with the lock of a command buffer, this one is taken first.
+  absl::Mutex queue_mutex_;
 
   static constexpr auto kPreSubmissionCpuTimestampComparator =
       [](const QueueSubmission& lhs, const QueueSubmission& rhs) -> bool {
@@ -1043,9 +1222,9 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   absl::flat_hash_map<VkQueue,
                       std::priority_queue<QueueSubmission, std::vector<QueueSubmission>,
                                           std::function<bool(QueueSubmission, QueueSubmission)>>>
-      queue_to_submission_priority_queue_;
+      queue_to_submission_priority_queue_ ABSL_GUARDED_BY(queue_mutex_);
 
-  absl::flat_hash_map<VkQueue, QueueMarkerState> queue_to_markers_;
+  absl::flat_hash_map<VkQueue, QueueMarkerState> queue_to_markers_ ABSL_GUARDED_BY(queue_mutex_);
 
   DispatchTable* dispatch_table_;
   TimerQueryPool* timer_query_pool_;
@@ -1053,7 +1232,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   // We use std::numeric_limits<uint32_t>::max() to disable filtering of markers and 0 to discard
   // all debug markers.
-  uint32_t max_local_marker_depth_per_command_buffer_ = std::numeric_limits<uint32_t>::max();
+  std::atomic<uint32_t> max_local_marker_depth_per_command_buffer_ =
+      std::numeric_limits<uint32_t>::max();
   VulkanLayerProducer* vulkan_layer_producer_ = nullptr;
 
   // This boolean is precisely true between a call to OnCaptureStart and OnCaptureFinished. In
@@ -1062,7 +1242,9 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   // command buffers and debug markers. A consistent state allows proper cleanup of query slots
   // either in OnCaptureFinished or when completing submits. Note that calling
   // vulkan_layer_producer_->IsCapturing() is not a correct replacement for checking this boolean.
-  bool is_capturing_ = false;
+  // It is read by command buffer operations while they hold the lock of that command buffer, see
+  // `OnCaptureFinished`.
+  std::atomic<bool> is_capturing_ = false;
 };
 
 }  // namespace orbit_vulkan_layer
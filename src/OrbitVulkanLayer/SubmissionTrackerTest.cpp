@@ -12,11 +12,13 @@
 #include <vulkan/vulkan_core.h>
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -27,6 +29,7 @@
 #include "SubmissionTracker.h"
 #include "VulkanLayerProducer.h"
 
+using ::testing::_;
 using ::testing::ElementsAre;
 using ::testing::Invoke;
 using ::testing::Return;
@@ -39,6 +42,7 @@ class MockDispatchTable {
  public:
   MOCK_METHOD(PFN_vkGetQueryPoolResults, GetQueryPoolResults, (VkDevice), ());
   MOCK_METHOD(PFN_vkCmdWriteTimestamp, CmdWriteTimestamp, (VkCommandBuffer), ());
+  MOCK_METHOD(PFN_vkGetCalibratedTimestampsEXT, GetCalibratedTimestampsEXT, (VkDevice), ());
 };
 
 PFN_vkCmdWriteTimestamp dummy_write_timestamp_function =
@@ -59,6 +63,7 @@ class MockDeviceManager {
  public:
   MOCK_METHOD(VkPhysicalDevice, GetPhysicalDeviceOfLogicalDevice, (VkDevice), ());
   MOCK_METHOD(VkPhysicalDeviceProperties, GetPhysicalDeviceProperties, (VkPhysicalDevice), ());
+  MOCK_METHOD(bool, IsCaptureClockCalibrationSupported, (VkDevice), ());
 };
 
 class MockVulkanLayerProducer : public VulkanLayerProducer {
@@ -208,36 +213,22 @@ class SubmissionTrackerTest : public ::testing::Test {
   static constexpr uint64_t kTimestamp6 = 16;
   static constexpr uint64_t kTimestamp7 = 17;
 
+  // Results are requested together with their availability, for runs of consecutive slots.
   const PFN_vkGetQueryPoolResults mock_get_query_pool_results_function_all_ready_ =
       +[](VkDevice /*device*/, VkQueryPool /*queryPool*/, uint32_t first_query,
-          uint32_t query_count, size_t /*dataSize*/, void* data, VkDeviceSize /*stride*/,
+          uint32_t query_count, size_t data_size, void* data, VkDeviceSize stride,
           VkQueryResultFlags flags) -> VkResult {
-    EXPECT_EQ(query_count, 1);
     EXPECT_NE((flags & VK_QUERY_RESULT_64_BIT), 0);
-    switch (first_query) {
-      case kSlotIndex1:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp1;
-        break;
-      case kSlotIndex2:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp2;
-        break;
-      case kSlotIndex3:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp3;
-        break;
-      case kSlotIndex4:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp4;
-        break;
-      case kSlotIndex5:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp5;
-        break;
-      case kSlotIndex6:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp6;
-        break;
-      case kSlotIndex7:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp7;
-        break;
-      default:
-        ORBIT_UNREACHABLE();
+    EXPECT_NE((flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT), 0);
+    EXPECT_EQ(stride, 2 * sizeof(uint64_t));
+    EXPECT_EQ(data_size, query_count * stride);
+    for (uint32_t i = 0; i < query_count; ++i) {
+      const uint32_t slot_index = first_query + i;
+      ORBIT_CHECK(slot_index >= kSlotIndex1 && slot_index <= kSlotIndex7);
+      auto* result = absl::bit_cast<uint64_t*>(static_cast<char*>(data) + i * stride);
+      // The timestamps follow the slot indices, like kTimestamp1 to kTimestamp7.
+      result[0] = kTimestamp1 + (slot_index - kSlotIndex1);
+      result[1] = 1;
     }
     return VK_SUCCESS;
   };
@@ -546,6 +537,59 @@ TEST_F(SubmissionTrackerTest, CanRetrieveCommandBufferTimestampsForACompleteSubm
                                         tid, pid, kTimestamp1, kTimestamp2);
 }
 
+TEST_F(SubmissionTrackerTest, ConvertsTimestampsToCaptureTimestampsIfCalibrationIsSupported) {
+  ExpectTwoNextReadyQuerySlotCalls();
+  EXPECT_CALL(dispatch_table_, GetQueryPoolResults)
+      .WillRepeatedly(Return(mock_get_query_pool_results_function_all_ready_));
+  EXPECT_CALL(timer_query_pool_, MarkQuerySlotsDoneReading).Times(1);
+  static constexpr uint64_t kCalibrationGpuTimestamp = 1000;
+  static constexpr uint64_t kCalibrationCaptureTimestamp = 5000;
+  PFN_vkGetCalibratedTimestampsEXT mock_get_calibrated_timestamps_function =
+      +[](VkDevice /*device*/, uint32_t timestamp_count,
+          const VkCalibratedTimestampInfoEXT* timestamp_infos, uint64_t* timestamps,
+          uint64_t* /*max_deviation*/) -> VkResult {
+    ORBIT_CHECK(timestamp_count == 2);
+    EXPECT_EQ(timestamp_infos[0].timeDomain, VK_TIME_DOMAIN_DEVICE_EXT);
+    EXPECT_EQ(timestamp_infos[1].timeDomain, kCaptureClockTimeDomain);
+    timestamps[0] = kCalibrationGpuTimestamp;
+    timestamps[1] = kCalibrationCaptureTimestamp;
+    return VK_SUCCESS;
+  };
+  EXPECT_CALL(device_manager_, IsCaptureClockCalibrationSupported).WillRepeatedly(Return(true));
+  EXPECT_CALL(dispatch_table_, GetCalibratedTimestampsEXT)
+      .Times(1)
+      .WillOnce(Return(mock_get_calibrated_timestamps_function));
+  orbit_grpc_protos::ProducerCaptureEvent actual_capture_event;
+  auto mock_enqueue_capture_event =
+      [&actual_capture_event](orbit_grpc_protos::ProducerCaptureEvent&& capture_event) {
+        actual_capture_event = std::move(capture_event);
+        return true;
+      };
+  EXPECT_CALL(*producer_, EnqueueCaptureEvent)
+      .Times(1)
+      .WillOnce(Invoke(mock_enqueue_capture_event));
+
+  producer_->StartCapture();
+  tracker_.TrackCommandBuffers(device_, command_pool_, &command_buffer_, 1);
+  tracker_.MarkCommandBufferBegin(command_buffer_);
+  tracker_.MarkCommandBufferEnd(command_buffer_);
+  uint32_t tid = orbit_base::GetCurrentThreadId();
+  uint32_t pid = orbit_base::GetCurrentProcessId();
+  uint64_t pre_submit_time = orbit_base::CaptureTimestampNs();
+  std::optional<QueueSubmission> queue_submission_optional =
+      tracker_.PersistCommandBuffersOnSubmit(queue_, 1, &submit_info_);
+  tracker_.PersistDebugMarkersOnSubmit(queue_, 1, &submit_info_, queue_submission_optional);
+  uint64_t post_submit_time = orbit_base::CaptureTimestampNs();
+  tracker_.CompleteSubmits(device_);
+
+  constexpr uint64_t kOffset = kCalibrationCaptureTimestamp - kCalibrationGpuTimestamp;
+  ExpectSingleCommandBufferSubmissionEq(actual_capture_event, pre_submit_time, post_submit_time,
+                                        tid, pid, kTimestamp1 + kOffset, kTimestamp2 + kOffset);
+  EXPECT_TRUE(actual_capture_event.gpu_queue_submission().gpu_timestamps_are_capture_timestamps());
+  EXPECT_EQ(actual_capture_event.gpu_queue_submission().queue_id(),
+            absl::bit_cast<uintptr_t>(queue_));
+}
+
 TEST_F(SubmissionTrackerTest,
        CanRetrieveCommandBufferTimestampsForACompleteSubmissionAtALaterTime) {
   ExpectTwoNextReadyQuerySlotCalls();
@@ -592,14 +636,28 @@ TEST_F(SubmissionTrackerTest, WillRetryCompletingSubmissionsWhenTimestampQueryFa
   // second attempt.
 
   ExpectFourNextReadyQuerySlotCalls();
+  // The four slots are consecutive, so each `CompleteSubmits` reads them with a single call. In the
+  // first call, the "begin" timestamp of the second command buffer is not available yet.
+  PFN_vkGetQueryPoolResults mock_get_query_pool_results_function_third_slot_not_ready =
+      +[](VkDevice /*device*/, VkQueryPool /*queryPool*/, uint32_t first_query,
+          uint32_t query_count, size_t /*dataSize*/, void* data, VkDeviceSize stride,
+          VkQueryResultFlags /*flags*/) -> VkResult {
+    EXPECT_EQ(first_query, kSlotIndex1);
+    EXPECT_EQ(query_count, 4);
+    for (uint32_t i = 0; i < query_count; ++i) {
+      const uint32_t slot_index = first_query + i;
+      auto* result = absl::bit_cast<uint64_t*>(static_cast<char*>(data) + i * stride);
+      if (slot_index != kSlotIndex3) {
+        result[0] = kTimestamp1 + (slot_index - kSlotIndex1);
+        result[1] = 1;
+      }
+    }
+    return VK_NOT_READY;
+  };
   EXPECT_CALL(dispatch_table_, GetQueryPoolResults)
-      // The first two calls should succeed to complete the first submission.
-      .WillOnce(Return(mock_get_query_pool_results_function_all_ready_))
-      .WillOnce(Return(mock_get_query_pool_results_function_all_ready_))
-      // Fail on the second submission so that we retry on the second call.
-      .WillOnce(Return(mock_get_query_pool_results_function_all_ready_))
-      .WillOnce(Return(mock_get_query_pool_results_function_not_ready_))
-      .WillRepeatedly(Return(mock_get_query_pool_results_function_all_ready_));
+      .Times(2)
+      .WillOnce(Return(mock_get_query_pool_results_function_third_slot_not_ready))
+      .WillOnce(Return(mock_get_query_pool_results_function_all_ready_));
 
   std::vector<uint32_t> actual_slots_done_reading1;
   std::vector<uint32_t> actual_slots_done_reading2;
@@ -664,9 +722,8 @@ TEST_F(SubmissionTrackerTest, WillRetryCompletingSubmissionsWhenTimestampQueryFa
 
   EXPECT_THAT(actual_slots_done_reading1,
               UnorderedElementsAre(kSlotIndex1, kSlotIndex2, kSlotIndex4));
-  // We failed on the 4th GetQuerySlots call above, which belongs to the "begin" timestamp of the
-  // second command buffer (note that the order of calls when querying for timestamps is to query
-  // for the end timestamp first). Therefore, this must be kSlotIndex3.
+  // Only kSlotIndex3, the "begin" timestamp of the second command buffer, was missing in the first
+  // attempt.
   EXPECT_THAT(actual_slots_done_reading2, UnorderedElementsAre(kSlotIndex3));
 
   ExpectSingleCommandBufferSubmissionEq(actual_capture_events[0], pre_submit_times[0],
@@ -1880,4 +1937,92 @@ TEST_F(SubmissionTrackerTest, WillWriteTimestampEvenWhenCommandBufferIsNotInInit
 
   EXPECT_THAT(actual_slots_to_reset, UnorderedElementsAre(kSlotIndex1, kSlotIndex2));
 }
+
+TEST_F(SubmissionTrackerTest, CommandBuffersCanBeRecordedAndSubmittedOnMultipleThreads) {
+  constexpr size_t kNumThreads = 8;
+  constexpr size_t kNumCommandBuffersPerThread = 200;
+
+  std::atomic<uint32_t> next_slot_index = 0;
+  EXPECT_CALL(timer_query_pool_, NextReadyQuerySlot)
+      .WillRepeatedly(Invoke([&next_slot_index](VkDevice /*device*/, uint32_t* slot_index) {
+        *slot_index = next_slot_index++;
+        return true;
+      }));
+  // Every query succeeds and returns the slot index as timestamp.
+  PFN_vkGetQueryPoolResults mock_get_query_pool_results_function =
+      +[](VkDevice /*device*/, VkQueryPool /*queryPool*/, uint32_t first_query,
+          uint32_t query_count, size_t /*dataSize*/, void* data, VkDeviceSize stride,
+          VkQueryResultFlags /*flags*/) -> VkResult {
+    for (uint32_t i = 0; i < query_count; ++i) {
+      auto* result = absl::bit_cast<uint64_t*>(static_cast<char*>(data) + i * stride);
+      result[0] = first_query + i;
+      result[1] = 1;
+    }
+    return VK_SUCCESS;
+  };
+  EXPECT_CALL(dispatch_table_, GetQueryPoolResults)
+      .WillRepeatedly(Return(mock_get_query_pool_results_function));
+  EXPECT_CALL(timer_query_pool_, MarkQuerySlotsDoneReading).Times(testing::AnyNumber());
+  EXPECT_CALL(timer_query_pool_, MarkQuerySlotsForReset).Times(testing::AnyNumber());
+  EXPECT_CALL(*producer_, InternStringIfNecessaryAndGetKey).WillRepeatedly(Return(1));
+
+  std::atomic<int> num_command_buffers_sent = 0;
+  std::atomic<int> num_markers_sent = 0;
+  EXPECT_CALL(*producer_, EnqueueCaptureEvent(_))
+      .WillRepeatedly(Invoke([&num_command_buffers_sent, &num_markers_sent](
+                                 orbit_grpc_protos::ProducerCaptureEvent&& capture_event) {
+        const orbit_grpc_protos::GpuQueueSubmission& submission =
+            capture_event.gpu_queue_submission();
+        for (const orbit_grpc_protos::GpuSubmitInfo& submit_info : submission.submit_infos()) {
+          num_command_buffers_sent += submit_info.command_buffers_size();
+        }
+        num_markers_sent += submission.completed_markers_size();
+        return true;
+      }));
+
+  producer_->StartCapture();
+
+  std::vector<std::thread> threads;
+  for (size_t thread_index = 0; thread_index < kNumThreads; ++thread_index) {
+    threads.emplace_back([this, thread_index] {
+      // Each thread uses its own command pool and queue, as Vulkan requires for recording and
+      // submitting without external synchronization.
+      auto command_pool = absl::bit_cast<VkCommandPool>(thread_index + 1);
+      auto queue = absl::bit_cast<VkQueue>(thread_index + 1);
+      std::vector<VkCommandBuffer> command_buffers;
+      for (size_t i = 0; i < kNumCommandBuffersPerThread; ++i) {
+        command_buffers.push_back(
+            absl::bit_cast<VkCommandBuffer>(thread_index * kNumCommandBuffersPerThread + i + 1));
+      }
+      tracker_.TrackCommandBuffers(device_, command_pool, command_buffers.data(),
+                                   command_buffers.size());
+
+      for (VkCommandBuffer& command_buffer : command_buffers) {
+        tracker_.MarkCommandBufferBegin(command_buffer);
+        tracker_.MarkDebugMarkerBegin(command_buffer, "Marker", {});
+        tracker_.MarkDebugMarkerEnd(command_buffer);
+        tracker_.MarkCommandBufferEnd(command_buffer);
+
+        VkSubmitInfo submit_info = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                    .pNext = nullptr,
+                                    .commandBufferCount = 1,
+                                    .pCommandBuffers = &command_buffer};
+        std::optional<QueueSubmission> queue_submission_optional =
+            tracker_.PersistCommandBuffersOnSubmit(queue, 1, &submit_info);
+        tracker_.PersistDebugMarkersOnSubmit(queue, 1, &submit_info, queue_submission_optional);
+        tracker_.CompleteSubmits(device_);
+      }
+
+      tracker_.UntrackCommandBuffers(device_, command_pool, command_buffers.data(),
+                                     command_buffers.size());
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(num_command_buffers_sent, kNumThreads * kNumCommandBuffersPerThread);
+  EXPECT_EQ(num_markers_sent, kNumThreads * kNumCommandBuffersPerThread);
+  EXPECT_EQ(next_slot_index, 4 * kNumThreads * kNumCommandBuffersPerThread);
+}
 }  // namespace orbit_vulkan_layer
@@ -11,6 +11,7 @@
 #include <absl/types/span.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
 #include <fstream>
 #include <numeric>
 #include <vector>
@@ -154,6 +155,7 @@ class TimerQueryPool {
     std::vector<SlotState>& slot_states = device_to_query_slots_.at(device);
     ORBIT_CHECK(device_to_free_slots_.contains(device));
     std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
+    std::vector<uint32_t> slots_to_reset;
     for (uint32_t slot_index : slot_indices) {
       ORBIT_CHECK(slot_index < num_timer_query_slots_);
       const SlotState& current_state = slot_states[slot_index];
@@ -164,9 +166,9 @@ class TimerQueryPool {
       ORBIT_CHECK(current_state == SlotState::kResetRequested);
       slot_states[slot_index] = SlotState::kReadyForQueryIssue;
       free_slots.push_back(slot_index);
-      VkQueryPool query_pool = device_to_query_pool_.at(device);
-      dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, slot_index, 1);
+      slots_to_reset.push_back(slot_index);
     }
+    ResetQuerySlotsOnVulkan(device, &slots_to_reset);
   }
 
   // Marks that the underlying slots are not used by any command buffer anymore
@@ -189,6 +191,7 @@ class TimerQueryPool {
     std::vector<SlotState>& slot_states = device_to_query_slots_.at(device);
     ORBIT_CHECK(device_to_free_slots_.contains(device));
     std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
+    std::vector<uint32_t> slots_to_reset;
     for (uint32_t slot_index : slot_indices) {
       ORBIT_CHECK(slot_index < num_timer_query_slots_);
       const SlotState& current_state = slot_states[slot_index];
@@ -199,9 +202,9 @@ class TimerQueryPool {
       ORBIT_CHECK(current_state == SlotState::kDoneReading);
       slot_states[slot_index] = SlotState::kReadyForQueryIssue;
       free_slots.push_back(slot_index);
-      VkQueryPool query_pool = device_to_query_pool_.at(device);
-      dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, slot_index, 1);
+      slots_to_reset.push_back(slot_index);
     }
+    ResetQuerySlotsOnVulkan(device, &slots_to_reset);
   }
 
   // Resets an occupied slot to be ready for queries again. It will *not* call to Vulkan to reset
@@ -238,6 +241,29 @@ class TimerQueryPool {
     kResetRequested = 3
   };
 
+  // Resets the given slots on Vulkan with one call per run of consecutive slot indices, as the
+  // slots of a completed submission are usually read and recycled together.
+  void ResetQuerySlotsOnVulkan(VkDevice device, std::vector<uint32_t>* slot_indices)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    if (slot_indices->empty()) {
+      return;
+    }
+    std::sort(slot_indices->begin(), slot_indices->end());
+    VkQueryPool query_pool = device_to_query_pool_.at(device);
+    PFN_vkResetQueryPoolEXT reset_query_pool_function = dispatch_table_->ResetQueryPoolEXT(device);
+    size_t run_begin = 0;
+    while (run_begin < slot_indices->size()) {
+      size_t run_end = run_begin + 1;
+      while (run_end < slot_indices->size() &&
+             (*slot_indices)[run_end] == (*slot_indices)[run_end - 1] + 1) {
+        ++run_end;
+      }
+      reset_query_pool_function(device, query_pool, (*slot_indices)[run_begin],
+                                static_cast<uint32_t>(run_end - run_begin));
+      run_begin = run_end;
+    }
+  }
+
   DispatchTable* dispatch_table_;
   const uint32_t num_timer_query_slots_;
 
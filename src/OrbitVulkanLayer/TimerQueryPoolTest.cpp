@@ -11,10 +11,12 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "TimerQueryPool.h"
 
+using ::testing::ElementsAre;
 using ::testing::Return;
 
 namespace orbit_vulkan_layer {
@@ -339,6 +341,36 @@ TEST(TimerQueryPool, ResettingSlotsDoesResetOnVulkan) {
   query_pool.MarkQuerySlotsForReset(device, reset_slots);
 }
 
+TEST(TimerQueryPool, ResettingConsecutiveSlotsDoesResetThemInOneCall) {
+  MockDispatchTable dispatch_table;
+  static constexpr uint32_t kNumSlots = 4;
+  TimerQueryPool<MockDispatchTable> query_pool(&dispatch_table, kNumSlots);
+  VkDevice device = {};
+  EXPECT_CALL(dispatch_table, CreateQueryPool)
+      .WillRepeatedly(Return(dummy_create_query_pool_function));
+
+  static std::vector<std::pair<uint32_t, uint32_t>> actual_resets;
+  actual_resets.clear();
+  PFN_vkResetQueryPoolEXT mock_reset_query_pool_function =
+      +[](VkDevice /*device*/, VkQueryPool /*query_pool*/, uint32_t first_query,
+          uint32_t query_count) { actual_resets.emplace_back(first_query, query_count); };
+  EXPECT_CALL(dispatch_table, ResetQueryPoolEXT)
+      .WillOnce(Return(dummy_reset_query_pool_function))
+      .WillRepeatedly(Return(mock_reset_query_pool_function));
+
+  query_pool.InitializeTimerQueryPool(device);
+  std::vector<uint32_t> slots(kNumSlots);
+  for (uint32_t& slot : slots) {
+    ASSERT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+  }
+  query_pool.MarkQuerySlotsDoneReading(device, slots);
+  EXPECT_TRUE(actual_resets.empty());
+
+  // Slots 0, 1 and 3, in no particular order.
+  query_pool.MarkQuerySlotsForReset(device, std::vector<uint32_t>{3, 0, 1});
+  EXPECT_THAT(actual_resets, ElementsAre(std::make_pair(0, 2), std::make_pair(3, 1)));
+}
+
 TEST(TimerQueryPool, CannotRollbackReadySlots) {
   MockDispatchTable dispatch_table;
   static constexpr uint32_t kNumSlots = 1;
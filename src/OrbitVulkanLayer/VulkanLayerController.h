@@ -165,6 +165,11 @@ class VulkanLayerController {
     // Add our required extension (if not already present), to the extensions requested by the game.
     AddRequiredDeviceExtensionNameIfMissing(
         create_info, physical_device, VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME, &all_extension_names);
+    // With this extension, GPU timestamps can be calibrated against the capture clock in the layer
+    // (see `SubmissionTracker`), which would otherwise require the GPU driver tracepoints.
+    AddOptionalDeviceExtensionNameIfMissingAndSupported(create_info, physical_device,
+                                                        VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME,
+                                                        &all_extension_names);
 
     // Expose the c-strings (but ensure, the std::strings stay in memory!).
     std::vector<const char*> all_extension_names_cstr{};
@@ -629,7 +634,9 @@ class VulkanLayerController {
   void InitVulkanLayerProducerIfNecessary() {
     absl::MutexLock lock{&vulkan_layer_producer_mutex_};
     if (vulkan_layer_producer_ == nullptr) {
-      vulkan_layer_producer_ = std::make_unique<VulkanLayerProducerImpl>();
+      auto vulkan_layer_producer = std::make_unique<VulkanLayerProducerImpl>();
+      vulkan_layer_producer->UseSharedMemoryBuffer();
+      vulkan_layer_producer_ = std::move(vulkan_layer_producer);
       ORBIT_LOG("Bringing up VulkanLayerProducer");
       vulkan_layer_producer_->BringUp(orbit_producer_side_channel::CreateProducerSideChannel());
       submission_tracker_.SetVulkanLayerProducer(vulkan_layer_producer_.get());
@@ -664,8 +671,10 @@ class VulkanLayerController {
     }
   }
 
+  // Returns whether the extension is enabled in the end, i.e. false only if it was missing and is
+  // not supported.
   template <typename CreateInfoT>
-  void AddRequiredExtensionNameIfMissing(
+  [[nodiscard]] bool AddExtensionNameIfMissingAndSupported(
       const CreateInfoT* create_info,
       const std::function<VkResult(uint32_t*, VkExtensionProperties*)>&
           enumerate_extension_properties_function,
@@ -697,17 +706,39 @@ class VulkanLayerController {
         }
       }
 
-      ORBIT_FAIL_IF(!extension_supported,
-                    "Orbit's Vulkan layer requires the %s extension to be supported.",
-                    extension_name);
+      if (!extension_supported) {
+        return false;
+      }
       output->emplace_back(extension_name);
     }
+    return true;
+  }
+
+  template <typename CreateInfoT>
+  void AddRequiredExtensionNameIfMissing(
+      const CreateInfoT* create_info,
+      const std::function<VkResult(uint32_t*, VkExtensionProperties*)>&
+          enumerate_extension_properties_function,
+      const char* extension_name, std::vector<std::string>* output) {
+    ORBIT_FAIL_IF(!AddExtensionNameIfMissingAndSupported(
+                      create_info, enumerate_extension_properties_function, extension_name, output),
+                  "Orbit's Vulkan layer requires the %s extension to be supported.",
+                  extension_name);
   }
 
   void AddRequiredDeviceExtensionNameIfMissing(const VkDeviceCreateInfo* create_info,
                                                VkPhysicalDevice physical_device,
                                                const char* extension_name,
                                                std::vector<std::string>* output) {
+    ORBIT_FAIL_IF(!AddOptionalDeviceExtensionNameIfMissingAndSupported(create_info, physical_device,
+                                                                       extension_name, output),
+                  "Orbit's Vulkan layer requires the %s extension to be supported.",
+                  extension_name);
+  }
+
+  bool AddOptionalDeviceExtensionNameIfMissingAndSupported(
+      const VkDeviceCreateInfo* create_info, VkPhysicalDevice physical_device,
+      const char* extension_name, std::vector<std::string>* output) {
     auto raw_enumerate_device_extension_properties_function =
         absl::bit_cast<PFN_vkEnumerateDeviceExtensionProperties>(
             dispatch_table_.EnumerateDeviceExtensionProperties(physical_device));
@@ -717,8 +748,8 @@ class VulkanLayerController {
       return raw_enumerate_device_extension_properties_function(physical_device, nullptr, count,
                                                                 properties);
     };
-    AddRequiredExtensionNameIfMissing(create_info, enumerate_device_extension_properties,
-                                      extension_name, output);
+    return AddExtensionNameIfMissingAndSupported(create_info, enumerate_device_extension_properties,
+                                                 extension_name, output);
   }
 
   void AddRequiredInstanceExtensionNameIfMissing(const VkInstanceCreateInfo* create_info,
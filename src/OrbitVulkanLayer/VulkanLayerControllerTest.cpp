@@ -743,11 +743,13 @@ TEST_F(
     return VK_SUCCESS;
   };
 
+  // Once for the required and once for the optional extensions.
   EXPECT_CALL(*dispatch_table, EnumerateDeviceExtensionProperties)
-      .Times(1)
-      .WillOnce(Invoke([](VkPhysicalDevice /*device*/) -> PFN_vkEnumerateDeviceExtensionProperties {
-        return kFakeEnumerateDeviceExtensionProperties;
-      }));
+      .Times(2)
+      .WillRepeatedly(
+          Invoke([](VkPhysicalDevice /*device*/) -> PFN_vkEnumerateDeviceExtensionProperties {
+            return kFakeEnumerateDeviceExtensionProperties;
+          }));
 
   PFN_vkGetDeviceProcAddr fake_get_device_proc_addr =
       +[](VkDevice /*device*/, const char* /*name*/) -> PFN_vkVoidFunction { return nullptr; };
@@ -836,6 +838,10 @@ TEST_F(VulkanLayerControllerTest,
     }
     return nullptr;
   };
+  // The optional extensions are still looked up.
+  EXPECT_CALL(*dispatch_table, EnumerateDeviceExtensionProperties)
+      .Times(1)
+      .WillOnce(Return(kFakeEnumerateDeviceExtensionProperties));
 
   VkLayerDeviceLink layer_link_1 = {.pfnNextGetInstanceProcAddr = fake_get_instance_proc_addr,
                                     .pfnNextGetDeviceProcAddr = fake_get_device_proc_addr};
@@ -856,6 +862,73 @@ TEST_F(VulkanLayerControllerTest,
   EXPECT_EQ(result, VK_SUCCESS);
 }
 
+TEST_F(VulkanLayerControllerTest,
+       WillEnableCalibratedTimestampsExtensionOnCreateDeviceIfSupported) {
+  const MockDispatchTable* dispatch_table = controller_.dispatch_table();
+  EXPECT_CALL(*dispatch_table, CreateDeviceDispatchTable).Times(1);
+  const MockDeviceManager* device_manager = controller_.device_manager();
+  EXPECT_CALL(*device_manager, TrackLogicalDevice).Times(1);
+  const MockTimerQueryPool* timer_query_pool = controller_.timer_query_pool();
+  EXPECT_CALL(*timer_query_pool, InitializeTimerQueryPool).Times(1);
+
+  static constexpr PFN_vkCreateDevice kMockDriverCreateDevice =
+      +[](VkPhysicalDevice /*physical_device*/, const VkDeviceCreateInfo* create_info,
+          const VkAllocationCallbacks* /*allocator*/, VkDevice* /*instance*/) {
+        bool requested_calibrated_timestamps_extension = false;
+        for (uint32_t i = 0; i < create_info->enabledExtensionCount; ++i) {
+          if (strcmp(create_info->ppEnabledExtensionNames[i],
+                     VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0) {
+            requested_calibrated_timestamps_extension = true;
+            break;
+          }
+        }
+        EXPECT_TRUE(requested_calibrated_timestamps_extension);
+        return VK_SUCCESS;
+      };
+  static constexpr PFN_vkEnumerateDeviceExtensionProperties
+      kFakeEnumerateDeviceExtensionProperties =
+          +[](VkPhysicalDevice /*physical_device*/, const char* /*layer_name*/,
+              uint32_t* property_count, VkExtensionProperties* properties) -> VkResult {
+    ORBIT_CHECK(property_count != nullptr);
+    if (properties == nullptr) {
+      *property_count = 2;
+      return VK_SUCCESS;
+    }
+    properties[0] = VkExtensionProperties{VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME,
+                                          VK_EXT_HOST_QUERY_RESET_SPEC_VERSION};
+    properties[1] = VkExtensionProperties{VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME,
+                                          VK_EXT_CALIBRATED_TIMESTAMPS_SPEC_VERSION};
+    return VK_SUCCESS;
+  };
+  EXPECT_CALL(*dispatch_table, EnumerateDeviceExtensionProperties)
+      .WillRepeatedly(Return(kFakeEnumerateDeviceExtensionProperties));
+
+  PFN_vkGetDeviceProcAddr fake_get_device_proc_addr =
+      +[](VkDevice /*device*/, const char* /*name*/) -> PFN_vkVoidFunction { return nullptr; };
+  PFN_vkGetInstanceProcAddr fake_get_instance_proc_addr =
+      +[](VkInstance /*instance*/, const char* name) -> PFN_vkVoidFunction {
+    if (strcmp(name, "vkCreateDevice") == 0) {
+      return absl::bit_cast<PFN_vkVoidFunction>(kMockDriverCreateDevice);
+    }
+    return nullptr;
+  };
+
+  VkLayerDeviceLink layer_link = {.pfnNextGetInstanceProcAddr = fake_get_instance_proc_addr,
+                                  .pfnNextGetDeviceProcAddr = fake_get_device_proc_addr};
+  VkLayerDeviceCreateInfo layer_create_info{.sType = VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO,
+                                            .function = VK_LAYER_LINK_INFO};
+  layer_create_info.u.pLayerInfo = &layer_link;
+  VkDeviceCreateInfo create_info{.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                                 .pNext = &layer_create_info,
+                                 .enabledExtensionCount = 0,
+                                 .ppEnabledExtensionNames = nullptr};
+  VkPhysicalDevice physical_device = {};
+  VkDevice created_device{};
+  VkResult result =
+      controller_.OnCreateDevice(physical_device, &create_info, nullptr, &created_device);
+  EXPECT_EQ(result, VK_SUCCESS);
+}
+
 TEST_F(VulkanLayerControllerTest, CallInDispatchTableOnGetInstanceProcAddr) {
   const MockDispatchTable* dispatch_table = controller_.dispatch_table();
   static constexpr PFN_vkVoidFunction kExpectedFunction = +[]() {};
@@ -34,11 +34,15 @@ class VulkanLayerProducerImpl : public VulkanLayerProducer {
 
   void TakeDown() override { lock_free_producer_.ShutdownAndWait(); }
 
+  // Makes the CaptureEvents go through a ring buffer in memory shared with OrbitService instead of
+  // gRPC. Needs to be called before BringUp.
+  void UseSharedMemoryBuffer() { lock_free_producer_.UseSharedMemoryBuffer(); }
+
   [[nodiscard]] bool IsCapturing() override { return lock_free_producer_.IsCapturing(); }
 
   bool EnqueueCaptureEvent(orbit_grpc_protos::ProducerCaptureEvent&& capture_event) override {
     return lock_free_producer_.EnqueueIntermediateEventIfCapturing(
-        [&capture_event] { return capture_event; });
+        [&capture_event] { return std::move(capture_event); });
   }
 
   [[nodiscard]] uint64_t InternStringIfNecessaryAndGetKey(std::string str) override;
@@ -52,6 +56,8 @@ class VulkanLayerProducerImpl : public VulkanLayerProducer {
    public:
     explicit LockFreeBufferVulkanLayerProducer(VulkanLayerProducerImpl* outer) : outer_{outer} {}
 
+    using LockFreeBufferCaptureEventProducer::UseSharedMemoryBuffer;
+
    protected:
     void OnCaptureStart(orbit_grpc_protos::CaptureOptions capture_options) override {
       LockFreeBufferCaptureEventProducer::OnCaptureStart(capture_options);
@@ -78,17 +84,11 @@ class VulkanLayerProducerImpl : public VulkanLayerProducer {
 
     orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
         orbit_grpc_protos::ProducerCaptureEvent&& intermediate_event,
-        google::protobuf::Arena* arena) override {
-      auto* capture_event =
-          google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
-      // Note that, as capture_event is in the Arena and intermediate_event is on the heap, this
-      // std::move will actually end up being a copy, as it will use CopyFrom internally.
-      // For the amount of events that this Vulkan layer produces, this is fine performance-wise.
-      // This is also in line with the principle of this method, which in general expects a
-      // transformation from any type that intermediate_event could be to the ProducerCaptureEvent
-      // protobuf.
-      *capture_event = std::move(intermediate_event);
-      return capture_event;
+        google::protobuf::Arena* /*arena*/) override {
+      // The event is moved to a new heap-allocated message instead of being copied into the Arena,
+      // which would copy all of its fields. As the message is not on the Arena, the
+      // RepeatedPtrField it is added to makes the Arena own it.
+      return new orbit_grpc_protos::ProducerCaptureEvent(std::move(intermediate_event));
     }
 
    private:
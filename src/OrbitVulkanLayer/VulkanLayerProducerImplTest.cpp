@@ -23,6 +23,8 @@
 
 #include "FakeProducerSideService/FakeProducerSideService.h"
 #include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/SharedMemoryRingBuffer.h"
 #include "VulkanLayerProducer.h"
 #include "VulkanLayerProducerImpl.h"
 
@@ -52,6 +54,14 @@ class VulkanLayerProducerImplTest : public ::testing::Test {
 
     producer_.emplace();
     producer_->SetCaptureStatusListener(&mock_listener_);
+    if (use_shared_memory_buffer_) {
+      EXPECT_CALL(*fake_service_, OnSharedMemoryBufferCreatedReceived)
+          .WillOnce([this](const std::string& name) {
+            absl::MutexLock lock{&shared_memory_buffer_name_mutex_};
+            shared_memory_buffer_name_ = name;
+          });
+      producer_->UseSharedMemoryBuffer();
+    }
     producer_->BringUp(channel);
 
     // Leave some time for the ReceiveCommandsAndSendEvents RPC to actually happen.
@@ -78,6 +88,10 @@ class VulkanLayerProducerImplTest : public ::testing::Test {
   std::optional<VulkanLayerProducerImpl> producer_;
   MockCaptureStatusListener mock_listener_;
 
+  bool use_shared_memory_buffer_ = false;
+  std::string shared_memory_buffer_name_ ABSL_GUARDED_BY(shared_memory_buffer_name_mutex_);
+  absl::Mutex shared_memory_buffer_name_mutex_;
+
   static const std::string kInternedString1;
   static const uint64_t kExpectedInternedString1Key;
   static const std::string kInternedString2;
@@ -565,5 +579,54 @@ TEST_F(VulkanLayerProducerImplTest, InternOnlyWhenCapturing) {
   fake_service_->SendCaptureFinishedCommand();
 }
 
+class VulkanLayerProducerImplWithSharedMemoryBufferTest : public VulkanLayerProducerImplTest {
+ protected:
+  VulkanLayerProducerImplWithSharedMemoryBufferTest() { use_shared_memory_buffer_ = true; }
+};
+
+TEST_F(VulkanLayerProducerImplWithSharedMemoryBufferTest, EnqueueCaptureEventWritesToBuffer) {
+  std::string shared_memory_buffer_name;
+  {
+    absl::MutexLock lock{&shared_memory_buffer_name_mutex_};
+    shared_memory_buffer_name = shared_memory_buffer_name_;
+  }
+  ASSERT_FALSE(shared_memory_buffer_name.empty());
+  ErrorMessageOr<orbit_base::SharedMemoryRingBuffer> buffer_or_error =
+      orbit_base::SharedMemoryRingBuffer::Open(shared_memory_buffer_name);
+  ASSERT_FALSE(buffer_or_error.has_error()) << buffer_or_error.error().message();
+
+  EXPECT_CALL(mock_listener_, OnCaptureStart(CaptureOptionsEq(kFakeCaptureOptions))).Times(1);
+  fake_service_->SendStartCaptureCommand(kFakeCaptureOptions);
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+
+  ::testing::Mock::VerifyAndClearExpectations(&mock_listener_);
+
+  EXPECT_CALL(*fake_service_, OnCaptureEventsReceived).Times(0);
+  for (uint64_t key : {1, 2, 3}) {
+    orbit_grpc_protos::ProducerCaptureEvent capture_event;
+    capture_event.mutable_interned_string()->set_key(key);
+    EXPECT_TRUE(producer_->EnqueueCaptureEvent(std::move(capture_event)));
+  }
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+
+  std::vector<uint64_t> keys;
+  ErrorMessageOr<uint64_t> record_count_or_error =
+      buffer_or_error.value().ReadRecords([&keys](absl::Span<const char> record) {
+        orbit_grpc_protos::ProducerCaptureEvent capture_event;
+        ASSERT_TRUE(capture_event.ParseFromArray(record.data(), static_cast<int>(record.size())));
+        keys.push_back(capture_event.interned_string().key());
+      });
+  ASSERT_FALSE(record_count_or_error.has_error()) << record_count_or_error.error().message();
+  EXPECT_EQ(record_count_or_error.value(), 3);
+  EXPECT_THAT(keys, ::testing::ElementsAre(1, 2, 3));
+
+  ::testing::Mock::VerifyAndClearExpectations(&*fake_service_);
+
+  EXPECT_CALL(mock_listener_, OnCaptureStop).Times(1);
+  EXPECT_CALL(*fake_service_, OnAllEventsSentReceived).Times(1);
+  fake_service_->SendStopCaptureCommand();
+  std::this_thread::sleep_for(kWaitMessagesSentDuration);
+}
+
 }  // namespace
 }  // namespace orbit_vulkan_layer
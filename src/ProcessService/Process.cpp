@@ -47,6 +47,11 @@ void Process::UpdateCpuUsage(Jiffies process_cpu_time, TotalCpuTime total_cpu_ti
 }
 
 ErrorMessageOr<Process> Process::FromPid(uint32_t pid) {
+  return FromPid(pid, orbit_process_service::GetCumulativeTotalCpuTime());
+}
+
+ErrorMessageOr<Process> Process::FromPid(uint32_t pid,
+                                         const std::optional<TotalCpuTime>& total_cpu_time) {
   const auto path = std::filesystem::path{"/proc"} / std::to_string(pid);
 
   OUTCOME_TRY(const bool is_directory, orbit_base::IsDirectory(path));
@@ -72,11 +77,11 @@ ErrorMessageOr<Process> Process::FromPid(uint32_t pid) {
   process.process_info_.set_pid(pid);
   process.process_info_.set_name(name);
 
-  const auto total_cpu_time = orbit_process_service::GetCumulativeTotalCpuTime();
-  const auto cpu_time =
-      orbit_process_service::GetCumulativeCpuTimeFromProcess(process.process_info().pid());
-  if (cpu_time && total_cpu_time) {
-    process.UpdateCpuUsage(cpu_time.value(), total_cpu_time.value());
+  const std::optional<orbit_process_service::ProcessStat> process_stat =
+      orbit_process_service::GetProcessStat(process.process_info().pid());
+  if (process_stat.has_value()) process.start_time_ = process_stat->start_time;
+  if (process_stat.has_value() && total_cpu_time.has_value()) {
+    process.UpdateCpuUsage(process_stat->cpu_time, total_cpu_time.value());
   } else {
     ORBIT_LOG("Could not update the CPU usage of process %u", process.process_info().pid());
   }
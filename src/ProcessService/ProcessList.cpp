@@ -10,11 +10,13 @@
 #include <stdint.h>
 
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <system_error>
 
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
+#include "ProcessService/CpuTime.h"
 #include "ProcessService/Process.h"
 #include "ProcessServiceUtils.h"
 
@@ -22,6 +24,11 @@ namespace orbit_process_service_internal {
 
 ErrorMessageOr<void> ProcessList::Refresh() {
   absl::flat_hash_map<pid_t, Process> updated_processes{};
+  updated_processes.reserve(processes_.size());
+
+  // The total CPU time only changes slightly while iterating the processes, so it is read once.
+  const std::optional<TotalCpuTime> total_cpu_time =
+      orbit_process_service::GetCumulativeTotalCpuTime();
 
   // TODO(b/161423785): This for loop should be refactored. For example, when
   //  parts are in a separate function, OUTCOME_TRY could be used to simplify
@@ -55,23 +62,27 @@ ErrorMessageOr<void> ProcessList::Refresh() {
     const auto iter = processes_.find(pid);
 
     if (iter != processes_.end()) {
-      auto process = processes_.extract(iter);
-
-      const auto total_cpu_time = orbit_process_service::GetCumulativeTotalCpuTime();
-      const auto cpu_time = orbit_process_service::GetCumulativeCpuTimeFromProcess(process.key());
-      if (cpu_time && total_cpu_time) {
-        process.mapped().UpdateCpuUsage(cpu_time.value(), total_cpu_time.value());
-      } else {
-        // We don't fail in this case. This could be a permission problem which might occur when not
-        // running as root.
-        ORBIT_ERROR("Could not update the CPU usage of process %d", process.key());
+      // The name, command line, executable and build id of a known process don't change, so only
+      // its CPU usage is updated, unless the pid now belongs to a different process.
+      const std::optional<orbit_process_service::ProcessStat> process_stat =
+          orbit_process_service::GetProcessStat(pid);
+      if (!process_stat.has_value() || process_stat->start_time == iter->second.start_time()) {
+        auto process = processes_.extract(iter);
+
+        if (process_stat.has_value() && total_cpu_time.has_value()) {
+          process.mapped().UpdateCpuUsage(process_stat->cpu_time, total_cpu_time.value());
+        } else {
+          // We don't fail in this case. This could be a permission problem which might occur when
+          // not running as root.
+          ORBIT_ERROR("Could not update the CPU usage of process %d", process.key());
+        }
+
+        updated_processes.insert(std::move(process));
+        continue;
       }
-
-      updated_processes.insert(std::move(process));
-      continue;
     }
 
-    auto process_or_error = Process::FromPid(pid);
+    auto process_or_error = Process::FromPid(pid, total_cpu_time);
 
     if (process_or_error.has_error()) {
       // We don't fail in this case. This could be a permission problem which is restricted to a
@@ -12,6 +12,8 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "GrpcProtos/module.pb.h"
@@ -23,6 +25,7 @@
 #include "OrbitBase/Result.h"
 #include "OrbitBase/ThreadUtils.h"
 #include "ProcessServiceUtils.h"
+#include "Symbols/CompressedFile.h"
 
 namespace orbit_process_service {
 
@@ -38,13 +41,37 @@ using orbit_grpc_protos::GetModuleListRequest;
 using orbit_grpc_protos::GetModuleListResponse;
 using orbit_grpc_protos::GetProcessListRequest;
 using orbit_grpc_protos::GetProcessListResponse;
+using orbit_grpc_protos::GetProcessMemoryRangesRequest;
+using orbit_grpc_protos::GetProcessMemoryRangesResponse;
 using orbit_grpc_protos::GetProcessMemoryRequest;
 using orbit_grpc_protos::GetProcessMemoryResponse;
 using orbit_grpc_protos::ProcessInfo;
+using orbit_grpc_protos::ResolveAddressesRequest;
+using orbit_grpc_protos::ResolveAddressesResponse;
+
+namespace {
+
+constexpr const char* kCompressedDebugInfoFilesDirectory = "/tmp/orbit_compressed_debug_info";
+
+}  // namespace
+
+ProcessServiceImpl::ProcessServiceImpl() {
+  warm_up_thread_ = std::thread([this] {
+    orbit_base::SetCurrentThreadName("ProcListWarmUp");
+    absl::MutexLock lock(&mutex_);
+    const auto refresh_result = process_list_.Refresh();
+    if (refresh_result.has_error()) {
+      ORBIT_ERROR("Reading the process list at startup: %s", refresh_result.error().message());
+    }
+  });
+}
+
+ProcessServiceImpl::~ProcessServiceImpl() { warm_up_thread_.join(); }
 
 Status ProcessServiceImpl::GetProcessList(ServerContext* /*context*/,
                                           const GetProcessListRequest* /*request*/,
                                           GetProcessListResponse* response) {
+  std::vector<ProcessInfo> processes;
   {
     absl::MutexLock lock(&mutex_);
 
@@ -52,15 +79,15 @@ Status ProcessServiceImpl::GetProcessList(ServerContext* /*context*/,
     if (refresh_result.has_error()) {
       return {StatusCode::INTERNAL, refresh_result.error().message()};
     }
+    processes = process_list_.GetProcesses();
   }
 
-  const std::vector<ProcessInfo>& processes = process_list_.GetProcesses();
   if (processes.empty()) {
     return {StatusCode::NOT_FOUND, "Error while getting processes."};
   }
 
-  for (const auto& process_info : process_list_.GetProcesses()) {
-    *(response->add_processes()) = process_info;
+  for (ProcessInfo& process_info : processes) {
+    *(response->add_processes()) = std::move(process_info);
   }
 
   return Status::OK;
@@ -104,6 +131,28 @@ Status ProcessServiceImpl::GetProcessMemory(ServerContext* /*context*/,
                           request->address(), request->pid())};
 }
 
+Status ProcessServiceImpl::GetProcessMemoryRanges(ServerContext* /*context*/,
+                                                  const GetProcessMemoryRangesRequest* request,
+                                                  GetProcessMemoryRangesResponse* response) {
+  ORBIT_CHECK(request != nullptr);
+
+  // Ranges beyond the maximum response size are requested with size zero, so that the response
+  // still has one entry per range.
+  std::vector<MemoryRange> ranges;
+  ranges.reserve(request->ranges_size());
+  uint64_t total_size = 0;
+  for (const orbit_grpc_protos::MemoryRange& range : request->ranges()) {
+    const uint64_t size = std::min(range.size(), kMaxGetProcessMemoryResponseSize - total_size);
+    total_size += size;
+    ranges.push_back({range.address(), size});
+  }
+
+  for (std::string& memory : ReadProcessMemoryRanges(request->pid(), ranges)) {
+    *response->add_memory() = std::move(memory);
+  }
+  return Status::OK;
+}
+
 Status ProcessServiceImpl::GetDebugInfoFile(ServerContext* /*context*/,
                                             const GetDebugInfoFileRequest* request,
                                             GetDebugInfoFileResponse* response) {
@@ -120,7 +169,62 @@ Status ProcessServiceImpl::GetDebugInfoFile(ServerContext* /*context*/,
   if (orbit_base::IsNotFound(find_result)) {
     return Status{StatusCode::NOT_FOUND, orbit_base::GetNotFoundMessage(find_result)};
   }
-  response->set_debug_info_file_path(orbit_base::GetFound(find_result));
+  const std::filesystem::path& debug_info_file_path = orbit_base::GetFound(find_result);
+  response->set_debug_info_file_path(debug_info_file_path);
+
+  if (request->accept_compressed_file()) {
+    // The client can still copy the uncompressed file, so this is not an error of the request.
+    ErrorMessageOr<std::filesystem::path> compressed_file_path =
+        orbit_symbols::GetOrCreateCompressedCopy(debug_info_file_path,
+                                                 kCompressedDebugInfoFilesDirectory);
+    if (compressed_file_path.has_error()) {
+      ORBIT_ERROR("Unable to compress debug info file \"%s\": %s", debug_info_file_path.string(),
+                  compressed_file_path.error().message());
+    } else {
+      response->set_compressed_debug_info_file_path(compressed_file_path.value());
+    }
+  }
+  return Status::OK;
+}
+
+Status ProcessServiceImpl::ResolveAddresses(ServerContext* /*context*/,
+                                            const ResolveAddressesRequest* request,
+                                            ResolveAddressesResponse* response) {
+  ORBIT_CHECK(request != nullptr);
+
+  std::shared_ptr<const SortedSymbols> sorted_symbols;
+  {
+    absl::MutexLock lock(&module_symbols_mutex_);
+    if (auto it = sorted_module_symbols_.find(request->build_id());
+        it != sorted_module_symbols_.end()) {
+      sorted_symbols = it->second;
+    }
+  }
+
+  if (sorted_symbols == nullptr) {
+    // Loaded without holding the lock, as this can take a while for large modules.
+    ErrorMessageOr<NotFoundOr<SortedSymbols>> load_result = LoadSortedModuleSymbols(*request);
+    if (load_result.has_error()) {
+      return {StatusCode::UNKNOWN, load_result.error().message()};
+    }
+    if (orbit_base::IsNotFound(load_result.value())) {
+      return {StatusCode::NOT_FOUND, orbit_base::GetNotFoundMessage(load_result.value())};
+    }
+    sorted_symbols = std::make_shared<const SortedSymbols>(
+        orbit_base::GetFound(std::move(load_result.value())));
+
+    // Without a build id the module can't be identified later, so its symbols are not cached.
+    if (!request->build_id().empty()) {
+      absl::MutexLock lock(&module_symbols_mutex_);
+      if (sorted_module_symbols_.size() >= kMaxCachedModuleSymbols) sorted_module_symbols_.clear();
+      sorted_module_symbols_.insert_or_assign(request->build_id(), sorted_symbols);
+    }
+  }
+
+  response->mutable_resolved_addresses()->Reserve(request->addresses_size());
+  for (uint64_t address : request->addresses()) {
+    *response->add_resolved_addresses() = ResolveAddress(*sorted_symbols, address);
+  }
   return Status::OK;
 }
 
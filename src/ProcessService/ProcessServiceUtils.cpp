@@ -12,11 +12,14 @@
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_join.h>
 #include <absl/strings/str_split.h>
+#include <limits.h>
 #include <sys/uio.h>
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <filesystem>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <numeric>
@@ -60,49 +63,25 @@ const std::vector<fs::path>& kHardcodedSearchDirectories{
     "/home/cloudcast/symbols", "/mnt/developer/symbols",
     "/srv/game/assets/symbols"};
 
-std::optional<Jiffies> GetCumulativeCpuTimeFromProcess(pid_t pid) {
-  const auto stat = std::filesystem::path{"/proc"} / std::to_string(pid) / "stat";
-
+std::optional<ProcessStat> ParseProcessStat(std::string_view stat_content) {
   // /proc/[pid]/stat looks like so (example - all in one line):
   // 1395261 (sleep) S 5273 1160 1160 0 -1 1077936128 101 0 0 0 0 0 0 0 20 0 1 0 42187401 5431296
   // 131 18446744073709551615 94702955896832 94702955911385 140735167078224 0 0 0 0 0 0 0 0 0 17 10
   // 0 0 0 0 0 94702955928880 94702955930112 94702967197696 140735167083224 140735167083235
   // 140735167083235 140735167086569 0
   //
-  // This code reads field 13 (user time) and 14 (kernel time) to determine the process's cpu usage.
-  // Older kernels might have less fields than in the example. Over time fields had been added to
-  // the end, but field indexes stayed stable.
-
-  std::error_code error;
-  bool file_exists = std::filesystem::exists(stat, error);
-  // Even if we couldn't stat we could still be able to read, continue in case of an error.
-  if (!error && !file_exists) {
-    return std::nullopt;
-  }
-
-  ErrorMessageOr<std::string> file_content_or_error = orbit_base::ReadFileToString(stat);
-  if (file_content_or_error.has_error()) {
-    ORBIT_ERROR("Could not read \"%s\": %s", stat.string(),
-                file_content_or_error.error().message());
-    return std::nullopt;
-  }
-
-  std::vector<std::string> lines =
-      absl::StrSplit(file_content_or_error.value(), absl::MaxSplits('\n', 1));
-  if (lines.empty()) {
-    ORBIT_ERROR("\"%s\" file is empty", stat.string());
-    return std::nullopt;
-  }
-
-  const std::string& first_line = lines.at(0);
+  // This code reads field 13 (user time) and 14 (kernel time) to determine the process's cpu usage,
+  // and field 21 (start time) to tell apart processes that reused the same pid. Older kernels might
+  // have less fields than in the example. Over time fields had been added to the end, but field
+  // indexes stayed stable.
+  std::string_view first_line = stat_content.substr(0, stat_content.find('\n'));
 
   // Remove fields up to comm (process name) as this, enclosed in parentheses, could contain spaces.
   size_t last_closed_paren_index = first_line.find_last_of(')');
-  if (last_closed_paren_index == std::string::npos) {
+  if (last_closed_paren_index == std::string_view::npos) {
     return std::nullopt;
   }
-  std::string_view first_line_excl_pid_comm =
-      std::string_view{first_line}.substr(last_closed_paren_index + 1);
+  std::string_view first_line_excl_pid_comm = first_line.substr(last_closed_paren_index + 1);
 
   std::vector<std::string_view> fields_excl_pid_comm =
       absl::StrSplit(first_line_excl_pid_comm, ' ', absl::SkipWhitespace{});
@@ -112,22 +91,61 @@ std::optional<Jiffies> GetCumulativeCpuTimeFromProcess(pid_t pid) {
   constexpr size_t kUtimeIndexExclPidComm = kUtimeIndex - kCommIndex - 1;
   constexpr size_t kStimeIndex = 14;
   constexpr size_t kStimeIndexExclPidComm = kStimeIndex - kCommIndex - 1;
+  constexpr size_t kStarttimeIndex = 21;
+  constexpr size_t kStarttimeIndexExclPidComm = kStarttimeIndex - kCommIndex - 1;
 
-  if (fields_excl_pid_comm.size() <= std::max(kUtimeIndex, kStimeIndex)) {
+  if (fields_excl_pid_comm.size() <= kStarttimeIndexExclPidComm) {
     return std::nullopt;
   }
 
-  size_t utime{};
+  uint64_t utime{};
   if (!absl::SimpleAtoi(fields_excl_pid_comm[kUtimeIndexExclPidComm], &utime)) {
     return std::nullopt;
   }
 
-  size_t stime{};
+  uint64_t stime{};
   if (!absl::SimpleAtoi(fields_excl_pid_comm[kStimeIndexExclPidComm], &stime)) {
     return std::nullopt;
   }
 
-  return Jiffies{utime + stime};
+  uint64_t start_time{};
+  if (!absl::SimpleAtoi(fields_excl_pid_comm[kStarttimeIndexExclPidComm], &start_time)) {
+    return std::nullopt;
+  }
+
+  return ProcessStat{Jiffies{utime + stime}, start_time};
+}
+
+std::optional<ProcessStat> GetProcessStat(pid_t pid) {
+  const auto stat = std::filesystem::path{"/proc"} / std::to_string(pid) / "stat";
+
+  ErrorMessageOr<orbit_base::UniqueFd> fd_or_error = orbit_base::OpenFileForReading(stat);
+  if (fd_or_error.has_error()) {
+    // The process has most likely exited in the meantime.
+    return std::nullopt;
+  }
+
+  // The file is a single line of about 52 numbers, so one read of this size gets all of it.
+  constexpr size_t kMaxStatSize = 4096;
+  std::array<char, kMaxStatSize> buffer{};
+  ErrorMessageOr<size_t> size_or_error =
+      orbit_base::ReadFullyAtOffset(fd_or_error.value(), buffer.data(), buffer.size(), 0);
+  if (size_or_error.has_error()) {
+    ORBIT_ERROR("Could not read \"%s\": %s", stat.string(), size_or_error.error().message());
+    return std::nullopt;
+  }
+  if (size_or_error.value() == 0) {
+    ORBIT_ERROR("\"%s\" file is empty", stat.string());
+    return std::nullopt;
+  }
+
+  return ParseProcessStat(std::string_view{buffer.data(), size_or_error.value()});
+}
+
+std::optional<Jiffies> GetCumulativeCpuTimeFromProcess(pid_t pid) {
+  std::optional<ProcessStat> process_stat = GetProcessStat(pid);
+  if (!process_stat.has_value()) return std::nullopt;
+  return process_stat->cpu_time;
 }
 
 std::optional<TotalCpuTime> GetCumulativeTotalCpuTime() {
@@ -349,6 +367,58 @@ ErrorMessageOr<orbit_base::NotFoundOr<fs::path>> FindSymbolsFilePath(
   return orbit_base::NotFound{not_found_message_for_client};
 }
 
+ErrorMessageOr<orbit_base::NotFoundOr<std::vector<orbit_grpc_protos::SymbolInfo>>>
+LoadSortedModuleSymbols(const orbit_grpc_protos::ResolveAddressesRequest& request) {
+  OUTCOME_TRY(auto&& object_file, CreateObjectFile(request.module_path()));
+  if (object_file->GetBuildId() != request.build_id()) {
+    return ErrorMessage{absl::StrFormat(
+        "Module \"%s\" has a different build id than the module requested by the client: "
+        "\"%s\" != \"%s\"",
+        request.module_path(), object_file->GetBuildId(), request.build_id())};
+  }
+
+  orbit_grpc_protos::GetDebugInfoFileRequest find_request;
+  find_request.set_module_path(request.module_path());
+  *find_request.mutable_additional_search_directories() = request.additional_search_directories();
+  OUTCOME_TRY(orbit_base::NotFoundOr<fs::path> find_result, FindSymbolsFilePath(find_request));
+  if (orbit_base::IsNotFound(find_result)) {
+    return orbit_base::NotFound{orbit_base::GetNotFoundMessage(find_result)};
+  }
+
+  orbit_object_utils::ObjectFileInfo object_file_info{object_file->GetLoadBias()};
+  OUTCOME_TRY(auto&& symbols_file,
+              CreateSymbolsFile(orbit_base::GetFound(find_result), object_file_info));
+  OUTCOME_TRY(orbit_grpc_protos::ModuleSymbols module_symbols, symbols_file->LoadDebugSymbols());
+
+  std::vector<orbit_grpc_protos::SymbolInfo> sorted_symbols(
+      std::make_move_iterator(module_symbols.mutable_symbol_infos()->begin()),
+      std::make_move_iterator(module_symbols.mutable_symbol_infos()->end()));
+  std::sort(sorted_symbols.begin(), sorted_symbols.end(),
+            [](const orbit_grpc_protos::SymbolInfo& lhs, const orbit_grpc_protos::SymbolInfo& rhs) {
+              return lhs.address() < rhs.address();
+            });
+  return sorted_symbols;
+}
+
+orbit_grpc_protos::ResolvedAddress ResolveAddress(
+    absl::Span<const orbit_grpc_protos::SymbolInfo> sorted_symbols, uint64_t address) {
+  orbit_grpc_protos::ResolvedAddress resolved_address;
+  // The last symbol that starts at or before the address.
+  auto it = std::upper_bound(
+      sorted_symbols.begin(), sorted_symbols.end(), address,
+      [](uint64_t address, const orbit_grpc_protos::SymbolInfo& symbol_info) {
+        return address < symbol_info.address();
+      });
+  if (it == sorted_symbols.begin()) return resolved_address;
+  --it;
+  if (address >= it->address() + it->size()) return resolved_address;
+
+  resolved_address.set_function_name(it->demangled_name());
+  resolved_address.set_function_address(it->address());
+  resolved_address.set_offset_in_function(address - it->address());
+  return resolved_address;
+}
+
 bool ReadProcessMemory(uint32_t pid, uintptr_t address, void* buffer, uint64_t size,
                        uint64_t* num_bytes_read) {
   iovec local_iov[] = {{buffer, size}};
@@ -359,4 +429,41 @@ bool ReadProcessMemory(uint32_t pid, uintptr_t address, void* buffer, uint64_t s
   return *num_bytes_read == size;
 }
 
+std::vector<std::string> ReadProcessMemoryRanges(uint32_t pid,
+                                                 absl::Span<const MemoryRange> ranges) {
+  std::vector<std::string> results(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) results[i].resize(ranges[i].size);
+  const pid_t native_pid = orbit_base::ToNativeProcessId(pid);
+
+  // process_vm_readv accepts at most IOV_MAX iovecs, and stops at the first remote iovec that it
+  // can't read completely. The reading then continues after that range.
+  std::vector<iovec> local_iovs;
+  std::vector<iovec> remote_iovs;
+  size_t next_range_index = 0;
+  while (next_range_index < ranges.size()) {
+    const size_t batch_size = std::min<size_t>(ranges.size() - next_range_index, IOV_MAX);
+    local_iovs.clear();
+    remote_iovs.clear();
+    for (size_t i = next_range_index; i < next_range_index + batch_size; ++i) {
+      local_iovs.push_back({results[i].data(), ranges[i].size});
+      remote_iovs.push_back({absl::bit_cast<void*>(ranges[i].address), ranges[i].size});
+    }
+    const ssize_t result = process_vm_readv(native_pid, local_iovs.data(), local_iovs.size(),
+                                            remote_iovs.data(), remote_iovs.size(), 0);
+    uint64_t num_bytes_read = result > 0 ? static_cast<uint64_t>(result) : 0;
+
+    const size_t batch_end = next_range_index + batch_size;
+    while (next_range_index < batch_end && num_bytes_read >= ranges[next_range_index].size) {
+      num_bytes_read -= ranges[next_range_index].size;
+      ++next_range_index;
+    }
+    if (next_range_index < batch_end) {
+      // This range was not read completely.
+      results[next_range_index].resize(num_bytes_read);
+      ++next_range_index;
+    }
+  }
+  return results;
+}
+
 }  // namespace orbit_process_service
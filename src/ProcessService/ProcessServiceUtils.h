@@ -5,6 +5,7 @@
 #ifndef PROCESS_SERVICE_PROCESS_SERVICE_UTILS_H_
 #define PROCESS_SERVICE_PROCESS_SERVICE_UTILS_H_
 
+#include <absl/types/span.h>
 #include <stdint.h>
 
 #include <ctime>
@@ -14,11 +15,13 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include "GrpcProtos/module.pb.h"
 #include "GrpcProtos/services.pb.h"
+#include "GrpcProtos/symbol.pb.h"
 #include "GrpcProtos/tracepoint.pb.h"
 #include "OrbitBase/NotFoundOr.h"
 #include "OrbitBase/Result.h"
@@ -26,16 +29,49 @@
 
 namespace orbit_process_service {
 
+struct ProcessStat {
+  orbit_process_service_internal::Jiffies cpu_time;
+  // The time the process started after system boot, in clock ticks. As pids are reused, the pid
+  // and the start time together identify a process.
+  uint64_t start_time;
+};
+
 std::optional<orbit_process_service_internal::TotalCpuTime> GetCumulativeTotalCpuTime();
+// Parses the content of /proc/[pid]/stat.
+[[nodiscard]] std::optional<ProcessStat> ParseProcessStat(std::string_view stat_content);
+// Reads /proc/[pid]/stat with a single read.
+std::optional<ProcessStat> GetProcessStat(pid_t pid);
 std::optional<orbit_process_service_internal::Jiffies> GetCumulativeCpuTimeFromProcess(pid_t pid);
 
 // Searches on the instance for a symbols file. This can have 3 outcomes, an error, not found or
 // success. In the success case it returns the symbol file path.
 ErrorMessageOr<orbit_base::NotFoundOr<std::filesystem::path>> FindSymbolsFilePath(
     const orbit_grpc_protos::GetDebugInfoFileRequest& request);
+
+// Loads the symbols of the module at module_path from the symbols file that FindSymbolsFilePath
+// finds for it, sorted by address. Returns an error if the module doesn't have the build id of the
+// request, which happens when the module was replaced on the instance.
+ErrorMessageOr<orbit_base::NotFoundOr<std::vector<orbit_grpc_protos::SymbolInfo>>>
+LoadSortedModuleSymbols(const orbit_grpc_protos::ResolveAddressesRequest& request);
+
+// Returns the function of sorted_symbols that contains address, or a ResolvedAddress with an empty
+// function name if no function contains it.
+[[nodiscard]] orbit_grpc_protos::ResolvedAddress ResolveAddress(
+    absl::Span<const orbit_grpc_protos::SymbolInfo> sorted_symbols, uint64_t address);
 bool ReadProcessMemory(uint32_t pid, uintptr_t address, void* buffer, uint64_t size,
                        uint64_t* num_bytes_read);
 
+struct MemoryRange {
+  uint64_t address;
+  uint64_t size;
+};
+
+// Reads many ranges of the memory of process `pid` with as few process_vm_readv calls as possible.
+// Returns, for each range, the bytes that could be read from its start: all of them, fewer if only
+// the start of the range is readable, or none.
+[[nodiscard]] std::vector<std::string> ReadProcessMemoryRanges(
+    uint32_t pid, absl::Span<const MemoryRange> ranges);
+
 }  // namespace orbit_process_service
 
 #endif  // PROCESS_SERVICE_PROCESS_SERVICE_UTILS_H_
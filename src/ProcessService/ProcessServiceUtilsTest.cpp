@@ -2,16 +2,21 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <absl/base/casts.h>
 #include <absl/strings/match.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "GrpcProtos/services.pb.h"
+#include "GrpcProtos/symbol.pb.h"
 #include "OrbitBase/NotFoundOr.h"
 #include "OrbitBase/Result.h"
 #include "ProcessService/CpuTime.h"
@@ -23,6 +28,9 @@ namespace orbit_process_service {
 
 using orbit_base::NotFoundOr;
 using orbit_grpc_protos::GetDebugInfoFileRequest;
+using orbit_grpc_protos::ResolveAddressesRequest;
+using orbit_grpc_protos::ResolvedAddress;
+using orbit_grpc_protos::SymbolInfo;
 using orbit_test_utils::HasErrorWithMessage;
 using orbit_test_utils::HasValue;
 
@@ -61,6 +69,33 @@ TEST(ProcessServiceUtils, GetCumulativeCpuTimeFromProcess) {
   ASSERT_TRUE(jiffies2->value <= total_cpu_time->jiffies.value);
 }
 
+TEST(ProcessServiceUtils, ParseProcessStat) {
+  // The name of the process contains a space and a closing parenthesis.
+  constexpr std::string_view kStat =
+      "1395261 (sle ep)) S 5273 1160 1160 0 -1 1077936128 101 0 0 0 7 5 0 0 20 0 1 0 42187401 "
+      "5431296 131 18446744073709551615 94702955896832 94702955911385 140735167078224 0 0 0 0 0 0 "
+      "0 0 0 17 10 0 0 0 0 0 94702955928880 94702955930112 94702967197696 140735167083224 "
+      "140735167083235 140735167083235 140735167086569 0\n";
+  const std::optional<ProcessStat> process_stat = ParseProcessStat(kStat);
+  ASSERT_TRUE(process_stat.has_value());
+  EXPECT_EQ(process_stat->cpu_time.value, 12);
+  EXPECT_EQ(process_stat->start_time, 42187401);
+
+  EXPECT_FALSE(
+      ParseProcessStat("1395261 (sleep) S 5273 1160 1160 0 -1 1077936128 101 0").has_value());
+  EXPECT_FALSE(ParseProcessStat("").has_value());
+}
+
+TEST(ProcessServiceUtils, GetProcessStat) {
+  const std::optional<ProcessStat> process_stat1 = GetProcessStat(getpid());
+  ASSERT_TRUE(process_stat1.has_value());
+  const std::optional<ProcessStat> process_stat2 = GetProcessStat(getpid());
+  ASSERT_TRUE(process_stat2.has_value());
+
+  EXPECT_GE(process_stat2->cpu_time.value, process_stat1->cpu_time.value);
+  EXPECT_EQ(process_stat2->start_time, process_stat1->start_time);
+}
+
 TEST(ProcessServiceUtils, FindSymbolsFilePath) {
   const std::filesystem::path test_directory = orbit_test::GetTestdataDir();
 
@@ -149,4 +184,86 @@ TEST(ProcessServiceUtils, FindSymbolsFilePath) {
   }
 }
 
+TEST(ProcessServiceUtils, LoadSortedModuleSymbols) {
+  const std::filesystem::path test_directory = orbit_test::GetTestdataDir();
+
+  ResolveAddressesRequest request;
+  request.set_module_path((test_directory / "hello_world_elf").string());
+  request.set_build_id("d12d54bc5b72ccce54a408bdeda65e2530740ac8");
+  request.add_additional_search_directories(test_directory);
+  const ErrorMessageOr<NotFoundOr<std::vector<SymbolInfo>>> result =
+      LoadSortedModuleSymbols(request);
+  ASSERT_THAT(result, HasValue());
+  ASSERT_FALSE(orbit_base::IsNotFound(result.value()));
+  const std::vector<SymbolInfo>& sorted_symbols = orbit_base::GetFound(result.value());
+  ASSERT_FALSE(sorted_symbols.empty());
+  EXPECT_TRUE(std::is_sorted(sorted_symbols.begin(), sorted_symbols.end(),
+                             [](const SymbolInfo& lhs, const SymbolInfo& rhs) {
+                               return lhs.address() < rhs.address();
+                             }));
+
+  const ResolvedAddress resolved_address = ResolveAddress(sorted_symbols, 0x1135 + 4);
+  EXPECT_EQ(resolved_address.function_name(), "main");
+  EXPECT_EQ(resolved_address.function_address(), 0x1135);
+  EXPECT_EQ(resolved_address.offset_in_function(), 4);
+
+  request.set_build_id("other_build_id");
+  EXPECT_THAT(LoadSortedModuleSymbols(request), HasErrorWithMessage("different build id"));
+}
+
+TEST(ProcessServiceUtils, ResolveAddress) {
+  std::vector<SymbolInfo> sorted_symbols(2);
+  sorted_symbols[0].set_demangled_name("foo");
+  sorted_symbols[0].set_address(0x100);
+  sorted_symbols[0].set_size(0x10);
+  sorted_symbols[1].set_demangled_name("bar");
+  sorted_symbols[1].set_address(0x200);
+  sorted_symbols[1].set_size(0x20);
+
+  EXPECT_EQ(ResolveAddress(sorted_symbols, 0x100).function_name(), "foo");
+  EXPECT_EQ(ResolveAddress(sorted_symbols, 0x10f).function_name(), "foo");
+  EXPECT_EQ(ResolveAddress(sorted_symbols, 0x10f).offset_in_function(), 0xf);
+  EXPECT_EQ(ResolveAddress(sorted_symbols, 0x21f).function_name(), "bar");
+  EXPECT_EQ(ResolveAddress(sorted_symbols, 0x21f).function_address(), 0x200);
+
+  // Before the first, between and after the last function.
+  EXPECT_EQ(ResolveAddress(sorted_symbols, 0xff).function_name(), "");
+  EXPECT_EQ(ResolveAddress(sorted_symbols, 0x110).function_name(), "");
+  EXPECT_EQ(ResolveAddress(sorted_symbols, 0x220).function_name(), "");
+  EXPECT_EQ(ResolveAddress({}, 0x100).function_name(), "");
+}
+
+TEST(ProcessServiceUtils, ReadProcessMemoryRanges) {
+  const std::string first = "first range";
+  const std::string second = "second range";
+  const std::vector<MemoryRange> ranges{
+      {absl::bit_cast<uint64_t>(first.data()), first.size()},
+      {0, 8},
+      {absl::bit_cast<uint64_t>(second.data()), second.size()},
+      {absl::bit_cast<uint64_t>(first.data()), 0}};
+
+  const std::vector<std::string> results = ReadProcessMemoryRanges(getpid(), ranges);
+  ASSERT_EQ(results.size(), ranges.size());
+  EXPECT_EQ(results[0], first);
+  EXPECT_EQ(results[1], "");
+  EXPECT_EQ(results[2], second);
+  EXPECT_EQ(results[3], "");
+}
+
+TEST(ProcessServiceUtils, ReadProcessMemoryRangesNeedsMultipleBatches) {
+  const std::string content(3000, 'x');
+  std::vector<MemoryRange> ranges;
+  for (size_t i = 0; i < content.size(); ++i) {
+    ranges.push_back({absl::bit_cast<uint64_t>(content.data() + i), 1});
+  }
+  // One unreadable range in the middle doesn't affect the following ones.
+  ranges[1500] = {0, 1};
+
+  const std::vector<std::string> results = ReadProcessMemoryRanges(getpid(), ranges);
+  ASSERT_EQ(results.size(), ranges.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i], i == 1500 ? "" : "x");
+  }
+}
+
 }  // namespace orbit_process_service
@@ -8,6 +8,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <optional>
+
 #include "GrpcProtos/process.pb.h"
 #include "OrbitBase/Result.h"
 #include "ProcessService/CpuTime.h"
@@ -21,11 +23,17 @@ class Process {
   // Creates a `Process` by reading details from the `/proc` filesystem.
   // This might fail due to a non existing pid or due to permission problems.
   static ErrorMessageOr<Process> FromPid(uint32_t pid);
+  // Same as above, but with the total CPU time already read for all the processes of a refresh.
+  static ErrorMessageOr<Process> FromPid(uint32_t pid,
+                                         const std::optional<TotalCpuTime>& total_cpu_time);
 
   // NOLINTNEXTLINE
   [[nodiscard]] const orbit_grpc_protos::ProcessInfo& process_info() const { return process_info_; }
+  // See `orbit_process_service::ProcessStat::start_time`.
+  [[nodiscard]] uint64_t start_time() const { return start_time_; }
 
  private:
+  uint64_t start_time_ = 0;
   Jiffies previous_process_cpu_time_ = {};
   Jiffies previous_total_cpu_time_ = {};
   orbit_grpc_protos::ProcessInfo process_info_;
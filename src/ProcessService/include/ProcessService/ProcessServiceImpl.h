@@ -5,21 +5,35 @@
 #ifndef PROCESS_SERVICE_PROCESS_SERVICE_IMPL_H_
 #define PROCESS_SERVICE_PROCESS_SERVICE_IMPL_H_
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
 #include <stddef.h>
 
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "GrpcProtos/services.grpc.pb.h"
 #include "GrpcProtos/services.pb.h"
+#include "GrpcProtos/symbol.pb.h"
 #include "ProcessService/ProcessList.h"
 
 namespace orbit_process_service {
 
 class ProcessServiceImpl final : public orbit_grpc_protos::ProcessService::Service {
  public:
+  // Starts reading the process list in the background, so that it is ready when the client first
+  // asks for it. That first request then only needs to update the CPU usage of the processes.
+  ProcessServiceImpl();
+  ~ProcessServiceImpl() override;
+
+  ProcessServiceImpl(const ProcessServiceImpl&) = delete;
+  ProcessServiceImpl& operator=(const ProcessServiceImpl&) = delete;
+  ProcessServiceImpl(ProcessServiceImpl&&) = delete;
+  ProcessServiceImpl& operator=(ProcessServiceImpl&&) = delete;
+
   [[nodiscard]] grpc::Status GetProcessList(
       grpc::ServerContext* context, const orbit_grpc_protos::GetProcessListRequest* request,
       orbit_grpc_protos::GetProcessListResponse* response) override;
@@ -32,13 +46,30 @@ class ProcessServiceImpl final : public orbit_grpc_protos::ProcessService::Servi
       grpc::ServerContext* context, const orbit_grpc_protos::GetProcessMemoryRequest* request,
       orbit_grpc_protos::GetProcessMemoryResponse* response) override;
 
+  [[nodiscard]] grpc::Status GetProcessMemoryRanges(
+      grpc::ServerContext* context, const orbit_grpc_protos::GetProcessMemoryRangesRequest* request,
+      orbit_grpc_protos::GetProcessMemoryRangesResponse* response) override;
+
   [[nodiscard]] grpc::Status GetDebugInfoFile(
       grpc::ServerContext* context, const orbit_grpc_protos::GetDebugInfoFileRequest* request,
       orbit_grpc_protos::GetDebugInfoFileResponse* response) override;
 
+  [[nodiscard]] grpc::Status ResolveAddresses(
+      grpc::ServerContext* context, const orbit_grpc_protos::ResolveAddressesRequest* request,
+      orbit_grpc_protos::ResolveAddressesResponse* response) override;
+
  private:
   absl::Mutex mutex_;
-  orbit_process_service_internal::ProcessList process_list_;
+  orbit_process_service_internal::ProcessList process_list_ ABSL_GUARDED_BY(mutex_);
+  std::thread warm_up_thread_;
+
+  // The sorted symbols of the modules that addresses were recently resolved in, by build id. The
+  // client usually resolves addresses in the same modules in several batches.
+  using SortedSymbols = std::vector<orbit_grpc_protos::SymbolInfo>;
+  absl::Mutex module_symbols_mutex_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const SortedSymbols>> sorted_module_symbols_
+      ABSL_GUARDED_BY(module_symbols_mutex_);
+  static constexpr size_t kMaxCachedModuleSymbols = 16;
 
   static constexpr size_t kMaxGetProcessMemoryResponseSize = 8 * 1024 * 1024;
 };
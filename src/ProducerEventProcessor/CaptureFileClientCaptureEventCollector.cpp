@@ -0,0 +1,141 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ProducerEventProcessor/CaptureFileClientCaptureEventCollector.h"
+
+#include <absl/time/time.h>
+
+#include <utility>
+
+#include "CaptureFile/CaptureFileHelpers.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ThreadUtils.h"
+
+using orbit_capture_file::CaptureFileOutputStream;
+using orbit_grpc_protos::ClientCaptureEvent;
+
+namespace orbit_producer_event_processor {
+
+namespace {
+
+[[nodiscard]] bool IsHighRateEvent(const ClientCaptureEvent& event) {
+  switch (event.event_case()) {
+    case ClientCaptureEvent::kFunctionCall:
+    case ClientCaptureEvent::kSchedulingSlice:
+    case ClientCaptureEvent::kCallstackSample:
+    case ClientCaptureEvent::kPageFaultSample:
+    case ClientCaptureEvent::kThreadStateSlice:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+ErrorMessageOr<std::unique_ptr<CaptureFileClientCaptureEventCollector>>
+CaptureFileClientCaptureEventCollector::Create(std::filesystem::path file_path,
+                                               ClientCaptureEventCollector* preview_collector) {
+  ORBIT_CHECK(preview_collector != nullptr);
+  OUTCOME_TRY(std::unique_ptr<CaptureFileOutputStream> output_stream,
+              CaptureFileOutputStream::Create(
+                  file_path, orbit_capture_file::CaptureSectionCompression::kZlib));
+  return std::unique_ptr<CaptureFileClientCaptureEventCollector>{
+      new CaptureFileClientCaptureEventCollector{std::move(file_path), std::move(output_stream),
+                                                 preview_collector}};
+}
+
+CaptureFileClientCaptureEventCollector::CaptureFileClientCaptureEventCollector(
+    std::filesystem::path file_path, std::unique_ptr<CaptureFileOutputStream> output_stream,
+    ClientCaptureEventCollector* preview_collector)
+    : file_path_{std::move(file_path)},
+      output_stream_{std::move(output_stream)},
+      preview_collector_{preview_collector} {
+  writer_thread_ = std::thread{[this] { WriterThread(); }};
+}
+
+void CaptureFileClientCaptureEventCollector::AddEvent(ClientCaptureEvent&& event) {
+  absl::MutexLock lock{&mutex_};
+  if (stop_requested_) {
+    return;
+  }
+
+  // The preview is forwarded while holding `mutex_`, so that it keeps the order of the events.
+  if (!IsHighRateEvent(event) || high_rate_event_count_++ % kPreviewSamplingPeriod == 0) {
+    ClientCaptureEvent preview_event = event;
+    preview_collector_->AddEvent(std::move(preview_event));
+  }
+  events_to_write_.push_back(std::move(event));
+}
+
+void CaptureFileClientCaptureEventCollector::StopAndWait() {
+  ORBIT_CHECK(writer_thread_.joinable());
+  {
+    absl::MutexLock lock{&mutex_};
+    stop_requested_ = true;
+  }
+  writer_thread_.join();
+
+  if (!write_failed_) {
+    ErrorMessageOr<void> close_result = output_stream_->Close();
+    if (close_result.has_error()) {
+      ORBIT_ERROR("Closing capture file \"%s\": %s", file_path_.string(),
+                  close_result.error().message());
+    } else {
+      ErrorMessageOr<void> write_index_result =
+          orbit_capture_file::WriteCaptureIndex(file_path_, output_stream_->GetCaptureIndex());
+      if (write_index_result.has_error()) {
+        ORBIT_ERROR("Writing the index of capture file \"%s\": %s", file_path_.string(),
+                    write_index_result.error().message());
+      }
+      ORBIT_LOG("Wrote %u events to capture file \"%s\"", total_number_of_events_written_,
+                file_path_.string());
+    }
+  }
+
+  preview_collector_->StopAndWait();
+}
+
+CaptureFileClientCaptureEventCollector::~CaptureFileClientCaptureEventCollector() {
+  ORBIT_CHECK(!writer_thread_.joinable());
+}
+
+void CaptureFileClientCaptureEventCollector::WriterThread() {
+  orbit_base::SetCurrentThreadName("CaptureFileWrtr");
+  constexpr absl::Duration kWriteTimeInterval = absl::Milliseconds(100);
+  constexpr size_t kWriteEventCountInterval = 10'000;
+
+  std::vector<ClientCaptureEvent> events_being_written;
+  bool stopped = false;
+  while (!stopped) {
+    mutex_.LockWhenWithTimeout(
+        absl::Condition(
+            +[](CaptureFileClientCaptureEventCollector* self)
+                 ABSL_EXCLUSIVE_LOCKS_REQUIRED(self->mutex_) {
+                   return self->events_to_write_.size() >= kWriteEventCountInterval ||
+                          self->stop_requested_;
+                 },
+            this),
+        kWriteTimeInterval);
+    stopped = stop_requested_;
+    events_being_written.swap(events_to_write_);
+    mutex_.Unlock();
+
+    for (const ClientCaptureEvent& event : events_being_written) {
+      if (write_failed_) break;
+      ErrorMessageOr<void> write_result = output_stream_->WriteCaptureEvent(event);
+      if (write_result.has_error()) {
+        // The output stream has deleted the file. The preview keeps being forwarded.
+        ORBIT_ERROR("Writing to capture file \"%s\": %s", file_path_.string(),
+                    write_result.error().message());
+        write_failed_ = true;
+        break;
+      }
+      ++total_number_of_events_written_;
+    }
+    events_being_written.clear();
+  }
+}
+
+}  // namespace orbit_producer_event_processor
@@ -0,0 +1,130 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "CaptureFile/CaptureFile.h"
+#include "CaptureFile/CaptureFileHelpers.h"
+#include "CaptureFile/ProtoSectionInputStream.h"
+#include "ClientProtos/capture_index.pb.h"
+#include "GrpcProtos/capture.pb.h"
+#include "ProducerEventProcessor/CaptureFileClientCaptureEventCollector.h"
+#include "ProducerEventProcessor/ClientCaptureEventCollector.h"
+#include "TestUtils/TemporaryDirectory.h"
+#include "TestUtils/TestUtils.h"
+
+using orbit_capture_file::CaptureFile;
+using orbit_grpc_protos::ClientCaptureEvent;
+using orbit_test_utils::HasNoError;
+using orbit_test_utils::HasValue;
+using orbit_test_utils::TemporaryDirectory;
+
+namespace orbit_producer_event_processor {
+
+namespace {
+
+class MockClientCaptureEventCollector : public ClientCaptureEventCollector {
+ public:
+  void AddEvent(ClientCaptureEvent&& event) override { OnEvent(event); }
+  MOCK_METHOD(void, OnEvent, (const ClientCaptureEvent& event), ());
+  MOCK_METHOD(void, StopAndWait, (), (override));
+};
+
+[[nodiscard]] ClientCaptureEvent CreateCallstackSampleEvent(uint64_t timestamp_ns) {
+  ClientCaptureEvent event;
+  event.mutable_callstack_sample()->set_tid(42);
+  event.mutable_callstack_sample()->set_timestamp_ns(timestamp_ns);
+  return event;
+}
+
+[[nodiscard]] ClientCaptureEvent CreateCaptureFinishedEvent() {
+  ClientCaptureEvent event;
+  event.mutable_capture_finished()->set_status(orbit_grpc_protos::CaptureFinished::kSuccessful);
+  return event;
+}
+
+}  // namespace
+
+TEST(CaptureFileClientCaptureEventCollector, WritesAllEventsAndForwardsPreview) {
+  auto temporary_dir_or_error = TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_dir_or_error, HasValue());
+  const std::filesystem::path capture_file_path =
+      temporary_dir_or_error.value().GetDirectoryPath() / "capture.orbit";
+
+  MockClientCaptureEventCollector preview_collector;
+  std::vector<ClientCaptureEvent> preview_events;
+  EXPECT_CALL(preview_collector, OnEvent)
+      .WillRepeatedly([&preview_events](const ClientCaptureEvent& event) {
+        preview_events.push_back(event);
+      });
+  EXPECT_CALL(preview_collector, StopAndWait).Times(1);
+
+  auto collector_or_error =
+      CaptureFileClientCaptureEventCollector::Create(capture_file_path, &preview_collector);
+  ASSERT_THAT(collector_or_error, HasValue());
+  std::unique_ptr<CaptureFileClientCaptureEventCollector> collector =
+      std::move(collector_or_error.value());
+
+  constexpr uint64_t kCallstackSampleCount =
+      2 * CaptureFileClientCaptureEventCollector::kPreviewSamplingPeriod + 1;
+  for (uint64_t i = 0; i < kCallstackSampleCount; ++i) {
+    collector->AddEvent(CreateCallstackSampleEvent(i));
+  }
+  collector->AddEvent(CreateCaptureFinishedEvent());
+  collector->StopAndWait();
+
+  ASSERT_EQ(preview_events.size(), 4);
+  EXPECT_EQ(preview_events[0].callstack_sample().timestamp_ns(), 0);
+  EXPECT_EQ(preview_events[1].callstack_sample().timestamp_ns(),
+            CaptureFileClientCaptureEventCollector::kPreviewSamplingPeriod);
+  EXPECT_EQ(preview_events[2].callstack_sample().timestamp_ns(),
+            2 * CaptureFileClientCaptureEventCollector::kPreviewSamplingPeriod);
+  EXPECT_EQ(preview_events[3].event_case(), ClientCaptureEvent::kCaptureFinished);
+
+  auto capture_file_or_error = CaptureFile::OpenForReadWrite(capture_file_path);
+  ASSERT_THAT(capture_file_or_error, HasValue());
+  std::unique_ptr<CaptureFile> capture_file = std::move(capture_file_or_error.value());
+
+  auto capture_section_input_stream = capture_file->CreateCaptureSectionInputStream();
+  for (uint64_t i = 0; i < kCallstackSampleCount; ++i) {
+    ClientCaptureEvent event;
+    ASSERT_THAT(capture_section_input_stream->ReadMessage(&event), HasNoError());
+    EXPECT_EQ(event.callstack_sample().timestamp_ns(), i);
+  }
+  ClientCaptureEvent event;
+  ASSERT_THAT(capture_section_input_stream->ReadMessage(&event), HasNoError());
+  EXPECT_EQ(event.event_case(), ClientCaptureEvent::kCaptureFinished);
+
+  auto capture_index_or_error = orbit_capture_file::ReadCaptureIndex(capture_file.get());
+  ASSERT_THAT(capture_index_or_error, HasValue());
+  EXPECT_TRUE(capture_index_or_error.value().has_value());
+}
+
+TEST(CaptureFileClientCaptureEventCollector, DropsEventsAfterStop) {
+  auto temporary_dir_or_error = TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_dir_or_error, HasValue());
+  const std::filesystem::path capture_file_path =
+      temporary_dir_or_error.value().GetDirectoryPath() / "capture.orbit";
+
+  MockClientCaptureEventCollector preview_collector;
+  EXPECT_CALL(preview_collector, OnEvent).Times(1);
+  EXPECT_CALL(preview_collector, StopAndWait).Times(1);
+
+  auto collector_or_error =
+      CaptureFileClientCaptureEventCollector::Create(capture_file_path, &preview_collector);
+  ASSERT_THAT(collector_or_error, HasValue());
+  collector_or_error.value()->AddEvent(CreateCaptureFinishedEvent());
+  collector_or_error.value()->StopAndWait();
+  collector_or_error.value()->AddEvent(CreateCaptureFinishedEvent());
+}
+
+}  // namespace orbit_producer_event_processor
@@ -0,0 +1,150 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ProducerEventProcessor/ClientCaptureEventBatcher.h"
+
+#include <utility>
+
+using orbit_grpc_protos::CallstackSample;
+using orbit_grpc_protos::CallstackSampleBatch;
+using orbit_grpc_protos::CaptureResponse;
+using orbit_grpc_protos::ClientCaptureEvent;
+using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::FunctionCallBatch;
+using orbit_grpc_protos::SchedulingSlice;
+using orbit_grpc_protos::SchedulingSliceBatch;
+using orbit_grpc_protos::ThreadStateSlice;
+using orbit_grpc_protos::ThreadStateSliceBatch;
+
+namespace orbit_producer_event_processor {
+
+namespace {
+
+// Returns the difference to `*previous_timestamp_ns`, then replaces it with `timestamp_ns`.
+[[nodiscard]] int64_t TakeTimestampDelta(uint64_t timestamp_ns, uint64_t* previous_timestamp_ns) {
+  const auto delta = static_cast<int64_t>(timestamp_ns - *previous_timestamp_ns);
+  *previous_timestamp_ns = timestamp_ns;
+  return delta;
+}
+
+}  // namespace
+
+void ClientCaptureEventBatcher::AddEvent(ClientCaptureEvent&& event) {
+  ++event_count_;
+  switch (event.event_case()) {
+    case ClientCaptureEvent::kFunctionCall:
+      // Registers are only recorded on request and have no column in FunctionCallBatch.
+      if (event.function_call().registers_size() == 0) {
+        AddFunctionCall(event.function_call());
+        return;
+      }
+      break;
+    case ClientCaptureEvent::kSchedulingSlice:
+      AddSchedulingSlice(event.scheduling_slice());
+      return;
+    case ClientCaptureEvent::kCallstackSample:
+      AddCallstackSample(event.callstack_sample());
+      return;
+    case ClientCaptureEvent::kThreadStateSlice:
+      AddThreadStateSlice(event.thread_state_slice());
+      return;
+    case ClientCaptureEvent::kInternedCallstack:
+      callstack_sample_batch_ = {};
+      thread_state_slice_batch_ = {};
+      break;
+    default:
+      break;
+  }
+  capture_response_->mutable_capture_events()->Add(std::move(event));
+}
+
+void ClientCaptureEventBatcher::AddFunctionCall(const FunctionCall& function_call) {
+  if (function_call_batch_.batch == nullptr) {
+    function_call_batch_.batch =
+        capture_response_->add_capture_events()->mutable_function_call_batch();
+  }
+  FunctionCallBatch* batch = function_call_batch_.batch;
+  batch->add_pids(function_call.pid());
+  batch->add_tids(function_call.tid());
+  batch->add_function_ids(function_call.function_id());
+  batch->add_durations_ns(function_call.duration_ns());
+  batch->add_end_timestamp_deltas_ns(TakeTimestampDelta(
+      function_call.end_timestamp_ns(), &function_call_batch_.previous_timestamp_ns));
+  batch->add_depths(function_call.depth());
+  batch->add_return_values(function_call.return_value());
+}
+
+void ClientCaptureEventBatcher::AddSchedulingSlice(const SchedulingSlice& scheduling_slice) {
+  if (scheduling_slice_batch_.batch == nullptr) {
+    scheduling_slice_batch_.batch =
+        capture_response_->add_capture_events()->mutable_scheduling_slice_batch();
+  }
+  SchedulingSliceBatch* batch = scheduling_slice_batch_.batch;
+  batch->add_pids(scheduling_slice.pid());
+  batch->add_tids(scheduling_slice.tid());
+  batch->add_cores(scheduling_slice.core());
+  batch->add_durations_ns(scheduling_slice.duration_ns());
+  batch->add_out_timestamp_deltas_ns(TakeTimestampDelta(
+      scheduling_slice.out_timestamp_ns(), &scheduling_slice_batch_.previous_timestamp_ns));
+}
+
+void ClientCaptureEventBatcher::AddCallstackSample(const CallstackSample& callstack_sample) {
+  if (callstack_sample_batch_.batch == nullptr) {
+    callstack_sample_batch_.batch =
+        capture_response_->add_capture_events()->mutable_callstack_sample_batch();
+  }
+  CallstackSampleBatch* batch = callstack_sample_batch_.batch;
+  batch->add_pids(callstack_sample.pid());
+  batch->add_tids(callstack_sample.tid());
+  batch->add_callstack_ids(callstack_sample.callstack_id());
+  batch->add_timestamp_deltas_ns(TakeTimestampDelta(
+      callstack_sample.timestamp_ns(), &callstack_sample_batch_.previous_timestamp_ns));
+}
+
+void ClientCaptureEventBatcher::AddThreadStateSlice(const ThreadStateSlice& thread_state_slice) {
+  if (thread_state_slice_batch_.batch == nullptr) {
+    thread_state_slice_batch_.batch =
+        capture_response_->add_capture_events()->mutable_thread_state_slice_batch();
+  }
+  ThreadStateSliceBatch* batch = thread_state_slice_batch_.batch;
+  batch->add_pids(thread_state_slice.pid());
+  batch->add_tids(thread_state_slice.tid());
+  batch->add_thread_states(thread_state_slice.thread_state());
+  batch->add_durations_ns(thread_state_slice.duration_ns());
+  batch->add_end_timestamp_deltas_ns(TakeTimestampDelta(
+      thread_state_slice.end_timestamp_ns(), &thread_state_slice_batch_.previous_timestamp_ns));
+  batch->add_wakeup_reasons(thread_state_slice.wakeup_reason());
+  batch->add_wakeup_tids(thread_state_slice.wakeup_tid());
+  batch->add_wakeup_pids(thread_state_slice.wakeup_pid());
+  batch->add_switch_out_or_wakeup_callstack_statuses(
+      thread_state_slice.switch_out_or_wakeup_callstack_status());
+  batch->add_switch_out_or_wakeup_callstack_ids(
+      thread_state_slice.switch_out_or_wakeup_callstack_id());
+}
+
+int GetClientCaptureEventCount(const CaptureResponse& response) {
+  int event_count = 0;
+  for (const ClientCaptureEvent& event : response.capture_events()) {
+    switch (event.event_case()) {
+      case ClientCaptureEvent::kFunctionCallBatch:
+        event_count += event.function_call_batch().tids_size();
+        break;
+      case ClientCaptureEvent::kSchedulingSliceBatch:
+        event_count += event.scheduling_slice_batch().tids_size();
+        break;
+      case ClientCaptureEvent::kCallstackSampleBatch:
+        event_count += event.callstack_sample_batch().tids_size();
+        break;
+      case ClientCaptureEvent::kThreadStateSliceBatch:
+        event_count += event.thread_state_slice_batch().tids_size();
+        break;
+      default:
+        ++event_count;
+        break;
+    }
+  }
+  return event_count;
+}
+
+}  // namespace orbit_producer_event_processor
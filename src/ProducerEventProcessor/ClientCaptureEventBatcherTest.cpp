@@ -0,0 +1,180 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "GrpcProtos/capture.pb.h"
+#include "GrpcProtos/services.pb.h"
+#include "ProducerEventProcessor/ClientCaptureEventBatcher.h"
+
+using orbit_grpc_protos::CaptureResponse;
+using orbit_grpc_protos::ClientCaptureEvent;
+using orbit_grpc_protos::ThreadStateSlice;
+using testing::ElementsAre;
+
+namespace orbit_producer_event_processor {
+
+namespace {
+
+ClientCaptureEvent CreateFunctionCallEvent(uint32_t tid, uint64_t function_id,
+                                           uint64_t end_timestamp_ns) {
+  ClientCaptureEvent event;
+  orbit_grpc_protos::FunctionCall* function_call = event.mutable_function_call();
+  function_call->set_pid(42);
+  function_call->set_tid(tid);
+  function_call->set_function_id(function_id);
+  function_call->set_duration_ns(100);
+  function_call->set_end_timestamp_ns(end_timestamp_ns);
+  function_call->set_depth(1);
+  function_call->set_return_value(7);
+  return event;
+}
+
+ClientCaptureEvent CreateCallstackSampleEvent(uint64_t callstack_id, uint64_t timestamp_ns) {
+  ClientCaptureEvent event;
+  orbit_grpc_protos::CallstackSample* callstack_sample = event.mutable_callstack_sample();
+  callstack_sample->set_pid(42);
+  callstack_sample->set_tid(43);
+  callstack_sample->set_callstack_id(callstack_id);
+  callstack_sample->set_timestamp_ns(timestamp_ns);
+  return event;
+}
+
+ClientCaptureEvent CreateInternedCallstackEvent(uint64_t key) {
+  ClientCaptureEvent event;
+  event.mutable_interned_callstack()->set_key(key);
+  return event;
+}
+
+}  // namespace
+
+TEST(ClientCaptureEventBatcher, FunctionCallsAreMergedIntoOneBatch) {
+  CaptureResponse capture_response;
+  ClientCaptureEventBatcher batcher{&capture_response};
+  batcher.AddEvent(CreateFunctionCallEvent(1, 10, 1000));
+  batcher.AddEvent(ClientCaptureEvent{});
+  batcher.AddEvent(CreateFunctionCallEvent(2, 20, 900));
+  batcher.AddEvent(CreateFunctionCallEvent(1, 30, 1500));
+
+  EXPECT_EQ(batcher.GetEventCount(), 4);
+  EXPECT_EQ(GetClientCaptureEventCount(capture_response), 4);
+  ASSERT_EQ(capture_response.capture_events_size(), 2);
+  ASSERT_EQ(capture_response.capture_events(0).event_case(),
+            ClientCaptureEvent::kFunctionCallBatch);
+  EXPECT_EQ(capture_response.capture_events(1).event_case(), ClientCaptureEvent::EVENT_NOT_SET);
+
+  const orbit_grpc_protos::FunctionCallBatch& batch =
+      capture_response.capture_events(0).function_call_batch();
+  EXPECT_THAT(batch.pids(), ElementsAre(42, 42, 42));
+  EXPECT_THAT(batch.tids(), ElementsAre(1, 2, 1));
+  EXPECT_THAT(batch.function_ids(), ElementsAre(10, 20, 30));
+  EXPECT_THAT(batch.durations_ns(), ElementsAre(100, 100, 100));
+  EXPECT_THAT(batch.end_timestamp_deltas_ns(), ElementsAre(1000, -100, 600));
+  EXPECT_THAT(batch.depths(), ElementsAre(1, 1, 1));
+  EXPECT_THAT(batch.return_values(), ElementsAre(7, 7, 7));
+}
+
+TEST(ClientCaptureEventBatcher, FunctionCallsWithRegistersAreNotBatched) {
+  CaptureResponse capture_response;
+  ClientCaptureEventBatcher batcher{&capture_response};
+  ClientCaptureEvent event_with_registers = CreateFunctionCallEvent(1, 10, 1000);
+  event_with_registers.mutable_function_call()->add_registers(3);
+  batcher.AddEvent(ClientCaptureEvent{event_with_registers});
+
+  ASSERT_EQ(capture_response.capture_events_size(), 1);
+  ASSERT_EQ(capture_response.capture_events(0).event_case(), ClientCaptureEvent::kFunctionCall);
+  EXPECT_EQ(capture_response.capture_events(0).function_call().SerializeAsString(),
+            event_with_registers.function_call().SerializeAsString());
+}
+
+TEST(ClientCaptureEventBatcher, InternedCallstackStartsNewCallstackSampleBatch) {
+  CaptureResponse capture_response;
+  ClientCaptureEventBatcher batcher{&capture_response};
+  batcher.AddEvent(CreateInternedCallstackEvent(1));
+  batcher.AddEvent(CreateCallstackSampleEvent(1, 1000));
+  batcher.AddEvent(CreateCallstackSampleEvent(1, 2000));
+  batcher.AddEvent(CreateInternedCallstackEvent(2));
+  batcher.AddEvent(CreateCallstackSampleEvent(2, 3000));
+
+  EXPECT_EQ(GetClientCaptureEventCount(capture_response), 5);
+  ASSERT_EQ(capture_response.capture_events_size(), 4);
+  EXPECT_EQ(capture_response.capture_events(0).event_case(),
+            ClientCaptureEvent::kInternedCallstack);
+  ASSERT_EQ(capture_response.capture_events(1).event_case(),
+            ClientCaptureEvent::kCallstackSampleBatch);
+  EXPECT_EQ(capture_response.capture_events(2).event_case(),
+            ClientCaptureEvent::kInternedCallstack);
+  ASSERT_EQ(capture_response.capture_events(3).event_case(),
+            ClientCaptureEvent::kCallstackSampleBatch);
+
+  const orbit_grpc_protos::CallstackSampleBatch& first_batch =
+      capture_response.capture_events(1).callstack_sample_batch();
+  EXPECT_THAT(first_batch.callstack_ids(), ElementsAre(1, 1));
+  EXPECT_THAT(first_batch.timestamp_deltas_ns(), ElementsAre(1000, 1000));
+  const orbit_grpc_protos::CallstackSampleBatch& second_batch =
+      capture_response.capture_events(3).callstack_sample_batch();
+  EXPECT_THAT(second_batch.callstack_ids(), ElementsAre(2));
+  EXPECT_THAT(second_batch.timestamp_deltas_ns(), ElementsAre(3000));
+}
+
+TEST(ClientCaptureEventBatcher, SchedulingSlicesAndThreadStateSlices) {
+  CaptureResponse capture_response;
+  ClientCaptureEventBatcher batcher{&capture_response};
+
+  ClientCaptureEvent scheduling_slice_event;
+  orbit_grpc_protos::SchedulingSlice* scheduling_slice =
+      scheduling_slice_event.mutable_scheduling_slice();
+  scheduling_slice->set_pid(42);
+  scheduling_slice->set_tid(43);
+  scheduling_slice->set_core(3);
+  scheduling_slice->set_duration_ns(50);
+  scheduling_slice->set_out_timestamp_ns(2000);
+  batcher.AddEvent(ClientCaptureEvent{scheduling_slice_event});
+
+  ClientCaptureEvent thread_state_slice_event;
+  ThreadStateSlice* thread_state_slice = thread_state_slice_event.mutable_thread_state_slice();
+  thread_state_slice->set_tid(43);
+  thread_state_slice->set_thread_state(ThreadStateSlice::kInterruptibleSleep);
+  thread_state_slice->set_duration_ns(60);
+  thread_state_slice->set_end_timestamp_ns(3000);
+  thread_state_slice->set_wakeup_reason(ThreadStateSlice::kUnblocked);
+  thread_state_slice->set_wakeup_tid(44);
+  thread_state_slice->set_wakeup_pid(42);
+  thread_state_slice->set_switch_out_or_wakeup_callstack_status(ThreadStateSlice::kCallstackSet);
+  thread_state_slice->set_switch_out_or_wakeup_callstack_id(5);
+  batcher.AddEvent(ClientCaptureEvent{thread_state_slice_event});
+
+  scheduling_slice->set_core(4);
+  scheduling_slice->set_out_timestamp_ns(2500);
+  batcher.AddEvent(ClientCaptureEvent{scheduling_slice_event});
+
+  ASSERT_EQ(capture_response.capture_events_size(), 2);
+  ASSERT_EQ(capture_response.capture_events(0).event_case(),
+            ClientCaptureEvent::kSchedulingSliceBatch);
+  ASSERT_EQ(capture_response.capture_events(1).event_case(),
+            ClientCaptureEvent::kThreadStateSliceBatch);
+
+  const orbit_grpc_protos::SchedulingSliceBatch& scheduling_slice_batch =
+      capture_response.capture_events(0).scheduling_slice_batch();
+  EXPECT_THAT(scheduling_slice_batch.tids(), ElementsAre(43, 43));
+  EXPECT_THAT(scheduling_slice_batch.cores(), ElementsAre(3, 4));
+  EXPECT_THAT(scheduling_slice_batch.durations_ns(), ElementsAre(50, 50));
+  EXPECT_THAT(scheduling_slice_batch.out_timestamp_deltas_ns(), ElementsAre(2000, 500));
+
+  const orbit_grpc_protos::ThreadStateSliceBatch& thread_state_slice_batch =
+      capture_response.capture_events(1).thread_state_slice_batch();
+  EXPECT_THAT(thread_state_slice_batch.tids(), ElementsAre(43));
+  EXPECT_THAT(thread_state_slice_batch.thread_states(),
+              ElementsAre(ThreadStateSlice::kInterruptibleSleep));
+  EXPECT_THAT(thread_state_slice_batch.end_timestamp_deltas_ns(), ElementsAre(3000));
+  EXPECT_THAT(thread_state_slice_batch.wakeup_reasons(), ElementsAre(ThreadStateSlice::kUnblocked));
+  EXPECT_THAT(thread_state_slice_batch.wakeup_tids(), ElementsAre(44));
+  EXPECT_THAT(thread_state_slice_batch.switch_out_or_wakeup_callstack_statuses(),
+              ElementsAre(ThreadStateSlice::kCallstackSet));
+  EXPECT_THAT(thread_state_slice_batch.switch_out_or_wakeup_callstack_ids(), ElementsAre(5));
+}
+
+}  // namespace orbit_producer_event_processor
@@ -12,6 +12,7 @@
 #include <utility>
 
 #include "ApiInterface/Orbit.h"
+#include "GrpcProtos/Constants.h"
 #include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/MakeUniqueForOverwrite.h"
@@ -37,8 +38,10 @@ static void InitializeArenaOfCaptureResponses(
 
 GrpcClientCaptureEventCollector::GrpcClientCaptureEventCollector(
     grpc::ServerReaderWriterInterface<orbit_grpc_protos::CaptureResponse,
-                                      orbit_grpc_protos::CaptureRequest>* reader_writer)
-    : reader_writer_{reader_writer} {
+                                      orbit_grpc_protos::CaptureRequest>* reader_writer,
+    std::shared_ptr<const std::atomic<uint64_t>> client_capture_backlog_byte_count)
+    : reader_writer_{reader_writer},
+      client_capture_backlog_byte_count_{std::move(client_capture_backlog_byte_count)} {
   ORBIT_CHECK(reader_writer_ != nullptr);
 
   InitializeArenaOfCaptureResponses(&arena_of_capture_responses_being_built_,
@@ -46,6 +49,23 @@ GrpcClientCaptureEventCollector::GrpcClientCaptureEventCollector(
   InitializeArenaOfCaptureResponses(&arena_of_capture_responses_to_send_,
                                     &initial_block_of_second_arena_);
 
+  orbit_base::StatsRegistry& registry = orbit_base::StatsRegistry::GetDefault();
+  live_stats_registrations_.push_back(
+      registry.Register("grpc_client_capture_event_collector.unsent_event_count", [this] {
+        // The two counters are not read atomically together, hence the clamping.
+        const uint64_t added = total_number_of_events_added_.load(std::memory_order_relaxed);
+        const uint64_t sent = total_number_of_events_sent_.load(std::memory_order_relaxed);
+        return added > sent ? added - sent : 0;
+      }));
+  live_stats_registrations_.push_back(
+      registry.Register("grpc_client_capture_event_collector.sent_event_count", [this] {
+        return total_number_of_events_sent_.load(std::memory_order_relaxed);
+      }));
+  live_stats_registrations_.push_back(
+      registry.Register("grpc_client_capture_event_collector.sent_byte_count", [this] {
+        return total_number_of_bytes_sent_.load(std::memory_order_relaxed);
+      }));
+
   sender_thread_ = std::thread{[this] { SenderThread(); }};
 }
 
@@ -62,13 +82,14 @@ void GrpcClientCaptureEventCollector::AddEvent(ClientCaptureEvent&& event) {
   // - could exceed the maximum gRPC message size.
   static constexpr int kMaxEventsPerCaptureResponse = 10'000;
   if (capture_responses_being_built_.empty() ||
-      capture_responses_being_built_.back()->capture_events_size() ==
-          kMaxEventsPerCaptureResponse) {
+      batcher_->GetEventCount() == kMaxEventsPerCaptureResponse) {
     auto* capture_response = google::protobuf::Arena::CreateMessage<CaptureResponse>(
         arena_of_capture_responses_being_built_.get());
     capture_responses_being_built_.push_back(capture_response);
+    batcher_.emplace(capture_response);
   }
-  capture_responses_being_built_.back()->mutable_capture_events()->Add(std::move(event));
+  batcher_->AddEvent(std::move(event));
+  total_number_of_events_added_.fetch_add(1, std::memory_order_relaxed);
 }
 
 void GrpcClientCaptureEventCollector::StopAndWait() {
@@ -85,24 +106,52 @@ void GrpcClientCaptureEventCollector::StopAndWait() {
 GrpcClientCaptureEventCollector::~GrpcClientCaptureEventCollector() {
   ORBIT_CHECK(!sender_thread_.joinable());
 
-  ORBIT_LOG("Total number of events sent: %u", total_number_of_events_sent_);
-  ORBIT_LOG("Total number of bytes sent: %u", total_number_of_bytes_sent_);
+  live_stats_registrations_.clear();
+  const uint64_t total_number_of_events_sent = total_number_of_events_sent_;
+  const uint64_t total_number_of_bytes_sent = total_number_of_bytes_sent_;
+
+  ORBIT_LOG("Total number of events sent: %u", total_number_of_events_sent);
+  ORBIT_LOG("Total number of bytes sent: %u", total_number_of_bytes_sent);
 
-  if (total_number_of_events_sent_ > 0) {
-    float average_bytes = static_cast<float>(total_number_of_bytes_sent_) /
-                          static_cast<float>(total_number_of_events_sent_);
+  if (total_number_of_events_sent > 0) {
+    float average_bytes = static_cast<float>(total_number_of_bytes_sent) /
+                          static_cast<float>(total_number_of_events_sent);
     ORBIT_LOG("Average number of bytes per event: %.2f", average_bytes);
   }
+
+  ORBIT_LOG("CPU time spent writing CaptureResponses: %.3f ms",
+            static_cast<double>(total_write_cpu_time_ns_) / 1'000'000);
+  if (total_number_of_bytes_sent > 0) {
+    ORBIT_LOG("CPU time spent writing CaptureResponses per MB: %.3f ms",
+              static_cast<double>(total_write_cpu_time_ns_) /
+                  static_cast<double>(total_number_of_bytes_sent));
+  }
 }
 
 void GrpcClientCaptureEventCollector::SenderThread() {
   orbit_base::SetCurrentThreadName("SenderThread");
   constexpr absl::Duration kSendTimeInterval = absl::Milliseconds(20);
+  constexpr absl::Duration kSendTimeIntervalWhenClientIsBehind = absl::Milliseconds(200);
+  constexpr size_t kFullCaptureResponsesToSendAtOnceWhenClientIsBehind = 8;
 
   bool stopped = false;
+  bool client_is_behind = false;
   while (!stopped) {
     ORBIT_SCOPE("SenderThread iteration");
 
+    const bool client_was_behind = client_is_behind;
+    client_is_behind = client_capture_backlog_byte_count_ != nullptr &&
+                       client_capture_backlog_byte_count_->load(std::memory_order_relaxed) >
+                           orbit_grpc_protos::kClientCaptureBacklogThresholdBytes;
+    if (client_is_behind != client_was_behind) {
+      ORBIT_LOG("The client is %s: sending CaptureResponses %s",
+                client_is_behind ? "behind" : "no longer behind",
+                client_is_behind ? "less often" : "as usual");
+      full_capture_responses_to_send_at_once_.store(
+          client_is_behind ? kFullCaptureResponsesToSendAtOnceWhenClientIsBehind : 1,
+          std::memory_order_relaxed);
+    }
+
     mutex_.LockWhenWithTimeout(
         absl::Condition(
             +[](GrpcClientCaptureEventCollector* self) ABSL_EXCLUSIVE_LOCKS_REQUIRED(self->mutex_) {
@@ -111,13 +160,16 @@ void GrpcClientCaptureEventCollector::SenderThread() {
               // true.
               constexpr int kSendEventCountInterval = 5000;
 
-              return (self->capture_responses_being_built_.size() == 1 &&
-                      self->capture_responses_being_built_.back()->capture_events_size() >=
-                          kSendEventCountInterval) ||
-                     self->capture_responses_being_built_.size() > 1 || self->stop_requested_;
+              const size_t full_capture_responses_to_send_at_once =
+                  self->full_capture_responses_to_send_at_once_.load(std::memory_order_relaxed);
+              const size_t capture_response_count = self->capture_responses_being_built_.size();
+              return (capture_response_count == full_capture_responses_to_send_at_once &&
+                      self->batcher_->GetEventCount() >= kSendEventCountInterval) ||
+                     capture_response_count > full_capture_responses_to_send_at_once ||
+                     self->stop_requested_;
             },
             this),
-        kSendTimeInterval);
+        client_is_behind ? kSendTimeIntervalWhenClientIsBehind : kSendTimeInterval);
     if (stop_requested_) {
       stopped = true;
     }
@@ -130,10 +182,12 @@ void GrpcClientCaptureEventCollector::SenderThread() {
     // `arena_of_capture_response_to_send_` are effectively the two buffers.
     arena_of_capture_responses_being_built_.swap(arena_of_capture_responses_to_send_);
     capture_responses_being_built_.swap(capture_responses_to_send_);
+    batcher_.reset();
     mutex_.Unlock();
 
     uint64_t number_of_events_sent = 0;
     uint64_t number_of_bytes_sent = 0;
+    uint64_t write_cpu_time_ns = 0;
 
     // Note that usually we only have one CaptureResponse to send because kSendEventCountInterval is
     // quite lower than kMaxEventsPerCaptureResponse. But we can have more than one if new events
@@ -141,7 +195,7 @@ void GrpcClientCaptureEventCollector::SenderThread() {
     // is a bit unresponsive.
     for (CaptureResponse* capture_response : capture_responses_to_send_) {
       // Record statistics on event count and byte size for this CaptureResponse.
-      int capture_response_event_count = capture_response->capture_events_size();
+      int capture_response_event_count = GetClientCaptureEventCount(*capture_response);
       ORBIT_CHECK(capture_response_event_count > 0);
       ORBIT_INT("Number of CaptureEvents in CaptureResponse", capture_response_event_count);
 
@@ -154,7 +208,9 @@ void GrpcClientCaptureEventCollector::SenderThread() {
       // Now send the CaptureResponse.
       {
         ORBIT_SCOPE("reader_writer_->Write");
+        const uint64_t cpu_time_before_write_ns = orbit_base::GetCurrentThreadCpuTimeNs();
         reader_writer_->Write(*capture_response);
+        write_cpu_time_ns += orbit_base::GetCurrentThreadCpuTimeNs() - cpu_time_before_write_ns;
       }
     }
 
@@ -166,9 +222,11 @@ void GrpcClientCaptureEventCollector::SenderThread() {
       [[maybe_unused]] const float average_bytes =
           static_cast<float>(number_of_bytes_sent) / static_cast<float>(number_of_events_sent);
       ORBIT_FLOAT("Average bytes per CaptureEvent", average_bytes);
+      ORBIT_UINT64("CPU time of writing CaptureResponses (ns)", write_cpu_time_ns);
 
-      total_number_of_events_sent_ += number_of_events_sent;
-      total_number_of_bytes_sent_ += number_of_bytes_sent;
+      total_number_of_events_sent_.fetch_add(number_of_events_sent, std::memory_order_relaxed);
+      total_number_of_bytes_sent_.fetch_add(number_of_bytes_sent, std::memory_order_relaxed);
+      total_write_cpu_time_ns_ += write_cpu_time_ns;
     }
 
     capture_responses_to_send_.clear();
@@ -0,0 +1,69 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ProducerEventProcessor/OffCpuTimeAggregator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+
+using orbit_grpc_protos::OffCpuTimeSummary;
+using orbit_grpc_protos::ThreadStateSlice;
+
+namespace orbit_producer_event_processor {
+
+bool OffCpuTimeAggregator::IsAggregatable(const ThreadStateSlice& thread_state_slice) {
+  return thread_state_slice.thread_state() != ThreadStateSlice::kRunning &&
+         thread_state_slice.wakeup_reason() == ThreadStateSlice::kNotApplicable &&
+         thread_state_slice.switch_out_or_wakeup_callstack_status() ==
+             ThreadStateSlice::kCallstackSet;
+}
+
+std::vector<OffCpuTimeSummary> OffCpuTimeAggregator::AddThreadStateSlice(
+    const ThreadStateSlice& thread_state_slice) {
+  ORBIT_CHECK(IsAggregatable(thread_state_slice));
+  const uint64_t end_timestamp_ns = thread_state_slice.end_timestamp_ns();
+  const uint64_t begin_timestamp_ns = end_timestamp_ns - thread_state_slice.duration_ns();
+
+  std::vector<OffCpuTimeSummary> finished_summaries;
+  if (!summaries_.empty() && end_timestamp_ns >= interval_start_timestamp_ns_ &&
+      end_timestamp_ns - interval_start_timestamp_ns_ >= interval_ns_) {
+    finished_summaries = Flush();
+  }
+  if (summaries_.empty()) interval_start_timestamp_ns_ = end_timestamp_ns;
+
+  auto [it, inserted] = summaries_.try_emplace(
+      Key{thread_state_slice.tid(), thread_state_slice.thread_state(),
+          thread_state_slice.switch_out_or_wakeup_callstack_id()});
+  OffCpuTimeSummary& summary = it->second;
+  if (inserted) {
+    summary.set_pid(thread_state_slice.pid());
+    summary.set_tid(thread_state_slice.tid());
+    summary.set_thread_state(thread_state_slice.thread_state());
+    summary.set_callstack_id(thread_state_slice.switch_out_or_wakeup_callstack_id());
+    summary.set_min_begin_timestamp_ns(begin_timestamp_ns);
+    summary.set_max_end_timestamp_ns(end_timestamp_ns);
+  } else {
+    summary.set_min_begin_timestamp_ns(
+        std::min(summary.min_begin_timestamp_ns(), begin_timestamp_ns));
+    summary.set_max_end_timestamp_ns(std::max(summary.max_end_timestamp_ns(), end_timestamp_ns));
+  }
+  summary.set_count(summary.count() + 1);
+  summary.set_total_duration_ns(summary.total_duration_ns() + thread_state_slice.duration_ns());
+
+  return finished_summaries;
+}
+
+std::vector<OffCpuTimeSummary> OffCpuTimeAggregator::Flush() {
+  std::vector<OffCpuTimeSummary> summaries;
+  summaries.reserve(summaries_.size());
+  for (auto& [unused_key, summary] : summaries_) {
+    summaries.push_back(std::move(summary));
+  }
+  summaries_.clear();
+  return summaries;
+}
+
+}  // namespace orbit_producer_event_processor
@@ -0,0 +1,137 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+#include "ProducerEventProcessor/OffCpuTimeAggregator.h"
+
+using orbit_grpc_protos::OffCpuTimeSummary;
+using orbit_grpc_protos::ThreadStateSlice;
+using testing::AllOf;
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::Property;
+using testing::UnorderedElementsAre;
+
+namespace orbit_producer_event_processor {
+
+namespace {
+
+constexpr uint32_t kPid = 5;
+constexpr uint32_t kTid1 = 7;
+constexpr uint32_t kTid2 = 11;
+constexpr uint64_t kCallstackId1 = 13;
+constexpr uint64_t kCallstackId2 = 17;
+constexpr uint64_t kIntervalNs = 1000;
+
+[[nodiscard]] ThreadStateSlice CreateThreadStateSlice(uint32_t tid,
+                                                      ThreadStateSlice::ThreadState thread_state,
+                                                      uint64_t callstack_id,
+                                                      uint64_t begin_timestamp_ns,
+                                                      uint64_t end_timestamp_ns) {
+  ThreadStateSlice thread_state_slice;
+  thread_state_slice.set_pid(kPid);
+  thread_state_slice.set_tid(tid);
+  thread_state_slice.set_thread_state(thread_state);
+  thread_state_slice.set_duration_ns(end_timestamp_ns - begin_timestamp_ns);
+  thread_state_slice.set_end_timestamp_ns(end_timestamp_ns);
+  thread_state_slice.set_switch_out_or_wakeup_callstack_status(ThreadStateSlice::kCallstackSet);
+  thread_state_slice.set_switch_out_or_wakeup_callstack_id(callstack_id);
+  return thread_state_slice;
+}
+
+auto SummaryIs(uint32_t tid, ThreadStateSlice::ThreadState thread_state, uint64_t callstack_id,
+               uint64_t count, uint64_t total_duration_ns, uint64_t min_begin_timestamp_ns,
+               uint64_t max_end_timestamp_ns) {
+  return AllOf(Property(&OffCpuTimeSummary::pid, kPid), Property(&OffCpuTimeSummary::tid, tid),
+               Property(&OffCpuTimeSummary::thread_state, thread_state),
+               Property(&OffCpuTimeSummary::callstack_id, callstack_id),
+               Property(&OffCpuTimeSummary::count, count),
+               Property(&OffCpuTimeSummary::total_duration_ns, total_duration_ns),
+               Property(&OffCpuTimeSummary::min_begin_timestamp_ns, min_begin_timestamp_ns),
+               Property(&OffCpuTimeSummary::max_end_timestamp_ns, max_end_timestamp_ns));
+}
+
+}  // namespace
+
+TEST(OffCpuTimeAggregator, IsAggregatable) {
+  ThreadStateSlice thread_state_slice =
+      CreateThreadStateSlice(kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 0, 10);
+  EXPECT_TRUE(OffCpuTimeAggregator::IsAggregatable(thread_state_slice));
+
+  ThreadStateSlice running_slice = thread_state_slice;
+  running_slice.set_thread_state(ThreadStateSlice::kRunning);
+  EXPECT_FALSE(OffCpuTimeAggregator::IsAggregatable(running_slice));
+
+  ThreadStateSlice woken_up_slice = thread_state_slice;
+  woken_up_slice.set_wakeup_reason(ThreadStateSlice::kUnblocked);
+  EXPECT_FALSE(OffCpuTimeAggregator::IsAggregatable(woken_up_slice));
+
+  ThreadStateSlice slice_without_callstack = thread_state_slice;
+  slice_without_callstack.set_switch_out_or_wakeup_callstack_status(
+      ThreadStateSlice::kNoCallstack);
+  EXPECT_FALSE(OffCpuTimeAggregator::IsAggregatable(slice_without_callstack));
+}
+
+TEST(OffCpuTimeAggregator, SumsUpSlicesPerThreadStateAndCallstack) {
+  OffCpuTimeAggregator aggregator{kIntervalNs};
+
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 100, 200)),
+              IsEmpty());
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 300, 350)),
+              IsEmpty());
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid1, ThreadStateSlice::kUninterruptibleSleep, kCallstackId1, 400, 500)),
+              IsEmpty());
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId2, 500, 700)),
+              IsEmpty());
+  // Slices don't necessarily arrive ordered by their end.
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid2, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 10, 150)),
+              IsEmpty());
+
+  EXPECT_THAT(
+      aggregator.Flush(),
+      UnorderedElementsAre(
+          SummaryIs(kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 2, 150, 100, 350),
+          SummaryIs(kTid1, ThreadStateSlice::kUninterruptibleSleep, kCallstackId1, 1, 100, 400,
+                    500),
+          SummaryIs(kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId2, 1, 200, 500, 700),
+          SummaryIs(kTid2, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 1, 140, 10,
+                    150)));
+  EXPECT_THAT(aggregator.Flush(), IsEmpty());
+}
+
+TEST(OffCpuTimeAggregator, ReturnsSummariesOfFinishedIntervals) {
+  OffCpuTimeAggregator aggregator{kIntervalNs};
+
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 100, 200)),
+              IsEmpty());
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 900, 1199)),
+              IsEmpty());
+  // Ends one interval after the first slice, so it starts the next interval.
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 1199, 1200)),
+              ElementsAre(SummaryIs(kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1,
+                                    2, 399, 100, 1199)));
+  EXPECT_THAT(aggregator.AddThreadStateSlice(CreateThreadStateSlice(
+                  kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 1500, 2000)),
+              IsEmpty());
+
+  EXPECT_THAT(aggregator.Flush(),
+              ElementsAre(SummaryIs(kTid1, ThreadStateSlice::kInterruptibleSleep, kCallstackId1, 2,
+                                    501, 1199, 2000)));
+}
+
+}  // namespace orbit_producer_event_processor
@@ -4,20 +4,34 @@
 
 #include "ProducerEventProcessor/ProducerEventProcessor.h"
 
+#include <absl/base/thread_annotations.h>
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include <absl/hash/hash.h>
 #include <absl/meta/type_traits.h>
+#include <absl/strings/str_format.h>
 #include <absl/synchronization/mutex.h>
+#include <google/protobuf/arena.h>
 #include <google/protobuf/stubs/port.h>
+#include <xxhash.h>
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "ApiUtils/PackedApiEvents.h"
 #include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/tracepoint.pb.h"
 #include "OrbitBase/Logging.h"
+#include "OrbitBase/MakeUniqueForOverwrite.h"
+#include "OrbitBase/StatsRegistry.h"
 #include "ProducerEventProcessor/ClientCaptureEventCollector.h"
+#include "ProducerEventProcessor/OffCpuTimeAggregator.h"
 
 using orbit_grpc_protos::AddressInfo;
 using orbit_grpc_protos::ApiScopeStart;
@@ -31,6 +45,7 @@ using orbit_grpc_protos::ApiTrackInt;
 using orbit_grpc_protos::ApiTrackInt64;
 using orbit_grpc_protos::ApiTrackUint;
 using orbit_grpc_protos::ApiTrackUint64;
+using orbit_grpc_protos::ApiTrackValueSummary;
 using orbit_grpc_protos::Callstack;
 using orbit_grpc_protos::CallstackSample;
 using orbit_grpc_protos::CaptureFinished;
@@ -43,6 +58,7 @@ using orbit_grpc_protos::ErrorsWithPerfEventOpenEvent;
 using orbit_grpc_protos::FullAddressInfo;
 using orbit_grpc_protos::FullCallstackSample;
 using orbit_grpc_protos::FullGpuJob;
+using orbit_grpc_protos::FullPageFaultSample;
 using orbit_grpc_protos::FullTracepointEvent;
 using orbit_grpc_protos::FunctionCall;
 using orbit_grpc_protos::GpuDebugMarker;
@@ -55,8 +71,14 @@ using orbit_grpc_protos::LostPerfRecordsEvent;
 using orbit_grpc_protos::MemoryUsageEvent;
 using orbit_grpc_protos::ModulesSnapshot;
 using orbit_grpc_protos::ModuleUpdateEvent;
+using orbit_grpc_protos::OffCpuTimeSummary;
 using orbit_grpc_protos::OutOfOrderEventsDiscardedEvent;
+using orbit_grpc_protos::PackedApiEvents;
+using orbit_grpc_protos::PageFaultSample;
+using orbit_grpc_protos::PerfEventProcessingStatsEvent;
+using orbit_grpc_protos::PerformanceCounterSample;
 using orbit_grpc_protos::PresentEvent;
+using orbit_grpc_protos::PressureStallEvent;
 using orbit_grpc_protos::ProducerCaptureEvent;
 using orbit_grpc_protos::SchedulingSlice;
 using orbit_grpc_protos::ThreadName;
@@ -72,56 +94,191 @@ namespace orbit_producer_event_processor {
 
 namespace {
 
+// Assigns ids to entries, and can be used from multiple threads at the same time. The entries are
+// distributed over shards with separate locks, and looking up an entry already interned only takes
+// the shared lock of its shard, so that concurrent callers rarely have to wait for each other.
 template <typename T>
 class InternPool final {
  public:
   InternPool() = default;
 
-  // Return pair of <id, assigned>, where assigned is true if the entry was assigned a new id
-  // and false if returning id for already existing entry.
-  std::pair<uint64_t, bool> GetOrAssignId(const T& entry) {
-    absl::MutexLock lock(&entry_to_id_mutex_);
-    auto it = entry_to_id_.find(entry);
-    if (it != entry_to_id_.end()) {
-      return std::make_pair(it->second, false);
+  // Returns the id of `entry`. If `entry` is assigned a new id, `on_assigned` is called with it
+  // before any other caller can obtain the same id. This allows sending the interned entry to the
+  // client before any event referring to it, even if those events come from other threads.
+  template <typename OnAssigned>
+  uint64_t GetOrAssignId(const T& entry, OnAssigned&& on_assigned) {
+    Shard& shard = shards_[absl::Hash<T>{}(entry) >> (kHashBits - kShardIndexBits)];
+    {
+      absl::ReaderMutexLock lock(&shard.mutex);
+      auto it = std::as_const(shard.entry_to_id).find(entry);
+      if (it != shard.entry_to_id.cend()) return it->second;
     }
 
-    uint64_t new_id = id_counter_++;
-    auto [unused_it, inserted] = entry_to_id_.insert_or_assign(entry, new_id);
-    ORBIT_CHECK(inserted);
-    return std::make_pair(new_id, true);
+    absl::MutexLock lock(&shard.mutex);
+    auto [it, inserted] = shard.entry_to_id.try_emplace(entry, 0);
+    if (!inserted) return it->second;
+    it->second = id_counter_.fetch_add(1, std::memory_order_relaxed);
+    std::forward<OnAssigned>(on_assigned)(it->second);
+    return it->second;
+  }
+
+  // The number of ids assigned so far. This can be called concurrently with GetOrAssignId.
+  [[nodiscard]] uint64_t size() const { return id_counter_.load(std::memory_order_relaxed) - 1; }
+
+ private:
+  // The shard is selected with the most significant bits of the hash, as the hash tables inside
+  // the shards mostly use the least significant ones.
+  static constexpr size_t kHashBits = sizeof(size_t) * 8;
+  static constexpr size_t kShardIndexBits = 4;
+
+  struct Shard {
+    absl::Mutex mutex;
+    absl::flat_hash_map<T, uint64_t> entry_to_id ABSL_GUARDED_BY(mutex);
+  };
+
+  std::atomic<uint64_t> id_counter_ = 1;  // 0 is reserved for invalid_id
+  std::array<Shard, size_t{1} << kShardIndexBits> shards_;
+};
+
+// Callstacks are interned by a 128-bit hash of their type and program counters, which makes
+// collisions practically impossible, instead of by a copy of the program counters.
+struct CallstackHash {
+  uint64_t low;
+  uint64_t high;
+
+  friend bool operator==(const CallstackHash& lhs, const CallstackHash& rhs) {
+    return lhs.low == rhs.low && lhs.high == rhs.high;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const CallstackHash& hash) {
+    return H::combine(std::move(h), hash.low, hash.high);
+  }
+};
+
+// The vendored xxHash doesn't have a 128-bit variant, so two 64-bit hashes with independent seeds
+// are combined. The program counters are hashed in place, in the memory of the repeated field.
+[[nodiscard]] CallstackHash ComputeCallstackHash(const Callstack& callstack) {
+  constexpr uint64_t kLowSeed = 0x9E3779B97F4A7C15;
+  constexpr uint64_t kHighSeed = 0xC2B2AE3D27D4EB4F;
+  const void* pcs = callstack.pcs().data();
+  const size_t pcs_size = callstack.pcs_size() * sizeof(uint64_t);
+  const auto type = static_cast<uint64_t>(callstack.type());
+  return {XXH64(pcs, pcs_size, kLowSeed ^ type), XXH64(pcs, pcs_size, kHighSeed ^ type)};
+}
+
+// Holds the ClientCaptureEvents that are built from scratch rather than around a message released
+// from the ProducerCaptureEvent, e.g., the CallstackSamples made from FullCallstackSamples. They
+// are only needed until ClientCaptureEventCollector::AddEvent returns, which copies them into its
+// own CaptureResponses. So the arena is cleared after each ProducerCaptureEvent, and allocating an
+// event is a pointer bump in the same reused block instead of a heap allocation and deallocation.
+class ClientCaptureEventArena final {
+ public:
+  ClientCaptureEventArena()
+      : initial_block_{make_unique_for_overwrite<char[]>(kBlockSize)},
+        arena_{CreateArenaOptions(initial_block_.get())} {}
+
+  [[nodiscard]] ClientCaptureEvent* CreateEvent() {
+    return google::protobuf::Arena::CreateMessage<ClientCaptureEvent>(&arena_);
+  }
+
+  // Invalidates the events created so far. The arena is only reset once it had to allocate more
+  // blocks, as until then new events simply go after the previous ones in the initial block.
+  void Clear() {
+    if (arena_.SpaceAllocated() > kBlockSize) arena_.Reset();
   }
 
  private:
-  uint64_t id_counter_ = 1;  // 0 is reserved for invalid_id
-  absl::flat_hash_map<T, uint64_t> entry_to_id_;
-  absl::Mutex entry_to_id_mutex_;
+  static constexpr size_t kBlockSize = 64 * 1024;
+
+  [[nodiscard]] static google::protobuf::ArenaOptions CreateArenaOptions(char* initial_block) {
+    google::protobuf::ArenaOptions arena_options;
+    arena_options.initial_block = initial_block;
+    arena_options.initial_block_size = kBlockSize;
+    arena_options.start_block_size = kBlockSize;
+    arena_options.max_block_size = kBlockSize;
+    return arena_options;
+  }
+
+  std::unique_ptr<char[]> initial_block_;
+  google::protobuf::Arena arena_;
 };
 
 class ProducerEventProcessorImpl : public ProducerEventProcessor {
  public:
   ProducerEventProcessorImpl() = delete;
   explicit ProducerEventProcessorImpl(ClientCaptureEventCollector* client_capture_event_collector)
-      : client_capture_event_collector_{client_capture_event_collector} {}
+      : client_capture_event_collector_{client_capture_event_collector} {
+    orbit_base::StatsRegistry& registry = orbit_base::StatsRegistry::GetDefault();
+    live_stats_registrations_.push_back(
+        registry.Register("producer_event_processor.interned_callstack_count",
+                          [this] { return callstack_pool_.size(); }));
+    live_stats_registrations_.push_back(registry.Register(
+        "producer_event_processor.interned_string_count", [this] { return string_pool_.size(); }));
+    live_stats_registrations_.push_back(
+        registry.Register("producer_event_processor.interned_tracepoint_count",
+                          [this] { return tracepoint_pool_.size(); }));
+  }
 
   void ProcessEvent(uint64_t producer_id, ProducerCaptureEvent&& event) override;
+  void DropEventsOfProducersExcept(absl::flat_hash_set<uint64_t> producer_ids_to_keep) override;
 
  private:
+  // The state that only concerns the events of one producer. Calls to ProcessEvent for different
+  // producers only share the InternPools, so they can run concurrently.
+  struct ProducerState {
+    explicit ProducerState(uint64_t producer_id)
+        : producer_id{producer_id},
+          event_count_registration{orbit_base::StatsRegistry::GetDefault().Register(
+              absl::StrFormat("producer_event_processor.producer_%u.event_count", producer_id),
+              [this] { return event_count.load(std::memory_order_relaxed); })} {}
+
+    const uint64_t producer_id;
+    std::atomic<uint64_t> event_count = 0;
+    // Set by DropEventsOfProducersExcept, checked without taking `mutex`.
+    std::atomic<bool> drop_events = false;
+    // Held for the whole duration of ProcessEvent. Calls for the same producer are rarely
+    // concurrent, e.g., for events received with gRPC and through shared memory at the same time.
+    absl::Mutex mutex;
+    // These map InternedStrings and InternedCallstacks from producer ids to client ids.
+    absl::flat_hash_map<uint64_t, uint64_t> producer_callstack_id_to_client_callstack_id
+        ABSL_GUARDED_BY(mutex);
+    absl::flat_hash_map<uint64_t, uint64_t> producer_string_id_to_client_string_id
+        ABSL_GUARDED_BY(mutex);
+    ClientCaptureEventArena event_arena ABSL_GUARDED_BY(mutex);
+    // Declared last, so that it is unregistered before `event_count` is destroyed.
+    orbit_base::StatsRegistry::Registration event_count_registration;
+  };
+
+  [[nodiscard]] ProducerState* GetOrCreateProducerState(uint64_t producer_id);
+  void ProcessEventWithProducerState(ProducerState* producer_state, ProducerCaptureEvent&& event)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
+
   // Please keep the declarations here and the definitions below of these Process... methods
   // alphabetically ordered as in the definition of the ProducerCaptureEvent message.
-  void ProcessApiScopeStartAndTransferOwnership(ApiScopeStart* api_scope_start);
-  void ProcessApiScopeStartAsyncAndTransferOwnership(ApiScopeStartAsync* api_scope_start_async);
+  void ProcessApiScopeStartAndTransferOwnership(ProducerState* producer_state,
+                                                ApiScopeStart* api_scope_start)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
+  void ProcessApiScopeStartAsyncAndTransferOwnership(ProducerState* producer_state,
+                                                     ApiScopeStartAsync* api_scope_start_async)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
   void ProcessApiScopeStopAndTransferOwnership(ApiScopeStop* api_scope_stop);
   void ProcessApiScopeStopAsyncAndTransferOwnership(ApiScopeStopAsync* api_scope_stop_async);
-  void ProcessApiStringEventAndTransferOwnership(ApiStringEvent* api_string_event);
+  void ProcessApiStringEventAndTransferOwnership(ProducerState* producer_state,
+                                                 ApiStringEvent* api_string_event)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
   void ProcessApiTrackDoubleAndTransferOwnership(ApiTrackDouble* api_track_double);
   void ProcessApiTrackFloatAndTransferOwnership(ApiTrackFloat* api_track_float);
   void ProcessApiTrackIntAndTransferOwnership(ApiTrackInt* api_track_int);
   void ProcessApiTrackInt64AndTransferOwnership(ApiTrackInt64* api_track_int64);
   void ProcessApiTrackUintAndTransferOwnership(ApiTrackUint* api_track_uint);
   void ProcessApiTrackUint64AndTransferOwnership(ApiTrackUint64* api_track_uint64);
-  void ProcessCallstackSampleAndTransferOwnership(uint64_t producer_id,
-                                                  CallstackSample* callstack_sample);
+  void ProcessApiTrackValueSummaryAndTransferOwnership(
+      ProducerState* producer_state, ApiTrackValueSummary* api_track_value_summary)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
+  void ProcessCallstackSampleAndTransferOwnership(ProducerState* producer_state,
+                                                  CallstackSample* callstack_sample)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
   void ProcessCaptureFinishedAndTransferOwnership(CaptureFinished* capture_finished);
   void ProcessCaptureStartedAndTransferOwnership(CaptureStarted* capture_started);
   void ProcessClockResolutionEventAndTransferOwnership(
@@ -132,18 +289,28 @@ class ProducerEventProcessorImpl : public ProducerEventProcessor {
       ErrorEnablingUserSpaceInstrumentationEvent* error_event);
   void ProcessErrorsWithPerfEventOpenEventAndTransferOwnership(
       ErrorsWithPerfEventOpenEvent* errors_with_perf_event_open_event);
-  void ProcessFullCallstackSample(FullCallstackSample* full_callstack_sample);
+  void ProcessFullCallstackSample(ProducerState* producer_state,
+                                  FullCallstackSample* full_callstack_sample)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
   void ProcessFullAddressInfo(FullAddressInfo* full_address_info);
   void ProcessFullGpuJob(FullGpuJob* full_gpu_job_event);
-  void ProcessFullTracepointEvent(FullTracepointEvent* full_tracepoint_event);
+  void ProcessFullPageFaultSample(ProducerState* producer_state,
+                                  FullPageFaultSample* full_page_fault_sample)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
+  void ProcessFullTracepointEvent(ProducerState* producer_state,
+                                  FullTracepointEvent* full_tracepoint_event)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
   void ProcessFunctionCallAndTransferOwnership(FunctionCall* function_call);
-  void ProcessGpuQueueSubmissionAndTransferOwnership(uint64_t producer_id,
-                                                     GpuQueueSubmission* gpu_queue_submission);
+  void ProcessGpuQueueSubmissionAndTransferOwnership(ProducerState* producer_state,
+                                                     GpuQueueSubmission* gpu_queue_submission)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
   // ProcessInterned* functions remap producer intern_ids to the id space used in the client.
-  // They keep track of these mappings in producer_interned_callstack_id_to_client_callstack_id_
-  // and producer_interned_string_id_to_client_string_id_.
-  void ProcessInternedCallstack(uint64_t producer_id, InternedCallstack* interned_callstack);
-  void ProcessInternedString(uint64_t producer_id, InternedString* interned_string);
+  // They keep track of these mappings in the ProducerState of the producer.
+  void ProcessInternedCallstack(ProducerState* producer_state,
+                                InternedCallstack* interned_callstack)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
+  void ProcessInternedString(ProducerState* producer_state, InternedString* interned_string)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
   void ProcessLostPerfRecordsEventAndTransferOwnership(
       LostPerfRecordsEvent* lost_perf_records_event);
   void ProcessMemoryUsageEventAndTransferOwnership(MemoryUsageEvent* memory_usage_event);
@@ -151,7 +318,15 @@ class ProducerEventProcessorImpl : public ProducerEventProcessor {
   void ProcessModuleUpdateEventAndTransferOwnership(ModuleUpdateEvent* module_update_event);
   void ProcessOutOfOrderEventsDiscardedEventAndTransferOwnership(
       OutOfOrderEventsDiscardedEvent* out_of_order_events_discarded_event);
+  void ProcessPerfEventProcessingStatsEventAndTransferOwnership(
+      PerfEventProcessingStatsEvent* perf_event_processing_stats_event);
+  void ProcessPackedApiEvents(ProducerState* producer_state,
+                              const PackedApiEvents& packed_api_events)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
+  void ProcessPerformanceCounterSampleAndTransferOwnership(
+      PerformanceCounterSample* performance_counter_sample);
   void ProcessPresentEventAndTransferOwnership(PresentEvent* present_event);
+  void ProcessPressureStallEventAndTransferOwnership(PressureStallEvent* pressure_stall_event);
   void ProcessSchedulingSliceAndTransferOwnership(SchedulingSlice* scheduling_slice);
   void ProcessThreadNameAndTransferOwnership(ThreadName* thread_name);
   void ProcessThreadNamesSnapshotAndTransferOwnership(ThreadNamesSnapshot* thread_names_snapshot);
@@ -163,23 +338,32 @@ class ProducerEventProcessorImpl : public ProducerEventProcessor {
   void ProcessWarningInstrumentingWithUserSpaceInstrumentationEventAndTransferOwnership(
       WarningInstrumentingWithUserSpaceInstrumentationEvent* warning_event);
 
+  // Remaps the `name_key` of an Api event from the producer's InternedString keys to the client's.
+  template <typename NamedApiEvent>
+  void TranslateApiEventNameKey(ProducerState* producer_state, NamedApiEvent* api_event)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_state->mutex);
+  // Returns the client id of the `callstack` of a full sample event. The first time a callstack is
+  // seen, it is released from the event and sent as InternedCallstack.
+  template <typename FullSampleEvent>
+  [[nodiscard]] uint64_t InternCallstack(FullSampleEvent* full_sample_event);
   void SendInternedStringEvent(uint64_t key, std::string value);
-  void MergeThreadStateSliceWithCallstackAndTransferOwnership(ThreadStateSlice* thread_state_slice);
+  void MergeThreadStateSliceWithCallstackAndTransferOwnership(ThreadStateSlice* thread_state_slice)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(thread_state_slice_mutex_);
+  void SendOffCpuTimeSummaries(std::vector<OffCpuTimeSummary> off_cpu_time_summaries);
 
   ClientCaptureEventCollector* client_capture_event_collector_;
 
-  InternPool<std::pair<std::vector<uint64_t>, Callstack::CallstackType>> callstack_pool_;
+  InternPool<CallstackHash> callstack_pool_;
   InternPool<std::string> string_pool_;
   InternPool<std::pair<std::string, std::string>> tracepoint_pool_;
 
-  // These are mapping InternStrings and InternedCallstacks from producer ids
-  // to client ids:
-  // <producer_id, producer_callstack_id> -> client_callstack_id
-  absl::flat_hash_map<std::pair<uint64_t, uint64_t>, uint64_t>
-      producer_interned_callstack_id_to_client_callstack_id_;
-  // <producer_id, producer_string_id> -> client_string_id
-  absl::flat_hash_map<std::pair<uint64_t, uint64_t>, uint64_t>
-      producer_interned_string_id_to_client_string_id_;
+  absl::Mutex producer_states_mutex_;
+  // The ProducerStates are never destroyed before this object, so that pointers to them stay valid.
+  absl::flat_hash_map<uint64_t, std::unique_ptr<ProducerState>> producer_states_
+      ABSL_GUARDED_BY(producer_states_mutex_);
+  // Also applies to the ProducerStates created after DropEventsOfProducersExcept was called.
+  std::optional<absl::flat_hash_set<uint64_t>> producer_ids_to_keep_
+      ABSL_GUARDED_BY(producer_states_mutex_);
 
   // Needed to allow merging of thread state slices and their callstacks, see:
   // http://go/stadia-orbit-tracepoint-callstack.
@@ -187,8 +371,17 @@ class ProducerEventProcessorImpl : public ProducerEventProcessor {
   // the begin tracepoint event that results in the ThreadStateSliceCallstack, so we will always
   // see the ThreadStateSliceCallstack before we see the matching ThreadStateSlice. Thus, we do not
   // need to save the thread state slices to be merged with a callstack later.
+  // Only the producer of the thread state slices accesses this, so the mutex is not contended.
+  absl::Mutex thread_state_slice_mutex_;
   absl::flat_hash_map<std::pair<uint32_t, uint64_t>, uint64_t>
-      thread_state_slice_tid_and_begin_timestamp_to_callstack_id_;
+      thread_state_slice_tid_and_begin_timestamp_to_callstack_id_
+          ABSL_GUARDED_BY(thread_state_slice_mutex_);
+  // Set at CaptureStarted if CaptureOptions.off_cpu_time_aggregation_interval_ns is not 0.
+  std::optional<OffCpuTimeAggregator> off_cpu_time_aggregator_
+      ABSL_GUARDED_BY(thread_state_slice_mutex_);
+
+  // Declared last, so that they are unregistered before the InternPools are destroyed.
+  std::vector<orbit_base::StatsRegistry::Registration> live_stats_registrations_;
 };
 
 void ProducerEventProcessorImpl::MergeThreadStateSliceWithCallstackAndTransferOwnership(
@@ -226,20 +419,66 @@ void ProducerEventProcessorImpl::MergeThreadStateSliceWithCallstackAndTransferOw
   thread_state_slice_tid_and_begin_timestamp_to_callstack_id_.erase(
       thread_state_slice_callstack_it);
 
+  if (off_cpu_time_aggregator_.has_value() &&
+      OffCpuTimeAggregator::IsAggregatable(*thread_state_slice)) {
+    // The slice is only sent as part of an OffCpuTimeSummary.
+    std::unique_ptr<ThreadStateSlice> aggregated_slice{thread_state_slice};
+    SendOffCpuTimeSummaries(off_cpu_time_aggregator_->AddThreadStateSlice(*aggregated_slice));
+    return;
+  }
+
   ClientCaptureEvent event;
   event.set_allocated_thread_state_slice(thread_state_slice);
   client_capture_event_collector_->AddEvent(std::move(event));
 }
 
+void ProducerEventProcessorImpl::SendOffCpuTimeSummaries(
+    std::vector<OffCpuTimeSummary> off_cpu_time_summaries) {
+  for (OffCpuTimeSummary& off_cpu_time_summary : off_cpu_time_summaries) {
+    ClientCaptureEvent event;
+    *event.mutable_off_cpu_time_summary() = std::move(off_cpu_time_summary);
+    client_capture_event_collector_->AddEvent(std::move(event));
+  }
+}
+
+template <typename NamedApiEvent>
+void ProducerEventProcessorImpl::TranslateApiEventNameKey(ProducerState* producer_state,
+                                                          NamedApiEvent* api_event) {
+  if (api_event->name_key() == 0) return;
+  auto it = producer_state->producer_string_id_to_client_string_id.find(api_event->name_key());
+  if (it == producer_state->producer_string_id_to_client_string_id.end()) {
+    ORBIT_ERROR("Unknown name key %u of Api event from producer %u", api_event->name_key(),
+                producer_state->producer_id);
+    api_event->set_name_key(0);
+    return;
+  }
+  api_event->set_name_key(it->second);
+}
+
+template <typename FullSampleEvent>
+uint64_t ProducerEventProcessorImpl::InternCallstack(FullSampleEvent* full_sample_event) {
+  const Callstack& callstack = full_sample_event->callstack();
+  return callstack_pool_.GetOrAssignId(
+      ComputeCallstackHash(callstack), [this, full_sample_event](uint64_t id) {
+        ClientCaptureEvent interned_callstack_event;
+        interned_callstack_event.mutable_interned_callstack()->set_key(id);
+        interned_callstack_event.mutable_interned_callstack()->set_allocated_intern(
+            full_sample_event->release_callstack());
+        client_capture_event_collector_->AddEvent(std::move(interned_callstack_event));
+      });
+}
+
 void ProducerEventProcessorImpl::ProcessApiScopeStartAndTransferOwnership(
-    ApiScopeStart* api_scope_start) {
+    ProducerState* producer_state, ApiScopeStart* api_scope_start) {
+  TranslateApiEventNameKey(producer_state, api_scope_start);
   ClientCaptureEvent event;
   event.set_allocated_api_scope_start(api_scope_start);
   client_capture_event_collector_->AddEvent(std::move(event));
 }
 
 void ProducerEventProcessorImpl::ProcessApiScopeStartAsyncAndTransferOwnership(
-    ApiScopeStartAsync* api_scope_start_async) {
+    ProducerState* producer_state, ApiScopeStartAsync* api_scope_start_async) {
+  TranslateApiEventNameKey(producer_state, api_scope_start_async);
   ClientCaptureEvent event;
   event.set_allocated_api_scope_start_async(api_scope_start_async);
   client_capture_event_collector_->AddEvent(std::move(event));
@@ -260,7 +499,8 @@ void ProducerEventProcessorImpl::ProcessApiScopeStopAsyncAndTransferOwnership(
 }
 
 void ProducerEventProcessorImpl::ProcessApiStringEventAndTransferOwnership(
-    ApiStringEvent* api_string_event) {
+    ProducerState* producer_state, ApiStringEvent* api_string_event) {
+  TranslateApiEventNameKey(producer_state, api_string_event);
   ClientCaptureEvent event;
   event.set_allocated_api_string_event(api_string_event);
   client_capture_event_collector_->AddEvent(std::move(event));
@@ -308,13 +548,21 @@ void ProducerEventProcessorImpl::ProcessApiTrackUint64AndTransferOwnership(
   client_capture_event_collector_->AddEvent(std::move(event));
 }
 
+void ProducerEventProcessorImpl::ProcessApiTrackValueSummaryAndTransferOwnership(
+    ProducerState* producer_state, ApiTrackValueSummary* api_track_value_summary) {
+  TranslateApiEventNameKey(producer_state, api_track_value_summary);
+  ClientCaptureEvent event;
+  event.set_allocated_api_track_value_summary(api_track_value_summary);
+  client_capture_event_collector_->AddEvent(std::move(event));
+}
+
 void ProducerEventProcessorImpl::ProcessCallstackSampleAndTransferOwnership(
-    uint64_t producer_id, CallstackSample* callstack_sample) {
+    ProducerState* producer_state, CallstackSample* callstack_sample) {
   // translate producer id to client id
-  auto it = producer_interned_callstack_id_to_client_callstack_id_.find(
-      {producer_id, callstack_sample->callstack_id()});
+  auto it = producer_state->producer_callstack_id_to_client_callstack_id.find(
+      callstack_sample->callstack_id());
   // TODO(b/180235290): replace with error message
-  ORBIT_CHECK(it != producer_interned_callstack_id_to_client_callstack_id_.end());
+  ORBIT_CHECK(it != producer_state->producer_callstack_id_to_client_callstack_id.end());
   callstack_sample->set_callstack_id(it->second);
 
   ClientCaptureEvent event;
@@ -324,12 +572,19 @@ void ProducerEventProcessorImpl::ProcessCallstackSampleAndTransferOwnership(
 
 void ProducerEventProcessorImpl::ProcessCaptureFinishedAndTransferOwnership(
     CaptureFinished* capture_finished) {
-  if (!thread_state_slice_tid_and_begin_timestamp_to_callstack_id_.empty()) {
-    // We don't expect this to happen because SwitchesNamesStateVisitor always produces a slice from
-    // the remaining begin tracepoints at the end of the capture.
-    ORBIT_ERROR(
-        "Some saved callstacks for thread state slices are left not merged to any slice after the "
-        "capture finished.");
+  {
+    absl::MutexLock lock{&thread_state_slice_mutex_};
+    if (!thread_state_slice_tid_and_begin_timestamp_to_callstack_id_.empty()) {
+      // We don't expect this to happen because SwitchesNamesStateVisitor always produces a slice
+      // from the remaining begin tracepoints at the end of the capture.
+      ORBIT_ERROR(
+          "Some saved callstacks for thread state slices are left not merged to any slice after "
+          "the capture finished.");
+    }
+    // The summaries of the last interval need to reach the client before CaptureFinished.
+    if (off_cpu_time_aggregator_.has_value()) {
+      SendOffCpuTimeSummaries(off_cpu_time_aggregator_->Flush());
+    }
   }
   ClientCaptureEvent event;
   event.set_allocated_capture_finished(capture_finished);
@@ -338,6 +593,12 @@ void ProducerEventProcessorImpl::ProcessCaptureFinishedAndTransferOwnership(
 
 void ProducerEventProcessorImpl::ProcessCaptureStartedAndTransferOwnership(
     CaptureStarted* capture_started) {
+  if (const uint64_t off_cpu_time_aggregation_interval_ns =
+          capture_started->capture_options().off_cpu_time_aggregation_interval_ns();
+      off_cpu_time_aggregation_interval_ns != 0) {
+    absl::MutexLock lock{&thread_state_slice_mutex_};
+    off_cpu_time_aggregator_.emplace(off_cpu_time_aggregation_interval_ns);
+  }
   ClientCaptureEvent event;
   event.set_allocated_capture_started(capture_started);
   client_capture_event_collector_->AddEvent(std::move(event));
@@ -373,41 +634,28 @@ void ProducerEventProcessorImpl::ProcessErrorsWithPerfEventOpenEventAndTransferO
 }
 
 void ProducerEventProcessorImpl::ProcessFullCallstackSample(
-    FullCallstackSample* full_callstack_sample) {
-  const Callstack& callstack = full_callstack_sample->callstack();
-  std::pair<std::vector<uint64_t>, Callstack::CallstackType> callstack_data{
-      {callstack.pcs().begin(), callstack.pcs().end()}, callstack.type()};
-  auto [callstack_id, assigned] = callstack_pool_.GetOrAssignId(callstack_data);
-
-  if (assigned) {
-    ClientCaptureEvent interned_callstack_event;
-    interned_callstack_event.mutable_interned_callstack()->set_key(callstack_id);
-    interned_callstack_event.mutable_interned_callstack()->set_allocated_intern(
-        full_callstack_sample->release_callstack());
-    client_capture_event_collector_->AddEvent(std::move(interned_callstack_event));
-  }
+    ProducerState* producer_state, FullCallstackSample* full_callstack_sample) {
+  const uint64_t callstack_id = InternCallstack(full_callstack_sample);
 
-  ClientCaptureEvent callstack_sample_event;
-  CallstackSample* callstack_sample = callstack_sample_event.mutable_callstack_sample();
+  ClientCaptureEvent* callstack_sample_event = producer_state->event_arena.CreateEvent();
+  CallstackSample* callstack_sample = callstack_sample_event->mutable_callstack_sample();
   callstack_sample->set_pid(full_callstack_sample->pid());
   callstack_sample->set_tid(full_callstack_sample->tid());
   callstack_sample->set_timestamp_ns(full_callstack_sample->timestamp_ns());
   callstack_sample->set_callstack_id(callstack_id);
-  client_capture_event_collector_->AddEvent(std::move(callstack_sample_event));
+  client_capture_event_collector_->AddEvent(std::move(*callstack_sample_event));
 }
 
 void ProducerEventProcessorImpl::ProcessFullAddressInfo(FullAddressInfo* full_address_info) {
-  auto [function_name_key, function_key_assigned] =
-      string_pool_.GetOrAssignId(full_address_info->function_name());
-  if (function_key_assigned) {
-    SendInternedStringEvent(function_name_key, full_address_info->function_name());
-  }
+  const uint64_t function_name_key = string_pool_.GetOrAssignId(
+      full_address_info->function_name(), [this, full_address_info](uint64_t key) {
+        SendInternedStringEvent(key, full_address_info->function_name());
+      });
 
-  auto [module_name_key, module_key_assigned] =
-      string_pool_.GetOrAssignId(full_address_info->module_name());
-  if (module_key_assigned) {
-    SendInternedStringEvent(module_name_key, full_address_info->module_name());
-  }
+  const uint64_t module_name_key = string_pool_.GetOrAssignId(
+      full_address_info->module_name(), [this, full_address_info](uint64_t key) {
+        SendInternedStringEvent(key, full_address_info->module_name());
+      });
 
   ClientCaptureEvent event;
   AddressInfo* interned_address_info = event.mutable_address_info();
@@ -420,10 +668,10 @@ void ProducerEventProcessorImpl::ProcessFullAddressInfo(FullAddressInfo* full_ad
 }
 
 void ProducerEventProcessorImpl::ProcessFullGpuJob(FullGpuJob* full_gpu_job_event) {
-  auto [timeline_key, assigned] = string_pool_.GetOrAssignId(full_gpu_job_event->timeline());
-  if (assigned) {
-    SendInternedStringEvent(timeline_key, full_gpu_job_event->timeline());
-  }
+  const uint64_t timeline_key = string_pool_.GetOrAssignId(
+      full_gpu_job_event->timeline(), [this, full_gpu_job_event](uint64_t key) {
+        SendInternedStringEvent(key, full_gpu_job_event->timeline());
+      });
 
   ClientCaptureEvent event;
   GpuJob* gpu_job_event = event.mutable_gpu_job();
@@ -441,28 +689,42 @@ void ProducerEventProcessorImpl::ProcessFullGpuJob(FullGpuJob* full_gpu_job_even
   client_capture_event_collector_->AddEvent(std::move(event));
 }
 
-void ProducerEventProcessorImpl::ProcessFullTracepointEvent(
-    FullTracepointEvent* full_tracepoint_event) {
-  auto [tracepoint_key, assigned] =
-      tracepoint_pool_.GetOrAssignId({full_tracepoint_event->tracepoint_info().category(),
-                                      full_tracepoint_event->tracepoint_info().name()});
-  if (assigned) {
-    ClientCaptureEvent event;
-    InternedTracepointInfo* interned_tracepoint_info = event.mutable_interned_tracepoint_info();
-    interned_tracepoint_info->set_key(tracepoint_key);
-    interned_tracepoint_info->set_allocated_intern(
-        full_tracepoint_event->release_tracepoint_info());
-    client_capture_event_collector_->AddEvent(std::move(event));
-  }
+void ProducerEventProcessorImpl::ProcessFullPageFaultSample(
+    ProducerState* producer_state, FullPageFaultSample* full_page_fault_sample) {
+  const uint64_t callstack_id = InternCallstack(full_page_fault_sample);
+
+  ClientCaptureEvent* page_fault_sample_event = producer_state->event_arena.CreateEvent();
+  PageFaultSample* page_fault_sample = page_fault_sample_event->mutable_page_fault_sample();
+  page_fault_sample->set_pid(full_page_fault_sample->pid());
+  page_fault_sample->set_tid(full_page_fault_sample->tid());
+  page_fault_sample->set_timestamp_ns(full_page_fault_sample->timestamp_ns());
+  page_fault_sample->set_callstack_id(callstack_id);
+  client_capture_event_collector_->AddEvent(std::move(*page_fault_sample_event));
+}
 
-  ClientCaptureEvent event;
-  TracepointEvent* tracepoint_event = event.mutable_tracepoint_event();
+void ProducerEventProcessorImpl::ProcessFullTracepointEvent(
+    ProducerState* producer_state, FullTracepointEvent* full_tracepoint_event) {
+  const uint64_t tracepoint_key = tracepoint_pool_.GetOrAssignId(
+      {full_tracepoint_event->tracepoint_info().category(),
+       full_tracepoint_event->tracepoint_info().name()},
+      [this, full_tracepoint_event](uint64_t key) {
+        ClientCaptureEvent event;
+        InternedTracepointInfo* interned_tracepoint_info =
+            event.mutable_interned_tracepoint_info();
+        interned_tracepoint_info->set_key(key);
+        interned_tracepoint_info->set_allocated_intern(
+            full_tracepoint_event->release_tracepoint_info());
+        client_capture_event_collector_->AddEvent(std::move(event));
+      });
+
+  ClientCaptureEvent* event = producer_state->event_arena.CreateEvent();
+  TracepointEvent* tracepoint_event = event->mutable_tracepoint_event();
   tracepoint_event->set_pid(full_tracepoint_event->pid());
   tracepoint_event->set_tid(full_tracepoint_event->tid());
   tracepoint_event->set_timestamp_ns(full_tracepoint_event->timestamp_ns());
   tracepoint_event->set_cpu(full_tracepoint_event->cpu());
   tracepoint_event->set_tracepoint_info_key(tracepoint_key);
-  client_capture_event_collector_->AddEvent(std::move(event));
+  client_capture_event_collector_->AddEvent(std::move(*event));
 }
 
 void ProducerEventProcessorImpl::ProcessFunctionCallAndTransferOwnership(
@@ -473,12 +735,12 @@ void ProducerEventProcessorImpl::ProcessFunctionCallAndTransferOwnership(
 }
 
 void ProducerEventProcessorImpl::ProcessGpuQueueSubmissionAndTransferOwnership(
-    uint64_t producer_id, GpuQueueSubmission* gpu_queue_submission) {
+    ProducerState* producer_state, GpuQueueSubmission* gpu_queue_submission) {
   // Translate debug marker keys
   for (GpuDebugMarker& mutable_marker : *gpu_queue_submission->mutable_completed_markers()) {
-    auto it = producer_interned_string_id_to_client_string_id_.find(
-        {producer_id, mutable_marker.text_key()});
-    ORBIT_CHECK(it != producer_interned_string_id_to_client_string_id_.end());
+    auto it = producer_state->producer_string_id_to_client_string_id.find(
+        mutable_marker.text_key());
+    ORBIT_CHECK(it != producer_state->producer_string_id_to_client_string_id.end());
     mutable_marker.set_text_key(it->second);
   }
 
@@ -487,50 +749,42 @@ void ProducerEventProcessorImpl::ProcessGpuQueueSubmissionAndTransferOwnership(
   client_capture_event_collector_->AddEvent(std::move(event));
 }
 
-void ProducerEventProcessorImpl::ProcessInternedCallstack(uint64_t producer_id,
+void ProducerEventProcessorImpl::ProcessInternedCallstack(ProducerState* producer_state,
                                                           InternedCallstack* interned_callstack) {
   // TODO(b/180235290): replace with error message
-  ORBIT_CHECK(!producer_interned_callstack_id_to_client_callstack_id_.contains(
-      {producer_id, interned_callstack->key()}));
-
-  std::pair<std::vector<uint64_t>, Callstack::CallstackType> callstack_data{
-      {interned_callstack->intern().pcs().begin(), interned_callstack->intern().pcs().end()},
-      interned_callstack->intern().type()};
-  auto [interned_callstack_id, assigned] = callstack_pool_.GetOrAssignId(callstack_data);
-
-  producer_interned_callstack_id_to_client_callstack_id_.insert_or_assign(
-      {producer_id, interned_callstack->key()}, interned_callstack_id);
-
-  if (!assigned) {
-    return;
-  }
-
-  // If this is first time we see it -> send it over with client_id
-  interned_callstack->set_key(interned_callstack_id);
-  ClientCaptureEvent event;
-  *event.mutable_interned_callstack() = std::move(*interned_callstack);
-  client_capture_event_collector_->AddEvent(std::move(event));
+  ORBIT_CHECK(!producer_state->producer_callstack_id_to_client_callstack_id.contains(
+      interned_callstack->key()));
+
+  const uint64_t producer_callstack_id = interned_callstack->key();
+  const uint64_t interned_callstack_id = callstack_pool_.GetOrAssignId(
+      ComputeCallstackHash(interned_callstack->intern()), [this, interned_callstack](uint64_t id) {
+        // If this is first time we see it -> send it over with client_id
+        interned_callstack->set_key(id);
+        ClientCaptureEvent event;
+        *event.mutable_interned_callstack() = std::move(*interned_callstack);
+        client_capture_event_collector_->AddEvent(std::move(event));
+      });
+
+  producer_state->producer_callstack_id_to_client_callstack_id.insert_or_assign(
+      producer_callstack_id, interned_callstack_id);
 }
 
-void ProducerEventProcessorImpl::ProcessInternedString(uint64_t producer_id,
+void ProducerEventProcessorImpl::ProcessInternedString(ProducerState* producer_state,
                                                        InternedString* interned_string) {
   // TODO(b/180235290): replace with error message
-  ORBIT_CHECK(!producer_interned_string_id_to_client_string_id_.contains(
-      {producer_id, interned_string->key()}));
-
-  auto [client_string_id, assigned] = string_pool_.GetOrAssignId(interned_string->intern());
-  producer_interned_string_id_to_client_string_id_.insert_or_assign(
-      {producer_id, interned_string->key()}, client_string_id);
-
-  if (!assigned) {
-    return;
-  }
-
-  interned_string->set_key(client_string_id);
-
-  ClientCaptureEvent event;
-  *event.mutable_interned_string() = std::move(*interned_string);
-  client_capture_event_collector_->AddEvent(std::move(event));
+  ORBIT_CHECK(!producer_state->producer_string_id_to_client_string_id.contains(
+      interned_string->key()));
+
+  const uint64_t producer_string_id = interned_string->key();
+  const uint64_t client_string_id =
+      string_pool_.GetOrAssignId(interned_string->intern(), [this, interned_string](uint64_t id) {
+        interned_string->set_key(id);
+        ClientCaptureEvent event;
+        *event.mutable_interned_string() = std::move(*interned_string);
+        client_capture_event_collector_->AddEvent(std::move(event));
+      });
+  producer_state->producer_string_id_to_client_string_id.insert_or_assign(producer_string_id,
+                                                                          client_string_id);
 }
 
 void ProducerEventProcessorImpl::ProcessLostPerfRecordsEventAndTransferOwnership(
@@ -568,6 +822,86 @@ void ProducerEventProcessorImpl::ProcessOutOfOrderEventsDiscardedEventAndTransfe
   client_capture_event_collector_->AddEvent(std::move(event));
 }
 
+void ProducerEventProcessorImpl::ProcessPerfEventProcessingStatsEventAndTransferOwnership(
+    PerfEventProcessingStatsEvent* perf_event_processing_stats_event) {
+  ClientCaptureEvent event;
+  event.set_allocated_perf_event_processing_stats_event(perf_event_processing_stats_event);
+  client_capture_event_collector_->AddEvent(std::move(event));
+}
+
+void ProducerEventProcessorImpl::ProcessPackedApiEvents(ProducerState* producer_state,
+                                                        const PackedApiEvents& packed_api_events) {
+  if (packed_api_events.version() != orbit_api::kPackedApiEventsVersion) {
+    ORBIT_ERROR("Unsupported version %u of PackedApiEvents from producer %u",
+                packed_api_events.version(), producer_state->producer_id);
+    return;
+  }
+
+  const uint32_t pid = packed_api_events.pid();
+  const std::string_view records = packed_api_events.records();
+  size_t offset = 0;
+  orbit_api::PackedApiEventType type;
+  while (orbit_api::ReadPackedApiEventType(records, offset, &type)) {
+    ClientCaptureEvent& event = *producer_state->event_arena.CreateEvent();
+    bool record_is_complete = false;
+    switch (type) {
+      case orbit_api::PackedApiEventType::kScopeStart: {
+        orbit_api::PackedApiScopeStart packed_event;
+        record_is_complete = orbit_api::ReadPackedApiEvent(records, offset, &packed_event);
+        offset += sizeof(packed_event);
+        ApiScopeStart* api_scope_start = event.mutable_api_scope_start();
+        api_scope_start->set_pid(pid);
+        api_scope_start->set_tid(packed_event.tid);
+        api_scope_start->set_timestamp_ns(packed_event.timestamp_ns);
+        api_scope_start->set_name_key(packed_event.name_key);
+        api_scope_start->set_group_id(packed_event.group_id);
+        api_scope_start->set_address_in_function(packed_event.address_in_function);
+        api_scope_start->set_color_rgba(packed_event.color_rgba);
+        TranslateApiEventNameKey(producer_state, api_scope_start);
+      } break;
+      case orbit_api::PackedApiEventType::kScopeStop: {
+        orbit_api::PackedApiScopeStop packed_event;
+        record_is_complete = orbit_api::ReadPackedApiEvent(records, offset, &packed_event);
+        offset += sizeof(packed_event);
+        ApiScopeStop* api_scope_stop = event.mutable_api_scope_stop();
+        api_scope_stop->set_pid(pid);
+        api_scope_stop->set_tid(packed_event.tid);
+        api_scope_stop->set_timestamp_ns(packed_event.timestamp_ns);
+      } break;
+      case orbit_api::PackedApiEventType::kScopeStartAsync: {
+        orbit_api::PackedApiScopeStartAsync packed_event;
+        record_is_complete = orbit_api::ReadPackedApiEvent(records, offset, &packed_event);
+        offset += sizeof(packed_event);
+        ApiScopeStartAsync* api_scope_start_async = event.mutable_api_scope_start_async();
+        api_scope_start_async->set_pid(pid);
+        api_scope_start_async->set_tid(packed_event.tid);
+        api_scope_start_async->set_timestamp_ns(packed_event.timestamp_ns);
+        api_scope_start_async->set_name_key(packed_event.name_key);
+        api_scope_start_async->set_id(packed_event.id);
+        api_scope_start_async->set_address_in_function(packed_event.address_in_function);
+        api_scope_start_async->set_color_rgba(packed_event.color_rgba);
+        TranslateApiEventNameKey(producer_state, api_scope_start_async);
+      } break;
+      case orbit_api::PackedApiEventType::kScopeStopAsync: {
+        orbit_api::PackedApiScopeStopAsync packed_event;
+        record_is_complete = orbit_api::ReadPackedApiEvent(records, offset, &packed_event);
+        offset += sizeof(packed_event);
+        ApiScopeStopAsync* api_scope_stop_async = event.mutable_api_scope_stop_async();
+        api_scope_stop_async->set_pid(pid);
+        api_scope_stop_async->set_tid(packed_event.tid);
+        api_scope_stop_async->set_timestamp_ns(packed_event.timestamp_ns);
+        api_scope_stop_async->set_id(packed_event.id);
+      } break;
+    }
+    // An unknown type or a truncated record means that the rest of the records can't be parsed.
+    if (!record_is_complete) {
+      ORBIT_ERROR("Malformed PackedApiEvents from producer %u", producer_state->producer_id);
+      return;
+    }
+    client_capture_event_collector_->AddEvent(std::move(event));
+  }
+}
+
 void ProducerEventProcessorImpl::ProcessPresentEventAndTransferOwnership(
     PresentEvent* present_event) {
   ClientCaptureEvent event;
@@ -575,6 +909,20 @@ void ProducerEventProcessorImpl::ProcessPresentEventAndTransferOwnership(
   client_capture_event_collector_->AddEvent(std::move(event));
 }
 
+void ProducerEventProcessorImpl::ProcessPerformanceCounterSampleAndTransferOwnership(
+    PerformanceCounterSample* performance_counter_sample) {
+  ClientCaptureEvent event;
+  event.set_allocated_performance_counter_sample(performance_counter_sample);
+  client_capture_event_collector_->AddEvent(std::move(event));
+}
+
+void ProducerEventProcessorImpl::ProcessPressureStallEventAndTransferOwnership(
+    PressureStallEvent* pressure_stall_event) {
+  ClientCaptureEvent event;
+  event.set_allocated_pressure_stall_event(pressure_stall_event);
+  client_capture_event_collector_->AddEvent(std::move(event));
+}
+
 void ProducerEventProcessorImpl::ProcessSchedulingSliceAndTransferOwnership(
     SchedulingSlice* scheduling_slice) {
   ClientCaptureEvent event;
@@ -606,6 +954,7 @@ void ProducerEventProcessorImpl::ProcessThreadStateSliceAndTransferOwnership(
     client_capture_event_collector_->AddEvent(std::move(event));
     return;
   }
+  absl::MutexLock lock{&thread_state_slice_mutex_};
   MergeThreadStateSliceWithCallstackAndTransferOwnership(thread_state_slice);
 }
 
@@ -627,20 +976,18 @@ void ProducerEventProcessorImpl::ProcessThreadStateSliceCallstack(
     ThreadStateSliceCallstack* thread_state_slice_callstack) {
   const Callstack& callstack = thread_state_slice_callstack->callstack();
 
-  std::pair<std::vector<uint64_t>, Callstack::CallstackType> callstack_data{
-      {callstack.pcs().begin(), callstack.pcs().end()}, callstack.type()};
-  auto [callstack_id, assigned] = callstack_pool_.GetOrAssignId(callstack_data);
-
-  if (assigned) {
-    ClientCaptureEvent interned_callstack_event;
-    interned_callstack_event.mutable_interned_callstack()->set_key(callstack_id);
-    interned_callstack_event.mutable_interned_callstack()->set_allocated_intern(
-        thread_state_slice_callstack->release_callstack());
-    client_capture_event_collector_->AddEvent(std::move(interned_callstack_event));
-  }
+  const uint64_t callstack_id = callstack_pool_.GetOrAssignId(
+      ComputeCallstackHash(callstack), [this, thread_state_slice_callstack](uint64_t id) {
+        ClientCaptureEvent interned_callstack_event;
+        interned_callstack_event.mutable_interned_callstack()->set_key(id);
+        interned_callstack_event.mutable_interned_callstack()->set_allocated_intern(
+            thread_state_slice_callstack->release_callstack());
+        client_capture_event_collector_->AddEvent(std::move(interned_callstack_event));
+      });
 
   // We are sending the callstack right away (if necessary) and only keep the callstack id to attach
   // it to the matching thread state slice.
+  absl::MutexLock lock{&thread_state_slice_mutex_};
   thread_state_slice_tid_and_begin_timestamp_to_callstack_id_[{
       thread_state_slice_callstack->thread_state_slice_tid(),
       thread_state_slice_callstack->timestamp_ns()}] = callstack_id;
@@ -654,15 +1001,55 @@ void ProducerEventProcessorImpl::
   client_capture_event_collector_->AddEvent(std::move(event));
 }
 
+ProducerEventProcessorImpl::ProducerState* ProducerEventProcessorImpl::GetOrCreateProducerState(
+    uint64_t producer_id) {
+  {
+    absl::ReaderMutexLock lock{&producer_states_mutex_};
+    auto it = std::as_const(producer_states_).find(producer_id);
+    if (it != producer_states_.cend()) return it->second.get();
+  }
+  absl::MutexLock lock{&producer_states_mutex_};
+  auto [it, inserted] = producer_states_.try_emplace(producer_id);
+  if (inserted) {
+    it->second = std::make_unique<ProducerState>(producer_id);
+    if (producer_ids_to_keep_.has_value() && !producer_ids_to_keep_->contains(producer_id)) {
+      it->second->drop_events = true;
+    }
+  }
+  return it->second.get();
+}
+
+void ProducerEventProcessorImpl::DropEventsOfProducersExcept(
+    absl::flat_hash_set<uint64_t> producer_ids_to_keep) {
+  absl::MutexLock lock{&producer_states_mutex_};
+  for (const auto& [producer_id, producer_state] : producer_states_) {
+    if (!producer_ids_to_keep.contains(producer_id)) {
+      producer_state->drop_events.store(true, std::memory_order_relaxed);
+    }
+  }
+  producer_ids_to_keep_ = std::move(producer_ids_to_keep);
+}
+
 void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCaptureEvent&& event) {
+  ProducerState* producer_state = GetOrCreateProducerState(producer_id);
+  producer_state->event_count.fetch_add(1, std::memory_order_relaxed);
+  if (producer_state->drop_events.load(std::memory_order_relaxed)) return;
+  absl::MutexLock lock{&producer_state->mutex};
+  ProcessEventWithProducerState(producer_state, std::move(event));
+  producer_state->event_arena.Clear();
+}
+
+void ProducerEventProcessorImpl::ProcessEventWithProducerState(ProducerState* producer_state,
+                                                               ProducerCaptureEvent&& event) {
   // Please keep the cases alphabetically ordered, as in the definition of the ProducerCaptureEvent
   // message.
   switch (event.event_case()) {
     case ProducerCaptureEvent::kApiScopeStart:
-      ProcessApiScopeStartAndTransferOwnership(event.release_api_scope_start());
+      ProcessApiScopeStartAndTransferOwnership(producer_state, event.release_api_scope_start());
       break;
     case ProducerCaptureEvent::kApiScopeStartAsync:
-      ProcessApiScopeStartAsyncAndTransferOwnership(event.release_api_scope_start_async());
+      ProcessApiScopeStartAsyncAndTransferOwnership(producer_state,
+                                                    event.release_api_scope_start_async());
       break;
     case ProducerCaptureEvent::kApiScopeStop:
       ProcessApiScopeStopAndTransferOwnership(event.release_api_scope_stop());
@@ -671,7 +1058,7 @@ void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCapt
       ProcessApiScopeStopAsyncAndTransferOwnership(event.release_api_scope_stop_async());
       break;
     case ProducerCaptureEvent::kApiStringEvent:
-      ProcessApiStringEventAndTransferOwnership(event.release_api_string_event());
+      ProcessApiStringEventAndTransferOwnership(producer_state, event.release_api_string_event());
       break;
     case ProducerCaptureEvent::kApiTrackDouble:
       ProcessApiTrackDoubleAndTransferOwnership(event.release_api_track_double());
@@ -691,8 +1078,12 @@ void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCapt
     case ProducerCaptureEvent::kApiTrackUint64:
       ProcessApiTrackUint64AndTransferOwnership(event.release_api_track_uint64());
       break;
+    case ProducerCaptureEvent::kApiTrackValueSummary:
+      ProcessApiTrackValueSummaryAndTransferOwnership(producer_state,
+                                                      event.release_api_track_value_summary());
+      break;
     case ProducerCaptureEvent::kCallstackSample:
-      ProcessCallstackSampleAndTransferOwnership(producer_id, event.release_callstack_sample());
+      ProcessCallstackSampleAndTransferOwnership(producer_state, event.release_callstack_sample());
       break;
     case ProducerCaptureEvent::kCaptureFinished:
       ProcessCaptureFinishedAndTransferOwnership(event.release_capture_finished());
@@ -716,7 +1107,7 @@ void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCapt
           event.release_errors_with_perf_event_open_event());
       break;
     case ProducerCaptureEvent::kFullCallstackSample:
-      ProcessFullCallstackSample(event.mutable_full_callstack_sample());
+      ProcessFullCallstackSample(producer_state, event.mutable_full_callstack_sample());
       break;
     case ProducerCaptureEvent::kFullAddressInfo:
       ProcessFullAddressInfo(event.mutable_full_address_info());
@@ -724,8 +1115,11 @@ void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCapt
     case ProducerCaptureEvent::kFullGpuJob:
       ProcessFullGpuJob(event.mutable_full_gpu_job());
       break;
+    case ProducerCaptureEvent::kFullPageFaultSample:
+      ProcessFullPageFaultSample(producer_state, event.mutable_full_page_fault_sample());
+      break;
     case ProducerCaptureEvent::kFullTracepointEvent:
-      ProcessFullTracepointEvent(event.mutable_full_tracepoint_event());
+      ProcessFullTracepointEvent(producer_state, event.mutable_full_tracepoint_event());
       break;
     case ProducerCaptureEvent::kFunctionCall:
       ProcessFunctionCallAndTransferOwnership(event.release_function_call());
@@ -735,14 +1129,14 @@ void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCapt
     case ProducerCaptureEvent::kFunctionExit:
       ORBIT_UNREACHABLE();
     case ProducerCaptureEvent::kGpuQueueSubmission:
-      ProcessGpuQueueSubmissionAndTransferOwnership(producer_id,
+      ProcessGpuQueueSubmissionAndTransferOwnership(producer_state,
                                                     event.release_gpu_queue_submission());
       break;
     case ProducerCaptureEvent::kInternedCallstack:
-      ProcessInternedCallstack(producer_id, event.mutable_interned_callstack());
+      ProcessInternedCallstack(producer_state, event.mutable_interned_callstack());
       break;
     case ProducerCaptureEvent::kInternedString:
-      ProcessInternedString(producer_id, event.mutable_interned_string());
+      ProcessInternedString(producer_state, event.mutable_interned_string());
       break;
     case ProducerCaptureEvent::kLostPerfRecordsEvent:
       ProcessLostPerfRecordsEventAndTransferOwnership(event.release_lost_perf_records_event());
@@ -760,9 +1154,23 @@ void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCapt
       ProcessOutOfOrderEventsDiscardedEventAndTransferOwnership(
           event.release_out_of_order_events_discarded_event());
       break;
+    case ProducerCaptureEvent::kPackedApiEvents:
+      ProcessPackedApiEvents(producer_state, event.packed_api_events());
+      break;
+    case ProducerCaptureEvent::kPerfEventProcessingStatsEvent:
+      ProcessPerfEventProcessingStatsEventAndTransferOwnership(
+          event.release_perf_event_processing_stats_event());
+      break;
     case ProducerCaptureEvent::kPresentEvent:
       ProcessPresentEventAndTransferOwnership(event.release_present_event());
       break;
+    case ProducerCaptureEvent::kPerformanceCounterSample:
+      ProcessPerformanceCounterSampleAndTransferOwnership(
+          event.release_performance_counter_sample());
+      break;
+    case ProducerCaptureEvent::kPressureStallEvent:
+      ProcessPressureStallEventAndTransferOwnership(event.release_pressure_stall_event());
+      break;
     case ProducerCaptureEvent::kSchedulingSlice:
       ProcessSchedulingSliceAndTransferOwnership(event.release_scheduling_slice());
       break;
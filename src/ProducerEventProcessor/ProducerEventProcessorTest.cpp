@@ -2,6 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include <gmock/gmock.h>
 #include <google/protobuf/stubs/port.h>
 #include <google/protobuf/util/message_differencer.h>
@@ -12,9 +15,11 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "ApiUtils/PackedApiEvents.h"
 #include "GrpcProtos/Constants.h"
 #include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/module.pb.h"
@@ -34,6 +39,7 @@ using orbit_grpc_protos::ApiTrackInt;
 using orbit_grpc_protos::ApiTrackInt64;
 using orbit_grpc_protos::ApiTrackUint;
 using orbit_grpc_protos::ApiTrackUint64;
+using orbit_grpc_protos::ApiTrackValueSummary;
 using orbit_grpc_protos::Callstack;
 using orbit_grpc_protos::CallstackSample;
 using orbit_grpc_protos::CaptureFinished;
@@ -48,6 +54,7 @@ using orbit_grpc_protos::ErrorsWithPerfEventOpenEvent;
 using orbit_grpc_protos::FullAddressInfo;
 using orbit_grpc_protos::FullCallstackSample;
 using orbit_grpc_protos::FullGpuJob;
+using orbit_grpc_protos::FullPageFaultSample;
 using orbit_grpc_protos::FullTracepointEvent;
 using orbit_grpc_protos::FunctionCall;
 using orbit_grpc_protos::GpuCommandBuffer;
@@ -66,6 +73,10 @@ using orbit_grpc_protos::ModuleInfo;
 using orbit_grpc_protos::ModulesSnapshot;
 using orbit_grpc_protos::ModuleUpdateEvent;
 using orbit_grpc_protos::OutOfOrderEventsDiscardedEvent;
+using orbit_grpc_protos::PageFaultSample;
+using orbit_grpc_protos::PerfEventProcessingStatsEvent;
+using orbit_grpc_protos::PerformanceCounterSample;
+using orbit_grpc_protos::PressureStallEvent;
 using orbit_grpc_protos::ProcessMemoryUsage;
 using orbit_grpc_protos::ProducerCaptureEvent;
 using orbit_grpc_protos::SchedulingSlice;
@@ -109,6 +120,7 @@ constexpr uint64_t kDurationNs2 = 977;
 
 constexpr uint64_t kTimestampNs1 = 7723;
 constexpr uint64_t kTimestampNs2 = 7727;
+constexpr uint64_t kTimestampNs3 = 7741;
 
 constexpr int32_t kNumBeginMarkers1 = 19;
 constexpr int32_t kNumBeginMarkers2 = 23;
@@ -138,6 +150,7 @@ constexpr float kBlue2 = 2.4f;
 constexpr uint32_t kColor1 = 0x11223344;
 
 constexpr uint64_t kGroupId1 = 42;
+constexpr uint64_t kGroupId2 = 43;
 
 constexpr uint64_t kEncodedName1 = 11;
 constexpr uint64_t kEncodedName2 = 22;
@@ -188,6 +201,36 @@ TEST(ProducerEventProcessor, OneSchedulingSliceEvent) {
   EXPECT_EQ(actual_scheduling_slice.out_timestamp_ns(), kTimestampNs1);
 }
 
+TEST(ProducerEventProcessor, DropEventsOfProducersExcept) {
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+  constexpr uint64_t kOtherProducerId = kDefaultProducerId + 1;
+  constexpr uint64_t kNewProducerId = kDefaultProducerId + 2;
+
+  auto create_scheduling_slice_event = [] {
+    ProducerCaptureEvent event;
+    SchedulingSlice* scheduling_slice = event.mutable_scheduling_slice();
+    scheduling_slice->set_pid(kPid1);
+    scheduling_slice->set_tid(kTid1);
+    scheduling_slice->set_out_timestamp_ns(kTimestampNs1);
+    return event;
+  };
+
+  EXPECT_CALL(collector, AddEvent).Times(2);
+  producer_event_processor->ProcessEvent(kDefaultProducerId, create_scheduling_slice_event());
+  producer_event_processor->ProcessEvent(kOtherProducerId, create_scheduling_slice_event());
+  ::testing::Mock::VerifyAndClearExpectations(&collector);
+
+  producer_event_processor->DropEventsOfProducersExcept({kDefaultProducerId});
+
+  // Only the events of the kept producer still reach the collector, including for producers that
+  // send their first event after the call.
+  EXPECT_CALL(collector, AddEvent).Times(1);
+  producer_event_processor->ProcessEvent(kDefaultProducerId, create_scheduling_slice_event());
+  producer_event_processor->ProcessEvent(kOtherProducerId, create_scheduling_slice_event());
+  producer_event_processor->ProcessEvent(kNewProducerId, create_scheduling_slice_event());
+}
+
 TEST(ProducerEventProcessor, OneInternedCallstack) {
   MockClientCaptureEventCollector collector;
   auto producer_event_processor = ProducerEventProcessor::Create(&collector);
@@ -771,6 +814,57 @@ TEST(ProducerEventProcessor, FullCallstackSamplesSameCallstack) {
   EXPECT_EQ(callstack_sample2.callstack_id(), interned_callstack1.key());
 }
 
+TEST(ProducerEventProcessor, FullPageFaultSampleSharesCallstacksWithFullCallstackSample) {
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+
+  ProducerCaptureEvent event1;
+  FullCallstackSample* full_callstack_sample = event1.mutable_full_callstack_sample();
+  full_callstack_sample->set_pid(kPid1);
+  full_callstack_sample->set_tid(kTid1);
+  full_callstack_sample->set_timestamp_ns(kTimestampNs1);
+  Callstack* callstack1 = full_callstack_sample->mutable_callstack();
+  callstack1->add_pcs(1);
+  callstack1->add_pcs(2);
+  callstack1->set_type(Callstack::kComplete);
+
+  ProducerCaptureEvent event2;
+  FullPageFaultSample* full_page_fault_sample = event2.mutable_full_page_fault_sample();
+  full_page_fault_sample->set_pid(kPid2);
+  full_page_fault_sample->set_tid(kTid2);
+  full_page_fault_sample->set_timestamp_ns(kTimestampNs2);
+  Callstack* callstack2 = full_page_fault_sample->mutable_callstack();
+  callstack2->add_pcs(1);
+  callstack2->add_pcs(2);
+  callstack2->set_type(Callstack::kComplete);
+
+  ClientCaptureEvent interned_callstack_event;
+  ClientCaptureEvent callstack_sample_event;
+  ClientCaptureEvent page_fault_sample_event;
+  EXPECT_CALL(collector, AddEvent)
+      .Times(3)
+      .WillOnce(SaveArg<0>(&interned_callstack_event))
+      .WillOnce(SaveArg<0>(&callstack_sample_event))
+      .WillOnce(SaveArg<0>(&page_fault_sample_event));
+
+  producer_event_processor->ProcessEvent(1, std::move(event1));
+  producer_event_processor->ProcessEvent(1, std::move(event2));
+
+  ASSERT_EQ(interned_callstack_event.event_case(), ClientCaptureEvent::kInternedCallstack);
+  ASSERT_EQ(callstack_sample_event.event_case(), ClientCaptureEvent::kCallstackSample);
+  ASSERT_EQ(page_fault_sample_event.event_case(), ClientCaptureEvent::kPageFaultSample);
+
+  const InternedCallstack& interned_callstack = interned_callstack_event.interned_callstack();
+  EXPECT_NE(interned_callstack.key(), orbit_grpc_protos::kInvalidInternId);
+  EXPECT_EQ(callstack_sample_event.callstack_sample().callstack_id(), interned_callstack.key());
+
+  const PageFaultSample& page_fault_sample = page_fault_sample_event.page_fault_sample();
+  EXPECT_EQ(page_fault_sample.pid(), kPid2);
+  EXPECT_EQ(page_fault_sample.tid(), kTid2);
+  EXPECT_EQ(page_fault_sample.timestamp_ns(), kTimestampNs2);
+  EXPECT_EQ(page_fault_sample.callstack_id(), interned_callstack.key());
+}
+
 TEST(ProducerEventProcessor, FullTracepointEventsDifferentTracepoints) {
   MockClientCaptureEventCollector collector;
   auto producer_event_processor = ProducerEventProcessor::Create(&collector);
@@ -1539,6 +1633,72 @@ TEST(ProducerEventProcessor,
   EXPECT_THAT(actual_event.thread_state_slice(), ThreadStateSliceEq(expected_thread_state_slice));
 }
 
+TEST(ProducerEventProcessor, ThreadStateSlicesWithCallstackAreSummarizedAsOffCpuTime) {
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+
+  std::vector<ClientCaptureEvent> actual_client_capture_events;
+  EXPECT_CALL(collector, AddEvent)
+      .Times(4)
+      .WillRepeatedly(
+          Invoke([&actual_client_capture_events](ClientCaptureEvent&& client_capture_event) {
+            actual_client_capture_events.push_back(std::move(client_capture_event));
+          }));
+
+  ProducerCaptureEvent capture_started_event;
+  capture_started_event.mutable_capture_started()
+      ->mutable_capture_options()
+      ->set_off_cpu_time_aggregation_interval_ns(1'000'000);
+  producer_event_processor->ProcessEvent(orbit_grpc_protos::kRootProducerId,
+                                         std::move(capture_started_event));
+
+  for (uint64_t end_timestamp_ns : {kTimestampNs1, kTimestampNs2}) {
+    ProducerCaptureEvent thread_state_slice_callstack_event;
+    ThreadStateSliceCallstack* thread_state_slice_callstack =
+        thread_state_slice_callstack_event.mutable_thread_state_slice_callstack();
+    thread_state_slice_callstack->set_thread_state_slice_tid(kTid1);
+    thread_state_slice_callstack->set_timestamp_ns(end_timestamp_ns - kDurationNs1);
+    thread_state_slice_callstack->mutable_callstack()->add_pcs(1);
+    producer_event_processor->ProcessEvent(orbit_grpc_protos::kLinuxTracingProducerId,
+                                           std::move(thread_state_slice_callstack_event));
+
+    ProducerCaptureEvent thread_state_slice_event;
+    ThreadStateSlice* thread_state_slice = thread_state_slice_event.mutable_thread_state_slice();
+    thread_state_slice->set_pid(kPid1);
+    thread_state_slice->set_tid(kTid1);
+    thread_state_slice->set_thread_state(ThreadStateSlice::kInterruptibleSleep);
+    thread_state_slice->set_duration_ns(kDurationNs1);
+    thread_state_slice->set_end_timestamp_ns(end_timestamp_ns);
+    thread_state_slice->set_switch_out_or_wakeup_callstack_status(
+        ThreadStateSlice::kWaitingForCallstack);
+    producer_event_processor->ProcessEvent(orbit_grpc_protos::kLinuxTracingProducerId,
+                                           std::move(thread_state_slice_event));
+  }
+
+  ProducerCaptureEvent capture_finished_event;
+  capture_finished_event.mutable_capture_finished();
+  producer_event_processor->ProcessEvent(orbit_grpc_protos::kRootProducerId,
+                                         std::move(capture_finished_event));
+
+  ASSERT_EQ(actual_client_capture_events.size(), 4);
+  EXPECT_EQ(actual_client_capture_events[0].event_case(), ClientCaptureEvent::kCaptureStarted);
+  ASSERT_EQ(actual_client_capture_events[1].event_case(), ClientCaptureEvent::kInternedCallstack);
+  ASSERT_EQ(actual_client_capture_events[2].event_case(), ClientCaptureEvent::kOffCpuTimeSummary);
+  EXPECT_EQ(actual_client_capture_events[3].event_case(), ClientCaptureEvent::kCaptureFinished);
+
+  const orbit_grpc_protos::OffCpuTimeSummary& off_cpu_time_summary =
+      actual_client_capture_events[2].off_cpu_time_summary();
+  EXPECT_EQ(off_cpu_time_summary.pid(), kPid1);
+  EXPECT_EQ(off_cpu_time_summary.tid(), kTid1);
+  EXPECT_EQ(off_cpu_time_summary.thread_state(), ThreadStateSlice::kInterruptibleSleep);
+  EXPECT_EQ(off_cpu_time_summary.callstack_id(),
+            actual_client_capture_events[1].interned_callstack().key());
+  EXPECT_EQ(off_cpu_time_summary.count(), 2);
+  EXPECT_EQ(off_cpu_time_summary.total_duration_ns(), 2 * kDurationNs1);
+  EXPECT_EQ(off_cpu_time_summary.min_begin_timestamp_ns(), kTimestampNs1 - kDurationNs1);
+  EXPECT_EQ(off_cpu_time_summary.max_end_timestamp_ns(), kTimestampNs2);
+}
+
 TEST(ProducerEventProcessor, ModuleUpdateEventSmoke) {
   MockClientCaptureEventCollector collector;
   auto producer_event_processor = ProducerEventProcessor::Create(&collector);
@@ -1901,6 +2061,56 @@ TEST(ProducerEventProcessor, MemoryUsageEvent) {
             expected_memory_usage_event_serialized_as_string);
 }
 
+TEST(ProducerEventProcessor, PressureStallEvent) {
+  ProducerCaptureEvent producer_capture_event;
+  PressureStallEvent* pressure_stall_event = producer_capture_event.mutable_pressure_stall_event();
+  pressure_stall_event->set_resource(PressureStallEvent::kMemory);
+  pressure_stall_event->set_is_cgroup(true);
+  pressure_stall_event->set_timestamp_ns(kTimestampNs1);
+  pressure_stall_event->set_duration_ns(1'000'000'000);
+  pressure_stall_event->set_some_stall_ns(150'000'000);
+  pressure_stall_event->set_full_stall_ns(50'000'000);
+
+  PressureStallEvent pressure_stall_event_copy = *pressure_stall_event;
+
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+  ClientCaptureEvent client_capture_event;
+  EXPECT_CALL(collector, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_capture_event));
+
+  producer_event_processor->ProcessEvent(kMemoryInfoProducerId, std::move(producer_capture_event));
+  ASSERT_EQ(client_capture_event.event_case(), ClientCaptureEvent::kPressureStallEvent);
+  const PressureStallEvent& actual_event = client_capture_event.pressure_stall_event();
+  EXPECT_TRUE(MessageDifferencer::Equivalent(pressure_stall_event_copy, actual_event));
+}
+
+TEST(ProducerEventProcessor, PerformanceCounterSample) {
+  ProducerCaptureEvent producer_capture_event;
+  PerformanceCounterSample* performance_counter_sample =
+      producer_capture_event.mutable_performance_counter_sample();
+  performance_counter_sample->set_pid(kPid1);
+  performance_counter_sample->set_tid(kTid1);
+  performance_counter_sample->set_cpu(2);
+  performance_counter_sample->set_timestamp_ns(kTimestampNs1);
+  performance_counter_sample->set_cycles(2'000'000);
+  performance_counter_sample->set_instructions(3'000'000);
+  performance_counter_sample->set_cache_misses(4'000);
+  performance_counter_sample->set_branch_misses(500);
+
+  PerformanceCounterSample performance_counter_sample_copy = *performance_counter_sample;
+
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+  ClientCaptureEvent client_capture_event;
+  EXPECT_CALL(collector, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_capture_event));
+
+  producer_event_processor->ProcessEvent(orbit_grpc_protos::kLinuxTracingProducerId,
+                                         std::move(producer_capture_event));
+  ASSERT_EQ(client_capture_event.event_case(), ClientCaptureEvent::kPerformanceCounterSample);
+  const PerformanceCounterSample& actual_event = client_capture_event.performance_counter_sample();
+  EXPECT_TRUE(MessageDifferencer::Equivalent(performance_counter_sample_copy, actual_event));
+}
+
 TEST(ProducerEventProcessor, ApiScopeStart) {
   ProducerCaptureEvent producer_capture_event;
   ApiScopeStart* api_scope_start = producer_capture_event.mutable_api_scope_start();
@@ -1933,6 +2143,110 @@ TEST(ProducerEventProcessor, ApiScopeStart) {
   EXPECT_TRUE(MessageDifferencer::Equivalent(api_scope_start_copy, actual_event));
 }
 
+TEST(ProducerEventProcessor, ApiScopeStartWithInternedName) {
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+
+  ClientCaptureEvent client_interned_string_event;
+  EXPECT_CALL(collector, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_interned_string_event));
+  producer_event_processor->ProcessEvent(kDefaultProducerId,
+                                         CreateInternedStringEvent(kKey1, "scope name"));
+  testing::Mock::VerifyAndClearExpectations(&collector);
+  ASSERT_EQ(client_interned_string_event.event_case(), ClientCaptureEvent::kInternedString);
+  const uint64_t client_key = client_interned_string_event.interned_string().key();
+
+  ProducerCaptureEvent producer_capture_event;
+  ApiScopeStart* api_scope_start = producer_capture_event.mutable_api_scope_start();
+  api_scope_start->set_pid(kPid1);
+  api_scope_start->set_tid(kTid1);
+  api_scope_start->set_timestamp_ns(kTimestampNs1);
+  api_scope_start->set_name_key(kKey1);
+
+  ClientCaptureEvent client_capture_event;
+  EXPECT_CALL(collector, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_capture_event));
+  producer_event_processor->ProcessEvent(kDefaultProducerId, std::move(producer_capture_event));
+  ASSERT_EQ(client_capture_event.event_case(), ClientCaptureEvent::kApiScopeStart);
+  const ApiScopeStart& actual_event = client_capture_event.api_scope_start();
+  EXPECT_EQ(actual_event.name_key(), client_key);
+  EXPECT_EQ(actual_event.pid(), kPid1);
+  EXPECT_EQ(actual_event.tid(), kTid1);
+  EXPECT_EQ(actual_event.timestamp_ns(), kTimestampNs1);
+}
+
+TEST(ProducerEventProcessor, PackedApiEvents) {
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+
+  ClientCaptureEvent client_interned_string_event;
+  EXPECT_CALL(collector, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_interned_string_event));
+  producer_event_processor->ProcessEvent(kDefaultProducerId,
+                                         CreateInternedStringEvent(kKey1, "scope name"));
+  testing::Mock::VerifyAndClearExpectations(&collector);
+  const uint64_t client_key = client_interned_string_event.interned_string().key();
+
+  ProducerCaptureEvent producer_capture_event;
+  orbit_grpc_protos::PackedApiEvents* packed_api_events =
+      producer_capture_event.mutable_packed_api_events();
+  packed_api_events->set_version(orbit_api::kPackedApiEventsVersion);
+  packed_api_events->set_pid(kPid1);
+  orbit_api::PackedApiScopeStart packed_scope_start;
+  packed_scope_start.tid = kTid1;
+  packed_scope_start.timestamp_ns = kTimestampNs1;
+  packed_scope_start.name_key = kKey1;
+  packed_scope_start.group_id = kGroupId1;
+  packed_scope_start.color_rgba = kColor1;
+  orbit_api::AppendPackedApiEvent(packed_scope_start, packed_api_events->mutable_records());
+  orbit_api::PackedApiScopeStopAsync packed_scope_stop_async;
+  packed_scope_stop_async.tid = kTid2;
+  packed_scope_stop_async.timestamp_ns = kTimestampNs2;
+  packed_scope_stop_async.id = kGroupId2;
+  orbit_api::AppendPackedApiEvent(packed_scope_stop_async, packed_api_events->mutable_records());
+
+  std::vector<ClientCaptureEvent> client_capture_events;
+  EXPECT_CALL(collector, AddEvent)
+      .Times(2)
+      .WillRepeatedly(
+          Invoke([&client_capture_events](ClientCaptureEvent&& client_capture_event) {
+            client_capture_events.push_back(std::move(client_capture_event));
+          }));
+  producer_event_processor->ProcessEvent(kDefaultProducerId, std::move(producer_capture_event));
+  ASSERT_EQ(client_capture_events.size(), 2);
+
+  ASSERT_EQ(client_capture_events[0].event_case(), ClientCaptureEvent::kApiScopeStart);
+  const ApiScopeStart& api_scope_start = client_capture_events[0].api_scope_start();
+  EXPECT_EQ(api_scope_start.pid(), kPid1);
+  EXPECT_EQ(api_scope_start.tid(), kTid1);
+  EXPECT_EQ(api_scope_start.timestamp_ns(), kTimestampNs1);
+  EXPECT_EQ(api_scope_start.name_key(), client_key);
+  EXPECT_EQ(api_scope_start.group_id(), kGroupId1);
+  EXPECT_EQ(api_scope_start.color_rgba(), kColor1);
+
+  ASSERT_EQ(client_capture_events[1].event_case(), ClientCaptureEvent::kApiScopeStopAsync);
+  const ApiScopeStopAsync& api_scope_stop_async = client_capture_events[1].api_scope_stop_async();
+  EXPECT_EQ(api_scope_stop_async.pid(), kPid1);
+  EXPECT_EQ(api_scope_stop_async.tid(), kTid2);
+  EXPECT_EQ(api_scope_stop_async.timestamp_ns(), kTimestampNs2);
+  EXPECT_EQ(api_scope_stop_async.id(), kGroupId2);
+}
+
+TEST(ProducerEventProcessor, PackedApiEventsTruncated) {
+  ProducerCaptureEvent producer_capture_event;
+  orbit_grpc_protos::PackedApiEvents* packed_api_events =
+      producer_capture_event.mutable_packed_api_events();
+  packed_api_events->set_version(orbit_api::kPackedApiEventsVersion);
+  packed_api_events->set_pid(kPid1);
+  orbit_api::AppendPackedApiEvent(orbit_api::PackedApiScopeStop{},
+                                  packed_api_events->mutable_records());
+  orbit_api::AppendPackedApiEvent(orbit_api::PackedApiScopeStart{},
+                                  packed_api_events->mutable_records());
+  packed_api_events->mutable_records()->resize(packed_api_events->records().size() - 1);
+
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+  EXPECT_CALL(collector, AddEvent).Times(1);
+  producer_event_processor->ProcessEvent(kDefaultProducerId, std::move(producer_capture_event));
+}
+
 TEST(ProducerEventProcessor, ApiScopeStop) {
   ProducerCaptureEvent producer_capture_event;
   ApiScopeStop* api_scope_stop = producer_capture_event.mutable_api_scope_stop();
@@ -2153,6 +2467,99 @@ TEST(ProducerEventProcessor, ApiTrackDouble) {
   EXPECT_TRUE(MessageDifferencer::Equivalent(api_track_double_copy, actual_event));
 }
 
+TEST(ProducerEventProcessor, ConcurrentProducersWithSameInternedStrings) {
+  constexpr uint64_t kProducerCount = 4;
+  constexpr uint64_t kStringCount = 200;
+
+  absl::Mutex mutex;
+  std::vector<ClientCaptureEvent> client_capture_events;
+  MockClientCaptureEventCollector collector;
+  EXPECT_CALL(collector, AddEvent)
+      .WillRepeatedly([&mutex, &client_capture_events](ClientCaptureEvent&& event) {
+        absl::MutexLock lock{&mutex};
+        client_capture_events.emplace_back(std::move(event));
+      });
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+
+  std::vector<std::thread> producer_threads;
+  for (uint64_t producer_id = 1; producer_id <= kProducerCount; ++producer_id) {
+    producer_threads.emplace_back([&producer_event_processor, producer_id] {
+      for (uint64_t i = 0; i < kStringCount; ++i) {
+        // Every producer uses different keys for the same strings.
+        const uint64_t producer_key = producer_id * kStringCount + i;
+        producer_event_processor->ProcessEvent(
+            producer_id, CreateInternedStringEvent(producer_key, absl::StrFormat("name %u", i)));
+        ProducerCaptureEvent scope_start_event;
+        ApiScopeStart* api_scope_start = scope_start_event.mutable_api_scope_start();
+        api_scope_start->set_pid(kPid1);
+        api_scope_start->set_tid(static_cast<int32_t>(producer_id));
+        api_scope_start->set_timestamp_ns(i);
+        api_scope_start->set_name_key(producer_key);
+        producer_event_processor->ProcessEvent(producer_id, std::move(scope_start_event));
+      }
+    });
+  }
+  for (std::thread& producer_thread : producer_threads) {
+    producer_thread.join();
+  }
+
+  // Each string is sent to the client exactly once, and before any event referring to it.
+  absl::flat_hash_map<uint64_t, std::string> client_key_to_string;
+  uint64_t scope_start_count = 0;
+  for (const ClientCaptureEvent& event : client_capture_events) {
+    if (event.event_case() == ClientCaptureEvent::kInternedString) {
+      EXPECT_TRUE(client_key_to_string
+                      .emplace(event.interned_string().key(), event.interned_string().intern())
+                      .second);
+      continue;
+    }
+    ASSERT_EQ(event.event_case(), ClientCaptureEvent::kApiScopeStart);
+    const ApiScopeStart& api_scope_start = event.api_scope_start();
+    auto it = client_key_to_string.find(api_scope_start.name_key());
+    ASSERT_NE(it, client_key_to_string.end());
+    EXPECT_EQ(it->second, absl::StrFormat("name %u", api_scope_start.timestamp_ns()));
+    ++scope_start_count;
+  }
+  EXPECT_EQ(client_key_to_string.size(), kStringCount);
+  EXPECT_EQ(scope_start_count, kProducerCount * kStringCount);
+}
+
+TEST(ProducerEventProcessor, ApiTrackValueSummary) {
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+
+  ClientCaptureEvent client_interned_string_event;
+  EXPECT_CALL(collector, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_interned_string_event));
+  producer_event_processor->ProcessEvent(kDefaultProducerId,
+                                         CreateInternedStringEvent(kKey1, "track name"));
+  testing::Mock::VerifyAndClearExpectations(&collector);
+  ASSERT_EQ(client_interned_string_event.event_case(), ClientCaptureEvent::kInternedString);
+  const uint64_t client_key = client_interned_string_event.interned_string().key();
+
+  ProducerCaptureEvent producer_capture_event;
+  ApiTrackValueSummary* api_track_value_summary =
+      producer_capture_event.mutable_api_track_value_summary();
+  api_track_value_summary->set_pid(kPid1);
+  api_track_value_summary->set_tid(kTid1);
+  api_track_value_summary->set_name_key(kKey1);
+  api_track_value_summary->set_count(3);
+  api_track_value_summary->set_min(-kDouble);
+  api_track_value_summary->set_min_timestamp_ns(kTimestampNs2);
+  api_track_value_summary->set_max(kDouble);
+  api_track_value_summary->set_max_timestamp_ns(kTimestampNs1);
+  api_track_value_summary->set_last(0.0);
+  api_track_value_summary->set_last_timestamp_ns(kTimestampNs3);
+  ApiTrackValueSummary expected_event = *api_track_value_summary;
+  expected_event.set_name_key(client_key);
+
+  ClientCaptureEvent client_capture_event;
+  EXPECT_CALL(collector, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_capture_event));
+  producer_event_processor->ProcessEvent(kDefaultProducerId, std::move(producer_capture_event));
+  ASSERT_EQ(client_capture_event.event_case(), ClientCaptureEvent::kApiTrackValueSummary);
+  EXPECT_TRUE(MessageDifferencer::Equivalent(expected_event,
+                                             client_capture_event.api_track_value_summary()));
+}
+
 TEST(ProducerEventProcessor, WarningEvent) {
   MockClientCaptureEventCollector collector;
   auto producer_event_processor = ProducerEventProcessor::Create(&collector);
@@ -2345,4 +2752,35 @@ TEST(ProducerEventProcessor, OutOfOrderEventsDiscardedEvent) {
   EXPECT_EQ(actual_out_of_order_events_discarded_event.end_timestamp_ns(), kTimestampNs1);
 }
 
+TEST(ProducerEventProcessor, PerfEventProcessingStatsEvent) {
+  MockClientCaptureEventCollector collector;
+  auto producer_event_processor = ProducerEventProcessor::Create(&collector);
+
+  ProducerCaptureEvent producer_capture_event;
+  PerfEventProcessingStatsEvent* perf_event_processing_stats_event =
+      producer_capture_event.mutable_perf_event_processing_stats_event();
+  perf_event_processing_stats_event->set_timestamp_ns(kTimestampNs1);
+  orbit_grpc_protos::PerfEventVisitorStats* visitor_stats =
+      perf_event_processing_stats_event->add_visitor_stats();
+  visitor_stats->set_name("UprobesUnwindingVisitor");
+  visitor_stats->set_processing_time_ns(kDurationNs1);
+  visitor_stats->set_event_count(42);
+
+  ClientCaptureEvent client_capture_event;
+  EXPECT_CALL(collector, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_capture_event));
+
+  producer_event_processor->ProcessEvent(kDefaultProducerId, std::move(producer_capture_event));
+
+  ASSERT_EQ(client_capture_event.event_case(), ClientCaptureEvent::kPerfEventProcessingStatsEvent);
+  const PerfEventProcessingStatsEvent& actual_perf_event_processing_stats_event =
+      client_capture_event.perf_event_processing_stats_event();
+  EXPECT_EQ(actual_perf_event_processing_stats_event.timestamp_ns(), kTimestampNs1);
+  ASSERT_EQ(actual_perf_event_processing_stats_event.visitor_stats_size(), 1);
+  EXPECT_EQ(actual_perf_event_processing_stats_event.visitor_stats(0).name(),
+            "UprobesUnwindingVisitor");
+  EXPECT_EQ(actual_perf_event_processing_stats_event.visitor_stats(0).processing_time_ns(),
+            kDurationNs1);
+  EXPECT_EQ(actual_perf_event_processing_stats_event.visitor_stats(0).event_count(), 42);
+}
+
 }  // namespace orbit_producer_event_processor
\ No newline at end of file
@@ -0,0 +1,70 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CAPTURE_EVENT_PROCESSOR_CAPTURE_FILE_CLIENT_CAPTURE_EVENT_COLLECTOR_H_
+#define CAPTURE_EVENT_PROCESSOR_CAPTURE_FILE_CLIENT_CAPTURE_EVENT_COLLECTOR_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "CaptureFile/CaptureFileOutputStream.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Result.h"
+#include "ProducerEventProcessor/ClientCaptureEventCollector.h"
+
+namespace orbit_producer_event_processor {
+
+// This class receives the ClientCaptureEvents emitted by a ProducerEventProcessor and writes all of
+// them to a compressed capture file on the machine where the capture is taken, on a separate
+// thread. Only a preview of the capture is forwarded to `preview_collector`, usually the collector
+// that streams the events to the client: all events, except that only one in
+// kPreviewSamplingPeriod of the high-rate ones (function calls, scheduling slices, callstack
+// samples and thread state slices) is forwarded.
+class CaptureFileClientCaptureEventCollector final : public ClientCaptureEventCollector {
+ public:
+  static constexpr uint64_t kPreviewSamplingPeriod = 100;
+
+  [[nodiscard]] static ErrorMessageOr<std::unique_ptr<CaptureFileClientCaptureEventCollector>>
+  Create(std::filesystem::path file_path, ClientCaptureEventCollector* preview_collector);
+
+  void AddEvent(orbit_grpc_protos::ClientCaptureEvent&& event) override;
+
+  // Writes the remaining events, completes the capture file with its CAPTURE_INDEX section, and
+  // then stops `preview_collector`.
+  void StopAndWait() override;
+
+  ~CaptureFileClientCaptureEventCollector() override;
+
+ private:
+  CaptureFileClientCaptureEventCollector(
+      std::filesystem::path file_path,
+      std::unique_ptr<orbit_capture_file::CaptureFileOutputStream> output_stream,
+      ClientCaptureEventCollector* preview_collector);
+
+  void WriterThread();
+
+  const std::filesystem::path file_path_;
+  std::unique_ptr<orbit_capture_file::CaptureFileOutputStream> output_stream_;
+  ClientCaptureEventCollector* preview_collector_;
+
+  absl::Mutex mutex_;
+  std::thread writer_thread_;
+  bool stop_requested_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<orbit_grpc_protos::ClientCaptureEvent> events_to_write_ ABSL_GUARDED_BY(mutex_);
+  uint64_t high_rate_event_count_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // Only accessed by the writer thread, and by StopAndWait once the writer thread has exited.
+  bool write_failed_ = false;
+  uint64_t total_number_of_events_written_ = 0;
+};
+
+}  // namespace orbit_producer_event_processor
+
+#endif  // CAPTURE_EVENT_PROCESSOR_CAPTURE_FILE_CLIENT_CAPTURE_EVENT_COLLECTOR_H_
@@ -0,0 +1,58 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef PRODUCER_EVENT_PROCESSOR_CLIENT_CAPTURE_EVENT_BATCHER_H_
+#define PRODUCER_EVENT_PROCESSOR_CLIENT_CAPTURE_EVENT_BATCHER_H_
+
+#include <stdint.h>
+
+#include "GrpcProtos/capture.pb.h"
+#include "GrpcProtos/services.pb.h"
+
+namespace orbit_producer_event_processor {
+
+// Appends ClientCaptureEvents to a CaptureResponse, merging the FunctionCalls, SchedulingSlices,
+// CallstackSamples and ThreadStateSlices into the columnar batches described in capture.proto.
+//
+// The batch of each kind sits where the first event of that kind was added, so events of different
+// kinds can reach the client in a different order than they were added. The client only relies on
+// InternedCallstacks preceding the events that reference them, hence an InternedCallstack closes
+// the current batches of CallstackSamples and ThreadStateSlices, and later ones start new batches.
+class ClientCaptureEventBatcher {
+ public:
+  explicit ClientCaptureEventBatcher(orbit_grpc_protos::CaptureResponse* capture_response)
+      : capture_response_{capture_response} {}
+
+  void AddEvent(orbit_grpc_protos::ClientCaptureEvent&& event);
+
+  // Events in a batch are counted individually.
+  [[nodiscard]] int GetEventCount() const { return event_count_; }
+
+ private:
+  template <typename BatchT>
+  struct OpenBatch {
+    BatchT* batch = nullptr;
+    uint64_t previous_timestamp_ns = 0;
+  };
+
+  void AddFunctionCall(const orbit_grpc_protos::FunctionCall& function_call);
+  void AddSchedulingSlice(const orbit_grpc_protos::SchedulingSlice& scheduling_slice);
+  void AddCallstackSample(const orbit_grpc_protos::CallstackSample& callstack_sample);
+  void AddThreadStateSlice(const orbit_grpc_protos::ThreadStateSlice& thread_state_slice);
+
+  orbit_grpc_protos::CaptureResponse* capture_response_;
+  int event_count_ = 0;
+
+  OpenBatch<orbit_grpc_protos::FunctionCallBatch> function_call_batch_;
+  OpenBatch<orbit_grpc_protos::SchedulingSliceBatch> scheduling_slice_batch_;
+  OpenBatch<orbit_grpc_protos::CallstackSampleBatch> callstack_sample_batch_;
+  OpenBatch<orbit_grpc_protos::ThreadStateSliceBatch> thread_state_slice_batch_;
+};
+
+// Returns the number of events in `capture_response`, counting events in a batch individually.
+[[nodiscard]] int GetClientCaptureEventCount(const orbit_grpc_protos::CaptureResponse& response);
+
+}  // namespace orbit_producer_event_processor
+
+#endif  // PRODUCER_EVENT_PROCESSOR_CLIENT_CAPTURE_EVENT_BATCHER_H_
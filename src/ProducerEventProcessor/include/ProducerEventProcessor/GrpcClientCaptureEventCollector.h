@@ -13,23 +13,31 @@
 #include <grpcpp/support/sync_stream.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <memory>
+#include <optional>
 #include <thread>
 #include <vector>
 
 #include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/services.pb.h"
+#include "OrbitBase/StatsRegistry.h"
+#include "ProducerEventProcessor/ClientCaptureEventBatcher.h"
 #include "ProducerEventProcessor/ClientCaptureEventCollector.h"
 
 namespace orbit_producer_event_processor {
 
 // This class receives the ClientCaptureEvents emitted by a ProducerEventProcessor and continuously
 // sends them to the client buffered in CaptureResponses.
+// While `client_capture_backlog_byte_count`, as reported by the client, exceeds
+// kClientCaptureBacklogThresholdBytes, the CaptureResponses are sent less often and several at a
+// time, which reduces the overhead per event on both sides.
 class GrpcClientCaptureEventCollector final : public ClientCaptureEventCollector {
  public:
   explicit GrpcClientCaptureEventCollector(
       grpc::ServerReaderWriterInterface<orbit_grpc_protos::CaptureResponse,
-                                        orbit_grpc_protos::CaptureRequest>* reader_writer);
+                                        orbit_grpc_protos::CaptureRequest>* reader_writer,
+      std::shared_ptr<const std::atomic<uint64_t>> client_capture_backlog_byte_count = nullptr);
 
   void AddEvent(orbit_grpc_protos::ClientCaptureEvent&& event) override;
 
@@ -42,6 +50,10 @@ class GrpcClientCaptureEventCollector final : public ClientCaptureEventCollector
 
   grpc::ServerReaderWriterInterface<orbit_grpc_protos::CaptureResponse,
                                     orbit_grpc_protos::CaptureRequest>* reader_writer_;
+  std::shared_ptr<const std::atomic<uint64_t>> client_capture_backlog_byte_count_;
+  // How many full CaptureResponses the sender thread waits for before sending them. Read in the
+  // Condition of the sender thread, which other threads can evaluate.
+  std::atomic<size_t> full_capture_responses_to_send_at_once_ = 1;
   absl::Mutex mutex_;
   std::thread sender_thread_;
   bool stop_requested_ ABSL_GUARDED_BY(mutex_) = false;
@@ -52,11 +64,21 @@ class GrpcClientCaptureEventCollector final : public ClientCaptureEventCollector
       ABSL_GUARDED_BY(mutex_);
   std::vector<orbit_grpc_protos::CaptureResponse*> capture_responses_being_built_
       ABSL_GUARDED_BY(mutex_);
+  // Adds the events to the last of `capture_responses_being_built_`.
+  std::optional<ClientCaptureEventBatcher> batcher_ ABSL_GUARDED_BY(mutex_);
   std::unique_ptr<google::protobuf::Arena> arena_of_capture_responses_to_send_;
   std::vector<orbit_grpc_protos::CaptureResponse*> capture_responses_to_send_;
 
-  uint64_t total_number_of_events_sent_ = 0;
-  uint64_t total_number_of_bytes_sent_ = 0;
+  // These can be read by the live stats while the sender thread updates them.
+  std::atomic<uint64_t> total_number_of_events_added_ = 0;
+  std::atomic<uint64_t> total_number_of_events_sent_ = 0;
+  std::atomic<uint64_t> total_number_of_bytes_sent_ = 0;
+  // CPU time of the sender thread spent in `reader_writer_->Write`, which includes serializing and,
+  // if enabled, compressing the CaptureResponses.
+  uint64_t total_write_cpu_time_ns_ = 0;
+
+  // Declared last, so that they are unregistered before the counters they read are destroyed.
+  std::vector<orbit_base::StatsRegistry::Registration> live_stats_registrations_;
 };
 
 }  // namespace orbit_producer_event_processor
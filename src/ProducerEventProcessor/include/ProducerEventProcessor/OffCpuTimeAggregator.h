@@ -0,0 +1,53 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef PRODUCER_EVENT_PROCESSOR_OFF_CPU_TIME_AGGREGATOR_H_
+#define PRODUCER_EVENT_PROCESSOR_OFF_CPU_TIME_AGGREGATOR_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <stdint.h>
+
+#include <tuple>
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+
+namespace orbit_producer_event_processor {
+
+// Sums up the durations of ThreadStateSlices per thread, thread state and callstack, see
+// CaptureOptions.off_cpu_time_aggregation_interval_ns. The slices are grouped into consecutive
+// intervals by their end timestamps: an interval starts with the first slice added to it and ends
+// with the first slice that ends at least `interval_ns` later, which then starts the next one.
+// So on a thread that blocks on the same callstack over and over, an OffCpuTimeSummary is sent per
+// interval instead of each slice.
+class OffCpuTimeAggregator {
+ public:
+  explicit OffCpuTimeAggregator(uint64_t interval_ns) : interval_ns_{interval_ns} {}
+
+  // Returns whether the off-CPU time of `thread_state_slice` can be summarized, i.e., whether the
+  // slice is not running and has the switch-out callstack of its own thread. Slices with the
+  // callstack of the thread that woke them up are not.
+  [[nodiscard]] static bool IsAggregatable(
+      const orbit_grpc_protos::ThreadStateSlice& thread_state_slice);
+
+  // Adds a slice for which IsAggregatable is true. If the slice ends after the current interval,
+  // the summaries of that interval are returned, and the slice is added to the next one.
+  [[nodiscard]] std::vector<orbit_grpc_protos::OffCpuTimeSummary> AddThreadStateSlice(
+      const orbit_grpc_protos::ThreadStateSlice& thread_state_slice);
+
+  // Returns the summaries of the current interval and starts a new one.
+  [[nodiscard]] std::vector<orbit_grpc_protos::OffCpuTimeSummary> Flush();
+
+ private:
+  // tid, thread state and callstack id.
+  using Key = std::tuple<uint32_t, int, uint64_t>;
+
+  uint64_t interval_ns_;
+  uint64_t interval_start_timestamp_ns_ = 0;
+  absl::flat_hash_map<Key, orbit_grpc_protos::OffCpuTimeSummary> summaries_;
+};
+
+}  // namespace orbit_producer_event_processor
+
+#endif  // PRODUCER_EVENT_PROCESSOR_OFF_CPU_TIME_AGGREGATOR_H_
@@ -5,6 +5,7 @@
 #ifndef CAPTURE_EVENT_PROCESSOR_EVENT_PROCESSOR_H_
 #define CAPTURE_EVENT_PROCESSOR_EVENT_PROCESSOR_H_
 
+#include <absl/container/flat_hash_set.h>
 #include <stdint.h>
 
 #include <memory>
@@ -22,9 +23,15 @@ class ProducerEventProcessor {
   ProducerEventProcessor() = default;
   virtual ~ProducerEventProcessor() = default;
 
+  // Can be called concurrently: calls for different `producer_id`s only wait for each other to
+  // intern the same entries for the first time.
   virtual void ProcessEvent(uint64_t producer_id,
                             orbit_grpc_protos::ProducerCaptureEvent&& event) = 0;
 
+  // From this call on, the events of producers whose id is not in `producer_ids_to_keep` are
+  // dropped, e.g., to shed load when OrbitService is running out of memory. This cannot be undone.
+  virtual void DropEventsOfProducersExcept(absl::flat_hash_set<uint64_t> producer_ids_to_keep) = 0;
+
   static std::unique_ptr<ProducerEventProcessor> Create(
       ClientCaptureEventCollector* client_capture_event_collector);
 };
@@ -6,16 +6,17 @@
 
 #include <absl/synchronization/mutex.h>
 #include <absl/time/time.h>
-#include <google/protobuf/arena.h>
 #include <stddef.h>
 
+#include <memory>
 #include <thread>
 #include <utility>
 
 #include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Logging.h"
-#include "OrbitBase/MakeUniqueForOverwrite.h"
 #include "OrbitBase/ThreadUtils.h"
+#include "ReceivedRequestQueue.h"
+#include "SharedMemoryEventReader.h"
 
 namespace orbit_producer_side_service {
 
@@ -120,15 +121,25 @@ grpc::Status ProducerSideServiceImpl::ReceiveCommandsAndSendEvents(
                                    &all_events_sent_received,
                                    &receive_events_thread_exited};
 
-  // This thread is responsible for reading from stream, and specifically for
-  // receiving ProducerCaptureEvents and AllEventsSent messages.
-  std::thread receive_events_thread{&ProducerSideServiceImpl::ReceiveEventsThread,
+  // A few requests can be queued while the previous ones are processed. Beyond that, reading from
+  // stream blocks until the ProducerEventProcessor has caught up with this producer.
+  constexpr size_t kMaxQueuedRequestCount = 4;
+  ReceivedRequestQueue request_queue{kMaxQueuedRequestCount};
+
+  // This thread is responsible for handling the requests received by receive_events_thread, and
+  // specifically for passing the ProducerCaptureEvents to the ProducerEventProcessor.
+  std::thread process_events_thread{&ProducerSideServiceImpl::ProcessEventsThread,
                                     this,
-                                    context,
-                                    stream,
+                                    &request_queue,
                                     producer_id_counter_++,
                                     &all_events_sent_received};
+
+  // This thread is responsible for reading from stream, and specifically for
+  // receiving ProducerCaptureEvents and AllEventsSent messages.
+  std::thread receive_events_thread{
+      &ProducerSideServiceImpl::ReceiveEventsThread, this, stream, &request_queue};
   receive_events_thread.join();
+  process_events_thread.join();
 
   // When receive_events_thread exits because stream->Read(&request) fails,
   // it means that the producer has disconnected: ask send_commands_thread to exit, too.
@@ -353,31 +364,18 @@ void ProducerSideServiceImpl::SendCommandsThread(
 }
 
 void ProducerSideServiceImpl::ReceiveEventsThread(
-    grpc::ServerContext* /*context*/,
     grpc::ServerReaderWriter<orbit_grpc_protos::ReceiveCommandsAndSendEventsResponse,
                              orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest>* stream,
-    uint64_t producer_id, bool* all_events_sent_received) {
+    ReceivedRequestQueue* request_queue) {
   orbit_base::SetCurrentThreadName("PSSI::RcvEvents");
 
-  // Create the ReceiveCommandsAndSendEventsRequest on a protobuf Arena, which prevents memory
-  // allocations for the multiple sub-messages containing ProducerCaptureEvents. Now, when calling
-  // ProducerEventProcessor::ProcessEvent below, passing the ProducerCaptureEvent will result in a
-  // deep copy and the memory allocations we saved before will happen here, plus copies.
-  // Nonetheless, and maybe counterintuitively, the performance improvement we measured is huge. In
-  // particular, ServerReaderWriter::Read seems particularly inefficient without an Arena.
-  google::protobuf::ArenaOptions arena_options;
-  constexpr size_t kArenaFixedBlockSize = 1024 * 1024;
-  auto arena_initial_block = make_unique_for_overwrite<char[]>(kArenaFixedBlockSize);
-  arena_options.initial_block = arena_initial_block.get();
-  arena_options.initial_block_size = kArenaFixedBlockSize;
-  arena_options.start_block_size = kArenaFixedBlockSize;
-  arena_options.max_block_size = kArenaFixedBlockSize;
-
   while (true) {
-    google::protobuf::Arena arena{arena_options};
-    auto* request = google::protobuf::Arena::CreateMessage<
-        orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest>(&arena);
-    if (!stream->Read(request)) break;
+    orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest* request =
+        request_queue->AcquireRequest();
+    if (!stream->Read(request)) {
+      ORBIT_ERROR("Receiving ReceiveCommandsAndSendEventsRequest from CaptureEventProducer");
+      break;
+    }
 
     {
       absl::MutexLock lock{&service_state_mutex_};
@@ -386,8 +384,26 @@ void ProducerSideServiceImpl::ReceiveEventsThread(
       }
     }
 
+    request_queue->PushRequest();
+  }
+  request_queue->CloseQueue();
+}
+
+void ProducerSideServiceImpl::ProcessEventsThread(ReceivedRequestQueue* request_queue,
+                                                  uint64_t producer_id,
+                                                  bool* all_events_sent_received) {
+  orbit_base::SetCurrentThreadName("PSSI::PrcEvents");
+
+  ProducerEventStats stats{producer_id};
+
+  // Only set if the producer sends its CaptureEvents through shared memory.
+  std::unique_ptr<SharedMemoryEventReader> shared_memory_event_reader;
+
+  orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest* request;
+  while ((request = request_queue->PopRequest()) != nullptr) {
     switch (request->event_case()) {
       case orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest::kBufferedCaptureEvents: {
+        auto* capture_events = request->mutable_buffered_capture_events()->mutable_capture_events();
         // We use ReaderMutexLock because the mutex guards the value of producer_event_processor_,
         // it does not guard calls to ProcessEvent nor the internal state of the object implementing
         // the interface. The interface implementation is by itself thread-safe.
@@ -395,15 +411,39 @@ void ProducerSideServiceImpl::ReceiveEventsThread(
         // producer_event_processor_ can be nullptr if a producer sends events while not capturing.
         // Don't log an error in such a case as it could easily spam the logs.
         if (producer_event_processor_ != nullptr) {
-          for (ProducerCaptureEvent& event :
-               *request->mutable_buffered_capture_events()->mutable_capture_events()) {
+          for (ProducerCaptureEvent& event : *capture_events) {
             producer_event_processor_->ProcessEvent(producer_id, std::move(event));
           }
+          stats.AddEvents(static_cast<uint64_t>(capture_events->size()), 0);
+        } else {
+          stats.AddEvents(0, static_cast<uint64_t>(capture_events->size()));
         }
       } break;
 
+      case orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest::kSharedMemoryBufferCreated: {
+        const std::string& name = request->shared_memory_buffer_created().name();
+        ORBIT_LOG("Received SharedMemoryBufferCreated \"%s\" from CaptureEventProducer", name);
+        auto buffer_or_error = orbit_base::SharedMemoryRingBuffer::Open(name);
+        if (buffer_or_error.has_error()) {
+          ORBIT_ERROR("Opening shared memory buffer of CaptureEventProducer: %s",
+                      buffer_or_error.error().message());
+          break;
+        }
+        shared_memory_event_reader = std::make_unique<SharedMemoryEventReader>(
+            std::move(buffer_or_error.value()),
+            [this, producer_id, &stats](orbit_base::SharedMemoryRingBuffer* buffer) {
+              ProcessSharedMemoryBufferEvents(buffer, producer_id, &stats);
+            });
+      } break;
+
       case orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest::kAllEventsSent: {
         ORBIT_LOG("Received AllEventsSent from CaptureEventProducer");
+        // The producer has written all its events to the shared memory buffer before sending
+        // AllEventsSent, so read them before the capture can finish.
+        if (shared_memory_event_reader != nullptr) {
+          shared_memory_event_reader->ReadNow();
+        }
+        stats.LogAndReset();
         absl::MutexLock lock{&service_state_mutex_};
         switch (service_state_.capture_status) {
           case CaptureStatus::kCaptureStarted: {
@@ -434,9 +474,16 @@ void ProducerSideServiceImpl::ReceiveEventsThread(
         ORBIT_ERROR("CaptureEventProducer sent EVENT_NOT_SET");
       } break;
     }
+    request_queue->ReleaseRequest();
   }
 
-  ORBIT_ERROR("Receiving ReceiveCommandsAndSendEventsRequest from CaptureEventProducer");
+  // Don't lose the events the producer has written to shared memory before disconnecting.
+  if (shared_memory_event_reader != nullptr) {
+    shared_memory_event_reader->ReadNow();
+    // Stop the reader thread before stats goes out of scope.
+    shared_memory_event_reader.reset();
+  }
+  stats.LogAndReset();
   {
     absl::MutexLock lock{&service_state_mutex_};
     // Producer has disconnected: treat this as if it had sent all its CaptureEvents.
@@ -449,4 +496,62 @@ void ProducerSideServiceImpl::ReceiveEventsThread(
   }
 }
 
+void ProducerSideServiceImpl::ProcessSharedMemoryBufferEvents(
+    orbit_base::SharedMemoryRingBuffer* buffer, uint64_t producer_id, ProducerEventStats* stats) {
+  absl::ReaderMutexLock lock{&producer_event_processor_mutex_};
+  // As for BufferedCaptureEvents, events sent while not capturing are dropped.
+  orbit_producer_event_processor::ProducerEventProcessor* producer_event_processor =
+      producer_event_processor_;
+  uint64_t processed_event_count = 0;
+  uint64_t dropped_event_count = 0;
+  uint64_t unparsable_event_count = 0;
+  auto read_result = buffer->ReadRecords([producer_event_processor, producer_id,
+                                          &processed_event_count, &dropped_event_count,
+                                          &unparsable_event_count](absl::Span<const char> record) {
+    if (producer_event_processor == nullptr) {
+      ++dropped_event_count;
+      return;
+    }
+    ProducerCaptureEvent event;
+    if (!event.ParseFromArray(record.data(), static_cast<int>(record.size()))) {
+      ++unparsable_event_count;
+      return;
+    }
+    producer_event_processor->ProcessEvent(producer_id, std::move(event));
+    ++processed_event_count;
+  });
+  stats->AddEvents(processed_event_count, dropped_event_count + unparsable_event_count);
+  if (read_result.has_error()) {
+    ORBIT_ERROR("Reading shared memory buffer of CaptureEventProducer: %s",
+                read_result.error().message());
+  }
+  if (unparsable_event_count > 0) {
+    ORBIT_ERROR("Dropped %u unparsable CaptureEvents from shared memory buffer",
+                unparsable_event_count);
+  }
+}
+
+void ProducerSideServiceImpl::ProducerEventStats::AddEvents(uint64_t processed_event_count,
+                                                           uint64_t dropped_event_count) {
+  if (processed_event_count == 0 && dropped_event_count == 0) return;
+  absl::MutexLock lock{&mutex_};
+  if (processed_event_count_ == 0 && dropped_event_count_ == 0) first_event_time_ = absl::Now();
+  processed_event_count_ += processed_event_count;
+  dropped_event_count_ += dropped_event_count;
+}
+
+void ProducerSideServiceImpl::ProducerEventStats::LogAndReset() {
+  absl::MutexLock lock{&mutex_};
+  if (processed_event_count_ == 0 && dropped_event_count_ == 0) return;
+  const double duration_s = absl::ToDoubleSeconds(absl::Now() - first_event_time_);
+  ORBIT_LOG(
+      "CaptureEventProducer %u: processed %u CaptureEvents (%.0f/s), dropped %u (received while "
+      "not capturing or unparsable)",
+      producer_id_, processed_event_count_,
+      duration_s > 0 ? static_cast<double>(processed_event_count_) / duration_s : 0.0,
+      dropped_event_count_);
+  processed_event_count_ = 0;
+  dropped_event_count_ = 0;
+}
+
 }  // namespace orbit_producer_side_service
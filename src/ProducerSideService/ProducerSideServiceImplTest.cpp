@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
 #include <gmock/gmock.h>
 #include <grpcpp/grpcpp.h>
@@ -147,6 +148,7 @@ class MockProducerEventProcessor : public orbit_producer_event_processor::Produc
  public:
   MOCK_METHOD(void, ProcessEvent, (uint64_t, orbit_grpc_protos::ProducerCaptureEvent&& event),
               (override));
+  MOCK_METHOD(void, DropEventsOfProducersExcept, (absl::flat_hash_set<uint64_t>), (override));
 };
 
 class ProducerSideServiceImplTest : public ::testing::Test {
@@ -0,0 +1,62 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_PRODUCER_SIDE_SERVICE_RECEIVED_REQUEST_QUEUE_H_
+#define ORBIT_PRODUCER_SIDE_SERVICE_RECEIVED_REQUEST_QUEUE_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <google/protobuf/arena.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "GrpcProtos/producer_side_services.pb.h"
+
+namespace orbit_producer_side_service {
+
+// Bounded single-producer single-consumer queue of the ReceiveCommandsAndSendEventsRequests read
+// from the stream of one producer, so that reading (and parsing) the next request overlaps with
+// processing the previous one. Each of the `capacity` requests lives on its own protobuf Arena with
+// a preallocated block, which is reset and reused once the request has been processed.
+//
+// The reading thread calls AcquireRequest, fills the request, and then calls PushRequest. The
+// processing thread calls PopRequest and, once done with the request, ReleaseRequest. When all
+// requests are in use, AcquireRequest blocks, which stops reading from the stream and so lets gRPC
+// flow control throttle only this producer. CloseQueue must be called by the reading thread when it
+// won't push any more requests: PopRequest then returns nullptr once the queue is empty.
+class ReceivedRequestQueue {
+ public:
+  explicit ReceivedRequestQueue(size_t capacity);
+  ReceivedRequestQueue(const ReceivedRequestQueue&) = delete;
+  ReceivedRequestQueue& operator=(const ReceivedRequestQueue&) = delete;
+
+  [[nodiscard]] orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest* AcquireRequest();
+  void PushRequest();
+  void CloseQueue();
+
+  [[nodiscard]] orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest* PopRequest();
+  void ReleaseRequest();
+
+ private:
+  struct Slot {
+    std::unique_ptr<char[]> arena_initial_block;
+    std::unique_ptr<google::protobuf::Arena> arena;
+    orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest* request = nullptr;
+  };
+  std::vector<Slot> slots_;
+
+  absl::Mutex mutex_;
+  // Slots are used in order: the request at `pushed_count_ % slots_.size()` is being filled, the
+  // ones from `released_count_` to `pushed_count_` (exclusive) are queued or being processed.
+  uint64_t pushed_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  uint64_t released_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace orbit_producer_side_service
+
+#endif  // ORBIT_PRODUCER_SIDE_SERVICE_RECEIVED_REQUEST_QUEUE_H_
@@ -0,0 +1,63 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/synchronization/notification.h>
+#include <absl/time/time.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "GrpcProtos/producer_side_services.pb.h"
+#include "ReceivedRequestQueue.h"
+
+namespace orbit_producer_side_service {
+
+using orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest;
+
+TEST(ReceivedRequestQueue, PopsRequestsInOrderUntilClosed) {
+  ReceivedRequestQueue queue{2};
+
+  queue.AcquireRequest()->mutable_shared_memory_buffer_created()->set_name("first");
+  queue.PushRequest();
+  queue.AcquireRequest()->mutable_all_events_sent();
+  queue.PushRequest();
+  queue.CloseQueue();
+
+  ReceiveCommandsAndSendEventsRequest* request = queue.PopRequest();
+  ASSERT_NE(request, nullptr);
+  EXPECT_EQ(request->shared_memory_buffer_created().name(), "first");
+  queue.ReleaseRequest();
+
+  request = queue.PopRequest();
+  ASSERT_NE(request, nullptr);
+  EXPECT_TRUE(request->has_all_events_sent());
+  queue.ReleaseRequest();
+
+  EXPECT_EQ(queue.PopRequest(), nullptr);
+}
+
+TEST(ReceivedRequestQueue, AcquireRequestBlocksUntilARequestIsReleased) {
+  ReceivedRequestQueue queue{1};
+  queue.AcquireRequest()->mutable_all_events_sent();
+  queue.PushRequest();
+
+  absl::Notification acquired;
+  std::thread reading_thread{[&queue, &acquired] {
+    ReceiveCommandsAndSendEventsRequest* request = queue.AcquireRequest();
+    // The slot was reset after being released.
+    EXPECT_EQ(request->event_case(), ReceiveCommandsAndSendEventsRequest::EVENT_NOT_SET);
+    acquired.Notify();
+    queue.CloseQueue();
+  }};
+
+  EXPECT_FALSE(acquired.WaitForNotificationWithTimeout(absl::Milliseconds(50)));
+  ASSERT_NE(queue.PopRequest(), nullptr);
+  queue.ReleaseRequest();
+  acquired.WaitForNotification();
+  EXPECT_EQ(queue.PopRequest(), nullptr);
+
+  reading_thread.join();
+}
+
+}  // namespace orbit_producer_side_service
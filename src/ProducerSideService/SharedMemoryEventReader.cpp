@@ -0,0 +1,45 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SharedMemoryEventReader.h"
+
+#include <absl/time/time.h>
+
+#include <utility>
+
+#include "OrbitBase/ThreadUtils.h"
+
+namespace orbit_producer_side_service {
+
+SharedMemoryEventReader::SharedMemoryEventReader(
+    orbit_base::SharedMemoryRingBuffer buffer,
+    std::function<void(orbit_base::SharedMemoryRingBuffer*)> read_events)
+    : buffer_{std::move(buffer)},
+      read_events_{std::move(read_events)},
+      reader_thread_{&SharedMemoryEventReader::ReaderThread, this} {}
+
+SharedMemoryEventReader::~SharedMemoryEventReader() {
+  {
+    absl::MutexLock lock{&mutex_};
+    exit_requested_ = true;
+  }
+  reader_thread_.join();
+}
+
+void SharedMemoryEventReader::ReadNow() {
+  absl::MutexLock lock{&mutex_};
+  read_events_(&buffer_);
+}
+
+void SharedMemoryEventReader::ReaderThread() {
+  orbit_base::SetCurrentThreadName("PSSI::ShmEvents");
+  // The same interval as the sleep of the forwarder thread in LockFreeBufferCaptureEventProducer.
+  constexpr absl::Duration kReadInterval = absl::Milliseconds(1);
+  absl::MutexLock lock{&mutex_};
+  while (!mutex_.AwaitWithTimeout(absl::Condition(&exit_requested_), kReadInterval)) {
+    read_events_(&buffer_);
+  }
+}
+
+}  // namespace orbit_producer_side_service
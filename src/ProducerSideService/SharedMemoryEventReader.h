@@ -0,0 +1,43 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_PRODUCER_SIDE_SERVICE_SHARED_MEMORY_EVENT_READER_H_
+#define ORBIT_PRODUCER_SIDE_SERVICE_SHARED_MEMORY_EVENT_READER_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <functional>
+#include <thread>
+
+#include "OrbitBase/SharedMemoryRingBuffer.h"
+
+namespace orbit_producer_side_service {
+
+// Owns the shared memory ring buffer a producer writes its CaptureEvents into, and passes it to
+// `read_events` periodically on a separate thread, until destroyed. ReadNow allows to read
+// synchronously instead, e.g., before handling AllEventsSent. Calls to `read_events` never overlap.
+class SharedMemoryEventReader {
+ public:
+  SharedMemoryEventReader(orbit_base::SharedMemoryRingBuffer buffer,
+                          std::function<void(orbit_base::SharedMemoryRingBuffer*)> read_events);
+  SharedMemoryEventReader(const SharedMemoryEventReader&) = delete;
+  SharedMemoryEventReader& operator=(const SharedMemoryEventReader&) = delete;
+  ~SharedMemoryEventReader();
+
+  void ReadNow();
+
+ private:
+  void ReaderThread();
+
+  absl::Mutex mutex_;
+  orbit_base::SharedMemoryRingBuffer buffer_ ABSL_GUARDED_BY(mutex_);
+  std::function<void(orbit_base::SharedMemoryRingBuffer*)> read_events_;
+  bool exit_requested_ ABSL_GUARDED_BY(mutex_) = false;
+  std::thread reader_thread_;
+};
+
+}  // namespace orbit_producer_side_service
+
+#endif  // ORBIT_PRODUCER_SIDE_SERVICE_SHARED_MEMORY_EVENT_READER_H_
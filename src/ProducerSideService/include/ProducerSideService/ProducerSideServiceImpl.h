@@ -8,6 +8,7 @@
 #include <absl/base/thread_annotations.h>
 #include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
 #include <grpcpp/grpcpp.h>
 #include <stdint.h>
 
@@ -19,10 +20,13 @@
 #include "GrpcProtos/capture.pb.h"
 #include "GrpcProtos/producer_side_services.grpc.pb.h"
 #include "GrpcProtos/producer_side_services.pb.h"
+#include "OrbitBase/SharedMemoryRingBuffer.h"
 #include "ProducerEventProcessor/ProducerEventProcessor.h"
 
 namespace orbit_producer_side_service {
 
+class ReceivedRequestQueue;
+
 // This class implements the gRPC service ProducerSideService, and in particular its only RPC
 // ReceiveCommandsAndSendEvents, through which producers of CaptureEvents connect to OrbitService.
 // It also implements the CaptureStartStopListener interface, whose methods cause this service to
@@ -71,11 +75,38 @@ class ProducerSideServiceImpl final : public orbit_grpc_protos::ProducerSideServ
                                orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest>* stream,
       bool* all_events_sent_received, std::atomic<bool>* receive_events_thread_exited);
 
+  // Counts the CaptureEvents received from one producer, both through the stream and through
+  // shared memory. They are logged and reset when the producer has sent all its CaptureEvents for a
+  // capture, and when it disconnects.
+  class ProducerEventStats {
+   public:
+    explicit ProducerEventStats(uint64_t producer_id) : producer_id_{producer_id} {}
+    void AddEvents(uint64_t processed_event_count, uint64_t dropped_event_count);
+    void LogAndReset();
+
+   private:
+    const uint64_t producer_id_;
+    absl::Mutex mutex_;
+    uint64_t processed_event_count_ ABSL_GUARDED_BY(mutex_) = 0;
+    uint64_t dropped_event_count_ ABSL_GUARDED_BY(mutex_) = 0;
+    absl::Time first_event_time_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  // Reads the requests of the producer from stream into request_queue, which has a bounded size.
   void ReceiveEventsThread(
-      grpc::ServerContext* context,
       grpc::ServerReaderWriter<orbit_grpc_protos::ReceiveCommandsAndSendEventsResponse,
                                orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest>* stream,
-      uint64_t producer_id, bool* all_events_sent_received);
+      ReceivedRequestQueue* request_queue);
+
+  // Handles the requests in request_queue, in particular passes the ProducerCaptureEvents to
+  // producer_event_processor_, until the queue is closed and empty.
+  void ProcessEventsThread(ReceivedRequestQueue* request_queue, uint64_t producer_id,
+                           bool* all_events_sent_received);
+
+  // Passes the CaptureEvents the producer has written to its shared memory buffer so far to
+  // producer_event_processor_.
+  void ProcessSharedMemoryBufferEvents(orbit_base::SharedMemoryRingBuffer* buffer,
+                                       uint64_t producer_id, ProducerEventStats* stats);
 
   absl::flat_hash_set<grpc::ServerContext*> server_contexts_
       ABSL_GUARDED_BY(server_contexts_mutex_);
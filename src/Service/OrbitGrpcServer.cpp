@@ -14,6 +14,7 @@
 #include <utility>
 
 #include "CaptureServiceBase/CaptureStartStopListener.h"
+#include "ServiceStatsService/ServiceStatsServiceImpl.h"
 
 #ifdef __linux
 
@@ -59,6 +60,7 @@ class OrbitGrpcServerImpl final : public OrbitGrpcServer {
   orbit_windows_capture_service::WindowsCaptureService capture_service_;
   orbit_windows_process_service::ProcessServiceImpl process_service_;
 #endif
+  orbit_service_stats_service::ServiceStatsServiceImpl service_stats_service_;
 
   std::unique_ptr<grpc::Server> server_;
 };
@@ -74,6 +76,7 @@ bool OrbitGrpcServerImpl::Init(std::string_view server_address, bool dev_mode) {
   builder.AddListeningPort(std::string(server_address), grpc::InsecureServerCredentials());
   builder.RegisterService(&capture_service_);
   builder.RegisterService(&process_service_);
+  builder.RegisterService(&service_stats_service_);
 
 #ifdef __linux
   builder.RegisterService(&tracepoint_service_);
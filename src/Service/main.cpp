@@ -95,7 +95,7 @@ std::filesystem::path GetLogFilePath() {
 }  // namespace
 
 int main(int argc, char** argv) {
-  orbit_base::InitLogFile(GetLogFilePath());
+  orbit_base::InitLogFile(GetLogFilePath(), orbit_base::LogFileWrites::kAsynchronous);
 
   absl::SetProgramUsageMessage("Orbit CPU Profiler Service");
   absl::SetFlagsUsageConfig(absl::FlagsUsageConfig{{}, {}, {}, &orbit_version::GetBuildReport, {}});
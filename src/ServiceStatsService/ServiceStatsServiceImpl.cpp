@@ -0,0 +1,31 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ServiceStatsService/ServiceStatsServiceImpl.h"
+
+#include <vector>
+
+#include "OrbitBase/Profiling.h"
+
+namespace orbit_service_stats_service {
+
+using orbit_grpc_protos::GetServiceStatsRequest;
+using orbit_grpc_protos::GetServiceStatsResponse;
+using orbit_grpc_protos::ServiceStat;
+
+grpc::Status ServiceStatsServiceImpl::GetServiceStats(grpc::ServerContext* /*context*/,
+                                                      const GetServiceStatsRequest* /*request*/,
+                                                      GetServiceStatsResponse* response) {
+  std::vector<orbit_base::StatsRegistry::Stat> stats = registry_->GetStats();
+  response->set_timestamp_ns(orbit_base::CaptureTimestampNs());
+  response->mutable_stats()->Reserve(static_cast<int>(stats.size()));
+  for (orbit_base::StatsRegistry::Stat& stat : stats) {
+    ServiceStat* service_stat = response->add_stats();
+    service_stat->set_name(std::move(stat.name));
+    service_stat->set_value(stat.value);
+  }
+  return grpc::Status::OK;
+}
+
+}  // namespace orbit_service_stats_service
@@ -0,0 +1,34 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include "GrpcProtos/services.pb.h"
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/StatsRegistry.h"
+#include "ServiceStatsService/ServiceStatsServiceImpl.h"
+
+namespace orbit_service_stats_service {
+
+TEST(ServiceStatsServiceImpl, GetServiceStatsReturnsTheRegisteredStats) {
+  orbit_base::StatsRegistry registry;
+  orbit_base::StatsRegistry::Registration registration_b = registry.Register("b", [] { return 2; });
+  orbit_base::StatsRegistry::Registration registration_a = registry.Register("a", [] { return 1; });
+  ServiceStatsServiceImpl service{&registry};
+
+  const uint64_t timestamp_before_ns = orbit_base::CaptureTimestampNs();
+  orbit_grpc_protos::GetServiceStatsRequest request;
+  orbit_grpc_protos::GetServiceStatsResponse response;
+  grpc::ServerContext context;
+  ASSERT_TRUE(service.GetServiceStats(&context, &request, &response).ok());
+
+  EXPECT_GE(response.timestamp_ns(), timestamp_before_ns);
+  ASSERT_EQ(response.stats_size(), 2);
+  EXPECT_EQ(response.stats(0).name(), "a");
+  EXPECT_EQ(response.stats(0).value(), 1);
+  EXPECT_EQ(response.stats(1).name(), "b");
+  EXPECT_EQ(response.stats(1).value(), 2);
+}
+
+}  // namespace orbit_service_stats_service
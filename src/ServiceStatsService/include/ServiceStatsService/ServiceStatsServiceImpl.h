@@ -0,0 +1,33 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SERVICE_STATS_SERVICE_SERVICE_STATS_SERVICE_IMPL_H_
+#define SERVICE_STATS_SERVICE_SERVICE_STATS_SERVICE_IMPL_H_
+
+#include <grpcpp/grpcpp.h>
+
+#include "GrpcProtos/services.grpc.pb.h"
+#include "GrpcProtos/services.pb.h"
+#include "OrbitBase/StatsRegistry.h"
+
+namespace orbit_service_stats_service {
+
+// Returns the stats currently registered in a StatsRegistry, by default the one of the process.
+class ServiceStatsServiceImpl final : public orbit_grpc_protos::ServiceStatsService::Service {
+ public:
+  explicit ServiceStatsServiceImpl(
+      const orbit_base::StatsRegistry* registry = &orbit_base::StatsRegistry::GetDefault())
+      : registry_{registry} {}
+
+  grpc::Status GetServiceStats(grpc::ServerContext* context,
+                               const orbit_grpc_protos::GetServiceStatsRequest* request,
+                               orbit_grpc_protos::GetServiceStatsResponse* response) override;
+
+ private:
+  const orbit_base::StatsRegistry* registry_;
+};
+
+}  // namespace orbit_service_stats_service
+
+#endif  // SERVICE_STATS_SERVICE_SERVICE_STATS_SERVICE_IMPL_H_
@@ -8,6 +8,8 @@
 #include <cstdint>
 #include <optional>
 
+#include "OrbitBase/Logging.h"
+
 namespace orbit_statistics {
 
 [[nodiscard]] std::optional<DataSet> DataSet::Create(absl::Span<const uint64_t> data) {
@@ -17,4 +19,12 @@ namespace orbit_statistics {
   return DataSet(data, *min, *max);
 }
 
+[[nodiscard]] std::optional<DataSet> DataSet::CreateFromSortedData(
+    absl::Span<const uint64_t> sorted_data) {
+  if (sorted_data.empty()) return std::nullopt;
+  ORBIT_DCHECK(std::is_sorted(sorted_data.begin(), sorted_data.end()));
+
+  return DataSet(sorted_data, sorted_data.front(), sorted_data.back());
+}
+
 }  // namespace orbit_statistics
\ No newline at end of file
@@ -21,20 +21,20 @@ constexpr uint32_t kNumberOfBinsGridSize = 12;
 constexpr size_t kLargeNumberOfBins = 2048;  // 2^11, not necessarily 2^(kNumberOfBinsGridSize-1)
 constexpr uint32_t kVeryLargeDatasetThreshold = 10'000'000;
 
-static Histogram BuildHistogramWithNumberOfBins(const std::optional<DataSet>& data_set,
-                                                size_t number_of_bins) {
-  uint64_t bin_width = NumberOfBinsToBinWidth(data_set.value(), number_of_bins);
-  return BuildHistogram(data_set.value(), bin_width);
-}
+using BuildHistogramWithBinWidth = Histogram (*)(const DataSet& data_set, uint64_t bin_width);
 
-[[nodiscard]] std::optional<Histogram> BuildHistogram(absl::Span<const uint64_t> data) {
-  std::optional<DataSet> data_set = DataSet::Create(data);
-  if (!data_set.has_value()) return std::nullopt;
+static Histogram BuildHistogramWithNumberOfBins(const DataSet& data_set, size_t number_of_bins,
+                                                BuildHistogramWithBinWidth build_histogram) {
+  uint64_t bin_width = NumberOfBinsToBinWidth(data_set, number_of_bins);
+  return build_histogram(data_set, bin_width);
+}
 
+[[nodiscard]] static Histogram BuildBestHistogram(const DataSet& data_set,
+                                                  BuildHistogramWithBinWidth build_histogram) {
   // if the data set is extremely large, we surely have enough data
   // to populate the maximal number of bins.
-  if (data_set->GetData().size() > kVeryLargeDatasetThreshold) {
-    return BuildHistogramWithNumberOfBins(data_set, kLargeNumberOfBins);
+  if (data_set.GetData().size() > kVeryLargeDatasetThreshold) {
+    return BuildHistogramWithNumberOfBins(data_set, kLargeNumberOfBins, build_histogram);
   }
 
   size_t number_of_bins = 1;
@@ -42,7 +42,7 @@ static Histogram BuildHistogramWithNumberOfBins(const std::optional<DataSet>& da
   Histogram best_histogram;
 
   for (uint32_t i = 0; i < kNumberOfBinsGridSize; ++i) {
-    Histogram histogram = BuildHistogramWithNumberOfBins(data_set, number_of_bins);
+    Histogram histogram = BuildHistogramWithNumberOfBins(data_set, number_of_bins, build_histogram);
     double risk_score = HistogramRiskScore(histogram);
     if (risk_score < best_risk_score) {
       best_risk_score = risk_score;
@@ -54,4 +54,19 @@ static Histogram BuildHistogramWithNumberOfBins(const std::optional<DataSet>& da
   return best_histogram;
 }
 
+[[nodiscard]] std::optional<Histogram> BuildHistogram(absl::Span<const uint64_t> data) {
+  std::optional<DataSet> data_set = DataSet::Create(data);
+  if (!data_set.has_value()) return std::nullopt;
+
+  return BuildBestHistogram(data_set.value(), &BuildHistogram);
+}
+
+[[nodiscard]] std::optional<Histogram> BuildHistogramFromSortedData(
+    absl::Span<const uint64_t> sorted_data) {
+  std::optional<DataSet> data_set = DataSet::CreateFromSortedData(sorted_data);
+  if (!data_set.has_value()) return std::nullopt;
+
+  return BuildBestHistogram(data_set.value(), &BuildHistogramFromSortedData);
+}
+
 }  // namespace orbit_statistics
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <limits>
 #include <numeric>
 #include <optional>
 #include <vector>
@@ -87,6 +88,43 @@ TEST(HistogramUtils, TestBuildHistogramCountsAllEqualDataElements) {
   EXPECT_EQ(histogram.counts[0], singular_dataset_size);
 }
 
+TEST(DataSet, TestCreateDataSetFromSortedData) {
+  std::vector<uint64_t> sorted_data = raw_data_set;
+  std::sort(sorted_data.begin(), sorted_data.end());
+  const std::optional<DataSet> data_set = DataSet::CreateFromSortedData(sorted_data);
+  ASSERT_TRUE(data_set.has_value());
+  EXPECT_EQ(data_set->GetMin(), kMin);
+  EXPECT_EQ(data_set->GetMax(), kMax);
+
+  EXPECT_FALSE(DataSet::CreateFromSortedData({}).has_value());
+}
+
+static void ExpectHistogramsEq(const Histogram& actual, const Histogram& expected) {
+  EXPECT_EQ(actual.min, expected.min);
+  EXPECT_EQ(actual.max, expected.max);
+  EXPECT_EQ(actual.bin_width, expected.bin_width);
+  EXPECT_EQ(actual.data_set_size, expected.data_set_size);
+  EXPECT_EQ(actual.counts, expected.counts);
+}
+
+TEST(HistogramUtils, BuildHistogramFromSortedDataMatchesBuildHistogram) {
+  std::vector<uint64_t> sorted_data = raw_data_set;
+  std::sort(sorted_data.begin(), sorted_data.end());
+  const std::optional<DataSet> data_set = DataSet::CreateFromSortedData(sorted_data);
+  ASSERT_TRUE(data_set.has_value());
+
+  for (const uint64_t bin_width : {uint64_t{1}, uint64_t{3}, kBinWidth, kMax - kMin, kMax}) {
+    ExpectHistogramsEq(BuildHistogramFromSortedData(data_set.value(), bin_width),
+                       BuildHistogram(data_set.value(), bin_width));
+  }
+
+  const std::vector<uint64_t> singular_data(10, std::numeric_limits<uint64_t>::max());
+  const std::optional<DataSet> singular_data_set = DataSet::CreateFromSortedData(singular_data);
+  ASSERT_TRUE(singular_data_set.has_value());
+  ExpectHistogramsEq(BuildHistogramFromSortedData(singular_data_set.value(), kBinWidth),
+                     BuildHistogram(singular_data_set.value(), kBinWidth));
+}
+
 static uint64_t NumberOfBinsToBinWidthHelper(size_t bins_num, uint64_t max, uint64_t min) {
   const std::vector<uint64_t> raw_data = {max, min};
   const auto data_set = DataSet::Create(absl::MakeSpan(raw_data));
@@ -169,4 +207,20 @@ TEST(Histogram, BuildHistogramCorrectlyChoosesTheBinWidth) {
   EXPECT_EQ(hist->counts.size(), 128);
 }
 
+TEST(Histogram, BuildHistogramFromSortedDataMatchesBuildHistogram) {
+  std::vector<uint64_t> data;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    data.push_back((i * i) % 997 + 10 * i);
+  }
+  std::sort(data.begin(), data.end());
+
+  const std::optional<Histogram> expected = BuildHistogram(data);
+  const std::optional<Histogram> actual = BuildHistogramFromSortedData(data);
+  ASSERT_TRUE(expected.has_value());
+  ASSERT_TRUE(actual.has_value());
+  ExpectHistogramsEq(actual.value(), expected.value());
+
+  EXPECT_FALSE(BuildHistogramFromSortedData({}).has_value());
+}
+
 }  // namespace orbit_statistics
\ No newline at end of file
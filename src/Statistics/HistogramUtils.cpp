@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <numeric>
 #include <utility>
 #include <vector>
@@ -55,4 +56,20 @@ namespace orbit_statistics {
           std::move(counts)};
 }
 
+[[nodiscard]] Histogram BuildHistogramFromSortedData(const DataSet& data_set, uint64_t bin_width) {
+  const size_t bin_num = ValueToHistogramBinIndex(data_set.GetMax(), data_set, bin_width) + 1;
+  const absl::Span<const uint64_t> data = data_set.GetData();
+  std::vector<size_t> counts(bin_num, 0UL);
+  auto bin_begin = data.begin();
+  // The upper bound of every bin but the last is at most `GetMax()`, so it can't overflow.
+  for (size_t i = 0; i + 1 < bin_num; ++i) {
+    const uint64_t next_bin_min = data_set.GetMin() + (i + 1) * bin_width;
+    const auto bin_end = std::lower_bound(bin_begin, data.end(), next_bin_min);
+    counts[i] = std::distance(bin_begin, bin_end);
+    bin_begin = bin_end;
+  }
+  counts.back() = std::distance(bin_begin, data.end());
+  return {data_set.GetMin(), data_set.GetMax(), bin_width, data.size(), std::move(counts)};
+}
+
 }  // namespace orbit_statistics
\ No newline at end of file
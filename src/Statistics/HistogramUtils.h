@@ -27,6 +27,10 @@ namespace orbit_statistics {
 
 [[nodiscard]] Histogram BuildHistogram(const DataSet& data_set, uint64_t bin_width);
 
+// Same as `BuildHistogram`, but the data of `data_set` has to be sorted. Then each bin is counted
+// with a binary search, so the cost depends on the number of bins rather than on the data size.
+[[nodiscard]] Histogram BuildHistogramFromSortedData(const DataSet& data_set, uint64_t bin_width);
+
 }  // namespace orbit_statistics
 
 #endif /* STATISTICS_HISTOGRAM_UTILS_H_ */
@@ -0,0 +1,94 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "Statistics/LogLinearHistogram.h"
+
+#include <absl/numeric/bits.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "OrbitBase/Logging.h"
+
+namespace orbit_statistics {
+
+constexpr uint64_t kSubBucketCount = uint64_t{1} << LogLinearHistogram::kSubBucketBits;
+
+size_t LogLinearHistogram::GetBucketIndex(uint64_t value) {
+  if (value < kSubBucketCount) return value;
+  // The kSubBucketBits bits after the most significant one select the bucket within [2^e, 2^(e+1)).
+  const int shift = absl::bit_width(value) - 1 - static_cast<int>(kSubBucketBits);
+  return (shift + 1) * kSubBucketCount + ((value >> shift) - kSubBucketCount);
+}
+
+uint64_t LogLinearHistogram::GetBucketLowerBound(size_t bucket_index) {
+  if (bucket_index < kSubBucketCount) return bucket_index;
+  const size_t shift = bucket_index / kSubBucketCount - 1;
+  return (kSubBucketCount + bucket_index % kSubBucketCount) << shift;
+}
+
+uint64_t LogLinearHistogram::GetBucketUpperBound(size_t bucket_index) {
+  if (bucket_index < kSubBucketCount) return bucket_index;
+  const size_t shift = bucket_index / kSubBucketCount - 1;
+  return GetBucketLowerBound(bucket_index) + ((uint64_t{1} << shift) - 1);
+}
+
+void LogLinearHistogram::ExtendBuckets(size_t bucket_begin, size_t bucket_end) {
+  if (bucket_counts_.empty()) {
+    first_bucket_index_ = bucket_begin;
+    bucket_counts_.resize(bucket_end - bucket_begin);
+    return;
+  }
+  if (bucket_begin < first_bucket_index_) {
+    bucket_counts_.insert(bucket_counts_.begin(), first_bucket_index_ - bucket_begin, 0);
+    first_bucket_index_ = bucket_begin;
+  }
+  if (bucket_end > first_bucket_index_ + bucket_counts_.size()) {
+    bucket_counts_.resize(bucket_end - first_bucket_index_);
+  }
+}
+
+void LogLinearHistogram::Add(uint64_t value) {
+  const size_t bucket_index = GetBucketIndex(value);
+  ExtendBuckets(bucket_index, bucket_index + 1);
+  ++bucket_counts_[bucket_index - first_bucket_index_];
+  ++count_;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+}
+
+void LogLinearHistogram::Merge(const LogLinearHistogram& other) {
+  if (other.count_ == 0) return;
+  ExtendBuckets(other.first_bucket_index_,
+                other.first_bucket_index_ + other.bucket_counts_.size());
+  for (size_t i = 0; i < other.bucket_counts_.size(); ++i) {
+    bucket_counts_[other.first_bucket_index_ - first_bucket_index_ + i] += other.bucket_counts_[i];
+  }
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+uint64_t LogLinearHistogram::ComputeQuantile(double quantile) const {
+  ORBIT_CHECK(quantile >= 0.0 && quantile <= 1.0);
+  if (count_ == 0) return 0;
+
+  // The rank, starting from 1, of the value to find.
+  const auto rank = std::max(
+      uint64_t{1}, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count_))));
+  if (rank == 1) return min_;
+  if (rank >= count_) return max_;
+  uint64_t count_so_far = 0;
+  for (size_t i = 0; i < bucket_counts_.size(); ++i) {
+    count_so_far += bucket_counts_[i];
+    if (count_so_far < rank) continue;
+    const size_t bucket_index = first_bucket_index_ + i;
+    const uint64_t lower_bound = GetBucketLowerBound(bucket_index);
+    const uint64_t middle = lower_bound + (GetBucketUpperBound(bucket_index) - lower_bound) / 2;
+    return std::clamp(middle, min_, max_);
+  }
+  return max_;
+}
+
+}  // namespace orbit_statistics
@@ -0,0 +1,86 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Statistics/LogLinearHistogram.h"
+
+namespace orbit_statistics {
+
+TEST(LogLinearHistogram, EmptyHistogramHasZeroQuantiles) {
+  LogLinearHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.ComputeQuantile(0.5), 0);
+}
+
+TEST(LogLinearHistogram, SmallValuesAreExact) {
+  LogLinearHistogram histogram;
+  for (uint64_t value = 1; value <= 50; ++value) histogram.Add(value);
+
+  EXPECT_EQ(histogram.count(), 50);
+  EXPECT_EQ(histogram.ComputeQuantile(0.0), 1);
+  EXPECT_EQ(histogram.ComputeQuantile(0.02), 1);
+  EXPECT_EQ(histogram.ComputeQuantile(0.5), 25);
+  EXPECT_EQ(histogram.ComputeQuantile(0.9), 45);
+  EXPECT_EQ(histogram.ComputeQuantile(1.0), 50);
+}
+
+TEST(LogLinearHistogram, QuantilesAreWithinTheMinAndTheMax) {
+  LogLinearHistogram histogram;
+  histogram.Add(1'000'001);
+  histogram.Add(1'000'003);
+
+  EXPECT_EQ(histogram.ComputeQuantile(0.0), 1'000'001);
+  EXPECT_EQ(histogram.ComputeQuantile(1.0), 1'000'003);
+}
+
+TEST(LogLinearHistogram, QuantilesHaveBoundedRelativeError) {
+  std::mt19937_64 random_engine(42);
+  std::lognormal_distribution<double> distribution(13.0, 2.0);
+  std::vector<uint64_t> values;
+  LogLinearHistogram histogram;
+  for (size_t i = 0; i < 10'000; ++i) {
+    const auto value = static_cast<uint64_t>(distribution(random_engine));
+    values.push_back(value);
+    histogram.Add(value);
+  }
+  std::sort(values.begin(), values.end());
+
+  const double max_relative_error = std::ldexp(1.0, -(LogLinearHistogram::kSubBucketBits + 1));
+  for (double quantile : {0.0, 0.01, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 1.0}) {
+    const auto rank = std::max(size_t{1}, static_cast<size_t>(std::ceil(quantile * values.size())));
+    const auto expected = static_cast<double>(values[rank - 1]);
+    EXPECT_LE(std::abs(histogram.ComputeQuantile(quantile) - expected),
+              expected * max_relative_error)
+        << "quantile: " << quantile;
+  }
+}
+
+TEST(LogLinearHistogram, MergeIsTheSameAsAddingAllValues) {
+  LogLinearHistogram first;
+  LogLinearHistogram second;
+  LogLinearHistogram all;
+  for (uint64_t value = 1; value < 100'000; value = value * 3 / 2 + 1) {
+    first.Add(value * 7);
+    second.Add(value);
+    all.Add(value * 7);
+    all.Add(value);
+  }
+  second.Merge(LogLinearHistogram{});
+  second.Merge(first);
+
+  EXPECT_EQ(second.count(), all.count());
+  for (double quantile : {0.0, 0.1, 0.5, 0.9, 0.99, 1.0}) {
+    EXPECT_EQ(second.ComputeQuantile(quantile), all.ComputeQuantile(quantile));
+  }
+}
+
+}  // namespace orbit_statistics
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/types/span.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <stddef.h>
@@ -18,6 +19,8 @@
 namespace orbit_statistics {
 
 using testing::DoubleNear;
+using testing::ElementsAre;
+using testing::IsEmpty;
 using testing::SizeIs;
 
 using orbit_test_utils::MakeMap;
@@ -80,4 +83,15 @@ TEST(MultiplicityCorrection, HolmBonferroniCorrectionIsCorrect) {
       std::vector<double>{0, 0, 0, 0.05, 1, 1, 1}, std::vector<double>{0, 0, 0, 0.2, 1, 1, 1});
 }
 
+TEST(MultiplicityCorrection, SpanCorrectionsKeepTheOrderOfThePvalues) {
+  constexpr double kTolerance = 1e-3;
+  EXPECT_THAT(BonferroniCorrection(kPvalues),
+              ElementsAre(DoubleNear(0.4, kTolerance), DoubleNear(0.8, kTolerance),
+                          DoubleNear(1.2, kTolerance), DoubleNear(0.08, kTolerance)));
+  EXPECT_THAT(HolmBonferroniCorrection(kPvalues),
+              ElementsAre(DoubleNear(0.30, kTolerance), DoubleNear(0.40, kTolerance),
+                          DoubleNear(0.40, kTolerance), DoubleNear(0.08, kTolerance)));
+  EXPECT_THAT(HolmBonferroniCorrection(absl::Span<const double>{}), IsEmpty());
+}
+
 }  // namespace orbit_statistics
\ No newline at end of file
@@ -18,6 +18,9 @@ namespace orbit_statistics {
 class DataSet {
  public:
   [[nodiscard]] static std::optional<DataSet> Create(absl::Span<const uint64_t> data);
+  // `sorted_data` has to be sorted in ascending order. Doesn't scan the data for min and max.
+  [[nodiscard]] static std::optional<DataSet> CreateFromSortedData(
+      absl::Span<const uint64_t> sorted_data);
 
   [[nodiscard]] absl::Span<const uint64_t> GetData() const { return data_; }
   [[nodiscard]] uint64_t GetMin() const { return min_; }
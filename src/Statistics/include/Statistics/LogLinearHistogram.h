@@ -0,0 +1,55 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef STATISTICS_LOG_LINEAR_HISTOGRAM_H_
+#define STATISTICS_LOG_LINEAR_HISTOGRAM_H_
+
+#include <stddef.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace orbit_statistics {
+
+// A streaming histogram of `uint64_t` values, e.g. durations in nanoseconds, whose buckets grow
+// with the values, like in an HDR histogram: values below 2^(kSubBucketBits + 1) have a bucket
+// each, and every larger range [2^e, 2^(e+1)) is split into 2^kSubBucketBits buckets of equal
+// width. So quantiles are estimated with a relative error of at most 2^-(kSubBucketBits + 1),
+// adding a value is constant time, and only the buckets between the smallest and the largest value
+// are stored.
+// Histograms can be merged, and the result is the same as adding all values to one histogram.
+class LogLinearHistogram {
+ public:
+  static constexpr uint32_t kSubBucketBits = 5;
+
+  void Add(uint64_t value);
+  void Merge(const LogLinearHistogram& other);
+
+  [[nodiscard]] uint64_t count() const { return count_; }
+
+  // Returns an estimate of the smallest value such that at least a fraction `quantile` of the
+  // values are not greater, e.g. the median for 0.5. `quantile` must be in [0, 1]. The smallest and
+  // the largest value are exact; otherwise the estimate is the middle of the bucket of that value,
+  // within the minimum and the maximum value. Returns 0 if the histogram is empty.
+  [[nodiscard]] uint64_t ComputeQuantile(double quantile) const;
+
+ private:
+  [[nodiscard]] static size_t GetBucketIndex(uint64_t value);
+  [[nodiscard]] static uint64_t GetBucketLowerBound(size_t bucket_index);
+  [[nodiscard]] static uint64_t GetBucketUpperBound(size_t bucket_index);
+  // Makes `bucket_counts_` cover [bucket_begin, bucket_end).
+  void ExtendBuckets(size_t bucket_begin, size_t bucket_end);
+
+  uint64_t count_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+  // bucket_counts_[i] counts the values of bucket `first_bucket_index_ + i`.
+  size_t first_bucket_index_ = 0;
+  std::vector<uint64_t> bucket_counts_;
+};
+
+}  // namespace orbit_statistics
+
+#endif  // STATISTICS_LOG_LINEAR_HISTOGRAM_H_
@@ -6,9 +6,12 @@
 #define STATISTICS_MULTIPLICITY_CORRECTION_H_
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/types/span.h>
+#include <stddef.h>
 
 #include <algorithm>
 #include <iterator>
+#include <numeric>
 #include <utility>
 #include <vector>
 
@@ -29,6 +32,15 @@ namespace orbit_statistics {
 
 // The simplest correction known in the literature. Very easy to reason about. Shouldn't be used
 // but for testing or for lack of a better alternative.
+// The corrected pvalues are returned in the order of `pvalues`.
+[[nodiscard]] inline std::vector<double> BonferroniCorrection(absl::Span<const double> pvalues) {
+  std::vector<double> corrected(pvalues.size());
+  const double correcting_multiplier = pvalues.size();
+  std::transform(std::begin(pvalues), std::end(pvalues), std::begin(corrected),
+                 [correcting_multiplier](double pvalue) { return pvalue * correcting_multiplier; });
+  return corrected;
+}
+
 template <typename K>
 [[nodiscard]] absl::flat_hash_map<K, double> BonferroniCorrection(
     const absl::flat_hash_map<K, double>& pvalues) {
@@ -42,22 +54,47 @@ template <typename K>
 }
 
 // A practical correction (unlike Bonferroni).
-template <typename K>
-[[nodiscard]] absl::flat_hash_map<K, double> HolmBonferroniCorrection(
-    const absl::flat_hash_map<K, double>& pvalues) {
-  std::vector<std::pair<K, double>> corrected_pvalues(std::begin(pvalues), std::end(pvalues));
-  orbit_base::sort(std::begin(corrected_pvalues), std::end(corrected_pvalues),
-                   &std::pair<K, double>::second);
+// The corrected pvalues are returned in the order of `pvalues`. Only the indices are sorted, so
+// neither the pvalues nor any keys associated with them are copied around.
+[[nodiscard]] inline std::vector<double> HolmBonferroniCorrection(
+    absl::Span<const double> pvalues) {
+  std::vector<size_t> indices_by_pvalue(pvalues.size());
+  std::iota(std::begin(indices_by_pvalue), std::end(indices_by_pvalue), 0);
+  orbit_base::sort(std::begin(indices_by_pvalue), std::end(indices_by_pvalue),
+                   [pvalues](size_t index) { return pvalues[index]; });
 
+  std::vector<double> corrected(pvalues.size());
   size_t correcting_multiplier = pvalues.size();
   double max_corrected_pvalue = 0.0;
-  for (auto& [unused_key, pvalue] : corrected_pvalues) {
-    pvalue = std::max(max_corrected_pvalue, pvalue * correcting_multiplier);
+  for (const size_t index : indices_by_pvalue) {
+    double pvalue = std::max(max_corrected_pvalue, pvalues[index] * correcting_multiplier);
     pvalue = std::min(pvalue, 1.0);
+    corrected[index] = pvalue;
     max_corrected_pvalue = pvalue;
     --correcting_multiplier;
-  };
-  return {std::begin(corrected_pvalues), std::end(corrected_pvalues)};
+  }
+  return corrected;
+}
+
+template <typename K>
+[[nodiscard]] absl::flat_hash_map<K, double> HolmBonferroniCorrection(
+    const absl::flat_hash_map<K, double>& pvalues) {
+  std::vector<const K*> keys;
+  keys.reserve(pvalues.size());
+  std::vector<double> values;
+  values.reserve(pvalues.size());
+  for (const auto& [key, pvalue] : pvalues) {
+    keys.push_back(&key);
+    values.push_back(pvalue);
+  }
+
+  const std::vector<double> corrected = HolmBonferroniCorrection(absl::MakeConstSpan(values));
+  absl::flat_hash_map<K, double> key_to_corrected;
+  key_to_corrected.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    key_to_corrected.try_emplace(*keys[i], corrected[i]);
+  }
+  return key_to_corrected;
 }
 
 }  // namespace orbit_statistics
@@ -4,48 +4,123 @@
 
 #include "StringManager/StringManager.h"
 
-#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
 #include <absl/synchronization/mutex.h>
+#include <string.h>
 
+#include <algorithm>
 #include <utility>
 
 #include "OrbitBase/Logging.h"
 
 namespace orbit_string_manager {
 
+namespace {
+
+// Must be a power of two.
+constexpr size_t kInitialTableCapacity = 256;
+constexpr size_t kStringChunkSize = 64 * 1024;
+
+}  // namespace
+
+StringManager::StringManager() {
+  absl::MutexLock lock{&mutex_};
+  tables_.push_back(std::make_unique<Table>(kInitialTableCapacity));
+  current_table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+std::atomic<const StringManager::Entry*>& StringManager::FindSlot(const Table& table,
+                                                                  uint64_t key) {
+  // The table is never more than half full, so this always finds an empty slot eventually.
+  for (size_t i = absl::Hash<uint64_t>{}(key) & table.mask;; i = (i + 1) & table.mask) {
+    const Entry* entry = table.slots[i].load(std::memory_order_acquire);
+    if (entry == nullptr || entry->key == key) return table.slots[i];
+  }
+}
+
+const StringManager::Entry* StringManager::Find(uint64_t key) const {
+  const Table* table = current_table_.load(std::memory_order_acquire);
+  return FindSlot(*table, key).load(std::memory_order_acquire);
+}
+
+const StringManager::Entry* StringManager::CreateEntry(uint64_t key, std::string_view str) {
+  if (str.size() > current_chunk_remaining_size_) {
+    const size_t chunk_size = std::max(str.size(), kStringChunkSize);
+    string_chunks_.push_back(std::make_unique<char[]>(chunk_size));
+    current_chunk_position_ = string_chunks_.back().get();
+    current_chunk_remaining_size_ = chunk_size;
+  }
+  if (!str.empty()) memcpy(current_chunk_position_, str.data(), str.size());
+  std::string_view value{current_chunk_position_, str.size()};
+  current_chunk_position_ += str.size();
+  current_chunk_remaining_size_ -= str.size();
+  return &entries_.emplace_back(Entry{key, value});
+}
+
+void StringManager::GrowTableIfNeeded() {
+  const Table& table = *tables_.back();
+  const size_t capacity = table.mask + 1;
+  if (2 * (num_keys_ + 1) <= capacity) return;
+
+  auto new_table = std::make_unique<Table>(2 * capacity);
+  for (size_t i = 0; i < capacity; ++i) {
+    const Entry* entry = table.slots[i].load(std::memory_order_relaxed);
+    if (entry == nullptr) continue;
+    FindSlot(*new_table, entry->key).store(entry, std::memory_order_relaxed);
+  }
+  // The previous tables stay alive, as lookups might still be probing them.
+  tables_.push_back(std::move(new_table));
+  current_table_.store(tables_.back().get(), std::memory_order_release);
+}
+
 // TODO(b/181207737): Make this assert that it is not present and rename to "Add".
 bool StringManager::AddIfNotPresent(uint64_t key, std::string_view str) {
   absl::MutexLock lock{&mutex_};
-  bool inserted = key_to_string_.emplace(key, str).second;
-  if (!inserted) {
+  GrowTableIfNeeded();
+  std::atomic<const Entry*>& slot = FindSlot(*tables_.back(), key);
+  if (slot.load(std::memory_order_relaxed) != nullptr) {
     ORBIT_ERROR("String collision for key: %u and string: %s", key, str);
+    return false;
   }
-  return inserted;
+  slot.store(CreateEntry(key, str), std::memory_order_release);
+  ++num_keys_;
+  return true;
 }
 
 bool StringManager::AddOrReplace(uint64_t key, std::string_view str) {
   absl::MutexLock lock{&mutex_};
-  bool inserted = key_to_string_.insert_or_assign(key, str).second;
+  GrowTableIfNeeded();
+  std::atomic<const Entry*>& slot = FindSlot(*tables_.back(), key);
+  const bool inserted = slot.load(std::memory_order_relaxed) == nullptr;
+  slot.store(CreateEntry(key, str), std::memory_order_release);
+  if (inserted) ++num_keys_;
   return inserted;
 }
 
 std::optional<std::string> StringManager::Get(uint64_t key) const {
-  absl::MutexLock lock{&mutex_};
-  auto it = key_to_string_.find(key);
-  if (it != key_to_string_.end()) {
-    return it->second;
-  }
-  return std::nullopt;
+  std::optional<std::string_view> value = GetView(key);
+  if (!value.has_value()) return std::nullopt;
+  return std::string{value.value()};
 }
 
-bool StringManager::Contains(uint64_t key) const {
-  absl::MutexLock lock{&mutex_};
-  return key_to_string_.contains(key);
+std::optional<std::string_view> StringManager::GetView(uint64_t key) const {
+  const Entry* entry = Find(key);
+  if (entry == nullptr) return std::nullopt;
+  return entry->value;
 }
 
+bool StringManager::Contains(uint64_t key) const { return Find(key) != nullptr; }
+
 void StringManager::Clear() {
   absl::MutexLock lock{&mutex_};
-  key_to_string_.clear();
+  tables_.clear();
+  tables_.push_back(std::make_unique<Table>(kInitialTableCapacity));
+  current_table_.store(tables_.back().get(), std::memory_order_release);
+  num_keys_ = 0;
+  entries_.clear();
+  string_chunks_.clear();
+  current_chunk_position_ = nullptr;
+  current_chunk_remaining_size_ = 0;
 }
 
 }  // namespace orbit_string_manager
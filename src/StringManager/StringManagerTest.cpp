@@ -4,8 +4,12 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
 
 #include "StringManager/StringManager.h"
 
@@ -59,4 +63,75 @@ TEST(StringManager, Clear) {
   EXPECT_FALSE(string_manager.Contains(1));
 }
 
+TEST(StringManager, GetView) {
+  StringManager string_manager;
+  string_manager.AddIfNotPresent(0, "test1");
+
+  EXPECT_EQ(string_manager.GetView(0).value_or("no value"), "test1");
+  EXPECT_FALSE(string_manager.GetView(1).has_value());
+}
+
+TEST(StringManager, ViewsStayValidWhenReplacingAndGrowing) {
+  StringManager string_manager;
+  string_manager.AddIfNotPresent(0, "test1");
+  std::optional<std::string_view> view = string_manager.GetView(0);
+  ASSERT_TRUE(view.has_value());
+
+  string_manager.AddOrReplace(0, "test2");
+  constexpr uint64_t kNumKeys = 10'000;
+  for (uint64_t key = 1; key < kNumKeys; ++key) {
+    EXPECT_TRUE(string_manager.AddIfNotPresent(key, std::to_string(key)));
+  }
+
+  EXPECT_EQ(view.value(), "test1");
+  EXPECT_EQ(string_manager.GetView(0).value_or("no value"), "test2");
+  for (uint64_t key = 1; key < kNumKeys; ++key) {
+    EXPECT_EQ(string_manager.Get(key).value_or("no value"), std::to_string(key));
+  }
+}
+
+TEST(StringManager, EmptyAndLongStrings) {
+  StringManager string_manager;
+  const std::string long_string(1'000'000, 'a');
+  string_manager.AddIfNotPresent(0, "");
+  string_manager.AddIfNotPresent(1, long_string);
+
+  EXPECT_EQ(string_manager.Get(0).value_or("no value"), "");
+  EXPECT_EQ(string_manager.Get(1).value_or("no value"), long_string);
+}
+
+TEST(StringManager, ConcurrentReadsAndWrites) {
+  StringManager string_manager;
+  constexpr uint64_t kNumKeys = 10'000;
+  std::atomic<uint64_t> num_added_keys = 0;
+
+  std::thread writer{[&] {
+    for (uint64_t key = 0; key < kNumKeys; ++key) {
+      string_manager.AddIfNotPresent(key, std::to_string(key));
+      num_added_keys.store(key + 1, std::memory_order_release);
+    }
+  }};
+
+  uint64_t num_keys_seen = 0;
+  while (num_keys_seen < kNumKeys) {
+    num_keys_seen = num_added_keys.load(std::memory_order_acquire);
+    if (num_keys_seen == 0) continue;
+    const uint64_t key = num_keys_seen - 1;
+    EXPECT_EQ(string_manager.GetView(key).value_or("no value"), std::to_string(key));
+  }
+  writer.join();
+}
+
+TEST(StringManager, ClearAndAddAgain) {
+  StringManager string_manager;
+  for (uint64_t key = 0; key < 1000; ++key) {
+    string_manager.AddIfNotPresent(key, "test1");
+  }
+  string_manager.Clear();
+  EXPECT_FALSE(string_manager.Contains(0));
+
+  EXPECT_TRUE(string_manager.AddIfNotPresent(0, "test2"));
+  EXPECT_EQ(string_manager.Get(0).value_or("no value"), "test2");
+}
+
 }  // namespace orbit_string_manager
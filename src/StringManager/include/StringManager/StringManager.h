@@ -5,21 +5,31 @@
 #ifndef STRING_MANAGER_STRING_MANAGER_H_
 #define STRING_MANAGER_STRING_MANAGER_H_
 
-#include <absl/container/flat_hash_map.h>
-#include <absl/hash/hash.h>
+#include <absl/base/thread_annotations.h>
 #include <absl/synchronization/mutex.h>
+#include <stddef.h>
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace orbit_string_manager {
 
-// This class is a thread-safe wrapper around `absl::flat_hash_map<uint64_t, std::string>`.
+// This class is a thread-safe map from uint64_t keys to strings. Reads are frequent (for example,
+// for every timer label that is drawn) and writes are rare after the start of a capture, so
+// lookups don't take a lock: they are wait-free probes into an open-addressing hash table, whose
+// slots point to entries that are never modified or freed until `Clear`. Writers are serialized by
+// a mutex. When the table gets too full, writers publish a larger copy and keep the old one alive
+// for the lookups that might still be using it. Replacing a value appends a new entry, so the
+// storage of the previous value stays valid as well.
 class StringManager {
  public:
-  StringManager() = default;
+  StringManager();
 
   // Returns true if insertion took place.
   bool AddIfNotPresent(uint64_t key, std::string_view str);
@@ -27,13 +37,45 @@ class StringManager {
   bool AddOrReplace(uint64_t key, std::string_view str);
 
   [[nodiscard]] std::optional<std::string> Get(uint64_t key) const;
+  // Like `Get`, but without copying the string. The view stays valid until `Clear` is called, even
+  // if the value for `key` is replaced.
+  [[nodiscard]] std::optional<std::string_view> GetView(uint64_t key) const;
   [[nodiscard]] bool Contains(uint64_t key) const;
 
+  // Invalidates all views returned by `GetView`. Must not be called concurrently with lookups.
   void Clear();
 
  private:
-  absl::flat_hash_map<uint64_t, std::string> key_to_string_;
-  mutable absl::Mutex mutex_;
+  struct Entry {
+    uint64_t key;
+    std::string_view value;
+  };
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : mask{capacity - 1}, slots{std::make_unique<std::atomic<const Entry*>[]>(capacity)} {}
+    size_t mask;
+    std::unique_ptr<std::atomic<const Entry*>[]> slots;
+  };
+
+  [[nodiscard]] const Entry* Find(uint64_t key) const;
+  // Returns the slot that contains the entry for `key`, or the empty slot where it belongs.
+  [[nodiscard]] static std::atomic<const Entry*>& FindSlot(const Table& table, uint64_t key);
+  [[nodiscard]] const Entry* CreateEntry(uint64_t key, std::string_view str)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void GrowTableIfNeeded() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  std::atomic<const Table*> current_table_ = nullptr;
+
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<Table>> tables_ ABSL_GUARDED_BY(mutex_);
+  size_t num_keys_ ABSL_GUARDED_BY(mutex_) = 0;
+  // std::deque doesn't move its elements when growing at the end.
+  std::deque<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Arena for the characters of the values.
+  std::vector<std::unique_ptr<char[]>> string_chunks_ ABSL_GUARDED_BY(mutex_);
+  char* current_chunk_position_ ABSL_GUARDED_BY(mutex_) = nullptr;
+  size_t current_chunk_remaining_size_ ABSL_GUARDED_BY(mutex_) = 0;
 };
 
 }  // namespace orbit_string_manager
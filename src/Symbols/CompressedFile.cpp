@@ -0,0 +1,120 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "Symbols/CompressedFile.h"
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_replace.h>
+#include <absl/time/time.h>
+#include <stddef.h>
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/ThreadUtils.h"
+#include "OrbitBase/UniqueResource.h"
+
+namespace orbit_symbols {
+
+namespace {
+
+constexpr size_t kBufferSize = 1024 * 1024;
+
+// Debug info files are compressed once and transferred often, so a better ratio is worth a slower
+// compression here, as opposed to the streamed capture data.
+constexpr int kCompressionLevel = 6;
+
+[[nodiscard]] ErrorMessage GzipError(gzFile file, std::string_view action,
+                                     const std::filesystem::path& file_path) {
+  int error_number = Z_OK;
+  const char* error_message = gzerror(file, &error_number);
+  return ErrorMessage{
+      absl::StrFormat("Unable to %s \"%s\": %s", action, file_path.string(), error_message)};
+}
+
+}  // namespace
+
+ErrorMessageOr<void> CompressFile(const std::filesystem::path& input_file_path,
+                                  const std::filesystem::path& output_file_path) {
+  OUTCOME_TRY(orbit_base::UniqueFd input_fd, orbit_base::OpenFileForReading(input_file_path));
+
+  const std::string mode = absl::StrFormat("wb%d", kCompressionLevel);
+  orbit_base::unique_resource output_file{gzopen(output_file_path.string().c_str(), mode.c_str()),
+                                          [](gzFile file) {
+                                            if (file != nullptr) gzclose(file);
+                                          }};
+  if (output_file.get() == nullptr) {
+    return ErrorMessage{absl::StrFormat("Unable to open \"%s\" for writing.",
+                                        output_file_path.string())};
+  }
+
+  std::vector<char> buffer(kBufferSize);
+  while (true) {
+    OUTCOME_TRY(size_t bytes_read, orbit_base::ReadFully(input_fd, buffer.data(), buffer.size()));
+    if (bytes_read == 0) break;
+    if (gzwrite(output_file.get(), buffer.data(), static_cast<unsigned>(bytes_read)) !=
+        static_cast<int>(bytes_read)) {
+      return GzipError(output_file.get(), "write", output_file_path);
+    }
+  }
+
+  // Closing flushes the remaining compressed data, so its result needs to be checked.
+  gzFile file = output_file.get();
+  output_file.release();
+  if (gzclose(file) != Z_OK) {
+    return ErrorMessage{absl::StrFormat("Unable to write \"%s\".", output_file_path.string())};
+  }
+  return outcome::success();
+}
+
+ErrorMessageOr<void> DecompressFile(const std::filesystem::path& input_file_path,
+                                    const std::filesystem::path& output_file_path) {
+  orbit_base::unique_resource input_file{gzopen(input_file_path.string().c_str(), "rb"),
+                                         [](gzFile file) {
+                                           if (file != nullptr) gzclose(file);
+                                         }};
+  if (input_file.get() == nullptr) {
+    return ErrorMessage{
+        absl::StrFormat("Unable to open \"%s\" for reading.", input_file_path.string())};
+  }
+  OUTCOME_TRY(orbit_base::UniqueFd output_fd, orbit_base::OpenFileForWriting(output_file_path));
+
+  std::vector<char> buffer(kBufferSize);
+  while (true) {
+    const int bytes_read =
+        gzread(input_file.get(), buffer.data(), static_cast<unsigned>(buffer.size()));
+    if (bytes_read < 0) return GzipError(input_file.get(), "read", input_file_path);
+    if (bytes_read == 0) break;
+    OUTCOME_TRY(orbit_base::WriteFully(output_fd, buffer.data(), bytes_read));
+  }
+  return outcome::success();
+}
+
+ErrorMessageOr<std::filesystem::path> GetOrCreateCompressedCopy(
+    const std::filesystem::path& file_path, const std::filesystem::path& directory) {
+  const std::filesystem::path compressed_file_path =
+      directory / absl::StrCat(absl::StrReplaceAll(file_path.string(), {{"/", "_"}}), ".gz");
+
+  OUTCOME_TRY(const bool compressed_file_exists,
+              orbit_base::FileOrDirectoryExists(compressed_file_path));
+  if (compressed_file_exists) {
+    OUTCOME_TRY(const absl::Time file_date_modified, orbit_base::GetFileDateModified(file_path));
+    OUTCOME_TRY(const absl::Time compressed_file_date_modified,
+                orbit_base::GetFileDateModified(compressed_file_path));
+    if (compressed_file_date_modified >= file_date_modified) return compressed_file_path;
+  }
+
+  OUTCOME_TRY(orbit_base::CreateDirectories(directory));
+  // Written to a temporary file first, so that a concurrent request never gets a partial copy.
+  const std::filesystem::path temporary_file_path = absl::StrFormat(
+      "%s.%u.tmp", compressed_file_path.string(), orbit_base::GetCurrentThreadId());
+  OUTCOME_TRY(CompressFile(file_path, temporary_file_path));
+  OUTCOME_TRY(orbit_base::MoveOrRenameFile(temporary_file_path, compressed_file_path));
+  return compressed_file_path;
+}
+
+}  // namespace orbit_symbols
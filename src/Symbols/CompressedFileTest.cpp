@@ -0,0 +1,74 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/WriteStringToFile.h"
+#include "Symbols/CompressedFile.h"
+#include "TestUtils/TemporaryDirectory.h"
+#include "TestUtils/TestUtils.h"
+
+using orbit_test_utils::HasError;
+using orbit_test_utils::HasNoError;
+using orbit_test_utils::HasValue;
+
+namespace orbit_symbols {
+
+TEST(CompressedFile, CompressAndDecompress) {
+  auto temporary_directory_or_error = orbit_test_utils::TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_directory_or_error, HasNoError());
+  const std::filesystem::path directory =
+      temporary_directory_or_error.value().GetDirectoryPath();
+
+  std::string content;
+  for (int i = 0; i < 100000; ++i) content.append("debug_info ");
+  const std::filesystem::path file_path = directory / "file";
+  ASSERT_THAT(orbit_base::WriteStringToFile(file_path, content), HasNoError());
+
+  const std::filesystem::path compressed_file_path = directory / "file.gz";
+  ASSERT_THAT(CompressFile(file_path, compressed_file_path), HasNoError());
+  ErrorMessageOr<uint64_t> compressed_size = orbit_base::FileSize(compressed_file_path);
+  ASSERT_THAT(compressed_size, HasNoError());
+  EXPECT_LT(compressed_size.value(), content.size() / 10);
+
+  const std::filesystem::path decompressed_file_path = directory / "decompressed";
+  ASSERT_THAT(DecompressFile(compressed_file_path, decompressed_file_path), HasNoError());
+  EXPECT_THAT(orbit_base::ReadFileToString(decompressed_file_path), HasValue(content));
+
+  EXPECT_THAT(CompressFile(directory / "does_not_exist", compressed_file_path), HasError());
+  EXPECT_THAT(DecompressFile(directory / "does_not_exist", decompressed_file_path), HasError());
+}
+
+TEST(CompressedFile, GetOrCreateCompressedCopy) {
+  auto temporary_directory_or_error = orbit_test_utils::TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_directory_or_error, HasNoError());
+  const std::filesystem::path directory =
+      temporary_directory_or_error.value().GetDirectoryPath();
+  const std::filesystem::path file_path = directory / "file.debug";
+  ASSERT_THAT(orbit_base::WriteStringToFile(file_path, "content"), HasNoError());
+
+  const std::filesystem::path compressed_directory = directory / "compressed";
+  ErrorMessageOr<std::filesystem::path> compressed_file_path =
+      GetOrCreateCompressedCopy(file_path, compressed_directory);
+  ASSERT_THAT(compressed_file_path, HasNoError());
+  EXPECT_EQ(compressed_file_path.value().parent_path(), compressed_directory);
+  EXPECT_EQ(compressed_file_path.value().extension(), ".gz");
+
+  // The existing copy is reused.
+  EXPECT_THAT(GetOrCreateCompressedCopy(file_path, compressed_directory),
+              HasValue(compressed_file_path.value()));
+
+  const std::filesystem::path decompressed_file_path = directory / "decompressed";
+  ASSERT_THAT(DecompressFile(compressed_file_path.value(), decompressed_file_path), HasNoError());
+  EXPECT_THAT(orbit_base::ReadFileToString(decompressed_file_path), HasValue("content"));
+}
+
+}  // namespace orbit_symbols
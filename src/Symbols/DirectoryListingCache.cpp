@@ -0,0 +1,69 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "Symbols/DirectoryListingCache.h"
+
+#include <absl/strings/ascii.h>
+
+#include <chrono>
+#include <system_error>
+#include <utility>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Result.h"
+
+namespace fs = std::filesystem;
+
+namespace orbit_symbols {
+
+namespace {
+// Filesystems store modification times with a limited resolution, down to 2 seconds on FAT. A
+// directory which is changed shortly after it got listed might still report the modification time
+// the listing was taken with. So we don't trust listings of directories that changed that recently.
+constexpr std::chrono::seconds kModificationTimeResolution{2};
+
+[[nodiscard]] std::string NormalizeFileName(const fs::path& file_name) {
+#ifdef _WIN32
+  // File names are case-insensitive on Windows.
+  return absl::AsciiStrToLower(file_name.string());
+#else
+  return file_name.string();
+#endif
+}
+}  // namespace
+
+std::vector<fs::path> DirectoryListingCache::FindFileNames(const fs::path& directory,
+                                                           absl::Span<const fs::path> file_names) {
+  std::error_code error;
+  const fs::file_time_type directory_last_write_time = fs::last_write_time(directory, error);
+  if (error) return {file_names.begin(), file_names.end()};
+
+  absl::MutexLock lock{&mutex_};
+  auto listing_it = listings_.find(directory.string());
+  if (listing_it == listings_.end() ||
+      listing_it->second.directory_last_write_time != directory_last_write_time ||
+      listing_it->second.listing_time - directory_last_write_time <= kModificationTimeResolution) {
+    Listing listing{directory_last_write_time, fs::file_time_type::clock::now(), {}};
+    ErrorMessageOr<std::vector<fs::path>> entries = orbit_base::ListFilesInDirectory(directory);
+    if (entries.has_error()) {
+      ORBIT_ERROR("%s", entries.error().message());
+      return {file_names.begin(), file_names.end()};
+    }
+    for (const fs::path& entry : entries.value()) {
+      listing.file_names.insert(NormalizeFileName(entry.filename()));
+    }
+    listing_it = listings_.insert_or_assign(directory.string(), std::move(listing)).first;
+  }
+
+  std::vector<fs::path> result;
+  for (const fs::path& file_name : file_names) {
+    if (listing_it->second.file_names.contains(NormalizeFileName(file_name))) {
+      result.push_back(file_name);
+    }
+  }
+  return result;
+}
+
+}  // namespace orbit_symbols
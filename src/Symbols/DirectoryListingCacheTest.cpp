@@ -0,0 +1,57 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "OrbitBase/WriteStringToFile.h"
+#include "Symbols/DirectoryListingCache.h"
+#include "TestUtils/TemporaryDirectory.h"
+#include "TestUtils/TestUtils.h"
+
+namespace orbit_symbols {
+
+using orbit_test_utils::HasNoError;
+using orbit_test_utils::TemporaryDirectory;
+using testing::ElementsAre;
+
+TEST(DirectoryListingCache, FindFileNames) {
+  auto temporary_dir_or_error = TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_dir_or_error, HasNoError());
+  const TemporaryDirectory temporary_dir = std::move(temporary_dir_or_error.value());
+  const std::filesystem::path& directory = temporary_dir.GetDirectoryPath();
+
+  ASSERT_THAT(orbit_base::WriteStringToFile(directory / "module.debug", "a"), HasNoError());
+  ASSERT_THAT(orbit_base::WriteStringToFile(directory / "module", "b"), HasNoError());
+
+  const std::vector<std::filesystem::path> file_names{"module.debug", "module.so.debug", "module"};
+
+  DirectoryListingCache cache;
+  EXPECT_THAT(cache.FindFileNames(directory, file_names), ElementsAre("module.debug", "module"));
+  // Served from the same listing.
+  EXPECT_THAT(cache.FindFileNames(directory, file_names), ElementsAre("module.debug", "module"));
+
+  // Changes of the directory need to be picked up.
+  ASSERT_THAT(orbit_base::WriteStringToFile(directory / "module.so.debug", "c"), HasNoError());
+  std::error_code error;
+  ASSERT_TRUE(std::filesystem::remove(directory / "module", error)) << error.message();
+
+  EXPECT_THAT(cache.FindFileNames(directory, file_names),
+              ElementsAre("module.debug", "module.so.debug"));
+}
+
+TEST(DirectoryListingCache, FindFileNamesInNonExistingDirectory) {
+  const std::vector<std::filesystem::path> file_names{"module.debug", "module"};
+
+  DirectoryListingCache cache;
+  EXPECT_THAT(cache.FindFileNames("/path/does/not/exist", file_names),
+              ElementsAre("module.debug", "module"));
+}
+
+}  // namespace orbit_symbols
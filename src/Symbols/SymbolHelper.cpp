@@ -39,6 +39,7 @@
 #include "SymbolProvider/StructuredDebugDirectorySymbolProvider.h"
 #include "SymbolProvider/SymbolLoadingOutcome.h"
 #include "Symbols/SymbolUtils.h"
+#include "Symbols/SymbolsCacheFile.h"
 
 using orbit_grpc_protos::ModuleSymbols;
 
@@ -220,8 +221,10 @@ ErrorMessageOr<fs::path> SymbolHelper::FindSymbolsFileLocally(
       search_paths.insert(path);
       continue;
     }
-    for (const auto& filename :
-         orbit_symbols::GetStandardSymbolFilenamesForModule(module_path, object_file_type)) {
+    // Only the candidates that exist in the directory's (cached) listing are worth checking.
+    const std::vector<fs::path> filenames =
+        orbit_symbols::GetStandardSymbolFilenamesForModule(module_path, object_file_type);
+    for (const auto& filename : directory_listing_cache_.FindFileNames(path, filenames)) {
       search_paths.insert(path / filename);
     }
   }
@@ -310,6 +313,38 @@ ErrorMessageOr<ModuleSymbols> SymbolHelper::LoadSymbolsFromFile(
   return symbols_file->LoadDebugSymbols();
 }
 
+ErrorMessageOr<ModuleSymbols> SymbolHelper::LoadSymbolsUsingCache(
+    const fs::path& file_path, std::string_view build_id,
+    const ObjectFileInfo& object_file_info) const {
+  ORBIT_SCOPE_FUNCTION;
+  // Without a build id, the cache file can't be told apart from the one of another build.
+  if (build_id.empty()) return LoadSymbolsFromFile(file_path, object_file_info);
+
+  const fs::path cache_file_path = GenerateSymbolsCacheFilePath(build_id);
+  OUTCOME_TRY(const bool exists, orbit_base::FileOrDirectoryExists(cache_file_path));
+  if (exists) {
+    ORBIT_SCOPED_TIMED_LOG("ReadSymbolsCacheFile: %s", cache_file_path.string());
+    ErrorMessageOr<ModuleSymbols> symbols_or_error =
+        ReadSymbolsCacheFile(cache_file_path, build_id, object_file_info.load_bias);
+    if (symbols_or_error.has_value()) return symbols_or_error;
+    ORBIT_LOG("%s (loading the symbols from \"%s\" instead)", symbols_or_error.error().message(),
+              file_path.string());
+  }
+
+  OUTCOME_TRY(ModuleSymbols symbols, LoadSymbolsFromFile(file_path, object_file_info));
+  ErrorMessageOr<void> write_result =
+      WriteSymbolsCacheFile(cache_file_path, build_id, object_file_info.load_bias, symbols);
+  if (write_result.has_error()) {
+    ORBIT_ERROR("Unable to write symbols cache file \"%s\": %s", cache_file_path.string(),
+                write_result.error().message());
+  }
+  return symbols;
+}
+
+fs::path SymbolHelper::GenerateSymbolsCacheFilePath(std::string_view build_id) const {
+  return cache_directory_ / absl::StrCat(build_id, ".symbols_cache");
+}
+
 ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> SymbolHelper::LoadFallbackSymbolsFromFile(
     const std::filesystem::path& file_path) {
   ORBIT_SCOPE_FUNCTION;
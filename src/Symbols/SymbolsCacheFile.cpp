@@ -0,0 +1,155 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "Symbols/SymbolsCacheFile.h"
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <string>
+#include <type_traits>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/WriteStringToFile.h"
+
+namespace orbit_symbols {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'R', 'B', 'I', 'T', 'S', 'Y', 'M'};
+// Increase whenever the layout of the file or the meaning of its fields changes.
+constexpr uint32_t kVersion = 1;
+
+constexpr uint32_t kIsHotpatchableFlag = 1;
+
+struct Header {
+  char magic[sizeof(kMagic)];
+  uint32_t version;
+  uint32_t build_id_size;
+  uint64_t load_bias;
+  uint64_t num_symbols;
+  uint64_t string_table_size;
+};
+static_assert(sizeof(Header) % 8 == 0);
+
+struct SymbolRecord {
+  uint64_t address;
+  uint64_t size;
+  // Relative to the start of the string table.
+  uint64_t name_offset;
+  uint32_t name_size;
+  uint32_t flags;
+};
+static_assert(sizeof(SymbolRecord) % 8 == 0);
+
+template <typename T>
+void Append(std::string& buffer, const T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+[[nodiscard]] T ReadAt(const std::string& buffer, size_t offset) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  ORBIT_CHECK(offset + sizeof(T) <= buffer.size());
+  T value;
+  memcpy(&value, buffer.data() + offset, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+ErrorMessageOr<void> WriteSymbolsCacheFile(const std::filesystem::path& file_path,
+                                           std::string_view build_id, uint64_t load_bias,
+                                           const orbit_grpc_protos::ModuleSymbols& module_symbols) {
+  std::string string_table{build_id};
+  std::string records;
+  records.reserve(module_symbols.symbol_infos_size() * sizeof(SymbolRecord));
+  for (const orbit_grpc_protos::SymbolInfo& symbol_info : module_symbols.symbol_infos()) {
+    SymbolRecord record{};
+    record.address = symbol_info.address();
+    record.size = symbol_info.size();
+    record.name_offset = string_table.size();
+    record.name_size = static_cast<uint32_t>(symbol_info.demangled_name().size());
+    record.flags = symbol_info.is_hotpatchable() ? kIsHotpatchableFlag : 0;
+    Append(records, record);
+    string_table.append(symbol_info.demangled_name());
+  }
+
+  Header header{};
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.build_id_size = static_cast<uint32_t>(build_id.size());
+  header.load_bias = load_bias;
+  header.num_symbols = module_symbols.symbol_infos_size();
+  header.string_table_size = string_table.size();
+
+  std::string content;
+  content.reserve(sizeof(header) + records.size() + string_table.size());
+  Append(content, header);
+  content.append(records);
+  content.append(string_table);
+
+  // Written to a temporary file first, so that a reader never sees a partially written file.
+  const std::filesystem::path temporary_file_path = absl::StrCat(file_path.string(), ".tmp");
+  OUTCOME_TRY(orbit_base::WriteStringToFile(temporary_file_path, content));
+  return orbit_base::MoveOrRenameFile(temporary_file_path, file_path);
+}
+
+ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> ReadSymbolsCacheFile(
+    const std::filesystem::path& file_path, std::string_view build_id, uint64_t load_bias) {
+  OUTCOME_TRY(std::string content, orbit_base::ReadFileToString(file_path));
+  const std::string error_prefix =
+      absl::StrFormat("Unable to read symbols cache file \"%s\"", file_path.string());
+
+  if (content.size() < sizeof(Header)) {
+    return ErrorMessage{absl::StrCat(error_prefix, ": The file is too small.")};
+  }
+  const auto header = ReadAt<Header>(content, 0);
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+    return ErrorMessage{absl::StrCat(error_prefix, ": Unknown file format or version.")};
+  }
+  const size_t records_offset = sizeof(Header);
+  if (header.num_symbols > (content.size() - records_offset) / sizeof(SymbolRecord)) {
+    return ErrorMessage{absl::StrCat(error_prefix, ": The file is truncated or corrupted.")};
+  }
+  const size_t string_table_offset = records_offset + header.num_symbols * sizeof(SymbolRecord);
+  if (header.string_table_size != content.size() - string_table_offset ||
+      header.build_id_size > header.string_table_size) {
+    return ErrorMessage{absl::StrCat(error_prefix, ": The file is truncated or corrupted.")};
+  }
+  const std::string_view string_table =
+      std::string_view{content}.substr(string_table_offset, header.string_table_size);
+
+  if (string_table.substr(0, header.build_id_size) != build_id) {
+    return ErrorMessage{absl::StrCat(error_prefix, ": The build id does not match.")};
+  }
+  if (header.load_bias != load_bias) {
+    return ErrorMessage{absl::StrFormat("%s: The load bias does not match (expected %#x, got %#x).",
+                                        error_prefix, load_bias, header.load_bias)};
+  }
+
+  orbit_grpc_protos::ModuleSymbols module_symbols;
+  module_symbols.mutable_symbol_infos()->Reserve(static_cast<int>(header.num_symbols));
+  for (size_t i = 0; i < header.num_symbols; ++i) {
+    const auto record = ReadAt<SymbolRecord>(content, records_offset + i * sizeof(SymbolRecord));
+    if (record.name_offset > string_table.size() ||
+        record.name_size > string_table.size() - record.name_offset) {
+      return ErrorMessage{absl::StrCat(error_prefix, ": A symbol name is out of bounds.")};
+    }
+    orbit_grpc_protos::SymbolInfo* symbol_info = module_symbols.add_symbol_infos();
+    symbol_info->set_address(record.address);
+    symbol_info->set_size(record.size);
+    symbol_info->set_demangled_name(
+        std::string{string_table.substr(record.name_offset, record.name_size)});
+    symbol_info->set_is_hotpatchable((record.flags & kIsHotpatchableFlag) != 0);
+  }
+  return module_symbols;
+}
+
+}  // namespace orbit_symbols
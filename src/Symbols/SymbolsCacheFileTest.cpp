@@ -0,0 +1,116 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+
+#include "GrpcProtos/symbol.pb.h"
+#include "ObjectUtils/SymbolsFile.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/Result.h"
+#include "OrbitBase/WriteStringToFile.h"
+#include "Symbols/SymbolHelper.h"
+#include "Symbols/SymbolsCacheFile.h"
+#include "Test/Path.h"
+#include "TestUtils/TemporaryDirectory.h"
+#include "TestUtils/TestUtils.h"
+
+using orbit_grpc_protos::ModuleSymbols;
+using orbit_grpc_protos::SymbolInfo;
+using orbit_test_utils::HasErrorWithMessage;
+using orbit_test_utils::HasNoError;
+using orbit_test_utils::HasValue;
+
+namespace orbit_symbols {
+
+namespace {
+
+void ExpectSymbolsEq(const ModuleSymbols& actual, const ModuleSymbols& expected) {
+  ASSERT_EQ(actual.symbol_infos_size(), expected.symbol_infos_size());
+  for (int i = 0; i < actual.symbol_infos_size(); ++i) {
+    const SymbolInfo& actual_symbol = actual.symbol_infos(i);
+    const SymbolInfo& expected_symbol = expected.symbol_infos(i);
+    EXPECT_EQ(actual_symbol.demangled_name(), expected_symbol.demangled_name());
+    EXPECT_EQ(actual_symbol.address(), expected_symbol.address());
+    EXPECT_EQ(actual_symbol.size(), expected_symbol.size());
+    EXPECT_EQ(actual_symbol.is_hotpatchable(), expected_symbol.is_hotpatchable());
+  }
+}
+
+}  // namespace
+
+TEST(SymbolsCacheFile, WriteAndRead) {
+  auto temporary_directory_or_error = orbit_test_utils::TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_directory_or_error, HasNoError());
+  const std::filesystem::path file_path =
+      temporary_directory_or_error.value().GetDirectoryPath() / "symbols_cache";
+
+  ModuleSymbols symbols;
+  SymbolInfo* symbol = symbols.add_symbol_infos();
+  symbol->set_demangled_name("foo(int)");
+  symbol->set_address(0x1000);
+  symbol->set_size(0x20);
+  symbol = symbols.add_symbol_infos();
+  symbol->set_address(0x1020);
+  symbol->set_size(0x10);
+  symbol->set_is_hotpatchable(true);
+
+  ASSERT_THAT(WriteSymbolsCacheFile(file_path, "build_id", 0x400000, symbols), HasNoError());
+
+  const ErrorMessageOr<ModuleSymbols> read_symbols =
+      ReadSymbolsCacheFile(file_path, "build_id", 0x400000);
+  ASSERT_THAT(read_symbols, HasValue());
+  ExpectSymbolsEq(read_symbols.value(), symbols);
+
+  EXPECT_THAT(ReadSymbolsCacheFile(file_path, "other_build_id", 0x400000),
+              HasErrorWithMessage("The build id does not match"));
+  EXPECT_THAT(ReadSymbolsCacheFile(file_path, "build_id", 0),
+              HasErrorWithMessage("The load bias does not match"));
+
+  ErrorMessageOr<std::string> content = orbit_base::ReadFileToString(file_path);
+  ASSERT_THAT(content, HasNoError());
+  const std::string truncated_content = content.value().substr(0, content.value().size() - 1);
+  ASSERT_THAT(orbit_base::WriteStringToFile(file_path, truncated_content), HasNoError());
+  EXPECT_THAT(ReadSymbolsCacheFile(file_path, "build_id", 0x400000),
+              HasErrorWithMessage("truncated or corrupted"));
+
+  ASSERT_THAT(orbit_base::WriteStringToFile(file_path, "not a symbols cache file"), HasNoError());
+  EXPECT_THAT(ReadSymbolsCacheFile(file_path, "build_id", 0x400000),
+              HasErrorWithMessage("too small"));
+}
+
+TEST(SymbolHelper, LoadSymbolsUsingCache) {
+  auto temporary_directory_or_error = orbit_test_utils::TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_directory_or_error, HasNoError());
+  const SymbolHelper symbol_helper(temporary_directory_or_error.value().GetDirectoryPath(), {});
+  const std::filesystem::path file_path = orbit_test::GetTestdataDir() / "no_symbols_elf.debug";
+  const orbit_object_utils::ObjectFileInfo object_file_info{0x10000};
+  constexpr const char* kBuildId = "b5413574bbacec6eacb3b89b1012d0e2cd92ec6b";
+
+  const ErrorMessageOr<ModuleSymbols> expected_symbols =
+      SymbolHelper::LoadSymbolsFromFile(file_path, object_file_info);
+  ASSERT_THAT(expected_symbols, HasValue());
+
+  const std::filesystem::path cache_file_path =
+      symbol_helper.GenerateSymbolsCacheFilePath(kBuildId);
+  EXPECT_THAT(orbit_base::FileOrDirectoryExists(cache_file_path), HasValue(false));
+
+  const ErrorMessageOr<ModuleSymbols> symbols =
+      symbol_helper.LoadSymbolsUsingCache(file_path, kBuildId, object_file_info);
+  ASSERT_THAT(symbols, HasValue());
+  ExpectSymbolsEq(symbols.value(), expected_symbols.value());
+  EXPECT_THAT(orbit_base::FileOrDirectoryExists(cache_file_path), HasValue(true));
+
+  // The second load reads the cache file, so it also works without the symbols file.
+  const ErrorMessageOr<ModuleSymbols> cached_symbols = symbol_helper.LoadSymbolsUsingCache(
+      orbit_test::GetTestdataDir() / "file_does_not_exist", kBuildId, object_file_info);
+  ASSERT_THAT(cached_symbols, HasValue());
+  ExpectSymbolsEq(cached_symbols.value(), expected_symbols.value());
+}
+
+}  // namespace orbit_symbols
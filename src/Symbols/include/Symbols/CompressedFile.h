@@ -0,0 +1,30 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SYMBOLS_COMPRESSED_FILE_H_
+#define SYMBOLS_COMPRESSED_FILE_H_
+
+#include <filesystem>
+
+#include "OrbitBase/Result.h"
+
+namespace orbit_symbols {
+
+// Writes a gzip compressed copy of input_file_path to output_file_path.
+[[nodiscard]] ErrorMessageOr<void> CompressFile(const std::filesystem::path& input_file_path,
+                                                const std::filesystem::path& output_file_path);
+
+// Writes the decompressed content of the gzip file input_file_path to output_file_path.
+[[nodiscard]] ErrorMessageOr<void> DecompressFile(const std::filesystem::path& input_file_path,
+                                                  const std::filesystem::path& output_file_path);
+
+// Returns the path of a gzip compressed copy of file_path in directory, and creates that copy
+// unless a copy that is newer than file_path already exists. Debug info files are mostly DWARF,
+// which compresses well, so transferring the compressed copy is a lot faster on slow connections.
+[[nodiscard]] ErrorMessageOr<std::filesystem::path> GetOrCreateCompressedCopy(
+    const std::filesystem::path& file_path, const std::filesystem::path& directory);
+
+}  // namespace orbit_symbols
+
+#endif  // SYMBOLS_COMPRESSED_FILE_H_
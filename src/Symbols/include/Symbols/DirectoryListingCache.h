@@ -0,0 +1,48 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SYMBOLS_DIRECTORY_LISTING_CACHE_H_
+#define SYMBOLS_DIRECTORY_LISTING_CACHE_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/types/span.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace orbit_symbols {
+
+// Keeps the names of the entries of directories, so that checking whether a directory contains
+// certain files is done with hash lookups instead of a filesystem call per file. That matters for
+// symbol directories that are network mounts and get asked for the symbol files of hundreds of
+// modules.
+//
+// A listing is refreshed once the modification time of its directory changes, which happens
+// whenever an entry gets added, removed or renamed. The class is thread-safe.
+class DirectoryListingCache {
+ public:
+  // Returns those of `file_names` that are entries of `directory`, in the same order. If the
+  // directory can't be listed, all of `file_names` are returned, so that the caller's own checks
+  // report the problem.
+  [[nodiscard]] std::vector<std::filesystem::path> FindFileNames(
+      const std::filesystem::path& directory, absl::Span<const std::filesystem::path> file_names);
+
+ private:
+  struct Listing {
+    std::filesystem::file_time_type directory_last_write_time;
+    std::filesystem::file_time_type listing_time;
+    absl::flat_hash_set<std::string> file_names;
+  };
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, Listing> listings_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace orbit_symbols
+
+#endif  // SYMBOLS_DIRECTORY_LISTING_CACHE_H_
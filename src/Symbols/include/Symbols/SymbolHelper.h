@@ -22,6 +22,7 @@
 #include "ObjectUtils/SymbolsFile.h"
 #include "OrbitBase/Result.h"
 #include "SymbolProvider/StructuredDebugDirectorySymbolProvider.h"
+#include "Symbols/DirectoryListingCache.h"
 #include "Symbols/SymbolCacheInterface.h"
 
 namespace orbit_symbols {
@@ -49,6 +50,13 @@ class SymbolHelper : public SymbolCacheInterface {
   static ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> LoadSymbolsFromFile(
       const std::filesystem::path& file_path,
       const orbit_object_utils::ObjectFileInfo& object_file_info);
+  // Like LoadSymbolsFromFile, but reads the symbols from the symbols cache file of `build_id` in
+  // the cache directory if there is one, and otherwise writes it after loading the symbols. Reading
+  // the cache file is much faster than parsing the symbols file and demangling its names.
+  [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> LoadSymbolsUsingCache(
+      const std::filesystem::path& file_path, std::string_view build_id,
+      const orbit_object_utils::ObjectFileInfo& object_file_info) const;
+  [[nodiscard]] std::filesystem::path GenerateSymbolsCacheFilePath(std::string_view build_id) const;
   static ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> LoadFallbackSymbolsFromFile(
       const std::filesystem::path& file_path);
 
@@ -68,6 +76,7 @@ class SymbolHelper : public SymbolCacheInterface {
   // TODO(b/246743231): Move this out of SymbolHelper in a next refactoring step.
   std::vector<orbit_symbol_provider::StructuredDebugDirectorySymbolProvider>
       structured_debug_directory_providers_;
+  DirectoryListingCache directory_listing_cache_;
 };
 
 [[nodiscard]] std::vector<std::filesystem::path> ReadSymbolsFile(
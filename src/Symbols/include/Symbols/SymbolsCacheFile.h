@@ -0,0 +1,35 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SYMBOLS_SYMBOLS_CACHE_FILE_H_
+#define SYMBOLS_SYMBOLS_CACHE_FILE_H_
+
+#include <stdint.h>
+
+#include <filesystem>
+#include <string_view>
+
+#include "GrpcProtos/symbol.pb.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_symbols {
+
+// A symbols cache file holds the symbols that were loaded from a symbols file (elf, coff, pdb) in a
+// compact binary format, so that loading them again doesn't need to parse the symbols file and
+// demangle its names. The file starts with a fixed-size header, followed by a fixed-size record per
+// symbol and a string table with the build id and the demangled names the records point into. All
+// records are 8-byte aligned, so the file could also be mapped into memory as it is.
+//
+// The symbols depend on the build id of the module and on the load bias they were loaded with, so
+// both are stored in the header and a cache file is only read if they match.
+ErrorMessageOr<void> WriteSymbolsCacheFile(const std::filesystem::path& file_path,
+                                           std::string_view build_id, uint64_t load_bias,
+                                           const orbit_grpc_protos::ModuleSymbols& module_symbols);
+
+[[nodiscard]] ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> ReadSymbolsCacheFile(
+    const std::filesystem::path& file_path, std::string_view build_id, uint64_t load_bias);
+
+}  // namespace orbit_symbols
+
+#endif  // SYMBOLS_SYMBOLS_CACHE_FILE_H_
@@ -75,7 +75,7 @@ const QRegularExpression kNoEndStringRegex{"(([^\\\\\"]|\\\\.)*\\\\)$"};
 }  // namespace CppRegex
 }  // namespace
 
-Cpp::Cpp() : QSyntaxHighlighter{static_cast<QObject*>(nullptr)} {}
+Cpp::Cpp() : LazySyntaxHighlighter{BlockDependency::kDependsOnPreviousBlock} {}
 
 CppHighlighterState HighlightBlockCpp(
     const QString& code, int previous_block_state,
@@ -138,7 +138,7 @@ CppHighlighterState HighlightBlockCpp(
   return next_block_state;
 }
 
-void Cpp::highlightBlock(const QString& code) {
+void Cpp::HighlightRequestedBlock(const QString& code) {
   setCurrentBlockState(HighlightBlockCpp(
       code, previousBlockState(), [this](int start, int count, const QTextCharFormat& format) {
         setFormat(start, count, format);
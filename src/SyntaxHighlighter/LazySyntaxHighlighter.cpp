@@ -0,0 +1,66 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SyntaxHighlighter/LazySyntaxHighlighter.h"
+
+#include <QTextDocument>
+#include <algorithm>
+
+namespace orbit_syntax_highlighter {
+namespace {
+// This is also the initial state of a QTextBlock. Highlighted blocks have a non-negative state.
+constexpr int kNotHighlightedState = -1;
+constexpr int kHighlightedInitialState = 0;
+}  // namespace
+
+LazySyntaxHighlighter::LazySyntaxHighlighter(BlockDependency block_dependency)
+    : QSyntaxHighlighter{static_cast<QObject*>(nullptr)}, block_dependency_{block_dependency} {}
+
+void LazySyntaxHighlighter::HighlightBlocks(const QTextBlock& first_block,
+                                            const QTextBlock& last_block) {
+  if (document() == nullptr || !first_block.isValid() || !last_block.isValid()) return;
+  if (first_block.document() != document() || last_block.document() != document()) return;
+
+  QTextBlock block = first_block;
+  if (block_dependency_ == BlockDependency::kDependsOnPreviousBlock) {
+    if (first_not_highlighted_block_number_ > last_block.blockNumber()) return;
+    block = document()->findBlockByNumber(first_not_highlighted_block_number_);
+  }
+
+  requested_first_block_number_ = block.blockNumber();
+  requested_last_block_number_ = last_block.blockNumber();
+
+  // Re-highlighting a block continues with the next blocks as long as their state changes, so for
+  // dependent blocks usually a single call highlights the whole requested range.
+  for (; block.isValid() && block.blockNumber() <= requested_last_block_number_;
+       block = block.next()) {
+    if (block.userState() == kNotHighlightedState) rehighlightBlock(block);
+  }
+
+  if (block_dependency_ == BlockDependency::kDependsOnPreviousBlock) {
+    first_not_highlighted_block_number_ =
+        std::max(first_not_highlighted_block_number_, requested_last_block_number_ + 1);
+  }
+
+  requested_first_block_number_ = 0;
+  requested_last_block_number_ = -1;
+}
+
+void LazySyntaxHighlighter::highlightBlock(const QString& code) {
+  const int block_number = currentBlock().blockNumber();
+  if (block_number < requested_first_block_number_ ||
+      block_number > requested_last_block_number_) {
+    // This happens when the document gets attached or modified. We leave the block without
+    // formatting and highlight it once it gets requested.
+    setCurrentBlockState(kNotHighlightedState);
+    first_not_highlighted_block_number_ =
+        std::min(first_not_highlighted_block_number_, block_number);
+    return;
+  }
+
+  setCurrentBlockState(kHighlightedInitialState);
+  HighlightRequestedBlock(code);
+}
+
+}  // namespace orbit_syntax_highlighter
@@ -219,9 +219,9 @@ const QRegularExpression kCallTargetRegex{R"(\bcall[^\(]*\((.*)\)$)"};
 }  // namespace AssemblyRegex
 }  // namespace
 
-X86Assembly::X86Assembly() : QSyntaxHighlighter{static_cast<QObject*>(nullptr)} {}
+X86Assembly::X86Assembly() : LazySyntaxHighlighter{BlockDependency::kIndependent} {}
 
-void X86Assembly::highlightBlock(const QString& code) {
+void X86Assembly::HighlightRequestedBlock(const QString& code) {
   const HighlightingMetadata* const highlighting_metadata =
       dynamic_cast<const HighlightingMetadata*>(currentBlock().userData());
   if (highlighting_metadata == nullptr || highlighting_metadata->IsMainContentLine()) {
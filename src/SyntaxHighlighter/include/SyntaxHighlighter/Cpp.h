@@ -8,22 +8,23 @@
 #include <QObject>
 #include <QRegularExpression>
 #include <QString>
-#include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 #include <functional>
 
+#include "SyntaxHighlighter/LazySyntaxHighlighter.h"
+
 namespace orbit_syntax_highlighter {
 
 //  This a syntax highlighter for C++.
-//  It derives from QSyntaxHighlighter, so check out QSyntaxHighlighter's
+//  It derives from LazySyntaxHighlighter, so check out its and QSyntaxHighlighter's
 //  documentation on how to use it. There are no additional settings or
 //  APIs.
 
 enum CppHighlighterState { kInitialState, kOpenCommentState, kOpenStringState };
 
-class Cpp : public QSyntaxHighlighter {
+class Cpp : public LazySyntaxHighlighter {
   Q_OBJECT
-  void highlightBlock(const QString& code) override;
+  void HighlightRequestedBlock(const QString& code) override;
 
  public:
   explicit Cpp();
@@ -0,0 +1,57 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SYNTAX_HIGHLIGHTER_LAZY_SYNTAX_HIGHLIGHTER_H_
+#define SYNTAX_HIGHLIGHTER_LAZY_SYNTAX_HIGHLIGHTER_H_
+
+#include <QObject>
+#include <QString>
+#include <QSyntaxHighlighter>
+#include <QTextBlock>
+
+namespace orbit_syntax_highlighter {
+
+/*
+  A QSyntaxHighlighter that only highlights the blocks it is explicitly asked for.
+
+  QSyntaxHighlighter runs over the whole document when it gets attached to it, which freezes the UI
+  for documents with tens of thousands of lines. Derived highlighters implement
+  `HighlightRequestedBlock` instead of `highlightBlock` and the view calls `HighlightBlocks` with
+  the blocks that are about to be painted. Blocks that are (re-)formatted by Qt outside of such a
+  request stay unformatted until they are requested.
+
+  Highlighters whose result for a block depends on the state of the previous block (e.g. multi-line
+  comments) pass `BlockDependency::kDependsOnPreviousBlock`. Then all blocks from the beginning of
+  the document up to the requested ones get highlighted, but each block only once.
+*/
+class LazySyntaxHighlighter : public QSyntaxHighlighter {
+  Q_OBJECT
+
+ public:
+  // Highlights all the blocks from `first_block` to `last_block` (both inclusive) that have not
+  // been highlighted yet.
+  void HighlightBlocks(const QTextBlock& first_block, const QTextBlock& last_block);
+
+ protected:
+  enum class BlockDependency { kIndependent, kDependsOnPreviousBlock };
+  explicit LazySyntaxHighlighter(BlockDependency block_dependency);
+
+  // Called for each requested block. The current block state is set to 0 before the call. Derived
+  // classes may change it, but only to non-negative values, as negative ones mark blocks which have
+  // not been highlighted.
+  virtual void HighlightRequestedBlock(const QString& code) = 0;
+
+ private:
+  void highlightBlock(const QString& code) final;
+
+  BlockDependency block_dependency_;
+  int requested_first_block_number_ = 0;
+  int requested_last_block_number_ = -1;
+  // Only used with kDependsOnPreviousBlock. All blocks before this one are highlighted.
+  int first_not_highlighted_block_number_ = 0;
+};
+
+}  // namespace orbit_syntax_highlighter
+
+#endif  // SYNTAX_HIGHLIGHTER_LAZY_SYNTAX_HIGHLIGHTER_H_
@@ -11,24 +11,25 @@
 #include <QObject>
 #include <QRegularExpression>
 #include <QString>
-#include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 #include <Qt>
 #include <functional>
 
+#include "SyntaxHighlighter/LazySyntaxHighlighter.h"
+
 namespace orbit_syntax_highlighter {
 
 /*
   This a syntax highlighter for x86 and x86_64 assembly (Intel syntax).
 
-  It derives from QSyntaxHighlighter, so check out QSyntaxHighlighter's
+  It derives from LazySyntaxHighlighter, so check out its and QSyntaxHighlighter's
   documentation on how to use it. There are no additional settings or
   APIs.
 */
-class X86Assembly : public QSyntaxHighlighter {
+class X86Assembly : public LazySyntaxHighlighter {
   Q_OBJECT
 
-  void highlightBlock(const QString& code) override;
+  void HighlightRequestedBlock(const QString& code) override;
 
  public:
   explicit X86Assembly();
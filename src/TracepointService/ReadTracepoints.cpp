@@ -5,14 +5,19 @@
 #include "ReadTracepoints.h"
 
 #include <absl/strings/str_format.h>
+#include <stddef.h>
+#include <xxhash.h>
 
 #include <algorithm>
-#include <chrono>
 #include <filesystem>
+#include <iterator>
+#include <string>
 #include <system_error>
+#include <utility>
 #include <vector>
 
 #include "GrpcProtos/tracepoint.pb.h"
+#include "OrbitBase/ParallelFor.h"
 #include "OrbitBase/Result.h"
 
 namespace fs = std::filesystem;
@@ -21,14 +26,15 @@ namespace orbit_tracepoint_service {
 
 static const char* kLinuxTracingEventsDirectory = "/sys/kernel/debug/tracing/events/";
 
-ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepoints() {
-  std::vector<orbit_grpc_protos::TracepointInfo> result;
+ErrorMessageOr<std::vector<fs::path>> ReadTracepointCategoryDirectories(
+    const fs::path& events_directory) {
+  std::vector<fs::path> result;
 
   std::error_code error;
-  auto category_directory_iterator = fs::directory_iterator(kLinuxTracingEventsDirectory, error);
+  auto category_directory_iterator = fs::directory_iterator(events_directory, error);
   if (error) {
     return ErrorMessage{absl::StrFormat("Unable to scan \"%s\" directory: %s",
-                                        kLinuxTracingEventsDirectory, error.message())};
+                                        events_directory.string(), error.message())};
   }
 
   for (auto category_it = fs::begin(category_directory_iterator),
@@ -36,7 +42,7 @@ ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepoints()
        category_it != category_end; category_it.increment(error)) {
     if (error) {
       return ErrorMessage{absl::StrFormat("Unable to scan \"%s\" directory: %s",
-                                          kLinuxTracingEventsDirectory, error.message())};
+                                          events_directory.string(), error.message())};
     }
 
     const fs::path& category_path = category_it->path();
@@ -47,38 +53,98 @@ ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepoints()
     }
 
     if (!outer_is_directory) continue;
+    result.push_back(category_path);
+  }
+
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+ErrorMessageOr<std::vector<fs::path>> ReadTracepointCategoryDirectories() {
+  return ReadTracepointCategoryDirectories(kLinuxTracingEventsDirectory);
+}
 
-    auto name_directory_iterator = fs::directory_iterator(category_path, error);
+static ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepointsOfCategory(
+    const fs::path& category_path) {
+  std::vector<orbit_grpc_protos::TracepointInfo> result;
+
+  std::error_code error;
+  auto name_directory_iterator = fs::directory_iterator(category_path, error);
+  if (error) {
+    return ErrorMessage{absl::StrFormat("Unable to scan \"%s\" directory: %s",
+                                        category_path.string(), error.message())};
+  }
+
+  for (auto it = fs::begin(name_directory_iterator), end = fs::end(name_directory_iterator);
+       it != end; it.increment(error)) {
     if (error) {
       return ErrorMessage{absl::StrFormat("Unable to scan \"%s\" directory: %s",
                                           category_path.string(), error.message())};
     }
 
-    for (auto it = fs::begin(name_directory_iterator), end = fs::end(name_directory_iterator);
-         it != end; it.increment(error)) {
-      if (error) {
-        return ErrorMessage{absl::StrFormat("Unable to scan \"%s\" directory: %s",
-                                            category_path.string(), error.message())};
-      }
-
-      bool inner_is_directory = it->is_directory(error);
-      if (error) {
-        return ErrorMessage{
-            absl::StrFormat("Unable to stat \"%s\": %s", it->path().string(), error.message())};
-      }
-
-      if (!inner_is_directory) {
-        continue;
-      }
-
-      orbit_grpc_protos::TracepointInfo tracepoint_info;
-      tracepoint_info.set_name(it->path().filename());
-      tracepoint_info.set_category(category_path.filename());
-      result.emplace_back(tracepoint_info);
+    bool inner_is_directory = it->is_directory(error);
+    if (error) {
+      return ErrorMessage{
+          absl::StrFormat("Unable to stat \"%s\": %s", it->path().string(), error.message())};
+    }
+
+    if (!inner_is_directory) {
+      continue;
     }
+
+    orbit_grpc_protos::TracepointInfo tracepoint_info;
+    tracepoint_info.set_name(it->path().filename());
+    tracepoint_info.set_category(category_path.filename());
+    result.emplace_back(std::move(tracepoint_info));
   }
 
+  std::sort(result.begin(), result.end(),
+            [](const orbit_grpc_protos::TracepointInfo& lhs,
+               const orbit_grpc_protos::TracepointInfo& rhs) { return lhs.name() < rhs.name(); });
+  return result;
+}
+
+ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepointsOfCategories(
+    absl::Span<const fs::path> category_directories) {
+  // Each directory read is a round trip to the kernel, so the categories are read in parallel.
+  std::vector<ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>>> results_by_category(
+      category_directories.size(), std::vector<orbit_grpc_protos::TracepointInfo>{});
+  orbit_base::ParallelFor(category_directories.size(), [&](size_t index) {
+    results_by_category[index] = ReadTracepointsOfCategory(category_directories[index]);
+  });
+
+  std::vector<orbit_grpc_protos::TracepointInfo> result;
+  for (ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>>& category_result :
+       results_by_category) {
+    if (category_result.has_error()) return category_result.error();
+    std::move(category_result.value().begin(), category_result.value().end(),
+              std::back_inserter(result));
+  }
+  // The category directories are sorted by path, which is not always the order of their names.
+  std::stable_sort(result.begin(), result.end(),
+                   [](const orbit_grpc_protos::TracepointInfo& lhs,
+                      const orbit_grpc_protos::TracepointInfo& rhs) {
+                     return lhs.category() < rhs.category();
+                   });
   return result;
 }
 
+ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepoints() {
+  OUTCOME_TRY(std::vector<fs::path> category_directories, ReadTracepointCategoryDirectories());
+  return ReadTracepointsOfCategories(category_directories);
+}
+
+uint64_t ComputeTracepointListHash(
+    absl::Span<const orbit_grpc_protos::TracepointInfo> tracepoints) {
+  XXH64_state_t hash_state;
+  XXH64_reset(&hash_state, 0);
+  for (const orbit_grpc_protos::TracepointInfo& tracepoint : tracepoints) {
+    // Include the terminating null characters, so that different splits of the same characters
+    // into category and name don't collide.
+    XXH64_update(&hash_state, tracepoint.category().c_str(), tracepoint.category().size() + 1);
+    XXH64_update(&hash_state, tracepoint.name().c_str(), tracepoint.name().size() + 1);
+  }
+  return XXH64_digest(&hash_state);
+}
+
 }  // namespace orbit_tracepoint_service
@@ -5,6 +5,10 @@
 #ifndef TRACEPOINT_SERVICE_READ_TRACEPOINTS_H_
 #define TRACEPOINT_SERVICE_READ_TRACEPOINTS_H_
 
+#include <absl/types/span.h>
+#include <stdint.h>
+
+#include <filesystem>
 #include <vector>
 
 #include "GrpcProtos/tracepoint.pb.h"
@@ -12,7 +16,26 @@
 
 namespace orbit_tracepoint_service {
 
-ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepoints();
+// Returns the directories of the tracepoint categories in `events_directory`, sorted. This only
+// scans `events_directory` itself, so it is much cheaper than reading the tracepoints.
+[[nodiscard]] ErrorMessageOr<std::vector<std::filesystem::path>> ReadTracepointCategoryDirectories(
+    const std::filesystem::path& events_directory);
+// Returns the directories of the tracepoint categories of the running kernel, sorted.
+[[nodiscard]] ErrorMessageOr<std::vector<std::filesystem::path>>
+ReadTracepointCategoryDirectories();
+
+// Returns the tracepoints of the given category directories, sorted by category and name. The
+// categories are read in parallel.
+[[nodiscard]] ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>>
+ReadTracepointsOfCategories(absl::Span<const std::filesystem::path> category_directories);
+
+// Returns the tracepoints of the running kernel, sorted by category and name.
+[[nodiscard]] ErrorMessageOr<std::vector<orbit_grpc_protos::TracepointInfo>> ReadTracepoints();
+
+// Returns a hash of the categories and names of `tracepoints` that doesn't depend on the process,
+// so that a client can tell whether it already has the list.
+[[nodiscard]] uint64_t ComputeTracepointListHash(
+    absl::Span<const orbit_grpc_protos::TracepointInfo> tracepoints);
 
 }  // namespace orbit_tracepoint_service
 
@@ -9,17 +9,23 @@
 #include <algorithm>
 #include <array>
 #include <deque>
+#include <filesystem>
+#include <fstream>
 #include <iterator>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "GrpcProtos/tracepoint.pb.h"
 #include "OrbitBase/Result.h"
 #include "ReadTracepoints.h"
+#include "TestUtils/TemporaryDirectory.h"
 #include "TestUtils/TestUtils.h"
 
 using orbit_grpc_protos::TracepointInfo;
 
+using orbit_test_utils::HasError;
+using orbit_test_utils::HasNoError;
 using orbit_test_utils::HasValue;
 
 namespace orbit_tracepoint_service {
@@ -85,4 +91,60 @@ TEST(ServiceUtils, NamesTracepoints) {
   }
 }
 
-}  // namespace orbit_tracepoint_service
\ No newline at end of file
+namespace {
+
+TracepointInfo CreateTracepointInfo(std::string category, std::string name) {
+  TracepointInfo tracepoint_info;
+  tracepoint_info.set_category(std::move(category));
+  tracepoint_info.set_name(std::move(name));
+  return tracepoint_info;
+}
+
+MATCHER_P2(TracepointIs, category, name, "") {
+  return arg.category() == category && arg.name() == name;
+}
+
+}  // namespace
+
+TEST(ServiceUtils, ReadTracepointsOfCategoryDirectories) {
+  auto temporary_directory_or_error = orbit_test_utils::TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_directory_or_error, HasNoError());
+  const std::filesystem::path& events_directory =
+      temporary_directory_or_error.value().GetDirectoryPath();
+  for (const char* tracepoint : {"sched/sched_wakeup", "sched/sched_switch", "irq/softirq_entry"}) {
+    std::filesystem::create_directories(events_directory / tracepoint);
+  }
+  // Files are not tracepoints.
+  std::ofstream{events_directory / "enable"};
+  std::ofstream{events_directory / "sched" / "filter"};
+
+  const auto category_directories = ReadTracepointCategoryDirectories(events_directory);
+  ASSERT_THAT(category_directories, HasValue());
+  EXPECT_THAT(category_directories.value(),
+              testing::ElementsAre(events_directory / "irq", events_directory / "sched"));
+
+  const auto tracepoint_infos = ReadTracepointsOfCategories(category_directories.value());
+  ASSERT_THAT(tracepoint_infos, HasValue());
+  EXPECT_THAT(tracepoint_infos.value(),
+              testing::ElementsAre(TracepointIs("irq", "softirq_entry"),
+                                   TracepointIs("sched", "sched_switch"),
+                                   TracepointIs("sched", "sched_wakeup")));
+
+  EXPECT_THAT(ReadTracepointsOfCategories({events_directory / "missing"}),
+              HasError());
+}
+
+TEST(ServiceUtils, ComputeTracepointListHash) {
+  const std::vector<TracepointInfo> tracepoints = {CreateTracepointInfo("sched", "sched_switch"),
+                                                   CreateTracepointInfo("sched", "sched_wakeup")};
+  EXPECT_EQ(ComputeTracepointListHash(tracepoints), ComputeTracepointListHash(tracepoints));
+
+  const std::vector<TracepointInfo> fewer_tracepoints = {tracepoints[0]};
+  EXPECT_NE(ComputeTracepointListHash(tracepoints), ComputeTracepointListHash(fewer_tracepoints));
+
+  const std::vector<TracepointInfo> other_split = {CreateTracepointInfo("sche", "dsched_switch"),
+                                                   CreateTracepointInfo("sched", "sched_wakeup")};
+  EXPECT_NE(ComputeTracepointListHash(tracepoints), ComputeTracepointListHash(other_split));
+}
+
+}  // namespace orbit_tracepoint_service
@@ -4,6 +4,8 @@
 
 #include "TracepointService/TracepointServiceImpl.h"
 
+#include <filesystem>
+#include <utility>
 #include <vector>
 
 #include "GrpcProtos/services.pb.h"
@@ -15,17 +17,35 @@
 namespace orbit_tracepoint_service {
 
 grpc::Status TracepointServiceImpl::GetTracepointList(grpc::ServerContext* /*context*/,
-                                                      const GetTracepointListRequest* /*request*/,
+                                                      const GetTracepointListRequest* request,
                                                       GetTracepointListResponse* response) {
-  ORBIT_LOG("Sending tracepoints");
+  ErrorMessageOr<std::vector<std::filesystem::path>> category_directories =
+      ReadTracepointCategoryDirectories();
+  if (category_directories.has_error()) {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, category_directories.error().message());
+  }
 
-  const auto tracepoint_infos = ReadTracepoints();
-  if (tracepoint_infos.has_error()) {
-    return grpc::Status(grpc::StatusCode::NOT_FOUND, tracepoint_infos.error().message());
+  absl::MutexLock lock{&mutex_};
+  if (cached_list_hash_ == 0 || category_directories.value() != cached_category_directories_) {
+    ORBIT_LOG("Reading tracepoints");
+    auto tracepoint_infos = ReadTracepointsOfCategories(category_directories.value());
+    if (tracepoint_infos.has_error()) {
+      return grpc::Status(grpc::StatusCode::NOT_FOUND, tracepoint_infos.error().message());
+    }
+    cached_category_directories_ = std::move(category_directories.value());
+    cached_tracepoints_ = std::move(tracepoint_infos.value());
+    cached_list_hash_ = ComputeTracepointListHash(cached_tracepoints_);
   }
 
-  *response->mutable_tracepoints() = {tracepoint_infos.value().begin(),
-                                      tracepoint_infos.value().end()};
+  response->set_list_hash(cached_list_hash_);
+  if (request->known_list_hash() == cached_list_hash_) {
+    ORBIT_LOG("Tracepoints are unchanged");
+    response->set_list_is_unchanged(true);
+    return grpc::Status::OK;
+  }
+
+  ORBIT_LOG("Sending tracepoints");
+  *response->mutable_tracepoints() = {cached_tracepoints_.begin(), cached_tracepoints_.end()};
 
   return grpc::Status::OK;
 }
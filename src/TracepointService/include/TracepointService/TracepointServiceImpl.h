@@ -5,13 +5,19 @@
 #ifndef TRACEPOINT_SERVICE_TRACEPOINT_SERVICE_IMPL_
 #define TRACEPOINT_SERVICE_TRACEPOINT_SERVICE_IMPL_
 
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
+#include <stdint.h>
 
+#include <filesystem>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "GrpcProtos/services.grpc.pb.h"
 #include "GrpcProtos/services.pb.h"
+#include "GrpcProtos/tracepoint.pb.h"
 
 namespace orbit_tracepoint_service {
 
@@ -19,11 +25,20 @@ using orbit_grpc_protos::GetTracepointListRequest;
 using orbit_grpc_protos::GetTracepointListResponse;
 using orbit_grpc_protos::TracepointService;
 
+// Reading the tracepoints takes one directory scan per category, so the list is cached. It is read
+// again when the set of categories changes, for example when a kernel module that defines its own
+// tracepoints is loaded.
 class TracepointServiceImpl final : public TracepointService::Service {
  public:
   [[nodiscard]] grpc::Status GetTracepointList(grpc::ServerContext* context,
                                                const GetTracepointListRequest* request,
                                                GetTracepointListResponse* response) override;
+
+ private:
+  absl::Mutex mutex_;
+  std::vector<std::filesystem::path> cached_category_directories_ ABSL_GUARDED_BY(mutex_);
+  std::vector<orbit_grpc_protos::TracepointInfo> cached_tracepoints_ ABSL_GUARDED_BY(mutex_);
+  uint64_t cached_list_hash_ ABSL_GUARDED_BY(mutex_) = 0;
 };
 
 }  // namespace orbit_tracepoint_service
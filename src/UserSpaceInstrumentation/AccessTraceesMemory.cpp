@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
 
 #include "OrbitBase/File.h"
 #include "OrbitBase/Logging.h"
@@ -50,6 +51,62 @@ using orbit_base::ReadFileToString;
   return outcome::success();
 }
 
+[[nodiscard]] ErrorMessageOr<std::vector<std::vector<uint8_t>>> ReadTraceesMemoryBatch(
+    pid_t pid, absl::Span<const AddressRange> address_ranges) {
+  std::vector<std::vector<uint8_t>> result;
+  if (address_ranges.empty()) return result;
+
+  OUTCOME_TRY(auto&& fd, orbit_base::OpenFileForReading(absl::StrFormat("/proc/%d/mem", pid)));
+
+  result.reserve(address_ranges.size());
+  for (const AddressRange& address_range : address_ranges) {
+    ORBIT_CHECK(address_range.end > address_range.start);
+    const uint64_t length = address_range.end - address_range.start;
+    std::vector<uint8_t>& bytes = result.emplace_back(length);
+    OUTCOME_TRY(auto&& read_size,
+                ReadFullyAtOffset(fd, bytes.data(), length, address_range.start));
+    if (read_size < length) {
+      return ErrorMessage(absl::StrFormat(
+          "Failed to read %u bytes at %#x from memory file of process %d. Only got %d bytes.",
+          length, address_range.start, pid, read_size));
+    }
+  }
+
+  return result;
+}
+
+[[nodiscard]] ErrorMessageOr<void> WriteTraceesMemoryBatch(pid_t pid,
+                                                           std::vector<TraceesMemoryWrite> writes) {
+  if (writes.empty()) return outcome::success();
+
+  std::stable_sort(writes.begin(), writes.end(),
+                   [](const TraceesMemoryWrite& lhs, const TraceesMemoryWrite& rhs) {
+                     return lhs.start_address < rhs.start_address;
+                   });
+  // Merge each write into the previous one if it starts exactly where the previous one ends.
+  std::vector<TraceesMemoryWrite> merged_writes;
+  for (TraceesMemoryWrite& write : writes) {
+    ORBIT_CHECK(!write.bytes.empty());
+    if (!merged_writes.empty() && merged_writes.back().start_address +
+                                          merged_writes.back().bytes.size() ==
+                                      write.start_address) {
+      merged_writes.back().bytes.insert(merged_writes.back().bytes.end(), write.bytes.begin(),
+                                        write.bytes.end());
+    } else {
+      merged_writes.push_back(std::move(write));
+    }
+  }
+
+  OUTCOME_TRY(auto&& fd, orbit_base::OpenFileForWriting(absl::StrFormat("/proc/%d/mem", pid)));
+
+  for (const TraceesMemoryWrite& write : merged_writes) {
+    OUTCOME_TRY(
+        WriteFullyAtOffset(fd, write.bytes.data(), write.bytes.size(), write.start_address));
+  }
+
+  return outcome::success();
+}
+
 [[nodiscard]] ErrorMessageOr<AddressRange> GetExistingExecutableMemoryRegion(
     pid_t pid, uint64_t exclude_address) {
   OUTCOME_TRY(auto&& maps, ReadFileToString(absl::StrFormat("/proc/%d/maps", pid)));
@@ -27,6 +27,25 @@ namespace orbit_user_space_instrumentation {
 [[nodiscard]] ErrorMessageOr<void> WriteTraceesMemory(pid_t pid, uint64_t start_address,
                                                       absl::Span<const uint8_t> bytes);
 
+// Reads each of `address_ranges` from process `pid`, opening the memory file of the process only
+// once. The result contains the bytes of the ranges in the order of `address_ranges`.
+// Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
+[[nodiscard]] ErrorMessageOr<std::vector<std::vector<uint8_t>>> ReadTraceesMemoryBatch(
+    pid_t pid, absl::Span<const AddressRange> address_ranges);
+
+// A block of bytes to be written into the memory of a tracee at `start_address`.
+struct TraceesMemoryWrite {
+  uint64_t start_address = 0;
+  std::vector<uint8_t> bytes;
+};
+
+// Writes all `writes` into memory of process `pid`, opening the memory file of the process only
+// once. Writes that are directly adjacent in memory are merged, so that each contiguous block is
+// written at once. Overlapping writes are applied in the order of their start addresses.
+// Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
+[[nodiscard]] ErrorMessageOr<void> WriteTraceesMemoryBatch(pid_t pid,
+                                                           std::vector<TraceesMemoryWrite> writes);
+
 // Returns the address range of an executable memory region. One options is usually the second line
 // in the `maps` file corresponding to the code of the process we look at. However we don't really
 // care. So keeping it general and just searching for an executable region is probably helping
@@ -18,6 +18,7 @@
 #include <random>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "AccessTraceesMemory.h"
@@ -233,4 +234,74 @@ TEST(AccessTraceesMemoryTest, ReadWriteRestore) {
   waitpid(pid, nullptr, 0);
 }
 
+TEST(AccessTraceesMemoryTest, BatchedReadWriteRestore) {
+  pid_t pid = fork();
+  ORBIT_CHECK(pid != -1);
+  if (pid == 0) {
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+    // Child just runs an endless loop.
+    volatile uint64_t counter = 0;
+    while (true) {
+      // Endless loops without side effects are UB and recent versions of clang optimize it away.
+      ++counter;
+    }
+  }
+
+  // Stop the child process using our tooling.
+  ORBIT_CHECK(!AttachAndStopProcess(pid).has_error());
+
+  auto memory_region_or_error = GetExistingExecutableMemoryRegion(pid);
+  ORBIT_CHECK(memory_region_or_error.has_value());
+  const uint64_t address = memory_region_or_error.value().start;
+
+  constexpr uint64_t kMemorySize = 4u * 1024u;
+  auto backup = ReadTraceesMemory(pid, address, kMemorySize);
+  ASSERT_TRUE(backup.has_value());
+
+  std::vector<uint8_t> new_data = backup.value();
+  std::mt19937 engine{std::random_device()()};
+  std::uniform_int_distribution<uint32_t> distribution{0x00, 0xff};
+  auto random_byte = [&distribution, &engine]() {
+    return static_cast<uint8_t>(distribution(engine));
+  };
+  std::generate(new_data.begin(), new_data.begin() + 300, random_byte);
+  std::generate(new_data.begin() + 1000, new_data.begin() + 1100, random_byte);
+
+  // Out of order, with the first two writes adjacent in memory.
+  std::vector<TraceesMemoryWrite> writes;
+  writes.push_back(TraceesMemoryWrite{
+      .start_address = address + 100,
+      .bytes = std::vector<uint8_t>(new_data.begin() + 100, new_data.begin() + 300)});
+  writes.push_back(TraceesMemoryWrite{
+      .start_address = address,
+      .bytes = std::vector<uint8_t>(new_data.begin(), new_data.begin() + 100)});
+  writes.push_back(TraceesMemoryWrite{
+      .start_address = address + 1000,
+      .bytes = std::vector<uint8_t>(new_data.begin() + 1000, new_data.begin() + 1100)});
+  ASSERT_FALSE(WriteTraceesMemoryBatch(pid, std::move(writes)).has_error());
+
+  const std::vector<AddressRange> address_ranges{
+      AddressRange{address + 1000, address + kMemorySize}, AddressRange{address, address + 1000}};
+  auto read_back_or_error = ReadTraceesMemoryBatch(pid, address_ranges);
+  ASSERT_TRUE(read_back_or_error.has_value());
+  ASSERT_EQ(read_back_or_error.value().size(), 2);
+  EXPECT_EQ(read_back_or_error.value()[0],
+            std::vector<uint8_t>(new_data.begin() + 1000, new_data.end()));
+  EXPECT_EQ(read_back_or_error.value()[1],
+            std::vector<uint8_t>(new_data.begin(), new_data.begin() + 1000));
+
+  // Reading from a bad address fails the whole batch.
+  const std::vector<AddressRange> bad_address_ranges{AddressRange{address, address + 1},
+                                                     AddressRange{0, 1}};
+  EXPECT_THAT(ReadTraceesMemoryBatch(pid, bad_address_ranges),
+              HasErrorWithMessage("Input/output error"));
+
+  // Restore, detach and end child.
+  ORBIT_CHECK(WriteTraceesMemory(pid, address, backup.value()).has_value());
+  ORBIT_CHECK(!DetachAndContinueProcess(pid).has_error());
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+}
+
 }  // namespace orbit_user_space_instrumentation
\ No newline at end of file
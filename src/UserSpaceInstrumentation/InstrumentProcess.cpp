@@ -16,9 +16,11 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <string>
 #include <string_view>
@@ -30,6 +32,7 @@
 #include "AccessTraceesMemory.h"
 #include "AllocateInTracee.h"
 #include "ExecuteMachineCode.h"
+#include "GrpcProtos/Constants.h"
 #include "GrpcProtos/module.pb.h"
 #include "MachineCode.h"
 #include "ModuleUtils/ReadLinuxModules.h"
@@ -40,8 +43,10 @@
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/TaskGroup.h"
 #include "OrbitBase/ThreadUtils.h"
 #include "OrbitBase/UniqueResource.h"
+#include "RelocatedPrologueCache.h"
 #include "Trampoline.h"
 #include "UserSpaceInstrumentation/AddressRange.h"
 #include "UserSpaceInstrumentation/AnyThreadIsInStrictSeccompMode.h"
@@ -274,6 +279,128 @@ ErrorMessageOr<std::vector<ModuleInfo>> ModulesFromModulePath(
   return cached_modules_from_path_it->second;
 }
 
+ErrorMessageOr<csh> OpenCapstone() {
+  csh capstone_handle = 0;
+  cs_err error_code = cs_open(CS_ARCH_X86, CS_MODE_64, &capstone_handle);
+  if (error_code != CS_ERR_OK) {
+    return ErrorMessage("Failed to open Capstone disassembler.");
+  }
+  error_code = cs_option(capstone_handle, CS_OPT_DETAIL, CS_OPT_ON);
+  if (error_code != CS_ERR_OK) {
+    cs_close(&capstone_handle);
+    return ErrorMessage("Failed to configure Capstone disassembler.");
+  }
+  return capstone_handle;
+}
+
+// A trampoline to be created for the function at `function_address` in `trampoline_address`.
+struct NewTrampoline {
+  uint64_t function_address = 0;
+  const std::string* function_name = nullptr;
+  uint64_t trampoline_address = 0;
+  // Identify the function in the RelocatedPrologueCache.
+  const std::string* build_id = nullptr;
+  uint64_t function_offset = 0;
+  // The beginning of the function.
+  std::vector<uint8_t> function_data;
+  // Whether `function_data` is the entire function.
+  bool function_data_is_complete = false;
+  // Found in the RelocatedPrologueCache, or set by BuildTrampolinesInParallel when relocating the
+  // prologue succeeded.
+  std::optional<RelocatedPrologue> relocated_prologue;
+  bool relocated_prologue_from_cache = false;
+
+  // Set by BuildTrampolinesInParallel.
+  ErrorMessageOr<TrampolineCode> trampoline_code_or_error{ErrorMessage{"Not built."}};
+  absl::flat_hash_map<uint64_t, uint64_t> relocation_map;
+};
+
+// Builds the code of `new_trampolines` on the default thread pool. The thread pool is only used
+// for the computation; the tracee is not accessed. Prologues that have already been relocated are
+// not disassembled again.
+void BuildTrampolinesInParallel(uint64_t entry_payload_function_address,
+                                uint64_t return_trampoline_address,
+                                absl::Span<NewTrampoline> new_trampolines) {
+  // Disassembling and relocating a prologue takes a few microseconds, so fewer larger tasks keep
+  // the overhead of scheduling and of opening a Capstone handle per task low.
+  constexpr size_t kTrampolinesPerTask = 64;
+  orbit_base::TaskGroup task_group;
+  for (size_t begin = 0; begin < new_trampolines.size(); begin += kTrampolinesPerTask) {
+    absl::Span<NewTrampoline> batch = new_trampolines.subspan(begin, kTrampolinesPerTask);
+    task_group.AddTask([batch, entry_payload_function_address, return_trampoline_address] {
+      // Capstone handles must not be shared between threads. Only open one if some prologue of
+      // the batch needs to be relocated.
+      std::optional<ErrorMessageOr<csh>> capstone_handle_or_error;
+      for (NewTrampoline& new_trampoline : batch) {
+        if (!new_trampoline.relocated_prologue.has_value()) {
+          if (!capstone_handle_or_error.has_value()) capstone_handle_or_error = OpenCapstone();
+          if (capstone_handle_or_error->has_error()) {
+            new_trampoline.trampoline_code_or_error = capstone_handle_or_error->error();
+            continue;
+          }
+          ErrorMessageOr<RelocatedPrologue> relocated_prologue_or_error =
+              RelocatePrologue(new_trampoline.function_address, new_trampoline.function_data,
+                               capstone_handle_or_error->value());
+          if (relocated_prologue_or_error.has_error()) {
+            new_trampoline.trampoline_code_or_error = relocated_prologue_or_error.error();
+            continue;
+          }
+          new_trampoline.relocated_prologue = std::move(relocated_prologue_or_error.value());
+          new_trampoline.relocated_prologue->function_may_use_ymm_registers =
+              !new_trampoline.function_data_is_complete ||
+              MayUseYmmRegisters(new_trampoline.function_data, capstone_handle_or_error->value());
+        }
+        new_trampoline.trampoline_code_or_error = BuildTrampolineFromRelocatedPrologue(
+            new_trampoline.function_address, new_trampoline.relocated_prologue.value(),
+            new_trampoline.trampoline_address, entry_payload_function_address,
+            return_trampoline_address, new_trampoline.relocation_map);
+      }
+      if (capstone_handle_or_error.has_value() && capstone_handle_or_error->has_value()) {
+        cs_close(&capstone_handle_or_error->value());
+      }
+    });
+  }
+  task_group.Wait();
+}
+
+std::vector<uint8_t> FunctionIdAsBytes(uint64_t function_id) {
+  MachineCode function_id_as_bytes;
+  function_id_as_bytes.AppendImmediate64(function_id);
+  return function_id_as_bytes.GetResultAsVector();
+}
+
+// Creates the trampoline that `MeasureFunctionCallOverheadNs` calls `CalibrationFunction` through.
+// The prologue of `CalibrationFunction` is never overwritten, so the trampoline is only entered by
+// `MeasureFunctionCallOverheadNs`.
+ErrorMessageOr<std::unique_ptr<MemoryInTracee>> CreateCalibrationTrampoline(
+    pid_t pid, uint64_t calibration_function_address, uint64_t entry_payload_function_address,
+    uint64_t return_trampoline_address) {
+  // Enough to contain the five bytes that get relocated and the instructions they belong to.
+  constexpr uint64_t kCalibrationFunctionReadSize = 16;
+  const AddressRange calibration_function_address_range{
+      calibration_function_address, calibration_function_address + kCalibrationFunctionReadSize};
+  OUTCOME_TRY(auto&& calibration_function,
+              ReadTraceesMemory(pid, calibration_function_address, kCalibrationFunctionReadSize));
+  OUTCOME_TRY(auto&& trampoline_memory,
+              AllocateMemoryForTrampolines(pid, calibration_function_address_range,
+                                           GetMaxTrampolineSize()));
+  OUTCOME_TRY(csh capstone_handle, OpenCapstone());
+  absl::flat_hash_map<uint64_t, uint64_t> unused_relocation_map;
+  ErrorMessageOr<uint64_t> address_after_prologue_or_error =
+      CreateTrampoline(pid, calibration_function_address, calibration_function,
+                       trampoline_memory->GetAddress(), entry_payload_function_address,
+                       return_trampoline_address, capstone_handle, unused_relocation_map);
+  cs_close(&capstone_handle);
+  OUTCOME_TRY(address_after_prologue_or_error);
+  // Any valid function id enables the trampoline. The payloads don't emit events for these calls.
+  constexpr uint64_t kCalibrationFunctionId = 1;
+  OUTCOME_TRY(WriteTraceesMemory(
+      pid, trampoline_memory->GetAddress() + GetOffsetOfFunctionIdInTrampoline(),
+      FunctionIdAsBytes(kCalibrationFunctionId)));
+  OUTCOME_TRY(trampoline_memory->EnsureMemoryExecutable());
+  return std::move(trampoline_memory);
+}
+
 }  // namespace
 
 // Holds all the data necessary to keep track of a process we instrument.
@@ -281,6 +408,12 @@ ErrorMessageOr<std::vector<ModuleInfo>> ModulesFromModulePath(
 // with our instrumentation code into the target process and create the return trampoline. Once
 // created we can instrument functions in the target process and deactivate the instrumentation
 // again (see `InstrumentFunctions`, `UninstrumentFunctions` below).
+//
+// The jumps into the trampolines stay in place after a capture. Outside of a capture the entry
+// payload returns right away, so a function that was instrumented once is only patched again by
+// `UninstrumentFunctions`. For the functions not being part of the current capture,
+// `InstrumentFunctions` sets the function id in the trampoline to kInvalidFunctionId, which the
+// entry payload treats as disabled.
 class InstrumentedProcess {
  public:
   InstrumentedProcess(const InstrumentedProcess&) = delete;
@@ -295,12 +428,15 @@ class InstrumentedProcess {
   // Instruments the functions capture_options.instrumented_functions. Returns a set of
   // function_id's of successfully instrumented functions, a map of function_id's to errors for
   // functions that couldn't be instrumented, the address ranges dedicated to trampolines, and the
-  // map name of the injected library.
+  // map name of the injected library. Prologues are looked up in and added to
+  // `relocated_prologue_cache`. Functions instrumented in a previous capture but not part of this
+  // one stay instrumented, but are disabled.
   [[nodiscard]] ErrorMessageOr<InstrumentationManager::InstrumentationResult> InstrumentFunctions(
-      const CaptureOptions& capture_options, absl::Span<const ModuleInfo> modules);
+      const CaptureOptions& capture_options, absl::Span<const ModuleInfo> modules,
+      RelocatedPrologueCache* relocated_prologue_cache);
 
-  // Removes the instrumentation for all functions in capture_options.instrumented_functions that
-  // have been instrumented previously.
+  // Removes the instrumentation for all functions that have been instrumented previously by
+  // restoring their prologues. The trampolines stay in place.
   [[nodiscard]] ErrorMessageOr<void> UninstrumentFunctions();
 
   // Returns the pid of the process.
@@ -313,10 +449,6 @@ class InstrumentedProcess {
   // identified by `address_range`. Handles the allocation in the tracee and the tracks the
   // allocated memory in `trampolines_for_modules_` below.
   [[nodiscard]] ErrorMessageOr<uint64_t> GetTrampolineMemory(AddressRange address_range);
-  // Releases the address previously obtained by `GetTrampolineMemory` such that it can be reused.
-  // Note that this must only be called once for each call to `GetTrampolineMemory`.
-  [[nodiscard]] ErrorMessageOr<void> ReleaseMostRecentlyAllocatedTrampolineMemory(
-      AddressRange address_range);
 
   [[nodiscard]] ErrorMessageOr<void> EnsureTrampolinesWritable();
   [[nodiscard]] ErrorMessageOr<void> EnsureTrampolinesExecutable();
@@ -333,6 +465,11 @@ class InstrumentedProcess {
 
   uint64_t return_trampoline_address_ = 0;
 
+  // Used to measure the overhead of the instrumentation in `InstrumentFunctions`. Not set if
+  // creating the calibration trampoline failed.
+  uint64_t measure_function_call_overhead_function_address_ = 0;
+  std::unique_ptr<MemoryInTracee> calibration_trampoline_memory_;
+
   // Keep track of each relocated instruction that has been moved into a trampoline. Used to move
   // the instruction pointers out of overwritten memory areas after the instrumentation has been
   // done.
@@ -363,8 +500,9 @@ class InstrumentedProcess {
   using TrampolineMemoryChunks = std::vector<TrampolineMemoryChunk>;
   absl::flat_hash_map<AddressRange, TrampolineMemoryChunks> trampolines_for_modules_;
 
-  // When instrumenting a function we record the address here. This is used when we uninstrument: we
-  // look up the original bytes in `trampoline_map_` above.
+  // When instrumenting a function we record the address here. These are the functions that
+  // currently jump into their trampoline. This is used when we uninstrument: we look up the
+  // original bytes in `trampoline_map_` above.
   absl::flat_hash_set<uint64_t> addresses_of_instrumented_functions_;
 
   // The absolute canonical path to the library injected into the target process. This path should
@@ -442,6 +580,36 @@ ErrorMessageOr<std::unique_ptr<InstrumentedProcess>> InstrumentedProcess::Create
                                        process->return_trampoline_address_);
   OUTCOME_TRY(return_trampoline_memory->EnsureMemoryExecutable());
 
+  // The overhead can't be measured without the calibration trampoline, but the instrumentation
+  // still works.
+  constexpr const char* kCalibrationFunctionName = "CalibrationFunction";
+  constexpr const char* kMeasureFunctionCallOverheadFunctionName = "MeasureFunctionCallOverheadNs";
+  ErrorMessageOr<void*> calibration_function_address_or_error =
+      DlsymInTracee(pid, modules, library_handle, kCalibrationFunctionName);
+  ErrorMessageOr<void*> measure_function_call_overhead_function_address_or_error =
+      DlsymInTracee(pid, modules, library_handle, kMeasureFunctionCallOverheadFunctionName);
+  if (calibration_function_address_or_error.has_error()) {
+    ORBIT_ERROR("Resolving \"%s\": %s", kCalibrationFunctionName,
+                calibration_function_address_or_error.error().message());
+  } else if (measure_function_call_overhead_function_address_or_error.has_error()) {
+    ORBIT_ERROR("Resolving \"%s\": %s", kMeasureFunctionCallOverheadFunctionName,
+                measure_function_call_overhead_function_address_or_error.error().message());
+  } else {
+    ErrorMessageOr<std::unique_ptr<MemoryInTracee>> calibration_trampoline_memory_or_error =
+        CreateCalibrationTrampoline(
+            pid, absl::bit_cast<uint64_t>(calibration_function_address_or_error.value()),
+            process->entry_payload_function_address_, process->return_trampoline_address_);
+    if (calibration_trampoline_memory_or_error.has_error()) {
+      ORBIT_ERROR("Creating the calibration trampoline: %s",
+                  calibration_trampoline_memory_or_error.error().message());
+    } else {
+      process->measure_function_call_overhead_function_address_ = absl::bit_cast<uint64_t>(
+          measure_function_call_overhead_function_address_or_error.value());
+      process->calibration_trampoline_memory_ =
+          std::move(calibration_trampoline_memory_or_error.value());
+    }
+  }
+
   if (already_injected) {
     ORBIT_LOG(
         "Skipping initialization of instrumentation library since it was already present in the "
@@ -493,7 +661,9 @@ ErrorMessageOr<std::unique_ptr<InstrumentedProcess>> InstrumentedProcess::Create
 
 ErrorMessageOr<InstrumentationManager::InstrumentationResult>
 InstrumentedProcess::InstrumentFunctions(const CaptureOptions& capture_options,
-                                         absl::Span<const ModuleInfo> modules) {
+                                         absl::Span<const ModuleInfo> modules,
+                                         RelocatedPrologueCache* relocated_prologue_cache) {
+  ORBIT_CHECK(relocated_prologue_cache != nullptr);
   ORBIT_LOG("Instrumenting functions in process %d", pid_);
   OUTCOME_TRY(AttachAndStopProcess(pid_));
   orbit_base::unique_resource detach_on_exit{pid_, [](int32_t pid) {
@@ -506,19 +676,6 @@ InstrumentedProcess::InstrumentFunctions(const CaptureOptions& capture_options,
     return ErrorMessage("At least one thread of the target process is in strict seccomp mode.");
   }
 
-  // Init Capstone disassembler.
-  csh capstone_handle = 0;
-  cs_err error_code = cs_open(CS_ARCH_X86, CS_MODE_64, &capstone_handle);
-  if (error_code != CS_ERR_OK) {
-    return ErrorMessage("Failed to open Capstone disassembler.");
-  }
-  error_code = cs_option(capstone_handle, CS_OPT_DETAIL, CS_OPT_ON);
-  if (error_code != CS_ERR_OK) {
-    return ErrorMessage("Failed to configure Capstone disassembler.");
-  }
-  orbit_base::unique_resource close_on_exit{
-      &capstone_handle, [](csh* capstone_handle) { cs_close(capstone_handle); }};
-
   const uint64_t now = orbit_base::CaptureTimestampNs();
   ORBIT_LOG("Calling StartNewCapture at timestamp %d", now);
   OUTCOME_TRY(
@@ -528,6 +685,25 @@ InstrumentedProcess::InstrumentFunctions(const CaptureOptions& capture_options,
 
   ORBIT_LOG("Trying to instrument %d functions", capture_options.instrumented_functions().size());
   InstrumentationManager::InstrumentationResult result;
+
+  // The instrumentation happens in three phases, to keep the time during which the target is
+  // stopped short even for many functions:
+  // 1. Resolve the function addresses, allocate the memory for the new trampolines and read the
+  //    beginning of the functions that don't have a trampoline yet.
+  // 2. Build the new trampolines in parallel. This is where the prologues get disassembled and
+  //    relocated, which takes most of the time, unless they are found in the
+  //    RelocatedPrologueCache.
+  // 3. Write all the trampolines into the tracee in one batch, then the jumps into them for the
+  //    functions that don't have one yet.
+  struct FunctionToInstrument {
+    uint64_t function_id;
+    const std::string* function_name;
+    uint64_t function_address;
+  };
+  std::vector<FunctionToInstrument> functions_to_instrument;
+  std::vector<NewTrampoline> new_trampolines;
+  absl::flat_hash_set<uint64_t> addresses_of_functions_with_new_trampolines;
+  std::vector<AddressRange> function_address_ranges_to_read;
   absl::flat_hash_map<std::string, std::vector<ModuleInfo>> cache_of_modules_from_path;
   for (const auto& function : capture_options.instrumented_functions()) {
     const uint64_t function_id = function.function_id();
@@ -554,7 +730,8 @@ InstrumentedProcess::InstrumentFunctions(const CaptureOptions& capture_options,
       const uint64_t function_address = orbit_module_utils::SymbolVirtualAddressToAbsoluteAddress(
           function.function_virtual_address(), module.address_start(), module.load_bias(),
           module.executable_segment_offset());
-      if (!trampoline_map_.contains(function_address)) {
+      if (!trampoline_map_.contains(function_address) &&
+          !addresses_of_functions_with_new_trampolines.contains(function_address)) {
         const AddressRange module_address_range(module.address_start(), module.address_end());
         auto trampoline_address_or_error = GetTrampolineMemory(module_address_range);
         if (trampoline_address_or_error.has_error()) {
@@ -562,7 +739,6 @@ InstrumentedProcess::InstrumentFunctions(const CaptureOptions& capture_options,
                       trampoline_address_or_error.error().message());
           continue;
         }
-        const uint64_t trampoline_address = trampoline_address_or_error.value();
         // We need the machine code of the function for two purposes: We need to relocate the
         // instructions that get overwritten into the trampoline and we also need to check if the
         // function contains a jump back into the first five bytes (which would prohibit
@@ -570,59 +746,175 @@ InstrumentedProcess::InstrumentFunctions(const CaptureOptions& capture_options,
         // somewhat arbitrarily to cover all cases of jumps into the first five bytes we encountered
         // in the wild. Specifically this covers all relative jumps to a signed 8 bit offset.
         // Compare the comment of CheckForRelativeJumpIntoFirstFiveBytes in Trampoline.cpp.
+        // Functions that are read entirely can also get a cheaper trampoline (compare
+        // `MayUseYmmRegisters`).
         constexpr uint64_t kMaxFunctionReadSize = 200;
         const uint64_t function_read_size =
             std::min(kMaxFunctionReadSize, function.function_size());
-        OUTCOME_TRY(auto&& function_data,
-                    ReadTraceesMemory(pid_, function_address, function_read_size));
-        auto address_after_prologue_or_error =
-            CreateTrampoline(pid_, function_address, function_data, trampoline_address,
-                             entry_payload_function_address_, return_trampoline_address_,
-                             capstone_handle, relocation_map_);
-        if (address_after_prologue_or_error.has_error()) {
-          const std::string message = absl::StrFormat(
-              "Can't instrument function \"%s\". Failed to create trampoline: %s",
-              function.function_name(), address_after_prologue_or_error.error().message());
-          ORBIT_ERROR("%s", message);
-          result.function_ids_to_error_messages[function_id] = message;
-          OUTCOME_TRY(ReleaseMostRecentlyAllocatedTrampolineMemory(module_address_range));
-          continue;
-        }
-        TrampolineData trampoline_data;
-        trampoline_data.trampoline_address = trampoline_address;
-        // We'll overwrite the first five bytes of the function and the rest of the instruction that
-        // we clobbered. Since we'll need to restore that when we remove the instrumentation we need
-        // a backup.
-        constexpr uint64_t kMaxFunctionBackupSize = 20;
-        const uint64_t function_backup_size =
-            std::min(kMaxFunctionBackupSize, function.function_size());
-        OUTCOME_TRY(auto&& function_backup_data,
-                    ReadTraceesMemory(pid_, function_address, function_backup_size));
-        trampoline_data.function_data = function_backup_data;
-        trampoline_data.address_after_prologue = address_after_prologue_or_error.value();
-        trampoline_map_.emplace(function_address, trampoline_data);
+        function_address_ranges_to_read.emplace_back(function_address,
+                                                     function_address + function_read_size);
+        addresses_of_functions_with_new_trampolines.insert(function_address);
+        NewTrampoline& new_trampoline = new_trampolines.emplace_back();
+        new_trampoline.function_address = function_address;
+        new_trampoline.function_name = &function.function_name();
+        new_trampoline.trampoline_address = trampoline_address_or_error.value();
+        new_trampoline.build_id = &function.file_build_id();
+        new_trampoline.function_offset = function.file_offset();
+        new_trampoline.function_data_is_complete = function_read_size == function.function_size();
       }
-      auto it = trampoline_map_.find(function_address);
-      if (it == trampoline_map_.end()) {
+      functions_to_instrument.push_back(FunctionToInstrument{.function_id = function_id,
+                                                             .function_name =
+                                                                 &function.function_name(),
+                                                             .function_address = function_address});
+    }
+  }
+
+  OUTCOME_TRY(auto&& function_data,
+              ReadTraceesMemoryBatch(pid_, function_address_ranges_to_read));
+  ORBIT_CHECK(function_data.size() == new_trampolines.size());
+  for (size_t i = 0; i < new_trampolines.size(); ++i) {
+    NewTrampoline& new_trampoline = new_trampolines[i];
+    new_trampoline.function_data = std::move(function_data[i]);
+    new_trampoline.relocated_prologue = relocated_prologue_cache->Find(
+        *new_trampoline.build_id, new_trampoline.function_offset, new_trampoline.function_data);
+    new_trampoline.relocated_prologue_from_cache = new_trampoline.relocated_prologue.has_value();
+  }
+
+  BuildTrampolinesInParallel(entry_payload_function_address_, return_trampoline_address_,
+                             absl::MakeSpan(new_trampolines));
+  uint64_t relocated_prologues_from_cache_count = 0;
+  for (const NewTrampoline& new_trampoline : new_trampolines) {
+    if (new_trampoline.relocated_prologue_from_cache) {
+      ++relocated_prologues_from_cache_count;
+    } else if (new_trampoline.relocated_prologue.has_value()) {
+      relocated_prologue_cache->Insert(*new_trampoline.build_id, new_trampoline.function_offset,
+                                       new_trampoline.function_data,
+                                       new_trampoline.relocated_prologue.value());
+    }
+  }
+  ORBIT_LOG("Reused %u out of %u relocated prologues", relocated_prologues_from_cache_count,
+            new_trampolines.size());
+
+  absl::flat_hash_map<uint64_t, TrampolineData> new_trampoline_map;
+  absl::flat_hash_map<uint64_t, std::string> function_addresses_to_trampoline_error_messages;
+  for (const NewTrampoline& new_trampoline : new_trampolines) {
+    if (new_trampoline.trampoline_code_or_error.has_error()) {
+      function_addresses_to_trampoline_error_messages.emplace(
+          new_trampoline.function_address,
+          absl::StrFormat("Can't instrument function \"%s\". Failed to create trampoline: %s",
+                          *new_trampoline.function_name,
+                          new_trampoline.trampoline_code_or_error.error().message()));
+      // The memory of this trampoline stays unused, as trampolines are never freed.
+      continue;
+    }
+    TrampolineData trampoline_data;
+    trampoline_data.trampoline_address = new_trampoline.trampoline_address;
+    // We'll overwrite the first five bytes of the function and the rest of the instruction that we
+    // clobbered. Since we'll need to restore that when we remove the instrumentation we need a
+    // backup.
+    constexpr uint64_t kMaxFunctionBackupSize = 20;
+    const uint64_t function_backup_size =
+        std::min<uint64_t>(kMaxFunctionBackupSize, new_trampoline.function_data.size());
+    trampoline_data.function_data.assign(
+        new_trampoline.function_data.begin(),
+        new_trampoline.function_data.begin() + function_backup_size);
+    trampoline_data.address_after_prologue =
+        new_trampoline.trampoline_code_or_error.value().address_after_prologue;
+    new_trampoline_map.emplace(new_trampoline.function_address, std::move(trampoline_data));
+  }
+
+  // The function id each trampoline hands over to the entry payload. If multiple functions share
+  // an address, the last one wins.
+  absl::flat_hash_map<uint64_t, uint64_t> function_addresses_to_function_ids;
+  std::vector<TraceesMemoryWrite> jump_writes;
+  for (const FunctionToInstrument& function : functions_to_instrument) {
+    auto error_message_it =
+        function_addresses_to_trampoline_error_messages.find(function.function_address);
+    if (error_message_it != function_addresses_to_trampoline_error_messages.end()) {
+      ORBIT_ERROR("%s", error_message_it->second);
+      result.function_ids_to_error_messages[function.function_id] = error_message_it->second;
+      continue;
+    }
+    auto it = trampoline_map_.find(function.function_address);
+    if (it == trampoline_map_.end()) {
+      it = new_trampoline_map.find(function.function_address);
+      if (it == new_trampoline_map.end()) {
         continue;
       }
-      const TrampolineData& trampoline_data = it->second;
-
-      auto result_or_error = InstrumentFunction(pid_, function_address, function_id,
-                                                trampoline_data.address_after_prologue,
-                                                trampoline_data.trampoline_address);
-      if (result_or_error.has_error()) {
-        const std::string message =
-            absl::StrFormat("Can't instrument function \"%s\": %s", function.function_name(),
-                            result_or_error.error().message());
-        ORBIT_ERROR("%s", message);
-        result.function_ids_to_error_messages[function_id] = message;
-      } else {
-        addresses_of_instrumented_functions_.insert(function_address);
-        result.instrumented_function_ids.insert(function_id);
-      }
     }
+    const TrampolineData& trampoline_data = it->second;
+
+    auto jump_or_error =
+        BuildJumpToTrampoline(function.function_address, trampoline_data.address_after_prologue,
+                              trampoline_data.trampoline_address);
+    if (jump_or_error.has_error()) {
+      const std::string message =
+          absl::StrFormat("Can't instrument function \"%s\": %s", *function.function_name,
+                          jump_or_error.error().message());
+      ORBIT_ERROR("%s", message);
+      result.function_ids_to_error_messages[function.function_id] = message;
+      continue;
+    }
+    if (function_addresses_to_function_ids
+            .insert_or_assign(function.function_address, function.function_id)
+            .second &&
+        !addresses_of_instrumented_functions_.contains(function.function_address)) {
+      jump_writes.push_back(TraceesMemoryWrite{.start_address = function.function_address,
+                                               .bytes = std::move(jump_or_error.value())});
+    }
+    result.instrumented_function_ids.insert(function.function_id);
+  }
+
+  // New trampolines are written as a whole, including the function id and padded to their fixed
+  // size, such that the consecutive trampolines in a chunk of trampoline memory end up in a single
+  // write. For trampolines created in previous captures, only the function id is updated. The ones
+  // that are still jumped to but are not part of this capture get kInvalidFunctionId.
+  std::vector<TraceesMemoryWrite> trampoline_writes;
+  for (NewTrampoline& new_trampoline : new_trampolines) {
+    if (new_trampoline.trampoline_code_or_error.has_error()) continue;
+    std::vector<uint8_t> code = std::move(new_trampoline.trampoline_code_or_error.value().code);
+    auto function_id_it = function_addresses_to_function_ids.find(new_trampoline.function_address);
+    if (function_id_it != function_addresses_to_function_ids.end()) {
+      const std::vector<uint8_t> function_id_as_bytes = FunctionIdAsBytes(function_id_it->second);
+      std::copy(function_id_as_bytes.begin(), function_id_as_bytes.end(),
+                code.begin() + static_cast<ptrdiff_t>(GetOffsetOfFunctionIdInTrampoline()));
+      function_addresses_to_function_ids.erase(function_id_it);
+    }
+    // The padding is never executed.
+    constexpr uint8_t kInt3 = 0xcc;
+    code.resize(GetMaxTrampolineSize(), kInt3);
+    trampoline_writes.push_back(TraceesMemoryWrite{
+        .start_address = new_trampoline.trampoline_address, .bytes = std::move(code)});
+  }
+  for (const auto& [function_address, function_id] : function_addresses_to_function_ids) {
+    trampoline_writes.push_back(TraceesMemoryWrite{
+        .start_address = trampoline_map_.at(function_address).trampoline_address +
+                         GetOffsetOfFunctionIdInTrampoline(),
+        .bytes = FunctionIdAsBytes(function_id)});
   }
+  for (uint64_t function_address : addresses_of_instrumented_functions_) {
+    if (function_addresses_to_function_ids.contains(function_address)) continue;
+    trampoline_writes.push_back(TraceesMemoryWrite{
+        .start_address = trampoline_map_.at(function_address).trampoline_address +
+                         GetOffsetOfFunctionIdInTrampoline(),
+        .bytes = FunctionIdAsBytes(orbit_grpc_protos::kInvalidFunctionId)});
+  }
+
+  // Only jump into trampolines that have been written successfully.
+  OUTCOME_TRY(WriteTraceesMemoryBatch(pid_, std::move(trampoline_writes)));
+  trampoline_map_.merge(new_trampoline_map);
+  for (const NewTrampoline& new_trampoline : new_trampolines) {
+    if (new_trampoline.trampoline_code_or_error.has_error()) continue;
+    relocation_map_.insert(new_trampoline.relocation_map.begin(),
+                           new_trampoline.relocation_map.end());
+  }
+  // Record the functions before overwriting them, so that all of them are restored on
+  // uninstrumentation, even if only some of the writes below succeed.
+  for (const TraceesMemoryWrite& jump_write : jump_writes) {
+    addresses_of_instrumented_functions_.insert(jump_write.start_address);
+  }
+  OUTCOME_TRY(WriteTraceesMemoryBatch(pid_, std::move(jump_writes)));
+
   ORBIT_LOG("Successfully instrumented %d functions", result.instrumented_function_ids.size());
 
   result.entry_trampoline_address_ranges = GetEntryTrampolineAddressRanges();
@@ -634,6 +926,20 @@ InstrumentedProcess::InstrumentFunctions(const CaptureOptions& capture_options,
 
   OUTCOME_TRY(EnsureTrampolinesExecutable());
 
+  if (calibration_trampoline_memory_ != nullptr) {
+    ErrorMessageOr<uint64_t> function_call_overhead_ns_or_error = ExecuteInProcess(
+        pid_, absl::bit_cast<void*>(measure_function_call_overhead_function_address_),
+        calibration_trampoline_memory_->GetAddress());
+    if (function_call_overhead_ns_or_error.has_error()) {
+      ORBIT_ERROR("Measuring the overhead of the instrumentation: %s",
+                  function_call_overhead_ns_or_error.error().message());
+    } else {
+      result.function_call_overhead_ns = function_call_overhead_ns_or_error.value();
+      ORBIT_LOG("Overhead of the instrumentation per function call: %u ns",
+                result.function_call_overhead_ns);
+    }
+  }
+
   return result;
 }
 
@@ -655,6 +961,7 @@ ErrorMessageOr<void> InstrumentedProcess::UninstrumentFunctions() {
     auto write_result_or_error = WriteTraceesMemory(pid_, function_address, code);
     ORBIT_FAIL_IF(write_result_or_error.has_error(), "%s", write_result_or_error.error().message());
   }
+  addresses_of_instrumented_functions_.clear();
   return outcome::success();
 }
 
@@ -678,15 +985,6 @@ ErrorMessageOr<uint64_t> InstrumentedProcess::GetTrampolineMemory(AddressRange a
   return result;
 }
 
-ErrorMessageOr<void> InstrumentedProcess::ReleaseMostRecentlyAllocatedTrampolineMemory(
-    AddressRange address_range) {
-  if (!trampolines_for_modules_.contains(address_range)) {
-    return ErrorMessage("Tried to release trampoline memory for a non existent address range");
-  }
-  trampolines_for_modules_.find(address_range)->second.back().first_available--;
-  return outcome::success();
-}
-
 ErrorMessageOr<void> InstrumentedProcess::EnsureTrampolinesWritable() {
   for (auto& trampoline_for_module : trampolines_for_modules_) {
     for (auto& memory_chunk : trampoline_for_module.second) {
@@ -721,14 +1019,27 @@ std::vector<AddressRange> InstrumentedProcess::GetEntryTrampolineAddressRanges()
 static std::mutex already_exists_mutex;
 static bool already_exists = false;
 
-std::unique_ptr<InstrumentationManager> InstrumentationManager::Create() {
+std::unique_ptr<InstrumentationManager> InstrumentationManager::Create(
+    std::filesystem::path relocated_prologue_cache_directory) {
   std::unique_lock<std::mutex> lock(already_exists_mutex);
   ORBIT_FAIL_IF(already_exists, "InstrumentationManager should be globally unique.");
   already_exists = true;
-  return std::unique_ptr<InstrumentationManager>(new InstrumentationManager());
+  std::unique_ptr<InstrumentationManager> instrumentation_manager(new InstrumentationManager());
+  instrumentation_manager->relocated_prologue_cache_ =
+      std::make_unique<RelocatedPrologueCache>(std::move(relocated_prologue_cache_directory));
+  return instrumentation_manager;
 }
 
 InstrumentationManager::~InstrumentationManager() {
+  // The instrumentation is kept between captures, so this is where it is removed from the processes
+  // that are still running.
+  for (const auto& [pid, process] : process_map_) {
+    if (!ProcessWithPidExists(pid)) continue;
+    ErrorMessageOr<void> result = process->UninstrumentFunctions();
+    if (result.has_error()) {
+      ORBIT_ERROR("Uninstrumenting process %d: %s", pid, result.error().message());
+    }
+  }
   std::unique_lock<std::mutex> lock(already_exists_mutex);
   already_exists = false;
 }
@@ -768,7 +1079,14 @@ InstrumentationManager::InstrumentProcess(const CaptureOptions& capture_options)
     process_map_.emplace(pid, std::move(process_or_error.value()));
   }
   OUTCOME_TRY(auto&& instrumentation_result,
-              process_map_[pid]->InstrumentFunctions(capture_options, modules));
+              process_map_[pid]->InstrumentFunctions(capture_options, modules,
+                                                     relocated_prologue_cache_.get()));
+
+  // The target process is running again at this point.
+  ErrorMessageOr<void> save_result = relocated_prologue_cache_->Save();
+  if (save_result.has_error()) {
+    ORBIT_ERROR("Saving relocated prologue cache: %s", save_result.error().message());
+  }
 
   return std::move(instrumentation_result);
 }
@@ -4,41 +4,57 @@
 
 #include "OrbitUserSpaceInstrumentation.h"
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include <google/protobuf/arena.h>
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include <stack>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "CaptureEventProducer/LockFreeBufferCaptureEventProducer.h"
+#include "GrpcProtos/Constants.h"
 #include "GrpcProtos/capture.pb.h"
 #include "OrbitBase/Overloaded.h"
 #include "OrbitBase/Profiling.h"
+#include "OrbitBase/SpscRingBuffer.h"
 #include "OrbitBase/ThreadUtils.h"
+#include "OrbitBase/Tsc.h"
 #include "ProducerSideChannel/ProducerSideChannel.h"
 
-using orbit_base::CaptureTimestampNs;
-
 namespace {
 
 struct OpenFunctionCall {
-  OpenFunctionCall(uint64_t return_address, uint64_t timestamp_on_entry_ns)
-      : return_address(return_address), timestamp_on_entry_ns(timestamp_on_entry_ns) {}
+  OpenFunctionCall(uint64_t return_address, uint64_t timestamp_on_entry)
+      : return_address(return_address), timestamp_on_entry(timestamp_on_entry) {}
   uint64_t return_address;
-  uint64_t timestamp_on_entry_ns;
+  // As returned by `ReadTimestamp`: either a capture timestamp or a value of the time stamp
+  // counter.
+  uint64_t timestamp_on_entry;
 };
 
 // The amount of data we store for each call is relevant for the overall performance. The assert is
 // here for awareness and to avoid packing issues in the struct.
 static_assert(sizeof(OpenFunctionCall) == 16, "OpenFunctionCall should be 16 bytes.");
 
-std::stack<OpenFunctionCall>& GetOpenFunctionCallStack() {
-  thread_local std::stack<OpenFunctionCall> open_function_calls;
+// Backed by a vector, which keeps its memory when popping, so that the payloads stop allocating
+// once the stack has grown to the maximum call depth.
+using OpenFunctionCallStack = std::stack<OpenFunctionCall, std::vector<OpenFunctionCall>>;
+
+OpenFunctionCallStack& GetOpenFunctionCallStack() {
+  thread_local OpenFunctionCallStack open_function_calls;
   return open_function_calls;
 }
 
 uint64_t current_capture_start_timestamp_ns = 0;
+// The value of the time stamp counter when `StartNewCapture` was called, to compare with the
+// timestamps of captures that use the time stamp counter.
+uint64_t current_capture_start_tsc = 0;
 
 pid_t orbit_threads[] = {-1, -1, -1, -1, -1, -1};
 
@@ -73,7 +89,31 @@ struct FunctionExit {
   uint64_t timestamp_ns;
 };
 
-using FunctionEntryExitVariant = std::variant<FunctionEntry, FunctionExit>;
+// Reports the function calls that were not recorded because the buffer of their thread was full.
+struct DroppedFunctionCalls {
+  DroppedFunctionCalls() = default;
+  DroppedFunctionCalls(uint64_t count, uint64_t timestamp_ns)
+      : count{count}, timestamp_ns{timestamp_ns} {}
+  uint64_t count;
+  uint64_t timestamp_ns;
+};
+
+using FunctionEntryExitVariant = std::variant<FunctionEntry, FunctionExit, DroppedFunctionCalls>;
+
+// Each thread writes its events to a ring buffer of its own, so that threads running instrumented
+// functions don't contend with each other. The forwarder thread of the producer drains the buffers.
+struct ThreadEventBuffer {
+  // FunctionEntryExitVariant is 48 bytes, so this is 384 kB per thread. This is enough for about
+  // four million events per second and thread, as the buffers are drained every millisecond.
+  static constexpr size_t kCapacity = 8192;
+
+  orbit_base::SpscRingBuffer<FunctionEntryExitVariant> ring_buffer{kCapacity};
+  // Function calls not recorded since the forwarder thread last looked at this buffer.
+  std::atomic<uint64_t> dropped_function_call_count = 0;
+};
+
+// Maps function ids to their InstrumentedFunction::record_one_in_n_calls.
+using CallSamplingPeriods = absl::flat_hash_map<uint64_t, uint32_t>;
 
 // This class is used to enqueue FunctionEntry and FunctionExit events from multiple threads,
 // transform them into orbit_grpc_protos::FunctionEntry and orbit_grpc_protos::FunctionExit protos,
@@ -83,14 +123,95 @@ class LockFreeUserSpaceInstrumentationEventProducer
           FunctionEntryExitVariant> {
  public:
   LockFreeUserSpaceInstrumentationEventProducer() {
+    UseSharedMemoryBuffer();
     BuildAndStart(orbit_producer_side_channel::CreateProducerSideChannel());
   }
 
   ~LockFreeUserSpaceInstrumentationEventProducer() override { ShutdownAndWait(); }
 
+  // Called once per thread, on the first instrumented function the thread runs during a capture.
+  // The buffer is kept until it has been drained after the thread has exited.
+  [[nodiscard]] std::shared_ptr<ThreadEventBuffer> CreateThreadEventBuffer() {
+    auto thread_event_buffer = std::make_shared<ThreadEventBuffer>();
+    absl::MutexLock lock{&thread_event_buffers_mutex_};
+    thread_event_buffers_.push_back(thread_event_buffer);
+    return thread_event_buffer;
+  }
+
+  // Only contains the functions of the current capture with a record_one_in_n_calls greater than 1.
+  // Null if there are none.
+  [[nodiscard]] const CallSamplingPeriods* GetCallSamplingPeriods() const {
+    return call_sampling_periods_.load(std::memory_order_acquire);
+  }
+
  protected:
+  void OnCaptureStart(orbit_grpc_protos::CaptureOptions capture_options) override {
+    auto call_sampling_periods = std::make_unique<CallSamplingPeriods>();
+    for (const auto& function : capture_options.instrumented_functions()) {
+      if (function.record_one_in_n_calls() > 1) {
+        call_sampling_periods->emplace(function.function_id(), function.record_one_in_n_calls());
+      }
+    }
+    // The payloads might still be reading the previous table, so it is never freed. This leaks at
+    // most one small table per capture.
+    call_sampling_periods_.store(
+        call_sampling_periods->empty() ? nullptr : call_sampling_periods.release(),
+        std::memory_order_release);
+    LockFreeBufferCaptureEventProducer::OnCaptureStart(std::move(capture_options));
+  }
+
+  size_t DequeueIntermediateEvents(FunctionEntryExitVariant* events,
+                                   size_t max_event_count) override {
+    // Keep one slot for reporting dropped function calls.
+    const size_t max_function_event_count = max_event_count - 1;
+    size_t event_count = 0;
+    {
+      absl::MutexLock lock{&thread_event_buffers_mutex_};
+      auto it = thread_event_buffers_.begin();
+      while (it != thread_event_buffers_.end()) {
+        // If we hold the only reference, the thread has exited and won't add any more events.
+        const bool thread_exited = it->use_count() == 1;
+        ThreadEventBuffer& thread_event_buffer = **it;
+        const size_t requested_event_count = max_function_event_count - event_count;
+        const size_t dequeued_event_count =
+            thread_event_buffer.ring_buffer.TryPopBulk(events + event_count, requested_event_count);
+        event_count += dequeued_event_count;
+        dropped_function_call_count_ +=
+            thread_event_buffer.dropped_function_call_count.exchange(0, std::memory_order_relaxed);
+        if (thread_exited && dequeued_event_count < requested_event_count) {
+          it = thread_event_buffers_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+    // Report dropped function calls at most once per second, to not flood the client with warnings.
+    constexpr uint64_t kMinNsBetweenDroppedFunctionCallReports = 1'000'000'000;
+    const uint64_t now = orbit_base::CaptureTimestampNs();
+    if (dropped_function_call_count_ > 0 &&
+        now - last_dropped_function_call_report_timestamp_ns_ >=
+            kMinNsBetweenDroppedFunctionCallReports) {
+      events[event_count] = DroppedFunctionCalls{dropped_function_call_count_, now};
+      ++event_count;
+      dropped_function_call_count_ = 0;
+      last_dropped_function_call_report_timestamp_ns_ = now;
+    }
+    return event_count;
+  }
+
   [[nodiscard]] orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
       FunctionEntryExitVariant&& raw_event, google::protobuf::Arena* arena) override {
+    std::visit(orbit_base::Overloaded{
+                   [this](FunctionEntry& raw_event) -> void {
+                     raw_event.timestamp_ns = ToCaptureTimestampNs(raw_event.timestamp_ns);
+                   },
+                   [this](FunctionExit& raw_event) -> void {
+                     raw_event.timestamp_ns = ToCaptureTimestampNs(raw_event.timestamp_ns);
+                   },
+                   [](DroppedFunctionCalls& /*raw_event*/) -> void {}},
+               raw_event);
+
     auto* capture_event =
         google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
 
@@ -111,6 +232,16 @@ class LockFreeUserSpaceInstrumentationEventProducer
                                  function_exit->set_pid(raw_event.pid);
                                  function_exit->set_tid(raw_event.tid);
                                  function_exit->set_timestamp_ns(raw_event.timestamp_ns);
+                               },
+                               [capture_event](const DroppedFunctionCalls& raw_event) -> void {
+                                 orbit_grpc_protos::WarningEvent* warning_event =
+                                     capture_event->mutable_warning_event();
+                                 warning_event->set_timestamp_ns(raw_event.timestamp_ns);
+                                 warning_event->set_message(absl::StrFormat(
+                                     "%u calls of dynamically instrumented functions were not "
+                                     "recorded because the instrumentation buffer of their thread "
+                                     "was full.",
+                                     raw_event.count));
                                }},
         raw_event);
 
@@ -120,6 +251,15 @@ class LockFreeUserSpaceInstrumentationEventProducer
  private:
   template <class>
   [[maybe_unused]] static constexpr bool kAlwaysFalseV = false;
+
+  absl::Mutex thread_event_buffers_mutex_;
+  std::vector<std::shared_ptr<ThreadEventBuffer>> thread_event_buffers_
+      ABSL_GUARDED_BY(thread_event_buffers_mutex_);
+  std::atomic<const CallSamplingPeriods*> call_sampling_periods_ = nullptr;
+
+  // Only accessed by the forwarder thread.
+  uint64_t dropped_function_call_count_ = 0;
+  uint64_t last_dropped_function_call_report_timestamp_ns_ = 0;
 };
 
 LockFreeUserSpaceInstrumentationEventProducer& GetCaptureEventProducer() {
@@ -134,6 +274,29 @@ bool& GetIsInPayload() {
   return is_in_payload;
 }
 
+// Set while `MeasureFunctionCallOverheadNs` calls `CalibrationFunction` through its trampoline.
+bool& GetIsCalibrating() {
+  thread_local bool is_calibrating = false;
+  return is_calibrating;
+}
+
+// Implements InstrumentedFunction::record_one_in_n_calls, per thread.
+bool ShouldRecordCall(uint64_t function_id) {
+  const CallSamplingPeriods* call_sampling_periods =
+      GetCaptureEventProducer().GetCallSamplingPeriods();
+  if (call_sampling_periods == nullptr) return true;
+  auto it = call_sampling_periods->find(function_id);
+  if (it == call_sampling_periods->end()) return true;
+  thread_local absl::flat_hash_map<uint64_t, uint64_t> function_ids_to_call_counts;
+  return function_ids_to_call_counts[function_id]++ % it->second == 0;
+}
+
+ThreadEventBuffer& GetThreadEventBuffer() {
+  thread_local const std::shared_ptr<ThreadEventBuffer> thread_event_buffer =
+      GetCaptureEventProducer().CreateThreadEventBuffer();
+  return *thread_event_buffer;
+}
+
 }  // namespace
 
 // NOTE: All symbols defined here have private linker visibility by default. Symbols that
@@ -156,11 +319,22 @@ bool& GetIsInPayload() {
 
 [[gnu::visibility("default")]] void StartNewCapture(uint64_t capture_start_timestamp_ns) {
   current_capture_start_timestamp_ns = capture_start_timestamp_ns;
+  current_capture_start_tsc = orbit_base::ReadTsc();
 }
 
 [[gnu::visibility("default")]] void EntryPayload(uint64_t return_address, uint64_t function_id,
                                                  uint64_t stack_pointer,
                                                  uint64_t return_trampoline_address) {
+  // Trampolines stay installed between captures. Functions that are not part of the current capture
+  // hand over kInvalidFunctionId. For those, and whenever no capture is running, we return right
+  // away without touching the return address, so the function returns directly to its caller and
+  // `ExitPayload` is not called.
+  const bool is_calibrating = GetIsCalibrating();
+  if (function_id == orbit_grpc_protos::kInvalidFunctionId ||
+      (!is_calibrating && !GetCaptureEventProducer().IsCapturing())) {
+    return;
+  }
+
   bool& is_in_payload = GetIsInPayload();
   // If something in the callgraph below `EntryPayload` or `ExitPayload` was instrumented we need to
   // break the cycle here otherwise we would crash in an infinite recursion.
@@ -177,18 +351,38 @@ bool& GetIsInPayload() {
     return;
   }
 
-  const uint64_t timestamp_on_entry_ns = CaptureTimestampNs();
+  // Calls that are not sampled are not instrumented at all, which also saves the exit trampoline.
+  if (!ShouldRecordCall(function_id)) {
+    is_in_payload = false;
+    return;
+  }
 
-  std::stack<OpenFunctionCall>& open_function_call_stack = GetOpenFunctionCallStack();
-  open_function_call_stack.emplace(return_address, timestamp_on_entry_ns);
+  OpenFunctionCallStack& open_function_call_stack = GetOpenFunctionCallStack();
+  if (is_calibrating) {
+    open_function_call_stack.emplace(return_address, GetCaptureEventProducer().ReadTimestamp());
+    *reinterpret_cast<uint64_t*>(stack_pointer) = return_trampoline_address;
+    is_in_payload = false;
+    return;
+  }
 
-  if (GetCaptureEventProducer().IsCapturing()) {
-    static const uint32_t kPid = orbit_base::GetCurrentProcessId();
-    GetCaptureEventProducer().EnqueueIntermediateEvent(
-        FunctionEntry{kPid, orbit_base::FromNativeThreadId(kTid), function_id, stack_pointer,
-                      return_address, timestamp_on_entry_ns});
+  ThreadEventBuffer& thread_event_buffer = GetThreadEventBuffer();
+  // Make sure there is space for the FunctionEntry and for the FunctionExits of this and all the
+  // open calls, so that a FunctionExit never gets lost. Otherwise this call is not recorded at all.
+  if (!thread_event_buffer.ring_buffer.HasFreeSlots(open_function_call_stack.size() + 2)) {
+    thread_event_buffer.dropped_function_call_count.fetch_add(1, std::memory_order_relaxed);
+    is_in_payload = false;
+    return;
   }
 
+  const uint64_t timestamp_on_entry = GetCaptureEventProducer().ReadTimestamp();
+
+  open_function_call_stack.emplace(return_address, timestamp_on_entry);
+
+  static const uint32_t kPid = orbit_base::GetCurrentProcessId();
+  [[maybe_unused]] const bool pushed = thread_event_buffer.ring_buffer.TryPush(
+      FunctionEntry{kPid, orbit_base::FromNativeThreadId(kTid), function_id, stack_pointer,
+                    return_address, timestamp_on_entry});
+
   // Overwrite return address so that we end up returning to the exit trampoline.
   *reinterpret_cast<uint64_t*>(stack_pointer) = return_trampoline_address;
 
@@ -199,22 +393,61 @@ bool& GetIsInPayload() {
   bool& is_in_payload = GetIsInPayload();
   is_in_payload = true;
 
-  const uint64_t timestamp_on_exit_ns = CaptureTimestampNs();
-  std::stack<OpenFunctionCall>& open_function_call_stack = GetOpenFunctionCallStack();
+  const uint64_t timestamp_on_exit = GetCaptureEventProducer().ReadTimestamp();
+  OpenFunctionCallStack& open_function_call_stack = GetOpenFunctionCallStack();
   OpenFunctionCall current_function_call = open_function_call_stack.top();
   open_function_call_stack.pop();
 
   // Skip emitting an event if we are not capturing or if the function call doesn't fully belong to
   // this capture.
-  if (GetCaptureEventProducer().IsCapturing() &&
-      current_capture_start_timestamp_ns < current_function_call.timestamp_on_entry_ns) {
+  const uint64_t capture_start_timestamp = GetCaptureEventProducer().UsesTscTimestamps()
+                                               ? current_capture_start_tsc
+                                               : current_capture_start_timestamp_ns;
+  if (!GetIsCalibrating() && GetCaptureEventProducer().IsCapturing() &&
+      capture_start_timestamp < current_function_call.timestamp_on_entry) {
     static uint32_t pid = orbit_base::GetCurrentProcessId();
     thread_local uint32_t tid = orbit_base::GetCurrentThreadId();
-    GetCaptureEventProducer().EnqueueIntermediateEvent(
-        FunctionExit{pid, tid, timestamp_on_exit_ns});
+    // Can't fail, as `EntryPayload` made sure there is space for this event.
+    [[maybe_unused]] const bool pushed =
+        GetThreadEventBuffer().ring_buffer.TryPush(FunctionExit{pid, tid, timestamp_on_exit});
   }
 
   is_in_payload = false;
 
   return current_function_call.return_address;
 }
+
+[[gnu::visibility("default")]] [[gnu::noinline]] void CalibrationFunction() {
+  // Needs to be at least five bytes long, such that its prologue can be relocated into a
+  // trampoline.
+  __asm__ __volatile__("nop\nnop\nnop\nnop\nnop" :::);
+}
+
+[[gnu::visibility("default")]] uint64_t MeasureFunctionCallOverheadNs(
+    uint64_t calibration_trampoline_address) {
+  auto* calibration_function_through_trampoline =
+      reinterpret_cast<void (*)()>(calibration_trampoline_address);
+  // Each round is timed separately, and the fastest one is taken, to ignore preemptions.
+  constexpr int kRounds = 10;
+  constexpr int kCallsPerRound = 100;
+  auto measure_ns_per_call = [](void (*function)()) {
+    uint64_t min_duration_ns = UINT64_MAX;
+    for (int round = 0; round < kRounds; ++round) {
+      const uint64_t start_ns = orbit_base::CaptureTimestampNs();
+      for (int i = 0; i < kCallsPerRound; ++i) {
+        function();
+      }
+      min_duration_ns = std::min(min_duration_ns, orbit_base::CaptureTimestampNs() - start_ns);
+    }
+    return min_duration_ns / kCallsPerRound;
+  };
+
+  GetIsCalibrating() = true;
+  // Initializes the thread local variables of the payloads.
+  calibration_function_through_trampoline();
+  const uint64_t instrumented_ns_per_call =
+      measure_ns_per_call(calibration_function_through_trampoline);
+  GetIsCalibrating() = false;
+  const uint64_t ns_per_call = measure_ns_per_call(&CalibrationFunction);
+  return instrumented_ns_per_call > ns_per_call ? instrumented_ns_per_call - ns_per_call : 0;
+}
@@ -35,4 +35,13 @@ extern "C" void EntryPayload(uint64_t return_address, uint64_t function_id, uint
 // the function such that the execution can be continued there.
 extern "C" uint64_t ExitPayload();
 
+// Does nothing. OrbitService builds a trampoline for this function, but never overwrites its
+// prologue, to measure the overhead of the instrumentation with `MeasureFunctionCallOverheadNs`.
+extern "C" void CalibrationFunction();
+
+// Returns by how much calling `CalibrationFunction` through the trampoline at
+// `calibration_trampoline_address` is slower than calling it directly, in nanoseconds. The payloads
+// do their usual work on these calls, except that they don't emit any events.
+extern "C" uint64_t MeasureFunctionCallOverheadNs(uint64_t calibration_trampoline_address);
+
 #endif  // ORBIT_USER_SPACE_INSTRUMENTATION_H_
\ No newline at end of file
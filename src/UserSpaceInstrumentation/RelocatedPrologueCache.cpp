@@ -0,0 +1,255 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "RelocatedPrologueCache.h"
+
+#include <absl/strings/str_format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ReadFileToString.h"
+
+namespace orbit_user_space_instrumentation {
+
+namespace {
+
+// The file starts with kMagic and kVersion, followed by the entries. kVersion needs to be increased
+// whenever the format or what `RelocatePrologue` computes changes, which invalidates all existing
+// files.
+constexpr std::string_view kMagic = "ORBITRPC";
+constexpr uint32_t kVersion = 2;
+
+template <typename T>
+void AppendValue(std::string* content, const T& value) {
+  content->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendBytes(std::string* content, absl::Span<const uint8_t> bytes) {
+  AppendValue(content, static_cast<uint32_t>(bytes.size()));
+  content->append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+// Reads the content of a cache file, making sure not to read past its end.
+class ContentReader {
+ public:
+  explicit ContentReader(std::string_view content) : content_{content} {}
+
+  template <typename T>
+  [[nodiscard]] ErrorMessageOr<T> ReadValue() {
+    if (content_.size() < sizeof(T)) {
+      return ErrorMessage{"Unexpected end of file"};
+    }
+    T value;
+    std::memcpy(&value, content_.data(), sizeof(T));
+    content_.remove_prefix(sizeof(T));
+    return value;
+  }
+
+  [[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> ReadBytes() {
+    OUTCOME_TRY(uint32_t size, ReadValue<uint32_t>());
+    if (content_.size() < size) {
+      return ErrorMessage{"Unexpected end of file"};
+    }
+    std::vector<uint8_t> bytes(content_.begin(), content_.begin() + size);
+    content_.remove_prefix(size);
+    return bytes;
+  }
+
+  [[nodiscard]] bool IsEmpty() const { return content_.empty(); }
+
+ private:
+  std::string_view content_;
+};
+
+[[nodiscard]] ErrorMessageOr<RelocatedPrologue::Fixup> ReadFixup(ContentReader* reader,
+                                                                 size_t code_size) {
+  RelocatedPrologue::Fixup fixup;
+  OUTCOME_TRY(uint8_t type, reader->ReadValue<uint8_t>());
+  OUTCOME_TRY(fixup.position, reader->ReadValue<uint64_t>());
+  OUTCOME_TRY(fixup.target, reader->ReadValue<uint64_t>());
+  OUTCOME_TRY(fixup.end_of_instruction, reader->ReadValue<uint64_t>());
+  // Make sure the fixup can't write outside of the code.
+  uint64_t size_of_address = 0;
+  switch (static_cast<RelocatedPrologue::Fixup::Type>(type)) {
+    case RelocatedPrologue::Fixup::Type::kRipRelativeDisplacement:
+      size_of_address = sizeof(int32_t);
+      break;
+    case RelocatedPrologue::Fixup::Type::kAbsoluteAddressInFunction:
+    case RelocatedPrologue::Fixup::Type::kAbsoluteAddressInRelocatedCode:
+      size_of_address = sizeof(uint64_t);
+      break;
+    default:
+      return ErrorMessage{absl::StrFormat("Unknown fixup type %u", type)};
+  }
+  if (fixup.position > code_size || code_size - fixup.position < size_of_address) {
+    return ErrorMessage{"Fixup out of bounds"};
+  }
+  fixup.type = static_cast<RelocatedPrologue::Fixup::Type>(type);
+  return fixup;
+}
+
+[[nodiscard]] ErrorMessageOr<void> ReadEntry(
+    ContentReader* reader, uint64_t* function_offset, std::vector<uint8_t>* function,
+    RelocatedPrologue* relocated_prologue) {
+  OUTCOME_TRY(*function_offset, reader->ReadValue<uint64_t>());
+  OUTCOME_TRY(*function, reader->ReadBytes());
+  OUTCOME_TRY(relocated_prologue->code, reader->ReadBytes());
+  OUTCOME_TRY(relocated_prologue->prologue_size, reader->ReadValue<uint64_t>());
+  OUTCOME_TRY(uint32_t instruction_count, reader->ReadValue<uint32_t>());
+  for (uint32_t i = 0; i < instruction_count; ++i) {
+    OUTCOME_TRY(uint64_t instruction_offset, reader->ReadValue<uint64_t>());
+    OUTCOME_TRY(uint64_t relocated_instruction_offset, reader->ReadValue<uint64_t>());
+    relocated_prologue->instruction_offsets.emplace_back(instruction_offset,
+                                                         relocated_instruction_offset);
+  }
+  OUTCOME_TRY(uint32_t fixup_count, reader->ReadValue<uint32_t>());
+  for (uint32_t i = 0; i < fixup_count; ++i) {
+    OUTCOME_TRY(RelocatedPrologue::Fixup fixup,
+                ReadFixup(reader, relocated_prologue->code.size()));
+    relocated_prologue->fixups.push_back(fixup);
+  }
+  OUTCOME_TRY(uint8_t function_may_use_ymm_registers, reader->ReadValue<uint8_t>());
+  relocated_prologue->function_may_use_ymm_registers = function_may_use_ymm_registers != 0;
+  return outcome::success();
+}
+
+void AppendEntry(std::string* content, uint64_t function_offset,
+                 absl::Span<const uint8_t> function, const RelocatedPrologue& relocated_prologue) {
+  AppendValue(content, function_offset);
+  AppendBytes(content, function);
+  AppendBytes(content, relocated_prologue.code);
+  AppendValue(content, relocated_prologue.prologue_size);
+  AppendValue(content, static_cast<uint32_t>(relocated_prologue.instruction_offsets.size()));
+  for (const auto& [instruction_offset, relocated_instruction_offset] :
+       relocated_prologue.instruction_offsets) {
+    AppendValue(content, instruction_offset);
+    AppendValue(content, relocated_instruction_offset);
+  }
+  AppendValue(content, static_cast<uint32_t>(relocated_prologue.fixups.size()));
+  for (const RelocatedPrologue::Fixup& fixup : relocated_prologue.fixups) {
+    AppendValue(content, static_cast<uint8_t>(fixup.type));
+    AppendValue(content, fixup.position);
+    AppendValue(content, fixup.target);
+    AppendValue(content, fixup.end_of_instruction);
+  }
+  AppendValue(content, static_cast<uint8_t>(relocated_prologue.function_may_use_ymm_registers));
+}
+
+}  // namespace
+
+std::optional<RelocatedPrologue> RelocatedPrologueCache::Find(std::string_view build_id,
+                                                              uint64_t function_offset,
+                                                              absl::Span<const uint8_t> function) {
+  if (build_id.empty()) return std::nullopt;
+  const Module& module = GetOrLoadModule(build_id);
+  auto it = module.entries.find(function_offset);
+  if (it == module.entries.end()) return std::nullopt;
+  const Entry& entry = it->second;
+  if (!std::equal(entry.function.begin(), entry.function.end(), function.begin(),
+                  function.end())) {
+    return std::nullopt;
+  }
+  return entry.relocated_prologue;
+}
+
+void RelocatedPrologueCache::Insert(std::string_view build_id, uint64_t function_offset,
+                                    absl::Span<const uint8_t> function,
+                                    RelocatedPrologue relocated_prologue) {
+  if (build_id.empty()) return;
+  Module& module = GetOrLoadModule(build_id);
+  module.entries.insert_or_assign(
+      function_offset, Entry{.function = std::vector<uint8_t>(function.begin(), function.end()),
+                             .relocated_prologue = std::move(relocated_prologue)});
+  module.modified = true;
+}
+
+ErrorMessageOr<void> RelocatedPrologueCache::Save() {
+  if (directory_.empty()) return outcome::success();
+  bool directory_exists = false;
+  for (auto& [build_id, module] : modules_) {
+    if (!module.modified) continue;
+    std::optional<std::filesystem::path> file_path = GetFilePath(build_id);
+    if (!file_path.has_value()) continue;
+    if (!directory_exists) {
+      OUTCOME_TRY(orbit_base::CreateDirectories(directory_));
+      directory_exists = true;
+    }
+
+    std::string content{kMagic};
+    AppendValue(&content, kVersion);
+    for (const auto& [function_offset, entry] : module.entries) {
+      AppendEntry(&content, function_offset, entry.function, entry.relocated_prologue);
+    }
+
+    // Write to a temporary file first, such that a concurrent reader never sees a partial file.
+    std::filesystem::path temporary_file_path = file_path.value();
+    temporary_file_path += ".tmp";
+    {
+      OUTCOME_TRY(auto&& fd, orbit_base::OpenFileForWriting(temporary_file_path));
+      OUTCOME_TRY(orbit_base::WriteFully(fd, content));
+    }
+    OUTCOME_TRY(orbit_base::MoveOrRenameFile(temporary_file_path, file_path.value()));
+    module.modified = false;
+  }
+  return outcome::success();
+}
+
+RelocatedPrologueCache::Module& RelocatedPrologueCache::GetOrLoadModule(
+    std::string_view build_id) {
+  auto [it, inserted] = modules_.try_emplace(build_id);
+  Module& module = it->second;
+  if (!inserted) return module;
+
+  std::optional<std::filesystem::path> file_path = GetFilePath(build_id);
+  if (!file_path.has_value()) return module;
+  ErrorMessageOr<bool> exists = orbit_base::FileOrDirectoryExists(file_path.value());
+  if (exists.has_error() || !exists.value()) return module;
+  ErrorMessageOr<std::string> content_or_error = orbit_base::ReadFileToString(file_path.value());
+  if (content_or_error.has_error()) {
+    ORBIT_ERROR("Reading relocated prologue cache \"%s\": %s", file_path.value().string(),
+                content_or_error.error().message());
+    return module;
+  }
+
+  std::string_view content = content_or_error.value();
+  if (content.substr(0, kMagic.size()) != kMagic) {
+    ORBIT_ERROR("\"%s\" is not a relocated prologue cache", file_path.value().string());
+    return module;
+  }
+  ContentReader reader{content.substr(kMagic.size())};
+  ErrorMessageOr<uint32_t> version = reader.ReadValue<uint32_t>();
+  // Files of other versions are silently replaced on the next `Save`.
+  if (version.has_error() || version.value() != kVersion) return module;
+  while (!reader.IsEmpty()) {
+    uint64_t function_offset = 0;
+    Entry entry;
+    ErrorMessageOr<void> result =
+        ReadEntry(&reader, &function_offset, &entry.function, &entry.relocated_prologue);
+    if (result.has_error()) {
+      ORBIT_ERROR("Reading relocated prologue cache \"%s\": %s", file_path.value().string(),
+                  result.error().message());
+      module.entries.clear();
+      return module;
+    }
+    module.entries.insert_or_assign(function_offset, std::move(entry));
+  }
+  return module;
+}
+
+std::optional<std::filesystem::path> RelocatedPrologueCache::GetFilePath(
+    std::string_view build_id) const {
+  if (directory_.empty()) return std::nullopt;
+  // The build id is used as file name, so only accept the usual hexadecimal build ids.
+  const bool is_hexadecimal = std::all_of(build_id.begin(), build_id.end(), [](char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+  });
+  if (!is_hexadecimal) return std::nullopt;
+  return directory_ / build_id;
+}
+
+}  // namespace orbit_user_space_instrumentation
@@ -0,0 +1,71 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef USER_SPACE_INSTRUMENTATION_RELOCATED_PROLOGUE_CACHE_H_
+#define USER_SPACE_INSTRUMENTATION_RELOCATED_PROLOGUE_CACHE_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/types/span.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "OrbitBase/Result.h"
+#include "Trampoline.h"
+
+namespace orbit_user_space_instrumentation {
+
+// Caches the results of `RelocatePrologue` for the functions of modules identified by their build
+// id, such that instrumenting the same function again, in another process or in a later run of
+// OrbitService, doesn't require disassembling it. The functions are identified by their offset in
+// the module file. An entry is only used if the beginning of the function is the same as when the
+// entry was created, so a stale or corrupted cache can't cause a wrong relocation.
+//
+// If a directory is given, the entries of each module are persisted in a file named after the build
+// id in that directory. The file of a module is read the first time the module is looked up, and
+// rewritten by `Save` if entries have been added since.
+class RelocatedPrologueCache {
+ public:
+  // An empty `directory` keeps the cache in memory only.
+  explicit RelocatedPrologueCache(std::filesystem::path directory)
+      : directory_{std::move(directory)} {}
+
+  // `function` is the beginning of the function, as passed to `RelocatePrologue`.
+  [[nodiscard]] std::optional<RelocatedPrologue> Find(std::string_view build_id,
+                                                      uint64_t function_offset,
+                                                      absl::Span<const uint8_t> function);
+
+  void Insert(std::string_view build_id, uint64_t function_offset,
+              absl::Span<const uint8_t> function, RelocatedPrologue relocated_prologue);
+
+  // Writes the files of the modules that have been modified since they were last saved. The
+  // directory is created if necessary.
+  [[nodiscard]] ErrorMessageOr<void> Save();
+
+ private:
+  struct Entry {
+    std::vector<uint8_t> function;
+    RelocatedPrologue relocated_prologue;
+  };
+  struct Module {
+    // Maps function offsets to entries.
+    absl::flat_hash_map<uint64_t, Entry> entries;
+    bool modified = false;
+  };
+
+  [[nodiscard]] Module& GetOrLoadModule(std::string_view build_id);
+  [[nodiscard]] std::optional<std::filesystem::path> GetFilePath(std::string_view build_id) const;
+
+  std::filesystem::path directory_;
+  absl::flat_hash_map<std::string, Module> modules_;
+};
+
+}  // namespace orbit_user_space_instrumentation
+
+#endif  // USER_SPACE_INSTRUMENTATION_RELOCATED_PROLOGUE_CACHE_H_
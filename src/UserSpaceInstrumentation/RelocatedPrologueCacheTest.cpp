@@ -0,0 +1,115 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/Result.h"
+#include "RelocatedPrologueCache.h"
+#include "TestUtils/TemporaryDirectory.h"
+#include "TestUtils/TestUtils.h"
+#include "Trampoline.h"
+
+namespace orbit_user_space_instrumentation {
+
+namespace {
+
+using orbit_test_utils::HasNoError;
+using orbit_test_utils::TemporaryDirectory;
+
+constexpr const char* kBuildId = "0123456789abcdef";
+constexpr uint64_t kFunctionOffset = 0x1234;
+const std::vector<uint8_t> kFunction{0x48, 0x8b, 0x05, 0x10, 0x00, 0x00, 0x00, 0xeb, 0xf7, 0xc3};
+
+// The relocation of "mov rax, [rip + 0x10]; jmp -9", the latter jumping to the beginning of the
+// function.
+[[nodiscard]] RelocatedPrologue MakeRelocatedPrologue() {
+  RelocatedPrologue relocated_prologue;
+  relocated_prologue.code = {0x48, 0x8b, 0x05, 0x10, 0x00, 0x00, 0x00, 0xff, 0x25, 0x00, 0x00,
+                             0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  relocated_prologue.prologue_size = 9;
+  relocated_prologue.instruction_offsets = {{0, 0}, {7, 7}};
+  relocated_prologue.fixups = {
+      {.type = RelocatedPrologue::Fixup::Type::kRipRelativeDisplacement,
+       .position = 3,
+       .target = 0x17,
+       .end_of_instruction = 7},
+      {.type = RelocatedPrologue::Fixup::Type::kAbsoluteAddressInRelocatedCode,
+       .position = 13,
+       .target = 0}};
+  relocated_prologue.function_may_use_ymm_registers = false;
+  return relocated_prologue;
+}
+
+}  // namespace
+
+TEST(RelocatedPrologueCache, FindsInsertedEntriesOnlyForTheSameFunctionBytes) {
+  RelocatedPrologueCache cache{""};
+  EXPECT_EQ(cache.Find(kBuildId, kFunctionOffset, kFunction), std::nullopt);
+  cache.Insert(kBuildId, kFunctionOffset, kFunction, MakeRelocatedPrologue());
+
+  EXPECT_EQ(cache.Find(kBuildId, kFunctionOffset, kFunction), MakeRelocatedPrologue());
+  EXPECT_EQ(cache.Find(kBuildId, kFunctionOffset + 1, kFunction), std::nullopt);
+  EXPECT_EQ(cache.Find("fedcba9876543210", kFunctionOffset, kFunction), std::nullopt);
+  std::vector<uint8_t> modified_function = kFunction;
+  modified_function[0] = 0xcc;
+  EXPECT_EQ(cache.Find(kBuildId, kFunctionOffset, modified_function), std::nullopt);
+  EXPECT_THAT(cache.Save(), HasNoError());
+}
+
+TEST(RelocatedPrologueCache, IgnoresEmptyBuildIds) {
+  RelocatedPrologueCache cache{""};
+  cache.Insert("", kFunctionOffset, kFunction, MakeRelocatedPrologue());
+  EXPECT_EQ(cache.Find("", kFunctionOffset, kFunction), std::nullopt);
+}
+
+TEST(RelocatedPrologueCache, SaveAndLoad) {
+  ErrorMessageOr<TemporaryDirectory> temporary_directory_or_error = TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_directory_or_error, HasNoError());
+  const std::filesystem::path directory =
+      temporary_directory_or_error.value().GetDirectoryPath() / "cache";
+  {
+    RelocatedPrologueCache cache{directory};
+    cache.Insert(kBuildId, kFunctionOffset, kFunction, MakeRelocatedPrologue());
+    EXPECT_THAT(cache.Save(), HasNoError());
+  }
+  EXPECT_TRUE(std::filesystem::exists(directory / kBuildId));
+
+  RelocatedPrologueCache cache{directory};
+  EXPECT_EQ(cache.Find(kBuildId, kFunctionOffset, kFunction), MakeRelocatedPrologue());
+}
+
+TEST(RelocatedPrologueCache, IgnoresCorruptedFiles) {
+  ErrorMessageOr<TemporaryDirectory> temporary_directory_or_error = TemporaryDirectory::Create();
+  ASSERT_THAT(temporary_directory_or_error, HasNoError());
+  const std::filesystem::path& directory = temporary_directory_or_error.value().GetDirectoryPath();
+  {
+    RelocatedPrologueCache cache{directory};
+    cache.Insert(kBuildId, kFunctionOffset, kFunction, MakeRelocatedPrologue());
+    EXPECT_THAT(cache.Save(), HasNoError());
+  }
+
+  // Truncate the file in the middle of the entry.
+  ErrorMessageOr<std::string> content = orbit_base::ReadFileToString(directory / kBuildId);
+  ASSERT_THAT(content, HasNoError());
+  content.value().resize(content.value().size() - 3);
+  {
+    ErrorMessageOr<orbit_base::UniqueFd> fd = orbit_base::OpenFileForWriting(directory / kBuildId);
+    ASSERT_THAT(fd, HasNoError());
+    ASSERT_THAT(orbit_base::WriteFully(fd.value(), content.value()), HasNoError());
+  }
+
+  RelocatedPrologueCache cache{directory};
+  EXPECT_EQ(cache.Find(kBuildId, kFunctionOffset, kFunction), std::nullopt);
+}
+
+}  // namespace orbit_user_space_instrumentation
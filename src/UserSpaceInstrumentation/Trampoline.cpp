@@ -227,7 +227,16 @@ bool CheckForRelativeJumpIntoFirstFiveBytes(uint64_t function_address,
 //
 // In conclusion, we are backing up: RAX, RCX, RDX, RSI, RDI, R8, R9, R10, R11, XMM0-15 (YMM0-15 if
 // AVX is available).
-void AppendBackupCode(MachineCode& trampoline) {
+//
+// The upper halves of YMM0-15 are volatile in all the calling conventions we consider, so they only
+// need to be backed up for the instrumented function itself, which might receive vector arguments
+// in them. Our payload functions are not compiled for AVX; still, they can call into code that
+// uses AVX and then zeroes the upper halves with vzeroupper. If `MayUseYmmRegisters` proved that
+// the instrumented function doesn't access any YMM register, `back_up_ymm_registers` can be false
+// and only XMM0-15 are backed up. The VEX encoding is used in this case as well, to avoid the
+// penalty of transitioning between AVX and legacy SSE code. The code has the same size in both
+// cases, so the offset of the function id doesn't depend on it.
+void AppendBackupCode(bool back_up_ymm_registers, MachineCode& trampoline) {
   // Back up the general purpose registers on the stack.
   //
   // push rax        50
@@ -263,7 +272,45 @@ void AppendBackupCode(MachineCode& trampoline) {
 
   // Back up the vector registers on the stack. If AVX is supported, back up ymm{0,..,15} (which
   // include the xmm{0,..,15} registers as their lower half).
-  if (HasAvx()) {
+  if (HasAvx() && !back_up_ymm_registers) {
+    // sub       rsp, 16            48 83 ec 10
+    // vmovdqa   [rsp], xmm0        c5 f9 7f 04 24
+    // ...
+    // sub       rsp, 16            48 83 ec 10
+    // vmovdqa   [rsp], xmm15       c5 79 7f 3c 24
+    trampoline.AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x7f, 0x04, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x7f, 0x0c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x7f, 0x14, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x7f, 0x1c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x7f, 0x24, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x7f, 0x2c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x7f, 0x34, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x7f, 0x3c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x7f, 0x04, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x7f, 0x0c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x7f, 0x14, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x7f, 0x1c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x7f, 0x24, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x7f, 0x2c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x7f, 0x34, 0x24})
+        .AppendBytes({0x48, 0x83, 0xec, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x7f, 0x3c, 0x24});
+  } else if (HasAvx()) {
     // sub       rsp, 32            48 83 ec 20
     // vmovdqa   [rsp], ymm0        c5 fd 7f 04 24
     // ...
@@ -376,9 +423,47 @@ void AppendCallToEntryPayload(uint64_t entry_payload_function_address,
       .AppendBytes({0xff, 0xd0});
 }
 
-void AppendRestoreCode(MachineCode& trampoline) {
+void AppendRestoreCode(bool back_up_ymm_registers, MachineCode& trampoline) {
   // Restore the vector registers (see comment on AppendBackupCode above).
-  if (HasAvx()) {
+  if (HasAvx() && !back_up_ymm_registers) {
+    // vmovdqa   xmm15, [rsp]        c5 79 6f 3c 24
+    // add       rsp, 16             48 83 c4 10
+    // ...
+    // vmovdqa   xmm0, [rsp]         c5 f9 6f 04 24
+    // add       rsp, 16             48 83 c4 10
+    trampoline.AppendBytes({0xc5, 0x79, 0x6f, 0x3c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x6f, 0x34, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x6f, 0x2c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x6f, 0x24, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x6f, 0x1c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x6f, 0x14, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x6f, 0x0c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0x79, 0x6f, 0x04, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x6f, 0x3c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x6f, 0x34, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x6f, 0x2c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x6f, 0x24, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x6f, 0x1c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x6f, 0x14, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x6f, 0x0c, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10})
+        .AppendBytes({0xc5, 0xf9, 0x6f, 0x04, 0x24})
+        .AppendBytes({0x48, 0x83, 0xc4, 0x10});
+  } else if (HasAvx()) {
     // vmovdqa   ymm15, [rsp]        c5 7d 6f 3c 24
     // add       rsp, 32             48 83 c4 20
     // ...
@@ -482,68 +567,6 @@ void AppendRestoreCode(MachineCode& trampoline) {
       .AppendBytes({0x58});
 }
 
-// Relocates instructions beginning at `function_address` into the trampoline until `kSizeOfJmp`
-// bytes at the beginning of the function are cleared.
-// Returns a mapping from old instruction start addresses in the function to new addresses in the
-// trampoline. The map is meant to be used to move instruction pointers inside the overwritten areas
-// into the correct positions in the trampoline. Therefore, only the instructions after the first
-// one are included (function_address will contain a valid instruction - the jump into the
-// trampoline - when we are done).
-[[nodiscard]] ErrorMessageOr<uint64_t> AppendRelocatedPrologueCode(
-    uint64_t function_address, absl::Span<const uint8_t> function, uint64_t trampoline_address,
-    csh capstone_handle, absl::flat_hash_map<uint64_t, uint64_t>& global_relocation_map,
-    MachineCode& trampoline) {
-  cs_insn* instruction = cs_malloc(capstone_handle);
-  ORBIT_FAIL_IF(instruction == nullptr, "Failed to allocate memory for capstone disassembler.");
-  orbit_base::unique_resource scope_exit{instruction,
-                                         [](cs_insn* instruction) { cs_free(instruction, 1); }};
-  std::vector<uint8_t> trampoline_code;
-  const uint8_t* code_pointer = function.data();
-  size_t code_size = function.size();
-  uint64_t disassemble_address = function_address;
-  std::vector<size_t> relocateable_addresses;
-  absl::flat_hash_map<uint64_t, uint64_t> relocation_map;
-  while ((disassemble_address - function_address < kSizeOfJmp) &&
-         cs_disasm_iter(capstone_handle, &code_pointer, &code_size, &disassemble_address,
-                        instruction)) {
-    const uint64_t original_instruction_address = disassemble_address - instruction->size;
-    const uint64_t relocated_instruction_address =
-        trampoline_address + trampoline.GetResultAsVector().size() + trampoline_code.size();
-    relocation_map.insert_or_assign(original_instruction_address, relocated_instruction_address);
-    OUTCOME_TRY(auto&& relocated_instruction,
-                RelocateInstruction(instruction, original_instruction_address,
-                                    relocated_instruction_address));
-    if (relocated_instruction.position_of_absolute_address.has_value()) {
-      const size_t offset = relocated_instruction.position_of_absolute_address.value();
-      const size_t instruction_address = trampoline_code.size();
-      relocateable_addresses.push_back(instruction_address + offset);
-    }
-    trampoline_code.insert(trampoline_code.end(), relocated_instruction.code.begin(),
-                           relocated_instruction.code.end());
-  }
-
-  if (disassemble_address - function_address < kSizeOfJmp) {
-    return ErrorMessage(
-        absl::StrFormat("Unable to disassemble enough of the function to instrument it. Code: %s",
-                        BytesAsString(function)));
-  }
-
-  // Relocate addresses encoded in the trampoline.
-  for (size_t pos : relocateable_addresses) {
-    uint64_t address_in_trampoline{};
-    std::memcpy(&address_in_trampoline, trampoline_code.data() + pos,
-                sizeof(address_in_trampoline));
-    auto it = relocation_map.find(address_in_trampoline);
-    if (it != relocation_map.end()) {
-      std::memcpy(trampoline_code.data() + pos, &it->second, sizeof(it->second));
-    }
-  }
-
-  trampoline.AppendBytes(trampoline_code);
-  global_relocation_map.insert(relocation_map.begin(), relocation_map.end());
-  return disassemble_address;
-}
-
 [[nodiscard]] ErrorMessageOr<void> AppendJumpBackCode(uint64_t address_after_prologue,
                                                       uint64_t trampoline_address,
                                                       MachineCode& trampoline) {
@@ -1050,6 +1073,7 @@ ErrorMessageOr<RelocatedInstruction> RelocateInstruction(cs_insn* instruction, u
     memcpy(result.code.data(), instruction->bytes, instruction->size);
     *absl::bit_cast<int32_t*>(result.code.data() + instruction->detail->x86.encoding.disp_offset) =
         new_displacement_or_error.value();
+    result.position_of_rip_relative_displacement = instruction->detail->x86.encoding.disp_offset;
   } else if (instruction->detail->x86.opcode[0] == 0xeb ||
              instruction->detail->x86.opcode[0] == 0xe9) {
     // This handles unconditional jump to relative immediate parameter (32 bit or 8 bit).
@@ -1148,14 +1172,80 @@ ErrorMessageOr<RelocatedInstruction> RelocateInstruction(cs_insn* instruction, u
   return result;
 }
 
+bool MayUseYmmRegisters(absl::Span<const uint8_t> function, csh capstone_handle) {
+  cs_insn* instruction = cs_malloc(capstone_handle);
+  ORBIT_FAIL_IF(instruction == nullptr, "Failed to allocate memory for capstone disassembler.");
+  orbit_base::unique_resource scope_exit{instruction,
+                                         [](cs_insn* instruction) { cs_free(instruction, 1); }};
+
+  const uint8_t* code_pointer = function.data();
+  size_t code_size = function.size();
+  uint64_t disassemble_offset = 0;
+  while (cs_disasm_iter(capstone_handle, &code_pointer, &code_size, &disassemble_offset,
+                        instruction)) {
+    // Code outside of the function, reached by a call or a jump, might access the YMM registers.
+    if (cs_insn_group(capstone_handle, instruction, CS_GRP_CALL) ||
+        cs_insn_group(capstone_handle, instruction, CS_GRP_INT)) {
+      return true;
+    }
+    if (cs_insn_group(capstone_handle, instruction, CS_GRP_JUMP)) {
+      const cs_x86& x86 = instruction->detail->x86;
+      if (x86.op_count != 1 || x86.operands[0].type != X86_OP_IMM ||
+          static_cast<uint64_t>(x86.operands[0].imm) >= function.size()) {
+        return true;
+      }
+    }
+    // These save or restore the entire extended state, including the upper halves of the YMM
+    // registers, without referring to them as operands.
+    switch (instruction->id) {
+      case X86_INS_XSAVE:
+      case X86_INS_XSAVE64:
+      case X86_INS_XSAVEC:
+      case X86_INS_XSAVEC64:
+      case X86_INS_XSAVEOPT:
+      case X86_INS_XSAVEOPT64:
+      case X86_INS_XSAVES:
+      case X86_INS_XSAVES64:
+      case X86_INS_XRSTOR:
+      case X86_INS_XRSTOR64:
+      case X86_INS_XRSTORS:
+      case X86_INS_XRSTORS64:
+        return true;
+      default:
+        break;
+    }
+    // This includes implicit operands and the index registers of vector memory operands.
+    cs_regs registers_read;
+    cs_regs registers_written;
+    uint8_t registers_read_count = 0;
+    uint8_t registers_written_count = 0;
+    if (cs_regs_access(capstone_handle, instruction, registers_read, &registers_read_count,
+                       registers_written, &registers_written_count) != CS_ERR_OK) {
+      return true;
+    }
+    auto is_ymm_or_zmm_register = [](uint16_t reg) {
+      return (reg >= X86_REG_YMM0 && reg <= X86_REG_YMM31) ||
+             (reg >= X86_REG_ZMM0 && reg <= X86_REG_ZMM31);
+    };
+    if (std::any_of(registers_read, registers_read + registers_read_count,
+                    is_ymm_or_zmm_register) ||
+        std::any_of(registers_written, registers_written + registers_written_count,
+                    is_ymm_or_zmm_register)) {
+      return true;
+    }
+  }
+  // Some bytes that couldn't be disassembled.
+  return code_size != 0;
+}
+
 uint64_t GetMaxTrampolineSize() {
   // The maximum size of a trampoline is constant. So the calculation can be cached on first call.
   static const uint64_t kTrampolineSize = []() -> uint64_t {
     MachineCode unused_code;
-    AppendBackupCode(unused_code);
+    AppendBackupCode(/*back_up_ymm_registers=*/true, unused_code);
     AppendCallToEntryPayload(/*entry_payload_function_address=*/0,
                              /*return_trampoline_address=*/0, unused_code);
-    AppendRestoreCode(unused_code);
+    AppendRestoreCode(/*back_up_ymm_registers=*/true, unused_code);
     unused_code.AppendBytes(std::vector<uint8_t>(kMaxRelocatedPrologueSize, 0));
     auto result =
         AppendJumpBackCode(/*address_after_prologue=*/0, /*trampoline_address=*/0, unused_code);
@@ -1169,12 +1259,9 @@ uint64_t GetMaxTrampolineSize() {
   return kTrampolineSize;
 }
 
-ErrorMessageOr<uint64_t> CreateTrampoline(pid_t pid, uint64_t function_address,
-                                          absl::Span<const uint8_t> function,
-                                          uint64_t trampoline_address,
-                                          uint64_t entry_payload_function_address,
-                                          uint64_t return_trampoline_address, csh capstone_handle,
-                                          absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
+ErrorMessageOr<RelocatedPrologue> RelocatePrologue(uint64_t function_address,
+                                                   absl::Span<const uint8_t> function,
+                                                   csh capstone_handle) {
   const bool harmful_jump =
       CheckForRelativeJumpIntoFirstFiveBytes(function_address, function, capstone_handle);
   if (harmful_jump) {
@@ -1183,30 +1270,168 @@ ErrorMessageOr<uint64_t> CreateTrampoline(pid_t pid, uint64_t function_address,
         "bytes of the function.");
   }
 
+  cs_insn* instruction = cs_malloc(capstone_handle);
+  ORBIT_FAIL_IF(instruction == nullptr, "Failed to allocate memory for capstone disassembler.");
+  orbit_base::unique_resource scope_exit{instruction,
+                                         [](cs_insn* instruction) { cs_free(instruction, 1); }};
+  // We relocate as if both the function and the relocated code were located at address zero, so
+  // the addresses computed by `RelocateInstruction` are offsets. The ones that depend on the
+  // actual location are recorded as fixups.
+  RelocatedPrologue result;
+  std::vector<size_t> positions_of_absolute_addresses;
+  const uint8_t* code_pointer = function.data();
+  size_t code_size = function.size();
+  uint64_t disassemble_offset = 0;
+  while (disassemble_offset < kSizeOfJmp &&
+         cs_disasm_iter(capstone_handle, &code_pointer, &code_size, &disassemble_offset,
+                        instruction)) {
+    const uint64_t instruction_offset = disassemble_offset - instruction->size;
+    const uint64_t relocated_instruction_offset = result.code.size();
+    result.instruction_offsets.emplace_back(instruction_offset, relocated_instruction_offset);
+    OUTCOME_TRY(auto&& relocated_instruction,
+                RelocateInstruction(instruction, instruction_offset, relocated_instruction_offset));
+    if (relocated_instruction.position_of_absolute_address.has_value()) {
+      positions_of_absolute_addresses.push_back(
+          relocated_instruction_offset +
+          relocated_instruction.position_of_absolute_address.value());
+    }
+    if (relocated_instruction.position_of_rip_relative_displacement.has_value()) {
+      const size_t position = relocated_instruction.position_of_rip_relative_displacement.value();
+      int32_t displacement{};
+      std::memcpy(&displacement, relocated_instruction.code.data() + position,
+                  sizeof(displacement));
+      const uint64_t end_of_instruction =
+          relocated_instruction_offset + relocated_instruction.code.size();
+      result.fixups.push_back(RelocatedPrologue::Fixup{
+          .type = RelocatedPrologue::Fixup::Type::kRipRelativeDisplacement,
+          .position = relocated_instruction_offset + position,
+          .target = end_of_instruction + displacement,
+          .end_of_instruction = end_of_instruction});
+    }
+    result.code.insert(result.code.end(), relocated_instruction.code.begin(),
+                       relocated_instruction.code.end());
+  }
+
+  if (disassemble_offset < kSizeOfJmp) {
+    return ErrorMessage(
+        absl::StrFormat("Unable to disassemble enough of the function to instrument it. Code: %s",
+                        BytesAsString(function)));
+  }
+  result.prologue_size = disassemble_offset;
+
+  // Jumps to instructions that have been relocated need to go to the relocated instruction.
+  for (size_t position : positions_of_absolute_addresses) {
+    uint64_t target{};
+    std::memcpy(&target, result.code.data() + position, sizeof(target));
+    auto it = std::find_if(result.instruction_offsets.begin(), result.instruction_offsets.end(),
+                           [target](const std::pair<uint64_t, uint64_t>& instruction_offsets) {
+                             return instruction_offsets.first == target;
+                           });
+    if (it != result.instruction_offsets.end()) {
+      result.fixups.push_back(RelocatedPrologue::Fixup{
+          .type = RelocatedPrologue::Fixup::Type::kAbsoluteAddressInRelocatedCode,
+          .position = position,
+          .target = it->second});
+    } else {
+      result.fixups.push_back(RelocatedPrologue::Fixup{
+          .type = RelocatedPrologue::Fixup::Type::kAbsoluteAddressInFunction,
+          .position = position,
+          .target = target});
+    }
+  }
+
+  return result;
+}
+
+ErrorMessageOr<TrampolineCode> BuildTrampolineFromRelocatedPrologue(
+    uint64_t function_address, const RelocatedPrologue& relocated_prologue,
+    uint64_t trampoline_address, uint64_t entry_payload_function_address,
+    uint64_t return_trampoline_address, absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
   MachineCode trampoline;
   // Add code to backup register state, execute the payload and restore the register state.
-  AppendBackupCode(trampoline);
+  AppendBackupCode(relocated_prologue.function_may_use_ymm_registers, trampoline);
   AppendCallToEntryPayload(entry_payload_function_address, return_trampoline_address, trampoline);
-  AppendRestoreCode(trampoline);
+  AppendRestoreCode(relocated_prologue.function_may_use_ymm_registers, trampoline);
 
   // Relocate prologue into trampoline.
-  OUTCOME_TRY(auto&& address_after_prologue,
-              AppendRelocatedPrologueCode(function_address, function, trampoline_address,
-                                          capstone_handle, relocation_map, trampoline));
+  const uint64_t relocated_code_address =
+      trampoline_address + trampoline.GetResultAsVector().size();
+  std::vector<uint8_t> relocated_code = relocated_prologue.code;
+  for (const RelocatedPrologue::Fixup& fixup : relocated_prologue.fixups) {
+    switch (fixup.type) {
+      case RelocatedPrologue::Fixup::Type::kRipRelativeDisplacement: {
+        ErrorMessageOr<int32_t> displacement_or_error = AddressDifferenceAsInt32(
+            function_address + fixup.target, relocated_code_address + fixup.end_of_instruction);
+        if (displacement_or_error.has_error()) {
+          return ErrorMessage(absl::StrFormat(
+              "While trying to relocate an instruction with rip relative addressing the target was "
+              "out of range from the trampoline. target: %#x, new address: %#x",
+              function_address + fixup.target, relocated_code_address + fixup.end_of_instruction));
+        }
+        const int32_t displacement = displacement_or_error.value();
+        std::memcpy(relocated_code.data() + fixup.position, &displacement, sizeof(displacement));
+        break;
+      }
+      case RelocatedPrologue::Fixup::Type::kAbsoluteAddressInFunction: {
+        const uint64_t address = function_address + fixup.target;
+        std::memcpy(relocated_code.data() + fixup.position, &address, sizeof(address));
+        break;
+      }
+      case RelocatedPrologue::Fixup::Type::kAbsoluteAddressInRelocatedCode: {
+        const uint64_t address = relocated_code_address + fixup.target;
+        std::memcpy(relocated_code.data() + fixup.position, &address, sizeof(address));
+        break;
+      }
+    }
+  }
+  trampoline.AppendBytes(relocated_code);
 
   // Add code for jump from trampoline back into function.
+  const uint64_t address_after_prologue = function_address + relocated_prologue.prologue_size;
   OUTCOME_TRY(AppendJumpBackCode(address_after_prologue, trampoline_address, trampoline));
 
+  for (const auto& [instruction_offset, relocated_instruction_offset] :
+       relocated_prologue.instruction_offsets) {
+    relocation_map.insert_or_assign(function_address + instruction_offset,
+                                    relocated_code_address + relocated_instruction_offset);
+  }
+  return TrampolineCode{.code = trampoline.GetResultAsVector(),
+                        .address_after_prologue = address_after_prologue};
+}
+
+ErrorMessageOr<TrampolineCode> BuildTrampoline(
+    uint64_t function_address, absl::Span<const uint8_t> function, uint64_t trampoline_address,
+    uint64_t entry_payload_function_address, uint64_t return_trampoline_address,
+    csh capstone_handle, absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
+  OUTCOME_TRY(auto&& relocated_prologue,
+              RelocatePrologue(function_address, function, capstone_handle));
+  return BuildTrampolineFromRelocatedPrologue(function_address, relocated_prologue,
+                                              trampoline_address, entry_payload_function_address,
+                                              return_trampoline_address, relocation_map);
+}
+
+ErrorMessageOr<uint64_t> CreateTrampoline(pid_t pid, uint64_t function_address,
+                                          absl::Span<const uint8_t> function,
+                                          uint64_t trampoline_address,
+                                          uint64_t entry_payload_function_address,
+                                          uint64_t return_trampoline_address, csh capstone_handle,
+                                          absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
+  OUTCOME_TRY(auto&& trampoline,
+              BuildTrampoline(function_address, function, trampoline_address,
+                              entry_payload_function_address, return_trampoline_address,
+                              capstone_handle, relocation_map));
+
   // Copy trampoline into tracee.
-  auto write_result_or_error =
-      WriteTraceesMemory(pid, trampoline_address, trampoline.GetResultAsVector());
+  auto write_result_or_error = WriteTraceesMemory(pid, trampoline_address, trampoline.code);
   if (write_result_or_error.has_error()) {
     return write_result_or_error.error();
   }
 
-  return address_after_prologue;
+  return trampoline.address_after_prologue;
 }
 
+uint64_t GetOffsetOfFunctionIdInTrampoline() { return kOffsetOfFunctionIdInCallToEntryPayload; }
+
 uint64_t GetReturnTrampolineSize() {
   // The size is constant. So the calculation can be cached on first call.
   static const uint64_t kReturnTrampolineSize = []() -> uint64_t {
@@ -1232,9 +1457,9 @@ ErrorMessageOr<void> CreateReturnTrampoline(pid_t pid, uint64_t exit_payload_fun
   return outcome::success();
 }
 
-ErrorMessageOr<void> InstrumentFunction(pid_t pid, uint64_t function_address, uint64_t function_id,
-                                        uint64_t address_after_prologue,
-                                        uint64_t trampoline_address) {
+ErrorMessageOr<std::vector<uint8_t>> BuildJumpToTrampoline(uint64_t function_address,
+                                                           uint64_t address_after_prologue,
+                                                           uint64_t trampoline_address) {
   MachineCode jump;
   jump.AppendBytes({0xe9});
   ErrorMessageOr<int32_t> offset_or_error =
@@ -1253,7 +1478,15 @@ ErrorMessageOr<void> InstrumentFunction(pid_t pid, uint64_t function_address, ui
   while (jump.GetResultAsVector().size() < address_after_prologue - function_address) {
     jump.AppendBytes({0x90});
   }
-  OUTCOME_TRY(WriteTraceesMemory(pid, function_address, jump.GetResultAsVector()));
+  return jump.GetResultAsVector();
+}
+
+ErrorMessageOr<void> InstrumentFunction(pid_t pid, uint64_t function_address, uint64_t function_id,
+                                        uint64_t address_after_prologue,
+                                        uint64_t trampoline_address) {
+  OUTCOME_TRY(auto&& jump,
+              BuildJumpToTrampoline(function_address, address_after_prologue, trampoline_address));
+  OUTCOME_TRY(WriteTraceesMemory(pid, function_address, jump));
 
   // Patch the trampoline to hand over the current function_id to the entry payload.
   MachineCode function_id_as_bytes;
@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "AllocateInTracee.h"
@@ -96,6 +97,10 @@ struct RelocatedInstruction {
   // needs to be recorded and handled later. In this case the `position_of_absolute_address` below
   // would be 8.
   std::optional<size_t> position_of_absolute_address = std::nullopt;
+
+  // For instructions using instruction pointer relative addressing, the position in `code` of the
+  // 32 bit displacement. The displacement depends on where the instruction was relocated to.
+  std::optional<size_t> position_of_rip_relative_displacement = std::nullopt;
 };
 
 // Relocate `instruction` from `old_address` to `new_address`.
@@ -116,6 +121,95 @@ struct RelocatedInstruction {
 // here since this captures every change to the code constructing the trampoline.
 [[nodiscard]] uint64_t GetMaxTrampolineSize();
 
+// The instructions at the beginning of a function relocated into a trampoline, in a form that
+// doesn't depend on the addresses of the function or of the trampoline. Relocating the prologue is
+// the expensive part of building a trampoline, as it involves disassembling the function. The
+// result can be reused for the same function at any address, e.g., in another process or in a
+// later run of OrbitService (compare `RelocatedPrologueCache`).
+struct RelocatedPrologue {
+  // An address in the relocated code that depends on where the function or the trampoline are.
+  struct Fixup {
+    enum class Type : uint8_t {
+      // A 32 bit displacement, relative to the end of the instruction at `end_of_instruction` in
+      // `code`, that addresses `target` in the function.
+      kRipRelativeDisplacement = 0,
+      // The 64 bit absolute address of `target` in the function.
+      kAbsoluteAddressInFunction = 1,
+      // The 64 bit absolute address of `target` in `code`.
+      kAbsoluteAddressInRelocatedCode = 2,
+    };
+
+    friend bool operator==(const Fixup& lhs, const Fixup& rhs) {
+      return lhs.type == rhs.type && lhs.position == rhs.position && lhs.target == rhs.target &&
+             lhs.end_of_instruction == rhs.end_of_instruction;
+    }
+
+    Type type = Type::kAbsoluteAddressInFunction;
+    // The position of the address in `code`.
+    uint64_t position = 0;
+    // An offset relative to the beginning of the function or of `code`. Targets before the
+    // beginning of the function wrap around.
+    uint64_t target = 0;
+    uint64_t end_of_instruction = 0;
+  };
+
+  friend bool operator==(const RelocatedPrologue& lhs, const RelocatedPrologue& rhs) {
+    return lhs.code == rhs.code && lhs.prologue_size == rhs.prologue_size &&
+           lhs.instruction_offsets == rhs.instruction_offsets && lhs.fixups == rhs.fixups &&
+           lhs.function_may_use_ymm_registers == rhs.function_may_use_ymm_registers;
+  }
+
+  // The relocated instructions, with all the addresses described by `fixups` still to be filled in.
+  std::vector<uint8_t> code;
+  // The number of bytes at the beginning of the function that have been relocated.
+  uint64_t prologue_size = 0;
+  // For each relocated instruction, its offset in the function and its offset in `code`.
+  std::vector<std::pair<uint64_t, uint64_t>> instruction_offsets;
+  std::vector<Fixup> fixups;
+  // Not set by `RelocatePrologue`, which only sees the beginning of the function, but by the caller
+  // from `MayUseYmmRegisters` below. If false, the trampoline only backs up the lower halves of the
+  // vector registers.
+  bool function_may_use_ymm_registers = true;
+};
+
+// Disassembles the beginning of the function at `function_address` and relocates the instructions
+// until the first five bytes, which will be overwritten by a jump, are cleared. `function` contains
+// the beginning of the function. Returns an error if the function can't be instrumented, e.g.,
+// because it contains a jump back into the first five bytes or an instruction that can't be
+// relocated.
+[[nodiscard]] ErrorMessageOr<RelocatedPrologue> RelocatePrologue(uint64_t function_address,
+                                                                 absl::Span<const uint8_t> function,
+                                                                 csh capstone_handle);
+
+// Returns false if the code of the entire function in `function` provably neither accesses any YMM
+// or ZMM register nor transfers control to code outside of the function, which could access them.
+// The upper halves of the YMM registers are treated as volatile, and the trampoline of such a
+// function doesn't need to preserve them. `capstone_handle` needs to have CS_OPT_DETAIL enabled.
+[[nodiscard]] bool MayUseYmmRegisters(absl::Span<const uint8_t> function, csh capstone_handle);
+
+// The machine code of a trampoline built by `BuildTrampoline` below, not yet in the tracee.
+struct TrampolineCode {
+  std::vector<uint8_t> code;
+  // The address of the first instruction not relocated into the trampoline.
+  uint64_t address_after_prologue = 0;
+};
+
+// Builds the trampoline that `CreateTrampoline` below creates, but returns its machine code instead
+// of writing it into the tracee. This doesn't access the tracee, so trampolines for many functions
+// can be built in parallel, as long as each thread uses its own `capstone_handle` and
+// `relocation_map`.
+[[nodiscard]] ErrorMessageOr<TrampolineCode> BuildTrampoline(
+    uint64_t function_address, absl::Span<const uint8_t> function, uint64_t trampoline_address,
+    uint64_t entry_payload_function_address, uint64_t return_trampoline_address,
+    csh capstone_handle, absl::flat_hash_map<uint64_t, uint64_t>& relocation_map);
+
+// Same as `BuildTrampoline` above but from the result of `RelocatePrologue`. This only fills in the
+// addresses in the relocated code and doesn't need a disassembler.
+[[nodiscard]] ErrorMessageOr<TrampolineCode> BuildTrampolineFromRelocatedPrologue(
+    uint64_t function_address, const RelocatedPrologue& relocated_prologue,
+    uint64_t trampoline_address, uint64_t entry_payload_function_address,
+    uint64_t return_trampoline_address, absl::flat_hash_map<uint64_t, uint64_t>& relocation_map);
+
 // Creates a trampoline for the function at `function_address`. The trampoline is built at
 // `trampoline_address`. The trampoline will call `entry_payload_function_address` with the
 // function's return address, a function id, the address on the stack where the return address is
@@ -125,7 +219,7 @@ struct RelocatedInstruction {
 // (kMaxFunctionPrologueBackupSize bytes or less if the function shorter). `capstone_handle` is a
 // handle to the capstone disassembler library returned by cs_open. The function returns an error if
 // it was not possible to instrument the function. For details on that see the comments at
-// AppendRelocatedPrologueCode. If the function is successful it will insert an address pair into
+// RelocatePrologue. If the function is successful it will insert an address pair into
 // `relocation_map` for each instruction it relocated from the beginning of the function into the
 // trampoline (needed for moving instruction pointers away from the overwritten bytes at the
 // beginning of the function, compare MoveInstructionPointersOutOfOverwrittenCode below). The return
@@ -137,6 +231,9 @@ struct RelocatedInstruction {
     uint64_t return_trampoline_address, csh capstone_handle,
     absl::flat_hash_map<uint64_t, uint64_t>& relocation_map);
 
+// Returns the offset in a trampoline of the 64 bit function id handed over to the entry payload.
+[[nodiscard]] uint64_t GetOffsetOfFunctionIdInTrampoline();
+
 // As above with `GetMaxTrampolineSize` this is a compile-time constant, but we prefer to compute it
 // here since this captures every change to the code constructing the return trampoline.
 [[nodiscard]] uint64_t GetReturnTrampolineSize();
@@ -154,6 +251,12 @@ struct RelocatedInstruction {
                                                           uint64_t exit_payload_function_address,
                                                           uint64_t return_trampoline_address);
 
+// Returns the code `InstrumentFunction` below writes over the beginning of the function at
+// `function_address`: a jump to `trampoline_address`, padded with nops up to
+// `address_after_prologue`.
+[[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> BuildJumpToTrampoline(
+    uint64_t function_address, uint64_t address_after_prologue, uint64_t trampoline_address);
+
 // Instrument function at `function_address` in process `pid`. This simply overwrites the beginning
 // of the function with a jump to `trampoline_address`. The trampoline needs to be constructed with
 // `CreateTrampoline` above. The trampoline gets patched such that it hands over the current
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <limits>
 #include <memory>
@@ -401,6 +402,7 @@ TEST_F(RelocateInstructionTest, RipRelativeAddressing) {
   EXPECT_THAT(result.value().code,
               ElementsAreArray({0x48, 0x83, 0x05, 0x56, 0x34, 0x12, 0x00, 0x01}));
   EXPECT_FALSE(result.value().position_of_absolute_address.has_value());
+  EXPECT_EQ(result.value().position_of_rip_relative_displacement, 3);
 
   result =
       RelocateInstruction(instruction_, kOriginalAddress, kOriginalAddress + kOffset + 0x123456);
@@ -549,6 +551,147 @@ TEST_F(RelocateInstructionTest, TrivialTranslation) {
   EXPECT_FALSE(result.value().position_of_absolute_address.has_value());
 }
 
+TEST(TrampolineTest, BuildTrampolineFromRelocatedPrologue) {
+  csh capstone_handle = 0;
+  ASSERT_EQ(cs_open(CS_ARCH_X86, CS_MODE_64, &capstone_handle), CS_ERR_OK);
+  ASSERT_EQ(cs_option(capstone_handle, CS_OPT_DETAIL, CS_OPT_ON), CS_ERR_OK);
+
+  MachineCode function;
+  // jmp 0x20                     eb 20
+  // mov rax, [rip + 0x10]        48 8b 05 10 00 00 00
+  // nop (32 times)               90
+  // ret                          c3
+  function.AppendBytes({0xeb, 0x20}).AppendBytes({0x48, 0x8b, 0x05}).AppendImmediate32(0x10);
+  for (int i = 0; i < 32; ++i) function.AppendBytes({0x90});
+  function.AppendBytes({0xc3});
+  const std::vector<uint8_t>& function_code = function.GetResultAsVector();
+
+  constexpr uint64_t kFunctionAddress = 0x10000000;
+  ErrorMessageOr<RelocatedPrologue> relocated_prologue_or_error =
+      RelocatePrologue(kFunctionAddress, function_code, capstone_handle);
+  ASSERT_THAT(relocated_prologue_or_error, HasValue());
+  const RelocatedPrologue& relocated_prologue = relocated_prologue_or_error.value();
+  EXPECT_EQ(relocated_prologue.prologue_size, 9);
+  // The jump gets relocated to "jmp [rip + 0]" followed by the absolute address of the target.
+  EXPECT_THAT(relocated_prologue.instruction_offsets,
+              ElementsAreArray({std::make_pair<uint64_t, uint64_t>(0, 0),
+                                std::make_pair<uint64_t, uint64_t>(2, 14)}));
+
+  // The result of `RelocatePrologue` can be reused for the function at another address, and yields
+  // the same trampoline as relocating the prologue for that address.
+  for (const uint64_t function_address : {kFunctionAddress, kFunctionAddress + 0x12345678}) {
+    const uint64_t trampoline_address = function_address + 0x01000000;
+    absl::flat_hash_map<uint64_t, uint64_t> relocation_map;
+    ErrorMessageOr<TrampolineCode> trampoline_or_error = BuildTrampolineFromRelocatedPrologue(
+        function_address, relocated_prologue, trampoline_address,
+        /*entry_payload_function_address=*/0x20000000,
+        /*return_trampoline_address=*/0x30000000, relocation_map);
+    ASSERT_THAT(trampoline_or_error, HasValue());
+    EXPECT_EQ(trampoline_or_error.value().address_after_prologue, function_address + 9);
+
+    absl::flat_hash_map<uint64_t, uint64_t> expected_relocation_map;
+    ErrorMessageOr<TrampolineCode> expected_trampoline_or_error = BuildTrampoline(
+        function_address, function_code, trampoline_address,
+        /*entry_payload_function_address=*/0x20000000,
+        /*return_trampoline_address=*/0x30000000, capstone_handle, expected_relocation_map);
+    ASSERT_THAT(expected_trampoline_or_error, HasValue());
+    EXPECT_EQ(trampoline_or_error.value().code, expected_trampoline_or_error.value().code);
+    EXPECT_EQ(relocation_map, expected_relocation_map);
+
+    // Check the relocated addresses.
+    ASSERT_TRUE(relocation_map.contains(function_address));
+    const uint64_t relocated_code_offset = relocation_map[function_address] - trampoline_address;
+    const std::vector<uint8_t>& code = trampoline_or_error.value().code;
+    uint64_t jump_target = 0;
+    std::memcpy(&jump_target, code.data() + relocated_code_offset + 6, sizeof(jump_target));
+    EXPECT_EQ(jump_target, function_address + 0x22);
+    int32_t displacement = 0;
+    std::memcpy(&displacement, code.data() + relocated_code_offset + 14 + 3, sizeof(displacement));
+    EXPECT_EQ(relocation_map[function_address] + 14 + 7 + displacement,
+              function_address + 9 + 0x10);
+  }
+
+  cs_close(&capstone_handle);
+}
+
+TEST(TrampolineTest, MayUseYmmRegisters) {
+  csh capstone_handle = 0;
+  ASSERT_EQ(cs_open(CS_ARCH_X86, CS_MODE_64, &capstone_handle), CS_ERR_OK);
+  ASSERT_EQ(cs_option(capstone_handle, CS_OPT_DETAIL, CS_OPT_ON), CS_ERR_OK);
+
+  // mov eax, edi                 89 f8
+  // addss xmm0, xmm1             f3 0f 58 c1
+  // test eax, eax                85 c0
+  // je 0x0                       74 f6
+  // ret                          c3
+  EXPECT_FALSE(MayUseYmmRegisters(
+      {0x89, 0xf8, 0xf3, 0x0f, 0x58, 0xc1, 0x85, 0xc0, 0x74, 0xf6, 0xc3}, capstone_handle));
+
+  // vaddps ymm0, ymm0, ymm1      c5 fc 58 c1
+  // ret                          c3
+  EXPECT_TRUE(MayUseYmmRegisters({0xc5, 0xfc, 0x58, 0xc1, 0xc3}, capstone_handle));
+
+  // call 0x10                    e8 0b 00 00 00
+  // ret                          c3
+  EXPECT_TRUE(MayUseYmmRegisters({0xe8, 0x0b, 0x00, 0x00, 0x00, 0xc3}, capstone_handle));
+
+  // Tail call.
+  // mov eax, edi                 89 f8
+  // jmp 0x100                    e9 f9 00 00 00
+  EXPECT_TRUE(MayUseYmmRegisters({0x89, 0xf8, 0xe9, 0xf9, 0x00, 0x00, 0x00}, capstone_handle));
+
+  // jmp rax                      ff e0
+  EXPECT_TRUE(MayUseYmmRegisters({0xff, 0xe0}, capstone_handle));
+
+  // xsave [rdi]                  0f ae 27
+  // ret                          c3
+  EXPECT_TRUE(MayUseYmmRegisters({0x0f, 0xae, 0x27, 0xc3}, capstone_handle));
+
+  // Not a valid instruction.
+  EXPECT_TRUE(MayUseYmmRegisters({0x06}, capstone_handle));
+
+  cs_close(&capstone_handle);
+}
+
+TEST(TrampolineTest, TrampolineWithoutYmmBackupHasTheSameLayout) {
+  RelocatedPrologue relocated_prologue;
+  // nop (5 times)                90
+  relocated_prologue.code = {0x90, 0x90, 0x90, 0x90, 0x90};
+  relocated_prologue.prologue_size = 5;
+  relocated_prologue.instruction_offsets = {{0, 0}, {1, 1}, {2, 2}, {3, 3}, {4, 4}};
+
+  constexpr uint64_t kFunctionAddress = 0x10000000;
+  constexpr uint64_t kTrampolineAddress = 0x11000000;
+  absl::flat_hash_map<uint64_t, uint64_t> relocation_map;
+  ErrorMessageOr<TrampolineCode> trampoline_or_error = BuildTrampolineFromRelocatedPrologue(
+      kFunctionAddress, relocated_prologue, kTrampolineAddress,
+      /*entry_payload_function_address=*/0x20000000,
+      /*return_trampoline_address=*/0x30000000, relocation_map);
+  ASSERT_THAT(trampoline_or_error, HasValue());
+
+  relocated_prologue.function_may_use_ymm_registers = false;
+  absl::flat_hash_map<uint64_t, uint64_t> minimal_relocation_map;
+  ErrorMessageOr<TrampolineCode> minimal_trampoline_or_error =
+      BuildTrampolineFromRelocatedPrologue(kFunctionAddress, relocated_prologue,
+                                           kTrampolineAddress,
+                                           /*entry_payload_function_address=*/0x20000000,
+                                           /*return_trampoline_address=*/0x30000000,
+                                           minimal_relocation_map);
+  ASSERT_THAT(minimal_trampoline_or_error, HasValue());
+
+  // The call to the entry payload, including the function id, and the relocated prologue are at
+  // the same offsets. Only the code backing up and restoring the vector registers differs.
+  const std::vector<uint8_t>& code = trampoline_or_error.value().code;
+  const std::vector<uint8_t>& minimal_code = minimal_trampoline_or_error.value().code;
+  ASSERT_EQ(code.size(), minimal_code.size());
+  EXPECT_EQ(relocation_map, minimal_relocation_map);
+  // The call consists of 9 bytes before and 25 bytes after the 8 bytes of the function id.
+  const uint64_t begin_of_call = GetOffsetOfFunctionIdInTrampoline() - 9;
+  const uint64_t end_of_call = GetOffsetOfFunctionIdInTrampoline() + 8 + 25;
+  EXPECT_TRUE(std::equal(code.begin() + begin_of_call, code.begin() + end_of_call,
+                         minimal_code.begin() + begin_of_call));
+}
+
 class InstrumentFunctionTest : public testing::Test {
  protected:
   void SetUp() override {
@@ -23,6 +23,7 @@
 namespace orbit_user_space_instrumentation {
 
 class InstrumentedProcess;
+class RelocatedPrologueCache;
 
 // `InstrumentationManager` is a globally unique object containing the bookkeeping for all user
 // space instrumentation (in the `process_map_` member). Its lifetime is pretty much identical to
@@ -33,9 +34,14 @@ class InstrumentationManager {
   InstrumentationManager(InstrumentationManager&&) = delete;
   InstrumentationManager& operator=(const InstrumentationManager&) = delete;
   InstrumentationManager& operator=(InstrumentationManager&&) = delete;
+  // Restores the prologues of the instrumented functions in all processes that are still running.
   ~InstrumentationManager();
 
-  [[nodiscard]] static std::unique_ptr<InstrumentationManager> Create();
+  // The relocated prologues of the instrumented functions are kept in
+  // `relocated_prologue_cache_directory` across runs of OrbitService. If it is empty, they are only
+  // kept in memory.
+  [[nodiscard]] static std::unique_ptr<InstrumentationManager> Create(
+      std::filesystem::path relocated_prologue_cache_directory = {});
 
   struct InstrumentationResult {
     absl::flat_hash_set<uint64_t> instrumented_function_ids;
@@ -43,27 +49,35 @@ class InstrumentationManager {
     std::vector<AddressRange> entry_trampoline_address_ranges;
     AddressRange return_trampoline_address_range;
     std::filesystem::path injected_library_path;
+    // The time the instrumentation adds to each function call, as measured in the target process.
+    // Zero if the measurement failed.
+    uint64_t function_call_overhead_ns = 0;
   };
 
   // On the first call to this function we inject OrbitUserSpaceInstrumentation.so into the target
   // process and create the return trampoline. On each call we create trampolines for functions that
   // were not instrumented before and instrument all functions by overwriting the prologue with a
-  // jump into the trampoline. Returns the function_id's of the instrumented functions and -
-  // potentially - error messages for functions where the instrumentation failed. Note that there is
-  // no guarantee that we can instrument all the functions in a binary. It also returns the address
-  // ranges dedicated to trampolines, including the return trampoline, and the map name of the
-  // injected library.
+  // jump into the trampoline. The jumps stay in place after the capture; outside of a capture the
+  // trampolines return right away. Functions instrumented in a previous capture that are not part
+  // of `capture_options` are disabled in their trampoline instead of being patched. Returns the
+  // function_id's of the instrumented functions and - potentially - error messages for functions
+  // where the instrumentation failed. Note that there is no guarantee that we can instrument all
+  // the functions in a binary. It also returns the address ranges dedicated to trampolines,
+  // including the return trampoline, the map name of the injected library, and the overhead that
+  // the instrumentation adds to each function call.
   [[nodiscard]] ErrorMessageOr<InstrumentationResult> InstrumentProcess(
       const orbit_grpc_protos::CaptureOptions& capture_options);
 
   // Undo the instrumentation of the functions. Leaves the library and trampolines in the target
-  // process intact. We merely restore the function prologues that were overwritten.
+  // process intact. We merely restore the function prologues that were overwritten. This is not
+  // needed at the end of a capture.
   [[nodiscard]] ErrorMessageOr<void> UninstrumentProcess(pid_t pid);
 
  private:
   InstrumentationManager() = default;
 
   absl::flat_hash_map<pid_t, std::unique_ptr<InstrumentedProcess>> process_map_;
+  std::unique_ptr<RelocatedPrologueCache> relocated_prologue_cache_;
 };
 
 }  // namespace orbit_user_space_instrumentation
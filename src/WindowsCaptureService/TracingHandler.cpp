@@ -11,9 +11,10 @@
 
 namespace orbit_windows_capture_service {
 
+using orbit_grpc_protos::CallstackSample;
 using orbit_grpc_protos::CaptureOptions;
-using orbit_grpc_protos::FullCallstackSample;
 using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::InternedCallstack;
 using orbit_grpc_protos::ProducerCaptureEvent;
 using orbit_grpc_protos::SchedulingSlice;
 using orbit_grpc_protos::ThreadName;
@@ -29,6 +30,7 @@ void TracingHandler::Start(CaptureOptions capture_options) {
 void TracingHandler::Stop() {
   ORBIT_CHECK(tracer_ != nullptr);
   tracer_->Stop();
+  etw_stats_ = tracer_->GetEtwStats();
   tracer_.reset();
   ORBIT_LOG("Windows TracingHandler stopped: ETW tracing is done");
 }
@@ -39,9 +41,15 @@ void TracingHandler::OnSchedulingSlice(SchedulingSlice scheduling_slice) {
   producer_event_processor_->ProcessEvent(kWindowsTracingProducerId, std::move(event));
 }
 
-void TracingHandler::OnCallstackSample(FullCallstackSample callstack_sample) {
+void TracingHandler::OnInternedCallstack(InternedCallstack interned_callstack) {
   ProducerCaptureEvent event;
-  *event.mutable_full_callstack_sample() = std::move(callstack_sample);
+  *event.mutable_interned_callstack() = std::move(interned_callstack);
+  producer_event_processor_->ProcessEvent(kWindowsTracingProducerId, std::move(event));
+}
+
+void TracingHandler::OnCallstackSample(CallstackSample callstack_sample) {
+  ProducerCaptureEvent event;
+  *event.mutable_callstack_sample() = std::move(callstack_sample);
   producer_event_processor_->ProcessEvent(kWindowsTracingProducerId, std::move(event));
 }
 
@@ -37,9 +37,12 @@ class TracingHandler : public orbit_windows_tracing::TracerListener {
 
   void Start(orbit_grpc_protos::CaptureOptions capture_options);
   void Stop();
+  // Only valid after Stop().
+  [[nodiscard]] const orbit_grpc_protos::EtwStats& GetEtwStats() const { return etw_stats_; }
 
   void OnSchedulingSlice(orbit_grpc_protos::SchedulingSlice scheduling_slice) override;
-  void OnCallstackSample(orbit_grpc_protos::FullCallstackSample callstack_sample) override;
+  void OnInternedCallstack(orbit_grpc_protos::InternedCallstack interned_callstack) override;
+  void OnCallstackSample(orbit_grpc_protos::CallstackSample callstack_sample) override;
   void OnFunctionCall(orbit_grpc_protos::FunctionCall function_call) override;
   void OnModuleUpdate(orbit_grpc_protos::ModuleUpdateEvent module_update_event) override;
   void OnModulesSnapshot(orbit_grpc_protos::ModulesSnapshot modules_snapshot) override;
@@ -49,6 +52,7 @@ class TracingHandler : public orbit_windows_tracing::TracerListener {
  private:
   orbit_producer_event_processor::ProducerEventProcessor* producer_event_processor_;
   std::unique_ptr<orbit_windows_tracing::Tracer> tracer_;
+  orbit_grpc_protos::EtwStats etw_stats_;
 };
 
 }  // namespace orbit_windows_capture_service
@@ -4,9 +4,14 @@
 
 #include "WindowsCaptureService/WindowsCaptureService.h"
 
+#include <absl/strings/str_format.h>
 #include <grpcpp/grpcpp.h>
 #include <stdint.h>
 
+#include <optional>
+#include <string>
+#include <utility>
+
 #include "ApiLoader/EnableInTracee.h"
 #include "CaptureServiceBase/CommonProducerCaptureEventBuilders.h"
 #include "CaptureServiceBase/GrpcStartStopCaptureRequestWaiter.h"
@@ -15,21 +20,28 @@
 #include "OrbitBase/ThreadUtils.h"
 #include "ProducerEventProcessor/GrpcClientCaptureEventCollector.h"
 #include "TracingHandler.h"
+#include "WindowsUserSpaceInstrumentation/InstrumentProcess.h"
 
 namespace orbit_windows_capture_service {
 
 using orbit_capture_service_base::CaptureStartStopListener;
+using orbit_grpc_protos::CaptureFinished;
 using orbit_grpc_protos::CaptureOptions;
 using orbit_grpc_protos::CaptureRequest;
 using orbit_grpc_protos::CaptureResponse;
+using orbit_grpc_protos::ProducerCaptureEvent;
 
 grpc::Status WindowsCaptureService::Capture(
-    grpc::ServerContext*,
+    grpc::ServerContext* context,
     grpc::ServerReaderWriter<CaptureResponse, CaptureRequest>* reader_writer) {
   orbit_base::SetCurrentThreadName("WinCS::Capture");
 
+  orbit_capture_service_base::GrpcStartStopCaptureRequestWaiter
+      grpc_start_stop_capture_request_waiter{reader_writer};
   orbit_producer_event_processor::GrpcClientCaptureEventCollector
-      grpc_client_capture_event_collector{reader_writer};
+      grpc_client_capture_event_collector{
+          reader_writer,
+          grpc_start_stop_capture_request_waiter.GetClientCaptureBacklogByteCountPtr()};
   CaptureServiceBase::CaptureInitializationResult initialization_result =
       InitializeCapture(&grpc_client_capture_event_collector);
   switch (initialization_result) {
@@ -40,16 +52,51 @@ grpc::Status WindowsCaptureService::Capture(
               "Cannot start capture because another capture is already in progress"};
   }
 
-  orbit_capture_service_base::GrpcStartStopCaptureRequestWaiter
-      grpc_start_stop_capture_request_waiter{reader_writer};
   const CaptureOptions& capture_options =
       grpc_start_stop_capture_request_waiter.WaitForStartCaptureRequest();
+  orbit_capture_service_base::SetCaptureResponseCompression(capture_options, context);
+  SetUpCaptureFileOnTarget(capture_options);
 
   if (capture_options.enable_api()) {
     EnableApiInTracee(capture_options);
   }
 
+  // Dynamic instrumentation happens before the capture starts, but errors and warnings are only
+  // reported once the CaptureStarted event has been sent.
+  std::optional<std::string> error_enabling_user_space_instrumentation;
+  std::optional<ProducerCaptureEvent> info_from_enabling_user_space_instrumentation;
+  const bool instrument_functions = !capture_options.instrumented_functions().empty();
+  if (instrument_functions) {
+    auto result_or_error =
+        orbit_windows_user_space_instrumentation::InstrumentProcess(capture_options);
+    if (result_or_error.has_error()) {
+      error_enabling_user_space_instrumentation = absl::StrFormat(
+          "Could not enable user space instrumentation: %s", result_or_error.error().message());
+      ORBIT_ERROR("%s", error_enabling_user_space_instrumentation.value());
+    } else if (!result_or_error.value().function_ids_to_error_messages.empty()) {
+      info_from_enabling_user_space_instrumentation =
+          orbit_capture_service_base::CreateWarningInstrumentingWithUserSpaceInstrumentationEvent(
+              orbit_base::CaptureTimestampNs(),
+              result_or_error.value().function_ids_to_error_messages);
+    }
+  }
+
   StartEventProcessing(capture_options);
+
+  if (error_enabling_user_space_instrumentation.has_value()) {
+    producer_event_processor_->ProcessEvent(
+        orbit_grpc_protos::kRootProducerId,
+        orbit_capture_service_base::CreateErrorEnablingUserSpaceInstrumentationEvent(
+            orbit_base::CaptureTimestampNs(),
+            std::move(error_enabling_user_space_instrumentation.value())));
+  }
+
+  if (info_from_enabling_user_space_instrumentation.has_value()) {
+    producer_event_processor_->ProcessEvent(
+        orbit_grpc_protos::kRootProducerId,
+        std::move(info_from_enabling_user_space_instrumentation.value()));
+  }
+
   TracingHandler tracing_handler{producer_event_processor_.get()};
   tracing_handler.Start(capture_options);
 
@@ -69,8 +116,17 @@ grpc::Status WindowsCaptureService::Capture(
     DisableApiInTracee(capture_options);
   }
 
+  if (instrument_functions && !error_enabling_user_space_instrumentation.has_value()) {
+    UninstrumentProcess(capture_options);
+  }
+
   tracing_handler.Stop();
-  FinalizeEventProcessing(stop_capture_reason);
+  const orbit_grpc_protos::EtwStats& etw_stats = tracing_handler.GetEtwStats();
+  ORBIT_LOG("ETW: %u events lost, %u buffers lost", etw_stats.events_lost(),
+            etw_stats.buffers_lost());
+  FinalizeEventProcessing(stop_capture_reason, CaptureFinished::kProcessStateUnknown,
+                          CaptureFinished::kTerminationSignalUnknown,
+                          /*unwinding_cache_stats=*/std::nullopt, etw_stats);
 
   TerminateCapture();
 
@@ -100,4 +156,17 @@ void WindowsCaptureService::DisableApiInTracee(const CaptureOptions& capture_opt
       orbit_capture_service_base::CreateWarningEvent(orbit_base::CaptureTimestampNs(), error));
 }
 
+void WindowsCaptureService::UninstrumentProcess(const CaptureOptions& capture_options) {
+  auto result =
+      orbit_windows_user_space_instrumentation::UninstrumentProcess(capture_options.pid());
+  if (!result.has_error()) return;
+
+  std::string error = absl::StrFormat("Could not disable user space instrumentation: %s",
+                                      result.error().message());
+  ORBIT_ERROR("%s", error);
+  producer_event_processor_->ProcessEvent(
+      orbit_grpc_protos::kRootProducerId,
+      orbit_capture_service_base::CreateWarningEvent(orbit_base::CaptureTimestampNs(), error));
+}
+
 }  // namespace orbit_windows_capture_service
@@ -22,6 +22,7 @@ class WindowsCaptureService final : public orbit_capture_service_base::CaptureSe
  private:
   void EnableApiInTracee(const orbit_grpc_protos::CaptureOptions& capture_options);
   void DisableApiInTracee(const orbit_grpc_protos::CaptureOptions& capture_options);
+  void UninstrumentProcess(const orbit_grpc_protos::CaptureOptions& capture_options);
 };
 
 }  // namespace orbit_windows_capture_service
@@ -37,6 +37,8 @@ using orbit_grpc_protos::GetModuleListRequest;
 using orbit_grpc_protos::GetModuleListResponse;
 using orbit_grpc_protos::GetProcessListRequest;
 using orbit_grpc_protos::GetProcessListResponse;
+using orbit_grpc_protos::GetProcessMemoryRangesRequest;
+using orbit_grpc_protos::GetProcessMemoryRangesResponse;
 using orbit_grpc_protos::GetProcessMemoryRequest;
 using orbit_grpc_protos::GetProcessMemoryResponse;
 using orbit_grpc_protos::ModuleInfo;
@@ -120,6 +122,32 @@ Status ProcessServiceImpl::GetProcessMemory(ServerContext*, const GetProcessMemo
   return Status::OK;
 }
 
+Status ProcessServiceImpl::GetProcessMemoryRanges(ServerContext*,
+                                                  const GetProcessMemoryRangesRequest* request,
+                                                  GetProcessMemoryRangesResponse* response) {
+  // Ranges beyond the maximum response size are requested with size zero, so that the response
+  // still has one entry per range.
+  std::vector<orbit_windows_utils::MemoryRange> ranges;
+  ranges.reserve(request->ranges_size());
+  uint64_t total_size = 0;
+  for (const orbit_grpc_protos::MemoryRange& range : request->ranges()) {
+    const uint64_t size = std::min(range.size(), kMaxGetProcessMemoryResponseSize - total_size);
+    total_size += size;
+    ranges.push_back({range.address(), size});
+  }
+
+  ErrorMessageOr<std::vector<std::string>> result =
+      orbit_windows_utils::ReadProcessMemoryRanges(request->pid(), ranges);
+  if (result.has_error()) {
+    return Status(StatusCode::PERMISSION_DENIED, result.error().message());
+  }
+
+  for (std::string& memory : result.value()) {
+    *response->add_memory() = std::move(memory);
+  }
+  return Status::OK;
+}
+
 Status ProcessServiceImpl::GetDebugInfoFile(ServerContext*, const GetDebugInfoFileRequest* request,
                                             GetDebugInfoFileResponse* response) {
   std::filesystem::path module_path(request->module_path());
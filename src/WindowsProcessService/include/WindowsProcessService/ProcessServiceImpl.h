@@ -28,6 +28,10 @@ class ProcessServiceImpl final : public orbit_grpc_protos::ProcessService::Servi
       grpc::ServerContext* context, const orbit_grpc_protos::GetProcessMemoryRequest* request,
       orbit_grpc_protos::GetProcessMemoryResponse* response) override;
 
+  [[nodiscard]] grpc::Status GetProcessMemoryRanges(
+      grpc::ServerContext* context, const orbit_grpc_protos::GetProcessMemoryRangesRequest* request,
+      orbit_grpc_protos::GetProcessMemoryRangesResponse* response) override;
+
   [[nodiscard]] grpc::Status GetDebugInfoFile(
       grpc::ServerContext* context, const orbit_grpc_protos::GetDebugInfoFileRequest* request,
       orbit_grpc_protos::GetDebugInfoFileResponse* response) override;
@@ -0,0 +1,18 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "CallstackInterner.h"
+
+namespace orbit_windows_tracing {
+
+std::pair<uint64_t, bool> CallstackInterner::GetOrAssignId(absl::Span<const uint64_t> pcs) {
+  auto it = pcs_to_id_.find(pcs);
+  if (it != pcs_to_id_.end()) return {it->second, false};
+
+  const uint64_t id = next_id_++;
+  pcs_to_id_.emplace(std::vector<uint64_t>(pcs.begin(), pcs.end()), id);
+  return {id, true};
+}
+
+}  // namespace orbit_windows_tracing
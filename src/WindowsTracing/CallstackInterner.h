@@ -0,0 +1,47 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WINDOWS_TRACING_CALLSTACK_INTERNER_H_
+#define WINDOWS_TRACING_CALLSTACK_INTERNER_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+#include <absl/types/span.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace orbit_windows_tracing {
+
+// Assigns ids to the distinct callstacks of a capture, so that each callstack only needs to be
+// sent once as an InternedCallstack, and samples can refer to it with a CallstackSample. Lookups
+// hash the frames directly, without copying them. Not thread-safe.
+class CallstackInterner {
+ public:
+  // Returns the id of the callstack with these program counters, and true if the id was assigned
+  // by this call, that is, if the callstack needs to be sent.
+  [[nodiscard]] std::pair<uint64_t, bool> GetOrAssignId(absl::Span<const uint64_t> pcs);
+
+ private:
+  struct PcsHash {
+    using is_transparent = void;
+    size_t operator()(absl::Span<const uint64_t> pcs) const {
+      return absl::Hash<absl::Span<const uint64_t>>{}(pcs);
+    }
+  };
+  struct PcsEq {
+    using is_transparent = void;
+    bool operator()(absl::Span<const uint64_t> lhs, absl::Span<const uint64_t> rhs) const {
+      return lhs == rhs;
+    }
+  };
+
+  absl::flat_hash_map<std::vector<uint64_t>, uint64_t, PcsHash, PcsEq> pcs_to_id_;
+  uint64_t next_id_ = 1;
+};
+
+}  // namespace orbit_windows_tracing
+
+#endif  // WINDOWS_TRACING_CALLSTACK_INTERNER_H_
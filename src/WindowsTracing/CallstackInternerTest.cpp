@@ -0,0 +1,45 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "CallstackInterner.h"
+
+namespace orbit_windows_tracing {
+
+TEST(CallstackInterner, AssignsIdsToDistinctCallstacks) {
+  CallstackInterner interner;
+  const std::vector<uint64_t> callstack1{0x10, 0x20, 0x30};
+  const std::vector<uint64_t> callstack2{0x10, 0x20};
+  const std::vector<uint64_t> callstack3{0x11, 0x20, 0x30};
+
+  const auto [id1, is_new1] = interner.GetOrAssignId(callstack1);
+  EXPECT_TRUE(is_new1);
+  const auto [id2, is_new2] = interner.GetOrAssignId(callstack2);
+  EXPECT_TRUE(is_new2);
+  const auto [id3, is_new3] = interner.GetOrAssignId(callstack3);
+  EXPECT_TRUE(is_new3);
+  EXPECT_NE(id1, id2);
+  EXPECT_NE(id1, id3);
+  EXPECT_NE(id2, id3);
+
+  const std::vector<uint64_t> callstack1_copy = callstack1;
+  const auto [id1_again, is_new1_again] = interner.GetOrAssignId(callstack1_copy);
+  EXPECT_FALSE(is_new1_again);
+  EXPECT_EQ(id1_again, id1);
+}
+
+TEST(CallstackInterner, EmptyCallstack) {
+  CallstackInterner interner;
+  const auto [id, is_new] = interner.GetOrAssignId({});
+  EXPECT_TRUE(is_new);
+  const auto [id_again, is_new_again] = interner.GetOrAssignId({});
+  EXPECT_FALSE(is_new_again);
+  EXPECT_EQ(id_again, id);
+}
+
+}  // namespace orbit_windows_tracing
@@ -17,7 +17,8 @@ namespace orbit_windows_tracing {
 class MockTracerListener : public orbit_windows_tracing::TracerListener {
  public:
   MOCK_METHOD(void, OnSchedulingSlice, (orbit_grpc_protos::SchedulingSlice), (override));
-  MOCK_METHOD(void, OnCallstackSample, (orbit_grpc_protos::FullCallstackSample), (override));
+  MOCK_METHOD(void, OnInternedCallstack, (orbit_grpc_protos::InternedCallstack), (override));
+  MOCK_METHOD(void, OnCallstackSample, (orbit_grpc_protos::CallstackSample), (override));
   MOCK_METHOD(void, OnFunctionCall, (orbit_grpc_protos::FunctionCall), (override));
   MOCK_METHOD(void, OnModulesSnapshot, (orbit_grpc_protos::ModulesSnapshot), (override));
   MOCK_METHOD(void, OnModuleUpdate, (orbit_grpc_protos::ModuleUpdateEvent), (override));
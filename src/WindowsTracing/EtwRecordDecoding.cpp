@@ -0,0 +1,51 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "EtwRecordDecoding.h"
+
+#include <string.h>
+
+#include <type_traits>
+
+namespace orbit_windows_tracing {
+
+namespace {
+
+template <typename T>
+[[nodiscard]] T ReadAt(absl::Span<const uint8_t> data, size_t offset) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  T value;
+  memcpy(&value, data.data() + offset, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+std::optional<ThreadTypeGroup1Payload> DecodeThreadTypeGroup1Payload(
+    uint8_t version, absl::Span<const uint8_t> user_data) {
+  // Versions 1 to 4 start with `uint32 ProcessId; uint32 TThreadId;`, version 0 has the two fields
+  // in the opposite order.
+  constexpr size_t kMinSize = 8;
+  if (version < 1 || version > 4 || user_data.size() < kMinSize) return std::nullopt;
+  return ThreadTypeGroup1Payload{ReadAt<uint32_t>(user_data, 0), ReadAt<uint32_t>(user_data, 4)};
+}
+
+std::optional<CSwitchPayload> DecodeCSwitchPayload(uint8_t version,
+                                                   absl::Span<const uint8_t> user_data) {
+  // Versions 2 to 4 start with `uint32 NewThreadId; uint32 OldThreadId;`.
+  constexpr size_t kMinSize = 8;
+  if (version < 2 || version > 4 || user_data.size() < kMinSize) return std::nullopt;
+  return CSwitchPayload{ReadAt<uint32_t>(user_data, 0), ReadAt<uint32_t>(user_data, 4)};
+}
+
+std::optional<StackWalkPayload> DecodeStackWalkPayload(uint8_t version,
+                                                       absl::Span<const uint8_t> user_data) {
+  // Version 2 is `uint64 EventTimeStamp; uint32 StackProcess; uint32 StackThread;` followed by the
+  // 64-bit addresses of the stack.
+  if (version != 2 || user_data.size() < kStackWalkStackDataOffset) return std::nullopt;
+  return StackWalkPayload{ReadAt<uint32_t>(user_data, 8), ReadAt<uint32_t>(user_data, 12),
+                          user_data.subspan(kStackWalkStackDataOffset)};
+}
+
+}  // namespace orbit_windows_tracing
@@ -0,0 +1,50 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WINDOWS_TRACING_ETW_RECORD_DECODING_H_
+#define WINDOWS_TRACING_ETW_RECORD_DECODING_H_
+
+#include <absl/types/span.h>
+
+#include <cstdint>
+#include <optional>
+
+namespace orbit_windows_tracing {
+
+// Decoders for the payloads (EVENT_RECORD::UserData) of the most frequent kernel events. They read
+// the fields at the fixed offsets documented for the given event versions, which is much cheaper
+// than a TDH schema lookup through krabs::schema and krabs::parser for every record. They return
+// std::nullopt for versions they don't know or payloads that are too small, in which case the
+// caller should fall back to krabs::parser.
+
+// https://docs.microsoft.com/en-us/windows/win32/etw/thread-typegroup1
+struct ThreadTypeGroup1Payload {
+  uint32_t pid;
+  uint32_t tid;
+};
+[[nodiscard]] std::optional<ThreadTypeGroup1Payload> DecodeThreadTypeGroup1Payload(
+    uint8_t version, absl::Span<const uint8_t> user_data);
+
+// https://docs.microsoft.com/en-us/windows/win32/etw/cswitch
+struct CSwitchPayload {
+  uint32_t new_tid;
+  uint32_t old_tid;
+};
+[[nodiscard]] std::optional<CSwitchPayload> DecodeCSwitchPayload(
+    uint8_t version, absl::Span<const uint8_t> user_data);
+
+// https://docs.microsoft.com/en-us/windows/win32/etw/stackwalk-event
+struct StackWalkPayload {
+  uint32_t pid;
+  uint32_t tid;
+  // Unaligned in general, read with memcpy.
+  absl::Span<const uint8_t> stack_data;
+};
+inline constexpr size_t kStackWalkStackDataOffset = 16;
+[[nodiscard]] std::optional<StackWalkPayload> DecodeStackWalkPayload(
+    uint8_t version, absl::Span<const uint8_t> user_data);
+
+}  // namespace orbit_windows_tracing
+
+#endif  // WINDOWS_TRACING_ETW_RECORD_DECODING_H_
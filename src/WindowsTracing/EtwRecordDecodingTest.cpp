@@ -0,0 +1,85 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/types/span.h>
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "EtwRecordDecoding.h"
+
+namespace orbit_windows_tracing {
+
+namespace {
+
+template <typename T>
+void AppendValue(std::vector<uint8_t>& buffer, const T& value) {
+  const size_t offset = buffer.size();
+  buffer.resize(offset + sizeof(value));
+  memcpy(buffer.data() + offset, &value, sizeof(value));
+}
+
+}  // namespace
+
+TEST(EtwRecordDecoding, DecodeThreadTypeGroup1Payload) {
+  std::vector<uint8_t> user_data;
+  AppendValue<uint32_t>(user_data, 42);  // ProcessId
+  AppendValue<uint32_t>(user_data, 43);  // TThreadId
+  AppendValue<uint64_t>(user_data, 0);   // StackBase
+
+  std::optional<ThreadTypeGroup1Payload> payload =
+      DecodeThreadTypeGroup1Payload(/*version=*/3, user_data);
+  ASSERT_TRUE(payload.has_value());
+  EXPECT_EQ(payload->pid, 42);
+  EXPECT_EQ(payload->tid, 43);
+
+  EXPECT_FALSE(DecodeThreadTypeGroup1Payload(/*version=*/0, user_data).has_value());
+  EXPECT_FALSE(DecodeThreadTypeGroup1Payload(/*version=*/5, user_data).has_value());
+  EXPECT_FALSE(DecodeThreadTypeGroup1Payload(
+                   /*version=*/3, absl::MakeConstSpan(user_data).subspan(0, 7))
+                   .has_value());
+}
+
+TEST(EtwRecordDecoding, DecodeCSwitchPayload) {
+  std::vector<uint8_t> user_data;
+  AppendValue<uint32_t>(user_data, 42);  // NewThreadId
+  AppendValue<uint32_t>(user_data, 43);  // OldThreadId
+  user_data.resize(24);
+
+  std::optional<CSwitchPayload> payload = DecodeCSwitchPayload(/*version=*/2, user_data);
+  ASSERT_TRUE(payload.has_value());
+  EXPECT_EQ(payload->new_tid, 42);
+  EXPECT_EQ(payload->old_tid, 43);
+
+  EXPECT_FALSE(DecodeCSwitchPayload(/*version=*/1, user_data).has_value());
+  EXPECT_FALSE(
+      DecodeCSwitchPayload(/*version=*/2, absl::MakeConstSpan(user_data).subspan(0, 4))
+          .has_value());
+}
+
+TEST(EtwRecordDecoding, DecodeStackWalkPayload) {
+  std::vector<uint8_t> user_data;
+  AppendValue<uint64_t>(user_data, 1234);         // EventTimeStamp
+  AppendValue<uint32_t>(user_data, 42);           // StackProcess
+  AppendValue<uint32_t>(user_data, 43);           // StackThread
+  AppendValue<uint64_t>(user_data, 0x1000'0000);  // Stack1
+  AppendValue<uint64_t>(user_data, 0x2000'0000);  // Stack2
+
+  std::optional<StackWalkPayload> payload = DecodeStackWalkPayload(/*version=*/2, user_data);
+  ASSERT_TRUE(payload.has_value());
+  EXPECT_EQ(payload->pid, 42);
+  EXPECT_EQ(payload->tid, 43);
+  ASSERT_EQ(payload->stack_data.size(), 2 * sizeof(uint64_t));
+  EXPECT_EQ(payload->stack_data.data(), user_data.data() + kStackWalkStackDataOffset);
+
+  EXPECT_FALSE(DecodeStackWalkPayload(/*version=*/1, user_data).has_value());
+  EXPECT_FALSE(
+      DecodeStackWalkPayload(/*version=*/2, absl::MakeConstSpan(user_data).subspan(0, 12))
+          .has_value());
+}
+
+}  // namespace orbit_windows_tracing
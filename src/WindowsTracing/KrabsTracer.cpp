@@ -4,13 +4,16 @@
 
 #include "KrabsTracer.h"
 
-#include <absl/base/casts.h>
+#include <absl/types/span.h>
 #include <evntrace.h>
+#include <string.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <optional>
 
 #include "EtwEventTypes.h"
+#include "EtwRecordDecoding.h"
 #include "ObjectUtils/CoffFile.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
@@ -26,15 +29,24 @@
 namespace orbit_windows_tracing {
 
 using orbit_grpc_protos::Callstack;
-using orbit_grpc_protos::FullCallstackSample;
+using orbit_grpc_protos::CallstackSample;
+using orbit_grpc_protos::InternedCallstack;
 using orbit_grpc_protos::SchedulingSlice;
 using orbit_windows_utils::PathConverter;
 
+namespace {
+
+[[nodiscard]] absl::Span<const uint8_t> GetUserData(const EVENT_RECORD& record) {
+  return {static_cast<const uint8_t*>(record.UserData), record.UserDataLength};
+}
+
+}  // namespace
+
 KrabsTracer::KrabsTracer(uint32_t pid, double sampling_frequency_hz, TracerListener* listener)
     : KrabsTracer(pid, sampling_frequency_hz, listener, ProviderFlags::kAll) {}
 
 KrabsTracer::KrabsTracer(uint32_t pid, double sampling_frequency_hz, TracerListener* listener,
-                         ProviderFlags providers)
+                         ProviderFlags providers, BufferOptions buffer_options)
     : target_pid_(pid),
       sampling_frequency_hz_(sampling_frequency_hz),
       listener_(listener),
@@ -42,16 +54,17 @@ KrabsTracer::KrabsTracer(uint32_t pid, double sampling_frequency_hz, TracerListe
       kernel_trace_(KERNEL_LOGGER_NAME),
       stack_walk_provider_(EVENT_TRACE_FLAG_PROFILE, krabs::guids::stack_walk) {
   path_converter_ = orbit_windows_utils::PathConverter::Create();
-  SetTraceProperties();
+  SetTraceProperties(buffer_options);
   EnableProviders();
 }
 
-void KrabsTracer::SetTraceProperties() {
+void KrabsTracer::SetTraceProperties(const BufferOptions& buffer_options) {
   // https://docs.microsoft.com/en-us/windows/win32/api/evntrace/ns-evntrace-event_trace_properties
+  constexpr uint32_t kMinimumBuffers = 12;
   EVENT_TRACE_PROPERTIES properties = {0};
-  properties.BufferSize = 256;
-  properties.MinimumBuffers = 12;
-  properties.MaximumBuffers = 48;
+  properties.BufferSize = buffer_options.buffer_size_kb;
+  properties.MinimumBuffers = std::min(kMinimumBuffers, buffer_options.max_buffer_count);
+  properties.MaximumBuffers = buffer_options.max_buffer_count;
   properties.FlushTimer = 1;
   properties.LogFileMode = EVENT_TRACE_REAL_TIME_MODE;
   kernel_trace_.set_trace_properties(&properties);
@@ -133,7 +146,10 @@ void KrabsTracer::Stop() {
   StopKernelTrace();
   StopUserTrace();
 
-  OutputStats();
+  krabs::trace_stats trace_stats = kernel_trace_.query_stats();
+  etw_stats_.set_events_lost(trace_stats.eventsLost);
+  etw_stats_.set_buffers_lost(trace_stats.buffersLost);
+  OutputStats(trace_stats);
   SetIsSystemProfilePrivilegeEnabled(false);
   context_switch_manager_ = nullptr;
 }
@@ -171,23 +187,35 @@ void KrabsTracer::OnThreadEvent(const EVENT_RECORD& record, const krabs::trace_c
       // The Start event type corresponds to a thread's creation. The DCStart and DCEnd event types
       // enumerate the threads that are currently running at the time the kernel session starts and
       // ends, respectively.
-      krabs::schema schema(record, context.schema_locator);
-      krabs::parser parser(schema);
-      uint32_t tid = parser.parse<uint32_t>(L"TThreadId");
-      uint32_t pid = parser.parse<uint32_t>(L"ProcessId");
-      context_switch_manager_->ProcessTidToPidMapping(tid, pid);
+      std::optional<ThreadTypeGroup1Payload> payload =
+          DecodeThreadTypeGroup1Payload(record.EventHeader.EventDescriptor.Version,
+                                        GetUserData(record));
+      if (!payload.has_value()) {
+        ++stats_.num_events_parsed_with_schema;
+        krabs::schema schema(record, context.schema_locator);
+        krabs::parser parser(schema);
+        payload = ThreadTypeGroup1Payload{parser.parse<uint32_t>(L"ProcessId"),
+                                          parser.parse<uint32_t>(L"TThreadId")};
+      }
+      context_switch_manager_->ProcessTidToPidMapping(payload->tid, payload->pid);
       break;
     }
     case kEtwThreadV2EventCSwitch: {
       // https://docs.microsoft.com/en-us/windows/win32/etw/cswitch
-      krabs::schema schema(record, context.schema_locator);
-      krabs::parser parser(schema);
-      uint32_t old_tid = parser.parse<uint32_t>(L"OldThreadId");
-      uint32_t new_tid = parser.parse<uint32_t>(L"NewThreadId");
+      std::optional<CSwitchPayload> payload =
+          DecodeCSwitchPayload(record.EventHeader.EventDescriptor.Version, GetUserData(record));
+      if (!payload.has_value()) {
+        ++stats_.num_events_parsed_with_schema;
+        krabs::schema schema(record, context.schema_locator);
+        krabs::parser parser(schema);
+        payload = CSwitchPayload{parser.parse<uint32_t>(L"NewThreadId"),
+                                 parser.parse<uint32_t>(L"OldThreadId")};
+      }
       uint64_t timestamp_ns =
           orbit_base::PerformanceCounterToNs(record.EventHeader.TimeStamp.QuadPart);
       uint16_t cpu = record.BufferContext.ProcessorIndex;
-      context_switch_manager_->ProcessContextSwitch(cpu, old_tid, new_tid, timestamp_ns);
+      context_switch_manager_->ProcessContextSwitch(cpu, payload->old_tid, payload->new_tid,
+                                                    timestamp_ns);
     } break;
     default:
       // Discard uninteresting thread events.
@@ -199,39 +227,54 @@ void KrabsTracer::OnStackWalkEvent(const EVENT_RECORD& record,
                                    const krabs::trace_context& context) {
   // https://docs.microsoft.com/en-us/windows/win32/etw/stackwalk-event
   ++stats_.num_stack_events;
-  krabs::schema schema(record, context.schema_locator);
-  krabs::parser parser(schema);
-  uint32_t pid = parser.parse<uint32_t>(L"StackProcess");
+  const absl::Span<const uint8_t> user_data = GetUserData(record);
+  std::optional<StackWalkPayload> payload =
+      DecodeStackWalkPayload(record.EventHeader.EventDescriptor.Version, user_data);
+  if (!payload.has_value()) {
+    ++stats_.num_events_parsed_with_schema;
+    krabs::schema schema(record, context.schema_locator);
+    krabs::parser parser(schema);
+    // The first address is at offset 16, see stackwalk-event doc above.
+    ORBIT_CHECK(user_data.size() >= kStackWalkStackDataOffset);
+    payload = StackWalkPayload{parser.parse<uint32_t>(L"StackProcess"),
+                               parser.parse<uint32_t>(L"StackThread"),
+                               user_data.subspan(kStackWalkStackDataOffset)};
+  }
 
   // Filter events based on target pid, if one was set.
   if (target_pid_ != orbit_base::kInvalidProcessId) {
-    if (pid != target_pid_) return;
+    if (payload->pid != target_pid_) return;
     ++stats_.num_stack_events_for_target_pid;
   }
 
-  // Get callstack addresses. The first address is at offset 16, see stackwalk-event doc above.
-  constexpr uint32_t kStackDataOffset = 16;
-  ORBIT_CHECK(record.UserDataLength >= kStackDataOffset);
-  const uint8_t* buffer_start = absl::bit_cast<uint8_t*>(record.UserData);
-  const uint8_t* buffer_end = buffer_start + record.UserDataLength;
-  const uint8_t* stack_data = buffer_start + kStackDataOffset;
-  uint32_t depth = (buffer_end - stack_data) / sizeof(void*);
-  ORBIT_CHECK(stack_data + depth * sizeof(void*) == buffer_end);
-
-  FullCallstackSample sample;
-  sample.set_pid(pid);
-  sample.set_tid(parser.parse<uint32_t>(L"StackThread"));
-  sample.set_timestamp_ns(
-      orbit_base::PerformanceCounterToNs(record.EventHeader.TimeStamp.QuadPart));
-
-  Callstack* callstack = sample.mutable_callstack();
-  callstack->set_type(Callstack::kComplete);
-  uint64_t* address = absl::bit_cast<uint64_t*>(stack_data);
-  for (size_t i = 0; i < depth; ++i, ++address) {
-    callstack->add_pcs(*address);
+  const absl::Span<const uint8_t> stack_data = payload->stack_data;
+  const size_t depth = stack_data.size() / sizeof(uint64_t);
+  ORBIT_CHECK(depth * sizeof(uint64_t) == stack_data.size());
+
+  // Copied out of the payload, as the addresses are not necessarily aligned there.
+  stack_walk_pcs_.resize(depth);
+  if (depth > 0) memcpy(stack_walk_pcs_.data(), stack_data.data(), stack_data.size());
+
+  // Identical callstacks are very frequent, so they are interned here instead of sending the full
+  // callstack of every sample to the ProducerEventProcessor.
+  const auto [callstack_id, is_new_callstack] = callstack_interner_.GetOrAssignId(stack_walk_pcs_);
+  if (is_new_callstack) {
+    ++stats_.num_unique_callstacks;
+    InternedCallstack interned_callstack;
+    interned_callstack.set_key(callstack_id);
+    Callstack* callstack = interned_callstack.mutable_intern();
+    callstack->set_type(Callstack::kComplete);
+    callstack->mutable_pcs()->Add(stack_walk_pcs_.begin(), stack_walk_pcs_.end());
+    listener_->OnInternedCallstack(std::move(interned_callstack));
   }
 
-  listener_->OnCallstackSample(sample);
+  CallstackSample sample;
+  sample.set_pid(payload->pid);
+  sample.set_tid(payload->tid);
+  sample.set_timestamp_ns(
+      orbit_base::PerformanceCounterToNs(record.EventHeader.TimeStamp.QuadPart));
+  sample.set_callstack_id(callstack_id);
+  listener_->OnCallstackSample(std::move(sample));
 }
 
 void KrabsTracer::OnImageLoadEvent(const EVENT_RECORD& record,
@@ -281,8 +324,7 @@ std::vector<orbit_windows_utils::Module> KrabsTracer::GetLoadedModules() const {
   return modules;
 }
 
-void KrabsTracer::OutputStats() {
-  krabs::trace_stats trace_stats = kernel_trace_.query_stats();
+void KrabsTracer::OutputStats(const krabs::trace_stats& trace_stats) {
   ORBIT_LOG("--- ETW stats ---");
   ORBIT_LOG("Number of buffers: %u", trace_stats.buffersCount);
   ORBIT_LOG("Free buffers: %u", trace_stats.buffersFree);
@@ -294,6 +336,9 @@ void KrabsTracer::OutputStats() {
   ORBIT_LOG("--- KrabsTracer stats ---");
   ORBIT_LOG("Number of stack events: %u", stats_.num_stack_events);
   ORBIT_LOG("Number of stack events for target pid: %u", stats_.num_stack_events_for_target_pid);
+  ORBIT_LOG("Number of unique callstacks: %u", stats_.num_unique_callstacks);
+  ORBIT_LOG("Number of thread and stack events parsed with schema: %u",
+            stats_.num_events_parsed_with_schema);
   context_switch_manager_->OutputStats();
   if (graphics_etw_provider_ != nullptr) {
     graphics_etw_provider_->OutputStats();
@@ -10,8 +10,11 @@
 #include <krabs/krabs.hpp>
 #include <memory>
 #include <thread>
+#include <vector>
 
+#include "CallstackInterner.h"
 #include "ContextSwitchManager.h"
+#include "GrpcProtos/capture.pb.h"
 #include "GraphicsEtwProvider.h"
 #include "OrbitBase/ThreadConstants.h"
 #include "WindowsTracing/TracerListener.h"
@@ -34,9 +37,15 @@ class KrabsTracer {
     kAll = kThread | kContextSwitch | kStackWalk | kImageLoad | kGraphics
   };
 
+  // Buffers of the kernel trace session. ETW loses events when all buffers are full.
+  struct BufferOptions {
+    uint32_t buffer_size_kb = 256;
+    uint32_t max_buffer_count = 48;
+  };
+
   KrabsTracer(uint32_t pid, double sampling_frequency_hz, TracerListener* listener);
   KrabsTracer(uint32_t pid, double sampling_frequency_hz, TracerListener* listener,
-              ProviderFlags providers);
+              ProviderFlags providers, BufferOptions buffer_options = {});
 
   KrabsTracer() = delete;
   void Start();
@@ -44,9 +53,11 @@ class KrabsTracer {
 
   [[nodiscard]] bool IsProviderEnabled(ProviderFlags provider) const;
   [[nodiscard]] std::vector<orbit_windows_utils::Module> GetLoadedModules() const;
+  // Only valid after Stop().
+  [[nodiscard]] orbit_grpc_protos::EtwStats GetEtwStats() const { return etw_stats_; }
 
  private:
-  void SetTraceProperties();
+  void SetTraceProperties(const BufferOptions& buffer_options);
   void EnableProviders();
   void SetIsSystemProfilePrivilegeEnabled(bool value);
   void SetupStackTracing();
@@ -57,13 +68,16 @@ class KrabsTracer {
   void OnThreadEvent(const EVENT_RECORD& record, const krabs::trace_context& context);
   void OnStackWalkEvent(const EVENT_RECORD& record, const krabs::trace_context& context);
   void OnImageLoadEvent(const EVENT_RECORD& record, const krabs::trace_context& context);
-  void OutputStats();
+  void OutputStats(const krabs::trace_stats& trace_stats);
 
   struct Stats {
     uint64_t num_thread_events = 0;
     uint64_t num_stack_events = 0;
     uint64_t num_stack_events_for_target_pid = 0;
+    uint64_t num_unique_callstacks = 0;
     uint64_t num_image_load_events_for_target_pid = 0;
+    // Thread and stack walk events that EtwRecordDecoding couldn't decode.
+    uint64_t num_events_parsed_with_schema = 0;
   };
 
  private:
@@ -73,9 +87,13 @@ class KrabsTracer {
   ProviderFlags providers_ = ProviderFlags::kAll;
 
   std::unique_ptr<ContextSwitchManager> context_switch_manager_;
+  // Only used on the kernel trace thread.
+  CallstackInterner callstack_interner_;
+  std::vector<uint64_t> stack_walk_pcs_;
   std::unique_ptr<std::thread> kernel_trace_thread_;
   std::unique_ptr<std::thread> user_trace_thread_;
   Stats stats_;
+  orbit_grpc_protos::EtwStats etw_stats_;
 
   krabs::user_trace user_trace_;
   krabs::kernel_trace kernel_trace_;
@@ -0,0 +1,113 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "QueuedTracerListener.h"
+
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Overloaded.h"
+#include "OrbitBase/ThreadUtils.h"
+
+namespace orbit_windows_tracing {
+
+using orbit_grpc_protos::CallstackSample;
+using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::InternedCallstack;
+using orbit_grpc_protos::ModulesSnapshot;
+using orbit_grpc_protos::ModuleUpdateEvent;
+using orbit_grpc_protos::PresentEvent;
+using orbit_grpc_protos::SchedulingSlice;
+using orbit_grpc_protos::ThreadNamesSnapshot;
+
+QueuedTracerListener::QueuedTracerListener(TracerListener* listener) : listener_{listener} {
+  ORBIT_CHECK(listener_ != nullptr);
+  forwarding_thread_ = std::thread{&QueuedTracerListener::ForwardEvents, this};
+}
+
+QueuedTracerListener::~QueuedTracerListener() {
+  {
+    absl::MutexLock lock{&mutex_};
+    stop_requested_ = true;
+  }
+  forwarding_thread_.join();
+}
+
+void QueuedTracerListener::OnSchedulingSlice(SchedulingSlice scheduling_slice) {
+  Enqueue(std::move(scheduling_slice));
+}
+
+void QueuedTracerListener::OnInternedCallstack(InternedCallstack interned_callstack) {
+  Enqueue(std::move(interned_callstack));
+}
+
+void QueuedTracerListener::OnCallstackSample(CallstackSample callstack_sample) {
+  Enqueue(std::move(callstack_sample));
+}
+
+void QueuedTracerListener::OnFunctionCall(FunctionCall function_call) {
+  Enqueue(std::move(function_call));
+}
+
+void QueuedTracerListener::OnModuleUpdate(ModuleUpdateEvent module_update_event) {
+  Enqueue(std::move(module_update_event));
+}
+
+void QueuedTracerListener::OnModulesSnapshot(ModulesSnapshot modules_snapshot) {
+  Enqueue(std::move(modules_snapshot));
+}
+
+void QueuedTracerListener::OnThreadNamesSnapshot(ThreadNamesSnapshot thread_names_snapshot) {
+  Enqueue(std::move(thread_names_snapshot));
+}
+
+void QueuedTracerListener::OnPresentEvent(PresentEvent present_event) {
+  Enqueue(std::move(present_event));
+}
+
+void QueuedTracerListener::Enqueue(Event event) {
+  absl::MutexLock lock{&mutex_};
+  queued_events_.emplace_back(std::move(event));
+}
+
+bool QueuedTracerListener::HasQueuedEventsOrIsStopping() const {
+  return !queued_events_.empty() || stop_requested_;
+}
+
+void QueuedTracerListener::ForwardEvents() {
+  orbit_base::SetCurrentThreadName("ForwardEtwEvents");
+  std::vector<Event> batch;
+  while (true) {
+    {
+      absl::MutexLock lock{&mutex_};
+      mutex_.Await(absl::Condition(this, &QueuedTracerListener::HasQueuedEventsOrIsStopping));
+      if (queued_events_.empty()) return;
+      // The producers keep appending to the (empty) vector that had been used for the previous
+      // batch, so the allocations are reused.
+      std::swap(batch, queued_events_);
+    }
+
+    for (Event& event : batch) {
+      ForwardEvent(std::move(event));
+    }
+    batch.clear();
+  }
+}
+
+void QueuedTracerListener::ForwardEvent(Event&& event) {
+  std::visit(
+      orbit_base::Overloaded{
+          [this](SchedulingSlice&& e) { listener_->OnSchedulingSlice(std::move(e)); },
+          [this](InternedCallstack&& e) { listener_->OnInternedCallstack(std::move(e)); },
+          [this](CallstackSample&& e) { listener_->OnCallstackSample(std::move(e)); },
+          [this](FunctionCall&& e) { listener_->OnFunctionCall(std::move(e)); },
+          [this](ModuleUpdateEvent&& e) { listener_->OnModuleUpdate(std::move(e)); },
+          [this](ModulesSnapshot&& e) { listener_->OnModulesSnapshot(std::move(e)); },
+          [this](ThreadNamesSnapshot&& e) { listener_->OnThreadNamesSnapshot(std::move(e)); },
+          [this](PresentEvent&& e) { listener_->OnPresentEvent(std::move(e)); },
+      },
+      std::move(event));
+}
+
+}  // namespace orbit_windows_tracing
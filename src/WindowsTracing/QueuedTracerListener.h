@@ -0,0 +1,68 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WINDOWS_TRACING_QUEUED_TRACER_LISTENER_H_
+#define WINDOWS_TRACING_QUEUED_TRACER_LISTENER_H_
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+#include "WindowsTracing/TracerListener.h"
+
+namespace orbit_windows_tracing {
+
+// TracerListener that only queues the events it receives, so that the ETW callbacks producing them
+// return quickly and the ETW buffers keep being consumed even when the downstream listener is slow.
+// A separate thread takes the queued events in batches and forwards them to `listener`, in the
+// order in which they were received. The queue is unbounded: dropping events here would be no
+// better than letting ETW lose them.
+class QueuedTracerListener : public TracerListener {
+ public:
+  explicit QueuedTracerListener(TracerListener* listener);
+  // Forwards the events that are still queued and joins the forwarding thread.
+  ~QueuedTracerListener() override;
+
+  QueuedTracerListener(const QueuedTracerListener&) = delete;
+  QueuedTracerListener& operator=(const QueuedTracerListener&) = delete;
+  QueuedTracerListener(QueuedTracerListener&&) = delete;
+  QueuedTracerListener& operator=(QueuedTracerListener&&) = delete;
+
+  void OnSchedulingSlice(orbit_grpc_protos::SchedulingSlice scheduling_slice) override;
+  void OnInternedCallstack(orbit_grpc_protos::InternedCallstack interned_callstack) override;
+  void OnCallstackSample(orbit_grpc_protos::CallstackSample callstack_sample) override;
+  void OnFunctionCall(orbit_grpc_protos::FunctionCall function_call) override;
+  void OnModuleUpdate(orbit_grpc_protos::ModuleUpdateEvent module_update_event) override;
+  void OnModulesSnapshot(orbit_grpc_protos::ModulesSnapshot modules_snapshot) override;
+  void OnThreadNamesSnapshot(orbit_grpc_protos::ThreadNamesSnapshot thread_names_snapshot) override;
+  void OnPresentEvent(orbit_grpc_protos::PresentEvent present_event) override;
+
+ private:
+  using Event =
+      std::variant<orbit_grpc_protos::SchedulingSlice, orbit_grpc_protos::InternedCallstack,
+                   orbit_grpc_protos::CallstackSample, orbit_grpc_protos::FunctionCall,
+                   orbit_grpc_protos::ModuleUpdateEvent, orbit_grpc_protos::ModulesSnapshot,
+                   orbit_grpc_protos::ThreadNamesSnapshot, orbit_grpc_protos::PresentEvent>;
+
+  void Enqueue(Event event);
+  [[nodiscard]] bool HasQueuedEventsOrIsStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void ForwardEvents();
+  void ForwardEvent(Event&& event);
+
+  TracerListener* listener_;
+
+  absl::Mutex mutex_;
+  std::vector<Event> queued_events_ ABSL_GUARDED_BY(mutex_);
+  bool stop_requested_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::thread forwarding_thread_;
+};
+
+}  // namespace orbit_windows_tracing
+
+#endif  // WINDOWS_TRACING_QUEUED_TRACER_LISTENER_H_
@@ -0,0 +1,111 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/synchronization/mutex.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "GrpcProtos/capture.pb.h"
+#include "QueuedTracerListener.h"
+#include "WindowsTracing/TracerListener.h"
+
+using ::testing::ElementsAre;
+
+namespace orbit_windows_tracing {
+
+namespace {
+
+// Records the timestamps of the scheduling slices and callstack samples, and the keys of the
+// interned callstacks, in the order in which it receives them.
+class RecordingTracerListener : public TracerListener {
+ public:
+  void OnSchedulingSlice(orbit_grpc_protos::SchedulingSlice scheduling_slice) override {
+    Record(scheduling_slice.out_timestamp_ns());
+  }
+  void OnInternedCallstack(orbit_grpc_protos::InternedCallstack interned_callstack) override {
+    Record(interned_callstack.key());
+  }
+  void OnCallstackSample(orbit_grpc_protos::CallstackSample callstack_sample) override {
+    Record(callstack_sample.timestamp_ns());
+  }
+  void OnFunctionCall(orbit_grpc_protos::FunctionCall /*function_call*/) override {}
+  void OnModuleUpdate(orbit_grpc_protos::ModuleUpdateEvent /*module_update_event*/) override {}
+  void OnModulesSnapshot(orbit_grpc_protos::ModulesSnapshot /*modules_snapshot*/) override {}
+  void OnThreadNamesSnapshot(
+      orbit_grpc_protos::ThreadNamesSnapshot /*thread_names_snapshot*/) override {}
+  void OnPresentEvent(orbit_grpc_protos::PresentEvent /*present_event*/) override {}
+
+  [[nodiscard]] std::vector<uint64_t> GetRecordedValues() const {
+    absl::MutexLock lock{&mutex_};
+    return recorded_values_;
+  }
+
+ private:
+  void Record(uint64_t value) {
+    EXPECT_NE(std::this_thread::get_id(), test_thread_id_);
+    absl::MutexLock lock{&mutex_};
+    recorded_values_.push_back(value);
+  }
+
+  std::thread::id test_thread_id_ = std::this_thread::get_id();
+  mutable absl::Mutex mutex_;
+  std::vector<uint64_t> recorded_values_;
+};
+
+}  // namespace
+
+TEST(QueuedTracerListener, ForwardsEventsInOrderOnAnotherThread) {
+  RecordingTracerListener recording_listener;
+  {
+    QueuedTracerListener queued_listener{&recording_listener};
+
+    orbit_grpc_protos::InternedCallstack interned_callstack;
+    interned_callstack.set_key(1);
+    queued_listener.OnInternedCallstack(interned_callstack);
+    orbit_grpc_protos::CallstackSample callstack_sample;
+    callstack_sample.set_timestamp_ns(2);
+    queued_listener.OnCallstackSample(callstack_sample);
+    orbit_grpc_protos::SchedulingSlice scheduling_slice;
+    scheduling_slice.set_out_timestamp_ns(3);
+    queued_listener.OnSchedulingSlice(scheduling_slice);
+  }
+
+  EXPECT_THAT(recording_listener.GetRecordedValues(), ElementsAre(1, 2, 3));
+}
+
+TEST(QueuedTracerListener, ForwardsAllEventsFromMultipleThreads) {
+  RecordingTracerListener recording_listener;
+  constexpr uint64_t kNumEventsPerThread = 10'000;
+  {
+    QueuedTracerListener queued_listener{&recording_listener};
+    std::vector<std::thread> threads;
+    for (uint64_t thread_index = 0; thread_index < 2; ++thread_index) {
+      threads.emplace_back([&queued_listener, thread_index] {
+        for (uint64_t i = 0; i < kNumEventsPerThread; ++i) {
+          orbit_grpc_protos::CallstackSample callstack_sample;
+          callstack_sample.set_timestamp_ns(thread_index * kNumEventsPerThread + i);
+          queued_listener.OnCallstackSample(callstack_sample);
+        }
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+  }
+
+  const std::vector<uint64_t> recorded_values = recording_listener.GetRecordedValues();
+  ASSERT_EQ(recorded_values.size(), 2 * kNumEventsPerThread);
+  // The events of each thread are forwarded in the order in which they were produced.
+  uint64_t next_expected_values[] = {0, kNumEventsPerThread};
+  for (uint64_t value : recorded_values) {
+    uint64_t& next_expected_value = next_expected_values[value / kNumEventsPerThread];
+    EXPECT_EQ(value, next_expected_value);
+    ++next_expected_value;
+  }
+}
+
+}  // namespace orbit_windows_tracing
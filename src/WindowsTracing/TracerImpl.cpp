@@ -27,15 +27,28 @@ void TracerImpl::Start() {
   ORBIT_CHECK(krabs_tracer_ == nullptr);
   SendModulesSnapshot();
   SendThreadNamesSnapshot();
-  krabs_tracer_ = std::make_unique<KrabsTracer>(capture_options_.pid(),
-                                                capture_options_.samples_per_second(), listener_);
+
+  KrabsTracer::BufferOptions buffer_options;
+  if (capture_options_.etw_buffer_size_kb() != 0) {
+    buffer_options.buffer_size_kb = capture_options_.etw_buffer_size_kb();
+  }
+  if (capture_options_.etw_max_buffer_count() != 0) {
+    buffer_options.max_buffer_count = capture_options_.etw_max_buffer_count();
+  }
+  queued_listener_ = std::make_unique<QueuedTracerListener>(listener_);
+  krabs_tracer_ = std::make_unique<KrabsTracer>(
+      capture_options_.pid(), capture_options_.samples_per_second(), queued_listener_.get(),
+      KrabsTracer::ProviderFlags::kAll, buffer_options);
   krabs_tracer_->Start();
 }
 
 void TracerImpl::Stop() {
   ORBIT_CHECK(krabs_tracer_ != nullptr);
   krabs_tracer_->Stop();
+  etw_stats_ = krabs_tracer_->GetEtwStats();
   krabs_tracer_ = nullptr;
+  // Forwards the events that are still queued.
+  queued_listener_ = nullptr;
 }
 
 void TracerImpl::SendModulesSnapshot() {
@@ -7,6 +7,7 @@
 
 #include "GrpcProtos/capture.pb.h"
 #include "KrabsTracer.h"
+#include "QueuedTracerListener.h"
 #include "WindowsTracing/Tracer.h"
 #include "WindowsTracing/TracerListener.h"
 
@@ -22,6 +23,8 @@ class TracerImpl : public Tracer {
   virtual void Start();
   virtual void Stop();
 
+  [[nodiscard]] orbit_grpc_protos::EtwStats GetEtwStats() const override { return etw_stats_; }
+
  private:
   void SendModulesSnapshot();
   void SendThreadNamesSnapshot();
@@ -29,7 +32,10 @@ class TracerImpl : public Tracer {
  private:
   orbit_grpc_protos::CaptureOptions capture_options_;
   TracerListener* listener_ = nullptr;
+  // Decouples the ETW callbacks in KrabsTracer from the delivery of the events to `listener_`.
+  std::unique_ptr<QueuedTracerListener> queued_listener_;
   std::unique_ptr<KrabsTracer> krabs_tracer_;
+  orbit_grpc_protos::EtwStats etw_stats_;
 };
 
 }  // namespace orbit_windows_tracing
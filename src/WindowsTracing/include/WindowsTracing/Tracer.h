@@ -18,6 +18,9 @@ class Tracer {
   virtual void Start() = 0;
   virtual void Stop() = 0;
 
+  // Statistics of the last capture, only valid after Stop().
+  [[nodiscard]] virtual orbit_grpc_protos::EtwStats GetEtwStats() const = 0;
+
   [[nodiscard]] static std::unique_ptr<Tracer> Create(
       orbit_grpc_protos::CaptureOptions capture_options, TracerListener* listener);
 };
@@ -14,7 +14,10 @@ class TracerListener {
  public:
   virtual ~TracerListener() = default;
   virtual void OnSchedulingSlice(orbit_grpc_protos::SchedulingSlice scheduling_slice) = 0;
-  virtual void OnCallstackSample(orbit_grpc_protos::FullCallstackSample callstack_sample) = 0;
+  // Each callstack is sent once as an InternedCallstack, before the first CallstackSample that
+  // refers to it.
+  virtual void OnInternedCallstack(orbit_grpc_protos::InternedCallstack interned_callstack) = 0;
+  virtual void OnCallstackSample(orbit_grpc_protos::CallstackSample callstack_sample) = 0;
   virtual void OnFunctionCall(orbit_grpc_protos::FunctionCall function_call) = 0;
   virtual void OnModuleUpdate(orbit_grpc_protos::ModuleUpdateEvent module_update_event) = 0;
   virtual void OnModulesSnapshot(orbit_grpc_protos::ModulesSnapshot modules_snapshot) = 0;
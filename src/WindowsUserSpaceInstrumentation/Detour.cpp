@@ -0,0 +1,116 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "Detour.h"
+
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+
+namespace orbit_windows_user_space_instrumentation {
+
+namespace {
+
+class MachineCode {
+ public:
+  MachineCode& Append(std::initializer_list<uint8_t> bytes) {
+    code_.insert(code_.end(), bytes);
+    return *this;
+  }
+
+  MachineCode& AppendImmediate64(uint64_t value) {
+    for (size_t i = 0; i < sizeof(value); ++i) {
+      code_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+    return *this;
+  }
+
+  // movabs rax, value
+  MachineCode& MovImmediateToRax(uint64_t value) {
+    return Append({0x48, 0xb8}).AppendImmediate64(value);
+  }
+
+  // movdqu [rsp + offset], xmm<index>
+  MachineCode& StoreXmmToStack(uint8_t index, uint8_t offset) {
+    return Append({0xf3, 0x0f, 0x7f, static_cast<uint8_t>(0x44 | (index << 3)), 0x24, offset});
+  }
+
+  // movdqu xmm<index>, [rsp + offset]
+  MachineCode& LoadXmmFromStack(uint8_t index, uint8_t offset) {
+    return Append({0xf3, 0x0f, 0x6f, static_cast<uint8_t>(0x44 | (index << 3)), 0x24, offset});
+  }
+
+  [[nodiscard]] std::vector<uint8_t> Take() { return std::move(code_); }
+
+ private:
+  std::vector<uint8_t> code_;
+};
+
+// Four integer argument registers are pushed, and the stack needs to be 16 byte aligned before the
+// call to the payload: 0x20 bytes of shadow space, 4 * 0x10 bytes for xmm0-xmm3, 8 bytes padding.
+constexpr uint8_t kEntryStackSize = 0x68;
+constexpr uint8_t kEntryXmmOffset = 0x20;
+constexpr uint8_t kEntryReturnAddressOffset = kEntryStackSize + 4 * 8;
+
+// rax is pushed: 0x20 bytes of shadow space, 0x10 bytes for xmm0, 8 bytes padding.
+constexpr uint8_t kExitStackSize = 0x38;
+constexpr uint8_t kExitXmmOffset = 0x20;
+
+}  // namespace
+
+std::vector<uint8_t> CreateEntryStub(uint64_t hook_data_address, uint64_t entry_payload_address) {
+  MachineCode code;
+  // push rcx; push rdx; push r8; push r9
+  code.Append({0x51, 0x52, 0x41, 0x50, 0x41, 0x51});
+  // sub rsp, kEntryStackSize
+  code.Append({0x48, 0x83, 0xec, kEntryStackSize});
+  for (uint8_t i = 0; i < 4; ++i) {
+    code.StoreXmmToStack(i, kEntryXmmOffset + 0x10 * i);
+  }
+  // lea r8, [rsp + kEntryReturnAddressOffset]
+  code.Append({0x4c, 0x8d, 0x84, 0x24, kEntryReturnAddressOffset, 0x00, 0x00, 0x00});
+  // mov rcx, [r8]
+  code.Append({0x49, 0x8b, 0x08});
+  // mov rdx, [hook_data_address + offsetof(HookData, function_id)]
+  code.MovImmediateToRax(hook_data_address + offsetof(HookData, function_id));
+  code.Append({0x48, 0x8b, 0x10});
+  // call entry_payload_address
+  code.MovImmediateToRax(entry_payload_address);
+  code.Append({0xff, 0xd0});
+  for (uint8_t i = 0; i < 4; ++i) {
+    code.LoadXmmFromStack(i, kEntryXmmOffset + 0x10 * i);
+  }
+  // add rsp, kEntryStackSize
+  code.Append({0x48, 0x83, 0xc4, kEntryStackSize});
+  // pop r9; pop r8; pop rdx; pop rcx
+  code.Append({0x41, 0x59, 0x41, 0x58, 0x5a, 0x59});
+  // jmp [hook_data_address + offsetof(HookData, original)]
+  code.MovImmediateToRax(hook_data_address + offsetof(HookData, original));
+  code.Append({0xff, 0x20});
+  return code.Take();
+}
+
+std::vector<uint8_t> CreateReturnTrampoline(uint64_t exit_payload_address) {
+  MachineCode code;
+  // push rax
+  code.Append({0x50});
+  // sub rsp, kExitStackSize
+  code.Append({0x48, 0x83, 0xec, kExitStackSize});
+  code.StoreXmmToStack(0, kExitXmmOffset);
+  // call exit_payload_address
+  code.MovImmediateToRax(exit_payload_address);
+  code.Append({0xff, 0xd0});
+  // mov r11, rax
+  code.Append({0x49, 0x89, 0xc3});
+  code.LoadXmmFromStack(0, kExitXmmOffset);
+  // add rsp, kExitStackSize
+  code.Append({0x48, 0x83, 0xc4, kExitStackSize});
+  // pop rax
+  code.Append({0x58});
+  // jmp r11
+  code.Append({0x41, 0xff, 0xe3});
+  return code.Take();
+}
+
+}  // namespace orbit_windows_user_space_instrumentation
@@ -0,0 +1,39 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WINDOWS_USER_SPACE_INSTRUMENTATION_DETOUR_H_
+#define WINDOWS_USER_SPACE_INSTRUMENTATION_DETOUR_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace orbit_windows_user_space_instrumentation {
+
+// Per instrumented function data read by its entry stub. `original` is the trampoline created by
+// MinHook that executes the relocated prologue and jumps back into the function.
+struct HookData {
+  uint64_t function_id;
+  uint64_t original;
+};
+
+// Returns the machine code of the detour MinHook redirects an instrumented function to. It saves
+// the integer and the first four vector argument registers, calls
+// `entry_payload(return_address, function_id, address_of_return_address)` following the Windows x64
+// calling convention, restores the registers and jumps to `hook_data->original`. This allows the
+// payload to replace the return address of the function with the return trampoline.
+//
+// Only xmm0-xmm3 are saved: functions taking more vector arguments with __vectorcall, or 256 bit
+// arguments, are not supported.
+[[nodiscard]] std::vector<uint8_t> CreateEntryStub(uint64_t hook_data_address,
+                                                   uint64_t entry_payload_address);
+
+// Returns the machine code of the code an instrumented function returns to. It saves the return
+// value registers rax and xmm0, calls `exit_payload()`, restores the return value and jumps to the
+// address returned by the payload, i.e., the original return address of the function.
+[[nodiscard]] std::vector<uint8_t> CreateReturnTrampoline(uint64_t exit_payload_address);
+
+}  // namespace orbit_windows_user_space_instrumentation
+
+#endif  // WINDOWS_USER_SPACE_INSTRUMENTATION_DETOUR_H_
@@ -0,0 +1,68 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Detour.h"
+
+namespace orbit_windows_user_space_instrumentation {
+
+using testing::ElementsAre;
+using testing::ElementsAreArray;
+
+namespace {
+
+[[nodiscard]] uint64_t ReadImmediate64(const std::vector<uint8_t>& code, size_t offset) {
+  uint64_t value = 0;
+  std::memcpy(&value, code.data() + offset, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+TEST(Detour, CreateEntryStub) {
+  constexpr uint64_t kHookDataAddress = 0x0102030405060708;
+  constexpr uint64_t kEntryPayloadAddress = 0x1112131415161718;
+  const std::vector<uint8_t> code = CreateEntryStub(kHookDataAddress, kEntryPayloadAddress);
+  ASSERT_EQ(code.size(), 0x74);
+
+  // push rcx; push rdx; push r8; push r9; sub rsp, 0x68
+  EXPECT_THAT(std::vector<uint8_t>(code.begin(), code.begin() + 10),
+              ElementsAre(0x51, 0x52, 0x41, 0x50, 0x41, 0x51, 0x48, 0x83, 0xec, 0x68));
+  // lea r8, [rsp+0x88]: the location of the return address after pushing four registers.
+  EXPECT_THAT(std::vector<uint8_t>(code.begin() + 0x22, code.begin() + 0x2a),
+              ElementsAre(0x4c, 0x8d, 0x84, 0x24, 0x88, 0x00, 0x00, 0x00));
+  EXPECT_EQ(ReadImmediate64(code, 0x2f), kHookDataAddress + offsetof(HookData, function_id));
+  EXPECT_EQ(ReadImmediate64(code, 0x3c), kEntryPayloadAddress);
+  EXPECT_EQ(ReadImmediate64(code, 0x6a), kHookDataAddress + offsetof(HookData, original));
+  // add rsp, 0x68; pop r9; pop r8; pop rdx; pop rcx
+  EXPECT_THAT(std::vector<uint8_t>(code.begin() + 0x5e, code.begin() + 0x68),
+              ElementsAre(0x48, 0x83, 0xc4, 0x68, 0x41, 0x59, 0x41, 0x58, 0x5a, 0x59));
+  // jmp [rax]
+  EXPECT_THAT(std::vector<uint8_t>(code.end() - 2, code.end()), ElementsAre(0xff, 0x20));
+}
+
+TEST(Detour, CreateReturnTrampoline) {
+  const std::vector<uint8_t> code = CreateReturnTrampoline(0x1112131415161718);
+  const std::vector<uint8_t> expected_code = {
+      0x50,                                                        // push rax
+      0x48, 0x83, 0xec, 0x38,                                      // sub rsp, 0x38
+      0xf3, 0x0f, 0x7f, 0x44, 0x24, 0x20,                          // movdqu [rsp+0x20], xmm0
+      0x48, 0xb8, 0x18, 0x17, 0x16, 0x15, 0x14, 0x13, 0x12, 0x11,  // movabs rax, ExitPayload
+      0xff, 0xd0,                                                  // call rax
+      0x49, 0x89, 0xc3,                                            // mov r11, rax
+      0xf3, 0x0f, 0x6f, 0x44, 0x24, 0x20,                          // movdqu xmm0, [rsp+0x20]
+      0x48, 0x83, 0xc4, 0x38,                                      // add rsp, 0x38
+      0x58,                                                        // pop rax
+      0x41, 0xff, 0xe3};                                           // jmp r11
+  EXPECT_THAT(code, ElementsAreArray(expected_code));
+}
+
+}  // namespace orbit_windows_user_space_instrumentation
@@ -0,0 +1,119 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "WindowsUserSpaceInstrumentation/InstrumentProcess.h"
+
+#include <MinHook.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_format.h>
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "ModuleUtils/VirtualAndAbsoluteAddresses.h"
+#include "OrbitBase/ExecutablePath.h"
+#include "OrbitBase/Logging.h"
+#include "WindowsUserSpaceInstrumentation/InstrumentationInfo.h"
+#include "WindowsUtils/DllInjection.h"
+#include "WindowsUtils/ListModules.h"
+
+namespace orbit_windows_user_space_instrumentation {
+
+using orbit_grpc_protos::CaptureOptions;
+using orbit_grpc_protos::InstrumentedFunction;
+
+namespace {
+
+constexpr const char* kLibName = "OrbitUserSpaceInstrumentation.dll";
+constexpr const char* kInstrumentFunctionsFunction = "orbit_instrument_functions";
+constexpr const char* kDisableInstrumentationFunction = "orbit_disable_instrumentation";
+
+ErrorMessageOr<std::filesystem::path> GetLibPath() {
+  const std::filesystem::path dll_path = orbit_base::GetExecutableDir() / kLibName;
+  if (std::filesystem::exists(dll_path)) {
+    return dll_path;
+  }
+  return ErrorMessage(absl::StrFormat("%s not found on system.", kLibName));
+}
+
+}  // namespace
+
+ErrorMessageOr<InstrumentationResult> InstrumentProcess(const CaptureOptions& capture_options) {
+  ORBIT_SCOPED_TIMED_LOG("Instrumenting functions in process %u", capture_options.pid());
+  const uint32_t pid = capture_options.pid();
+  InstrumentationResult result;
+
+  absl::flat_hash_map<std::string, orbit_windows_utils::Module> paths_to_modules;
+  for (orbit_windows_utils::Module& module : orbit_windows_utils::ListModules(pid)) {
+    std::string full_path = module.full_path;
+    paths_to_modules.emplace(std::move(full_path), std::move(module));
+  }
+
+  std::vector<InstrumentedFunctionInfo> function_infos;
+  for (const InstrumentedFunction& function : capture_options.instrumented_functions()) {
+    auto module_it = paths_to_modules.find(function.file_path());
+    if (module_it == paths_to_modules.end()) {
+      result.function_ids_to_error_messages[function.function_id()] =
+          absl::StrFormat("Can't instrument function \"%s\" since module \"%s\" is not loaded.",
+                          function.function_name(), function.file_path());
+      continue;
+    }
+    const orbit_windows_utils::Module& module = module_it->second;
+    InstrumentedFunctionInfo& function_info = function_infos.emplace_back();
+    function_info.function_id = function.function_id();
+    // The executable section offset is not used on Windows.
+    function_info.absolute_address = orbit_module_utils::SymbolVirtualAddressToAbsoluteAddress(
+        function.function_virtual_address(), module.address_start, module.load_bias,
+        /*module_executable_section_offset=*/0);
+    function_info.result = MH_UNKNOWN;
+  }
+
+  // Even with no function to instrument, this disables the hooks of a previous capture.
+  OUTCOME_TRY(std::filesystem::path lib_path, GetLibPath());
+  OUTCOME_TRY(orbit_windows_utils::InjectDllIfNotLoaded(pid, lib_path.string()));
+
+  // Encode the functions into the buffer "CreateRemoteThread" writes in the target process.
+  InstrumentationInfoHeader header{};
+  header.function_count = function_infos.size();
+  std::vector<char> parameter(sizeof(header) + function_infos.size() * sizeof(function_infos[0]));
+  std::memcpy(parameter.data(), &header, sizeof(header));
+  if (!function_infos.empty()) {
+    std::memcpy(parameter.data() + sizeof(header), function_infos.data(),
+                function_infos.size() * sizeof(function_infos[0]));
+  }
+
+  OUTCOME_TRY(std::vector<char> returned_parameter,
+              orbit_windows_utils::CreateRemoteThreadAndWait(
+                  pid, lib_path.filename().string(), kInstrumentFunctionsFunction, parameter));
+  ORBIT_CHECK(returned_parameter.size() == parameter.size());
+  if (!function_infos.empty()) {
+    std::memcpy(function_infos.data(), returned_parameter.data() + sizeof(header),
+                function_infos.size() * sizeof(function_infos[0]));
+  }
+
+  for (const InstrumentedFunctionInfo& function_info : function_infos) {
+    const auto status = static_cast<MH_STATUS>(function_info.result);
+    if (status == MH_OK) {
+      result.instrumented_function_ids.insert(function_info.function_id);
+      continue;
+    }
+    result.function_ids_to_error_messages[function_info.function_id] =
+        absl::StrFormat("Can't hook function at address %#x: %s", function_info.absolute_address,
+                        MH_StatusToString(status));
+  }
+  ORBIT_LOG("Instrumented %u functions, failed to instrument %u functions",
+            result.instrumented_function_ids.size(), result.function_ids_to_error_messages.size());
+
+  return result;
+}
+
+ErrorMessageOr<void> UninstrumentProcess(uint32_t pid) {
+  OUTCOME_TRY(std::filesystem::path lib_path, GetLibPath());
+  OUTCOME_TRY(orbit_windows_utils::CreateRemoteThreadAndWait(
+      pid, lib_path.filename().string(), kDisableInstrumentationFunction, {}));
+  return outcome::success();
+}
+
+}  // namespace orbit_windows_user_space_instrumentation
@@ -0,0 +1,245 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This library is injected into the Windows process Orbit is profiling. It hooks the instrumented
+// functions with MinHook and provides the payloads executed on their entry and exit.
+//
+// MinHook redirects an instrumented function to an entry stub (see Detour.h), which calls
+// `EntryPayload`. The payload records the timestamp and replaces the return address of the function
+// with the return trampoline, which calls `ExitPayload` once the function returns. `ExitPayload`
+// enqueues a FunctionCall event and returns the original return address.
+//
+// Limitations: since the return address is replaced, exceptions unwinding through an instrumented
+// function are not supported. Threads of the profiler itself are not filtered, only nested calls
+// from within the payloads are skipped. Arguments and return values are not recorded.
+
+// clang-format off
+#include <Windows.h>
+// clang-format on
+
+#include <MinHook.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <google/protobuf/arena.h>
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "CaptureEventProducer/LockFreeBufferCaptureEventProducer.h"
+#include "Detour.h"
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ThreadUtils.h"
+#include "ProducerSideChannel/ProducerSideChannel.h"
+#include "WindowsUserSpaceInstrumentation/InstrumentationInfo.h"
+
+using orbit_windows_user_space_instrumentation::HookData;
+using orbit_windows_user_space_instrumentation::InstrumentationInfoHeader;
+using orbit_windows_user_space_instrumentation::InstrumentedFunctionInfo;
+
+namespace {
+
+struct FunctionCall {
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t function_id;
+  uint64_t begin_timestamp;
+  uint64_t end_timestamp;
+  int32_t depth;
+};
+
+// This class is used to enqueue FunctionCall events from multiple threads, transform them into
+// orbit_grpc_protos::FunctionCall protos, and relay them to OrbitService.
+class LockFreeWindowsUserSpaceInstrumentationEventProducer
+    : public orbit_capture_event_producer::LockFreeBufferCaptureEventProducer<FunctionCall> {
+ public:
+  LockFreeWindowsUserSpaceInstrumentationEventProducer() {
+    UseSharedMemoryBuffer();
+    BuildAndStart(orbit_producer_side_channel::CreateProducerSideChannel());
+  }
+
+  ~LockFreeWindowsUserSpaceInstrumentationEventProducer() override { ShutdownAndWait(); }
+
+ protected:
+  [[nodiscard]] orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
+      FunctionCall&& raw_event, google::protobuf::Arena* arena) override {
+    auto* capture_event =
+        google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
+    const uint64_t begin_timestamp_ns = ToCaptureTimestampNs(raw_event.begin_timestamp);
+    const uint64_t end_timestamp_ns = ToCaptureTimestampNs(raw_event.end_timestamp);
+    orbit_grpc_protos::FunctionCall* function_call = capture_event->mutable_function_call();
+    function_call->set_pid(raw_event.pid);
+    function_call->set_tid(raw_event.tid);
+    function_call->set_function_id(raw_event.function_id);
+    function_call->set_duration_ns(end_timestamp_ns - begin_timestamp_ns);
+    function_call->set_end_timestamp_ns(end_timestamp_ns);
+    function_call->set_depth(raw_event.depth);
+    return capture_event;
+  }
+};
+
+LockFreeWindowsUserSpaceInstrumentationEventProducer& GetCaptureEventProducer() {
+  static LockFreeWindowsUserSpaceInstrumentationEventProducer producer;
+  return producer;
+}
+
+struct OpenFunctionCall {
+  uint64_t return_address;
+  uint64_t function_id;
+  uint64_t begin_timestamp;
+};
+
+// Keeps track of the instrumented functions the current thread is in, innermost last.
+thread_local std::vector<OpenFunctionCall> open_function_calls;
+
+// Whether the current thread is inside one of the payloads. If that is the case, we avoid further
+// instrumentation, e.g., of functions called by the event producer.
+thread_local bool is_in_payload = false;
+
+absl::Mutex hooks_mutex;
+// Maps the addresses of hooked functions to their data. Hooks are never removed: a disabled hook
+// can still be running, and the same function is likely to be instrumented in the next capture.
+absl::flat_hash_map<uint64_t, HookData*> addresses_to_hook_data ABSL_GUARDED_BY(hooks_mutex);
+// Written once, under `hooks_mutex`, before the first hook is created.
+std::atomic<uint64_t> return_trampoline_address = 0;
+
+void EntryPayload(uint64_t return_address, uint64_t function_id,
+                  uint64_t* return_address_location);
+uint64_t ExitPayload();
+
+// Copies `code` to newly allocated executable memory, which is never freed.
+[[nodiscard]] uint64_t WriteExecutableCode(const std::vector<uint8_t>& code) {
+  void* memory = VirtualAlloc(nullptr, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+  if (memory == nullptr) return 0;
+  std::memcpy(memory, code.data(), code.size());
+  DWORD old_protection = 0;
+  if (!VirtualProtect(memory, code.size(), PAGE_EXECUTE_READ, &old_protection)) {
+    VirtualFree(memory, /*dwSize=*/0, MEM_RELEASE);
+    return 0;
+  }
+  FlushInstructionCache(GetCurrentProcess(), memory, code.size());
+  return reinterpret_cast<uint64_t>(memory);
+}
+
+[[nodiscard]] MH_STATUS InitializeIfNeeded() ABSL_EXCLUSIVE_LOCKS_REQUIRED(hooks_mutex) {
+  if (return_trampoline_address != 0) return MH_OK;
+  const MH_STATUS status = MH_Initialize();
+  if (status != MH_OK && status != MH_ERROR_ALREADY_INITIALIZED) return status;
+  const uint64_t address = WriteExecutableCode(
+      orbit_windows_user_space_instrumentation::CreateReturnTrampoline(
+          reinterpret_cast<uint64_t>(&ExitPayload)));
+  if (address == 0) return MH_ERROR_MEMORY_ALLOC;
+  return_trampoline_address = address;
+  return MH_OK;
+}
+
+[[nodiscard]] MH_STATUS CreateHookIfNeeded(const InstrumentedFunctionInfo& function_info)
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(hooks_mutex) {
+  auto it = addresses_to_hook_data.find(function_info.absolute_address);
+  if (it != addresses_to_hook_data.end()) {
+    // Function ids can change from one capture to the next.
+    it->second->function_id = function_info.function_id;
+    return MH_OK;
+  }
+
+  auto* hook_data = new HookData{function_info.function_id, 0};
+  const uint64_t entry_stub_address =
+      WriteExecutableCode(orbit_windows_user_space_instrumentation::CreateEntryStub(
+          reinterpret_cast<uint64_t>(hook_data), reinterpret_cast<uint64_t>(&EntryPayload)));
+  if (entry_stub_address == 0) {
+    delete hook_data;
+    return MH_ERROR_MEMORY_ALLOC;
+  }
+  void* original = nullptr;
+  const MH_STATUS status =
+      MH_CreateHook(reinterpret_cast<void*>(function_info.absolute_address),
+                    reinterpret_cast<void*>(entry_stub_address), &original);
+  if (status != MH_OK) {
+    VirtualFree(reinterpret_cast<void*>(entry_stub_address), /*dwSize=*/0, MEM_RELEASE);
+    delete hook_data;
+    return status;
+  }
+  hook_data->original = reinterpret_cast<uint64_t>(original);
+  addresses_to_hook_data.emplace(function_info.absolute_address, hook_data);
+  return MH_OK;
+}
+
+void EntryPayload(uint64_t return_address, uint64_t function_id,
+                  uint64_t* return_address_location) {
+  if (is_in_payload) return;
+  is_in_payload = true;
+  if (GetCaptureEventProducer().IsCapturing()) {
+    open_function_calls.push_back(
+        {return_address, function_id, GetCaptureEventProducer().ReadTimestamp()});
+    *return_address_location = return_trampoline_address.load(std::memory_order_relaxed);
+  }
+  is_in_payload = false;
+}
+
+uint64_t ExitPayload() {
+  const uint64_t end_timestamp = GetCaptureEventProducer().ReadTimestamp();
+  is_in_payload = true;
+  ORBIT_CHECK(!open_function_calls.empty());
+  const OpenFunctionCall open_function_call = open_function_calls.back();
+  open_function_calls.pop_back();
+  if (GetCaptureEventProducer().IsCapturing()) {
+    static const uint32_t kPid = orbit_base::GetCurrentProcessId();
+    GetCaptureEventProducer().EnqueueIntermediateEvent(
+        FunctionCall{kPid, orbit_base::GetCurrentThreadId(), open_function_call.function_id,
+                     open_function_call.begin_timestamp, end_timestamp,
+                     static_cast<int32_t>(open_function_calls.size())});
+  }
+  is_in_payload = false;
+  return open_function_call.return_address;
+}
+
+}  // namespace
+
+extern "C" {
+
+// Called remotely by OrbitService via "CreateRemoteThread" with an InstrumentationInfoHeader
+// followed by the InstrumentedFunctionInfos. Enables the hooks for exactly these functions and
+// writes the result of hooking each function into its InstrumentedFunctionInfo.
+__declspec(dllexport) void orbit_instrument_functions(void* parameter) {
+  // Establish the connection to OrbitService before the first function call is recorded.
+  GetCaptureEventProducer();
+
+  auto* header = static_cast<InstrumentationInfoHeader*>(parameter);
+  auto* function_infos = reinterpret_cast<InstrumentedFunctionInfo*>(header + 1);
+
+  absl::MutexLock lock{&hooks_mutex};
+  const MH_STATUS initialization_status = InitializeIfNeeded();
+  std::vector<void*> addresses_to_enable;
+  for (uint64_t i = 0; i < header->function_count; ++i) {
+    InstrumentedFunctionInfo& function_info = function_infos[i];
+    function_info.result = initialization_status == MH_OK ? CreateHookIfNeeded(function_info)
+                                                          : initialization_status;
+    if (function_info.result == MH_OK) {
+      addresses_to_enable.push_back(reinterpret_cast<void*>(function_info.absolute_address));
+    }
+  }
+  if (initialization_status != MH_OK) return;
+
+  // Functions of the previous capture stay disabled unless they are requested again.
+  MH_DisableHook(MH_ALL_HOOKS);
+  for (void* address : addresses_to_enable) {
+    MH_QueueEnableHook(address);
+  }
+  const MH_STATUS enable_status = MH_ApplyQueued();
+  if (enable_status != MH_OK) {
+    for (uint64_t i = 0; i < header->function_count; ++i) {
+      if (function_infos[i].result == MH_OK) function_infos[i].result = enable_status;
+    }
+  }
+}
+
+// Called remotely by OrbitService via "CreateRemoteThread" at the end of a capture.
+__declspec(dllexport) void orbit_disable_instrumentation(void* /*parameter*/) {
+  absl::MutexLock lock{&hooks_mutex};
+  if (return_trampoline_address == 0) return;
+  MH_DisableHook(MH_ALL_HOOKS);
+}
+
+}  // extern "C"
@@ -0,0 +1,42 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WINDOWS_USER_SPACE_INSTRUMENTATION_INSTRUMENT_PROCESS_H_
+#define WINDOWS_USER_SPACE_INSTRUMENTATION_INSTRUMENT_PROCESS_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "GrpcProtos/capture.pb.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_windows_user_space_instrumentation {
+
+struct InstrumentationResult {
+  absl::flat_hash_set<uint64_t> instrumented_function_ids;
+  absl::flat_hash_map<uint64_t, std::string> function_ids_to_error_messages;
+};
+
+// Instruments the functions in `capture_options.instrumented_functions()` in the process identified
+// by `capture_options.pid()`. This injects "OrbitUserSpaceInstrumentation.dll" into the target, if
+// it's not already loaded, and hooks the functions with MinHook. The hooks report a FunctionCall
+// event for each call to OrbitService through the producer side channel.
+//
+// Functions instrumented in a previous capture that are no longer requested are disabled. Each
+// function that can't be instrumented gets an entry in `function_ids_to_error_messages`. An error
+// is only returned if the instrumentation as a whole failed, e.g., when the library can't be
+// injected.
+[[nodiscard]] ErrorMessageOr<InstrumentationResult> InstrumentProcess(
+    const orbit_grpc_protos::CaptureOptions& capture_options);
+
+// Disables all hooks installed by `InstrumentProcess`. The hooks and the injected library stay in
+// the target such that functions that are running at this point can return safely.
+[[nodiscard]] ErrorMessageOr<void> UninstrumentProcess(uint32_t pid);
+
+}  // namespace orbit_windows_user_space_instrumentation
+
+#endif  // WINDOWS_USER_SPACE_INSTRUMENTATION_INSTRUMENT_PROCESS_H_
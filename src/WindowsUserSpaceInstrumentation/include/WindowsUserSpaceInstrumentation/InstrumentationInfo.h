@@ -0,0 +1,36 @@
+// Copyright (c) 2022 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef WINDOWS_USER_SPACE_INSTRUMENTATION_INSTRUMENTATION_INFO_H_
+#define WINDOWS_USER_SPACE_INSTRUMENTATION_INSTRUMENTATION_INFO_H_
+
+#include <stdint.h>
+
+#include <type_traits>
+
+namespace orbit_windows_user_space_instrumentation {
+
+// The parameter of "orbit_instrument_functions", which OrbitService calls remotely using the
+// "CreateRemoteThread" api. It consists of an `InstrumentationInfoHeader` directly followed by
+// `function_count` instances of `InstrumentedFunctionInfo`. These structs need to be POD so that we
+// can easily copy them in a remote process address space.
+struct InstrumentationInfoHeader {
+  uint64_t function_count;
+};
+
+struct InstrumentedFunctionInfo {
+  uint64_t function_id;
+  uint64_t absolute_address;
+  // Written by the injected library: the MH_STATUS of hooking the function, MH_OK on success.
+  int32_t result;
+};
+
+static_assert(std::is_trivial<InstrumentationInfoHeader>::value,
+              "InstrumentationInfoHeader must be a trivial type.");
+static_assert(std::is_trivial<InstrumentedFunctionInfo>::value,
+              "InstrumentedFunctionInfo must be a trivial type.");
+
+}  // namespace orbit_windows_user_space_instrumentation
+
+#endif  // WINDOWS_USER_SPACE_INSTRUMENTATION_INSTRUMENTATION_INFO_H_
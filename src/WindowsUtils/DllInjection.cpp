@@ -160,16 +160,67 @@ ErrorMessageOr<void> CreateRemoteThread(uint32_t pid, std::string_view module_na
     parameter_address = address;
   }
 
-  if (!::CreateRemoteThread(handle, /*lpThreadAttributes=*/0, /*dwStackSize=*/0,
-                            absl::bit_cast<LPTHREAD_START_ROUTINE>(function_address),
-                            absl::bit_cast<LPVOID>(parameter_address),
-                            /*dwCreationFlags=*/0, /*lpThreadId=*/0)) {
+  HANDLE thread_handle = ::CreateRemoteThread(
+      handle, /*lpThreadAttributes=*/0, /*dwStackSize=*/0,
+      absl::bit_cast<LPTHREAD_START_ROUTINE>(function_address),
+      absl::bit_cast<LPVOID>(parameter_address), /*dwCreationFlags=*/0, /*lpThreadId=*/0);
+  if (thread_handle == nullptr) {
     return orbit_base::GetLastErrorAsErrorMessage("CreateRemoteThread");
   }
+  SafeHandle thread_handle_closer(thread_handle);
 
   return outcome::success();
 }
 
+ErrorMessageOr<std::vector<char>> CreateRemoteThreadAndWait(uint32_t pid,
+                                                            std::string_view module_name,
+                                                            std::string_view function_name,
+                                                            absl::Span<const char> parameter,
+                                                            uint32_t timeout_ms) {
+  OUTCOME_TRY(uint64_t function_address, GetRemoteProcAddress(pid, module_name, function_name));
+  OUTCOME_TRY(SafeHandle safe_handle,
+              OpenProcess(PROCESS_ALL_ACCESS, /*inherit_handle=*/false, pid));
+  HANDLE handle = *safe_handle;
+
+  uint64_t parameter_address = 0;
+  if (!parameter.empty()) {
+    OUTCOME_TRY(uint64_t address, RemoteWrite(handle, parameter));
+    parameter_address = address;
+  }
+
+  HANDLE thread_handle = ::CreateRemoteThread(
+      handle, /*lpThreadAttributes=*/0, /*dwStackSize=*/0,
+      absl::bit_cast<LPTHREAD_START_ROUTINE>(function_address),
+      absl::bit_cast<LPVOID>(parameter_address), /*dwCreationFlags=*/0, /*lpThreadId=*/0);
+  if (thread_handle == nullptr) {
+    return orbit_base::GetLastErrorAsErrorMessage("CreateRemoteThread");
+  }
+  SafeHandle thread_handle_closer(thread_handle);
+
+  const DWORD wait_result = WaitForSingleObject(thread_handle, timeout_ms);
+  if (wait_result == WAIT_TIMEOUT) {
+    // The thread might still access the parameter, so its memory is not freed.
+    return ErrorMessage(absl::StrFormat("Remote function \"%s\" did not return within %u ms",
+                                        function_name, timeout_ms));
+  }
+  if (wait_result != WAIT_OBJECT_0) {
+    return orbit_base::GetLastErrorAsErrorMessage("WaitForSingleObject");
+  }
+
+  std::vector<char> result(parameter.size());
+  if (!parameter.empty()) {
+    size_t number_of_bytes_read = 0;
+    const bool read_succeeded =
+        ::ReadProcessMemory(handle, absl::bit_cast<LPCVOID>(parameter_address), result.data(),
+                            result.size(), &number_of_bytes_read) != 0;
+    VirtualFreeEx(handle, absl::bit_cast<LPVOID>(parameter_address), /*dwSize=*/0, MEM_RELEASE);
+    if (!read_succeeded || number_of_bytes_read != result.size()) {
+      return ErrorMessage("Unable to read back the parameter of the remote thread function");
+    }
+  }
+  return result;
+}
+
 // Parse remote module's MS-DOS, NT, and optional headers in order to locate the
 // IMAGE_EXPORT_DIRECTORY structure and find the requested function address.
 // See https://docs.microsoft.com/en-us/windows/win32/debug/pe-format for more info.
@@ -41,4 +41,20 @@ ErrorMessageOr<std::string> ReadProcessMemory(uint32_t pid, uintptr_t address, u
   return std::move(buffer);
 }
 
+ErrorMessageOr<std::vector<std::string>> ReadProcessMemoryRanges(
+    uint32_t pid, absl::Span<const MemoryRange> ranges) {
+  OUTCOME_TRY(SafeHandle process_handle, OpenProcessForReading(pid));
+  std::vector<std::string> results(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    std::string& buffer = results[i];
+    buffer.resize(ranges[i].size);
+    SIZE_T num_bytes_read = 0;
+    // On a partial copy, the call fails but still reports the number of bytes that were read.
+    ::ReadProcessMemory(*process_handle, absl::bit_cast<void*>(ranges[i].address), buffer.data(),
+                        buffer.size(), &num_bytes_read);
+    buffer.resize(num_bytes_read);
+  }
+  return results;
+}
+
 }  // namespace orbit_windows_utils
@@ -5,6 +5,9 @@
 #include <absl/base/casts.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 #include "OrbitBase/ThreadConstants.h"
 #include "OrbitBase/ThreadUtils.h"
 #include "WindowsUtils/ReadProcessMemory.h"
@@ -35,6 +38,22 @@ TEST(ReadProcessMemory, ReadCurrentProcessMemoryAsString) {
   EXPECT_STREQ(result.value().data(), test_string.data());
 }
 
+TEST(ReadProcessMemory, ReadCurrentProcessMemoryRanges) {
+  std::string first("The quick brown fox");
+  std::string second("jumps over the lazy dog");
+  uint32_t pid = orbit_base::GetCurrentProcessId();
+  const std::vector<MemoryRange> ranges{{absl::bit_cast<uintptr_t>(first.data()), first.size()},
+                                        {/*address=*/0, /*size=*/8},
+                                        {absl::bit_cast<uintptr_t>(second.data()), second.size()}};
+
+  ErrorMessageOr<std::vector<std::string>> result = ReadProcessMemoryRanges(pid, ranges);
+  ASSERT_FALSE(result.has_error());
+  ASSERT_EQ(result.value().size(), ranges.size());
+  EXPECT_EQ(result.value()[0], first);
+  EXPECT_EQ(result.value()[1], "");
+  EXPECT_EQ(result.value()[2], second);
+}
+
 TEST(ReadProcessMemory, ReadInvalidProcessMemory) {
   uint32_t pid = orbit_base::kInvalidProcessId;
   constexpr const size_t kReadSize = 32;
@@ -30,6 +30,13 @@ namespace orbit_windows_utils {
                                                       std::string_view function_name,
                                                       absl::Span<const char> parameter);
 
+// Like above, but waits for the thread function to return, for at most `timeout_ms` milliseconds.
+// The thread function can report results by writing them into its parameter: the returned buffer
+// is the content of the parameter in the remote process after the thread function has returned.
+[[nodiscard]] ErrorMessageOr<std::vector<char>> CreateRemoteThreadAndWait(
+    uint32_t pid, std::string_view module_name, std::string_view function_name,
+    absl::Span<const char> parameter, uint32_t timeout_ms = 10'000);
+
 // Get address of function in a remote process.
 [[nodiscard]] ErrorMessageOr<uint64_t> GetRemoteProcAddress(uint32_t pid,
                                                             std::string_view module_name,
@@ -5,7 +5,10 @@
 #ifndef WINDOWS_UTILS_READ_PROCESS_MEMORY_H_
 #define WINDOWS_UTILS_READ_PROCESS_MEMORY_H_
 
+#include <absl/types/span.h>
+
 #include <string>
+#include <vector>
 
 #include "OrbitBase/Result.h"
 
@@ -19,6 +22,17 @@ namespace orbit_windows_utils {
 [[nodiscard]] ErrorMessageOr<std::string> ReadProcessMemory(uint32_t pid, uintptr_t address,
                                                             uint64_t size);
 
+struct MemoryRange {
+  uint64_t address;
+  uint64_t size;
+};
+
+// Reads many ranges of the memory of process "pid", opening the process only once. Returns, for
+// each range, the bytes that could be read from its start, which might be fewer than requested or
+// none. Only fails if the process can't be opened.
+[[nodiscard]] ErrorMessageOr<std::vector<std::string>> ReadProcessMemoryRanges(
+    uint32_t pid, absl::Span<const MemoryRange> ranges);
+
 }  // namespace orbit_windows_utils
 
 #endif  // WINDOWS_UTILS_READ_PROCESS_MEMORY_H_